@@ -41,6 +41,8 @@ void HttpClient::resetState()
   iChunkLength = 0;
   iHttpResponseTimeout = kHttpResponseTimeout;
   iHttpWaitForDataDelay = kHttpWaitForDataDelay;
+  iChunkedBody = false;
+  iChunkBufferLength = 0;
 }
 
 void HttpClient::stop()
@@ -282,6 +284,110 @@ void HttpClient::beginBody()
     // else the end of headers has already been sent, so nothing to do here
 }
 
+int HttpClient::beginChunkedBody()
+{
+    if (iState != eRequestStarted)
+    {
+        // The headers have been finished already, or no request was started
+        return HTTP_ERROR_API;
+    }
+    sendHeader(HTTP_HEADER_TRANSFER_ENCODING, HTTP_HEADER_VALUE_CHUNKED);
+    finishHeaders();
+    iChunkedBody = true;
+    iChunkBufferLength = 0;
+    return HTTP_SUCCESS;
+}
+
+size_t HttpClient::writeChunk(const uint8_t* aData, size_t aSize)
+{
+    if (!iChunkedBody || aSize == 0 || !flushChunkBuffer())
+    {
+        return 0;
+    }
+    // The chunk size in hex, then the data, each followed by CRLF
+    iClient->print((unsigned long)aSize, HEX);
+    iClient->print("\r\n");
+    size_t sent = iClient->write(aData, aSize);
+    iClient->print("\r\n");
+    return sent;
+}
+
+int HttpClient::endChunkedBody()
+{
+    if (!iChunkedBody)
+    {
+        return HTTP_ERROR_API;
+    }
+    bool flushed = flushChunkBuffer();
+    iChunkedBody = false;
+    // The last chunk has a size of 0, and no trailers follow it
+    iClient->print("0\r\n\r\n");
+    return flushed ? HTTP_SUCCESS : HTTP_ERROR_CONNECTION_FAILED;
+}
+
+bool HttpClient::flushChunkBuffer()
+{
+    if (iChunkBufferLength == 0)
+    {
+        return true;
+    }
+    size_t length = iChunkBufferLength;
+    iChunkBufferLength = 0;
+    iClient->print((unsigned long)length, HEX);
+    iClient->print("\r\n");
+    size_t sent = iClient->write(iChunkBuffer, length);
+    iClient->print("\r\n");
+    return sent == length;
+}
+
+size_t HttpClient::write(uint8_t aByte)
+{
+    if (iState < eRequestSent)
+    {
+        finishHeaders();
+    }
+    if (!iChunkedBody)
+    {
+        return iClient->write(aByte);
+    }
+    if (iChunkBufferLength == sizeof(iChunkBuffer) && !flushChunkBuffer())
+    {
+        return 0;
+    }
+    iChunkBuffer[iChunkBufferLength++] = aByte;
+    return 1;
+}
+
+size_t HttpClient::write(const uint8_t *aBuffer, size_t aSize)
+{
+    if (iState < eRequestSent)
+    {
+        finishHeaders();
+    }
+    if (!iChunkedBody)
+    {
+        return iClient->write(aBuffer, aSize);
+    }
+    if (aSize >= sizeof(iChunkBuffer))
+    {
+        // Too much to gather, send what is there and this as chunks of their own
+        return writeChunk(aBuffer, aSize);
+    }
+    size_t gathered = 0;
+    while (gathered < aSize)
+    {
+        if (iChunkBufferLength == sizeof(iChunkBuffer) && !flushChunkBuffer())
+        {
+            break;
+        }
+        size_t part = min(aSize - gathered, sizeof(iChunkBuffer) - iChunkBufferLength);
+        memcpy(iChunkBuffer + iChunkBufferLength, aBuffer + gathered, part);
+        iChunkBufferLength += part;
+        gathered += part;
+    }
+    return gathered;
+}
+
 int HttpClient::get(const char* aURLPath)
 {
     return startRequest(aURLPath, HTTP_METHOD_GET);
@@ -38,6 +38,12 @@ static const int HTTP_ERROR_INVALID_RESPONSE =-4;
 #define HTTP_HEADER_USER_AGENT     "User-Agent"
 #define HTTP_HEADER_VALUE_CHUNKED  "chunked"
 
+// Bytes of a chunked request body gathered before they go out as one chunk,
+// so single byte writes don't each cost a chunk header
+#ifndef HTTP_CHUNK_BUFFER_SIZE
+#define HTTP_CHUNK_BUFFER_SIZE 128
+#endif
+
 class HttpClient : public Client
 {
 public:
@@ -72,6 +78,30 @@ public:
     */
     void beginBody();
 
+    /** Start a body sent with Transfer-Encoding: chunked, for a body whose
+        length isn't known up front.  Call it after beginRequest(), the
+        request method (e.g. post(aURLPath)) and any sendHeader() calls.
+        Everything written or printed afterwards is sent in chunks of up to
+        HTTP_CHUNK_BUFFER_SIZE bytes, so a large body can be streamed with
+        constant memory.  Finish it with endChunkedBody().
+      @return 0 if successful, else error
+    */
+    int beginChunkedBody();
+
+    /** Send aSize bytes as one chunk of a body started with
+        beginChunkedBody(), after whatever was written before them.
+      @param aData   Data to send
+      @param aSize   Number of bytes, 0 sends nothing
+      @return Number of bytes sent
+    */
+    size_t writeChunk(const uint8_t* aData, size_t aSize);
+
+    /** Send what is left of a chunked body and the terminating empty chunk.
+        The response can then be read as usual, e.g. with responseStatusCode().
+      @return 0 if successful, else error
+    */
+    int endChunkedBody();
+
     /** Connect to the server and start to send a GET request.
       @param aURLPath     Url to request
       @return 0 if successful, else error
@@ -298,8 +328,8 @@ public:
     // Inherited from Print
     // Note: 1st call to these indicates the user is sending the body, so if need
     // Note: be we should finish the header first
-    virtual size_t write(uint8_t aByte) { if (iState < eRequestSent) { finishHeaders(); }; return iClient-> write(aByte); };
-    virtual size_t write(const uint8_t *aBuffer, size_t aSize) { if (iState < eRequestSent) { finishHeaders(); }; return iClient->write(aBuffer, aSize); };
+    virtual size_t write(uint8_t aByte);
+    virtual size_t write(const uint8_t *aBuffer, size_t aSize);
     // Inherited from Stream
     virtual int available();
     /** Read the next byte from the server.
@@ -341,6 +371,11 @@ protected:
     */
     void flushClientRx();
 
+    /** Send the bytes gathered in iChunkBuffer as one chunk
+      @return false if they could not all be sent
+    */
+    bool flushChunkBuffer();
+
     // Number of milliseconds that we wait each time there isn't any data
     // available to be read (during status code and header processing)
     static const int kHttpWaitForDataDelay = 100;
@@ -391,6 +426,11 @@ protected:
     bool iConnectionClose;
     bool iSendDefaultRequestHeaders;
     String iHeaderLine;
+    // Set between beginChunkedBody() and endChunkedBody()
+    bool iChunkedBody;
+    // Body bytes not yet sent as a chunk
+    uint8_t iChunkBuffer[HTTP_CHUNK_BUFFER_SIZE];
+    size_t iChunkBufferLength;
 };
 
 #endif
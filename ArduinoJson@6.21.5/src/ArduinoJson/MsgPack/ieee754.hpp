@@ -1,18 +0,0 @@
-// ArduinoJson - https://arduinojson.org
-// Copyright © 2014-2023, Benoit BLANCHON
-// MIT License
-
-#pragma once
-
-#include <ArduinoJson/Namespace.hpp>
-
-ARDUINOJSON_BEGIN_PRIVATE_NAMESPACE
-
-inline void doubleToFloat(const uint8_t d[8], uint8_t f[4]) {
-  f[0] = uint8_t((d[0] & 0xC0) | (d[0] << 3 & 0x3f) | (d[1] >> 5));
-  f[1] = uint8_t((d[1] << 3) | (d[2] >> 5));
-  f[2] = uint8_t((d[2] << 3) | (d[3] >> 5));
-  f[3] = uint8_t((d[3] << 3) | (d[4] >> 5));
-}
-
-ARDUINOJSON_END_PRIVATE_NAMESPACE
@@ -1,21 +0,0 @@
-// ArduinoJson - https://arduinojson.org
-// Copyright © 2014-2023, Benoit BLANCHON
-// MIT License
-
-#pragma once
-
-#include <ArduinoJson/Namespace.hpp>
-
-ARDUINOJSON_BEGIN_PRIVATE_NAMESPACE
-
-template <bool Condition, class TrueType, class FalseType>
-struct conditional {
-  typedef TrueType type;
-};
-
-template <class TrueType, class FalseType>
-struct conditional<false, TrueType, FalseType> {
-  typedef FalseType type;
-};
-
-ARDUINOJSON_END_PRIVATE_NAMESPACE
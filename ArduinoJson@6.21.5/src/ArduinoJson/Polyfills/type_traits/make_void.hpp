@@ -1,14 +0,0 @@
-// ArduinoJson - https://arduinojson.org
-// Copyright © 2014-2023, Benoit BLANCHON
-// MIT License
-
-#pragma once
-
-ARDUINOJSON_BEGIN_PRIVATE_NAMESPACE
-
-template <class = void>
-struct make_void {
-  typedef void type;
-};
-
-ARDUINOJSON_END_PRIVATE_NAMESPACE
@@ -1,28 +0,0 @@
-// ArduinoJson - https://arduinojson.org
-// Copyright © 2014-2023, Benoit BLANCHON
-// MIT License
-
-#pragma once
-
-#include <ArduinoJson/Namespace.hpp>
-
-ARDUINOJSON_BEGIN_PRIVATE_NAMESPACE
-
-template <typename T>
-struct remove_cv {
-  typedef T type;
-};
-template <typename T>
-struct remove_cv<const T> {
-  typedef T type;
-};
-template <typename T>
-struct remove_cv<volatile T> {
-  typedef T type;
-};
-template <typename T>
-struct remove_cv<const volatile T> {
-  typedef T type;
-};
-
-ARDUINOJSON_END_PRIVATE_NAMESPACE
@@ -7,6 +7,9 @@
 
 #include "PubSubClient.h"
 #include "Arduino.h"
+#if defined(ESP32)
+#include <lwip/sockets.h>
+#endif
 
 PubSubClient::PubSubClient() {
     this->_state = MQTT_DISCONNECTED;
@@ -159,7 +162,9 @@ PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGN
 }
 
 PubSubClient::~PubSubClient() {
-  free(this->buffer);
+  if (this->bufferCapacity == 0) {
+    free(this->buffer);
+  }
 }
 
 boolean PubSubClient::connect(const char *id) {
@@ -179,6 +184,20 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
 }
 
 boolean PubSubClient::connect(const char *id, const char *user, const char *pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession) {
+    if (!beginConnect(id,user,pass,willTopic,willQos,willRetain,willMessage,cleanSession)) {
+        return false;
+    }
+    while (this->_state == MQTT_CONNECTING) {
+        pollConnect();
+    }
+    return this->_state == MQTT_CONNECTED;
+}
+
+boolean PubSubClient::beginConnect(const char *id, const char *user, const char *pass) {
+    return beginConnect(id,user,pass,0,0,0,0,1);
+}
+
+boolean PubSubClient::beginConnect(const char *id, const char *user, const char *pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession) {
     if (!connected()) {
         int result = 0;
 
@@ -186,6 +205,10 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
         if(_client->connected()) {
             result = 1;
         } else {
+#if defined(ESP32)
+            // A new connection gets a new socket
+            this->socketFd = -1;
+#endif
             if (domain != NULL) {
                 result = _client->connect(this->domain, this->port);
             } else {
@@ -195,6 +218,8 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
 
         if (result == 1) {
             nextMsgId = 1;
+            // The messages are not kept to be resent, so their acknowledgements are not waited for any longer
+            this->inflightCount = 0;
             // Leave room in the buffer for header and variable length field
             uint16_t length = MQTT_MAX_HEADER_SIZE;
             unsigned int j;
@@ -253,29 +278,8 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
             write(MQTTCONNECT,this->buffer,length-MQTT_MAX_HEADER_SIZE);
 
             lastInActivity = lastOutActivity = millis();
-
-            while (!_client->available()) {
-                unsigned long t = millis();
-                if (t-lastInActivity >= ((int32_t) this->socketTimeout*1000UL)) {
-                    _state = MQTT_CONNECTION_TIMEOUT;
-                    _client->stop();
-                    return false;
-                }
-            }
-            uint8_t llen;
-            uint32_t len = readPacket(&llen);
-
-            if (len == 4) {
-                if (buffer[3] == 0) {
-                    lastInActivity = millis();
-                    pingOutstanding = false;
-                    _state = MQTT_CONNECTED;
-                    return true;
-                } else {
-                    _state = buffer[3];
-                }
-            }
-            _client->stop();
+            _state = MQTT_CONNECTING;
+            return true;
         } else {
             _state = MQTT_CONNECT_FAILED;
         }
@@ -284,10 +288,57 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
     return true;
 }
 
+boolean PubSubClient::pollConnect() {
+    if (this->_state != MQTT_CONNECTING) {
+        return connected();
+    }
+    if (!_client->available()) {
+        unsigned long t = millis();
+        if (t-lastInActivity >= ((int32_t) this->socketTimeout*1000UL)) {
+            _state = MQTT_CONNECTION_TIMEOUT;
+            _client->stop();
+        } else if (!_client->connected()) {
+            _state = MQTT_CONNECT_FAILED;
+            _client->stop();
+        }
+        return false;
+    }
+    uint8_t llen;
+    uint32_t len = readPacket(&llen);
+
+    if (len == 4) {
+        if (buffer[3] == 0) {
+            lastInActivity = millis();
+            pingOutstanding = false;
+            _state = MQTT_CONNECTED;
+            return true;
+        } else {
+            _state = buffer[3];
+        }
+    } else {
+        _state = MQTT_CONNECT_FAILED;
+    }
+    _client->stop();
+    return false;
+}
+
+boolean PubSubClient::connecting() {
+    return this->_state == MQTT_CONNECTING;
+}
+
 // reads a byte into result
 boolean PubSubClient::readByte(uint8_t * result) {
    uint32_t previousMillis = millis();
    while(!_client->available()) {
+#if defined(ESP32)
+     if (this->socketFd >= 0) {
+       uint32_t elapsed = millis() - previousMillis;
+       if (elapsed >= this->socketTimeout * 1000UL || waitReadable(this->socketTimeout * 1000UL - elapsed) < 0) {
+         return false;
+       }
+       continue;
+     }
+#endif
      yield();
      uint32_t currentMillis = millis();
      if(currentMillis - previousMillis >= ((int32_t) this->socketTimeout * 1000)){
@@ -309,6 +360,76 @@ boolean PubSubClient::readByte(uint8_t * result, uint16_t * index){
   return false;
 }
 
+// reads length bytes into result
+boolean PubSubClient::readBytes(uint8_t * result, uint16_t length) {
+   uint16_t index = 0;
+   while (index < length) {
+     if (!readByte(result + index)) {
+       return false;
+     }
+     index++;
+     // The rest of what already arrived is read at once
+     int available = _client->available();
+     uint16_t count = length - index;
+     if (available > 0 && count > 0) {
+       if ((uint32_t)available < count) {
+         count = available;
+       }
+       int received = _client->read(result + index, count);
+       if (received > 0) {
+         index += received;
+       }
+     }
+   }
+   return true;
+}
+
+void PubSubClient::readStreamedPublish(uint16_t headerLength, uint32_t length) {
+    uint8_t digit = 0;
+    uint32_t consumed = 0;
+    if (!readBytes(this->buffer + headerLength, 2)) return;
+    consumed = 2;
+    uint16_t tl = (this->buffer[headerLength]<<8)+this->buffer[headerLength+1]; /* topic length in bytes */
+    boolean qos1 = (this->buffer[0]&0x06) == MQTTQOS1;
+    uint32_t variableLength = 2 + tl + (qos1 ? 2 : 0);
+    // The topic, its terminator and at least one byte of payload have to fit
+    if (variableLength > length || (uint32_t)headerLength + 2 + tl >= this->bufferSize) {
+        for (; consumed < length; consumed++) {
+            if (!readByte(&digit)) return;
+        }
+        return;
+    }
+    if (!readBytes(this->buffer + headerLength + 2, tl)) return;
+    uint16_t msgId = 0;
+    if (qos1) {
+        if (!readByte(&digit)) return;
+        msgId = digit << 8;
+        if (!readByte(&digit)) return;
+        msgId |= digit;
+    }
+    memmove(this->buffer+headerLength+1,this->buffer+headerLength+2,tl); /* move topic inside buffer 1 byte to front */
+    this->buffer[headerLength+1+tl] = 0; /* end the topic as a 'C' string with \x00 */
+    char *topic = (char*) this->buffer+headerLength+1;
+    uint8_t *payload = this->buffer+headerLength+2+tl;
+    uint16_t room = this->bufferSize-headerLength-2-tl;
+    uint32_t total = length - variableLength;
+    for (uint32_t offset = 0; offset < total;) {
+        uint16_t piece = total - offset < room ? (uint16_t)(total - offset) : room;
+        if (!readBytes(payload, piece)) return;
+        streamCallback(topic, offset, payload, piece, total);
+        offset += piece;
+    }
+    lastInActivity = millis();
+    if (qos1) {
+        this->buffer[0] = MQTTPUBACK;
+        this->buffer[1] = 2;
+        this->buffer[2] = (msgId >> 8);
+        this->buffer[3] = (msgId & 0xFF);
+        _client->write(this->buffer,4);
+        lastOutActivity = lastInActivity;
+    }
+}
+
 uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
     uint16_t len = 0;
     if(!readByte(this->buffer, &len)) return 0;
@@ -333,6 +454,12 @@ uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
     } while ((digit & 128) != 0);
     *lengthLength = len-1;
 
+    if (isPublish && this->streamCallback && !this->stream && len + length > this->bufferSize) {
+        // Handled completely, there is nothing left for loop() to process
+        readStreamedPublish(len, length);
+        return 0;
+    }
+
     if (isPublish) {
         // Read in topic length to calculate bytes to skip over for Stream writing
         if(!readByte(this->buffer, &len)) return 0;
@@ -368,6 +495,9 @@ uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
 }
 
 boolean PubSubClient::loop() {
+    if (this->_state == MQTT_CONNECTING) {
+        return pollConnect();
+    }
     if (connected()) {
         unsigned long t = millis();
         if ((t - lastInActivity > this->keepAlive*1000UL) || (t - lastOutActivity > this->keepAlive*1000UL)) {
@@ -422,6 +552,19 @@ boolean PubSubClient::loop() {
                     _client->write(this->buffer,2);
                 } else if (type == MQTTPINGRESP) {
                     pingOutstanding = false;
+                } else if (type == MQTTPUBACK) {
+                    msgId = (this->buffer[llen+1]<<8)+this->buffer[llen+2];
+                    for (uint8_t i = 0; i < this->inflightCount; i++) {
+                        if (this->inflightIds[i] == msgId) {
+                            // Keep the rest in the order they were sent
+                            memmove(this->inflightIds+i,this->inflightIds+i+1,(this->inflightCount-i-1)*sizeof(uint16_t));
+                            this->inflightCount--;
+                            if (pubackCallback) {
+                                pubackCallback(msgId);
+                            }
+                            break;
+                        }
+                    }
                 }
             } else if (!connected()) {
                 // readPacket has closed the connection
@@ -471,6 +614,49 @@ boolean PubSubClient::publish(const char* topic, const uint8_t* payload, unsigne
     return false;
 }
 
+uint16_t PubSubClient::publishQos1(const char* topic, const uint8_t* payload, unsigned int plength, boolean retained) {
+    if (connected()) {
+        if (this->inflightCount >= MQTT_MAX_INFLIGHT) {
+            return 0;
+        }
+        if (this->bufferSize < MQTT_MAX_HEADER_SIZE + 2+strnlen(topic, this->bufferSize) + 2 + plength) {
+            // Too long
+            return 0;
+        }
+        // Leave room in the buffer for header and variable length field
+        uint16_t length = MQTT_MAX_HEADER_SIZE;
+        length = writeString(topic,this->buffer,length);
+        nextMsgId++;
+        if (nextMsgId == 0) {
+            nextMsgId = 1;
+        }
+        this->buffer[length++] = (nextMsgId >> 8);
+        this->buffer[length++] = (nextMsgId & 0xFF);
+
+        // Add payload
+        uint16_t i;
+        for (i=0;i<plength;i++) {
+            this->buffer[length++] = payload[i];
+        }
+
+        // Write the header
+        uint8_t header = MQTTPUBLISH | MQTTQOS1;
+        if (retained) {
+            header |= 1;
+        }
+        if (!write(header,this->buffer,length-MQTT_MAX_HEADER_SIZE)) {
+            return 0;
+        }
+        this->inflightIds[this->inflightCount++] = nextMsgId;
+        return nextMsgId;
+    }
+    return 0;
+}
+
+uint8_t PubSubClient::inflight() {
+    return this->inflightCount;
+}
+
 boolean PubSubClient::publish_P(const char* topic, const char* payload, boolean retained) {
     return publish_P(topic, (const uint8_t*)payload, payload ? strnlen(payload, this->bufferSize) : 0, retained);
 }
@@ -533,27 +719,106 @@ boolean PubSubClient::beginPublish(const char* topic, unsigned int plength, bool
             header |= 1;
         }
         size_t hlen = buildHeader(header, this->buffer, plength+length-MQTT_MAX_HEADER_SIZE);
+#if MQTT_COALESCE_PUBLISH
+        // Keep the header in the buffer, it is sent together with the first part of the payload
+        this->publishStart = MQTT_MAX_HEADER_SIZE-hlen;
+        this->publishLength = length-(MQTT_MAX_HEADER_SIZE-hlen);
+        this->publishActive = true;
+        this->publishFailed = false;
+        return true;
+#else
         uint16_t rc = _client->write(this->buffer+(MQTT_MAX_HEADER_SIZE-hlen),length-(MQTT_MAX_HEADER_SIZE-hlen));
         lastOutActivity = millis();
         return (rc == (length-(MQTT_MAX_HEADER_SIZE-hlen)));
+#endif
     }
     return false;
 }
 
 int PubSubClient::endPublish() {
+#if MQTT_COALESCE_PUBLISH
+    if (this->publishActive) {
+        this->publishActive = false;
+        return flushPublish() && !this->publishFailed;
+    }
+#endif
  return 1;
 }
 
 size_t PubSubClient::write(uint8_t data) {
+#if MQTT_COALESCE_PUBLISH
+    if (this->publishActive) {
+        return write(&data,1);
+    }
+#endif
     lastOutActivity = millis();
     return _client->write(data);
 }
 
 size_t PubSubClient::write(const uint8_t *buffer, size_t size) {
+#if MQTT_COALESCE_PUBLISH
+    if (this->publishActive) {
+        if (this->publishFailed) {
+            return 0;
+        }
+        size_t written = 0;
+        while (written < size) {
+            if (this->publishStart+this->publishLength == this->bufferSize) {
+                if (!flushPublish()) {
+                    return written;
+                }
+            }
+            // Payload that fills the whole buffer anyway is passed on without copying it first
+            if (this->publishLength == 0 && size-written >= this->bufferSize) {
+                size_t rc = _client->write(buffer+written,size-written);
+                lastOutActivity = millis();
+                if (rc != size-written) {
+                    this->publishFailed = true;
+                }
+                return written+rc;
+            }
+            uint16_t chunk = this->bufferSize-this->publishStart-this->publishLength;
+            if (chunk > size-written) {
+                chunk = size-written;
+            }
+            memcpy(this->buffer+this->publishStart+this->publishLength,buffer+written,chunk);
+            this->publishLength += chunk;
+            written += chunk;
+        }
+        return written;
+    }
+#endif
     lastOutActivity = millis();
     return _client->write(buffer,size);
 }
 
+#if MQTT_COALESCE_PUBLISH
+boolean PubSubClient::flushPublish() {
+    boolean result = true;
+    uint8_t* writeBuf = this->buffer+this->publishStart;
+    uint16_t bytesRemaining = this->publishLength;
+    while ((bytesRemaining > 0) && result) {
+#ifdef MQTT_MAX_TRANSFER_SIZE
+        uint16_t bytesToWrite = (bytesRemaining > MQTT_MAX_TRANSFER_SIZE)?MQTT_MAX_TRANSFER_SIZE:bytesRemaining;
+#else
+        uint16_t bytesToWrite = bytesRemaining;
+#endif
+        uint16_t rc = _client->write(writeBuf,bytesToWrite);
+        result = (rc == bytesToWrite);
+        bytesRemaining -= rc;
+        writeBuf += rc;
+    }
+    lastOutActivity = millis();
+    // Once the header is out the complete buffer can be used for the payload
+    this->publishStart = 0;
+    this->publishLength = 0;
+    if (!result) {
+        this->publishFailed = true;
+    }
+    return result;
+}
+#endif
+
 size_t PubSubClient::buildHeader(uint8_t header, uint8_t* buf, uint16_t length) {
     uint8_t lenBuf[4];
     uint8_t llen = 0;
@@ -664,9 +929,66 @@ void PubSubClient::disconnect() {
     _state = MQTT_DISCONNECTED;
     _client->flush();
     _client->stop();
+#if defined(ESP32)
+    this->socketFd = -1;
+#endif
     lastInActivity = lastOutActivity = millis();
 }
 
+unsigned long PubSubClient::keepAliveDue() {
+    unsigned long t = millis();
+    if (this->_state == MQTT_CONNECTING) {
+        unsigned long elapsed = t - lastInActivity;
+        return elapsed >= this->socketTimeout*1000UL ? 0 : this->socketTimeout*1000UL - elapsed;
+    }
+    if (this->_state != MQTT_CONNECTED) {
+        return 0;
+    }
+    // loop() pings once either side was quiet for longer than the keepalive
+    unsigned long quiet = t - lastInActivity;
+    if (t - lastOutActivity > quiet) {
+        quiet = t - lastOutActivity;
+    }
+    return quiet > this->keepAlive*1000UL ? 0 : this->keepAlive*1000UL - quiet + 1;
+}
+
+#if defined(ESP32)
+PubSubClient& PubSubClient::setSocketFd(int fd) {
+    this->socketFd = fd;
+    return *this;
+}
+
+int PubSubClient::waitReadable(uint32_t timeoutMs) {
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(this->socketFd, &readable);
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    int rc = select(this->socketFd + 1, &readable, NULL, NULL, &timeout);
+    return rc < 0 ? -1 : (rc > 0 ? 1 : 0);
+}
+
+boolean PubSubClient::waitForActivity(uint32_t maxWaitMs) {
+    if (_client == NULL) {
+        return false;
+    }
+    if (_client->available()) {
+        return true;
+    }
+    unsigned long due = keepAliveDue();
+    if (due == 0) {
+        return true;
+    }
+    if (this->socketFd < 0) {
+        return false;
+    }
+    int rc = waitReadable(due < maxWaitMs ? due : maxWaitMs);
+    // A failed socket is for loop() to notice
+    return rc != 0 || keepAliveDue() == 0;
+}
+#endif
+
 uint16_t PubSubClient::writeString(const char* string, uint8_t* buf, uint16_t pos) {
     const char* idp = string;
     uint16_t i = 0;
@@ -692,6 +1014,9 @@ boolean PubSubClient::connected() {
                 this->_state = MQTT_CONNECTION_LOST;
                 _client->flush();
                 _client->stop();
+#if defined(ESP32)
+                this->socketFd = -1;
+#endif
             }
         } else {
             return this->_state == MQTT_CONNECTED;
@@ -718,6 +1043,16 @@ PubSubClient& PubSubClient::setServer(const char * domain, uint16_t port) {
     return *this;
 }
 
+PubSubClient& PubSubClient::setPubackCallback(MQTT_PUBACK_CALLBACK_SIGNATURE) {
+    this->pubackCallback = pubackCallback;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setStreamCallback(MQTT_STREAM_CALLBACK_SIGNATURE) {
+    this->streamCallback = streamCallback;
+    return *this;
+}
+
 PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE) {
     this->callback = callback;
     return *this;
@@ -742,6 +1077,14 @@ boolean PubSubClient::setBufferSize(uint16_t size) {
         // Cannot set it back to 0
         return false;
     }
+    if (this->bufferCapacity > 0) {
+        // The given buffer stays, only the part of it that is used changes
+        if (size > this->bufferCapacity) {
+            return false;
+        }
+        this->bufferSize = size;
+        return true;
+    }
     if (this->bufferSize == 0) {
         this->buffer = (uint8_t*)malloc(size);
     } else {
@@ -756,6 +1099,19 @@ boolean PubSubClient::setBufferSize(uint16_t size) {
     return (this->buffer != NULL);
 }
 
+boolean PubSubClient::setBuffer(uint8_t* buffer, uint16_t capacity) {
+    if (buffer == NULL || capacity == 0) {
+        return false;
+    }
+    if (this->bufferCapacity == 0) {
+        free(this->buffer);
+    }
+    this->buffer = buffer;
+    this->bufferCapacity = capacity;
+    this->bufferSize = capacity;
+    return true;
+}
+
 uint16_t PubSubClient::getBufferSize() {
     return this->bufferSize;
 }
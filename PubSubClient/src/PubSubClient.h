@@ -41,7 +41,23 @@
 //  pass the entire MQTT packet in each write call.
 //#define MQTT_MAX_TRANSFER_SIZE 80
 
+// MQTT_MAX_INFLIGHT : Maximum number of QoS 1 messages sent with publishQos1() that may be waiting
+//  for their PUBACK at once. Further ones are refused until an acknowledgement frees a slot.
+#ifndef MQTT_MAX_INFLIGHT
+#define MQTT_MAX_INFLIGHT 4
+#endif
+
+// MQTT_COALESCE_PUBLISH : collect the header, topic and payload of a message sent with
+//  beginPublish/write/endPublish in the packet buffer, and only pass them to the network client
+//  once the buffer is full or endPublish is called. Otherwise every write call reaches the client on
+//  its own, which on some clients (e.g. the ESP32 WiFiClient) sends a separate TCP segment each time.
+//  Set to 0 to pass every write call straight through.
+#ifndef MQTT_COALESCE_PUBLISH
+#define MQTT_COALESCE_PUBLISH 1
+#endif
+
 // Possible values for client.state()
+#define MQTT_CONNECTING             -5
 #define MQTT_CONNECTION_TIMEOUT     -4
 #define MQTT_CONNECTION_LOST        -3
 #define MQTT_CONNECT_FAILED         -2
@@ -79,8 +95,12 @@
 #if defined(ESP8266) || defined(ESP32)
 #include <functional>
 #define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+#define MQTT_PUBACK_CALLBACK_SIGNATURE std::function<void(uint16_t)> pubackCallback
+#define MQTT_STREAM_CALLBACK_SIGNATURE std::function<void(char*, uint32_t, uint8_t*, unsigned int, uint32_t)> streamCallback
 #else
 #define MQTT_CALLBACK_SIGNATURE void (*callback)(char*, uint8_t*, unsigned int)
+#define MQTT_PUBACK_CALLBACK_SIGNATURE void (*pubackCallback)(uint16_t)
+#define MQTT_STREAM_CALLBACK_SIGNATURE void (*streamCallback)(char*, uint32_t, uint8_t*, unsigned int, uint32_t)
 #endif
 
 #define CHECK_STRING_LENGTH(l,s) if (l+2+strnlen(s, this->bufferSize) > this->bufferSize) {_client->stop();return false;}
@@ -90,6 +110,8 @@ private:
    Client* _client;
    uint8_t* buffer;
    uint16_t bufferSize;
+   // Capacity of a buffer given with setBuffer, 0 while the buffer is allocated on the heap
+   uint16_t bufferCapacity = 0;
    uint16_t keepAlive;
    uint16_t socketTimeout;
    uint16_t nextMsgId;
@@ -97,9 +119,19 @@ private:
    unsigned long lastInActivity;
    bool pingOutstanding;
    MQTT_CALLBACK_SIGNATURE;
+   MQTT_PUBACK_CALLBACK_SIGNATURE = NULL;
+   MQTT_STREAM_CALLBACK_SIGNATURE = NULL;
+   // Packet identifiers of the QoS 1 messages waiting for their PUBACK, oldest first
+   uint16_t inflightIds[MQTT_MAX_INFLIGHT];
+   uint8_t inflightCount = 0;
    uint32_t readPacket(uint8_t*);
    boolean readByte(uint8_t * result);
    boolean readByte(uint8_t * result, uint16_t * index);
+   // Reads length bytes into result, as many at a time as the client has available
+   boolean readBytes(uint8_t * result, uint16_t length);
+   // Reads the rest of a PUBLISH too large for the buffer, whose fixed header of headerLength bytes is in the buffer,
+   // and passes its payload to the stream callback in pieces of what the topic leaves of the buffer
+   void readStreamedPublish(uint16_t headerLength, uint32_t length);
    boolean write(uint8_t header, uint8_t* buf, uint16_t length);
    uint16_t writeString(const char* string, uint8_t* buf, uint16_t pos);
    // Build up the header ready to send
@@ -107,6 +139,25 @@ private:
    // Note: the header is built at the end of the first MQTT_MAX_HEADER_SIZE bytes, so will start
    //       (MQTT_MAX_HEADER_SIZE - <returned size>) bytes into the buffer
    size_t buildHeader(uint8_t header, uint8_t* buf, uint16_t length);
+   // Reads the CONNACK of a connection started with beginConnect, if it has arrived
+   boolean pollConnect();
+#if defined(ESP32)
+   // lwIP socket of the connection given with setSocketFd, -1 to poll the client
+   int socketFd = -1;
+   // Waits in select() for the socket to become readable, for at most timeoutMs.
+   // Returns 1 if it is readable, 0 on the timeout, -1 if the socket failed
+   int waitReadable(uint32_t timeoutMs);
+#endif
+#if MQTT_COALESCE_PUBLISH
+   // Position in the buffer and length of the bytes of the message started with beginPublish,
+   // that have not been passed to the client yet
+   uint16_t publishStart = 0;
+   uint16_t publishLength = 0;
+   boolean publishActive = false;
+   boolean publishFailed = false;
+   // Passes the collected bytes to the client, returns false if not all of them were written
+   boolean flushPublish();
+#endif
    IPAddress ip;
    const char* domain;
    uint16_t port;
@@ -134,12 +185,25 @@ public:
    PubSubClient& setServer(uint8_t * ip, uint16_t port);
    PubSubClient& setServer(const char * domain, uint16_t port);
    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE);
+   // Called from loop() with the packet identifier returned by publishQos1(), once its PUBACK arrived
+   PubSubClient& setPubackCallback(MQTT_PUBACK_CALLBACK_SIGNATURE);
+   // Called from loop() for messages too large for the buffer, instead of dropping them. Their payload is read
+   // from the client straight into the buffer behind the topic and passed on in pieces, each with the topic, its
+   // offset in the payload, its bytes and length, and the total length of the payload. Messages that fit the
+   // buffer still go to the callback, so a small buffer is enough for OTA chunks or large attribute updates.
+   // Messages whose topic does not fit the buffer are still dropped
+   PubSubClient& setStreamCallback(MQTT_STREAM_CALLBACK_SIGNATURE);
    PubSubClient& setClient(Client& client);
    PubSubClient& setStream(Stream& stream);
    PubSubClient& setKeepAlive(uint16_t keepAlive);
    PubSubClient& setSocketTimeout(uint16_t timeout);
 
    boolean setBufferSize(uint16_t size);
+   // Use buffer, e.g. a static array or a PSRAM region, of capacity bytes instead of allocating one on the heap.
+   // The heap buffer is freed, the given one is never freed nor reallocated, later calls to setBufferSize
+   // only change how much of it is used, and fail for more than capacity. Returns 0 if buffer is NULL or
+   // capacity 0. Only call it while disconnected
+   boolean setBuffer(uint8_t* buffer, uint16_t capacity);
    uint16_t getBufferSize();
 
    boolean connect(const char* id);
@@ -147,6 +211,16 @@ public:
    boolean connect(const char* id, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage);
    boolean connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage);
    boolean connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession);
+   // Start to connect without waiting for the CONNACK of the server.
+   // Opens the network connection and sends CONNECT, state() is then MQTT_CONNECTING
+   // until loop() has read the CONNACK (or timed out after the socket timeout),
+   // meaning connected() only returns true once a call to loop() returned true.
+   // Opening the network connection itself still blocks, because the Client api has no other way
+   // Returns 1 if CONNECT was sent (or the client is already connected), 0 if there was an error
+   boolean beginConnect(const char* id, const char* user, const char* pass);
+   boolean beginConnect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession);
+   // Whether a connection started with beginConnect is still waiting for the CONNACK
+   boolean connecting();
    void disconnect();
    boolean publish(const char* topic, const char* payload);
    boolean publish(const char* topic, const char* payload, boolean retained);
@@ -154,6 +228,14 @@ public:
    boolean publish(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained);
    boolean publish_P(const char* topic, const char* payload, boolean retained);
    boolean publish_P(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained);
+   // Publish a message with QoS 1, without waiting for its PUBACK. Up to MQTT_MAX_INFLIGHT messages
+   // can be in flight, their acknowledgements are handled by loop() and reported to the puback callback.
+   // The message is not kept, if the connection is lost before its PUBACK arrived it has to be published
+   // again after reconnecting, the in flight messages are forgotten once connect is called.
+   // Returns the packet identifier of the message, 0 if it could not be sent or the window is full
+   uint16_t publishQos1(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained);
+   // Number of QoS 1 messages waiting for their PUBACK
+   uint8_t inflight();
    // Start to publish a message.
    // This API:
    //   beginPublish(...)
@@ -175,6 +257,20 @@ public:
    boolean subscribe(const char* topic, uint8_t qos);
    boolean unsubscribe(const char* topic);
    boolean loop();
+   // Milliseconds until loop() has to run even though nothing arrived: to send the keepalive ping, to give up on
+   // its answer, or to give up on the CONNACK of beginConnect. 0 if it is due or the client is not connected
+   unsigned long keepAliveDue();
+#if defined(ESP32)
+   // The lwIP socket the client reads from, e.g. WiFiClient::fd() once connect() returned, -1 to poll again.
+   // With it, a read waiting for the rest of a packet blocks in select() instead of spinning on available(),
+   // and waitForActivity() can sleep until bytes arrive. Only for clients whose bytes select() sees, i.e.
+   // not WiFiClientSecure, which holds decrypted bytes of its own. Forgotten on disconnect and reconnect
+   PubSubClient& setSocketFd(int fd);
+   // Blocks the calling task until bytes arrived, keepAliveDue() passed or maxWaitMs passed, whichever is first,
+   // so a task that only runs loop() sleeps while the connection is idle. Without a socket it returns at once.
+   // Returns whether loop() has something to do
+   boolean waitForActivity(uint32_t maxWaitMs);
+#endif
    boolean connected();
    int state();
 
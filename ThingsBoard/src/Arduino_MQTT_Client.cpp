@@ -14,6 +14,10 @@ void Arduino_MQTT_Client::set_client(Client & transport_client) {
     m_mqtt_client.setClient(transport_client);
 }
 
+void Arduino_MQTT_Client::set_non_blocking_connect(bool non_blocking) {
+    m_non_blocking_connect = non_blocking;
+}
+
 void Arduino_MQTT_Client::set_data_callback(Callback<void, char *, uint8_t *, unsigned int>::function callback) {
     m_mqtt_client.setCallback(callback);
 }
@@ -30,11 +34,33 @@ uint16_t Arduino_MQTT_Client::get_buffer_size() {
     return m_mqtt_client.getBufferSize();
 }
 
+bool Arduino_MQTT_Client::set_static_buffer(uint8_t * buffer, uint16_t capacity) {
+    return m_mqtt_client.setBuffer(buffer, capacity);
+}
+
+#if defined(ESP32)
+void Arduino_MQTT_Client::set_socket_fd(int fd) {
+    m_mqtt_client.setSocketFd(fd);
+}
+
+bool Arduino_MQTT_Client::wait_for_activity(uint32_t max_wait_ms) {
+    return m_mqtt_client.waitForActivity(max_wait_ms);
+}
+#endif
+
 void Arduino_MQTT_Client::set_server(char const * domain, uint16_t port) {
     m_mqtt_client.setServer(domain, port);
 }
 
 bool Arduino_MQTT_Client::connect(char const * client_id, char const * user_name, char const * password) {
+    if (m_non_blocking_connect) {
+        bool const result = m_mqtt_client.beginConnect(client_id, user_name, password);
+        // Was already connected, otherwise the callback is called by loop() once the broker accepted the connection
+        if (result && !m_mqtt_client.connecting()) {
+            m_connected_callback.Call_Callback();
+        }
+        return result;
+    }
     bool const result = m_mqtt_client.connect(client_id, user_name, password);
     m_connected_callback.Call_Callback();
     return result;
@@ -45,6 +71,14 @@ void Arduino_MQTT_Client::disconnect() {
 }
 
 bool Arduino_MQTT_Client::loop() {
+    if (m_mqtt_client.connecting()) {
+        if (!m_mqtt_client.loop()) {
+            // Still waiting for the broker is not an error, timing out or being refused is
+            return m_mqtt_client.connecting();
+        }
+        m_connected_callback.Call_Callback();
+        return true;
+    }
     return m_mqtt_client.loop();
 }
 
@@ -52,6 +86,10 @@ bool Arduino_MQTT_Client::publish(char const * topic, uint8_t const * payload, s
     return m_mqtt_client.publish(topic, payload, length, false);
 }
 
+bool Arduino_MQTT_Client::publish(char const * topic, uint8_t const * payload, size_t const & length, bool retained) {
+    return m_mqtt_client.publish(topic, payload, length, retained);
+}
+
 bool Arduino_MQTT_Client::subscribe(char const * topic) {
     return m_mqtt_client.subscribe(topic);
 }
@@ -64,7 +102,7 @@ bool Arduino_MQTT_Client::connected() {
     return m_mqtt_client.connected();
 }
 
-#if THINGSBOARD_ENABLE_STREAM_UTILS
+#if THINGSBOARD_ENABLE_STREAM_PUBLISH
 
 bool Arduino_MQTT_Client::begin_publish(char const * topic, size_t const & length) {
     return m_mqtt_client.beginPublish(topic, length, false);
@@ -74,14 +112,16 @@ bool Arduino_MQTT_Client::end_publish() {
     return m_mqtt_client.endPublish();
 }
 
+#if THINGSBOARD_ENABLE_STREAM_UTILS
 size_t Arduino_MQTT_Client::write(uint8_t payload_byte) {
     return m_mqtt_client.write(payload_byte);
 }
+#endif // THINGSBOARD_ENABLE_STREAM_UTILS
 
 size_t Arduino_MQTT_Client::write(uint8_t const * buffer, size_t const & size) {
     return m_mqtt_client.write(buffer, size);
 }
 
-#endif // THINGSBOARD_ENABLE_STREAM_UTILS
+#endif // THINGSBOARD_ENABLE_STREAM_PUBLISH
 
 #endif // ARDUINO
@@ -27,6 +27,14 @@ class Arduino_MQTT_Client : public IMQTT_Client {
     /// but the actual type of connection does not matter (Ethernet or WiFi)
     void set_client(Client & transport_client);
 
+    /// @brief Sets whether connect() waits for the broker to accept the connection or returns as soon as the connection request has been sent.
+    /// Without waiting, connect() returning true only means the request was sent and the following calls to loop() then wait for the answer of the broker,
+    /// once it accepted the connection loop() calls the callback set with set_connect_callback() and connected() returns true, until then loop() still returns true.
+    /// Allows to keep polling other peripherals while the broker takes its time to answer, instead of blocking for up to the socket timeout of the PubSubClient (15 seconds).
+    /// Opening the network connection itself still blocks, because the Arduino Client interface has no other way to do it, default = false
+    /// @param non_blocking Whether connect() should return without waiting for the broker to accept the connection
+    void set_non_blocking_connect(bool non_blocking);
+
     void set_data_callback(Callback<void, char *, uint8_t *, unsigned int>::function callback) override;
 
     void set_connect_callback(Callback<void>::function callback) override;
@@ -35,6 +43,28 @@ class Arduino_MQTT_Client : public IMQTT_Client {
 
     uint16_t get_buffer_size() override;
 
+    /// @brief Lets the PubSubClient use the given buffer, for example a static array or a region of PSRAM, instead of the one it allocates on the heap.
+    /// The buffer is never freed nor reallocated, so set_buffer_size() calls while running, like the ones of the OTA update to fit its chunks,
+    /// only change how much of it is used instead of fragmenting the heap over time, and fail if they ask for more than the given capacity.
+    /// Has to be called while disconnected
+    /// @param buffer Buffer that the PubSubClient sends and receives its packets in, has to exist as long as this instance
+    /// @param capacity Size of the buffer in bytes, the most any set_buffer_size() call can succeed with
+    /// @return Whether the buffer is used from now on or not, fails if it is nullptr or the capacity is 0
+    bool set_static_buffer(uint8_t * buffer, uint16_t capacity);
+
+#if defined(ESP32)
+    /// @brief Lets the PubSubClient wait for the given lwIP socket in select() instead of spinning on available(), while it reads the rest of a packet and in wait_for_activity().
+    /// Only works for network clients whose received bytes the socket shows, so for example WiFiClient but not WiFiClientSecure. Has to be set again after every connect()
+    /// @param fd Socket of the network client once connected, for example WiFiClient::fd(), -1 to go back to polling
+    void set_socket_fd(int fd);
+
+    /// @brief Blocks the calling task until data arrived on the socket given with set_socket_fd(), the keepalive of the connection is due or the given time passed,
+    /// so a task that only calls loop() can sleep while the connection is idle instead of polling it. Returns at once without a socket
+    /// @param max_wait_ms Longest time to block for in milliseconds
+    /// @return Whether loop() has something to do
+    bool wait_for_activity(uint32_t max_wait_ms);
+#endif
+
     void set_server(char const * domain, uint16_t port) override;
 
     bool connect(char const * client_id, char const * user_name, char const * password) override;
@@ -45,31 +75,43 @@ class Arduino_MQTT_Client : public IMQTT_Client {
 
     bool publish(char const * topic, uint8_t const * payload, size_t const & length) override;
 
+    /// @brief Sends the given payload like publish(), but with the retain flag set as given, meaning the broker keeps the last message of the topic
+    /// and hands it to every later subscriber, for example per value state topics of a broker on the local network
+    /// @param topic Topic that the message is sent over
+    /// @param payload Payload that should be sent
+    /// @param length Length of the payload in bytes
+    /// @param retained Whether the broker should retain the message
+    /// @return Whether publishing the payload on the given topic was successful or not
+    bool publish(char const * topic, uint8_t const * payload, size_t const & length, bool retained);
+
     bool subscribe(char const * topic) override;
 
     bool unsubscribe(char const * topic) override;
 
     bool connected() override;
 
-#if THINGSBOARD_ENABLE_STREAM_UTILS
+#if THINGSBOARD_ENABLE_STREAM_PUBLISH
 
     bool begin_publish(char const * topic, size_t const & length) override;
 
     bool end_publish() override;
 
+#if THINGSBOARD_ENABLE_STREAM_UTILS
     //----------------------------------------------------------------------------
     // Print interface
     //----------------------------------------------------------------------------
 
     size_t write(uint8_t payload_byte) override;
+#endif // THINGSBOARD_ENABLE_STREAM_UTILS
 
     size_t write(uint8_t const * buffer, size_t const & size) override;
 
-#endif // THINGSBOARD_ENABLE_STREAM_UTILS
+#endif // THINGSBOARD_ENABLE_STREAM_PUBLISH
 
   private:
-    Callback<void> m_connected_callback = {}; // Callback that will be called as soon as the mqtt client has connected
-    PubSubClient   m_mqtt_client = {};        // Underlying MQTT client instance used to send data
+    Callback<void> m_connected_callback = {};   // Callback that will be called as soon as the mqtt client has connected
+    PubSubClient   m_mqtt_client = {};          // Underlying MQTT client instance used to send data
+    bool           m_non_blocking_connect = {}; // Whether connect() returns without waiting for the CONNACK of the broker
 };
 
 #endif // ARDUINO
@@ -0,0 +1,126 @@
+#ifndef Arena_Allocator_h
+#define Arena_Allocator_h
+
+// Local include.
+#include "Configuration.h"
+
+#if THINGSBOARD_ENABLE_JSON_ARENA
+
+// Library includes.
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static_assert(ARDUINOJSON_VERSION_MAJOR >= 7, "THINGSBOARD_ENABLE_JSON_ARENA requires ArduinoJson 7, which allows to pass an ArduinoJson::Allocator to the JsonDocument");
+
+// Size in bytes of the buffer received responses are deserialized into. Has to hold the complete deserialized response, meaning every value and a copy of every key and string.
+// ArduinoJson allocates the values in pools of ARDUINOJSON_POOL_CAPACITY slots, that are at most 16 bytes each with ARDUINOJSON_USE_DOUBLE and ARDUINOJSON_USE_LONG_LONG,
+// and always allocates a full pool before shrinking the last one once deserialization is done, therefore the default fits one pool and the same amount again for the strings
+#ifndef THINGSBOARD_JSON_ARENA_SIZE
+#define THINGSBOARD_JSON_ARENA_SIZE (2U * ARDUINOJSON_POOL_CAPACITY * 16U)
+#endif // THINGSBOARD_JSON_ARENA_SIZE
+
+
+/// @brief ArduinoJson 7 allocator that hands out memory from a fixed buffer, which is a member of this class and therefore allocated once together with the owning instance.
+/// Allocations simply bump an offset into the buffer and deallocations only count down the amount of blocks that are still alive, once the last one is freed the complete buffer is handed out from the start again.
+/// Because a JsonDocument that is cleared or deserialized into again frees all its memory, a document that is kept alive and reused for every received message never calls malloc or free,
+/// which prevents the heap fragmentation that allocating a new document per message causes over long uptimes.
+/// Memory freed while other blocks are still alive is only reused once all of them are freed as well, the buffer therefore has to be big enough to hold one complete deserialized response
+/// @tparam Size Amount of bytes in the underlying buffer, if a document requires more the allocation fails and the deserialization returns DeserializationError::NoMemory
+template <size_t Size>
+class Arena_Allocator : public ArduinoJson::Allocator {
+  public:
+    /// @brief Constructor
+    Arena_Allocator(void) = default;
+
+    Arena_Allocator(Arena_Allocator const &) = delete;
+    Arena_Allocator & operator=(Arena_Allocator const &) = delete;
+
+    void* allocate(size_t size) override {
+        size_t const block_size = Aligned_Size(size);
+        if (block_size > Size - m_offset) {
+            return nullptr;
+        }
+        Header * header = reinterpret_cast<Header *>(m_buffer + m_offset);
+        header->size = size;
+        m_last_offset = m_offset;
+        m_offset += block_size;
+        m_alive++;
+        return header + 1U;
+    }
+
+    void deallocate(void* ptr) override {
+        if (ptr == nullptr || m_alive == 0U) {
+            return;
+        }
+        m_alive--;
+        if (m_alive == 0U) {
+            m_offset = 0U;
+            m_last_offset = 0U;
+        }
+    }
+
+    void* reallocate(void* ptr, size_t new_size) override {
+        if (ptr == nullptr) {
+            return allocate(new_size);
+        }
+        Header * header = static_cast<Header *>(ptr) - 1U;
+        size_t const header_offset = reinterpret_cast<uint8_t *>(header) - m_buffer;
+        // The most recently allocated block can grow or shrink in place, which is the common case because ArduinoJson grows the string it is currently reading and shrinks the last pool once done
+        if (header_offset == m_last_offset) {
+            size_t const block_size = Aligned_Size(new_size);
+            if (block_size > Size - header_offset) {
+                return nullptr;
+            }
+            header->size = new_size;
+            m_offset = header_offset + block_size;
+            return ptr;
+        }
+        else if (new_size <= header->size) {
+            header->size = new_size;
+            return ptr;
+        }
+        void * const new_ptr = allocate(new_size);
+        if (new_ptr == nullptr) {
+            return nullptr;
+        }
+        memcpy(new_ptr, ptr, header->size);
+        deallocate(ptr);
+        return new_ptr;
+    }
+
+    /// @brief Returns the amount of bytes that are currently handed out, including the padding and the size stored in front of each block
+    /// @return Amount of used bytes in the underlying buffer
+    size_t Get_Used_Size() const {
+        return m_offset;
+    }
+
+    /// @brief Returns the size of the underlying buffer
+    /// @return Size of the underlying buffer in bytes
+    static size_t constexpr Get_Capacity() {
+        return Size;
+    }
+
+  private:
+    // Stored in front of every block, because reallocate needs to know how much to copy when a block that is not the last one is grown
+    struct alignas(max_align_t) Header {
+        size_t size;
+    };
+
+    /// @brief Returns the amount of bytes a block of the given size takes in the buffer
+    /// @param size Amount of bytes that were requested
+    /// @return Size of the block including its header, rounded up so the following block is aligned as well
+    static size_t constexpr Aligned_Size(size_t size) {
+        return sizeof(Header) + ((size + alignof(Header) - 1U) & ~(alignof(Header) - 1U));
+    }
+
+    alignas(Header) uint8_t m_buffer[Size] = {}; // Underlying buffer all allocations are handed out from
+    size_t                  m_offset = {};       // Offset of the first byte that has not been handed out yet
+    size_t                  m_last_offset = {};  // Offset of the header of the most recently allocated block
+    size_t                  m_alive = {};        // Amount of blocks that were allocated but not deallocated yet
+};
+
+#endif // THINGSBOARD_ENABLE_JSON_ARENA
+
+#endif // Arena_Allocator_h
@@ -83,47 +83,33 @@ class Attribute_Request : public IAPI_Implementation {
 
     void Process_Json_Response(char const * topic, JsonDocument const & data) override {
         size_t const request_id = Helper::parseRequestId(ATTRIBUTE_RESPONSE_TOPIC, topic);
-        JsonObjectConst object = data.template as<JsonObjectConst>();
+        JsonObjectConst const object = data.template as<JsonObjectConst>();
 
-#if THINGSBOARD_ENABLE_STL
-#if THINGSBOARD_ENABLE_DYNAMIC
-        auto it = std::find_if(m_attribute_request_callbacks.begin(), m_attribute_request_callbacks.end(), [&request_id](Attribute_Request_Callback & attribute_request) {
-#else
-        auto it = std::find_if(m_attribute_request_callbacks.begin(), m_attribute_request_callbacks.end(), [&request_id](Attribute_Request_Callback<MaxAttributes> & attribute_request) {
-#endif // THINGSBOARD_ENABLE_DYNAMIC
-            return attribute_request.Get_Request_ID() == request_id;
-        });
-        if (it != m_attribute_request_callbacks.end()) {
-            auto & attribute_request = *it;
-#else
-        for (auto it = m_attribute_request_callbacks.begin(); it != m_attribute_request_callbacks.end(); ++it) {
-            auto & attribute_request = *it;
-
-            if (attribute_request.Get_Request_ID() != request_id) {
-                continue;
-            }
-#endif // THINGSBOARD_ENABLE_STL
+        // All callbacks that were sent together in one request share its request id and are stored next to each other
+        size_t const first = Find_Request(request_id);
+        size_t last = first;
+        for (; last < m_attribute_request_callbacks.size() - m_pending_requests && m_attribute_request_callbacks[last].Get_Request_ID() == request_id; ++last) {
+            auto & attribute_request = m_attribute_request_callbacks[last];
             char const * attribute_response_key = attribute_request.Get_Attribute_Key();
             if (attribute_response_key == nullptr) {
 #if THINGSBOARD_ENABLE_DEBUG
                 Logger::println(ATT_KEY_NOT_FOUND);
 #endif // THINGSBOARD_ENABLE_DEBUG
-                goto delete_callback;
+                continue;
             }
 
-            if (object.containsKey(attribute_response_key)) {
-                object = object[attribute_response_key];
+            JsonObjectConst response = object;
+            if (!response[attribute_response_key].isNull()) {
+                response = response[attribute_response_key];
             }
 
             attribute_request.Stop_Timeout_Timer();
-            attribute_request.Call_Callback(object);
-
-            delete_callback:
-            // Delete callback because the changes have been requested and the callback is no longer needed
-            Helper::remove(m_attribute_request_callbacks, it);
-#if !THINGSBOARD_ENABLE_STL
-            break;
-#endif // !THINGSBOARD_ENABLE_STL
+            attribute_request.Call_Callback(response);
+        }
+
+        // Delete callbacks because the changes have been requested and the callbacks are no longer needed
+        for (size_t i = first; i < last; ++i) {
+            Helper::remove(m_attribute_request_callbacks, m_attribute_request_callbacks.begin() + first);
         }
 
         // Unsubscribe from the shared attribute request topic,
@@ -138,6 +124,10 @@ class Attribute_Request : public IAPI_Implementation {
         return strncmp(ATTRIBUTE_RESPONSE_TOPIC, topic, strlen(ATTRIBUTE_RESPONSE_TOPIC)) == 0;
     }
 
+    char const * Get_Response_Topic_Prefix() const override {
+        return ATTRIBUTE_RESPONSE_TOPIC;
+    }
+
     bool Unsubscribe() override {
         return Attributes_Request_Unsubscribe();
     }
@@ -158,6 +148,17 @@ class Attribute_Request : public IAPI_Implementation {
         // Nothing to do
     }
 
+    void Flush() override {
+#if THINGSBOARD_ENABLE_ATTRIBUTE_REQUEST_COALESCING
+        if (m_pending_requests == 0U) {
+            return;
+        }
+        size_t const first = m_attribute_request_callbacks.size() - m_pending_requests;
+        m_pending_requests = 0U;
+        (void)Send_Request(first);
+#endif // THINGSBOARD_ENABLE_ATTRIBUTE_REQUEST_COALESCING
+    }
+
     void Set_Client_Callbacks(Callback<void, IAPI_Implementation &>::function subscribe_api_callback, Callback<bool, char const * const, JsonDocument const &, size_t const &>::function send_json_callback, Callback<bool, char const * const, char const * const>::function send_json_string_callback, Callback<bool, char const * const>::function subscribe_topic_callback, Callback<bool, char const * const>::function unsubscribe_topic_callback, Callback<uint16_t>::function get_size_callback, Callback<bool, uint16_t>::function set_buffer_size_callback, Callback<size_t *>::function get_request_id_callback) override {
         m_send_json_callback.Set_Callback(send_json_callback);
         m_subscribe_topic_callback.Set_Callback(subscribe_topic_callback);
@@ -205,43 +206,43 @@ class Attribute_Request : public IAPI_Implementation {
             return false;
         }
 
-        // String are const char* and therefore stored as a pointer --> zero copy, meaning the size for the strings is 0 bytes,
-        // Data structure size depends on the amount of key value pairs passed + the default clientKeys or sharedKeys
-        // See https://arduinojson.org/v6/assistant/ for more information on the needed size for the JsonDocument
-        StaticJsonDocument<JSON_OBJECT_SIZE(1)> request_buffer;
+        registered_callback->Set_Attribute_Key(attribute_response_key);
+        registered_callback->Start_Timeout_Timer();
+#if THINGSBOARD_ENABLE_ATTRIBUTE_REQUEST_COALESCING
+        // Held back until the next Flush(), so every request made before it is combined into one message. The request id is only given once it is sent
+        ++m_pending_requests;
+        return true;
+#else
+        return Send_Request(m_attribute_request_callbacks.size() - 1U);
+#endif // THINGSBOARD_ENABLE_ATTRIBUTE_REQUEST_COALESCING
+    }
 
-        // Calculate the size required for the char buffer containing all the attributes seperated by a comma,
-        // before initalizing it so it is possible to allocate it on the stack
-        size_t size = 0U;
-        for (const auto & att : attributes) {
-            if (Helper::stringIsNullorEmpty(att)) {
-                continue;
-            }
+    /// @brief Sends one request for the keys of all callbacks from the given position to the end of the registered callbacks, and gives all of them its request id
+    /// @param first Position of the first callback in m_attribute_request_callbacks that should be requested
+    /// @return Whether sending the request was successful or not
+    bool Send_Request(size_t const & first) {
+        TBJsonDocument request_buffer;
 
-            size += strlen(att);
-            size += strlen(",");
-        }
+        // Calculate the size required for the char buffers containing all the attributes seperated by a comma,
+        // before initalizing them so it is possible to allocate them on the stack
+        size_t const client_size = Keys_Size(first, CLIENT_RESPONSE_KEY);
+        size_t const shared_size = Keys_Size(first, SHARED_RESPONSE_KEY);
 
-        // Initalizes complete array to 0, required because strncat needs both destination and source to contain proper null terminated strings
-        char request[size] = {};
-        for (const auto & att : attributes) {
-            if (Helper::stringIsNullorEmpty(att)) {
-#if THINGSBOARD_ENABLE_DEBUG
-                Logger::println(ATT_KEY_IS_NULL);
-#endif // THINGSBOARD_ENABLE_DEBUG
-                continue;
-            }
-
-            strncat(request, att, size);
-            size -= strlen(att);
-            strncat(request, ",", size);
-            size -= strlen(",");
-        }
+        // Initalizes complete arrays to 0, required because strncat needs both destination and source to contain proper null terminated strings
+        char client_request[client_size + 1U] = {};
+        char shared_request[shared_size + 1U] = {};
+        Join_Keys(first, CLIENT_RESPONSE_KEY, client_request, client_size);
+        Join_Keys(first, SHARED_RESPONSE_KEY, shared_request, shared_size);
 
         // Ensure to cast to const, this is done so that ArduinoJson does not copy the value but instead simply store the pointer, which does not require any more memory,
         // besides the base size needed to allocate one key-value pair. Because if we don't the char array would be copied
         // and because there is not enough space the value would simply be "undefined" instead. Which would cause the request to not be sent correctly
-        request_buffer[attribute_request_key] = static_cast<const char*>(request);
+        if (client_size != 0U) {
+            request_buffer[CLIENT_REQUEST_KEYS] = static_cast<const char*>(client_request);
+        }
+        if (shared_size != 0U) {
+            request_buffer[SHARED_REQUEST_KEY] = static_cast<const char*>(shared_request);
+        }
 
         size_t * p_request_id = m_get_request_id_callback.Call_Callback();
         if (p_request_id == nullptr) {
@@ -249,16 +250,86 @@ class Attribute_Request : public IAPI_Implementation {
             return false;
         }
         auto & request_id = *p_request_id;
+        ++request_id;
 
-        registered_callback->Set_Request_ID(++request_id);
-        registered_callback->Set_Attribute_Key(attribute_response_key);
-        registered_callback->Start_Timeout_Timer();
+        for (size_t i = first; i < m_attribute_request_callbacks.size(); ++i) {
+            m_attribute_request_callbacks[i].Set_Request_ID(request_id);
+        }
 
         char topic[Helper::detectSize(ATTRIBUTE_REQUEST_TOPIC, request_id)] = {};
         (void)snprintf(topic, sizeof(topic), ATTRIBUTE_REQUEST_TOPIC, request_id);
         return m_send_json_callback.Call_Callback(topic, request_buffer, Helper::Measure_Json(request_buffer));
     }
 
+    /// @brief Calculates the length of the keys of all callbacks from the given position on, that receive their response on the given key, seperated by a comma
+    /// @param first Position of the first callback in m_attribute_request_callbacks that should be requested
+    /// @param attribute_response_key Key of the key-value pair that will contain the attributes we got as a response ("client" or "shared")
+    /// @return Length of the comma seperated keys, without the null terminator
+    size_t Keys_Size(size_t const & first, char const * attribute_response_key) const {
+        size_t size = 0U;
+        for (size_t i = first; i < m_attribute_request_callbacks.size(); ++i) {
+            auto const & attribute_request = m_attribute_request_callbacks[i];
+            if (attribute_request.Get_Attribute_Key() == nullptr || strcmp(attribute_request.Get_Attribute_Key(), attribute_response_key) != 0) {
+                continue;
+            }
+            for (const auto & att : attribute_request.Get_Attributes()) {
+                if (Helper::stringIsNullorEmpty(att)) {
+                    continue;
+                }
+
+                size += strlen(att);
+                size += strlen(",");
+            }
+        }
+        return size;
+    }
+
+    /// @brief Writes the keys of all callbacks from the given position on, that receive their response on the given key, seperated by a comma into the given buffer
+    /// @param first Position of the first callback in m_attribute_request_callbacks that should be requested
+    /// @param attribute_response_key Key of the key-value pair that will contain the attributes we got as a response ("client" or "shared")
+    /// @param request Buffer the keys are appended to, has to be null terminated
+    /// @param size Length of the keys, as calculated by Keys_Size()
+    void Join_Keys(size_t const & first, char const * attribute_response_key, char * request, size_t size) const {
+        for (size_t i = first; i < m_attribute_request_callbacks.size(); ++i) {
+            auto const & attribute_request = m_attribute_request_callbacks[i];
+            if (attribute_request.Get_Attribute_Key() == nullptr || strcmp(attribute_request.Get_Attribute_Key(), attribute_response_key) != 0) {
+                continue;
+            }
+            for (const auto & att : attribute_request.Get_Attributes()) {
+                if (Helper::stringIsNullorEmpty(att)) {
+#if THINGSBOARD_ENABLE_DEBUG
+                    Logger::println(ATT_KEY_IS_NULL);
+#endif // THINGSBOARD_ENABLE_DEBUG
+                    continue;
+                }
+
+                strncat(request, att, size);
+                size -= strlen(att);
+                strncat(request, ",", size);
+                size -= strlen(",");
+            }
+        }
+    }
+
+    /// @brief Searches the sent requests for the first callback with the given request id. Request ids are given in ascending order and callbacks are appended,
+    /// therefore the sent requests are always sorted by it and can be searched with a binary search, instead of comparing every one of them
+    /// @param request_id Request id of the received response
+    /// @return Position of the first callback with the given request id in m_attribute_request_callbacks, or the end of the sent requests if there is none
+    size_t Find_Request(size_t const & request_id) const {
+        size_t first = 0U;
+        size_t last = m_attribute_request_callbacks.size() - m_pending_requests;
+        while (first < last) {
+            size_t const middle = first + (last - first) / 2U;
+            if (m_attribute_request_callbacks[middle].Get_Request_ID() < request_id) {
+                first = middle + 1U;
+            }
+            else {
+                last = middle;
+            }
+        }
+        return first;
+    }
+
     /// @brief Subscribes to attribute response topic
     /// @param callback Callback method that will be called
     /// @param registered_callback Editable pointer to a reference of the local version that was copied from the passed callback
@@ -288,6 +359,7 @@ class Attribute_Request : public IAPI_Implementation {
     /// and from the  attribute response topic, was successful or not
     bool Attributes_Request_Unsubscribe() {
         m_attribute_request_callbacks.clear();
+        m_pending_requests = 0U;
         return m_unsubscribe_topic_callback.Call_Callback(ATTRIBUTE_RESPONSE_SUBSCRIBE_TOPIC);
     }
 
@@ -295,6 +367,7 @@ class Attribute_Request : public IAPI_Implementation {
     Callback<bool, char const * const>                                       m_subscribe_topic_callback = {};    // Subscribe mqtt topic client callback
     Callback<bool, char const * const>                                       m_unsubscribe_topic_callback = {};  // Unubscribe mqtt topic client callback
     Callback<size_t *>                                                       m_get_request_id_callback = {};     // Get internal request id callback
+    size_t                                                                   m_pending_requests = {};            // Amount of callbacks at the end of m_attribute_request_callbacks, whose request has not been sent yet
 
     // Vectors or array (depends on wheter if THINGSBOARD_ENABLE_DYNAMIC is set to 1 or 0), hold copy of the actual passed data, this is to ensure they stay valid,
     // even if the user only temporarily created the object before the method was called.
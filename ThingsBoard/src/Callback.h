@@ -8,6 +8,7 @@
 #else
 #include "Array.h"
 #endif // !THINGSBOARD_ENABLE_STL && THINGSBOARD_ENABLE_DYNAMIC
+#include "Inline_Function.h"
 
 // Library includes.
 #include <ArduinoJson.h>
@@ -33,7 +34,9 @@ template<typename return_typ, typename... argument_types>
 class Callback {
   public:
     /// @brief Callback signature
-#if THINGSBOARD_ENABLE_STL
+#if THINGSBOARD_ENABLE_STL && THINGSBOARD_ENABLE_INLINE_CALLBACK
+    using function = Inline_Function<return_typ(argument_types... arguments), THINGSBOARD_CALLBACK_INLINE_SIZE>;
+#elif THINGSBOARD_ENABLE_STL
     using function = std::function<return_typ(argument_types... arguments)>;
 #else
     using function = return_typ (*)(argument_types... arguments);
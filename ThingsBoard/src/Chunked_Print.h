@@ -0,0 +1,98 @@
+#ifndef Chunked_Print_h
+#define Chunked_Print_h
+
+// Local include.
+#include "Configuration.h"
+
+#if THINGSBOARD_ENABLE_STREAM_PUBLISH && !THINGSBOARD_ENABLE_STREAM_UTILS
+
+// Local includes.
+#include "Constants.h"
+#include "IMQTT_Client.h"
+
+// Library includes.
+#include <Print.h>
+#include <string.h>
+
+
+/// @brief Print that collects the bytes written into it in a small fixed buffer and forwards them in chunks to the payload of a message started with IMQTT_Client::begin_publish().
+/// Replacement for the BufferingPrint of the StreamUtils library, if it is not used, because the client interface only has to support writing buffers instead of being a Print itself.
+/// Ensures serializeJson() or Printable::printTo(), which often write single characters, cause one write call to the underlying client per chunk instead of per byte,
+/// while the required memory stays the same no matter how big the complete message is.
+/// Any bytes still in the buffer have to be sent with flush() before calling IMQTT_Client::end_publish(), once a write to the client failed all following bytes are discarded
+/// @tparam ChunkSize Amount of bytes collected before they are written to the client, default = Default_Chunk_Size (64)
+template <size_t ChunkSize = Default_Chunk_Size>
+class Chunked_Print : public Print {
+  public:
+    /// @brief Constructor
+    /// @param client MQTT client the payload of the message that has been started with begin_publish() is written to
+    explicit Chunked_Print(IMQTT_Client & client)
+      : m_client(client)
+      , m_buffer()
+      , m_size(0U)
+      , m_failed(false)
+    {
+        // Nothing to do
+    }
+
+    size_t write(uint8_t payload_byte) override {
+        if (m_failed) {
+            return 0U;
+        }
+        if (m_size == ChunkSize) {
+            flush();
+            if (m_failed) {
+                return 0U;
+            }
+        }
+        m_buffer[m_size++] = payload_byte;
+        return 1U;
+    }
+
+    size_t write(uint8_t const * buffer, size_t size) override {
+        if (m_failed) {
+            return 0U;
+        }
+        // Chunks that would not fit into the remaining buffer anyway are written directly, to skip copying them first
+        if (size > ChunkSize - m_size) {
+            flush();
+            if (m_failed) {
+                return 0U;
+            }
+            if (size >= ChunkSize) {
+                if (m_client.write(buffer, size) != size) {
+                    m_failed = true;
+                    return 0U;
+                }
+                return size;
+            }
+        }
+        memcpy(m_buffer + m_size, buffer, size);
+        m_size += size;
+        return size;
+    }
+
+    void flush() override {
+        if (m_size == 0U || m_failed) {
+            return;
+        }
+        m_failed = m_client.write(m_buffer, m_size) != m_size;
+        m_size = 0U;
+    }
+
+    /// @brief Whether writing any of the chunks to the client failed, in which case the message is incomplete and should not be finished
+    /// @return Whether writing to the underlying client failed
+    bool Failed() const {
+        return m_failed;
+    }
+
+  private:
+    IMQTT_Client & m_client;              // MQTT client the chunks are written to
+    uint8_t        m_buffer[ChunkSize];   // Bytes that have been written but not yet been sent
+    size_t         m_size;                // Amount of bytes in the buffer
+    bool           m_failed;              // Whether writing to the client failed
+};
+
+#endif // THINGSBOARD_ENABLE_STREAM_PUBLISH && !THINGSBOARD_ENABLE_STREAM_UTILS
+
+#endif // Chunked_Print_h
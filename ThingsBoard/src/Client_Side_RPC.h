@@ -12,8 +12,8 @@ char constexpr RPC_RESPONSE_TOPIC[] = "v1/devices/me/rpc/response/";
 char constexpr RPC_SEND_REQUEST_TOPIC[] = "v1/devices/me/rpc/request/%u";
 // Log messages.
 char constexpr CLIENT_RPC_METHOD_NULL[] = "Client-side RPC method name is NULL";
+char constexpr RPC_REQUEST_OVERFLOWED[] = "Client-side RPC request overflowed, allocating its memory failed. Ensure there is enough heap memory left";
 #if !THINGSBOARD_ENABLE_DYNAMIC
-char constexpr RPC_REQUEST_OVERFLOWED[] = "Client-side RPC request overflowed, increase MaxRequestRPC (%u)";
 char constexpr CLIENT_SIDE_RPC_SUBSCRIPTIONS[] = "client-side RPC";
 #endif // !THINGSBOARD_ENABLE_DYNAMIC
 char constexpr RPC_EMPTY_PARAMS_VALUE[] = "{}";
@@ -27,10 +27,7 @@ template <typename Logger = DefaultLogger>
 #else
 /// @tparam MaxSubscriptions Maximum amount of simultaneous client side rpc requests.
 /// Once the maximum amount has been reached it is not possible to increase the size, this is done because it allows to allcoate the memory on the stack instead of the heap, default = Default_Subscriptions_Amount (1)
-/// @tparam MaxRequestRPC Maximum amount of key-value pairs that will ever be sent as parameters to the requests client side rpc method, allows to use a StaticJsonDocument on the stack in the background.
-/// Is expected to only request client side rpc requests, that do not additionally send any parameters. If we attempt to send parameters, we have to adjust the size accordingly.
-/// Default value is big enough to hold no parameters, but simply the default method name and params key needed for the request, if additional parameters are sent with the request the size has to be increased by one for each key-value pair.
-/// See https://arduinojson.org/v6/assistant/ for more information on how to estimate the required size and divide the result by 16 and add 2 to receive the required MaxRequestRPC value, default = Default_Request_RPC_Amount (2)
+/// @tparam MaxRequestRPC Not used anymore, because the ArduinoJson 7 JsonDocument the request is created in grows as required. Only kept to not break existing code that passes it, default = Default_Request_RPC_Amount (2)
 template<size_t MaxSubscriptions = Default_Subscriptions_Amount, size_t MaxRequestRPC = Default_Request_RPC_Amount, typename Logger = DefaultLogger>
 #endif // THINGSBOARD_ENABLE_DYNAMIC
 class Client_Side_RPC : public IAPI_Implementation {
@@ -62,15 +59,7 @@ class Client_Side_RPC : public IAPI_Implementation {
 
         JsonArray const * parameters = callback.Get_Parameters();
 
-#if THINGSBOARD_ENABLE_DYNAMIC
-        // String are const char* and therefore stored as a pointer --> zero copy, meaning the size for the strings is 0 bytes,
-        // Data structure size depends on the amount of key value pairs passed + the default method name and params key needed for the request.
-        // See https://arduinojson.org/v6/assistant/ for more information on the needed size for the JsonDocument
-        TBJsonDocument request_buffer(JSON_OBJECT_SIZE(parameters != nullptr ? parameters->size() + 2U : 2U));
-#else
-        // Ensure to have enough size for the infinite amount of possible parameters that could be sent to the cloud
-        StaticJsonDocument<JSON_OBJECT_SIZE(MaxRequestRPC)> request_buffer;
-#endif // THINGSBOARD_ENABLE_DYNAMIC
+        TBJsonDocument request_buffer;
 
         request_buffer[RPC_METHOD_KEY] = method_name;
 
@@ -81,12 +70,10 @@ class Client_Side_RPC : public IAPI_Implementation {
             request_buffer[RPC_PARAMS_KEY] = RPC_EMPTY_PARAMS_VALUE;
         }
 
-#if !THINGSBOARD_ENABLE_DYNAMIC
         if (request_buffer.overflowed()) {
-            Logger::printfln(RPC_REQUEST_OVERFLOWED, MaxRequestRPC);
+            Logger::println(RPC_REQUEST_OVERFLOWED);
             return false;
         }
-#endif // !THINGSBOARD_ENABLE_DYNAMIC
 
         size_t * p_request_id = m_get_request_id_callback.Call_Callback();
         if (p_request_id == nullptr) {
@@ -150,6 +137,10 @@ class Client_Side_RPC : public IAPI_Implementation {
         return strncmp(RPC_RESPONSE_TOPIC, topic, strlen(RPC_RESPONSE_TOPIC)) == 0;
     }
 
+    char const * Get_Response_Topic_Prefix() const override {
+        return RPC_RESPONSE_TOPIC;
+    }
+
     bool Unsubscribe() override {
         return RPC_Request_Unsubscribe();
     }
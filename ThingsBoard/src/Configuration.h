@@ -17,7 +17,7 @@
 #  endif
 
 // Enabled the usage of int64_t and double values with ArduinoJson. Making the JsonVariant store double and int64_t instead of float and int32_t.
-// See https://arduinojson.org/v6/api/config/use_long_long/ for more information.
+// See https://arduinojson.org/v7/api/config/use_long_long/ for more information.
 #define ARDUINOJSON_USE_LONG_LONG 1
 #define ARDUINOJSON_USE_DOUBLE 1
 
@@ -114,9 +114,23 @@
 #    endif
 #  endif
 
+// Use the nvs header internally for persisting the progress of ota updates, as long as the header exists,
+// to allow users that do have the needed component to use the Espressif_OTA_Resume_Store and continue an interrupted update where it broke off.
+// Only exists following major version 2 minor version 0 on ESP32 (https://github.com/espressif/esp-idf/releases/tag/v2.0) and major version 3 minor version 0 on ESP8266 (https://github.com/espressif/ESP8266_RTOS_SDK/releases/tag/v3.0-rc1).
+#  ifndef THINGSBOARD_USE_ESP_NVS
+#    ifdef __has_include
+#      if __has_include(<nvs.h>) && THINGSBOARD_USE_ESP_PARTITION
+#        define THINGSBOARD_USE_ESP_NVS 1
+#      else
+#        define THINGSBOARD_USE_ESP_NVS 0
+#      endif
+#    else
+#      define THINGSBOARD_USE_ESP_NVS 0
+#    endif
+#  endif
+
 // Enables the ThingsBoard class to be fully dynamic instead of requiring template arguments to statically allocate memory.
 // If enabled the program might be slightly slower and all the memory will be placed onto the heap instead of the stack.
-// See https://arduinojson.org/v6/api/dynamicjsondocument/ for the main difference in the underlying code.
 // Can also optionally be configured via the ESP-IDF menuconfig, if that is the done the value is set to the value entered in the menuconfig,
 // if the value is manually overriden tough with a #define before including ThingsBoard then the hardcoded value takes precendence.
 #  ifndef THINGSBOARD_ENABLE_DYNAMIC
@@ -135,7 +149,7 @@
 // Use the StreamUtils header internally for enabling the usage of an additonal library as a fallback, as long as the header exists,
 // to allwo to directly serialize a json message that is sent to the cloud, if the size of that message would be bigger than the internal buffer size of the client.
 // Allows sending much bigger messages than would otherwise be possible, and without the need to increase stack or heap requirements, but at the cost of increased send times.
-// See https://arduinojson.org/v6/how-to/use-arduinojson-with-pubsubclient/#serializing-a-json-document-into-an-mqtt-message for the main difference in the underlying code.
+// See https://arduinojson.org/v7/how-to/use-arduinojson-with-pubsubclient/#serializing-a-json-document-into-an-mqtt-message for the main difference in the underlying code.
 // Option can only be enabled when using Arduino, because this feature relies on Arduino as it improves the underlying data streams to directly write the data into the MQTT Client,
 // but writing each byte one by one, would be too slow, therefore the ArduinoStreamUtils (https://github.com/bblanchon/ArduinoStreamUtils) library is used to buffer those calls into bigger packets.
 // This allows sending data that is very big without requiring to allocate that much memory, because it is sent in smaller packets.
@@ -152,10 +166,21 @@
 #    endif
 #  endif
 
-// Enables the ThingsBoard class to save the allocated memory of the DynamicJsonDocument into psram instead of onto the sram.
-// Enabled by default if THINGSBOARD_ENABLE_DYNAMIC has been set and the esp_heap_caps header exists, because it requries DynamicJsonDocument to work.
+// Enables the ThingsBoard class to stream a json message straight into the client with begin_publish(), write() and end_publish() in chunks, if it is bigger than the buffer size of the client,
+// or if it is sent from a Printable that writes its own json. Unlike THINGSBOARD_ENABLE_STREAM_UTILS no additional library is required, because the chunks are collected in a small fixed buffer on the stack (see Chunked_Print.h),
+// and only the IMQTT_Client interface implementation needs to support streaming the payload of a message. Meaning the required memory does not depend on the size of the sent message anymore.
+// Enabled by default, because PubSubClient used by the Arduino_MQTT_Client supports it. Required and therefore always enabled if THINGSBOARD_ENABLE_STREAM_UTILS has been set, which then buffers with BufferingPrint instead.
+#  ifndef THINGSBOARD_ENABLE_STREAM_PUBLISH
+#    define THINGSBOARD_ENABLE_STREAM_PUBLISH 1
+#  endif
+#  if THINGSBOARD_ENABLE_STREAM_UTILS && !THINGSBOARD_ENABLE_STREAM_PUBLISH
+#    error "THINGSBOARD_ENABLE_STREAM_UTILS requires THINGSBOARD_ENABLE_STREAM_PUBLISH"
+#  endif
+
+// Enables the ThingsBoard class to save the allocated memory of the JsonDocument into psram instead of onto the sram.
+// Enabled by default if THINGSBOARD_ENABLE_DYNAMIC has been set and the esp_heap_caps header exists.
 // If enabled the program might be slightly slower, but all the memory will be placed onto psram instead of sram, meaning the sram can be allocated for other things.
-// See https://arduinojson.org/v6/how-to/use-external-ram-on-esp32/ and https://arduinojson.org/v6/api/basicjsondocument/ for the main difference in the underlying code.
+// See https://arduinojson.org/v7/how-to/use-external-ram-on-esp32/ and https://arduinojson.org/v7/api/jsondocument/ for the main difference in the underlying code.
 #  ifndef THINGSBOARD_ENABLE_PSRAM
 #    ifdef __has_include
 #      if THINGSBOARD_ENABLE_DYNAMIC && __has_include(<esp_heap_caps.h>)
@@ -168,4 +193,34 @@
 #    endif
 #  endif
 
+// Enables the ThingsBoard class to deserialize every received response into one JsonDocument that is kept alive for the lifetime of the instance,
+// and whose memory is handed out by an allocator from a fixed buffer of THINGSBOARD_JSON_ARENA_SIZE bytes, allocated once together with the instance (see Arena_Allocator.h for its default).
+// Removes the need to estimate the required size by counting the symbols in the payload beforehand and removes the malloc and free of the document for every received message,
+// which otherwise fragments the heap over long uptimes. Responses that do not fit into the buffer fail deserialization with DeserializationError::NoMemory.
+// Requires ArduinoJson 7, because only following that version an ArduinoJson::Allocator can be passed to the JsonDocument, see https://arduinojson.org/v7/api/jsondocument/ for more information.
+#  ifndef THINGSBOARD_ENABLE_JSON_ARENA
+#    define THINGSBOARD_ENABLE_JSON_ARENA 0
+#  endif
+
+// Size in bytes of a buffer kept in the ThingsBoard class, that payloads too big for the stack (see setMaximumStackSize) are serialized into before they are sent,
+// instead of allocating and freeing a buffer on the heap for every one of them. Together with THINGSBOARD_ENABLE_JSON_ARENA sending and receiving then does no heap allocation at all.
+// Payloads bigger than the buffer still fall back to the heap. 0 disables the buffer, meaning every payload too big for the stack is allocated on the heap.
+#  ifndef THINGSBOARD_SEND_BUFFER_SIZE
+#    define THINGSBOARD_SEND_BUFFER_SIZE 0
+#  endif
+
+// Enables storing the callbacks in an Inline_Function instead of a std::function, if the C++ STL is used. The wrapped lambda, function object or std::bind is placed inside of the callback itself,
+// into THINGSBOARD_CALLBACK_INLINE_SIZE bytes (see Inline_Function.h for its default), therefore creating or copying a callback never allocates on the heap.
+// Callables that are bigger fail to compile, instead of silently being allocated on the heap. Calling the callback goes through a single function pointer instead of the virtual dispatch of std::function
+#  ifndef THINGSBOARD_ENABLE_INLINE_CALLBACK
+#    define THINGSBOARD_ENABLE_INLINE_CALLBACK 0
+#  endif
+
+// Enables the Attribute_Request to hold back the client-side and shared attribute requests made between two calls to ThingsBoard::loop() and to send them as one request,
+// with a single request id that every one of the held back callbacks is completed with. Fetching many attributes at startup then needs one round trip instead of one per request.
+// The requests are only sent once loop() is called, therefore Client_Attributes_Request() and Shared_Attributes_Request() only report whether they could be registered
+#  ifndef THINGSBOARD_ENABLE_ATTRIBUTE_REQUEST_COALESCING
+#    define THINGSBOARD_ENABLE_ATTRIBUTE_REQUEST_COALESCING 0
+#  endif
+
 #endif // Configuration_h
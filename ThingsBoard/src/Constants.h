@@ -5,9 +5,9 @@
 #include "Configuration.h"
 
 // Library includes.
-#if THINGSBOARD_ENABLE_PSRAM || THINGSBOARD_ENABLE_DYNAMIC
 #include <ArduinoJson.h>
-#endif // THINGSBOARD_ENABLE_PSRAM || THINGSBOARD_ENABLE_DYNAMIC
+
+static_assert(ARDUINOJSON_VERSION_MAJOR >= 7, "ThingsBoard requires ArduinoJson 7, because every JsonDocument is created with the ArduinoJson 7 interface");
 
 #define Default_Endpoints_Amount 7
 #define Default_Response_Amount 8
@@ -19,6 +19,8 @@
 #define Default_Max_Stack_Size 1024
 #if THINGSBOARD_ENABLE_STREAM_UTILS
 #define Default_Buffering_Size 64
+#elif THINGSBOARD_ENABLE_STREAM_PUBLISH
+#define Default_Chunk_Size 64
 #endif // THINGSBOARD_ENABLE_STREAM_UTILS
 #if THINGSBOARD_ENABLE_DYNAMIC
 #define Default_Max_Response_Size 0
@@ -27,35 +29,53 @@
 
 // Log messages.
 #if !THINGSBOARD_ENABLE_DYNAMIC
-char constexpr TOO_MANY_JSON_FIELDS[] = "Attempt to enter to many JSON fields into StaticJsonDocument (%u), increase (%s) (%u) accordingly";
+char constexpr TOO_MANY_JSON_FIELDS[] = "Attempt to enter to many JSON fields into JsonDocument (%u), increase (%s) (%u) accordingly";
 #endif // !THINGSBOARD_ENABLE_DYNAMIC
 char constexpr UNABLE_TO_SERIALIZE[] = "Unable to serialize key-value json";
 char constexpr CONNECT_FAILED[] = "Connecting to server failed";
 char constexpr UNABLE_TO_SERIALIZE_JSON[] = "Unable to serialize json data";
 char constexpr UNABLE_TO_ALLOCATE_JSON[] = "Allocating memory for the JsonDocument failed, passed JsonDocument is NULL";
-char constexpr JSON_SIZE_TO_SMALL[] = "JsonDocument too small to store all values. Ensure every key value pair gets JSON_OBJECT_SIZE(1) capacity + size required by value / key that is inserted";
+char constexpr JSON_SIZE_TO_SMALL[] = "Allocating memory for the values inserted into the JsonDocument failed. Ensure there is enough heap memory left";
 
 
 #if THINGSBOARD_ENABLE_PSRAM
 #include <esp_heap_caps.h>
 
-struct SpiRamAllocator {
-  void* allocate(size_t size) {
-    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
-  }
+/// @brief ArduinoJson allocator that places the memory pools of the JsonDocument into psram instead of onto the sram
+class SpiRamAllocator : public ArduinoJson::Allocator {
+  public:
+    void* allocate(size_t size) override {
+        return heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    }
+
+    void deallocate(void* pointer) override {
+        heap_caps_free(pointer);
+    }
 
-  void deallocate(void* pointer) {
-    heap_caps_free(pointer);
-  }
+    void* reallocate(void* ptr, size_t new_size) override {
+        return heap_caps_realloc(ptr, new_size, MALLOC_CAP_SPIRAM);
+    }
 
-  void* reallocate(void* ptr, size_t new_size) {
-    return heap_caps_realloc(ptr, new_size, MALLOC_CAP_SPIRAM);
-  }
+    /// @brief Returns the instance shared by all JsonDocument, the allocator does not have any state therefore one is enough
+    /// @return Pointer to the shared instance
+    static SpiRamAllocator * instance() {
+        static SpiRamAllocator allocator;
+        return &allocator;
+    }
 };
 
-using TBJsonDocument = BasicJsonDocument<SpiRamAllocator>;
-#elif THINGSBOARD_ENABLE_DYNAMIC
-using TBJsonDocument = DynamicJsonDocument;
-#endif
+/// @brief JsonDocument that allocates its memory pools from psram, grows as required like any ArduinoJson 7 document
+class TBJsonDocument : public JsonDocument {
+  public:
+    TBJsonDocument(void)
+      : JsonDocument(SpiRamAllocator::instance())
+    {
+        // Nothing to do
+    }
+};
+#else
+// ArduinoJson 7 documents allocate their values in pools that grow as required, therefore no capacity has to be passed or estimated anymore
+using TBJsonDocument = JsonDocument;
+#endif // THINGSBOARD_ENABLE_PSRAM
 
 #endif // Constants_h
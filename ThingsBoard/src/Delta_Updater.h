@@ -0,0 +1,418 @@
+#ifndef Delta_Updater_h
+#define Delta_Updater_h
+
+// Local include.
+#include "Configuration.h"
+#include "IUpdater.h"
+#include "IDelta_Source.h"
+#include "HashGenerator.h"
+
+// Library include.
+#include <string.h>
+
+// Delta patch format.
+char constexpr DELTA_MAGIC[] = "TBD1";
+size_t constexpr DELTA_MAGIC_SIZE = 4U;
+// SHA-256 hash as 64 hex characters, the same representation HashGenerator::finish() creates
+size_t constexpr DELTA_HASH_SIZE = 64U;
+size_t constexpr DELTA_HEADER_SIZE = DELTA_MAGIC_SIZE + 4U + 4U + (2U * DELTA_HASH_SIZE);
+// Default size of the buffers the firmware is read from and the new firmware is written into
+size_t constexpr DEFAULT_DELTA_BUFFER_SIZE = 512U;
+// Log messages.
+char constexpr DELTA_SOURCE_MISMATCH[] = "Delta patch was not created against the running firmware, calculated checksum (%s) instead of expected (%s)";
+char constexpr DELTA_PATCH_INVALID[] = "Delta patch is malformed after (%u) bytes of new firmware";
+char constexpr DELTA_FIRMWARE_MISMATCH[] = "Firmware created from the delta patch has checksum (%s), not the same as expected checksum (%s)";
+
+
+/// @brief IUpdater implementation that applies a delta patch to the running firmware while it is downloaded and writes the resulting firmware with another IUpdater.
+/// Uploading the patch instead of the firmware binary means only about as many bytes are downloaded as have changed between the two versions.
+/// The patch is created with tools/create_delta_patch.py from both firmware binaries, and uploaded as the OTA package, so the fw_checksum ThingsBoard sends is the one of the patch.
+/// Binaries that do not start with the patch header are written unchanged, so the same updater can install both patches and complete binaries.
+///
+/// The patch starts with the header "TBD1", the 32-bit little endian size of the firmware it was created against, the one of the new firmware,
+/// followed by the SHA-256 hash of both as 64 hex characters each. The records that follow describe the new firmware, in the manner of bsdiff (https://www.daemonology.net/bsdiff/),
+/// each consisting of the amount of diff bytes, the amount of extra bytes and the seek, as LEB128 numbers with the seek zigzag encoded, followed by the diff bytes and the extra bytes.
+/// Each diff byte is added to the next byte of the running firmware, the extra bytes are copied unchanged and the seek then moves the position in the running firmware.
+/// Because most diff bytes are 0, they are sent as LEB128 tokens with the amount in the upper bits, the lowest bit set if the bytes follow or not set for a run of 0, instead of compressing them.
+///
+/// The hash of the running firmware is checked as soon as the header has been received, before anything is written, the one of the new firmware when the update ends.
+/// RAM usage is two buffers of BufferSize bytes and the header, no matter the size of the firmware.
+/// Resuming is not supported, because the position in the patch can not be restored without the buffered state
+/// @tparam Logger Implementation that should be used to print error messages generated by internal processes and additional debugging messages if THINGSBOARD_ENABLE_DEBUG is set, default = DefaultLogger
+/// @tparam BufferSize Size of the buffers the running firmware is read from and the new firmware is written with, default = DEFAULT_DELTA_BUFFER_SIZE (512)
+template <typename Logger = DefaultLogger, size_t BufferSize = DEFAULT_DELTA_BUFFER_SIZE>
+class Delta_Updater : public IUpdater {
+  public:
+    /// @brief Constructor
+    /// @param updater Updater implementation that writes the new firmware, for example the Espressif_Updater
+    /// @param source Firmware the patches are applied to, for example the Espressif_Delta_Source
+    Delta_Updater(IUpdater & updater, IDelta_Source & source)
+      : m_updater(updater)
+      , m_source(source)
+    {
+        Reset_State();
+    }
+
+    bool begin(size_t const & firmware_size) override {
+        // Beginning the underlying updater is delayed until the header shows whether a patch or a complete binary is received
+        m_patch_size = firmware_size;
+        Reset_State();
+        return true;
+    }
+
+    size_t write(uint8_t * payload, size_t const & total_bytes) override {
+        if (m_state == Delta_State::PASSTHROUGH) {
+            return m_updater.write(payload, total_bytes);
+        }
+        for (size_t i = 0U; i < total_bytes;) {
+            bool success = true;
+            switch (m_state) {
+                case Delta_State::HEADER:
+                    success = Receive_Header(payload, total_bytes, i);
+                    if (success && m_state == Delta_State::PASSTHROUGH) {
+                        return (m_updater.write(payload + i, total_bytes - i) == total_bytes - i) ? total_bytes : 0U;
+                    }
+                    break;
+                case Delta_State::CONTROL:
+                    success = Receive_Control(payload[i++]);
+                    break;
+                case Delta_State::DIFF_TOKEN:
+                    success = Receive_Diff_Token(payload[i++]);
+                    break;
+                case Delta_State::DIFF_BYTES: {
+                    uint8_t source_byte = 0U;
+                    success = Read_Source(source_byte) && Output(source_byte + payload[i++]);
+                    m_diff_left--;
+                    if (success && --m_run_left == 0U) {
+                        success = End_Diff_Run();
+                    }
+                    break;
+                }
+                case Delta_State::EXTRA:
+                    success = Output(payload[i++]);
+                    if (success && --m_extra_left == 0U) {
+                        success = End_Record();
+                    }
+                    break;
+                default:
+                    success = false;
+                    break;
+            }
+            if (!success) {
+                Fail();
+                return 0U;
+            }
+        }
+        return total_bytes;
+    }
+
+    void reset() override {
+        m_updater.reset();
+        Reset_State();
+    }
+
+    bool end() override {
+        if (m_state == Delta_State::PASSTHROUGH) {
+            return m_updater.end();
+        }
+        if (m_state != Delta_State::CONTROL || m_field != 0U || m_varint_shift != 0U || m_written != m_target_size || !Flush()) {
+            Fail();
+            return false;
+        }
+        char calculated_checksum[(MBEDTLS_MD_MAX_SIZE * 2U) + 1U] = {};
+        (void)m_hash.finish(calculated_checksum);
+        if (strncmp(calculated_checksum, m_header + DELTA_HASH_OFFSET + DELTA_HASH_SIZE, DELTA_HASH_SIZE) != 0) {
+            char expected_checksum[DELTA_HASH_SIZE + 1U] = {};
+            (void)memcpy(expected_checksum, m_header + DELTA_HASH_OFFSET + DELTA_HASH_SIZE, DELTA_HASH_SIZE);
+            Logger::printfln(DELTA_FIRMWARE_MISMATCH, calculated_checksum, expected_checksum);
+            m_updater.reset();
+            Reset_State();
+            return false;
+        }
+        Reset_State();
+        return m_updater.end();
+    }
+
+  private:
+    // Offset of the two hashes in the header, following the magic and the two sizes
+    static size_t constexpr DELTA_HASH_OFFSET = DELTA_MAGIC_SIZE + 4U + 4U;
+
+    /// @brief Part of the patch that the next received byte belongs to
+    enum class Delta_State : uint8_t {
+        HEADER,      // Header with the sizes and hashes of both firmwares
+        CONTROL,     // Amount of diff bytes, amount of extra bytes and seek of the next record
+        DIFF_TOKEN,  // Token telling whether diff bytes follow or how many of them are 0
+        DIFF_BYTES,  // Diff bytes that are added to the running firmware
+        EXTRA,       // Extra bytes that are copied unchanged
+        PASSTHROUGH, // Complete binary without header, written unchanged
+        FAILED       // Patch was invalid or writing failed, until the update is reset
+    };
+
+    /// @brief Resets the received patch, so the next received byte is expected to be the first one of the header
+    void Reset_State() {
+        m_state = Delta_State::HEADER;
+        m_header_size = 0U;
+        m_target_size = 0U;
+        m_source_size = 0U;
+        m_written = 0U;
+        m_source_offset = 0U;
+        m_buffer_start = 0U;
+        m_buffer_size = 0U;
+        m_output_size = 0U;
+        m_field = 0U;
+        m_varint = 0U;
+        m_varint_shift = 0U;
+        m_diff_left = 0U;
+        m_extra_left = 0U;
+        m_run_left = 0U;
+        m_seek = 0;
+    }
+
+    /// @brief Stops applying the patch until the update is reset and logs where the patch was malformed
+    void Fail() {
+        // Failures while receiving the header have already been logged by the check of the running firmware or by the underlying updater
+        if (m_state != Delta_State::FAILED && m_state != Delta_State::HEADER) {
+            Logger::printfln(DELTA_PATCH_INVALID, m_written);
+        }
+        m_state = Delta_State::FAILED;
+    }
+
+    /// @brief Copies the received bytes into the header until it is complete, then checks the running firmware and begins writing the new one,
+    /// or writes the binary unchanged if it does not start with the magic
+    /// @param payload Firmware packet data
+    /// @param total_bytes Amount of bytes in the firmware packet data
+    /// @param index Index of the next byte in the firmware packet data, is moved past the bytes belonging to the header
+    /// @return Whether the header was valid so far or not
+    bool Receive_Header(uint8_t const * payload, size_t const & total_bytes, size_t & index) {
+        size_t copied = DELTA_HEADER_SIZE - m_header_size;
+        if (copied > total_bytes - index) {
+            copied = total_bytes - index;
+        }
+        (void)memcpy(m_header + m_header_size, payload + index, copied);
+        m_header_size += copied;
+        index += copied;
+
+        size_t const compared = (m_header_size < DELTA_MAGIC_SIZE) ? m_header_size : DELTA_MAGIC_SIZE;
+        if (memcmp(m_header, DELTA_MAGIC, compared) != 0) {
+            // The bytes that were held back as a possible header are the beginning of the binary
+            m_state = Delta_State::PASSTHROUGH;
+            return m_updater.begin(m_patch_size) && m_updater.write(reinterpret_cast<uint8_t *>(m_header), m_header_size) == m_header_size;
+        }
+        if (m_header_size < DELTA_HEADER_SIZE) {
+            return true;
+        }
+
+        m_source_size = Read_Uint32(m_header + DELTA_MAGIC_SIZE);
+        m_target_size = Read_Uint32(m_header + DELTA_MAGIC_SIZE + 4U);
+        if (!Check_Source() || !m_updater.begin(m_target_size)) {
+            return false;
+        }
+        // Hash start result is ignored, because it can only fail if the input parameters are invalid
+        (void)m_hash.start(mbedtls_md_type_t::MBEDTLS_MD_SHA256);
+        m_state = Delta_State::CONTROL;
+        return true;
+    }
+
+    /// @brief Hashes the running firmware and compares it with the hash in the header, because applying the patch to any other firmware would create an invalid one,
+    /// which would only be noticed once the complete patch has been downloaded
+    /// @return Whether the running firmware is the one the patch was created against or not
+    bool Check_Source() {
+        (void)m_hash.start(mbedtls_md_type_t::MBEDTLS_MD_SHA256);
+        for (size_t offset = 0U; offset < m_source_size; offset += BufferSize) {
+            size_t const length = (m_source_size - offset < BufferSize) ? (m_source_size - offset) : BufferSize;
+            if (m_source.read(offset, m_buffer, length) != length) {
+                return false;
+            }
+            (void)m_hash.update(m_buffer, length);
+        }
+        char calculated_checksum[(MBEDTLS_MD_MAX_SIZE * 2U) + 1U] = {};
+        (void)m_hash.finish(calculated_checksum);
+        if (strncmp(calculated_checksum, m_header + DELTA_HASH_OFFSET, DELTA_HASH_SIZE) != 0) {
+            char expected_checksum[DELTA_HASH_SIZE + 1U] = {};
+            (void)memcpy(expected_checksum, m_header + DELTA_HASH_OFFSET, DELTA_HASH_SIZE);
+            Logger::printfln(DELTA_SOURCE_MISMATCH, calculated_checksum, expected_checksum);
+            return false;
+        }
+        return true;
+    }
+
+    /// @brief Adds the given byte to the LEB128 number that is currently received
+    /// @param byte Received byte of the number
+    /// @param complete Whether the number is complete with the given byte, it is then contained in m_varint
+    /// @return Whether the number fits into 32 bits or not
+    bool Receive_Varint(uint8_t const & byte, bool & complete) {
+        if (m_varint_shift == 0U) {
+            m_varint = 0U;
+        }
+        if (m_varint_shift > 28U) {
+            return false;
+        }
+        m_varint |= static_cast<uint32_t>(byte & 0x7FU) << m_varint_shift;
+        complete = (byte & 0x80U) == 0U;
+        m_varint_shift = complete ? 0U : (m_varint_shift + 7U);
+        return true;
+    }
+
+    /// @brief Receives the amount of diff bytes, the amount of extra bytes and the seek of the next record
+    /// @param byte Received byte of the record
+    /// @return Whether the record is valid so far or not
+    bool Receive_Control(uint8_t const & byte) {
+        bool complete = false;
+        if (!Receive_Varint(byte, complete)) {
+            return false;
+        }
+        if (!complete) {
+            return true;
+        }
+        switch (m_field++) {
+            case 0U:
+                m_diff_left = m_varint;
+                return true;
+            case 1U:
+                m_extra_left = m_varint;
+                return true;
+            default:
+                // Zigzag decoding, 0, 1, 2, 3 stand for 0, -1, 1, -2
+                m_seek = static_cast<int32_t>(m_varint >> 1U) ^ -static_cast<int32_t>(m_varint & 1U);
+                m_field = 0U;
+                if (m_written + m_diff_left + m_extra_left > m_target_size) {
+                    return false;
+                }
+                return End_Diff_Run();
+        }
+    }
+
+    /// @brief Receives the token telling whether the next diff bytes follow in the patch or are 0, those are copied from the running firmware straight away
+    /// @param byte Received byte of the token
+    /// @return Whether the token is valid so far and copying was successful or not
+    bool Receive_Diff_Token(uint8_t const & byte) {
+        bool complete = false;
+        if (!Receive_Varint(byte, complete)) {
+            return false;
+        }
+        if (!complete) {
+            return true;
+        }
+        m_run_left = m_varint >> 1U;
+        if (m_run_left == 0U || m_run_left > m_diff_left) {
+            return false;
+        }
+        if ((m_varint & 1U) != 0U) {
+            m_state = Delta_State::DIFF_BYTES;
+            return true;
+        }
+        for (; m_run_left > 0U; m_run_left--, m_diff_left--) {
+            uint8_t source_byte = 0U;
+            if (!Read_Source(source_byte) || !Output(source_byte)) {
+                return false;
+            }
+        }
+        return End_Diff_Run();
+    }
+
+    /// @brief Continues with the next token if diff bytes remain, else with the extra bytes or the next record
+    /// @return Whether the record could be completed or not
+    bool End_Diff_Run() {
+        if (m_diff_left > 0U) {
+            m_state = Delta_State::DIFF_TOKEN;
+            return true;
+        }
+        if (m_extra_left > 0U) {
+            m_state = Delta_State::EXTRA;
+            return true;
+        }
+        return End_Record();
+    }
+
+    /// @brief Moves the position in the running firmware by the seek of the record and continues with the next record
+    /// @return Whether the position is still inside the running firmware or not
+    bool End_Record() {
+        int64_t const source_offset = static_cast<int64_t>(m_source_offset) + m_seek;
+        if (source_offset < 0 || source_offset > static_cast<int64_t>(m_source_size)) {
+            return false;
+        }
+        m_source_offset = static_cast<size_t>(source_offset);
+        m_state = Delta_State::CONTROL;
+        return true;
+    }
+
+    /// @brief Reads the next byte of the running firmware, through the buffer so the source is only read BufferSize bytes at a time
+    /// @param byte Variable the read byte will be copied into
+    /// @return Whether the byte is inside the running firmware and could be read or not
+    bool Read_Source(uint8_t & byte) {
+        if (m_source_offset < m_buffer_start || m_source_offset >= m_buffer_start + m_buffer_size) {
+            if (m_source_offset >= m_source_size) {
+                return false;
+            }
+            size_t const length = (m_source_size - m_source_offset < BufferSize) ? (m_source_size - m_source_offset) : BufferSize;
+            if (m_source.read(m_source_offset, m_buffer, length) != length) {
+                m_buffer_size = 0U;
+                return false;
+            }
+            m_buffer_start = m_source_offset;
+            m_buffer_size = length;
+        }
+        byte = m_buffer[m_source_offset - m_buffer_start];
+        m_source_offset++;
+        return true;
+    }
+
+    /// @brief Appends the given byte to the new firmware, which is written and hashed once the output buffer is full
+    /// @param byte Next byte of the new firmware
+    /// @return Whether writing was successful or not
+    bool Output(uint8_t const & byte) {
+        if (m_written >= m_target_size) {
+            return false;
+        }
+        m_output[m_output_size++] = byte;
+        m_written++;
+        return m_output_size < BufferSize || Flush();
+    }
+
+    /// @brief Writes and hashes the buffered bytes of the new firmware
+    /// @return Whether writing was successful or not
+    bool Flush() {
+        if (m_output_size == 0U) {
+            return true;
+        }
+        size_t const written_bytes = m_updater.write(m_output, m_output_size);
+        (void)m_hash.update(m_output, m_output_size);
+        bool const success = written_bytes == m_output_size;
+        m_output_size = 0U;
+        return success;
+    }
+
+    /// @brief Reads a 32-bit little endian number
+    /// @param bytes Bytes of the number
+    /// @return Read number
+    static uint32_t Read_Uint32(char const * bytes) {
+        uint8_t const * data = reinterpret_cast<uint8_t const *>(bytes);
+        return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8U) | (static_cast<uint32_t>(data[2]) << 16U) | (static_cast<uint32_t>(data[3]) << 24U);
+    }
+
+    IUpdater      &m_updater;                     // Updater implementation that writes the new firmware
+    IDelta_Source &m_source;                      // Firmware the patch is applied to
+    HashGenerator m_hash = {};                    // Hash of the running firmware while the header is checked, then of the new firmware
+    Delta_State   m_state = {};                   // Part of the patch that the next received byte belongs to
+    size_t        m_patch_size = {};              // Size of the received binary, written as the firmware size if it is not a patch
+    char          m_header[DELTA_HEADER_SIZE] = {}; // Received header of the patch
+    size_t        m_header_size = {};             // Amount of header bytes received
+    size_t        m_source_size = {};             // Size of the firmware the patch was created against
+    size_t        m_target_size = {};             // Size of the new firmware
+    size_t        m_written = {};                 // Amount of bytes of the new firmware that have been created
+    size_t        m_source_offset = {};           // Position in the running firmware the next diff byte is added to
+    uint8_t       m_buffer[BufferSize] = {};      // Bytes of the running firmware starting at m_buffer_start
+    size_t        m_buffer_start = {};            // Position in the running firmware of the first byte in m_buffer
+    size_t        m_buffer_size = {};             // Amount of valid bytes in m_buffer
+    uint8_t       m_output[BufferSize] = {};      // Bytes of the new firmware that have not been written yet
+    size_t        m_output_size = {};             // Amount of bytes in m_output
+    uint8_t       m_field = {};                   // Number of the record that is currently received, the amount of diff bytes, the amount of extra bytes or the seek
+    uint32_t      m_varint = {};                  // LEB128 number that is currently received
+    uint8_t       m_varint_shift = {};            // Bits of the number that have been received, 0 if the next byte starts a new one
+    uint32_t      m_diff_left = {};               // Diff bytes remaining in the current record
+    uint32_t      m_extra_left = {};              // Extra bytes remaining in the current record
+    uint32_t      m_run_left = {};                // Diff bytes remaining in the current token
+    int32_t       m_seek = {};                    // Seek of the current record, applied once its diff and extra bytes have been created
+};
+
+#endif // Delta_Updater_h
@@ -0,0 +1,36 @@
+#ifndef Espressif_Delta_Source_h
+#define Espressif_Delta_Source_h
+
+// Local include.
+#include "Configuration.h"
+
+#if THINGSBOARD_USE_ESP_PARTITION
+
+// Local include.
+#include "IDelta_Source.h"
+
+// Library include.
+#include <esp_ota_ops.h>
+
+
+/// @brief IDelta_Source implementation that reads the firmware from the partition the device is currently running from,
+/// with the partition API from Espressif (https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/storage/partition.html),
+/// which transparently decrypts the data if flash encryption is enabled
+class Espressif_Delta_Source : public IDelta_Source {
+  public:
+    Espressif_Delta_Source() = default;
+
+    size_t read(size_t const & offset, uint8_t * buffer, size_t const & total_bytes) override {
+        esp_partition_t const * running = esp_ota_get_running_partition();
+        if (running == nullptr || offset + total_bytes > running->size) {
+            return 0U;
+        }
+        esp_err_t const error = esp_partition_read(running, offset, buffer, total_bytes);
+        size_t const read_bytes = (error == ESP_OK) ? total_bytes : 0U;
+        return read_bytes;
+    }
+};
+
+#endif // THINGSBOARD_USE_ESP_PARTITION
+
+#endif // Espressif_Delta_Source_h
@@ -40,6 +40,7 @@ class Espressif_MQTT_Client : public IMQTT_Client {
       , m_connected_callback()
       , m_connected(false)
       , m_enqueue_messages(false)
+      , m_publish_qos(0U)
       , m_mqtt_configuration()
       , m_mqtt_client(nullptr)
     {
@@ -210,6 +211,29 @@ class Espressif_MQTT_Client : public IMQTT_Client {
         m_enqueue_messages = enqueue_messages;
     }
 
+    /// @brief Sets the QoS level published messages are sent with, either 0 (at most once) or 1 (at least once).
+    /// With QoS level 1 the message is kept in the outbox of the underlying client until the broker acknowledged it, and resent after the connection has been reestablished if it was lost before that,
+    /// meaning messages published over a shortly interrupted connection still arrive, at the cost of keeping them in memory until they are acknowledged.
+    /// Combined with set_enqueue_messages(true) publishing is furthermore possible while the client is reconnecting and never blocks the calling task, because the mqtt task sends the messages from the outbox once it is connected again.
+    /// Messages still unacknowledged after CONFIG_MQTT_OUTBOX_EXPIRED_TIMEOUT_MS (30 seconds by default) are discarded, so that option has to be increased to ride out longer interruptions, default = 0
+    /// @param qos QoS level all following messages are published with, values above 1 are sent with QoS level 1
+    void set_publish_qos(uint8_t qos) {
+        m_publish_qos = qos > 1U ? 1U : qos;
+    }
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+    /// @brief Returns the amount of bytes the messages in the outbox take, meaning the messages that were enqueued but not sent yet, or sent with QoS level 1 but not acknowledged by the broker yet.
+    /// Can be used to stop publishing new messages until the backlog has been sent, instead of filling the outbox until enqueueing fails
+    /// @return Amount of bytes in the outbox of the underlying client, 0 if the client has not been initalized with connect() yet
+    size_t get_outbox_size() const {
+        if (m_mqtt_client == nullptr) {
+            return 0U;
+        }
+        int const outbox_size = esp_mqtt_client_get_outbox_size(m_mqtt_client);
+        return outbox_size > 0 ? static_cast<size_t>(outbox_size) : 0U;
+    }
+#endif // ESP_IDF_VERSION_MAJOR >= 5
+
     void set_data_callback(Callback<void, char *, uint8_t *, unsigned int>::function callback) override {
         m_received_data_callback.Set_Callback(callback);
     }
@@ -312,17 +336,17 @@ class Espressif_MQTT_Client : public IMQTT_Client {
         int message_id = MQTT_FAILURE_MESSAGE_ID;
 
         if (m_enqueue_messages) {
-            message_id = esp_mqtt_client_enqueue(m_mqtt_client, topic, reinterpret_cast<const char*>(payload), length, 0U, 0U, true);
+            message_id = esp_mqtt_client_enqueue(m_mqtt_client, topic, reinterpret_cast<const char*>(payload), length, m_publish_qos, 0U, true);
             return message_id > MQTT_FAILURE_MESSAGE_ID;
         }
 
         // The blocking version esp_mqtt_client_publish() it is sent directly from the users task context.
         // This way is used to send messages to the cloud, because like that no internal buffer has to be used to store the message until it should be sent,
-        // because all messages are sent with QoS level 0. If this is not wanted esp_mqtt_client_enqueue() could be used with store = true,
+        // because messages are sent with QoS level 0 by default. If this is not wanted esp_mqtt_client_enqueue() could be used with store = true,
         // to ensure the sending is done in the mqtt event context instead of the users task context.
         // Allows to use the publish method without having to worry about any CPU overhead, so it can even be used in callbacks or high priority tasks, without starving other tasks,
         // but compared to the other method esp_mqtt_client_enqueue() requires to save the message in the outbox, which increases the memory requirements for the internal buffer size
-        message_id = esp_mqtt_client_publish(m_mqtt_client, topic, reinterpret_cast<const char*>(payload), length, 0U, 0U);
+        message_id = esp_mqtt_client_publish(m_mqtt_client, topic, reinterpret_cast<const char*>(payload), length, m_publish_qos, 0U);
         return message_id > MQTT_FAILURE_MESSAGE_ID;
     }
 
@@ -350,6 +374,29 @@ class Espressif_MQTT_Client : public IMQTT_Client {
         return m_connected;
     }
 
+#if THINGSBOARD_ENABLE_STREAM_PUBLISH
+    // The esp mqtt client only publishes complete messages, streaming a payload is therefore not supported
+    // and the ThingsBoard instance reports that the message could not be sent, instead of returning a partial message
+
+    bool begin_publish(char const *, size_t const &) override {
+        return false;
+    }
+
+    bool end_publish() override {
+        return false;
+    }
+
+#if THINGSBOARD_ENABLE_STREAM_UTILS
+    size_t write(uint8_t) override {
+        return 0U;
+    }
+#endif // THINGSBOARD_ENABLE_STREAM_UTILS
+
+    size_t write(uint8_t const *, size_t const &) override {
+        return 0U;
+    }
+#endif // THINGSBOARD_ENABLE_STREAM_PUBLISH
+
 private:
     /// @brief Is internally used to allow changes to the underlying configuration of the esp_mqtt_client_handle_t after it has connected,
     /// to for example increase the buffer size or increase the timeouts or stack size, allows to change the underlying client configuration,
@@ -443,6 +490,7 @@ private:
     Callback<void>                                  m_connected_callback = {};     // Callback that will be called as soon as the mqtt client has connected
     bool                                            m_connected = {};              // Whether the client has received the connected or disconnected event
     bool                                            m_enqueue_messages = {};       // Whether we enqueue messages making nearly all ThingsBoard calls non blocking or wheter we publish instead
+    uint8_t                                         m_publish_qos = {};            // QoS level published messages are sent with, 1 keeps them in the outbox until the broker acknowledged them
     esp_mqtt_client_config_t                        m_mqtt_configuration = {};     // Configuration of the underlying mqtt client, saved as a private variable to allow changes after inital configuration with the same options for all non changed settings
     esp_mqtt_client_handle_t                        m_mqtt_client = {};            // Handle to the underlying mqtt client, used to establish the communication
 };
@@ -0,0 +1,96 @@
+#ifndef Espressif_OTA_Resume_Store_h
+#define Espressif_OTA_Resume_Store_h
+
+// Local include.
+#include "Configuration.h"
+
+#if THINGSBOARD_USE_ESP_NVS
+
+// Local include.
+#include "IOTA_Resume_Store.h"
+#include "DefaultLogger.h"
+
+// Library include.
+#include <nvs.h>
+
+char constexpr OTA_RESUME_NAMESPACE[] = "tb_ota";
+char constexpr OTA_RESUME_KEY[] = "progress";
+char constexpr OPEN_NVS_FAILED[] = "Opening NVS namespace failed with error reason (%s)";
+char constexpr SAVE_OTA_PROGRESS_FAILED[] = "Saving OTA progress failed with error reason (%s)";
+
+
+/// @brief IOTA_Resume_Store implementation that uses the Non-volatile storage library from Espressif (https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/storage/nvs_flash.html)
+/// under the hood to keep the progress of a firmware download as a blob in its own namespace. The NVS partition has to be initalized with nvs_flash_init() beforehand,
+/// which the Arduino core already does on startup, its wear levelling spreads the writes of the progress over the whole partition
+/// @tparam Logger Implementation that should be used to print error messages generated by internal processes and additional debugging messages if THINGSBOARD_ENABLE_DEBUG is set, default = DefaultLogger
+template <typename Logger = DefaultLogger>
+class Espressif_OTA_Resume_Store : public IOTA_Resume_Store {
+  public:
+    /// @brief Constructor
+    /// @param name_space NVS namespace the progress is kept in, at most 15 characters, default = OTA_RESUME_NAMESPACE
+    Espressif_OTA_Resume_Store(char const * name_space = OTA_RESUME_NAMESPACE)
+      : m_namespace(name_space)
+    {
+        // Nothing to do
+    }
+
+    bool load(OTA_Resume_State & state) override {
+        nvs_handle_t handle;
+        // A namespace that has never been written does not exist yet, which is expected before the first update and therefore not logged
+        if (nvs_open(m_namespace, NVS_READONLY, &handle) != ESP_OK) {
+            return false;
+        }
+        size_t length = sizeof(state);
+        esp_err_t const error = nvs_get_blob(handle, OTA_RESUME_KEY, &state, &length);
+        nvs_close(handle);
+        return error == ESP_OK && length == sizeof(state);
+    }
+
+    bool save(OTA_Resume_State const & state) override {
+        nvs_handle_t handle;
+        if (!Open(handle)) {
+            return false;
+        }
+        esp_err_t error = nvs_set_blob(handle, OTA_RESUME_KEY, &state, sizeof(state));
+        if (error == ESP_OK) {
+            error = nvs_commit(handle);
+        }
+        nvs_close(handle);
+        if (error != ESP_OK) {
+            Logger::printfln(SAVE_OTA_PROGRESS_FAILED, esp_err_to_name(error));
+            return false;
+        }
+        return true;
+    }
+
+    void clear() override {
+        nvs_handle_t handle;
+        if (!Open(handle)) {
+            return;
+        }
+        // Erasing a key that does not exist fails, which does not matter because there is nothing to clear then
+        if (nvs_erase_key(handle, OTA_RESUME_KEY) == ESP_OK) {
+            (void)nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+
+  private:
+    /// @brief Opens the namespace for writing, creating it if it does not exist yet
+    /// @param handle Handle the opened namespace will be copied into
+    /// @return Whether opening was successful or not
+    bool Open(nvs_handle_t & handle) const {
+        esp_err_t const error = nvs_open(m_namespace, NVS_READWRITE, &handle);
+        if (error != ESP_OK) {
+            Logger::printfln(OPEN_NVS_FAILED, esp_err_to_name(error));
+            return false;
+        }
+        return true;
+    }
+
+    char const *m_namespace = {}; // NVS namespace the progress is kept in
+};
+
+#endif // THINGSBOARD_USE_ESP_NVS
+
+#endif // Espressif_OTA_Resume_Store_h
@@ -15,6 +15,8 @@
 constexpr char INVALID_OTA_PARTIION[] = "The running partition and the parition we wanted to boot into were not the same meaning the previous update failed and choose the fallback partition instead";
 constexpr char MISSING_OTA_APP[] = "Missing second ota app or app was invalid";
 constexpr char BEGIN_UPDATE_FAILED[] = "Beginning update failed with error reason (%s)";
+// Smallest area of flash memory that can be erased, the partitions are aligned to it
+constexpr size_t OTA_FLASH_SECTOR_SIZE = 4096U;
 
 
 /// @brief IUpdater implementation that uses the Over the Air Update API from Espressif (https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/ota.html)
@@ -26,18 +28,9 @@ class Espressif_Updater : public IUpdater {
     Espressif_Updater() = default;
 
     bool begin(size_t const & firmware_size) override {
-        esp_partition_t const * running = esp_ota_get_running_partition();
-        esp_partition_t const * configured = esp_ota_get_boot_partition();
-
-        if (configured != running) {
-            Logger::println(INVALID_OTA_PARTIION);
-            return false;
-        }
-
-        esp_partition_t const * update_partition = esp_ota_get_next_update_partition(nullptr);
+        esp_partition_t const * update_partition = Get_Update_Partition();
 
         if (update_partition == nullptr) {
-            Logger::println(MISSING_OTA_APP);
             return false;
         }
 
@@ -54,16 +47,50 @@ class Espressif_Updater : public IUpdater {
 
         m_ota_handle = ota_handle;
         m_update_partition = update_partition;
+        m_resumed = false;
+        return true;
+    }
+
+    bool resume(size_t const & firmware_size, size_t const & offset) override {
+        esp_partition_t const * update_partition = Get_Update_Partition();
+
+        // Encrypted partitions are only written in blocks of 16 bytes, which the last packet does not have to fill, esp_ota_write() pads it but the partition API does not
+        if (update_partition == nullptr || update_partition->encrypted || firmware_size > update_partition->size || offset > firmware_size) {
+            return false;
+        }
+
+        // esp_ota_begin() would erase the data that was already written, therefore the following packets are written with the partition API instead
+        // and the sectors in front of them are erased on the way. The image is verified in the end, when esp_ota_set_boot_partition() is called
+        m_update_partition = update_partition;
+        m_resumed = true;
+        m_write_offset = offset;
+        m_erased_offset = ((offset + OTA_FLASH_SECTOR_SIZE - 1U) / OTA_FLASH_SECTOR_SIZE) * OTA_FLASH_SECTOR_SIZE;
         return true;
     }
 
+    size_t read(size_t const & offset, uint8_t * buffer, size_t const & total_bytes) override {
+        if (m_update_partition == nullptr) {
+            return 0U;
+        }
+        esp_err_t const error = esp_partition_read(m_update_partition, offset, buffer, total_bytes);
+        size_t const read_bytes = (error == ESP_OK) ? total_bytes : 0U;
+        return read_bytes;
+    }
+
     size_t write(uint8_t * payload, size_t const & total_bytes) override {
+        if (m_resumed) {
+            return Write_Partition(payload, total_bytes);
+        }
         esp_err_t const error = esp_ota_write(m_ota_handle, payload, total_bytes);
         size_t const written_bytes = (error == ESP_OK) ? total_bytes : 0U;
         return written_bytes;
     }
 
     void reset() override {
+        if (m_resumed) {
+            m_resumed = false;
+            return;
+        }
 #if defined(ESP8266) || (ESP_IDF_VERSION_MAJOR == 4 && ESP_IDF_VERSION_MINOR < 3) || ESP_IDF_VERSION_MAJOR < 4
         (void)end();
 #else
@@ -72,6 +99,10 @@ class Espressif_Updater : public IUpdater {
     }
 
     bool end() override {
+        if (m_resumed) {
+            m_resumed = false;
+            return esp_ota_set_boot_partition(m_update_partition) == ESP_OK;
+        }
         esp_err_t error = esp_ota_end(m_ota_handle);
         if (error != ESP_OK) {
             return false;
@@ -82,8 +113,53 @@ class Espressif_Updater : public IUpdater {
     }
 
   private:
+    /// @brief Gets the non active OTA partition, as long as the previous update did not fail and choose the fallback partition instead
+    /// @return Partition the update can be written into, nullptr if there is none
+    esp_partition_t const * Get_Update_Partition() const {
+        esp_partition_t const * running = esp_ota_get_running_partition();
+        esp_partition_t const * configured = esp_ota_get_boot_partition();
+
+        if (configured != running) {
+            Logger::println(INVALID_OTA_PARTIION);
+            return nullptr;
+        }
+
+        esp_partition_t const * update_partition = esp_ota_get_next_update_partition(nullptr);
+
+        if (update_partition == nullptr) {
+            Logger::println(MISSING_OTA_APP);
+        }
+        return update_partition;
+    }
+
+    /// @brief Writes the given packet of a resumed update behind the already written data, erasing the sectors it reaches into first
+    /// @param payload Firmware packet data that should be written
+    /// @param total_bytes Amount of bytes in the current firmware packet data
+    /// @return Total amount of bytes that were successfully written
+    size_t Write_Partition(uint8_t * payload, size_t const & total_bytes) {
+        size_t const write_end = m_write_offset + total_bytes;
+        if (write_end > m_update_partition->size) {
+            return 0U;
+        }
+        if (write_end > m_erased_offset) {
+            size_t const erase_end = ((write_end + OTA_FLASH_SECTOR_SIZE - 1U) / OTA_FLASH_SECTOR_SIZE) * OTA_FLASH_SECTOR_SIZE;
+            if (esp_partition_erase_range(m_update_partition, m_erased_offset, erase_end - m_erased_offset) != ESP_OK) {
+                return 0U;
+            }
+            m_erased_offset = erase_end;
+        }
+        if (esp_partition_write(m_update_partition, m_write_offset, payload, total_bytes) != ESP_OK) {
+            return 0U;
+        }
+        m_write_offset = write_end;
+        return total_bytes;
+    }
+
     uint32_t               m_ota_handle = {};       // ESP OTA hanle that is used to to access the underlying updater
     esp_partition_t const *m_update_partition = {}; // Non active OTA partition that we write our data into
+    bool                   m_resumed = {};          // Whether a resumed update is written, which goes through the partition API instead of the OTA handle
+    size_t                 m_write_offset = {};     // Offset in the partition the next packet of a resumed update is written to
+    size_t                 m_erased_offset = {};    // Offset in the partition up to which a resumed update has been erased
 };
 
 #endif // THINGSBOARD_USE_ESP_PARTITION
@@ -24,6 +24,18 @@ bool Helper::stringIsNullorEmpty(char const * str) {
     return str == nullptr || str[0] == '\0';
 }
 
+uint32_t Helper::FNV_1a_Hash(uint32_t hash, char character) {
+    return (hash ^ static_cast<uint8_t>(character)) * FNV_PRIME;
+}
+
+uint32_t Helper::FNV_1a_Hash(char const * str) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (; *str != '\0'; ++str) {
+        hash = FNV_1a_Hash(hash, *str);
+    }
+    return hash;
+}
+
 size_t Helper::parseRequestId(char const * base_topic, char const * received_topic) {
     // Remove the not needed part of the received topic string, which is everything before the request id,
     // therefore we ignore the section before that which is the base topic, that seperates the topic from the request id.
@@ -12,8 +12,13 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdint.h>
 
 
+// FNV-1a parameters, used to hash topic prefixes and RPC method names for the lookup tables.
+uint32_t constexpr FNV_OFFSET_BASIS = 2166136261U;
+uint32_t constexpr FNV_PRIME = 16777619U;
+
 /// @brief Static helper class that includes some uniliterally used functionalities in multiple places, especially the ThingsBoardHttp and ThingsBoard implementations
 class Helper {
   public:
@@ -46,6 +51,25 @@ class Helper {
     /// @return Wheter the given string is a nullptr or empty
     static bool stringIsNullorEmpty(char const * str);
 
+    /// @brief Folds the given character into the given FNV-1a hash
+    /// @param hash Hash of the characters before, FNV_OFFSET_BASIS to start a new one
+    /// @param character Next character that should be added to the hash
+    /// @return Hash including the given character
+    static uint32_t FNV_1a_Hash(uint32_t hash, char character);
+
+    /// @brief Returns the FNV-1a hash of the given string, not including the null terminator
+    /// @param str String that we want to hash, has to be a valid pointer
+    /// @return Hash of all characters of the given string
+    static uint32_t FNV_1a_Hash(char const * str);
+
+    /// @brief Returns the smallest power of two that is bigger than or equal to the given value, at compile time if possible
+    /// @param value Value that should be rounded up
+    /// @param power Power of two the search starts with, should be left at its default value
+    /// @return Smallest power of two that can hold the given value
+    static size_t constexpr Next_Power_Of_Two(size_t value, size_t power = 1U) {
+        return power >= value ? power : Next_Power_Of_Two(value, power * 2U);
+    }
+
     /// @brief Returns the portion of the received topic after the base topic as an integer.
     /// Should contain the request id that the original request was sent with
     /// Is used to know which received response is connected to which inital request
@@ -57,13 +81,13 @@ class Helper {
     /// @brief Calculates the total size of the string the serializeJson method would produce including the null end terminator.
     /// Be aware that null terminator will later not be serialied in the serializeJson() call,
     /// meaning the returned written amount of bytes is the return value of this method - 1.
-    /// See https://arduinojson.org/v6/api/json/measurejson/ for more information on the underlying method used
+    /// See https://arduinojson.org/v7/api/json/measurejson/ for more information on the underlying method used
     /// @tparam TSource Source class that should be used to serialize the json that is sent to the server
     /// @param source Data source containing our json key value pairs we want to measure
     /// @return Total size required for the string that would be produced by serializeJson + 1 byte for the string null terminator
     template <typename TSource>
     static size_t Measure_Json(TSource const & source) {
-        return JSON_STRING_SIZE(measureJson(source));
+        return measureJson(source) + 1U;
     }
 
     /// @brief Removes the element with the given index, which allows to use data containers that do not have a random-access iterator.
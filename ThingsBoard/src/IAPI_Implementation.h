@@ -63,6 +63,14 @@ class IAPI_Implementation {
     /// @return Whether the received response topic matches the topic this api implementation handles responses on
     virtual bool Compare_Response_Topic(char const * topic) const = 0;
 
+    /// @brief Constant start of every topic this api implementation handles responses on, up to any variable part like a request id.
+    /// Used to build the routing table that received messages are dispatched with, so only the api implementations whose prefix matches
+    /// are asked with Compare_Response_Topic, which still makes the final decision. The default nullptr means the api implementation is asked for every message
+    /// @return Prefix of the response topics, has to stay valid and unchanged for as long as the api implementation is subscribed
+    virtual char const * Get_Response_Topic_Prefix() const {
+        return nullptr;
+    }
+
     /// @brief Unsubcribes all callbacks, to clear up any ongoing subscriptions and stop receiving information over the previously subscribed topic
     /// @return Whether unsubcribing all the previously subscribed callbacks
     /// and from the previously subscribed topic, was successful or not
@@ -80,6 +88,12 @@ class IAPI_Implementation {
     virtual void loop() = 0;
 #endif // !THINGSBOARD_USE_ESP_TIMER
 
+    /// @brief Sends any messages the API held back to combine them into fewer ones, like the attribute requests made since the last call.
+    /// Called for every API implementation at the start of ThingsBoard::loop(), regardless of whether the ESP Timer is used
+    virtual void Flush() {
+        // Nothing to do
+    }
+
     /// @brief Method that allows to construct internal objects, after the required callback member methods have been set already.
     /// Required for API Implementations that subscribe further API calls, because immediately calling in the constructor can lead,
     /// to attempted subscriptions before the m_subscribe_api_callback is actually subscribed. Therefore we have to call methods like that,
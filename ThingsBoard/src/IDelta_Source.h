@@ -0,0 +1,24 @@
+#ifndef IDelta_Source_h
+#define IDelta_Source_h
+
+// Local include.
+#include "Configuration.h"
+
+// Library include.
+#include <stddef.h>
+#include <stdint.h>
+
+
+/// @brief Interface for the firmware a delta patch was created against, which the Delta_Updater reads the unchanged parts of the new firmware from.
+/// Is normally the firmware the device is currently running
+class IDelta_Source {
+  public:
+    /// @brief Reads the given amount of bytes of the firmware
+    /// @param offset Position in the firmware to read from
+    /// @param buffer Buffer the read bytes are copied into
+    /// @param total_bytes Amount of bytes that should be read
+    /// @return Total amount of bytes that were successfully read, 0 if the firmware does not reach that far
+    virtual size_t read(size_t const & offset, uint8_t * buffer, size_t const & total_bytes) = 0;
+};
+
+#endif // IDelta_Source_h
@@ -106,7 +106,7 @@ class IMQTT_Client {
     /// @return Whether the client is currently connected or not
     virtual bool connected() = 0;
 
-#if THINGSBOARD_ENABLE_STREAM_UTILS
+#if THINGSBOARD_ENABLE_STREAM_PUBLISH
 
     /// @brief Start to publish a message over a given topic, without being restricted to the internal buffer size.
     /// Meaning it allows for arbitrarily large payloads to be sent without them having to be copied into a new buffer and held in memory.
@@ -120,6 +120,7 @@ class IMQTT_Client {
     /// @return Whether the complete packet was sent successfully or not
     virtual bool end_publish() = 0;
 
+#if THINGSBOARD_ENABLE_STREAM_UTILS
     //----------------------------------------------------------------------------
     // Print interface
     //----------------------------------------------------------------------------
@@ -131,6 +132,7 @@ class IMQTT_Client {
     /// @param payload_byte Byte containing part of the payload that should be sent
     /// @return The amount of bytes successfully written
     virtual size_t write(uint8_t payload_byte) = 0;
+#endif // THINGSBOARD_ENABLE_STREAM_UTILS
 
     /// @brief Sends a buffer containing multiple bytes of payload to be published, is meant to be used after having calling begin_publish()
     /// Once the complete payload has been written ensure to call end_publish() to send any remaining bytes
@@ -139,7 +141,7 @@ class IMQTT_Client {
     /// @return The amount of bytes successfully written
     virtual size_t write(uint8_t const * buffer, size_t const & size) = 0;
 
-#endif // THINGSBOARD_ENABLE_STREAM_UTILS
+#endif // THINGSBOARD_ENABLE_STREAM_PUBLISH
 };
 
 #endif // IMQTT_Client_h
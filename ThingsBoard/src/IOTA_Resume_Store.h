@@ -0,0 +1,48 @@
+#ifndef IOTA_Resume_Store_h
+#define IOTA_Resume_Store_h
+
+// Local include.
+#include "Configuration.h"
+#include "HashGenerator.h"
+
+// Library include.
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Maximum size consists of size required for byte representation of the hash * 2 because every byte is 2 hex characters + 1 for null termination
+size_t constexpr OTA_RESUME_CHECKSUM_SIZE = (MBEDTLS_MD_MAX_SIZE * 2U) + 1;
+// Progress is only persisted at offsets that are a multiple of the flash sector size, so a resumed update can erase the sectors following it without touching written data
+size_t constexpr OTA_RESUME_ALIGNMENT = 4096U;
+
+
+/// @brief Progress of a firmware download that was written into the update partition, persisted so the download can continue after a lost connection or a restart,
+/// instead of requesting the complete firmware binary again
+struct OTA_Resume_State {
+    uint32_t firmware_id;                        // FNV-1a hash of the title and the version of the firmware the progress belongs to
+    char     checksum[OTA_RESUME_CHECKSUM_SIZE]; // Checksum of the complete firmware binary the progress belongs to
+    uint32_t firmware_size;                      // Total size of the firmware binary
+    uint16_t chunk_size;                         // Size of the chunks the firmware binary was requested in
+    uint32_t written_chunks;                     // Amount of chunks from the beginning of the firmware binary that have been written
+};
+
+
+/// @brief Interface for a non-volatile store that the OTA_Handler keeps the progress of a firmware download in while it is written,
+/// so an update that broke off can be resumed with an IUpdater that supports IUpdater::resume()
+class IOTA_Resume_Store {
+  public:
+    /// @brief Loads the last saved progress
+    /// @param state Progress the saved values will be copied into
+    /// @return Whether any progress was saved or not
+    virtual bool load(OTA_Resume_State & state) = 0;
+
+    /// @brief Saves the given progress, replacing the one saved before
+    /// @param state Progress that should be saved
+    /// @return Whether saving was successful or not
+    virtual bool save(OTA_Resume_State const & state) = 0;
+
+    /// @brief Removes the saved progress, once the update finished or its written data can not be used anymore
+    virtual void clear() = 0;
+};
+
+#endif // IOTA_Resume_Store_h
@@ -30,6 +30,25 @@ class IUpdater {
     /// @brief Ends the update and returns wheter it was successfully completed
     /// @return Whether the complete amount of bytes initally given was successfully written or not
     virtual bool end() = 0;
+
+    /// @brief Continues an update that was interrupted, instead of beginning it anew. Keeps the bytes already written in front of the given offset
+    /// and writes the following packets after them, until the update is ended or reset. Only has to be implemented by updaters that write directly into a partition
+    /// which survives a lost connection or a restart, the default does not support resuming, which restarts the update from its beginning instead
+    /// @param firmware_size Total size of the data that should be written, the same one the interrupted update began with
+    /// @param offset Amount of bytes that have already been written, is always a multiple of OTA_RESUME_ALIGNMENT
+    /// @return Whether the update can be continued from the given offset or not
+    virtual bool resume(size_t const & firmware_size, size_t const & offset) {
+        return false;
+    }
+
+    /// @brief Reads back the bytes written by an update that was resumed, which are then hashed again, so the final checksum covers the whole firmware
+    /// @param offset Position in the written data to read from
+    /// @param buffer Buffer the read bytes are copied into
+    /// @param total_bytes Amount of bytes that should be read
+    /// @return Total amount of bytes that were successfully read
+    virtual size_t read(size_t const & offset, uint8_t * buffer, size_t const & total_bytes) {
+        return 0U;
+    }
 };
 
 #endif // IUpdater_h
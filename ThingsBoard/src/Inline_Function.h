@@ -0,0 +1,153 @@
+#ifndef Inline_Function_h
+#define Inline_Function_h
+
+// Local include.
+#include "Configuration.h"
+
+#if THINGSBOARD_ENABLE_STL && THINGSBOARD_ENABLE_INLINE_CALLBACK
+
+// Library includes.
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Size in bytes of the storage every callback has for the callable it wraps, which has to fit into it completely.
+// The default holds a function pointer, a lambda capturing up to four pointers or references, or a std::bind of a member method with the instance pointer and its placeholders
+#ifndef THINGSBOARD_CALLBACK_INLINE_SIZE
+#define THINGSBOARD_CALLBACK_INLINE_SIZE (4U * sizeof(void *))
+#endif // THINGSBOARD_CALLBACK_INLINE_SIZE
+
+
+template <typename Signature, size_t Size>
+class Inline_Function;
+
+/// @brief Replacement for std::function, that stores the wrapped callable inside of the instance itself instead of on the heap.
+/// std::function is free to allocate for any callable that is bigger than its own small buffer, which depends on the implementation and can even be only a single pointer,
+/// meaning a capturing lambda or a std::bind can cause a heap allocation every time a callback is created or copied. Callables that do not fit into the given size fail to compile instead,
+/// which makes the memory used by every callback known at compile time. Calling the callback goes through a single function pointer, that was instantiated for the type of the stored callable
+/// @tparam return_type Type the wrapped callable returns
+/// @tparam argument_types Types the wrapped callable receives
+/// @tparam Size Amount of bytes the wrapped callable can take at most
+template <typename return_type, typename... argument_types, size_t Size>
+class Inline_Function<return_type(argument_types...), Size> {
+  public:
+    /// @brief Constructs an empty instance, that evaluates to false
+    Inline_Function(void) = default;
+
+    /// @brief Constructs an empty instance, that evaluates to false. Allows to pass nullptr wherever a callback is expected, the same as with std::function
+    Inline_Function(std::nullptr_t) {
+        // Nothing to do
+    }
+
+    /// @brief Constructor that copies or moves the given callable into the inline storage
+    /// @tparam Callable Type of the function pointer, lambda or function object, has to be invocable with the argument types and fit into the given size
+    /// @param callable Callable that should be called, an empty instance is created if it is a function pointer that is nullptr
+    template <typename Callable, typename = typename std::enable_if<!std::is_same<typename std::decay<Callable>::type, Inline_Function>::value>::type>
+    Inline_Function(Callable && callable) {
+        using Stored = typename std::decay<Callable>::type;
+        static_assert(sizeof(Stored) <= Size, "Callable does not fit into the inline storage of the callback, capture less or increase THINGSBOARD_CALLBACK_INLINE_SIZE");
+        static_assert(alignof(Stored) <= alignof(max_align_t), "Callable requires an alignment bigger than the inline storage of the callback provides");
+        if (Is_Null(callable)) {
+            return;
+        }
+        new (m_storage) Stored(std::forward<Callable>(callable));
+        m_invoke = &Invoke<Stored>;
+        m_manage = &Manage<Stored>;
+    }
+
+    Inline_Function(Inline_Function const & other) {
+        Copy_From(other);
+    }
+
+    Inline_Function & operator=(Inline_Function const & other) {
+        if (this != &other) {
+            Reset();
+            Copy_From(other);
+        }
+        return *this;
+    }
+
+    Inline_Function & operator=(std::nullptr_t) {
+        Reset();
+        return *this;
+    }
+
+    /// @brief Destructor
+    ~Inline_Function() {
+        Reset();
+    }
+
+    /// @brief Returns whether a callable is stored, that can be called
+    explicit operator bool() const {
+        return m_invoke != nullptr;
+    }
+
+    /// @brief Calls the stored callable with the given arguments, has to be checked to not be empty beforehand
+    /// @param ...arguments Arguments that are forwarded to the stored callable
+    /// @return Argument returned by the stored callable
+    return_type operator()(argument_types... arguments) const {
+        return m_invoke(m_storage, std::forward<argument_types>(arguments)...);
+    }
+
+  private:
+    enum class Operation : uint8_t {
+        COPY,
+        DESTROY
+    };
+
+    using Invoker = return_type (*)(void const * storage, argument_types&&... arguments);
+    using Manager = void (*)(Operation operation, void * destination, void const * source);
+
+    template <typename Stored>
+    static return_type Invoke(void const * storage, argument_types&&... arguments) {
+        // Called through a constant instance like std::function, that allows the stored callable to change its own captured state as well
+        return (*static_cast<Stored *>(const_cast<void *>(storage)))(std::forward<argument_types>(arguments)...);
+    }
+
+    template <typename Stored>
+    static void Manage(Operation operation, void * destination, void const * source) {
+        if (operation == Operation::COPY) {
+            new (destination) Stored(*static_cast<Stored const *>(source));
+        }
+        else {
+            static_cast<Stored *>(destination)->~Stored();
+        }
+    }
+
+    template <typename Stored>
+    static bool Is_Null(Stored const &) {
+        return false;
+    }
+
+    template <typename function_return_type, typename... function_argument_types>
+    static bool Is_Null(function_return_type (*function)(function_argument_types...)) {
+        return function == nullptr;
+    }
+
+    void Copy_From(Inline_Function const & other) {
+        if (other.m_manage == nullptr) {
+            return;
+        }
+        other.m_manage(Operation::COPY, m_storage, other.m_storage);
+        m_invoke = other.m_invoke;
+        m_manage = other.m_manage;
+    }
+
+    void Reset() {
+        if (m_manage != nullptr) {
+            m_manage(Operation::DESTROY, m_storage, nullptr);
+        }
+        m_invoke = nullptr;
+        m_manage = nullptr;
+    }
+
+    alignas(max_align_t) unsigned char m_storage[Size] = {}; // Inline storage the wrapped callable is placed into
+    Invoker                            m_invoke = {};        // Calls the callable of the type placed into the storage, nullptr if there is none
+    Manager                            m_manage = {};        // Copies or destroys the callable of the type placed into the storage, nullptr if there is none
+};
+
+#endif // THINGSBOARD_ENABLE_STL && THINGSBOARD_ENABLE_INLINE_CALLBACK
+
+#endif // Inline_Function_h
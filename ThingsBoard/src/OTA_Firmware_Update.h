@@ -13,6 +13,7 @@ uint8_t constexpr OTA_ATTRIBUTE_KEYS_AMOUNT = 5U;
 char constexpr NO_FW_REQUEST_RESPONSE[] = "Did not receive requested shared attribute firmware keys. Ensure keys exist and device is connected";
 // Firmware topics.
 char constexpr FIRMWARE_RESPONSE_TOPIC[] = "v2/fw/response/%u/chunk/";
+char constexpr FIRMWARE_RESPONSE_TOPIC_PREFIX[] = "v2/fw/response/";
 char constexpr FIRMWARE_RESPONSE_SUBSCRIBE_TOPIC[] = "v2/fw/response/+";
 char constexpr FIRMWARE_REQUEST_TOPIC[] = "v2/fw/request/%u/chunk/%u";
 // Firmware data keys.
@@ -157,7 +158,7 @@ class OTA_Firmware_Update : public IAPI_Implementation {
     /// @param current_fw_version Current device firmware version
     /// @return Whether sending the current device firmware information was successful or not
     bool Firmware_Send_Info(char const * current_fw_title, char const * current_fw_version) {
-        StaticJsonDocument<JSON_OBJECT_SIZE(2)> current_firmware_info;
+        TBJsonDocument current_firmware_info;
         current_firmware_info[CURR_FW_TITLE_KEY] = current_fw_title;
         current_firmware_info[CURR_FW_VER_KEY] = current_fw_version;
         return m_send_json_callback.Call_Callback(TELEMETRY_TOPIC, current_firmware_info, Helper::Measure_Json(current_firmware_info));
@@ -170,7 +171,7 @@ class OTA_Firmware_Update : public IAPI_Implementation {
     /// simply do not enter a value and the default value will be used which overwrites the firmware error messages, default = ""
     /// @return Whether sending the current firmware download state was successful or not
     bool Firmware_Send_State(char const * current_fw_state, char const * fw_error = "") {
-        StaticJsonDocument<JSON_OBJECT_SIZE(2)> current_firmware_state;
+        TBJsonDocument current_firmware_state;
         current_firmware_state[FW_ERROR_KEY] = fw_error;
         current_firmware_state[FW_STATE_KEY] = current_fw_state;
         return m_send_json_callback.Call_Callback(TELEMETRY_TOPIC, current_firmware_state, Helper::Measure_Json(current_firmware_state));
@@ -196,6 +197,10 @@ class OTA_Firmware_Update : public IAPI_Implementation {
         return strncmp(m_response_topic, topic, strlen(m_response_topic)) == 0;
     }
 
+    char const * Get_Response_Topic_Prefix() const override {
+        return FIRMWARE_RESPONSE_TOPIC_PREFIX;
+    }
+
     bool Unsubscribe() override {
         Stop_Firmware_Update();
         return true;
@@ -260,7 +265,7 @@ class OTA_Firmware_Update : public IAPI_Implementation {
     /// @return Whether subscribing to the firmware response topic was successful or not
     bool Firmware_OTA_Subscribe() {
         if (!m_subscribe_topic_callback.Call_Callback(FIRMWARE_RESPONSE_SUBSCRIBE_TOPIC)) {
-            char message[JSON_STRING_SIZE(strlen(SUBSCRIBE_TOPIC_FAILED)) + JSON_STRING_SIZE(strlen(FIRMWARE_RESPONSE_SUBSCRIBE_TOPIC))] = {};
+            char message[(strlen(SUBSCRIBE_TOPIC_FAILED) + 1U) + (strlen(FIRMWARE_RESPONSE_SUBSCRIBE_TOPIC) + 1U)] = {};
             (void)snprintf(message, sizeof(message), SUBSCRIBE_TOPIC_FAILED, FIRMWARE_RESPONSE_SUBSCRIBE_TOPIC);
             Logger::println(message);
             Firmware_Send_State(FW_STATE_FAILED, message);
@@ -344,7 +349,7 @@ class OTA_Firmware_Update : public IAPI_Implementation {
         // If firmware title is not the same, we do not initiate an update, because we expect the binary to be for another type of device
         // and downloading it on this device could possibly cause hardware issues or even destroy the device
         else if (strncmp(curr_fw_title, fw_title, strlen(curr_fw_title)) != 0) {
-            char message[JSON_STRING_SIZE(strlen(FW_NOT_FOR_US)) + JSON_STRING_SIZE(strlen(fw_title)) + JSON_STRING_SIZE(strlen(curr_fw_title))] = {};
+            char message[(strlen(FW_NOT_FOR_US) + 1U) + (strlen(fw_title) + 1U) + (strlen(curr_fw_title) + 1U)] = {};
             (void)snprintf(message, sizeof(message), FW_NOT_FOR_US, fw_title, curr_fw_title);
             Logger::println(message);
             Firmware_Send_State(FW_STATE_FAILED, message);
@@ -366,7 +371,7 @@ class OTA_Firmware_Update : public IAPI_Implementation {
             fw_checksum_algorithm = mbedtls_md_type_t::MBEDTLS_MD_SHA512;
         }
         else {
-            char message[JSON_STRING_SIZE(strlen(FW_CHKS_ALGO_NOT_SUPPORTED)) + JSON_STRING_SIZE(strlen(fw_algorithm))] = {};
+            char message[(strlen(FW_CHKS_ALGO_NOT_SUPPORTED) + 1U) + (strlen(fw_algorithm) + 1U)] = {};
             (void)snprintf(message, sizeof(message), FW_CHKS_ALGO_NOT_SUPPORTED, fw_algorithm);
             Logger::println(message);
             Firmware_Send_State(FW_STATE_FAILED, message);
@@ -383,7 +388,7 @@ class OTA_Firmware_Update : public IAPI_Implementation {
 #if THINGSBOARD_ENABLE_DEBUG
         Logger::println(PAGE_BREAK);
         Logger::println(NEW_FW);
-        char firmware[JSON_STRING_SIZE(strlen(FROM_TOO)) + JSON_STRING_SIZE(strlen(curr_fw_version)) + JSON_STRING_SIZE(strlen(fw_version))] = {};
+        char firmware[(strlen(FROM_TOO) + 1U) + (strlen(curr_fw_version) + 1U) + (strlen(fw_version) + 1U)] = {};
         (void)snprintf(firmware, sizeof(firmware), FROM_TOO, curr_fw_version, fw_version);
         Logger::println(firmware);
         Logger::println(DOWNLOADING_FW);
@@ -405,7 +410,7 @@ class OTA_Firmware_Update : public IAPI_Implementation {
             return;
         }
 
-        m_ota.Start_Firmware_Update(m_fw_callback, fw_size, fw_checksum, fw_checksum_algorithm);
+        m_ota.Start_Firmware_Update(m_fw_callback, fw_title, fw_version, fw_size, fw_checksum, fw_checksum_algorithm);
     }
 
 #if !THINGSBOARD_ENABLE_STL
@@ -12,6 +12,7 @@
 #include "Helper.h"
 
 // Library includes.
+#include <stdint.h>
 #include <string.h>
 
 
@@ -25,7 +26,7 @@ char constexpr FW_STATE_UPDATED[] = "UPDATED";
 // Log messages.
 char constexpr OTA_CB_IS_NULL[] = "OTA update callback is NULL, has it been deleted";
 char constexpr UNABLE_TO_REQUEST_CHUNCKS[] = "Unable to request firmware chunk";
-char constexpr RECEIVED_UNEXPECTED_CHUNK[] = "Received chunk (%u), not the same as requested chunk (%u)";
+char constexpr RECEIVED_UNEXPECTED_CHUNK[] = "Received chunk (%u), not one of the requested chunks starting at (%u)";
 char constexpr RECEIVED_UNEXPECTED_CHUNK_SIZE[] = "Received chunk size (%u), not the same as expected chunk size (%u)";
 char constexpr ERROR_UPDATE_BEGIN[] = "Failed to initalize flash updater, ensure that the partition scheme has two app sections";
 char constexpr ERROR_UPDATE_WRITE[] = "Only wrote (%u) bytes of binary data instead of expected (%u)";
@@ -33,6 +34,8 @@ char constexpr ERROR_UPDATE_END[] = "Error during flash updater not all bytes wr
 char constexpr CHECKSUM_VERIFICATION_FAILED[] = "Calculated checksum (%s), not the same as expected checksum (%s)";
 char constexpr FW_UPDATE_ABORTED[] = "Firmware update aborted";
 char constexpr CHUNK_REQUEST_TIMED_OUT[] = "Failed to receive requested chunk (%u) in (%llu) us. Internet connection might have been lost";
+char constexpr RESUMING_FW[] = "Resuming firmware update after (%u) of (%u) chunks";
+char constexpr ERROR_UPDATE_READ[] = "Failed to read back the written binary data of the interrupted update, restarting it";
 #if THINGSBOARD_ENABLE_DEBUG
 char constexpr FW_CHUNK[] = "Receive chunk (%u), with size (%u) bytes";
 char constexpr HASH_EXPECTED[] = "Expected checksum: (%s)";
@@ -41,6 +44,13 @@ char constexpr FW_UPDATE_SUCCESS[] = "Update success";
 #endif // THINGSBOARD_ENABLE_DEBUG
 // Maximum size consists of size required for byte representation of the hash * 2 because every byte is 2 hex characters + 1 for null termination
 size_t constexpr FIRMWARE_HASH_SIZE = (MBEDTLS_MD_MAX_SIZE * 2U) + 1;
+// Maximum amount of chunks that can be requested ahead, see OTA_Update_Callback::Set_Chunk_Window()
+uint8_t constexpr OTA_MAX_CHUNK_WINDOW = 8U;
+// Marks a slot of the reorder buffer that does not hold a chunk
+size_t constexpr FREE_REORDER_SLOT = SIZE_MAX;
+// Amount of written bytes after which the progress is persisted again, if the OTA_Update_Callback has a resume store.
+// Persisting after every chunk would wear the flash memory for little gain, because the chunks in between are simply downloaded again
+size_t constexpr OTA_RESUME_INTERVAL = (32U * 1024U);
 
 
 /// @brief Handles the complete processing of received binary firmware data, including flashing it onto the device,
@@ -61,28 +71,57 @@ class OTA_Handler {
       , m_fw_size(0U)
       , m_fw_checksum()
       , m_fw_checksum_algorithm()
+      , m_fw_id(0U)
       , m_hash()
       , m_total_chunks(0U)
       , m_requested_chunks(0U)
+      , m_next_request(0U)
+      , m_saved_bytes(0U)
+      , m_chunk_window(1U)
+      , m_reorder_buffer(nullptr)
+      , m_reorder_chunks()
+      , m_reorder_sizes()
       , m_retries(0U)
       , m_watchdog(std::bind(&OTA_Handler::Handle_Request_Timeout, this))
     {
         // Nothing to do
     }
 
-    /// @brief Starts the firmware update with requesting the first firmware packet and initalizes the underlying needed components
+    /// @brief Destructor
+    ~OTA_Handler() {
+        Free_Reorder_Buffer();
+    }
+
+    /// @brief Starts the firmware update with requesting the first firmware packet and initalizes the underlying needed components.
+    /// If the progress of an interrupted download of the same firmware was persisted, the update is resumed with the chunks following the already written ones instead
     /// @param fw_callback Callback method that contains configuration information, about the over the air update
+    /// @param fw_title Title of the firmware that will be downloaded, together with the version decides whether persisted progress belongs to the same firmware
+    /// @param fw_version Version of the firmware that will be downloaded
     /// @param fw_size Complete size of the firmware binary that will be downloaded and flashed onto this device
     /// @param fw_checksum Checksum of the complete firmware binary, should be the same as the actually written data in the end
     /// @param fw_checksum_algorithm Algorithm type used to hash the firmware binary
-    void Start_Firmware_Update(OTA_Update_Callback const & fw_callback, size_t const & fw_size, char const * fw_checksum, mbedtls_md_type_t const & fw_checksum_algorithm) {
+    void Start_Firmware_Update(OTA_Update_Callback const & fw_callback, char const * fw_title, char const * fw_version, size_t const & fw_size, char const * fw_checksum, mbedtls_md_type_t const & fw_checksum_algorithm) {
         m_fw_callback = &fw_callback;
+        m_fw_id = Firmware_ID(fw_title, fw_version);
         m_fw_size = fw_size;
         m_total_chunks = (m_fw_size / m_fw_callback->Get_Chunk_Size()) + 1U;
         (void)strncpy(m_fw_checksum, fw_checksum, sizeof(m_fw_checksum));
         m_fw_checksum_algorithm = fw_checksum_algorithm;
         m_fw_updater = m_fw_callback->Get_Updater();
-        Request_First_Firmware_Packet();
+        m_chunk_window = m_fw_callback->Get_Chunk_Window();
+        if (m_chunk_window == 0U) {
+            m_chunk_window = 1U;
+        }
+        else if (m_chunk_window > OTA_MAX_CHUNK_WINDOW) {
+            m_chunk_window = OTA_MAX_CHUNK_WINDOW;
+        }
+        Free_Reorder_Buffer();
+        if (m_chunk_window > 1U) {
+            m_reorder_buffer = new uint8_t[(m_chunk_window - 1U) * m_fw_callback->Get_Chunk_Size()];
+        }
+        if (!Resume_Firmware_Update()) {
+            Request_First_Firmware_Packet();
+        }
         (void)m_send_fw_state_callback.Call_Callback(FW_STATE_DOWNLOADING, "");
     }
 
@@ -98,31 +137,68 @@ class OTA_Handler {
     }
 
     /// @brief Uses the given firmware packet data and process it. Starting with writing the given amount of bytes of the packet data into flash memory and
-    /// into a hash function that will be used to compare the expected complete binary file and the actually received binary file
+    /// into a hash function that will be used to compare the expected complete binary file and the actually received binary file.
+    /// Chunks that were requested ahead and arrive before the chunks preceding them are kept until those have been written
     /// @param current_chunk Index of the chunk we recieved the binary data for
     /// @param payload Firmware packet data of the current chunk
     /// @param total_bytes Amount of bytes in the current firmware packet data
     void Process_Firmware_Packet(size_t const & current_chunk, uint8_t * payload, size_t const & total_bytes)  {
-        if (current_chunk != m_requested_chunks) {
+        if (current_chunk < m_requested_chunks || current_chunk >= m_next_request) {
             Logger::printfln(RECEIVED_UNEXPECTED_CHUNK, current_chunk, m_requested_chunks);
             return;
         }
         size_t expected_chunk_size = 0U;
-        if (!Received_Valid_Chunk_Size(total_bytes, expected_chunk_size)) {
+        if (!Received_Valid_Chunk_Size(current_chunk, total_bytes, expected_chunk_size)) {
             Logger::printfln(RECEIVED_UNEXPECTED_CHUNK_SIZE, expected_chunk_size, total_bytes);
             return;
         }
 
-        m_watchdog.detach();
     #if THINGSBOARD_ENABLE_DEBUG
         Logger::printfln(FW_CHUNK, current_chunk, total_bytes);
     #endif // THINGSBOARD_ENABLE_DEBUG
 
-        if (current_chunk == 0U) {
+        if (current_chunk != m_requested_chunks) {
+            Keep_Firmware_Packet(current_chunk, payload, total_bytes);
+            return;
+        }
+
+        m_watchdog.detach();
+        if (!Write_Firmware_Packet(payload, total_bytes)) {
+            return;
+        }
+        // Write the chunks that were received ahead and now follow directly onto the written data
+        for (uint8_t slot = Find_Kept_Firmware_Packet(m_requested_chunks); slot < m_chunk_window - 1U; slot = Find_Kept_Firmware_Packet(m_requested_chunks)) {
+            m_reorder_chunks[slot] = FREE_REORDER_SLOT;
+            if (!Write_Firmware_Packet(m_reorder_buffer + (slot * m_fw_callback->Get_Chunk_Size()), m_reorder_sizes[slot])) {
+                return;
+            }
+        }
+
+        // Reset retries as the current chunk has been downloaded and handled successfully
+        m_retries = m_fw_callback->Get_Chunk_Retries();
+        Request_Next_Firmware_Packet();
+    }
+
+#if !THINGSBOARD_USE_ESP_TIMER
+    /// @brief Used to update the watchdog timer which uses a simple software time in the background. Ensure to call recently often for higher precision.
+    /// Meaning the timer is actually triggered closer to the specified waiting time
+    void update() {
+        m_watchdog.update();
+    }
+#endif // !THINGSBOARD_USE_ESP_TIMER
+
+  private:
+    /// @brief Writes the given chunk, which has to be the one following the already written ones, into flash memory and into the hash and informs the user about the progress
+    /// @param payload Firmware packet data of the chunk
+    /// @param total_bytes Amount of bytes in the firmware packet data
+    /// @return Whether the chunk was written and the update can continue, if not the failure has already been handled
+    bool Write_Firmware_Packet(uint8_t * payload, size_t const & total_bytes) {
+        if (m_requested_chunks == 0U) {
             // Initialize Flash
             if (!m_fw_updater->begin(m_fw_size)) {
                 Logger::println(ERROR_UPDATE_BEGIN);
-                return Handle_Failure(OTA_Failure_Response::RETRY_UPDATE, ERROR_UPDATE_BEGIN);
+                Handle_Failure(OTA_Failure_Response::RETRY_UPDATE, ERROR_UPDATE_BEGIN);
+                return false;
             }
         }
 
@@ -132,45 +208,82 @@ class OTA_Handler {
             char message[Helper::detectSize(ERROR_UPDATE_WRITE, written_bytes, total_bytes)] = {};
             (void)snprintf(message, sizeof(message), ERROR_UPDATE_WRITE, written_bytes, total_bytes);
             Logger::println(message);
-            return Handle_Failure(OTA_Failure_Response::RETRY_UPDATE, message);
+            Handle_Failure(OTA_Failure_Response::RETRY_UPDATE, message);
+            return false;
         }
 
         // Update value only if writing to flash was a success, result is ignored,
         // because it can only fail if the input parameters are invalid
         (void)m_hash.update(payload, total_bytes);
 
-        m_requested_chunks = current_chunk + 1;
+        m_requested_chunks++;
+        Save_Resume_State();
         m_fw_callback->Call_Progress_Callback(m_requested_chunks, m_total_chunks);
 
         // Ensure to check if the update was cancelled during the progress callback,
         // if it was the callback variable was reset and there is no need to request the next firmware packet
         if (m_fw_callback == nullptr) {
             Logger::println(OTA_CB_IS_NULL);
-            return Handle_Failure(OTA_Failure_Response::RETRY_NOTHING, OTA_CB_IS_NULL);
+            Handle_Failure(OTA_Failure_Response::RETRY_NOTHING, OTA_CB_IS_NULL);
+            return false;
         }
+        return true;
+    }
 
-        // Reset retries as the current chunk has been downloaded and handled successfully
-        m_retries = m_fw_callback->Get_Chunk_Retries();
-        Request_Next_Firmware_Packet();
+    /// @brief Copies a chunk that arrived before the chunks preceding it into a free slot of the reorder buffer, so it does not have to be requested again.
+    /// If it is already kept or no slot is free it is discarded and requested again once the request timed out
+    /// @param current_chunk Index of the chunk we recieved the binary data for
+    /// @param payload Firmware packet data of the chunk
+    /// @param total_bytes Amount of bytes in the firmware packet data
+    void Keep_Firmware_Packet(size_t const & current_chunk, uint8_t const * payload, size_t const & total_bytes) {
+        if (Find_Kept_Firmware_Packet(current_chunk) < m_chunk_window - 1U) {
+            return;
+        }
+        uint8_t const slot = Find_Kept_Firmware_Packet(FREE_REORDER_SLOT);
+        if (slot >= m_chunk_window - 1U) {
+            return;
+        }
+        (void)memcpy(m_reorder_buffer + (slot * m_fw_callback->Get_Chunk_Size()), payload, total_bytes);
+        m_reorder_chunks[slot] = current_chunk;
+        m_reorder_sizes[slot] = total_bytes;
     }
 
-#if !THINGSBOARD_USE_ESP_TIMER
-    /// @brief Used to update the watchdog timer which uses a simple software time in the background. Ensure to call recently often for higher precision.
-    /// Meaning the timer is actually triggered closer to the specified waiting time
-    void update() {
-        m_watchdog.update();
+    /// @brief Searches the reorder buffer for the slot that holds the given chunk
+    /// @param chunk Index of the chunk to search for, FREE_REORDER_SLOT to search for a free slot
+    /// @return Slot holding the given chunk, or m_chunk_window - 1 if no slot holds it
+    uint8_t Find_Kept_Firmware_Packet(size_t const & chunk) const {
+        uint8_t slot = 0U;
+        for (; slot < m_chunk_window - 1U; slot++) {
+            if (m_reorder_chunks[slot] == chunk) {
+                break;
+            }
+        }
+        return slot;
+    }
+
+    /// @brief Marks all slots of the reorder buffer as free
+    void Clear_Reorder_Buffer() {
+        for (auto & chunk : m_reorder_chunks) {
+            chunk = FREE_REORDER_SLOT;
+        }
+    }
+
+    /// @brief Releases the reorder buffer, once the update has completed or failed
+    void Free_Reorder_Buffer() {
+        delete[] m_reorder_buffer;
+        m_reorder_buffer = nullptr;
+        Clear_Reorder_Buffer();
     }
-#endif // !THINGSBOARD_USE_ESP_TIMER
 
-  private:
     /// @brief Checks whether the received chunk size matches the expected chunk size, should be the configured chunk size of the OTA_Update_Callback, CHUNK_SIZE (4096) per default
     /// and it should be the remaining bytes to fill the total firmware size with the last received chunk. If that is not the case then something went wrong with the request and we have to rerequest that specific chunk,
     /// because if we do not do that we would write missing or only partial binary data to flash and into the hash, meaning the complete OTA update will be invalidated at the end and has to be restarted
+    /// @param current_chunk Index of the received chunk
     /// @param received_chunk_size Size in bytes of the received chunk
-    /// @param expected_chunk_size Variable the expected chunk size for the currently requested chunk will be copied into
+    /// @param expected_chunk_size Variable the expected chunk size for the received chunk will be copied into
     /// @return Whether the received chunk has the expected size or not
-    bool Received_Valid_Chunk_Size(size_t const & received_chunk_size, size_t & expected_chunk_size) {
-        bool const is_last_chunk = m_requested_chunks + 1 >= m_total_chunks;
+    bool Received_Valid_Chunk_Size(size_t const & current_chunk, size_t const & received_chunk_size, size_t & expected_chunk_size) {
+        bool const is_last_chunk = current_chunk + 1 >= m_total_chunks;
         if (is_last_chunk) {
             size_t const last_chunk_expected_size = m_fw_size % m_fw_callback->Get_Chunk_Size();
             expected_chunk_size = last_chunk_expected_size;
@@ -180,9 +293,101 @@ class OTA_Handler {
         return received_chunk_size == m_fw_callback->Get_Chunk_Size();
     }
 
+    /// @brief Returns the FNV-1a hash of the given firmware title and version, the null terminator in between keeps the title "ab" with the version "c" apart from the title "a" with the version "bc"
+    /// @param fw_title Title of the firmware
+    /// @param fw_version Version of the firmware
+    /// @return Hash of the firmware title and version
+    static uint32_t Firmware_ID(char const * fw_title, char const * fw_version) {
+        uint32_t hash = Helper::FNV_1a_Hash(Helper::FNV_1a_Hash(fw_title), '\0');
+        for (; *fw_version != '\0'; ++fw_version) {
+            hash = Helper::FNV_1a_Hash(hash, *fw_version);
+        }
+        return hash;
+    }
+
+    /// @brief Persists the progress of the download once another OTA_RESUME_INTERVAL bytes have been written, at an offset aligned to OTA_RESUME_ALIGNMENT,
+    /// so an interrupted update of the same firmware can continue from it. Nothing is persisted if the OTA_Update_Callback has no resume store
+    void Save_Resume_State() {
+        IOTA_Resume_Store * resume_store = m_fw_callback->Get_Resume_Store();
+        size_t const written_bytes = m_requested_chunks * m_fw_callback->Get_Chunk_Size();
+        if (resume_store == nullptr || m_requested_chunks >= m_total_chunks || (written_bytes % OTA_RESUME_ALIGNMENT) != 0U || written_bytes - m_saved_bytes < OTA_RESUME_INTERVAL) {
+            return;
+        }
+        OTA_Resume_State state = {};
+        state.firmware_id = m_fw_id;
+        (void)strncpy(state.checksum, m_fw_checksum, sizeof(state.checksum) - 1U);
+        state.firmware_size = m_fw_size;
+        state.chunk_size = m_fw_callback->Get_Chunk_Size();
+        state.written_chunks = m_requested_chunks;
+        if (resume_store->save(state)) {
+            m_saved_bytes = written_bytes;
+        }
+    }
+
+    /// @brief Removes the persisted progress, if there is a resume store
+    void Clear_Resume_State() {
+        IOTA_Resume_Store * resume_store = m_fw_callback->Get_Resume_Store();
+        if (resume_store != nullptr) {
+            resume_store->clear();
+        }
+    }
+
+    /// @brief Continues an interrupted download of the same firmware, with the chunks following the ones the persisted progress says were written.
+    /// The hash is started again over the data read back from the partition, because hardware accelerated hash contexts can not be persisted,
+    /// which additionally means the final checksum is calculated over the data that was actually written
+    /// @return Whether the update was resumed and the next chunks have been requested, if not it has to be started from its beginning
+    bool Resume_Firmware_Update() {
+        IOTA_Resume_Store * resume_store = m_fw_callback->Get_Resume_Store();
+        OTA_Resume_State state = {};
+        if (resume_store == nullptr || !resume_store->load(state)) {
+            return false;
+        }
+
+        uint16_t const & chunk_size = m_fw_callback->Get_Chunk_Size();
+        size_t const written_bytes = state.written_chunks * chunk_size;
+        if (state.firmware_id != m_fw_id || strncmp(state.checksum, m_fw_checksum, sizeof(state.checksum)) != 0 || state.firmware_size != m_fw_size || state.chunk_size != chunk_size ||
+          state.written_chunks == 0U || state.written_chunks >= m_total_chunks || !m_fw_updater->resume(m_fw_size, written_bytes)) {
+            return false;
+        }
+
+        // Hash start result is ignored, because it can only fail if the input parameters are invalid
+        (void)m_hash.start(m_fw_checksum_algorithm);
+        uint8_t * chunk = new uint8_t[chunk_size];
+        size_t read_chunks = 0U;
+        for (; read_chunks < state.written_chunks; read_chunks++) {
+            if (m_fw_updater->read(read_chunks * chunk_size, chunk, chunk_size) != chunk_size) {
+                break;
+            }
+            (void)m_hash.update(chunk, chunk_size);
+        }
+        delete[] chunk;
+        if (read_chunks != state.written_chunks) {
+            Logger::println(ERROR_UPDATE_READ);
+            return false;
+        }
+
+        char message[Helper::detectSize(RESUMING_FW, read_chunks, m_total_chunks)] = {};
+        (void)snprintf(message, sizeof(message), RESUMING_FW, read_chunks, m_total_chunks);
+        Logger::println(message);
+
+        m_requested_chunks = read_chunks;
+        m_next_request = read_chunks;
+        m_saved_bytes = written_bytes;
+        Clear_Reorder_Buffer();
+        m_retries = m_fw_callback->Get_Chunk_Retries();
+        m_watchdog.detach();
+        Request_Next_Firmware_Packet();
+        return true;
+    }
+
     /// @brief Restarts or starts the firmware update and its needed components and then requests the first firmware chunk
     void Request_First_Firmware_Packet()  {
         m_requested_chunks = 0U;
+        m_next_request = 0U;
+        m_saved_bytes = 0U;
+        // Progress of a previous download can not be used anymore, because the partition is overwritten from its beginning
+        Clear_Resume_State();
+        Clear_Reorder_Buffer();
         m_retries = m_fw_callback->Get_Chunk_Retries();
         // Hash start result is ignored, because it can only fail if the input parameters are invalid
         (void)m_hash.start(m_fw_checksum_algorithm);
@@ -191,8 +396,8 @@ class OTA_Handler {
         Request_Next_Firmware_Packet();
     }
 
-    /// @brief Requests the next firmware chunk of the OTA firmware if there are any left
-    /// and starts the timer that ensures we request the same chunk again if we have not received a response yet
+    /// @brief Requests the next firmware chunks of the OTA firmware if there are any left, until as many chunks following the already written ones are requested as the chunk window allows,
+    /// and starts the timer that ensures we request the same chunks again if we have not received a response yet
     void Request_Next_Firmware_Packet()  {
         // Check if we have already requested and handled the last remaining chunk
         if (m_requested_chunks >= m_total_chunks) {
@@ -200,8 +405,21 @@ class OTA_Handler {
             return;
         }
 
-        if (!m_publish_callback.Call_Callback(m_fw_callback->Get_Request_ID(), m_requested_chunks)) {
-            Logger::println(UNABLE_TO_REQUEST_CHUNCKS);
+        size_t window_end = m_requested_chunks + m_chunk_window;
+        if (window_end > m_total_chunks) {
+            window_end = m_total_chunks;
+        }
+        while (m_next_request < window_end) {
+            size_t const chunk = m_next_request++;
+            // Chunks that arrived ahead before the request timed out do not need to be requested again
+            if (Find_Kept_Firmware_Packet(chunk) < m_chunk_window - 1U) {
+                continue;
+            }
+            if (!m_publish_callback.Call_Callback(m_fw_callback->Get_Request_ID(), chunk)) {
+                Logger::println(UNABLE_TO_REQUEST_CHUNCKS);
+                m_next_request = chunk;
+                break;
+            }
         }
 
         // Watchdog gets started no matter if publishing request was successful or not in hopes,
@@ -226,6 +444,8 @@ class OTA_Handler {
             char message[Helper::detectSize(CHECKSUM_VERIFICATION_FAILED, calculated_checksum, m_fw_checksum)] = {};
             (void)snprintf(message, sizeof(message), CHECKSUM_VERIFICATION_FAILED, calculated_checksum, m_fw_checksum);
             Logger::println(message);
+            // Ensures an update that failed its last retry is not resumed with the same invalid data again
+            Clear_Resume_State();
             return Handle_Failure(OTA_Failure_Response::RETRY_UPDATE, message);
         }
 
@@ -235,6 +455,7 @@ class OTA_Handler {
 
         if (!m_fw_updater->end()) {
             Logger::println(ERROR_UPDATE_END);
+            Clear_Resume_State();
             return Handle_Failure(OTA_Failure_Response::RETRY_UPDATE, ERROR_UPDATE_END);
         }
 
@@ -242,8 +463,10 @@ class OTA_Handler {
         Logger::println(FW_UPDATE_SUCCESS);
     #endif // THINGSBOARD_ENABLE_DEBUG
 
+        Clear_Resume_State();
         (void)m_send_fw_state_callback.Call_Callback(FW_STATE_UPDATING, "");
         m_fw_callback->Call_Callback(true);
+        Free_Reorder_Buffer();
         (void)m_finish_callback.Call_Callback();
     }
 
@@ -255,6 +478,7 @@ class OTA_Handler {
         if (m_retries <= 0) {
             (void)m_send_fw_state_callback.Call_Callback(FW_STATE_FAILED, error_message);
             m_fw_callback->Call_Callback(false);
+            Free_Reorder_Buffer();
             (void)m_finish_callback.Call_Callback();
             return;
         }
@@ -265,6 +489,8 @@ class OTA_Handler {
 
         switch (failure_response) {
             case OTA_Failure_Response::RETRY_CHUNK:
+                // Requests every chunk of the window again, because it is not known which of them got lost
+                m_next_request = m_requested_chunks;
                 Request_Next_Firmware_Packet();
                 break;
             case OTA_Failure_Response::RETRY_UPDATE:
@@ -273,6 +499,7 @@ class OTA_Handler {
             case OTA_Failure_Response::RETRY_NOTHING:
                 (void)m_send_fw_state_callback.Call_Callback(FW_STATE_FAILED, error_message);
                 m_fw_callback->Call_Callback(false);
+                Free_Reorder_Buffer();
                 (void)m_finish_callback.Call_Callback();
                 break;
             default:
@@ -297,10 +524,17 @@ class OTA_Handler {
     size_t                                                 m_fw_size = {};                         // Total size of the firmware binary we will receive. Allows for a binary size of up to theoretically 4 GB
     char                                                   m_fw_checksum[FIRMWARE_HASH_SIZE] = {}; // Checksum of the complete firmware binary, should be the same as the actually written data in the end
     mbedtls_md_type_t                                      m_fw_checksum_algorithm = {};           // Algorithm type used to hash the firmware binary
+    uint32_t                                               m_fw_id = {};                           // Hash of the firmware title and version, decides together with the checksum whether persisted progress belongs to the same firmware
     IUpdater                                               *m_fw_updater = {};                     // Interface implementation that writes received firmware binary data onto the given device
     HashGenerator                                          m_hash = {};                            // Class instance that allows to generate a hash from received firmware binary data
     size_t                                                 m_total_chunks = {};                    // Total amount of chunks that need to be received to get the complete firmware binary
     size_t                                                 m_requested_chunks = {};                // Amount of successfully requested and received firmware binary chunks
+    size_t                                                 m_next_request = {};                    // Index of the next firmware binary chunk that has not been requested yet
+    size_t                                                 m_saved_bytes = {};                     // Amount of written bytes the persisted progress covers
+    uint8_t                                                m_chunk_window = {};                    // Amount of chunks following the written ones that are requested at once
+    uint8_t                                                *m_reorder_buffer = {};                 // Holds the chunks that arrived before the chunks preceding them, one slot of the chunk size per chunk requested ahead
+    size_t                                                 m_reorder_chunks[OTA_MAX_CHUNK_WINDOW - 1U] = {}; // Index of the chunk kept in each slot of the reorder buffer, FREE_REORDER_SLOT if the slot is free
+    size_t                                                 m_reorder_sizes[OTA_MAX_CHUNK_WINDOW - 1U] = {};  // Amount of bytes of the chunk kept in each slot of the reorder buffer
     uint8_t                                                m_retries = {};                         // Amount of request retries we attempt for each chunk, increasing makes the connection more stable
     Callback_Watchdog                                      m_watchdog = {};                        // Class instances that allows to timeout if we do not receive a response for a requested chunk in the given time
 };
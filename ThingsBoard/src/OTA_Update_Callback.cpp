@@ -39,6 +39,14 @@ void OTA_Update_Callback::Set_Updater(IUpdater* updater) {
     m_updater = updater;
 }
 
+IOTA_Resume_Store * OTA_Update_Callback::Get_Resume_Store() const {
+    return m_resume_store;
+}
+
+void OTA_Update_Callback::Set_Resume_Store(IOTA_Resume_Store *resume_store) {
+    m_resume_store = resume_store;
+}
+
 size_t const & OTA_Update_Callback::Get_Request_ID() const {
     return m_request_id;
 }
@@ -79,6 +87,14 @@ void OTA_Update_Callback::Set_Chunk_Size(uint16_t chunk_size) {
     m_chunk_size = chunk_size;
 }
 
+uint8_t OTA_Update_Callback::Get_Chunk_Window() const {
+    return m_chunk_window;
+}
+
+void OTA_Update_Callback::Set_Chunk_Window(uint8_t chunk_window) {
+    m_chunk_window = chunk_window;
+}
+
 uint64_t const & OTA_Update_Callback::Get_Timeout() const {
     return m_timeout_microseconds;
 }
@@ -6,12 +6,14 @@
 
 // Local includes.
 #include "IUpdater.h"
+#include "IOTA_Resume_Store.h"
 
 
 // OTA default values.
 uint8_t constexpr CHUNK_RETRIES = 12U;
 uint16_t constexpr CHUNK_SIZE = (4U * 1024U);
 uint64_t constexpr REQUEST_TIMEOUT = (5U * 1000U * 1000U);
+uint8_t constexpr CHUNK_WINDOW = 1U;
 
 
 /// @brief Over the air firmware update callback wrapper,
@@ -77,6 +79,17 @@ class OTA_Update_Callback : public Callback<void, bool const &> {
     /// @param updater Updater implementation that writes the given firmware data
     void Set_Updater(IUpdater *updater);
 
+    /// @brief Gets the store the progress of the firmware download is persisted in
+    /// @return Store the progress is persisted in, nullptr if an interrupted update is always restarted from its beginning
+    IOTA_Resume_Store * Get_Resume_Store() const;
+
+    /// @brief Sets the store the progress of the firmware download is persisted in while it is written. If the same firmware is downloaded again,
+    /// because the connection was lost during the update or the device restarted, the download continues after the chunks already written instead of requesting the complete firmware binary again.
+    /// The written data is read back from the partition to start the hash again, so the checksum in the end still covers the complete firmware binary.
+    /// Requires an updater that implements IUpdater::resume(), for example the Espressif_Updater, default = nullptr
+    /// @param resume_store Store the progress is persisted in, for example the Espressif_OTA_Resume_Store
+    void Set_Resume_Store(IOTA_Resume_Store *resume_store);
+
     /// @brief Gets the unique request identifier that is connected to the original request,
     /// and will be later used to verifiy which OTA_Update_Callback
     /// is connected to which received OTA firmware chunk update
@@ -135,6 +148,18 @@ class OTA_Update_Callback : public Callback<void, bool const &> {
     /// @param chunk_size Size of each single chunk to be downloaded
     void Set_Chunk_Size(uint16_t chunk_size);
 
+    /// @brief Gets the amount of chunks that are requested at once, before the response to the first of them has been received
+    /// @return Amount of chunk requests that may be outstanding at once
+    uint8_t Get_Chunk_Window() const;
+
+    /// @brief Sets the amount of chunks that are requested at once, before the response to the first of them has been received.
+    /// Requesting only one chunk at a time waits a full round trip to the server between each chunk, which makes up most of the update time over connections with a high latency,
+    /// while requesting multiple chunks ahead keeps the connection busy. Chunks received out of order are kept until all chunks before them have been written,
+    /// which requires a heap allocation of (chunk_window - 1) * chunk_size bytes for the duration of the update, additionally the internal buffer of the network client has to be able
+    /// to hold the responses that arrive while a chunk is written, because they are sent without waiting. Is clamped to OTA_MAX_CHUNK_WINDOW (8), default = CHUNK_WINDOW (1)
+    /// @param chunk_window Amount of chunk requests that may be outstanding at once
+    void Set_Chunk_Window(uint8_t chunk_window);
+
     /// @brief Gets the time in microseconds we wait until we declare a single chunk we attempted to download as a failure
     /// @return Timeout time until we expect a response from the server
     uint64_t const & Get_Timeout() const;
@@ -147,11 +172,13 @@ class OTA_Update_Callback : public Callback<void, bool const &> {
     char const                                     *m_current_fw_title = {};        // Current firmware title of device
     char const                                     *m_current_fw_version = {};      // Current firmware version of device
     IUpdater                                       *m_updater = {};                 // Updater implementation used to write firmware data
+    IOTA_Resume_Store                              *m_resume_store = {};            // Store the progress of the firmware download is persisted in
     size_t                                         m_request_id = {};               // Id the request was called with
     Callback<void, size_t const &, size_t const &> m_progress_callback = {};        // Callback called when amount of downloaded chunks increased
     Callback<void>                                 m_update_starting_callback = {}; // Callback called when update is about to start (moment before topic subscription)
     uint8_t                                        m_chunk_retries = {};            // Maximum amount of retries for a single chunk to be downloaded and flashed successfully
     uint16_t                                       m_chunk_size = {};               // Size of chunks the firmware data will be split into
+    uint8_t                                        m_chunk_window = CHUNK_WINDOW;   // Amount of chunks requested at once
     uint64_t                                       m_timeout_microseconds = {};     // How long we wait for each chunck to arrive before declaring it as failed
 };
 
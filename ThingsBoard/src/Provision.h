@@ -52,7 +52,7 @@ class Provision : public IAPI_Implementation {
             return false;
         }
 
-        StaticJsonDocument<JSON_OBJECT_SIZE(9)> request_buffer;
+        TBJsonDocument request_buffer;
         char const * device_name = callback.Get_Device_Name();
         char const * access_token = callback.Get_Device_Access_Token();
         char const * cred_username = callback.Get_Credentials_Username();
@@ -108,7 +108,11 @@ class Provision : public IAPI_Implementation {
     }
 
     bool Compare_Response_Topic(char const * topic) const override {
-        return strncmp(PROV_RESPONSE_TOPIC, topic, JSON_STRING_SIZE(strlen(PROV_RESPONSE_TOPIC))) == 0;
+        return strncmp(PROV_RESPONSE_TOPIC, topic, strlen(PROV_RESPONSE_TOPIC) + 1U) == 0;
+    }
+
+    char const * Get_Response_Topic_Prefix() const override {
+        return PROV_RESPONSE_TOPIC;
     }
 
     bool Unsubscribe() override {
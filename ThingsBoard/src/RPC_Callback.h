@@ -18,19 +18,10 @@ class RPC_Callback : public Callback<void, JsonVariantConst const &, JsonDocumen
     /// @param method_name Name we expect to be sent via. server-side RPC so that this method callback will be called
     /// @param callback Callback method that will be called upon data arrival with the given data that was received serialized into a JsonDocument
     /// and should enter data into the JsonDocument, can be empty if the RPC widget does not expect any response.
-    /// See https://arduinojson.org/v6/api/jsondocument/ for more information on how to enter data into a JsonDocument
-#if THINGSBOARD_ENABLE_DYNAMIC
-    /// @param response_size Internal size the JsonDocument should be able to hold to contain the response to the server side RPC call.
-    /// Use JSON_OBJECT_SIZE() and pass the amount of key value pair to calculate the estimated size. See https://arduinojson.org/v6/assistant/ for more information on how to estimate the required size, default = Default_RPC_Amount (0)
-    RPC_Callback(char const * method_name, function callback, size_t const & response_size = JSON_OBJECT_SIZE(Default_RPC_Amount))
-#else
+    /// See https://arduinojson.org/v7/api/jsondocument/ for more information on how to enter data into a JsonDocument, it grows as required so no size has to be passed
     RPC_Callback(char const * method_name, function callback)
-#endif // THINGSBOARD_ENABLE_DYNAMIC
       : Callback(callback)
       , m_method_name(method_name)
-#if THINGSBOARD_ENABLE_DYNAMIC
-      , m_response_size(response_size)
-#endif // THINGSBOARD_ENABLE_DYNAMIC
     {
         // Nothing to do
     }
@@ -47,26 +38,8 @@ class RPC_Callback : public Callback<void, JsonVariantConst const &, JsonDocumen
         m_method_name = method_name;
     }
 
-#if THINGSBOARD_ENABLE_DYNAMIC
-    /// @brief Gets the internal size the JsonDocument needs to have to contain the response to the server side RPC call.
-    /// @return Internal JsonDocument size
-    size_t const & Get_Response_Size() const {
-        return m_response_size;
-    }
-
-    /// @brief Sets the internal size the JsonDocument needs to have to contain the response to the server side RPC call.
-    /// Use JSON_OBJECT_SIZE() and pass the amount of key value pair to calculate the estimated size. See https://arduinojson.org/v6/assistant/ for more information on how to estimate the required size
-    /// @param response_size Internal JsonDocument size
-    void Set_Response_Size(size_t const & response_size) {
-        m_response_size = response_size;
-    }
-#endif // THINGSBOARD_ENABLE_DYNAMIC
-
   private:
     char const *m_method_name = {};  // Method name
-#if THINGSBOARD_ENABLE_DYNAMIC
-    size_t     m_response_size = {}; // Required size to contain the response
-#endif // THINGSBOARD_ENABLE_DYNAMIC
 };
 
 #endif // RPC_Callback_h
@@ -11,7 +11,7 @@ char constexpr RPC_SUBSCRIBE_TOPIC[] = "v1/devices/me/rpc/request/+";
 char constexpr RPC_REQUEST_TOPIC[] = "v1/devices/me/rpc/request/";
 char constexpr RPC_SEND_RESPONSE_TOPIC[] = "v1/devices/me/rpc/response/%u";
 // Log messages.
-char constexpr RPC_RESPONSE_OVERFLOWED[] = "Server-side RPC response overflowed, increase MaxRPC (%u)";
+char constexpr RPC_RESPONSE_OVERFLOWED[] = "Server-side RPC response overflowed, allocating its memory failed. Ensure there is enough heap memory left";
 #if !THINGSBOARD_ENABLE_DYNAMIC
 char constexpr SERVER_SIDE_RPC_SUBSCRIPTIONS[] = "server-side RPC";
 #endif // !THINGSBOARD_ENABLE_DYNAMIC
@@ -20,6 +20,7 @@ char constexpr SERVER_RPC_METHOD_NULL[] = "Server-side RPC method name is NULL";
 char constexpr RPC_RESPONSE_NULL[] = "Response JsonDocument is NULL, skipping sending";
 char constexpr NO_RPC_PARAMS_PASSED[] = "No parameters passed with RPC, passing null JSON";
 char constexpr CALLING_RPC_CB[] = "Calling subscribed callback for rpc with methodname (%s)";
+char constexpr RPC_RESPONSE_DEFERRED[] = "Response to rpc request (%u) deferred, send it with RPC_Respond";
 #endif // THINGSBOARD_ENABLE_DEBUG
 
 
@@ -31,9 +32,7 @@ template <typename Logger = DefaultLogger>
 #else
 /// @tparam MaxSubscriptions Maximum amount of simultaneous server side rpc subscriptions.
 /// Once the maximum amount has been reached it is not possible to increase the size, this is done because it allows to allcoate the memory on the stack instead of the heap, default = Default_Subscriptions_Amount (1)
-/// @tparam MaxRPC Maximum amount of key-value pairs that will ever be sent in the subscribed callback method of an RPC_Callback, allows to use a StaticJsonDocument on the stack in the background.
-/// If we simply use .to<JsonVariant>(); on the received document and use .set() to change the internal value then the size requirements are 0.
-/// However if we attempt to send multiple key-value pairs, we have to adjust the size accordingly. See https://arduinojson.org/v6/assistant/ for more information on how to estimate the required size and divide the result by 16 to receive the required MaxRPC value, default = Default_RPC_Amount (0)
+/// @tparam MaxRPC Not used anymore, because the ArduinoJson 7 JsonDocument the response is created in grows as required. Only kept to not break existing code that passes it, default = Default_RPC_Amount (0)
 template<size_t MaxSubscriptions = Default_Subscriptions_Amount, size_t MaxRPC = Default_RPC_Amount, typename Logger = DefaultLogger>
 #endif // THINGSBOARD_ENABLE_DYNAMIC
 class Server_Side_RPC : public IAPI_Implementation {
@@ -67,6 +66,7 @@ class Server_Side_RPC : public IAPI_Implementation {
         (void)m_subscribe_topic_callback.Call_Callback(RPC_SUBSCRIBE_TOPIC);
         // Push back complete vector into our local m_rpc_callbacks vector.
         m_rpc_callbacks.insert(m_rpc_callbacks.end(), first, last);
+        Rebuild_Method_Index();
         return true;
     }
 
@@ -89,6 +89,7 @@ class Server_Side_RPC : public IAPI_Implementation {
 #endif // !THINGSBOARD_ENABLE_DYNAMIC
         (void)m_subscribe_topic_callback.Call_Callback(RPC_SUBSCRIBE_TOPIC);
         m_rpc_callbacks.push_back(callback);
+        Rebuild_Method_Index();
         return true;
     }
 
@@ -98,9 +99,48 @@ class Server_Side_RPC : public IAPI_Implementation {
     /// and from the rpc topic, was successful or not
     bool RPC_Unsubscribe() {
         m_rpc_callbacks.clear();
+        Rebuild_Method_Index();
         return m_unsubscribe_topic_callback.Call_Callback(RPC_SUBSCRIBE_TOPIC);
     }
 
+    /// @brief Defers the response to the server-side RPC request, whose subscribed callback is currently being called.
+    /// The callback can then return without entering anything into its JsonDocument and start a slow operation instead,
+    /// for example a command on a serial peripheral that is answered asynchronously, so the MQTT loop is not blocked while it is waiting.
+    /// Once the result is known, it is sent with RPC_Respond() and the request id received here.
+    /// Has to be called from inside the subscribed callback, because that is the only place the request id is known.
+    /// Ensure the response is sent before the RPC timeout configured on the server side, because ThingsBoard discards later responses
+    /// @param request_id Set to the id of the request currently being handled, which has to be passed to RPC_Respond()
+    /// @return Whether a request is currently being handled, false if called outside of a subscribed callback
+    bool RPC_Defer(size_t & request_id) {
+        if (!m_handling_request) {
+            return false;
+        }
+        request_id = m_request_id;
+        m_response_deferred = true;
+        return true;
+    }
+
+    /// @brief Sends the response to a server-side RPC request, that has been deferred with RPC_Defer().
+    /// Can be called from anywhere the client is used from, for example the completion callback of the deferred operation
+    /// @param request_id Id of the request, as received from RPC_Defer()
+    /// @param response JsonDocument containing the response, that should be sent to the server
+    /// @return Whether sending the response was successful or not
+    bool RPC_Respond(size_t const & request_id, JsonDocument const & response) {
+        if (response.isNull()) {
+#if THINGSBOARD_ENABLE_DEBUG
+            Logger::println(RPC_RESPONSE_NULL);
+#endif // THINGSBOARD_ENABLE_DEBUG
+            return false;
+        }
+        else if (response.overflowed()) {
+            Logger::println(RPC_RESPONSE_OVERFLOWED);
+            return false;
+        }
+        char responseTopic[Helper::detectSize(RPC_SEND_RESPONSE_TOPIC, request_id)] = {};
+        (void)snprintf(responseTopic, sizeof(responseTopic), RPC_SEND_RESPONSE_TOPIC, request_id);
+        return m_send_json_callback.Call_Callback(responseTopic, response, Helper::Measure_Json(response));
+    }
+
     API_Process_Type Get_Process_Type() const override {
         return API_Process_Type::JSON;
     }
@@ -118,20 +158,9 @@ class Server_Side_RPC : public IAPI_Implementation {
         }
         char const * method_name = data[RPC_METHOD_KEY];
 
-#if THINGSBOARD_ENABLE_STL
-        auto it = std::find_if(m_rpc_callbacks.begin(), m_rpc_callbacks.end(), [&method_name](RPC_Callback const & rpc) {
-            char const * subscribedMethodName = rpc.Get_Name();
-            return (!Helper::stringIsNullorEmpty(subscribedMethodName) && strncmp(subscribedMethodName, method_name, strlen(subscribedMethodName)) == 0);
-        });
-        if (it != m_rpc_callbacks.end()) {
-            auto & rpc = *it;
-#else
-        for (auto const & rpc : m_rpc_callbacks) {
-            char const * subscribedMethodName = rpc.Get_Name();
-            if (Helper::stringIsNullorEmpty(subscribedMethodName) || strncmp(subscribedMethodName, method_name, strlen(subscribedMethodName)) != 0) {
-              continue;
-            }
-#endif // THINGSBOARD_ENABLE_STL
+        RPC_Callback const * const callback = Find_Callback(method_name);
+        if (callback != nullptr) {
+            auto & rpc = *callback;
 #if THINGSBOARD_ENABLE_DEBUG
             if (!data.containsKey(RPC_PARAMS_KEY)) {
                 Logger::println(NO_RPC_PARAMS_PASSED);
@@ -143,30 +172,20 @@ class Server_Side_RPC : public IAPI_Implementation {
 #endif // THINGSBOARD_ENABLE_DEBUG
 
             JsonVariantConst const param = data[RPC_PARAMS_KEY];
-#if THINGSBOARD_ENABLE_DYNAMIC
-            size_t const & rpc_response_size = rpc.Get_Response_Size();
-            TBJsonDocument json_buffer(rpc_response_size);
-#else
-            size_t constexpr rpc_response_size = MaxRPC;
-            StaticJsonDocument<JSON_OBJECT_SIZE(MaxRPC)> json_buffer;
-#endif // THINGSBOARD_ENABLE_DYNAMIC
+            TBJsonDocument json_buffer;
+            m_request_id = Helper::parseRequestId(RPC_REQUEST_TOPIC, topic);
+            m_handling_request = true;
+            m_response_deferred = false;
             rpc.Call_Callback(param, json_buffer);
+            m_handling_request = false;
 
-            if (json_buffer.isNull()) {
+            if (m_response_deferred) {
 #if THINGSBOARD_ENABLE_DEBUG
-                Logger::println(RPC_RESPONSE_NULL);
+                Logger::printfln(RPC_RESPONSE_DEFERRED, m_request_id);
 #endif // THINGSBOARD_ENABLE_DEBUG
                 return;
             }
-            else if (json_buffer.overflowed()) {
-                Logger::printfln(RPC_RESPONSE_OVERFLOWED, rpc_response_size);
-                return;
-            }
-
-            size_t const request_id = Helper::parseRequestId(RPC_REQUEST_TOPIC, topic);
-            char responseTopic[Helper::detectSize(RPC_SEND_RESPONSE_TOPIC, request_id)] = {};
-            (void)snprintf(responseTopic, sizeof(responseTopic), RPC_SEND_RESPONSE_TOPIC, request_id);
-            (void)m_send_json_callback.Call_Callback(responseTopic, json_buffer, Helper::Measure_Json(json_buffer));
+            (void)RPC_Respond(m_request_id, json_buffer);
             return;
         }
     }
@@ -175,6 +194,10 @@ class Server_Side_RPC : public IAPI_Implementation {
         return strncmp(RPC_REQUEST_TOPIC, topic, strlen(RPC_REQUEST_TOPIC)) == 0;
     }
 
+    char const * Get_Response_Topic_Prefix() const override {
+        return RPC_REQUEST_TOPIC;
+    }
+
     bool Unsubscribe() override {
         return RPC_Unsubscribe();
     }
@@ -204,6 +227,58 @@ class Server_Side_RPC : public IAPI_Implementation {
     }
 
   private:
+#if !THINGSBOARD_ENABLE_DYNAMIC
+    // Slots of the method name index, atleast twice the amount of callbacks so the linear probing stays short
+    static size_t constexpr METHOD_INDEX_SIZE = Helper::Next_Power_Of_Two(2U * MaxSubscriptions);
+#endif // !THINGSBOARD_ENABLE_DYNAMIC
+
+    /// @brief Rebuilds the open addressing hash index from the FNV-1a hash of the method names to the subscribed callbacks.
+    /// Called whenever the subscribed callbacks change, if multiple callbacks have the same method name only the first one subscribed is indexed
+    void Rebuild_Method_Index() {
+        m_method_index.clear();
+#if THINGSBOARD_ENABLE_DYNAMIC
+        size_t const index_size = Helper::Next_Power_Of_Two(2U * m_rpc_callbacks.size());
+#else
+        size_t constexpr index_size = METHOD_INDEX_SIZE;
+#endif // THINGSBOARD_ENABLE_DYNAMIC
+        for (size_t i = 0; i < index_size; ++i) {
+            m_method_index.push_back(0U);
+        }
+        for (size_t i = 0; i < m_rpc_callbacks.size(); ++i) {
+            char const * name = m_rpc_callbacks[i].Get_Name();
+            if (Helper::stringIsNullorEmpty(name) || Find_Callback(name) != nullptr) {
+                continue;
+            }
+            size_t slot = Helper::FNV_1a_Hash(name) & (index_size - 1U);
+            while (m_method_index[slot] != 0U) {
+                slot = (slot + 1U) & (index_size - 1U);
+            }
+            // Stored one based, so that 0 can mark an empty slot
+            m_method_index[slot] = i + 1U;
+        }
+    }
+
+    /// @brief Looks up the subscribed callback with exactly the given method name in the hash index
+    /// @param method_name Name of the received RPC method
+    /// @return Pointer to the subscribed callback or nullptr if there is none for the given method name
+    RPC_Callback const * Find_Callback(char const * method_name) const {
+        size_t const index_size = m_method_index.size();
+        if (method_name == nullptr || index_size == 0U) {
+            return nullptr;
+        }
+        size_t slot = Helper::FNV_1a_Hash(method_name) & (index_size - 1U);
+        for (; m_method_index[slot] != 0U; slot = (slot + 1U) & (index_size - 1U)) {
+            RPC_Callback const & rpc = m_rpc_callbacks[m_method_index[slot] - 1U];
+            if (strcmp(rpc.Get_Name(), method_name) == 0) {
+                return &rpc;
+            }
+        }
+        return nullptr;
+    }
+
+    size_t                                                                   m_request_id = {};                 // Id of the request whose callback is being called, or was called last
+    bool                                                                     m_handling_request = {};           // Whether a subscribed callback is currently being called
+    bool                                                                     m_response_deferred = {};          // Whether that callback called RPC_Defer()
     Callback<bool, char const * const, JsonDocument const &, size_t const &> m_send_json_callback = {};         // Send json document callback
     Callback<bool, char const * const>                                       m_subscribe_topic_callback = {};   // Subscribe mqtt topic client callback
     Callback<bool, char const * const>                                       m_unsubscribe_topic_callback = {}; // Unubscribe mqtt topic client callback
@@ -218,8 +293,10 @@ class Server_Side_RPC : public IAPI_Implementation {
     // especially because at most we copy internal vectors or array, that will only ever contain a few pointers
 #if THINGSBOARD_ENABLE_DYNAMIC
     Vector<RPC_Callback>                                                     m_rpc_callbacks = {};              // Server side RPC callbacks vector
+    Vector<size_t>                                                           m_method_index = {};               // Hash index of the method names, one based index into m_rpc_callbacks or 0 if the slot is empty
 #else
     Array<RPC_Callback, MaxSubscriptions>                                    m_rpc_callbacks = {};              // Server side RPC callbacks array
+    Array<size_t, METHOD_INDEX_SIZE>                                         m_method_index = {};               // Hash index of the method names, one based index into m_rpc_callbacks or 0 if the slot is empty
 #endif // THINGSBOARD_ENABLE_DYNAMIC
 };
 
@@ -54,6 +54,7 @@ class Shared_Attribute_Update : public IAPI_Implementation {
         (void)m_subscribe_topic_callback.Call_Callback(ATTRIBUTE_TOPIC);
         // Push back complete vector into our local m_shared_attribute_update_callbacks vector.
         m_shared_attribute_update_callbacks.insert(m_shared_attribute_update_callbacks.end(), first, last);
+        Rebuild_Attribute_Index();
         return true;
     }
 
@@ -80,6 +81,7 @@ class Shared_Attribute_Update : public IAPI_Implementation {
 #endif // !THINGSBOARD_ENABLE_DYNAMIC
         (void)m_subscribe_topic_callback.Call_Callback(ATTRIBUTE_TOPIC);
         m_shared_attribute_update_callbacks.push_back(callback);
+        Rebuild_Attribute_Index();
         return true;
     }
 
@@ -89,6 +91,8 @@ class Shared_Attribute_Update : public IAPI_Implementation {
     /// and from the attribute topic, was successful or not
     bool Shared_Attributes_Unsubscribe() {
         m_shared_attribute_update_callbacks.clear();
+        m_attribute_index.clear();
+        m_matched_callbacks.clear();
         return m_unsubscribe_topic_callback.Call_Callback(ATTRIBUTE_TOPIC);
     }
 
@@ -106,62 +110,28 @@ class Shared_Attribute_Update : public IAPI_Implementation {
             object = object[SHARED_RESPONSE_KEY];
         }
 
-#if THINGSBOARD_ENABLE_STL
-#if THINGSBOARD_ENABLE_CXX20
-#if THINGSBOARD_ENABLE_DYNAMIC
-        auto filtered_shared_attribute_update_callbacks = m_shared_attribute_update_callbacks | std::views::filter([&object](Shared_Attribute_Callback const & shared_attribute) {
-#else
-        auto filtered_shared_attribute_update_callbacks = m_shared_attribute_update_callbacks | std::views::filter([&object](Shared_Attribute_Callback<MaxAttributes> const & shared_attribute) {
-#endif // THINGSBOARD_ENABLE_DYNAMIC
-#else
-#if THINGSBOARD_ENABLE_DYNAMIC
-        Vector<Shared_Attribute_Callback> filtered_shared_attribute_update_callbacks = {};
-        std::copy_if(m_shared_attribute_update_callbacks.begin(), m_shared_attribute_update_callbacks.end(), std::back_inserter(filtered_shared_attribute_update_callbacks), [&object](Shared_Attribute_Callback const & shared_attribute) {
-#else
-        Array<Shared_Attribute_Callback<MaxAttributes>, MaxSubscriptions> filtered_shared_attribute_update_callbacks = {};
-        std::copy_if(m_shared_attribute_update_callbacks.begin(), m_shared_attribute_update_callbacks.end(), std::back_inserter(filtered_shared_attribute_update_callbacks), [&object](Shared_Attribute_Callback<MaxAttributes> const & shared_attribute) {
-#endif // THINGSBOARD_ENABLE_DYNAMIC
-#endif // THINGSBOARD_ENABLE_CXX20
-            return (shared_attribute.Get_Attributes().empty() || std::find_if(shared_attribute.Get_Attributes().begin(), shared_attribute.Get_Attributes().end(), [&object](const char * att) {
-                return object.containsKey(att);
-            }) != shared_attribute.Get_Attributes().end());
-        });
-
-        for (auto const & shared_attribute : filtered_shared_attribute_update_callbacks) {
-#else
-        for (auto const & shared_attribute : m_shared_attribute_update_callbacks) {
-            if (shared_attribute.Get_Attributes().empty()) {
-                // No specifc keys were subscribed so we call the callback anyway, assumed to be subscribed to any update
-                shared_attribute.Call_Callback(object);
-                continue;
-            }
-
-            char const * requested_att = nullptr;
-
-            for (auto const & att : shared_attribute.Get_Attributes()) {
-                if (Helper::stringIsNullorEmpty(att)) {
-                    continue;
-                }
-                // Check if the request contained any of our requested keys and
-                // break early if the key was requested from this callback.
-                if (object.containsKey(att)) {
-                    requested_att = att;
-                    break;
-                }
-            }
+        // Every received key is looked up in the index built at subscribe time, instead of every subscribed attribute being searched for in the object,
+        // which keeps updates with many keys linear in their size. The flags make sure each callback is called once, even if several of its keys were received
+        for (size_t i = 0U; i < m_matched_callbacks.size(); ++i) {
+            m_matched_callbacks[i] = m_shared_attribute_update_callbacks[i].Get_Attributes().empty();
+        }
+        for (JsonPairConst const pair : object) {
+            Match_Attribute(pair.key().c_str());
+        }
 
-            // Check if this callback did not request any keys that were in this response,
-            // if there were not we simply continue with the next subscribed callback.
-            if (requested_att == nullptr) {
-                continue;
+        for (size_t i = 0U; i < m_shared_attribute_update_callbacks.size(); ++i) {
+            if (m_matched_callbacks[i]) {
+                m_shared_attribute_update_callbacks[i].Call_Callback(object);
             }
-#endif // THINGSBOARD_ENABLE_STL
-            shared_attribute.Call_Callback(object);
         }
     }
 
     bool Compare_Response_Topic(char const * topic) const override {
-        return strncmp(ATTRIBUTE_TOPIC, topic, JSON_STRING_SIZE(strlen(ATTRIBUTE_TOPIC))) == 0;
+        return strncmp(ATTRIBUTE_TOPIC, topic, strlen(ATTRIBUTE_TOPIC) + 1U) == 0;
+    }
+
+    char const * Get_Response_Topic_Prefix() const override {
+        return ATTRIBUTE_TOPIC;
     }
 
     bool Unsubscribe() override {
@@ -192,6 +162,65 @@ class Shared_Attribute_Update : public IAPI_Implementation {
     }
 
   private:
+    /// @brief Entry of the attribute index, links the key of one subscribed attribute to the callback that requested it
+    struct Attribute_Key {
+        uint32_t     hash;     // FNV-1a hash of the key, the index is sorted by it
+        char const * key;      // Key of the attribute, compared once the hash matched to rule out collisions
+        size_t       callback; // Position of the callback that requested the key in m_shared_attribute_update_callbacks
+    };
+
+    /// @brief Rebuilds the index from the keys of all subscribed callbacks, sorted by their hash so a received key can be found with a binary search.
+    /// Called whenever callbacks are subscribed, which happens rarely compared to receiving updates
+    void Rebuild_Attribute_Index() {
+        m_attribute_index.clear();
+        m_matched_callbacks.clear();
+        for (size_t i = 0U; i < m_shared_attribute_update_callbacks.size(); ++i) {
+            m_matched_callbacks.push_back(false);
+            for (auto const & att : m_shared_attribute_update_callbacks[i].Get_Attributes()) {
+                if (Helper::stringIsNullorEmpty(att)) {
+                    continue;
+                }
+                Attribute_Key entry = {};
+                entry.hash = Helper::FNV_1a_Hash(att);
+                entry.key = att;
+                entry.callback = i;
+                // Insertion sort, keeps the entries ordered by ascending hash
+                m_attribute_index.push_back(entry);
+                for (size_t j = m_attribute_index.size() - 1U; j > 0U && m_attribute_index[j - 1U].hash > m_attribute_index[j].hash; --j) {
+                    Attribute_Key const previous = m_attribute_index[j - 1U];
+                    m_attribute_index[j - 1U] = m_attribute_index[j];
+                    m_attribute_index[j] = previous;
+                }
+            }
+        }
+    }
+
+    /// @brief Marks every callback that requested the given received key
+    /// @param key Key of one of the received attributes
+    void Match_Attribute(char const * key) {
+        if (key == nullptr) {
+            return;
+        }
+        uint32_t const hash = Helper::FNV_1a_Hash(key);
+        size_t first = 0U;
+        size_t last = m_attribute_index.size();
+        while (first < last) {
+            size_t const middle = first + (last - first) / 2U;
+            if (m_attribute_index[middle].hash < hash) {
+                first = middle + 1U;
+            }
+            else {
+                last = middle;
+            }
+        }
+        for (; first < m_attribute_index.size() && m_attribute_index[first].hash == hash; ++first) {
+            Attribute_Key const & entry = m_attribute_index[first];
+            if (strcmp(entry.key, key) == 0) {
+                m_matched_callbacks[entry.callback] = true;
+            }
+        }
+    }
+
     Callback<bool, char const * const>                                       m_subscribe_topic_callback = {};          // Subscribe mqtt topic client callback
     Callback<bool, char const * const>                                       m_unsubscribe_topic_callback = {};        // Unubscribe mqtt topic client callback
 
@@ -208,6 +237,13 @@ class Shared_Attribute_Update : public IAPI_Implementation {
 #else
     Array<Shared_Attribute_Callback<MaxAttributes>, MaxSubscriptions>        m_shared_attribute_update_callbacks = {}; // Shared attribute update callbacks array
 #endif // THINGSBOARD_ENABLE_DYNAMIC
+#if THINGSBOARD_ENABLE_DYNAMIC
+    Vector<Attribute_Key>                                                    m_attribute_index = {};                   // Keys of the subscribed attributes sorted by their hash, to look up the callbacks of a received key
+    Vector<bool>                                                             m_matched_callbacks = {};                 // Whether the callback at the same position requested a key of the update that is dispatched
+#else
+    Array<Attribute_Key, MaxSubscriptions * MaxAttributes>                   m_attribute_index = {};                   // Keys of the subscribed attributes sorted by their hash, to look up the callbacks of a received key
+    Array<bool, MaxSubscriptions>                                            m_matched_callbacks = {};                 // Whether the callback at the same position requested a key of the update that is dispatched
+#endif // THINGSBOARD_ENABLE_DYNAMIC
 };
 
 #endif // Shared_Attribute_Update_h
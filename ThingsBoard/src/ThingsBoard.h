@@ -7,6 +7,8 @@
 #include "IMQTT_Client.h"
 #include "DefaultLogger.h"
 #include "Telemetry.h"
+#include "Arena_Allocator.h"
+#include "Chunked_Print.h"
 
 // Library includes.
 #if THINGSBOARD_ENABLE_STREAM_UTILS
@@ -18,12 +20,11 @@ uint16_t constexpr DEFAULT_MQTT_PORT = 1883U;
 char constexpr PROV_ACCESS_TOKEN[] = "provision";
 // Log messages.
 char constexpr UNABLE_TO_DE_SERIALIZE_JSON[] = "Unable to de-serialize received json data with error (DeserializationError::%s)";
-char constexpr INVALID_BUFFER_SIZE[] = "Buffer size (%u) to small for the given payloads size (%u), increase with setBufferSize accordingly or set THINGSBOARD_ENABLE_STREAM_UTILS to 1 before including ThingsBoard";
+char constexpr INVALID_BUFFER_SIZE[] = "Buffer size (%u) to small for the given payloads size (%u), increase with setBufferSize accordingly or set THINGSBOARD_ENABLE_STREAM_PUBLISH to 1 before including ThingsBoard";
 char constexpr UNABLE_TO_ALLOCATE_BUFFER[] = "Allocating memory for the internal MQTT buffer failed";
 char constexpr MAX_ENDPOINTS_AMOUNT_TEMPLATE_NAME[] = "MaxEndpointsAmount";
 #if THINGSBOARD_ENABLE_DYNAMIC
-char constexpr MAXIMUM_RESPONSE_EXCEEDED[] = "Prevented allocation on the heap (%u) for JsonDocument. Discarding message that is bigger than maximum response size (%u)";
-char constexpr HEAP_ALLOCATION_FAILED[] = "Failed allocating required size (%u) for JsonDocument. Ensure there is enough heap memory left";
+char constexpr MAXIMUM_RESPONSE_EXCEEDED[] = "Prevented allocation on the heap for JsonDocument. Discarding message (%u) that is bigger than maximum response size (%u)";
 #endif // THINGSBOARD_ENABLE_DYNAMIC
 #if THINGSBOARD_ENABLE_DEBUG
 char constexpr RECEIVE_MESSAGE[] = "Received (%u) bytes of data from server over topic (%s)";
@@ -73,33 +74,33 @@ class ThingsBoardSized {
     /// @param client MQTT Client implementation that should be used to establish the connection to ThingsBoard
     /// @param buffer_size Maximum amount of data that can be either received or sent to ThingsBoard at once, if bigger packets are received they are discarded
     /// and if we attempt to send data that is bigger, it will not be sent, the internal value can be changed later at any time with the setBufferSize() method
-    /// alternatively setting THINGSBOARD_ENABLE_STREAM_UTILS to 1 allows to send arbitrary size payloads if that is done the internal buffer of the MQTT Client implementation
+    /// alternatively THINGSBOARD_ENABLE_STREAM_PUBLISH, which is enabled by default, allows to send arbitrary size payloads if that is done the internal buffer of the MQTT Client implementation
     /// can be theoretically set to only be as big as the biggest message we should every receive from ThingsBoard,
-    /// this will mean though that all messages are sent over the StreamUtils library as long as they are bigger than the internal buffer,
+    /// this will mean though that all messages are streamed into the client in chunks as long as they are bigger than the internal buffer,
     /// which needs more time than sending a message directly but has the advantage of requiring less memory.
-    /// So if that is a problem on the board it might be useful to enable the THINGSBOARD_ENABLE_STREAM_UTILS option
+    /// So if that is a problem on the board it might be useful to keep the THINGSBOARD_ENABLE_STREAM_PUBLISH option enabled
     /// and decrease the internal buffer size of the mqtt client to what is needed to receive all MQTT messages,
     /// that size can vary but if all ThingsBoard features are used a buffer size of 256 bytes should suffice for receiving most responses.
     /// If the aforementioned feature is not enabled the buffer size might need to be much bigger though,
     /// but in that case if a message was too big to be sent the user will be informed with a message to the Logger.
-    /// The aforementioned options can only be enabled if Arduino is used to build this library, because the StreamUtils library requires it, default = Default_Payload_Size (64)
+    /// The aforementioned option requires a client that implements begin_publish(), write() and end_publish(), which Espressif_MQTT_Client does not, default = Default_Payload_Size (64)
     /// @param max_stack_size Maximum amount of bytes we want to allocate on the stack, default = Default_Max_Stack_Size (1024)
     /// @param ...args Arguments that will be forwarded into the overloaded Array or Vector (THINGSBOARD_ENABLE_DYNAMIC) constructor
     template<typename... Args>
 #if THINGSBOARD_ENABLE_DYNAMIC
 #if THINGSBOARD_ENABLE_STREAM_UTILS
     /// @param buffering_size Amount of bytes allocated to speed up serialization, default = Default_Buffering_Size (64)
-    /// @param max_response_size Maximum amount of bytes allocated for the interal JsonDocument structure that holds the received payload.
-    /// Size is calculated automatically from certain characters in the received payload (',', '{', '[') but if we receive a malicious payload that contains these symbols in a string {"example":",,,,,,..."}.
-    /// It is possible to cause huge allocations, nut because the memory only lives for as long as the subscribed callback methods it should not be a problem,
+    /// @param max_response_size Maximum amount of bytes of a received payload that is deserialized into the interal JsonDocument structure.
+    /// The JsonDocument grows while deserializing and copies every key and string, therefore the allocated memory grows with the length of the received payload.
+    /// It is possible to cause huge allocations with a huge payload, nut because the memory only lives for as long as the subscribed callback methods it should not be a problem,
     /// especially because attempting to allocate too much memory, will cause the allocation to fail, which is checked. But if the failure of that heap allocation is subscribed for example with the heap_caps_register_failed_alloc_callback method on the ESP32,
     /// then that subscribed callback will be called and could theoretically restart the device. To circumvent that we can simply set the size of this variable to a value that should never be exceeded by a non malicious json payload, received by attribute requests, shared attribute updates, server-side or client-side rpc.
     /// If this safety feature is not required, because the heap allocation failure callback is not subscribed, then the value of the variable can simply be kept as 0, which means we will not check the received payload for its size before the allocation happens, default = Default_Max_Response_Size (0)
     ThingsBoardSized(IMQTT_Client & client, uint16_t buffer_size = Default_Payload_Size, size_t const & max_stack_size = Default_Max_Stack_Size, size_t const & buffering_size = Default_Buffering_Size, size_t const & max_response_size = Default_Max_Response_Size, Args const &... args)
 #else
-    /// @param max_response_size Maximum amount of bytes allocated for the interal JsonDocument structure that holds the received payload.
-    /// Size is calculated automatically from certain characters in the received payload (',', '{', '[') but if we receive a malicious payload that contains these symbols in a string {"example":",,,,,,..."}.
-    /// It is possible to cause huge allocations, nut because the memory only lives for as long as the subscribed callback methods it should not be a problem,
+    /// @param max_response_size Maximum amount of bytes of a received payload that is deserialized into the interal JsonDocument structure.
+    /// The JsonDocument grows while deserializing and copies every key and string, therefore the allocated memory grows with the length of the received payload.
+    /// It is possible to cause huge allocations with a huge payload, nut because the memory only lives for as long as the subscribed callback methods it should not be a problem,
     /// especially because attempting to allocate too much memory, will cause the allocation to fail, which is checked. But if the failure of that heap allocation is subscribed for example with the heap_caps_register_failed_alloc_callback method on the ESP32,
     /// then that subscribed callback will be called and could theoretically restart the device. To circumvent that we can simply set the size of this variable to a value that should never be exceeded by a non malicious json payload, received by attribute requests, shared attribute updates, server-side or client-side rpc.
     /// If this safety feature is not required, because the heap allocation failure callback is not subscribed, then the value of the variable can simply be kept as 0, which means we will not check the received payload for its size before the allocation happens, default = Default_Max_Response_Size (0)
@@ -134,6 +135,7 @@ class ThingsBoardSized {
 #endif // THINGSBOARD_ENABLE_STL
             api->Initialize();
         }
+        Rebuild_Topic_Routes();
         (void)setBufferSize(buffer_size);
         // Initialize callback.
 #if THINGSBOARD_ENABLE_STL
@@ -172,9 +174,9 @@ class ThingsBoardSized {
 
 #if THINGSBOARD_ENABLE_DYNAMIC
     /// @brief Sets the maximum amount of bytes allocated for internal JsonDocument holding received payload from server responses by attribute requests, shared attribute updates, server-side or client-side rpc
-    /// @param max_response_size Maximum amount of bytes allocated for the interal JsonDocument structure that holds the received payload.
-    /// Size is calculated automatically from certain characters in the received payload (',', '{', '[') but if we receive a malicious payload that contains these symbols in a string {"example":",,,,,,..."}.
-    /// It is possible to cause huge allocations, nut because the memory only lives for as long as the subscribed callback methods it should not be a problem,
+    /// @param max_response_size Maximum amount of bytes of a received payload that is deserialized into the interal JsonDocument structure.
+    /// The JsonDocument grows while deserializing and copies every key and string, therefore the allocated memory grows with the length of the received payload.
+    /// It is possible to cause huge allocations with a huge payload, nut because the memory only lives for as long as the subscribed callback methods it should not be a problem,
     /// especially because attempting to allocate too much memory, will cause the allocation to fail, which is checked. But if the failure of that heap allocation is subscribed for example with the heap_caps_register_failed_alloc_callback method on the ESP32,
     /// then that subscribed callback will be called and could theoretically restart the device. To circumvent that we can simply set the size of this variable to a value that should never be exceeded by a non malicious json payload, received by attribute requests, shared attribute updates, server-side or client-side rpc.
     /// If this safety feature is not required, because the heap allocation failure callback is not subscribed, then the value of the variable can simply be kept as 0, which means we will not check the received payload for its size before the allocation happens, default = Default_Max_Response_Size (0)
@@ -186,16 +188,16 @@ class ThingsBoardSized {
     /// @brief Sets the size of the buffer for the underlying network client that will be used to establish the connection to ThingsBoard
     /// @param buffer_size Maximum amount of data that can be either received or sent to ThingsBoard at once, if bigger packets are received they are discarded
     /// and if we attempt to send data that is bigger, it will not be sent, the internal value can be changed later at any time with the setBufferSize() method
-    /// alternatively setting THINGSBOARD_ENABLE_STREAM_UTILS to 1 allows to send arbitrary size payloads if that is done the internal buffer of the MQTT Client implementation
+    /// alternatively THINGSBOARD_ENABLE_STREAM_PUBLISH, which is enabled by default, allows to send arbitrary size payloads if that is done the internal buffer of the MQTT Client implementation
     /// can be theoretically set to only be as big as the biggest message we should every receive from ThingsBoard,
-    /// this will mean though that all messages are sent over the StreamUtils library as long as they are bigger than the internal buffer,
+    /// this will mean though that all messages are streamed into the client in chunks as long as they are bigger than the internal buffer,
     /// which needs more time than sending a message directly but has the advantage of requiring less memory.
-    /// So if that is a problem on the board it might be useful to enable the THINGSBOARD_ENABLE_STREAM_UTILS option
+    /// So if that is a problem on the board it might be useful to keep the THINGSBOARD_ENABLE_STREAM_PUBLISH option enabled
     /// and decrease the internal buffer size of the mqtt client to what is needed to receive all MQTT messages,
     /// that size can vary but if all ThingsBoard features are used a buffer size of 256 bytes should suffice for receiving most responses.
     /// If the aforementioned feature is not enabled the buffer size might need to be much bigger though,
     /// but in that case if a message was too big to be sent the user will be informed with a message to the logger implementation.
-    /// The aforementioned options can only be enabled if Arduino is used to build this library, because the StreamUtils library requires it
+    /// The aforementioned option requires a client that implements begin_publish(), write() and end_publish(), which Espressif_MQTT_Client does not
     /// @return Whether allocating the needed memory for the given buffer size was successful or not
     bool setBufferSize(uint16_t buffer_size) {
         bool const result = m_client.set_buffer_size(buffer_size);
@@ -256,39 +258,40 @@ class ThingsBoardSized {
     /// Additionally when not being able to use the ESP Timer, it updates the internal timeout timers
     /// @return Whether sending or receiving the oustanding the messages was successful or not
     bool loop() {
-#if !THINGSBOARD_USE_ESP_TIMER
         for (auto & api : m_api_implementations) {
             if (api == nullptr) {
                 continue;
             }
+            api->Flush();
+#if !THINGSBOARD_USE_ESP_TIMER
             api->loop();
-        }
 #endif // !THINGSBOARD_USE_ESP_TIMER
+        }
         return m_client.loop();
     }
 
     /// @brief Attempts to send key value pairs from custom source over the given topic to the server
     /// @param topic Topic we want to send the data over
     /// @param source JsonDocument containing our json key value pairs we want to send,
-    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v6/api/jsondocument/ for more information
+    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v7/api/jsondocument/ for more information
     /// @param json_size Size of the data inside the source
     /// @return Whether sending the data was successful or not
     bool Send_Json(char const * topic, JsonDocument const & source, size_t const & json_size) {
         // Check if allocating needed memory failed when trying to create the JsonDocument,
-        // if it did the isNull() method will return true. See https://arduinojson.org/v6/api/jsonvariant/isnull/ for more information
+        // if it did the isNull() method will return true. See https://arduinojson.org/v7/api/jsonvariant/isnull/ for more information
         if (source.isNull()) {
             Logger::println(UNABLE_TO_ALLOCATE_JSON);
             return false;
         }
-        // Check if inserting any of the internal values failed because the JsonDocument was too small,
-        // if it did the overflowed() method will return true. See https://arduinojson.org/v6/api/jsondocument/overflowed/ for more information
+        // Check if inserting any of the internal values failed because allocating the memory for them failed,
+        // if it did the overflowed() method will return true. See https://arduinojson.org/v7/api/jsondocument/overflowed/ for more information
         if (source.overflowed()) {
             Logger::println(JSON_SIZE_TO_SMALL);
             return false;
         }
         bool result = false;
 
-#if THINGSBOARD_ENABLE_STREAM_UTILS
+#if THINGSBOARD_ENABLE_STREAM_PUBLISH
         // Check if the size of the given message would be too big for the actual client,
         // if it is utilize the serialize json work around, so that the internal client buffer can be circumvented
         if (m_client.get_buffer_size() < json_size)  {
@@ -300,7 +303,19 @@ class ThingsBoardSized {
         // Check if the remaining stack size of the current task would overflow the stack,
         // if it would allocate the memory on the heap instead to ensure no stack overflow occurs
         else
-#endif // THINGSBOARD_ENABLE_STREAM_UTILS
+#endif // THINGSBOARD_ENABLE_STREAM_PUBLISH
+#if THINGSBOARD_SEND_BUFFER_SIZE
+        // Payloads too big for the stack are serialized into the buffer that is kept for them, it is free again once the payload was handed to the client
+        if (json_size > getMaximumStackSize() && json_size <= THINGSBOARD_SEND_BUFFER_SIZE) {
+            if (serializeJson(source, m_send_buffer, json_size) < json_size - 1) {
+                Logger::println(UNABLE_TO_SERIALIZE_JSON);
+            }
+            else {
+                result = Send_Json_String(topic, m_send_buffer);
+            }
+        }
+        else
+#endif // THINGSBOARD_SEND_BUFFER_SIZE
         if (json_size > getMaximumStackSize()) {
             char* json = new char[json_size]();
             if (serializeJson(source, json, json_size) < json_size - 1) {
@@ -366,6 +381,7 @@ class ThingsBoardSized {
 #endif // THINGSBOARD_ENABLE_STL
         api.Initialize();
         m_api_implementations.push_back(&api);
+        Rebuild_Topic_Routes();
     }
 
     /// @brief Copies the non-owning pointers to the given API implementations, into the local data container.
@@ -398,6 +414,7 @@ class ThingsBoardSized {
             api->Initialize();
         }
         m_api_implementations.insert(m_api_implementations.end(), first, last);
+        Rebuild_Topic_Routes();
     }
 
     //----------------------------------------------------------------------------
@@ -412,7 +429,7 @@ class ThingsBoardSized {
     /// @param duration_ms Total time in milliseconds the user has to claim their device as their own
     /// @return Whether sending the claiming request was successful or not
     bool Claim_Request(char const * secret_key, size_t const & duration_ms) {
-        StaticJsonDocument<JSON_OBJECT_SIZE(2)> request_buffer;
+        TBJsonDocument request_buffer;
 
         if (!Helper::stringIsNullorEmpty(secret_key)) {
             request_buffer[SECRET_KEY] = secret_key;
@@ -469,13 +486,25 @@ class ThingsBoardSized {
     /// @brief Attempts to send telemetry key value pairs from custom source to the server.
     /// See https://thingsboard.io/docs/user-guide/telemetry/ for more information
     /// @param source JsonDocument containing our json key value pairs we want to send,
-    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v6/api/jsondocument/ for more information
+    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v7/api/jsondocument/ for more information
     /// @param json_size Size of the data inside the source
     /// @return Whether sending the data was successful or not
     bool sendTelemetryJson(JsonDocument const & source, size_t const & json_size) {
         return Send_Json(TELEMETRY_TOPIC, source, json_size);
     }
 
+#if THINGSBOARD_ENABLE_STREAM_PUBLISH
+    /// @brief Attempts to send telemetry that can print itself as json, for example a struct with its own writer.
+    /// The source is printed straight into the client, so neither a JsonDocument nor a serialized copy is ever created.
+    /// See https://thingsboard.io/docs/user-guide/telemetry/ for more information
+    /// @param source Printable that writes the complete json object when printTo() is called
+    /// @param json_size Exact amount of bytes printTo() will write, needed up front by begin_publish()
+    /// @return Whether sending the data was successful or not
+    bool sendTelemetryPrintable(Printable const & source, size_t const & json_size) {
+        return Serialize_Printable(TELEMETRY_TOPIC, source, json_size);
+    }
+#endif // THINGSBOARD_ENABLE_STREAM_PUBLISH
+
     //----------------------------------------------------------------------------
     // Attribute API
 
@@ -524,7 +553,7 @@ class ThingsBoardSized {
     /// @brief Attempts to send attribute key value pairs from custom source to the server.
     /// See https://thingsboard.io/docs/user-guide/attributes/ for more information
     /// @param source JsonDocument containing our json key value pairs we want to send,
-    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v6/api/jsondocument/ for more information
+    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v7/api/jsondocument/ for more information
     /// @param json_size Size of the data inside the source
     /// @return Whether sending the data was successful or not
     bool sendAttributeJson(JsonDocument const & source, size_t const & json_size) {
@@ -532,12 +561,23 @@ class ThingsBoardSized {
     }
 
   private:
-#if THINGSBOARD_ENABLE_STREAM_UTILS
+    /// @brief Entry of the routing table received messages are dispatched with,
+    /// holds all subscribed api implementations that share the same response topic prefix
+    struct Topic_Route {
+        char const * prefix;  // Response topic prefix shared by the api implementations of this route, nullptr if they handle any topic
+        size_t       length;  // Length of the prefix, 0 if they handle any topic
+        uint32_t     hash;    // FNV-1a hash of the prefix, compared before the prefix itself
+        size_t       first;   // Index of the first api implementation of this route in m_routed_implementations
+        size_t       count;   // Amount of api implementations of this route
+        bool         matched; // Whether the topic of the message currently being dispatched starts with the prefix
+    };
+
+#if THINGSBOARD_ENABLE_STREAM_PUBLISH
     /// @brief Serialize the custom attribute source into the underlying client.
-    /// Sends the given bytes to the client without requiring any temporary buffer at the cost of hugely increased send times
+    /// Sends the given bytes to the client in chunks without requiring a buffer for the complete message, at the cost of increased send times
     /// @param topic Topic we want to send the data over
     /// @param source JsonDocument containing our json key value pairs we want to send,
-    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v6/api/jsondocument/ for more information
+    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v7/api/jsondocument/ for more information
     /// @param json_size Size of the data inside the source
     /// @return Whether sending the data was successful or not
     bool Serialize_Json(char const * topic, JsonDocument const & source, size_t const & json_size) {
@@ -545,16 +585,57 @@ class ThingsBoardSized {
             Logger::println(UNABLE_TO_SERIALIZE_JSON);
             return false;
         }
+#if THINGSBOARD_ENABLE_STREAM_UTILS
         BufferingPrint buffered_print(m_client, getBufferingSize());
+#else
+        Chunked_Print<> buffered_print(m_client);
+#endif // THINGSBOARD_ENABLE_STREAM_UTILS
         size_t const bytes_serialized = serializeJson(source, buffered_print);
-        if (bytes_serialized < json_size) {
+        return Finish_Publish(buffered_print, bytes_serialized, json_size);
+    }
+
+    /// @brief Print the custom source into the underlying client.
+    /// Same as Serialize_Json, but the source writes its own json instead of it being serialized from a JsonDocument
+    /// @param topic Topic we want to send the data over
+    /// @param source Printable that writes the complete json object when printTo() is called
+    /// @param json_size Exact amount of bytes printTo() will write
+    /// @return Whether sending the data was successful or not
+    bool Serialize_Printable(char const * topic, Printable const & source, size_t const & json_size) {
+        if (!m_client.begin_publish(topic, json_size)) {
+            Logger::println(UNABLE_TO_SERIALIZE_JSON);
+            return false;
+        }
+#if THINGSBOARD_ENABLE_STREAM_UTILS
+        BufferingPrint buffered_print(m_client, getBufferingSize());
+#else
+        Chunked_Print<> buffered_print(m_client);
+#endif // THINGSBOARD_ENABLE_STREAM_UTILS
+        size_t const bytes_printed = source.printTo(buffered_print);
+        return Finish_Publish(buffered_print, bytes_printed, json_size);
+    }
+
+    /// @brief Sends the bytes remaining in the given print and finishes the message started with begin_publish()
+    /// @tparam TPrint Print the payload was written into, either the BufferingPrint of StreamUtils or the internal Chunked_Print
+    /// @param buffered_print Print the payload was written into
+    /// @param bytes_written Amount of bytes the serialization wrote into the print
+    /// @param json_size Amount of bytes announced with begin_publish()
+    /// @return Whether sending the complete message was successful or not
+    template <typename TPrint>
+    bool Finish_Publish(TPrint & buffered_print, size_t const & bytes_written, size_t const & json_size) {
+        if (bytes_written < json_size) {
             Logger::println(UNABLE_TO_SERIALIZE_JSON);
             return false;
         }
         buffered_print.flush();
+#if !THINGSBOARD_ENABLE_STREAM_UTILS
+        if (buffered_print.Failed()) {
+            Logger::println(UNABLE_TO_SERIALIZE_JSON);
+            return false;
+        }
+#endif // !THINGSBOARD_ENABLE_STREAM_UTILS
         return m_client.end_publish();
     }
-#endif // THINGSBOARD_ENABLE_STREAM_UTILS
+#endif // THINGSBOARD_ENABLE_STREAM_PUBLISH
 
     /// @brief Returns the maximum amount of bytes that we want to allocate on the stack, before the memory is allocated on the heap instead
     /// @return Maximum amount of bytes we want to allocate on the stack
@@ -641,7 +722,7 @@ class ThingsBoardSized {
             return false;
         }
 
-        StaticJsonDocument<JSON_OBJECT_SIZE(1)> json_buffer;
+        TBJsonDocument json_buffer;
         if (!t.SerializeKeyValue(json_buffer)) {
             Logger::println(UNABLE_TO_SERIALIZE);
             return false;
@@ -665,19 +746,14 @@ class ThingsBoardSized {
     template<size_t MaxKeyValuePairAmount, typename InputIterator>
 #endif // THINGSBOARD_ENABLE_DYNAMIC
     bool sendDataArray(InputIterator const & first, InputIterator const & last, bool telemetry) {
+#if !THINGSBOARD_ENABLE_DYNAMIC
         size_t const size = Helper::distance(first, last);
-#if THINGSBOARD_ENABLE_DYNAMIC
-        // char const * are stored as only a pointer inside the JsonDocument --> zero copy, meaning the size for the strings is 0 bytes.
-        // Data structure size, therefore only depends on the amount of key value pairs passed.
-        // See https://arduinojson.org/v6/assistant/ for more information on the needed size for the JsonDocument
-        TBJsonDocument json_buffer(JSON_OBJECT_SIZE(size));
-#else
         if (size > MaxKeyValuePairAmount) {
             Logger::printfln(TOO_MANY_JSON_FIELDS, size, "MaxKeyValuePairAmount", MaxKeyValuePairAmount);
             return false;
         }
-        StaticJsonDocument<JSON_OBJECT_SIZE(MaxKeyValuePairAmount)> json_buffer;
-#endif // THINGSBOARD_ENABLE_DYNAMIC
+#endif // !THINGSBOARD_ENABLE_DYNAMIC
+        TBJsonDocument json_buffer;
 
 #if THINGSBOARD_ENABLE_STL
         if (std::any_of(first, last, [&json_buffer](Telemetry const & data) { return !data.SerializeKeyValue(json_buffer); })) {
@@ -696,6 +772,98 @@ class ThingsBoardSized {
         return telemetry ? sendTelemetryJson(json_buffer, Helper::Measure_Json(json_buffer)) : sendAttributeJson(json_buffer, Helper::Measure_Json(json_buffer));
     }
 
+    /// @brief Groups the subscribed api implementations by their response topic prefix into the routing table.
+    /// Routes are sorted by ascending prefix length, so a received topic can be matched against all of them in a single pass over its characters.
+    /// Called whenever api implementations are subscribed, which happens rarely compared to receiving messages
+    void Rebuild_Topic_Routes() {
+        m_topic_routes.clear();
+        m_routed_implementations.clear();
+        for (auto const & api : m_api_implementations) {
+            if (api == nullptr) {
+                continue;
+            }
+            char const * prefix = api->Get_Response_Topic_Prefix();
+            size_t const length = prefix != nullptr ? strlen(prefix) : 0U;
+            bool found = false;
+            for (auto const & route : m_topic_routes) {
+                if (route.length == length && (length == 0U || strncmp(route.prefix, prefix, length) == 0)) {
+                    found = true;
+                    break;
+                }
+            }
+            if (found) {
+                continue;
+            }
+            Topic_Route route = {};
+            route.prefix = prefix;
+            route.length = length;
+            route.hash = length != 0U ? Helper::FNV_1a_Hash(prefix) : FNV_OFFSET_BASIS;
+            // Insertion sort, keeps the routes ordered by ascending prefix length
+            m_topic_routes.push_back(route);
+            for (size_t i = m_topic_routes.size() - 1U; i > 0U && m_topic_routes[i - 1U].length > m_topic_routes[i].length; --i) {
+                Topic_Route const previous = m_topic_routes[i - 1U];
+                m_topic_routes[i - 1U] = m_topic_routes[i];
+                m_topic_routes[i] = previous;
+            }
+        }
+        for (auto & route : m_topic_routes) {
+            route.first = m_routed_implementations.size();
+            for (auto const & api : m_api_implementations) {
+                if (api == nullptr) {
+                    continue;
+                }
+                char const * prefix = api->Get_Response_Topic_Prefix();
+                size_t const length = prefix != nullptr ? strlen(prefix) : 0U;
+                if (route.length == length && (length == 0U || strncmp(route.prefix, prefix, length) == 0)) {
+                    m_routed_implementations.push_back(api);
+                }
+            }
+            route.count = m_routed_implementations.size() - route.first;
+        }
+    }
+
+    /// @brief Marks every route whose prefix the given topic starts with, hashing the topic once and comparing only the routes whose hash matches.
+    /// Routes of api implementations without a prefix always match, because they have to be asked for every message
+    /// @param topic Topic we received the message over
+    void Match_Topic_Routes(char const * topic) {
+        size_t next = 0U;
+        for (auto & route : m_topic_routes) {
+            route.matched = route.length == 0U;
+            next += route.matched ? 1U : 0U;
+        }
+        uint32_t hash = FNV_OFFSET_BASIS;
+        for (size_t i = 0U; topic[i] != '\0' && next < m_topic_routes.size(); ++i) {
+            hash = Helper::FNV_1a_Hash(hash, topic[i]);
+            for (; next < m_topic_routes.size() && m_topic_routes[next].length == i + 1U; ++next) {
+                Topic_Route & route = m_topic_routes[next];
+                route.matched = route.hash == hash && strncmp(route.prefix, topic, route.length) == 0;
+            }
+        }
+    }
+
+    /// @brief Passes the received payload to the raw api implementations of the matched routes, that handle the given topic
+    /// @param topic Topic we received the message over
+    /// @param payload Payload that was sent over the cloud and received over the given topic
+    /// @param length Total length of the received payload
+    /// @return Whether the payload was processed as raw bytes by atleast one api implementation
+    bool Dispatch_Raw_Response(char * topic, uint8_t * payload, unsigned int length) {
+        bool processed_response_as_raw = false;
+        for (auto const & route : m_topic_routes) {
+            if (!route.matched) {
+                continue;
+            }
+            for (size_t i = route.first; i < route.first + route.count; ++i) {
+                IAPI_Implementation * api = m_routed_implementations[i];
+                if (api->Get_Process_Type() != API_Process_Type::RAW || !api->Compare_Response_Topic(topic)) {
+                    continue;
+                }
+                api->Process_Response(topic, payload, length);
+                processed_response_as_raw = true;
+            }
+        }
+        return processed_response_as_raw;
+    }
+
     /// @brief MQTT callback that will be called if a publish message is received from the server
     /// Payload contains data from the internal buffer of the MQTT client,
     /// therefore the buffer and the specific memory region the payload points too and the following length bytes need to live on for as long as this method has not finished.
@@ -711,110 +879,64 @@ class ThingsBoardSized {
         Logger::printfln(RECEIVE_MESSAGE, length, topic);
 #endif // THINGSBOARD_ENABLE_DEBUG
 
-#if THINGSBOARD_ENABLE_STL
-#if THINGSBOARD_ENABLE_CXX20
-        auto filtered_raw_api_implementations = m_api_implementations | std::views::filter([&topic](IAPI_Implementation const * api) {
-#else
-#if THINGSBOARD_ENABLE_DYNAMIC
-        Vector<IAPI_Implementation *> filtered_raw_api_implementations = {};
-#else
-        Array<IAPI_Implementation *, MaxEndpointsAmount> filtered_raw_api_implementations = {};
-#endif // THINGSBOARD_ENABLE_DYNAMIC
-        std::copy_if(m_api_implementations.begin(), m_api_implementations.end(), std::back_inserter(filtered_raw_api_implementations), [&topic](IAPI_Implementation const * api) {
-#endif // THINGSBOARD_ENABLE_CXX20
-            return (api != nullptr && api->Get_Process_Type() == API_Process_Type::RAW && api->Compare_Response_Topic(topic));
-        });
-
-        for (auto & api : filtered_raw_api_implementations) {
-            api->Process_Response(topic, payload, length);
-        }
-
-        // If the filtered api implementations was not emtpy it means the response was processed as its raw bytes representation atleast once,
-        // and because we interpreted it as raw bytes instead of json, we skip the further processing of those raw bytes as json.
+        Match_Topic_Routes(topic);
+        // If the response was processed as its raw bytes representation atleast once, we skip the further processing of those raw bytes as json.
         // We do that because the received response is in that case not even valid json in the first place and would therefore simply fail deserialization
-        if (!filtered_raw_api_implementations.empty()) {
+        if (Dispatch_Raw_Response(topic, payload, length)) {
             return;
         }
-#else
-        bool processed_response_as_raw = false;
-        for (auto & api : m_api_implementations) {
-            if (api == nullptr || api->Get_Process_Type() != API_Process_Type::RAW || !api->Compare_Response_Topic(topic)) {
-                continue;
-            }
-            api->Process_Response(topic, payload, length);
-            processed_response_as_raw = true;
-        }
 
-        if (processed_response_as_raw) {
+#if THINGSBOARD_ENABLE_JSON_ARENA
+        // Reuses the document and with it the memory of the arena it allocates from, therefore neither a size estimation nor a heap allocation is required.
+        // The previous response is freed by the deserialization itself, responses that do not fit into the arena fail with DeserializationError::NoMemory
+        JsonDocument & json_buffer = m_receive_document;
+#if THINGSBOARD_ENABLE_DEBUG
+        Logger::printfln(ALLOCATING_JSON, m_receive_arena.Get_Capacity());
+#endif // THINGSBOARD_ENABLE_DEBUG
+#else
+#if THINGSBOARD_ENABLE_DYNAMIC
+        // ArduinoJson 7 copies every key and string out of the payload into the JsonDocument, therefore the allocated memory grows with the length of the payload,
+        // which makes that length the size that is compared against the maximum, instead of an estimation from the symbols contained in the payload
+        if (m_max_response_size != 0U && length > m_max_response_size) {
+            Logger::printfln(MAXIMUM_RESPONSE_EXCEEDED, length, m_max_response_size);
             return;
         }
-#endif // THINGSBOARD_ENABLE_STL
-
+#else
         // Calculate size with the total amount of commas, always denotes the end of a key-value pair besides for the last element in an array or in an object where the comma is not permitted,
         // therfore we have to add the space for another key-value pair for all the occurences of thoose symbols as well
         size_t const size = Helper::getOccurences(payload, ',', length) + Helper::getOccurences(payload, '{', length) + Helper::getOccurences(payload, '[', length);
-#if THINGSBOARD_ENABLE_DYNAMIC
-        // Buffer that we deserialize is writeable and not read only and therefore stored as a pointer inside the JsonDocument --> zero copy, meaning the size for the received payload is 0 bytes.
-        // Data structure size, therefore only depends on the amount of key value pairs received.
-        // See https://arduinojson.org/v6/assistant/ for more information on the needed size for the JsonDocument
-        size_t const document_size = JSON_OBJECT_SIZE(size);
-        if (m_max_response_size != 0U && document_size > m_max_response_size) {
-            Logger::printfln(MAXIMUM_RESPONSE_EXCEEDED, document_size, m_max_response_size);
-            return;
-        }
-        TBJsonDocument json_buffer(document_size);
-        // Because we calcualte the allocation dynamically fromt he payload, which is user input, it could theoretically be malicious ({ "malicious" : "{{{{{{{{{..."}) and contain a lot of the symbols used to calculate the size.
-        // But if that is the case adn the allocation still succeeds we delete the allocated memory relatively fast again so it shouldn't be a problem and if the allocation fails we simply return at this point with an appropriate error message
-        if (json_buffer.capacity() != document_size) {
-            Logger::printfln(HEAP_ALLOCATION_FAILED, document_size);
-            return;
-        }
-#else
         if (size > MaxResponse) {
             Logger::printfln(TOO_MANY_JSON_FIELDS, size, "MaxResponse", MaxResponse);
             return;
         }
-        size_t const document_size = JSON_OBJECT_SIZE(MaxResponse);
-        StaticJsonDocument<document_size> json_buffer;
 #endif // THINGSBOARD_ENABLE_DYNAMIC
-#if THINGSBOARD_ENABLE_DEBUG
-        Logger::printfln(ALLOCATING_JSON, document_size);
-#endif // THINGSBOARD_ENABLE_DEBUG
+        // Grows as required while deserializing, if allocating the memory fails the deserialization returns DeserializationError::NoMemory
+        TBJsonDocument json_buffer;
+#endif // THINGSBOARD_ENABLE_JSON_ARENA
 
-        // The deserializeJson method we use, can use the zero copy mode because a writeable input was passed,
-        // if that were not the case the needed allocated memory would drastically increase, because the keys would need to be copied as well.
-        // See https://arduinojson.org/v6/doc/deserialization/ for more info on ArduinoJson deserialization
+        // See https://arduinojson.org/v7/api/json/deserializejson/ for more info on ArduinoJson deserialization
         DeserializationError const error = deserializeJson(json_buffer, payload, length);
         if (error) {
             Logger::printfln(UNABLE_TO_DE_SERIALIZE_JSON, error.c_str());
             return;
         }
 
-#if THINGSBOARD_ENABLE_STL
-#if THINGSBOARD_ENABLE_CXX20
-        auto filtered_json_api_implementations = m_api_implementations | std::views::filter([&topic](IAPI_Implementation const * api) {
-#else
-#if THINGSBOARD_ENABLE_DYNAMIC
-        Vector<IAPI_Implementation *> filtered_json_api_implementations = {};
-#else
-        Array<IAPI_Implementation *, MaxEndpointsAmount> filtered_json_api_implementations = {};
-#endif // THINGSBOARD_ENABLE_DYNAMIC
-        std::copy_if(m_api_implementations.begin(), m_api_implementations.end(), std::back_inserter(filtered_json_api_implementations), [&topic](IAPI_Implementation const * api) {
-#endif // THINGSBOARD_ENABLE_CXX20
-            return (api != nullptr && api->Get_Process_Type() == API_Process_Type::JSON && api->Compare_Response_Topic(topic));
-        });
-
-        for (auto & api : filtered_json_api_implementations) {
-            api->Process_Json_Response(topic, json_buffer);
-        }
-#else
-        for (auto & api : m_api_implementations) {
-            if (api == nullptr || api->Get_Process_Type() != API_Process_Type::JSON || !api->Compare_Response_Topic(topic)) {
+        for (auto const & route : m_topic_routes) {
+            if (!route.matched) {
                 continue;
             }
-            api->Process_Json_Response(topic, json_buffer);
+            for (size_t i = route.first; i < route.first + route.count; ++i) {
+                IAPI_Implementation * api = m_routed_implementations[i];
+                if (api->Get_Process_Type() != API_Process_Type::JSON || !api->Compare_Response_Topic(topic)) {
+                    continue;
+                }
+                api->Process_Json_Response(topic, json_buffer);
+            }
         }
-#endif // THINGSBOARD_ENABLE_STL
+#if THINGSBOARD_ENABLE_JSON_ARENA
+        // Hands the complete arena back, so that the response does not keep it occupied until the next one is received
+        json_buffer.clear();
+#endif // THINGSBOARD_ENABLE_JSON_ARENA
     }
 
 #if !THINGSBOARD_ENABLE_STL
@@ -902,10 +1024,21 @@ class ThingsBoardSized {
 #endif // THINGSBOARD_ENABLE_STREAM_UTILS
 #if !THINGSBOARD_ENABLE_DYNAMIC
     Array<IAPI_Implementation*, MaxEndpointsAmount> m_api_implementations = {}; // Can hold a pointer to all possible API implementations (Server side RPC, Client side RPC, Shared attribute update, Client-side or shared attribute request, Provision)   
+    Array<Topic_Route, MaxEndpointsAmount>          m_topic_routes = {};        // Routing table of the received messages, one route per distinct response topic prefix, sorted by ascending prefix length
+    Array<IAPI_Implementation*, MaxEndpointsAmount> m_routed_implementations = {}; // Same pointers as m_api_implementations, ordered so that the api implementations of each route are adjacent
 #else
     size_t                                          m_max_response_size = {};   // Maximum size allocated on the heap to hold the Json data structure for received cloud response payload, prevents possible malicious payload allocaitng a lot of memory
     Vector<IAPI_Implementation*>                    m_api_implementations = {}; // Can hold a pointer to all  possible API implementations (Server side RPC, Client side RPC, Shared attribute update, Client-side or shared attribute request, Provision)   
+    Vector<Topic_Route>                             m_topic_routes = {};        // Routing table of the received messages, one route per distinct response topic prefix, sorted by ascending prefix length
+    Vector<IAPI_Implementation*>                    m_routed_implementations = {}; // Same pointers as m_api_implementations, ordered so that the api implementations of each route are adjacent
 #endif // !THINGSBOARD_ENABLE_DYNAMIC                
+#if THINGSBOARD_ENABLE_JSON_ARENA
+    Arena_Allocator<THINGSBOARD_JSON_ARENA_SIZE>    m_receive_arena = {};       // Buffer the memory of the received responses is handed out from, allocated once together with this instance
+    JsonDocument                                    m_receive_document{&m_receive_arena}; // Document every received response is deserialized into, kept alive so its memory is reused instead of allocated per message
+#endif // THINGSBOARD_ENABLE_JSON_ARENA
+#if THINGSBOARD_SEND_BUFFER_SIZE
+    char                                            m_send_buffer[THINGSBOARD_SEND_BUFFER_SIZE] = {}; // Buffer payloads too big for the stack are serialized into, allocated once together with this instance
+#endif // THINGSBOARD_SEND_BUFFER_SIZE
 };
 
 #if !THINGSBOARD_ENABLE_STL
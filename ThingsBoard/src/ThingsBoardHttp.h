@@ -49,6 +49,7 @@ class ThingsBoardHttpSized {
       : m_client(client)
       , m_max_stack(max_stack_size)
       , m_token(access_token)
+      , m_keep_alive(keep_alive)
     {
         m_client.set_keep_alive(keep_alive);
         if (m_client.connect(host, port) != 0) {
@@ -65,18 +66,18 @@ class ThingsBoardHttpSized {
     /// @brief Attempts to send key value pairs from custom source over the given topic to the server
     /// @param topic Topic we want to send the data over
     /// @param source JsonDocument containing our json key value pairs we want to send,
-    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v6/api/jsondocument/ for more information
+    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v7/api/jsondocument/ for more information
     /// @param json_size Size of the data inside the source
     /// @return Whether sending the data was successful or not
     bool Send_Json(char const * topic, JsonDocument const & source, size_t const & json_size) {
         // Check if allocating needed memory failed when trying to create the JsonDocument,
-        // if it did the isNull() method will return true. See https://arduinojson.org/v6/api/jsonvariant/isnull/ for more information
+        // if it did the isNull() method will return true. See https://arduinojson.org/v7/api/jsonvariant/isnull/ for more information
         if (source.isNull()) {
             Logger::println(UNABLE_TO_ALLOCATE_JSON);
             return false;
         }
-        // Check if inserting any of the internal values failed because the JsonDocument was too small,
-        // if it did the overflowed() method will return true. See https://arduinojson.org/v6/api/jsondocument/overflowed/ for more information
+        // Check if inserting any of the internal values failed because allocating the memory for them failed,
+        // if it did the overflowed() method will return true. See https://arduinojson.org/v7/api/jsondocument/overflowed/ for more information
         if (source.overflowed()) {
             Logger::println(JSON_SIZE_TO_SMALL);
             return false;
@@ -159,6 +160,8 @@ class ThingsBoardHttpSized {
 
     /// @brief Attempts to send custom json telemetry string.
     /// See https://thingsboard.io/docs/user-guide/telemetry/ for more information
+    /// @note The json may also be an array of timestamped samples, [{"ts":1700000000000,"values":{...}},...],
+    /// which uploads a whole batch with a single request. Together with keep alive, every further sample then only costs its own bytes
     /// @param json String containing our json key value pairs we want to attempt to send
     /// @return Whetherr sending the data was successful or not
     bool sendTelemetryString(char const * json) {
@@ -168,7 +171,7 @@ class ThingsBoardHttpSized {
     /// @brief Attempts to send telemetry key value pairs from custom source to the server.
     /// See https://thingsboard.io/docs/user-guide/telemetry/ for more information
     /// @param source JsonDocument containing our json key value pairs we want to send,
-    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v6/api/jsondocument/ for more information
+    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v7/api/jsondocument/ for more information
     /// @param json_size Size of the data inside the source
     /// @return Whether sending the data was successful or not
     bool sendTelemetryJson(JsonDocument const & source, size_t const & json_size) {
@@ -244,7 +247,7 @@ class ThingsBoardHttpSized {
     /// @brief Attempts to send attribute key value pairs from custom source to the server.
     /// See https://thingsboard.io/docs/user-guide/attributes/ for more information
     /// @param source JsonDocument containing our json key value pairs we want to send,
-    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v6/api/jsondocument/ for more information
+    /// is checked before usage for any possible occuring internal errors. See https://arduinojson.org/v7/api/jsondocument/ for more information
     /// @param json_size Size of the data inside the source
     /// @return Whether sending the data was successful or not
     bool sendAttributeJson(JsonDocument const & source, size_t const & json_size) {
@@ -262,6 +265,18 @@ class ThingsBoardHttpSized {
     /// and resets the TCP as well, if data is resend the TCP connection has to be re-established
     void clearConnection() {
         m_client.stop();
+        m_connection_used = false;
+    }
+
+    /// @brief Finishes a request that succeeded. With keep alive the response body is read to its end,
+    /// so the next request can be sent over the same TCP (and TLS) connection, otherwise the connection is closed
+    void finishRequest() {
+        if (!m_keep_alive) {
+            clearConnection();
+            return;
+        }
+        (void)m_client.get_response_body();
+        m_connection_used = true;
     }
 
     /// @brief Attempts to send a POST request over HTTP or HTTPS
@@ -270,15 +285,23 @@ class ThingsBoardHttpSized {
     /// @return Whetherr sending the POST request was successful or not
     bool postMessage(char const * path, char const * json) {
         bool success = m_client.post(path, HTTP_POST_PATH, json) == 0;
-        int const status = m_client.get_response_status_code();
+        int status = m_client.get_response_status_code();
+
+        if (!success && m_connection_used) {
+            // The server may have closed the kept connection while it was idle, retry once over a new one.
+            clearConnection();
+            success = m_client.post(path, HTTP_POST_PATH, json) == 0;
+            status = m_client.get_response_status_code();
+        }
 
         if (!success || status < HTTP_RESPONSE_SUCCESS_RANGE_START || status > HTTP_RESPONSE_SUCCESS_RANGE_END) {
             Logger::printfln(HTTP_FAILED, POST, status);
-            success = false;
+            clearConnection();
+            return false;
         }
 
-        clearConnection();
-        return success;
+        finishRequest();
+        return true;
     }
 
     /// @brief Attempts to send a GET request over HTTP or HTTPS
@@ -291,19 +314,30 @@ class ThingsBoardHttpSized {
 #else
     bool getMessage(char const * path, String& response) {
 #endif // THINGSBOARD_ENABLE_STL
-        bool success = m_client.get(path);
-        int const status = m_client.get_response_status_code();
+        bool success = m_client.get(path) == 0;
+        int status = m_client.get_response_status_code();
+
+        if (!success && m_connection_used) {
+            // The server may have closed the kept connection while it was idle, retry once over a new one.
+            clearConnection();
+            success = m_client.get(path) == 0;
+            status = m_client.get_response_status_code();
+        }
 
         if (!success || status < HTTP_RESPONSE_SUCCESS_RANGE_START || status > HTTP_RESPONSE_SUCCESS_RANGE_END) {
             Logger::printfln(HTTP_FAILED, GET, status);
-            success = false;
-            goto cleanup;
+            clearConnection();
+            return false;
         }
         response = m_client.get_response_body();
 
-        cleanup:
-        clearConnection();
-        return success;
+        if (m_keep_alive) {
+            m_connection_used = true;
+        }
+        else {
+            clearConnection();
+        }
+        return true;
     }
 
     /// @brief Attempts to send aggregated attribute or telemetry data
@@ -322,16 +356,14 @@ class ThingsBoardHttpSized {
     template<size_t MaxKeyValuePairAmount, typename InputIterator>
 #endif // THINGSBOARD_ENABLE_DYNAMIC
     bool sendDataArray(InputIterator const & first, InputIterator const & last, bool telemetry) {
+#if !THINGSBOARD_ENABLE_DYNAMIC
         size_t const size = Helper::distance(first, last);
-#if THINGSBOARD_ENABLE_DYNAMIC
-        TBJsonDocument json_buffer(JSON_OBJECT_SIZE(size));
-#else
         if (size > MaxKeyValuePairAmount) {
             Logger::printfln(TOO_MANY_JSON_FIELDS, size, "MaxKeyValuePairAmount", MaxKeyValuePairAmount);
             return false;
         }
-        StaticJsonDocument<JSON_OBJECT_SIZE(MaxKeyValuePairAmount)> json_buffer;
-#endif // THINGSBOARD_ENABLE_DYNAMIC
+#endif // !THINGSBOARD_ENABLE_DYNAMIC
+        TBJsonDocument json_buffer;
 
 #if THINGSBOARD_ENABLE_STL
         if (std::any_of(first, last, [&json_buffer](Telemetry const & data) { return !data.SerializeKeyValue(json_buffer); })) {
@@ -364,7 +396,7 @@ class ThingsBoardHttpSized {
             return false;
         }
 
-        StaticJsonDocument<JSON_OBJECT_SIZE(1)> json_buffer;
+        TBJsonDocument json_buffer;
         if (!t.SerializeKeyValue(json_buffer)) {
             Logger::printfln(UNABLE_TO_SERIALIZE);
             return false;
@@ -375,6 +407,8 @@ class ThingsBoardHttpSized {
     IHTTP_Client& m_client = {};     // HttpClient instance
     size_t        m_max_stack = {};  // Maximum stack size we allocate at once on the stack.
     char const    *m_token = {};     // Access token used to connect with
+    bool          m_keep_alive = {}; // Whether the TCP connection is kept open between requests
+    bool          m_connection_used = {}; // Whether a previous request went over the currently open connection
 };
 
 using ThingsBoardHttp = ThingsBoardHttpSized<>;
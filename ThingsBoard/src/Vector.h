@@ -144,18 +144,29 @@ class Vector {
     /// @param element Element that should be inserted at the end
     void push_back(T const & element) {
         if (m_size == m_capacity) {
-            m_capacity = (m_capacity == 0) ? 1 : 2 * m_capacity;
-            T* new_elements = new T[m_capacity]();
-            if (m_elements != nullptr) {
-                memcpy(new_elements, m_elements, m_size * sizeof(T));
-                delete[] m_elements;
-            }
-            m_elements = new_elements;
+            reserve((m_capacity == 0) ? 1 : 2 * m_capacity);
         }
         m_elements[m_size] = element;
         m_size++;
     }
 
+    /// @brief Grows the underlying data container so it can hold at least the given amount of elements without allocating again, does nothing if it already can.
+    /// Allows to allocate the complete capacity once at startup instead of growing it by doubling, which allocates and frees a new block every time the capacity is exceeded.
+    /// Because clear() keeps the capacity, a container that is reserved once and cleared instead of destroyed never allocates again
+    /// @param capacity Amount of elements the underlying data container should be able to hold
+    void reserve(size_t const & capacity) {
+        if (capacity <= m_capacity) {
+            return;
+        }
+        T* new_elements = new T[capacity]();
+        if (m_elements != nullptr) {
+            memcpy(new_elements, m_elements, m_size * sizeof(T));
+            delete[] m_elements;
+        }
+        m_elements = new_elements;
+        m_capacity = capacity;
+    }
+
     /// @brief Inserts all element from the given start to the given end iterator into the underlying data container.
     /// Simply calls push_back on each element, meaning if the initally allocated size if not big enough to hold all elements,
     /// then this method will simply not insert those elements instead
@@ -214,7 +225,7 @@ class Vector {
     }
 
     /// @brief Clears the given underlying data container.
-    /// Simply sets the underlying size to 0, data will only be cleared in the destructor
+    /// Simply sets the underlying size to 0, data will only be cleared in the destructor and the capacity is kept for the following push_back calls
     void clear() {
         m_size = 0;
     }
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Creates a delta patch from the firmware binary a device runs to a new one, which the Delta_Updater applies while it is downloaded.
+
+Upload the patch as the OTA package instead of the new binary, it only has to reach devices running the old binary exactly,
+the Delta_Updater refuses it on any other one before writing anything. See src/Delta_Updater.h for the format.
+
+    python3 create_delta_patch.py old.bin new.bin patch.bin
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+
+MAGIC = b"TBD1"
+# Length of the exact matches searched in the old binary, before they are extended into diff bytes
+MATCH_SIZE = 8
+# How many bytes past the best point a diff is extended, before the bytes are taken as extra bytes instead
+EXTEND_LOOKAHEAD = 64
+# Runs of 0 shorter than this are kept inside the diff bytes that follow in the patch, because each token costs a byte
+MIN_ZERO_RUN = 3
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+
+def index_old(old):
+    index = {}
+    for pos in range(len(old) - MATCH_SIZE + 1):
+        index.setdefault(old[pos:pos + MATCH_SIZE], pos)
+    return index
+
+
+def find_match(old, new, index, start, alignment):
+    """Returns the next position in new from start that matches old, preferring the previous alignment, and its position in old."""
+    for pos in range(start, len(new) - MATCH_SIZE + 1):
+        key = new[pos:pos + MATCH_SIZE]
+        if alignment is not None:
+            candidate = pos + alignment
+            if 0 <= candidate <= len(old) - MATCH_SIZE and old[candidate:candidate + MATCH_SIZE] == key:
+                return pos, candidate
+        candidate = index.get(key)
+        if candidate is not None:
+            return pos, candidate
+    return len(new), None
+
+
+def extend(old, new, new_pos, old_pos):
+    """Returns how far the diff starting at the given positions is worth extending, where at least half of the bytes match."""
+    best, best_score, score = 0, 0, 0
+    length = 0
+    limit = min(len(new) - new_pos, len(old) - old_pos)
+    while length < limit and length - best <= EXTEND_LOOKAHEAD:
+        score += 1 if new[new_pos + length] == old[old_pos + length] else -1
+        length += 1
+        if score > best_score:
+            best, best_score = length, score
+    return best
+
+
+def encode_diff(diff):
+    out = bytearray()
+    zero_run = bytes(MIN_ZERO_RUN)
+    pos = 0
+    while pos < len(diff):
+        end = pos
+        while end < len(diff) and diff[end] == 0:
+            end += 1
+        if end > pos:
+            out += varint((end - pos) << 1)
+        else:
+            while end < len(diff) and diff[end:end + MIN_ZERO_RUN] != zero_run:
+                end += 1
+            out += varint(((end - pos) << 1) | 1) + diff[pos:end]
+        pos = end
+    return bytes(out)
+
+
+def record(diff, extra, seek):
+    return varint(len(diff)) + varint(len(extra)) + varint(zigzag(seek)) + encode_diff(diff) + extra
+
+
+def create_patch(old, new):
+    index = index_old(old)
+    patch = bytearray(MAGIC + struct.pack("<II", len(old), len(new)))
+    patch += hashlib.sha256(old).hexdigest().encode() + hashlib.sha256(new).hexdigest().encode()
+
+    new_pos, old_pos = find_match(old, new, index, 0, None)
+    patch += record(b"", new[:new_pos], old_pos if old_pos is not None else 0)
+    while new_pos < len(new):
+        length = extend(old, new, new_pos, old_pos)
+        diff = bytes((new[new_pos + i] - old[old_pos + i]) & 0xFF for i in range(length))
+        new_pos += length
+        old_pos += length
+        next_new, next_old = find_match(old, new, index, new_pos, old_pos - new_pos)
+        seek = (next_old - old_pos) if next_old is not None else 0
+        patch += record(diff, new[new_pos:next_new], seek)
+        new_pos = next_new
+        old_pos += seek
+    return bytes(patch)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("old", help="firmware binary the devices run")
+    parser.add_argument("new", help="firmware binary they should be updated to")
+    parser.add_argument("patch", help="delta patch that is created")
+    args = parser.parse_args()
+
+    with open(args.old, "rb") as file:
+        old = file.read()
+    with open(args.new, "rb") as file:
+        new = file.read()
+    patch = create_patch(old, new)
+    with open(args.patch, "wb") as file:
+        file.write(patch)
+    print("%s: %u bytes, %.1f %% of %s" % (args.patch, len(patch), 100.0 * len(patch) / max(len(new), 1), args.new), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,259 @@
+// Include Arduino.h for ESP32 to quieten annoying VS Code squiggles
+#ifdef ARDUINO_ARCH_ESP32
+    #include <Arduino.h>
+#endif
+#include "InfiniCRC.h"
+#include "InfiniCommandMaker.h"
+#include "InfiniResponseParser.h"
+#include "InfiniJsonWriter.h"
+#include "InfiniGsSkeleton.h"
+#include "InfiniGsView.h"
+#include "InfiniRxRing.h"
+#include "InfiniTelemetryBatch.h"
+
+// On-target benchmarks, no inverter needed. Each operation runs ITERATIONS times and the sketch
+// prints the mean cycles per run, from the CCOUNT register on ESP32 or Timer1 at F_CPU on AVR,
+// and the stack it used at most. Interrupts stay on, so expect a few percent of noise from the tick.
+// GS is decoded by hand unless built with -DINFI_GS_SSCANF=1, build both to compare the two.
+
+using namespace INFI;
+
+// Baud rate for debug serial
+#define SERIAL_DEBUG_BAUD    115200
+
+const unsigned int ITERATIONS = 200;
+
+// Bytes below the caller's stack frame painted before each operation, more than any of them uses.
+#if defined(ARDUINO_ARCH_ESP32)
+const size_t STACK_PROBE_SZ = 3072;
+#else
+const size_t STACK_PROBE_SZ = 768;
+#endif
+const uint8_t STACK_PAINT = 0xA5;
+
+#if defined(__AVR__)
+volatile unsigned long timer1Overflows = 0;
+
+ISR(TIMER1_OVF_vect) {
+    timer1Overflows++;
+}
+
+// Timer1 counts every CPU cycle, its overflows extend it to 32 bits.
+void startCycleCounter() {
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+    TCNT1 = 0;
+    TIMSK1 = _BV(TOIE1);
+}
+
+unsigned long cycleCount() {
+    uint8_t sreg = SREG;
+    cli();
+    unsigned long overflows = timer1Overflows;
+    uint16_t count = TCNT1;
+    // Overflowed after cli(), the ISR has not counted it yet.
+    if ((TIFR1 & _BV(TOV1)) && count < 0x8000) {
+        overflows++;
+    }
+    SREG = sreg;
+    return (overflows << 16) | count;
+}
+#else
+void startCycleCounter() {}
+
+unsigned long cycleCount() {
+    return ESP.getCycleCount();
+}
+#endif
+
+// Whatever an operation leaves here, so the compiler cannot drop it.
+volatile unsigned long sink = 0;
+
+// A ^Dxxx reply around payload with a valid CRC, as the inverter would send it.
+struct Frame {
+    char data[MAX_RESPONSE_SZ];
+    size_t len;
+
+    void make(const char *payload) {
+        int n = snprintf(data, sizeof(data), "^D%03d%s", (int)strlen(payload) + CRC_SZ + END_TOKEN_SZ, payload);
+        WORD crc = calc_crc_half((const BYTE *)data, (BYTE)n);
+        data[n++] = (char)(crc >> 8);
+        data[n++] = (char)(crc & 0xFF);
+        data[n++] = '\r';
+        data[n] = '\0';
+        len = (size_t)n;
+    }
+};
+
+// Discards whatever is written.
+class NullPrint : public Print {
+    public:
+    size_t write(uint8_t) override { return 1; }
+};
+
+Frame gsFrame;
+Frame piriFrame;
+InfiniCommandMaker cmdMaker;
+InfiniResponseParser respParser;
+InfiniRxRing rxRing;
+NullPrint nullPrint;
+char rxFrame[MAX_RESPONSE_SZ];
+char gsJson[PARSED_SZ];
+InfiniGsSkeleton gsSkeleton;
+RatedInformation piri;
+
+// The publish path up to the MQTT client, which only has to be handed the finished payload.
+bool countPublish(const char *json, void *) {
+    sink += strlen(json);
+    return true;
+}
+char batchJson[1024];
+InfiniTelemetryBatch telemetryBatch(batchJson, sizeof(batchJson), 32, countPublish);
+
+void benchCrc() {
+    sink += calc_crc_half((const BYTE *)gsFrame.data, (BYTE)(gsFrame.len - CRC_SZ - END_TOKEN_SZ));
+}
+
+void benchCrcAccumulator() {
+    InfiniCrcAccumulator acc;
+    acc.update((const BYTE *)gsFrame.data, (BYTE)(gsFrame.len - CRC_SZ - END_TOKEN_SZ));
+    sink += acc.finalize();
+}
+
+void benchWriteCommand() {
+    sink += cmdMaker.writeCommand(GENERAL_STATUS, NULL, nullPrint);
+}
+
+void benchRxFraming() {
+    for (size_t i = 0; i < gsFrame.len; ++i) {
+        rxRing.push((BYTE)gsFrame.data[i]);
+    }
+    sink += rxRing.popFrame(rxFrame, sizeof(rxFrame));
+}
+
+void benchGsDecode() {
+    sink += respParser.fromILGSToGeneralStatusFixed(gsFrame.data, gsFrame.len);
+}
+
+void benchGsView3() {
+    GeneralStatusView view;
+    if (view.reset(gsFrame.data, gsFrame.len)) {
+        sink += view.value(GS_BATT_VOLT) + view.value(GS_PV1_IN_POW) + view.value(GS_AC_OUT_ACTIVE_POW);
+    }
+}
+
+void benchGsToJson() {
+    sink += respParser.fromILGSToGeneralStatus(gsFrame.data, gsFrame.len);
+}
+
+void benchPiriDecode() {
+    sink += respParser.fromPIRIToRatedInformation(piriFrame.data, piriFrame.len, piri);
+}
+
+void benchGsJsonWriter() {
+    InfiniBufferPrint out(gsJson, sizeof(gsJson));
+    sink += writeGeneralStatusJson(respParser.generalStatusFixed, out);
+}
+
+void benchGsSkeleton() {
+    gsSkeleton.fill(respParser.generalStatusFixed);
+    sink += gsSkeleton.printTo(nullPrint);
+}
+
+void benchPublishPath() {
+    InfiniBufferPrint out(gsJson, sizeof(gsJson));
+    writeGeneralStatusJson(respParser.generalStatusFixed, out);
+    telemetryBatch.addJson(gsJson);
+    sink += telemetryBatch.flush();
+}
+
+typedef void (*BenchOp)();
+
+struct Bench {
+    const char *name;
+    BenchOp op;
+};
+
+const Bench BENCHES[] = {
+    { "calc_crc_half GS", benchCrc },
+    { "InfiniCrcAccumulator GS", benchCrcAccumulator },
+    { "writeCommand GS", benchWriteCommand },
+    { "InfiniRxRing GS frame", benchRxFraming },
+#if INFI_GS_SSCANF
+    { "GS decode (sscanf)", benchGsDecode },
+#else
+    { "GS decode (hand)", benchGsDecode },
+#endif
+    { "GS view, 3 fields", benchGsView3 },
+    { "GS decode + JSON", benchGsToJson },
+    { "PIRI decode", benchPiriDecode },
+    { "writeGeneralStatusJson", benchGsJsonWriter },
+    { "InfiniGsSkeleton fill + write", benchGsSkeleton },
+    { "GS publish path", benchPublishPath }
+};
+
+// Fills STACK_PROBE_SZ bytes below this frame with STACK_PAINT. Never inlined, so the frames
+// of the operation called after it start about where this one did.
+__attribute__((noinline)) void paintStack() {
+    volatile uint8_t marker = 0;
+    volatile uint8_t *top = &marker - 32;
+    for (size_t i = 0; i < STACK_PROBE_SZ; ++i) {
+        *(top - i) = STACK_PAINT;
+    }
+}
+
+// The number of painted bytes the last operation overwrote, counted from the deepest one.
+__attribute__((noinline)) size_t measureStack() {
+    volatile uint8_t marker = 0;
+    volatile uint8_t *top = &marker - 32;
+    size_t untouched = 0;
+    while (untouched < STACK_PROBE_SZ && *(top - (STACK_PROBE_SZ - 1) + untouched) == STACK_PAINT) {
+        untouched++;
+    }
+    return STACK_PROBE_SZ - untouched;
+}
+
+void runBench(const Bench &bench) {
+    paintStack();
+    bench.op();
+    size_t stackUsed = measureStack();
+
+    unsigned long start = cycleCount();
+    for (unsigned int i = 0; i < ITERATIONS; ++i) {
+        bench.op();
+    }
+    unsigned long cycles = (cycleCount() - start) / ITERATIONS;
+
+    Serial.print(bench.name);
+    Serial.print(": ");
+    Serial.print(cycles);
+    Serial.print(" cycles, ");
+    Serial.print(cycles / (F_CPU / 1000000UL));
+    Serial.print(" us, stack ");
+    Serial.print((unsigned long)stackUsed);
+    Serial.println(" bytes");
+}
+
+void setup() {
+    Serial.begin(SERIAL_DEBUG_BAUD);
+    while(!Serial) {
+        delay(1000);
+    }
+    startCycleCounter();
+
+    gsFrame.make("2300,500,2301,500,0450,0400,009,524,000,000,000,012,100,035,030,000,0850,0000,3400,0000,0,2,0,1,1,2,1,0");
+    piriFrame.make("2300,500,0200,230,500,0217,5000,500,480,460,540,420,564,1,30,060,0,0,2,9,0,1,0,1,2");
+    if (!respParser.fromILGSToGeneralStatusFixed(gsFrame.data, gsFrame.len)) {
+        Serial.println("GS sample frame did not decode");
+    }
+}
+
+void loop() {
+    Serial.println();
+    Serial.print(ITERATIONS);
+    Serial.println(" runs each");
+    for (size_t i = 0; i < sizeof(BENCHES) / sizeof(BENCHES[0]); ++i) {
+        runBench(BENCHES[i]);
+    }
+    delay(10000);
+}
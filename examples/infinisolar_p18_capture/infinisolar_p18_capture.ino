@@ -0,0 +1,49 @@
+// Include Arduino.h for ESP32 to quieten annoying VS Code squiggles
+#ifdef ARDUINO_ARCH_ESP32
+    #include <Arduino.h>
+#endif
+#include "InfiniCommandQueue.h"
+#include "InfiniLinkCapture.h"
+
+using INFI::InfiniCommandSender;
+using INFI::InfiniCommandQueue;
+
+#define RXD2 16
+#define TXD2 17
+
+// The USB Serial only carries capture records, see InfiniLinkCapture.h for their layout.
+#define SERIAL_CAPTURE_BAUD  921600
+
+// How often GS and T are queued. The queue sends them back to back, as fast as the inverter answers.
+const unsigned long POLL_PERIOD = 1000;
+unsigned long polledMs = 0;
+
+// No debug stream, the text logs would land in the middle of the records.
+InfiniCommandSender cmdSender(Serial2);
+InfiniCommandQueue cmdQueue(cmdSender);
+INFI::InfiniLinkCapture linkCapture;
+
+void setup() {
+    Serial.begin(SERIAL_CAPTURE_BAUD);
+    #ifdef ARDUINO_ARCH_ESP32
+        Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1, RXD2, TXD2);
+    #else
+        Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1);
+    #endif
+
+    while(!Serial || !Serial2) {
+        delay(1000);
+    }
+    cmdSender.setCapture(&linkCapture);
+}
+
+void loop() {
+    if (millis() - polledMs >= POLL_PERIOD) {
+        polledMs = millis();
+        cmdQueue.enqueue(INFI::GENERAL_STATUS, "");
+        cmdQueue.enqueue(INFI::CURRENT_TIME, "");
+    }
+    cmdQueue.loop();
+    // Only what fits in the TX buffer of the port, so the link is never held up by the laptop.
+    linkCapture.drain(Serial);
+}
@@ -0,0 +1,210 @@
+// A SIM7000 on Serial1, for a SIM7600 define TINY_GSM_MODEM_SIM7600 instead. Needs TinyGSM, see lib_deps.
+#define TINY_GSM_MODEM_SIM7000
+#include <TinyGsmClient.h>
+#include <PubSubClient.h>   // Plain MQTT over the modem's TCP socket
+#include "infinisolar_p18_cellular_defs.h" // Defs for various secrets, keys
+#include "InfiniPollScheduler.h"
+#include "InfiniResponseParser.h"
+#include "InfiniClock.h"
+#include "InfiniGsHistory.h"
+#include "InfiniCellular.h"
+
+using INFI::InfiniCommandSender;
+using INFI::InfiniCommandQueue;
+using INFI::InfiniPollScheduler;
+using INFI::InfiniResponseParser;
+
+// Baud rate for debug serial
+#define SERIAL_DEBUG_BAUD    115200
+
+// The modem's UART, its PWRKEY, which takes it out of PSM, and DTR, which takes it out of the AT+CSCLK sleep.
+#define MODEM_RX        26
+#define MODEM_TX        27
+#define MODEM_PWRKEY    4
+#define MODEM_DTR       25
+const unsigned long MODEM_BAUD = 115200;
+
+InfiniCommandSender cmdSender(Serial2, &Serial);
+InfiniCommandQueue cmdQueue(cmdSender);
+InfiniPollScheduler pollScheduler(cmdQueue);
+InfiniResponseParser respParser;
+
+// The inverter's clock timestamps the samples, T is only polled to resync it.
+INFI::InfiniClock inverterClock;
+// How far the inverter's local time is ahead of UTC, e.g. 19800 for India.
+const long INVERTER_UTC_OFFSET_S = 19800;
+
+// GS is sampled every GS_PERIOD into the history, which the modem flushes whenever a wake is worth it,
+// and at least every MAX_LATENCY_MS.
+const unsigned long GS_PERIOD = 10000;
+const unsigned long MAX_LATENCY_MS = 30UL * 60 * 1000;
+INFI::InfiniGsHistory gsHistory;
+INFI::GeneralStatusDelta gsDelta;
+// millis() of the oldest sample not flushed yet, and the JSON bytes a sample took in the last flush.
+unsigned long oldestPendingMs = 0;
+unsigned long bytesPerSample = 400;
+
+// PSM asks the network for a TAU of a day, so the modem is rarely woken by it, and 10 s of paging after
+// every flush, for the broker's acknowledgements.
+const unsigned long PSM_TAU_S = 24UL * 3600;
+const unsigned long PSM_ACTIVE_S = 10;
+// How long a wake may take to get online before it counts as failed.
+const unsigned long WAKE_TIMEOUT_MS = 60000;
+
+TinyGsm modem(Serial1);
+TinyGsmClient gsmClient(modem);
+PubSubClient mqtt(gsmClient);
+char telemetryJson[2048];
+INFI::InfiniCellularUplink uplink;
+
+void onCurrentTime(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || respParser.fromILCurrentTimeToILCurrentDay(response.val, response.actualLen) == 0
+      || !inverterClock.sync(response.val + INFI::START_OFFSET_SZ, millis())) {
+    Serial.println("Malformed current time response.");
+    return;
+  }
+  pollScheduler.setPeriod(INFI::CURRENT_TIME, inverterClock.resyncPeriodMs());
+}
+
+void onGeneralStatus(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || response.actualLen != INFI::getResponseSize(INFI::GENERAL_STATUS) ||
+      !respParser.fromILGSToGeneralStatusFixed(response.val, response.actualLen)) {
+    Serial.println("Malformed General Status response.");
+    return;
+  }
+  if (!inverterClock.isSynced()) {
+    return;
+  }
+  if (gsHistory.isEmpty()) {
+    oldestPendingMs = millis();
+  }
+  gsHistory.push(respParser.generalStatusFixed, inverterClock.unixMs(millis(), INVERTER_UTC_OFFSET_S));
+}
+
+// Out of the CSCLK sleep with DTR, and out of PSM, where the UART is dead, with a PWRKEY pulse.
+void wakeModem() {
+  digitalWrite(MODEM_DTR, LOW);
+  if (!modem.testAT(500)) {
+    digitalWrite(MODEM_PWRKEY, LOW);
+    delay(100);
+    digitalWrite(MODEM_PWRKEY, HIGH);
+  }
+}
+
+// The modem drops into PSM by itself once the active time after the flush ran out.
+void sleepModem() {
+  modem.sleepEnable(true);
+  digitalWrite(MODEM_DTR, HIGH);
+}
+
+// Sends the history in telemetry arrays, every one timed for the throughput the next batch is sized by.
+bool flushHistory() {
+  unsigned long samples = 0;
+  unsigned long bytes = 0;
+  while (!gsHistory.isEmpty()) {
+    // Only keep the delta's view of what was published if the publish went through.
+    INFI::GeneralStatusDelta delta = gsDelta;
+    INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+    INFI::BYTE consumed = gsHistory.writeJson(json, delta, sizeof(telemetryJson) - 1);
+    if (consumed == 0) {
+      break;
+    }
+    unsigned long start = millis();
+    if (!mqtt.publish("v1/devices/me/telemetry", telemetryJson)) {
+      return false;
+    }
+    uplink.onFlushed(json.length(), millis() - start);
+    gsDelta = delta;
+    gsHistory.pop(consumed);
+    samples += consumed;
+    bytes += json.length();
+    pollScheduler.loop();
+  }
+  if (samples > 0) {
+    bytesPerSample = bytes / samples;
+  }
+  return true;
+}
+
+// Steps the wake as far as it goes without waiting on the network, the inverter keeps being polled meanwhile.
+void runUplink() {
+  unsigned long now = millis();
+  switch (uplink.state()) {
+    case INFI::CELL_ASLEEP:
+      if (uplink.shouldWake(gsHistory.size() * bytesPerSample, now - oldestPendingMs, now)) {
+        uplink.beginWake(now);
+        wakeModem();
+      }
+      break;
+    case INFI::CELL_WAKING:
+      if (modem.isNetworkConnected() && (modem.isGprsConnected() ||
+          modem.gprsConnect(CELL_APN, CELL_APN_USER, CELL_APN_PASSWORD))) {
+        uplink.onAttached(millis());
+      }
+      break;
+    case INFI::CELL_CONNECTING: {
+      // The modem kept its TCP socket over the sleep, if the broker and the NAT did too, the session goes on.
+      bool reused = mqtt.connected() && mqtt.loop();
+      if (!reused && !mqtt.connect("infinisolar", TOKEN, NULL)) {
+        break;
+      }
+      uplink.onSessionUp(reused, millis());
+      break;
+    }
+    case INFI::CELL_ONLINE:
+      if (flushHistory()) {
+        mqtt.loop();
+        sleepModem();
+        uplink.endWake(millis());
+        Serial.print("Flushed, "); uplink.writeJson(Serial); Serial.println();
+      } else {
+        sleepModem();
+        uplink.onFailed(millis());
+      }
+      return;
+  }
+  if (uplink.state() != INFI::CELL_ASLEEP && uplink.awakeMs(now) >= WAKE_TIMEOUT_MS) {
+    Serial.println("The modem did not get online, backing off.");
+    sleepModem();
+    uplink.onFailed(now);
+  }
+}
+
+void setup() {
+  Serial.begin(SERIAL_DEBUG_BAUD);
+  Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1, 16, 17);
+  Serial1.begin(MODEM_BAUD, SERIAL_8N1, MODEM_RX, MODEM_TX);
+  pinMode(MODEM_PWRKEY, OUTPUT);
+  pinMode(MODEM_DTR, OUTPUT);
+  digitalWrite(MODEM_PWRKEY, HIGH);
+  digitalWrite(MODEM_DTR, LOW);
+
+  if (!gsHistory.allocate(MAX_LATENCY_MS * 2 / GS_PERIOD)) {
+    Serial.println("No PSRAM, keeping the small GS history.");
+  }
+  // A wake sends what the history holds at most, and a late one still goes while it has room.
+  uplink.setMaxLatency(MAX_LATENCY_MS);
+  uplink.setBatchLimit(gsHistory.capacity() * bytesPerSample / 2);
+  pollScheduler.addPeriodic(INFI::CURRENT_TIME, INFI::CLOCK_RESYNC_MS, onCurrentTime);
+  pollScheduler.addPeriodic(INFI::GENERAL_STATUS, GS_PERIOD, onGeneralStatus);
+
+  modem.restart();
+  if (strlen(CELL_SIM_PIN) > 0) {
+    modem.simUnlock(CELL_SIM_PIN);
+  }
+  char psmParams[INFI::CELL_PSM_PARAMS_SZ];
+  if (INFI::makePsmParams(PSM_TAU_S, PSM_ACTIVE_S, psmParams)) {
+    modem.sendAT(GF("+CPSMS=1,,,"), psmParams);
+    modem.waitResponse();
+  }
+  mqtt.setServer(THINGSBOARD_SERVER, THINGSBOARD_PORT);
+  // The session has to outlive the sleep between flushes to be reused, the keep alive is in seconds.
+  mqtt.setKeepAlive(MAX_LATENCY_MS * 3 / 2 / 1000);
+  mqtt.setBufferSize(sizeof(telemetryJson) + 64);
+}
+
+void loop() {
+  // Sampling goes on whatever the modem does, the samples wait in gsHistory.
+  pollScheduler.loop();
+  runUplink();
+}
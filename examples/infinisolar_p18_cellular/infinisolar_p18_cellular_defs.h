@@ -0,0 +1,17 @@
+#ifndef INFINISOLAR_P18_CELLULAR_DEFS_H
+#define INFINISOLAR_P18_CELLULAR_DEFS_H
+
+// APN of the SIM, and its credentials if it has any.
+#define CELL_APN            "your.apn"
+#define CELL_APN_USER       ""
+#define CELL_APN_PASSWORD   ""
+// SIM PIN, empty if the SIM has none.
+#define CELL_SIM_PIN        ""
+
+// Access token of the ThingsBoard device.
+#define TOKEN               "device_access_token"
+// ThingsBoard server instance.
+#define THINGSBOARD_SERVER  "your.thingsboard.address"
+#define THINGSBOARD_PORT    1883
+
+#endif
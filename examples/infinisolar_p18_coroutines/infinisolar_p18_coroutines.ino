@@ -0,0 +1,82 @@
+// Include Arduino.h for ESP32 to quieten annoying VS Code squiggles
+#ifdef ARDUINO_ARCH_ESP32
+    #include <Arduino.h>
+#endif
+#include "InfiniCoroutine.h"
+#include "InfiniResponseParser.h"
+
+#if !INFI_ENABLE_COROUTINES
+    #error "This example needs C++20 coroutines, e.g. build_flags = -std=gnu++2a and build_unflags = -std=gnu++11"
+#endif
+
+using namespace INFI;
+
+#define RXD2 16
+#define TXD2 17
+
+// Baud rate for debug serial
+#define SERIAL_DEBUG_BAUD    115200
+
+// How often the whole read flow runs.
+const unsigned long CYCLE_PERIOD = 10000;
+
+InfiniCommandSender cmdSender(Serial2, &Serial);
+InfiniCommandQueue cmdQueue(cmdSender);
+InfiniResponseParser respParser;
+InfiniExecutor executor;
+InfiniCoInverter inverter(cmdQueue);
+
+// ED, EM and EY of day, one after the other.
+InfiniTask readEnergy(const char *day) {
+    const COMMAND_TYPE counters[] = { GEN_ENERGY_DAY, GEN_ENERGY_MONTH, GEN_ENERGY_YEAR };
+    for (COMMAND_TYPE counter : counters) {
+        InfiniQueryResult energy = co_await inverter.query(counter, day);
+        if (!energy.ok()) {
+            Serial.print("No energy reply: "); Serial.println(getResponseErrorString(energy.response.error));
+            continue;
+        }
+        Serial.print(getCommandDescriptor(counter).mnemonic); Serial.print(": ");
+        Serial.println(respParser.fromInfiniGenEnergyToULong(energy.response.val, energy.response.actualLen));
+    }
+}
+
+// T, then the energy of the day it read, then GS. Each co_await waits for the reply without blocking loop().
+InfiniTask readCycle() {
+    for (;;) {
+        InfiniQueryResult t = co_await inverter.query(CURRENT_TIME);
+        if (t.ok() && respParser.fromILCurrentTimeToILCurrentDay(t.response.val, t.response.actualLen) > 0) {
+            char day[TIME_DAY_SZ + 1];
+            memcpy(day, respParser.parsed, sizeof(day));
+            Serial.print("Current day: "); Serial.println(day);
+            co_await readEnergy(day);
+        } else {
+            Serial.println("Inverter not responding, skipping the energy counters.");
+        }
+
+        InfiniQueryResult gs = co_await inverter.query(GENERAL_STATUS);
+        if (gs.ok() && respParser.fromILGSToGeneralStatusFixed(gs.response.val, gs.response.actualLen)) {
+            Serial.print("Battery: "); Serial.print(respParser.generalStatusFixed.battVoltDeci / 10.0f); Serial.println(" V");
+        }
+        co_await executor.sleep(CYCLE_PERIOD);
+    }
+}
+
+void setup() {
+    Serial.begin(SERIAL_DEBUG_BAUD);
+    #ifdef ARDUINO_ARCH_ESP32
+        Serial2.begin(SERIAL_BAUD, SERIAL_8N1, RXD2, TXD2);
+    #else
+        Serial2.begin(SERIAL_BAUD, SERIAL_8N1);
+    #endif
+
+    while(!Serial || !Serial2) {
+        delay(1000);
+    }
+    executor.spawn(readCycle());
+}
+
+void loop() {
+    // The queue moves the link along, the executor resumes whichever task got its reply.
+    cmdQueue.loop();
+    executor.loop();
+}
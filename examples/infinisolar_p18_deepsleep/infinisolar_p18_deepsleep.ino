@@ -0,0 +1,391 @@
+#include <WiFi.h>           // WiFi control for ESP32
+#include <ThingsBoard.h>    // ThingsBoard SDK
+#include <esp_sleep.h>
+#include "infinisolar_p18_deepsleep_defs.h" // Defs for various secrets, keys
+#include "InfiniCommandQueue.h"
+#include "InfiniResponseParser.h"
+#include "InfiniJsonWriter.h"
+#include "InfiniBinaryWriter.h"
+#include "InfiniDeltaTelemetry.h"
+#include "InfiniEnergyTracker.h"
+#include "InfiniClock.h"
+#include "InfiniTelemetryBatch.h"
+#include "InfiniGsHistory.h"
+#include "InfiniIdle.h"
+#include "InfiniTlsClient.h"
+#include "InfiniWiFiFast.h"
+
+// Duty cycled sampling for sites on solar power only. The ESP32 wakes every WAKE_PERIOD_MS, reads GS and ED,
+// keeps the GS sample in RTC memory and goes back to deep sleep. Only every FLUSH_EVERY_WAKES wakes,
+// or when the samples are about to overflow, WiFi and ThingsBoard are brought up to upload them.
+// Everything the library learnt, the clock model, the energy baselines and what the delta last published,
+// is kept in RTC memory as well, so a wake neither re-reads PIRI/DI nor has to sync T every time.
+
+using INFI::InfiniCommandSender;
+using INFI::InfiniCommandQueue;
+using INFI::InfiniResponseParser;
+
+#define RXD2 16
+#define TXD2 17
+
+const size_t MQTT_BUFFER_SZ = 1024;
+const size_t MAX_FIELDS_AMT = 16;
+// Baud rate for debug serial
+#define SERIAL_DEBUG_BAUD    115200
+
+const unsigned long WAKE_PERIOD_MS = 60000;
+const unsigned long FLUSH_EVERY_WAKES = 30;
+// Time allowed for the inverter queries of a wake, and for WiFi and ThingsBoard to come up.
+const unsigned long POLL_TIMEOUT_MS = 3000;
+const unsigned long WIFI_CONNECT_TIMEOUT_MS = 15000;
+// Shortest deep sleep, should a wake have taken longer than WAKE_PERIOD_MS.
+const unsigned long MIN_SLEEP_MS = 1000;
+// Local time of the inverter ahead of UTC, for the sample timestamps. India is +5.5 h.
+const long INVERTER_UTC_OFFSET_S = 19800;
+
+// GS samples kept over deep sleep, as BINARY_GS_SAMPLE records of 48 bytes. The RTC slow memory is 8 kB.
+const INFI::BYTE RTC_SAMPLES_SZ = 64;
+// Flush once fewer than this many slots are left, so a failed upload still has a few wakes to retry.
+const INFI::BYTE RTC_SAMPLES_MARGIN = 8;
+
+//! Everything that lives on from one wake to the next.
+struct SleepState {
+  unsigned long wakes;
+  //! The deep sleep that ended with this wake, to move the clock model on by.
+  unsigned long sleptMs;
+  INFI::ClockState clock;
+  INFI::EnergyTrackerState energy;
+  INFI::GeneralStatusDeltaState gsDelta;
+  //! GS settingsChanged as last seen, only its rising edge counts.
+  bool settingsChanged;
+  //! PIRI and DI have to be read again, done on the next flush.
+  bool configDue;
+  INFI::BYTE samples[RTC_SAMPLES_SZ][INFI::BINARY_GS_SAMPLE_SZ];
+  INFI::BYTE head;
+  INFI::BYTE count;
+  //! Samples overwritten because the uploads kept failing.
+  unsigned long dropped;
+  //! The TLS session of the last upload, resumed by the next one instead of a full handshake.
+  INFI::TlsSessionState tls;
+  //! The AP and lease of the last upload, connected to again without scanning.
+  INFI::WiFiFastState wifi;
+};
+RTC_DATA_ATTR SleepState sleepState;
+
+// MQTT over TLS on THINGSBOARD_TLS_PORT, or plain on 1883.
+const bool USE_TLS = true;
+// The root CA of the ThingsBoard server's certificate, in PEM. NULL connects without checking it.
+const char *const THINGSBOARD_ROOT_CA = NULL;
+// Reuse the last DHCP lease as a static IP on fast connects, only if the router always hands out the same one.
+const bool REUSE_DHCP_LEASE = false;
+// Initialize ThingsBoard client
+WiFiClient espClient;
+INFI::InfiniTlsClient tlsClient(sleepState.tls);
+INFI::InfiniWiFiFast wifiFast(sleepState.wifi);
+// Initialize ThingsBoard instance
+ThingsBoardSized<MQTT_BUFFER_SZ, MAX_FIELDS_AMT> tb(USE_TLS ? (Client &)tlsClient : (Client &)espClient);
+
+InfiniCommandSender cmdSender(Serial2, &Serial);
+INFI::InfiniRxRing rxRing;
+InfiniCommandQueue cmdQueue(cmdSender);
+InfiniResponseParser respParser;
+INFI::InfiniClock inverterClock;
+INFI::InfiniEnergyTracker energyTracker;
+INFI::GeneralStatusDelta gsDelta;
+// The stored samples go through here on upload, for its ThingsBoard JSON.
+INFI::InfiniGsHistory sampleChunk;
+
+// Read on flush wakes when configDue, uploaded after the samples.
+INFI::RatedInformation piri;
+INFI::DefaultValues di;
+bool hasPiri = false;
+bool hasDi = false;
+
+char telemetryJson[MQTT_BUFFER_SZ];
+// The MQTT header and topic take about 30 bytes of the client buffer.
+const size_t MQTT_OVERHEAD_SZ = 32;
+char batchJson[MQTT_BUFFER_SZ - MQTT_OVERHEAD_SZ];
+bool publishBatch(const char *json, void *context);
+INFI::InfiniTelemetryBatch telemetryBatch(batchJson, sizeof(batchJson), MAX_FIELDS_AMT, publishBatch);
+
+// Telemetry keys, passed as the context of the queued commands.
+char GEN_ENERGY_DAY_KEY[] = "gen_energy_day";
+char GEN_ENERGY_MONTH_KEY[] = "gen_energy_month";
+char GEN_ENERGY_YEAR_KEY[] = "gen_energy_year";
+
+bool publishBatch(const char *json, void *context) {
+  return tb.sendTelemetryJson(json);
+}
+
+// Appends a GS sample to the RTC ring, overwriting the oldest when it is full.
+void storeSample(const INFI::GeneralStatusFixed &gs, uint64_t tsMs) {
+  // One more for the null terminator InfiniBufferPrint keeps.
+  char record[INFI::BINARY_GS_SAMPLE_SZ + 1];
+  INFI::InfiniBufferPrint out(record, sizeof(record));
+  if (INFI::writeGsSampleBinary(gs, tsMs, out) != INFI::BINARY_GS_SAMPLE_SZ) {
+    return;
+  }
+  SleepState &s = sleepState;
+  if (s.count == RTC_SAMPLES_SZ) {
+    s.head = (s.head + 1) % RTC_SAMPLES_SZ;
+    s.count--;
+    s.dropped++;
+  }
+  memcpy(s.samples[(s.head + s.count) % RTC_SAMPLES_SZ], record, INFI::BINARY_GS_SAMPLE_SZ);
+  s.count++;
+}
+
+// Command queue callbacks
+void onEnergy(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  const char *key = (const char *)context;
+  if (status != INFI::SEND_COMPLETE) {
+    Serial.print("No reply for "); Serial.println(key);
+    return;
+  }
+  long energy = respParser.fromInfiniGenEnergyToULong(response.val, response.actualLen);
+  if (energy < 0) {
+    return;
+  }
+  if (response.cmdType == INFI::GEN_ENERGY_YEAR) {
+    energyTracker.onYear(energy);
+  } else if (response.cmdType == INFI::GEN_ENERGY_MONTH) {
+    energyTracker.onMonth(energy);
+  } else {
+    energyTracker.onDay(energy);
+  }
+}
+
+// Queues ED, and EY and EM for a new day, with the day from the clock model.
+void queueEnergy() {
+  char today[INFI::TIME_DAY_SZ + 1];
+  if (!inverterClock.getToday(today, millis())) {
+    return;
+  }
+  INFI::BYTE queries = energyTracker.onCurrentDay(today);
+  if (queries & INFI::ENERGY_QUERY_YEAR) {
+    cmdQueue.enqueue(INFI::GEN_ENERGY_YEAR, today, onEnergy, GEN_ENERGY_YEAR_KEY);
+  }
+  if (queries & INFI::ENERGY_QUERY_MONTH) {
+    cmdQueue.enqueue(INFI::GEN_ENERGY_MONTH, today, onEnergy, GEN_ENERGY_MONTH_KEY);
+  }
+  cmdQueue.enqueue(INFI::GEN_ENERGY_DAY, today, onEnergy, GEN_ENERGY_DAY_KEY);
+}
+
+void onCurrentTime(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || response.actualLen == 0
+      || respParser.fromILCurrentTimeToILCurrentDay(response.val, response.actualLen) == 0
+      || !inverterClock.sync(response.val + INFI::START_OFFSET_SZ, millis())) {
+    // The restored model is still good enough for the ED day, it is tried again next wake.
+    Serial.println("No valid current time response.");
+  } else {
+    Serial.print("Clock drift over the sleeps: "); Serial.println(inverterClock.lastDriftS());
+  }
+  queueEnergy();
+}
+
+void onGeneralStatus(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || !respParser.fromILGSToGeneralStatusFixed(response.val, response.actualLen)) {
+    Serial.println("No valid General Status response.");
+    return;
+  }
+  const INFI::GeneralStatusFixed &gs = respParser.generalStatusFixed;
+  if (inverterClock.isSynced()) {
+    storeSample(gs, inverterClock.unixMs(millis(), INVERTER_UTC_OFFSET_S));
+  }
+  if (gs.settingsChanged && !sleepState.settingsChanged) {
+    sleepState.configDue = true;
+  }
+  sleepState.settingsChanged = gs.settingsChanged;
+}
+
+void onConfig(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE) {
+    return;
+  }
+  if (response.cmdType == INFI::QUERY_RATED_INFORMATION) {
+    hasPiri = respParser.fromPIRIToRatedInformation(response.val, response.actualLen, piri);
+  } else {
+    hasDi = respParser.fromDIToDefaultValues(response.val, response.actualLen, di);
+  }
+}
+
+// Runs the queued commands until they are all done, or POLL_TIMEOUT_MS passed.
+void runQueue() {
+  unsigned long start = millis();
+  while ((cmdQueue.isBusy() || !cmdQueue.isEmpty()) && millis() - start < POLL_TIMEOUT_MS) {
+    cmdQueue.loop();
+    INFI::idleFor(cmdQueue.msUntilWork());
+  }
+}
+
+bool connect() {
+  unsigned long start = millis();
+  if (!wifiFast.connect(WIFI_AP_NAME, WIFI_PASSWORD, WIFI_CONNECT_TIMEOUT_MS)) {
+    Serial.println("Could not connect to AP");
+    return false;
+  }
+  Serial.print(wifiFast.isFast() ? "Reconnected to the last AP in " : "Connected to AP in ");
+  Serial.print(millis() - start); Serial.println(" ms");
+  // A scan found the AP anew, keep it for the first wake after a power cycle too.
+  if (!wifiFast.isFast()) {
+    INFI::saveWiFiFast(sleepState.wifi);
+  }
+  if (USE_TLS ? !tb.connect(THINGSBOARD_SERVER, THINGSBOARD_TOKEN, THINGSBOARD_TLS_PORT)
+              : !tb.connect(THINGSBOARD_SERVER, THINGSBOARD_TOKEN)) {
+    Serial.println("Failed to connect");
+    return false;
+  }
+  if (USE_TLS) {
+    Serial.print(tlsClient.isResumed() ? "TLS session resumed in " : "Full TLS handshake in ");
+    Serial.print(tlsClient.handshakeMs()); Serial.println(" ms");
+    // A new session is kept in NVS as well, for the first upload after a power cycle.
+    if (!tlsClient.isResumed()) {
+      INFI::saveTlsSession(sleepState.tls);
+    }
+  }
+  return true;
+}
+
+// Uploads the stored samples oldest first, as far as the uploads go through.
+// The delta only keeps its view of what was published for the chunks that went up.
+bool uploadSamples() {
+  SleepState &s = sleepState;
+  while (s.count > 0) {
+    // As many as the history holds are taken out of the ring per publish, up to an unreadable record.
+    sampleChunk.pop(sampleChunk.size());
+    INFI::GeneralStatusFixed gs;
+    uint64_t tsMs;
+    for (INFI::BYTE i = 0; i < s.count && sampleChunk.size() < sampleChunk.capacity(); ++i) {
+      if (!INFI::readGsSampleBinary(s.samples[(s.head + i) % RTC_SAMPLES_SZ], INFI::BINARY_GS_SAMPLE_SZ, gs, tsMs)) {
+        break;
+      }
+      sampleChunk.push(gs, tsMs);
+    }
+    INFI::BYTE consumed = 1;
+    if (!sampleChunk.isEmpty()) {
+      INFI::GeneralStatusDelta delta = gsDelta;
+      INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+      consumed = sampleChunk.writeJson(json, delta, sizeof(batchJson) - 1);
+      if (consumed == 0) {
+        return false;
+      }
+      if (json.length() > 2 && !tb.sendTelemetryJson(telemetryJson)) {
+        Serial.println("Could not upload the GS samples to Thingsboard");
+        return false;
+      }
+      gsDelta = delta;
+    }
+    // With nothing readable at the head, that record is dropped.
+    s.head = (s.head + consumed) % RTC_SAMPLES_SZ;
+    s.count -= consumed;
+  }
+  return true;
+}
+
+// Uploads the samples, the energy counters and any freshly read config.
+void flush() {
+  if (!connect()) {
+    return;
+  }
+  if (!uploadSamples()) {
+    return;
+  }
+  if (energyTracker.hasDay()) {
+    telemetryBatch.addInt(GEN_ENERGY_DAY_KEY, energyTracker.day());
+  }
+  if (energyTracker.hasMonth()) {
+    telemetryBatch.addInt(GEN_ENERGY_MONTH_KEY, energyTracker.month());
+  }
+  if (energyTracker.hasYear()) {
+    telemetryBatch.addInt(GEN_ENERGY_YEAR_KEY, energyTracker.year());
+  }
+  if (sleepState.dropped > 0) {
+    telemetryBatch.addInt("samples_dropped", sleepState.dropped);
+  }
+  if (hasPiri) {
+    INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+    INFI::writeRatedInformationJson(piri, json);
+    telemetryBatch.addJson(telemetryJson);
+  }
+  if (hasDi) {
+    INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+    INFI::writeDefaultValuesJson(di, json);
+    telemetryBatch.addJson(telemetryJson);
+  }
+  if (telemetryBatch.flush() && hasPiri && hasDi) {
+    sleepState.configDue = false;
+  }
+  tb.disconnect();
+}
+
+void setup() {
+  Serial.begin(SERIAL_DEBUG_BAUD);
+  Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1, RXD2, TXD2);
+  INFI::attachRxRing(Serial2, rxRing);
+  cmdSender.useRxRing(&rxRing);
+  tlsClient.setCACert(THINGSBOARD_ROOT_CA);
+  wifiFast.setReuseLease(REUSE_DHCP_LEASE);
+
+  SleepState &s = sleepState;
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) {
+    // Power on or reset, RTC memory holds nothing of ours. Read everything once.
+    memset(&s, 0, sizeof(s));
+    s.configDue = true;
+    if (USE_TLS) {
+      INFI::loadTlsSession(s.tls);
+    }
+    INFI::loadWiFiFast(s.wifi);
+  } else {
+    inverterClock.restoreState(s.clock, s.sleptMs + millis(), millis());
+    energyTracker.restoreState(s.energy);
+    gsDelta.restoreState(s.gsDelta);
+  }
+  s.wakes++;
+
+  // Deadbands are set up on every boot, they are not part of the saved state.
+  gsDelta.setDeadband(INFI::GS_BATT_VOLT, 2);        // 0.2 V
+  gsDelta.setDeadband(INFI::GS_GRID_VOLT, 20);       // 2 V
+  gsDelta.setDeadband(INFI::GS_AC_OUT_VOLT, 20);     // 2 V
+  gsDelta.setDeadband(INFI::GS_PV1_IN_VOLT, 20);     // 2 V
+  gsDelta.setDeadband(INFI::GS_PV2_IN_VOLT, 20);     // 2 V
+  gsDelta.setDeadband(INFI::GS_PV1_IN_POW, 20);
+  gsDelta.setDeadband(INFI::GS_PV2_IN_POW, 20);
+
+  bool flushing = s.wakes == 1 || s.wakes % FLUSH_EVERY_WAKES == 0 || s.count >= RTC_SAMPLES_SZ - RTC_SAMPLES_MARGIN;
+
+  // T only to resync the model, the RTC slow clock the sleeps are timed by drifts by a few percent.
+  // ED/EM/EY follow once the day is known, from the T callback.
+  if (!inverterClock.isSynced() || inverterClock.msSinceSync(millis()) >= inverterClock.resyncPeriodMs()) {
+    cmdQueue.enqueue(INFI::CURRENT_TIME, NULL, onCurrentTime);
+  } else {
+    queueEnergy();
+  }
+  cmdQueue.enqueue(INFI::GENERAL_STATUS, NULL, onGeneralStatus);
+  runQueue();
+
+  // Config type queries only when uploading, after a reboot or a change of settings.
+  if (flushing && s.configDue) {
+    cmdQueue.enqueue(INFI::QUERY_RATED_INFORMATION, NULL, onConfig);
+    cmdQueue.enqueue(INFI::QUERY_DEFAULT_VALUE, NULL, onConfig);
+    runQueue();
+  }
+  if (flushing) {
+    flush();
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+  }
+
+  unsigned long awakeMs = millis();
+  s.sleptMs = awakeMs + MIN_SLEEP_MS < WAKE_PERIOD_MS ? WAKE_PERIOD_MS - awakeMs : MIN_SLEEP_MS;
+  inverterClock.saveState(s.clock, awakeMs);
+  energyTracker.saveState(s.energy);
+  gsDelta.saveState(s.gsDelta);
+  Serial.print("Sleeping for "); Serial.print(s.sleptMs); Serial.print(" ms, samples stored: "); Serial.println(s.count);
+  Serial.flush();
+  esp_sleep_enable_timer_wakeup((uint64_t)s.sleptMs * 1000ULL);
+  esp_deep_sleep_start();
+}
+
+void loop() {
+  // Never reached, every wake ends in deep sleep from setup().
+}
@@ -0,0 +1,16 @@
+#ifndef INFINISOLAR_P18_DEEPSLEEP_DEFS_H
+#define INFINISOLAR_P18_DEEPSLEEP_DEFS_H
+
+// WiFi access point
+#define WIFI_AP_NAME        "wifi_ssid"
+// WiFi password
+#define WIFI_PASSWORD       "password"
+
+// ThingsBoard Device Access token
+#define THINGSBOARD_TOKEN   "device_access_token"
+// ThingsBoard server instance.
+#define THINGSBOARD_SERVER  "your.thingsboard.address"
+// Port of its MQTT over TLS.
+#define THINGSBOARD_TLS_PORT 8883
+
+#endif
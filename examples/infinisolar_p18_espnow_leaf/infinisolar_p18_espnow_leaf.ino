@@ -0,0 +1,62 @@
+#include "infinisolar_p18_espnow_leaf_defs.h" // Defs for the gateway and the radio
+#include "InfiniPollScheduler.h"
+#include "InfiniResponseParser.h"
+#include "InfiniEspNow.h"
+#include "InfiniIdle.h"
+
+// An inverter without a WiFi network of its own in reach, or one of many on a site where a TCP/IP stack,
+// DHCP lease and MQTT session per inverter cost more than the readings. GS is read every GS_PERIOD and relayed
+// over ESP-NOW to the ESP32 running infinisolar_p18_gateway, which publishes it as one of its devices.
+
+using INFI::InfiniCommandSender;
+using INFI::InfiniCommandQueue;
+using INFI::InfiniPollScheduler;
+using INFI::InfiniResponseParser;
+
+#define RXD2 16
+#define TXD2 17
+
+// Baud rate for debug serial
+#define SERIAL_DEBUG_BAUD    115200
+
+const unsigned long GS_PERIOD = 5000;
+const INFI::BYTE gatewayMac[6] = GATEWAY_MAC;
+
+InfiniCommandSender cmdSender(Serial2, &Serial);
+InfiniCommandQueue cmdQueue(cmdSender);
+InfiniPollScheduler pollScheduler(cmdQueue);
+InfiniResponseParser respParser;
+INFI::InfiniEspNowLeaf leaf(gatewayMac, NODE_ID);
+
+void onGeneralStatus(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || response.actualLen != INFI::getResponseSize(INFI::GENERAL_STATUS) ||
+      !respParser.fromILGSToGeneralStatusFixed(response.val, response.actualLen)) {
+    Serial.println("Malformed General Status response.");
+    return;
+  }
+  if (!leaf.queue(respParser.generalStatusFixed, millis())) {
+    Serial.println("Gateway out of reach, dropped the oldest sample.");
+  }
+}
+
+unsigned long earliest(unsigned long a, unsigned long b) {
+  return a < b ? a : b;
+}
+
+void setup() {
+  Serial.begin(SERIAL_DEBUG_BAUD);
+  Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1, RXD2, TXD2);
+
+  pollScheduler.addPeriodic(INFI::GENERAL_STATUS, GS_PERIOD, onGeneralStatus);
+  if (!leaf.begin(ESPNOW_CHANNEL)) {
+    Serial.println("Could not start ESP-NOW.");
+  }
+}
+
+void loop() {
+  pollScheduler.loop();
+  const unsigned long now = millis();
+  leaf.loop(now);
+  // Replies from the inverter and acknowledgements from the gateway wake the loop early.
+  INFI::idleFor(earliest(pollScheduler.msUntilDue(), leaf.msUntilWork(now)));
+}
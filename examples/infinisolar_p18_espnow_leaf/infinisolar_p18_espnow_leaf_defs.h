@@ -0,0 +1,11 @@
+#ifndef INFINISOLAR_P18_ESPNOW_LEAF_DEFS_H
+#define INFINISOLAR_P18_ESPNOW_LEAF_DEFS_H
+
+// Station MAC of the ESP32 running infinisolar_p18_gateway, as printed at its startup.
+#define GATEWAY_MAC         { 0x24, 0x6F, 0x28, 0x00, 0x00, 0x00 }
+// WiFi channel of the gateway's access point, the leaf has no AP to learn it from.
+#define ESPNOW_CHANNEL      1
+// This leaf's node id, unique per gateway. It is published as "Leaf <id + 1>".
+#define NODE_ID             0
+
+#endif
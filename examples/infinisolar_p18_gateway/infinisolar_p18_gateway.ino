@@ -0,0 +1,229 @@
+#include <WiFi.h>           // WiFi control for ESP32
+#include <PubSubClient.h>   // Plain MQTT, the gateway API needs its own topics
+#include <sys/time.h>       // The NTP clock, for the timestamps of relayed samples
+#include "infinisolar_p18_gateway_defs.h" // Defs for various secrets, keys
+#include "InfiniPollScheduler.h"
+#include "InfiniResponseParser.h"
+#include "InfiniJsonWriter.h"
+#include "InfiniSetter.h"
+#include "InfiniGateway.h"
+#include "InfiniEspNow.h"
+
+using INFI::InfiniCommandSender;
+using INFI::InfiniCommandQueue;
+using INFI::InfiniPollScheduler;
+using INFI::InfiniResponseParser;
+
+// Baud rate for debug serial
+#define SERIAL_DEBUG_BAUD    115200
+
+// One inverter per RS232 port, all of them published over the one MQTT session of the gateway.
+// The device id of each sender is its index in queues and DEVICE_NAMES. Build with
+// -DINFI_POLL_SCHEDULER_DEVICES=2, or as many as there are ports, for the scheduler to take them all.
+const INFI::BYTE NUM_INVERTERS = 2;
+// Inverters of infinisolar_p18_espnow_leaf nodes relayed over ESP-NOW follow them, leaf NODE_ID n is
+// device NUM_INVERTERS + n.
+const INFI::BYTE NUM_LEAVES = 2;
+const INFI::BYTE NUM_DEVICES = NUM_INVERTERS + NUM_LEAVES;
+const char *const DEVICE_NAMES[NUM_DEVICES] = { "Inverter A", "Inverter B", "Leaf 1", "Leaf 2" };
+const char DEVICE_TYPE[] = "InfiniSolar P18";
+
+InfiniCommandSender senderA(Serial2, &Serial);
+InfiniCommandSender senderB(Serial1, &Serial);
+InfiniCommandQueue queueA(senderA);
+InfiniCommandQueue queueB(senderB);
+INFI::InfiniSetter setterA(queueA, senderA);
+INFI::InfiniSetter setterB(queueB, senderB);
+InfiniCommandSender *senders[NUM_INVERTERS] = { &senderA, &senderB };
+InfiniCommandQueue *queues[NUM_INVERTERS] = { &queueA, &queueB };
+INFI::InfiniSetter *setters[NUM_INVERTERS] = { &setterA, &setterB };
+InfiniPollScheduler pollScheduler(queueA);
+InfiniResponseParser respParser;
+
+// The machine the RPC settings are addressed to, within each inverter's parallel system.
+const INFI::BYTE PARALLEL_MACHINE = 0;
+
+WiFiClient espClient;
+PubSubClient mqtt(espClient);
+const size_t MQTT_BUFFER_SZ = 1024;
+// Header and topic of a publish, the rest of the client's buffer is for the payload.
+const size_t MQTT_OVERHEAD_SZ = 32;
+char gatewayJson[MQTT_BUFFER_SZ - MQTT_OVERHEAD_SZ];
+bool publishGateway(const char *topic, const char *payload, void *context);
+INFI::InfiniGateway gateway(gatewayJson, sizeof(gatewayJson), DEVICE_NAMES, NUM_DEVICES, publishGateway);
+void onLeafSample(INFI::BYTE nodeId, const INFI::GeneralStatusFixed &gs, unsigned long ageMs, void *context);
+INFI::InfiniEspNowGateway espNowGateway(onLeafSample);
+
+// GS of every inverter is read every GS_PERIOD, and what was gathered goes out in one message every UPLOAD_PERIOD.
+const unsigned long GS_PERIOD = 5000;
+const unsigned long UPLOAD_PERIOD = 15000;
+unsigned long lastUploadMs = 0;
+// One inverter's GS JSON, handed to the gateway as soon as it is written.
+char sampleJson[512];
+
+const unsigned long RECONNECT_PERIOD = 5000;
+unsigned long lastConnectAttemptMs = 0;
+
+bool publishGateway(const char *topic, const char *payload, void *context) {
+  if (mqtt.publish(topic, payload)) {
+    return true;
+  }
+  Serial.print("Could not publish on ");
+  Serial.println(topic);
+  return false;
+}
+
+void onGeneralStatus(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || response.actualLen != INFI::getResponseSize(INFI::GENERAL_STATUS) ||
+      !respParser.fromILGSToGeneralStatusFixed(response.val, response.actualLen)) {
+    Serial.println("Malformed General Status response.");
+    return;
+  }
+  INFI::InfiniBufferPrint json(sampleJson, sizeof(sampleJson));
+  INFI::writeGeneralStatusJson(respParser.generalStatusFixed, json);
+  // The scheduler polls the inverters one after the other, so each one's samples stay together.
+  if (!gateway.addTelemetry(response.deviceId, sampleJson)) {
+    Serial.println("Could not add telemetry.");
+  }
+}
+
+// Milliseconds since the Unix epoch by NTP, 0 until it synced.
+unsigned long long nowUnixMs() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  // Anything before 2020 is the clock still counting from boot.
+  if (tv.tv_sec < 1577836800L) {
+    return 0;
+  }
+  return (unsigned long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+void onLeafSample(INFI::BYTE nodeId, const INFI::GeneralStatusFixed &gs, unsigned long ageMs, void *context) {
+  if (nodeId >= NUM_LEAVES) {
+    Serial.println("Sample of an unknown leaf.");
+    return;
+  }
+  INFI::InfiniBufferPrint json(sampleJson, sizeof(sampleJson));
+  INFI::writeGeneralStatusJson(gs, json);
+  // A leaf's samples arrive a frame at a time, so they stay together like the inverters'. Stamped with when
+  // they were taken, which may be minutes ago if the leaf could not reach us, unless NTP has not synced yet.
+  const unsigned long long now = nowUnixMs();
+  if (!gateway.addTelemetry(NUM_INVERTERS + nodeId, sampleJson, now > 0 ? now - ageMs : 0)) {
+    Serial.println("Could not add telemetry.");
+  }
+}
+
+// The gateway RPCs that set one value, e.g. {"method":"setMaxChargingCurrent","params":30} for one device.
+struct RpcBinding {
+  const char *method;
+  INFI::COMMAND_TYPE commandType;
+};
+
+const RpcBinding RPC_BINDINGS[] = {
+  { "setMaxChargingCurrent",     INFI::SET_MAX_CHARGING_CURRENT     },
+  { "setMaxACChargingCurrent",   INFI::SET_MAX_AC_CHARGING_CURRENT  },
+  { "setOutputSourcePriority",   INFI::SET_OUTPUT_SOURCE_PRIORITY   },
+  { "setChargingSourcePriority", INFI::SET_CHARGING_SOURCE_PRIORITY },
+  { "setSolarPowerPriority",     INFI::SET_SOLAR_POWER_PRIORITY     },
+  { "setBatteryType",            INFI::SET_BATTERY_TYPE             }
+};
+
+void onRpcSetting(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  const RpcBinding &binding = *(const RpcBinding *)context;
+  Serial.print(DEVICE_NAMES[response.deviceId]); Serial.print(": "); Serial.print(binding.method);
+  Serial.println(status == INFI::SEND_COMPLETE && response.error == INFI::RESP_OK ? " accepted" : " not accepted");
+}
+
+// Checks the value and queues it on the queue of device, the reply echoes it, or -1 if it was invalid.
+bool handleRpc(INFI::BYTE device, const char *method, JsonVariantConst params, JsonObject result, void *context) {
+  if (device >= NUM_INVERTERS) {
+    // The leaves only send.
+    return false;
+  }
+  for (const RpcBinding &binding : RPC_BINDINGS) {
+    if (strcmp(binding.method, method) != 0) {
+      continue;
+    }
+    char cmdParams[INFI::MAX_PARAMS_SZ];
+    int value = params.is<int>() ? params.as<int>() : -1;
+    if (value < 0 || !setters[device]->makeParams(binding.commandType, PARALLEL_MACHINE, value, cmdParams) ||
+        !queues[device]->enqueue(binding.commandType, cmdParams, onRpcSetting, (void *)&binding)) {
+      value = -1;
+    }
+    result[method] = value;
+    return true;
+  }
+  return false;
+}
+
+void onMqttMessage(char *topic, byte *payload, unsigned int length) {
+  if (strcmp(topic, INFI::GATEWAY_RPC_TOPIC) == 0 &&
+      !gateway.handleRpc((const char *)payload, length, handleRpc)) {
+    Serial.println("Malformed gateway RPC.");
+  }
+}
+
+bool connectGateway() {
+  if (!mqtt.connect("infinisolar-gateway", GATEWAY_TOKEN, NULL)) {
+    return false;
+  }
+  mqtt.subscribe(INFI::GATEWAY_RPC_TOPIC);
+  for (INFI::BYTE d = 0; d < NUM_DEVICES; ++d) {
+    gateway.connectDevice(d, DEVICE_TYPE);
+  }
+  return true;
+}
+
+void setup() {
+  Serial.begin(SERIAL_DEBUG_BAUD);
+  Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1, 16, 17);
+  Serial1.begin(INFI::SERIAL_BAUD, SERIAL_8N1, 26, 27);
+
+  for (INFI::BYTE d = 0; d < NUM_INVERTERS; ++d) {
+    senders[d]->setDeviceId(d);
+    if (d > 0) {
+      pollScheduler.addDevice(*queues[d]);
+    }
+  }
+  pollScheduler.addPeriodic(INFI::GENERAL_STATUS, GS_PERIOD, onGeneralStatus);
+
+  WiFi.mode(WIFI_STA);
+  // ESP-NOW frames that arrive while the radio dozes are lost.
+  WiFi.setSleep(false);
+  WiFi.begin(WIFI_AP_NAME, WIFI_PASSWORD);
+  Serial.print("Gateway MAC for the leaves: ");
+  Serial.println(WiFi.macAddress());
+  if (!espNowGateway.begin()) {
+    Serial.println("Could not start ESP-NOW.");
+  }
+  configTime(0, 0, "pool.ntp.org");
+  mqtt.setServer(THINGSBOARD_SERVER, THINGSBOARD_PORT);
+  mqtt.setBufferSize(MQTT_BUFFER_SZ);
+  mqtt.setCallback(onMqttMessage);
+}
+
+void loop() {
+  // Queue whichever GS reads are due and advance every link without blocking, whatever the network does.
+  pollScheduler.loop();
+
+  if (WiFi.status() != WL_CONNECTED) {
+    return;
+  }
+  if (!mqtt.connected()) {
+    if (millis() - lastConnectAttemptMs < RECONNECT_PERIOD) {
+      return;
+    }
+    lastConnectAttemptMs = millis();
+    if (!connectGateway()) {
+      Serial.println("Could not connect to ThingsBoard as a gateway.");
+      return;
+    }
+  }
+  mqtt.loop();
+  // Only acknowledged while ThingsBoard is reachable, until then the leaves hold on to their samples.
+  espNowGateway.loop();
+  if (millis() - lastUploadMs >= UPLOAD_PERIOD) {
+    lastUploadMs = millis();
+    gateway.flush();
+  }
+}
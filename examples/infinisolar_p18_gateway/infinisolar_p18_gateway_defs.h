@@ -0,0 +1,15 @@
+#ifndef INFINISOLAR_P18_GATEWAY_DEFS_H
+#define INFINISOLAR_P18_GATEWAY_DEFS_H
+
+// WiFi access point
+#define WIFI_AP_NAME        "wifi_ssid"
+// WiFi password
+#define WIFI_PASSWORD       "password"
+
+// Access token of the ThingsBoard device created as a gateway, the inverters become its devices.
+#define GATEWAY_TOKEN       "gateway_access_token"
+// ThingsBoard server instance.
+#define THINGSBOARD_SERVER  "your.thingsboard.address"
+#define THINGSBOARD_PORT    1883
+
+#endif
@@ -0,0 +1,103 @@
+#include <WiFi.h>                 // WiFi control for ESP32
+#include <ArduinoHttpClient.h>    // HTTP/1.1 with keep-alive and chunked requests
+#include "infinisolar_p18_influx_defs.h" // Defs for various secrets, keys
+#include "InfiniPollScheduler.h"
+#include "InfiniResponseParser.h"
+#include "InfiniClock.h"
+#include "InfiniInflux.h"
+
+using INFI::InfiniCommandSender;
+using INFI::InfiniCommandQueue;
+using INFI::InfiniPollScheduler;
+using INFI::InfiniResponseParser;
+
+// Baud rate for debug serial
+#define SERIAL_DEBUG_BAUD    115200
+
+const char DEVICE_NAME[] = "inverter0";
+
+InfiniCommandSender cmdSender(Serial2, &Serial);
+InfiniCommandQueue cmdQueue(cmdSender);
+InfiniPollScheduler pollScheduler(cmdQueue);
+InfiniResponseParser respParser;
+
+// The inverter's clock timestamps the samples, T is only polled to resync it.
+INFI::InfiniClock inverterClock;
+// How far the inverter's local time is ahead of UTC, e.g. 19800 for India.
+const long INVERTER_UTC_OFFSET_S = 19800;
+// GS is sampled every GS_PERIOD and the samples go to InfluxDB in batches every UPLOAD_PERIOD.
+// What InfluxDB misses while unreachable waits in the history, a day of it with PSRAM.
+const unsigned long GS_PERIOD = 5000;
+const unsigned long UPLOAD_PERIOD = 60000;
+const unsigned long GS_HISTORY_PSRAM_SZ = 24UL * 3600 * 1000 / GS_PERIOD;
+INFI::InfiniGsHistory gsHistory;
+unsigned long lastUploadMs = 0;
+
+// One connection for every upload, kept open between them.
+WiFiClient wifiClient;
+HttpClient http(wifiClient, INFLUX_HOST, INFLUX_PORT);
+INFI::InfiniInfluxWriter influx(http, INFLUX_PATH, INFLUX_AUTH);
+// Line protocol is repetitive, gzip shrinks a batch several times over for the cost of the deflate window.
+INFI::InfiniDeflatePrint deflate(http, INFI::DEFLATE_GZIP);
+
+void onCurrentTime(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || respParser.fromILCurrentTimeToILCurrentDay(response.val, response.actualLen) == 0
+      || !inverterClock.sync(response.val + INFI::START_OFFSET_SZ, millis())) {
+    Serial.println("Malformed current time response.");
+    return;
+  }
+  pollScheduler.setPeriod(INFI::CURRENT_TIME, inverterClock.resyncPeriodMs());
+}
+
+void onGeneralStatus(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || response.actualLen != INFI::getResponseSize(INFI::GENERAL_STATUS) ||
+      !respParser.fromILGSToGeneralStatusFixed(response.val, response.actualLen)) {
+    Serial.println("Malformed General Status response.");
+    return;
+  }
+  // Without the time there is nothing to put on the point.
+  if (inverterClock.isSynced()) {
+    gsHistory.push(respParser.generalStatusFixed, inverterClock.unixMs(millis(), INVERTER_UTC_OFFSET_S));
+  }
+}
+
+void uploadHistory() {
+  while (!gsHistory.isEmpty()) {
+    unsigned long sent = influx.post(gsHistory, DEVICE_NAME);
+    if (sent == 0) {
+      Serial.print("InfluxDB write failed: "); Serial.println(influx.lastStatus());
+      return;
+    }
+    gsHistory.pop(sent);
+    Serial.printf("Wrote %lu points, %lu bytes as %lu gzipped\n", sent, influx.lastBytesIn(), influx.lastBytesOut());
+    // Let the inverter's replies in between the batches of a backlog.
+    pollScheduler.loop();
+  }
+}
+
+void setup() {
+  Serial.begin(SERIAL_DEBUG_BAUD);
+  Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1, 16, 17);
+
+  if (!gsHistory.allocate(GS_HISTORY_PSRAM_SZ)) {
+    Serial.println("No PSRAM, keeping the small GS history.");
+  }
+  influx.setCompression(&deflate);
+  pollScheduler.addPeriodic(INFI::CURRENT_TIME, INFI::CLOCK_RESYNC_MS, onCurrentTime);
+  pollScheduler.addPeriodic(INFI::GENERAL_STATUS, GS_PERIOD, onGeneralStatus);
+
+  WiFi.begin(WIFI_AP_NAME, WIFI_PASSWORD);
+}
+
+void loop() {
+  // Sampling goes on whatever the network does, the samples wait in gsHistory.
+  pollScheduler.loop();
+
+  if (WiFi.status() != WL_CONNECTED) {
+    return;
+  }
+  if (millis() - lastUploadMs >= UPLOAD_PERIOD) {
+    lastUploadMs = millis();
+    uploadHistory();
+  }
+}
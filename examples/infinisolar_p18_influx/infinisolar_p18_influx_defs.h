@@ -0,0 +1,17 @@
+#ifndef INFINISOLAR_P18_INFLUX_DEFS_H
+#define INFINISOLAR_P18_INFLUX_DEFS_H
+
+// WiFi access point
+#define WIFI_AP_NAME        "wifi_ssid"
+// WiFi password
+#define WIFI_PASSWORD       "password"
+
+// InfluxDB server instance.
+#define INFLUX_HOST         "your.influxdb.address"
+#define INFLUX_PORT         8086
+// The write endpoint with its bucket, for InfluxDB 1.x "/write?db=solar&precision=ns".
+#define INFLUX_PATH         "/api/v2/write?org=home&bucket=solar&precision=ns"
+// Value of the Authorization header, an API token allowed to write the bucket.
+#define INFLUX_AUTH         "Token your_api_token"
+
+#endif
@@ -0,0 +1,149 @@
+#include "infinisolar_p18_lora_defs.h" // Defs for the LoRaWAN keys
+#include "InfiniPollScheduler.h"
+#include "InfiniResponseParser.h"
+#include "InfiniClock.h"
+#include "InfiniLoRa.h"
+#include "InfiniIdle.h"
+
+// A site with neither WiFi nor cellular coverage. GS and FWS are polled as usual, but only go out as a
+// 19 byte rollup every UPLINK_PERIOD over LoRaWAN, through a RAK3172, or any modem with the RUI3 AT commands,
+// on Serial1. The network server unpacks it with the layout in InfiniLoRa.h.
+
+using INFI::InfiniCommandSender;
+using INFI::InfiniCommandQueue;
+using INFI::InfiniPollScheduler;
+using INFI::InfiniResponseParser;
+
+// Baud rate for debug serial
+#define SERIAL_DEBUG_BAUD    115200
+
+#define MODEM_RX        26
+#define MODEM_TX        27
+const unsigned long MODEM_BAUD = 115200;
+// The spreading factor of the data rate set in setup(), DR3 in EU868.
+const INFI::BYTE LORAWAN_SF = 9;
+
+InfiniCommandSender cmdSender(Serial2, &Serial);
+InfiniCommandQueue cmdQueue(cmdSender);
+InfiniPollScheduler pollScheduler(cmdQueue);
+InfiniResponseParser respParser;
+// For the day the ED param needs.
+INFI::InfiniClock inverterClock;
+
+const unsigned long GS_PERIOD = 10000;
+const unsigned long FWS_PERIOD = 30000;
+const unsigned long UPLINK_PERIOD = 5UL * 60 * 1000;
+// ED is read once per uplink, shortly before it, so the rollup has the energy of the day so far.
+const unsigned long ENERGY_LEAD_MS = 20000;
+unsigned long energyQueuedMs = 0;
+
+bool sendToModem(const INFI::BYTE *payload, INFI::BYTE len, void *context);
+INFI::InfiniLoRaUplink uplink(sendToModem);
+
+// Sends payload unconfirmed as AT+SEND=<port>:<hex>, the modem answers OK once it took it.
+bool sendToModem(const INFI::BYTE *payload, INFI::BYTE len, void *context) {
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+  Serial1.print("AT+SEND=");
+  Serial1.print(LORAWAN_PORT);
+  Serial1.print(':');
+  for (INFI::BYTE i = 0; i < len; ++i) {
+    Serial1.write(HEX_DIGITS[payload[i] >> 4]);
+    Serial1.write(HEX_DIGITS[payload[i] & 0x0F]);
+  }
+  Serial1.print("\r\n");
+  Serial1.setTimeout(1000);
+  return Serial1.find((char *)"OK");
+}
+
+// Sends an AT command and waits for its OK.
+bool modemCommand(const char *command) {
+  Serial1.print(command);
+  Serial1.print("\r\n");
+  Serial1.setTimeout(1000);
+  return Serial1.find((char *)"OK");
+}
+
+void onCurrentTime(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || respParser.fromILCurrentTimeToILCurrentDay(response.val, response.actualLen) == 0
+      || !inverterClock.sync(response.val + INFI::START_OFFSET_SZ, millis())) {
+    Serial.println("Malformed current time response.");
+    return;
+  }
+  pollScheduler.setPeriod(INFI::CURRENT_TIME, inverterClock.resyncPeriodMs());
+}
+
+void onGeneralStatus(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || response.actualLen != INFI::getResponseSize(INFI::GENERAL_STATUS) ||
+      !respParser.fromILGSToGeneralStatusFixed(response.val, response.actualLen)) {
+    Serial.println("Malformed General Status response.");
+    return;
+  }
+  uplink.add(respParser.generalStatusFixed);
+}
+
+void onFaultWarningStatus(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  INFI::FaultWarningStatus fws;
+  if (status != INFI::SEND_COMPLETE || !respParser.fromFWSToFaultWarningStatus(response.val, response.actualLen, fws)) {
+    Serial.println("Malformed fws response.");
+    return;
+  }
+  uplink.addFaults(fws);
+}
+
+void onEnergyDay(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  long energy = status == INFI::SEND_COMPLETE ? respParser.fromInfiniGenEnergyToULong(response.val, response.actualLen) : -1;
+  if (energy >= 0) {
+    uplink.setEnergyToday(energy);
+  }
+}
+
+unsigned long earliest(unsigned long a, unsigned long b) {
+  return a < b ? a : b;
+}
+
+void setup() {
+  Serial.begin(SERIAL_DEBUG_BAUD);
+  Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1, 16, 17);
+  Serial1.begin(MODEM_BAUD, SERIAL_8N1, MODEM_RX, MODEM_TX);
+
+  // LoRaWAN, OTAA, unconfirmed uplinks at a fixed data rate, so the airtime below holds.
+  modemCommand("AT+NWM=1");
+  modemCommand("AT+NJM=1");
+  modemCommand("AT+DEVEUI=" LORAWAN_DEVEUI);
+  modemCommand("AT+APPEUI=" LORAWAN_APPEUI);
+  modemCommand("AT+APPKEY=" LORAWAN_APPKEY);
+  modemCommand("AT+ADR=0");
+  // SF9 at 125 kHz in EU868.
+  modemCommand("AT+DR=3");
+  // Joins in the background and keeps retrying, sends fail until it did.
+  if (!modemCommand("AT+JOIN=1:0:10:8")) {
+    Serial.println("The LoRaWAN modem does not answer.");
+  }
+
+  uplink.setPeriod(UPLINK_PERIOD);
+  // 13 bytes of LoRaWAN header, port and MIC go with every payload.
+  uplink.setRadio(LORAWAN_SF, 125, 13);
+  Serial.print("Time on air per uplink: "); Serial.print(uplink.airtimeMs()); Serial.println(" ms");
+
+  pollScheduler.addPeriodic(INFI::CURRENT_TIME, INFI::CLOCK_RESYNC_MS, onCurrentTime);
+  pollScheduler.addPeriodic(INFI::GENERAL_STATUS, GS_PERIOD, onGeneralStatus);
+  pollScheduler.addPeriodic(INFI::FAULT_WARNING_STATUS, FWS_PERIOD, onFaultWarningStatus);
+}
+
+void loop() {
+  pollScheduler.loop();
+  const unsigned long now = millis();
+  const unsigned long untilUplink = uplink.msUntilWork(now);
+  char today[INFI::TIME_DAY_SZ + 1];
+  if (untilUplink <= ENERGY_LEAD_MS && now - energyQueuedMs >= ENERGY_LEAD_MS * 2 &&
+      inverterClock.getToday(today, now)) {
+    energyQueuedMs = now;
+    cmdQueue.enqueue(INFI::GEN_ENERGY_DAY, today, onEnergyDay);
+  }
+  uplink.loop(now);
+  unsigned long wait = earliest(pollScheduler.msUntilDue(), uplink.msUntilWork(now));
+  if (untilUplink > ENERGY_LEAD_MS) {
+    wait = earliest(wait, untilUplink - ENERGY_LEAD_MS);
+  }
+  INFI::idleFor(wait);
+}
@@ -0,0 +1,11 @@
+#ifndef INFINISOLAR_P18_LORA_DEFS_H
+#define INFINISOLAR_P18_LORA_DEFS_H
+
+// The keys of the LoRaWAN network server's device, for OTAA, as hex.
+#define LORAWAN_DEVEUI      "0000000000000000"
+#define LORAWAN_APPEUI      "0000000000000000"
+#define LORAWAN_APPKEY      "00000000000000000000000000000000"
+// The LoRaWAN port the rollups go out on, the decoder on the server side is attached to it.
+#define LORAWAN_PORT        2
+
+#endif
@@ -0,0 +1,134 @@
+#include <WiFi.h>           // WiFi control for ESP32
+#include <PubSubClient.h>   // Plain MQTT, for a broker on the LAN
+#include <LittleFS.h>       // Keeps the samples taken while offline
+#include <sys/time.h>
+#include "infinisolar_p18_mqtt_defs.h" // Defs for various secrets, keys
+#include "InfiniPollScheduler.h"
+#include "InfiniResponseParser.h"
+#include "InfiniCorkClient.h"
+#include "InfiniFieldTopics.h"
+#include "InfiniTelemetryLog.h"
+
+using INFI::InfiniCommandSender;
+using INFI::InfiniCommandQueue;
+using INFI::InfiniPollScheduler;
+using INFI::InfiniResponseParser;
+
+// Baud rate for debug serial
+#define SERIAL_DEBUG_BAUD    115200
+
+InfiniCommandSender cmdSender(Serial2, &Serial);
+InfiniCommandQueue cmdQueue(cmdSender);
+InfiniPollScheduler pollScheduler(cmdQueue);
+InfiniResponseParser respParser;
+
+// Each sample is a few publishes of the fields that moved, corked so they leave in one TCP segment.
+WiFiClient wifiClient;
+INFI::InfiniCorkClient corkClient(wifiClient);
+PubSubClient mqtt(corkClient);
+bool publishField(const char *topic, const char *payload, void *context);
+// Retained infinisolar/0/<key> topics, e.g. infinisolar/0/battVolt.
+INFI::InfiniFieldTopics fieldTopics("infinisolar", "0", publishField);
+
+// Samples taken while the broker is unreachable go to flash, and up as a telemetry array on
+// infinisolar/0/history once it is back. The log is only trimmed on each upload's PUBACK.
+const char HISTORY_TOPIC[] = "infinisolar/0/history";
+const uint16_t MQTT_BUFFER_SZ = 2048;
+char historyPayload[MQTT_BUFFER_SZ - 128];
+INFI::InfiniTelemetryLog telemetryLog(LittleFS);
+uint16_t publishHistory(const char *payload, void *context);
+INFI::InfiniLogDrain logDrain(telemetryLog, historyPayload, sizeof(historyPayload), publishHistory);
+
+const unsigned long GS_PERIOD = 5000;
+const unsigned long RECONNECT_PERIOD = 5000;
+unsigned long lastConnectAttemptMs = 0;
+
+bool publishField(const char *topic, const char *payload, void *context) {
+  return mqtt.publish(topic, payload, true);
+}
+
+uint16_t publishHistory(const char *payload, void *context) {
+  return mqtt.publishQos1(HISTORY_TOPIC, (const uint8_t *)payload, strlen(payload), false);
+}
+
+// Milliseconds since the Unix epoch by NTP, 0 until it synced.
+unsigned long long nowUnixMs() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  // Anything before 2020 is the clock still counting from boot.
+  if (tv.tv_sec < 1577836800L) {
+    return 0;
+  }
+  return (unsigned long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+void onGeneralStatus(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || response.actualLen != INFI::getResponseSize(INFI::GENERAL_STATUS) ||
+      !respParser.fromILGSToGeneralStatusFixed(response.val, response.actualLen)) {
+    Serial.println("Malformed General Status response.");
+    return;
+  }
+  if (!mqtt.connected()) {
+    // Without a time the sample could not be placed in the history, it is only missed on the topics.
+    unsigned long long tsMs = nowUnixMs();
+    if (tsMs != 0 && !telemetryLog.append(respParser.generalStatusFixed, tsMs)) {
+      Serial.println("Could not log the GS sample.");
+    }
+    return;
+  }
+  corkClient.cork();
+  int published = fieldTopics.publish(respParser.generalStatusFixed);
+  if (!corkClient.uncork() || published < 0) {
+    Serial.println("Could not publish the GS fields.");
+  }
+}
+
+void setup() {
+  Serial.begin(SERIAL_DEBUG_BAUD);
+  Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1, 16, 17);
+
+  // Noise on the readings would otherwise republish them every sample.
+  INFI::GeneralStatusDelta &delta = fieldTopics.delta();
+  delta.setDeadband(INFI::GS_GRID_VOLT, 20);
+  delta.setDeadband(INFI::GS_AC_OUT_VOLT, 20);
+  delta.setDeadband(INFI::GS_BATT_VOLT, 2);
+  delta.setDeadband(INFI::GS_PV1_IN_POW, 20);
+  delta.setDeadband(INFI::GS_PV2_IN_POW, 20);
+  delta.setDeadband(INFI::GS_AC_OUT_ACTIVE_POW, 20);
+  pollScheduler.addPeriodic(INFI::GENERAL_STATUS, GS_PERIOD, onGeneralStatus);
+
+  if (!LittleFS.begin(true) || !telemetryLog.begin()) {
+    Serial.println("No telemetry log, samples taken offline are lost.");
+  }
+
+  WiFi.begin(WIFI_AP_NAME, WIFI_PASSWORD);
+  configTime(0, 0, "pool.ntp.org");
+  mqtt.setServer(MQTT_BROKER, MQTT_PORT);
+  mqtt.setBufferSize(MQTT_BUFFER_SZ);
+  mqtt.setPubackCallback([](uint16_t packetId) { logDrain.onAck(packetId); });
+}
+
+void loop() {
+  // Sampling goes on whatever the network does, the topics are retained so a gap just leaves the last values.
+  pollScheduler.loop();
+
+  if (WiFi.status() != WL_CONNECTED) {
+    return;
+  }
+  if (!mqtt.connected()) {
+    if (millis() - lastConnectAttemptMs < RECONNECT_PERIOD) {
+      return;
+    }
+    lastConnectAttemptMs = millis();
+    if (!mqtt.connect("infinisolar", MQTT_USER, MQTT_PASSWORD)) {
+      Serial.println("Could not connect to the MQTT broker.");
+      return;
+    }
+    // The broker may have been restarted without its retained messages.
+    fieldTopics.delta().forceFullSnapshot();
+    // The session is new, uploads that were in flight never got their PUBACK and go again.
+    logDrain.reset();
+  }
+  mqtt.loop();
+  logDrain.loop();
+}
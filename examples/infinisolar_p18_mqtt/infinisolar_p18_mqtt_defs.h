@@ -0,0 +1,15 @@
+#ifndef INFINISOLAR_P18_MQTT_DEFS_H
+#define INFINISOLAR_P18_MQTT_DEFS_H
+
+// WiFi access point
+#define WIFI_AP_NAME        "wifi_ssid"
+// WiFi password
+#define WIFI_PASSWORD       "password"
+
+// MQTT broker on the LAN, e.g. the Mosquitto add-on of Home Assistant.
+#define MQTT_BROKER         "homeassistant.local"
+#define MQTT_PORT           1883
+#define MQTT_USER           "mqtt_user"
+#define MQTT_PASSWORD       "mqtt_password"
+
+#endif
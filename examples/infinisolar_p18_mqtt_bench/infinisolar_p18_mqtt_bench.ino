@@ -0,0 +1,371 @@
+// Include Arduino.h for ESP32 to quieten annoying VS Code squiggles
+#ifdef ARDUINO_ARCH_ESP32
+    #include <Arduino.h>
+#endif
+#include <WiFi.h>                 // WiFi control for ESP32
+#include <esp_freertos_hooks.h>   // Idle hooks, for the CPU time left over
+#include <algorithm>
+#include "infinisolar_p18_mqtt_bench_defs.h" // Defs for the broker and WiFi
+#if MQTT_CLIENT_ESPRESSIF
+    #define THINGSBOARD_USE_ESP_MQTT 1
+    #include <Espressif_MQTT_Client.h>
+#else
+    #include <Arduino_MQTT_Client.h>
+#endif
+#include <ArduinoJson.h>
+#include <ThingsBoard.h>
+#include "InfiniCRC.h"
+#include "InfiniResponseParser.h"
+#include "InfiniJsonWriter.h"
+#include "InfiniGsSkeleton.h"
+#include "InfiniDeltaTelemetry.h"
+#include "InfiniDeflate.h"
+
+// The uplink against a real broker, no inverter needed, for picking the batch, encoding and buffer
+// size of a site. Built against the SDK vendored in ThingsBoard/ rather than the fork in lib_deps.
+// Every run sends SAMPLES GS samples as fast as the link takes them, for each buffer size, encoding
+// and batch size, and prints a CSV line:
+//   buffer, encoding, batch, samples per publish, samples/s, publish latency p50, p90, p99 and max in us,
+//   bytes on the wire per sample, the busy share of each core in % and the publishes that failed.
+// The latency is the publish call, which returns once the payload is in lwIP's send buffer at QoS 0, and
+// samples/s runs to the last one returning, so it is high by at most that buffer's worth.
+// The busy share is what the idle task did not get: FreeRTOS idle hooks count their turns, against the
+// turns per ms they got in setup() before WiFi came up. Core 0 is the WiFi and lwIP one.
+// test/test_mqtt_bench runs the same sweep on the host.
+
+using namespace INFI;
+
+// Baud rate for debug serial
+#define SERIAL_DEBUG_BAUD    115200
+
+const unsigned int SAMPLES = 240;
+const unsigned long long FIRST_TS_MS = 1700000000000ULL;
+const unsigned long SAMPLE_PERIOD_MS = 5000;
+// Header and topic of a publish, the rest of the client's buffer is for the payload.
+const size_t MQTT_OVERHEAD_SZ = 32;
+const size_t MAX_BUFFER_SZ = 8192;
+
+const WORD BUFFER_SIZES[] = { 1024, 4096, 8192 };
+const BYTE BATCH_SIZES[] = { 1, 4, 16, 32 };
+
+enum ENCODING {
+    ENCODING_JSON = 0,  // ThingsBoard's [{"ts":...,"values":{...}}] array of writeGeneralStatusJson() objects.
+    ENCODING_SKELETON,  // InfiniGsSkeleton by sendTelemetryPrintable(), one sample a publish and no timestamp.
+    ENCODING_MSGPACK,   // The same array as MessagePack, the fields in the units they are stored in.
+    ENCODING_DEFLATE,   // The JSON array through InfiniDeflatePrint, GZIP.
+    NUM_ENCODINGS
+};
+
+const char *const ENCODING_NAMES[NUM_ENCODINGS] = { "json", "skeleton", "msgpack", "deflate" };
+
+#if MQTT_CLIENT_ESPRESSIF
+Espressif_MQTT_Client<> mqttClient;
+#else
+WiFiClient espClient;
+Arduino_MQTT_Client mqttClient(espClient);
+#endif
+ThingsBoardSized<> tb(mqttClient, MAX_BUFFER_SZ);
+InfiniResponseParser respParser;
+
+GeneralStatusFixed samples[SAMPLES];
+unsigned long latencyUs[SAMPLES];
+char payload[MAX_BUFFER_SZ];
+// The JSON text deflate compresses, which may take more than the buffer it compresses into.
+char deflateText[2 * MAX_BUFFER_SZ];
+
+// payload as a Print, refusing what does not fit the room given to reset().
+class PayloadPrint : public Print {
+    public:
+    void reset(size_t room) {
+        m_room = room;
+        m_length = 0;
+    }
+    size_t write(uint8_t c) override {
+        if (m_length >= m_room) {
+            return 0;
+        }
+        payload[m_length++] = (char)c;
+        return 1;
+    }
+    size_t length() const {
+        return m_length;
+    }
+
+    private:
+    size_t m_room = 0;
+    size_t m_length = 0;
+};
+
+PayloadPrint payloadOut;
+// Static, its window and hash chains are too much for the loop task's stack.
+InfiniDeflatePrint deflate(payloadOut, DEFLATE_GZIP);
+
+// Turns of the idle task of each core, and how many it gets per ms with nothing else to do.
+volatile unsigned long idleTurns[portNUM_PROCESSORS];
+float idleTurnsPerMs[portNUM_PROCESSORS];
+
+bool countIdle0() {
+    idleTurns[0]++;
+    // Keeps it spinning instead of waiting for the next interrupt, so the turns measure idle time.
+    return false;
+}
+
+#if portNUM_PROCESSORS > 1
+bool countIdle1() {
+    idleTurns[1]++;
+    return false;
+}
+#endif
+
+void resetIdle() {
+    for (BYTE c = 0; c < portNUM_PROCESSORS; ++c) {
+        idleTurns[c] = 0;
+    }
+}
+
+// The GS reply of every sample, PV and load wander and the grid jitters, as in the host benchmarks.
+const char GS_FORMAT[] =
+    "%04u,500,2301,500,%04u,%04u,%03u,524,000,000,000,%03u,%03u,035,030,000,%04u,0000,3400,0000,0,2,0,1,1,2,1,0";
+
+// Decodes the samples from ^Dxxx replies with a valid CRC, as the inverter would send them.
+void makeSamples() {
+    char gs[sizeof(GS_FORMAT)];
+    char frame[MAX_RESPONSE_SZ];
+    for (unsigned int i = 0; i < SAMPLES; ++i) {
+        unsigned int load = 400 + (i * 7) % 90;
+        snprintf(gs, sizeof(gs), GS_FORMAT, 2295 + (i * 13) % 11, load + 50, load, load / 12, (i / 50) % 10,
+                 30 + (i / 200) % 70, 850 + (i * 3) % 200);
+        int n = snprintf(frame, sizeof(frame), "^D%03d%s", (int)strlen(gs) + CRC_SZ + END_TOKEN_SZ, gs);
+        WORD crc = calc_crc_half((const BYTE *)frame, (BYTE)n);
+        frame[n++] = (char)(crc >> 8);
+        frame[n++] = (char)(crc & 0xFF);
+        frame[n++] = '\r';
+        frame[n] = '\0';
+        if (!respParser.fromILGSToGeneralStatusFixed(frame, n)) {
+            Serial.println("GS sample frame did not decode");
+        }
+        samples[i] = respParser.generalStatusFixed;
+    }
+}
+
+unsigned long long sampleTs(unsigned int i) {
+    return FIRST_TS_MS + (unsigned long long)i * SAMPLE_PERIOD_MS;
+}
+
+// Writes count samples from first on as ThingsBoard's timestamped telemetry array.
+void writeTelemetryArray(unsigned int first, BYTE count, Print &out) {
+    char ts[32];
+    out.print('[');
+    for (BYTE i = 0; i < count; ++i) {
+        snprintf(ts, sizeof(ts), "%s{\"ts\":%llu,\"values\":", i > 0 ? "," : "", sampleTs(first + i));
+        out.print(ts);
+        writeGeneralStatusJson(samples[first + i], out);
+        out.print('}');
+    }
+    out.print(']');
+}
+
+size_t encodeMsgPack(unsigned int first, BYTE count, size_t room) {
+    JsonDocument doc;
+    JsonArray array = doc.to<JsonArray>();
+    for (BYTE i = 0; i < count; ++i) {
+        JsonObject sample = array.add<JsonObject>();
+        sample["ts"] = sampleTs(first + i);
+        JsonObject values = sample["values"].to<JsonObject>();
+        for (BYTE f = 0; f < NUM_GS_FIELDS; ++f) {
+            values[getGeneralStatusFieldKey((GS_FIELD)f)] = getGeneralStatusField(samples[first + i], (GS_FIELD)f);
+        }
+    }
+    if (measureMsgPack(doc) > room) {
+        return 0;
+    }
+    return serializeMsgPack(doc, payload, room);
+}
+
+// Encodes count samples from first on into payload, with room bytes for it.
+// Returns its length, 0 if it does not fit. JSON is null terminated.
+size_t encode(ENCODING encoding, unsigned int first, BYTE count, size_t room) {
+    switch (encoding) {
+        case ENCODING_JSON: {
+            InfiniCountingPrint counter;
+            writeTelemetryArray(first, count, counter);
+            if (counter.count() > room) {
+                return 0;
+            }
+            // InfiniBufferPrint keeps a byte for the terminator.
+            InfiniBufferPrint out(payload, room + 1);
+            writeTelemetryArray(first, count, out);
+            return out.length();
+        }
+        case ENCODING_MSGPACK:
+            return encodeMsgPack(first, count, room);
+        case ENCODING_DEFLATE: {
+            InfiniBufferPrint text(deflateText, sizeof(deflateText));
+            writeTelemetryArray(first, count, text);
+            if (text.length() + 1 >= sizeof(deflateText)) {
+                return 0;
+            }
+            payloadOut.reset(room);
+            deflate.begin();
+            deflate.write((const uint8_t *)deflateText, text.length());
+            return deflate.finish() ? payloadOut.length() : 0;
+        }
+        default:
+            return 0;
+    }
+}
+
+// The most samples up to batch that fit a payload of room bytes, taken from the first ones. 0 if none does.
+BYTE fitBatch(ENCODING encoding, BYTE batch, size_t room) {
+    while (batch > 0 && encode(encoding, 0, batch, room) == 0) {
+        --batch;
+    }
+    return batch;
+}
+
+// The bytes of a QoS 0 PUBLISH on the wire: fixed header with the remaining length, topic, payload.
+size_t wireSize(const char *topic, size_t payloadLen) {
+    size_t remaining = 2 + strlen(topic) + payloadLen;
+    size_t header = 1;
+    for (size_t n = remaining; n > 0; n >>= 7) {
+        ++header;
+    }
+    return header + remaining;
+}
+
+bool connectBroker() {
+    if (tb.connected()) {
+        return true;
+    }
+    if (!tb.connect(BENCH_SERVER, BENCH_TOKEN, BENCH_PORT)) {
+        return false;
+    }
+    // The ESP-IDF client connects on its own task.
+    unsigned long start = millis();
+    while (!tb.connected() && millis() - start < 10000) {
+        delay(10);
+    }
+    return tb.connected();
+}
+
+void run(WORD bufferSize, ENCODING encoding, BYTE batch) {
+    static InfiniGsSkeleton skeleton;
+    const bool raw = encoding == ENCODING_MSGPACK || encoding == ENCODING_DEFLATE;
+    const size_t room = bufferSize - MQTT_OVERHEAD_SZ;
+    const BYTE perPublish = encoding == ENCODING_SKELETON ? 1 : fitBatch(encoding, batch, room);
+    if (perPublish == 0 || !tb.setBufferSize(bufferSize) || !connectBroker()) {
+        return;
+    }
+    const char *topic = raw ? BENCH_RAW_TOPIC : TELEMETRY_TOPIC;
+    unsigned long publishes = 0;
+    unsigned long failed = 0;
+    unsigned long wireBytes = 0;
+    BYTE count = 0;
+    resetIdle();
+    const unsigned long start = micros();
+
+    for (unsigned int first = 0; first < SAMPLES; first += count) {
+        count = (BYTE)std::min<unsigned int>(perPublish, SAMPLES - first);
+        bool sent = false;
+        unsigned long publishStart;
+        size_t len;
+        if (encoding == ENCODING_SKELETON) {
+            skeleton.fill(samples[first]);
+            len = skeleton.length();
+            publishStart = micros();
+            sent = tb.sendTelemetryPrintable(skeleton, len);
+        } else {
+            len = encode(encoding, first, count, room);
+            // The compressed size varies, samples that do not fit after all go with the next publish.
+            while (len == 0 && count > 1) {
+                len = encode(encoding, first, --count, room);
+            }
+            publishStart = micros();
+            if (len == 0) {
+                sent = false;
+            } else if (raw) {
+                sent = mqttClient.publish(topic, (const uint8_t *)payload, len);
+            } else {
+                sent = tb.sendTelemtryString(payload);
+            }
+        }
+        latencyUs[publishes++] = micros() - publishStart;
+        if (sent) {
+            wireBytes += wireSize(topic, len);
+        } else {
+            failed++;
+        }
+        tb.loop();
+    }
+    const unsigned long elapsedUs = micros() - start;
+    float busy[portNUM_PROCESSORS];
+    for (BYTE c = 0; c < portNUM_PROCESSORS; ++c) {
+        busy[c] = 100.0f * (1.0f - idleTurns[c] / (idleTurnsPerMs[c] * elapsedUs / 1000.0f));
+        busy[c] = busy[c] < 0 ? 0 : busy[c];
+    }
+
+    std::sort(latencyUs, latencyUs + publishes);
+    Serial.printf("%u,%s,%u,%u,%.0f,%lu,%lu,%lu,%lu,%.1f", bufferSize, ENCODING_NAMES[encoding], batch, perPublish,
+                  SAMPLES * 1e6f / elapsedUs, latencyUs[(publishes - 1) * 50 / 100],
+                  latencyUs[(publishes - 1) * 90 / 100], latencyUs[(publishes - 1) * 99 / 100],
+                  latencyUs[publishes - 1], (float)wireBytes / SAMPLES);
+    for (BYTE c = 0; c < portNUM_PROCESSORS; ++c) {
+        Serial.printf(",%.0f", busy[c]);
+    }
+    Serial.printf(",%lu\n", failed);
+}
+
+void setup() {
+    Serial.begin(SERIAL_DEBUG_BAUD);
+    while(!Serial) {
+        delay(1000);
+    }
+    makeSamples();
+
+    esp_register_freertos_idle_hook_for_cpu(countIdle0, 0);
+#if portNUM_PROCESSORS > 1
+    esp_register_freertos_idle_hook_for_cpu(countIdle1, 1);
+#endif
+    resetIdle();
+    delay(1000);
+    for (BYTE c = 0; c < portNUM_PROCESSORS; ++c) {
+        idleTurnsPerMs[c] = idleTurns[c] / 1000.0f;
+    }
+
+    WiFi.begin(WIFI_AP_NAME, WIFI_PASSWORD);
+    // Modem sleep would add its beacon interval to the latencies.
+    WiFi.setSleep(false);
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(500);
+        Serial.print(".");
+    }
+    Serial.println();
+    if (!connectBroker()) {
+        Serial.println("Could not connect to the broker");
+    }
+}
+
+void loop() {
+    Serial.println();
+    Serial.println("buffer,encoding,batch,per_publish,samples_s,p50_us,p90_us,p99_us,max_us,bytes_sample,busy_pct_core0"
+#if portNUM_PROCESSORS > 1
+                   ",busy_pct_core1"
+#endif
+                   ",failed");
+    for (size_t b = 0; b < sizeof(BUFFER_SIZES) / sizeof(BUFFER_SIZES[0]); ++b) {
+        for (BYTE e = 0; e < NUM_ENCODINGS; ++e) {
+            const ENCODING encoding = (ENCODING)e;
+            if ((encoding == ENCODING_MSGPACK || encoding == ENCODING_DEFLATE) && strlen(BENCH_RAW_TOPIC) == 0) {
+                continue;
+            }
+            for (size_t n = 0; n < sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]); ++n) {
+                // The skeleton is one sample a publish, its batch is always 1.
+                if (encoding == ENCODING_SKELETON && n > 0) {
+                    break;
+                }
+                run(BUFFER_SIZES[b], encoding, BATCH_SIZES[n]);
+            }
+        }
+    }
+    delay(60000);
+}
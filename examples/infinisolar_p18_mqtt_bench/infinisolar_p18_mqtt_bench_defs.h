@@ -0,0 +1,21 @@
+#ifndef INFINISOLAR_P18_MQTT_BENCH_DEFS_H
+#define INFINISOLAR_P18_MQTT_BENCH_DEFS_H
+
+// WiFi access point
+#define WIFI_AP_NAME        "wifi_ssid"
+// WiFi password
+#define WIFI_PASSWORD       "password"
+
+// The broker, a ThingsBoard server or any other, and the port.
+#define BENCH_SERVER        "your.broker.address"
+#define BENCH_PORT          1883
+// The user name, a ThingsBoard device's access token. Any name does for a broker without authentication.
+#define BENCH_TOKEN         "device_access_token"
+// Where the MessagePack and compressed payloads go, ThingsBoard drops a session that sends them as telemetry.
+// Leave empty to skip them, e.g. against ThingsBoard itself.
+#define BENCH_RAW_TOPIC     ""
+
+// 1 for the ESP-IDF MQTT client, Espressif_MQTT_Client, 0 for PubSubClient, Arduino_MQTT_Client.
+#define MQTT_CLIENT_ESPRESSIF 0
+
+#endif
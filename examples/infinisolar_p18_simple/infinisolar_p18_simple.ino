@@ -5,7 +5,7 @@
 #include "InfiniCommandSender.h"
 #include "InfiniResponseParser.h"
 
-using INFI::InfiniCommandSender;
+using INFI::InfiniCommandSenderT;
 using INFI::InfiniResponseParser;
 
 #define RXD2 16
@@ -14,9 +14,14 @@ using INFI::InfiniResponseParser;
 // Baud rate for debug serial
 #define SERIAL_DEBUG_BAUD    115200
 
-const int CMD_DELAY = 2000;
+// How often T is read. The link itself needs no gap between commands, sendCommand() returns
+// as soon as the reply is in, and the calibration keeps its timeout close to what the inverter takes.
+const unsigned long POLL_PERIOD = 2000;
+unsigned long polledMs = 0;
 
-InfiniCommandSender cmdSender(Serial2, &Serial);
+// Reads the reply through HardwareSerial's own read(), not through Stream's vtable.
+InfiniCommandSenderT<HardwareSerial> cmdSender(Serial2, &Serial);
+INFI::InfiniLinkCalibration linkCalibration;
 InfiniResponseParser respParser;
 
 void setup() {
@@ -30,10 +35,14 @@ void setup() {
     while(!Serial || !Serial2) {
         delay(1000);
     }
+    cmdSender.setCalibration(&linkCalibration);
 }
 
 void loop() {
-    delay(CMD_DELAY);
+    if (millis() - polledMs < POLL_PERIOD) {
+        return;
+    }
+    polledMs = millis();
     cmdSender.sendCommand(INFI::CURRENT_TIME, {});
 
     if (cmdSender.response.actualLen == 0) {
@@ -47,9 +56,10 @@ void loop() {
     Serial.println("Parsing current time to get current day");
     size_t parsedSz = respParser.fromILCurrentTimeToILCurrentDay(cmdSender.response.val, cmdSender.response.actualLen);
     if (parsedSz == 0) {
-    Serial.println("Malformed response. Please restart device.\n");
+    Serial.println("Malformed response, skipped. The next poll starts on a clean link.\n");
     return;
     }
     Serial.print("Current day: "); Serial.println(respParser.parsed);
+    Serial.print("Inverter turnaround: "); Serial.print(linkCalibration.turnaroundMs(INFI::CURRENT_TIME)); Serial.println(" ms");
     Serial.println();
 }
\ No newline at end of file
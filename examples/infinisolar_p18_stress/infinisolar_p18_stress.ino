@@ -0,0 +1,113 @@
+// Include Arduino.h for ESP32 to quieten annoying VS Code squiggles
+#ifdef ARDUINO_ARCH_ESP32
+    #include <Arduino.h>
+#endif
+#include "InfiniStressTest.h"
+
+using INFI::InfiniCommandSender;
+using INFI::InfiniCommandQueue;
+
+#define RXD2 16
+#define TXD2 17
+
+// Baud rate for debug serial
+#define SERIAL_DEBUG_BAUD    115200
+
+// Sends each mix back to back for RUN_MS and prints what the inverter kept up with, then the next mix.
+// Meant for a bench with nothing else on the port, the results set the cadence ceilings of a model.
+const unsigned long RUN_MS = 60000;
+const unsigned long PAUSE_MS = 5000;
+
+struct Mix {
+    const char *name;
+    INFI::COMMAND_TYPE commands[4];
+    BYTE count;
+};
+
+const Mix MIXES[] = {
+    { "GS", { INFI::GENERAL_STATUS }, 1 },
+    { "T", { INFI::CURRENT_TIME }, 1 },
+    { "GS+FWS+MOD", { INFI::GENERAL_STATUS, INFI::FAULT_WARNING_STATUS, INFI::QUERY_WORKING_MODE }, 3 },
+    { "PIRI+GS", { INFI::QUERY_RATED_INFORMATION, INFI::GENERAL_STATUS }, 2 },
+};
+const BYTE MIX_COUNT = sizeof(MIXES) / sizeof(MIXES[0]);
+BYTE mixIndex = 0;
+unsigned long pausedMs = 0;
+
+InfiniCommandSender cmdSender(Serial2);
+InfiniCommandQueue cmdQueue(cmdSender);
+INFI::InfiniLinkCalibration linkCalibration;
+INFI::InfiniLinkStats linkStats;
+INFI::InfiniStressTest stressTest(cmdQueue);
+
+void startMix() {
+    const Mix &mix = MIXES[mixIndex];
+    stressTest.clear();
+    for (BYTE i = 0; i < mix.count; ++i) {
+        stressTest.add(mix.commands[i]);
+    }
+    linkStats.reset();
+    stressTest.begin(RUN_MS);
+    Serial.printf("Mix %s for %lu s\n", mix.name, RUN_MS / 1000);
+}
+
+void printResult() {
+    const INFI::StressResult &result = stressTest.result();
+    Serial.printf("  %lu transactions in %lu ms: %lu.%lu/s of %lu.%lu/s the wire allows\n", result.transactions,
+                  result.elapsedMs, stressTest.transactionsPerS10() / 10, stressTest.transactionsPerS10() % 10,
+                  stressTest.wireLimitPerS10() / 10, stressTest.wireLimitPerS10() % 10);
+    Serial.printf("  ok %lu, nak %lu, timeout %lu, error %lu\n", result.ok, result.nak, result.timeout, result.error);
+    Serial.printf("  %lu.%lu bytes/s, %lu.%lu %% of %lu baud\n", stressTest.bytesPerS10() / 10,
+                  stressTest.bytesPerS10() % 10, stressTest.utilization10() / 10, stressTest.utilization10() % 10,
+                  cmdSender.baud());
+    Serial.printf("  turnaround min %lu, mean %lu, max %lu ms\n", result.replies > 0 ? result.turnaroundMinMs : 0,
+                  stressTest.meanTurnaroundMs(), result.turnaroundMaxMs);
+    Serial.print("  turnaround histogram:");
+    for (BYTE i = 0; i < INFI::LATENCY_BUCKETS; ++i) {
+        WORD maxMs = INFI::InfiniLinkStats::latencyBucketMaxMs(i);
+        if (maxMs > 0) {
+            Serial.printf(" <=%u:%lu", maxMs, stressTest.turnaroundBucket(i));
+        } else {
+            Serial.printf(" more:%lu", stressTest.turnaroundBucket(i));
+        }
+    }
+    Serial.println();
+    // The same for a log parser, then every attempt, retries included.
+    stressTest.writeJson(Serial);
+    Serial.println();
+    linkStats.writeJson(Serial);
+    Serial.println();
+}
+
+void setup() {
+    Serial.begin(SERIAL_DEBUG_BAUD);
+    #ifdef ARDUINO_ARCH_ESP32
+        Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1, RXD2, TXD2);
+    #else
+        Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1);
+    #endif
+
+    while(!Serial || !Serial2) {
+        delay(1000);
+    }
+    // The deadlines follow the inverter, so a lost reply costs little more than its turnaround.
+    cmdSender.setCalibration(&linkCalibration);
+    cmdSender.setStats(&linkStats);
+    startMix();
+}
+
+void loop() {
+    if (stressTest.isRunning()) {
+        stressTest.loop();
+        cmdQueue.loop();
+        if (!stressTest.isRunning()) {
+            printResult();
+            pausedMs = millis();
+        }
+        return;
+    }
+    if (millis() - pausedMs >= PAUSE_MS) {
+        mixIndex = (mixIndex + 1) % MIX_COUNT;
+        startMix();
+    }
+}
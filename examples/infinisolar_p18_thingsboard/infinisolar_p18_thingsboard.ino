@@ -1,54 +1,1220 @@
 #include <WiFi.h>           // WiFi control for ESP32
 #include <ThingsBoard.h>    // ThingsBoard SDK
+#include <PubSubClient.h>   // MQTT client, for the provisioning session
+#include <SD.h>             // SD card on the SPI bus, for the long term GS log
 #include "infinisolar_p18_thingsboard_defs.h" // Defs for various secrets, keys
-#include "InfiniCommandSender.h"
+#include "InfiniPollScheduler.h"
 #include "InfiniResponseParser.h"
+#include "InfiniJsonWriter.h"
+#include "InfiniDeltaTelemetry.h"
+#include "InfiniPlantStatus.h"
+#include "InfiniEnergyTracker.h"
+#include "InfiniEnergyBackfill.h"
+#include "InfiniEnergyHistory.h"
+#include "InfiniClock.h"
+#include "InfiniTelemetryBatch.h"
+#include "InfiniGsHistory.h"
+#include "InfiniColumnKernels.h"
+#include "InfiniRollup.h"
+#include "InfiniPartitionLog.h"
+#include "InfiniLinkStats.h"
+#include "InfiniResourceStats.h"
+#include "InfiniIdle.h"
+#include "InfiniStatusServer.h"
+#include "InfiniGsStream.h"
+#include "InfiniSampleFanout.h"
+#include "InfiniSdLog.h"
+#include "InfiniSinkQueue.h"
+#include "InfiniModbus.h"
+#include "InfiniSettingsBatch.h"
+#include "InfiniSetter.h"
+#include "InfiniFaultEvents.h"
+#include "InfiniFaultCapture.h"
+#include "InfiniGsStats.h"
+#include "InfiniPollPolicy.h"
+#include "InfiniRules.h"
+#include "InfiniGsCadence.h"
+#include "InfiniDaylight.h"
+#include "InfiniStaticInfo.h"
+#include "InfiniLinkDiscovery.h"
+#include "InfiniBridge.h"
+#include "InfiniWiFiFast.h"
+#include "InfiniWiFiPower.h"
+#include "InfiniEthernet.h"
+#include "InfiniCredentials.h"
+#include "InfiniTrace.h"
+#include "InfiniUploadPacer.h"
+#include "InfiniSupervisor.h"
+#include "InfiniTimerWheel.h"
+#include "InfiniBleService.h"
 
 using INFI::InfiniCommandSender;
+using INFI::InfiniCommandQueue;
+using INFI::InfiniPollScheduler;
 using INFI::InfiniResponseParser;
 
-#define RXD2 16
-#define TXD2 17
+// The RX/TX pins an inverter may be wired to, the first one that answers at boot is used.
+struct LinkPins {
+  int8_t rx;
+  int8_t tx;
+};
+const LinkPins LINK_PINS[] = { { 16, 17 }, { 26, 27 }, { 4, 2 } };
+const INFI::BYTE NUM_LINK_PINS = sizeof(LINK_PINS) / sizeof(LINK_PINS[0]);
 
-// Initialize ThingsBoard client
+// Initialize ThingsBoard client. Over Ethernet it is a socket like any other, the cable is just another netif.
 WiFiClient espClient;
 // Initialize ThingsBoard instance
+const size_t MQTT_BUFFER_SZ = 1024;
 const size_t MAX_FIELDS_AMT = 16;
-const size_t NUM_RPC_CALLBACKS = 9;
-ThingsBoardSized<INFI::MAX_RESPONSE_SZ, MAX_FIELDS_AMT,
+const size_t NUM_RPC_CALLBACKS = 11;
+ThingsBoardSized<MQTT_BUFFER_SZ, MAX_FIELDS_AMT,
                  ThingsBoardDefaultLogger,
                  NUM_RPC_CALLBACKS> tb(espClient);
-// the Wifi radio's status
-int status = WL_IDLE_STATUS;
-
 // Baud rate for debug serial
 #define SERIAL_DEBUG_BAUD    115200
 
+// One sender and queue per inverter, the device id of each is its index in deviceQueues.
+// To drive inverters on more RS232 ports, add a sender/queue pair per port, list the queues below,
+// build with -DINFI_POLL_SCHEDULER_DEVICES=<n> and pollScheduler.addDevice() them in setup().
 InfiniCommandSender cmdSender(Serial2, &Serial);
+// RS232 link quality, uploaded as attributes every LINK_STATS_PERIOD.
+INFI::InfiniLinkStats linkStats;
+// The inverter's turnaround per command, learnt from every reply, sets how long a reply is waited for.
+INFI::InfiniLinkCalibration linkCalibration;
+// Set to try faster rates at boot, for an inverter whose port was configured for one. Highest first.
+const bool PROBE_BAUD = false;
+const unsigned long BAUD_CANDIDATES[] = { 9600, 4800, INFI::SERIAL_BAUD };
+// Serial1 only helps Serial2 probe LINK_PINS at boot, both UARTs take a set of pins per round.
+InfiniCommandSender probeSender(Serial1);
+InfiniCommandSender *probeChannels[] = { &cmdSender, &probeSender };
+HardwareSerial *const PROBE_UARTS[] = { &Serial2, &Serial1 };
+// The pins and baud discoverLink() left Serial2 on, a restart of the UART goes back to them.
+INFI::BYTE linkCandidate = 0;
+unsigned long linkBaud = INFI::SERIAL_BAUD;
+// Stack and heap minima per stage of the cycle, uploaded as telemetry every RESOURCE_STATS_PERIOD.
+// Set resources to NULL to take the probes out.
+INFI::InfiniResourceStats resourceStats;
+INFI::InfiniResourceStats *resources = &resourceStats;
+// The periodic uploads of the stats above, run from the online part of loop(). Jobs of that kind go here
+// rather than in another sent-at stamp, msUntilWork() then needs no line of its own for them.
+INFI::InfiniTimerWheel timers;
+INFI::BYTE linkStatsTimer = INFI::TIMER_WHEEL_SZ;
+INFI::BYTE resourceStatsTimer = INFI::TIMER_WHEEL_SZ;
+// Replies are assembled here by the UART event task, the loop only picks up complete frames.
+INFI::InfiniRxRing rxRing;
+InfiniCommandQueue cmdQueue(cmdSender);
+InfiniCommandQueue *deviceQueues[INFI::POLL_SCHEDULER_DEVICES] = { &cmdQueue };
+InfiniPollScheduler pollScheduler(cmdQueue);
 InfiniResponseParser respParser;
+// A settings profile pushed in one RPC, see processSetSettingsProfile().
+INFI::InfiniSettingsBatch settingsBatch(cmdQueue, cmdSender, respParser);
+// The typed ^S commands of the RPC handlers, they check each value before it goes out.
+INFI::InfiniSetter setter(cmdQueue, cmdSender);
+char settingsBatchJson[96];
+INFI::GeneralStatusDelta gsDeltas[INFI::POLL_SCHEDULER_DEVICES];
+// GS telemetry with the short keys, e.g. "bdc" for battDischargeCurr, about half the bytes of a full sample.
+// The map goes up once as the gsKeys client attribute, for a rule chain on the server to expand them.
+const bool SHORT_GS_KEYS = false;
+bool gsKeyMapSent = false;
+// Per minute min/max/avg/sd of the PV, load and battery readings, and the battery energy in and out,
+// uploaded as one record so the server does not have to compute them from the raw samples.
+INFI::GeneralStatusStats gsStats[INFI::POLL_SCHEDULER_DEVICES];
+// The inverter's clock, so T is only polled to resync it and the ED day comes from here.
+INFI::InfiniClock inverterClocks[INFI::POLL_SCHEDULER_DEVICES];
+INFI::InfiniGsHistory gsHistory;
+unsigned long gsUploadedMs = 0;
+bool gsBacklog = false;
+// GS samples taken while offline are moved here, and replayed once ThingsBoard is reachable.
+// On the raw data partition of the default partition table, no file system goes on it.
+INFI::InfiniPartitionLog telemetryLog("spiffs");
+INFI::InfiniGsHistory logReplay;
+// The records logReplay was peeked with, consumed from the log once all of it went up.
+INFI::BYTE logReplayRead = 0;
+unsigned long logDrainedMs = 0;
+// Set once the result of the boot time check of the log was printed.
+bool logVerifyReported = false;
+// What goes to the log is also aged into 1 min and 1 h aggregates, which cover an outage longer than the log
+// and go up first on reconnect, ahead of the raw samples.
+INFI::InfiniRollup rollup;
+unsigned long energyPolledMs = 0;
+// EY and EM are only queried once a day, then kept up to date from ED.
+INFI::InfiniEnergyTracker energyTrackers[INFI::POLL_SCHEDULER_DEVICES];
+// FWS goes up as the flags that were raised or cleared since the last upload, not as the whole status.
+INFI::FaultWarningTracker faultTrackers[INFI::POLL_SCHEDULER_DEVICES];
+// With several inverters, their GS are merged into one plant record per cycle.
+INFI::InfiniPlantAggregator plant;
+// Replies sent further apart than this are from different ticks. Well under GS_PERIOD.
+const unsigned long PLANT_ALIGNMENT_US = 100000;
+// The latest GS/PIRI/FWS of each inverter, served as JSON on http://<ip>/status for readers on the LAN.
+// Set SERVE_STATUS to false to keep the HTTP task from starting.
+const bool SERVE_STATUS = true;
+INFI::InfiniStatusCache statusCaches[INFI::POLL_SCHEDULER_DEVICES];
+INFI::InfiniStatusServer statusServer(statusCaches, INFI::POLL_SCHEDULER_DEVICES);
+// Every GS sample is also pushed to the WebSocket clients on ws://<ip>:81/, as JSON.
+INFI::InfiniGsStream gsStream(81, INFI::GS_STREAM_JSON);
+// Hands each GS sample, serialized once per format, to the local consumers, e.g. the WebSocket stream.
+// An SD log or a LAN MQTT client would be added with addSink() in setup() and share the same buffers.
+INFI::InfiniSampleFanout gsFanout;
+// Every timestamped GS sample is also kept on an SD card, one file per day under /gs.
+// Set LOG_TO_SD to false to run without a card. SD_CS_PIN is the chip select of the card slot.
+const bool LOG_TO_SD = true;
+const int SD_CS_PIN = 5;
+INFI::InfiniSdLog sdLog(SD, INFI::SAMPLE_BINARY_STAMPED);
+// The fan-out only copies the samples for the card into this queue, a slow write or a remount then never holds up
+// the polling. loop() writes SD_DRAIN_RECORDS of them at a time. A card that stays behind loses the oldest.
+char sdQueueStorage[16 * INFI::BINARY_GS_SAMPLE_SZ];
+INFI::InfiniSinkQueue sdQueue(sdQueueStorage, sizeof(sdQueueStorage), INFI::BINARY_GS_SAMPLE_SZ, INFI::SINK_DROP_OLDEST);
+const INFI::BYTE SD_DRAIN_RECORDS = 4;
+// Set while the last drain left records it could have taken, loop() then comes back at once.
+bool sdBacklog = false;
+
+// The parallel machine the RPC settings are addressed to.
+const INFI::BYTE PARALLEL_MACHINE = 0;
+
+// Modbus TCP on port 502 for a plant controller, reads come from the status cache of the first inverter,
+// writes to the holding registers are queued as SET commands. See InfiniModbus.h for the register map.
+INFI::InfiniModbusMap modbusMap(statusCaches[0], cmdQueue, PARALLEL_MACHINE);
+INFI::InfiniModbusTcp modbusTcp(modbusMap);
+
+#if INFI_ENABLE_BLE
+// A phone on site reads the live values of the first inverter over BLE, from its status cache as well.
+// Set SERVE_BLE to true to advertise as BLE_NAME, Bluedroid takes around 60 kB of heap.
+const bool SERVE_BLE = false;
+const char BLE_NAME[] = "InfiniSolar";
+INFI::InfiniBleService bleService(statusCaches[0]);
+#endif
+
+// The vendor's PC tool can reach the inverter through a virtual COM port on tcp://<ip>:8899, its frames
+// go out in the link's spare time between the polls. Set BRIDGE_VENDOR_TOOL to false to close the port.
+const bool BRIDGE_VENDOR_TOOL = true;
+INFI::InfiniBridge bridge(cmdQueue);
+INFI::InfiniBridgeTcp bridgeTcp(bridge);
+
+// Telemetry JSON is written here before it is added to the batch. DI is the longest at about 800 chars.
+char telemetryJson[MQTT_BUFFER_SZ];
+
+// A cycle's telemetry goes out as one publish, split only when it exceeds MAX_FIELDS_AMT
+// or the client buffer. The MQTT header and topic take about 30 bytes of that buffer.
+// Double buffered, the next cycle is gathered while the last one is published.
+const size_t MQTT_OVERHEAD_SZ = 32;
+char batchJson[MQTT_BUFFER_SZ - MQTT_OVERHEAD_SZ];
+char batchBackJson[MQTT_BUFFER_SZ - MQTT_OVERHEAD_SZ];
+bool publishBatch(const char *json, void *context);
+INFI::InfiniTelemetryBatch telemetryBatch(batchJson, batchBackJson, sizeof(batchJson), MAX_FIELDS_AMT, publishBatch);
+
+// Between loops the task sleeps until the next deadline, or until an inverter reply or WiFi event
+// wakes it. Online, it still wakes every MQTT_POLL_MS for tb.loop() to take RPC requests, over WiFi
+// only while wifiPower has the radio up.
+const unsigned long MQTT_POLL_MS = 100;
+
+#if NET_TRANSPORT == NET_WIFI
+// Between the flushes WiFi is in max modem sleep, and tb.loop() only runs in the windows around them, which
+// carry the keepalive pings too. An RPC keeps the radio up and tb.loop() polled for RPC_SESSION_MS.
+// MQTT_KEEPALIVE_MS is PubSubClient's default, the client of ThingsBoard.
+const unsigned long MQTT_KEEPALIVE_MS = 15000;
+const unsigned long RPC_SESSION_MS = 60000;
+INFI::InfiniWiFiPower wifiPower(MQTT_KEEPALIVE_MS, RPC_SESSION_MS, MQTT_POLL_MS);
+#endif
+
+// A flush is about to go out: the radio comes up for it, and a keepalive ping due goes along.
+void openFlushWindow() {
+#if NET_TRANSPORT == NET_WIFI
+  wifiPower.openWindow(millis());
+#endif
+}
+
+// Called by every RPC handler, the calls that follow are taken without waiting for a window.
+void onRpcCall() {
+#if NET_TRANSPORT == NET_WIFI
+  wifiPower.onRpc(millis());
+#endif
+}
+
+// Whether tb.loop() runs this loop. Over a cable on every one.
+bool shouldPollMqtt() {
+#if NET_TRANSPORT == NET_WIFI
+  return wifiPower.shouldPoll(millis());
+#else
+  return true;
+#endif
+}
+
+unsigned long msUntilMqttPoll(unsigned long nowMs) {
+#if NET_TRANSPORT == NET_WIFI
+  return wifiPower.msUntilPoll(nowMs);
+#else
+  return MQTT_POLL_MS;
+#endif
+}
+
+// Startup stages after setup(), which only starts the link and the scheduler. One is brought up per loop().
+enum BOOT_STAGE {
+  BOOT_NETWORK,  // WiFi started, the cached AP, lease and credentials loaded.
+  BOOT_STORAGE,  // Telemetry log and SD card mounted.
+  BOOT_SERVICES, // Status, GS stream, Modbus and bridge servers listening.
+  BOOT_DONE
+};
+BOOT_STAGE bootStage = BOOT_NETWORK;
+// When the first GS came in, milliseconds after boot, 0 until then.
+unsigned long firstSampleMs = 0;
+
+// Network connection states, advanced by serviceNetwork() without ever waiting in a loop.
+enum NET_STATE {
+  NET_LINK_DOWN,       // Waiting for the backoff to pass before WiFi.begin(), or for the cable and its lease.
+  NET_LINK_CONNECTING, // WiFi.begin() called, waiting for the got IP event.
+  NET_MQTT_DOWN,       // The link is up, waiting for the backoff to pass before tb.connect().
+  NET_ONLINE           // Connected to ThingsBoard and subscribed for RPC.
+};
+NET_STATE netState = NET_LINK_DOWN;
+// Set from the network event task, for WiFi and Ethernet alike.
+volatile bool linkUp = false;
+unsigned long netAttemptMs = 0;
+// Failed attempts back off exponentially, so a dead AP or broker costs little time per loop.
+const unsigned long NET_BACKOFF_MIN_MS = 1000;
+const unsigned long NET_BACKOFF_MAX_MS = 60000;
+unsigned long netBackoffMs = 0;
+const unsigned long WIFI_CONNECT_TIMEOUT_MS = 15000;
+// After a regional outage the whole fleet comes back at once. Every unit waits a jitter of its own, drawn
+// from its MAC, before it connects to the broker and again before its backlog goes up, and the backlog then
+// goes at UPLOAD_BYTES_PER_S and UPLOAD_MESSAGES_PER_S at most, or at the "uploadRate" shared attribute.
+const unsigned long MQTT_CONNECT_JITTER_MS = 20000;
+const unsigned long BACKLOG_JITTER_MS = 60000;
+const unsigned long UPLOAD_BYTES_PER_S = 2048;
+const unsigned long UPLOAD_MESSAGES_PER_S = 2;
+INFI::InfiniUploadPacer uploadPacer(UPLOAD_BYTES_PER_S, UPLOAD_MESSAGES_PER_S);
+// When the last connect went through, and the jitter drawn for the backlog after it.
+unsigned long onlineMs = 0;
+unsigned long backlogJitterMs = 0;
+// A part that wedges is restarted on its own, the rest keeps sampling and buffering meanwhile.
+// The UART is kicked on every good reply and the scheduler on every completed command, which GS and FWS
+// bring at least every GS_NIGHT_PERIOD. The link on every loop it is up, the MQTT session on every publish.
+const unsigned long UART_WATCHDOG_MS = 300000;
+const unsigned long SCHEDULER_WATCHDOG_MS = 300000;
+const unsigned long NET_WATCHDOG_MS = 600000;
+INFI::InfiniSupervisor supervisor;
+INFI::BYTE uartSubsystem = INFI::SUPERVISOR_SZ;
+INFI::BYTE schedulerSubsystem = INFI::SUPERVISOR_SZ;
+INFI::BYTE linkSubsystem = INFI::SUPERVISOR_SZ;
+INFI::BYTE mqttSubsystem = INFI::SUPERVISOR_SZ;
+// Write failures of sdLog as of the last check, the card is restarted when they grow.
+unsigned long sdFailuresSeen = 0;
+#if NET_TRANSPORT == NET_ETH_LAN8720
+// The WT32-ETH01: PHY address 1, MDC 23, MDIO 18, the oscillator enabled by GPIO16 and clocking GPIO0.
+const INFI::EthernetConfig ETH_CONFIG = { INFI::ETH_TRANSPORT_LAN8720, 1, 23, 18, 16, ETH_CLOCK_GPIO0_IN,
+                                          -1, -1, -1, -1, -1, -1, 0 };
+#elif NET_TRANSPORT == NET_ETH_W5500
+// A W5500 module on the VSPI pins, CS 5, INT 4, no reset line, at 20 MHz.
+const INFI::EthernetConfig ETH_CONFIG = { INFI::ETH_TRANSPORT_W5500, 1, -1, -1, -1, 0,
+                                          5, 4, -1, 18, 19, 23, 20 };
+#endif
+// The AP and lease of the last connect, kept in NVS so a boot reconnects without scanning.
+INFI::WiFiFastState wifiState;
+INFI::InfiniWiFiFast wifiFast(wifiState);
+// The token provisioning got, kept in NVS so a boot connects with it right away. Only
+// provisioned again if the server refuses it, see credentialsRejected().
+const uint16_t THINGSBOARD_MQTT_PORT = 1883;
+const unsigned long PROVISION_TIMEOUT_MS = 5000;
+INFI::DeviceCredentials credentials;
+bool provisionAnswered = false;
+
+// Polling periods of the inverter queries, milliseconds.
+// Rated info, defaults, flags and selectable currents are only re-read at boot
+// and when GS reports that the settings changed.
+const unsigned long GS_PERIOD = 3000;
+// GS is read every GS_PERIOD while PV, the load or the battery current move, and backs off to GS_QUIET_PERIOD
+// while they hold still, e.g. overnight. The thresholds are set in setup().
+const unsigned long GS_QUIET_PERIOD = 48000;
+INFI::InfiniGsCadence gsCadence(GS_PERIOD, GS_QUIET_PERIOD);
+// Once every device's PV has been dark for a while, GS drops to GS_NIGHT_PERIOD and the energy counters,
+// which only PV moves, are not read. The first PV reading brings both back.
+const unsigned long GS_NIGHT_PERIOD = 120000;
+INFI::InfiniDaylight daylights[INFI::POLL_SCHEDULER_DEVICES];
+const unsigned long ENERGY_PERIOD = 10000;
+// GS is sampled at most every GS_PERIOD into gsHistory, and uploaded from there every GS_UPLOAD_PERIOD.
+const unsigned long GS_UPLOAD_PERIOD = 60000;
+// With PSRAM, gsHistory holds a day of samples, about 1.3 MB. A backlog goes up a few publishes per loop.
+const unsigned long GS_HISTORY_PSRAM_SZ = 24UL * 3600 * 1000 / GS_PERIOD;
+const INFI::BYTE GS_UPLOAD_CHUNKS = 4;
+unsigned long gsUploadPeriod = GS_UPLOAD_PERIOD;
+// Offline, samples beyond half of gsHistory are moved to the flash log, this many per loop.
+const INFI::BYTE GS_SPILL_RECORDS = 32;
+// With PSRAM, a day of 1 min and a month of 1 h aggregates.
+const unsigned long ROLLUP_MINUTES_PSRAM_SZ = 24UL * 60;
+const unsigned long ROLLUP_HOURS_PSRAM_SZ = 24UL * 31;
+// The log is replayed a few samples at a time, so it does not hold up the live telemetry.
+const unsigned long LOG_DRAIN_PERIOD = 2000;
+const INFI::BYTE LOG_DRAIN_RECORDS = 8;
+// Local time of the inverter ahead of UTC, for the sample timestamps. India is +5.5 h.
+const long INVERTER_UTC_OFFSET_S = 19800;
+const unsigned long FWS_PERIOD = 10000;
+// While any inverter has a fault or warning up, FWS is polled this often to catch it clearing.
+const unsigned long FWS_ACTIVE_PERIOD = 2000;
+unsigned long fwsPeriod = FWS_PERIOD;
+// After an RPC changed a setting, read just that setting back and upload it right away,
+// instead of trusting the ^1 until the next settings change re-reads everything.
+const bool READ_BACK_SETTINGS = true;
+// Set by a read-back, so its telemetry goes up without waiting for the queues to drain.
+bool settingsReadBack = false;
+const unsigned long LINK_STATS_PERIOD = 600000;
+const unsigned long RESOURCE_STATS_PERIOD = 60000;
+// A stats upload that failed is tried again this much later, instead of a whole period.
+const unsigned long STATS_RETRY_MS = 5000;
+
+
+// Telemetry keys, passed as the context of the queued commands.
+char GEN_ENERGY_DAY_KEY[] = "gen_energy_day";
+char GEN_ENERGY_MONTH_KEY[] = "gen_energy_month";
+char GEN_ENERGY_YEAR_KEY[] = "gen_energy_year";
+char PIRI_KEY[] = "piri";
+char FLAG_KEY[] = "flag";
+char DI_KEY[] = "di";
+char MCHGCR_KEY[] = "mchgcr";
+char MUCHGCR_KEY[] = "muchgcr";
+// PI, ID and VFW of each inverter, uploaded together once all three are in.
+INFI::DeviceInfo deviceInfos[INFI::POLL_SCHEDULER_DEVICES];
+// PIRI and DI of every device, uploaded as client attributes when they change and kept in NVS per series number.
+INFI::InfiniStaticInfo staticInfos[INFI::POLL_SCHEDULER_DEVICES];
+INFI::BYTE deviceInfoParts[INFI::POLL_SCHEDULER_DEVICES];
+
+// Device 0 keeps the bare telemetry keys, so a single inverter uploads what it always did.
+// The others get an "inv<id>_" prefix to keep their readings apart.
+const char *deviceKey(INFI::BYTE deviceId, const char *key) {
+  static char prefixed[32];
+  if (deviceId == 0) {
+    return key;
+  }
+  snprintf(prefixed, sizeof(prefixed), "inv%u_%s", deviceId, key);
+  return prefixed;
+}
+
+// A telemetryJson writer that applies the deviceKey() prefix to every key.
+struct DeviceJson {
+  char prefix[8];
+  INFI::InfiniBufferPrint buffer;
+  INFI::InfiniKeyPrefixPrint prefixed;
+  Print &out;
+
+  DeviceJson(INFI::BYTE deviceId) :
+    buffer(telemetryJson, sizeof(telemetryJson)),
+    prefixed(buffer, prefix),
+    out(deviceId == 0 ? (Print &)buffer : (Print &)prefixed)
+  {
+    snprintf(prefix, sizeof(prefix), "inv%u_", deviceId);
+  }
+};
+
+bool publishBatch(const char *json, void *context) {
+  INFI_TRACE_SCOPE(INFI::TRACE_PUBLISH, 0);
+  if (tb.sendTelemetryJson(json)) {
+    return true;
+  }
+  Serial.println("Could not upload telemetry to Thingsboard");
+  // What went missing is sent in full next time.
+  for (INFI::BYTE d = 0; d < INFI::POLL_SCHEDULER_DEVICES; ++d) {
+    gsDeltas[d].forceFullSnapshot();
+    faultTrackers[d].forceFullSnapshot();
+  }
+  return false;
+}
+
+// Seals the batch once every queue has drained, i.e. at the end of a poll cycle,
+// or at once for a settings read-back. loop() publishes it with publishSealed().
+void flushTelemetryIfIdle() {
+  if (settingsReadBack) {
+    settingsReadBack = false;
+    telemetryBatch.flush();
+    return;
+  }
+  for (INFI::BYTE d = 0; d < pollScheduler.deviceCount(); ++d) {
+    if (deviceQueues[d]->isBusy() || !deviceQueues[d]->isEmpty()) {
+      return;
+    }
+  }
+  telemetryBatch.flush();
+}
+
+// Uploads the GS samples taken since the last upload as timestamped telemetry arrays.
+// A backlog left after GS_UPLOAD_CHUNKS publishes is continued on the next loop.
+void uploadGsHistory() {
+  if (!gsBacklog && millis() - gsUploadedMs < gsUploadPeriod) {
+    return;
+  }
+  gsUploadedMs = millis();
+  gsBacklog = false;
+  if (!gsHistory.isEmpty()) {
+    openFlushWindow();
+  }
+  for (INFI::BYTE chunk = 0; !gsHistory.isEmpty(); ++chunk) {
+    if (chunk == GS_UPLOAD_CHUNKS) {
+      gsBacklog = true;
+      break;
+    }
+    // Only keep the delta's view of what was published if the upload went through.
+    INFI::GeneralStatusDelta delta = gsDeltas[0];
+    INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+    INFI::BYTE consumed = gsHistory.writeJson(json, delta, sizeof(batchJson) - 1);
+    if (consumed == 0) {
+      break;
+    }
+    if (json.length() > 2 && !uploadPacer.take(json.length(), millis())) {
+      // Over the upload rate, the rest goes once the buckets refilled.
+      gsBacklog = true;
+      break;
+    }
+    if (json.length() > 2 && !tb.sendTelemetryJson(telemetryJson)) {
+      Serial.println("Could not upload the GS history to Thingsboard");
+      break;
+    }
+    gsDeltas[0] = delta;
+    gsHistory.pop(consumed);
+  }
+}
+
+// Moves the oldest GS samples to the flash log while offline, so they survive an outage longer
+// than gsHistory holds, and a reboot. The newer half stays in RAM, ready to go out on reconnect.
+void spillGsHistory() {
+  INFI::GeneralStatusFixed gs;
+  uint64_t tsMs;
+  for (INFI::BYTE n = 0; n < GS_SPILL_RECORDS && gsHistory.size() > gsHistory.capacity() / 2; ++n) {
+    if (!gsHistory.oldest(gs, tsMs)) {
+      break;
+    }
+    if (!telemetryLog.append(gs, tsMs)) {
+      // No partition or a failed write, gsHistory keeps them until it overflows. Counted in telemetryLog.dropped().
+      break;
+    }
+    rollup.add(gs, tsMs);
+    gsHistory.pop(1);
+  }
+}
+
+// Uploads one array of the aggregates of the outage per loop, the hours first as they cover the most.
+// Returns true once both tiers are empty.
+bool uploadRollups() {
+  for (INFI::BYTE t = INFI::NUM_ROLLUP_TIERS; t-- > 0;) {
+    const INFI::ROLLUP_TIER tier = (INFI::ROLLUP_TIER)t;
+    if (rollup.isEmpty(tier)) {
+      continue;
+    }
+    INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+    INFI::BYTE consumed = rollup.writeJson(tier, json, sizeof(batchJson) - 1);
+    if (json.length() > 2 && !uploadPacer.take(json.length(), millis())) {
+      return false;
+    }
+    if (json.length() > 2 && !tb.sendTelemetryJson(telemetryJson)) {
+      Serial.println("Could not upload the GS rollups to Thingsboard");
+      return false;
+    }
+    rollup.pop(tier, consumed);
+    return false;
+  }
+  return true;
+}
+
+// Uploads a few of the logged samples, dropping them from the log only once the upload went through.
+// Returns true once the log is empty.
+bool drainTelemetryLog() {
+  if (!telemetryLog.hasRecords()) {
+    return true;
+  }
+  if (telemetryLog.isVerifying()) {
+    return false;
+  }
+  if (!logVerifyReported) {
+    logVerifyReported = true;
+    if (telemetryLog.corrupted() > 0) {
+      Serial.printf("%lu logged samples failed their CRC and are skipped\n", telemetryLog.corrupted());
+    }
+  }
+  if (millis() - logDrainedMs < LOG_DRAIN_PERIOD) {
+    return false;
+  }
+  logDrainedMs = millis();
+  // What was left by the upload rate or a failed publish goes on from where it stopped.
+  if (logReplay.isEmpty()) {
+    logReplayRead = telemetryLog.peek(logReplay, LOG_DRAIN_RECORDS);
+    if (logReplayRead == 0) {
+      // Unreadable, do not hold up the live uploads behind it.
+      return true;
+    }
+  }
+  // Old samples are sent in full, the live delta's view of what was published is left alone.
+  INFI::GeneralStatusDelta delta = gsDeltas[0];
+  delta.forceFullSnapshot();
+  while (!logReplay.isEmpty()) {
+    INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+    INFI::BYTE consumed = logReplay.writeJson(json, delta, sizeof(batchJson) - 1);
+    if (consumed == 0) {
+      break;
+    }
+    if (json.length() > 2 && !uploadPacer.take(json.length(), millis())) {
+      return false;
+    }
+    if (json.length() > 2 && !tb.sendTelemetryJson(telemetryJson)) {
+      Serial.println("Could not upload the GS log to Thingsboard");
+      return false;
+    }
+    logReplay.pop(consumed);
+  }
+  // A sample too long for a publish is dropped with the rest.
+  logReplay.pop(logReplay.size());
+  telemetryLog.consume(logReplayRead);
+  return !telemetryLog.hasRecords();
+}
+
+// The energy the first inverter kept from before it was monitored, read back a day or month at a time
+// whenever its link is idle and ThingsBoard is reachable, and resumed from NVS after a reboot.
+INFI::InfiniEnergyBackfill energyBackfill(cmdQueue, respParser);
+// A result not published yet, a timestamped telemetry array. The sweep waits until it went up.
+char backfillJson[96];
+unsigned long backfillSavedMs = 0;
+// Progress goes to NVS at most this often.
+const unsigned long BACKFILL_SAVE_PERIOD = 60000;
+
+void onBackfillResult(INFI::COMMAND_TYPE commandType, unsigned long startS, unsigned long wh, void *context) {
+  // Into the keys of the live counters, at the start of their day or month in UTC.
+  snprintf(backfillJson, sizeof(backfillJson), "[{\"ts\":%lu000,\"values\":{\"%s\":%lu}}]",
+           INFI::UNIX_SECONDS_AT_2000 + startS - INVERTER_UTC_OFFSET_S,
+           commandType == INFI::GEN_ENERGY_DAY ? GEN_ENERGY_DAY_KEY : GEN_ENERGY_MONTH_KEY, wh);
+}
+
+// Publishes the last backfill result, then lets the sweep queue the next query.
+void serviceBackfill() {
+  if (backfillJson[0] != '\0') {
+    if (!tb.sendTelemetryJson(backfillJson)) {
+      return;
+    }
+    backfillJson[0] = '\0';
+  }
+  if (!energyBackfill.isStarted()) {
+    char today[INFI::TIME_DAY_SZ + 1];
+    if (!inverterClocks[0].getToday(today, millis()) || !energyBackfill.begin(today)) {
+      return;
+    }
+  }
+  energyBackfill.loop(millis());
+  if (energyBackfill.isDirty() && (energyBackfill.isDone() || millis() - backfillSavedMs >= BACKFILL_SAVE_PERIOD)) {
+    backfillSavedMs = millis();
+    if (!energyBackfill.save()) {
+      Serial.println("Could not store the energy backfill");
+    } else if (energyBackfill.isDone()) {
+      Serial.printf("Energy backfill done, %u days and %u months\n", energyBackfill.state().days,
+                    energyBackfill.state().months);
+    }
+  }
+}
+
+// The energy of the first inverter's past days, months and years, as the backfill and the getEnergy RPC read it.
+// The queue answers those queries from here once they were read, and the tables are kept in NVS.
+INFI::InfiniEnergyHistory energyHistory;
+unsigned long energyHistorySavedMs = 0;
+
+// Moves the history on to the inverter's day, then keeps what it learnt at most every BACKFILL_SAVE_PERIOD.
+void serviceEnergyHistory() {
+  char today[INFI::TIME_DAY_SZ + 1];
+  if (inverterClocks[0].getToday(today, millis())) {
+    energyHistory.setToday(today);
+  }
+  if (energyHistory.isDirty() && millis() - energyHistorySavedMs >= BACKFILL_SAVE_PERIOD) {
+    energyHistorySavedMs = millis();
+    if (!energyHistory.save()) {
+      Serial.println("Could not store the energy history");
+    }
+  }
+}
+
+// Uploads the map of the short GS keys once, see SHORT_GS_KEYS.
+void uploadGsKeyMap() {
+  if (!SHORT_GS_KEYS || gsKeyMapSent) {
+    return;
+  }
+  INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+  INFI::writeGeneralStatusKeyMapJson("gsKeys", json);
+  gsKeyMapSent = tb.sendAttributeJSON(telemetryJson);
+}
+
+// How busy each link is in permille, the factor the periods were stretched by, and per query its requested,
+// scheduled and achieved periods, the last one per device, e.g. {"pollLoad":[830],"pollScale":1000,"pollGS":[...]}.
+void writePollRates(Print &out) {
+  out.print("{\"pollLoad\":[");
+  for (INFI::BYTE d = 0; d < pollScheduler.deviceCount(); ++d) {
+    if (d > 0) {
+      out.print(',');
+    }
+    out.print(pollScheduler.utilization(d));
+  }
+  out.print("],\"pollScale\":");
+  out.print(pollScheduler.periodScale());
+  INFI::PollRates rates;
+  for (INFI::BYTE i = 0; i < INFI::NUM_COMMAND_TYPES; ++i) {
+    if (!pollScheduler.getRates((INFI::COMMAND_TYPE)i, 0, rates)) {
+      continue;
+    }
+    out.print(",\"poll");
+    out.print(INFI::getCommandDescriptor((INFI::COMMAND_TYPE)i).mnemonic);
+    out.print("\":[");
+    out.print(rates.requestedMs);
+    out.print(',');
+    out.print(rates.scheduledMs);
+    for (INFI::BYTE d = 0; d < pollScheduler.deviceCount(); ++d) {
+      pollScheduler.getRates((INFI::COMMAND_TYPE)i, d, rates);
+      out.print(',');
+      out.print(rates.achievedMs);
+    }
+    out.print(']');
+  }
+  out.print('}');
+}
+
+// Uploads the link counters as attributes, they are totals since boot, the learnt turnarounds and the poll rates.
+void uploadLinkStats(void *) {
+  INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+  linkStats.writeJson(json);
+  bool sent = tb.sendAttributeJSON(telemetryJson);
+  if (sent) {
+    INFI::InfiniBufferPrint calibrationJson(telemetryJson, sizeof(telemetryJson));
+    linkCalibration.writeJson(calibrationJson);
+    sent = tb.sendAttributeJSON(telemetryJson);
+  }
+  if (sent) {
+    INFI::InfiniBufferPrint ratesJson(telemetryJson, sizeof(telemetryJson));
+    writePollRates(ratesJson);
+    sent = tb.sendAttributeJSON(telemetryJson);
+  }
+  if (!sent) {
+    // The period goes on from the retry.
+    timers.restart(linkStatsTimer, STATS_RETRY_MS, millis());
+  }
+}
+
+// The pipeline's own counters for /metrics, next to the snapshot and link ones. Runs on the HTTP task, so it only
+// reads counters, each a word the loop writes in one store.
+size_t writePipelineMetrics(Print &out, void *) {
+  size_t n = INFI::writeMetricFamily(out, "infini_queue_depth", INFI::METRIC_GAUGE, "Commands waiting to be sent");
+  n += INFI::writeMetricSample(out, "infini_queue_depth", INFI::METRIC_GAUGE, cmdQueue.size());
+  n += INFI::writeMetricFamily(out, "infini_history_samples", INFI::METRIC_GAUGE, "GS samples held for the uplink");
+  n += INFI::writeMetricSample(out, "infini_history_samples", INFI::METRIC_GAUGE, gsHistory.size());
+  n += INFI::writeMetricFamily(out, "infini_history_dropped", INFI::METRIC_COUNTER, "GS samples lost to a full history");
+  n += INFI::writeMetricSample(out, "infini_history_dropped", INFI::METRIC_COUNTER, gsHistory.dropped());
+  n += INFI::writeMetricFamily(out, "infini_log_records", INFI::METRIC_GAUGE, "Records in the flash log");
+  n += INFI::writeMetricSample(out, "infini_log_records", INFI::METRIC_GAUGE, telemetryLog.size());
+  n += INFI::writeMetricFamily(out, "infini_log_dropped", INFI::METRIC_COUNTER, "Records the flash log lost");
+  n += INFI::writeMetricSample(out, "infini_log_dropped", INFI::METRIC_COUNTER, telemetryLog.dropped());
+  n += INFI::writeMetricFamily(out, "infini_sd_queue_dropped", INFI::METRIC_COUNTER, "Samples the SD card fell behind on");
+  n += INFI::writeMetricSample(out, "infini_sd_queue_dropped", INFI::METRIC_COUNTER, sdQueue.dropped());
+  n += INFI::writeMetricFamily(out, "infini_bridge_forwarded", INFI::METRIC_COUNTER, "Vendor tool frames sent on");
+  n += INFI::writeMetricSample(out, "infini_bridge_forwarded", INFI::METRIC_COUNTER, bridge.forwarded());
+  return n;
+}
+
+// Uploads the stack and heap minima, they are the worst since boot.
+void uploadResourceStats(void *) {
+  INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+  resources->writeJson(json);
+  if (!tb.sendTelemetryJson(telemetryJson)) {
+    timers.restart(resourceStatsTimer, STATS_RETRY_MS, millis());
+  }
+}
+
+// Command queue callbacks
+void onEnergy(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  const char *key = (const char *)context;
+  if (status != INFI::SEND_COMPLETE) {
+    Serial.print("No reply for "); Serial.println(key);
+    return;
+  }
+  long energy = respParser.fromInfiniGenEnergyToULong(response.val, response.actualLen);
+  Serial.print(key); Serial.print(" in Wh: "); Serial.println(energy);
+  if (energy < 0) {
+    return;
+  }
+  INFI::InfiniEnergyTracker &tracker = energyTrackers[response.deviceId];
+  if (response.cmdType == INFI::GEN_ENERGY_YEAR) {
+    tracker.onYear(energy);
+  } else if (response.cmdType == INFI::GEN_ENERGY_MONTH) {
+    tracker.onMonth(energy);
+  } else {
+    tracker.onDay(energy);
+    // The month and year counters move with the day's.
+    if (tracker.hasMonth()) {
+      telemetryBatch.addInt(deviceKey(response.deviceId, GEN_ENERGY_MONTH_KEY), tracker.month());
+    }
+    if (tracker.hasYear()) {
+      telemetryBatch.addInt(deviceKey(response.deviceId, GEN_ENERGY_YEAR_KEY), tracker.year());
+    }
+  }
+  telemetryBatch.addInt(deviceKey(response.deviceId, key), energy);
+  INFI::EnergyCounters counters = {
+    tracker.hasDay() ? tracker.day() : INFI::ENERGY_UNKNOWN,
+    tracker.hasMonth() ? tracker.month() : INFI::ENERGY_UNKNOWN,
+    tracker.hasYear() ? tracker.year() : INFI::ENERGY_UNKNOWN
+  };
+  statusCaches[response.deviceId].updateEnergy(counters, millis());
+}
+
+void onCurrentTime(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE || response.actualLen == 0) {
+    Serial.println("Inverter not responding. Perhaps the inverter is disconnected.\n");
+    return;
+  }
+
+  // Check the reply, then sync the clock model to it.
+  INFI::InfiniClock &clock = inverterClocks[response.deviceId];
+  if (respParser.fromILCurrentTimeToILCurrentDay(response.val, response.actualLen) == 0
+      || !clock.sync(response.val + INFI::START_OFFSET_SZ, millis())) {
+    Serial.println("Malformed current time response.\n");
+    return;
+  }
+  Serial.print("Current day: "); Serial.print(respParser.parsed);
+  Serial.print(", clock drift: "); Serial.println(clock.lastDriftS());
+  // Resync sooner if the inverter's clock ran away from ours.
+  pollScheduler.setPeriod(INFI::CURRENT_TIME, clock.resyncPeriodMs());
+
+  // Upload to thingsboard, just the YYYYMMDDHHFFSS digits.
+  char timeDigits[INFI::TIME_SECOND_SZ + 1];
+  memcpy(timeDigits, response.val + INFI::START_OFFSET_SZ, INFI::TIME_SECOND_SZ);
+  timeDigits[INFI::TIME_SECOND_SZ] = '\0';
+  telemetryBatch.addString(deviceKey(response.deviceId, "inverter_time"), timeDigits);
+}
+
+// Queues the energy counters of every device whose clock is synced, with the day from the clock model.
+void pollEnergy() {
+  if (pollScheduler.isNight() || millis() - energyPolledMs < ENERGY_PERIOD) {
+    return;
+  }
+  energyPolledMs = millis();
+  for (INFI::BYTE d = 0; d < pollScheduler.deviceCount(); ++d) {
+    char today[INFI::TIME_DAY_SZ + 1];
+    if (!inverterClocks[d].getToday(today, millis())) {
+      continue;
+    }
+    // The queue copies the params, so today may go out of scope.
+    // EY and EM only go out for a new day, and always ahead of ED so it integrates from their baseline.
+    InfiniCommandQueue &queue = *deviceQueues[d];
+    INFI::BYTE queries = energyTrackers[d].onCurrentDay(today);
+    if (queries & INFI::ENERGY_QUERY_YEAR) {
+      queue.enqueue(INFI::GEN_ENERGY_YEAR, today, onEnergy, GEN_ENERGY_YEAR_KEY);
+    }
+    if (queries & INFI::ENERGY_QUERY_MONTH) {
+      queue.enqueue(INFI::GEN_ENERGY_MONTH, today, onEnergy, GEN_ENERGY_MONTH_KEY);
+    }
+    queue.enqueue(INFI::GEN_ENERGY_DAY, today, onEnergy, GEN_ENERGY_DAY_KEY);
+  }
+}
+
+// Night for the plant once it is night on every device, day again as soon as one sees PV.
+void updateDaylight(const INFI::GeneralStatusFixed &gs, INFI::BYTE deviceId) {
+  const INFI::InfiniClock &clock = inverterClocks[deviceId];
+  long secondOfDay = clock.isSynced() ? (long)(clock.now(millis()) % 86400UL) : INFI::NO_TIME_OF_DAY;
+  if (!daylights[deviceId].update(gs, millis(), secondOfDay)) {
+    return;
+  }
+  bool night = true;
+  for (INFI::BYTE d = 0; d < pollScheduler.deviceCount(); ++d) {
+    night = night && daylights[d].isNight();
+  }
+  if (night != pollScheduler.isNight()) {
+    pollScheduler.setNight(night);
+    Serial.println(night ? "Night, PV queries paused." : "Daylight, full rate polling.");
+  }
+}
+
+// The queue completed a poll, the UART only counts as working if the inverter answered.
+void kickLinkSubsystems(INFI::SEND_STATUS status) {
+  supervisor.kick(schedulerSubsystem, millis());
+  if (status == INFI::SEND_COMPLETE) {
+    supervisor.kick(uartSubsystem, millis());
+  }
+}
+
+// The GS samples of the first inverter around a fault at the link's full rate, read in every gap the polls leave.
+// A new fault or warning, or a raised alarm, uploads the FAULT_CAPTURE_PRE_MS before it and FAULT_CAPTURE_POST_MS
+// after as one compressed BINARY_GS_HISTORY record, base64 under "fault_burst" at the trigger's timestamp.
+// Set FAULT_CAPTURE to false to leave the gaps to the backfill and the bridge.
+const bool FAULT_CAPTURE = true;
+const unsigned long FAULT_CAPTURE_PRE_MS = 10000;
+const unsigned long FAULT_CAPTURE_POST_MS = 20000;
+INFI::InfiniFaultCapture faultCapture(FAULT_CAPTURE_PRE_MS, FAULT_CAPTURE_POST_MS);
+bool faultCaptureQueued = false;
+
+// A fan-out sink, writes the JSON of the sample to the WebSocket clients as is.
+void onGsSample(const INFI::InfiniSampleBuffer &buffer, void *context) {
+  INFI::InfiniGsStream &stream = *(INFI::InfiniGsStream *)context;
+  stream.broadcastPayload(buffer.data, buffer.len, INFI::GS_STREAM_JSON);
+}
+
+void onGeneralStatus(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  kickLinkSubsystems(status);
+  if (status != INFI::SEND_COMPLETE || response.actualLen != INFI::getResponseSize(INFI::GENERAL_STATUS)) {
+    Serial.println("Malformed General Status response.\n");
+    return;
+  }
+  bool parsed;
+  {
+    INFI::InfiniResourceProbe probe(resources, INFI::STAGE_PARSE);
+    parsed = respParser.fromILGSToGeneralStatusFixed(response.val, response.actualLen);
+  }
+  if (!parsed) {
+    Serial.print("Malformed General Status response: ");
+    Serial.println(INFI::getResponseErrorString(respParser.result.error));
+    return;
+  }
+  const INFI::GeneralStatusFixed &gs = respParser.generalStatusFixed;
+  // The rules act on the inverter the commands go to.
+  if (response.deviceId == 0) {
+    rules.evaluate(gs, millis());
+  }
+  if (firstSampleMs == 0) {
+    firstSampleMs = millis();
+    Serial.print("First sample at ");
+    Serial.print(firstSampleMs);
+    Serial.println(" ms");
+  }
+  INFI::GeneralStatusDelta &gsDelta = gsDeltas[response.deviceId];
+  statusCaches[response.deviceId].updateGs(gs, millis());
+  if (gsCadence.update(gs, response.deviceId, millis())) {
+    pollScheduler.setPeriod(INFI::GENERAL_STATUS, gsCadence.periodMs());
+  }
+  updateDaylight(gs, response.deviceId);
+  const uint64_t sampledMs = inverterClocks[response.deviceId].isSynced()
+    ? inverterClocks[response.deviceId].unixMs(millis(), INVERTER_UTC_OFFSET_S) : 0;
+  gsFanout.publish(gs, sampledMs, response.deviceId);
+  if (FAULT_CAPTURE && response.deviceId == 0 && sampledMs != 0) {
+    faultCapture.push(gs, sampledMs);
+  }
+
+  INFI::InfiniResourceProbe probe(resources, INFI::STAGE_SERIALIZE);
+  INFI_TRACE_SCOPE(INFI::TRACE_SERIALIZE, response.cmdType);
+  INFI::GeneralStatusStats &stats = gsStats[response.deviceId];
+  stats.add(gs, millis());
+  if (stats.isWindowDue(millis())) {
+    DeviceJson json(response.deviceId);
+    stats.writeJson(json.out);
+    telemetryBatch.addJson(telemetryJson);
+    stats.startWindow();
+  }
+  if (INFI::POLL_SCHEDULER_DEVICES > 1) {
+    // Upload one plant record once every module reported this tick.
+    plant.update(gs, response.sentUs);
+    if (plant.isComplete(pollScheduler.deviceCount())) {
+      INFI::PlantStatus summary;
+      plant.summarize(summary);
+      plant.startCycle();
+      INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+      INFI::writePlantStatusJson(summary, json);
+      telemetryBatch.addJson(telemetryJson);
+    }
+  } else if (inverterClocks[response.deviceId].isSynced()) {
+    // Timestamped, so it can go up later with the rest, see uploadGsHistory().
+    gsHistory.push(gs, inverterClocks[response.deviceId].unixMs(millis(), INVERTER_UTC_OFFSET_S));
+  } else if (gsDelta.hasChanges(gs)) {
+    // Only upload the fields that moved, with a full snapshot every now and then.
+    DeviceJson json(response.deviceId);
+    gsDelta.writeJson(gs, json.out);
+    // A failed publish forces a full snapshot, see publishBatch().
+    if (telemetryBatch.addJson(telemetryJson)) {
+      gsDelta.markPublished(gs);
+    }
+  }
+
+  // Re-read the config type queries when the inverter says its settings changed.
+  // The flag can stay raised for a while, so only react to its rising edge.
+  static bool settingsChanged[INFI::POLL_SCHEDULER_DEVICES] = {};
+  if (gs.settingsChanged && !settingsChanged[response.deviceId]) {
+    pollScheduler.notifySettingsChanged(response.deviceId);
+    if (response.deviceId == 0) {
+      // Until PIRI and FLAG are read again, every RPC goes to the inverter.
+      setter.invalidateSettings();
+    }
+  }
+  settingsChanged[response.deviceId] = gs.settingsChanged;
+}
+
+// Decodes the config type replies and uploads them as numeric keys, instead of raw ^D strings.
+void onTypedTelemetry(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  const char *key = (const char *)context;
+  if (status != INFI::SEND_COMPLETE) {
+    Serial.print("No reply for "); Serial.println(key);
+    return;
+  }
+
+  // Decoding and writing the JSON are interleaved here, both count as parsing.
+  INFI::InfiniResourceProbe probe(resources, INFI::STAGE_PARSE);
+  DeviceJson deviceJson(response.deviceId);
+  Print &json = deviceJson.out;
+  // One table lookup picks the decoder of response.cmdType.
+  INFI::InfiniDecoded decoded;
+  if (!respParser.decode(response, decoded)) {
+    Serial.print("Malformed "); Serial.print(key); Serial.print(" response: ");
+    Serial.println(INFI::getResponseErrorString(respParser.result.error));
+    return;
+  }
+  INFI::writeDecodedJson(decoded, key, json);
+  if ((decoded.cmdType == INFI::QUERY_MAX_CHARGING_CURRENT || decoded.cmdType == INFI::QUERY_MAX_AC_CHARGING_CURRENT)
+      && response.deviceId == 0) {
+    // The currents the setter lets through, see RPC_BINDINGS.
+    setter.setChargingCurrents(decoded.cmdType, decoded.currents);
+  }
+  if (decoded.cmdType == INFI::QUERY_ENABLE_DISABLE_STATUS && response.deviceId == 0) {
+    // The switches an RPC that changes nothing is answered from, see processEnableDisableStatus().
+    setter.updateFlags(decoded.flag);
+  }
+  telemetryBatch.addJson(telemetryJson);
+}
+
+// The capture's own GS reads, they only go into the burst.
+void onCaptureStatus(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  faultCaptureQueued = false;
+  if (status != INFI::SEND_COMPLETE || !inverterClocks[0].isSynced()
+      || !respParser.fromILGSToGeneralStatusFixed(response.val, response.actualLen)) {
+    return;
+  }
+  if (faultCapture.push(respParser.generalStatusFixed, inverterClocks[0].unixMs(millis(), INVERTER_UTC_OFFSET_S))) {
+    Serial.printf("Fault capture done, %lu samples\n", faultCapture.samples().size());
+  }
+}
+
+// Queues the next capture read once the link is idle and no poll falls due before it could end.
+void serviceFaultCapture() {
+  if (!FAULT_CAPTURE || faultCaptureQueued || faultCapture.isReady() || !inverterClocks[0].isSynced()
+      || !pollScheduler.fitsBackground(0, INFI::GENERAL_STATUS)) {
+    return;
+  }
+  faultCaptureQueued = cmdQueue.enqueueWithPriority(INFI::PRIORITY_BACKGROUND, INFI::GENERAL_STATUS, "",
+                                                    onCaptureStatus);
+}
+
+// Prints what is written to it as base64 into out, so a binary record goes into a JSON string without a copy.
+class Base64Print : public Print {
+  public:
+  explicit Base64Print(Print &out) : m_out(out), m_count(0), m_encoded(0) {}
+
+  size_t write(uint8_t c) override {
+    m_group[m_count++] = c;
+    if (m_count == 3) {
+      finish();
+    }
+    return 1;
+  }
+
+  //! Writes the last group, padded. Call once after the last byte.
+  void finish() {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    if (m_count == 0) {
+      return;
+    }
+    const uint32_t bits = (uint32_t)m_group[0] << 16 | (m_count > 1 ? (uint32_t)m_group[1] << 8 : 0)
+                          | (m_count > 2 ? m_group[2] : 0);
+    char chars[4];
+    for (INFI::BYTE i = 0; i < 4; ++i) {
+      chars[i] = i <= m_count ? ALPHABET[(bits >> (18 - 6 * i)) & 0x3F] : '=';
+    }
+    m_encoded += m_out.write((const uint8_t *)chars, sizeof(chars));
+    m_count = 0;
+  }
+
+  //! Chars written to out.
+  size_t encoded() const {
+    return m_encoded;
+  }
+
+  private:
+  Print &m_out;
+  uint8_t m_group[3];
+  INFI::BYTE m_count;
+  size_t m_encoded;
+};
+
+// The burst as [{"ts":...,"values":{"fault_burst":"..."}}].
+size_t writeFaultBurstJson(Print &out) {
+  size_t n = out.printf("[{\"ts\":%llu,\"values\":{\"fault_burst\":\"",
+                        (unsigned long long)faultCapture.triggerMs());
+  Base64Print base64(out);
+  faultCapture.writeBinary(base64);
+  base64.finish();
+  return n + base64.encoded() + out.print("\"}}]");
+}
+
+// Uploads a complete burst, and arms the capture again once it went up.
+// It goes up in one publish, so a burst that does not fit the MQTT buffer is dropped, raise MQTT_BUFFER_SZ to keep those.
+void publishFaultBurst() {
+  if (!faultCapture.isReady()) {
+    return;
+  }
+  // A dry run first, the buffer would cut it short without saying.
+  INFI::InfiniCountingPrint counter;
+  writeFaultBurstJson(counter);
+  if (counter.count() >= sizeof(telemetryJson)) {
+    Serial.printf("Fault burst of %u bytes does not fit the MQTT buffer, dropped\n", (unsigned)counter.count());
+    faultCapture.release();
+    return;
+  }
+  INFI::InfiniBufferPrint json(telemetryJson, sizeof(telemetryJson));
+  writeFaultBurstJson(json);
+  if (tb.sendTelemetryJson(telemetryJson)) {
+    faultCapture.release();
+  }
+}
+
+// Uploads only the FWS flags that changed, and polls faster while a fault or warning is up.
+void onFaultWarningStatus(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  kickLinkSubsystems(status);
+  if (status != INFI::SEND_COMPLETE) {
+    Serial.println("No reply for fws");
+    return;
+  }
+  INFI::FaultWarningStatus fws;
+  if (!respParser.fromFWSToFaultWarningStatus(response.val, response.actualLen, fws)) {
+    Serial.print("Malformed fws response: ");
+    Serial.println(INFI::getResponseErrorString(respParser.result.error));
+    return;
+  }
+  statusCaches[response.deviceId].updateFws(fws, millis());
+  if (FAULT_CAPTURE && response.deviceId == 0 && inverterClocks[0].isSynced()
+      && faultCapture.onFaultWarning(fws, inverterClocks[0].unixMs(millis(), INVERTER_UTC_OFFSET_S))) {
+    Serial.println("Fault capture triggered by FWS");
+  }
+
+  static bool active[INFI::POLL_SCHEDULER_DEVICES] = {};
+  active[response.deviceId] = INFI::FaultWarningTracker::isActive(fws);
+  bool anyActive = false;
+  for (INFI::BYTE d = 0; d < INFI::POLL_SCHEDULER_DEVICES; ++d) {
+    anyActive |= active[d];
+  }
+  pollScheduler.setPeriod(INFI::FAULT_WARNING_STATUS, anyActive ? FWS_ACTIVE_PERIOD : fwsPeriod);
 
-// Main application loop delay
-int quant = 20;
-unsigned long quant_now = 0;
+  INFI::FaultWarningTracker &tracker = faultTrackers[response.deviceId];
+  if (!tracker.hasEvents(fws)) {
+    return;
+  }
+  DeviceJson json(response.deviceId);
+  tracker.writeEventsJson(fws, json.out);
+  // A failed publish reports the whole FWS next time, see publishBatch().
+  if (telemetryBatch.addJson(telemetryJson)) {
+    tracker.markPublished(fws);
+  }
+}
 
-// Period of delay for Wifi (re)connection attempt.
-int wifi_connect_delay = 500;
+// The read-back the queue sends after an accepted SET, see READ_BACK_SETTINGS.
+void onReadBack(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (response.cmdType == INFI::CURRENT_TIME) {
+    onCurrentTime(response, status, NULL);
+  } else if (response.cmdType == INFI::QUERY_ENABLE_DISABLE_STATUS) {
+    onTypedTelemetry(response, status, FLAG_KEY);
+  } else {
+    // PIRI, which holds the charging currents too, MCHGCR and MUCHGCR only list the ones allowed.
+    onStaticInfo(response, status, PIRI_KEY);
+  }
+  settingsReadBack = true;
+}
 
-// Time passed after Wifi (re)connection attempted.
-unsigned long wifi_connect_passed = 0;
+// Uploads PIRI and DI as client attributes if they changed since they last went up, and keeps them in NVS.
+void publishStaticInfo(INFI::BYTE deviceId) {
+  INFI::InfiniStaticInfo &info = staticInfos[deviceId];
+  if (info.isChanged() && netState == NET_ONLINE) {
+    DeviceJson piriJson(deviceId);
+    INFI::writeRatedInformationJson(info.piri(), piriJson.out);
+    if (!tb.sendAttributeJSON(telemetryJson)) {
+      return;
+    }
+    DeviceJson diJson(deviceId);
+    INFI::writeDefaultValuesJson(info.di(), diJson.out);
+    if (!tb.sendAttributeJSON(telemetryJson)) {
+      return;
+    }
+    info.markPublished();
+  }
+  info.save();
+}
 
-// Period of sending inverter data.
-int send_delay = 10000;
+// Takes PIRI and DI from NVS if they were kept for this unit, otherwise reads them. NULL if ID had no valid reply.
+void loadStaticInfo(INFI::BYTE deviceId, const char *seriesNumber) {
+  INFI::InfiniStaticInfo &info = staticInfos[deviceId];
+  if (seriesNumber != NULL) {
+    info.setSeriesNumber(seriesNumber);
+    if (info.isComplete() || info.load()) {
+      statusCaches[deviceId].updatePiri(info.piri(), millis());
+      return;
+    }
+  }
+  pollScheduler.trigger(INFI::QUERY_RATED_INFORMATION, deviceId);
+  pollScheduler.trigger(INFI::QUERY_DEFAULT_VALUE, deviceId);
+}
 
-// Time passed after inverter data was sent, milliseconds.
-int send_passed = 0;
+// PIRI and DI replies, uploaded by publishStaticInfo() instead of as telemetry, they seldom change.
+void onStaticInfo(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  const char *key = (const char *)context;
+  if (status != INFI::SEND_COMPLETE) {
+    Serial.print("No reply for "); Serial.println(key);
+    return;
+  }
+  INFI::InfiniDecoded decoded;
+  if (!respParser.decode(response, decoded)) {
+    Serial.print("Malformed "); Serial.print(key); Serial.print(" response: ");
+    Serial.println(INFI::getResponseErrorString(respParser.result.error));
+    return;
+  }
+  INFI::InfiniStaticInfo &info = staticInfos[response.deviceId];
+  if (decoded.cmdType == INFI::QUERY_RATED_INFORMATION) {
+    statusCaches[response.deviceId].updatePiri(decoded.piri, millis());
+    info.updatePiri(decoded.piri);
+    if (response.deviceId == 0) {
+      // Only a fresh reply, what NVS kept may predate a change made on the inverter's panel.
+      setter.updateSettings(decoded.piri, PARALLEL_MACHINE);
+    }
+  } else {
+    info.updateDi(decoded.di);
+  }
+  publishStaticInfo(response.deviceId);
+}
 
-// Set to true if application is subscribed for the RPC messages.
-bool subscribed = false;
+// PI, ID and VFW each fill their part of deviceInfos, the whole of it is uploaded once the last one is in.
+void onDeviceInfo(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  if (status != INFI::SEND_COMPLETE) {
+    Serial.println("No reply for the device info");
+    if (response.cmdType == INFI::QUERY_SERIES_NUMBER) {
+      loadStaticInfo(response.deviceId, NULL);
+    }
+    return;
+  }
+  INFI::DeviceInfo &info = deviceInfos[response.deviceId];
+  bool decoded;
+  if (response.cmdType == INFI::QUERY_PROTOCOL_ID) {
+    decoded = respParser.fromPIToDeviceInfo(response.val, response.actualLen, info);
+  } else if (response.cmdType == INFI::QUERY_SERIES_NUMBER) {
+    decoded = respParser.fromIDToDeviceInfo(response.val, response.actualLen, info);
+    loadStaticInfo(response.deviceId, decoded ? info.seriesNumber : NULL);
+  } else {
+    decoded = respParser.fromVFWToDeviceInfo(response.val, response.actualLen, info);
+  }
+  if (!decoded) {
+    Serial.print("Malformed device info response: ");
+    Serial.println(INFI::getResponseErrorString(respParser.result.error));
+    return;
+  }
+  INFI::BYTE &parts = deviceInfoParts[response.deviceId];
+  parts |= 1 << (response.cmdType - INFI::QUERY_PROTOCOL_ID);
+  if (parts == 0x07) {
+    parts = 0;
+    DeviceJson deviceJson(response.deviceId);
+    INFI::writeDeviceInfoJson(info, deviceJson.out);
+    telemetryBatch.addJson(telemetryJson);
+  }
+}
+
+void onWorkingMode(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  INFI::BYTE mode;
+  if (status != INFI::SEND_COMPLETE || !respParser.fromMODToWorkingMode(response.val, response.actualLen, mode)) {
+    Serial.println("No valid reply for the working mode");
+    return;
+  }
+  telemetryBatch.addInt(deviceKey(response.deviceId, "working_mode"), mode);
+}
 
 // RPC handlers
 RPC_Response processEnableDisableStatus(const RPC_Data &data) {
   Serial.println("Received an enable/disable flag status toggle method.");
+  onRpcCall();
 
   // All the enable disable vals are just switches.
   
@@ -71,7 +1237,12 @@ RPC_Response processEnableDisableStatus(const RPC_Data &data) {
   if (k_i == NUM_KEYS) {
     return RPC_Response("unknown", false);
   }
-  cmdSender.sendCommand(INFI::SET_ENABLE_DISABLE_STATUS, e);
+  // Already so, answered without a transaction, unless {"force":true} came along.
+  if (!data["force"].as<bool>() && setter.isFlagUnchanged(e[1], val)) {
+    return RPC_Response(keys[k_i], val);
+  }
+  cmdQueue.sendBlocking(INFI::SET_ENABLE_DISABLE_STATUS, e);
+  setter.invalidateSettings();
   if (cmdSender.response.val[1] == '1') {
     return RPC_Response(keys[k_i], val);
   } else {
@@ -79,355 +1250,803 @@ RPC_Response processEnableDisableStatus(const RPC_Data &data) {
   }
 }
 
-RPC_Response processSetMaxChargingCurrent(const RPC_Data &data) {
-  Serial.println("Received the set max charging current function.");
+// The RPCs that set one value, bound to their command. The value is read from the RPC_Data ThingsBoard
+// already deserialized, checked by the setter and queued in the high priority lane, so the handler returns
+// without waiting for the link. The reply echoes the value, or -1 if it was invalid or the lane was full.
+// Whether the inverter took it shows up with the read-back, see READ_BACK_SETTINGS.
+// A value the inverter has already, by the last PIRI, is echoed without queuing anything. To send it
+// regardless, pass {"value":30,"force":true} instead of the bare value.
+typedef bool (*RpcExtractor)(const RPC_Data &data, INFI::COMMAND_TYPE &commandType, int &value);
 
-  // Get the value from data, which is just int.
-  int current = data.as<int>();
-  Serial.print(current); Serial.println(" Amps");
-  char currentChars[6];
-  currentChars[0] = '0';
-  currentChars[1] = ',';
-  INFI::getThreeDigits(current, currentChars, 2);
-  cmdSender.sendCommand(INFI::SET_MAX_CHARGING_CURRENT, currentChars);
+struct RpcBinding {
+  const char *method;
+  INFI::COMMAND_TYPE commandType;
+  const char *replyKey;
+  RpcExtractor extract;
+};
 
-  if (cmdSender.response.val[1] == '1') {
-    return RPC_Response("set_mchgcr", current);
-  } else {
-    return RPC_Response("set_mchgcr", -1);
+// The params are the value itself, e.g. 30 for setMaxChargingCurrent, or {"value":30}.
+bool extractValue(const RPC_Data &data, INFI::COMMAND_TYPE &commandType, int &value) {
+  if (data.is<int>()) {
+    value = data.as<int>();
+    return true;
+  }
+  if (!data["value"].is<int>()) {
+    return false;
   }
+  value = data["value"].as<int>();
+  return true;
 }
 
-RPC_Response processSetMaxACChargingCurrent(const RPC_Data &data) {
-  Serial.println("Received the set max AC charging current function.");
+// {"ac_out_freq":50}, anything below 55 is 50 Hz.
+bool extractFrequency(const RPC_Data &data, INFI::COMMAND_TYPE &commandType, int &value) {
+  if (!data["ac_out_freq"].is<int>()) {
+    return false;
+  }
+  value = data["ac_out_freq"].as<int>() < 55 ? 50 : 60;
+  commandType = value == 50 ? INFI::AC_OUT_FREQ_50 : INFI::AC_OUT_FREQ_60;
+  return true;
+}
 
-  // Get the value from data, which is just int.
-  int current = data.as<int>();
-  Serial.print(current); Serial.println(" Amps");
-  char currentChars[6];
-  currentChars[0] = '0';
-  currentChars[1] = ',';
-  INFI::getThreeDigits(current, currentChars, 2);
-  cmdSender.sendCommand(INFI::SET_MAX_AC_CHARGING_CURRENT, currentChars);
+const RpcBinding RPC_BINDINGS[] = {
+  { "setMaxChargingCurrent",     INFI::SET_MAX_CHARGING_CURRENT,     "set_mchgcr",  extractValue     },
+  { "setMaxACChargingCurrent",   INFI::SET_MAX_AC_CHARGING_CURRENT,  "set_muchgcr", extractValue     },
+  { "setACOutFreq",              INFI::AC_OUT_FREQ_50,               "ac_out_freq", extractFrequency },
+  { "setOutputSourcePriority",   INFI::SET_OUTPUT_SOURCE_PRIORITY,   "set_pop",     extractValue     },
+  { "setChargingSourcePriority", INFI::SET_CHARGING_SOURCE_PRIORITY, "set_pcp",     extractValue     },
+  { "setSolarPowerPriority",     INFI::SET_SOLAR_POWER_PRIORITY,     "set_psp",     extractValue     },
+  { "setBatteryType",            INFI::SET_BATTERY_TYPE,             "set_pbt",     extractValue     }
+};
 
-  if (cmdSender.response.val[1] == '1') {
-    return RPC_Response("set_muchgcr", current);
-  } else {
-    return RPC_Response("set_muchgcr", -1);
-  }
+// Logs how a bound RPC's command went, context is its RpcBinding.
+void onRpcSetting(const INFI::InfiniResponse &response, INFI::SEND_STATUS status, void *context) {
+  const RpcBinding &binding = *(const RpcBinding *)context;
+  Serial.print(binding.method);
+  Serial.println(status == INFI::SEND_COMPLETE && response.error == INFI::RESP_OK ? " accepted" : " not accepted");
 }
 
-RPC_Response processSetACOutFreq(const RPC_Data &data)
-{
-  Serial.println("Received the set AC Out Frequency method");
-  
-  // Convert rpc call to StaticJsonDocument, because it is just char*
-  StaticJsonDocument<256> doc;
-  deserializeJson(doc, data.as<char*>());
-  serializeJson(doc, Serial);
-  Serial.println();
-  
-  // Get the new frequency from doc.
-  int freq = doc["ac_out_freq"].as<int>();
-  freq = (freq < 55) ? 50 : 60;
-  if (freq == 50) {
-    Serial.println("Setting to 50Hz");
-    cmdSender.sendCommand(INFI::AC_OUT_FREQ_50, {});
-  } else {
-    Serial.println("Setting to 60Hz");
-    cmdSender.sendCommand(INFI::AC_OUT_FREQ_60, {});
+RPC_Response runRpcBinding(const RpcBinding &binding, const RPC_Data &data) {
+  onRpcCall();
+  INFI::COMMAND_TYPE commandType = binding.commandType;
+  int value;
+  char params[INFI::MAX_PARAMS_SZ];
+  if (!binding.extract(data, commandType, value) || value < 0 ||
+      !setter.makeParams(commandType, PARALLEL_MACHINE, value, params)) {
+    return RPC_Response(binding.replyKey, -1);
+  }
+  if (!data["force"].as<bool>() && setter.isUnchanged(commandType, PARALLEL_MACHINE, value)) {
+    Serial.print(binding.method); Serial.println(" unchanged, not sent");
+    return RPC_Response(binding.replyKey, value);
+  }
+  if (!cmdQueue.enqueue(commandType, params, onRpcSetting, (void *)&binding)) {
+    return RPC_Response(binding.replyKey, -1);
   }
+  // The cached value is stale once the SET goes out, whatever the inverter answers.
+  setter.invalidateSettings();
+  return RPC_Response(binding.replyKey, value);
+}
 
-  return RPC_Response("ac_out_freq", freq);
+// One handler per binding, RPC_Callback takes a plain function.
+template <size_t I>
+RPC_Response processBinding(const RPC_Data &data) {
+  return runRpcBinding(RPC_BINDINGS[I], data);
 }
 
-RPC_Response processSetOutputSourcePriority(const RPC_Data &data) {
-  Serial.println("Received the set AC Output Source Priority method");
+RPC_Response processSetDateTime(const RPC_Data &data) {
+  Serial.println("Received the set Date/Time method");
+  onRpcCall();
 
-  int priority = data.as<int>() % 2; // mod 2 makes sure it's 0/1.
-  char priorityChars[2];
-  sprintf(priorityChars, "%d", priority);
-  cmdSender.sendCommand(INFI::SET_OUTPUT_SOURCE_PRIORITY, priorityChars);
+  // Either Unix seconds, or the yymmddhhffss chars of DAT in the inverter's local time.
+  unsigned long seconds;
+  if (data.is<unsigned long>()) {
+    seconds = data.as<unsigned long>() - INFI::UNIX_SECONDS_AT_2000 + INVERTER_UTC_OFFSET_S;
+  } else {
+    const char *dtStr = data.as<const char*>();
+    char digits[INFI::TIME_SECOND_SZ + 1] = "20";
+    if (dtStr == NULL || strlen(dtStr) != INFI::DATE_TIME_PARAMS_SZ) {
+      return RPC_Response("set_dat", false);
+    }
+    strcpy(digits + 2, dtStr);
+    if (!INFI::InfiniClock::parseSeconds(digits, seconds)) {
+      return RPC_Response("set_dat", false);
+    }
+  }
+  INFI::SET_RESULT result = setter.setDateTime(seconds);
+  if (result == INFI::SET_INVALID) {
+    return RPC_Response("set_dat", false);
+  }
+  // The clock model no longer matches, read T again, unless the read-back already does.
+  inverterClocks[0].invalidate();
+  if (!READ_BACK_SETTINGS || result != INFI::SET_ACCEPTED) {
+    pollScheduler.trigger(INFI::CURRENT_TIME);
+  }
 
-  if (cmdSender.response.val[1] == '1') {
-    return RPC_Response("set_pop", priority);
+  if (result == INFI::SET_ACCEPTED) {
+    // The reply is serialized after the return.
+    static char dat[INFI::DATE_TIME_PARAMS_SZ + 1];
+    INFI::InfiniClock::formatDateTime(seconds, dat);
+    return RPC_Response("set_dat", dat);
   } else {
-    return RPC_Response("set_pop", -1);
+    return RPC_Response("set_dat", false);
   }
 }
 
-RPC_Response processSetChargingSourcePriority(const RPC_Data &data) {
-  Serial.println("Received the set Charging Source Priority method");
+// Applies a whole profile in one transaction, e.g. {"pbt":1,"mchgc":30,"muchgc":10,"pop":1,"pcp":2,"rollback":true}.
+// Any subset of pbt, mchgc, muchgc, pop, pcp, psp and ac_out_freq is sent back to back, stopping at the first refusal.
+// With rollback set, what was applied before it is put back. The reply holds the writeJson() outcome.
+// Values the inverter has already are left out, unless "force":true is in the profile too.
+RPC_Response processSetSettingsProfile(const RPC_Data &data) {
+  Serial.println("Received the set settings profile method");
+  onRpcCall();
 
-  int priority = data.as<int>() % 3; // mod 3 makes sure it's 0/1/2
-  char priorityChars[5];
-  sprintf(priorityChars, "0,%d", priority); // hardcode the parallel machine as 0 for now
-  cmdSender.sendCommand(INFI::SET_CHARGING_SOURCE_PRIORITY, priorityChars);
+  settingsBatch.clear();
+  // Values the inverter does not take are left out of the batch.
+  static const struct {
+    const char *key;
+    INFI::COMMAND_TYPE commandType;
+  } PROFILE_KEYS[] = {
+    { "pbt", INFI::SET_BATTERY_TYPE },
+    { "mchgc", INFI::SET_MAX_CHARGING_CURRENT },
+    { "muchgc", INFI::SET_MAX_AC_CHARGING_CURRENT },
+    { "pop", INFI::SET_OUTPUT_SOURCE_PRIORITY },
+    { "pcp", INFI::SET_CHARGING_SOURCE_PRIORITY },
+    { "psp", INFI::SET_SOLAR_POWER_PRIORITY }
+  };
+  const bool force = data["force"].as<bool>();
+  bool unchanged = false;
+  char params[INFI::MAX_PARAMS_SZ];
+  for (const auto &profileKey : PROFILE_KEYS) {
+    const int value = data[profileKey.key].as<int>();
+    if (data.containsKey(profileKey.key) && value >= 0 &&
+        setter.makeParams(profileKey.commandType, PARALLEL_MACHINE, value, params)) {
+      if (force || !setter.isUnchanged(profileKey.commandType, PARALLEL_MACHINE, value)) {
+        settingsBatch.add(profileKey.commandType, params);
+      } else {
+        unchanged = true;
+      }
+    }
+  }
+  if (data.containsKey("ac_out_freq")) {
+    INFI::COMMAND_TYPE freq = data["ac_out_freq"].as<int>() < 55 ? INFI::AC_OUT_FREQ_50 : INFI::AC_OUT_FREQ_60;
+    if (force || !setter.isUnchanged(freq, PARALLEL_MACHINE, 0)) {
+      settingsBatch.add(freq, "");
+    } else {
+      unchanged = true;
+    }
+  }
+  if (settingsBatch.size() == 0) {
+    return RPC_Response("profile", unchanged ? "unchanged" : "empty");
+  }
 
-  if (cmdSender.response.val[1] == '1') {
-    return RPC_Response("set_pcp", priority);
-  } else {
-    return RPC_Response("set_pcp", -1);
+  settingsBatch.run(data["rollback"].as<bool>());
+  setter.invalidateSettings();
+  INFI::InfiniBufferPrint json(settingsBatchJson, sizeof(settingsBatchJson));
+  settingsBatch.writeJson(json);
+  return RPC_Response("profile", settingsBatchJson);
+}
+
+// The energy of one day, month or year in Wh, {"day":"20240131"}, {"month":"202401"} or {"year":"2024"}.
+// A past one is answered from the history without the link once it was read, -1 if it could not be had.
+RPC_Response processGetEnergy(const RPC_Data &data) {
+  Serial.println("Received the get energy method");
+  onRpcCall();
+
+  static const struct {
+    const char *key;
+    INFI::COMMAND_TYPE commandType;
+    INFI::BYTE len;
+  } PERIOD_KEYS[] = {
+    { "day", INFI::GEN_ENERGY_DAY, INFI::TIME_DAY_SZ },
+    { "month", INFI::GEN_ENERGY_MONTH, INFI::TIME_MON_SZ },
+    { "year", INFI::GEN_ENERGY_YEAR, INFI::TIME_YEAR_SZ }
+  };
+  for (const auto &periodKey : PERIOD_KEYS) {
+    const char *params = data[periodKey.key].as<const char*>();
+    if (params == NULL) {
+      continue;
+    }
+    if (strlen(params) != periodKey.len) {
+      return RPC_Response(periodKey.key, -1);
+    }
+    long energy = -1;
+    if (cmdQueue.sendBlocking(periodKey.commandType, params) == INFI::SEND_COMPLETE) {
+      energy = respParser.fromInfiniGenEnergyToULong(cmdSender.response.val, cmdSender.response.actualLen);
+    }
+    return RPC_Response(periodKey.key, energy);
   }
+  return RPC_Response("energy", -1);
 }
 
-RPC_Response processSetSolarPowerPriority(const RPC_Data &data) {
-  Serial.println("Received the set Solar Power Priority method");
+RPC_Callback callbacks[NUM_RPC_CALLBACKS] = {
+  { "enableDisableStatus", processEnableDisableStatus },
+  { RPC_BINDINGS[0].method, processBinding<0> },
+  { RPC_BINDINGS[1].method, processBinding<1> },
+  { RPC_BINDINGS[2].method, processBinding<2> },
+  { RPC_BINDINGS[3].method, processBinding<3> },
+  { RPC_BINDINGS[4].method, processBinding<4> },
+  { RPC_BINDINGS[5].method, processBinding<5> },
+  { RPC_BINDINGS[6].method, processBinding<6> },
+  { "setDateTime", processSetDateTime },
+  { "setSettingsProfile", processSetSettingsProfile },
+  { "getEnergy", processGetEnergy }
+};
 
-  int priority = data.as<int>() % 2; // mod 2 makes sure it's 0/1.
-  char priorityChars[2];
-  sprintf(priorityChars, "%d", priority);
-  cmdSender.sendCommand(INFI::SET_SOLAR_POWER_PRIORITY, priorityChars);
+// The polling policy pushed as shared attributes, applied live and kept in NVS over reboots:
+//   "pollPeriods": {"GS":1000,"FWS":2000}  ms per query mnemonic, e.g. 1 s sampling during an incident.
+//   "deadbands": {"battVolt":2,"pv1InPow":20}  GS deadbands, in the units GeneralStatusFixed stores them in.
+//   "gsUploadPeriod": 60000  how often the sampled GS go up.
+//   "gsFields": "pv1InPow,pv2InPow,battVolt"  the GS fields to upload, empty for all of them.
+//   "rules": "battCapacity<30~10@60:POP=0; invHeatSinkTemp>80~5@5:!overTemp"  local control and alarms,
+//     see InfiniRules. An alarm goes up as the telemetry key alarm_<name>, true while raised.
+//   "uploadRate": {"bytesPerS":2048,"msgsPerS":2}  how fast a backlog goes up, 0 for no limit. Not kept in NVS.
+// Fields outside gsFields are neither decoded nor serialized, except the ones the sketch itself needs.
+INFI::InfiniPollPolicy pollPolicy;
+INFI::InfiniRules rules(cmdQueue, setter);
+const char SHARED_ATTRIBUTE_KEYS[] = "pollPeriods,deadbands,gsUploadPeriod,gsFields,rules,uploadRate";
+const INFI::GsFieldMask GS_REQUIRED_FIELDS = (1UL << INFI::GS_SETTINGS_CHANGED) | (1UL << INFI::GS_LOCAL_PARALLEL_ID) |
+  (1UL << INFI::GS_BATT_VOLT) | (1UL << INFI::GS_BATT_CHARGE_CURR) | (1UL << INFI::GS_BATT_DISCHARGE_CURR) |
+  (1UL << INFI::GS_PV1_IN_POW) | (1UL << INFI::GS_PV2_IN_POW) | (1UL << INFI::GS_AC_OUT_ACTIVE_POW);
 
-  if (cmdSender.response.val[1] == '1') {
-    return RPC_Response("set_psp", priority);
-  } else {
-    return RPC_Response("set_psp", -1);
+void applyPollPolicy() {
+  // A GS period set from the server pins the cadence there.
+  unsigned long gsPeriod = pollPolicy.period(INFI::GENERAL_STATUS);
+  gsCadence.setBounds(gsPeriod > 0 ? gsPeriod : GS_PERIOD, gsPeriod > 0 ? gsPeriod : GS_QUIET_PERIOD);
+  pollScheduler.setPeriod(INFI::GENERAL_STATUS, gsCadence.periodMs());
+  pollScheduler.setNightPeriod(INFI::GENERAL_STATUS, gsPeriod > 0 ? gsPeriod : GS_NIGHT_PERIOD);
+  pollPolicy.apply(pollScheduler);
+  if (pollPolicy.period(INFI::FAULT_WARNING_STATUS) > 0) {
+    fwsPeriod = pollPolicy.period(INFI::FAULT_WARNING_STATUS);
+  }
+  gsUploadPeriod = pollPolicy.flushPeriod() > 0 ? pollPolicy.flushPeriod() : GS_UPLOAD_PERIOD;
+  respParser.setGsFields(pollPolicy.fields() | GS_REQUIRED_FIELDS | rules.fields());
+  for (INFI::BYTE d = 0; d < INFI::POLL_SCHEDULER_DEVICES; ++d) {
+    INFI::GsFieldMask fieldsBefore = gsDeltas[d].fields();
+    pollPolicy.apply(gsDeltas[d]);
+    // Fields just added go up at once.
+    if (gsDeltas[d].fields() != fieldsBefore) {
+      gsDeltas[d].forceFullSnapshot();
+    }
+  }
+}
+
+void processSharedAttributes(const Shared_Attribute_Data &data) {
+  if (data.containsKey("pollPeriods")) {
+    for (JsonPairConst period : data["pollPeriods"].as<JsonObjectConst>()) {
+      if (!pollPolicy.setPeriod(period.key().c_str(), period.value().as<unsigned long>())) {
+        Serial.print("Unknown poll period: "); Serial.println(period.key().c_str());
+      }
+    }
+  }
+  if (data.containsKey("deadbands")) {
+    for (JsonPairConst deadband : data["deadbands"].as<JsonObjectConst>()) {
+      if (!pollPolicy.setDeadband(deadband.key().c_str(), deadband.value().as<INFI::WORD>())) {
+        Serial.print("Unknown deadband: "); Serial.println(deadband.key().c_str());
+      }
+    }
+  }
+  if (data.containsKey("gsUploadPeriod")) {
+    pollPolicy.setFlushPeriod(data["gsUploadPeriod"].as<unsigned long>());
+  }
+  if (data.containsKey("gsFields")) {
+    const char *keys = data["gsFields"].as<const char *>();
+    pollPolicy.setFields(keys != NULL && keys[0] != '\0' ? INFI::parseGsFieldMask(keys) : INFI::GS_ALL_FIELDS);
+  }
+  if (data.containsKey("uploadRate")) {
+    JsonObjectConst rate = data["uploadRate"].as<JsonObjectConst>();
+    unsigned long bytesPerS = rate["bytesPerS"] | uploadPacer.bytesPerS();
+    unsigned long messagesPerS = rate["msgsPerS"] | uploadPacer.messagesPerS();
+    // Sent again on every connect, only a change refills the buckets.
+    if (bytesPerS != uploadPacer.bytesPerS() || messagesPerS != uploadPacer.messagesPerS()) {
+      uploadPacer.setRates(bytesPerS, messagesPerS, millis());
+    }
+  }
+  if (pollPolicy.isDirty()) {
+    applyPollPolicy();
+    if (!pollPolicy.save()) {
+      Serial.println("Could not store the poll policy");
+    }
+  }
+  if (data.containsKey("rules")) {
+    const char *source = data["rules"].as<const char *>();
+    if (source == NULL) {
+      source = "";
+    }
+    // Sent again on every connect, only a change recompiles.
+    if (strcmp(source, rules.source()) != 0) {
+      if (!rules.compile(source)) {
+        Serial.print("Rules do not compile at char "); Serial.println(rules.errorAt());
+      } else {
+        applyPollPolicy();
+        if (!rules.save()) {
+          Serial.println("Could not store the rules");
+        }
+      }
+    }
   }
 }
 
-RPC_Response processSetBatteryType(const RPC_Data &data) {
-  Serial.println("Received the set Battery Type method");
+// The alarm changes not published yet, each a member of a JSON object, e.g. "alarm_low_soc":true.
+// They are events, nothing else ever pushes them out, only a queue full of alarms refuses the next one.
+const size_t ALARM_MEMBER_SZ = 8 + INFI::RULES_ALARM_SZ + 6;
+char alarmQueueStorage[8 * ALARM_MEMBER_SZ];
+INFI::InfiniSinkQueue alarmQueue(alarmQueueStorage, sizeof(alarmQueueStorage), ALARM_MEMBER_SZ, INFI::SINK_BLOCK);
+char alarmJson[128];
 
-  int battType = data.as<int>() % 3; // mod 3 makes sure it's 0/1/2.
-  char battTypeChars[2];
-  sprintf(battTypeChars, "%d", battType);
-  cmdSender.sendCommand(INFI::SET_BATTERY_TYPE, battTypeChars);
+void onRuleAlarm(INFI::BYTE rule, const char *alarm, bool raised, void *context) {
+  Serial.print("Alarm "); Serial.print(alarm); Serial.println(raised ? " raised" : " cleared");
+  if (FAULT_CAPTURE && raised && inverterClocks[0].isSynced()) {
+    faultCapture.trigger(inverterClocks[0].unixMs(millis(), INVERTER_UTC_OFFSET_S));
+  }
+  char member[ALARM_MEMBER_SZ];
+  int n = snprintf(member, sizeof(member), "\"alarm_%s\":%s", alarm, raised ? "true" : "false");
+  if (n < 0 || !alarmQueue.push(member, n, millis(), 0, INFI::SINK_PRIORITY_EVENT)) {
+    Serial.println("Too many alarms to publish, dropped");
+  }
+}
 
-  if (cmdSender.response.val[1] == '1') {
-    return RPC_Response("set_pbt", battType);
-  } else {
-    return RPC_Response("set_pbt", -1);
+// Publishes the alarm changes on their own, ahead of and apart from the batch and the deltas, so they go up
+// in the loop() that sampled them instead of with the next flush.
+void publishAlarms() {
+  INFI::SinkItem members[8];
+  const INFI::BYTE count = alarmQueue.peek(members, 8);
+  if (count == 0) {
+    return;
+  }
+  INFI_TRACE_SCOPE(INFI::TRACE_PUBLISH, 0);
+  size_t len = 0;
+  INFI::BYTE taken = 0;
+  // As many as fit, with room for the braces, the rest go in the next loop().
+  for (; taken < count && len + members[taken].len + 2 < sizeof(alarmJson); ++taken) {
+    alarmJson[len++] = taken == 0 ? '{' : ',';
+    memcpy(alarmJson + len, members[taken].data, members[taken].len);
+    len += members[taken].len;
+  }
+  alarmJson[len++] = '}';
+  alarmJson[len] = '\0';
+  // Kept for the next loop() unless it went up.
+  if (tb.sendTelemetryJson(alarmJson)) {
+    alarmQueue.pop(taken);
   }
 }
 
-RPC_Response processSetDateTime(const RPC_Data &data) {
-  Serial.println("Received the set Date/Time method");
+void onRuleFired(INFI::BYTE rule, INFI::COMMAND_TYPE commandType, bool queued, void *context) {
+  Serial.print("Rule "); Serial.print(rule);
+  Serial.print(queued ? " queued " : " could not queue ");
+  Serial.println(INFI::getCommandDescriptor(commandType).mnemonic);
+}
 
-  // Our custom ng widget should send the correct chars. (lol)
-  const char *dtStr = data.as<const char*>();
-  cmdSender.sendCommand(INFI::SET_DATE_TIME, dtStr);
+Shared_Attribute_Callback sharedAttributesCallback(processSharedAttributes);
+// What changed while offline is asked for on every connect.
+Attribute_Request_Callback sharedAttributesRequest(SHARED_ATTRIBUTE_KEYS, processSharedAttributes);
 
-  if (cmdSender.response.val[1] == '1') {
-    return RPC_Response("set_dat", dtStr);
-  } else {
-    return RPC_Response("set_dat", false);
+bool routeLink(INFI::BYTE channel, INFI::BYTE candidate, unsigned long baud, void *context) {
+  PROBE_UARTS[channel]->begin(baud, SERIAL_8N1, LINK_PINS[candidate].rx, LINK_PINS[candidate].tx);
+  return true;
+}
+
+//! Finds the pins and baud the inverter answers at and leaves Serial2 on them, 16/17 at SERIAL_BAUD if none.
+void discoverLink() {
+  INFI::InfiniLinkDiscovery discovery(probeChannels, 2, routeLink);
+  static const unsigned long DEFAULT_BAUD[] = { INFI::SERIAL_BAUD };
+  const unsigned long *bauds = PROBE_BAUD ? BAUD_CANDIDATES : DEFAULT_BAUD;
+  const INFI::BYTE baudCount = PROBE_BAUD ? sizeof(BAUD_CANDIDATES) / sizeof(BAUD_CANDIDATES[0]) : 1;
+  INFI::DiscoveredLink links[NUM_LINK_PINS];
+  INFI::BYTE found = discovery.discover(NUM_LINK_PINS, bauds, baudCount, links, NUM_LINK_PINS);
+  Serial1.end();
+  for (INFI::BYTE i = 0; i < found; ++i) {
+    Serial.print("Inverter on RX "); Serial.print(LINK_PINS[links[i].candidate].rx);
+    Serial.print(" TX "); Serial.print(LINK_PINS[links[i].candidate].tx);
+    Serial.print(" at "); Serial.println(links[i].baud);
+  }
+  if (found > 1) {
+    Serial.println("Only the first is polled, see deviceQueues for driving more");
   }
+  linkCandidate = found > 0 ? links[0].candidate : 0;
+  linkBaud = found > 0 ? links[0].baud : INFI::SERIAL_BAUD;
+  if (found == 0) {
+    Serial.println("No inverter answered, staying on the first pins");
+  }
+  routeLink(0, linkCandidate, linkBaud, NULL);
+  cmdSender.setBaud(linkBaud);
+}
 
-  return RPC_Response("unknown",NULL);
+// Subsystem restarts of the supervisor, each leaves the others running.
+void restartUart(void *context) {
+  Serial.println("No reply for a while, restarting the UART");
+  Serial2.end();
+  routeLink(0, linkCandidate, linkBaud, NULL);
+  // The driver dropped the event handler with the UART.
+  INFI::attachRxRing(Serial2, rxRing);
+  rxRing.discard();
+  cmdQueue.restart();
 }
 
-RPC_Callback callbacks[NUM_RPC_CALLBACKS] = {
-  { "enableDisableStatus", processEnableDisableStatus },
-  { "setMaxChargingCurrent", processSetMaxChargingCurrent },
-  { "setMaxACChargingCurrent", processSetMaxACChargingCurrent },
-  { "setACOutFreq", processSetACOutFreq },
-  { "setOutputSourcePriority", processSetOutputSourcePriority },
-  { "setChargingSourcePriority", processSetChargingSourcePriority },
-  { "setSolarPowerPriority", processSetSolarPowerPriority },
-  { "setBatteryType", processSetBatteryType },
-  { "setDateTime", processSetDateTime }
-};
+void restartScheduler(void *context) {
+  Serial.println("No command completed for a while, restarting the queue");
+  cmdQueue.restart();
+}
+
+// Only on WiFi, a cable or lease that does not come back is not the driver's fault.
+void restartLink(void *context) {
+  Serial.println("No link for a while, restarting WiFi");
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+  WiFi.mode(WIFI_STA);
+  linkUp = false;
+  netState = NET_LINK_DOWN;
+  netAttemptMs = millis();
+  netBackoffMs = 0;
+}
+
+void restartMqtt(void *context) {
+  Serial.println("Nothing published for a while, restarting the MQTT session");
+  tb.disconnect();
+  netConnectJitter();
+  netState = NET_MQTT_DOWN;
+}
+
+bool onSdRecord(const INFI::SinkItem &item, void *context) {
+  return ((INFI::InfiniSdLog *)context)->appendRecord(item.data, item.len, item.tsMs);
+}
+
+// Writes the queued samples to the card, a few per loop() so a slow card only costs the loops it is slow in.
+// A failed write stays queued, the supervisor remounts the card meanwhile.
+void drainSdQueue() {
+  const INFI::BYTE written = sdQueue.drain(onSdRecord, &sdLog, SD_DRAIN_RECORDS);
+  sdBacklog = written == SD_DRAIN_RECORDS && !sdQueue.isEmpty();
+}
+
+bool isSdHealthy(void *context) {
+  const unsigned long failures = sdLog.failures();
+  const bool healthy = failures == sdFailuresSeen;
+  sdFailuresSeen = failures;
+  return healthy;
+}
+
+void restartSd(void *context) {
+  Serial.println("SD writes failed, remounting the card");
+  sdLog.end();
+  SD.end();
+  if (!SD.begin(SD_CS_PIN) || !sdLog.begin()) {
+    Serial.println("SD card not back");
+  }
+  // What end() failed to flush is not held against the card.
+  sdFailuresSeen = sdLog.failures();
+}
+
+// The network is supervised from its loop, which kicks what has nothing to do.
+void kickNetworkSubsystems() {
+  const unsigned long now = millis();
+  if (linkUp) {
+    supervisor.kick(linkSubsystem, now);
+  }
+  if (netState != NET_ONLINE) {
+    // Connects are retried with their own backoff.
+    supervisor.kick(mqttSubsystem, now);
+  }
+}
 
 void setup() {
   Serial.begin(SERIAL_DEBUG_BAUD);
-  Serial2.begin(INFI::SERIAL_BAUD, SERIAL_8N1, RXD2, TXD2);
-  while(!Serial || !Serial2) {
-    delay(1000);
+  if (!INFI::crc_self_test()) {
+    Serial.println("CRC backend disagrees with the reference, build with -DINFI_CRC_IMPL=INFI_CRC_BYTEWISE");
   }
-  
-  WiFi.begin(WIFI_AP_NAME, WIFI_PASSWORD);
-  InitWiFi();
-  INFI::setupGMTTimeForIndia();
-}
+  if (!INFI::column_kernels_self_test()) {
+    Serial.println("Column kernels disagree with the reference, build with -DINFI_COLUMN_IMPL=INFI_COLUMN_SCALAR");
+  }
+  // Unique per unit, so the fleet draws its jitters apart.
+  const uint64_t mac = ESP.getEfuseMac();
+  uploadPacer.seed((uint32_t)mac ^ (uint32_t)(mac >> 32));
+  // Probe before the RX ring takes Serial2 over, the senders read their streams directly until then.
+  discoverLink();
+  INFI::attachRxRing(Serial2, rxRing);
+  cmdSender.useRxRing(&rxRing);
+  uartSubsystem = supervisor.add("uart", UART_WATCHDOG_MS, NULL, restartUart, NULL, millis());
+  schedulerSubsystem = supervisor.add("scheduler", SCHEDULER_WATCHDOG_MS, NULL, restartScheduler, NULL, millis());
+#if NET_TRANSPORT == NET_WIFI
+  linkSubsystem = supervisor.add("wifi", NET_WATCHDOG_MS, NULL, restartLink, NULL, millis());
+#endif
+  mqttSubsystem = supervisor.add("mqtt", NET_WATCHDOG_MS, NULL, restartMqtt, NULL, millis());
+  cmdSender.setStats(&linkStats);
+  cmdSender.setCalibration(&linkCalibration);
+  linkStatsTimer = timers.start(LINK_STATS_PERIOD, uploadLinkStats, NULL, millis(), LINK_STATS_PERIOD);
+  if (resources != NULL) {
+    resourceStatsTimer = timers.start(RESOURCE_STATS_PERIOD, uploadResourceStats, NULL, millis(), RESOURCE_STATS_PERIOD);
+  }
+  if (READ_BACK_SETTINGS) {
+    cmdQueue.setReadBack(onReadBack);
+  }
+  if (!gsHistory.allocate(GS_HISTORY_PSRAM_SZ)) {
+    Serial.println("No PSRAM, GS history kept in internal RAM");
+  }
+  if (FAULT_CAPTURE && !faultCapture.allocate(INFI::FAULT_CAPTURE_MAX_SAMPLES)) {
+    Serial.printf("No PSRAM, fault captures hold %lu samples\n", faultCapture.samples().capacity());
+  }
+  rollup.allocate(INFI::ROLLUP_MINUTE, ROLLUP_MINUTES_PSRAM_SZ);
+  rollup.allocate(INFI::ROLLUP_HOUR, ROLLUP_HOURS_PSRAM_SZ);
+  rollup.track(INFI::GS_BATT_VOLT);
+  rollup.track(INFI::GS_BATT_CAPACITY);
+  rollup.track(INFI::GS_PV1_IN_POW);
+  rollup.track(INFI::GS_PV2_IN_POW);
+  rollup.track(INFI::GS_AC_OUT_ACTIVE_POW);
+  rollup.track(INFI::GS_GRID_VOLT);
 
-void loop() {
-  if (millis() - quant_now > quant) {
-    quant_now = millis();
-    
-    // Increment send_passed by quant
-    send_passed += quant;
-  
-    // Reconnect to WiFi, if needed
-    if (WiFi.status() != WL_CONNECTED) {
-      reconnect();
-      return;
-    }
-  
-    // Reconnect to ThingsBoard, if needed
-    if (!tb.connected()) {
-      subscribed = false;
-  
-      // Connect to the ThingsBoard
-      Serial.print("Connecting to: ");
-      Serial.println(THINGSBOARD_SERVER);
-      if (!tb.connect(THINGSBOARD_SERVER, THINGSBOARD_TOKEN)) {
-        Serial.println("Failed to connect");
-        return;
-      }
-    }
-  
-    // Subscribe for RPC, if needed
-    if (!subscribed) {
-      Serial.println("Subscribing for RPC...");
-  
-      // Perform a subscription. All consequent data processing will happen in
-      // callbacks as denoted by callbacks[] array.
-      if (!tb.RPC_Subscribe(callbacks, NUM_RPC_CALLBACKS)) {
-        Serial.println("Failed to subscribe for RPC");
-        return;
-      }
-  
-      Serial.println("Subscribe done");
-      subscribed = true;
-    }
-  
-    // Check if it is a time to send inverter data.
-    if (send_passed > send_delay) {
-      //Serial.println("Sending data...");
-      
-      // Reset send_passed in case there's an early return.
-      send_passed = 0;
-
-      // Query the current time
-      Serial.println("Getting current time");
-      cmdSender.sendCommand(INFI::CURRENT_TIME, {});
-      if (cmdSender.response.actualLen == 0) {
-        Serial.println("Inverter not responding. Perhaps the inverter is disconnected.\n");
-        return;
-      }
-      Serial.println();
-
-      // Parse current time to get the current day
-      Serial.println("Parsing current time to get current day");
-      size_t parsedSz = respParser.fromILCurrentTimeToILCurrentDay(cmdSender.response.val, cmdSender.response.actualLen);
-      if (parsedSz == 0) {
-        Serial.println("Malformed response. Please restart device.\n");
-        return;
-      }
-      Serial.print("Current day: "); Serial.println(respParser.parsed);
-      Serial.println();
-
-      // Upload to thingsboard
-      Serial.println("Uploading current date/time to Thingsboard.");
-      tb.sendTelemetryString("inverter_time", cmdSender.response.val);
-
-      // Query the generated energy for the day.
-      Serial.println("Querying generated energy for day");
-      cmdSender.sendCommand(INFI::GEN_ENERGY_DAY, respParser.parsed);
-      Serial.println();
-
-      // Parse the generated energy response and upload
-      Serial.println("Parsing the generated energy response");
-      long energy = respParser.fromInfiniGenEnergyToULong(cmdSender.response.val, cmdSender.response.actualLen);
-      Serial.print("Energy generated today in Wh: "); Serial.println(energy);
-      if (energy >= 0) {        
-        Serial.println("Uploading gen_energy_day to ThingsBoard");
-        tb.sendTelemetryInt("gen_energy_day", energy);
-      }
-      Serial.println();
+  // Deadbands for the noisy GS readings, in the units GeneralStatusFixed stores them in.
+  for (INFI::BYTE d = 0; d < INFI::POLL_SCHEDULER_DEVICES; ++d) {
+    INFI::GeneralStatusDelta &gsDelta = gsDeltas[d];
+    gsDelta.setShortKeys(SHORT_GS_KEYS);
+    gsDelta.setDeadband(INFI::GS_BATT_VOLT, 2);        // 0.2 V
+    gsDelta.setDeadband(INFI::GS_GRID_VOLT, 20);       // 2 V
+    gsDelta.setDeadband(INFI::GS_AC_OUT_VOLT, 20);     // 2 V
+    gsDelta.setDeadband(INFI::GS_PV1_IN_VOLT, 20);     // 2 V
+    gsDelta.setDeadband(INFI::GS_PV2_IN_VOLT, 20);     // 2 V
+    gsDelta.setDeadband(INFI::GS_AC_OUT_ACTIVE_POW, 20);
+    gsDelta.setDeadband(INFI::GS_AC_OUT_APPARENT_POW, 20);
+    gsDelta.setDeadband(INFI::GS_PV1_IN_POW, 20);
+    gsDelta.setDeadband(INFI::GS_PV2_IN_POW, 20);
 
-      // Query the generated energy for the month.
-      Serial.println("Querying generated energy for month");
-      cmdSender.sendCommand(INFI::GEN_ENERGY_MONTH, respParser.parsed);
-      Serial.println();
+    INFI::GeneralStatusStats &stats = gsStats[d];
+    stats.track(INFI::GS_PV1_IN_POW);
+    stats.track(INFI::GS_PV2_IN_POW);
+    stats.track(INFI::GS_AC_OUT_ACTIVE_POW);
+    stats.track(INFI::GS_BATT_CHARGE_CURR);
+    stats.track(INFI::GS_BATT_DISCHARGE_CURR);
+  }
 
-      // Parse the generated energy response and upload
-      Serial.println("Parsing the generated energy response");
-      energy = respParser.fromInfiniGenEnergyToULong(cmdSender.response.val, cmdSender.response.actualLen);
-      Serial.print("Energy generated this month in Wh: "); Serial.println(energy);
-      if (energy >= 0) {
-        Serial.println("Uploading gen_energy_month to ThingsBoard");
-        tb.sendTelemetryInt("gen_energy_month", energy);
-      }
-      Serial.println();
+  // Changes within these a second speed GS up, in the units GeneralStatusFixed stores them in.
+  gsCadence.track(INFI::GS_PV1_IN_POW, 50);
+  gsCadence.track(INFI::GS_AC_OUT_ACTIVE_POW, 50);
+  gsCadence.track(INFI::GS_BATT_CHARGE_CURR, 2);
+  gsCadence.track(INFI::GS_BATT_DISCHARGE_CURR, 2);
 
-      // Query the generated energy for the year.
-      Serial.println("Querying generated energy for year");
-      cmdSender.sendCommand(INFI::GEN_ENERGY_YEAR, respParser.parsed);
-      Serial.println();
+  // Periods the link cannot keep up with, e.g. from the pollPeriods attribute, are stretched alike instead of
+  // leaving the queries to lag. The pollLoad and poll<mnemonic> attributes show by how much.
+  pollScheduler.setAdmission(INFI::POLL_ADMIT_SCALE);
+  // T is read at boot and then only to resync the clock model, ED/EM/EY are queued by pollEnergy().
+  pollScheduler.addPeriodic(INFI::CURRENT_TIME, INFI::CLOCK_RESYNC_MS, onCurrentTime);
+  if (INFI::POLL_SCHEDULER_DEVICES > 1) {
+    // Every module's GS goes out at the same tick, so the plant record adds up readings taken together.
+    pollScheduler.addSynchronized(INFI::GENERAL_STATUS, GS_PERIOD, onGeneralStatus);
+    plant.setAlignment(PLANT_ALIGNMENT_US);
+  } else {
+    pollScheduler.addPeriodic(INFI::GENERAL_STATUS, GS_PERIOD, onGeneralStatus);
+  }
+  pollScheduler.setNightPeriod(INFI::GENERAL_STATUS, GS_NIGHT_PERIOD);
+  pollScheduler.addPeriodic(INFI::FAULT_WARNING_STATUS, FWS_PERIOD, onFaultWarningStatus);
+  pollScheduler.addOnSettingsChanged(INFI::QUERY_RATED_INFORMATION, onStaticInfo, PIRI_KEY);
+  pollScheduler.addOnSettingsChanged(INFI::QUERY_ENABLE_DISABLE_STATUS, onTypedTelemetry, FLAG_KEY);
+  pollScheduler.addOnSettingsChanged(INFI::QUERY_DEFAULT_VALUE, onStaticInfo, DI_KEY);
+  pollScheduler.addOnSettingsChanged(INFI::QUERY_MAX_CHARGING_CURRENT, onTypedTelemetry, MCHGCR_KEY);
+  pollScheduler.addOnSettingsChanged(INFI::QUERY_MAX_AC_CHARGING_CURRENT, onTypedTelemetry, MUCHGCR_KEY);
+  // Only change with a firmware update, which comes with a reboot, but they are cheap to re-read.
+  pollScheduler.addOnSettingsChanged(INFI::QUERY_PROTOCOL_ID, onDeviceInfo);
+  pollScheduler.addOnSettingsChanged(INFI::QUERY_SERIES_NUMBER, onDeviceInfo);
+  pollScheduler.addOnSettingsChanged(INFI::QUERY_CPU_VERSION, onDeviceInfo);
+  // PIRI and DI wait for ID at boot, they may be in NVS already, see loadStaticInfo().
+  pollScheduler.cancel(INFI::QUERY_RATED_INFORMATION);
+  pollScheduler.cancel(INFI::QUERY_DEFAULT_VALUE);
+  pollScheduler.addPeriodic(INFI::QUERY_WORKING_MODE, FWS_PERIOD, onWorkingMode);
 
-      // Parse the generated energy response and upload
-      Serial.println("Parsing the generated energy response");
-      energy = respParser.fromInfiniGenEnergyToULong(cmdSender.response.val, cmdSender.response.actualLen);
-      Serial.print("Energy generated this year in Wh: "); Serial.println(energy);
-      if (energy >= 0) {
-        Serial.println("Uploading gen_energy_year to ThingsBoard");
-        tb.sendTelemetryInt("gen_energy_year", energy);
+  // The policy last pushed from ThingsBoard, until the server sends a newer one.
+  if (pollPolicy.load()) {
+    applyPollPolicy();
+  }
+  // The rules run offline too, so they come from NVS rather than wait for the server.
+  rules.setOnFired(onRuleFired);
+  rules.setOnAlarm(onRuleAlarm);
+  // A sweep left by the last boot goes on where it stopped, a new one starts once the clock is synced. It only
+  // takes the gaps between the polls.
+  energyBackfill.setOnResult(onBackfillResult);
+  energyBackfill.setScheduler(&pollScheduler);
+  energyBackfill.load();
+  cmdQueue.setEnergyHistory(&energyHistory);
+  energyHistory.load();
+  if (rules.load()) {
+    applyPollPolicy();
+  }
+  // Sampling starts with the first loop(), the network, storage and servers come up behind it, see serviceStartup().
+}
+
+// Brings up the next startup stage, once per loop() until all are up. Each one only runs after
+// the inverter queries of that loop were queued, so the first sample never waits for them.
+void serviceStartup() {
+  switch (bootStage) {
+    case BOOT_NETWORK:
+      // Connecting happens in loop(), see serviceNetwork().
+      WiFi.onEvent(onNetworkEvent);
+#if NET_TRANSPORT == NET_WIFI
+      WiFi.mode(WIFI_STA);
+      INFI::loadWiFiFast(wifiState);
+#else
+      // The radio is not needed, and off it can not disturb the cable's timing.
+      WiFi.mode(WIFI_OFF);
+      if (!INFI::beginEthernet(ETH_CONFIG)) {
+        Serial.println("Could not start Ethernet");
+      }
+#endif
+      if (usesProvisioning() && INFI::loadCredentials(credentials)) {
+        Serial.println("Using the provisioned token");
       }
-      Serial.println();
-
-      // Query the general status.
-      Serial.println("Querying the general status");
-      cmdSender.sendCommand(INFI::GENERAL_STATUS, {});
-      if (cmdSender.response.actualLen != INFI::START_OFFSET_SZ + INFI::RESP_TO_END_SZS[INFI::GENERAL_STATUS]) {
-        Serial.println("Malformed response. Please restart device.\n");
-        return;
+      INFI::setupGMTTimeForIndia();
+      bootStage = BOOT_STORAGE;
+      break;
+
+    case BOOT_STORAGE:
+      // Takes over the data partition on first use. Until then samples wait in gsHistory.
+      if (!telemetryLog.begin()) {
+        Serial.println("Telemetry log not available");
+      } else if (telemetryLog.hasRecords()) {
+        // Checks what was left before the reset on both cores, sampling goes on meanwhile.
+        telemetryLog.startVerify();
       }
-      Serial.println("Uploading General Status to Thingsboard");
-      if (!tb.sendTelemetryString("gs", cmdSender.response.val)) {
-        Serial.println("Could not upload General Status to Thingsboard");
+      if (LOG_TO_SD && SD.begin(SD_CS_PIN) && sdLog.begin()) {
+        gsFanout.addSink(INFI::SAMPLE_BINARY_STAMPED, sdQueue);
+        supervisor.add("sd", 0, isSdHealthy, restartSd, NULL, millis());
+      } else if (LOG_TO_SD) {
+        Serial.println("SD log not available");
       }
-      Serial.println();
-
-      // Query rated info.
-      Serial.println("Querying rated info");
-      cmdSender.sendCommand(INFI::QUERY_RATED_INFORMATION, "");
-      Serial.println("Uploading Rated Info to Thingsboard");
-      if (!tb.sendTelemetryString("piri", cmdSender.response.val)) {
-        Serial.println("Could not upload Rated Info to Thingsboard");
+      bootStage = BOOT_SERVICES;
+      break;
+
+    case BOOT_SERVICES:
+      statusServer.setLinkStats(&linkStats);
+      statusServer.setMetricsWriter(writePipelineMetrics);
+      if (SERVE_STATUS && !statusServer.begin()) {
+        Serial.println("Status server not started");
       }
-      Serial.println();
-
-      // Query the fault warning status.
-      Serial.println("Getting fault warning status");
-      cmdSender.sendCommand(INFI::FAULT_WARNING_STATUS, "");
-      Serial.println("Uploading Fault Warning Status to Thingsboard");
-      if (!tb.sendTelemetryString("fws", cmdSender.response.val)) {
-        Serial.println("Could not upload Fault Warning Status to Thingsboard");
+      gsStream.begin();
+      gsFanout.addSink(INFI::SAMPLE_JSON, onGsSample, &gsStream);
+      modbusTcp.begin();
+#if INFI_ENABLE_BLE
+      if (SERVE_BLE && !bleService.begin(BLE_NAME)) {
+        Serial.println("BLE service not started");
       }
-      Serial.println();
-
-      // Query the enable/disable status.
-      Serial.println("Querying enable disable status");
-      cmdSender.sendCommand(INFI::QUERY_ENABLE_DISABLE_STATUS, "");
-      Serial.println("Uploading Enable Disable Status to Thingsboard");
-      if (!tb.sendTelemetryString("flag", cmdSender.response.val)) {
-        Serial.println("Could not upload Enable Disable Status to Thingsboard");
+#endif
+      if (BRIDGE_VENDOR_TOOL) {
+        bridgeTcp.begin();
       }
-      Serial.println();
-
-      // Query default values of changeable params.
-      Serial.println("Querying default values of changeable parameters");
-      cmdSender.sendCommand(INFI::QUERY_DEFAULT_VALUE, "");
-      // Serial.println("Uploading Default Values to Thingsboard");
-      // if (!tb.sendTelemetryString("di", cmdSender.response.val)) {
-      //   Serial.println("Could not upload Enable Disable Status to Thingsboard");
-      // }
-      Serial.println();
-
-      // Query the max charging current selectable value.
-      Serial.println("Querying max charging current selectable value");
-      cmdSender.sendCommand(INFI::QUERY_MAX_CHARGING_CURRENT, "");
-      Serial.println("Uploading Max Charging Current Selectable Value to Thingsboard");
-      if (!tb.sendTelemetryString("mchgcr", cmdSender.response.val)) {
-        Serial.println("Could not upload Max Charging Current Selectable Value to Thingsboard");
+      Serial.print("Started in ");
+      Serial.print(millis());
+      Serial.println(" ms");
+      bootStage = BOOT_DONE;
+      break;
+
+    case BOOT_DONE:
+      break;
+  }
+}
+
+void loop() {
+  // Keep sampling the inverter whatever the state of the network, the samples wait in gsHistory.
+  // Queue whichever inverter queries are due and advance the transactions without blocking.
+  pollEnergy();
+  {
+    INFI::InfiniResourceProbe probe(resources, INFI::STAGE_POLL);
+    pollScheduler.loop();
+  }
+  // After the polls, the capture only takes the gaps they leave.
+  serviceFaultCapture();
+  if (bootStage != BOOT_DONE) {
+    serviceStartup();
+  }
+  // An erase or a write of the flash keeps its cache off for a while, so both go between two transactions on
+  // the link, and the sector erase ahead of the append that would need it.
+  if (netState != NET_ONLINE && bootStage > BOOT_STORAGE && !cmdQueue.isBusy()) {
+    telemetryLog.eraseAhead();
+    spillGsHistory();
+  }
+  drainSdQueue();
+  if (bootStage == BOOT_DONE) {
+    gsStream.loop();
+    modbusTcp.loop();
+#if INFI_ENABLE_BLE
+    if (SERVE_BLE) {
+      bleService.loop();
+    }
+#endif
+    if (BRIDGE_VENDOR_TOOL) {
+      bridgeTcp.loop();
+    }
+  }
+
+  if (bootStage > BOOT_NETWORK && serviceNetwork()) {
+    INFI::InfiniResourceProbe probe(resources, INFI::STAGE_PUBLISH);
+    publishAlarms();
+    publishFaultBurst();
+    flushTelemetryIfIdle();
+    // After the flush, which its queries would otherwise hold up.
+    serviceBackfill();
+    serviceEnergyHistory();
+    if (telemetryBatch.hasSealed()) {
+      if (resources != NULL) {
+        // The cycle just sealed is where its allocations are drawn a line under.
+        resources->endCycle();
       }
-      Serial.println();
-
-      // Query the max ac charging current selectable value.
-      Serial.println("Querying max AC charging current selectable value");
-      cmdSender.sendCommand(INFI::QUERY_MAX_AC_CHARGING_CURRENT, "");
-      Serial.println("Uploading Max AC Charging Current Selectable Value to Thingsboard");
-      if (!tb.sendTelemetryString("muchgcr", cmdSender.response.val)) {
-        Serial.println("Could not upload Max AC Charging Current Selectable Value to Thingsboard");
+      // Start the next cycle's due queries first, their replies come in while the publish blocks.
+      pollScheduler.loop();
+      openFlushWindow();
+      if (telemetryBatch.publishSealed()) {
+        supervisor.kick(mqttSubsystem, millis());
       }
-      Serial.println();
     }
-  
+    // The aggregates of an outage go up first, then the logged samples, which are older than the current history.
+    // Nothing goes before the jitter after the connect, which also sets the phase of the periodic uploads.
+    if (millis() - onlineMs >= backlogJitterMs && uploadRollups() && drainTelemetryLog()) {
+      uploadGsHistory();
+    }
+    uploadGsKeyMap();
+    timers.loop(millis());
+    for (INFI::BYTE d = 0; d < pollScheduler.deviceCount(); ++d) {
+      publishStaticInfo(d);
+    }
+
     // Process messages
+    if (shouldPollMqtt()) {
+      INFI_TRACE_BEGIN(INFI::TRACE_NETWORK, 0);
       tb.loop();
+      INFI_TRACE_END(INFI::TRACE_NETWORK, 0);
+    }
   }
+
+  kickNetworkSubsystems();
+  supervisor.loop(millis());
+
+  INFI::idleFor(msUntilWork());
+}
+
+unsigned long earliest(unsigned long a, unsigned long b) {
+  return a < b ? a : b;
+}
+
+// How long loop() can sleep before one of the timers above is due. Telemetry waiting in the batch
+// goes out once the queues drain, which the scheduler's wait covers.
+unsigned long msUntilWork() {
+  if (bootStage != BOOT_DONE) {
+    // The next startup stage.
+    return 0;
+  }
+  if (sdBacklog) {
+    return 0;
+  }
+  unsigned long now = millis();
+  unsigned long wait = earliest(pollScheduler.msUntilDue(), INFI::msUntilElapsed(energyPolledMs, ENERGY_PERIOD, now));
+  wait = earliest(wait, supervisor.msUntilCheck(now));
+  if (netState != NET_ONLINE) {
+    if (gsHistory.size() > gsHistory.capacity() / 2 && !cmdQueue.isBusy()) {
+      // spillGsHistory() has more to move. With a command in flight, its reply wakes the loop.
+      return 0;
+    }
+    // Network events wake the loop early.
+#if NET_TRANSPORT == NET_WIFI
+    unsigned long netWait = netState == NET_LINK_CONNECTING ? INFI::msUntilElapsed(netAttemptMs, WIFI_CONNECT_TIMEOUT_MS, now)
+      : INFI::msUntilElapsed(netAttemptMs, netBackoffMs, now);
+#else
+    // Only the broker is retried, a cable coming back is an event.
+    unsigned long netWait = netState == NET_MQTT_DOWN ? INFI::msUntilElapsed(netAttemptMs, netBackoffMs, now) : wait;
+#endif
+    return earliest(wait, netWait);
+  }
+  if (!alarmQueue.isEmpty()) {
+    return 0;
+  }
+  wait = earliest(wait, msUntilMqttPoll(now));
+  if (energyBackfill.isStarted() && !energyBackfill.isDone()) {
+    wait = earliest(wait, INFI::ENERGY_BACKFILL_PERIOD_MS);
+  }
+  const unsigned long backlogWait = INFI::msUntilElapsed(onlineMs, backlogJitterMs, now);
+  if (backlogWait > 0) {
+    wait = earliest(wait, backlogWait);
+  } else {
+    if (gsBacklog || !rollup.isEmpty(INFI::ROLLUP_MINUTE) || !rollup.isEmpty(INFI::ROLLUP_HOUR)) {
+      // Right away, unless the upload rate holds it back.
+      wait = earliest(wait, uploadPacer.msUntilAvailable(now));
+    }
+    wait = earliest(wait, INFI::msUntilElapsed(gsUploadedMs, GS_UPLOAD_PERIOD, now));
+    if (telemetryLog.hasRecords()) {
+      wait = earliest(wait, INFI::msUntilElapsed(logDrainedMs, LOG_DRAIN_PERIOD, now));
+    }
+  }
+  return earliest(wait, timers.msUntilNext(now));
 }
 
 //void sendCommand(COMMAND_TYPE commandType, const char* params) {//, Stream *debugStream) {
@@ -445,28 +2064,215 @@ void loop() {
 //  Serial2.write(command.msg, command.actualLen);
 //}
 
-void InitWiFi()
-{
-  Serial.println("Connecting to AP ...");
-  // attempt to connect to WiFi network
+// The link is up once it has an address, and down as soon as the AP or the cable goes, or the lease.
+void onNetworkEvent(WiFiEvent_t event) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+    case ARDUINO_EVENT_ETH_GOT_IP:
+      linkUp = true;
+      INFI::wakeIdle();
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+    case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+    case ARDUINO_EVENT_ETH_DISCONNECTED:
+    case ARDUINO_EVENT_ETH_LOST_IP:
+    case ARDUINO_EVENT_ETH_STOP:
+      linkUp = false;
+      INFI::wakeIdle();
+      break;
+    default:
+      break;
+  }
+}
+
+// The attempt just made failed, wait longer before the next one.
+void netBackoff() {
+  netAttemptMs = millis();
+  netBackoffMs = netBackoffMs == 0 ? NET_BACKOFF_MIN_MS : netBackoffMs * 2;
+  if (netBackoffMs > NET_BACKOFF_MAX_MS) {
+    netBackoffMs = NET_BACKOFF_MAX_MS;
+  }
+  // Up to half as long again, so units that failed together do not retry together.
+  netBackoffMs += uploadPacer.jitterMs(netBackoffMs / 2);
+}
+
+// The link just came up or the broker went: the first connect waits a jitter of its own.
+void netConnectJitter() {
+  netAttemptMs = millis();
+  netBackoffMs = uploadPacer.jitterMs(MQTT_CONNECT_JITTER_MS);
+}
 
-  WiFi.begin(WIFI_AP_NAME, WIFI_PASSWORD);
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");
+bool usesProvisioning() {
+  return PROVISION_DEVICE_KEY[0] != '\0';
+}
+
+void onProvisionResponse(char *topic, uint8_t *payload, unsigned int length) {
+  if (strcmp(topic, INFI::PROVISION_RESPONSE_TOPIC) != 0) {
+    return;
   }
-  Serial.println("Connected to AP");
+  if (!INFI::parseProvisionResponse((const char *)payload, length, credentials)) {
+    Serial.println("Provisioning refused");
+  }
+  provisionAnswered = true;
 }
 
-void reconnect() {
-  // Loop until we're reconnected
-  status = WiFi.status();
-  if ( status != WL_CONNECTED) {
-    WiFi.begin(WIFI_AP_NAME, WIFI_PASSWORD);
-    while (WiFi.status() != WL_CONNECTED) {
-      delay(500);
-      Serial.print(".");
-    }
-    Serial.println("Connected to AP");
+// Asks the server for a token over a session of its own, waiting up to PROVISION_TIMEOUT_MS for the answer.
+// Returns true, with the token stored, if credentials holds one.
+bool provisionDevice() {
+  WiFiClient provisionSocket;
+  PubSubClient provision(provisionSocket);
+  provision.setServer(THINGSBOARD_SERVER, THINGSBOARD_MQTT_PORT);
+  provision.setCallback(onProvisionResponse);
+  if (!provision.connect("provision", "provision", NULL) || !provision.subscribe(INFI::PROVISION_RESPONSE_TOPIC)) {
+    return false;
+  }
+  char request[192];
+  INFI::InfiniBufferPrint requestOut(request, sizeof(request));
+  INFI::writeProvisionRequest(PROVISION_DEVICE_NAME, PROVISION_DEVICE_KEY, PROVISION_DEVICE_SECRET, requestOut);
+  provisionAnswered = false;
+  // A full buffer means the request was cut short.
+  if (requestOut.length() + 1 >= sizeof(request) || !provision.publish(INFI::PROVISION_REQUEST_TOPIC, request)) {
+    provision.disconnect();
+    return false;
+  }
+  unsigned long start = millis();
+  while (!provisionAnswered && provision.connected() && millis() - start < PROVISION_TIMEOUT_MS) {
+    provision.loop();
+    delay(10);
+  }
+  provision.disconnect();
+  return credentials.type == INFI::CREDENTIALS_ACCESS_TOKEN && INFI::saveCredentials(credentials);
+}
+
+// Called once tb.connect() failed with the provisioned token: whether the server refused it rather than
+// not being reachable. Only then is it dropped, so a broker outage does not provision a new device.
+bool credentialsRejected() {
+  WiFiClient probeSocket;
+  PubSubClient probe(probeSocket);
+  probe.setServer(THINGSBOARD_SERVER, THINGSBOARD_MQTT_PORT);
+  if (probe.connect("probe", credentials.token, NULL)) {
+    probe.disconnect();
+    return false;
+  }
+  return probe.state() == MQTT_CONNECT_BAD_CREDENTIALS || probe.state() == MQTT_CONNECT_UNAUTHORIZED;
+}
+
+// Advances the link and ThingsBoard connection by at most one step. Returns true while online.
+// Only tb.connect() may take a while, bounded by the TCP connect timeout. Inverter replies
+// arriving meanwhile wait in rxRing.
+bool serviceNetwork() {
+  if (!linkUp && (netState == NET_MQTT_DOWN || netState == NET_ONLINE)) {
+    Serial.println(NET_TRANSPORT == NET_WIFI ? "WiFi lost" : "Ethernet lost");
+    netState = NET_LINK_DOWN;
+    netAttemptMs = millis();
+    netBackoffMs = 0;
+  }
+  switch (netState) {
+#if NET_TRANSPORT == NET_WIFI
+    case NET_LINK_DOWN:
+      if (millis() - netAttemptMs >= netBackoffMs) {
+        Serial.println(wifiFast.hasCache(WIFI_AP_NAME) ? "Connecting to the last AP ..." : "Connecting to AP ...");
+        WiFi.disconnect();
+        wifiFast.begin(WIFI_AP_NAME, WIFI_PASSWORD);
+        netAttemptMs = millis();
+        netState = NET_LINK_CONNECTING;
+      }
+      return false;
+
+    case NET_LINK_CONNECTING:
+      if (linkUp) {
+        Serial.println("Connected to AP");
+        if (wifiFast.onConnected()) {
+          INFI::saveWiFiFast(wifiState);
+        }
+        netConnectJitter();
+        netState = NET_MQTT_DOWN;
+      } else if (wifiFast.isFast() && millis() - netAttemptMs > INFI::WIFI_FAST_TIMEOUT_MS) {
+        // The AP is not where it was, scan for it right away.
+        Serial.println("Last AP not found");
+        wifiFast.onFailed();
+        netAttemptMs = millis();
+        netState = NET_LINK_DOWN;
+      } else if (millis() - netAttemptMs > WIFI_CONNECT_TIMEOUT_MS) {
+        Serial.println("Could not connect to AP");
+        netBackoff();
+        netState = NET_LINK_DOWN;
+      }
+      return false;
+#else
+    // The driver brings the cable up by itself and DHCP follows, there is nothing to retry.
+    case NET_LINK_DOWN:
+    case NET_LINK_CONNECTING:
+      if (linkUp) {
+        Serial.println("Ethernet up");
+        netConnectJitter();
+        netState = NET_MQTT_DOWN;
+      }
+      return false;
+#endif
+
+    case NET_MQTT_DOWN:
+      if (millis() - netAttemptMs < netBackoffMs) {
+        return false;
+      }
+      if (usesProvisioning() && credentials.type != INFI::CREDENTIALS_ACCESS_TOKEN) {
+        Serial.println("Provisioning the device...");
+        if (!provisionDevice()) {
+          Serial.println("Failed to provision");
+          netBackoff();
+          return false;
+        }
+      }
+      Serial.print("Connecting to: ");
+      Serial.println(THINGSBOARD_SERVER);
+      if (!tb.connect(THINGSBOARD_SERVER, usesProvisioning() ? credentials.token : THINGSBOARD_TOKEN)) {
+        Serial.println("Failed to connect");
+        if (usesProvisioning() && credentialsRejected()) {
+          Serial.println("Provisioned token refused, provisioning again");
+          INFI::clearCredentials();
+          memset(&credentials, 0, sizeof(credentials));
+        }
+        netBackoff();
+        return false;
+      }
+
+      // Perform a subscription. All consequent data processing will happen in
+      // callbacks as denoted by callbacks[] array.
+      Serial.println("Subscribing for RPC...");
+      if (!tb.RPC_Subscribe(callbacks, NUM_RPC_CALLBACKS)) {
+        Serial.println("Failed to subscribe for RPC");
+        netBackoff();
+        return false;
+      }
+      if (!tb.Shared_Attributes_Subscribe(sharedAttributesCallback)) {
+        Serial.println("Failed to subscribe for shared attributes");
+        netBackoff();
+        return false;
+      }
+      if (!tb.Shared_Attributes_Request(sharedAttributesRequest)) {
+        Serial.println("Failed to request the shared attributes");
+      }
+      Serial.println("Subscribe done");
+      netBackoffMs = 0;
+      // The minute and hour the outage ended in go up with the rest of it.
+      rollup.seal();
+      onlineMs = millis();
+      backlogJitterMs = uploadPacer.jitterMs(BACKLOG_JITTER_MS);
+#if NET_TRANSPORT == NET_WIFI
+      // The core put its own sleep mode back with the connect.
+      wifiPower.begin(millis());
+#endif
+      netState = NET_ONLINE;
+      return true;
+
+    case NET_ONLINE:
+      if (!tb.connected()) {
+        Serial.println("ThingsBoard connection lost");
+        netConnectJitter();
+        netState = NET_MQTT_DOWN;
+        return false;
+      }
+      return true;
   }
+  return false;
 }
@@ -1,6 +1,12 @@
 #ifndef INFINISOLAR_P18_ESP32_MONITOR_DEFS_H
 #define INFINISOLAR_P18_ESP32_MONITOR_DEFS_H
 
+// The uplink: NET_WIFI, or a cable for a steady latency, NET_ETH_LAN8720 on e.g. a WT32-ETH01, or NET_ETH_W5500.
+#define NET_WIFI            0
+#define NET_ETH_LAN8720     1
+#define NET_ETH_W5500       2
+#define NET_TRANSPORT       NET_WIFI
+
 // WiFi access point
 #define WIFI_AP_NAME        "wifi_ssid"
 // WiFi password
@@ -8,6 +14,11 @@
 
 // ThingsBoard Device Access token
 #define THINGSBOARD_TOKEN   "device_access_token"
+// Device provisioning, instead of THINGSBOARD_TOKEN when the key is set: the device profile's
+// provision key and secret. The token it gets is kept in NVS. An empty name lets the server pick one.
+#define PROVISION_DEVICE_KEY    ""
+#define PROVISION_DEVICE_SECRET ""
+#define PROVISION_DEVICE_NAME   ""
 // ThingsBoard server instance.
 #define THINGSBOARD_SERVER  "your.thingsboard.address"
 
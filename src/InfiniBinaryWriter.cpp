@@ -0,0 +1,162 @@
+#include "InfiniBinaryWriter.h"
+
+#if INFI_MODULE_BINARY
+
+namespace INFI {
+  static size_t writeHeader(Print &out, BINARY_RECORD_TYPE type, BYTE payloadSz) {
+    size_t n = out.write(BINARY_SCHEMA_VERSION);
+    n += out.write((uint8_t)type);
+    n += out.write(payloadSz);
+    return n;
+  }
+
+  static size_t writeWord(Print &out, WORD value) {
+    size_t n = out.write((uint8_t)(value & 0xFF));
+    n += out.write((uint8_t)(value >> 8));
+    return n;
+  }
+
+  static size_t writeLong(Print &out, uint32_t value) {
+    size_t n = writeWord(out, (WORD)(value & 0xFFFF));
+    n += writeWord(out, (WORD)(value >> 16));
+    return n;
+  }
+
+  static WORD readWord(const BYTE *buf) {
+    return (WORD)(buf[0] | (buf[1] << 8));
+  }
+
+  // The GS payload, without a header.
+  static size_t writeGeneralStatusFields(const GeneralStatusFixed &gs, Print &out) {
+    size_t n = writeWord(out, gs.gridVoltDeci);
+    n += writeWord(out, gs.gridFreqDeci);
+    n += writeWord(out, gs.acOutVoltDeci);
+    n += writeWord(out, gs.acOutFreqDeci);
+    n += writeWord(out, gs.acOutApparentPow);
+    n += writeWord(out, gs.acOutActivePow);
+    n += writeWord(out, gs.battVoltDeci);
+    n += writeWord(out, gs.battVoltSCCDeci);
+    n += writeWord(out, gs.battVoltSCC2Deci);
+    n += writeWord(out, gs.battDischargeCurr);
+    n += writeWord(out, gs.battChargeCurr);
+    n += writeWord(out, gs.pv1InPow);
+    n += writeWord(out, gs.pv2InPow);
+    n += writeWord(out, gs.pv1InVoltDeci);
+    n += writeWord(out, gs.pv2InVoltDeci);
+    n += out.write(gs.outLoadPct);
+    n += out.write(gs.battCapacity);
+    n += out.write(gs.invHeatSinkTemp);
+    n += out.write(gs.mppt1ChrgrTemp);
+    n += out.write(gs.mppt2ChrgrTemp);
+    n += out.write((uint8_t)(gs.settingsChanged | (gs.loadConnection << 1) | (gs.mppt1ChrgrStatus << 2)
+                             | (gs.mppt2ChrgrStatus << 4) | (gs.battPowDir << 6)));
+    n += out.write((uint8_t)(gs.dcACPowDir | (gs.linePowDir << 2) | (gs.localParallelId << 4)));
+    return n;
+  }
+
+  size_t writeGeneralStatusBinary(const GeneralStatusFixed &gs, Print &out) {
+    size_t n = writeHeader(out, BINARY_GENERAL_STATUS, BINARY_GENERAL_STATUS_SZ - BINARY_HEADER_SZ);
+    return n + writeGeneralStatusFields(gs, out);
+  }
+
+  size_t writeGsSampleBinary(const GeneralStatusFixed &gs, uint64_t tsMs, Print &out) {
+    size_t n = writeHeader(out, BINARY_GS_SAMPLE, BINARY_GS_SAMPLE_SZ - BINARY_HEADER_SZ);
+    n += writeLong(out, (uint32_t)(tsMs & 0xFFFFFFFFUL));
+    n += writeLong(out, (uint32_t)(tsMs >> 32));
+    return n + writeGeneralStatusFields(gs, out);
+  }
+
+  size_t writeRatedInformationBinary(const RatedInformation &piri, Print &out) {
+    size_t n = writeHeader(out, BINARY_RATED_INFORMATION, BINARY_RATED_INFORMATION_SZ - BINARY_HEADER_SZ);
+    n += writeWord(out, piri.acInVoltDeci);
+    n += writeWord(out, piri.acInFreqDeci);
+    n += writeWord(out, piri.acInCurrDeci);
+    n += writeWord(out, piri.acOutVoltDeci);
+    n += writeWord(out, piri.acOutFreqDeci);
+    n += writeWord(out, piri.acOutCurrDeci);
+    n += writeWord(out, piri.acOutApparentPow);
+    n += writeWord(out, piri.acOutActivePow);
+    n += writeWord(out, piri.battVoltDeci);
+    n += writeWord(out, piri.battRechargeVoltDeci);
+    n += writeWord(out, piri.battRedischargeVoltDeci);
+    n += writeWord(out, piri.battUnderVoltDeci);
+    n += writeWord(out, piri.battBulkVoltDeci);
+    n += writeWord(out, piri.maxChargingCurr);
+    n += out.write(piri.battType);
+    n += out.write(piri.maxACChargingCurr);
+    n += out.write(piri.inVoltRange);
+    n += out.write(piri.outSourcePriority);
+    n += out.write(piri.chargerSourcePriority);
+    n += out.write(piri.parallelMaxNum);
+    n += out.write(piri.machineType);
+    n += out.write(piri.topology);
+    n += out.write(piri.outModel);
+    n += out.write(piri.solarPowerPriority);
+    n += out.write(piri.mpptString);
+    return n;
+  }
+
+  size_t writeEnergyBinary(unsigned long yearWh, unsigned long monthWh, unsigned long dayWh, Print &out) {
+    size_t n = writeHeader(out, BINARY_ENERGY, BINARY_ENERGY_SZ - BINARY_HEADER_SZ);
+    n += writeLong(out, yearWh);
+    n += writeLong(out, monthWh);
+    n += writeLong(out, dayWh);
+    return n;
+  }
+
+  // The GS payload at p, as written by writeGeneralStatusFields().
+  static void readGeneralStatusFields(const BYTE *p, GeneralStatusFixed &gs) {
+    gs.gridVoltDeci = readWord(p);
+    gs.gridFreqDeci = readWord(p + 2);
+    gs.acOutVoltDeci = readWord(p + 4);
+    gs.acOutFreqDeci = readWord(p + 6);
+    gs.acOutApparentPow = readWord(p + 8);
+    gs.acOutActivePow = readWord(p + 10);
+    gs.battVoltDeci = readWord(p + 12);
+    gs.battVoltSCCDeci = readWord(p + 14);
+    gs.battVoltSCC2Deci = readWord(p + 16);
+    gs.battDischargeCurr = readWord(p + 18);
+    gs.battChargeCurr = readWord(p + 20);
+    gs.pv1InPow = readWord(p + 22);
+    gs.pv2InPow = readWord(p + 24);
+    gs.pv1InVoltDeci = readWord(p + 26);
+    gs.pv2InVoltDeci = readWord(p + 28);
+    p += 30;
+    gs.outLoadPct = p[0];
+    gs.battCapacity = p[1];
+    gs.invHeatSinkTemp = p[2];
+    gs.mppt1ChrgrTemp = p[3];
+    gs.mppt2ChrgrTemp = p[4];
+    gs.settingsChanged = p[5] & 0x01;
+    gs.loadConnection = (p[5] >> 1) & 0x01;
+    gs.mppt1ChrgrStatus = (p[5] >> 2) & 0x03;
+    gs.mppt2ChrgrStatus = (p[5] >> 4) & 0x03;
+    gs.battPowDir = (p[5] >> 6) & 0x03;
+    gs.dcACPowDir = p[6] & 0x03;
+    gs.linePowDir = (p[6] >> 2) & 0x03;
+    gs.localParallelId = (p[6] >> 4) & 0x0F;
+  }
+
+  bool readGeneralStatusBinary(const BYTE *buf, size_t len, GeneralStatusFixed &gs) {
+    if (len < BINARY_GENERAL_STATUS_SZ || buf[0] != BINARY_SCHEMA_VERSION || buf[1] != BINARY_GENERAL_STATUS
+        || buf[2] != BINARY_GENERAL_STATUS_SZ - BINARY_HEADER_SZ) {
+      return false;
+    }
+    readGeneralStatusFields(buf + BINARY_HEADER_SZ, gs);
+    return true;
+  }
+
+  bool readGsSampleBinary(const BYTE *buf, size_t len, GeneralStatusFixed &gs, uint64_t &tsMs) {
+    if (len < BINARY_GS_SAMPLE_SZ || buf[0] != BINARY_SCHEMA_VERSION || buf[1] != BINARY_GS_SAMPLE
+        || buf[2] != BINARY_GS_SAMPLE_SZ - BINARY_HEADER_SZ) {
+      return false;
+    }
+    const BYTE *p = buf + BINARY_HEADER_SZ;
+    uint32_t low = readWord(p) | ((uint32_t)readWord(p + 2) << 16);
+    uint32_t high = readWord(p + 4) | ((uint32_t)readWord(p + 6) << 16);
+    tsMs = ((uint64_t)high << 32) | low;
+    readGeneralStatusFields(p + 8, gs);
+    return true;
+  }
+}
+#endif
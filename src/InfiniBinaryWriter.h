@@ -0,0 +1,50 @@
+#ifndef INFINI_BINARY_WRITER_H
+#define INFINI_BINARY_WRITER_H
+
+#include <stdint.h>
+#include <Print.h>
+#include "InfiniDataTypes.h"
+
+namespace INFI {
+
+  //! Bumped whenever a record layout below changes, so the gateway can tell them apart.
+  const BYTE BINARY_SCHEMA_VERSION = 1;
+  //! Schema version, record type and payload length.
+  const BYTE BINARY_HEADER_SZ = 3;
+
+  //! The record type, second byte of every record.
+  enum BINARY_RECORD_TYPE {
+    BINARY_GENERAL_STATUS = 1,  // GeneralStatusFixed.
+    BINARY_GS_SAMPLE,           // uint64 Unix ms, then the BINARY_GENERAL_STATUS payload.
+    BINARY_RATED_INFORMATION,   // RatedInformation.
+    BINARY_ENERGY,              // uint32 year, month and day Wh.
+    BINARY_GS_HISTORY,          // Compressed GS samples, see InfiniGsCodec.h.
+    BINARY_GS_SCHEMA,           // The GS field table, see InfiniRecordSchema.h.
+    BINARY_GS_COLUMNS           // GS samples by column, see InfiniRecordSchema.h.
+  };
+
+  const BYTE BINARY_GENERAL_STATUS_SZ = BINARY_HEADER_SZ + 37;
+  const BYTE BINARY_GS_SAMPLE_SZ = BINARY_GENERAL_STATUS_SZ + 8;
+  const BYTE BINARY_RATED_INFORMATION_SZ = BINARY_HEADER_SZ + 39;
+  const BYTE BINARY_ENERGY_SZ = BINARY_HEADER_SZ + 12;
+
+  /*!
+   * Packed binary records, the compact alternative to the JSON writers for uplinks that take binary payloads.
+   * Each record is the header, then the fields in struct order with the same fixed point units as the structs,
+   * multi byte fields little endian. GS bit fields are packed LSB first into two bytes:
+   * settingsChanged, loadConnection, mppt1ChrgrStatus:2, mppt2ChrgrStatus:2, battPowDir:2,
+   * then dcACPowDir:2, linePowDir:2, localParallelId:4.
+   * Several records can simply be written back to back. Each returns the number of bytes written.
+   */
+  size_t writeGeneralStatusBinary(const GeneralStatusFixed &gs, Print &out);
+  size_t writeGsSampleBinary(const GeneralStatusFixed &gs, uint64_t tsMs, Print &out);
+  size_t writeRatedInformationBinary(const RatedInformation &piri, Print &out);
+  size_t writeEnergyBinary(unsigned long yearWh, unsigned long monthWh, unsigned long dayWh, Print &out);
+
+  //! Reads back a BINARY_GENERAL_STATUS record. False if buf does not hold one of this schema version.
+  bool readGeneralStatusBinary(const BYTE *buf, size_t len, GeneralStatusFixed &gs);
+  //! Reads back a BINARY_GS_SAMPLE record, e.g. one kept in RTC memory over a deep sleep.
+  bool readGsSampleBinary(const BYTE *buf, size_t len, GeneralStatusFixed &gs, uint64_t &tsMs);
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include "InfiniBleService.h"
+
+#if INFI_MODULE_SINKS && INFI_ENABLE_BLE
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLE2902.h>
+#include <string.h>
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+
+  // The stack stops advertising once a central connects, so the next phone could not find the service.
+  class BleAdvertiseAgain : public BLEServerCallbacks {
+    void onDisconnect(BLEServer *server) override {
+      server->startAdvertising();
+    }
+  };
+
+  static BleAdvertiseAgain advertiseAgain;
+
+  static BLECharacteristic *addReadout(BLEService *service, const char *uuid) {
+    BLECharacteristic *characteristic = service->createCharacteristic(
+      uuid, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+    // The client characteristic configuration descriptor, where a phone turns notifications on.
+    characteristic->addDescriptor(new BLE2902());
+    return characteristic;
+  }
+
+  InfiniBleService::InfiniBleService(const InfiniStatusCache &cache) :
+    m_cache(cache),
+    m_server(NULL),
+    m_gs(NULL),
+    m_faults(NULL),
+    m_energy(NULL),
+    m_version(0),
+    m_started(false),
+    m_gsLen(0),
+    m_faultsLen(0),
+    m_energyLen(0),
+    m_notifications(0)
+  {}
+
+  bool InfiniBleService::begin(const char *name) {
+    if (m_started) {
+      return true;
+    }
+    BLEDevice::init(name);
+    m_server = BLEDevice::createServer();
+    if (m_server == NULL) {
+      return false;
+    }
+    m_server->setCallbacks(&advertiseAgain);
+    BLEService *service = m_server->createService(BLE_SERVICE_UUID);
+    m_gs = addReadout(service, BLE_GS_UUID);
+    m_faults = addReadout(service, BLE_FAULTS_UUID);
+    m_energy = addReadout(service, BLE_ENERGY_UUID);
+    service->start();
+    BLEAdvertising *advertising = BLEDevice::getAdvertising();
+    advertising->addServiceUUID(BLE_SERVICE_UUID);
+    advertising->setScanResponse(true);
+    BLEDevice::startAdvertising();
+    // The first loop() fills in whatever the cache already holds.
+    m_version = m_cache.version() - 1;
+    m_started = true;
+    return true;
+  }
+
+  void InfiniBleService::loop() {
+    if (!m_started || m_cache.version() == m_version) {
+      return;
+    }
+    StatusSnapshot snapshot;
+    // The version first, an update while reading is then picked up by the next loop().
+    m_version = m_cache.version();
+    if (!m_cache.read(snapshot)) {
+      return;
+    }
+    if (snapshot.parts & STATUS_GS) {
+      BYTE value[sizeof(m_gsValue)];
+      InfiniBufferPrint out((char *)value, sizeof(value));
+      writeGeneralStatusBinary(snapshot.gs, out);
+      publish(m_gs, value, out.length(), m_gsValue, m_gsLen);
+    }
+    if (snapshot.parts & STATUS_FWS) {
+      const WORD flags = getFaultWarningFlags(snapshot.fws);
+      const BYTE value[BLE_FAULTS_SZ] = { snapshot.fws.faultCode, (BYTE)(flags & 0xFF), (BYTE)(flags >> 8) };
+      publish(m_faults, value, sizeof(value), m_faultsValue, m_faultsLen);
+    }
+    if (snapshot.parts & STATUS_ENERGY) {
+      BYTE value[sizeof(m_energyValue)];
+      InfiniBufferPrint out((char *)value, sizeof(value));
+      writeEnergyBinary(snapshot.energy.yearWh, snapshot.energy.monthWh, snapshot.energy.dayWh, out);
+      publish(m_energy, value, out.length(), m_energyValue, m_energyLen);
+    }
+  }
+
+  void InfiniBleService::publish(BLECharacteristic *characteristic, const BYTE *value, size_t len, BYTE *last,
+                                 size_t &lastLen) {
+    if (len == lastLen && memcmp(value, last, len) == 0) {
+      return;
+    }
+    memcpy(last, value, len);
+    lastLen = len;
+    characteristic->setValue(last, len);
+    // Goes only to the phones that turned notifications on.
+    characteristic->notify();
+    m_notifications++;
+  }
+
+  unsigned long InfiniBleService::notifications() const {
+    return m_notifications;
+  }
+}
+
+#endif
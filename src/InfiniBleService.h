@@ -0,0 +1,91 @@
+#ifndef INFINI_BLE_SERVICE_H
+#define INFINI_BLE_SERVICE_H
+
+#include "InfiniBinaryWriter.h"
+#include "InfiniStatusCache.h"
+
+// Whether InfiniBleService is built: on an ESP32 whose core has Bluedroid and its Arduino BLE library.
+#ifndef INFI_ENABLE_BLE
+#  if defined(ARDUINO_ARCH_ESP32) && defined(__has_include)
+#    if __has_include(<sdkconfig.h>)
+#      include <sdkconfig.h>
+#    endif
+#    if defined(CONFIG_BLUEDROID_ENABLED) && __has_include(<BLEDevice.h>)
+#      define INFI_ENABLE_BLE 1
+#    else
+#      define INFI_ENABLE_BLE 0
+#    endif
+#  else
+#    define INFI_ENABLE_BLE 0
+#  endif
+#endif
+
+#if INFI_ENABLE_BLE
+class BLEServer;
+class BLECharacteristic;
+#endif
+
+namespace INFI {
+
+  //! The live readout service and its characteristics, all read and notify only.
+  const char *const BLE_SERVICE_UUID = "5f1b0001-8c3e-4b7a-9d2e-1f6a0c5e3b10";
+  //! The latest GS as a BINARY_GENERAL_STATUS record of writeGeneralStatusBinary().
+  const char *const BLE_GS_UUID = "5f1b0002-8c3e-4b7a-9d2e-1f6a0c5e3b10";
+  //! The latest FWS as BLE_FAULTS_SZ bytes: the fault code, then getFaultWarningFlags() little endian.
+  const char *const BLE_FAULTS_UUID = "5f1b0003-8c3e-4b7a-9d2e-1f6a0c5e3b10";
+  //! The energy counters as a BINARY_ENERGY record of writeEnergyBinary(), unknown ones as 0xFFFFFFFF.
+  const char *const BLE_ENERGY_UUID = "5f1b0004-8c3e-4b7a-9d2e-1f6a0c5e3b10";
+
+  const BYTE BLE_FAULTS_SZ = 3;
+
+#if INFI_ENABLE_BLE
+  /*!
+   * A BLE GATT service with the live values of one inverter, for a technician's phone on site, which needs
+   * no WiFi credentials. Its characteristics are compact binary records, the encoders of the uplink's binary
+   * format, read from an InfiniStatusCache. So a phone reading them adds no traffic to the RS232 link, and
+   * every connected phone shares the monitor's polling.
+   * loop() looks at the cache once its version() moved, encodes the parts it holds, and only sets and notifies
+   * the characteristics whose bytes changed. Parts never read are left empty.
+   * There are no writable characteristics, settings stay with the RPCs and Modbus.
+   * Bluedroid takes around 60 kB of heap with WiFi running alongside, so it is off unless the sketch asks.
+   */
+  class InfiniBleService {
+    public:
+    InfiniBleService(const InfiniStatusCache &cache);
+
+    /*! Initializes BLE under name, adds the service and starts advertising it. Advertising starts again
+     * whenever a phone disconnects. Returns false if BLE could not be started.
+     */
+    bool begin(const char *name);
+
+    //! Updates and notifies what changed in the cache. Call from loop(), it reads the cache only.
+    void loop();
+
+    //! Characteristic updates notified since begin(), one per part that changed.
+    unsigned long notifications() const;
+
+    private:
+    //! Sets characteristic to len bytes of value and notifies it, if they differ from what last, of lastLen, held.
+    void publish(BLECharacteristic *characteristic, const BYTE *value, size_t len, BYTE *last, size_t &lastLen);
+
+    const InfiniStatusCache &m_cache;
+    BLEServer *m_server;
+    BLECharacteristic *m_gs;
+    BLECharacteristic *m_faults;
+    BLECharacteristic *m_energy;
+    //! The cache's version() loop() last looked at.
+    BYTE m_version;
+    bool m_started;
+    //! What each characteristic holds, one spare byte each for the terminator InfiniBufferPrint writes.
+    BYTE m_gsValue[BINARY_GENERAL_STATUS_SZ + 1];
+    size_t m_gsLen;
+    BYTE m_faultsValue[BLE_FAULTS_SZ];
+    size_t m_faultsLen;
+    BYTE m_energyValue[BINARY_ENERGY_SZ + 1];
+    size_t m_energyLen;
+    unsigned long m_notifications;
+  };
+#endif
+}
+
+#endif
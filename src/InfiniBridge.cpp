@@ -0,0 +1,179 @@
+#include "InfiniBridge.h"
+
+#if INFI_MODULE_SCHEDULER
+#include "InfiniCRC.h"
+
+namespace INFI {
+
+  InfiniBridge::InfiniBridge(InfiniCommandQueue &queue) :
+    m_queue(queue),
+    m_forwarded(0),
+    m_rejected(0)
+  {
+    for (BYTE i = 0; i < BRIDGE_PENDING; ++i) {
+      m_slots[i].bridge = this;
+      m_slots[i].client = NULL;
+      m_slots[i].used = false;
+    }
+  }
+
+  bool InfiniBridge::submit(const char *frame, size_t len, Print &client) {
+    char params[MAX_PARAMS_SZ];
+    COMMAND_TYPE commandType = parseCommandFrame(frame, len, params, sizeof(params));
+    if (commandType == NUM_COMMAND_TYPES) {
+      m_rejected++;
+      writeNak(client);
+      return false;
+    }
+    Slot *slot = NULL;
+    for (BYTE i = 0; i < BRIDGE_PENDING && slot == NULL; ++i) {
+      if (!m_slots[i].used) {
+        slot = &m_slots[i];
+      }
+    }
+    if (slot == NULL) {
+      m_rejected++;
+      return false;
+    }
+    // Taken before enqueueing, a cached reply calls back from inside it.
+    slot->used = true;
+    slot->client = &client;
+    if (!m_queue.enqueueWithPriority(PRIORITY_BRIDGE, commandType, params, onComplete, slot)) {
+      slot->used = false;
+      slot->client = NULL;
+      m_rejected++;
+      return false;
+    }
+    m_forwarded++;
+    return true;
+  }
+
+  void InfiniBridge::readFrom(Stream &client, BridgeFrame &frame) {
+    while (client.available() > 0) {
+      int c = client.read();
+      if (c < 0) {
+        break;
+      }
+      if (frame.len == 0 && !frame.overrun && c != '^') {
+        continue;
+      }
+      if (frame.len < sizeof(frame.buf)) {
+        frame.buf[frame.len++] = (char)c;
+      } else {
+        frame.overrun = true;
+      }
+      if (c == '\r') {
+        if (!frame.overrun) {
+          submit(frame.buf, frame.len, client);
+        } else {
+          m_rejected++;
+        }
+        frame.len = 0;
+        frame.overrun = false;
+      }
+    }
+  }
+
+  void InfiniBridge::forget(const Print &client) {
+    for (BYTE i = 0; i < BRIDGE_PENDING; ++i) {
+      if (m_slots[i].client == &client) {
+        m_slots[i].client = NULL;
+      }
+    }
+  }
+
+  BYTE InfiniBridge::pending(const Print &client) const {
+    BYTE count = 0;
+    for (BYTE i = 0; i < BRIDGE_PENDING; ++i) {
+      if (m_slots[i].used && m_slots[i].client == &client) {
+        count++;
+      }
+    }
+    return count;
+  }
+
+  unsigned long InfiniBridge::forwarded() const {
+    return m_forwarded;
+  }
+
+  unsigned long InfiniBridge::rejected() const {
+    return m_rejected;
+  }
+
+  void InfiniBridge::onComplete(const InfiniResponse &response, SEND_STATUS status, void *context) {
+    Slot *slot = (Slot *)context;
+    Print *client = slot->client;
+    slot->used = false;
+    slot->client = NULL;
+    // A timed out or rejected reply is not passed on, the client times out as it would on the port.
+    if (client != NULL && status == SEND_COMPLETE) {
+      client->write((const uint8_t *)response.val, response.actualLen);
+    }
+  }
+
+  void InfiniBridge::writeNak(Print &client) {
+    BYTE frame[START_TOKEN_SZ + CRC_SZ + END_TOKEN_SZ] = { '^', '0' };
+    WORD crc = calc_crc_half(frame, START_TOKEN_SZ);
+    frame[START_TOKEN_SZ] = (BYTE)(crc >> 8);
+    frame[START_TOKEN_SZ + 1] = (BYTE)(crc & 0xFF);
+    frame[START_TOKEN_SZ + CRC_SZ] = '\r';
+    client.write(frame, sizeof(frame));
+  }
+
+  InfiniBridgeSerial::InfiniBridgeSerial(InfiniBridge &bridge, Stream &port) :
+    m_bridge(bridge),
+    m_port(port)
+  {
+    m_frame.len = 0;
+    m_frame.overrun = false;
+  }
+
+  void InfiniBridgeSerial::loop() {
+    m_bridge.readFrom(m_port, m_frame);
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  InfiniBridgeTcp::InfiniBridgeTcp(InfiniBridge &bridge, uint16_t port) :
+    m_bridge(bridge),
+    m_server(port)
+  {
+    for (BYTE i = 0; i < BRIDGE_TCP_CLIENTS; ++i) {
+      m_peers[i].frame.len = 0;
+      m_peers[i].frame.overrun = false;
+    }
+  }
+
+  void InfiniBridgeTcp::begin() {
+    m_server.begin();
+    m_server.setNoDelay(true);
+  }
+
+  void InfiniBridgeTcp::loop() {
+    if (m_server.hasClient()) {
+      WiFiClient incoming = m_server.available();
+      Peer *slot = NULL;
+      for (BYTE i = 0; i < BRIDGE_TCP_CLIENTS && slot == NULL; ++i) {
+        if (!m_peers[i].socket.connected()) {
+          slot = &m_peers[i];
+        }
+      }
+      if (slot == NULL) {
+        incoming.stop();
+      } else {
+        // Replies still owed to the last client on this slot must not reach the new one.
+        m_bridge.forget(slot->socket);
+        slot->socket.stop();
+        slot->socket = incoming;
+        slot->frame.len = 0;
+        slot->frame.overrun = false;
+      }
+    }
+    for (BYTE i = 0; i < BRIDGE_TCP_CLIENTS; ++i) {
+      if (m_peers[i].socket.connected()) {
+        m_bridge.readFrom(m_peers[i].socket, m_peers[i].frame);
+      }
+    }
+  }
+#endif
+}
+#endif
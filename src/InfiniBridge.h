@@ -0,0 +1,128 @@
+#ifndef INFINI_BRIDGE_H
+#define INFINI_BRIDGE_H
+
+#include <Stream.h>
+#include "InfiniCommandQueue.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <WiFi.h>
+#endif
+
+// Bridged commands queued or in flight at once, further frames are dropped until one finished.
+#ifndef INFI_BRIDGE_PENDING
+#define INFI_BRIDGE_PENDING INFI_COMMAND_QUEUE_BRIDGE_SZ
+#endif
+
+// TCP clients a InfiniBridgeTcp serves at once, further ones are turned away.
+#ifndef INFI_BRIDGE_TCP_CLIENTS
+#define INFI_BRIDGE_TCP_CLIENTS 1
+#endif
+
+namespace INFI {
+
+  const BYTE BRIDGE_PENDING = INFI_BRIDGE_PENDING;
+  const BYTE BRIDGE_TCP_CLIENTS = INFI_BRIDGE_TCP_CLIENTS;
+
+  //! A command frame of a client being put together, see InfiniBridge::readFrom().
+  struct BridgeFrame {
+    char buf[MAX_CMD_SZ];
+    BYTE len;
+    //! Set while a frame longer than buf is being skipped.
+    bool overrun;
+  };
+
+  /*!
+   * Lets another master, e.g. the vendor's PC tool, talk to the inverter through our link instead of
+   * taking the port over. Its P18 command frames are checked and queued in PRIORITY_BRIDGE, so they
+   * go out whenever the polls leave the link idle and the monitoring keeps its rate. Each pending
+   * command remembers the client it came from, and its reply frame is written back to that client as
+   * the inverter sent it. Queued READs are answered from the queue's response cache when it has them.
+   * A frame that is not a command of COMMAND_DESCRIPTORS is answered with ^0, one whose command gets
+   * no reply is not answered at all, as the inverter would do, and the client retries.
+   * Transport independent, InfiniBridgeSerial and InfiniBridgeTcp feed it. Not thread safe, because of
+   * the queue: drive it from the task that runs the queue.
+   */
+  class InfiniBridge {
+    public:
+    InfiniBridge(InfiniCommandQueue &queue);
+
+    /*! Queues the command frame of client, len bytes with the '\r', the reply goes to client.
+     * Returns false if it was not queued: answered with ^0 if it is no command, dropped if
+     * every pending slot or the lane is taken.
+     */
+    bool submit(const char *frame, size_t len, Print &client);
+
+    /*! Reads what client has into frame and submit()s each frame as its '\r' arrives.
+     * Never blocks. Bytes before a '^' are dropped, as are frames longer than any command.
+     */
+    void readFrom(Stream &client, BridgeFrame &frame);
+
+    //! Drops the replies still owed to client, e.g. before its connection is reused.
+    void forget(const Print &client);
+
+    //! Commands of client queued or in flight.
+    BYTE pending(const Print &client) const;
+
+    unsigned long forwarded() const;
+    //! Frames answered with ^0 or dropped.
+    unsigned long rejected() const;
+
+    private:
+    struct Slot {
+      InfiniBridge *bridge;
+      //! NULL while the slot is free, or once its client was forgotten and the reply is dropped.
+      Print *client;
+      bool used;
+    };
+
+    static void onComplete(const InfiniResponse &response, SEND_STATUS status, void *context);
+    static void writeNak(Print &client);
+
+    InfiniCommandQueue &m_queue;
+    Slot m_slots[BRIDGE_PENDING];
+    unsigned long m_forwarded;
+    unsigned long m_rejected;
+  };
+
+  /*!
+   * The bridge on a serial port of its own, e.g. the USB Serial of the board, so the vendor's tool
+   * runs on the laptop the board is plugged into. Call loop() from the Arduino loop as often as possible.
+   */
+  class InfiniBridgeSerial {
+    public:
+    InfiniBridgeSerial(InfiniBridge &bridge, Stream &port);
+
+    void loop();
+
+    private:
+    InfiniBridge &m_bridge;
+    Stream &m_port;
+    BridgeFrame m_frame;
+  };
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /*!
+   * The bridge as a raw TCP port, like ser2net, for a vendor tool pointed at a virtual COM port.
+   * Call loop() from the Arduino loop, it never waits for a client.
+   */
+  class InfiniBridgeTcp {
+    public:
+    InfiniBridgeTcp(InfiniBridge &bridge, uint16_t port = 8899);
+
+    void begin();
+    void loop();
+
+    private:
+    struct Peer {
+      WiFiClient socket;
+      BridgeFrame frame;
+    };
+
+    InfiniBridge &m_bridge;
+    WiFiServer m_server;
+    Peer m_peers[BRIDGE_TCP_CLIENTS];
+  };
+#endif
+}
+
+#endif
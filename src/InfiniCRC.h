@@ -3,8 +3,63 @@
 
 #include "InfiniCommon.h"
 
+/*
+ * Selects how calc_crc_half computes the CRC.
+ * INFI_CRC_NIBBLE walks a 16 entry table twice per byte (32 bytes of table).
+ * INFI_CRC_BYTEWISE walks a 256 entry table once per byte (512 bytes of table, in flash on AVR).
+ * INFI_CRC_ROM calls the CRC16 of the ESP32 mask ROM, which costs no flash at all. The default on ESP32.
+ * All give the same result, override with a build flag, e.g. -DINFI_CRC_IMPL=INFI_CRC_NIBBLE.
+ */
+#define INFI_CRC_NIBBLE 0
+#define INFI_CRC_BYTEWISE 1
+#define INFI_CRC_ROM 2
+
+#ifndef INFI_CRC_IMPL
+#if defined(ARDUINO_ARCH_ESP32)
+#define INFI_CRC_IMPL INFI_CRC_ROM
+#else
+#define INFI_CRC_IMPL INFI_CRC_BYTEWISE
+#endif
+#endif
+
 namespace INFI {
+    //! The P18 CRC of the len bytes at pin, with the protocol's escape step applied.
     WORD calc_crc_half(const BYTE *pin, BYTE len);
+
+    /*! The protocol's escape step: a CRC byte that would read as '(', '\r' or '\n' is incremented,
+     * so the CRC can never be mistaken for a frame delimiter.
+     */
+    WORD escape_crc(WORD crc);
+
+    //! Folds one byte into a raw (not yet escaped) CRC.
+    WORD crc_update(WORD crc, BYTE b);
+
+    /*! Checks calc_crc_half, crc_update and InfiniCrcAccumulator of the INFI_CRC_IMPL built against the nibble
+     * table, over every length up to a frame's. Returns false if any differs, e.g. a ROM with another CRC16.
+     */
+    bool crc_self_test();
+
+    /*!
+     * Computes the same CRC as calc_crc_half, but one byte or block at a time,
+     * so a receiver can fold bytes in as they arrive instead of scanning the buffer afterwards.
+     * It, crc_update() and escape_crc() are in IRAM on ESP32, safe from an interrupt while the flash is written.
+     */
+    class InfiniCrcAccumulator {
+      public:
+      InfiniCrcAccumulator();
+
+      //! Starts over, as though no byte had been folded in yet.
+      void reset();
+
+      void update(BYTE b);
+      void update(const BYTE *ptr, BYTE len);
+
+      //! The escaped CRC of everything folded in so far. Does not reset.
+      WORD finalize() const;
+
+      private:
+      WORD m_crc;
+    };
 }
 
 #endif
@@ -0,0 +1,213 @@
+#include "InfiniCellular.h"
+
+#if INFI_MODULE_SINKS
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+
+  //! A GPRS timer unit, its code in bits 8 to 6 and how many seconds it stands for.
+  struct PsmTimerUnit {
+    BYTE code;
+    unsigned long seconds;
+  };
+
+  // In ascending order, the periodic TAU of GPRS timer 3 and the active time of GPRS timer 2.
+  static const PsmTimerUnit TAU_UNITS[] = {
+    { 3, 2 }, { 4, 30 }, { 5, 60 }, { 0, 600 }, { 1, 3600 }, { 2, 36000 }, { 6, 1152000 }
+  };
+  static const PsmTimerUnit ACTIVE_UNITS[] = {
+    { 0, 2 }, { 1, 60 }, { 2, 360 }
+  };
+  //! Largest value of the 5 bits a unit is multiplied with.
+  static const unsigned long PSM_TIMER_MAX = 31;
+
+  // Writes "bbbbbbbb" for seconds in the first unit that reaches it, plus a null terminator.
+  static bool makePsmTimer(unsigned long seconds, const PsmTimerUnit *units, BYTE count, char *out) {
+    if (seconds == 0) {
+      seconds = 1;
+    }
+    for (BYTE u = 0; u < count; ++u) {
+      const unsigned long value = (seconds + units[u].seconds - 1) / units[u].seconds;
+      if (value > PSM_TIMER_MAX) {
+        continue;
+      }
+      const BYTE octet = (BYTE)((units[u].code << 5) | value);
+      out[0] = '"';
+      for (BYTE bit = 0; bit < 8; ++bit) {
+        out[1 + bit] = (octet & (0x80 >> bit)) ? '1' : '0';
+      }
+      out[9] = '"';
+      out[10] = '\0';
+      return true;
+    }
+    return false;
+  }
+
+  bool makePsmParams(unsigned long tauS, unsigned long activeS, char *out) {
+    if (!makePsmTimer(tauS, TAU_UNITS, sizeof(TAU_UNITS) / sizeof(TAU_UNITS[0]), out)) {
+      return false;
+    }
+    out[10] = ',';
+    return makePsmTimer(activeS, ACTIVE_UNITS, sizeof(ACTIVE_UNITS) / sizeof(ACTIVE_UNITS[0]), out + 11);
+  }
+
+  InfiniCellularUplink::InfiniCellularUplink() :
+    m_state(CELL_ASLEEP),
+    m_maxLatencyMs(0),
+    m_batchLimit(0),
+    m_wakeMs(CELL_WAKE_MS),
+    m_connectMs(CELL_CONNECT_MS),
+    m_bytesPerS(CELL_BYTES_PER_S),
+    m_wakeLearnt(false),
+    m_connectLearnt(false),
+    m_throughputLearnt(false),
+    m_lastReused(false),
+    m_wokeMs(0),
+    m_stepMs(0),
+    m_backoffMs(0),
+    m_sleptMs(0),
+    m_wakes(0),
+    m_reused(0),
+    m_failed(0),
+    m_bytes(0)
+  {
+  }
+
+  void InfiniCellularUplink::setMaxLatency(unsigned long maxLatencyMs) {
+    m_maxLatencyMs = maxLatencyMs;
+  }
+
+  void InfiniCellularUplink::setBatchLimit(unsigned long bytes) {
+    m_batchLimit = bytes;
+  }
+
+  bool InfiniCellularUplink::shouldWake(unsigned long pendingBytes, unsigned long oldestAgeMs,
+                                        unsigned long nowMs) const {
+    if (m_state != CELL_ASLEEP || pendingBytes == 0 || nowMs - m_sleptMs < m_backoffMs) {
+      return false;
+    }
+    return pendingBytes >= batchTargetBytes() || (m_maxLatencyMs > 0 && oldestAgeMs >= m_maxLatencyMs);
+  }
+
+  unsigned long InfiniCellularUplink::msUntilWake(unsigned long oldestAgeMs, unsigned long nowMs) const {
+    if (m_state != CELL_ASLEEP) {
+      return 0;
+    }
+    const unsigned long sinceSleep = nowMs - m_sleptMs;
+    const unsigned long backoff = sinceSleep < m_backoffMs ? m_backoffMs - sinceSleep : 0;
+    if (m_maxLatencyMs == 0) {
+      return backoff > 0 ? backoff : CELL_MAX_BACKOFF_MS;
+    }
+    const unsigned long latency = oldestAgeMs < m_maxLatencyMs ? m_maxLatencyMs - oldestAgeMs : 0;
+    return backoff > latency ? backoff : latency;
+  }
+
+  unsigned long InfiniCellularUplink::batchTargetBytes() const {
+    // A reused session skips the handshakes, so the next wake likely costs only the attach.
+    const unsigned long fixedMs = m_wakeMs + (m_lastReused ? 0 : m_connectMs);
+    const uint64_t target = (uint64_t)m_bytesPerS * fixedMs * CELL_PAYLOAD_RATIO / 1000;
+    if (m_batchLimit > 0 && target > m_batchLimit) {
+      return m_batchLimit;
+    }
+    return (unsigned long)target;
+  }
+
+  void InfiniCellularUplink::beginWake(unsigned long nowMs) {
+    m_state = CELL_WAKING;
+    m_wokeMs = nowMs;
+    m_stepMs = nowMs;
+    m_wakes++;
+  }
+
+  void InfiniCellularUplink::onAttached(unsigned long nowMs) {
+    smooth(m_wakeMs, nowMs - m_stepMs, !m_wakeLearnt);
+    m_wakeLearnt = true;
+    m_state = CELL_CONNECTING;
+    m_stepMs = nowMs;
+  }
+
+  void InfiniCellularUplink::onSessionUp(bool reused, unsigned long nowMs) {
+    if (reused) {
+      m_reused++;
+    } else {
+      smooth(m_connectMs, nowMs - m_stepMs, !m_connectLearnt);
+      m_connectLearnt = true;
+    }
+    m_lastReused = reused;
+    m_state = CELL_ONLINE;
+  }
+
+  void InfiniCellularUplink::onFlushed(unsigned long bytes, unsigned long durationMs) {
+    m_bytes += bytes;
+    if (durationMs == 0) {
+      return;
+    }
+    smooth(m_bytesPerS, (unsigned long)((uint64_t)bytes * 1000 / durationMs), !m_throughputLearnt);
+    m_throughputLearnt = true;
+  }
+
+  void InfiniCellularUplink::endWake(unsigned long nowMs) {
+    m_state = CELL_ASLEEP;
+    m_sleptMs = nowMs;
+    m_backoffMs = 0;
+  }
+
+  void InfiniCellularUplink::onFailed(unsigned long nowMs) {
+    m_failed++;
+    m_state = CELL_ASLEEP;
+    m_sleptMs = nowMs;
+    m_lastReused = false;
+    if (m_backoffMs == 0) {
+      m_backoffMs = m_wakeMs + m_connectMs;
+    } else {
+      m_backoffMs = m_backoffMs > CELL_MAX_BACKOFF_MS / 2 ? CELL_MAX_BACKOFF_MS : m_backoffMs * 2;
+    }
+  }
+
+  CELL_STATE InfiniCellularUplink::state() const {
+    return m_state;
+  }
+
+  unsigned long InfiniCellularUplink::awakeMs(unsigned long nowMs) const {
+    return m_state == CELL_ASLEEP ? 0 : nowMs - m_wokeMs;
+  }
+
+  unsigned long InfiniCellularUplink::wakeMs() const {
+    return m_wakeMs;
+  }
+
+  unsigned long InfiniCellularUplink::connectMs() const {
+    return m_connectMs;
+  }
+
+  unsigned long InfiniCellularUplink::bytesPerS() const {
+    return m_bytesPerS;
+  }
+
+  size_t InfiniCellularUplink::writeJson(Print &out) const {
+    size_t n = writeJsonFieldP(out, INFI_PSTR("cellWakes"), m_wakes, JSON_UINT, true);
+    n += writeJsonFieldP(out, INFI_PSTR("cellReused"), m_reused, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("cellFailed"), m_failed, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("cellWakeMs"), m_wakeMs, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("cellConnectMs"), m_connectMs, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("cellBps"), m_bytesPerS, JSON_UINT, false);
+    // Past what an AVR unsigned int prints through JSON_UINT.
+    n += out.print(INFI_F(",\"cellBatch\":"));
+    n += out.print(batchTargetBytes());
+    n += out.print(INFI_F(",\"cellBytes\":"));
+    n += out.print(m_bytes);
+    n += out.print('}');
+    return n;
+  }
+
+  void InfiniCellularUplink::smooth(unsigned long &value, unsigned long sample, bool first) {
+    if (first) {
+      value = sample;
+    } else if (sample >= value) {
+      value += (sample - value) / 4;
+    } else {
+      value -= (value - sample) / 4;
+    }
+  }
+}
+#endif
@@ -0,0 +1,137 @@
+#ifndef INFINI_CELLULAR_H
+#define INFINI_CELLULAR_H
+
+#include <Print.h>
+#include "InfiniCommon.h"
+
+// What a flush is assumed to take before one was measured: the modem out of PSM and attached, milliseconds,
+// the TCP and MQTT handshakes on top, milliseconds, and the uplink throughput, bytes per second.
+#ifndef INFI_CELL_WAKE_MS
+#define INFI_CELL_WAKE_MS 6000
+#endif
+#ifndef INFI_CELL_CONNECT_MS
+#define INFI_CELL_CONNECT_MS 4000
+#endif
+#ifndef INFI_CELL_BYTES_PER_S
+#define INFI_CELL_BYTES_PER_S 2000
+#endif
+
+// How many times its fixed cost a wake should spend sending, e.g. 2 for two thirds of the radio time on payload.
+#ifndef INFI_CELL_PAYLOAD_RATIO
+#define INFI_CELL_PAYLOAD_RATIO 2
+#endif
+
+// Longest back off after failed wakes, milliseconds, it doubles from the wake time up to this.
+#ifndef INFI_CELL_MAX_BACKOFF_MS
+#define INFI_CELL_MAX_BACKOFF_MS 900000UL
+#endif
+
+namespace INFI {
+
+  const unsigned long CELL_WAKE_MS = INFI_CELL_WAKE_MS;
+  const unsigned long CELL_CONNECT_MS = INFI_CELL_CONNECT_MS;
+  const unsigned long CELL_BYTES_PER_S = INFI_CELL_BYTES_PER_S;
+  const BYTE CELL_PAYLOAD_RATIO = INFI_CELL_PAYLOAD_RATIO;
+  const unsigned long CELL_MAX_BACKOFF_MS = INFI_CELL_MAX_BACKOFF_MS;
+
+  //! Length of the two quoted timers of the AT+CPSMS params, "01000011","00000001", plus a null terminator.
+  const BYTE CELL_PSM_PARAMS_SZ = 22;
+
+  /*! Writes the params of AT+CPSMS=1,,,<params> that ask the network for a periodic TAU of at least tauS
+   * and an active time of at least activeS, the GPRS timer 3 and 2 bytes of 3GPP TS 24.008 in binary digits.
+   * Each is rounded up to the next value its units can express. Returns false if tauS is over 320 h x 31
+   * or activeS over 186 min. The network may grant other values, AT+CEREG=4 reports them.
+   */
+  bool makePsmParams(unsigned long tauS, unsigned long activeS, char *out);
+
+  enum CELL_STATE {
+    CELL_ASLEEP = 0,   // The modem is in PSM, or eDRX, and costs next to nothing.
+    CELL_WAKING,       // Coming out of PSM and attaching, beginWake() was called.
+    CELL_CONNECTING,   // Attached, the TCP and MQTT session is being opened or checked.
+    CELL_ONLINE        // The session is up, flush away.
+  };
+
+  /*!
+   * Decides when a cellular modem, e.g. a SIM7000 or SIM7600 behind a TinyGSM Client, is woken to flush the
+   * telemetry held back, and how much to send then. Getting out of PSM, attaching and opening the session cost
+   * seconds of a radio at full power whatever is sent after, so a wake is only worth it for a batch that keeps
+   * the radio busy CELL_PAYLOAD_RATIO times that long: batchTargetBytes() is the learnt throughput times the
+   * learnt fixed cost times the ratio, capped by setBatchLimit(). shouldWake() says so once that much is
+   * pending, or the oldest sample is setMaxLatency() old. A session that survived the sleep, i.e. the MQTT
+   * client is still connected as the modem is attached again, saves the handshakes, so after a reused one the
+   * fixed cost counts only the wake and batches are smaller.
+   * The sketch drives the modem and reports each step: beginWake(), onAttached(), onSessionUp(), onFlushed()
+   * for every batch sent, then endWake() as the modem goes back to PSM, or onFailed() for a back off.
+   */
+  class InfiniCellularUplink {
+    public:
+    InfiniCellularUplink();
+
+    //! No sample waits longer than maxLatencyMs for a wake, whatever the batch. 0 waits for a full batch.
+    void setMaxLatency(unsigned long maxLatencyMs);
+    //! Most bytes a wake is planned to send, e.g. what the history holds less a margin. 0 for no cap.
+    void setBatchLimit(unsigned long bytes);
+
+    /*! Whether to wake the modem now, with pendingBytes held back, the oldest taken oldestAgeMs ago.
+     * False while awake or backing off.
+     */
+    bool shouldWake(unsigned long pendingBytes, unsigned long oldestAgeMs, unsigned long nowMs) const;
+    //! How long until shouldWake() could turn true by the latency alone, e.g. for idleFor().
+    unsigned long msUntilWake(unsigned long oldestAgeMs, unsigned long nowMs) const;
+    //! Bytes a wake should send to be worth its fixed cost, see the class comment.
+    unsigned long batchTargetBytes() const;
+
+    //! The modem is being woken.
+    void beginWake(unsigned long nowMs);
+    //! Registered and the PDP context active. Learns the wake time.
+    void onAttached(unsigned long nowMs);
+    //! The session is ready, reused if it survived the sleep. Learns the handshake time of a new one.
+    void onSessionUp(bool reused, unsigned long nowMs);
+    //! A batch of bytes went out in durationMs. Learns the throughput.
+    void onFlushed(unsigned long bytes, unsigned long durationMs);
+    //! The modem is going back to PSM.
+    void endWake(unsigned long nowMs);
+    //! The wake did not get online, or the session broke. Back to sleep with a doubled back off.
+    void onFailed(unsigned long nowMs);
+
+    CELL_STATE state() const;
+    //! Milliseconds since beginWake(), e.g. to give up on a wake that takes too long. 0 while asleep.
+    unsigned long awakeMs(unsigned long nowMs) const;
+    //! The learnt fixed cost of a wake, and of opening a session on top, milliseconds.
+    unsigned long wakeMs() const;
+    unsigned long connectMs() const;
+    //! The learnt uplink throughput, bytes per second.
+    unsigned long bytesPerS() const;
+
+    /*! Writes the wake and session counts and what was learnt, e.g. {"cellWakes":12,"cellReused":9,
+     * "cellFailed":0,"cellWakeMs":5210,"cellConnectMs":3820,"cellBps":1840,"cellBatch":19168,"cellBytes":201532}.
+     */
+    size_t writeJson(Print &out) const;
+
+    private:
+    //! value += (sample - value) / 4, the first sample taken as it is.
+    static void smooth(unsigned long &value, unsigned long sample, bool first);
+
+    CELL_STATE m_state;
+    unsigned long m_maxLatencyMs;
+    unsigned long m_batchLimit;
+    unsigned long m_wakeMs;
+    unsigned long m_connectMs;
+    unsigned long m_bytesPerS;
+    //! What was learnt from measurements rather than assumed.
+    bool m_wakeLearnt;
+    bool m_connectLearnt;
+    bool m_throughputLearnt;
+    bool m_lastReused;
+    unsigned long m_wokeMs;
+    unsigned long m_stepMs;
+    unsigned long m_backoffMs;
+    unsigned long m_sleptMs;
+    unsigned long m_wakes;
+    unsigned long m_reused;
+    unsigned long m_failed;
+    unsigned long m_bytes;
+  };
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef INFINI_CIVIL_DATE_H
+#define INFINI_CIVIL_DATE_H
+
+#include "InfiniCommon.h"
+
+namespace INFI {
+
+  /*!
+   * Calendar arithmetic in plain integers, for the clock model, the log file names and the ED/EM/EY params,
+   * instead of mktime(), localtime() and sprintf(), which take the time zone and locale into account and can
+   * take a lock in newlib. There is no time zone here at all, a date is whatever clock it was read from.
+   * Everything is constexpr in the C++11 sense, so dates known at compile time cost nothing at run time,
+   * and the rest is a handful of integer divisions, after H. Hinnant's days_from_civil and civil_from_days.
+   * Only dates from 1970-01-01 on are handled.
+   */
+  struct CivilDate {
+    WORD year;
+    //! 1 to 12.
+    BYTE month;
+    //! 1 to 31.
+    BYTE day;
+  };
+
+  //! What changed between two days, see civilRollover().
+  enum CIVIL_ROLLOVER {
+    ROLLOVER_NONE = 0,
+    ROLLOVER_DAY = 1,
+    ROLLOVER_MONTH = 2,
+    ROLLOVER_YEAR = 4
+  };
+
+  constexpr bool isLeapYear(WORD year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  }
+
+  //! Days in month of year, month from 1 to 12.
+  constexpr BYTE daysInMonth(WORD year, BYTE month) {
+    return month == 2 ? (isLeapYear(year) ? 29 : 28) : (month == 4 || month == 6 || month == 9 || month == 11) ? 30 : 31;
+  }
+
+  //! Whether year, month and day name a day that exists, from 1970 on.
+  constexpr bool isValidCivil(long year, long month, long day) {
+    return year >= 1970 && year <= 65535 && month >= 1 && month <= 12 && day >= 1
+      && day <= daysInMonth((WORD)year, (BYTE)month);
+  }
+
+  namespace civil_detail {
+    // The year counts from March, so the leap day is the last day of its year. 400 years are 146097 days.
+    constexpr long dayOfEra(long yearOfEra, long dayOfYear) {
+      return yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    }
+    constexpr long daysFromMarchYear(long year, long month, long day) {
+      return year / 400 * 146097 + dayOfEra(year % 400, (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1)
+        - 719468;
+    }
+    constexpr long yearOfEra(long dayOfEra) {
+      return (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    }
+    constexpr CivilDate fromMonthIndex(long marchYear, long dayOfYear, long monthIndex) {
+      return CivilDate{ (WORD)(marchYear + (monthIndex >= 10 ? 1 : 0)),
+                        (BYTE)(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9),
+                        (BYTE)(dayOfYear - (153 * monthIndex + 2) / 5 + 1) };
+    }
+    constexpr CivilDate fromDayOfYear(long marchYear, long dayOfYear) {
+      return fromMonthIndex(marchYear, dayOfYear, (5 * dayOfYear + 2) / 153);
+    }
+    constexpr CivilDate fromYearOfEra(long era, long dayOfEra, long yearOfEra) {
+      return fromDayOfYear(era * 400 + yearOfEra, dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100));
+    }
+    constexpr CivilDate fromDayOfEra(long era, long dayOfEra) {
+      return fromYearOfEra(era, dayOfEra, yearOfEra(dayOfEra));
+    }
+    constexpr CivilDate fromShiftedDays(long days) {
+      return fromDayOfEra(days / 146097, days % 146097);
+    }
+  }
+
+  //! Days from 1970-01-01 to the given date, which must be valid, see isValidCivil().
+  constexpr long daysFromCivil(WORD year, BYTE month, BYTE day) {
+    return civil_detail::daysFromMarchYear(month <= 2 ? year - 1 : year, month, day);
+  }
+
+  //! The date days after 1970-01-01, days not negative.
+  constexpr CivilDate civilFromDays(long days) {
+    return civil_detail::fromShiftedDays(days + 719468);
+  }
+
+  //! Days from 1970-01-01 to 2000-01-01, where InfiniClock counts its seconds from.
+  constexpr long DAYS_TO_2000 = daysFromCivil(2000, 1, 1);
+  static_assert(DAYS_TO_2000 == 10957, "daysFromCivil() is off");
+  static_assert(civilFromDays(DAYS_TO_2000 + 59).month == 2 && civilFromDays(DAYS_TO_2000 + 59).day == 29,
+                "civilFromDays() is off");
+
+  //! Which of the day, month and year differ between the dates a and b, as CIVIL_ROLLOVER bits.
+  constexpr BYTE civilRollover(const CivilDate &a, const CivilDate &b) {
+    return (a.year != b.year ? ROLLOVER_DAY | ROLLOVER_MONTH | ROLLOVER_YEAR : 0)
+      | (a.month != b.month ? ROLLOVER_DAY | ROLLOVER_MONTH : 0) | (a.day != b.day ? ROLLOVER_DAY : 0);
+  }
+
+  //! civilRollover() of two days counted from 1970-01-01. Two days a month apart roll the month over, of course.
+  constexpr BYTE civilRollover(long daysA, long daysB) {
+    return daysA == daysB ? (BYTE)ROLLOVER_NONE : civilRollover(civilFromDays(daysA), civilFromDays(daysB));
+  }
+
+  //! The value of count digits at in, or -1 if one of them is not a digit.
+  inline long readDigits(const char *in, BYTE count) {
+    long value = 0;
+    for (BYTE i = 0; i < count; ++i) {
+      if (in[i] < '0' || in[i] > '9') {
+        return -1;
+      }
+      value = value * 10 + (in[i] - '0');
+    }
+    return value;
+  }
+
+  //! The last width digits of value at out, zero padded and without a terminator.
+  inline void writeDigits(unsigned long value, BYTE width, char *out) {
+    for (BYTE i = width; i > 0; --i) {
+      out[i - 1] = '0' + value % 10;
+      value /= 10;
+    }
+  }
+
+  //! value in decimal plus a null terminator, what sprintf("%lu") writes. Returns its length, at most 10.
+  inline BYTE formatUnsigned(unsigned long value, char *out) {
+    BYTE width = 1;
+    for (unsigned long rest = value / 10; rest > 0; rest /= 10) {
+      width++;
+    }
+    writeDigits(value, width, out);
+    out[width] = '\0';
+    return width;
+  }
+
+  //! date as YYYYMMDD, the ED param, plus a null terminator. EM and EY take its first TIME_MON_SZ and TIME_YEAR_SZ.
+  inline void formatCivilDay(const CivilDate &date, char *out) {
+    writeDigits(date.year, 4, out);
+    writeDigits(date.month, 2, out + 4);
+    writeDigits(date.day, 2, out + 6);
+    out[TIME_DAY_SZ] = '\0';
+  }
+}
+
+#endif
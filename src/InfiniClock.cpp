@@ -0,0 +1,134 @@
+#include "InfiniClock.h"
+#include "InfiniCivilDate.h"
+
+namespace INFI {
+
+  static const unsigned long SECONDS_PER_DAY = 86400UL;
+
+  InfiniClock::InfiniClock() :
+    m_synced(false),
+    m_syncSeconds(0),
+    m_syncMs(0),
+    m_syncAgeMs(0),
+    m_lastDriftS(0)
+  {}
+
+  bool InfiniClock::sync(const char *digits, unsigned long nowMs) {
+    unsigned long seconds;
+    if (!parseSeconds(digits, seconds)) {
+      return false;
+    }
+    m_lastDriftS = m_synced ? (long)(seconds - now(nowMs)) : 0;
+    m_syncSeconds = seconds;
+    m_syncMs = nowMs;
+    m_syncAgeMs = 0;
+    m_synced = true;
+    return true;
+  }
+
+  void InfiniClock::invalidate() {
+    m_synced = false;
+    m_lastDriftS = 0;
+  }
+
+  bool InfiniClock::isSynced() const {
+    return m_synced;
+  }
+
+  unsigned long InfiniClock::now(unsigned long nowMs) const {
+    // Unsigned subtraction, so a millis() wrap in between is fine.
+    return m_syncSeconds + (nowMs - m_syncMs) / 1000UL;
+  }
+
+  uint64_t InfiniClock::unixMs(unsigned long nowMs, long utcOffsetS) const {
+    const unsigned long elapsedMs = nowMs - m_syncMs;
+    const int64_t seconds = (int64_t)m_syncSeconds + elapsedMs / 1000UL + UNIX_SECONDS_AT_2000 - utcOffsetS;
+    return (uint64_t)seconds * 1000ULL + elapsedMs % 1000UL;
+  }
+
+  bool InfiniClock::getToday(char *out, unsigned long nowMs) const {
+    if (!m_synced) {
+      return false;
+    }
+    formatDay(now(nowMs), out);
+    return true;
+  }
+
+  long InfiniClock::lastDriftS() const {
+    return m_lastDriftS;
+  }
+
+  unsigned long InfiniClock::resyncPeriodMs() const {
+    long drift = m_lastDriftS < 0 ? -m_lastDriftS : m_lastDriftS;
+    return drift > CLOCK_MAX_DRIFT_S ? CLOCK_DRIFT_RESYNC_MS : CLOCK_RESYNC_MS;
+  }
+
+  unsigned long InfiniClock::msSinceSync(unsigned long nowMs) const {
+    return m_syncAgeMs + (nowMs - m_syncMs);
+  }
+
+  void InfiniClock::saveState(ClockState &state, unsigned long nowMs) const {
+    const unsigned long elapsedMs = nowMs - m_syncMs;
+    state.synced = m_synced;
+    state.seconds = m_syncSeconds + elapsedMs / 1000UL;
+    state.ms = elapsedMs % 1000UL;
+    state.sinceSyncMs = msSinceSync(nowMs);
+    state.lastDriftS = m_lastDriftS;
+  }
+
+  void InfiniClock::restoreState(const ClockState &state, unsigned long msSinceSave, unsigned long nowMs) {
+    const unsigned long elapsedMs = state.ms + msSinceSave;
+    m_synced = state.synced;
+    // Anchored on the last whole second, so now() keeps ticking over at the same moments.
+    m_syncSeconds = state.seconds + elapsedMs / 1000UL;
+    m_syncMs = nowMs - elapsedMs % 1000UL;
+    m_syncAgeMs = state.sinceSyncMs + msSinceSave - elapsedMs % 1000UL;
+    m_lastDriftS = state.lastDriftS;
+  }
+
+  unsigned long InfiniClock::toSeconds(WORD year, BYTE month, BYTE day, BYTE hour, BYTE minute, BYTE second) {
+    const unsigned long days = daysFromCivil(year, month, day) - DAYS_TO_2000;
+    return days * SECONDS_PER_DAY + hour * 3600UL + minute * 60UL + second;
+  }
+
+  bool InfiniClock::parseSeconds(const char *digits, unsigned long &seconds) {
+    long year = readDigits(digits, 4);
+    long month = readDigits(digits + 4, 2);
+    long day = readDigits(digits + 6, 2);
+    long hour = readDigits(digits + 8, 2);
+    long minute = readDigits(digits + 10, 2);
+    long second = readDigits(digits + 12, 2);
+    if (year < 2000 || !isValidCivil(year, month, day)
+        || hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59) {
+      return false;
+    }
+    seconds = toSeconds(year, month, day, hour, minute, second);
+    return true;
+  }
+
+  //! The calendar date of seconds since 2000-01-01.
+  static CivilDate dayOf(unsigned long seconds) {
+    return civilFromDays(DAYS_TO_2000 + (long)(seconds / SECONDS_PER_DAY));
+  }
+
+  void InfiniClock::formatDay(unsigned long seconds, char *out) {
+    formatCivilDay(dayOf(seconds), out);
+  }
+
+  bool InfiniClock::formatDateTime(unsigned long seconds, char *out) {
+    const CivilDate date = dayOf(seconds);
+    if (date.year > 2099) {
+      // DAT only takes two digits of the year.
+      return false;
+    }
+    const unsigned long secondOfDay = seconds % SECONDS_PER_DAY;
+    writeDigits(date.year - 2000, 2, out);
+    writeDigits(date.month, 2, out + 2);
+    writeDigits(date.day, 2, out + 4);
+    writeDigits(secondOfDay / 3600, 2, out + 6);
+    writeDigits(secondOfDay / 60 % 60, 2, out + 8);
+    writeDigits(secondOfDay % 60, 2, out + 10);
+    out[DATE_TIME_PARAMS_SZ] = '\0';
+    return true;
+  }
+}
@@ -0,0 +1,122 @@
+#ifndef INFINI_CLOCK_H
+#define INFINI_CLOCK_H
+
+#include <stdint.h>
+#include "InfiniCommon.h"
+
+// How often the clock model is resynced with T, milliseconds.
+#ifndef INFI_CLOCK_RESYNC_MS
+#define INFI_CLOCK_RESYNC_MS 900000UL
+#endif
+
+// Drift, in seconds, past which the next resync comes after INFI_CLOCK_DRIFT_RESYNC_MS instead.
+#ifndef INFI_CLOCK_MAX_DRIFT_S
+#define INFI_CLOCK_MAX_DRIFT_S 2
+#endif
+#ifndef INFI_CLOCK_DRIFT_RESYNC_MS
+#define INFI_CLOCK_DRIFT_RESYNC_MS 60000UL
+#endif
+
+namespace INFI {
+
+  const unsigned long CLOCK_RESYNC_MS = INFI_CLOCK_RESYNC_MS;
+  const long CLOCK_MAX_DRIFT_S = INFI_CLOCK_MAX_DRIFT_S;
+  const unsigned long CLOCK_DRIFT_RESYNC_MS = INFI_CLOCK_DRIFT_RESYNC_MS;
+
+  //! 2000-01-01 00:00 in seconds since the Unix epoch.
+  const unsigned long UNIX_SECONDS_AT_2000 = 946684800UL;
+
+  //! Length of the YYYYMMDDHHFFSS digits in a T reply.
+  const BYTE TIME_SECOND_SZ = TIME_DAY_SZ + 6;
+  //! Length of the yymmddhhffss params of DAT.
+  const BYTE DATE_TIME_PARAMS_SZ = TIME_SECOND_SZ - 2;
+
+  /*! What InfiniClock::saveState() keeps, plain data so it can sit in ESP32 RTC memory over a deep sleep,
+   * where millis() starts again from 0.
+   */
+  struct ClockState {
+    bool synced;
+    //! Inverter time at the save, seconds since 2000-01-01 and the milliseconds past them.
+    unsigned long seconds;
+    WORD ms;
+    //! Milliseconds from the last T sync to the save.
+    unsigned long sinceSyncMs;
+    long lastDriftS;
+  };
+
+  /*!
+   * A model of the inverter's wall clock: the time of the last T reply plus the millis() since.
+   * Date params for ED/EM/EY come from it, so T only has to be polled every resyncPeriodMs().
+   * Times are seconds since 2000-01-01 00:00 in the inverter's own (local) time, there is no time zone.
+   * The calendar math is the integer arithmetic of InfiniCivilDate.h, there is no mktime().
+   */
+  class InfiniClock {
+    public:
+    InfiniClock();
+
+    /*! Syncs to the YYYYMMDDHHFFSS digits of a checked T reply, i.e. the reply from START_OFFSET_SZ on.
+     * Returns false, and leaves the model as it was, if they are not a valid date and time.
+     */
+    bool sync(const char *digits, unsigned long nowMs);
+
+    //! Forgets the sync, e.g. after the inverter's clock was set with DAT.
+    void invalidate();
+
+    bool isSynced() const;
+
+    //! Inverter time in seconds since 2000-01-01, only meaningful once synced.
+    unsigned long now(unsigned long nowMs) const;
+
+    /*! Milliseconds since the Unix epoch, e.g. for telemetry timestamps. utcOffsetS is how far the
+     * inverter's local time is ahead of UTC, e.g. 19800 for India. Only meaningful once synced.
+     */
+    uint64_t unixMs(unsigned long nowMs, long utcOffsetS) const;
+
+    //! Writes the inverter's current day as YYYYMMDD plus a null terminator, the ED param. False if not synced.
+    bool getToday(char *out, unsigned long nowMs) const;
+
+    //! How far the model was off at the last sync, in seconds, positive if the inverter was ahead.
+    long lastDriftS() const;
+
+    //! When to sync next: CLOCK_RESYNC_MS, or CLOCK_DRIFT_RESYNC_MS after a drift beyond CLOCK_MAX_DRIFT_S.
+    unsigned long resyncPeriodMs() const;
+
+    //! Milliseconds since the last sync, also across a saveState() and restoreState().
+    unsigned long msSinceSync(unsigned long nowMs) const;
+
+    //! Stores the model as of nowMs.
+    void saveState(ClockState &state, unsigned long nowMs) const;
+
+    /*! Resumes from state, saved msSinceSave ago, e.g. the deep sleep time plus millis() since the wake.
+     * Whatever msSinceSave is off by, e.g. the drift of the RTC slow clock, the model is off by until the next sync.
+     */
+    void restoreState(const ClockState &state, unsigned long msSinceSave, unsigned long nowMs);
+
+    //! Seconds since 2000-01-01 of the given date and time. The date must be from 2000 on.
+    static unsigned long toSeconds(WORD year, BYTE month, BYTE day, BYTE hour, BYTE minute, BYTE second);
+
+    /*! Reads the YYYYMMDDHHFFSS digits of a T reply into seconds since 2000-01-01.
+     * Returns false, and leaves seconds as it was, if they are not a valid date and time.
+     */
+    static bool parseSeconds(const char *digits, unsigned long &seconds);
+
+    //! Writes the YYYYMMDD date of seconds since 2000-01-01, plus a null terminator.
+    static void formatDay(unsigned long seconds, char *out);
+
+    /*! Writes seconds since 2000-01-01 as the yymmddhhffss params of DAT, plus a null terminator.
+     * Returns false if the year is past 2099, which two digits cannot hold.
+     */
+    static bool formatDateTime(unsigned long seconds, char *out);
+
+    private:
+    bool m_synced;
+    //! Inverter time at the millis() m_syncMs.
+    unsigned long m_syncSeconds;
+    unsigned long m_syncMs;
+    //! How long before m_syncMs the last sync was, only nonzero after restoreState().
+    unsigned long m_syncAgeMs;
+    long m_lastDriftS;
+  };
+}
+
+#endif
@@ -0,0 +1,141 @@
+#include "InfiniColumnKernels.h"
+
+#if INFI_MODULE_BINARY
+
+namespace INFI {
+
+  static void wordColumnStatsScalar(const WORD *values, unsigned long count, WORD &min, WORD &max,
+                                    unsigned long &sum) {
+    WORD lo = min;
+    WORD hi = max;
+    unsigned long total = sum;
+    for (unsigned long i = 0; i < count; ++i) {
+      lo = values[i] < lo ? values[i] : lo;
+      hi = values[i] > hi ? values[i] : hi;
+      total += values[i];
+    }
+    min = lo;
+    max = hi;
+    sum = total;
+  }
+
+#if INFI_COLUMN_IMPL == INFI_COLUMN_PIE
+  // The PIE compares and multiplies signed lanes, so the values are flipped to signed by their top bit,
+  // which keeps their order: 0 becomes -32768 and 0xFFFF 32767.
+  static const int16_t PIE_BIAS = (int16_t)0x8000;
+  static const int16_t PIE_ONE = 1;
+  static const int16_t PIE_MIN_START = 0x7FFF;
+  static const int16_t PIE_MAX_START = (int16_t)0x8000;
+  // Vectors per pass, so the biased sum, at most 32768 a value, stays within the 32 bits read off ACCX.
+  static const unsigned long PIE_PASS_VECTORS = 4096;
+
+  // Folds vectors of 8 values at values, which is 16 byte aligned, into the lanes of mins and maxs, biased,
+  // and returns their biased sum. The whole loop is one asm block, so the compiler never sees the Q registers.
+  static int32_t pieStatsPass(const WORD *values, unsigned long vectors, int16_t *mins, int16_t *maxs) {
+    int32_t biasedSum;
+    asm volatile(
+      "ee.vldbc.16 q3, %[bias]\n"
+      "ee.vldbc.16 q4, %[one]\n"
+      "ee.vld.128.ip q0, %[mins], 0\n"
+      "ee.vld.128.ip q1, %[maxs], 0\n"
+      "ee.zero.accx\n"
+      "1:\n"
+      "ee.vld.128.ip q2, %[values], 16\n"
+      "ee.xorq q2, q2, q3\n"
+      "ee.vmin.s16 q0, q0, q2\n"
+      "ee.vmax.s16 q1, q1, q2\n"
+      // ACCX += the sum of the lanes times 1.
+      "ee.vmulas.s16.accx q2, q4\n"
+      "addi %[vectors], %[vectors], -1\n"
+      "bnez %[vectors], 1b\n"
+      "ee.vst.128.ip q0, %[mins], 0\n"
+      "ee.vst.128.ip q1, %[maxs], 0\n"
+      "ee.srs.accx %[sum], %[vectors], 0\n"
+      : [values] "+r"(values), [vectors] "+r"(vectors), [sum] "=&r"(biasedSum)
+      : [bias] "r"(&PIE_BIAS), [one] "r"(&PIE_ONE), [mins] "r"(mins), [maxs] "r"(maxs)
+      : "memory");
+    return biasedSum;
+  }
+
+  void wordColumnStats(const WORD *values, unsigned long count, WORD &min, WORD &max, unsigned long &sum) {
+    // Up to the first 16 byte boundary one at a time, the vector loads only take aligned addresses.
+    unsigned long head = ((16 - ((uintptr_t)values & 15)) & 15) / sizeof(WORD);
+    if (head > count) {
+      head = count;
+    }
+    wordColumnStatsScalar(values, head, min, max, sum);
+    values += head;
+    count -= head;
+    unsigned long vectors = count / 8;
+    if (vectors > 0) {
+      alignas(16) int16_t mins[8];
+      alignas(16) int16_t maxs[8];
+      for (BYTE lane = 0; lane < 8; ++lane) {
+        mins[lane] = PIE_MIN_START;
+        maxs[lane] = PIE_MAX_START;
+      }
+      while (vectors > 0) {
+        const unsigned long pass = vectors < PIE_PASS_VECTORS ? vectors : PIE_PASS_VECTORS;
+        const int32_t biasedSum = pieStatsPass(values, pass, mins, maxs);
+        sum += (unsigned long)(biasedSum + (int32_t)(pass * 8 * 32768UL));
+        values += pass * 8;
+        count -= pass * 8;
+        vectors -= pass;
+      }
+      for (BYTE lane = 0; lane < 8; ++lane) {
+        const WORD lo = (WORD)mins[lane] ^ 0x8000;
+        const WORD hi = (WORD)maxs[lane] ^ 0x8000;
+        min = lo < min ? lo : min;
+        max = hi > max ? hi : max;
+      }
+    }
+    wordColumnStatsScalar(values, count, min, max, sum);
+  }
+#else
+  void wordColumnStats(const WORD *values, unsigned long count, WORD &min, WORD &max, unsigned long &sum) {
+    wordColumnStatsScalar(values, count, min, max, sum);
+  }
+#endif
+
+  void wordColumnDeltas(const WORD *values, unsigned long count, WORD prev, uint32_t *tokens) {
+    // The differences take 17 bits, too wide for 16 bit lanes, so this one stays scalar. Branch free.
+    int32_t before = prev;
+    for (unsigned long i = 0; i < count; ++i) {
+      const int32_t value = values[i];
+      const int32_t d = value - before;
+      before = value;
+      tokens[i] = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+    }
+  }
+
+  bool column_kernels_self_test() {
+    // Extremes first, then xorshift values, with room behind them to start off every alignment.
+    alignas(16) WORD values[64 + 8];
+    const WORD extremes[] = { 0x0000, 0xFFFF, 0x8000, 0x7FFF, 0x8001, 0x7FFE, 0x0001, 0xFFFE };
+    uint32_t state = 0x9E3779B9UL;
+    for (BYTE i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      values[i] = i < sizeof(extremes) / sizeof(extremes[0]) ? extremes[i] : (WORD)state;
+    }
+    for (BYTE offset = 0; offset < 8; ++offset) {
+      for (BYTE count = 0; count <= 64; ++count) {
+        WORD min = 0xFFFF;
+        WORD max = 0;
+        unsigned long sum = 0;
+        WORD refMin = 0xFFFF;
+        WORD refMax = 0;
+        unsigned long refSum = 0;
+        wordColumnStats(values + offset, count, min, max, sum);
+        wordColumnStatsScalar(values + offset, count, refMin, refMax, refSum);
+        if (min != refMin || max != refMax || sum != refSum) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+}
+
+#endif
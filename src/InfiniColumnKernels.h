@@ -0,0 +1,49 @@
+#ifndef INFINI_COLUMN_KERNELS_H
+#define INFINI_COLUMN_KERNELS_H
+
+#include <stdint.h>
+#include "InfiniCommon.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(__has_include)
+#if __has_include(<sdkconfig.h>)
+#include <sdkconfig.h>
+#endif
+#endif
+
+/*
+ * Selects how the loops over the WORD columns of InfiniGsHistory run.
+ * INFI_COLUMN_SCALAR goes one value at a time, on every target.
+ * INFI_COLUMN_PIE runs the reductions 8 values at a time in the 128 bit registers of the ESP32-S3's
+ * processor instruction extensions. The default on the S3, which always has them.
+ * Both give the same result, override with a build flag, e.g. -DINFI_COLUMN_IMPL=INFI_COLUMN_SCALAR.
+ */
+#define INFI_COLUMN_SCALAR 0
+#define INFI_COLUMN_PIE 1
+
+#ifndef INFI_COLUMN_IMPL
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+#define INFI_COLUMN_IMPL INFI_COLUMN_PIE
+#else
+#define INFI_COLUMN_IMPL INFI_COLUMN_SCALAR
+#endif
+#endif
+
+namespace INFI {
+
+  /*! Folds count values into min, max and sum, which hold what was folded in before,
+   * e.g. 0xFFFF, 0 and 0 for the first run of a column.
+   */
+  void wordColumnStats(const WORD *values, unsigned long count, WORD &min, WORD &max, unsigned long &sum);
+
+  /*! The differences of count values to the value before each, prev for the first, as the zig-zag
+   * (d << 1) ^ (d >> 31) of each, so small steps either way give small tokens. For the varints of InfiniGsCodec.
+   */
+  void wordColumnDeltas(const WORD *values, unsigned long count, WORD prev, uint32_t *tokens);
+
+  /*! Checks wordColumnStats of the INFI_COLUMN_IMPL built against the scalar loop, over every length
+   * and alignment up to a few vectors. Returns false if any differs.
+   */
+  bool column_kernels_self_test();
+}
+
+#endif
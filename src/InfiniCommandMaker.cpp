@@ -1,7 +1,95 @@
 #include "InfiniCommandMaker.h"
 #include "InfiniCRC.h"
+#include <string.h>
 
 namespace INFI {
+  BYTE makeParallelParams(COMMAND_TYPE commandType, BYTE machine, WORD value, char *out, size_t outSz) {
+    const InfiniCommandDescriptor &desc = getCommandDescriptor(commandType);
+    // "m," then the value digits.
+    const BYTE digits = desc.paramSz - 2;
+    if (!desc.parallelAddressed || machine > MAX_PARALLEL_MACHINE || outSz < (size_t)desc.paramSz + 1) {
+      return 0;
+    }
+    out[0] = '0' + machine;
+    out[1] = ',';
+    for (BYTE i = 0; i < digits; ++i) {
+      out[desc.paramSz - 1 - i] = '0' + value % 10;
+      value /= 10;
+    }
+    if (value != 0) {
+      // Wider than the command takes.
+      out[0] = '\0';
+      return 0;
+    }
+    out[desc.paramSz] = '\0';
+    return desc.paramSz;
+  }
+
+  COMMAND_TYPE parseCommandFrame(const char *frame, size_t len, char *params, size_t paramsSz) {
+    if (len < START_OFFSET_SZ + CRC_SZ + END_TOKEN_SZ || len > 0xFF || frame[0] != '^' ||
+        (frame[1] != 'P' && frame[1] != 'S') || frame[len - 1] != '\r') {
+      return NUM_COMMAND_TYPES;
+    }
+    size_t toEnd = 0;
+    for (BYTE i = START_TOKEN_SZ; i < START_OFFSET_SZ; ++i) {
+      if (frame[i] < '0' || frame[i] > '9') {
+        return NUM_COMMAND_TYPES;
+      }
+      toEnd = toEnd * 10 + (frame[i] - '0');
+    }
+    if (toEnd != len - START_OFFSET_SZ) {
+      return NUM_COMMAND_TYPES;
+    }
+    const BYTE crcPos = len - CRC_SZ - END_TOKEN_SZ;
+    WORD crc = calc_crc_half((const BYTE *)frame, crcPos);
+    if ((BYTE)frame[crcPos] != (crc >> 8) || (BYTE)frame[crcPos + 1] != (crc & 0xFF)) {
+      return NUM_COMMAND_TYPES;
+    }
+    const ACTION_TYPE actionType = frame[1] == 'P' ? READ : UPDATE;
+    const size_t bodySz = crcPos - START_OFFSET_SZ;
+    for (BYTE i = 0; i < NUM_COMMAND_TYPES; ++i) {
+      const InfiniCommandDescriptor &desc = getCommandDescriptor((COMMAND_TYPE)i);
+      const size_t mnemonicSz = getMnemonicSize(desc.mnemonic);
+      if (desc.actionType != actionType || mnemonicSz + desc.paramSz != bodySz ||
+          strncmp(frame + START_OFFSET_SZ, desc.mnemonic, mnemonicSz) != 0) {
+        continue;
+      }
+      if (params != NULL) {
+        if (paramsSz < (size_t)desc.paramSz + 1) {
+          return NUM_COMMAND_TYPES;
+        }
+        memcpy(params, frame + START_OFFSET_SZ + mnemonicSz, desc.paramSz);
+        params[desc.paramSz] = '\0';
+      }
+      return (COMMAND_TYPE)i;
+    }
+    return NUM_COMMAND_TYPES;
+  }
+
+  BYTE getSettingValueCount(COMMAND_TYPE commandType) {
+    switch (commandType) {
+      case SET_OUTPUT_SOURCE_PRIORITY:
+        return NUM_OUTPUT_SOURCE_PRIORITIES;
+      case SET_CHARGING_SOURCE_PRIORITY:
+        return NUM_CHARGER_SOURCE_PRIORITIES;
+      case SET_SOLAR_POWER_PRIORITY:
+        return NUM_SOLAR_POWER_PRIORITIES;
+      case SET_BATTERY_TYPE:
+        return NUM_BATTERY_TYPES;
+      default:
+        return 0;
+    }
+  }
+
+  BYTE makeSettingParams(COMMAND_TYPE commandType, BYTE value, char *out, size_t outSz) {
+    if (getCommandDescriptor(commandType).paramSz != 1 || value >= getSettingValueCount(commandType) || outSz < 2) {
+      return 0;
+    }
+    out[0] = '0' + value;
+    out[1] = '\0';
+    return 1;
+  }
+
   InfiniCommandMaker::InfiniCommandMaker() :
     m_cmdToEndSz(0)
   {}
@@ -11,7 +99,7 @@ namespace INFI {
     command.reset();
 
     // Get the cmdToEnd size in the protocol manual based on the commandType.
-    m_cmdToEndSz = CMD_TO_END_SZS[commandType];
+    m_cmdToEndSz = getCommandToEndSize(commandType);
     
     // Insert the start token, length and command chars
     makeStartLengthCommand(commandType, params);
@@ -24,52 +112,40 @@ namespace INFI {
     command.actualLen += CRC_SZ + END_TOKEN_SZ;
   }
   
-  void InfiniCommandMaker::makeStartLengthCommand(COMMAND_TYPE commandType, const char* params) {
-    if (commandType == CURRENT_TIME) {
-      insertStartLengthCommand(READ, "T", "");
-    } else if (commandType == TOTAL_GEN_ENERGY) {
-      insertStartLengthCommand(READ, "ET", "");
-    } else if (commandType == GEN_ENERGY_YEAR) {
-      insertStartLengthCommand(READ, "EY", params);
-    } else if (commandType == GEN_ENERGY_MONTH) {
-      insertStartLengthCommand(READ, "EM", params);
-    } else if (commandType == GEN_ENERGY_DAY) {
-      insertStartLengthCommand(READ, "ED", params);
-    } else if (commandType == GENERAL_STATUS) {
-      insertStartLengthCommand(READ, "GS", "");
-    } else if (commandType == QUERY_RATED_INFORMATION) {
-      insertStartLengthCommand(READ, "PIRI", "");
-    } else if (commandType == FAULT_WARNING_STATUS) {
-      insertStartLengthCommand(READ, "FWS", "");
-    } else if (commandType == QUERY_ENABLE_DISABLE_STATUS) {
-      insertStartLengthCommand(READ, "FLAG", "");
-    } else if (commandType == QUERY_DEFAULT_VALUE) {
-      insertStartLengthCommand(READ, "DI", "");
-    } else if (commandType == QUERY_MAX_CHARGING_CURRENT) {
-      insertStartLengthCommand(READ, "MCHGCR", "");
-    } else if (commandType == QUERY_MAX_AC_CHARGING_CURRENT) {
-      insertStartLengthCommand(READ, "MUCHGCR", "");
-    } else if (commandType == SET_ENABLE_DISABLE_STATUS) {
-      insertStartLengthCommand(UPDATE, "P", params);
-    } else if (commandType == SET_MAX_CHARGING_CURRENT) {
-      insertStartLengthCommand(UPDATE, "MCHGC", params);
-    } else if (commandType == SET_MAX_AC_CHARGING_CURRENT) {
-      insertStartLengthCommand(UPDATE, "MUCHGC", params);
-    } else if (commandType == AC_OUT_FREQ_50) {
-      insertStartLengthCommand(UPDATE, "F50", "");
-    } else if (commandType == AC_OUT_FREQ_60) {
-      insertStartLengthCommand(UPDATE, "F60", "");
-    } else if (commandType == SET_OUTPUT_SOURCE_PRIORITY) {
-      insertStartLengthCommand(UPDATE, "POP", params);
-    } else if (commandType == SET_CHARGING_SOURCE_PRIORITY) {
-      insertStartLengthCommand(UPDATE, "PCP", params);
-    } else if (commandType == SET_SOLAR_POWER_PRIORITY) {
-      insertStartLengthCommand(UPDATE, "PSP", params);
-    } else if (commandType == SET_BATTERY_TYPE) {
-      insertStartLengthCommand(UPDATE, "PBT", params);
-    } else if (commandType == SET_DATE_TIME) {
-      insertStartLengthCommand(UPDATE, "DAT", params);
+  BYTE InfiniCommandMaker::writeCommand(COMMAND_TYPE commandType, const char* params, Print &out) {
+    const InfiniCommandDescriptor &desc = getCommandDescriptor(commandType);
+    InfiniCrcAccumulator crc;
+
+    // The start token and length, same as insertStartAndType and insertLength.
+    BYTE header[START_OFFSET_SZ];
+    header[0] = '^';
+    header[1] = (desc.actionType == UPDATE) ? 'S' : 'P';
+    getThreeDigits(getCommandToEndSize(commandType), header, START_TOKEN_SZ);
+    crc.update(header, START_OFFSET_SZ);
+    BYTE written = out.write(header, START_OFFSET_SZ);
+
+    // The mnemonic, then at most paramSz param chars.
+    for (const char *c = desc.mnemonic; *c != '\0'; ++c) {
+      crc.update((BYTE)*c);
+      written += out.write((BYTE)*c);
+    }
+    if (desc.paramSz > 0 && params != NULL) {
+      for (BYTE i = 0; i < desc.paramSz && params[i] != '\0'; ++i) {
+        crc.update((BYTE)params[i]);
+        written += out.write((BYTE)params[i]);
+      }
     }
+
+    WORD value = crc.finalize();
+    BYTE trailer[CRC_SZ + END_TOKEN_SZ] = { (BYTE)(value >> 8), (BYTE)(value & 0xff), '\r' };
+    written += out.write(trailer, CRC_SZ + END_TOKEN_SZ);
+    return written;
+  }
+
+  void InfiniCommandMaker::makeStartLengthCommand(COMMAND_TYPE commandType, const char* params) {
+    const InfiniCommandDescriptor &desc = getCommandDescriptor(commandType);
+    // Commands without params ignore whatever was passed in.
+    insertStartLengthCommand(desc.actionType, desc.mnemonic, desc.paramSz > 0 ? params : "");
   }
   
   void InfiniCommandMaker::insertStartLengthCommand(ACTION_TYPE actionType,
@@ -1,10 +1,68 @@
 #ifndef INFINI_COMMAND_MAKER
 #define INFINI_COMMAND_MAKER
 
+#include <Print.h>
 #include "InfiniMessageTypes.h"
 
 namespace INFI {
 
+  //! Highest parallel machine index P18 can address, m is a single digit.
+  const BYTE MAX_PARALLEL_MACHINE = 9;
+
+  /*! Formats the params of a parallel addressed command (PCP, MCHGC, MUCHGC) as "m,<value>",
+   * value zero padded to the width the command takes, e.g. "0,030" for MCHGC. out gets a null terminator.
+   * Returns the number of chars written, or 0 if the command is not parallel addressed,
+   * machine or value do not fit, or out is too small.
+   */
+  BYTE makeParallelParams(COMMAND_TYPE commandType, BYTE machine, WORD value, char *out, size_t outSz);
+
+  //! POP, also outSourcePriority in PIRI and DI.
+  enum OUTPUT_SOURCE_PRIORITY {
+    OUTPUT_SOLAR_UTILITY_BATTERY = 0,
+    OUTPUT_SOLAR_BATTERY_UTILITY,
+    NUM_OUTPUT_SOURCE_PRIORITIES
+  };
+
+  //! PCP, also chargerSourcePriority in PIRI and DI.
+  enum CHARGER_SOURCE_PRIORITY {
+    CHARGER_SOLAR_FIRST = 0,
+    CHARGER_SOLAR_AND_UTILITY,
+    CHARGER_SOLAR_ONLY,
+    NUM_CHARGER_SOURCE_PRIORITIES
+  };
+
+  //! PSP, also solarPowerPriority in PIRI and DI.
+  enum SOLAR_POWER_PRIORITY {
+    SOLAR_BATTERY_LOAD_UTILITY = 0,
+    SOLAR_LOAD_BATTERY_UTILITY,
+    NUM_SOLAR_POWER_PRIORITIES
+  };
+
+  //! PBT, also battType in PIRI and DI.
+  enum BATTERY_TYPE {
+    BATTERY_AGM = 0,
+    BATTERY_FLOODED,
+    BATTERY_USER,
+    NUM_BATTERY_TYPES
+  };
+
+  /*! How many values the single digit setting of commandType takes, e.g. NUM_BATTERY_TYPES for PBT,
+   * PCP's value after the "m,". 0 for commands without one.
+   */
+  BYTE getSettingValueCount(COMMAND_TYPE commandType);
+
+  /*! Formats the param of POP, PSP or PBT, value as its one digit. out gets a null terminator.
+   * Returns the number of chars written, or 0 if the command takes no such param, value is not
+   * one getSettingValueCount() allows, or out is too small.
+   */
+  BYTE makeSettingParams(COMMAND_TYPE commandType, BYTE value, char *out, size_t outSz);
+
+  /*! The command in frame, len bytes of a complete command such as "^P005GS<CRC><cr>", the '\r' included.
+   * NUM_COMMAND_TYPES if its start, length or CRC is wrong or no row of COMMAND_DESCRIPTORS matches it.
+   * Unless params is NULL, the param chars are copied there with a null terminator, paramsSz must hold them.
+   */
+  COMMAND_TYPE parseCommandFrame(const char *frame, size_t len, char *params, size_t paramsSz);
+
   class InfiniCommandMaker {
     public:
     InfiniCommandMaker();
@@ -15,6 +73,11 @@ namespace INFI {
     //! Creates and inserts all the desired command chars.
     void makeCommand(COMMAND_TYPE commandType, const char* params);
 
+    /*! Writes the same frame makeCommand would build straight to out, folding the CRC as it goes.
+     * Nothing is staged in command, so there is no buffer to reset. Returns the number of bytes written.
+     */
+    BYTE writeCommand(COMMAND_TYPE commandType, const char* params, Print &out);
+
     private:
     //! Helper to combine insertion of start token, length and command + param chars.
     void makeStartLengthCommand(COMMAND_TYPE commandType, const char* params);
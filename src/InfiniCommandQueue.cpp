@@ -0,0 +1,441 @@
+#include "InfiniCommandQueue.h"
+
+#if INFI_MODULE_SCHEDULER
+#include <Arduino.h>
+#include "InfiniEnergyHistory.h"
+#include "InfiniResponseCache.h"
+#include "InfiniRs485Bus.h"
+
+namespace INFI {
+
+  InfiniCommandQueue::InfiniCommandQueue(InfiniCommandSender &sender) :
+    m_sender(sender),
+    m_cache(NULL),
+    m_history(NULL),
+    m_bus(NULL),
+    m_readBack(NULL),
+    m_readBackContext(NULL),
+    m_busy(false),
+    m_attempt(0),
+    m_timeoutsInRow(0),
+    m_linkDown(false),
+    m_probing(false),
+    m_probeBackoffMs(LINK_PROBE_MIN_MS),
+    m_lastProbeMs(0)
+  {
+    m_lanes[PRIORITY_HIGH].entries = m_highEntries;
+    m_lanes[PRIORITY_HIGH].capacity = COMMAND_QUEUE_HIGH_SZ;
+    m_lanes[PRIORITY_NORMAL].entries = m_normalEntries;
+    m_lanes[PRIORITY_NORMAL].capacity = COMMAND_QUEUE_SZ;
+    m_lanes[PRIORITY_BRIDGE].entries = m_bridgeEntries;
+    m_lanes[PRIORITY_BRIDGE].capacity = COMMAND_QUEUE_BRIDGE_SZ;
+    m_lanes[PRIORITY_BACKGROUND].entries = m_backgroundEntries;
+    m_lanes[PRIORITY_BACKGROUND].capacity = COMMAND_QUEUE_BACKGROUND_SZ;
+    for (BYTE p = 0; p < NUM_PRIORITIES; ++p) {
+      m_lanes[p].head = 0;
+      m_lanes[p].count = 0;
+    }
+    m_historyLane.entries = m_historyEntries;
+    m_historyLane.capacity = COMMAND_QUEUE_HISTORY_SZ;
+    m_historyLane.head = 0;
+    m_historyLane.count = 0;
+  }
+
+  bool InfiniCommandQueue::enqueue(COMMAND_TYPE commandType, const char* params, CommandCallback callback, void *context) {
+    COMMAND_PRIORITY priority = (getActionType(commandType) == UPDATE) ? PRIORITY_HIGH : PRIORITY_NORMAL;
+    return enqueueWithPriority(priority, commandType, params, callback, context);
+  }
+
+  bool InfiniCommandQueue::enqueueWithPriority(COMMAND_PRIORITY priority, COMMAND_TYPE commandType, const char* params,
+                                               CommandCallback callback, void *context) {
+    if (priority >= NUM_PRIORITIES) {
+      return false;
+    }
+    if (m_cache != NULL && getActionType(commandType) == READ) {
+      // Both only fall back to the lane when every waiter is taken.
+      if (m_cache->lookup(commandType, params, millis()) != NULL &&
+          m_cache->addWaiter(true, commandType, params, callback, context)) {
+        return true;
+      }
+      if (isPending(commandType, params) && m_cache->addWaiter(false, commandType, params, callback, context)) {
+        return true;
+      }
+    }
+    Lane *target = &m_lanes[priority];
+    unsigned long wh;
+    if (m_history != NULL && m_historyLane.count < m_historyLane.capacity &&
+        m_history->lookup(commandType, params, wh)) {
+      target = &m_historyLane;
+    } else if (isFull(priority)) {
+      return false;
+    }
+    Lane &lane = *target;
+    Entry &entry = lane.entries[(lane.head + lane.count) % lane.capacity];
+    entry.commandType = commandType;
+    entry.params[0] = '\0';
+    if (params != NULL) {
+      strncpy(entry.params, params, MAX_PARAMS_SZ - 1);
+      entry.params[MAX_PARAMS_SZ - 1] = '\0';
+    }
+    entry.callback = callback;
+    entry.context = context;
+    lane.count++;
+    return true;
+  }
+
+  void InfiniCommandQueue::loop() {
+    runCachedCallbacks();
+    runHistoryCallbacks();
+    if (m_busy && !pollInFlight()) {
+      return;
+    }
+    if (m_linkDown) {
+      failQueued();
+      startProbe();
+      return;
+    }
+    // Start the next command straight away so the link does not idle between replies.
+    startNext();
+  }
+
+  SEND_STATUS InfiniCommandQueue::sendBlocking(COMMAND_TYPE commandType, const char* params) {
+    while (m_busy && !pollInFlight()) {
+      yield();
+    }
+    if (m_history != NULL && m_history->reply(commandType, params, m_sender.response)) {
+      m_sender.response.deviceId = m_sender.deviceId();
+      return SEND_COMPLETE;
+    }
+    if (m_linkDown) {
+      return SEND_LINK_DOWN;
+    }
+    if (m_cache != NULL && getActionType(commandType) == READ) {
+      const InfiniResponse *cached = m_cache->lookup(commandType, params, millis());
+      if (cached != NULL) {
+        InfiniResponse &response = m_sender.response;
+        response.reset();
+        memcpy(response.val, cached->val, cached->actualLen);
+        response.actualLen = cached->actualLen;
+        response.cmdType = cached->cmdType;
+        response.error = cached->error;
+        response.deviceId = cached->deviceId;
+        response.sentUs = cached->sentUs;
+        return SEND_COMPLETE;
+      }
+    }
+    while (!acquireBus(true)) {
+      // The holder's reply only comes in through its own loop().
+      InfiniCommandQueue *holder = m_bus->holder();
+      if (holder != NULL && holder != this) {
+        holder->loop();
+      }
+      yield();
+    }
+    m_attempt = 0;
+    SEND_STATUS status;
+    do {
+      m_sender.sendCommand(commandType, params);
+      status = m_sender.status();
+    } while (shouldRetry(status));
+    releaseBus();
+    recordOutcome(status);
+    if (m_cache != NULL) {
+      cacheOutcome(commandType, params, m_sender.response, status);
+    }
+    if (m_history != NULL && status == SEND_COMPLETE) {
+      m_history->storeReply(commandType, params, m_sender.response);
+    }
+    scheduleReadBack(commandType, m_sender.response, status);
+    return status;
+  }
+
+  void InfiniCommandQueue::setResponseCache(InfiniResponseCache *cache) {
+    m_cache = cache;
+  }
+
+  void InfiniCommandQueue::setEnergyHistory(InfiniEnergyHistory *history) {
+    m_history = history;
+  }
+
+  void InfiniCommandQueue::setBus(InfiniRs485Bus *bus) {
+    m_bus = bus;
+  }
+
+  void InfiniCommandQueue::setReadBack(CommandCallback callback, void *context) {
+    m_readBack = callback;
+    m_readBackContext = context;
+  }
+
+  void InfiniCommandQueue::scheduleReadBack(COMMAND_TYPE updateType, const InfiniResponse &response, SEND_STATUS status) {
+    if (m_readBack == NULL || status != SEND_COMPLETE || response.error != RESP_OK) {
+      return;
+    }
+    COMMAND_TYPE query = getReadBackQuery(updateType);
+    if (query != NUM_COMMAND_TYPES) {
+      // A full lane only loses the read-back, the next poll cycle reads the setting anyway.
+      enqueueWithPriority(PRIORITY_HIGH, query, "", m_readBack, m_readBackContext);
+    }
+  }
+
+  BYTE InfiniCommandQueue::size() const {
+    BYTE total = 0;
+    for (BYTE p = 0; p < NUM_PRIORITIES; ++p) {
+      total += m_lanes[p].count;
+    }
+    return total;
+  }
+
+  bool InfiniCommandQueue::isEmpty() const {
+    return size() == 0;
+  }
+
+  bool InfiniCommandQueue::isFull(COMMAND_PRIORITY priority) const {
+    return m_lanes[priority].count >= m_lanes[priority].capacity;
+  }
+
+  bool InfiniCommandQueue::isBusy() const {
+    return m_busy;
+  }
+
+  bool InfiniCommandQueue::isLinkDown() const {
+    return m_linkDown;
+  }
+
+  const InfiniCommandSender &InfiniCommandQueue::sender() const {
+    return m_sender;
+  }
+
+  unsigned long InfiniCommandQueue::msUntilWork() const {
+    if (m_busy) {
+      return m_sender.msUntilDeadline();
+    }
+    if (m_historyLane.count > 0) {
+      return 0;
+    }
+    if (!isEmpty()) {
+      return m_bus != NULL ? m_bus->msUntilFree() : 0;
+    }
+    return m_linkDown ? msUntilElapsed(m_lastProbeMs, m_probeBackoffMs, millis()) : NO_DEADLINE;
+  }
+
+  bool InfiniCommandQueue::isPending(COMMAND_TYPE commandType, const char* params) const {
+    const char *wanted = params != NULL ? params : "";
+    if (m_busy && !m_probing && m_inFlight.commandType == commandType &&
+        strncmp(m_inFlight.params, wanted, MAX_PARAMS_SZ - 1) == 0) {
+      return true;
+    }
+    for (BYTE p = 0; p < NUM_PRIORITIES; ++p) {
+      const Lane &lane = m_lanes[p];
+      for (BYTE i = 0; i < lane.count; ++i) {
+        const Entry &entry = lane.entries[(lane.head + i) % lane.capacity];
+        if (entry.commandType == commandType && strncmp(entry.params, wanted, MAX_PARAMS_SZ - 1) == 0) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  void InfiniCommandQueue::runCachedCallbacks() {
+    if (m_cache == NULL) {
+      return;
+    }
+    InfiniResponseCache::Waiter waiter;
+    while (m_cache->popReady(waiter)) {
+      const InfiniResponse *cached = m_cache->find(waiter.commandType, waiter.params);
+      if (cached == NULL) {
+        // An UPDATE dropped the reply since, ask the inverter after all.
+        if (!enqueue(waiter.commandType, waiter.params, waiter.callback, waiter.context) && waiter.callback != NULL) {
+          m_sender.response.reset();
+          m_sender.response.cmdType = waiter.commandType;
+          m_sender.response.deviceId = m_sender.deviceId();
+          m_sender.response.error = RESP_TIMEOUT;
+          waiter.callback(m_sender.response, SEND_ERROR, waiter.context);
+        }
+      } else if (waiter.callback != NULL) {
+        waiter.callback(*cached, SEND_COMPLETE, waiter.context);
+      }
+    }
+  }
+
+  void InfiniCommandQueue::runHistoryCallbacks() {
+    // Only what was answered on entry, a callback may ask for the day before.
+    for (BYTE pending = m_historyLane.count; pending > 0 && m_historyLane.count > 0; --pending) {
+      Entry entry = m_historyLane.entries[m_historyLane.head];
+      m_historyLane.head = (m_historyLane.head + 1) % m_historyLane.capacity;
+      m_historyLane.count--;
+      // Not in sender.response, a reply in flight is read into it.
+      InfiniResponse answer;
+      if (m_history->reply(entry.commandType, entry.params, answer)) {
+        answer.deviceId = m_sender.deviceId();
+        if (entry.callback != NULL) {
+          entry.callback(answer, SEND_COMPLETE, entry.context);
+        }
+        continue;
+      }
+      // The history was cleared since, ask the inverter after all.
+      if (!enqueue(entry.commandType, entry.params, entry.callback, entry.context)) {
+        failEntry(entry);
+      }
+    }
+  }
+
+  void InfiniCommandQueue::cacheOutcome(COMMAND_TYPE commandType, const char* params,
+                                        const InfiniResponse &response, SEND_STATUS status) {
+    if (getActionType(commandType) == READ) {
+      if (status == SEND_COMPLETE) {
+        m_cache->store(response, params, millis());
+      }
+    } else if (response.error != RESP_NAK) {
+      // Unless the inverter refused it, the setting may have changed, even if the reply got lost.
+      m_cache->invalidateAfterUpdate(commandType);
+    }
+  }
+
+  void InfiniCommandQueue::startNext() {
+    if (m_busy) {
+      return;
+    }
+    for (BYTE p = 0; p < NUM_PRIORITIES; ++p) {
+      Lane &lane = m_lanes[p];
+      if (lane.count == 0) {
+        continue;
+      }
+      if (!acquireBus()) {
+        return;
+      }
+      // Pop before beginning, so callbacks can enqueue into the freed slot.
+      m_inFlight = lane.entries[lane.head];
+      lane.head = (lane.head + 1) % lane.capacity;
+      lane.count--;
+      m_busy = true;
+      m_attempt = 0;
+      m_sender.beginCommand(m_inFlight.commandType, m_inFlight.params);
+      return;
+    }
+  }
+
+  bool InfiniCommandQueue::pollInFlight() {
+    SEND_STATUS status = m_sender.poll();
+    if (status == SEND_PENDING) {
+      return false;
+    }
+    if (!m_probing && shouldRetry(status)) {
+      m_sender.beginCommand(m_inFlight.commandType, m_inFlight.params);
+      return false;
+    }
+    m_busy = false;
+    releaseBus();
+    recordOutcome(status);
+    if (m_probing) {
+      // The probe is ours, nobody is waiting on its reply.
+      m_probing = false;
+      return true;
+    }
+    if (m_cache != NULL) {
+      // Before the callback, so a query it enqueues again is answered from the cache.
+      cacheOutcome(m_inFlight.commandType, m_inFlight.params, m_sender.response, status);
+    }
+    if (m_history != NULL && status == SEND_COMPLETE) {
+      m_history->storeReply(m_inFlight.commandType, m_inFlight.params, m_sender.response);
+    }
+    scheduleReadBack(m_inFlight.commandType, m_sender.response, status);
+    if (m_inFlight.callback != NULL) {
+      m_inFlight.callback(m_sender.response, status, m_inFlight.context);
+    }
+    if (m_cache != NULL) {
+      m_cache->completeWaiters(m_inFlight.commandType, m_inFlight.params, m_sender.response, status);
+    }
+    return true;
+  }
+
+  bool InfiniCommandQueue::shouldRetry(SEND_STATUS status) {
+    if (status != SEND_ERROR || m_attempt >= COMMAND_RETRIES) {
+      return false;
+    }
+    m_attempt++;
+    return true;
+  }
+
+  bool InfiniCommandQueue::acquireBus(bool urgent) {
+    return m_bus == NULL || m_bus->acquire(m_sender.deviceId(), this, urgent);
+  }
+
+  void InfiniCommandQueue::releaseBus() {
+    if (m_bus != NULL) {
+      m_bus->release();
+    }
+  }
+
+  void InfiniCommandQueue::recordOutcome(SEND_STATUS status) {
+    if (status != SEND_TIMEOUT) {
+      // Any frame, even a rejected one, means the inverter is there.
+      m_timeoutsInRow = 0;
+      m_linkDown = false;
+      m_probeBackoffMs = LINK_PROBE_MIN_MS;
+      return;
+    }
+    m_lastProbeMs = millis();
+    if (m_linkDown) {
+      m_probeBackoffMs = (m_probeBackoffMs * 2 > LINK_PROBE_MAX_MS) ? LINK_PROBE_MAX_MS : m_probeBackoffMs * 2;
+    } else if (++m_timeoutsInRow >= LINK_DOWN_TIMEOUTS) {
+      m_linkDown = true;
+    }
+  }
+
+  void InfiniCommandQueue::failQueued() {
+    for (BYTE p = 0; p < NUM_PRIORITIES; ++p) {
+      Lane &lane = m_lanes[p];
+      // Only what was queued on entry, a callback that re-queues must not keep us here.
+      for (BYTE pending = lane.count; pending > 0 && lane.count > 0; --pending) {
+        // Pop before calling back, callbacks may enqueue again.
+        Entry entry = lane.entries[lane.head];
+        lane.head = (lane.head + 1) % lane.capacity;
+        lane.count--;
+        failEntry(entry);
+      }
+    }
+  }
+
+  void InfiniCommandQueue::failEntry(const Entry &entry) {
+    m_sender.response.reset();
+    m_sender.response.cmdType = entry.commandType;
+    m_sender.response.deviceId = m_sender.deviceId();
+    m_sender.response.error = RESP_TIMEOUT;
+    if (entry.callback != NULL) {
+      entry.callback(m_sender.response, SEND_LINK_DOWN, entry.context);
+    }
+    if (m_cache != NULL) {
+      // Whatever waited on this one fails with it.
+      m_cache->completeWaiters(entry.commandType, entry.params, m_sender.response, SEND_LINK_DOWN);
+    }
+  }
+
+  void InfiniCommandQueue::restart() {
+    const bool abandoned = m_busy && !m_probing;
+    if (m_busy) {
+      m_busy = false;
+      m_probing = false;
+      releaseBus();
+    }
+    m_linkDown = true;
+    m_timeoutsInRow = LINK_DOWN_TIMEOUTS;
+    m_probeBackoffMs = LINK_PROBE_MIN_MS;
+    m_lastProbeMs = millis() - LINK_PROBE_MIN_MS;
+    if (abandoned) {
+      failEntry(m_inFlight);
+    }
+    failQueued();
+  }
+
+  void InfiniCommandQueue::startProbe() {
+    if (m_busy || millis() - m_lastProbeMs < m_probeBackoffMs || !acquireBus()) {
+      return;
+    }
+    m_busy = true;
+    m_probing = true;
+    m_attempt = 0;
+    m_sender.beginCommand(LINK_PROBE_COMMAND, "");
+  }
+}
+#endif
@@ -0,0 +1,261 @@
+#ifndef INFINI_COMMAND_QUEUE_H
+#define INFINI_COMMAND_QUEUE_H
+
+#include "InfiniCommandSender.h"
+
+// Number of commands that can wait in the normal lane. Override with a build flag if needed.
+#ifndef INFI_COMMAND_QUEUE_SZ
+#define INFI_COMMAND_QUEUE_SZ 16
+#endif
+
+// Number of commands that can wait in the high priority lane.
+#ifndef INFI_COMMAND_QUEUE_HIGH_SZ
+#define INFI_COMMAND_QUEUE_HIGH_SZ 4
+#endif
+
+// Number of commands from a bridged client that can wait, see InfiniBridge.
+#ifndef INFI_COMMAND_QUEUE_BRIDGE_SZ
+#define INFI_COMMAND_QUEUE_BRIDGE_SZ 4
+#endif
+
+// Number of commands of background jobs that can wait, see InfiniEnergyBackfill.
+#ifndef INFI_COMMAND_QUEUE_BACKGROUND_SZ
+#define INFI_COMMAND_QUEUE_BACKGROUND_SZ 2
+#endif
+
+// Number of queries the energy history answered that wait for loop() to run their callbacks.
+#ifndef INFI_COMMAND_QUEUE_HISTORY_SZ
+#define INFI_COMMAND_QUEUE_HISTORY_SZ 4
+#endif
+
+// Times a command is re-sent after a rejected (bad CRC, start or length) reply.
+#ifndef INFI_COMMAND_RETRIES
+#define INFI_COMMAND_RETRIES 2
+#endif
+
+// Consecutive timeouts after which the link is considered down.
+#ifndef INFI_LINK_DOWN_TIMEOUTS
+#define INFI_LINK_DOWN_TIMEOUTS 3
+#endif
+
+// First and longest wait between probes while the link is down, milliseconds.
+#ifndef INFI_LINK_PROBE_MIN_MS
+#define INFI_LINK_PROBE_MIN_MS 2000
+#endif
+#ifndef INFI_LINK_PROBE_MAX_MS
+#define INFI_LINK_PROBE_MAX_MS 60000
+#endif
+
+namespace INFI {
+
+  const BYTE COMMAND_QUEUE_SZ = INFI_COMMAND_QUEUE_SZ;
+  const BYTE COMMAND_QUEUE_HIGH_SZ = INFI_COMMAND_QUEUE_HIGH_SZ;
+  const BYTE COMMAND_QUEUE_BRIDGE_SZ = INFI_COMMAND_QUEUE_BRIDGE_SZ;
+  const BYTE COMMAND_QUEUE_BACKGROUND_SZ = INFI_COMMAND_QUEUE_BACKGROUND_SZ;
+  const BYTE COMMAND_QUEUE_HISTORY_SZ = INFI_COMMAND_QUEUE_HISTORY_SZ;
+  const BYTE COMMAND_RETRIES = INFI_COMMAND_RETRIES;
+  const BYTE LINK_DOWN_TIMEOUTS = INFI_LINK_DOWN_TIMEOUTS;
+  const unsigned long LINK_PROBE_MIN_MS = INFI_LINK_PROBE_MIN_MS;
+  const unsigned long LINK_PROBE_MAX_MS = INFI_LINK_PROBE_MAX_MS;
+
+  //! The command sent to find out whether a link that is down came back. T is the cheapest query.
+  const COMMAND_TYPE LINK_PROBE_COMMAND = CURRENT_TIME;
+
+  //! Longest params string we copy into a queue entry, including the null terminator.
+  const BYTE MAX_PARAMS_SZ = 16;
+
+  /*!
+   * The lanes of the command queue, in the order they are served.
+   * A command in a lane only starts once every lane before it is empty,
+   * but it never interrupts the transaction already in flight.
+   */
+  enum COMMAND_PRIORITY {
+    PRIORITY_HIGH = 0,   // ^S UPDATE commands, e.g. from operator RPCs.
+    PRIORITY_NORMAL,     // ^P READ polls.
+    PRIORITY_BRIDGE,     // Frames of another master, e.g. the vendor's tool through InfiniBridge, in the link's spare time.
+    PRIORITY_BACKGROUND, // Background jobs, e.g. InfiniEnergyBackfill, once nobody else needs the link.
+    NUM_PRIORITIES
+  };
+
+  /*!
+   * Called once a queued command has finished, whatever the outcome.
+   * response is only valid for the duration of the call, copy out what you need.
+   * It is safe to enqueue further commands from inside the callback.
+   */
+  typedef void (*CommandCallback)(const InfiniResponse &response, SEND_STATUS status, void *context);
+
+  class InfiniResponseCache;
+  class InfiniEnergyHistory;
+  class InfiniRs485Bus;
+
+  /*!
+   * A fixed capacity queue of commands in front of an InfiniCommandSender.
+   * loop() feeds the sender one command after another, starting the next command
+   * in the same call that completes the previous one, so the link never sits idle.
+   * Commands are FIFO within a lane, and higher priority lanes are always served first.
+   *
+   * A command whose reply is rejected is re-sent up to COMMAND_RETRIES times before its callback
+   * sees SEND_ERROR. After LINK_DOWN_TIMEOUTS timeouts in a row the link is considered down:
+   * queued commands complete at once with SEND_LINK_DOWN and only a LINK_PROBE_COMMAND is sent,
+   * with the wait between probes doubling from LINK_PROBE_MIN_MS to LINK_PROBE_MAX_MS.
+   * Any frame from the inverter brings the link back up.
+   */
+  class InfiniCommandQueue {
+    public:
+    InfiniCommandQueue(InfiniCommandSender &sender);
+
+    /*! Copies the command into the queue. Returns false if its lane is full.
+     * UPDATE commands go to PRIORITY_HIGH, READ commands to PRIORITY_NORMAL.
+     * params longer than MAX_PARAMS_SZ - 1 are trimmed.
+     */
+    bool enqueue(COMMAND_TYPE commandType, const char* params, CommandCallback callback = NULL, void *context = NULL);
+
+    //! Like enqueue(), but into an explicitly chosen lane.
+    bool enqueueWithPriority(COMMAND_PRIORITY priority, COMMAND_TYPE commandType, const char* params,
+                             CommandCallback callback = NULL, void *context = NULL);
+
+    /*! Advances the in-flight transaction and starts the next one when it completes.
+     * Never blocks, call it from loop() as often as possible.
+     */
+    void loop();
+
+    /*! Waits for the in-flight transaction (its callback still runs), then sends this command
+     * ahead of every lane and blocks until its reply is in sender.response.
+     * Meant for callers that must answer synchronously, like RPC handlers.
+     * Rejected replies are retried like queued ones. Returns SEND_LINK_DOWN without sending if the link is down.
+     */
+    SEND_STATUS sendBlocking(COMMAND_TYPE commandType, const char* params);
+
+    /*! Abandons the transaction in flight and completes it and every queued command with SEND_LINK_DOWN,
+     * e.g. after the UART was restarted under it. The link counts as down, so the probe goes out next, at once.
+     * A late reply of the abandoned command is dropped by the sender as stale.
+     */
+    void restart();
+
+    /*! Puts a read-through cache in front of the link, NULL to go without, which is the default.
+     * From then on READ commands may be answered from it or wait on an identical one, see InfiniResponseCache.
+     * sendBlocking() answers a fresh READ by copying the cached reply into sender.response.
+     */
+    void setResponseCache(InfiniResponseCache *cache);
+
+    /*! Answers ED, EM and EY queries of past periods from history, NULL to go without, which is the default.
+     * Every such reply from the inverter is kept in it. A queued query it knows completes from the next loop(),
+     * also while the link is down, and sendBlocking() writes the reply into sender.response without sending.
+     */
+    void setEnergyHistory(InfiniEnergyHistory *history);
+
+    /*! Once the inverter accepted an UPDATE, queued or sent with sendBlocking(), queues its getReadBackQuery()
+     * in the high priority lane with callback, so the new setting is confirmed within a transaction or two
+     * instead of on the next poll cycle. NULL turns it off, which is the default.
+     */
+    void setReadBack(CommandCallback callback, void *context = NULL);
+
+    /*! Shares the link with the other queues on bus, NULL for a link of its own, which is the default.
+     * Every transaction, probes and sendBlocking() included, then waits until bus grants it to the
+     * sender's deviceId, and the bus is handed back as soon as its reply is in. See InfiniRs485Bus.
+     */
+    void setBus(InfiniRs485Bus *bus);
+
+    //! Number of commands waiting in all lanes, not counting the one in flight.
+    BYTE size() const;
+    bool isEmpty() const;
+    bool isFull(COMMAND_PRIORITY priority = PRIORITY_NORMAL) const;
+
+    //! True while a command is in flight on the sender.
+    bool isBusy() const;
+
+    //! True while the inverter is considered unreachable, see the class comment.
+    bool isLinkDown() const;
+
+    //! The sender it feeds, e.g. for its InfiniCommandSender::transactionMs().
+    const InfiniCommandSender &sender() const;
+
+    /*! Milliseconds until loop() has something to do, NO_DEADLINE if it waits for an enqueue().
+     * 0 while commands wait to be sent. With one in flight, the time until it times out,
+     * so the reply has to wake the caller earlier, e.g. through attachRxRing().
+     */
+    unsigned long msUntilWork() const;
+
+    private:
+    struct Entry {
+      COMMAND_TYPE commandType;
+      char params[MAX_PARAMS_SZ];
+      CommandCallback callback;
+      void *context;
+    };
+
+    //! A FIFO ring over part of the entry storage.
+    struct Lane {
+      Entry *entries;
+      BYTE capacity;
+      BYTE head;
+      BYTE count;
+    };
+
+    //! Whether an identical command is queued or in flight, so a READ can wait on its reply.
+    bool isPending(COMMAND_TYPE commandType, const char* params) const;
+
+    //! Runs the callbacks the cache answers from memory.
+    void runCachedCallbacks();
+
+    //! Runs the callbacks of the queries the energy history answers.
+    void runHistoryCallbacks();
+
+    //! Lets the cache keep the reply of a READ, or drop what an UPDATE may have changed.
+    void cacheOutcome(COMMAND_TYPE commandType, const char* params, const InfiniResponse &response, SEND_STATUS status);
+
+    //! Queues the read-back of updateType if it was accepted, see setReadBack().
+    void scheduleReadBack(COMMAND_TYPE updateType, const InfiniResponse &response, SEND_STATUS status);
+
+    //! Begins the oldest command of the highest priority non-empty lane, if any.
+    void startNext();
+
+    //! Polls the in-flight command and runs its callback if it finished. Returns true if it finished.
+    bool pollInFlight();
+
+    //! Whether a rejected reply should be retried, and counts the attempt if so.
+    bool shouldRetry(SEND_STATUS status);
+
+    //! Whether the link is ours for the next transaction, always true without a bus.
+    bool acquireBus(bool urgent = false);
+
+    //! Hands the bus back once a transaction finished.
+    void releaseBus();
+
+    //! Feeds the outcome of a transaction into the link state.
+    void recordOutcome(SEND_STATUS status);
+
+    //! While the link is down, completes every queued command with SEND_LINK_DOWN.
+    void failQueued();
+    //! Completes entry with SEND_LINK_DOWN, and whatever waits on it in the cache.
+    void failEntry(const Entry &entry);
+
+    //! While the link is down, sends the probe once the backoff has passed.
+    void startProbe();
+
+    InfiniCommandSender &m_sender;
+    InfiniResponseCache *m_cache;
+    InfiniEnergyHistory *m_history;
+    InfiniRs485Bus *m_bus;
+    CommandCallback m_readBack;
+    void *m_readBackContext;
+    Entry m_highEntries[COMMAND_QUEUE_HIGH_SZ];
+    Entry m_normalEntries[COMMAND_QUEUE_SZ];
+    Entry m_bridgeEntries[COMMAND_QUEUE_BRIDGE_SZ];
+    Entry m_backgroundEntries[COMMAND_QUEUE_BACKGROUND_SZ];
+    Lane m_lanes[NUM_PRIORITIES];
+    //! Queries the energy history answers, apart from the lanes as they never go to the link.
+    Entry m_historyEntries[COMMAND_QUEUE_HISTORY_SZ];
+    Lane m_historyLane;
+    Entry m_inFlight;
+    bool m_busy;
+    BYTE m_attempt;
+    BYTE m_timeoutsInRow;
+    bool m_linkDown;
+    bool m_probing;
+    unsigned long m_probeBackoffMs;
+    unsigned long m_lastProbeMs;
+  };
+}
+
+#endif
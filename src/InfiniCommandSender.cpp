@@ -1,59 +1,506 @@
 #include "InfiniCommandSender.h"
+#include <Arduino.h>
+#include <string.h>
+#if INFI_LOG_LEVEL > INFI_LOG_NONE
+#include "InfiniJsonWriter.h"
+#endif
+#include "InfiniTrace.h"
 
 namespace INFI {
+
+  //! Writes the command to the link and a copy of each byte to the capture.
+  class CaptureTee : public Print {
+    public:
+    CaptureTee(Print &out, InfiniLinkCapture &capture) : m_out(out), m_capture(capture) {}
+
+    size_t write(uint8_t b) override {
+      m_capture.write(b);
+      return m_out.write(b);
+    }
+
+    size_t write(const uint8_t *buffer, size_t size) override {
+      for (size_t i = 0; i < size; ++i) {
+        m_capture.write(buffer[i]);
+      }
+      return m_out.write(buffer, size);
+    }
+
+    private:
+    Print &m_out;
+    InfiniLinkCapture &m_capture;
+  };
   
+  //! Size of what is read of a reply to commandType before its size is known: an ack whole, a query's header.
+  static size_t getKnownFrameSize(COMMAND_TYPE commandType) {
+    return getActionType(commandType) == UPDATE ? getResponseSize(commandType) : START_OFFSET_SZ;
+  }
+
+  //! Whether the whole frame val of len bytes has the start token and size of a reply to commandType.
+  static bool fitsCommand(const char *val, size_t len, COMMAND_TYPE commandType) {
+    if (len != getResponseSize(commandType) || val[0] != '^') {
+      return false;
+    }
+    if (getActionType(commandType) == UPDATE) {
+      return val[1] == '1' || val[1] == '0';
+    }
+    size_t toEnd = 0;
+    for (BYTE i = 0; i < DATA_LENGTH_SZ; ++i) {
+      const char digit = val[START_TOKEN_SZ + i];
+      if (digit < '0' || digit > '9') {
+        return false;
+      }
+      toEnd = toEnd * 10 + (size_t)(digit - '0');
+    }
+    return val[1] == 'D' && toEnd == getCommandDescriptor(commandType).respToEndSz;
+  }
+
   InfiniCommandSender::InfiniCommandSender(Stream &cmdStream, Stream *dbgStream) :
     m_cmdStream(cmdStream),
-    m_dbgStream(dbgStream)
+    m_dbgStream(dbgStream),
+    m_status(SEND_IDLE),
+    m_startUs(0),
+    m_timeoutMs(PER_COMMAND_TIMEOUT),
+    m_turnaroundMs(TURNAROUND_MS),
+    m_deadlineMs(0),
+    m_rxRing(NULL),
+    m_stats(NULL),
+    m_capture(NULL),
+    m_calibration(NULL),
+    m_baud(SERIAL_BAUD),
+    m_deviceId(0),
+    m_frameSz(0),
+    m_resync(false),
+    m_stale(false)
   {}
 
   void InfiniCommandSender::sendCommand(COMMAND_TYPE commandType, const char* params) {
-    // Reset the response buffer. Is this of any use?
+    beginCommand(commandType, params);
+    while (poll() == SEND_PENDING) {
+      // Let the core run its background tasks while we wait on the 2400 baud link.
+      yield();
+    }
+  }
+
+  void InfiniCommandSender::beginCommand(COMMAND_TYPE commandType, const char* params) {
+    // Reset the response buffer so a previous reply can never leak into this one.
     response.reset();
+    response.error = RESP_OK;
+    m_rxCrc.reset();
 
     // Set the cmdType to commandType
     response.cmdType = commandType;
+    response.deviceId = m_deviceId;
 
-    // Make the command
-    m_cmdMaker.makeCommand(commandType, params);
+#if INFI_LOG_LEVEL >= INFI_LOG_DEBUG
+    // Only build the command in a buffer when debugging, so it can be printed.
     if (m_dbgStream != NULL) {
+      m_cmdMaker.makeCommand(commandType, params);
       printCommandAsHex();
     }
+#endif
     
-    // Send message to inverter!
-    m_cmdStream.flush(); // What does this do? Why have I added it?
-    m_cmdStream.write(m_cmdMaker.command.val, m_cmdMaker.command.actualLen);
-
-    // Read the reply into response.
-    // readBytesUntil is a blocking call, so that's probably bad for when we want to process
-    // other things while we're collecting chars on Serial2 (which at 2400 baud is real slow).
-    // See eg 3 here: https://forum.arduino.cc/index.php?topic=396450.0
-    // It expects a start and end byte. We always know the start is '^' and the end is '\r'.
-    response.actualLen = m_cmdStream.readBytesUntil('\r', response.val, response.bufferSize);
-    
-    // Add back the carriage return to last position.
-    if (response.actualLen > 0) {
-      if (response.actualLen < response.bufferSize) {
-        response.val[response.actualLen] = '\r';
-        response.actualLen++;
-      } else if (m_dbgStream != NULL) {
-        m_dbgStream->print("[InfiniCommandSender] response buffer too small, carriage return not appended.");
+    // Send message to inverter! Parameterless commands are precomputed,
+    // the rest are written out as they are made, without a staging buffer.
+    // No flush() before or after: the frame fits the UART's TX buffer, so the writes return at once
+    // and the bytes go out behind our back. Their wire time is already part of the deadline.
+    // A late reply to an earlier command must not be taken for this one's.
+    if (m_rxRing != NULL) {
+      m_rxRing->discard();
+    } else {
+      // So is whatever came in on the stream since the last transaction ended.
+      while (m_cmdStream.available() > 0 && m_cmdStream.read() >= 0) {
       }
     }
-    
+    response.sentUs = micros();
+    INFI_TRACE_BEGIN(TRACE_TX, commandType);
+    if (m_capture != NULL && m_capture->begin(CAPTURE_TX, m_deviceId, response.sentUs, MAX_CMD_SZ)) {
+      CaptureTee tee(m_cmdStream, *m_capture);
+      if (writeFixedFrame(commandType, tee) == 0) {
+        m_cmdMaker.writeCommand(commandType, params, tee);
+      }
+      m_capture->commit();
+    } else if (writeFixedFrame(commandType, m_cmdStream) == 0) {
+      m_cmdMaker.writeCommand(commandType, params, m_cmdStream);
+    }
+    INFI_TRACE_END(TRACE_TX, commandType);
+    INFI_TRACE_BEGIN(TRACE_WAIT, commandType);
+
+    // The reply is collected by poll(). A command's ack has a fixed size, a query's is announced by its
+    // ^Dxxx header, the header alone is asked for first.
+    m_frameSz = getKnownFrameSize(commandType);
+    m_deadlineMs = transactionMs(commandType);
+    m_startUs = micros();
+    m_status = SEND_PENDING;
+    // Wakes a loop sleeping in idleFor() right at the deadline, so the timeout is not left to a poll.
+    m_deadlineTimer.once(m_deadlineMs * 1000UL);
+#if INFI_MODULE_STATS
+    if (m_stats != NULL) {
+      m_stats->recordSent(commandType);
+    }
+#endif
+  }
+
+  SEND_STATUS InfiniCommandSender::poll() {
+    if (m_status != SEND_PENDING) {
+      return m_status;
+    }
+    if (m_rxRing != NULL) {
+      return pollRxRing();
+    }
+
+    if (drainStream()) {
+      return m_status;
+    }
+
+    if (micros() - m_startUs >= m_deadlineMs * 1000UL) {
+      return finish(SEND_TIMEOUT, RESP_TIMEOUT);
+    }
+    return SEND_PENDING;
+  }
+
+  //! drain() source over a Stream.
+  struct StreamSource {
+    Stream &stream;
+
+    int available() {
+      return stream.available();
+    }
+
+    size_t readBlock(char *buffer, size_t length) {
+#if defined(ARDUINO_ARCH_ESP32)
+      // Never waits for the timeout, the bytes are already there.
+      return stream.readBytes(buffer, length);
+#else
+      // AVR's readBytes() would check millis() for every byte.
+      size_t count = 0;
+      while (count < length) {
+        int c = stream.read();
+        if (c < 0) {
+          break;
+        }
+        buffer[count++] = (char)c;
+      }
+      return count;
+#endif
+    }
+  };
+
+  bool InfiniCommandSender::drainStream() {
+    StreamSource source = {m_cmdStream};
+    return drain(source);
+  }
+
+  void InfiniCommandSender::overflow() {
+#if INFI_LOG_LEVEL >= INFI_LOG_ERROR
     if (m_dbgStream != NULL) {
-      m_dbgStream->print("[InfiniCommandSender] ");
-      m_dbgStream->println(response.val); 
-      m_dbgStream->print("[InfiniCommandSender] Response had size "); m_dbgStream->println(response.actualLen);
+      m_dbgStream->print(INFI_F("[InfiniCommandSender] response buffer too small, carriage return not received.\r\n"));
+    }
+#endif
+    finish(SEND_ERROR, RESP_BAD_LENGTH);
+  }
+
+  bool InfiniCommandSender::takeBlock(size_t length) {
+    const size_t start = response.actualLen;
+    char *block = response.val + start;
+    if (m_resync) {
+      // What is left of a frame rejected early is not this reply, which starts at the next '^'. Only the
+      // escaped CRC could hold one, and the inverter may drop the rest of a reply once the next command is in,
+      // so its '\r' can't be waited for.
+      const char *begin = (const char *)memchr(block, '^', length);
+      if (begin == NULL) {
+        return false;
+      }
+      m_resync = false;
+      length -= (size_t)(begin - block);
+      memmove(block, begin, length);
+    }
+    if (start == 0) {
+      INFI_TRACE_END(TRACE_WAIT, response.cmdType);
+      INFI_TRACE_BEGIN(TRACE_RX, response.cmdType);
+    }
+    response.actualLen = start + length;
+    const bool isUpdate = getActionType(response.cmdType) == UPDATE;
+    if (start < START_TOKEN_SZ && response.actualLen >= START_TOKEN_SZ) {
+      // Queries are answered with ^D, commands with ^1 or ^0.
+      const char type = response.val[1];
+      if (response.val[0] != '^' || (isUpdate ? (type != '1' && type != '0') : type != 'D')) {
+        return m_stale ? skipStale() : reject(RESP_BAD_START, memchr(block, '\r', length) != NULL);
+      }
+    }
+    if (!isUpdate && start < START_OFFSET_SZ && response.actualLen >= START_OFFSET_SZ) {
+      // The header announces the rest of the frame, which must be what the table says.
+      const char *digits = response.val + START_TOKEN_SZ;
+      size_t toEnd = 0;
+      for (BYTE i = 0; i < DATA_LENGTH_SZ; ++i) {
+        if (digits[i] < '0' || digits[i] > '9') {
+          return m_stale ? skipStale() : reject(RESP_BAD_LENGTH, memchr(block, '\r', length) != NULL);
+        }
+        toEnd = toEnd * 10 + (size_t)(digits[i] - '0');
+      }
+      if (toEnd != getCommandDescriptor(response.cmdType).respToEndSz) {
+        return m_stale ? skipStale() : reject(RESP_BAD_LENGTH, memchr(block, '\r', length) != NULL);
+      }
+      m_frameSz = START_OFFSET_SZ + toEnd;
+    }
+    // Until its announced end, no '\r' belongs in the frame: the data is ASCII and the escape step keeps it
+    // out of the CRC. One earlier means bytes went missing.
+    const char *end = (const char *)memchr(block, '\r', length);
+    if (end != NULL && (size_t)(end - response.val) + END_TOKEN_SZ != m_frameSz) {
+      response.actualLen = (size_t)(end - response.val) + END_TOKEN_SZ;
+      return reject(RESP_BAD_LENGTH, true);
+    }
+    // Everything in front of the two CRC bytes is covered. Before the header is whole, that is all of it.
+    const size_t covered = (isUpdate || response.actualLen >= START_OFFSET_SZ) ? m_frameSz - CRC_SZ - END_TOKEN_SZ
+      : response.actualLen;
+    const size_t from = start < covered ? start : covered;
+    const size_t to = response.actualLen < covered ? response.actualLen : covered;
+    if (to > from) {
+      m_rxCrc.update((const BYTE *)response.val + from, (BYTE)(to - from));
+    }
+    if (response.actualLen < m_frameSz) {
+      return false;
+    }
+    if (end == NULL) {
+      // Longer than announced, its '\r' is still to come.
+      return reject(RESP_BAD_LENGTH, false);
+    }
+    RESPONSE_ERROR error = verifyFrame();
+    finish((error == RESP_OK || error == RESP_NAK) ? SEND_COMPLETE : SEND_ERROR, error);
+    return true;
+  }
+
+  bool InfiniCommandSender::skipStale() {
+    // After a timeout, a frame that is no reply to this command is taken for the late reply to the last one.
+    // The next '^' starts over, it may already be among the bytes read.
+    const size_t length = response.actualLen - 1;
+    memmove(response.val, response.val + 1, length);
+    response.actualLen = 0;
+    m_frameSz = getKnownFrameSize(response.cmdType);
+    m_rxCrc.reset();
+    m_resync = true;
+    return length > 0 && takeBlock(length);
+  }
+
+  bool InfiniCommandSender::reject(RESPONSE_ERROR error, bool ended) {
+    // Unless the frame's '\r' was read, the rest of it is still to come and skipped ahead of the next reply.
+    m_resync = !ended;
+    finish(SEND_ERROR, error);
+    return true;
+  }
+
+  SEND_STATUS InfiniCommandSender::pollRxRing() {
+    while (m_rxRing->framesReady() > 0) {
+      // Keep the last byte for the terminator, the debug output prints val as a string.
+      size_t len = m_rxRing->popFrame(response.val, response.bufferSize - 1);
+      if (m_stale && len > 0 && !fitsCommand(response.val, len, response.cmdType)) {
+        // The late reply to the command that timed out, or what is left of it.
+        continue;
+      }
+      // The ring only tells once the frame is whole, so its RX is the pop.
+      INFI_TRACE_END(TRACE_WAIT, response.cmdType);
+      INFI_TRACE_BEGIN(TRACE_RX, response.cmdType);
+      response.actualLen = len;
+      if (len == 0 || response.val[len - 1] != '\r') {
+#if INFI_LOG_LEVEL >= INFI_LOG_ERROR
+        if (m_dbgStream != NULL) {
+          m_dbgStream->print(INFI_F("[InfiniCommandSender] response buffer too small, carriage return not received.\r\n"));
+        }
+#endif
+        return finish(SEND_ERROR, RESP_BAD_LENGTH);
+      }
+      // The whole frame is here, so the CRC covers everything up to the last two bytes before '\r'.
+      if (len > CRC_SZ + END_TOKEN_SZ) {
+        m_rxCrc.update((const BYTE *)response.val, (BYTE)(len - CRC_SZ - END_TOKEN_SZ));
+      }
+      RESPONSE_ERROR error = verifyFrame();
+      return finish((error == RESP_OK || error == RESP_NAK) ? SEND_COMPLETE : SEND_ERROR, error);
+    }
+
+    if (micros() - m_startUs >= m_deadlineMs * 1000UL) {
+      return finish(SEND_TIMEOUT, RESP_TIMEOUT);
+    }
+    return SEND_PENDING;
+  }
+
+  bool InfiniCommandSender::isDone() const {
+    return m_status != SEND_PENDING;
+  }
+
+  SEND_STATUS InfiniCommandSender::status() const {
+    return m_status;
+  }
+
+  void InfiniCommandSender::setTimeout(unsigned long timeoutMs) {
+    m_timeoutMs = timeoutMs;
+  }
+
+  void InfiniCommandSender::setTurnaround(unsigned long turnaroundMs) {
+    m_turnaroundMs = turnaroundMs;
+  }
+
+  unsigned long InfiniCommandSender::deadlineMs() const {
+    return m_deadlineMs;
+  }
+
+  unsigned long InfiniCommandSender::msUntilDeadline() const {
+    if (m_status != SEND_PENDING) {
+      return NO_DEADLINE;
+    }
+    return msUntilElapsedUs(m_startUs, m_deadlineMs, micros());
+  }
+
+  void InfiniCommandSender::setCalibration(InfiniLinkCalibration *calibration) {
+    m_calibration = calibration;
+  }
+
+  void InfiniCommandSender::setBaud(unsigned long baud) {
+    m_baud = baud;
+  }
+
+  unsigned long InfiniCommandSender::transactionMs(COMMAND_TYPE commandType) const {
+    if (m_timeoutMs != PER_COMMAND_TIMEOUT) {
+      return m_timeoutMs;
+    }
+    unsigned long turnaroundMs = m_calibration != NULL ? m_calibration->deadlineTurnaroundMs(commandType) : m_turnaroundMs;
+    return getResponseTimeoutMs(commandType, turnaroundMs, m_baud);
+  }
+
+  unsigned long InfiniCommandSender::expectedTransactionMs(COMMAND_TYPE commandType) const {
+    unsigned long turnaroundMs = m_calibration != NULL ? m_calibration->turnaroundMs(commandType) : m_turnaroundMs;
+    return getResponseTimeoutMs(commandType, turnaroundMs, m_baud);
+  }
+
+  unsigned long InfiniCommandSender::baud() const {
+    return m_baud;
+  }
+
+  unsigned long InfiniCommandSender::probeBaud(const unsigned long *candidates, BYTE count, BaudSetter setBaud, void *context) {
+    for (BYTE i = 0; i < count; ++i) {
+      if (!setBaud(candidates[i], context)) {
+        continue;
+      }
+      m_baud = candidates[i];
+      sendCommand(CURRENT_TIME, NULL);
+      if (m_status == SEND_COMPLETE && response.error == RESP_OK) {
+        return m_baud;
+      }
+    }
+    setBaud(SERIAL_BAUD, context);
+    m_baud = SERIAL_BAUD;
+    return 0;
+  }
+
+  void InfiniCommandSender::setDeviceId(BYTE deviceId) {
+    m_deviceId = deviceId;
+  }
+
+  BYTE InfiniCommandSender::deviceId() const {
+    return m_deviceId;
+  }
+
+  void InfiniCommandSender::useRxRing(InfiniRxRing *ring) {
+    m_rxRing = ring;
+  }
+
+#if INFI_MODULE_STATS
+  void InfiniCommandSender::setStats(InfiniLinkStats *stats) {
+    m_stats = stats;
+  }
+#endif
+
+  void InfiniCommandSender::setCapture(InfiniLinkCapture *capture) {
+    m_capture = capture;
+  }
+
+  RESPONSE_ERROR InfiniCommandSender::verifyFrame() const {
+    INFI_TRACE_SCOPE(TRACE_CRC, response.cmdType);
+    const size_t len = response.actualLen;
+    if (len < START_TOKEN_SZ + CRC_SZ + END_TOKEN_SZ) {
+      return RESP_BAD_LENGTH;
+    }
+    const char *val = response.val;
+    // Queries are answered with ^D, commands with ^1 or ^0.
+    const bool isUpdate = getActionType(response.cmdType) == UPDATE;
+    if (val[0] != '^' || (isUpdate ? (val[1] != '1' && val[1] != '0') : val[1] != 'D')) {
+      return RESP_BAD_START;
+    }
+    WORD received = ((WORD)(BYTE)val[len - 3] << 8) | (BYTE)val[len - 2];
+    if (received != m_rxCrc.finalize()) {
+      return RESP_BAD_CRC;
+    }
+    return (isUpdate && val[1] == '0') ? RESP_NAK : RESP_OK;
+  }
+
+  SEND_STATUS InfiniCommandSender::finish(SEND_STATUS status, RESPONSE_ERROR error) {
+    m_status = status;
+    // Its reply may still come, and is told apart from the next command's.
+    m_stale = status == SEND_TIMEOUT;
+    response.error = error;
+    m_deadlineTimer.cancel();
+    // RX began with the first byte, without one the reply was still awaited.
+    INFI_TRACE_END(response.actualLen > 0 ? TRACE_RX : TRACE_WAIT, response.cmdType);
+    const unsigned long latencyMs = (micros() - m_startUs) / 1000UL;
+    if (m_capture != NULL && (response.actualLen > 0 || status == SEND_TIMEOUT)) {
+      // A frame that checked out or was rejected on its contents still came whole, up to its '\r'.
+      bool whole = response.actualLen > 0 && response.val[response.actualLen - 1] == '\r';
+      m_capture->record(whole ? CAPTURE_RX : CAPTURE_RX_PARTIAL, m_deviceId, micros(), (const BYTE *)response.val,
+                        response.actualLen);
+    }
+#if INFI_MODULE_STATS
+    if (m_stats != NULL) {
+      if (status == SEND_TIMEOUT) {
+        m_stats->recordTimeout(response.cmdType);
+      } else {
+        m_stats->recordReply(response.cmdType, error, latencyMs);
+      }
+    }
+#endif
+    if (m_calibration != NULL) {
+      if (status == SEND_TIMEOUT) {
+        m_calibration->recordTimeout(response.cmdType);
+      } else if (error == RESP_OK || error == RESP_NAK) {
+        // Whatever the frames did not spend on the wire was the inverter's.
+        unsigned long wireMs = getWireTimeMs((unsigned long)getFrameSize(response.cmdType) + response.actualLen, m_baud);
+        m_calibration->recordTurnaround(response.cmdType, latencyMs > wireMs ? latencyMs - wireMs : 0);
+      }
+    }
+#if INFI_LOG_LEVEL > INFI_LOG_NONE
+    if (m_dbgStream != NULL && (INFI_LOG_LEVEL >= INFI_LOG_DEBUG || error != RESP_OK)) {
+      char line[INFI_LOG_LINE_SZ];
+      InfiniBufferPrint out(line, sizeof(line));
+      out.print(INFI_F("[InfiniCommandSender] "));
+      // The reply ends in its own '\r', printed as the line break.
+      for (size_t i = 0; i < response.actualLen && response.val[i] != '\r'; ++i) {
+        out.print(response.val[i]);
+      }
+      out.print(" (");
+      out.print((unsigned long)response.actualLen);
+      out.print(INFI_F(" bytes)"));
+      if (error != RESP_OK) {
+        out.print(INFI_F(" rejected: "));
+        out.print(getResponseErrorString(error));
+      }
+      out.print("\r\n");
+      m_dbgStream->write((const uint8_t *)line, out.length());
     }
+#endif
+    return m_status;
   }
   
   void InfiniCommandSender::printCommandAsHex() {
-    m_dbgStream->print("[InfiniCommandSender] ");
+#if INFI_LOG_LEVEL >= INFI_LOG_DEBUG
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    char line[INFI_LOG_LINE_SZ];
+    InfiniBufferPrint out(line, sizeof(line));
+    out.print(INFI_F("[InfiniCommandSender] "));
     for (BYTE i = 0; i < m_cmdMaker.command.actualLen; ++i) {
-      m_dbgStream->print(m_cmdMaker.command.val[i], HEX);
-      m_dbgStream->print(" ");
+      BYTE b = m_cmdMaker.command.val[i];
+      out.print(HEX_DIGITS[b >> 4]);
+      out.print(HEX_DIGITS[b & 0x0F]);
+      out.print(' ');
     }
-    m_dbgStream->println();
+    out.print("\r\n");
+    m_dbgStream->write((const uint8_t *)line, out.length());
+#endif
   }
 }
@@ -2,10 +2,47 @@
 #define INFINI_COMMAND_SENDER
 
 #include <Stream.h>
+#if defined(ARDUINO_ARCH_ESP32)
+#include <HardwareSerial.h>
+#endif
 
 #include "InfiniCommandMaker.h"
+#include "InfiniCRC.h"
+#include "InfiniFixedFrames.h"
+#include "InfiniIdle.h"
+#include "InfiniLinkCalibration.h"
+#include "InfiniLinkCapture.h"
+#include "InfiniLinkStats.h"
+#include "InfiniRxRing.h"
+#include "InfiniTrace.h"
 
 namespace INFI {
+
+  /*!
+   * The state of the transaction currently owned by an InfiniCommandSender.
+   * PENDING means the command was written and we are still collecting the reply,
+   * the other non-idle values are terminal until the next beginCommand().
+   * COMPLETE means a well formed frame arrived, check response.error for RESP_NAK.
+   * ERROR means a frame arrived but was rejected, response.error says why.
+   * LINK_DOWN is never returned by the sender, InfiniCommandQueue uses it for commands it
+   * did not send because the inverter stopped answering.
+   */
+  enum SEND_STATUS {
+    SEND_IDLE = 0,
+    SEND_PENDING,
+    SEND_COMPLETE,
+    SEND_TIMEOUT,
+    SEND_ERROR,
+    SEND_LINK_DOWN
+  };
+
+  /*! Passed to setTimeout() to derive the timeout of each command from its frame and reply sizes.
+   * This is the default, see getResponseTimeoutMs().
+   */
+  const unsigned long PER_COMMAND_TIMEOUT = 0;
+
+  //! Switches the UART behind the command stream to baud, e.g. with HardwareSerial::updateBaudRate().
+  typedef bool (*BaudSetter)(unsigned long baud, void *context);
   
   class InfiniCommandSender {
     public:
@@ -15,20 +52,267 @@ namespace INFI {
     
     /*! Constructs the command sender.
      * Note cmdStream is a ref while dbgStream is a pointer. It's a bit awkward.
+     * Nothing is written to dbgStream unless INFI_LOG_LEVEL is raised at compile time.
      */
     InfiniCommandSender(Stream &cmdStream, Stream *dbgStream = NULL);
+    virtual ~InfiniCommandSender() = default;
 
-    /*! Makes and sends all the desired command chars over the command stream set in the ctor.
+    /*! Makes and sends all the desired command chars over the command stream set in the ctor,
+     * then blocks until the reply is complete or the timeout passes.
+     * This is a thin wrapper over beginCommand() + poll().
      */
     void sendCommand(COMMAND_TYPE commandType, const char* params);
+
+    /*! Makes and writes the command, then returns immediately.
+     * The frame is left in the UART's TX buffer, nothing waits for it to drain. The deadline counts the
+     * frame's wire time at baud(), so the reply is still given the full turnaround once it went out.
+     * The reply is collected into response by subsequent calls to poll(). Bytes received since the last
+     * transaction ended are dropped first, they can't be this command's reply.
+     */
+    void beginCommand(COMMAND_TYPE commandType, const char* params);
+
+    /*! Drains the bytes of the reply available on the command stream into response.
+     * Never blocks. Returns SEND_PENDING until the reply's '\r' arrives (SEND_COMPLETE),
+     * the frame is rejected (SEND_ERROR) or the timeout passes (SEND_TIMEOUT).
+     * The CRC is folded in as bytes arrive, so the frame is verified the moment '\r' is read.
+     * A bad start token or a ^Dxxx header that does not match the command's reply size ends in SEND_ERROR
+     * as soon as it is read, as does a '\r' short of the announced size or a frame running past it.
+     * What is left of such a frame is skipped before the next reply.
+     * After a timeout, the late reply may come in after the next command went out. Until the next
+     * transaction ends, a frame that does not fit its command is skipped as that reply instead of failing it.
+     */
+    SEND_STATUS poll();
+
+    //! True once the current transaction reached a terminal state (or none was started).
+    bool isDone() const;
+
+    //! The state of the current transaction.
+    SEND_STATUS status() const;
+
+    /*! Sets how long poll() waits for a complete reply, counted from beginCommand(), for every command.
+     * PER_COMMAND_TIMEOUT goes back to a deadline computed for each command.
+     */
+    void setTimeout(unsigned long timeoutMs);
+
+    //! Sets the inverter turnaround added to the computed per command deadlines.
+    //! Ignored while a calibration is set, which learns it per command instead.
+    void setTurnaround(unsigned long turnaroundMs);
+
+    /*! Learns the inverter's turnaround per command from every reply into calibration, and derives
+     * the computed deadlines from it. NULL goes back to the fixed setTurnaround().
+     */
+    void setCalibration(InfiniLinkCalibration *calibration);
+
+    //! The baud rate the command stream runs at, for the computed deadlines. SERIAL_BAUD by default.
+    void setBaud(unsigned long baud);
+    unsigned long baud() const;
+
+    /*! Tries the count candidates in order, highest first, for one the inverter answers at.
+     * For each, setBaud switches the UART and a T query is sent, blocking like sendCommand().
+     * The first one answered with a valid frame is kept and returned. If none is, the UART is put back
+     * to SERIAL_BAUD and 0 returned. P18 has no command to change the inverter's rate, so this only
+     * finds a model whose port was set up faster, e.g. from its front panel.
+     */
+    unsigned long probeBaud(const unsigned long *candidates, BYTE count, BaudSetter setBaud, void *context = NULL);
+
+    //! The deadline of the current transaction, milliseconds after beginCommand().
+    unsigned long deadlineMs() const;
+
+    /*! The deadline a transaction of commandType would get: the wire time of its frame and reply at baud() plus
+     * the turnaround allowed for, or the fixed setTimeout(). So it is also the longest it can hold the link.
+     */
+    unsigned long transactionMs(COMMAND_TYPE commandType) const;
+
+    /*! How long a transaction of commandType usually holds the link: the wire time of its frame and reply at baud()
+     * plus the smoothed turnaround learnt, without the margin of transactionMs(). For link budgets.
+     */
+    unsigned long expectedTransactionMs(COMMAND_TYPE commandType) const;
+
+    /*! Milliseconds left until the current transaction times out, rounded up, NO_DEADLINE if none is pending.
+     * On ESP32 the deadline also ends idleFor() when it passes, through an InfiniWakeTimer.
+     */
+    unsigned long msUntilDeadline() const;
+
+    /*! Tags the replies of this sender with deviceId, e.g. the inverter's parallel id,
+     * so callbacks shared by several inverters can tell them apart.
+     */
+    void setDeviceId(BYTE deviceId);
+    BYTE deviceId() const;
+
+    /*! Takes replies from ring instead of reading the command stream, NULL goes back to reading it.
+     * The ring is filled from the UART ISR or event task, so poll() only ever sees complete frames.
+     */
+    void useRxRing(InfiniRxRing *ring);
+
+#if INFI_MODULE_STATS
+    //! Counts every transaction into stats, NULL stops counting. Several senders may share one.
+    void setStats(InfiniLinkStats *stats);
+#endif
+
+    /*! Adds every command and reply frame to capture, with its micros(), NULL stops capturing.
+     * Commands are then written through the capture as they are made, one byte at a time.
+     */
+    void setCapture(InfiniLinkCapture *capture);
   
+    protected:
+    /*! Takes the reply bytes available on the command stream, returns true once they ended the transaction.
+     * Reads through Stream, on ESP32 with one readBytes() per block, which HardwareSerial takes from the UART
+     * driver in one go. InfiniCommandSenderT reads through its transport's own methods instead.
+     */
+    virtual bool drainStream();
+
+    /*! drainStream() from source, anything with available() and a readBlock(buffer, length) that takes
+     * up to length bytes that are already there. Each block goes straight into response. The reads are sized
+     * by the frame: a query's 5 byte ^Dxxx header is checked against COMMAND_DESCRIPTORS before exactly the
+     * rest it announces is read, so a bad frame is rejected at its header instead of at its '\r' or timeout.
+     * Only take what is already there, so we never wait on the 2400 baud link.
+     */
+    template <typename SourceT>
+    bool drain(SourceT &source) {
+      int available;
+      while ((available = source.available()) > 0) {
+        const size_t room = response.bufferSize - response.actualLen;
+        if (room == 0) {
+          overflow();
+          return true;
+        }
+        // Never past the end of the frame as far as it is known, the header first, then the rest it announces.
+        const size_t wanted = m_frameSz - response.actualLen < room ? m_frameSz - response.actualLen : room;
+        char *block = response.val + response.actualLen;
+        size_t length = source.readBlock(block, (size_t)available < wanted ? (size_t)available : wanted);
+        if (length == 0) {
+          break;
+        }
+        if (takeBlock(length)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
     private:
+    //! Ends the transaction in SEND_ERROR, the reply did not fit the response buffer.
+    void overflow();
+
+    //! Takes the length bytes just read behind response.actualLen, returns true once they ended the transaction.
+    bool takeBlock(size_t length);
+
+    /*! Ends the transaction in SEND_ERROR with error, returns true. Unless ended, the frame's '\r' is still
+     * to come, and the next transaction skips what is left of it.
+     */
+    bool reject(RESPONSE_ERROR error, bool ended);
+
+    //! Drops the frame being read as the late reply to a command that timed out, returns takeBlock() of the rest.
+    bool skipStale();
+
+    //! poll() when replies arrive through m_rxRing.
+    SEND_STATUS pollRxRing();
+
     //! Print command's contents to stream as HEX. Assumes stream != NULL.
     void printCommandAsHex();
+
+    //! Moves to the terminal status and prints the response if debugging.
+    SEND_STATUS finish(SEND_STATUS status, RESPONSE_ERROR error);
+
+    //! Checks the start token and CRC of the complete frame in response.
+    RESPONSE_ERROR verifyFrame() const;
     
     InfiniCommandMaker m_cmdMaker;
     Stream &m_cmdStream;
     Stream *m_dbgStream;
+    SEND_STATUS m_status;
+    //! micros() when the command went out, the deadline is kept to the microsecond.
+    unsigned long m_startUs;
+    unsigned long m_timeoutMs;
+    unsigned long m_turnaroundMs;
+    //! m_timeoutMs, or the computed deadline of the current command.
+    unsigned long m_deadlineMs;
+    //! Wakes idleFor() when the pending transaction times out.
+    InfiniWakeTimer m_deadlineTimer;
+    InfiniRxRing *m_rxRing;
+    InfiniLinkStats *m_stats;
+    InfiniLinkCapture *m_capture;
+    InfiniLinkCalibration *m_calibration;
+    unsigned long m_baud;
+    BYTE m_deviceId;
+    //! Size of the reply frame as far as it is known, the header until a query's header is in.
+    size_t m_frameSz;
+    //! Whether the rest of a rejected frame is skipped, up to the next '^', before taking the next reply.
+    bool m_resync;
+    //! Whether the last transaction timed out, so a frame that does not fit this one may be its late reply.
+    bool m_stale;
+
+    //! CRC of the received bytes, folded two bytes behind the newest so the CRC bytes stay out of it.
+    InfiniCrcAccumulator m_rxCrc;
+  };
+
+  /*!
+   * How InfiniCommandSenderT<TransportT> takes a block of length bytes TransportT said were available,
+   * by default with a read() per byte. Specialize it for a transport with a faster way.
+   */
+  template <typename TransportT>
+  struct InfiniBlockReader {
+    static size_t read(TransportT &transport, char *buffer, size_t length) {
+      size_t count = 0;
+      while (count < length) {
+        int c = transport.TransportT::read();
+        if (c < 0) {
+          break;
+        }
+        buffer[count++] = (char)c;
+      }
+      return count;
+    }
+  };
+
+#if defined(ARDUINO_ARCH_ESP32)
+  //! The whole block in one uart_read_bytes(), instead of a driver call per byte.
+  template <>
+  struct InfiniBlockReader<HardwareSerial> {
+    static size_t read(HardwareSerial &transport, char *buffer, size_t length) {
+      return transport.HardwareSerial::read((uint8_t *)buffer, length);
+    }
+  };
+#endif
+
+  /*!
+   * An InfiniCommandSender whose replies are read straight from a TransportT known at compile time, e.g.
+   * HardwareSerial or InfiniSimulatedInverter. Its available() and read() are called by name, not through
+   * Stream's vtable, so a transport that defines them inline is inlined into the RX loop, and any other one
+   * costs a direct call per byte instead of two virtual ones. The command still goes out through Stream,
+   * once per transaction. Use it wherever an InfiniCommandSender is taken.
+   * TransportT derives from Stream and does not have to be the most derived type of the object: its
+   * own available() and read() are called, so take care that they are the ones that read the link.
+   */
+  template <typename TransportT>
+  class InfiniCommandSenderT : public InfiniCommandSender {
+    public:
+    InfiniCommandSenderT(TransportT &transport, Stream *dbgStream = NULL) :
+      InfiniCommandSender(transport, dbgStream),
+      m_transport(transport)
+    {}
+
+    protected:
+    bool drainStream() override {
+      Direct direct = {m_transport};
+      return drain(direct);
+    }
+
+    private:
+    //! The transport's own available() and read(), bound at compile time.
+    struct Direct {
+      TransportT &transport;
+
+      int available() {
+        return transport.TransportT::available();
+      }
+
+      size_t readBlock(char *buffer, size_t length) {
+        return InfiniBlockReader<TransportT>::read(transport, buffer, length);
+      }
+    };
+
+    TransportT &m_transport;
   };
 }
 #endif
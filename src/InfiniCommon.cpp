@@ -1,8 +1,33 @@
 #include "InfiniCommon.h"
+#include "InfiniCivilDate.h"
 #include <time.h>
 #include <stdio.h>
+#include <string.h>
 
 namespace INFI {
+  FlashString getResponseErrorString(RESPONSE_ERROR error) {
+    switch (error) {
+      case RESP_OK: return INFI_F("ok");
+      case RESP_BAD_LENGTH: return INFI_F("bad length");
+      case RESP_BAD_START: return INFI_F("bad start token");
+      case RESP_BAD_CRC: return INFI_F("bad crc");
+      case RESP_TIMEOUT: return INFI_F("timeout");
+      case RESP_NAK: return INFI_F("nak");
+      case RESP_BAD_FIELD: return INFI_F("bad field");
+    }
+    return INFI_F("unknown");
+  }
+
+  COMMAND_TYPE findCommandType(const char *mnemonic, ACTION_TYPE actionType) {
+    for (BYTE i = 0; mnemonic != NULL && i < NUM_COMMAND_TYPES; ++i) {
+      const InfiniCommandDescriptor &desc = COMMAND_DESCRIPTORS[i];
+      if (desc.actionType == actionType && strcmp(desc.mnemonic, mnemonic) == 0) {
+        return (COMMAND_TYPE)i;
+      }
+    }
+    return NUM_COMMAND_TYPES;
+  }
+
   BYTE getFullSizeFromCommandSize(BYTE commandSz, bool skipEndToken) {
     BYTE val = START_TOKEN_SZ + DATA_LENGTH_SZ + commandSz;
     if (skipEndToken) {
@@ -44,10 +69,14 @@ namespace INFI {
   }
 
   void getToday(char *out) {
-    time_t rawtime;
-    struct tm * ptm;
-    time(&rawtime);
-    ptm = localtime (&rawtime);
-    sprintf(out, "%4d%02d%02d", ptm->tm_year + 1900, ptm->tm_mon + 1, ptm->tm_mday);
+    // In the local time configTime() set up, the day the ED/EM/EY keys are for. Only the formatting is ours.
+    const time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    CivilDate date;
+    date.year = local.tm_year + 1900;
+    date.month = local.tm_mon + 1;
+    date.day = local.tm_mday;
+    formatCivilDay(date, out);
   }
 }
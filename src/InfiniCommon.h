@@ -1,6 +1,85 @@
 #ifndef INFINI_COMMON_H
 #define INFINI_COMMON_H
 
+#include "InfiniModules.h"
+
+/*
+ * Constant tables can live in flash. On AVR flash is a separate address space,
+ * so those tables are marked INFI_PROGMEM and must be read with the INFI_READ_* macros.
+ * Strings go there with INFI_PSTR("..."), read them with the *_P string functions below,
+ * or print them as INFI_FLASH(str). INFI_F("...") is both at once, like F() but portable.
+ * Everywhere else these are plain reads.
+ */
+#if defined(__AVR__)
+  #include <avr/pgmspace.h>
+  class __FlashStringHelper;
+  #define INFI_PROGMEM PROGMEM
+  #define INFI_READ_BYTE(addr) pgm_read_byte(addr)
+  #define INFI_READ_WORD(addr) pgm_read_word(addr)
+  #define INFI_PSTR(s) PSTR(s)
+  #define INFI_FLASH(str) (reinterpret_cast<const __FlashStringHelper *>(str))
+  #define INFI_STRLEN_P(str) strlen_P(str)
+  #define INFI_STRNCMP_P(ram, str, n) strncmp_P(ram, str, n)
+  #define INFI_STRNCPY_P(dest, str, n) strncpy_P(dest, str, n)
+  #define INFI_MEMCPY_P(dest, src, n) memcpy_P(dest, src, n)
+#else
+  #define INFI_PROGMEM
+  #define INFI_READ_BYTE(addr) (*(const unsigned char *)(addr))
+  #define INFI_READ_WORD(addr) (*(const unsigned short *)(addr))
+  #define INFI_PSTR(s) (s)
+  #define INFI_FLASH(str) (str)
+  #define INFI_STRLEN_P(str) strlen(str)
+  #define INFI_STRNCMP_P(ram, str, n) strncmp(ram, str, n)
+  #define INFI_STRNCPY_P(dest, str, n) strncpy(dest, str, n)
+  #define INFI_MEMCPY_P(dest, src, n) memcpy(dest, src, n)
+#endif
+#define INFI_F(s) INFI_FLASH(INFI_PSTR(s))
+
+/*
+ * On ESP32 a flash erase or write, e.g. an NVS commit, an InfiniPartitionLog append or an OTA, turns the flash
+ * cache off, and until it is back only code in IRAM and data in DRAM can be reached. INFI_IRAM puts the receive
+ * path there, the RX ring and the incremental CRC, and INFI_DRAM the tables it reads. Nothing elsewhere.
+ */
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <esp_attr.h>
+  #define INFI_IRAM IRAM_ATTR
+  #define INFI_DRAM DRAM_ATTR
+#else
+  #define INFI_IRAM
+  #define INFI_DRAM
+#endif
+
+// Room in the reply buffer beyond the longest reply in COMMAND_DESCRIPTORS.
+#ifndef INFI_RESPONSE_MARGIN_SZ
+#define INFI_RESPONSE_MARGIN_SZ 16
+#endif
+
+// Size of the command buffer, at least the longest frame in COMMAND_DESCRIPTORS (23 bytes).
+// Set these per environment with build_flags in platformio.ini, e.g. to squeeze an AVR build.
+#ifndef INFI_MAX_CMD_SZ
+#define INFI_MAX_CMD_SZ 32
+#endif
+
+// Time the inverter takes between the end of a command and the start of its reply, milliseconds.
+#ifndef INFI_TURNAROUND_MS
+#define INFI_TURNAROUND_MS 250
+#endif
+
+/*
+ * Compile time log level of the library's debug output, like THINGSBOARD_ENABLE_DEBUG.
+ * Below a level its logging code is not compiled in at all, so the default costs nothing.
+ * Each log line is formatted into a buffer of INFI_LOG_LINE_SZ and written to the debug stream in one go.
+ */
+#define INFI_LOG_NONE 0
+#define INFI_LOG_ERROR 1   // Rejected and overflowing replies.
+#define INFI_LOG_DEBUG 2   // Every command in hex and every reply.
+#ifndef INFI_LOG_LEVEL
+#define INFI_LOG_LEVEL INFI_LOG_NONE
+#endif
+#ifndef INFI_LOG_LINE_SZ
+#define INFI_LOG_LINE_SZ 192
+#endif
+
 namespace INFI {
 
   typedef unsigned char BYTE; //1byte
@@ -9,6 +88,20 @@ namespace INFI {
   
   enum ACTION_TYPE { READ, UPDATE };
 
+  /*!
+   * Why a received frame was rejected.
+   * RESP_NAK is not a framing error: the inverter answered ^0 and refused the command.
+   */
+  enum RESPONSE_ERROR {
+    RESP_OK = 0,
+    RESP_BAD_LENGTH,  // Length differs from the ^Dxxx header, the protocol, or the buffer.
+    RESP_BAD_START,   // Does not begin with ^D, ^1 or ^0.
+    RESP_BAD_CRC,     // The two CRC bytes do not match the frame.
+    RESP_TIMEOUT,     // No complete frame before the deadline.
+    RESP_NAK,         // The inverter answered ^0.
+    RESP_BAD_FIELD    // A payload field is not a number or is wider than the protocol allows.
+  };
+
   /*!
    * An enum for representing the various commands listed in the protocol file.
    * I thought it might be good to use an enum because
@@ -28,6 +121,10 @@ namespace INFI {
     QUERY_DEFAULT_VALUE,
     QUERY_MAX_CHARGING_CURRENT,
     QUERY_MAX_AC_CHARGING_CURRENT,
+    QUERY_PROTOCOL_ID,
+    QUERY_SERIES_NUMBER,
+    QUERY_CPU_VERSION,
+    QUERY_WORKING_MODE,
     SET_ENABLE_DISABLE_STATUS,
     SET_MAX_CHARGING_CURRENT,
     SET_MAX_AC_CHARGING_CURRENT,
@@ -37,65 +134,87 @@ namespace INFI {
     SET_CHARGING_SOURCE_PRIORITY,
     SET_SOLAR_POWER_PRIORITY,
     SET_BATTERY_TYPE,
-    SET_DATE_TIME
+    SET_DATE_TIME,
+    NUM_COMMAND_TYPES // Not a command, the number of entries above.
   };
 
   /*!
-   * Command sizes per protocol manual i.e. the int represented by the 3 digits after ^P or ^S.
-   * The command sizes in the protocol manual include the 2 <CRC> and 1 <cr> chars.
+   * Everything the maker, sender and parser need to know about one command, see COMMAND_DESCRIPTORS.
+   * Adding a P18 query means adding a COMMAND_TYPE and one row to that table.
    */
-  const BYTE CMD_TO_END_SZS[] = {
-    4,   // ^P004T<CRC><cr>
-    5,   // ^P005ET<CRC><cr>
-    9,   // ^P009EY2019<CRC><cr>
-    11,  // ^P011EM201902<CRC><cr>
-    13,  // ^P013ED20190216<CRC><cr>
-    5,   // ^P005GS<CRC><cr>
-    7,   // ^P007PIRI<CRC><cr>
-    6,   // ^P006FWS<CRC><cr>
-    7,   // ^P007FLAG<CRC><cr>
-    5,   // ^P005DI<CRC><cr>
-    9,   // ^P009MCHGCR<CRC><cr>
-    10,  // ^P010MUCHGCR<CRC><cr>
-    6,   // ^S006Pmn<CRC><cr>
-    13,  // ^S013MCHGCm,nnn<CRC><cr>
-    14,  // ^S014MUCHGCm,nnn<CRC><cr>
-    6,   // ^S006F50<CRC><cr>
-    6,   // ^S006F60<CRC><cr>
-    7,   // ^S007POPm<CRC><cr>
-    9,   // ^S009PCPm,n<CRC><cr>
-    7,   // ^S007PSPm<CRC><cr>
-    7,   // ^S007PBTm<CRC><cr>
-    18   // ^S018DATyymmddhhffss<CRC><cr>
+  struct InfiniCommandDescriptor {
+    //! The command chars after ^Pxxx or ^Sxxx, e.g. "GS".
+    const char *mnemonic;
+    //! READ for ^P queries, UPDATE for ^S commands.
+    ACTION_TYPE actionType;
+    //! How many param chars follow the mnemonic, 0 if the command takes none.
+    BYTE paramSz;
+    //! The 3 digits after ^D in the reply, i.e. the reply size from there to <cr>. 0 for ^1/^0 replies.
+    BYTE respToEndSz;
+    //! Whether the params are "m,<value>", addressed to parallel machine m. See makeParallelParams().
+    bool parallelAddressed;
+    //! For an UPDATE, the query that reports the setting it changes. NUM_COMMAND_TYPES for READ commands.
+    COMMAND_TYPE readBack;
   };
 
-  const BYTE RESP_TO_END_SZS[] = {
-    17,  // T, ^D017YYYYMMDDHHFFSS<CRC><cr>
-    11,  // ET, ^D011NNNNNNNN<CRC><cr>
-    11,  // EY, ^D011NNNNNNNN<CRC><cr>
-    11,  // EM, ^D011NNNNNNNN<CRC><cr>
-    11,  // ED, ^D011NNNNNNNN<CRC><cr>
-    106, // GS, ^D106AAAA,BBB,CCCC,DDD,EEEE,FFFF,GGG,HHH,III,JJJ,KKK,LLL,MMM,NNN,OOO,PPP,QQQQ,RRRR,SSSS,TTTT,U,V,W,X,Y,Z,a,b<CRC><cr>
-    85,  // PIRI, ^D085AAAA,BBB,CCCC,DDD,EEE,FFFF,GGGG,HHH,III,JJJ,KKK,LLL,MMM,N,OO,PPP,Q,R,S,T,U,V,W,Z,a<CRC><cr>
-    37,  // FWS, ^D037AA,B,C,D,E,F,G,H,I,J,K,L,M,N,O,P,Q<CRC><cr>,
-    20,  // FLAG, ^D020A,B,C,D,E,F,G,H,I<CRC><cr>
-    68,  // DI, ^D068AAAA,BBB,C,DDD,EEE,FFF,GGG,HHH,III,JJ,K,L,M,N,O,P,S,T,U,V,W,X,Y,Z<CRC><cr>
-    58,  // MCHGCR, ^D058AAA,BBB,CCC,DDD,EEE,FFF,GGG,HHH,III,JJJ,KKK,LLL,MMM,NNN<CRC><cr>
-    30,  // MUCHGCR, ^D030AAA,BBB,CCC,DDD,EEE,FFF,GGG<CRC><cr>NNN<CRC><cr>
-    0,   // Pmn, ^1<CRC><cr> or ^0<CRC><cr>
-    0,   // MCHGCm,nnn, ^1<CRC><cr> or ^0<CRC><cr>
-    0,   // MUCHGCm,nnn, ^1<CRC><cr> or ^0<CRC><cr>
-    0,   // F50, ^1<CRC><cr> or ^0<CRC><cr>
-    0,   // F60, ^1<CRC><cr> or ^0<CRC><cr>
-    0,   // POPm, ^1<CRC><cr> or ^0<CRC><cr>
-    0,   // PCPm,n, ^1<CRC><cr> or ^0<CRC><cr>
-    0,   // PSPm, ^1<CRC><cr> or ^0<CRC><cr>
-    0,   // PBTm, ^1<CRC><cr> or ^0<CRC><cr>
-    0,   // DATyymmddhhffss, ^1<CRC><cr> or ^0<CRC><cr>
+  /*!
+   * The command table, indexed by COMMAND_TYPE.
+   * The sizes are per the protocol manual, so they include the 2 <CRC> and 1 <cr> chars.
+   */
+  constexpr InfiniCommandDescriptor COMMAND_DESCRIPTORS[] = {
+    { "T",       READ,   0,  17, false, NUM_COMMAND_TYPES             },  // ^P004T<CRC><cr>, ^D017YYYYMMDDHHFFSS<CRC><cr>
+    { "ET",      READ,   0,  11, false, NUM_COMMAND_TYPES             },  // ^P005ET<CRC><cr>, ^D011NNNNNNNN<CRC><cr>
+    { "EY",      READ,   4,  11, false, NUM_COMMAND_TYPES             },  // ^P009EY2019<CRC><cr>, ^D011NNNNNNNN<CRC><cr>
+    { "EM",      READ,   6,  11, false, NUM_COMMAND_TYPES             },  // ^P011EM201902<CRC><cr>, ^D011NNNNNNNN<CRC><cr>
+    { "ED",      READ,   8,  11, false, NUM_COMMAND_TYPES             },  // ^P013ED20190216<CRC><cr>, ^D011NNNNNNNN<CRC><cr>
+    { "GS",      READ,   0, 106, false, NUM_COMMAND_TYPES             },  // ^P005GS<CRC><cr>, ^D106AAAA,BBB,CCCC,DDD,EEEE,FFFF,GGG,HHH,III,JJJ,KKK,LLL,MMM,NNN,OOO,PPP,QQQQ,RRRR,SSSS,TTTT,U,V,W,X,Y,Z,a,b<CRC><cr>
+    { "PIRI",    READ,   0,  85, false, NUM_COMMAND_TYPES             },  // ^P007PIRI<CRC><cr>, ^D085AAAA,BBB,CCCC,DDD,EEE,FFFF,GGGG,HHH,III,JJJ,KKK,LLL,MMM,N,OO,PPP,Q,R,S,T,U,V,W,Z,a<CRC><cr>
+    { "FWS",     READ,   0,  37, false, NUM_COMMAND_TYPES             },  // ^P006FWS<CRC><cr>, ^D037AA,B,C,D,E,F,G,H,I,J,K,L,M,N,O,P,Q<CRC><cr>
+    { "FLAG",    READ,   0,  20, false, NUM_COMMAND_TYPES             },  // ^P007FLAG<CRC><cr>, ^D020A,B,C,D,E,F,G,H,I<CRC><cr>
+    { "DI",      READ,   0,  68, false, NUM_COMMAND_TYPES             },  // ^P005DI<CRC><cr>, ^D068AAAA,BBB,C,DDD,EEE,FFF,GGG,HHH,III,JJ,K,L,M,N,O,P,S,T,U,V,W,X,Y,Z<CRC><cr>
+    { "MCHGCR",  READ,   0,  58, false, NUM_COMMAND_TYPES             },  // ^P009MCHGCR<CRC><cr>, ^D058AAA,BBB,CCC,DDD,EEE,FFF,GGG,HHH,III,JJJ,KKK,LLL,MMM,NNN<CRC><cr>
+    { "MUCHGCR", READ,   0,  30, false, NUM_COMMAND_TYPES             },  // ^P010MUCHGCR<CRC><cr>, ^D030AAA,BBB,CCC,DDD,EEE,FFF,GGG<CRC><cr>
+    { "PI",      READ,   0,   5, false, NUM_COMMAND_TYPES             },  // ^P005PI<CRC><cr>, ^D005AA<CRC><cr>
+    { "ID",      READ,   0,  25, false, NUM_COMMAND_TYPES             },  // ^P005ID<CRC><cr>, ^D025AABBBBBBBBBBBBBBBBBBBB<CRC><cr>
+    { "VFW",     READ,   0,  20, false, NUM_COMMAND_TYPES             },  // ^P006VFW<CRC><cr>, ^D020AAAAA,BBBBB,CCCCC<CRC><cr>
+    { "MOD",     READ,   0,   5, false, NUM_COMMAND_TYPES             },  // ^P006MOD<CRC><cr>, ^D005AA<CRC><cr>
+    { "P",       UPDATE, 2,   0, false, QUERY_ENABLE_DISABLE_STATUS   },  // ^S006Pmn<CRC><cr>, ^1<CRC><cr> or ^0<CRC><cr>
+    { "MCHGC",   UPDATE, 5,   0, true,  QUERY_RATED_INFORMATION       },  // ^S013MCHGCm,nnn<CRC><cr>, ^1<CRC><cr> or ^0<CRC><cr>
+    { "MUCHGC",  UPDATE, 5,   0, true,  QUERY_RATED_INFORMATION       },  // ^S014MUCHGCm,nnn<CRC><cr>, ^1<CRC><cr> or ^0<CRC><cr>
+    { "F50",     UPDATE, 0,   0, false, QUERY_RATED_INFORMATION       },  // ^S006F50<CRC><cr>, ^1<CRC><cr> or ^0<CRC><cr>
+    { "F60",     UPDATE, 0,   0, false, QUERY_RATED_INFORMATION       },  // ^S006F60<CRC><cr>, ^1<CRC><cr> or ^0<CRC><cr>
+    { "POP",     UPDATE, 1,   0, false, QUERY_RATED_INFORMATION       },  // ^S007POPm<CRC><cr>, ^1<CRC><cr> or ^0<CRC><cr>
+    { "PCP",     UPDATE, 3,   0, true,  QUERY_RATED_INFORMATION       },  // ^S009PCPm,n<CRC><cr>, ^1<CRC><cr> or ^0<CRC><cr>
+    { "PSP",     UPDATE, 1,   0, false, QUERY_RATED_INFORMATION       },  // ^S007PSPm<CRC><cr>, ^1<CRC><cr> or ^0<CRC><cr>
+    { "PBT",     UPDATE, 1,   0, false, QUERY_RATED_INFORMATION       },  // ^S007PBTm<CRC><cr>, ^1<CRC><cr> or ^0<CRC><cr>
+    { "DAT",     UPDATE, 12,  0, false, CURRENT_TIME                  }   // ^S018DATyymmddhhffss<CRC><cr>, ^1<CRC><cr> or ^0<CRC><cr>
   };
 
+  static_assert(sizeof(COMMAND_DESCRIPTORS) / sizeof(COMMAND_DESCRIPTORS[0]) == NUM_COMMAND_TYPES,
+                "COMMAND_DESCRIPTORS needs one row per COMMAND_TYPE");
+
+  //! The table row for commandType.
+  constexpr const InfiniCommandDescriptor& getCommandDescriptor(COMMAND_TYPE commandType) {
+    return COMMAND_DESCRIPTORS[commandType];
+  }
+
+  //! Length of a C string, usable at compile time on the table's mnemonics.
+  constexpr BYTE getMnemonicSize(const char *mnemonic) {
+    return *mnemonic == '\0' ? 0 : 1 + getMnemonicSize(mnemonic + 1);
+  }
+
   // Messaging baud
   const long SERIAL_BAUD = 2400;
+
+  //! Bits a byte takes on the wire with SERIAL_8N1: start, 8 data, stop.
+  const BYTE BITS_PER_WIRE_BYTE = 10;
+
+  const unsigned long TURNAROUND_MS = INFI_TURNAROUND_MS;
+
+  //! Milliseconds it takes to move bytes at baud, rounded up.
+  constexpr unsigned long getWireTimeMs(unsigned long bytes, unsigned long baud = SERIAL_BAUD) {
+    return (bytes * BITS_PER_WIRE_BYTE * 1000UL + baud - 1) / baud;
+  }
   
   // Message Format sizes in bytes
   const BYTE START_TOKEN_SZ = 2;
@@ -104,8 +223,7 @@ namespace INFI {
   const BYTE END_TOKEN_SZ = 1;
 
   // Message Response sizes in bytes
-  const BYTE MAX_CMD_SZ = 32;
-  const int MAX_RESPONSE_SZ = 1024;
+  const BYTE MAX_CMD_SZ = INFI_MAX_CMD_SZ;
 
   // Other common sizes in bytes
   const BYTE START_OFFSET_SZ = START_TOKEN_SZ + DATA_LENGTH_SZ;
@@ -113,6 +231,95 @@ namespace INFI {
   const BYTE TIME_MON_SZ = TIME_YEAR_SZ + 2; //201611
   const BYTE TIME_DAY_SZ = TIME_MON_SZ + 2; //20161103
 
+  //! The 3 digits after ^P or ^S: the size of the mnemonic, params, <CRC> and <cr>.
+  constexpr BYTE getCommandToEndSize(COMMAND_TYPE commandType) {
+    return getMnemonicSize(COMMAND_DESCRIPTORS[commandType].mnemonic) + COMMAND_DESCRIPTORS[commandType].paramSz
+      + CRC_SZ + END_TOKEN_SZ;
+  }
+
+  //! The size of the whole frame sent for commandType, from ^ to <cr>.
+  constexpr BYTE getFrameSize(COMMAND_TYPE commandType) {
+    return START_OFFSET_SZ + getCommandToEndSize(commandType);
+  }
+
+  //! The size of the whole reply to commandType, from ^ to <cr>.
+  constexpr BYTE getResponseSize(COMMAND_TYPE commandType) {
+    return COMMAND_DESCRIPTORS[commandType].actionType == UPDATE ? START_TOKEN_SZ + CRC_SZ + END_TOKEN_SZ
+      : START_OFFSET_SZ + COMMAND_DESCRIPTORS[commandType].respToEndSz;
+  }
+
+  //! The longest reply in COMMAND_DESCRIPTORS, looking from index i onwards.
+  constexpr BYTE getLongestResponseSize(BYTE i = 0) {
+    return i >= NUM_COMMAND_TYPES ? 0
+      : getResponseSize((COMMAND_TYPE)i) > getLongestResponseSize(i + 1) ? getResponseSize((COMMAND_TYPE)i)
+      : getLongestResponseSize(i + 1);
+  }
+
+  //! The longest frame in COMMAND_DESCRIPTORS, looking from index i onwards.
+  constexpr BYTE getLongestFrameSize(BYTE i = 0, BYTE longest = 0) {
+    return i >= NUM_COMMAND_TYPES ? longest
+      : getLongestFrameSize(i + 1, getFrameSize((COMMAND_TYPE)i) > longest ? getFrameSize((COMMAND_TYPE)i) : longest);
+  }
+
+  static_assert(MAX_CMD_SZ >= getLongestFrameSize(), "INFI_MAX_CMD_SZ is too small for the longest command");
+
+  /*! How long a transaction of commandType may take, counted from when its frame is handed to the UART:
+   * sending the frame, the inverter's turnaround and receiving the whole reply.
+   * About 320 ms for a ^S ack and 760 ms for GS with the default turnaround at SERIAL_BAUD.
+   */
+  constexpr unsigned long getResponseTimeoutMs(COMMAND_TYPE commandType, unsigned long turnaroundMs = TURNAROUND_MS,
+                                               unsigned long baud = SERIAL_BAUD) {
+    return getWireTimeMs((unsigned long)getFrameSize(commandType) + getResponseSize(commandType), baud) + turnaroundMs;
+  }
+
+  //! What the msUntil*() methods return when nothing is scheduled.
+  const unsigned long NO_DEADLINE = 0xFFFFFFFFUL;
+
+  //! Milliseconds from nowMs until periodMs will have passed since sinceMs, 0 if it already has.
+  constexpr unsigned long msUntilElapsed(unsigned long sinceMs, unsigned long periodMs, unsigned long nowMs) {
+    return nowMs - sinceMs >= periodMs ? 0 : periodMs - (nowMs - sinceMs);
+  }
+
+  /*! msUntilElapsed() of a deadline kept in micros(), rounded up to whole milliseconds,
+   * so a loop that sleeps for it never wakes to find it still a fraction of a millisecond away.
+   */
+  constexpr unsigned long msUntilElapsedUs(unsigned long sinceUs, unsigned long periodMs, unsigned long nowUs) {
+    return nowUs - sinceUs >= periodMs * 1000UL ? 0 : (periodMs * 1000UL - (nowUs - sinceUs) + 999UL) / 1000UL;
+  }
+
+  //! Size of the reply buffer, the longest reply (GS, 111 bytes) plus INFI_RESPONSE_MARGIN_SZ.
+  const int MAX_RESPONSE_SZ = getLongestResponseSize() + INFI_RESPONSE_MARGIN_SZ;
+  // The byte after the longest reply stays free for the terminator, the debug output prints replies as strings.
+  static_assert(INFI_RESPONSE_MARGIN_SZ >= 1, "INFI_RESPONSE_MARGIN_SZ must leave room for the terminator");
+
+#if defined(__AVR__)
+  //! What INFI_F() gives, a string Print can print straight from flash.
+  typedef const __FlashStringHelper *FlashString;
+#else
+  typedef const char *FlashString;
+#endif
+
+  //! A short description of error, for debug output. In flash on AVR, it can be printed but not used as a char *.
+  FlashString getResponseErrorString(RESPONSE_ERROR error);
+
+  //! The command of actionType whose mnemonic is mnemonic, e.g. GENERAL_STATUS for READ "GS". NUM_COMMAND_TYPES if none.
+  COMMAND_TYPE findCommandType(const char *mnemonic, ACTION_TYPE actionType);
+
+  //! Whether commandType addresses a parallel machine, i.e. its params start with "m,".
+  constexpr bool isParallelAddressed(COMMAND_TYPE commandType) {
+    return COMMAND_DESCRIPTORS[commandType].parallelAddressed;
+  }
+
+  //! The query that reads back what the UPDATE commandType changed, NUM_COMMAND_TYPES if there is none.
+  constexpr COMMAND_TYPE getReadBackQuery(COMMAND_TYPE commandType) {
+    return COMMAND_DESCRIPTORS[commandType].readBack;
+  }
+
+  //! Whether commandType is a ^P query (READ) or a ^S command (UPDATE).
+  constexpr ACTION_TYPE getActionType(COMMAND_TYPE commandType) {
+    return COMMAND_DESCRIPTORS[commandType].actionType;
+  }
+
   /*! Derive the length of the entire message to be sent from the command size.
    *  This appears in the msg itself as the 3 digits after the start token.
    */
@@ -130,7 +337,7 @@ namespace INFI {
    */
   void setupGMTTimeForIndia();
   
-  //! Get current day.
+  //! Get current day from the MCU's system clock, in its local time zone. InfiniClock::getToday() gives the inverter's instead.
   void getToday(char *out);
 }
 
@@ -0,0 +1,158 @@
+#ifndef INFINI_CONCURRENCY_H
+#define INFINI_CONCURRENCY_H
+
+#include <stdint.h>
+#include <string.h>
+#include "InfiniCommon.h"
+
+// Bytes the indexes of a InfiniSpscRing are kept apart by, so the producer and the consumer on different cores
+// don't fight over the line holding both. No cache to mind on AVR.
+#ifndef INFI_CACHE_LINE_SZ
+#if defined(ARDUINO_ARCH_ESP32)
+#define INFI_CACHE_LINE_SZ 32
+#else
+#define INFI_CACHE_LINE_SZ 1
+#endif
+#endif
+
+namespace INFI {
+
+  /*!
+   * A lock-free single producer, single consumer ring of N items of T, for handing data from one task or ISR to
+   * another without a FreeRTOS queue's critical section. T is copied in and out with memcpy, so keep it plain
+   * data and small, e.g. a pool slot or a pointer, rather than a whole frame.
+   * N is a power of two of at most 128, and all N slots can be used: head and tail run freely and wrap as bytes,
+   * so their loads and stores are atomic on AVR too. Each is written by one side only and sits on its own cache line.
+   */
+  template <typename T, BYTE N>
+  class InfiniSpscRing {
+    static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0, "InfiniSpscRing size must be a power of two of at most 128");
+
+    public:
+    InfiniSpscRing() :
+      m_head(0),
+      m_tail(0)
+    {}
+
+    //! Producer side. Copies item into the ring, or returns false if it is full.
+    bool push(const T &item) {
+      BYTE head = m_head;
+      if ((BYTE)(head - __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE)) >= N) {
+        return false;
+      }
+      memcpy(&m_items[head & (N - 1)], &item, sizeof(T));
+      // Publish the item before the index that hands it over.
+      __atomic_store_n(&m_head, (BYTE)(head + 1), __ATOMIC_RELEASE);
+      return true;
+    }
+
+    //! Consumer side. Moves the oldest item into item, or returns false if the ring is empty.
+    bool pop(T &item) {
+      BYTE tail = m_tail;
+      if (tail == __atomic_load_n(&m_head, __ATOMIC_ACQUIRE)) {
+        return false;
+      }
+      memcpy(&item, &m_items[tail & (N - 1)], sizeof(T));
+      // The slot is the producer's again only once the copy is out.
+      __atomic_store_n(&m_tail, (BYTE)(tail + 1), __ATOMIC_RELEASE);
+      return true;
+    }
+
+    //! Items waiting, from either side. Only a snapshot while the other side runs.
+    BYTE size() const {
+      return (BYTE)(__atomic_load_n(&m_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE));
+    }
+
+    bool isEmpty() const {
+      return size() == 0;
+    }
+
+    static BYTE capacity() {
+      return N;
+    }
+
+    private:
+    T m_items[N];
+    //! Written by the producer only.
+    alignas(INFI_CACHE_LINE_SZ) volatile BYTE m_head;
+    //! Written by the consumer only.
+    alignas(INFI_CACHE_LINE_SZ) volatile BYTE m_tail;
+  };
+
+  /*!
+   * The latest value of T, written by one task and read from any number of others without a lock.
+   * A seqlock over two copies: write() bumps the sequence, so readers move over to the second copy, updates
+   * the first, bumps it again and then updates the second. read() copies the copy the sequence points at and
+   * starts over only if a write() got past it meanwhile. A reader therefore never waits for a writer that is
+   * in the middle of an update, even one it preempted on the same core, and the writer never waits at all.
+   * T is copied with memcpy, so it has to be plain data, e.g. GeneralStatusFixed. beginWrite() and endWrite()
+   * change the latest value in place instead, for a writer that only updates a part of a bigger T.
+   */
+  template <typename T>
+  class InfiniSnapshot {
+    public:
+    InfiniSnapshot() :
+      m_sequence(0),
+      m_written(false)
+    {
+      memset(m_copies, 0, sizeof(m_copies));
+    }
+
+    //! Writer side. Stores value as the latest one. Writes must all come from one task.
+    void write(const T &value) {
+      memcpy(&beginWrite(), &value, sizeof(T));
+      endWrite();
+    }
+
+    //! Writer side. Returns the latest value to change in place, readers keep seeing it unchanged until endWrite().
+    T &beginWrite() {
+      // Odd: readers are on the second copy while the first one changes.
+      __atomic_store_n(&m_sequence, (SEQUENCE)(m_sequence + 1), __ATOMIC_RELEASE);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      return m_copies[0];
+    }
+
+    //! Writer side. Publishes what was changed since beginWrite().
+    void endWrite() {
+      // Even: back to the first copy, now up to date, while the second one changes.
+      __atomic_store_n(&m_sequence, (SEQUENCE)(m_sequence + 1), __ATOMIC_RELEASE);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      memcpy(&m_copies[1], &m_copies[0], sizeof(T));
+      // Only once both copies hold a value, whichever a reader is on.
+      __atomic_store_n(&m_written, true, __ATOMIC_RELEASE);
+    }
+
+    //! Reader side, from any task. Copies the latest value into out. Returns false if nothing was written yet.
+    bool read(T &out) const {
+      SEQUENCE sequence = __atomic_load_n(&m_sequence, __ATOMIC_ACQUIRE);
+      while (true) {
+        memcpy(&out, &m_copies[sequence & 1], sizeof(T));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        SEQUENCE now = __atomic_load_n(&m_sequence, __ATOMIC_ACQUIRE);
+        if (now == sequence) {
+          return __atomic_load_n(&m_written, __ATOMIC_ACQUIRE);
+        }
+        sequence = now;
+      }
+    }
+
+    //! Bumped by every finished write(), so a reader can tell whether the value moved since it last looked.
+    unsigned long version() const {
+      return __atomic_load_n(&m_sequence, __ATOMIC_ACQUIRE) / 2;
+    }
+
+    private:
+    //! A single byte on AVR, so its loads and stores are atomic there too.
+#if defined(ARDUINO_ARCH_ESP32)
+    typedef uint32_t SEQUENCE;
+#else
+    typedef BYTE SEQUENCE;
+#endif
+
+    T m_copies[2];
+    volatile SEQUENCE m_sequence;
+    volatile bool m_written;
+  };
+}
+
+#endif
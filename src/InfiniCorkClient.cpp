@@ -0,0 +1,112 @@
+#include "InfiniCorkClient.h"
+
+#if INFI_MODULE_SINKS
+
+#if defined(ARDUINO)
+#include <string.h>
+
+namespace INFI {
+
+  InfiniCorkClient::InfiniCorkClient(Client &client) :
+    m_client(client),
+    m_length(0),
+    m_corked(false)
+  {
+  }
+
+  void InfiniCorkClient::cork() {
+    m_corked = true;
+  }
+
+  bool InfiniCorkClient::uncork() {
+    m_corked = false;
+    return send();
+  }
+
+  bool InfiniCorkClient::isCorked() const {
+    return m_corked;
+  }
+
+  size_t InfiniCorkClient::pending() const {
+    return m_length;
+  }
+
+  int InfiniCorkClient::connect(IPAddress ip, uint16_t port) {
+    m_length = 0;
+    return m_client.connect(ip, port);
+  }
+
+  int InfiniCorkClient::connect(const char *host, uint16_t port) {
+    m_length = 0;
+    return m_client.connect(host, port);
+  }
+
+  size_t InfiniCorkClient::write(uint8_t b) {
+    return write(&b, 1);
+  }
+
+  size_t InfiniCorkClient::write(const uint8_t *buf, size_t size) {
+    if (!m_corked) {
+      return m_client.write(buf, size);
+    }
+    size_t done = 0;
+    while (done < size) {
+      if (m_length == CORK_BUFFER_SZ && !send()) {
+        return done;
+      }
+      size_t chunk = CORK_BUFFER_SZ - m_length;
+      if (chunk > size - done) {
+        chunk = size - done;
+      }
+      memcpy(m_buffer + m_length, buf + done, chunk);
+      m_length += chunk;
+      done += chunk;
+    }
+    return done;
+  }
+
+  int InfiniCorkClient::available() {
+    return m_client.available();
+  }
+
+  int InfiniCorkClient::read() {
+    return m_client.read();
+  }
+
+  int InfiniCorkClient::read(uint8_t *buf, size_t size) {
+    return m_client.read(buf, size);
+  }
+
+  int InfiniCorkClient::peek() {
+    return m_client.peek();
+  }
+
+  void InfiniCorkClient::flush() {
+    send();
+    m_client.flush();
+  }
+
+  void InfiniCorkClient::stop() {
+    m_length = 0;
+    m_client.stop();
+  }
+
+  uint8_t InfiniCorkClient::connected() {
+    return m_client.connected();
+  }
+
+  InfiniCorkClient::operator bool() {
+    return (bool)m_client;
+  }
+
+  bool InfiniCorkClient::send() {
+    if (m_length == 0) {
+      return true;
+    }
+    const size_t length = m_length;
+    m_length = 0;
+    return m_client.write(m_buffer, length) == length;
+  }
+}
+#endif
+#endif
@@ -0,0 +1,67 @@
+#ifndef INFINI_CORK_CLIENT_H
+#define INFINI_CORK_CLIENT_H
+
+#include <stddef.h>
+#include "InfiniCommon.h"
+
+// Most bytes InfiniCorkClient holds back, one TCP segment at lwIP's default MSS.
+#ifndef INFI_CORK_BUFFER_SZ
+#define INFI_CORK_BUFFER_SZ 1436
+#endif
+
+#if defined(ARDUINO)
+#include <Client.h>
+#endif
+
+namespace INFI {
+
+  const size_t CORK_BUFFER_SZ = INFI_CORK_BUFFER_SZ;
+
+#if defined(ARDUINO)
+  /*!
+   * A Client in front of another that, while corked, gathers what is written and hands it over in one write()
+   * on uncork(), like TCP_CORK. An MQTT client writes every packet on its own, so a burst of small publishes,
+   * e.g. of InfiniFieldTopics, would go out as a TCP segment each, or over InfiniTlsClient a TLS record each.
+   * Corked around the burst they share one. When the buffer fills up, what it holds is sent and gathering
+   * starts over. Everything else is passed through, uncorked so are the writes.
+   */
+  class InfiniCorkClient : public Client {
+    public:
+    InfiniCorkClient(Client &client);
+
+    //! Holds back what is written from now on, until uncork().
+    void cork();
+    //! Writes what was held back, in one go. Returns false if the connection did not take all of it.
+    bool uncork();
+    bool isCorked() const;
+    //! Bytes held back right now.
+    size_t pending() const;
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char *host, uint16_t port) override;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t *buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t size) override;
+    int peek() override;
+    //! Writes what was held back, then flushes the connection.
+    void flush() override;
+    //! Drops what was held back along with the connection.
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override;
+
+    private:
+    //! Writes the buffer to the connection and empties it.
+    bool send();
+
+    Client &m_client;
+    BYTE m_buffer[CORK_BUFFER_SZ];
+    size_t m_length;
+    bool m_corked;
+  };
+#endif
+}
+
+#endif
@@ -0,0 +1,141 @@
+#include "InfiniCoroutine.h"
+
+#if INFI_MODULE_SCHEDULER
+
+#if INFI_ENABLE_COROUTINES
+#include <Arduino.h>
+#include <string.h>
+
+namespace INFI {
+
+  InfiniExecutor::InfiniExecutor() :
+    m_readyHead(0),
+    m_readyCount(0)
+  {
+    for (BYTE i = 0; i < EXECUTOR_TASKS_SZ; ++i) {
+      m_tasks[i] = nullptr;
+      m_ready[i] = nullptr;
+      m_timers[i].handle = nullptr;
+    }
+  }
+
+  InfiniExecutor::~InfiniExecutor() {
+    // Nothing resumes them past this point.
+    for (BYTE i = 0; i < EXECUTOR_TASKS_SZ; ++i) {
+      if (m_tasks[i]) {
+        m_tasks[i].destroy();
+      }
+    }
+  }
+
+  bool InfiniExecutor::spawn(InfiniTask task) {
+    for (BYTE i = 0; i < EXECUTOR_TASKS_SZ; ++i) {
+      if (m_tasks[i]) {
+        continue;
+      }
+      InfiniTask::Handle handle = task.release();
+      handle.promise().executor = this;
+      m_tasks[i] = handle;
+      // Suspended at its start, so the first loop() runs it up to its first co_await.
+      return schedule(handle);
+    }
+    return false;
+  }
+
+  void InfiniExecutor::loop() {
+    unsigned long now = millis();
+    for (BYTE i = 0; i < EXECUTOR_TASKS_SZ; ++i) {
+      Timer &timer = m_timers[i];
+      if (timer.handle && now - timer.startMs >= timer.ms) {
+        schedule(timer.handle);
+        timer.handle = nullptr;
+      }
+    }
+    // Only the ones ready now, a task a step makes ready again waits for the next loop().
+    for (BYTE n = m_readyCount; n > 0; --n) {
+      std::coroutine_handle<> handle = m_ready[m_readyHead];
+      m_readyHead = (BYTE)((m_readyHead + 1) % EXECUTOR_TASKS_SZ);
+      m_readyCount--;
+      handle.resume();
+    }
+    for (BYTE i = 0; i < EXECUTOR_TASKS_SZ; ++i) {
+      if (m_tasks[i] && m_tasks[i].done()) {
+        m_tasks[i].destroy();
+        m_tasks[i] = nullptr;
+      }
+    }
+  }
+
+  BYTE InfiniExecutor::running() const {
+    BYTE count = 0;
+    for (BYTE i = 0; i < EXECUTOR_TASKS_SZ; ++i) {
+      count += m_tasks[i] ? 1 : 0;
+    }
+    return count;
+  }
+
+  InfiniExecutor::SleepAwaiter InfiniExecutor::sleep(unsigned long ms) {
+    return SleepAwaiter{*this, ms};
+  }
+
+  bool InfiniExecutor::schedule(std::coroutine_handle<> handle) {
+    if (m_readyCount >= EXECUTOR_TASKS_SZ) {
+      return false;
+    }
+    m_ready[(m_readyHead + m_readyCount) % EXECUTOR_TASKS_SZ] = handle;
+    m_readyCount++;
+    return true;
+  }
+
+  bool InfiniExecutor::addTimer(std::coroutine_handle<> handle, unsigned long ms) {
+    for (BYTE i = 0; i < EXECUTOR_TASKS_SZ; ++i) {
+      Timer &timer = m_timers[i];
+      if (!timer.handle) {
+        timer.handle = handle;
+        timer.startMs = millis();
+        timer.ms = ms;
+        return true;
+      }
+    }
+    // No timer left, the task goes on without sleeping.
+    return false;
+  }
+
+  InfiniCoInverter::InfiniCoInverter(InfiniCommandQueue &queue) :
+    m_queue(queue)
+  {}
+
+  InfiniCoInverter::QueryAwaiter InfiniCoInverter::query(COMMAND_TYPE commandType, const char *params) {
+    return QueryAwaiter{m_queue, commandType, params, NULL, nullptr, {}};
+  }
+
+  bool InfiniCoInverter::QueryAwaiter::await_suspend(InfiniTask::Handle awaiting) {
+    executor = awaiting.promise().executor;
+    handle = awaiting;
+    result.status = SEND_ERROR;
+    result.response.cmdType = commandType;
+    if (executor == NULL || !queue.enqueue(commandType, params, onComplete, this)) {
+      return false;
+    }
+    return true;
+  }
+
+  void InfiniCoInverter::QueryAwaiter::onComplete(const InfiniResponse &response, SEND_STATUS status, void *context) {
+    QueryAwaiter *awaiter = (QueryAwaiter *)context;
+    InfiniResponse &copy = awaiter->result.response;
+    size_t len = response.actualLen < copy.bufferSize ? response.actualLen : copy.bufferSize;
+    copy.reset();
+    memcpy(copy.val, response.val, len);
+    copy.actualLen = len;
+    copy.cmdType = response.cmdType;
+    copy.error = response.error;
+    copy.deviceId = response.deviceId;
+    copy.sentUs = response.sentUs;
+    awaiter->result.status = status;
+    // Not resumed from inside the queue's loop(), the task may well queue the next command.
+    awaiter->executor->schedule(awaiter->handle);
+  }
+}
+
+#endif
+#endif
@@ -0,0 +1,195 @@
+#ifndef INFINI_COROUTINE_H
+#define INFINI_COROUTINE_H
+
+#include "InfiniCommandQueue.h"
+
+// C++20 coroutines, on by default where the toolchain has them, e.g. ESP32 Arduino 3 with -std=gnu++2a.
+#ifndef INFI_ENABLE_COROUTINES
+#  if __cplusplus >= 202002L && defined(__has_include)
+#    if __has_include(<coroutine>)
+#      define INFI_ENABLE_COROUTINES 1
+#    endif
+#  endif
+#endif
+#ifndef INFI_ENABLE_COROUTINES
+#define INFI_ENABLE_COROUTINES 0
+#endif
+
+// Coroutines one InfiniExecutor runs at once, counting only the spawn()ed ones.
+#ifndef INFI_EXECUTOR_TASKS_SZ
+#define INFI_EXECUTOR_TASKS_SZ 4
+#endif
+
+#if INFI_ENABLE_COROUTINES
+#include <coroutine>
+
+namespace INFI {
+
+  const BYTE EXECUTOR_TASKS_SZ = INFI_EXECUTOR_TASKS_SZ;
+
+  class InfiniExecutor;
+
+  /*!
+   * A coroutine run by an InfiniExecutor: spawn() it, or co_await it from another InfiniTask to run it as a step.
+   * It does not start until then. The frame is allocated when it is called and freed once it finished.
+   */
+  class InfiniTask {
+    public:
+    struct promise_type;
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    struct promise_type {
+      //! The task awaiting this one, resumed once it finished. None for a spawned task.
+      std::coroutine_handle<> continuation;
+      InfiniExecutor *executor = NULL;
+
+      //! Hands over to the awaiting task, or back to the executor, which frees a spawned task once it is done.
+      struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept {
+          std::coroutine_handle<> next = handle.promise().continuation;
+          return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+      };
+
+      InfiniTask get_return_object() { return InfiniTask(Handle::from_promise(*this)); }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      FinalAwaiter final_suspend() noexcept { return {}; }
+      void return_void() {}
+      // Exceptions are off on the Arduino cores.
+      void unhandled_exception() {}
+    };
+
+    //! Runs the task as a step of the awaiting one, on the same executor.
+    struct Awaiter {
+      Handle handle;
+      bool await_ready() const { return !handle || handle.done(); }
+      std::coroutine_handle<> await_suspend(Handle awaiting) {
+        handle.promise().continuation = awaiting;
+        handle.promise().executor = awaiting.promise().executor;
+        return handle;
+      }
+      void await_resume() {}
+    };
+
+    InfiniTask(InfiniTask &&other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
+    InfiniTask(const InfiniTask &) = delete;
+    InfiniTask &operator=(const InfiniTask &) = delete;
+    ~InfiniTask() {
+      if (m_handle) {
+        m_handle.destroy();
+      }
+    }
+
+    Awaiter operator co_await() && { return Awaiter{m_handle}; }
+
+    //! Gives up the frame, the executor owns it from then on.
+    Handle release() {
+      Handle handle = m_handle;
+      m_handle = nullptr;
+      return handle;
+    }
+
+    private:
+    explicit InfiniTask(Handle handle) : m_handle(handle) {}
+
+    Handle m_handle;
+  };
+
+  /*!
+   * Runs InfiniTasks on the thread that calls loop(), one step at a time and never more than one at once.
+   * A task only runs up to its next co_await, so loop() returns as soon as every ready task is waiting again.
+   * Not thread safe, spawn() and loop() belong to the same task.
+   */
+  class InfiniExecutor {
+    public:
+    InfiniExecutor();
+    ~InfiniExecutor();
+
+    //! Starts task on the next loop(). Returns false, and frees it, if EXECUTOR_TASKS_SZ are already running.
+    bool spawn(InfiniTask task);
+
+    //! Resumes the tasks that are ready, frees the ones that finished. Call it from loop() as often as possible.
+    void loop();
+
+    //! Number of spawned tasks that have not finished.
+    BYTE running() const;
+
+    //! co_await executor.sleep(ms) resumes the task on the first loop() ms later.
+    struct SleepAwaiter {
+      InfiniExecutor &executor;
+      unsigned long ms;
+      bool await_ready() const { return ms == 0; }
+      bool await_suspend(std::coroutine_handle<> handle) { return executor.addTimer(handle, ms); }
+      void await_resume() {}
+    };
+    SleepAwaiter sleep(unsigned long ms);
+
+    /*! The awaitables' side. Resumes handle on the next loop(). Returns false if the ready list is full,
+     * which it cannot be while each task waits on one thing at a time.
+     */
+    bool schedule(std::coroutine_handle<> handle);
+
+    private:
+    bool addTimer(std::coroutine_handle<> handle, unsigned long ms);
+
+    struct Timer {
+      std::coroutine_handle<> handle;
+      unsigned long startMs;
+      unsigned long ms;
+    };
+
+    InfiniTask::Handle m_tasks[EXECUTOR_TASKS_SZ];
+    //! A FIFO of the handles to resume, at most one per task.
+    std::coroutine_handle<> m_ready[EXECUTOR_TASKS_SZ];
+    BYTE m_readyHead;
+    BYTE m_readyCount;
+    Timer m_timers[EXECUTOR_TASKS_SZ];
+  };
+
+  //! The outcome of a co_await InfiniCoInverter::query(), a copy of the reply as the callback saw it.
+  struct InfiniQueryResult {
+    SEND_STATUS status;
+    InfiniResponse response;
+
+    //! Whether the inverter answered with a frame that checked out.
+    bool ok() const { return status == SEND_COMPLETE && response.error == RESP_OK; }
+  };
+
+  /*!
+   * An InfiniCommandQueue seen from coroutines. co_await inverter.query(GENERAL_STATUS) queues the command
+   * and suspends the task until its callback, so a flow like T, then ED/EM/EY for the day it read, then GS
+   * reads top to bottom instead of as a chain of callbacks. The queue keeps running from its own loop()
+   * or an InfiniPollScheduler, and the task resumes on the executor's next loop(), after the queue returned.
+   */
+  class InfiniCoInverter {
+    public:
+    InfiniCoInverter(InfiniCommandQueue &queue);
+
+    struct QueryAwaiter {
+      InfiniCommandQueue &queue;
+      COMMAND_TYPE commandType;
+      const char *params;
+      InfiniExecutor *executor;
+      std::coroutine_handle<> handle;
+      InfiniQueryResult result;
+
+      bool await_ready() const { return false; }
+      //! Queues the command. If its lane is full the task goes on at once, with SEND_ERROR.
+      bool await_suspend(InfiniTask::Handle awaiting);
+      InfiniQueryResult await_resume() { return result; }
+
+      static void onComplete(const InfiniResponse &response, SEND_STATUS status, void *context);
+    };
+
+    //! Sends the command through the queue, like enqueue(). params are copied once it is queued.
+    QueryAwaiter query(COMMAND_TYPE commandType, const char *params = "");
+
+    private:
+    InfiniCommandQueue &m_queue;
+  };
+}
+
+#endif
+#endif
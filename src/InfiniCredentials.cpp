@@ -0,0 +1,112 @@
+#include "InfiniCredentials.h"
+
+#if INFI_MODULE_JSON
+#include <string.h>
+#include <ArduinoJson.h>
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Preferences.h>
+#endif
+
+namespace INFI {
+
+  const char PROVISION_REQUEST_TOPIC[] = "/provision/request";
+  const char PROVISION_RESPONSE_TOPIC[] = "/provision/response";
+
+  size_t writeProvisionRequest(const char *deviceName, const char *key, const char *secret, Print &out) {
+    JsonDocument request;
+    if (deviceName != NULL && deviceName[0] != '\0') {
+      request["deviceName"] = deviceName;
+    }
+    request["provisionDeviceKey"] = key;
+    request["provisionDeviceSecret"] = secret;
+    return serializeJson(request, out);
+  }
+
+  //! Copies value into out, which holds CREDENTIAL_SZ chars. Returns false if it is missing or too long.
+  static bool copyCredential(const char *value, char *out) {
+    if (value == NULL) {
+      return false;
+    }
+    size_t len = strlen(value);
+    if (len > CREDENTIAL_SZ) {
+      return false;
+    }
+    memcpy(out, value, len + 1);
+    return true;
+  }
+
+  bool parseProvisionResponse(const char *payload, size_t len, DeviceCredentials &credentials) {
+    memset(&credentials, 0, sizeof(credentials));
+    JsonDocument response;
+    if (deserializeJson(response, payload, len) != DeserializationError::Ok
+        || strcmp(response["status"] | "", "SUCCESS") != 0) {
+      return false;
+    }
+    const char *type = response["credentialsType"] | "";
+    JsonVariantConst value = response["credentialsValue"];
+    bool parsed = false;
+    if (strcmp(type, "ACCESS_TOKEN") == 0) {
+      // Older servers send the token as a string, newer ones as the "credentialsId" of an object.
+      const char *token = value.is<const char *>() ? value.as<const char *>() : value["credentialsId"];
+      parsed = copyCredential(token, credentials.token) && credentials.token[0] != '\0';
+      credentials.type = CREDENTIALS_ACCESS_TOKEN;
+    } else if (strcmp(type, "MQTT_BASIC") == 0) {
+      parsed = copyCredential(value["clientId"] | "", credentials.token)
+        && copyCredential(value["userName"] | "", credentials.userName)
+        && copyCredential(value["password"] | "", credentials.password)
+        && (credentials.token[0] != '\0' || credentials.userName[0] != '\0');
+      credentials.type = CREDENTIALS_MQTT_BASIC;
+    }
+    if (!parsed) {
+      memset(&credentials, 0, sizeof(credentials));
+      return false;
+    }
+    credentials.version = CREDENTIALS_VERSION;
+    return true;
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  static const char CREDENTIALS_KEY[] = "creds";
+
+  bool saveCredentials(const DeviceCredentials &credentials, const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) {
+      return false;
+    }
+    bool saved = prefs.putBytes(CREDENTIALS_KEY, &credentials, sizeof(credentials)) == sizeof(credentials);
+    prefs.end();
+    return saved;
+  }
+
+  bool loadCredentials(DeviceCredentials &credentials, const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, true)) {
+      memset(&credentials, 0, sizeof(credentials));
+      return false;
+    }
+    bool loaded = prefs.getBytesLength(CREDENTIALS_KEY) == sizeof(credentials)
+      && prefs.getBytes(CREDENTIALS_KEY, &credentials, sizeof(credentials)) == sizeof(credentials)
+      && credentials.version == CREDENTIALS_VERSION && credentials.type != CREDENTIALS_NONE;
+    prefs.end();
+    if (!loaded) {
+      memset(&credentials, 0, sizeof(credentials));
+      return false;
+    }
+    credentials.token[CREDENTIAL_SZ] = '\0';
+    credentials.userName[CREDENTIAL_SZ] = '\0';
+    credentials.password[CREDENTIAL_SZ] = '\0';
+    return true;
+  }
+
+  bool clearCredentials(const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) {
+      return false;
+    }
+    bool cleared = !prefs.isKey(CREDENTIALS_KEY) || prefs.remove(CREDENTIALS_KEY);
+    prefs.end();
+    return cleared;
+  }
+#endif
+}
+#endif
@@ -0,0 +1,65 @@
+#ifndef INFINI_CREDENTIALS_H
+#define INFINI_CREDENTIALS_H
+
+#include <stddef.h>
+#include <Print.h>
+#include "InfiniCommon.h"
+
+// Longest access token, client id, user name or password kept, ThingsBoard generates 20 char tokens.
+#ifndef INFI_CREDENTIAL_SZ
+#define INFI_CREDENTIAL_SZ 64
+#endif
+
+namespace INFI {
+
+  const size_t CREDENTIAL_SZ = INFI_CREDENTIAL_SZ;
+
+  //! Bumped whenever DeviceCredentials changes, stored credentials of another version are not used.
+  const BYTE CREDENTIALS_VERSION = 1;
+
+  //! ThingsBoard's device provisioning topics, the session is opened with the user name "provision".
+  extern const char PROVISION_REQUEST_TOPIC[];
+  extern const char PROVISION_RESPONSE_TOPIC[];
+
+  enum CREDENTIALS_TYPE {
+    CREDENTIALS_NONE = 0,
+    //! token is the MQTT user name.
+    CREDENTIALS_ACCESS_TOKEN,
+    //! clientId, userName and password of a MQTT_BASIC device.
+    CREDENTIALS_MQTT_BASIC
+  };
+
+  /*! What provisioning gave the device, plain data so it can be stored with saveCredentials().
+   * Zeroed it holds nothing.
+   */
+  struct DeviceCredentials {
+    BYTE version;
+    //! A CREDENTIALS_TYPE.
+    BYTE type;
+    //! The access token, or the MQTT_BASIC client id.
+    char token[CREDENTIAL_SZ + 1];
+    char userName[CREDENTIAL_SZ + 1];
+    char password[CREDENTIAL_SZ + 1];
+  };
+
+  /*! Writes the payload of a provisioning request for deviceName, with the device profile's provision key and
+   * secret, to publish on PROVISION_REQUEST_TOPIC. ThingsBoard then generates an access token.
+   */
+  size_t writeProvisionRequest(const char *deviceName, const char *key, const char *secret, Print &out);
+
+  /*! Parses the payload of a PROVISION_RESPONSE_TOPIC message into credentials. Returns false, with credentials
+   * zeroed, if the request was refused or the payload carries no credentials that fit.
+   */
+  bool parseProvisionResponse(const char *payload, size_t len, DeviceCredentials &credentials);
+
+#if defined(ARDUINO_ARCH_ESP32)
+  //! Stores credentials in the NVS namespace ns, so the next boot connects without provisioning.
+  bool saveCredentials(const DeviceCredentials &credentials, const char *ns = "infi_prov");
+  //! Loads what saveCredentials() stored. Returns false, with credentials zeroed, if there is nothing.
+  bool loadCredentials(DeviceCredentials &credentials, const char *ns = "infi_prov");
+  //! Drops the stored credentials, e.g. once the server refused them, so the device provisions again.
+  bool clearCredentials(const char *ns = "infi_prov");
+#endif
+}
+
+#endif
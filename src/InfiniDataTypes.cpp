@@ -0,0 +1,54 @@
+#include "InfiniDataTypes.h"
+
+namespace INFI {
+  WORD getFaultWarningFlags(const FaultWarningStatus &fws) {
+    const bool flags[FWS_FLAGS] = {
+      fws.lineFail, fws.outCircuitShort, fws.invOverTemp, fws.fanLocked,
+      fws.battVoltHigh, fws.battLow, fws.battUnder, fws.overLoad,
+      fws.eepromFail, fws.powLimit, fws.pv1VoltHigh, fws.pv2VoltHigh,
+      fws.mppt1Overload, fws.mppt2Overload, fws.battTooLowToChargeSCC1, fws.battTooLowToChargeSCC2
+    };
+    WORD mask = 0;
+    for (BYTE i = 0; i < FWS_FLAGS; ++i) {
+      if (flags[i]) {
+        mask |= (WORD)(1u << i);
+      }
+    }
+    return mask;
+  }
+
+  float deciToFloat(WORD deci) {
+    return deci / 10.0f;
+  }
+
+  void toGeneralStatus(const GeneralStatusFixed &in, GeneralStatus &out) {
+    out.gridVolt = deciToFloat(in.gridVoltDeci);
+    out.gridFreq = deciToFloat(in.gridFreqDeci);
+    out.acOutVolt = deciToFloat(in.acOutVoltDeci);
+    out.acOutFreq = deciToFloat(in.acOutFreqDeci);
+    out.acOutApparentPow = in.acOutApparentPow;
+    out.acOutActivePow = in.acOutActivePow;
+    out.outLoadPct = in.outLoadPct;
+    out.battVolt = deciToFloat(in.battVoltDeci);
+    out.battVoltSCC = deciToFloat(in.battVoltSCCDeci);
+    out.battVoltSCC2 = deciToFloat(in.battVoltSCC2Deci);
+    out.battDischargeCurr = in.battDischargeCurr;
+    out.battChargeCurr = in.battChargeCurr;
+    out.battCapacity = in.battCapacity;
+    out.invHeatSinkTemp = in.invHeatSinkTemp;
+    out.mppt1ChrgrTemp = in.mppt1ChrgrTemp;
+    out.mppt2ChrgrTemp = in.mppt2ChrgrTemp;
+    out.pv1InPow = in.pv1InPow;
+    out.pv2InPow = in.pv2InPow;
+    out.pv1InVolt = deciToFloat(in.pv1InVoltDeci);
+    out.pv2InVolt = deciToFloat(in.pv2InVoltDeci);
+    out.settingsChanged = in.settingsChanged;
+    out.mppt1ChrgrStatus = in.mppt1ChrgrStatus;
+    out.mppt2ChrgrStatus = in.mppt2ChrgrStatus;
+    out.loadConnection = in.loadConnection;
+    out.battPowDir = in.battPowDir;
+    out.dcACPowDir = in.dcACPowDir;
+    out.linePowDir = in.linePowDir;
+    out.localParallelId = in.localParallelId;
+  }
+}
@@ -40,6 +40,245 @@ namespace INFI {
     BYTE linePowDir;
     BYTE localParallelId;
   };
+
+  /*! The one schema of GS: every field in the order of the reply, which is also the order of GS_FIELD and
+   * writeGeneralStatusJson(). The enum, the key and kind tables, the getters and setters, the JSON writer,
+   * the reply decoder and the offsets of GeneralStatusView are all expanded from it, so a field is added
+   * or changed here and nowhere else. Every row is
+   *   X(field, member of GeneralStatusFixed, JSON key, short JSON key, digits in the reply, JSON_FIELD_KIND, bits of member)
+   * GeneralStatusFixed itself stays written out, its layout is stored in NVS, RTC memory and the offline log
+   * and must not move with the order here, but every member is used by the expansions.
+   */
+#define INFI_GS_SCHEMA(X) \
+    X(GS_GRID_VOLT,           gridVoltDeci,      "gridVolt",          "gv",   4, JSON_DECI, 16) \
+    X(GS_GRID_FREQ,           gridFreqDeci,      "gridFreq",          "gf",   3, JSON_DECI, 16) \
+    X(GS_AC_OUT_VOLT,         acOutVoltDeci,     "acOutVolt",         "aov",  4, JSON_DECI, 16) \
+    X(GS_AC_OUT_FREQ,         acOutFreqDeci,     "acOutFreq",         "aof",  3, JSON_DECI, 16) \
+    X(GS_AC_OUT_APPARENT_POW, acOutApparentPow,  "acOutApparentPow",  "ova",  4, JSON_UINT, 16) \
+    X(GS_AC_OUT_ACTIVE_POW,   acOutActivePow,    "acOutActivePow",    "ovw",  4, JSON_UINT, 16) \
+    X(GS_OUT_LOAD_PCT,        outLoadPct,        "outLoadPct",        "olp",  3, JSON_UINT,  8) \
+    X(GS_BATT_VOLT,           battVoltDeci,      "battVolt",          "bv",   3, JSON_DECI, 16) \
+    X(GS_BATT_VOLT_SCC,       battVoltSCCDeci,   "battVoltSCC",       "bvs",  3, JSON_DECI, 16) \
+    X(GS_BATT_VOLT_SCC2,      battVoltSCC2Deci,  "battVoltSCC2",      "bvs2", 3, JSON_DECI, 16) \
+    X(GS_BATT_DISCHARGE_CURR, battDischargeCurr, "battDischargeCurr", "bdc",  3, JSON_UINT, 16) \
+    X(GS_BATT_CHARGE_CURR,    battChargeCurr,    "battChargeCurr",    "bcc",  3, JSON_UINT, 16) \
+    X(GS_BATT_CAPACITY,       battCapacity,      "battCapacity",      "bcp",  3, JSON_UINT,  8) \
+    X(GS_INV_HEAT_SINK_TEMP,  invHeatSinkTemp,   "invHeatSinkTemp",   "iht",  3, JSON_UINT,  8) \
+    X(GS_MPPT1_CHRGR_TEMP,    mppt1ChrgrTemp,    "mppt1ChrgrTemp",    "m1t",  3, JSON_UINT,  8) \
+    X(GS_MPPT2_CHRGR_TEMP,    mppt2ChrgrTemp,    "mppt2ChrgrTemp",    "m2t",  3, JSON_UINT,  8) \
+    X(GS_PV1_IN_POW,          pv1InPow,          "pv1InPow",          "p1w",  4, JSON_UINT, 16) \
+    X(GS_PV2_IN_POW,          pv2InPow,          "pv2InPow",          "p2w",  4, JSON_UINT, 16) \
+    X(GS_PV1_IN_VOLT,         pv1InVoltDeci,     "pv1InVolt",         "p1v",  4, JSON_DECI, 16) \
+    X(GS_PV2_IN_VOLT,         pv2InVoltDeci,     "pv2InVolt",         "p2v",  4, JSON_DECI, 16) \
+    X(GS_SETTINGS_CHANGED,    settingsChanged,   "settingsChanged",   "sc",   1, JSON_UINT,  1) \
+    X(GS_MPPT1_CHRGR_STATUS,  mppt1ChrgrStatus,  "mppt1ChrgrStatus",  "m1s",  1, JSON_UINT,  2) \
+    X(GS_MPPT2_CHRGR_STATUS,  mppt2ChrgrStatus,  "mppt2ChrgrStatus",  "m2s",  1, JSON_UINT,  2) \
+    X(GS_LOAD_CONNECTION,     loadConnection,    "loadConnection",    "lc",   1, JSON_BOOL,  1) \
+    X(GS_BATT_POW_DIR,        battPowDir,        "battPowDir",        "bpd",  1, JSON_UINT,  2) \
+    X(GS_DC_AC_POW_DIR,       dcACPowDir,        "dcACPowDir",        "dpd",  1, JSON_UINT,  2) \
+    X(GS_LINE_POW_DIR,        linePowDir,        "linePowDir",        "lpd",  1, JSON_UINT,  2) \
+    X(GS_LOCAL_PARALLEL_ID,   localParallelId,   "localParallelId",   "lpi",  1, JSON_UINT,  4)
+
+#define INFI_GS_ENUM(field, member, key, shortKey, width, kind, bits) field,
+
+  //! The fields of GeneralStatusFixed, in the order writeGeneralStatusJson() writes them.
+  enum GS_FIELD {
+    INFI_GS_SCHEMA(INFI_GS_ENUM)
+    NUM_GS_FIELDS // Not a field, the number of entries above.
+  };
+
+  //! A set of GS fields, bit i for GS_FIELD i.
+  typedef unsigned long GsFieldMask;
+  const GsFieldMask GS_ALL_FIELDS = (1UL << NUM_GS_FIELDS) - 1;
+
+  /*!
+   * The same GS data, kept in the units the inverter sends, so decoding needs no float math.
+   * Fields ending in Deci are in 0.1 V or 0.1 Hz. The single digit fields are packed into bitfields,
+   * so the struct is about half the size of GeneralStatus. This is what storage and uplink code should use,
+   * the float helpers below are for display.
+   */
+  struct GeneralStatusFixed {
+    WORD gridVoltDeci;
+    WORD gridFreqDeci;
+    WORD acOutVoltDeci;
+    WORD acOutFreqDeci;
+    WORD acOutApparentPow;
+    WORD acOutActivePow;
+    WORD battVoltDeci;
+    WORD battVoltSCCDeci;
+    WORD battVoltSCC2Deci;
+    WORD battDischargeCurr;
+    WORD battChargeCurr;
+    WORD pv1InPow;
+    WORD pv2InPow;
+    WORD pv1InVoltDeci;
+    WORD pv2InVoltDeci;
+    BYTE outLoadPct;
+    BYTE battCapacity;
+    BYTE invHeatSinkTemp;
+    BYTE mppt1ChrgrTemp;
+    BYTE mppt2ChrgrTemp;
+    BYTE settingsChanged : 1; // setting value configuration state
+    BYTE loadConnection : 1;
+    BYTE mppt1ChrgrStatus : 2;
+    BYTE mppt2ChrgrStatus : 2;
+    BYTE battPowDir : 2;
+    BYTE dcACPowDir : 2;
+    BYTE linePowDir : 2;
+    BYTE localParallelId : 4;
+  };
+
+  //! PIRI, the rated information. Fields ending in Deci are in 0.1 V, 0.1 Hz or 0.1 A.
+  struct RatedInformation {
+    WORD acInVoltDeci;
+    WORD acInFreqDeci;
+    WORD acInCurrDeci;
+    WORD acOutVoltDeci;
+    WORD acOutFreqDeci;
+    WORD acOutCurrDeci;
+    WORD acOutApparentPow;
+    WORD acOutActivePow;
+    WORD battVoltDeci;
+    WORD battRechargeVoltDeci;
+    WORD battRedischargeVoltDeci;
+    WORD battUnderVoltDeci;
+    WORD battBulkVoltDeci;
+    WORD maxChargingCurr;
+    BYTE battType;
+    BYTE maxACChargingCurr;
+    BYTE inVoltRange;
+    BYTE outSourcePriority;
+    BYTE chargerSourcePriority;
+    BYTE parallelMaxNum;
+    BYTE machineType;
+    BYTE topology;
+    BYTE outModel;
+    BYTE solarPowerPriority;
+    BYTE mpptString;
+  };
+
+  //! FWS, the fault code and the warning flags.
+  struct FaultWarningStatus {
+    BYTE faultCode;
+    bool lineFail;
+    bool outCircuitShort;
+    bool invOverTemp;
+    bool fanLocked;
+    bool battVoltHigh;
+    bool battLow;
+    bool battUnder;
+    bool overLoad;
+    bool eepromFail;
+    bool powLimit;
+    bool pv1VoltHigh;
+    bool pv2VoltHigh;
+    bool mppt1Overload;
+    bool mppt2Overload;
+    bool battTooLowToChargeSCC1;
+    bool battTooLowToChargeSCC2;
+  };
+
+  //! The warning flags of FaultWarningStatus.
+  const BYTE FWS_FLAGS = 16;
+
+  //! The FWS warning flags as a bit mask, bit i set for the i-th flag in struct order, lineFail in bit 0.
+  WORD getFaultWarningFlags(const FaultWarningStatus &fws);
+
+  //! FLAG, the enable/disable switches, in the order of the Pmn command's n codes A to I.
+  struct EnableDisableStatus {
+    bool buzzer;
+    bool overloadBypass;
+    bool lcdEscape;
+    bool overloadRestart;
+    bool overTempRestart;
+    bool backlight;
+    bool primarySourceInterruptAlarm;
+    bool faultCodeRecord;
+    bool gridTie;
+  };
+
+  //! DI, the default settings. Fields ending in Deci are in 0.1 V or 0.1 Hz.
+  struct DefaultValues {
+    WORD acOutVoltDeci;
+    WORD acOutFreqDeci;
+    WORD battUnderVoltDeci;
+    WORD battFloatVoltDeci;
+    WORD battBulkVoltDeci;
+    WORD battRechargeVoltDeci;
+    WORD battRedischargeVoltDeci;
+    WORD maxChargingCurr;
+    BYTE maxACChargingCurr;
+    BYTE acInVoltRange;
+    BYTE battType;
+    BYTE outSourcePriority;
+    BYTE chargerSourcePriority;
+    BYTE solarPowerPriority;
+    BYTE machineType;
+    BYTE outModel;
+    EnableDisableStatus flags;
+  };
+
+  //! The most values MCHGCR lists.
+  const BYTE MAX_CHARGING_CURRENTS_SZ = 14;
+
+  //! MCHGCR or MUCHGCR, the currents in A that the SET_MAX_*_CHARGING_CURRENT commands accept.
+  struct ChargingCurrents {
+    BYTE count;
+    WORD values[MAX_CHARGING_CURRENTS_SZ];
+  };
+
+  //! The most chars of a series number ID reports.
+  const BYTE SERIES_NUMBER_SZ = 20;
+
+  //! What PI, ID and VFW report about the inverter itself. Each of their decoders fills its own fields.
+  struct DeviceInfo {
+    //! PI, 18 for this protocol.
+    BYTE protocolId;
+    //! ID, just the valid chars, null terminated.
+    char seriesNumber[SERIES_NUMBER_SZ + 1];
+    //! VFW, the firmware versions of the main and the two slave CPUs.
+    unsigned long mainCpuVersion;
+    unsigned long slave1CpuVersion;
+    unsigned long slave2CpuVersion;
+  };
+
+  //! The modes MOD reports.
+  enum WORKING_MODE {
+    MODE_POWER_ON = 0,
+    MODE_STANDBY,
+    MODE_BYPASS,
+    MODE_BATTERY,
+    MODE_FAULT,
+    MODE_HYBRID,  // Line mode, or grid mode with grid tie on.
+    NUM_WORKING_MODES
+  };
+
+  /*!
+   * Any decoded reply, what InfiniResponseParser::decode() fills. cmdType says which member holds it:
+   * unixTime for T, energy for ET, EY, EM and ED, workingMode for MOD, and for PI, ID and VFW only their
+   * fields of info, the rest 0. An UPDATE's ^1 carries nothing.
+   */
+  struct InfiniDecoded {
+    COMMAND_TYPE cmdType;
+    union {
+      unsigned long unixTime;
+      unsigned long energy;
+      GeneralStatusFixed gs;
+      RatedInformation piri;
+      FaultWarningStatus fws;
+      EnableDisableStatus flag;
+      DefaultValues di;
+      ChargingCurrents currents;
+      DeviceInfo info;
+      BYTE workingMode;
+    };
+  };
+
+  //! A 0.1 unit reading as a float, for display only.
+  float deciToFloat(WORD deci);
+
+  //! Fills the float GeneralStatus from the fixed point one.
+  void toGeneralStatus(const GeneralStatusFixed &in, GeneralStatus &out);
   
 }
 
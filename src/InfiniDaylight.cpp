@@ -0,0 +1,64 @@
+#include "InfiniDaylight.h"
+
+#if INFI_MODULE_SCHEDULER
+
+namespace INFI {
+
+  static const long SECONDS_PER_DAY = 86400L;
+
+  InfiniDaylight::InfiniDaylight(unsigned long darkMs, long dawnS) :
+    m_darkMs(darkMs),
+    m_dawnS(dawnS),
+    m_darkSinceMs(0),
+    m_dark(false),
+    m_darkLong(false),
+    m_night(false),
+    m_sunrise(NO_TIME_OF_DAY)
+  {}
+
+  bool InfiniDaylight::isDark(const GeneralStatusFixed &gs) {
+    return gs.pv1InPow == 0 && gs.pv2InPow == 0 && gs.pv1InVoltDeci == 0 &&
+           gs.mppt1ChrgrStatus == NormalNotCharged && gs.mppt2ChrgrStatus != Charging;
+  }
+
+  bool InfiniDaylight::update(const GeneralStatusFixed &gs, unsigned long nowMs, long secondOfDay) {
+    const bool before = m_night;
+    if (!isDark(gs)) {
+      if (m_darkLong && secondOfDay != NO_TIME_OF_DAY) {
+        m_sunrise = secondOfDay;
+      }
+      m_dark = false;
+      m_darkLong = false;
+      m_night = false;
+    } else {
+      if (!m_dark) {
+        m_dark = true;
+        m_darkSinceMs = nowMs;
+      }
+      if (nowMs - m_darkSinceMs >= m_darkMs) {
+        m_darkLong = true;
+      }
+      // Still dark well past the usual sunrise, e.g. overcast, goes back to night until the PV shows.
+      m_night = m_darkLong && !isDawn(secondOfDay);
+    }
+    return m_night != before;
+  }
+
+  bool InfiniDaylight::isNight() const {
+    return m_night;
+  }
+
+  long InfiniDaylight::sunrise() const {
+    return m_sunrise;
+  }
+
+  bool InfiniDaylight::isDawn(long secondOfDay) const {
+    if (m_sunrise == NO_TIME_OF_DAY || secondOfDay == NO_TIME_OF_DAY) {
+      return false;
+    }
+    long untilSunrise = ((m_sunrise - secondOfDay) % SECONDS_PER_DAY + SECONDS_PER_DAY) % SECONDS_PER_DAY;
+    long sinceSunrise = (SECONDS_PER_DAY - untilSunrise) % SECONDS_PER_DAY;
+    return untilSunrise <= m_dawnS || sinceSunrise <= m_dawnS;
+  }
+}
+#endif
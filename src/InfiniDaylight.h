@@ -0,0 +1,61 @@
+#ifndef INFINI_DAYLIGHT_H
+#define INFINI_DAYLIGHT_H
+
+#include "InfiniDataTypes.h"
+
+// How long PV has to read dark before it is taken for night, milliseconds. Longer than a passing cloud.
+#ifndef INFI_DAYLIGHT_DARK_MS
+#define INFI_DAYLIGHT_DARK_MS 900000UL
+#endif
+
+// How far either side of the sunrise learnt the day before night mode is held off, seconds.
+#ifndef INFI_DAYLIGHT_DAWN_S
+#define INFI_DAYLIGHT_DAWN_S 1800
+#endif
+
+namespace INFI {
+
+  const unsigned long DAYLIGHT_DARK_MS = INFI_DAYLIGHT_DARK_MS;
+  const long DAYLIGHT_DAWN_S = INFI_DAYLIGHT_DAWN_S;
+  //! A time of day that is not known, e.g. before the inverter clock was read.
+  const long NO_TIME_OF_DAY = -1;
+
+  /*!
+   * Tells night from day from the GS samples, for InfiniPollScheduler::setNight(). It is night once the PV has
+   * read dark for DAYLIGHT_DARK_MS, and day again with the first sample that is not dark. Given the inverter's
+   * time of day, it also learns when PV came back after the last night, and holds night mode off from
+   * DAYLIGHT_DAWN_S before that time, so the first light of the morning is sampled at the day rate.
+   */
+  class InfiniDaylight {
+    public:
+    InfiniDaylight(unsigned long darkMs = DAYLIGHT_DARK_MS, long dawnS = DAYLIGHT_DAWN_S);
+
+    //! No PV power or voltage on the first string, and MPPT1 idle without a fault.
+    static bool isDark(const GeneralStatusFixed &gs);
+
+    /*! Takes the GS sample read at nowMs. secondOfDay is the inverter's local time of it, seconds since midnight,
+     * or NO_TIME_OF_DAY. Returns true if isNight() changed.
+     */
+    bool update(const GeneralStatusFixed &gs, unsigned long nowMs, long secondOfDay = NO_TIME_OF_DAY);
+
+    bool isNight() const;
+
+    //! Time of day PV came back after the last night, NO_TIME_OF_DAY until it was seen once.
+    long sunrise() const;
+
+    private:
+    //! Whether secondOfDay is within DAYLIGHT_DAWN_S of sunrise().
+    bool isDawn(long secondOfDay) const;
+
+    unsigned long m_darkMs;
+    long m_dawnS;
+    unsigned long m_darkSinceMs;
+    bool m_dark;
+    //! Dark for m_darkMs, so the next light is a sunrise.
+    bool m_darkLong;
+    bool m_night;
+    long m_sunrise;
+  };
+}
+
+#endif
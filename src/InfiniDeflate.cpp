@@ -0,0 +1,281 @@
+#include "InfiniDeflate.h"
+
+#if INFI_MODULE_BINARY
+#include <string.h>
+
+namespace INFI {
+
+  static const WORD MIN_MATCH = 3;
+  static const WORD MAX_MATCH = 258;
+
+  //! Bases and extra bits of the length symbols 257 to 285.
+  static const WORD LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+  };
+  static const BYTE LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+  };
+  //! Bases and extra bits of the distance codes 0 to 29.
+  static const WORD DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+  };
+  static const BYTE DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+  };
+
+  //! CRC-32 of gzip, reflected 0xEDB88320, a nibble at a time.
+  static const uint32_t CRC32_NIBBLE[16] = {
+    0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL, 0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+    0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL, 0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+  };
+  static const uint32_t ADLER_MOD = 65521UL;
+
+  static_assert((DEFLATE_WINDOW_SZ & (DEFLATE_WINDOW_SZ - 1)) == 0 && DEFLATE_WINDOW_SZ >= 512
+                && DEFLATE_WINDOW_SZ <= 32768, "INFI_DEFLATE_WINDOW_SZ must be a power of 2 from 512 to 32768");
+
+  InfiniDeflatePrint::InfiniDeflatePrint(Print &out, DEFLATE_FORMAT format) :
+    m_out(out),
+    m_format(format)
+  {
+    begin();
+  }
+
+  void InfiniDeflatePrint::begin() {
+    for (WORD h = 0; h < HASH_SZ; ++h) {
+      m_head[h] = NO_POS;
+    }
+    m_pos = 0;
+    m_end = 0;
+    m_bits = 0;
+    m_bitCount = 0;
+    m_check = m_format == DEFLATE_GZIP ? 0xFFFFFFFFUL : 1;
+    m_adler2 = 0;
+    m_in = 0;
+    m_outBytes = 0;
+    m_error = false;
+    m_finished = false;
+
+    if (m_format == DEFLATE_GZIP) {
+      // ID1 ID2, deflate, no flags, no mtime, no extra flags, unknown OS.
+      static const BYTE GZIP_HEADER[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+      for (BYTE i = 0; i < sizeof(GZIP_HEADER); ++i) {
+        putByte(GZIP_HEADER[i]);
+      }
+    } else if (m_format == DEFLATE_ZLIB) {
+      // Deflate with a 32 kB window, fastest level, which FCHECK makes a multiple of 31.
+      putByte(0x78);
+      putByte(0x01);
+    }
+    // One fixed Huffman block for the whole stream, not the last one: finish() adds an empty last block.
+    putBits(0, 1);
+    putBits(1, 2);
+  }
+
+  size_t InfiniDeflatePrint::write(uint8_t c) {
+    return write(&c, 1);
+  }
+
+  size_t InfiniDeflatePrint::write(const uint8_t *buffer, size_t size) {
+    if (m_finished) {
+      return 0;
+    }
+    for (size_t i = 0; i < size; ++i) {
+      BYTE b = buffer[i];
+      if (m_format == DEFLATE_GZIP) {
+        m_check ^= b;
+        m_check = (m_check >> 4) ^ CRC32_NIBBLE[m_check & 0x0F];
+        m_check = (m_check >> 4) ^ CRC32_NIBBLE[m_check & 0x0F];
+      } else if (m_format == DEFLATE_ZLIB) {
+        m_check = (m_check + b) % ADLER_MOD;
+        m_adler2 = (m_adler2 + m_check) % ADLER_MOD;
+      }
+      if (m_end == BUFFER_SZ) {
+        slide();
+      }
+      m_buffer[m_end++] = b;
+      // A match may reach MAX_MATCH ahead, encode only once that much is buffered.
+      if (m_end - m_pos >= MAX_MATCH) {
+        compress(MAX_MATCH);
+      }
+    }
+    m_in += size;
+    return size;
+  }
+
+  bool InfiniDeflatePrint::finish() {
+    if (!m_finished) {
+      compress(1);
+      // End of the fixed block, then an empty last one.
+      putSymbol(256);
+      putBits(1, 1);
+      putBits(1, 2);
+      putSymbol(256);
+      alignToByte();
+      if (m_format == DEFLATE_GZIP) {
+        uint32_t crc = ~m_check;
+        for (BYTE i = 0; i < 4; ++i) {
+          putByte(crc >> (8 * i));
+        }
+        for (BYTE i = 0; i < 4; ++i) {
+          putByte(m_in >> (8 * i));
+        }
+      } else if (m_format == DEFLATE_ZLIB) {
+        uint32_t adler = (m_adler2 << 16) | m_check;
+        for (BYTE i = 0; i < 4; ++i) {
+          putByte(adler >> (24 - 8 * i));
+        }
+      }
+      m_finished = true;
+    }
+    return !m_error;
+  }
+
+  unsigned long InfiniDeflatePrint::bytesIn() const {
+    return m_in;
+  }
+
+  unsigned long InfiniDeflatePrint::bytesOut() const {
+    return m_outBytes;
+  }
+
+  void InfiniDeflatePrint::compress(WORD lookahead) {
+    while (m_end - m_pos >= lookahead) {
+      Pos avail = m_end - m_pos;
+      WORD maxLen = avail < MAX_MATCH ? avail : MAX_MATCH;
+      WORD dist = 0;
+      WORD length = maxLen >= MIN_MATCH ? findMatch(maxLen, dist) : 0;
+      if (length >= MIN_MATCH) {
+        putMatch(length, dist);
+      } else {
+        putLiteral(m_buffer[m_pos]);
+        length = 1;
+      }
+      for (WORD i = 0; i < length; ++i) {
+        if (m_end - m_pos >= MIN_MATCH) {
+          insertHash(m_pos);
+        }
+        m_pos++;
+      }
+    }
+  }
+
+  void InfiniDeflatePrint::slide() {
+    // m_pos is within MAX_MATCH of the end, so the newer half holds it and a whole window before it.
+    memmove(m_buffer, m_buffer + DEFLATE_WINDOW_SZ, DEFLATE_WINDOW_SZ);
+    memmove(m_prev, m_prev + DEFLATE_WINDOW_SZ, DEFLATE_WINDOW_SZ * sizeof(m_prev[0]));
+    for (WORD h = 0; h < HASH_SZ; ++h) {
+      m_head[h] = m_head[h] != NO_POS && m_head[h] >= DEFLATE_WINDOW_SZ ? m_head[h] - DEFLATE_WINDOW_SZ : NO_POS;
+    }
+    for (WORD p = 0; p < DEFLATE_WINDOW_SZ; ++p) {
+      m_prev[p] = m_prev[p] != NO_POS && m_prev[p] >= DEFLATE_WINDOW_SZ ? m_prev[p] - DEFLATE_WINDOW_SZ : NO_POS;
+    }
+    m_pos -= DEFLATE_WINDOW_SZ;
+    m_end -= DEFLATE_WINDOW_SZ;
+  }
+
+  WORD InfiniDeflatePrint::hashAt(Pos pos) const {
+    uint32_t h = ((uint32_t)m_buffer[pos] << 16) | ((uint32_t)m_buffer[pos + 1] << 8) | m_buffer[pos + 2];
+    return (WORD)((h * 2654435761UL) >> (32 - DEFLATE_HASH_BITS)) & (HASH_SZ - 1);
+  }
+
+  void InfiniDeflatePrint::insertHash(Pos pos) {
+    WORD h = hashAt(pos);
+    m_prev[pos] = m_head[h];
+    m_head[h] = pos;
+  }
+
+  WORD InfiniDeflatePrint::findMatch(WORD maxLen, WORD &dist) const {
+    WORD best = 0;
+    Pos candidate = m_head[hashAt(m_pos)];
+    for (BYTE tries = 0; candidate != NO_POS && tries < DEFLATE_MAX_CHAIN; ++tries) {
+      if (candidate >= m_pos || m_pos - candidate > DEFLATE_WINDOW_SZ) {
+        break;
+      }
+      const BYTE *a = m_buffer + candidate;
+      const BYTE *b = m_buffer + m_pos;
+      // Only a candidate that beats the best so far is compared in full.
+      if (a[best] == b[best]) {
+        WORD length = 0;
+        while (length < maxLen && a[length] == b[length]) {
+          length++;
+        }
+        if (length > best) {
+          best = length;
+          dist = m_pos - candidate;
+          if (best == maxLen) {
+            break;
+          }
+        }
+      }
+      candidate = m_prev[candidate];
+    }
+    return best;
+  }
+
+  void InfiniDeflatePrint::putLiteral(BYTE literal) {
+    putSymbol(literal);
+  }
+
+  void InfiniDeflatePrint::putMatch(WORD length, WORD dist) {
+    BYTE code = 28;
+    while (LENGTH_BASE[code] > length) {
+      code--;
+    }
+    putSymbol(257 + code);
+    putBits(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+    BYTE dcode = 29;
+    while (DIST_BASE[dcode] > dist) {
+      dcode--;
+    }
+    // The fixed distance codes are all 5 bits.
+    putCode(dcode, 5);
+    putBits(dist - DIST_BASE[dcode], DIST_EXTRA[dcode]);
+  }
+
+  void InfiniDeflatePrint::putSymbol(WORD symbol) {
+    // The fixed literal/length code of RFC 1951 3.2.6.
+    if (symbol < 144) {
+      putCode(0x30 + symbol, 8);
+    } else if (symbol < 256) {
+      putCode(0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+      putCode(symbol - 256, 7);
+    } else {
+      putCode(0xC0 + symbol - 280, 8);
+    }
+  }
+
+  void InfiniDeflatePrint::putBits(uint32_t value, BYTE count) {
+    m_bits |= value << m_bitCount;
+    m_bitCount += count;
+    while (m_bitCount >= 8) {
+      putByte(m_bits & 0xFF);
+      m_bits >>= 8;
+      m_bitCount -= 8;
+    }
+  }
+
+  void InfiniDeflatePrint::putCode(uint32_t code, BYTE count) {
+    uint32_t reversed = 0;
+    for (BYTE i = 0; i < count; ++i) {
+      reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    putBits(reversed, count);
+  }
+
+  void InfiniDeflatePrint::putByte(BYTE b) {
+    if (m_out.write(b) != 1) {
+      m_error = true;
+      return;
+    }
+    m_outBytes++;
+  }
+
+  void InfiniDeflatePrint::alignToByte() {
+    if (m_bitCount > 0) {
+      putBits(0, 8 - m_bitCount);
+    }
+  }
+}
+#endif
@@ -0,0 +1,116 @@
+#ifndef INFINI_DEFLATE_H
+#define INFINI_DEFLATE_H
+
+#include <Print.h>
+#include "InfiniCommon.h"
+
+// History the compressor matches against, bytes, a power of 2 from 512 to 32768.
+// It takes 6 bytes of RAM per byte of window: the window and its lookahead, and their hash chains.
+// At 32768 it takes 10, the 64 kB buffer needs 4 byte positions.
+#ifndef INFI_DEFLATE_WINDOW_SZ
+#define INFI_DEFLATE_WINDOW_SZ 1024
+#endif
+
+// log2 of the heads of the hash chains, 2 bytes each.
+#ifndef INFI_DEFLATE_HASH_BITS
+#define INFI_DEFLATE_HASH_BITS 9
+#endif
+
+// Earlier positions with the same hash tried per byte, more compresses better and slower.
+#ifndef INFI_DEFLATE_MAX_CHAIN
+#define INFI_DEFLATE_MAX_CHAIN 16
+#endif
+
+namespace INFI {
+
+  const WORD DEFLATE_WINDOW_SZ = INFI_DEFLATE_WINDOW_SZ;
+  const BYTE DEFLATE_HASH_BITS = INFI_DEFLATE_HASH_BITS;
+  const BYTE DEFLATE_MAX_CHAIN = INFI_DEFLATE_MAX_CHAIN;
+
+  //! What InfiniDeflatePrint wraps the deflate stream in.
+  enum DEFLATE_FORMAT {
+    DEFLATE_RAW = 0, // Bare RFC 1951 blocks.
+    DEFLATE_ZLIB,    // RFC 1950, Content-Encoding: deflate.
+    DEFLATE_GZIP     // RFC 1952, Content-Encoding: gzip.
+  };
+
+  /*!
+   * Compresses whatever is printed to it into out, e.g. a telemetry array from InfiniGsHistory::writeJson()
+   * straight into HttpClient::beginChunkedBody() or an MQTT payload buffer. Repetitive JSON shrinks 4 to 8 times.
+   * LZ77 over a DEFLATE_WINDOW_SZ window with the fixed Huffman codes of deflate, so it needs no tables
+   * of its own and a constant 6 * DEFLATE_WINDOW_SZ bytes, instead of the hundreds of kB of a full zlib,
+   * or of the miniz in the ESP32 ROM. Any inflater reads it.
+   * Every payload is begin(), the writes, then finish(), which writes the end of the stream and the trailer.
+   */
+  class InfiniDeflatePrint : public Print {
+    public:
+    InfiniDeflatePrint(Print &out, DEFLATE_FORMAT format = DEFLATE_GZIP);
+
+    //! Starts a new stream into out, dropping the history of the last one. The ctor already began the first.
+    void begin();
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    /*! Compresses what is still pending, ends the stream and writes the trailer.
+     * Returns false if out refused a byte of the stream at any point, e.g. a full buffer.
+     */
+    bool finish();
+
+    //! Bytes printed to it since begin().
+    unsigned long bytesIn() const;
+    //! Bytes written to out since begin().
+    unsigned long bytesOut() const;
+
+    private:
+    //! A position in m_buffer, 4 bytes only when the buffer of the largest window needs them.
+#if INFI_DEFLATE_WINDOW_SZ > 16384
+    typedef uint32_t Pos;
+#else
+    typedef WORD Pos;
+#endif
+    static const unsigned long BUFFER_SZ = 2UL * DEFLATE_WINDOW_SZ;
+    static const WORD HASH_SZ = 1 << DEFLATE_HASH_BITS;
+    //! No position, in m_head and m_prev.
+    static const Pos NO_POS = (Pos)-1;
+
+    //! Encodes from m_pos until fewer than lookahead bytes are left.
+    void compress(WORD lookahead);
+    //! Moves the newer half of the buffer down once it is full.
+    void slide();
+    WORD hashAt(Pos pos) const;
+    void insertHash(Pos pos);
+    //! The longest earlier match for m_pos, at most maxLen, its distance in dist.
+    WORD findMatch(WORD maxLen, WORD &dist) const;
+
+    void putLiteral(BYTE literal);
+    void putMatch(WORD length, WORD dist);
+    //! Writes the Huffman code of the literal/length symbol.
+    void putSymbol(WORD symbol);
+    //! Writes count bits of value, least significant first.
+    void putBits(uint32_t value, BYTE count);
+    //! Writes the count bits of code, most significant first, as Huffman codes are.
+    void putCode(uint32_t code, BYTE count);
+    void putByte(BYTE b);
+    void alignToByte();
+
+    Print &m_out;
+    DEFLATE_FORMAT m_format;
+    BYTE m_buffer[BUFFER_SZ];
+    Pos m_head[HASH_SZ];
+    Pos m_prev[BUFFER_SZ];
+    //! Next byte to encode, and the end of what was written into m_buffer.
+    Pos m_pos;
+    Pos m_end;
+    uint32_t m_bits;
+    BYTE m_bitCount;
+    uint32_t m_check;
+    uint32_t m_adler2;
+    unsigned long m_in;
+    unsigned long m_outBytes;
+    bool m_error;
+    bool m_finished;
+  };
+}
+
+#endif
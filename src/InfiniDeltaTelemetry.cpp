@@ -0,0 +1,291 @@
+#include "InfiniDeltaTelemetry.h"
+
+#if INFI_MODULE_PARSERS
+#include <string.h>
+
+namespace INFI {
+#define INFI_GS_KEY(field, member, key, shortKey, width, kind, bits) key,
+#define INFI_GS_SHORT_KEY(field, member, key, shortKey, width, kind, bits) shortKey,
+#define INFI_GS_KIND(field, member, key, shortKey, width, kind, bits) kind,
+#define INFI_GS_GET(field, member, key, shortKey, width, kind, bits) case field: return gs.member;
+// Cut to the width of the member, 1 to 16 bits, rather than leave it to the bitfields.
+#define INFI_GS_SET(field, member, key, shortKey, width, kind, bits) case field: gs.member = value & ((1UL << bits) - 1); break;
+
+  // Keys and formats of the fields, same as writeGeneralStatusJson(), indexed by GS_FIELD. Both stay in flash on AVR.
+  static const char GS_FIELD_KEYS[NUM_GS_FIELDS][18] INFI_PROGMEM = {
+    INFI_GS_SCHEMA(INFI_GS_KEY)
+  };
+
+  static const char GS_FIELD_SHORT_KEYS[NUM_GS_FIELDS][5] INFI_PROGMEM = {
+    INFI_GS_SCHEMA(INFI_GS_SHORT_KEY)
+  };
+
+  static const BYTE GS_FIELD_KINDS[NUM_GS_FIELDS] INFI_PROGMEM = {
+    INFI_GS_SCHEMA(INFI_GS_KIND)
+  };
+
+  const char *getGeneralStatusFieldKey(GS_FIELD field) {
+    return field < NUM_GS_FIELDS ? GS_FIELD_KEYS[field] : NULL;
+  }
+
+  const char *getGeneralStatusFieldShortKey(GS_FIELD field) {
+    return field < NUM_GS_FIELDS ? GS_FIELD_SHORT_KEYS[field] : NULL;
+  }
+
+  JSON_FIELD_KIND getGeneralStatusFieldKind(GS_FIELD field) {
+    return field < NUM_GS_FIELDS ? (JSON_FIELD_KIND)INFI_READ_BYTE(&GS_FIELD_KINDS[field]) : JSON_UINT;
+  }
+
+  // The field whose key is the len chars at key.
+  static GS_FIELD findField(const char *key, size_t len) {
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      if (INFI_STRLEN_P(GS_FIELD_KEYS[i]) == len && INFI_STRNCMP_P(key, GS_FIELD_KEYS[i], len) == 0) {
+        return (GS_FIELD)i;
+      }
+    }
+    return NUM_GS_FIELDS;
+  }
+
+  GS_FIELD findGeneralStatusField(const char *key) {
+    return key != NULL ? findField(key, strlen(key)) : NUM_GS_FIELDS;
+  }
+
+  GsFieldMask parseGsFieldMask(const char *keys) {
+    GsFieldMask mask = 0;
+    while (keys != NULL && *keys != '\0') {
+      const char *end = strchr(keys, ',');
+      size_t len = end != NULL ? (size_t)(end - keys) : strlen(keys);
+      GS_FIELD field = findField(keys, len);
+      if (field < NUM_GS_FIELDS) {
+        mask |= 1UL << field;
+      }
+      keys = end != NULL ? end + 1 : NULL;
+    }
+    return mask;
+  }
+
+  long getGeneralStatusField(const GeneralStatusFixed &gs, GS_FIELD field) {
+    switch (field) {
+      INFI_GS_SCHEMA(INFI_GS_GET)
+      case NUM_GS_FIELDS: break;
+    }
+    return 0;
+  }
+
+  void setGeneralStatusField(GeneralStatusFixed &gs, GS_FIELD field, long value) {
+    switch (field) {
+      INFI_GS_SCHEMA(INFI_GS_SET)
+      case NUM_GS_FIELDS: break;
+    }
+  }
+
+#if INFI_MODULE_JSON
+  size_t writeGeneralStatusFieldsJson(const GeneralStatusFixed &gs, GsFieldMask fields, Print &out) {
+    size_t n = 0;
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      if ((fields & (1UL << i)) != 0) {
+        n += writeJsonFieldP(out, GS_FIELD_KEYS[i], getGeneralStatusField(gs, (GS_FIELD)i),
+                            (JSON_FIELD_KIND)INFI_READ_BYTE(&GS_FIELD_KINDS[i]), n == 0);
+      }
+    }
+    n += n == 0 ? out.print("{}") : out.print('}');
+    return n;
+  }
+
+  size_t writeGeneralStatusKeyMapJson(const char *key, Print &out) {
+    size_t n = out.print(INFI_F("{\""));
+    n += out.print(key);
+    n += out.print(INFI_F("\":"));
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      n += out.print(i == 0 ? '{' : ',');
+      n += out.print('"');
+      n += out.print(INFI_FLASH(GS_FIELD_SHORT_KEYS[i]));
+      n += out.print(INFI_F("\":\""));
+      n += out.print(INFI_FLASH(GS_FIELD_KEYS[i]));
+      n += out.print('"');
+    }
+    n += out.print(INFI_F("}}"));
+    return n;
+  }
+#endif
+
+  size_t writeGeneralStatusCsv(const GeneralStatusFixed &gs, uint64_t tsMs, Print &out) {
+    size_t n = printUint64(tsMs, out);
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      n += out.print(',');
+      n += out.print(getGeneralStatusField(gs, (GS_FIELD)i));
+    }
+    n += out.print('\n');
+    return n;
+  }
+
+  size_t writeGeneralStatusCsvHeader(Print &out) {
+    size_t n = out.print(INFI_F("ts"));
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      n += out.print(',');
+      n += out.print(INFI_FLASH(GS_FIELD_KEYS[i]));
+    }
+    n += out.print('\n');
+    return n;
+  }
+
+  // Copies one field of from into to, so a field within its deadband keeps its old published value.
+  static void copyGeneralStatusField(const GeneralStatusFixed &from, GeneralStatusFixed &to, GS_FIELD field) {
+    switch (field) {
+      case GS_GRID_VOLT: to.gridVoltDeci = from.gridVoltDeci; break;
+      case GS_GRID_FREQ: to.gridFreqDeci = from.gridFreqDeci; break;
+      case GS_AC_OUT_VOLT: to.acOutVoltDeci = from.acOutVoltDeci; break;
+      case GS_AC_OUT_FREQ: to.acOutFreqDeci = from.acOutFreqDeci; break;
+      case GS_AC_OUT_APPARENT_POW: to.acOutApparentPow = from.acOutApparentPow; break;
+      case GS_AC_OUT_ACTIVE_POW: to.acOutActivePow = from.acOutActivePow; break;
+      case GS_OUT_LOAD_PCT: to.outLoadPct = from.outLoadPct; break;
+      case GS_BATT_VOLT: to.battVoltDeci = from.battVoltDeci; break;
+      case GS_BATT_VOLT_SCC: to.battVoltSCCDeci = from.battVoltSCCDeci; break;
+      case GS_BATT_VOLT_SCC2: to.battVoltSCC2Deci = from.battVoltSCC2Deci; break;
+      case GS_BATT_DISCHARGE_CURR: to.battDischargeCurr = from.battDischargeCurr; break;
+      case GS_BATT_CHARGE_CURR: to.battChargeCurr = from.battChargeCurr; break;
+      case GS_BATT_CAPACITY: to.battCapacity = from.battCapacity; break;
+      case GS_INV_HEAT_SINK_TEMP: to.invHeatSinkTemp = from.invHeatSinkTemp; break;
+      case GS_MPPT1_CHRGR_TEMP: to.mppt1ChrgrTemp = from.mppt1ChrgrTemp; break;
+      case GS_MPPT2_CHRGR_TEMP: to.mppt2ChrgrTemp = from.mppt2ChrgrTemp; break;
+      case GS_PV1_IN_POW: to.pv1InPow = from.pv1InPow; break;
+      case GS_PV2_IN_POW: to.pv2InPow = from.pv2InPow; break;
+      case GS_PV1_IN_VOLT: to.pv1InVoltDeci = from.pv1InVoltDeci; break;
+      case GS_PV2_IN_VOLT: to.pv2InVoltDeci = from.pv2InVoltDeci; break;
+      case GS_SETTINGS_CHANGED: to.settingsChanged = from.settingsChanged; break;
+      case GS_MPPT1_CHRGR_STATUS: to.mppt1ChrgrStatus = from.mppt1ChrgrStatus; break;
+      case GS_MPPT2_CHRGR_STATUS: to.mppt2ChrgrStatus = from.mppt2ChrgrStatus; break;
+      case GS_LOAD_CONNECTION: to.loadConnection = from.loadConnection; break;
+      case GS_BATT_POW_DIR: to.battPowDir = from.battPowDir; break;
+      case GS_DC_AC_POW_DIR: to.dcACPowDir = from.dcACPowDir; break;
+      case GS_LINE_POW_DIR: to.linePowDir = from.linePowDir; break;
+      case GS_LOCAL_PARALLEL_ID: to.localParallelId = from.localParallelId; break;
+      case NUM_GS_FIELDS: break;
+    }
+  }
+
+  GeneralStatusDelta::GeneralStatusDelta() :
+    m_published(),
+    m_fields(GS_ALL_FIELDS),
+    m_fullSnapshotEvery(INFI_GS_FULL_SNAPSHOT_EVERY),
+    m_sinceFullSnapshot(0),
+    m_hasPublished(false),
+    m_shortKeys(false)
+  {
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      m_deadbands[i] = 0;
+    }
+  }
+
+  void GeneralStatusDelta::setDeadband(GS_FIELD field, WORD deadband) {
+    if (field < NUM_GS_FIELDS) {
+      m_deadbands[field] = deadband;
+    }
+  }
+
+  void GeneralStatusDelta::setFields(GsFieldMask fields) {
+    m_fields = fields & GS_ALL_FIELDS;
+  }
+
+  GsFieldMask GeneralStatusDelta::fields() const {
+    return m_fields;
+  }
+
+  void GeneralStatusDelta::setFullSnapshotEvery(WORD cycles) {
+    m_fullSnapshotEvery = cycles;
+  }
+
+  void GeneralStatusDelta::setShortKeys(bool shortKeys) {
+    m_shortKeys = shortKeys;
+  }
+
+  bool GeneralStatusDelta::hasShortKeys() const {
+    return m_shortKeys;
+  }
+
+  void GeneralStatusDelta::forceFullSnapshot() {
+    m_hasPublished = false;
+  }
+
+  bool GeneralStatusDelta::hasChanges(const GeneralStatusFixed &gs) const {
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      if (shouldPublish(gs, (GS_FIELD)i)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  GsFieldMask GeneralStatusDelta::changedFields(const GeneralStatusFixed &gs) const {
+    GsFieldMask fields = 0;
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      if (shouldPublish(gs, (GS_FIELD)i)) {
+        fields |= 1UL << i;
+      }
+    }
+    return fields;
+  }
+
+#if INFI_MODULE_JSON
+  size_t GeneralStatusDelta::writeJson(const GeneralStatusFixed &gs, Print &out) const {
+    size_t n = 0;
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      GS_FIELD field = (GS_FIELD)i;
+      if (shouldPublish(gs, field)) {
+        n += writeJsonFieldP(out, m_shortKeys ? GS_FIELD_SHORT_KEYS[i] : GS_FIELD_KEYS[i], getGeneralStatusField(gs, field),
+                            (JSON_FIELD_KIND)INFI_READ_BYTE(&GS_FIELD_KINDS[i]), n == 0);
+      }
+    }
+    if (n > 0) {
+      n += out.print('}');
+    }
+    return n;
+  }
+#endif
+
+  void GeneralStatusDelta::markPublished(const GeneralStatusFixed &gs) {
+    if (isFullSnapshotDue()) {
+      m_published = gs;
+      m_sinceFullSnapshot = 0;
+    } else {
+      for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+        if (shouldPublish(gs, (GS_FIELD)i)) {
+          copyGeneralStatusField(gs, m_published, (GS_FIELD)i);
+        }
+      }
+    }
+    m_sinceFullSnapshot++;
+    m_hasPublished = true;
+  }
+
+  void GeneralStatusDelta::saveState(GeneralStatusDeltaState &state) const {
+    state.published = m_published;
+    state.sinceFullSnapshot = m_sinceFullSnapshot;
+    state.hasPublished = m_hasPublished;
+  }
+
+  void GeneralStatusDelta::restoreState(const GeneralStatusDeltaState &state) {
+    m_published = state.published;
+    m_sinceFullSnapshot = state.sinceFullSnapshot;
+    m_hasPublished = state.hasPublished;
+  }
+
+  bool GeneralStatusDelta::isFullSnapshotDue() const {
+    return !m_hasPublished || (m_fullSnapshotEvery > 0 && m_sinceFullSnapshot >= m_fullSnapshotEvery);
+  }
+
+  bool GeneralStatusDelta::shouldPublish(const GeneralStatusFixed &gs, GS_FIELD field) const {
+    if ((m_fields & (1UL << field)) == 0) {
+      return false;
+    }
+    if (isFullSnapshotDue()) {
+      return true;
+    }
+    long diff = getGeneralStatusField(gs, field) - getGeneralStatusField(m_published, field);
+    if (diff < 0) {
+      diff = -diff;
+    }
+    return diff > m_deadbands[field];
+  }
+}
+#endif
@@ -0,0 +1,116 @@
+#ifndef INFINI_DELTA_TELEMETRY_H
+#define INFINI_DELTA_TELEMETRY_H
+
+#include "InfiniJsonWriter.h"
+
+// Publish every GS field at least once this many publishes, 0 to only ever send changes.
+#ifndef INFI_GS_FULL_SNAPSHOT_EVERY
+#define INFI_GS_FULL_SNAPSHOT_EVERY 30
+#endif
+
+namespace INFI {
+
+  //! The value of one field of gs, in the units it is stored in.
+  long getGeneralStatusField(const GeneralStatusFixed &gs, GS_FIELD field);
+  //! Sets one field of gs, value in the units getGeneralStatusField() returns, cut to the width of the field.
+  void setGeneralStatusField(GeneralStatusFixed &gs, GS_FIELD field, long value);
+  //! The key and format writeGeneralStatusJson() uses for field. The key is in flash on AVR, see writeJsonFieldP().
+  const char *getGeneralStatusFieldKey(GS_FIELD field);
+  //! The short key of field, e.g. "bdc" for battDischargeCurr, see GeneralStatusDelta::setShortKeys(). In flash on AVR.
+  const char *getGeneralStatusFieldShortKey(GS_FIELD field);
+  JSON_FIELD_KIND getGeneralStatusFieldKind(GS_FIELD field);
+
+  //! The field whose key is key, NUM_GS_FIELDS if none.
+  GS_FIELD findGeneralStatusField(const char *key);
+
+  /*! The mask of the GS fields named in keys, comma separated keys of writeGeneralStatusJson(),
+   * e.g. "pv1InPow,pv2InPow,battVolt". Unknown keys are ignored.
+   */
+  GsFieldMask parseGsFieldMask(const char *keys);
+
+#if INFI_MODULE_JSON
+  //! writeGeneralStatusJson() limited to the fields in the mask. Writes {} if there are none.
+  size_t writeGeneralStatusFieldsJson(const GeneralStatusFixed &gs, GsFieldMask fields, Print &out);
+
+  /*! Writes {"key":{"gv":"gridVolt",...}}, every short key with its full one, e.g. as a client attribute that
+   * a rule chain on the server expands short key payloads with.
+   */
+  size_t writeGeneralStatusKeyMapJson(const char *key, Print &out);
+#endif
+
+  /*! One CSV line, e.g. for a log on an SD card: tsMs, then every field in GS_FIELD order and in the units
+   * getGeneralStatusField() returns, ended by a newline. writeGeneralStatusCsvHeader() names the columns.
+   */
+  size_t writeGeneralStatusCsv(const GeneralStatusFixed &gs, uint64_t tsMs, Print &out);
+  size_t writeGeneralStatusCsvHeader(Print &out);
+
+  //! What GeneralStatusDelta::saveState() keeps, plain data so it can sit in ESP32 RTC memory.
+  //! The deadbands are not part of it, they are set up again on every boot.
+  struct GeneralStatusDeltaState {
+    GeneralStatusFixed published;
+    WORD sinceFullSnapshot;
+    bool hasPublished;
+  };
+
+  /*!
+   * Publishes only the GS fields that moved since they were last published.
+   * A field counts as moved once it differs from its published value by more than its deadband,
+   * so slow drift still gets through. Every fullSnapshotEvery publishes, all fields are sent.
+   * Call writeJson() to get the payload, then markPublished() once it was actually sent.
+   */
+  class GeneralStatusDelta {
+    public:
+    GeneralStatusDelta();
+
+    //! Changes to field of at most deadband are not published. In deci-units for the volt and hertz fields.
+    void setDeadband(GS_FIELD field, WORD deadband);
+
+    //! Only ever publishes the fields in the mask, also in full snapshots. All of them by default.
+    void setFields(GsFieldMask fields);
+    GsFieldMask fields() const;
+
+    //! Publish every field every cycles publishes, 0 to only ever publish changes.
+    void setFullSnapshotEvery(WORD cycles);
+
+    /*! Has writeJson() use the short keys of INFI_GS_SCHEMA, e.g. "bdc" rather than "battDischargeCurr",
+     * which takes a full snapshot from about 500 bytes to about 250. The server needs the map of
+     * writeGeneralStatusKeyMapJson() to name the fields again. Off by default.
+     */
+    void setShortKeys(bool shortKeys);
+    bool hasShortKeys() const;
+
+    //! Makes the next writeJson() write every field.
+    void forceFullSnapshot();
+
+    //! Whether writeJson() would write anything for gs.
+    bool hasChanges(const GeneralStatusFixed &gs) const;
+    //! The fields writeJson() would write for gs, e.g. to publish each on its own.
+    GsFieldMask changedFields(const GeneralStatusFixed &gs) const;
+
+#if INFI_MODULE_JSON
+    //! Writes the fields of gs that should be published, as one JSON object. Returns 0 if there are none.
+    size_t writeJson(const GeneralStatusFixed &gs, Print &out) const;
+#endif
+
+    //! Records what writeJson() wrote for gs as published.
+    void markPublished(const GeneralStatusFixed &gs);
+
+    //! Keeps what was published over a deep sleep, so the first upload after a wake is still only the changes.
+    void saveState(GeneralStatusDeltaState &state) const;
+    void restoreState(const GeneralStatusDeltaState &state);
+
+    private:
+    bool isFullSnapshotDue() const;
+    bool shouldPublish(const GeneralStatusFixed &gs, GS_FIELD field) const;
+
+    GeneralStatusFixed m_published;
+    WORD m_deadbands[NUM_GS_FIELDS];
+    GsFieldMask m_fields;
+    WORD m_fullSnapshotEvery;
+    WORD m_sinceFullSnapshot;
+    bool m_hasPublished;
+    bool m_shortKeys;
+  };
+}
+
+#endif
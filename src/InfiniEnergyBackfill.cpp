@@ -0,0 +1,204 @@
+#include "InfiniEnergyBackfill.h"
+
+#if INFI_MODULE_SCHEDULER
+#include <string.h>
+#include "InfiniCivilDate.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Preferences.h>
+#endif
+
+namespace INFI {
+
+#if defined(ARDUINO_ARCH_ESP32)
+  static const char *const BACKFILL_KEY = "state";
+#endif
+
+  static const unsigned long SECONDS_PER_DAY = 86400UL;
+
+  //! Tries of one day or month before it is skipped.
+  static const BYTE BACKFILL_TRIES = 3;
+
+  InfiniEnergyBackfill::InfiniEnergyBackfill(InfiniCommandQueue &queue, InfiniResponseParser &parser) :
+    m_queue(queue),
+    m_parser(parser),
+    m_scheduler(NULL),
+    m_device(0),
+    m_onResult(NULL),
+    m_onResultContext(NULL),
+    m_dirty(false),
+    m_pending(false),
+    m_queuedMs(0),
+    m_failures(0)
+  {
+    memset(&m_state, 0, sizeof(m_state));
+    m_state.version = ENERGY_BACKFILL_VERSION;
+  }
+
+  bool InfiniEnergyBackfill::begin(const char *today) {
+    // Midnight, as a T reply would give it.
+    char digits[TIME_SECOND_SZ + 1];
+    memcpy(digits, today, TIME_DAY_SZ);
+    memset(digits + TIME_DAY_SZ, '0', TIME_SECOND_SZ - TIME_DAY_SZ);
+    digits[TIME_SECOND_SZ] = '\0';
+    unsigned long seconds;
+    if (strlen(today) != TIME_DAY_SZ || !InfiniClock::parseSeconds(digits, seconds)) {
+      return false;
+    }
+    memset(&m_state, 0, sizeof(m_state));
+    m_state.version = ENERGY_BACKFILL_VERSION;
+    m_state.started = true;
+    m_state.daysDone = seconds < SECONDS_PER_DAY;
+    m_state.day = seconds - SECONDS_PER_DAY;
+    m_state.year = (today[0] - '0') * 1000 + (today[1] - '0') * 100 + (today[2] - '0') * 10 + (today[3] - '0');
+    m_state.month = (today[4] - '0') * 10 + (today[5] - '0');
+    if (--m_state.month == 0) {
+      m_state.month = 12;
+      m_state.year--;
+    }
+    m_state.monthsDone = m_state.year < 2000;
+    m_failures = 0;
+    m_dirty = true;
+    return true;
+  }
+
+  bool InfiniEnergyBackfill::isStarted() const {
+    return m_state.started;
+  }
+
+  bool InfiniEnergyBackfill::isDone() const {
+    return m_state.started && m_state.daysDone && m_state.monthsDone;
+  }
+
+  void InfiniEnergyBackfill::setOnResult(BackfillResult onResult, void *context) {
+    m_onResult = onResult;
+    m_onResultContext = context;
+  }
+
+  void InfiniEnergyBackfill::setScheduler(const InfiniPollScheduler *scheduler, BYTE device) {
+    m_scheduler = scheduler;
+    m_device = device;
+  }
+
+  void InfiniEnergyBackfill::loop(unsigned long nowMs) {
+    if (!m_state.started || isDone() || m_pending || nowMs - m_queuedMs < ENERGY_BACKFILL_PERIOD_MS) {
+      return;
+    }
+    char params[TIME_DAY_SZ + 1];
+    COMMAND_TYPE commandType;
+    if (!m_state.monthsDone) {
+      commandType = GEN_ENERGY_MONTH;
+      writeDigits(m_state.year, 4, params);
+      writeDigits(m_state.month, 2, params + TIME_YEAR_SZ);
+      params[TIME_MON_SZ] = '\0';
+    } else {
+      commandType = GEN_ENERGY_DAY;
+      InfiniClock::formatDay(m_state.day, params);
+    }
+    // Only into a link nobody else wants, and never while it is down.
+    if (m_scheduler != NULL ? !m_scheduler->fitsBackground(m_device, commandType)
+        : m_queue.isBusy() || !m_queue.isEmpty() || m_queue.isLinkDown()) {
+      return;
+    }
+    if (m_queue.enqueueWithPriority(PRIORITY_BACKGROUND, commandType, params, onReply, this)) {
+      m_pending = true;
+      m_queuedMs = nowMs;
+    }
+  }
+
+  void InfiniEnergyBackfill::onReply(const InfiniResponse &response, SEND_STATUS status, void *context) {
+    InfiniEnergyBackfill *self = (InfiniEnergyBackfill *)context;
+    self->m_pending = false;
+    // A reply of the walk already moved on, e.g. after a restoreState(), is dropped.
+    const COMMAND_TYPE expected = self->m_state.monthsDone ? GEN_ENERGY_DAY : GEN_ENERGY_MONTH;
+    if (response.cmdType != expected || self->isDone()) {
+      return;
+    }
+    unsigned long wh = 0;
+    if (status == SEND_COMPLETE) {
+      wh = self->m_parser.fromInfiniGenEnergyToULong(response.val, response.actualLen);
+    }
+    if (status != SEND_COMPLETE || self->m_parser.result.hasError) {
+      if (++self->m_failures < BACKFILL_TRIES) {
+        return;
+      }
+      // Skipped, without counting as empty.
+      self->advance(response.cmdType, 1);
+      return;
+    }
+    const unsigned long startS = response.cmdType == GEN_ENERGY_MONTH
+      ? InfiniClock::toSeconds(self->m_state.year, self->m_state.month, 1, 0, 0, 0) : self->m_state.day;
+    if (self->m_onResult != NULL) {
+      self->m_onResult(response.cmdType, startS, wh, self->m_onResultContext);
+    }
+    self->advance(response.cmdType, wh);
+  }
+
+  void InfiniEnergyBackfill::advance(COMMAND_TYPE commandType, unsigned long wh) {
+    m_failures = 0;
+    m_dirty = true;
+    if (commandType == GEN_ENERGY_MONTH) {
+      m_state.months++;
+      m_state.emptyMonths = wh == 0 ? m_state.emptyMonths + 1 : 0;
+      if (--m_state.month == 0) {
+        m_state.month = 12;
+        m_state.year--;
+      }
+      m_state.monthsDone = m_state.months >= ENERGY_BACKFILL_MONTHS || m_state.emptyMonths >= ENERGY_BACKFILL_EMPTY_MONTHS
+        || m_state.year < 2000;
+    } else {
+      m_state.days++;
+      m_state.emptyDays = wh == 0 ? m_state.emptyDays + 1 : 0;
+      m_state.daysDone = m_state.days >= ENERGY_BACKFILL_DAYS || m_state.emptyDays >= ENERGY_BACKFILL_EMPTY_DAYS
+        || m_state.day < SECONDS_PER_DAY;
+      m_state.day -= SECONDS_PER_DAY;
+    }
+  }
+
+  bool InfiniEnergyBackfill::isDirty() const {
+    return m_dirty;
+  }
+
+  const EnergyBackfillState &InfiniEnergyBackfill::state() const {
+    return m_state;
+  }
+
+  bool InfiniEnergyBackfill::restoreState(const EnergyBackfillState &state) {
+    if (state.version != ENERGY_BACKFILL_VERSION) {
+      return false;
+    }
+    m_state = state;
+    m_failures = 0;
+    m_dirty = false;
+    return true;
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  bool InfiniEnergyBackfill::save(const char *ns) {
+    if (!m_dirty) {
+      return true;
+    }
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) {
+      return false;
+    }
+    bool saved = prefs.putBytes(BACKFILL_KEY, &m_state, sizeof(m_state)) == sizeof(m_state);
+    prefs.end();
+    m_dirty &= !saved;
+    return saved;
+  }
+
+  bool InfiniEnergyBackfill::load(const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, true)) {
+      return false;
+    }
+    EnergyBackfillState state;
+    bool loaded = prefs.getBytesLength(BACKFILL_KEY) == sizeof(state)
+      && prefs.getBytes(BACKFILL_KEY, &state, sizeof(state)) == sizeof(state);
+    prefs.end();
+    return loaded && restoreState(state);
+  }
+#endif
+}
+#endif
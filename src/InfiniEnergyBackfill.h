@@ -0,0 +1,127 @@
+#ifndef INFINI_ENERGY_BACKFILL_H
+#define INFINI_ENERGY_BACKFILL_H
+
+#include "InfiniPollScheduler.h"
+#include "InfiniResponseParser.h"
+#include "InfiniClock.h"
+
+// Days and months a sweep walks back at most, e.g. about 3 years.
+#ifndef INFI_ENERGY_BACKFILL_DAYS
+#define INFI_ENERGY_BACKFILL_DAYS 1100
+#endif
+#ifndef INFI_ENERGY_BACKFILL_MONTHS
+#define INFI_ENERGY_BACKFILL_MONTHS 36
+#endif
+
+// Days, and months, in a row without any energy after which a sweep stops, the inverter was not installed yet.
+#ifndef INFI_ENERGY_BACKFILL_EMPTY_DAYS
+#define INFI_ENERGY_BACKFILL_EMPTY_DAYS 14
+#endif
+#ifndef INFI_ENERGY_BACKFILL_EMPTY_MONTHS
+#define INFI_ENERGY_BACKFILL_EMPTY_MONTHS 2
+#endif
+
+// Least milliseconds from one query of a sweep to the next, so it never takes the link for long.
+#ifndef INFI_ENERGY_BACKFILL_PERIOD_MS
+#define INFI_ENERGY_BACKFILL_PERIOD_MS 1000
+#endif
+
+namespace INFI {
+
+  const WORD ENERGY_BACKFILL_DAYS = INFI_ENERGY_BACKFILL_DAYS;
+  const WORD ENERGY_BACKFILL_MONTHS = INFI_ENERGY_BACKFILL_MONTHS;
+  const WORD ENERGY_BACKFILL_EMPTY_DAYS = INFI_ENERGY_BACKFILL_EMPTY_DAYS;
+  const WORD ENERGY_BACKFILL_EMPTY_MONTHS = INFI_ENERGY_BACKFILL_EMPTY_MONTHS;
+  const unsigned long ENERGY_BACKFILL_PERIOD_MS = INFI_ENERGY_BACKFILL_PERIOD_MS;
+
+  //! Bumped whenever EnergyBackfillState changes, a stored sweep of another version is not loaded.
+  const BYTE ENERGY_BACKFILL_VERSION = 1;
+
+  //! Where a sweep is, plain data so it can be stored as one blob.
+  struct EnergyBackfillState {
+    BYTE version;
+    bool started;
+    //! Midnight of the next day to query, seconds since 2000-01-01 in the inverter's time.
+    unsigned long day;
+    //! The next month to query.
+    WORD year;
+    BYTE month;
+    //! Queried so far, and without energy in a row.
+    WORD days;
+    WORD months;
+    WORD emptyDays;
+    WORD emptyMonths;
+    bool daysDone;
+    bool monthsDone;
+  };
+
+  /*! Called with the energy of a past day, for GEN_ENERGY_DAY, or month, for GEN_ENERGY_MONTH, in Wh. startS is
+   * the start of the day or month, seconds since 2000-01-01 in the inverter's time, see InfiniClock.
+   */
+  typedef void (*BackfillResult)(COMMAND_TYPE commandType, unsigned long startS, unsigned long wh, void *context);
+
+  /*!
+   * Reads the energy history an inverter kept from before it was monitored. EM and ED answer for any month and
+   * day, so a sweep walks back from the month and the day before today, the months first as there are few of
+   * them, then the days. It stops after ENERGY_BACKFILL_MONTHS and ENERGY_BACKFILL_DAYS, or where the inverter
+   * had nothing for ENERGY_BACKFILL_EMPTY_MONTHS or ENERGY_BACKFILL_EMPTY_DAYS in a row.
+   * Queries go in PRIORITY_BACKGROUND, one at a time and at most every ENERGY_BACKFILL_PERIOD_MS, only once the
+   * whole queue is idle, so a poll waits for one transaction at worst, or with setScheduler() only in the gaps
+   * its polls leave. A query without a valid reply is tried again a few times, then its day or month is skipped.
+   * On the ESP32 the progress is kept in NVS, see save() and load(), so a reboot resumes the sweep.
+   */
+  class InfiniEnergyBackfill {
+    public:
+    InfiniEnergyBackfill(InfiniCommandQueue &queue, InfiniResponseParser &parser);
+
+    /*! Starts a sweep back from the day before today, YYYYMMDD as from InfiniClock::getToday(), and the month
+     * before its month. Returns false, and leaves the sweep as it was, if today is no valid day.
+     */
+    bool begin(const char *today);
+    bool isStarted() const;
+    //! True once both walks stopped.
+    bool isDone() const;
+
+    void setOnResult(BackfillResult onResult, void *context = NULL);
+
+    //! Waits for InfiniPollScheduler::fitsBackground() on device, the one of the queue, NULL for an idle queue.
+    void setScheduler(const InfiniPollScheduler *scheduler, BYTE device = 0);
+
+    //! Queues the next query if its turn came, see the class comment. Call it from loop().
+    void loop(unsigned long nowMs);
+
+    //! True once loop() or a result changed the state since the last save() or load().
+    bool isDirty() const;
+    const EnergyBackfillState &state() const;
+    //! Resumes from state. Returns false, leaving the sweep as it was, if it is of another version.
+    bool restoreState(const EnergyBackfillState &state);
+
+#if defined(ARDUINO_ARCH_ESP32)
+    //! Keeps the progress in the NVS namespace ns, at most 15 chars. Does nothing unless isDirty().
+    bool save(const char *ns = "infi_backfill");
+    //! Resumes what save() kept. Returns false if there is none, or it is of another version.
+    bool load(const char *ns = "infi_backfill");
+#endif
+
+    private:
+    static void onReply(const InfiniResponse &response, SEND_STATUS status, void *context);
+    //! Moves past the day or month just queried, with wh of energy in it.
+    void advance(COMMAND_TYPE commandType, unsigned long wh);
+
+    InfiniCommandQueue &m_queue;
+    InfiniResponseParser &m_parser;
+    const InfiniPollScheduler *m_scheduler;
+    BYTE m_device;
+    BackfillResult m_onResult;
+    void *m_onResultContext;
+    EnergyBackfillState m_state;
+    bool m_dirty;
+    //! A query is queued or in flight.
+    bool m_pending;
+    unsigned long m_queuedMs;
+    //! Failed tries of the day or month queried.
+    BYTE m_failures;
+  };
+}
+
+#endif
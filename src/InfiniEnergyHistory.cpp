@@ -0,0 +1,247 @@
+#include "InfiniEnergyHistory.h"
+
+#if INFI_MODULE_SCHEDULER
+#include <Arduino.h>
+#include <string.h>
+#include "InfiniCRC.h"
+#include "InfiniCivilDate.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Preferences.h>
+#endif
+
+namespace INFI {
+
+#if defined(ARDUINO_ARCH_ESP32)
+  static const char *const HISTORY_KEY = "table";
+#endif
+
+  //! The NNNNNNNN of an ED, EM or EY reply.
+  static const BYTE ENERGY_DIGITS = 8;
+
+  InfiniEnergyHistory::InfiniEnergyHistory() :
+    m_today(0),
+    m_thisMonth(0),
+    m_thisYear(0),
+    m_dirty(false),
+    m_hits(0)
+  {
+    memset(&m_table, 0, sizeof(m_table));
+    m_table.version = ENERGY_HISTORY_VERSION;
+  }
+
+  bool InfiniEnergyHistory::setToday(const char *today) {
+    const WORD day = periodNumber(GEN_ENERGY_DAY, today);
+    if (day == 0) {
+      return false;
+    }
+    m_today = day;
+    m_thisMonth = periodNumber(GEN_ENERGY_MONTH, today);
+    m_thisYear = periodNumber(GEN_ENERGY_YEAR, today);
+    return true;
+  }
+
+  WORD InfiniEnergyHistory::periodNumber(COMMAND_TYPE commandType, const char *params) {
+    BYTE len;
+    switch (commandType) {
+      case GEN_ENERGY_DAY:
+        len = TIME_DAY_SZ;
+        break;
+      case GEN_ENERGY_MONTH:
+        len = TIME_MON_SZ;
+        break;
+      case GEN_ENERGY_YEAR:
+        len = TIME_YEAR_SZ;
+        break;
+      default:
+        return 0;
+    }
+    if (params == NULL || strlen(params) < len) {
+      return 0;
+    }
+    const long year = readDigits(params, TIME_YEAR_SZ);
+    const long month = len >= TIME_MON_SZ ? readDigits(params + TIME_YEAR_SZ, 2) : 1;
+    const long day = len >= TIME_DAY_SZ ? readDigits(params + TIME_MON_SZ, 2) : 1;
+    if (year < 2000 || !isValidCivil(year, month, day)) {
+      return 0;
+    }
+    switch (commandType) {
+      case GEN_ENERGY_DAY:
+        return (WORD)(daysFromCivil(year, month, day) - DAYS_TO_2000 + 1);
+      case GEN_ENERGY_MONTH:
+        return (WORD)((year - 2000) * 12 + month);
+      default:
+        return (WORD)(year - 2000 + 1);
+    }
+  }
+
+  bool InfiniEnergyHistory::slots(COMMAND_TYPE commandType, WORD *&numbers, unsigned long *&wh, WORD &size) {
+    switch (commandType) {
+      case GEN_ENERGY_DAY:
+        numbers = m_table.dayNumbers;
+        wh = m_table.dayWh;
+        size = ENERGY_HISTORY_DAYS;
+        return true;
+      case GEN_ENERGY_MONTH:
+        numbers = m_table.monthNumbers;
+        wh = m_table.monthWh;
+        size = ENERGY_HISTORY_MONTHS;
+        return true;
+      case GEN_ENERGY_YEAR:
+        numbers = m_table.yearNumbers;
+        wh = m_table.yearWh;
+        size = ENERGY_HISTORY_YEARS;
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  bool InfiniEnergyHistory::isPast(COMMAND_TYPE commandType, WORD number) const {
+    switch (commandType) {
+      case GEN_ENERGY_DAY:
+        return number < m_today;
+      case GEN_ENERGY_MONTH:
+        return number < m_thisMonth;
+      case GEN_ENERGY_YEAR:
+        return number < m_thisYear;
+      default:
+        return false;
+    }
+  }
+
+  bool InfiniEnergyHistory::store(COMMAND_TYPE commandType, const char *params, unsigned long wh) {
+    const WORD number = periodNumber(commandType, params);
+    WORD *numbers;
+    unsigned long *values;
+    WORD size;
+    if (number == 0 || !isPast(commandType, number) || !slots(commandType, numbers, values, size)) {
+      return false;
+    }
+    const WORD slot = number % size;
+    // A backfill walks back in time, it must not push out the later periods that share the slot.
+    if (numbers[slot] > number) {
+      return false;
+    }
+    if (numbers[slot] != number || values[slot] != wh) {
+      numbers[slot] = number;
+      values[slot] = wh;
+      m_dirty = true;
+    }
+    return true;
+  }
+
+  bool InfiniEnergyHistory::storeReply(COMMAND_TYPE commandType, const char *params, const InfiniResponse &response) {
+    if (response.error != RESP_OK || response.cmdType != commandType || COMMAND_DESCRIPTORS[commandType].actionType != READ ||
+        response.actualLen != getResponseSize(commandType) ||
+        COMMAND_DESCRIPTORS[commandType].respToEndSz != ENERGY_DIGITS + CRC_SZ + END_TOKEN_SZ) {
+      return false;
+    }
+    unsigned long wh = 0;
+    for (BYTE i = 0; i < ENERGY_DIGITS; ++i) {
+      const char c = response.val[START_OFFSET_SZ + i];
+      if (c < '0' || c > '9') {
+        return false;
+      }
+      wh = wh * 10 + (c - '0');
+    }
+    return store(commandType, params, wh);
+  }
+
+  bool InfiniEnergyHistory::lookup(COMMAND_TYPE commandType, const char *params, unsigned long &wh) const {
+    const WORD number = periodNumber(commandType, params);
+    WORD *numbers;
+    unsigned long *values;
+    WORD size;
+    // slots() only hands out pointers, nothing is changed through them here.
+    if (number == 0 || !isPast(commandType, number) ||
+        !const_cast<InfiniEnergyHistory *>(this)->slots(commandType, numbers, values, size) ||
+        numbers[number % size] != number) {
+      return false;
+    }
+    wh = values[number % size];
+    return true;
+  }
+
+  bool InfiniEnergyHistory::reply(COMMAND_TYPE commandType, const char *params, InfiniResponse &response) const {
+    unsigned long wh;
+    if (!lookup(commandType, params, wh)) {
+      return false;
+    }
+    m_hits++;
+    response.reset();
+    response.val[0] = '^';
+    response.val[1] = 'D';
+    writeDigits(COMMAND_DESCRIPTORS[commandType].respToEndSz, DATA_LENGTH_SZ, response.val + START_TOKEN_SZ);
+    writeDigits(wh, ENERGY_DIGITS, response.val + START_OFFSET_SZ);
+    size_t n = START_OFFSET_SZ + ENERGY_DIGITS;
+    const WORD crc = calc_crc_half((const BYTE *)response.val, (BYTE)n);
+    response.val[n++] = (char)(crc >> 8);
+    response.val[n++] = (char)(crc & 0xFF);
+    response.val[n++] = '\r';
+    response.actualLen = n;
+    response.cmdType = commandType;
+    response.error = RESP_OK;
+    response.sentUs = micros();
+    return true;
+  }
+
+  unsigned long InfiniEnergyHistory::hits() const {
+    return m_hits;
+  }
+
+  void InfiniEnergyHistory::clear() {
+    memset(&m_table, 0, sizeof(m_table));
+    m_table.version = ENERGY_HISTORY_VERSION;
+    m_dirty = true;
+  }
+
+  bool InfiniEnergyHistory::isDirty() const {
+    return m_dirty;
+  }
+
+  const EnergyHistoryTable &InfiniEnergyHistory::table() const {
+    return m_table;
+  }
+
+  bool InfiniEnergyHistory::restoreTable(const EnergyHistoryTable &table) {
+    if (table.version != ENERGY_HISTORY_VERSION) {
+      return false;
+    }
+    m_table = table;
+    m_dirty = false;
+    return true;
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  bool InfiniEnergyHistory::save(const char *ns) {
+    if (!m_dirty) {
+      return true;
+    }
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) {
+      return false;
+    }
+    bool saved = prefs.putBytes(HISTORY_KEY, &m_table, sizeof(m_table)) == sizeof(m_table);
+    prefs.end();
+    m_dirty &= !saved;
+    return saved;
+  }
+
+  bool InfiniEnergyHistory::load(const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, true)) {
+      return false;
+    }
+    // Too big for the stack of most tasks.
+    EnergyHistoryTable *table = new EnergyHistoryTable;
+    bool loaded = prefs.getBytesLength(HISTORY_KEY) == sizeof(*table)
+      && prefs.getBytes(HISTORY_KEY, table, sizeof(*table)) == sizeof(*table);
+    prefs.end();
+    loaded = loaded && restoreTable(*table);
+    delete table;
+    return loaded;
+  }
+#endif
+}
+#endif
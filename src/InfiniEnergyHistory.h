@@ -0,0 +1,108 @@
+#ifndef INFINI_ENERGY_HISTORY_H
+#define INFINI_ENERGY_HISTORY_H
+
+#include "InfiniMessageTypes.h"
+
+// Past days, months and years kept, the most recent ones win a slot, e.g. a bit over a year of days.
+#ifndef INFI_ENERGY_HISTORY_DAYS
+#define INFI_ENERGY_HISTORY_DAYS 400
+#endif
+#ifndef INFI_ENERGY_HISTORY_MONTHS
+#define INFI_ENERGY_HISTORY_MONTHS 120
+#endif
+#ifndef INFI_ENERGY_HISTORY_YEARS
+#define INFI_ENERGY_HISTORY_YEARS 20
+#endif
+
+namespace INFI {
+
+  const WORD ENERGY_HISTORY_DAYS = INFI_ENERGY_HISTORY_DAYS;
+  const WORD ENERGY_HISTORY_MONTHS = INFI_ENERGY_HISTORY_MONTHS;
+  const WORD ENERGY_HISTORY_YEARS = INFI_ENERGY_HISTORY_YEARS;
+
+  //! Bumped whenever EnergyHistoryTable changes, a stored table of another version is not loaded.
+  const BYTE ENERGY_HISTORY_VERSION = 1;
+
+  /*!
+   * The tables, plain data so they can be stored as one blob. A slot is a period's number, 0 while empty,
+   * and its energy in Wh. Days count from 2000-01-01 as 1, months from January 2000 as 1, years from 2000 as 1.
+   * Each period goes to the slot of its number modulo the table size.
+   */
+  struct EnergyHistoryTable {
+    BYTE version;
+    WORD dayNumbers[ENERGY_HISTORY_DAYS];
+    unsigned long dayWh[ENERGY_HISTORY_DAYS];
+    WORD monthNumbers[ENERGY_HISTORY_MONTHS];
+    unsigned long monthWh[ENERGY_HISTORY_MONTHS];
+    WORD yearNumbers[ENERGY_HISTORY_YEARS];
+    unsigned long yearWh[ENERGY_HISTORY_YEARS];
+  };
+
+  /*!
+   * The energy of past days, months and years, which the inverter will never report differently, so an ED, EM
+   * or EY for one of them needs no link once it was read. See InfiniCommandQueue::setEnergyHistory(), which
+   * keeps every such reply, from the polls as from InfiniEnergyBackfill, and answers those queries from here.
+   * Only periods before today, setToday(), count as past, the day, month and year still running always go to
+   * the inverter. Lookups are O(1), a slot per period. On the ESP32 the tables are kept in NVS, see save().
+   */
+  class InfiniEnergyHistory {
+    public:
+    InfiniEnergyHistory();
+
+    /*! Today, YYYYMMDD as from InfiniClock::getToday(). Nothing is kept or answered until it is known.
+     * Returns false, and keeps the day it had, if today is no valid day.
+     */
+    bool setToday(const char *today);
+
+    /*! Keeps wh for the period of commandType, GEN_ENERGY_DAY, GEN_ENERGY_MONTH or GEN_ENERGY_YEAR, with params
+     * as the query's, YYYYMMDD, YYYYMM or YYYY. Returns false if it is no past period, or the table holds a later one in its slot.
+     */
+    bool store(COMMAND_TYPE commandType, const char *params, unsigned long wh);
+    //! store() of the valid reply to a query, ignoring anything else.
+    bool storeReply(COMMAND_TYPE commandType, const char *params, const InfiniResponse &response);
+
+    //! The energy of a past period in Wh, params as for store(). False if it is not kept.
+    bool lookup(COMMAND_TYPE commandType, const char *params, unsigned long &wh) const;
+    /*! Writes the reply the inverter would send for the query into response, CRC included.
+     * Returns false, leaving response as it was, if lookup() would.
+     */
+    bool reply(COMMAND_TYPE commandType, const char *params, InfiniResponse &response) const;
+
+    //! Queries reply() answered.
+    unsigned long hits() const;
+
+    //! Empties the tables, today stays.
+    void clear();
+
+    //! True once a store() changed the tables since the last save() or load().
+    bool isDirty() const;
+    const EnergyHistoryTable &table() const;
+    //! Takes over table. Returns false, leaving the tables as they were, if it is of another version.
+    bool restoreTable(const EnergyHistoryTable &table);
+
+#if defined(ARDUINO_ARCH_ESP32)
+    //! Keeps the tables in the NVS namespace ns, at most 15 chars. Does nothing unless isDirty().
+    bool save(const char *ns = "infi_energy");
+    //! Takes over what save() kept. Returns false if there is none, or it is of another version.
+    bool load(const char *ns = "infi_energy");
+#endif
+
+    private:
+    //! The number of the period params names for commandType, see EnergyHistoryTable, or 0 if none.
+    static WORD periodNumber(COMMAND_TYPE commandType, const char *params);
+    //! The table of commandType, false for other commands.
+    bool slots(COMMAND_TYPE commandType, WORD *&numbers, unsigned long *&wh, WORD &size);
+    //! Whether the period number of commandType is over.
+    bool isPast(COMMAND_TYPE commandType, WORD number) const;
+
+    EnergyHistoryTable m_table;
+    //! The numbers of today, this month and this year, 0 until setToday().
+    WORD m_today;
+    WORD m_thisMonth;
+    WORD m_thisYear;
+    bool m_dirty;
+    mutable unsigned long m_hits;
+  };
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include "InfiniEnergyTracker.h"
+
+#if INFI_MODULE_PARSERS
+#include <string.h>
+
+namespace INFI {
+  InfiniEnergyTracker::InfiniEnergyTracker() {
+    reset();
+  }
+
+  BYTE InfiniEnergyTracker::onCurrentDay(const char *day) {
+    if (!m_hasDate || strncmp(m_date, day, TIME_DAY_SZ) != 0) {
+      // Re-baseline once a day, this also covers the month and year rollovers.
+      memcpy(m_date, day, TIME_DAY_SZ);
+      m_hasDate = true;
+      m_hasYear = false;
+      m_hasMonth = false;
+      m_hasDay = false;
+      m_dayIsBase = false;
+    }
+    BYTE queries = ENERGY_QUERY_NONE;
+    if (!m_hasYear) {
+      queries |= ENERGY_QUERY_YEAR;
+    }
+    if (!m_hasMonth) {
+      queries |= ENERGY_QUERY_MONTH;
+    }
+    return queries;
+  }
+
+  void InfiniEnergyTracker::onYear(unsigned long wh) {
+    m_year = wh;
+    m_hasYear = true;
+    // The baseline already holds today's energy so far, integrate from the next ED on.
+    m_dayIsBase = false;
+  }
+
+  void InfiniEnergyTracker::onMonth(unsigned long wh) {
+    m_month = wh;
+    m_hasMonth = true;
+    m_dayIsBase = false;
+  }
+
+  void InfiniEnergyTracker::onDay(unsigned long wh) {
+    // The counter only grows within a day, anything else is not integrated.
+    if (m_dayIsBase && wh > m_day) {
+      const unsigned long delta = wh - m_day;
+      m_year += delta;
+      m_month += delta;
+    }
+    m_day = wh;
+    m_hasDay = true;
+    m_dayIsBase = true;
+  }
+
+  bool InfiniEnergyTracker::hasYear() const {
+    return m_hasYear;
+  }
+
+  bool InfiniEnergyTracker::hasMonth() const {
+    return m_hasMonth;
+  }
+
+  bool InfiniEnergyTracker::hasDay() const {
+    return m_hasDay;
+  }
+
+  unsigned long InfiniEnergyTracker::year() const {
+    return m_year;
+  }
+
+  unsigned long InfiniEnergyTracker::month() const {
+    return m_month;
+  }
+
+  unsigned long InfiniEnergyTracker::day() const {
+    return m_day;
+  }
+
+  void InfiniEnergyTracker::reset() {
+    memset(m_date, 0, sizeof(m_date));
+    m_hasDate = false;
+    m_hasYear = false;
+    m_hasMonth = false;
+    m_hasDay = false;
+    m_dayIsBase = false;
+    m_year = 0;
+    m_month = 0;
+    m_day = 0;
+  }
+
+  void InfiniEnergyTracker::saveState(EnergyTrackerState &state) const {
+    memcpy(state.date, m_date, TIME_DAY_SZ);
+    state.hasDate = m_hasDate;
+    state.hasYear = m_hasYear;
+    state.hasMonth = m_hasMonth;
+    state.hasDay = m_hasDay;
+    state.dayIsBase = m_dayIsBase;
+    state.year = m_year;
+    state.month = m_month;
+    state.day = m_day;
+  }
+
+  void InfiniEnergyTracker::restoreState(const EnergyTrackerState &state) {
+    memcpy(m_date, state.date, TIME_DAY_SZ);
+    m_hasDate = state.hasDate;
+    m_hasYear = state.hasYear;
+    m_hasMonth = state.hasMonth;
+    m_hasDay = state.hasDay;
+    m_dayIsBase = state.dayIsBase;
+    m_year = state.year;
+    m_month = state.month;
+    m_day = state.day;
+  }
+}
+#endif
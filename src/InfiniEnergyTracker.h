@@ -0,0 +1,82 @@
+#ifndef INFINI_ENERGY_TRACKER_H
+#define INFINI_ENERGY_TRACKER_H
+
+#include "InfiniCommon.h"
+
+namespace INFI {
+
+  //! Which energy counters have to be queried from the inverter, as a bit mask.
+  enum ENERGY_QUERY {
+    ENERGY_QUERY_NONE = 0,
+    ENERGY_QUERY_YEAR = 1,   // EY
+    ENERGY_QUERY_MONTH = 2   // EM
+  };
+
+  //! What InfiniEnergyTracker::saveState() keeps, plain data so it can sit in ESP32 RTC memory.
+  struct EnergyTrackerState {
+    char date[TIME_DAY_SZ];
+    bool hasDate;
+    bool hasYear;
+    bool hasMonth;
+    bool hasDay;
+    bool dayIsBase;
+    unsigned long year;
+    unsigned long month;
+    unsigned long day;
+  };
+
+  /*!
+   * Keeps the yearly and monthly generated energy up to date from the daily counter,
+   * so only T and ED have to be polled every cycle.
+   * EY and EM are queried once per inverter day, and after a reboot, to get a baseline.
+   * From then on every increase of ED is added to both. Query ED right after EY and EM:
+   * what is produced between their replies is missed, until the next day re-baselines.
+   */
+  class InfiniEnergyTracker {
+    public:
+    InfiniEnergyTracker();
+
+    /*! Feeds the inverter's day, YYYYMMDD as from fromILCurrentTimeToILCurrentDay().
+     * A new day drops the baselines. Returns the ENERGY_QUERY bits of the counters to query,
+     * which stay set until their reply was fed in.
+     */
+    BYTE onCurrentDay(const char *day);
+
+    //! Feed the EY, EM and ED replies, in Wh.
+    void onYear(unsigned long wh);
+    void onMonth(unsigned long wh);
+    void onDay(unsigned long wh);
+
+    bool hasYear() const;
+    bool hasMonth() const;
+    bool hasDay() const;
+
+    //! The counters in Wh, only meaningful while the matching has*() is true.
+    unsigned long year() const;
+    unsigned long month() const;
+    unsigned long day() const;
+
+    //! Drops everything, as after a reboot.
+    void reset();
+
+    /*! Keeps the baselines over a deep sleep, so EY and EM are not queried again on every wake.
+     * What ED gained while asleep is integrated by the first onDay() after the wake.
+     */
+    void saveState(EnergyTrackerState &state) const;
+    void restoreState(const EnergyTrackerState &state);
+
+    private:
+    char m_date[TIME_DAY_SZ];
+    bool m_hasDate;
+    bool m_hasYear;
+    bool m_hasMonth;
+    bool m_hasDay;
+    //! Whether m_day was read after the baselines, so increases from it can be integrated.
+    bool m_dayIsBase;
+    unsigned long m_year;
+    unsigned long m_month;
+    unsigned long m_day;
+  };
+}
+
+#endif
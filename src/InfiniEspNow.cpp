@@ -0,0 +1,298 @@
+#include "InfiniEspNow.h"
+
+#if INFI_MODULE_SINKS
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <esp_idf_version.h>
+#include <string.h>
+#include "InfiniIdle.h"
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+
+  static const BYTE BROADCAST_MAC[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+  // ESP-NOW has a single receive callback, so a single leaf or gateway per ESP32.
+  static InfiniEspNowLeaf *leafInstance = NULL;
+  static InfiniEspNowGateway *gatewayInstance = NULL;
+
+  static void writeHeader(BYTE *frame, ESPNOW_FRAME_TYPE type, BYTE nodeId, WORD seq) {
+    frame[0] = 'I';
+    frame[1] = 'N';
+    frame[2] = ESPNOW_VERSION;
+    frame[3] = type;
+    frame[4] = nodeId;
+    frame[5] = (BYTE)(seq & 0xFF);
+    frame[6] = (BYTE)(seq >> 8);
+  }
+
+  static bool isFrame(const BYTE *data, int len, ESPNOW_FRAME_TYPE type) {
+    return len >= ESPNOW_ACK_SZ && data[0] == 'I' && data[1] == 'N' && data[2] == ESPNOW_VERSION && data[3] == type;
+  }
+
+  static WORD frameSeq(const BYTE *data) {
+    return (WORD)(data[5] | (data[6] << 8));
+  }
+
+  static bool addPeer(const BYTE *mac) {
+    if (esp_now_is_peer_exist(mac)) {
+      return true;
+    }
+    esp_now_peer_info_t peer;
+    memset(&peer, 0, sizeof(peer));
+    memcpy(peer.peer_addr, mac, 6);
+    // The channel WiFi is on.
+    peer.channel = 0;
+    peer.ifidx = WIFI_IF_STA;
+    peer.encrypt = false;
+    return esp_now_add_peer(&peer) == ESP_OK;
+  }
+
+  // The receive callback lost the sender's address to an info struct in ESP-IDF 5.
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+  static void onReceive(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
+#else
+  static void onReceive(const uint8_t *mac, const uint8_t *data, int len) {
+#endif
+    if (leafInstance != NULL) {
+      InfiniEspNowLeaf::onAck(data, len);
+    } else if (gatewayInstance != NULL) {
+      InfiniEspNowGateway::onFrame(data, len);
+    }
+  }
+
+  // The acknowledgement the leaf's onAck() saw last, for loop() to pick up.
+  static volatile bool ackReceived = false;
+  static volatile WORD ackSeq = 0;
+
+  InfiniEspNowLeaf::InfiniEspNowLeaf(const BYTE *gatewayMac, BYTE nodeId) :
+    m_nodeId(nodeId),
+    m_head(0),
+    m_count(0),
+    m_frameLen(0),
+    m_inFlight(0),
+    m_hasFrame(false),
+    m_seq(0),
+    m_sentMs(0),
+    m_waitMs(0),
+    m_frames(0),
+    m_retries(0),
+    m_dropped(0)
+  {
+    memcpy(m_gatewayMac, gatewayMac, sizeof(m_gatewayMac));
+  }
+
+  bool InfiniEspNowLeaf::begin(BYTE channel) {
+    WiFi.mode(WIFI_STA);
+    WiFi.disconnect();
+    esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+    if (esp_now_init() != ESP_OK || !addPeer(m_gatewayMac)) {
+      return false;
+    }
+    leafInstance = this;
+    return esp_now_register_recv_cb(onReceive) == ESP_OK;
+  }
+
+  void InfiniEspNowLeaf::onAck(const BYTE *data, int len) {
+    if (!isFrame(data, len, ESPNOW_ACK) || leafInstance == NULL || data[4] != leafInstance->m_nodeId) {
+      // Another leaf's, the gateway broadcasts them.
+      return;
+    }
+    ackSeq = frameSeq(data);
+    ackReceived = true;
+    wakeIdle();
+  }
+
+  bool InfiniEspNowLeaf::queue(const GeneralStatusFixed &gs, unsigned long sampleMs) {
+    bool kept = true;
+    if (m_count == ESPNOW_LEAF_QUEUE_SZ) {
+      // The frame in flight holds its own copy, only its count of what is left in the queue goes down.
+      m_head = (m_head + 1) % ESPNOW_LEAF_QUEUE_SZ;
+      m_count--;
+      if (m_inFlight > 0) {
+        m_inFlight--;
+      }
+      m_dropped++;
+      kept = false;
+    }
+    const BYTE slot = (m_head + m_count) % ESPNOW_LEAF_QUEUE_SZ;
+    m_samples[slot] = gs;
+    m_sampleMs[slot] = sampleMs;
+    m_count++;
+    return kept;
+  }
+
+  void InfiniEspNowLeaf::buildFrame() {
+    const BYTE count = m_count < ESPNOW_SAMPLES_PER_FRAME ? m_count : ESPNOW_SAMPLES_PER_FRAME;
+    m_seq++;
+    writeHeader(m_frame, ESPNOW_SAMPLES, m_nodeId, m_seq);
+    m_frame[7] = count;
+    InfiniBufferPrint out((char *)m_frame + ESPNOW_SAMPLES_HEADER_SZ, sizeof(m_frame) - ESPNOW_SAMPLES_HEADER_SZ);
+    for (BYTE i = 0; i < count; ++i) {
+      const BYTE slot = (m_head + i) % ESPNOW_LEAF_QUEUE_SZ;
+      writeGsSampleBinary(m_samples[slot], m_sampleMs[slot], out);
+    }
+    m_frameLen = ESPNOW_SAMPLES_HEADER_SZ + count * BINARY_GS_SAMPLE_SZ;
+    m_inFlight = count;
+    m_hasFrame = true;
+    m_waitMs = ESPNOW_ACK_TIMEOUT_MS;
+  }
+
+  void InfiniEspNowLeaf::send(unsigned long nowMs) {
+    // The ages of the samples are taken against this, so it is set again for every attempt.
+    m_frame[8] = (BYTE)(nowMs & 0xFF);
+    m_frame[9] = (BYTE)(nowMs >> 8);
+    m_frame[10] = (BYTE)(nowMs >> 16);
+    m_frame[11] = (BYTE)(nowMs >> 24);
+    esp_now_send(m_gatewayMac, m_frame, m_frameLen);
+    m_sentMs = nowMs;
+  }
+
+  void InfiniEspNowLeaf::loop(unsigned long nowMs) {
+    if (ackReceived) {
+      ackReceived = false;
+      if (m_hasFrame && ackSeq == m_seq) {
+        m_head = (m_head + m_inFlight) % ESPNOW_LEAF_QUEUE_SZ;
+        m_count -= m_inFlight;
+        m_inFlight = 0;
+        m_hasFrame = false;
+        m_frames++;
+      }
+    }
+    if (!m_hasFrame) {
+      if (m_count == 0) {
+        return;
+      }
+      buildFrame();
+      send(nowMs);
+      return;
+    }
+    if (nowMs - m_sentMs >= m_waitMs) {
+      send(nowMs);
+      m_retries++;
+      m_waitMs = m_waitMs > ESPNOW_RETRY_MAX_MS / 2 ? ESPNOW_RETRY_MAX_MS : m_waitMs * 2;
+    }
+  }
+
+  unsigned long InfiniEspNowLeaf::msUntilWork(unsigned long nowMs) const {
+    if (ackReceived || (!m_hasFrame && m_count > 0)) {
+      return 0;
+    }
+    return m_hasFrame ? msUntilElapsed(m_sentMs, m_waitMs, nowMs) : NO_DEADLINE;
+  }
+
+  BYTE InfiniEspNowLeaf::pending() const {
+    return m_count;
+  }
+
+  unsigned long InfiniEspNowLeaf::frames() const {
+    return m_frames;
+  }
+
+  unsigned long InfiniEspNowLeaf::retries() const {
+    return m_retries;
+  }
+
+  unsigned long InfiniEspNowLeaf::dropped() const {
+    return m_dropped;
+  }
+
+  InfiniEspNowGateway::InfiniEspNowGateway(EspNowSampleHandler handler, void *context) :
+    m_handler(handler),
+    m_context(context),
+    m_head(0),
+    m_tail(0),
+    m_overflows(0),
+    m_passed(0),
+    m_duplicates(0)
+  {
+    memset(m_seen, 0, sizeof(m_seen));
+  }
+
+  bool InfiniEspNowGateway::begin() {
+    if (esp_now_init() != ESP_OK || !addPeer(BROADCAST_MAC)) {
+      return false;
+    }
+    gatewayInstance = this;
+    return esp_now_register_recv_cb(onReceive) == ESP_OK;
+  }
+
+  void InfiniEspNowGateway::onFrame(const BYTE *data, int len) {
+    InfiniEspNowGateway &gateway = *gatewayInstance;
+    if (!isFrame(data, len, ESPNOW_SAMPLES) || len > ESPNOW_FRAME_SZ) {
+      return;
+    }
+    const BYTE next = (gateway.m_head + 1) % ESPNOW_GATEWAY_FRAMES;
+    if (next == gateway.m_tail) {
+      // Not acknowledged, so the leaf sends it again.
+      gateway.m_overflows++;
+      return;
+    }
+    Frame &frame = gateway.m_frames[gateway.m_head];
+    memcpy(frame.data, data, len);
+    frame.len = (BYTE)len;
+    gateway.m_head = next;
+    wakeIdle();
+  }
+
+  bool InfiniEspNowGateway::hasFrames() const {
+    return m_head != m_tail;
+  }
+
+  void InfiniEspNowGateway::loop() {
+    while (m_head != m_tail) {
+      handle(m_frames[m_tail]);
+      m_tail = (m_tail + 1) % ESPNOW_GATEWAY_FRAMES;
+    }
+  }
+
+  void InfiniEspNowGateway::handle(const Frame &frame) {
+    const BYTE *data = frame.data;
+    const BYTE nodeId = data[4];
+    const WORD seq = frameSeq(data);
+    const BYTE count = frame.len >= ESPNOW_SAMPLES_HEADER_SZ ? data[7] : 0;
+    if (nodeId >= ESPNOW_NODES || frame.len < ESPNOW_SAMPLES_HEADER_SZ + count * BINARY_GS_SAMPLE_SZ) {
+      return;
+    }
+    BYTE ack[ESPNOW_ACK_SZ];
+    writeHeader(ack, ESPNOW_ACK, nodeId, seq);
+    esp_now_send(BROADCAST_MAC, ack, sizeof(ack));
+
+    const BYTE bit = 1 << (nodeId & 7);
+    if ((m_seen[nodeId / 8] & bit) && m_lastSeq[nodeId] == seq) {
+      // Our acknowledgement got lost, the samples were passed on already.
+      m_duplicates++;
+      return;
+    }
+    m_seen[nodeId / 8] |= bit;
+    m_lastSeq[nodeId] = seq;
+    m_passed++;
+    const unsigned long sentMs = (unsigned long)data[8] | ((unsigned long)data[9] << 8) |
+                                 ((unsigned long)data[10] << 16) | ((unsigned long)data[11] << 24);
+    for (BYTE i = 0; i < count; ++i) {
+      GeneralStatusFixed gs;
+      uint64_t sampleMs;
+      if (readGsSampleBinary(data + ESPNOW_SAMPLES_HEADER_SZ + i * BINARY_GS_SAMPLE_SZ, BINARY_GS_SAMPLE_SZ, gs,
+                             sampleMs)) {
+        m_handler(nodeId, gs, sentMs - (unsigned long)sampleMs, m_context);
+      }
+    }
+  }
+
+  unsigned long InfiniEspNowGateway::frames() const {
+    return m_passed;
+  }
+
+  unsigned long InfiniEspNowGateway::duplicates() const {
+    return m_duplicates;
+  }
+
+  unsigned long InfiniEspNowGateway::overflows() const {
+    return m_overflows;
+  }
+}
+#endif
+#endif
@@ -0,0 +1,175 @@
+#ifndef INFINI_ESP_NOW_H
+#define INFINI_ESP_NOW_H
+
+#include "InfiniBinaryWriter.h"
+
+// Samples a leaf holds until the gateway acknowledged them, e.g. 5 minutes at 5 s. When full the oldest go.
+#ifndef INFI_ESPNOW_LEAF_QUEUE_SZ
+#define INFI_ESPNOW_LEAF_QUEUE_SZ 60
+#endif
+
+// Frames the gateway buffers between the WiFi task that receives them and its loop().
+#ifndef INFI_ESPNOW_GATEWAY_FRAMES
+#define INFI_ESPNOW_GATEWAY_FRAMES 8
+#endif
+
+// Node ids the gateway tells apart, 0 to this less 1.
+#ifndef INFI_ESPNOW_NODES
+#define INFI_ESPNOW_NODES 64
+#endif
+
+// How long a leaf waits for the acknowledgement of a frame before sending it again, doubling up to the
+// longest wait, milliseconds.
+#ifndef INFI_ESPNOW_ACK_TIMEOUT_MS
+#define INFI_ESPNOW_ACK_TIMEOUT_MS 50
+#endif
+#ifndef INFI_ESPNOW_RETRY_MAX_MS
+#define INFI_ESPNOW_RETRY_MAX_MS 5000
+#endif
+
+namespace INFI {
+
+  const BYTE ESPNOW_LEAF_QUEUE_SZ = INFI_ESPNOW_LEAF_QUEUE_SZ;
+  const BYTE ESPNOW_GATEWAY_FRAMES = INFI_ESPNOW_GATEWAY_FRAMES;
+  const BYTE ESPNOW_NODES = INFI_ESPNOW_NODES;
+  const unsigned long ESPNOW_ACK_TIMEOUT_MS = INFI_ESPNOW_ACK_TIMEOUT_MS;
+  const unsigned long ESPNOW_RETRY_MAX_MS = INFI_ESPNOW_RETRY_MAX_MS;
+
+  /*
+   * The frames, little endian. Every frame starts with 'I', 'N', ESPNOW_VERSION, its ESPNOW_FRAME_TYPE,
+   * the leaf's node id and the frame's sequence number as a WORD.
+   * ESPNOW_SAMPLES then has the number of samples, the leaf's millis() when the frame went out as 4 bytes,
+   * and that many writeGsSampleBinary() records stamped with the leaf's millis() when each was taken.
+   * The gateway tells the age of each sample from the two, so leaves need no clock.
+   * ESPNOW_ACK has nothing more, it acknowledges the frame of that node and sequence number.
+   */
+  const BYTE ESPNOW_VERSION = 1;
+  enum ESPNOW_FRAME_TYPE {
+    ESPNOW_SAMPLES = 1,
+    ESPNOW_ACK = 2
+  };
+  const BYTE ESPNOW_ACK_SZ = 7;
+  const BYTE ESPNOW_SAMPLES_HEADER_SZ = 12;
+  //! ESP-NOW's largest payload.
+  const BYTE ESPNOW_FRAME_SZ = 250;
+  const BYTE ESPNOW_SAMPLES_PER_FRAME = (ESPNOW_FRAME_SZ - ESPNOW_SAMPLES_HEADER_SZ) / BINARY_GS_SAMPLE_SZ;
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /*!
+   * The inverter side of an ESP-NOW relay: sends the GS samples queue()d to a gateway node, which publishes
+   * them with those of every other leaf over its one ThingsBoard session. A leaf never brings up TCP/IP,
+   * DHCP or TLS, its radio only talks to the gateway.
+   * Up to ESPNOW_SAMPLES_PER_FRAME samples go out in a frame, which is sent again until the gateway
+   * acknowledges it, after ESPNOW_ACK_TIMEOUT_MS and then twice as long each time, up to ESPNOW_RETRY_MAX_MS.
+   * Samples are held until then, so a gateway that is down for a while loses nothing but what does not
+   * fit ESPNOW_LEAF_QUEUE_SZ. Only one leaf per ESP32, ESP-NOW has one receive callback.
+   */
+  class InfiniEspNowLeaf {
+    public:
+    //! gatewayMac is the gateway's station MAC, nodeId this leaf's, below ESPNOW_NODES and unique per gateway.
+    InfiniEspNowLeaf(const BYTE *gatewayMac, BYTE nodeId);
+
+    /*! Starts WiFi as a station without connecting, on channel, which has to be the gateway's, i.e. its AP's.
+     * Returns false if ESP-NOW could not be started.
+     */
+    bool begin(BYTE channel);
+
+    //! Queues gs taken at sampleMs, millis(). Returns false if the oldest sample was dropped to make room.
+    bool queue(const GeneralStatusFixed &gs, unsigned long sampleMs);
+
+    //! Sends the next frame, or again, and takes acknowledged samples off the queue.
+    void loop(unsigned long nowMs);
+    //! How long until loop() has something to do, e.g. for idleFor(). An acknowledgement wakes the loop.
+    unsigned long msUntilWork(unsigned long nowMs) const;
+
+    //! Samples waiting for their acknowledgement.
+    BYTE pending() const;
+    //! Frames acknowledged, frames sent again, and samples dropped from a full queue.
+    unsigned long frames() const;
+    unsigned long retries() const;
+    unsigned long dropped() const;
+
+    //! Called by the ESP-NOW receive callback, on the WiFi task.
+    static void onAck(const BYTE *data, int len);
+
+    private:
+    //! Writes the oldest samples into m_frame under the next sequence number.
+    void buildFrame();
+    //! Sends m_frame with the time in it set to nowMs.
+    void send(unsigned long nowMs);
+
+    BYTE m_gatewayMac[6];
+    BYTE m_nodeId;
+    GeneralStatusFixed m_samples[ESPNOW_LEAF_QUEUE_SZ];
+    unsigned long m_sampleMs[ESPNOW_LEAF_QUEUE_SZ];
+    BYTE m_head;
+    BYTE m_count;
+    BYTE m_frame[ESPNOW_FRAME_SZ];
+    BYTE m_frameLen;
+    //! Samples of m_frame still in the queue, 0 if no frame is in flight.
+    BYTE m_inFlight;
+    bool m_hasFrame;
+    WORD m_seq;
+    unsigned long m_sentMs;
+    unsigned long m_waitMs;
+    unsigned long m_frames;
+    unsigned long m_retries;
+    unsigned long m_dropped;
+  };
+
+  //! Takes a relayed sample of nodeId, taken ageMs before it arrived.
+  typedef void (*EspNowSampleHandler)(BYTE nodeId, const GeneralStatusFixed &gs, unsigned long ageMs, void *context);
+
+  /*!
+   * The uplink side of an ESP-NOW relay, on the node that holds the ThingsBoard session, e.g. in gateway mode
+   * with InfiniGateway. Frames are taken in by the WiFi task and handed to loop(), which acknowledges each and
+   * passes its samples to handler. A frame sent again after a lost acknowledgement is acknowledged again but
+   * not passed on twice. The acknowledgements are broadcast, so any number of leaves take no ESP-NOW peer slot.
+   * Call begin() once WiFi is a station, the leaves have to be on the channel of its AP. Keep WiFi out of
+   * modem sleep, WiFi.setSleep(false), or frames that arrive while it dozes are lost and sent again.
+   */
+  class InfiniEspNowGateway {
+    public:
+    InfiniEspNowGateway(EspNowSampleHandler handler, void *context = NULL);
+
+    //! Starts ESP-NOW. Returns false if it could not be started.
+    bool begin();
+
+    //! Acknowledges and hands on what arrived. Frames arriving wake the loop.
+    void loop();
+    bool hasFrames() const;
+
+    //! Frames passed on, frames that came again, and frames lost to a full buffer.
+    unsigned long frames() const;
+    unsigned long duplicates() const;
+    unsigned long overflows() const;
+
+    //! Called by the ESP-NOW receive callback, on the WiFi task.
+    static void onFrame(const BYTE *data, int len);
+
+    private:
+    struct Frame {
+      BYTE len;
+      BYTE data[ESPNOW_FRAME_SZ];
+    };
+
+    void handle(const Frame &frame);
+
+    EspNowSampleHandler m_handler;
+    void *m_context;
+    Frame m_frames[ESPNOW_GATEWAY_FRAMES];
+    //! Written by the WiFi task only.
+    volatile BYTE m_head;
+    //! Written by loop() only.
+    volatile BYTE m_tail;
+    volatile unsigned long m_overflows;
+    //! The last sequence number passed on per node, valid once its bit in m_seen is set.
+    WORD m_lastSeq[ESPNOW_NODES];
+    BYTE m_seen[(ESPNOW_NODES + 7) / 8];
+    unsigned long m_passed;
+    unsigned long m_duplicates;
+  };
+#endif
+}
+
+#endif
@@ -0,0 +1,43 @@
+#include "InfiniEthernet.h"
+
+#if INFI_MODULE_SINKS
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_arduino_version.h>
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+#include <SPI.h>
+#endif
+
+namespace INFI {
+
+  static bool beginLan8720(const EthernetConfig &config) {
+#if CONFIG_ETH_USE_ESP32_EMAC
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    return ETH.begin(ETH_PHY_LAN8720, config.phyAddr, config.mdc, config.mdio, config.power,
+                     (eth_clock_mode_t)config.clockMode);
+#else
+    return ETH.begin(config.phyAddr, config.power, config.mdc, config.mdio, ETH_PHY_LAN8720,
+                     (eth_clock_mode_t)config.clockMode);
+#endif
+#else
+    // No Ethernet MAC on this ESP32.
+    return false;
+#endif
+  }
+
+  static bool beginW5500(const EthernetConfig &config) {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3 && CONFIG_ETH_SPI_ETHERNET_W5500
+    SPI.begin(config.sck, config.miso, config.mosi);
+    return ETH.begin(ETH_PHY_W5500, config.phyAddr, config.cs, config.irq, config.rst, SPI, config.spiMhz);
+#else
+    // ETH only drives SPI chips from core 3 on.
+    return false;
+#endif
+  }
+
+  bool beginEthernet(const EthernetConfig &config) {
+    return config.transport == ETH_TRANSPORT_W5500 ? beginW5500(config) : beginLan8720(config);
+  }
+}
+#endif
+#endif
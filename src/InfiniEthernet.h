@@ -0,0 +1,53 @@
+#ifndef INFINI_ETHERNET_H
+#define INFINI_ETHERNET_H
+
+#include <stdint.h>
+#include "InfiniCommon.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <ETH.h>
+#endif
+
+namespace INFI {
+
+  enum ETH_TRANSPORT {
+    ETH_TRANSPORT_LAN8720 = 0, // The ESP32's own Ethernet MAC with a LAN8720 PHY over RMII.
+    ETH_TRANSPORT_W5500        // A WIZnet W5500 on SPI, the MAC and PHY both on the chip.
+  };
+
+  //! How the Ethernet chip is wired. Only the pins of the transport used matter, -1 for one not connected.
+  struct EthernetConfig {
+    ETH_TRANSPORT transport;
+    //! Address of the PHY on the MDIO bus, e.g. 1 on a WT32-ETH01, or of the W5500, usually 1.
+    int8_t phyAddr;
+    //! LAN8720: the management bus, the pin powering the PHY or its oscillator, and where the 50 MHz RMII
+    //! clock comes in or goes out, an eth_clock_mode_t, e.g. ETH_CLOCK_GPIO0_IN.
+    int8_t mdc;
+    int8_t mdio;
+    int8_t power;
+    BYTE clockMode;
+    //! W5500: chip select, interrupt and reset, and the SPI bus with its clock in MHz.
+    int8_t cs;
+    int8_t irq;
+    int8_t rst;
+    int8_t sck;
+    int8_t miso;
+    int8_t mosi;
+    BYTE spiMhz;
+  };
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /*!
+   * Starts Ethernet as config describes. Either transport ends up a netif of lwIP like WiFi's station, so a
+   * WiFiClient, and the ThingsBoard client over it, connects through the cable unchanged, and the link comes
+   * and goes as ARDUINO_EVENT_ETH_CONNECTED, _GOT_IP, _DISCONNECTED and _LOST_IP, the same way the WiFi events
+   * drive a reconnect. A cable has no retransmissions over the air, so publishes and RPC round trips keep a
+   * steady latency, turn WiFi off then to keep its radio out of the way too.
+   * The W5500 needs the ESP32 Arduino core 3, where ETH drives SPI chips, and the LAN8720 an ESP32 with an
+   * Ethernet MAC. Returns false if the core can not drive the transport or the chip did not start.
+   */
+  bool beginEthernet(const EthernetConfig &config);
+#endif
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include "InfiniFaultCapture.h"
+
+#if INFI_MODULE_BINARY
+#include "InfiniGsCodec.h"
+
+namespace INFI {
+
+  InfiniFaultCapture::InfiniFaultCapture(unsigned long preMs, unsigned long postMs) :
+    m_preMs(preMs),
+    m_postMs(postMs),
+    m_state(CAPTURE_ARMED),
+    m_triggerMs(0),
+    m_hasFws(false),
+    m_fwsFlags(0),
+    m_faultCode(0),
+    m_triggers(0),
+    m_missed(0)
+  {}
+
+  bool InfiniFaultCapture::allocate(unsigned long capacity) {
+    if (!m_ring.allocate(capacity)) {
+      return false;
+    }
+    m_state = CAPTURE_ARMED;
+    m_triggerMs = 0;
+    return true;
+  }
+
+  unsigned long InfiniFaultCapture::limit() const {
+    return m_ring.capacity() < FAULT_CAPTURE_MAX_SAMPLES ? m_ring.capacity() : FAULT_CAPTURE_MAX_SAMPLES;
+  }
+
+  bool InfiniFaultCapture::push(const GeneralStatusFixed &gs, uint64_t tsMs) {
+    if (m_state == CAPTURE_READY) {
+      return false;
+    }
+    m_ring.push(gs, tsMs);
+    if (m_state == CAPTURE_ARMED) {
+      // Half the ring at most, so the post-trigger window always has the other half.
+      while (m_ring.size() > limit() / 2 || (m_ring.size() > 1 && m_ring.timestamp(0) + m_preMs < tsMs)) {
+        m_ring.pop(1);
+      }
+      return false;
+    }
+    if (m_ring.size() >= limit() || tsMs >= m_triggerMs + m_postMs) {
+      m_state = CAPTURE_READY;
+      return true;
+    }
+    return false;
+  }
+
+  bool InfiniFaultCapture::trigger(uint64_t tsMs) {
+    if (m_state != CAPTURE_ARMED) {
+      m_missed++;
+      return false;
+    }
+    m_state = CAPTURE_RECORDING;
+    m_triggerMs = tsMs;
+    m_triggers++;
+    return true;
+  }
+
+  bool InfiniFaultCapture::onFaultWarning(const FaultWarningStatus &fws, uint64_t tsMs) {
+    const WORD flags = getFaultWarningFlags(fws);
+    const bool edge = m_hasFws && ((flags & ~m_fwsFlags) != 0 || (fws.faultCode != 0 && fws.faultCode != m_faultCode));
+    m_hasFws = true;
+    m_fwsFlags = flags;
+    m_faultCode = fws.faultCode;
+    return edge && trigger(tsMs);
+  }
+
+  CAPTURE_STATE InfiniFaultCapture::state() const {
+    return m_state;
+  }
+
+  bool InfiniFaultCapture::isReady() const {
+    return m_state == CAPTURE_READY;
+  }
+
+  uint64_t InfiniFaultCapture::triggerMs() const {
+    return m_triggerMs;
+  }
+
+  const InfiniGsHistory &InfiniFaultCapture::samples() const {
+    return m_ring;
+  }
+
+  size_t InfiniFaultCapture::writeBinary(Print &out) const {
+    if (m_state != CAPTURE_READY) {
+      return 0;
+    }
+    return writeGsHistoryBinary(m_ring, (BYTE)m_ring.size(), out);
+  }
+
+  void InfiniFaultCapture::release() {
+    m_ring.pop(m_ring.size());
+    m_state = CAPTURE_ARMED;
+    m_triggerMs = 0;
+  }
+
+  unsigned long InfiniFaultCapture::triggers() const {
+    return m_triggers;
+  }
+
+  unsigned long InfiniFaultCapture::missed() const {
+    return m_missed;
+  }
+}
+#endif
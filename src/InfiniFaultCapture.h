@@ -0,0 +1,82 @@
+#ifndef INFINI_FAULT_CAPTURE_H
+#define INFINI_FAULT_CAPTURE_H
+
+#include <stdint.h>
+#include "InfiniGsHistory.h"
+
+namespace INFI {
+
+  //! Where an InfiniFaultCapture is, see the class comment.
+  enum CAPTURE_STATE {
+    CAPTURE_ARMED = 0, // Keeps the pre-trigger window rolling.
+    CAPTURE_RECORDING, // Triggered, fills the post-trigger window.
+    CAPTURE_READY      // The burst is complete and waits for release().
+  };
+
+  //! Samples one burst holds at most, what one writeGsHistoryBinary() record takes.
+  const BYTE FAULT_CAPTURE_MAX_SAMPLES = 255;
+
+  /*!
+   * The GS samples around a fault at the full rate of the link, kept apart from the regular, much sparser,
+   * telemetry and only uploaded when something happened. Feed it every GS sample, e.g. from a POLL_BACKGROUND
+   * GS poll that takes every gap of the link. While armed it keeps the last preMs of them, at most half the ring.
+   * trigger(), or a new fault or warning in onFaultWarning(), freezes that pre-trigger window and records on until
+   * postMs after the trigger or the ring is full. Then the burst is ready, writeBinary() puts all of it into one
+   * compressed timestamped BINARY_GS_HISTORY record, and release() arms it again once that went up.
+   * Samples and triggers that come while it is ready are dropped, one burst is uploaded at a time.
+   */
+  class InfiniFaultCapture {
+    public:
+    InfiniFaultCapture(unsigned long preMs, unsigned long postMs);
+
+    //! See InfiniGsHistory::allocate(), at most FAULT_CAPTURE_MAX_SAMPLES are used. Drops what it held.
+    bool allocate(unsigned long capacity);
+
+    //! Takes gs sampled at tsMs, milliseconds since the Unix epoch. Returns true if that completed the burst.
+    bool push(const GeneralStatusFixed &gs, uint64_t tsMs);
+
+    //! Starts a burst at tsMs, e.g. when an alarm rule fires. False, changing nothing, unless it is armed.
+    bool trigger(uint64_t tsMs);
+
+    /*! Triggers on a fault code that appeared or changed, or a warning flag that went up since the last call.
+     * The first FWS only sets the baseline, a fault that was already there at boot starts nothing.
+     */
+    bool onFaultWarning(const FaultWarningStatus &fws, uint64_t tsMs);
+
+    CAPTURE_STATE state() const;
+    bool isReady() const;
+
+    //! When the burst was triggered, 0 while armed.
+    uint64_t triggerMs() const;
+
+    //! The samples held, oldest first, the burst once it is ready.
+    const InfiniGsHistory &samples() const;
+
+    //! The burst as one writeGsHistoryBinary() record. 0 bytes unless it is ready.
+    size_t writeBinary(Print &out) const;
+
+    //! Drops the burst and arms again, e.g. once it was uploaded.
+    void release();
+
+    //! Bursts triggered, and triggers dropped while one was recording or waiting, since construction.
+    unsigned long triggers() const;
+    unsigned long missed() const;
+
+    private:
+    //! Samples the ring takes before the burst is cut off.
+    unsigned long limit() const;
+
+    InfiniGsHistory m_ring;
+    unsigned long m_preMs;
+    unsigned long m_postMs;
+    CAPTURE_STATE m_state;
+    uint64_t m_triggerMs;
+    bool m_hasFws;
+    WORD m_fwsFlags;
+    BYTE m_faultCode;
+    unsigned long m_triggers;
+    unsigned long m_missed;
+  };
+}
+
+#endif
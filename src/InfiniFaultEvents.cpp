@@ -0,0 +1,72 @@
+#include "InfiniFaultEvents.h"
+
+#if INFI_MODULE_PARSERS
+
+namespace INFI {
+
+  //! Every bit getFaultWarningFlags() can set.
+  static const WORD ALL_FLAGS = (WORD)((1UL << FWS_FLAGS) - 1);
+
+  FaultWarningTracker::FaultWarningTracker() :
+    m_full(true),
+    m_flags(0),
+    m_faultCode(0)
+  {}
+
+  void FaultWarningTracker::forceFullSnapshot() {
+    m_full = true;
+  }
+
+  WORD FaultWarningTracker::raised(const FaultWarningStatus &fws) const {
+    const WORD flags = getFaultWarningFlags(fws);
+    return m_full ? flags : flags & ~m_flags;
+  }
+
+  WORD FaultWarningTracker::cleared(const FaultWarningStatus &fws) const {
+    const WORD flags = getFaultWarningFlags(fws);
+    return m_full ? ALL_FLAGS & ~flags : m_flags & ~flags;
+  }
+
+  bool FaultWarningTracker::faultCodeChanged(const FaultWarningStatus &fws) const {
+    return m_full || fws.faultCode != m_faultCode;
+  }
+
+  bool FaultWarningTracker::hasEvents(const FaultWarningStatus &fws) const {
+    return m_full || fws.faultCode != m_faultCode || getFaultWarningFlags(fws) != m_flags;
+  }
+
+#if INFI_MODULE_JSON
+  size_t FaultWarningTracker::writeEventsJson(const FaultWarningStatus &fws, Print &out) const {
+    if (!hasEvents(fws)) {
+      return 0;
+    }
+    const WORD up = raised(fws);
+    const WORD down = cleared(fws);
+    size_t n = 0;
+    bool first = true;
+    for (BYTE i = 0; i < FWS_FLAGS; ++i) {
+      const WORD bit = (WORD)(1u << i);
+      if ((up & bit) != 0 || (down & bit) != 0) {
+        n += writeJsonFieldP(out, getFaultWarningFlagKey(i), (up & bit) != 0, JSON_BOOL, first);
+        first = false;
+      }
+    }
+    if (faultCodeChanged(fws)) {
+      n += writeJsonFieldP(out, INFI_PSTR("faultCode"), fws.faultCode, JSON_UINT, first);
+    }
+    n += out.print('}');
+    return n;
+  }
+#endif
+
+  void FaultWarningTracker::markPublished(const FaultWarningStatus &fws) {
+    m_full = false;
+    m_flags = getFaultWarningFlags(fws);
+    m_faultCode = fws.faultCode;
+  }
+
+  bool FaultWarningTracker::isActive(const FaultWarningStatus &fws) {
+    return fws.faultCode != 0 || getFaultWarningFlags(fws) != 0;
+  }
+}
+#endif
@@ -0,0 +1,50 @@
+#ifndef INFINI_FAULT_EVENTS_H
+#define INFINI_FAULT_EVENTS_H
+
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+
+  /*!
+   * Turns the FWS polls of one inverter into edge events, instead of uploading all 17 fields every poll.
+   * A flag is raised once it is set and was not in the last published FWS, and cleared the other way round.
+   * The fault code is reported whenever it differs from the published one, 0 when the fault went away.
+   * Same contract as GeneralStatusDelta: writeEventsJson() for the payload, markPublished() once it was sent.
+   * Until the first markPublished(), and after forceFullSnapshot(), every flag and the fault code are reported.
+   */
+  class FaultWarningTracker {
+    public:
+    FaultWarningTracker();
+
+    //! Makes the next writeEventsJson() report the whole FWS.
+    void forceFullSnapshot();
+
+    //! Bit masks of getFaultWarningFlags() with the flags that went up and came down since the last publish.
+    WORD raised(const FaultWarningStatus &fws) const;
+    WORD cleared(const FaultWarningStatus &fws) const;
+    bool faultCodeChanged(const FaultWarningStatus &fws) const;
+
+    //! Whether writeEventsJson() would write anything for fws.
+    bool hasEvents(const FaultWarningStatus &fws) const;
+
+#if INFI_MODULE_JSON
+    /*! Writes the events as one JSON object, e.g. {"battLow":true,"overLoad":false,"faultCode":0},
+     * with the keys of writeFaultWarningStatusJson(). Returns 0 if there are none.
+     */
+    size_t writeEventsJson(const FaultWarningStatus &fws, Print &out) const;
+#endif
+
+    //! Records fws as published.
+    void markPublished(const FaultWarningStatus &fws);
+
+    //! Whether fws has a fault code or any warning flag set, to poll it faster while it lasts.
+    static bool isActive(const FaultWarningStatus &fws);
+
+    private:
+    bool m_full;
+    WORD m_flags;
+    BYTE m_faultCode;
+  };
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include "InfiniFieldReader.h"
+
+#if INFI_MODULE_PARSERS
+
+namespace INFI {
+  InfiniFieldReader::InfiniFieldReader(const char *in, size_t start, size_t end) :
+    m_in(in),
+    m_pos(start),
+    m_end(end),
+    m_ok(true),
+    m_fieldIndex(0)
+  {}
+
+  long InfiniFieldReader::next(BYTE width) {
+    if (!m_ok) {
+      return 0;
+    }
+    // Fields after the first one start after a comma.
+    if (m_fieldIndex > 0) {
+      if (m_pos >= m_end || m_in[m_pos] != ',') {
+        m_ok = false;
+        return 0;
+      }
+      m_pos++;
+    }
+
+    bool negative = false;
+    if (m_pos < m_end && m_in[m_pos] == '-') {
+      negative = true;
+      m_pos++;
+      width--;
+    }
+    long value = 0;
+    BYTE digits = 0;
+    while (m_pos < m_end && m_in[m_pos] >= '0' && m_in[m_pos] <= '9') {
+      if (digits == width) {
+        // Wider than the protocol allows.
+        m_ok = false;
+        return 0;
+      }
+      value = value * 10 + (m_in[m_pos] - '0');
+      digits++;
+      m_pos++;
+    }
+    // No digits, or something other than the next comma or the end.
+    if (digits == 0 || (m_pos < m_end && m_in[m_pos] != ',')) {
+      m_ok = false;
+      return 0;
+    }
+    m_fieldIndex++;
+    return negative ? -value : value;
+  }
+
+  void InfiniFieldReader::skip() {
+    if (!m_ok) {
+      return;
+    }
+    if (m_fieldIndex > 0) {
+      if (m_pos >= m_end || m_in[m_pos] != ',') {
+        m_ok = false;
+        return;
+      }
+      m_pos++;
+    }
+    const size_t start = m_pos;
+    while (m_pos < m_end && m_in[m_pos] != ',') {
+      m_pos++;
+    }
+    if (m_pos == start) {
+      m_ok = false;
+      return;
+    }
+    m_fieldIndex++;
+  }
+
+  bool InfiniFieldReader::ok() const {
+    return m_ok;
+  }
+
+  bool InfiniFieldReader::done() const {
+    return m_ok && m_pos == m_end;
+  }
+
+  BYTE InfiniFieldReader::fieldIndex() const {
+    return m_fieldIndex;
+  }
+}
+#endif
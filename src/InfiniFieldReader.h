@@ -0,0 +1,43 @@
+#ifndef INFINI_FIELD_READER_H
+#define INFINI_FIELD_READER_H
+
+#include <stddef.h>
+#include "InfiniCommon.h"
+
+namespace INFI {
+
+  /*!
+   * Walks the comma separated fields of a ^D reply payload, e.g. AAAA,BBB,CCCC,...
+   * Each field is an optional '-' followed by digits, decoded with integer math only.
+   * The first malformed field stops the reader, later next() calls just return 0.
+   */
+  class InfiniFieldReader {
+    public:
+    //! Reads the fields in in[start, end), end being where the CRC starts.
+    InfiniFieldReader(const char *in, size_t start, size_t end);
+
+    //! Decodes the next field, which may be at most width chars wide.
+    long next(BYTE width);
+
+    //! Steps over the next field without decoding it, only its separator is checked.
+    void skip();
+
+    //! Whether every field so far was well formed.
+    bool ok() const;
+
+    //! Whether every field was well formed and the whole payload was consumed.
+    bool done() const;
+
+    //! Index of the first malformed field, or the number of fields read when ok().
+    BYTE fieldIndex() const;
+
+    private:
+    const char *m_in;
+    size_t m_pos;
+    size_t m_end;
+    bool m_ok;
+    BYTE m_fieldIndex;
+  };
+}
+
+#endif
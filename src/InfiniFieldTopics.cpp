@@ -0,0 +1,80 @@
+#include "InfiniFieldTopics.h"
+
+#if INFI_MODULE_JSON && INFI_MODULE_PARSERS
+#include <string.h>
+
+namespace INFI {
+
+  //! Longest value payload, a 32 bit number and its terminator.
+  static const BYTE FIELD_VALUE_SZ = 12;
+
+  InfiniFieldTopics::InfiniFieldTopics(const char *prefix, const char *device, FieldTopicPublish publish,
+                                       void *context) :
+    m_prefix(prefix),
+    m_device(device),
+    m_publish(publish),
+    m_context(context),
+    m_delta()
+  {
+  }
+
+  GeneralStatusDelta &InfiniFieldTopics::delta() {
+    return m_delta;
+  }
+
+  int InfiniFieldTopics::publish(const GeneralStatusFixed &gs) {
+    const GsFieldMask fields = m_delta.changedFields(gs);
+    int published = 0;
+    char topic[FIELD_TOPIC_SZ];
+    char value[FIELD_VALUE_SZ];
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      const GS_FIELD field = (GS_FIELD)i;
+      if ((fields & (1UL << i)) == 0) {
+        continue;
+      }
+      if (!makeTopic(field, topic)) {
+        continue;
+      }
+      InfiniBufferPrint payload(value, sizeof(value));
+      writeJsonValue(payload, getGeneralStatusField(gs, field), getGeneralStatusFieldKind(field));
+      if (!m_publish(topic, value, m_context)) {
+        return -1;
+      }
+      ++published;
+    }
+    if (fields != 0) {
+      m_delta.markPublished(gs);
+    }
+    return published;
+  }
+
+  bool InfiniFieldTopics::makeTopic(GS_FIELD field, char *topic) const {
+    size_t len = 0;
+    const char *parts[2] = { m_prefix, m_device };
+    for (BYTE p = 0; p < 2; ++p) {
+      const size_t partLen = strlen(parts[p]);
+      if (len + partLen + 1 >= FIELD_TOPIC_SZ) {
+        topic[len] = '\0';
+        return false;
+      }
+      memcpy(topic + len, parts[p], partLen);
+      len += partLen;
+      topic[len++] = '/';
+    }
+    // The key is in flash on AVR.
+    for (const char *key = getGeneralStatusFieldKey(field); ; ++key) {
+      const char c = (char)INFI_READ_BYTE(key);
+      if (c == '\0') {
+        break;
+      }
+      if (len + 1 >= FIELD_TOPIC_SZ) {
+        topic[len] = '\0';
+        return false;
+      }
+      topic[len++] = c;
+    }
+    topic[len] = '\0';
+    return true;
+  }
+}
+#endif
@@ -0,0 +1,53 @@
+#ifndef INFINI_FIELD_TOPICS_H
+#define INFINI_FIELD_TOPICS_H
+
+#include "InfiniDeltaTelemetry.h"
+
+// Longest topic InfiniFieldTopics builds, prefix, device and key with the slashes and the terminator.
+#ifndef INFI_FIELD_TOPIC_SZ
+#define INFI_FIELD_TOPIC_SZ 64
+#endif
+
+namespace INFI {
+
+  const BYTE FIELD_TOPIC_SZ = INFI_FIELD_TOPIC_SZ;
+
+  /*! Publishes payload on topic, retained, e.g. with PubSubClient::publish(topic, payload, true) or
+   * Arduino_MQTT_Client::publish(topic, payload, length, true). Returns false if it could not be sent.
+   */
+  typedef bool (*FieldTopicPublish)(const char *topic, const char *payload, void *context);
+
+  /*!
+   * Publishes GS as a retained topic per field, <prefix>/<device>/<key> with the keys of writeGeneralStatusJson(),
+   * e.g. infinisolar/0/battVolt 52.1, the shape Home Assistant and Node-RED expect of a LAN broker.
+   * Only the fields its GeneralStatusDelta lets through are published, so a sample that barely moved is a
+   * handful of tiny publishes instead of one for every field, and the broker's retained copy of the rest
+   * stays right. The delta's full snapshots refresh every topic now and then. Cork the MQTT client's
+   * connection around publish(), see InfiniCorkClient, for the publishes of a sample to share a TCP segment.
+   */
+  class InfiniFieldTopics {
+    public:
+    //! prefix and device must outlive the sink.
+    InfiniFieldTopics(const char *prefix, const char *device, FieldTopicPublish publish, void *context = NULL);
+
+    //! The filter deciding which fields are published, to set its deadbands and fields.
+    GeneralStatusDelta &delta();
+
+    /*! Publishes the fields of gs the delta lets through and marks them published. Returns how many were,
+     * or -1 if a publish failed, then nothing is marked and the next call publishes them again.
+     */
+    int publish(const GeneralStatusFixed &gs);
+
+    //! Writes the topic of field into topic, FIELD_TOPIC_SZ long. False, with topic cut short, if it does not fit.
+    bool makeTopic(GS_FIELD field, char *topic) const;
+
+    private:
+    const char *m_prefix;
+    const char *m_device;
+    FieldTopicPublish m_publish;
+    void *m_context;
+    GeneralStatusDelta m_delta;
+  };
+}
+
+#endif
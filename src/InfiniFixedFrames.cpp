@@ -0,0 +1,122 @@
+#include "InfiniFixedFrames.h"
+
+namespace INFI {
+  /*
+   * C++11 constexpr functions are a single return statement, so the frame is described
+   * byte by byte: frameByte(type, i) is what InfiniCommandMaker would put at command.val[i].
+   * Everything about the command comes from COMMAND_DESCRIPTORS.
+   * The CRC is the same CRC-16/XMODEM as InfiniCRC.cpp, one bit per recursion step.
+   */
+  constexpr WORD crcBits(WORD crc, BYTE bits) {
+    return bits == 0 ? crc
+      : crcBits((WORD)((crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1)), bits - 1);
+  }
+
+  constexpr WORD crcByte(WORD crc, BYTE b) {
+    return crcBits((WORD)(crc ^ ((WORD)b << 8)), 8);
+  }
+
+  constexpr BYTE escapeByte(BYTE b) {
+    return (b == 0x28 || b == 0x0d || b == 0x0a) ? b + 1 : b;
+  }
+
+  constexpr BYTE frameByte(COMMAND_TYPE type, BYTE i);
+
+  // The raw (not yet escaped) CRC of the first n bytes of the frame.
+  constexpr WORD frameCrc(COMMAND_TYPE type, BYTE n) {
+    return n == 0 ? 0 : crcByte(frameCrc(type, n - 1), frameByte(type, n - 1));
+  }
+
+  constexpr BYTE frameByte(COMMAND_TYPE type, BYTE i) {
+    return i == 0 ? '^'
+      : i == 1 ? (getActionType(type) == UPDATE ? 'S' : 'P')
+      : i == 2 ? '0' + getCommandToEndSize(type) / 100
+      : i == 3 ? '0' + getCommandToEndSize(type) / 10 % 10
+      : i == 4 ? '0' + getCommandToEndSize(type) % 10
+      : i < START_OFFSET_SZ + getMnemonicSize(getCommandDescriptor(type).mnemonic)
+        ? (BYTE)getCommandDescriptor(type).mnemonic[i - START_OFFSET_SZ]
+      : i == getFrameSize(type) - 3 ? escapeByte(frameCrc(type, getFrameSize(type) - 3) >> 8)
+      : i == getFrameSize(type) - 2 ? escapeByte(frameCrc(type, getFrameSize(type) - 3) & 0xff)
+      : i == getFrameSize(type) - 1 ? '\r'
+      : 0;
+  }
+
+  // Commands with params get an empty entry, their frame is built at runtime.
+  constexpr BYTE fixedFrameSize(COMMAND_TYPE type) {
+    return getCommandDescriptor(type).paramSz > 0 ? 0 : getFrameSize(type);
+  }
+
+  constexpr BYTE fixedFrameByte(COMMAND_TYPE type, BYTE i) {
+    return i < fixedFrameSize(type) ? frameByte(type, i) : 0;
+  }
+
+#define INFI_FRAME_BYTE(t, i) fixedFrameByte(t, i)
+#define INFI_FIXED_FRAME(t) { fixedFrameSize(t), { \
+    INFI_FRAME_BYTE(t, 0),  INFI_FRAME_BYTE(t, 1),  INFI_FRAME_BYTE(t, 2),  INFI_FRAME_BYTE(t, 3), \
+    INFI_FRAME_BYTE(t, 4),  INFI_FRAME_BYTE(t, 5),  INFI_FRAME_BYTE(t, 6),  INFI_FRAME_BYTE(t, 7), \
+    INFI_FRAME_BYTE(t, 8),  INFI_FRAME_BYTE(t, 9),  INFI_FRAME_BYTE(t, 10), INFI_FRAME_BYTE(t, 11), \
+    INFI_FRAME_BYTE(t, 12), INFI_FRAME_BYTE(t, 13), INFI_FRAME_BYTE(t, 14), INFI_FRAME_BYTE(t, 15) } }
+
+  // Indexed by COMMAND_TYPE, in flash on AVR.
+  static constexpr InfiniFixedFrame FIXED_FRAMES[] INFI_PROGMEM = {
+    INFI_FIXED_FRAME(CURRENT_TIME),
+    INFI_FIXED_FRAME(TOTAL_GEN_ENERGY),
+    INFI_FIXED_FRAME(GEN_ENERGY_YEAR),
+    INFI_FIXED_FRAME(GEN_ENERGY_MONTH),
+    INFI_FIXED_FRAME(GEN_ENERGY_DAY),
+    INFI_FIXED_FRAME(GENERAL_STATUS),
+    INFI_FIXED_FRAME(QUERY_RATED_INFORMATION),
+    INFI_FIXED_FRAME(FAULT_WARNING_STATUS),
+    INFI_FIXED_FRAME(QUERY_ENABLE_DISABLE_STATUS),
+    INFI_FIXED_FRAME(QUERY_DEFAULT_VALUE),
+    INFI_FIXED_FRAME(QUERY_MAX_CHARGING_CURRENT),
+    INFI_FIXED_FRAME(QUERY_MAX_AC_CHARGING_CURRENT),
+    INFI_FIXED_FRAME(QUERY_PROTOCOL_ID),
+    INFI_FIXED_FRAME(QUERY_SERIES_NUMBER),
+    INFI_FIXED_FRAME(QUERY_CPU_VERSION),
+    INFI_FIXED_FRAME(QUERY_WORKING_MODE),
+    INFI_FIXED_FRAME(SET_ENABLE_DISABLE_STATUS),
+    INFI_FIXED_FRAME(SET_MAX_CHARGING_CURRENT),
+    INFI_FIXED_FRAME(SET_MAX_AC_CHARGING_CURRENT),
+    INFI_FIXED_FRAME(AC_OUT_FREQ_50),
+    INFI_FIXED_FRAME(AC_OUT_FREQ_60),
+    INFI_FIXED_FRAME(SET_OUTPUT_SOURCE_PRIORITY),
+    INFI_FIXED_FRAME(SET_CHARGING_SOURCE_PRIORITY),
+    INFI_FIXED_FRAME(SET_SOLAR_POWER_PRIORITY),
+    INFI_FIXED_FRAME(SET_BATTERY_TYPE),
+    INFI_FIXED_FRAME(SET_DATE_TIME)
+  };
+
+#undef INFI_FIXED_FRAME
+#undef INFI_FRAME_BYTE
+
+  static_assert(sizeof(FIXED_FRAMES) / sizeof(FIXED_FRAMES[0]) == NUM_COMMAND_TYPES,
+                "FIXED_FRAMES needs one entry per COMMAND_TYPE");
+
+  // Every fixed frame must fit in FIXED_FRAME_SZ, checked from index i onwards.
+  constexpr bool fixedFramesFit(BYTE i) {
+    return i >= NUM_COMMAND_TYPES ? true
+      : fixedFrameSize((COMMAND_TYPE)i) <= FIXED_FRAME_SZ && fixedFramesFit(i + 1);
+  }
+  static_assert(fixedFramesFit(0), "FIXED_FRAME_SZ is too small for the longest fixed frame");
+
+  bool hasFixedFrame(COMMAND_TYPE commandType) {
+    return INFI_READ_BYTE(&FIXED_FRAMES[commandType].len) != 0;
+  }
+
+  BYTE writeFixedFrame(COMMAND_TYPE commandType, Print &out) {
+    const InfiniFixedFrame *frame = &FIXED_FRAMES[commandType];
+    BYTE len = INFI_READ_BYTE(&frame->len);
+#if defined(__AVR__)
+    // The frame is in flash, so it has to come out a byte at a time.
+    for (BYTE i = 0; i < len; ++i) {
+      out.write(INFI_READ_BYTE(&frame->val[i]));
+    }
+#else
+    if (len > 0) {
+      out.write(frame->val, len);
+    }
+#endif
+    return len;
+  }
+}
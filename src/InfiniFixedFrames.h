@@ -0,0 +1,30 @@
+#ifndef INFINI_FIXED_FRAMES_H
+#define INFINI_FIXED_FRAMES_H
+
+#include <Print.h>
+#include "InfiniCommon.h"
+
+namespace INFI {
+
+  //! Room for the longest parameterless frame, ^P010MUCHGCR<CRC><cr>.
+  const BYTE FIXED_FRAME_SZ = 16;
+
+  /*!
+   * A complete command frame, CRC and '\r' included, built by the compiler.
+   * len is 0 for commands that take params, those still go through InfiniCommandMaker.
+   */
+  struct InfiniFixedFrame {
+    BYTE len;
+    BYTE val[FIXED_FRAME_SZ];
+  };
+
+  //! Whether commandType takes no params, so its frame never changes and is precomputed.
+  bool hasFixedFrame(COMMAND_TYPE commandType);
+
+  /*! Writes the precomputed frame for commandType to out.
+   * Returns the number of bytes written, 0 if commandType takes params and has no fixed frame.
+   */
+  BYTE writeFixedFrame(COMMAND_TYPE commandType, Print &out);
+}
+
+#endif
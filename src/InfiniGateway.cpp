@@ -0,0 +1,217 @@
+#include "InfiniGateway.h"
+
+#if INFI_MODULE_JSON
+#include <string.h>
+
+namespace INFI {
+
+  const char GATEWAY_TELEMETRY_TOPIC[] = "v1/gateway/telemetry";
+  const char GATEWAY_ATTRIBUTES_TOPIC[] = "v1/gateway/attributes";
+  const char GATEWAY_RPC_TOPIC[] = "v1/gateway/rpc";
+  const char GATEWAY_CONNECT_TOPIC[] = "v1/gateway/connect";
+
+  static const BYTE MAX_GATEWAY_DEVICES = 32;
+
+  //! Writes value in decimal into out, which holds 21 chars. Returns the number of digits.
+  static BYTE writeDecimal(unsigned long long value, char *out) {
+    char digits[20];
+    BYTE n = 0;
+    do {
+      digits[n++] = '0' + value % 10;
+      value /= 10;
+    } while (value != 0);
+    for (BYTE i = 0; i < n; ++i) {
+      out[i] = digits[n - 1 - i];
+    }
+    out[n] = '\0';
+    return n;
+  }
+
+  InfiniGateway::InfiniGateway(char *buffer, size_t bufferSize, const char *const *names, BYTE count,
+                               GatewayPublish publish, void *context) :
+    m_buffer(buffer),
+    m_bufferSize(bufferSize),
+    m_length(0),
+    m_names(names),
+    m_count(count < MAX_GATEWAY_DEVICES ? count : MAX_GATEWAY_DEVICES),
+    m_publish(publish),
+    m_context(context),
+    m_added(0),
+    m_open(m_count)
+  {
+    if (m_bufferSize > 0) {
+      m_buffer[0] = '\0';
+    }
+  }
+
+  BYTE InfiniGateway::deviceCount() const {
+    return m_count;
+  }
+
+  const char *InfiniGateway::deviceName(BYTE device) const {
+    return device < m_count ? m_names[device] : NULL;
+  }
+
+  BYTE InfiniGateway::findDevice(const char *name) const {
+    for (BYTE d = 0; name != NULL && d < m_count; ++d) {
+      if (strcmp(m_names[d], name) == 0) {
+        return d;
+      }
+    }
+    return m_count;
+  }
+
+  bool InfiniGateway::addTelemetry(BYTE device, const char *json, unsigned long long tsMs) {
+    if (device >= m_count || json == NULL) {
+      return false;
+    }
+    char ts[21];
+    BYTE tsLen = tsMs != 0 ? writeDecimal(tsMs, ts) : 0;
+    // {"ts":<ts>,"values":<json>} or just <json>.
+    const size_t sampleLen = strlen(json) + (tsMs != 0 ? tsLen + 18 : 0);
+    // ,"name":[ before the first sample of a device, "]}" and the terminator after the last.
+    const size_t openLen = strlen(m_names[device]) + 5;
+    const size_t trailerLen = 3;
+    if (openLen + sampleLen + trailerLen > m_bufferSize) {
+      return false;
+    }
+    bool sent = true;
+    const uint32_t bit = (uint32_t)1 << device;
+    if ((m_added & bit) != 0 && m_open != device) {
+      // A device only appears once per payload.
+      sent = flush();
+    }
+    size_t needed = (m_open == device ? 1 : openLen) + sampleLen + trailerLen;
+    if (m_length + needed > m_bufferSize) {
+      sent = flush() && sent;
+    }
+    if (m_open == device) {
+      append(",");
+    } else {
+      if (m_length == 0) {
+        append("{\"");
+      } else {
+        append("],\"");
+      }
+      append(m_names[device]);
+      append("\":[");
+      m_open = device;
+      m_added |= bit;
+    }
+    if (tsMs != 0) {
+      append("{\"ts\":");
+      append(ts, tsLen);
+      append(",\"values\":");
+      append(json);
+      append("}");
+    } else {
+      append(json);
+    }
+    return sent;
+  }
+
+  bool InfiniGateway::flush() {
+    if (m_length == 0) {
+      return true;
+    }
+    append("]}");
+    bool sent = m_publish == NULL || m_publish(GATEWAY_TELEMETRY_TOPIC, m_buffer, m_context);
+    m_length = 0;
+    m_buffer[0] = '\0';
+    m_added = 0;
+    m_open = m_count;
+    return sent;
+  }
+
+  bool InfiniGateway::isEmpty() const {
+    return m_length == 0;
+  }
+
+  bool InfiniGateway::connectDevice(BYTE device, const char *type) {
+    if (device >= m_count) {
+      return false;
+    }
+    bool sent = flush();
+    if (!append("{\"device\":\"") || !append(m_names[device]) || !append("\"") ||
+        (type != NULL && (!append(",\"type\":\"") || !append(type) || !append("\""))) || !append("}")) {
+      m_length = 0;
+      m_buffer[0] = '\0';
+      return false;
+    }
+    sent = (m_publish == NULL || m_publish(GATEWAY_CONNECT_TOPIC, m_buffer, m_context)) && sent;
+    m_length = 0;
+    m_buffer[0] = '\0';
+    return sent;
+  }
+
+  bool InfiniGateway::publishAttributes(BYTE device, const char *json) {
+    return publishWrapped(GATEWAY_ATTRIBUTES_TOPIC, device, json);
+  }
+
+  bool InfiniGateway::handleRpc(const char *payload, size_t len, GatewayRpcHandler handler, void *context) {
+    JsonDocument request;
+    if (deserializeJson(request, payload, len) != DeserializationError::Ok) {
+      return false;
+    }
+    const char *name = request["device"];
+    JsonVariantConst data = request["data"];
+    if (name == NULL || !data["id"].is<long>()) {
+      return false;
+    }
+    const char *method = data["method"] | "";
+
+    JsonDocument reply;
+    reply["device"] = name;
+    reply["id"] = data["id"];
+    JsonObject result = reply["data"].to<JsonObject>();
+    BYTE device = findDevice(name);
+    if (device >= m_count) {
+      result["error"] = "unknown device";
+    } else if (handler == NULL || !handler(device, method, data["params"], result, context)) {
+      result.clear();
+      result["error"] = "unknown method";
+    }
+
+    // The reply goes through the buffer, after whatever telemetry was gathered in it.
+    bool sent = flush();
+    size_t written = serializeJson(reply, m_buffer, m_bufferSize);
+    if (written == 0 || written >= m_bufferSize - 1) {
+      m_buffer[0] = '\0';
+      return false;
+    }
+    sent = (m_publish == NULL || m_publish(GATEWAY_RPC_TOPIC, m_buffer, m_context)) && sent;
+    m_buffer[0] = '\0';
+    return sent;
+  }
+
+  bool InfiniGateway::publishWrapped(const char *topic, BYTE device, const char *json) {
+    if (device >= m_count || json == NULL) {
+      return false;
+    }
+    bool sent = flush();
+    if (!append("{\"") || !append(m_names[device]) || !append("\":") || !append(json) || !append("}")) {
+      m_length = 0;
+      m_buffer[0] = '\0';
+      return false;
+    }
+    sent = (m_publish == NULL || m_publish(topic, m_buffer, m_context)) && sent;
+    m_length = 0;
+    m_buffer[0] = '\0';
+    return sent;
+  }
+
+  bool InfiniGateway::append(const char *in, size_t len) {
+    if (m_length + len + 1 > m_bufferSize) {
+      return false;
+    }
+    memcpy(m_buffer + m_length, in, len);
+    m_length += len;
+    m_buffer[m_length] = '\0';
+    return true;
+  }
+
+  bool InfiniGateway::append(const char *in) {
+    return append(in, strlen(in));
+  }
+}
+#endif
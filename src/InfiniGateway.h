@@ -0,0 +1,90 @@
+#ifndef INFINI_GATEWAY_H
+#define INFINI_GATEWAY_H
+
+#include <stddef.h>
+#include "InfiniCommon.h"
+
+#if INFI_MODULE_JSON
+#include <ArduinoJson.h>
+
+namespace INFI {
+
+  //! ThingsBoard's gateway API topics, the session is opened with the gateway device's token.
+  extern const char GATEWAY_TELEMETRY_TOPIC[];
+  extern const char GATEWAY_ATTRIBUTES_TOPIC[];
+  extern const char GATEWAY_RPC_TOPIC[];
+  extern const char GATEWAY_CONNECT_TOPIC[];
+
+  //! Publishes payload on topic, e.g. with PubSubClient::publish(). Returns false if it could not be sent.
+  typedef bool (*GatewayPublish)(const char *topic, const char *payload, void *context);
+
+  /*! Handles the gateway RPC method for device, with the request's params, writing the reply's members
+   * into result. Returns false if device has no such method.
+   */
+  typedef bool (*GatewayRpcHandler)(BYTE device, const char *method, JsonVariantConst params, JsonObject result,
+                                    void *context);
+
+  /*!
+   * Publishes the telemetry of several inverters over one ThingsBoard MQTT session, the gateway's, instead of
+   * a session per device token. Each inverter is a device of the gateway, named by names[device], which
+   * ThingsBoard creates on its first message. Telemetry is gathered into one v1/gateway/telemetry payload,
+   * {"name":[{...},{"ts":...,"values":{...}}],...}, every device once with all its samples in one array,
+   * and only published by flush() or when the buffer is full. A device that comes up again once another
+   * followed it starts a new payload, so feed it device by device, e.g. from one InfiniTelemetryBatch each.
+   * The RPCs ThingsBoard sends a device are routed by handleRpc() and answered on v1/gateway/rpc.
+   * Attributes and connects go out at once, after the gathered telemetry, through the same buffer.
+   */
+  class InfiniGateway {
+    public:
+    /*! count devices named names, which must outlive the gateway, at most 32. buffer holds a whole payload,
+     * within the MQTT client's buffer less its header and topic.
+     */
+    InfiniGateway(char *buffer, size_t bufferSize, const char *const *names, BYTE count,
+                  GatewayPublish publish, void *context = NULL);
+
+    BYTE deviceCount() const;
+    const char *deviceName(BYTE device) const;
+    //! The device named name, deviceCount() if there is none.
+    BYTE findDevice(const char *name) const;
+
+    /*! Adds json, a flat object of telemetry, as a sample of device, stamped tsMs unless it is 0.
+     * Returns false if it can not fit even in an empty payload, or an early flush failed.
+     */
+    bool addTelemetry(BYTE device, const char *json, unsigned long long tsMs = 0);
+    //! Publishes the telemetry gathered, if any. Returns false if the publish failed.
+    bool flush();
+    bool isEmpty() const;
+
+    //! Tells ThingsBoard device is online, as type, e.g. on every connect. NULL leaves the type default.
+    bool connectDevice(BYTE device, const char *type = NULL);
+    //! Publishes json, a flat object, as client attributes of device.
+    bool publishAttributes(BYTE device, const char *json);
+
+    /*! Parses an RPC request, the payload of a v1/gateway/rpc message, runs handler for its device and method,
+     * and publishes the reply. A request for another device or method is answered with an "error" member.
+     * Returns false if the payload is no request or the reply could not be sent.
+     */
+    bool handleRpc(const char *payload, size_t len, GatewayRpcHandler handler, void *context = NULL);
+
+    private:
+    //! Writes {"name":json} into the emptied buffer and publishes it on topic.
+    bool publishWrapped(const char *topic, BYTE device, const char *json);
+    bool append(const char *in, size_t len);
+    bool append(const char *in);
+
+    char *m_buffer;
+    size_t m_bufferSize;
+    size_t m_length;
+    const char *const *m_names;
+    BYTE m_count;
+    GatewayPublish m_publish;
+    void *m_context;
+    //! Bit per device already in the payload.
+    uint32_t m_added;
+    //! The device whose array is still open, m_count if none.
+    BYTE m_open;
+  };
+}
+#endif
+
+#endif
@@ -0,0 +1,88 @@
+#include "InfiniGsCadence.h"
+
+#if INFI_MODULE_SCHEDULER
+
+namespace INFI {
+
+  InfiniGsCadence::InfiniGsCadence(unsigned long floorMs, unsigned long ceilingMs) :
+    m_tracked(0),
+    m_floorMs(floorMs),
+    m_ceilingMs(ceilingMs < floorMs ? floorMs : ceilingMs),
+    m_periodMs(floorMs),
+    m_stepMs(0)
+  {
+    reset();
+  }
+
+  bool InfiniGsCadence::track(GS_FIELD field, WORD perSecond) {
+    if (m_tracked >= GS_CADENCE_FIELDS_SZ || field >= NUM_GS_FIELDS) {
+      return false;
+    }
+    m_fields[m_tracked].field = field;
+    m_fields[m_tracked].perSecond = perSecond;
+    m_tracked++;
+    return true;
+  }
+
+  void InfiniGsCadence::setBounds(unsigned long floorMs, unsigned long ceilingMs) {
+    m_floorMs = floorMs;
+    m_ceilingMs = ceilingMs < floorMs ? floorMs : ceilingMs;
+    if (m_periodMs < m_floorMs) {
+      m_periodMs = m_floorMs;
+    } else if (m_periodMs > m_ceilingMs) {
+      m_periodMs = m_ceilingMs;
+    }
+  }
+
+  bool InfiniGsCadence::update(const GeneralStatusFixed &gs, BYTE device, unsigned long nowMs) {
+    if (device >= POLL_SCHEDULER_DEVICES) {
+      return false;
+    }
+    bool moving = false;
+    // The change may have happened anywhere between the two samples, so ones further apart count as 1 s apart.
+    // Otherwise a long period would average a cloud edge away and never speed up again.
+    unsigned long elapsedMs = nowMs - m_lastMs[device];
+    elapsedMs = elapsedMs == 0 ? 1 : (elapsedMs > 1000 ? 1000 : elapsedMs);
+    for (BYTE i = 0; i < m_tracked; ++i) {
+      long value = getGeneralStatusField(gs, m_fields[i].field);
+      if (m_hasLast[device]) {
+        long change = value - m_last[device][i];
+        if (change < 0) {
+          change = -change;
+        }
+        // change / elapsed s > perSecond, without the division.
+        if ((unsigned long)change * 1000UL > (unsigned long)m_fields[i].perSecond * elapsedMs) {
+          moving = true;
+        }
+      }
+      m_last[device][i] = value;
+    }
+    m_lastMs[device] = nowMs;
+    m_hasLast[device] = true;
+
+    const unsigned long before = m_periodMs;
+    if (moving) {
+      m_periodMs = m_floorMs;
+      m_stepMs = nowMs;
+    } else if (nowMs - m_stepMs >= (m_periodMs > 0 ? m_periodMs : 1000) && m_periodMs < m_ceilingMs) {
+      // Stable for a whole period. From a floor of 0 it takes a stable second, then goes to 1 s.
+      unsigned long next = m_periodMs > 0 ? m_periodMs * 2 : 1000;
+      m_periodMs = next < m_periodMs || next > m_ceilingMs ? m_ceilingMs : next;
+      m_stepMs = nowMs;
+    }
+    return m_periodMs != before;
+  }
+
+  unsigned long InfiniGsCadence::periodMs() const {
+    return m_periodMs;
+  }
+
+  void InfiniGsCadence::reset() {
+    for (BYTE d = 0; d < POLL_SCHEDULER_DEVICES; ++d) {
+      m_hasLast[d] = false;
+      m_lastMs[d] = 0;
+    }
+    m_periodMs = m_floorMs;
+  }
+}
+#endif
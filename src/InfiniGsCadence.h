@@ -0,0 +1,64 @@
+#ifndef INFINI_GS_CADENCE_H
+#define INFINI_GS_CADENCE_H
+
+#include "InfiniDeltaTelemetry.h"
+#include "InfiniPollScheduler.h"
+
+// GS fields one InfiniGsCadence can watch.
+#ifndef INFI_GS_CADENCE_FIELDS_SZ
+#define INFI_GS_CADENCE_FIELDS_SZ 4
+#endif
+
+namespace INFI {
+
+  const BYTE GS_CADENCE_FIELDS_SZ = INFI_GS_CADENCE_FIELDS_SZ;
+
+  /*!
+   * Picks the GS polling period from how fast the readings move, so cloud transients are sampled closely
+   * and a quiet night costs next to no link time or uplink. Every sample is compared with the previous one
+   * of the same device: if a watched field changed faster than its threshold, the period drops to the floor
+   * at once. Samples more than 1 s apart count as 1 s apart, the change may have been a step anywhere in between.
+   * Once a whole period went by without such a change, the period doubles, up to the ceiling.
+   * Feed it every GS from the callback and pass periodMs() to InfiniPollScheduler::setPeriod() when update() says so.
+   */
+  class InfiniGsCadence {
+    public:
+    //! Starts at floorMs, so the first samples come quickly. A floor of 0 polls GS as fast as the link answers.
+    InfiniGsCadence(unsigned long floorMs, unsigned long ceilingMs);
+
+    /*! Speeds up whenever field changes by more than perSecond a second, in its stored units,
+     * e.g. 50 for GS_PV1_IN_POW is 50 W/s. Returns false if GS_CADENCE_FIELDS_SZ are watched already.
+     */
+    bool track(GS_FIELD field, WORD perSecond);
+
+    //! Changes the floor and ceiling, the period is put back within them. Equal ones pin the period.
+    void setBounds(unsigned long floorMs, unsigned long ceilingMs);
+
+    //! Takes the GS sample of device read at nowMs. Returns true if periodMs() changed.
+    bool update(const GeneralStatusFixed &gs, BYTE device, unsigned long nowMs);
+
+    unsigned long periodMs() const;
+
+    //! Forgets the previous samples, e.g. after the link was down, and goes back to the floor.
+    void reset();
+
+    private:
+    struct Field {
+      GS_FIELD field;
+      WORD perSecond;
+    };
+
+    Field m_fields[GS_CADENCE_FIELDS_SZ];
+    BYTE m_tracked;
+    unsigned long m_floorMs;
+    unsigned long m_ceilingMs;
+    unsigned long m_periodMs;
+    //! When the period last changed, or the readings last moved.
+    unsigned long m_stepMs;
+    long m_last[POLL_SCHEDULER_DEVICES][GS_CADENCE_FIELDS_SZ];
+    unsigned long m_lastMs[POLL_SCHEDULER_DEVICES];
+    bool m_hasLast[POLL_SCHEDULER_DEVICES];
+  };
+}
+
+#endif
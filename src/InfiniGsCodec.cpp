@@ -0,0 +1,211 @@
+#include "InfiniGsCodec.h"
+
+#if INFI_MODULE_BINARY
+#include "InfiniColumnKernels.h"
+
+namespace INFI {
+
+  // The timestamps, then one per GS_FIELD.
+  static const BYTE CODEC_COLUMNS = 1 + NUM_GS_FIELDS;
+  // A uint64 takes at most 10 varint bytes.
+  static const BYTE MAX_VARINT_SZ = 10;
+
+  static size_t writeVarint(Print &out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+      n += out.write((uint8_t)(value | 0x80));
+      value >>= 7;
+    }
+    return n + out.write((uint8_t)value);
+  }
+
+  static bool readVarint(const BYTE *buf, size_t len, size_t &pos, uint64_t &value) {
+    value = 0;
+    for (BYTE i = 0; i < MAX_VARINT_SZ && pos < len; ++i) {
+      const BYTE b = buf[pos++];
+      value |= (uint64_t)(b & 0x7F) << (7 * i);
+      if ((b & 0x80) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static uint64_t zigZag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+  }
+
+  static int64_t unZigZag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+  }
+
+  static int64_t columnValue(const InfiniGsHistory &history, BYTE column, unsigned long index) {
+    if (column == 0) {
+      return (int64_t)history.timestamp(index);
+    }
+    return history.value((GS_FIELD)(column - 1), index);
+  }
+
+  static size_t writeZeros(Print &out, BYTE &zeros) {
+    if (zeros == 0) {
+      return 0;
+    }
+    size_t n = writeVarint(out, 0);
+    n += writeVarint(out, zeros - 1);
+    zeros = 0;
+    return n;
+  }
+
+  static size_t writeColumn(const InfiniGsHistory &history, BYTE column, BYTE count, Print &out) {
+    size_t n = 0;
+    int64_t prev = 0;
+    int64_t prevDelta = 0;
+    BYTE zeros = 0;
+    for (BYTE i = 0; i < count; ++i) {
+      const int64_t value = columnValue(history, column, i);
+      const int64_t delta = value - prev;
+      const int64_t token = delta - prevDelta;
+      prev = value;
+      if (column == 0 && i > 0) {
+        prevDelta = delta;
+      }
+      if (token == 0) {
+        zeros++;
+      } else {
+        n += writeZeros(out, zeros);
+        n += writeVarint(out, zigZag(token));
+      }
+    }
+    return n + writeZeros(out, zeros);
+  }
+
+  // Tokens of a WORD column are made in chunks of this many, on the stack.
+  static const BYTE TOKEN_CHUNK = 32;
+
+  // writeColumn() for a field stored as a WORD, whose tokens are just the zig-zag differences.
+  // Runs over the contiguous column rather than looking every sample up.
+  static size_t writeWordColumn(const InfiniGsHistory &history, GS_FIELD field, BYTE count, Print &out) {
+    size_t n = 0;
+    WORD prev = 0;
+    BYTE zeros = 0;
+    uint32_t tokens[TOKEN_CHUNK];
+    for (unsigned long i = 0; i < count;) {
+      unsigned long run;
+      const WORD *values = history.wordColumn(field, i, run);
+      if (run > count - i) {
+        run = count - i;
+      }
+      for (unsigned long j = 0; j < run;) {
+        const BYTE chunk = run - j < TOKEN_CHUNK ? (BYTE)(run - j) : TOKEN_CHUNK;
+        wordColumnDeltas(values + j, chunk, prev, tokens);
+        prev = values[j + chunk - 1];
+        for (BYTE k = 0; k < chunk; ++k) {
+          if (tokens[k] == 0) {
+            zeros++;
+          } else {
+            n += writeZeros(out, zeros);
+            n += writeVarint(out, tokens[k]);
+          }
+        }
+        j += chunk;
+      }
+      i += run;
+    }
+    return n + writeZeros(out, zeros);
+  }
+
+  size_t writeGsHistoryBinary(const InfiniGsHistory &history, BYTE count, Print &out) {
+    if (count > history.size()) {
+      count = (BYTE)history.size();
+    }
+    if (count == 0) {
+      return 0;
+    }
+    size_t n = out.write(BINARY_SCHEMA_VERSION);
+    n += out.write((uint8_t)BINARY_GS_HISTORY);
+    n += out.write(count);
+    for (BYTE c = 0; c < CODEC_COLUMNS; ++c) {
+      unsigned long run;
+      if (c > 0 && history.wordColumn((GS_FIELD)(c - 1), 0, run) != NULL) {
+        n += writeWordColumn(history, (GS_FIELD)(c - 1), count, out);
+      } else {
+        n += writeColumn(history, c, count, out);
+      }
+    }
+    return n;
+  }
+
+  // Where the decoder is in one column.
+  struct CodecCursor {
+    size_t pos;
+    int64_t value;
+    int64_t delta;
+    //! Tokens of 0 still to come from the current run.
+    BYTE zeros;
+  };
+
+  // Moves cursor on to the value of sample index. False if the column ends early.
+  static bool step(CodecCursor &cursor, const BYTE *buf, size_t len, BYTE column, BYTE index) {
+    int64_t token = 0;
+    if (cursor.zeros > 0) {
+      cursor.zeros--;
+    } else {
+      uint64_t raw;
+      if (!readVarint(buf, len, cursor.pos, raw)) {
+        return false;
+      }
+      if (raw == 0) {
+        uint64_t run;
+        if (!readVarint(buf, len, cursor.pos, run) || run > 0xFF) {
+          return false;
+        }
+        cursor.zeros = (BYTE)run;
+      } else {
+        token = unZigZag(raw);
+      }
+    }
+    const int64_t delta = (column == 0 && index > 0 ? cursor.delta : 0) + token;
+    cursor.value += delta;
+    if (column == 0 && index > 0) {
+      cursor.delta = delta;
+    }
+    return true;
+  }
+
+  BYTE readGsHistoryBinary(const BYTE *buf, size_t len, InfiniGsHistory &out) {
+    if (len < BINARY_HEADER_SZ || buf[0] != BINARY_SCHEMA_VERSION || buf[1] != BINARY_GS_HISTORY || buf[2] == 0) {
+      return 0;
+    }
+    const BYTE count = buf[2];
+    // Find where each column starts, decoding them once. This also checks the whole record is there.
+    CodecCursor cursors[CODEC_COLUMNS];
+    size_t pos = BINARY_HEADER_SZ;
+    for (BYTE c = 0; c < CODEC_COLUMNS; ++c) {
+      CodecCursor scan = { pos, 0, 0, 0 };
+      for (BYTE i = 0; i < count; ++i) {
+        if (!step(scan, buf, len, c, i)) {
+          return 0;
+        }
+      }
+      if (scan.zeros != 0) {
+        // A run longer than the samples.
+        return 0;
+      }
+      CodecCursor start = { pos, 0, 0, 0 };
+      cursors[c] = start;
+      pos = scan.pos;
+    }
+    // Then sample by sample, one step in every column.
+    for (BYTE i = 0; i < count; ++i) {
+      step(cursors[0], buf, len, 0, i);
+      GeneralStatusFixed gs;
+      for (BYTE f = 0; f < NUM_GS_FIELDS; ++f) {
+        step(cursors[f + 1], buf, len, f + 1, i);
+        setGeneralStatusField(gs, (GS_FIELD)f, (long)cursors[f + 1].value);
+      }
+      out.push(gs, (uint64_t)cursors[0].value);
+    }
+    return count;
+  }
+}
+#endif
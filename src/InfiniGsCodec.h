@@ -0,0 +1,36 @@
+#ifndef INFINI_GS_CODEC_H
+#define INFINI_GS_CODEC_H
+
+#include <stdint.h>
+#include "InfiniBinaryWriter.h"
+#include "InfiniGsHistory.h"
+
+namespace INFI {
+
+  /*!
+   * A compressed BINARY_GS_HISTORY record, for keeping many more buffered samples in the same flash or RTC memory.
+   * Consecutive GS samples hardly differ, and the flags and states almost never change, so each column of an
+   * InfiniGsHistory is written as the differences between samples, most of them 0 or small.
+   *
+   * The header is the schema version, BINARY_GS_HISTORY and the number of samples, 1 to 255.
+   * The length is not in the header, the record runs to the end of what the transport delivers.
+   * Then come 1 + NUM_GS_FIELDS columns back to back: the timestamps, then the fields in GS_FIELD order.
+   * Each column is a list of tokens, one per sample, each the difference d to the previous sample (the first
+   * sample's to 0). For the timestamps the token is d minus the previous d from the second sample on,
+   * so samples taken at a steady period give 0.
+   * A token t other than 0 is written as the zig-zag (t << 1) ^ (t >> 63) of it, an unsigned LEB128 varint:
+   * 7 bits per byte, least significant first, the top bit set on every byte but the last. A run of n tokens
+   * of 0 is written as varint 0 followed by varint n - 1.
+   * On a steady site a sample takes a few bytes instead of its BINARY_GS_SAMPLE_SZ.
+   *
+   * Writes the oldest count samples of history, at most 255 and size(). Returns the bytes written, 0 if there are none.
+   */
+  size_t writeGsHistoryBinary(const InfiniGsHistory &history, BYTE count, Print &out);
+
+  /*! Decodes a record of writeGsHistoryBinary() and pushes its samples into out.
+   * Returns the number pushed. 0, pushing nothing, if buf does not hold a whole record of this schema version.
+   */
+  BYTE readGsHistoryBinary(const BYTE *buf, size_t len, InfiniGsHistory &out);
+}
+
+#endif
@@ -0,0 +1,326 @@
+#include "InfiniGsHistory.h"
+
+#if INFI_MODULE_BINARY
+#include "InfiniColumnKernels.h"
+#if INFI_ENABLE_PSRAM
+#include <esp_heap_caps.h>
+#endif
+
+namespace INFI {
+
+  // The WORD column of field, or -1 if it is not stored as a WORD. Column 15 holds the 2 bit states.
+  static int wordColumnOf(GS_FIELD field) {
+    if (field <= GS_AC_OUT_ACTIVE_POW) {
+      return field;
+    }
+    if (field >= GS_BATT_VOLT && field <= GS_BATT_CHARGE_CURR) {
+      return field - 1;
+    }
+    if (field >= GS_PV1_IN_POW && field <= GS_PV2_IN_VOLT) {
+      return field - 5;
+    }
+    return -1;
+  }
+
+  // The BYTE column of field, or -1.
+  static int byteColumnOf(GS_FIELD field) {
+    if (field == GS_OUT_LOAD_PCT) {
+      return 0;
+    }
+    if (field >= GS_BATT_CAPACITY && field <= GS_MPPT2_CHRGR_TEMP) {
+      return field - GS_BATT_CAPACITY + 1;
+    }
+    return -1;
+  }
+
+  InfiniGsHistory::InfiniGsHistory() :
+    m_ts(m_internalTs),
+    m_words(m_internalWords),
+    m_bytes(m_internalBytes),
+    m_capacity(GS_HISTORY_SZ),
+    m_head(0),
+    m_count(0),
+    m_dropped(0)
+  {}
+
+  InfiniGsHistory::~InfiniGsHistory() {
+#if INFI_ENABLE_PSRAM
+    if (m_ts != m_internalTs) {
+      heap_caps_free(m_ts);
+    }
+#endif
+  }
+
+  bool InfiniGsHistory::allocate(unsigned long capacity) {
+#if INFI_ENABLE_PSRAM
+    if (capacity <= GS_HISTORY_SZ) {
+      return false;
+    }
+    // One block for every column, timestamps first so they stay 8 byte aligned.
+    // NULL when the board has no PSRAM, or not that much of it.
+    void *block = heap_caps_malloc(capacity * SAMPLE_SZ, MALLOC_CAP_SPIRAM);
+    if (block == NULL) {
+      return false;
+    }
+    if (m_ts != m_internalTs) {
+      heap_caps_free(m_ts);
+    }
+    setColumns(block, capacity);
+    m_head = 0;
+    m_count = 0;
+    return true;
+#else
+    (void)capacity;
+    return false;
+#endif
+  }
+
+  void InfiniGsHistory::setColumns(void *block, unsigned long capacity) {
+    m_ts = (uint64_t *)block;
+    m_words = (WORD *)(m_ts + capacity);
+    m_bytes = (BYTE *)(m_words + WORD_COLUMNS * capacity);
+    m_capacity = capacity;
+  }
+
+  unsigned long InfiniGsHistory::capacity() const {
+    return m_capacity;
+  }
+
+  unsigned long InfiniGsHistory::slot(unsigned long index) const {
+    return (m_head + index) % m_capacity;
+  }
+
+  void InfiniGsHistory::store(unsigned long slot, const GeneralStatusFixed &gs) {
+    WORD *words = m_words + slot;
+    const unsigned long c = m_capacity;
+    words[0 * c] = gs.gridVoltDeci;
+    words[1 * c] = gs.gridFreqDeci;
+    words[2 * c] = gs.acOutVoltDeci;
+    words[3 * c] = gs.acOutFreqDeci;
+    words[4 * c] = gs.acOutApparentPow;
+    words[5 * c] = gs.acOutActivePow;
+    words[6 * c] = gs.battVoltDeci;
+    words[7 * c] = gs.battVoltSCCDeci;
+    words[8 * c] = gs.battVoltSCC2Deci;
+    words[9 * c] = gs.battDischargeCurr;
+    words[10 * c] = gs.battChargeCurr;
+    words[11 * c] = gs.pv1InPow;
+    words[12 * c] = gs.pv2InPow;
+    words[13 * c] = gs.pv1InVoltDeci;
+    words[14 * c] = gs.pv2InVoltDeci;
+    words[15 * c] = (WORD)(gs.settingsChanged | gs.loadConnection << 1 | gs.mppt1ChrgrStatus << 2 |
+                           gs.mppt2ChrgrStatus << 4 | gs.battPowDir << 6 | gs.dcACPowDir << 8 |
+                           gs.linePowDir << 10 | (WORD)gs.localParallelId << 12);
+    BYTE *bytes = m_bytes + slot;
+    bytes[0 * c] = gs.outLoadPct;
+    bytes[1 * c] = gs.battCapacity;
+    bytes[2 * c] = gs.invHeatSinkTemp;
+    bytes[3 * c] = gs.mppt1ChrgrTemp;
+    bytes[4 * c] = gs.mppt2ChrgrTemp;
+  }
+
+  void InfiniGsHistory::load(unsigned long slot, GeneralStatusFixed &gs) const {
+    const WORD *words = m_words + slot;
+    const unsigned long c = m_capacity;
+    gs.gridVoltDeci = words[0 * c];
+    gs.gridFreqDeci = words[1 * c];
+    gs.acOutVoltDeci = words[2 * c];
+    gs.acOutFreqDeci = words[3 * c];
+    gs.acOutApparentPow = words[4 * c];
+    gs.acOutActivePow = words[5 * c];
+    gs.battVoltDeci = words[6 * c];
+    gs.battVoltSCCDeci = words[7 * c];
+    gs.battVoltSCC2Deci = words[8 * c];
+    gs.battDischargeCurr = words[9 * c];
+    gs.battChargeCurr = words[10 * c];
+    gs.pv1InPow = words[11 * c];
+    gs.pv2InPow = words[12 * c];
+    gs.pv1InVoltDeci = words[13 * c];
+    gs.pv2InVoltDeci = words[14 * c];
+    const WORD states = words[15 * c];
+    gs.settingsChanged = states & 1;
+    gs.loadConnection = (states >> 1) & 1;
+    gs.mppt1ChrgrStatus = (states >> 2) & 3;
+    gs.mppt2ChrgrStatus = (states >> 4) & 3;
+    gs.battPowDir = (states >> 6) & 3;
+    gs.dcACPowDir = (states >> 8) & 3;
+    gs.linePowDir = (states >> 10) & 3;
+    gs.localParallelId = (states >> 12) & 0xF;
+    const BYTE *bytes = m_bytes + slot;
+    gs.outLoadPct = bytes[0 * c];
+    gs.battCapacity = bytes[1 * c];
+    gs.invHeatSinkTemp = bytes[2 * c];
+    gs.mppt1ChrgrTemp = bytes[3 * c];
+    gs.mppt2ChrgrTemp = bytes[4 * c];
+  }
+
+  void InfiniGsHistory::push(const GeneralStatusFixed &gs, uint64_t tsMs) {
+    if (m_count == m_capacity) {
+      // Full, the oldest goes.
+      m_head = (m_head + 1) % m_capacity;
+      m_count--;
+      m_dropped++;
+    }
+    const unsigned long s = slot(m_count);
+    m_ts[s] = tsMs;
+    store(s, gs);
+    m_count++;
+  }
+
+  unsigned long InfiniGsHistory::size() const {
+    return m_count;
+  }
+
+  bool InfiniGsHistory::isEmpty() const {
+    return m_count == 0;
+  }
+
+  unsigned long InfiniGsHistory::dropped() const {
+    return m_dropped;
+  }
+
+#if INFI_MODULE_JSON
+  BYTE InfiniGsHistory::writeJson(Print &out, GeneralStatusDelta &delta, size_t maxLen) const {
+    // '[' and ']' always go out.
+    size_t len = 2;
+    BYTE consumed = 0;
+    bool first = true;
+    out.print('[');
+    for (; consumed < m_count && consumed < 0xFF; ++consumed) {
+      const unsigned long s = slot(consumed);
+      GeneralStatusFixed gs;
+      load(s, gs);
+      if (delta.hasChanges(gs)) {
+        InfiniCountingPrint counter;
+        size_t sampleLen = writeSample(counter, m_ts[s], gs, delta, first);
+        if (len + sampleLen > maxLen) {
+          if (!first) {
+            break;
+          }
+          // Does not fit even on its own, so it never will. Skip it rather than wedge the ring.
+          continue;
+        }
+        len += writeSample(out, m_ts[s], gs, delta, first);
+        first = false;
+      }
+      delta.markPublished(gs);
+    }
+    out.print(']');
+    return consumed;
+  }
+#endif
+
+  void InfiniGsHistory::pop(unsigned long count) {
+    if (count > m_count) {
+      count = m_count;
+    }
+    m_head = (m_head + count) % m_capacity;
+    m_count -= count;
+  }
+
+  bool InfiniGsHistory::oldest(GeneralStatusFixed &gs, uint64_t &tsMs) const {
+    return at(0, gs, tsMs);
+  }
+
+  bool InfiniGsHistory::at(unsigned long index, GeneralStatusFixed &gs, uint64_t &tsMs) const {
+    if (index >= m_count) {
+      return false;
+    }
+    const unsigned long s = slot(index);
+    load(s, gs);
+    tsMs = m_ts[s];
+    return true;
+  }
+
+  long InfiniGsHistory::value(GS_FIELD field, unsigned long index) const {
+    if (index >= m_count) {
+      return 0;
+    }
+    const unsigned long s = slot(index);
+    const int w = wordColumnOf(field);
+    if (w >= 0) {
+      return m_words[w * m_capacity + s];
+    }
+    const int b = byteColumnOf(field);
+    if (b >= 0) {
+      return m_bytes[b * m_capacity + s];
+    }
+    GeneralStatusFixed gs;
+    load(s, gs);
+    return getGeneralStatusField(gs, field);
+  }
+
+  uint64_t InfiniGsHistory::timestamp(unsigned long index) const {
+    return index < m_count ? m_ts[slot(index)] : 0;
+  }
+
+  const WORD *InfiniGsHistory::wordColumn(GS_FIELD field, unsigned long index, unsigned long &count) const {
+    count = 0;
+    const int w = wordColumnOf(field);
+    if (w < 0 || index >= m_count) {
+      return NULL;
+    }
+    const unsigned long s = slot(index);
+    const unsigned long toEnd = m_capacity - s;
+    count = m_count - index < toEnd ? m_count - index : toEnd;
+    return m_words + w * m_capacity + s;
+  }
+
+  bool InfiniGsHistory::summarize(GS_FIELD field, long &min, long &max, unsigned long &sum) const {
+    if (m_count == 0 || field >= NUM_GS_FIELDS) {
+      return false;
+    }
+    const int b = byteColumnOf(field);
+    if (wordColumnOf(field) < 0 && b < 0) {
+      // A 2 bit state, unpacked sample by sample.
+      min = max = value(field, 0);
+      sum = 0;
+      for (unsigned long i = 0; i < m_count; ++i) {
+        const long v = value(field, i);
+        min = v < min ? v : min;
+        max = v > max ? v : max;
+        sum += v;
+      }
+      return true;
+    }
+    WORD lo = 0xFFFF;
+    WORD hi = 0;
+    sum = 0;
+    // At most two contiguous runs, the ring wraps once.
+    for (unsigned long i = 0; i < m_count;) {
+      const unsigned long s = slot(i);
+      const unsigned long run = m_count - i < m_capacity - s ? m_count - i : m_capacity - s;
+      if (b >= 0) {
+        const BYTE *v = m_bytes + b * m_capacity + s;
+        for (unsigned long j = 0; j < run; ++j) {
+          lo = v[j] < lo ? v[j] : lo;
+          hi = v[j] > hi ? v[j] : hi;
+          sum += v[j];
+        }
+      } else {
+        wordColumnStats(m_words + wordColumnOf(field) * m_capacity + s, run, lo, hi, sum);
+      }
+      i += run;
+    }
+    min = lo;
+    max = hi;
+    return true;
+  }
+
+#if INFI_MODULE_JSON
+  size_t InfiniGsHistory::writeSample(Print &out, uint64_t tsMs, const GeneralStatusFixed &gs, const GeneralStatusDelta &delta,
+                                      bool first) {
+    size_t n = 0;
+    if (!first) {
+      n += out.print(',');
+    }
+    n += out.print(INFI_F("{\"ts\":"));
+    n += printUint64(tsMs, out);
+    n += out.print(INFI_F(",\"values\":"));
+    n += delta.writeJson(gs, out);
+    n += out.print('}');
+    return n;
+  }
+#endif
+}
+#endif
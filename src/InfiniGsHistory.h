@@ -0,0 +1,130 @@
+#ifndef INFINI_GS_HISTORY_H
+#define INFINI_GS_HISTORY_H
+
+#include <stdint.h>
+#include "InfiniDeltaTelemetry.h"
+
+// Number of timestamped GS samples kept between uploads, e.g. 60 s of samples every 2 s.
+#ifndef INFI_GS_HISTORY_SZ
+#define INFI_GS_HISTORY_SZ 32
+#endif
+
+// Whether InfiniGsHistory::allocate() may place a bigger ring in PSRAM. Detected the same way
+// as THINGSBOARD_ENABLE_PSRAM, whether the board has PSRAM fitted is only known at run time.
+#ifndef INFI_ENABLE_PSRAM
+#  if defined(ARDUINO_ARCH_ESP32) && defined(__has_include)
+#    if __has_include(<esp_heap_caps.h>)
+#      define INFI_ENABLE_PSRAM 1
+#    else
+#      define INFI_ENABLE_PSRAM 0
+#    endif
+#  else
+#    define INFI_ENABLE_PSRAM 0
+#  endif
+#endif
+
+namespace INFI {
+
+  const BYTE GS_HISTORY_SZ = INFI_GS_HISTORY_SZ;
+
+  /*!
+   * A fixed capacity ring of timestamped GS samples, so GS can be sampled every few seconds
+   * and uploaded in one go much less often. When full, the oldest sample makes room.
+   * writeJson() writes them as ThingsBoard's [{"ts":...,"values":{...}},...] telemetry array,
+   * each sample with only the fields a GeneralStatusDelta lets through.
+   * The GS_HISTORY_SZ samples live in the object itself, allocate() swaps them for a bigger ring in PSRAM.
+   *
+   * Samples are stored by column, one array per field at the width GeneralStatusFixed gives it,
+   * the 2 bit states sharing one WORD column. So a statistic over one field, summarize() or a
+   * delta encoder over wordColumn(), runs through contiguous memory instead of striding over whole samples.
+   */
+  class InfiniGsHistory {
+    public:
+    InfiniGsHistory();
+    ~InfiniGsHistory();
+
+    /*! Moves the ring to PSRAM with room for capacity samples, e.g. a day's worth, dropping what it held.
+     * Returns false, keeping the GS_HISTORY_SZ ring in internal RAM, without PSRAM or if it is too small.
+     */
+    bool allocate(unsigned long capacity);
+
+    //! The number of samples it holds at most.
+    unsigned long capacity() const;
+
+    //! Stores gs taken at tsMs, milliseconds since the Unix epoch.
+    void push(const GeneralStatusFixed &gs, uint64_t tsMs);
+
+    unsigned long size() const;
+    bool isEmpty() const;
+
+    //! Samples overwritten before they were uploaded, since construction.
+    unsigned long dropped() const;
+
+#if INFI_MODULE_JSON
+    /*! Writes the oldest samples to out as a telemetry array of at most maxLen chars, passing each
+     * through delta and marking it published there. Samples without changes are consumed but not written.
+     * Returns the number of samples consumed, at most 255, pop() them once the array was sent.
+     * Pass a copy of the delta and keep it only if the upload worked, so a failed upload can be retried.
+     * An array with nothing in it is written as []. A sample too long for maxLen on its own is skipped.
+     */
+    BYTE writeJson(Print &out, GeneralStatusDelta &delta, size_t maxLen) const;
+#endif
+
+    //! Drops the count oldest samples.
+    void pop(unsigned long count);
+
+    //! Copies out the oldest sample, false if there is none. E.g. to move it to an InfiniTelemetryLog.
+    bool oldest(GeneralStatusFixed &gs, uint64_t &tsMs) const;
+
+    //! Copies out sample index, 0 being the oldest. False past size().
+    bool at(unsigned long index, GeneralStatusFixed &gs, uint64_t &tsMs) const;
+
+    //! field of sample index, 0 being the oldest, or 0 past size().
+    long value(GS_FIELD field, unsigned long index) const;
+    //! The timestamp of sample index, or 0 past size().
+    uint64_t timestamp(unsigned long index) const;
+
+    //! The lowest, highest and summed field over every sample held. False if there are none.
+    bool summarize(GS_FIELD field, long &min, long &max, unsigned long &sum) const;
+
+    /*! The values of a field stored as a WORD (the Deci readings, powers and currents) from sample index on,
+     * as far as they run contiguously, count of them. NULL for the BYTE fields and 2 bit states, or past size().
+     * The ring wraps at most once, so a second call at index + count gets the rest.
+     */
+    const WORD *wordColumn(GS_FIELD field, unsigned long index, unsigned long &count) const;
+
+    private:
+#if INFI_MODULE_JSON
+    //! Writes {"ts":...,"values":...} for gs, preceded by ',' unless first.
+    static size_t writeSample(Print &out, uint64_t tsMs, const GeneralStatusFixed &gs, const GeneralStatusDelta &delta,
+                              bool first);
+#endif
+
+    //! Where sample index lives in the columns.
+    unsigned long slot(unsigned long index) const;
+    void store(unsigned long slot, const GeneralStatusFixed &gs);
+    void load(unsigned long slot, GeneralStatusFixed &gs) const;
+    //! Points the columns at a block with room for capacity samples.
+    void setColumns(void *block, unsigned long capacity);
+
+    //! 15 WORD fields and the packed 2 bit states, and 5 BYTE fields.
+    static const BYTE WORD_COLUMNS = 16;
+    static const BYTE BYTE_COLUMNS = 5;
+    //! Bytes one sample takes.
+    static const size_t SAMPLE_SZ = sizeof(uint64_t) + WORD_COLUMNS * sizeof(WORD) + BYTE_COLUMNS;
+
+    uint64_t m_internalTs[GS_HISTORY_SZ];
+    WORD m_internalWords[WORD_COLUMNS * GS_HISTORY_SZ];
+    BYTE m_internalBytes[BYTE_COLUMNS * GS_HISTORY_SZ];
+    uint64_t *m_ts;
+    //! Column c of capacity samples starts at c * m_capacity.
+    WORD *m_words;
+    BYTE *m_bytes;
+    unsigned long m_capacity;
+    unsigned long m_head;
+    unsigned long m_count;
+    unsigned long m_dropped;
+  };
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include "InfiniGsSkeleton.h"
+
+#if INFI_MODULE_JSON && INFI_MODULE_PARSERS
+#include <string.h>
+#include "InfiniDeltaTelemetry.h"
+
+namespace INFI {
+
+  static BYTE slotWidth(JSON_FIELD_KIND kind) {
+    // 6553.5 is the widest 0.1 unit reading, 65535 and false the widest of the rest.
+    return kind == JSON_DECI ? 6 : 5;
+  }
+
+  InfiniGsSkeleton::InfiniGsSkeleton() {
+    size_t n = 0;
+    m_text[n++] = '{';
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      if (i > 0) {
+        m_text[n++] = ',';
+      }
+      const char *key = getGeneralStatusFieldKey((GS_FIELD)i);
+      const size_t keyLen = INFI_STRLEN_P(key);
+      m_text[n++] = '"';
+      INFI_MEMCPY_P(m_text + n, key, keyLen);
+      n += keyLen;
+      m_text[n++] = '"';
+      m_text[n++] = ':';
+      m_slots[i] = (WORD)n;
+      const BYTE width = slotWidth(getGeneralStatusFieldKind((GS_FIELD)i));
+      memset(m_text + n, ' ', width);
+      n += width;
+      m_values[i] = -1;
+    }
+    m_text[n++] = '}';
+    m_text[n] = '\0';
+  }
+
+  void InfiniGsSkeleton::patch(BYTE field, long value) {
+    const JSON_FIELD_KIND kind = getGeneralStatusFieldKind((GS_FIELD)field);
+    const BYTE width = slotWidth(kind);
+    char *slot = m_text + m_slots[field];
+    char *end = slot + width;
+    if (kind == JSON_BOOL) {
+      if (value != 0) {
+        memcpy(end - 4, "true", 4);
+        end -= 4;
+      } else {
+        memcpy(end - 5, "false", 5);
+        end -= 5;
+      }
+    } else {
+      unsigned long digits = (unsigned long)value & 0xFFFF;
+      // Like writeGeneralStatusJson(), 2300 is written as 230 and 2301 as 230.1.
+      if (kind == JSON_DECI && digits % 10 != 0) {
+        *--end = (char)('0' + digits % 10);
+        *--end = '.';
+      }
+      if (kind == JSON_DECI) {
+        digits /= 10;
+      }
+      do {
+        *--end = (char)('0' + digits % 10);
+        digits /= 10;
+      } while (digits != 0 && end > slot);
+    }
+    memset(slot, ' ', end - slot);
+    m_values[field] = value;
+  }
+
+  const char *InfiniGsSkeleton::fill(const GeneralStatusFixed &gs) {
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      const long value = getGeneralStatusField(gs, (GS_FIELD)i);
+      if (value != m_values[i]) {
+        patch(i, value);
+      }
+    }
+    return m_text;
+  }
+
+  const char *InfiniGsSkeleton::text() const {
+    return m_text;
+  }
+
+  size_t InfiniGsSkeleton::length() const {
+    return GS_SKELETON_SZ;
+  }
+
+  size_t InfiniGsSkeleton::printTo(Print &out) const {
+    return out.write((const uint8_t *)m_text, GS_SKELETON_SZ);
+  }
+}
+#endif
@@ -0,0 +1,47 @@
+#ifndef INFINI_GS_SKELETON_H
+#define INFINI_GS_SKELETON_H
+
+#include <Print.h>
+#include <Printable.h>
+#include "InfiniDataTypes.h"
+
+namespace INFI {
+
+  //! The length of the text of InfiniGsSkeleton, every key of writeGeneralStatusJson() with its slot.
+  const size_t GS_SKELETON_SZ = 593;
+
+  /*!
+   * writeGeneralStatusJson() as a fixed text, for a sink that takes the whole GS object every sample.
+   * The keys, quotes and commas are put together once, by the constructor, with a slot after each colon
+   * that is wide enough for any value of its field: 6 chars for a 0.1 unit reading and 5 for the rest.
+   * fill() only rewrites the digits of the fields that changed since the last sample, right aligned and
+   * padded with spaces, which JSON allows between a colon and its value. So every sample is GS_SKELETON_SZ
+   * chars long and goes out with a single write(), at the cost of the padding on the wire.
+   */
+  class InfiniGsSkeleton : public Printable {
+    public:
+    InfiniGsSkeleton();
+
+    //! Patches the values of gs into the slots. Returns the text, null terminated, valid until the next fill().
+    const char *fill(const GeneralStatusFixed &gs);
+
+    const char *text() const;
+    //! Always GS_SKELETON_SZ.
+    size_t length() const;
+
+    //! Writes the text as it was last filled. Before the first fill() its slots are blank, which is no JSON.
+    size_t printTo(Print &out) const override;
+
+    private:
+    //! Writes value into the slot of field, right aligned.
+    void patch(BYTE field, long value);
+
+    char m_text[GS_SKELETON_SZ + 1];
+    //! Where the slot of each field starts in m_text.
+    WORD m_slots[NUM_GS_FIELDS];
+    //! The values last patched in, -1 for a slot still blank.
+    long m_values[NUM_GS_FIELDS];
+  };
+}
+
+#endif
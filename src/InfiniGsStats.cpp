@@ -0,0 +1,150 @@
+#include "InfiniGsStats.h"
+
+#if INFI_MODULE_STATS
+#include <math.h>
+#include <string.h>
+
+namespace INFI {
+
+  static const float MS_PER_HOUR = 3600000.0f;
+
+  //! v rounded to a whole number, clamped to the range a JSON field takes.
+  static long roundField(float v) {
+    if (v < 0) {
+      return 0;
+    }
+    return v > 65535.0f ? 65535 : (long)(v + 0.5f);
+  }
+
+  // key is a flash key of getGeneralStatusFieldKey().
+  static size_t writeStat(Print &out, const char *key, const char *suffix, long value, JSON_FIELD_KIND kind, bool first) {
+    char statKey[32];
+    INFI_STRNCPY_P(statKey, key, sizeof(statKey) - 4);
+    statKey[sizeof(statKey) - 4] = '\0';
+    strcat(statKey, suffix);
+    return writeJsonField(out, statKey, value, kind, first);
+  }
+
+  GeneralStatusStats::GeneralStatusStats(unsigned long windowMs) :
+    m_tracked(0),
+    m_windowMs(windowMs)
+  {
+    reset();
+  }
+
+  bool GeneralStatusStats::track(GS_FIELD field) {
+    if (m_tracked >= GS_STATS_FIELDS_SZ || field >= NUM_GS_FIELDS) {
+      return false;
+    }
+    m_fields[m_tracked++].field = field;
+    startWindow();
+    return true;
+  }
+
+  void GeneralStatusStats::setWindow(unsigned long windowMs) {
+    m_windowMs = windowMs;
+  }
+
+  void GeneralStatusStats::add(const GeneralStatusFixed &gs, unsigned long nowMs) {
+    if (m_samples == 0) {
+      m_startMs = nowMs;
+    }
+    if (m_samples < 0xFFFF) {
+      m_samples++;
+    }
+    for (BYTE i = 0; i < m_tracked; ++i) {
+      Field &f = m_fields[i];
+      const long value = getGeneralStatusField(gs, f.field);
+      if (m_samples == 1 || value < f.min) {
+        f.min = value;
+      }
+      if (m_samples == 1 || value > f.max) {
+        f.max = value;
+      }
+      const float delta = value - f.mean;
+      f.mean += delta / m_samples;
+      f.m2 += delta * (value - f.mean);
+    }
+
+    const float battVolt = deciToFloat(gs.battVoltDeci);
+    const float chargeW = battVolt * gs.battChargeCurr;
+    const float dischargeW = battVolt * gs.battDischargeCurr;
+    if (m_hasLast && nowMs - m_lastMs <= GS_STATS_MAX_GAP_MS) {
+      const float hours = (nowMs - m_lastMs) / MS_PER_HOUR;
+      m_chargeWh += (m_lastChargeW + chargeW) / 2 * hours;
+      m_dischargeWh += (m_lastDischargeW + dischargeW) / 2 * hours;
+    }
+    m_hasLast = true;
+    m_lastMs = nowMs;
+    m_lastChargeW = chargeW;
+    m_lastDischargeW = dischargeW;
+  }
+
+  bool GeneralStatusStats::isWindowDue(unsigned long nowMs) const {
+    return m_samples > 0 && nowMs - m_startMs >= m_windowMs;
+  }
+
+  WORD GeneralStatusStats::samples() const {
+    return m_samples;
+  }
+
+  float GeneralStatusStats::battChargeWh() const {
+    return m_chargeWh;
+  }
+
+  float GeneralStatusStats::battDischargeWh() const {
+    return m_dischargeWh;
+  }
+
+  float GeneralStatusStats::mean(BYTE i) const {
+    return i < m_tracked ? m_fields[i].mean : 0;
+  }
+
+  float GeneralStatusStats::stdDev(BYTE i) const {
+    return i < m_tracked && m_samples > 1 ? sqrtf(m_fields[i].m2 / m_samples) : 0;
+  }
+
+  size_t GeneralStatusStats::writeJson(Print &out) const {
+    if (m_samples == 0) {
+      return 0;
+    }
+    size_t n = 0;
+    for (BYTE i = 0; i < m_tracked; ++i) {
+      const Field &f = m_fields[i];
+      const char *key = getGeneralStatusFieldKey(f.field);
+      const JSON_FIELD_KIND kind = getGeneralStatusFieldKind(f.field);
+      n += writeStat(out, key, "Min", f.min, kind, i == 0);
+      n += writeStat(out, key, "Max", f.max, kind, false);
+      n += writeStat(out, key, "Avg", roundField(f.mean), kind, false);
+      n += writeStat(out, key, "Sd", roundField(stdDev(i)), kind, false);
+    }
+    // In 0.1 Wh.
+    n += writeJsonFieldP(out, INFI_PSTR("battChargeWh"), roundField(m_chargeWh * 10), JSON_DECI, m_tracked == 0);
+    n += writeJsonFieldP(out, INFI_PSTR("battDischargeWh"), roundField(m_dischargeWh * 10), JSON_DECI, false);
+    n += writeJsonFieldP(out, INFI_PSTR("samples"), m_samples, JSON_UINT, false);
+    n += out.print('}');
+    return n;
+  }
+
+  void GeneralStatusStats::startWindow() {
+    m_samples = 0;
+    m_startMs = 0;
+    m_chargeWh = 0;
+    m_dischargeWh = 0;
+    for (BYTE i = 0; i < m_tracked; ++i) {
+      m_fields[i].min = 0;
+      m_fields[i].max = 0;
+      m_fields[i].mean = 0;
+      m_fields[i].m2 = 0;
+    }
+  }
+
+  void GeneralStatusStats::reset() {
+    startWindow();
+    m_hasLast = false;
+    m_lastMs = 0;
+    m_lastChargeW = 0;
+    m_lastDischargeW = 0;
+  }
+}
+#endif
@@ -0,0 +1,90 @@
+#ifndef INFINI_GS_STATS_H
+#define INFINI_GS_STATS_H
+
+#include "InfiniDeltaTelemetry.h"
+
+// GS fields one GeneralStatusStats can keep statistics of.
+#ifndef INFI_GS_STATS_FIELDS_SZ
+#define INFI_GS_STATS_FIELDS_SZ 6
+#endif
+
+// Samples further apart than this are not integrated into the battery energy, the link was down in between.
+#ifndef INFI_GS_STATS_MAX_GAP_MS
+#define INFI_GS_STATS_MAX_GAP_MS 60000
+#endif
+
+namespace INFI {
+
+  const BYTE GS_STATS_FIELDS_SZ = INFI_GS_STATS_FIELDS_SZ;
+  const unsigned long GS_STATS_MAX_GAP_MS = INFI_GS_STATS_MAX_GAP_MS;
+
+  /*!
+   * Min, max, mean and standard deviation of a few GS fields over a time window, plus the energy that went
+   * into and out of the battery, so the uplink sends one aggregate per window instead of every sample.
+   * The statistics are running (Welford), the energy is the trapezoidal integral of battVolt times the
+   * charge or discharge current between consecutive samples. Memory does not grow with the samples.
+   * The interval between two samples counts towards the window of the later one, so none is lost at a boundary.
+   */
+  class GeneralStatusStats {
+    public:
+    explicit GeneralStatusStats(unsigned long windowMs = 60000);
+
+    //! Keeps statistics of field. Returns false if GS_STATS_FIELDS_SZ fields are tracked already.
+    bool track(GS_FIELD field);
+
+    void setWindow(unsigned long windowMs);
+
+    //! Adds the sample gs taken at nowMs to the current window.
+    void add(const GeneralStatusFixed &gs, unsigned long nowMs);
+
+    //! True once the current window has samples and started windowMs or more before nowMs.
+    bool isWindowDue(unsigned long nowMs) const;
+
+    //! Samples in the current window.
+    WORD samples() const;
+
+    //! Battery energy of the current window, in Wh.
+    float battChargeWh() const;
+    float battDischargeWh() const;
+
+    //! Mean and standard deviation of the i-th tracked field, in its stored units.
+    float mean(BYTE i) const;
+    float stdDev(BYTE i) const;
+
+    /*! Writes the window as one JSON object: <key>Min, <key>Max, <key>Avg and <key>Sd for every tracked field,
+     * in the format of writeGeneralStatusJson(), then battChargeWh, battDischargeWh and samples.
+     * Returns 0 if the window has no samples.
+     */
+    size_t writeJson(Print &out) const;
+
+    //! Starts the next window. The last sample is kept for the energy integral.
+    void startWindow();
+
+    //! Forgets everything, including the last sample.
+    void reset();
+
+    private:
+    struct Field {
+      GS_FIELD field;
+      long min;
+      long max;
+      float mean;
+      //! Sum of the squared deviations from the mean.
+      float m2;
+    };
+
+    Field m_fields[GS_STATS_FIELDS_SZ];
+    BYTE m_tracked;
+    unsigned long m_windowMs;
+    unsigned long m_startMs;
+    WORD m_samples;
+    float m_chargeWh;
+    float m_dischargeWh;
+    bool m_hasLast;
+    unsigned long m_lastMs;
+    float m_lastChargeW;
+    float m_lastDischargeW;
+  };
+}
+
+#endif
@@ -0,0 +1,273 @@
+#include "InfiniGsStream.h"
+
+#if INFI_MODULE_SINKS
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <Arduino.h>
+#include <string.h>
+#include <strings.h>
+#include <mbedtls/base64.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/version.h>
+#include "InfiniBinaryWriter.h"
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+
+  // RFC 6455, appended to the client's key before hashing it into Sec-WebSocket-Accept.
+  static const char WEBSOCKET_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+  static const char WEBSOCKET_KEY_HEADER[] = "Sec-WebSocket-Key:";
+
+  static const BYTE OPCODE_TEXT = 0x1;
+  static const BYTE OPCODE_BINARY = 0x2;
+  static const BYTE OPCODE_CLOSE = 0x8;
+  static const BYTE FRAME_FIN = 0x80;
+  static const BYTE FRAME_MASKED = 0x80;
+  //! Room in front of the payload in m_frame, for a header with a 16 bit length.
+  static const BYTE FRAME_HEADER_SZ = 4;
+
+  InfiniGsStream::InfiniGsStream(uint16_t port, GS_STREAM_FORMAT format) :
+    m_server(port),
+    m_format(format)
+  {
+    for (BYTE i = 0; i < GS_STREAM_CLIENTS; ++i) {
+      m_clients[i].state = CLIENT_FREE;
+    }
+  }
+
+  void InfiniGsStream::begin() {
+    m_server.begin();
+    // Frames are written whole, there is nothing to gain from Nagle holding them back.
+    m_server.setNoDelay(true);
+  }
+
+  void InfiniGsStream::loop() {
+    if (m_server.hasClient()) {
+      WiFiClient incoming = m_server.available();
+      Peer *slot = NULL;
+      for (BYTE i = 0; i < GS_STREAM_CLIENTS && slot == NULL; ++i) {
+        if (m_clients[i].state == CLIENT_FREE) {
+          slot = &m_clients[i];
+        }
+      }
+      if (slot == NULL) {
+        incoming.stop();
+      } else {
+        slot->socket = incoming;
+        slot->state = CLIENT_HANDSHAKE;
+        slot->acceptedMs = millis();
+        slot->lineLen = 0;
+        slot->key[0] = '\0';
+        slot->rxHeaderLen = 0;
+        slot->rxSkip = 0;
+      }
+    }
+
+    for (BYTE i = 0; i < GS_STREAM_CLIENTS; ++i) {
+      Peer &client = m_clients[i];
+      if (client.state == CLIENT_FREE) {
+        continue;
+      }
+      if (!client.socket.connected()) {
+        drop(client);
+      } else if (client.state == CLIENT_HANDSHAKE) {
+        if (millis() - client.acceptedMs > GS_STREAM_HANDSHAKE_MS) {
+          drop(client);
+        } else {
+          readHandshake(client);
+        }
+      } else {
+        readFrames(client);
+      }
+    }
+  }
+
+  void InfiniGsStream::readHandshake(Peer &client) {
+    while (client.state == CLIENT_HANDSHAKE && client.socket.available() > 0) {
+      int c = client.socket.read();
+      if (c < 0) {
+        break;
+      }
+      if (c == '\n') {
+        handshakeLine(client);
+        client.lineLen = 0;
+      } else if (c != '\r' && client.lineLen < GS_STREAM_LINE_SZ - 1) {
+        // Longer lines are cut short, none of those matter.
+        client.line[client.lineLen++] = (char)c;
+      }
+    }
+  }
+
+  void InfiniGsStream::handshakeLine(Peer &client) {
+    client.line[client.lineLen] = '\0';
+    if (client.lineLen > 0) {
+      const size_t headerLen = sizeof(WEBSOCKET_KEY_HEADER) - 1;
+      if (strncasecmp(client.line, WEBSOCKET_KEY_HEADER, headerLen) == 0) {
+        const char *value = client.line + headerLen;
+        while (*value == ' ') {
+          value++;
+        }
+        strncpy(client.key, value, sizeof(client.key) - 1);
+        client.key[sizeof(client.key) - 1] = '\0';
+      }
+      return;
+    }
+
+    // The empty line ends the request.
+    if (client.key[0] == '\0') {
+      client.socket.print("HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n");
+      drop(client);
+      return;
+    }
+    unsigned char hash[20];
+    char keyGuid[sizeof(client.key) + sizeof(WEBSOCKET_GUID)];
+    strcpy(keyGuid, client.key);
+    strcat(keyGuid, WEBSOCKET_GUID);
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    mbedtls_sha1((const unsigned char *)keyGuid, strlen(keyGuid), hash);
+#else
+    mbedtls_sha1_ret((const unsigned char *)keyGuid, strlen(keyGuid), hash);
+#endif
+    unsigned char accept[32];
+    size_t acceptLen = 0;
+    mbedtls_base64_encode(accept, sizeof(accept), &acceptLen, hash, sizeof(hash));
+    accept[acceptLen] = '\0';
+
+    client.socket.print("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                        "Sec-WebSocket-Accept: ");
+    client.socket.print((const char *)accept);
+    client.socket.print("\r\n\r\n");
+    client.state = CLIENT_OPEN;
+  }
+
+  void InfiniGsStream::readFrames(Peer &client) {
+    BYTE scratch[32];
+    while (client.state == CLIENT_OPEN && client.socket.available() > 0) {
+      if (client.rxSkip > 0) {
+        size_t want = client.rxSkip < sizeof(scratch) ? client.rxSkip : sizeof(scratch);
+        int got = client.socket.read(scratch, want);
+        if (got <= 0) {
+          break;
+        }
+        client.rxSkip -= got;
+        continue;
+      }
+
+      int c = client.socket.read();
+      if (c < 0) {
+        break;
+      }
+      client.rxHeader[client.rxHeaderLen++] = (BYTE)c;
+      if (client.rxHeaderLen < 2) {
+        continue;
+      }
+      BYTE len7 = client.rxHeader[1] & 0x7F;
+      BYTE lenSz = len7 == 126 ? 2 : (len7 == 127 ? 8 : 0);
+      BYTE maskSz = (client.rxHeader[1] & FRAME_MASKED) ? 4 : 0;
+      if (client.rxHeaderLen < 2 + lenSz + maskSz) {
+        continue;
+      }
+
+      if ((client.rxHeader[0] & 0x0F) == OPCODE_CLOSE) {
+        const BYTE close[2] = { FRAME_FIN | OPCODE_CLOSE, 0 };
+        client.socket.write(close, sizeof(close));
+        drop(client);
+        return;
+      }
+      unsigned long payloadLen = len7;
+      if (lenSz > 0) {
+        payloadLen = 0;
+        // Anything past 32 bits is far beyond what a listening client sends.
+        for (BYTE i = 0; i < lenSz; ++i) {
+          payloadLen = (payloadLen << 8) | client.rxHeader[2 + i];
+        }
+      }
+      client.rxSkip = payloadLen;
+      client.rxHeaderLen = 0;
+    }
+  }
+
+  void InfiniGsStream::drop(Peer &client) {
+    client.socket.stop();
+    client.state = CLIENT_FREE;
+  }
+
+  BYTE InfiniGsStream::broadcast(const GeneralStatusFixed &gs) {
+    BYTE *payload = m_frame + FRAME_HEADER_SZ;
+    const size_t room = GS_STREAM_FRAME_SZ - FRAME_HEADER_SZ;
+    BYTE opcode;
+    size_t len;
+    {
+      // Leaves one byte for the null terminator it keeps.
+      InfiniBufferPrint out((char *)payload, room);
+      if (m_format == GS_STREAM_BINARY) {
+        opcode = OPCODE_BINARY;
+        writeGeneralStatusBinary(gs, out);
+      } else {
+        opcode = OPCODE_TEXT;
+        if (measureGeneralStatusJson(gs) >= room) {
+          return 0;
+        }
+        writeGeneralStatusJson(gs, out);
+      }
+      len = out.length();
+    }
+    return sendFrame(opcode, len);
+  }
+
+  BYTE InfiniGsStream::broadcastPayload(const char *payload, size_t len, GS_STREAM_FORMAT format) {
+    if (len > GS_STREAM_FRAME_SZ - FRAME_HEADER_SZ) {
+      return 0;
+    }
+    memcpy(m_frame + FRAME_HEADER_SZ, payload, len);
+    return sendFrame(format == GS_STREAM_BINARY ? OPCODE_BINARY : OPCODE_TEXT, len);
+  }
+
+  BYTE InfiniGsStream::sendFrame(BYTE opcode, size_t len) {
+    BYTE *payload = m_frame + FRAME_HEADER_SZ;
+    BYTE *frame;
+    if (len < 126) {
+      frame = payload - 2;
+      frame[1] = (BYTE)len;
+    } else {
+      frame = payload - 4;
+      frame[1] = 126;
+      frame[2] = (BYTE)(len >> 8);
+      frame[3] = (BYTE)(len & 0xFF);
+    }
+    frame[0] = FRAME_FIN | opcode;
+    const size_t frameLen = len + (payload - frame);
+
+    BYTE sent = 0;
+    for (BYTE i = 0; i < GS_STREAM_CLIENTS; ++i) {
+      Peer &client = m_clients[i];
+      if (client.state != CLIENT_OPEN) {
+        continue;
+      }
+      if (client.socket.write(frame, frameLen) != frameLen) {
+        drop(client);
+      } else {
+        sent++;
+      }
+    }
+    return sent;
+  }
+
+  GS_STREAM_FORMAT InfiniGsStream::format() const {
+    return m_format;
+  }
+
+  BYTE InfiniGsStream::clientCount() const {
+    BYTE count = 0;
+    for (BYTE i = 0; i < GS_STREAM_CLIENTS; ++i) {
+      if (m_clients[i].state == CLIENT_OPEN) {
+        count++;
+      }
+    }
+    return count;
+  }
+}
+
+#endif
+#endif
@@ -0,0 +1,113 @@
+#ifndef INFINI_GS_STREAM_H
+#define INFINI_GS_STREAM_H
+
+#include "InfiniDataTypes.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <WiFi.h>
+
+// WebSocket clients the stream serves at once, further connections are turned away.
+#ifndef INFI_GS_STREAM_CLIENTS
+#define INFI_GS_STREAM_CLIENTS 4
+#endif
+
+// Room for one frame, the 4 byte header and a GS sample as JSON, which is at most about 560 chars.
+#ifndef INFI_GS_STREAM_FRAME_SZ
+#define INFI_GS_STREAM_FRAME_SZ 640
+#endif
+
+// Longest line of the opening handshake kept, the only one needed is the Sec-WebSocket-Key one.
+#ifndef INFI_GS_STREAM_LINE_SZ
+#define INFI_GS_STREAM_LINE_SZ 64
+#endif
+
+// Time a new connection gets to finish the opening handshake, milliseconds.
+#ifndef INFI_GS_STREAM_HANDSHAKE_MS
+#define INFI_GS_STREAM_HANDSHAKE_MS 2000
+#endif
+
+namespace INFI {
+
+  const BYTE GS_STREAM_CLIENTS = INFI_GS_STREAM_CLIENTS;
+  const size_t GS_STREAM_FRAME_SZ = INFI_GS_STREAM_FRAME_SZ;
+  const size_t GS_STREAM_LINE_SZ = INFI_GS_STREAM_LINE_SZ;
+  const unsigned long GS_STREAM_HANDSHAKE_MS = INFI_GS_STREAM_HANDSHAKE_MS;
+
+  //! How InfiniGsStream puts a sample in a frame.
+  enum GS_STREAM_FORMAT {
+    GS_STREAM_JSON = 0, // A text frame holding the writeGeneralStatusJson() object.
+    GS_STREAM_BINARY    // A binary frame holding the writeGeneralStatusBinary() record, 40 bytes.
+  };
+
+  /*!
+   * A WebSocket server that pushes every GS sample to the clients connected to it, e.g. local dashboards
+   * that would otherwise poll InfiniStatusServer. broadcast() serializes a sample into one frame
+   * and writes that same frame to every client, so more clients only cost the writes.
+   * Clients only listen: whatever they send is skipped, except a close, which is answered.
+   * A client whose write fails, e.g. because it stopped reading, is dropped.
+   * Driven from loop(), not thread safe.
+   */
+  class InfiniGsStream {
+    public:
+    explicit InfiniGsStream(uint16_t port = 81, GS_STREAM_FORMAT format = GS_STREAM_JSON);
+
+    void begin();
+
+    //! Accepts new connections, advances their handshakes and skips what clients sent. Call it from loop().
+    void loop();
+
+    //! Sends gs to every connected client. Returns the number of clients it went to.
+    BYTE broadcast(const GeneralStatusFixed &gs);
+
+    /*! Sends a sample already serialized in format, e.g. an InfiniSampleFanout buffer, to every connected client.
+     * Returns the number of clients it went to, 0 if len does not fit a frame.
+     */
+    BYTE broadcastPayload(const char *payload, size_t len, GS_STREAM_FORMAT format);
+
+    //! The format broadcast() uses.
+    GS_STREAM_FORMAT format() const;
+
+    //! Clients past the handshake.
+    BYTE clientCount() const;
+
+    private:
+    enum CLIENT_STATE {
+      CLIENT_FREE = 0,
+      CLIENT_HANDSHAKE, // Reading the HTTP upgrade request.
+      CLIENT_OPEN       // Receives frames.
+    };
+
+    struct Peer {
+      WiFiClient socket;
+      CLIENT_STATE state;
+      unsigned long acceptedMs;
+      //! The handshake line being read.
+      char line[GS_STREAM_LINE_SZ];
+      BYTE lineLen;
+      //! The Sec-WebSocket-Key value, once its line was read.
+      char key[32];
+      //! Header bytes of the incoming frame read so far, and payload bytes of it still to skip.
+      BYTE rxHeader[14];
+      BYTE rxHeaderLen;
+      unsigned long rxSkip;
+    };
+
+    void readHandshake(Peer &client);
+    //! Handles one complete handshake line, an empty one ends the request.
+    void handshakeLine(Peer &client);
+    void readFrames(Peer &client);
+    void drop(Peer &client);
+    //! Puts the header in front of the len payload bytes in m_frame and writes the frame to every open client.
+    BYTE sendFrame(BYTE opcode, size_t len);
+
+    WiFiServer m_server;
+    GS_STREAM_FORMAT m_format;
+    Peer m_clients[GS_STREAM_CLIENTS];
+    //! The frame broadcast() writes to every client, the header is put right in front of the payload.
+    BYTE m_frame[GS_STREAM_FRAME_SZ];
+  };
+}
+
+#endif
+#endif
@@ -0,0 +1,110 @@
+#include "InfiniGsView.h"
+
+#if INFI_MODULE_PARSERS
+#include <string.h>
+#include "InfiniCRC.h"
+#include "InfiniDeltaTelemetry.h"
+
+namespace INFI {
+
+#define INFI_GS_WIDTH(field, member, key, shortKey, width, kind, bits) width,
+#define INFI_GS_OFFSET(field, member, key, shortKey, width, kind, bits) gsOffset(field),
+
+  // ^D106AAAA,BBB,CCCC,DDD,EEEE,FFFF,GGG,HHH,III,JJJ,KKK,LLL,MMM,NNN,OOO,PPP,QQQQ,RRRR,SSSS,TTTT,U,V,W,X,Y,Z,a,b
+  // How wide each field is, by GS_FIELD.
+  static const BYTE GS_FIELD_WIDTHS[NUM_GS_FIELDS] INFI_PROGMEM = {
+    INFI_GS_SCHEMA(INFI_GS_WIDTH)
+  };
+
+  // The same, to add the offsets up at compile time, the table above is not readable there on AVR.
+  static constexpr BYTE GS_WIDTHS[NUM_GS_FIELDS] = {
+    INFI_GS_SCHEMA(INFI_GS_WIDTH)
+  };
+
+  //! Where field starts in the frame: each one follows the previous one and its comma.
+  static constexpr BYTE gsOffset(BYTE field) {
+    return field == 0 ? START_OFFSET_SZ : gsOffset(field - 1) + GS_WIDTHS[field - 1] + 1;
+  }
+
+  // Where each field starts in the frame, by GS_FIELD.
+  static const BYTE GS_FIELD_OFFSETS[NUM_GS_FIELDS] INFI_PROGMEM = {
+    INFI_GS_SCHEMA(INFI_GS_OFFSET)
+  };
+
+  static_assert(gsOffset(NUM_GS_FIELDS - 1) + GS_WIDTHS[NUM_GS_FIELDS - 1] == getResponseSize(GENERAL_STATUS) - CRC_SZ - END_TOKEN_SZ,
+                "INFI_GS_SCHEMA must end where the CRC starts");
+
+  GeneralStatusView::GeneralStatusView() :
+    m_in(NULL)
+  {}
+
+  bool GeneralStatusView::reset(const char *in, size_t inSize) {
+    m_in = NULL;
+    if (inSize != getResponseSize(GENERAL_STATUS) || strncmp(in, "^D106", START_OFFSET_SZ) != 0) {
+      return false;
+    }
+    const size_t crcPos = inSize - CRC_SZ - END_TOKEN_SZ;
+    WORD received = ((WORD)(BYTE)in[crcPos] << 8) | (BYTE)in[crcPos + 1];
+    if (received != calc_crc_half((const BYTE*)in, (BYTE)crcPos)) {
+      return false;
+    }
+    // The fields sit where the table says only if every comma does.
+    for (BYTE f = 1; f < NUM_GS_FIELDS; ++f) {
+      if (in[INFI_READ_BYTE(&GS_FIELD_OFFSETS[f]) - 1] != ',') {
+        return false;
+      }
+    }
+    m_in = in;
+    return true;
+  }
+
+  bool GeneralStatusView::isValid() const {
+    return m_in != NULL;
+  }
+
+  bool GeneralStatusView::get(GS_FIELD field, long &value) const {
+    value = 0;
+    if (m_in == NULL || field >= NUM_GS_FIELDS) {
+      return false;
+    }
+    const char *p = m_in + INFI_READ_BYTE(&GS_FIELD_OFFSETS[field]);
+    const char *end = p + INFI_READ_BYTE(&GS_FIELD_WIDTHS[field]);
+    // Temperatures may be negative, the sign then takes the place of a digit.
+    const bool negative = *p == '-' && end - p > 1;
+    if (negative) {
+      p++;
+    }
+    for (; p < end; ++p) {
+      if (*p < '0' || *p > '9') {
+        value = 0;
+        return false;
+      }
+      value = value * 10 + (*p - '0');
+    }
+    if (negative) {
+      value = -value;
+    }
+    return true;
+  }
+
+  long GeneralStatusView::value(GS_FIELD field) const {
+    long value;
+    get(field, value);
+    return value;
+  }
+
+  bool GeneralStatusView::decode(GeneralStatusFixed &gs, GsFieldMask fields) const {
+    memset(&gs, 0, sizeof(gs));
+    bool ok = m_in != NULL;
+    for (BYTE f = 0; ok && f < NUM_GS_FIELDS; ++f) {
+      if ((fields & (1UL << f)) == 0) {
+        continue;
+      }
+      long value;
+      ok = get((GS_FIELD)f, value);
+      setGeneralStatusField(gs, (GS_FIELD)f, value);
+    }
+    return ok;
+  }
+}
+#endif
@@ -0,0 +1,38 @@
+#ifndef INFINI_GS_VIEW_H
+#define INFINI_GS_VIEW_H
+
+#include <stddef.h>
+#include "InfiniDataTypes.h"
+
+namespace INFI {
+
+  /*!
+   * A GS reply read in place. reset() checks the frame once, after that every field sits at a fixed offset,
+   * the protocol pads each one to its width, so get() decodes just the field asked for.
+   * Code that looks at a few fields, e.g. a snapshot or a change check, pays for those and not all 28.
+   * Only keeps a pointer, the reply must outlive the view.
+   */
+  class GeneralStatusView {
+    public:
+    GeneralStatusView();
+
+    /*! Checks the length, ^D106, the CRC and the commas between the fields of the reply in.
+     * Returns false, and the view is invalid, if one of them is off.
+     */
+    bool reset(const char *in, size_t inSize);
+    bool isValid() const;
+
+    //! Decodes field into value, in the units getGeneralStatusField() returns. False if it is malformed.
+    bool get(GS_FIELD field, long &value) const;
+    //! The same, 0 for a malformed field or an invalid view.
+    long value(GS_FIELD field) const;
+
+    //! Decodes the fields in the mask into gs, the others are set to 0. False if one of them is malformed.
+    bool decode(GeneralStatusFixed &gs, GsFieldMask fields = GS_ALL_FIELDS) const;
+
+    private:
+    const char *m_in;
+  };
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include "InfiniIdle.h"
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif defined(__AVR__)
+#include <avr/sleep.h>
+#endif
+
+namespace INFI {
+#if defined(ARDUINO_ARCH_ESP32)
+  // The task sleeping in idleFor(), known after its first call.
+  static TaskHandle_t idleTask = NULL;
+
+  // Longest wait an InfiniWakeTimer is given in one go.
+  static const unsigned long MAX_WAKE_MS = 4000000UL;
+
+  // Ends the wait of idleFor() itself.
+  static InfiniWakeTimer idleTimer;
+
+  void idleFor(unsigned long waitMs) {
+    if (waitMs == 0) {
+      return;
+    }
+    idleTask = xTaskGetCurrentTaskHandle();
+    if (waitMs == NO_DEADLINE) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      return;
+    }
+    // A tick timeout would end the wait on a tick boundary, up to a tick early or late.
+    // Waits past the 71 minutes the microseconds hold end early, and the loop just waits again.
+    idleTimer.once(waitMs < MAX_WAKE_MS ? waitMs * 1000UL : MAX_WAKE_MS * 1000UL);
+    // A wake given while the task was busy is still pending, so this returns at once and nothing is missed.
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    idleTimer.cancel();
+  }
+
+  void wakeIdle() {
+    TaskHandle_t task = idleTask;
+    if (task != NULL) {
+      xTaskNotifyGive(task);
+    }
+  }
+
+  static void onWakeTimer(void *) {
+    wakeIdle();
+  }
+
+  InfiniWakeTimer::InfiniWakeTimer() : m_timer(NULL) {}
+
+  InfiniWakeTimer::~InfiniWakeTimer() {
+    if (m_timer != NULL) {
+      esp_timer_stop((esp_timer_handle_t)m_timer);
+      esp_timer_delete((esp_timer_handle_t)m_timer);
+    }
+  }
+
+  void InfiniWakeTimer::once(unsigned long waitUs) {
+    // Not in the constructor, a static one would be built before the esp_timer service runs.
+    if (m_timer == NULL) {
+      esp_timer_create_args_t args = {};
+      args.callback = &onWakeTimer;
+      args.dispatch_method = ESP_TIMER_TASK;
+      args.name = "infi_wake";
+      esp_timer_handle_t timer = NULL;
+      if (esp_timer_create(&args, &timer) != ESP_OK) {
+        return;
+      }
+      m_timer = timer;
+    }
+    // Restarting a running one-shot fails, so it is stopped first.
+    esp_timer_stop((esp_timer_handle_t)m_timer);
+    esp_timer_start_once((esp_timer_handle_t)m_timer, waitUs);
+  }
+
+  void InfiniWakeTimer::cancel() {
+    if (m_timer != NULL) {
+      esp_timer_stop((esp_timer_handle_t)m_timer);
+    }
+  }
+#else
+#if defined(__AVR__)
+  void idleFor(unsigned long waitMs) {
+    if (waitMs == 0) {
+      return;
+    }
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+  }
+
+  void wakeIdle() {
+    // Any interrupt already ends the sleep.
+  }
+#else
+  void idleFor(unsigned long waitMs) {
+    if (waitMs != 0) {
+      yield();
+    }
+  }
+
+  void wakeIdle() {}
+#endif
+
+  InfiniWakeTimer::InfiniWakeTimer() : m_timer(NULL) {}
+
+  InfiniWakeTimer::~InfiniWakeTimer() {}
+
+  void InfiniWakeTimer::once(unsigned long) {}
+
+  void InfiniWakeTimer::cancel() {}
+#endif
+}
@@ -0,0 +1,50 @@
+#ifndef INFINI_IDLE_H
+#define INFINI_IDLE_H
+
+#include "InfiniCommon.h"
+
+namespace INFI {
+
+  /*!
+   * Sleeps the calling task for at most waitMs, or until wakeIdle() is called, instead of spinning loop().
+   * Feed it the least of the msUntil*() of what the loop drives, e.g. InfiniPollScheduler::msUntilDue().
+   * On ESP32 the task blocks on its notification, so the idle task halts the CPU and WiFi can stay
+   * in modem sleep. With automatic light sleep enabled through esp_pm_configure() the chip sleeps too.
+   * The wait is an esp_timer one-shot, so it ends on the microsecond instead of on the next FreeRTOS tick.
+   * On AVR the CPU halts in idle mode until the next interrupt, which the millis() tick raises every
+   * millisecond at the latest, so this returns early and the loop runs again, just at a fraction of the power.
+   * Returns straight away for a waitMs of 0.
+   */
+  void idleFor(unsigned long waitMs);
+
+  /*! Ends the current or next idleFor() early, e.g. when a reply or a network event arrived.
+   * Safe to call from other tasks on ESP32, but not from an ISR.
+   */
+  void wakeIdle();
+
+  /*!
+   * A one-shot that calls wakeIdle() once its time is up, so a deadline ends idleFor() when it passes,
+   * e.g. a transaction's RX timeout, without the loop having to poll for it.
+   * On ESP32 it is an esp_timer dispatched from the timer task, created on the first once().
+   * Elsewhere it does nothing: on AVR the millis() tick already ends every idleFor() within a millisecond.
+   */
+  class InfiniWakeTimer {
+    public:
+    InfiniWakeTimer();
+    ~InfiniWakeTimer();
+    InfiniWakeTimer(const InfiniWakeTimer &) = delete;
+    InfiniWakeTimer &operator=(const InfiniWakeTimer &) = delete;
+
+    //! Wakes the loop in waitUs, replacing the time a previous once() set.
+    void once(unsigned long waitUs);
+
+    //! Stops the pending wake, if any.
+    void cancel();
+
+    private:
+    //! The esp_timer_handle_t, kept as void * so esp_timer.h stays out of the headers.
+    void *m_timer;
+  };
+}
+
+#endif
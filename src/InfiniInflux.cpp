@@ -0,0 +1,202 @@
+#include "InfiniInflux.h"
+
+#if INFI_MODULE_SINKS
+#include "InfiniDeltaTelemetry.h"
+
+namespace INFI {
+
+  // Writes a measurement name or tag value, with the chars line protocol gives a meaning escaped.
+  static size_t writeEscaped(Print &out, const char *s, bool isMeasurement) {
+    size_t n = 0;
+    for (; *s != '\0'; ++s) {
+      if (*s == ',' || *s == ' ' || (*s == '=' && !isMeasurement)) {
+        n += out.print('\\');
+      }
+      n += out.print(*s);
+    }
+    return n;
+  }
+
+  size_t writeGeneralStatusLine(Print &out, const char *measurement, const char *device, const GeneralStatusFixed &gs,
+                                uint64_t tsMs, GsFieldMask fields) {
+    size_t n = writeEscaped(out, measurement, true);
+    if (device != NULL && *device != '\0') {
+      n += out.print(INFI_F(",device="));
+      n += writeEscaped(out, device, false);
+    }
+    bool first = true;
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      const GS_FIELD field = (GS_FIELD)i;
+      if (!(fields & (1UL << i))) {
+        continue;
+      }
+      n += out.print(first ? ' ' : ',');
+      first = false;
+      n += out.print(INFI_FLASH(getGeneralStatusFieldKey(field)));
+      n += out.print('=');
+      const unsigned long value = (unsigned long)getGeneralStatusField(gs, field);
+      switch (getGeneralStatusFieldKind(field)) {
+        case JSON_DECI:
+          // Always with the decimal, so InfluxDB never sees the field as an integer.
+          n += out.print(value / 10);
+          n += out.print('.');
+          n += out.print(value % 10);
+          break;
+        case JSON_BOOL:
+          n += out.print(value != 0 ? INFI_F("true") : INFI_F("false"));
+          break;
+        default:
+          n += out.print(value);
+          n += out.print('i');
+          break;
+      }
+    }
+    // The ms with six zeros, as ns.
+    n += out.print(' ');
+    n += printUint64(tsMs, out);
+    n += out.print(INFI_F("000000\n"));
+    return n;
+  }
+
+#if INFI_ENABLE_INFLUX_HTTP
+  //! Quiet time after which the rest of a response is given up on, and the connection with it.
+  static const unsigned long INFLUX_DRAIN_MS = 2000;
+
+  // Forwards to out and counts, for the size of an uncompressed body.
+  class CountingForwardPrint : public Print {
+    public:
+    explicit CountingForwardPrint(Print &out) :
+      m_out(out),
+      m_count(0)
+    {}
+
+    size_t write(uint8_t c) override {
+      size_t n = m_out.write(c);
+      m_count += n;
+      return n;
+    }
+
+    size_t write(const uint8_t *buffer, size_t size) override {
+      size_t n = m_out.write(buffer, size);
+      m_count += n;
+      return n;
+    }
+
+    unsigned long count() const {
+      return m_count;
+    }
+
+    private:
+    Print &m_out;
+    unsigned long m_count;
+  };
+
+  InfiniInfluxWriter::InfiniInfluxWriter(HttpClient &http, const char *path, const char *authorization) :
+    m_http(http),
+    m_path(path),
+    m_authorization(authorization),
+    m_measurement("gs"),
+    m_fields(GS_ALL_FIELDS),
+    m_deflate(NULL),
+    m_lastStatus(0),
+    m_lastBytesIn(0),
+    m_lastBytesOut(0)
+  {}
+
+  void InfiniInfluxWriter::setMeasurement(const char *measurement) {
+    m_measurement = measurement;
+  }
+
+  void InfiniInfluxWriter::setFields(GsFieldMask fields) {
+    m_fields = fields;
+  }
+
+  void InfiniInfluxWriter::setCompression(InfiniDeflatePrint *deflate) {
+    m_deflate = deflate;
+  }
+
+  unsigned long InfiniInfluxWriter::post(const InfiniGsHistory &history, const char *device, unsigned long maxPoints) {
+    const unsigned long points = history.size() < maxPoints ? history.size() : maxPoints;
+    if (points == 0) {
+      return 0;
+    }
+    m_http.connectionKeepAlive();
+    m_http.beginRequest();
+    int error = m_http.post(m_path);
+    if (error != HTTP_SUCCESS) {
+      m_lastStatus = error;
+      m_http.stop();
+      return 0;
+    }
+    m_http.sendHeader(HTTP_HEADER_CONTENT_TYPE, "text/plain; charset=utf-8");
+    if (m_authorization != NULL) {
+      m_http.sendHeader("Authorization", m_authorization);
+    }
+    if (m_deflate != NULL) {
+      m_http.sendHeader("Content-Encoding", "gzip");
+    }
+    m_http.beginChunkedBody();
+    CountingForwardPrint body(m_http);
+    Print &out = m_deflate != NULL ? (Print &)*m_deflate : (Print &)body;
+    if (m_deflate != NULL) {
+      m_deflate->begin();
+    }
+    GeneralStatusFixed gs;
+    uint64_t tsMs;
+    for (unsigned long i = 0; i < points && history.at(i, gs, tsMs); ++i) {
+      writeGeneralStatusLine(out, m_measurement, device, gs, tsMs, m_fields);
+    }
+    bool written = true;
+    if (m_deflate != NULL) {
+      written = m_deflate->finish();
+      m_lastBytesIn = m_deflate->bytesIn();
+      m_lastBytesOut = m_deflate->bytesOut();
+    } else {
+      m_lastBytesIn = m_lastBytesOut = body.count();
+    }
+    written &= m_http.endChunkedBody() == HTTP_SUCCESS;
+    m_lastStatus = written ? m_http.responseStatusCode() : HTTP_ERROR_CONNECTION_FAILED;
+    if (m_lastStatus < 0) {
+      m_http.stop();
+      return 0;
+    }
+    drainResponse();
+    return m_lastStatus >= 200 && m_lastStatus < 300 ? points : 0;
+  }
+
+  void InfiniInfluxWriter::drainResponse() {
+    m_http.skipResponseHeaders();
+    // A 204, InfluxDB's answer to a write, has no body. An error's JSON is short and comes with its length.
+    const long length = m_lastStatus == 204 ? 0 : m_http.contentLength();
+    if (length == HttpClient::kNoContentLengthHeader) {
+      // No telling where it ends, so the connection can not be reused.
+      m_http.stop();
+      return;
+    }
+    unsigned long quietMs = millis();
+    for (long read = 0; read < length;) {
+      if (m_http.available()) {
+        m_http.read();
+        read++;
+        quietMs = millis();
+      } else if (!m_http.connected() || millis() - quietMs >= INFLUX_DRAIN_MS) {
+        m_http.stop();
+        return;
+      }
+    }
+  }
+
+  int InfiniInfluxWriter::lastStatus() const {
+    return m_lastStatus;
+  }
+
+  unsigned long InfiniInfluxWriter::lastBytesIn() const {
+    return m_lastBytesIn;
+  }
+
+  unsigned long InfiniInfluxWriter::lastBytesOut() const {
+    return m_lastBytesOut;
+  }
+#endif
+}
+#endif
@@ -0,0 +1,95 @@
+#ifndef INFINI_INFLUX_H
+#define INFINI_INFLUX_H
+
+#include <Print.h>
+#include "InfiniGsHistory.h"
+#include "InfiniDeflate.h"
+
+// Whether InfiniInfluxWriter is built, it needs ArduinoHttpClient, see lib_deps.
+#ifndef INFI_ENABLE_INFLUX_HTTP
+#  if defined(__has_include)
+#    if __has_include(<ArduinoHttpClient.h>)
+#      define INFI_ENABLE_INFLUX_HTTP 1
+#    else
+#      define INFI_ENABLE_INFLUX_HTTP 0
+#    endif
+#  else
+#    define INFI_ENABLE_INFLUX_HTTP 0
+#  endif
+#endif
+
+// Most points InfiniInfluxWriter::post() sends in one request.
+#ifndef INFI_INFLUX_BATCH_POINTS
+#define INFI_INFLUX_BATCH_POINTS 500
+#endif
+
+#if INFI_ENABLE_INFLUX_HTTP
+#include <ArduinoHttpClient.h>
+#endif
+
+namespace INFI {
+
+  const unsigned long INFLUX_BATCH_POINTS = INFI_INFLUX_BATCH_POINTS;
+
+  /*! Writes gs, taken at tsMs since the Unix epoch, as one point of InfluxDB line protocol and its '\n':
+   *   gs,device=inv0 gridVolt=230.1,acOutActivePow=512i,...,loadConnection=true 1700000000000000000
+   * Fields have the keys of writeGeneralStatusJson(). The 0.1 unit readings are floats, written from the fixed
+   * point value without float math, the rest integers, and the flags booleans, so every field keeps one type.
+   * The timestamp is in ns, write with precision=ns. Commas, spaces and '=' in measurement and device are
+   * escaped. Only the fields in fields are written, at least one has to be.
+   */
+  size_t writeGeneralStatusLine(Print &out, const char *measurement, const char *device, const GeneralStatusFixed &gs,
+                                uint64_t tsMs, GsFieldMask fields = GS_ALL_FIELDS);
+
+#if INFI_ENABLE_INFLUX_HTTP
+  /*!
+   * Uploads the samples of an InfiniGsHistory to InfluxDB, hundreds of points per POST instead of a request
+   * per sample. The body is line protocol printed straight into a chunked request, so a batch takes no RAM
+   * of its own, optionally through an InfiniDeflatePrint for Content-Encoding: gzip. The connection is kept
+   * alive, so only the first post() after a drop pays for the TCP, or TLS, handshake.
+   * post() blocks until InfluxDB answered, call it from a task that may wait, or between polls.
+   */
+  class InfiniInfluxWriter {
+    public:
+    /*! Posts through http to path, e.g. "/api/v2/write?org=home&bucket=solar&precision=ns" for InfluxDB 2, or
+     * "/write?db=solar&precision=ns" for 1.x. authorization, if not NULL, is the value of the Authorization
+     * header, e.g. "Token <API token>". Both must outlive the writer.
+     */
+    InfiniInfluxWriter(HttpClient &http, const char *path, const char *authorization = NULL);
+
+    //! The measurement of the points, "gs" by default. Must outlive the writer.
+    void setMeasurement(const char *measurement);
+    //! Only writes these GS fields, every one by default.
+    void setFields(GsFieldMask fields);
+    //! Compresses the bodies with deflate, a DEFLATE_GZIP one printing into the same HttpClient. NULL sends them plain.
+    void setCompression(InfiniDeflatePrint *deflate);
+
+    /*! POSTs the oldest samples of history, at most maxPoints, as points tagged device. Returns how many went,
+     * pop() them from history then, or 0 if InfluxDB did not answer 2xx, see lastStatus().
+     */
+    unsigned long post(const InfiniGsHistory &history, const char *device, unsigned long maxPoints = INFLUX_BATCH_POINTS);
+
+    //! The HTTP status of the last post(), or the negative error of HttpClient if there was none.
+    int lastStatus() const;
+    //! Body bytes of the last post() before and after compression.
+    unsigned long lastBytesIn() const;
+    unsigned long lastBytesOut() const;
+
+    private:
+    //! Reads the rest of the response, so the next request can go over the same connection.
+    void drainResponse();
+
+    HttpClient &m_http;
+    const char *m_path;
+    const char *m_authorization;
+    const char *m_measurement;
+    GsFieldMask m_fields;
+    InfiniDeflatePrint *m_deflate;
+    int m_lastStatus;
+    unsigned long m_lastBytesIn;
+    unsigned long m_lastBytesOut;
+  };
+#endif
+}
+
+#endif
@@ -0,0 +1,243 @@
+#include "InfiniInverterTask.h"
+
+#if INFI_MODULE_SCHEDULER
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <Arduino.h>
+
+namespace INFI {
+
+  InfiniInverterTask::InfiniInverterTask(InfiniPollScheduler &scheduler, InfiniCommandQueue &queue) :
+    m_scheduler(scheduler),
+    m_queue(queue),
+    m_requests(NULL),
+    m_task(NULL),
+    m_droppedResults(0)
+  {
+    for (BYTE i = 0; i < INVERTER_TASK_ROUTES_SZ; ++i) {
+      m_routes[i].task = this;
+      m_routes[i].inUse = false;
+      m_routes[i].permanent = false;
+    }
+  }
+
+  bool InfiniInverterTask::addPeriodic(COMMAND_TYPE commandType, unsigned long periodMs, CommandCallback callback,
+                                       void *context, const char* params) {
+    Route *route = allocRoute(true, callback, context);
+    if (route == NULL) {
+      return false;
+    }
+    if (!m_scheduler.addPeriodic(commandType, periodMs, onComplete, route, params)) {
+      route->inUse = false;
+      return false;
+    }
+    return true;
+  }
+
+  bool InfiniInverterTask::addOnSettingsChanged(COMMAND_TYPE commandType, CommandCallback callback, void *context,
+                                                unsigned long refreshMs, const char* params) {
+    Route *route = allocRoute(true, callback, context);
+    if (route == NULL) {
+      return false;
+    }
+    if (!m_scheduler.addOnSettingsChanged(commandType, onComplete, route, refreshMs, params)) {
+      route->inUse = false;
+      return false;
+    }
+    return true;
+  }
+
+  bool InfiniInverterTask::begin(BaseType_t core, UBaseType_t priority) {
+    if (m_task != NULL) {
+      return true;
+    }
+    m_requests = xQueueCreate(INVERTER_TASK_REQUESTS_SZ, sizeof(Request));
+    if (m_requests == NULL) {
+      return false;
+    }
+    return xTaskCreatePinnedToCore(run, "infi_io", INVERTER_TASK_STACK_SZ, this, priority, &m_task, core) == pdPASS;
+  }
+
+  bool InfiniInverterTask::request(COMMAND_TYPE commandType, const char* params, CommandCallback callback,
+                                   void *context) {
+    Request request;
+    request.kind = REQUEST_COMMAND;
+    request.commandType = commandType;
+    strncpy(request.params, params != NULL ? params : "", MAX_PARAMS_SZ - 1);
+    request.params[MAX_PARAMS_SZ - 1] = '\0';
+    request.callback = callback;
+    request.context = context;
+    request.response = NULL;
+    request.status = NULL;
+    request.waiter = NULL;
+    return post(request);
+  }
+
+  SEND_STATUS InfiniInverterTask::requestBlocking(COMMAND_TYPE commandType, const char* params,
+                                                  InfiniResponse &response) {
+    SEND_STATUS status = SEND_IDLE;
+    Request request;
+    request.kind = REQUEST_BLOCKING;
+    request.commandType = commandType;
+    strncpy(request.params, params != NULL ? params : "", MAX_PARAMS_SZ - 1);
+    request.params[MAX_PARAMS_SZ - 1] = '\0';
+    request.callback = NULL;
+    request.context = NULL;
+    request.response = &response;
+    request.status = &status;
+    request.waiter = xTaskGetCurrentTaskHandle();
+    response.reset();
+    response.cmdType = commandType;
+    if (!post(request)) {
+      return SEND_IDLE;
+    }
+    // The I/O task always notifies, even when the command could not be queued,
+    // so response and status are never written after we return.
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return status;
+  }
+
+  bool InfiniInverterTask::notifySettingsChanged() {
+    Request request;
+    memset(&request, 0, sizeof(request));
+    request.kind = REQUEST_SETTINGS_CHANGED;
+    return post(request);
+  }
+
+  bool InfiniInverterTask::trigger(COMMAND_TYPE commandType) {
+    Request request;
+    memset(&request, 0, sizeof(request));
+    request.kind = REQUEST_TRIGGER;
+    request.commandType = commandType;
+    return post(request);
+  }
+
+  BYTE InfiniInverterTask::dispatchResults() {
+    BYTE dispatched = 0;
+    Result result;
+    while (m_results.pop(result)) {
+      // The buffer goes back to the pool once the callback returned.
+      ResponseHandle response = m_pool.adopt(result.slot);
+      result.callback(*response, result.status, result.context);
+      dispatched++;
+    }
+    return dispatched;
+  }
+
+  unsigned long InfiniInverterTask::droppedResults() const {
+    return m_droppedResults;
+  }
+
+  void InfiniInverterTask::run(void *arg) {
+    InfiniInverterTask *task = (InfiniInverterTask *)arg;
+    Request request;
+    while (true) {
+      while (xQueueReceive(task->m_requests, &request, 0) == pdTRUE) {
+        task->handleRequest(request);
+      }
+      task->m_scheduler.loop();
+      // A byte takes about 4 ms at 2400 baud, a tick is plenty.
+      vTaskDelay(1);
+    }
+  }
+
+  void InfiniInverterTask::handleRequest(const Request &request) {
+    switch (request.kind) {
+      case REQUEST_COMMAND: {
+        Route *route = allocRoute(false, request.callback, request.context);
+        if (route == NULL || !m_queue.enqueue(request.commandType, request.params, onComplete, route)) {
+          if (route != NULL) {
+            route->inUse = false;
+          }
+        }
+        break;
+      }
+      case REQUEST_BLOCKING: {
+        Route *route = allocRoute(false, NULL, NULL);
+        if (route != NULL) {
+          route->response = request.response;
+          route->status = request.status;
+          route->waiter = request.waiter;
+          if (m_queue.enqueueWithPriority(PRIORITY_HIGH, request.commandType, request.params, onComplete, route)) {
+            break;
+          }
+          route->inUse = false;
+        }
+        // Could not be queued, status stays SEND_IDLE.
+        xTaskNotifyGive(request.waiter);
+        break;
+      }
+      case REQUEST_SETTINGS_CHANGED:
+        m_scheduler.notifySettingsChanged();
+        break;
+      case REQUEST_TRIGGER:
+        m_scheduler.trigger(request.commandType);
+        break;
+    }
+  }
+
+  void InfiniInverterTask::onComplete(const InfiniResponse &response, SEND_STATUS status, void *context) {
+    Route *route = (Route *)context;
+    InfiniInverterTask *task = route->task;
+    if (route->waiter != NULL) {
+      copyResponse(response.val, response.actualLen, response.cmdType, response.error, response.deviceId,
+                   response.sentUs, *route->response);
+      *route->status = status;
+      xTaskNotifyGive(route->waiter);
+    } else if (route->callback != NULL) {
+      ResponseHandle pooled = task->m_pool.acquire(response);
+      if (!pooled) {
+        task->m_droppedResults++;
+      } else {
+        Result result;
+        result.status = status;
+        result.slot = pooled.detach();
+        result.callback = route->callback;
+        result.context = route->context;
+        if (!task->m_results.push(result)) {
+          // Not posted, so the buffer is still ours to give back.
+          task->m_pool.adopt(result.slot).release();
+          task->m_droppedResults++;
+        }
+      }
+    }
+    if (!route->permanent) {
+      route->inUse = false;
+    }
+  }
+
+  void InfiniInverterTask::copyResponse(const char *val, size_t len, COMMAND_TYPE commandType, RESPONSE_ERROR error,
+                                        BYTE deviceId, unsigned long sentUs, InfiniResponse &response) {
+    memcpy(response.val, val, MAX_RESPONSE_SZ);
+    response.actualLen = len;
+    response.cmdType = commandType;
+    response.error = error;
+    response.deviceId = deviceId;
+    response.sentUs = sentUs;
+  }
+
+  InfiniInverterTask::Route *InfiniInverterTask::allocRoute(bool permanent, CommandCallback callback, void *context) {
+    for (BYTE i = 0; i < INVERTER_TASK_ROUTES_SZ; ++i) {
+      Route &route = m_routes[i];
+      if (!route.inUse) {
+        route.inUse = true;
+        route.permanent = permanent;
+        route.callback = callback;
+        route.context = context;
+        route.response = NULL;
+        route.status = NULL;
+        route.waiter = NULL;
+        return &route;
+      }
+    }
+    return NULL;
+  }
+
+  bool InfiniInverterTask::post(const Request &request) {
+    return m_requests != NULL && xQueueSend(m_requests, &request, 0) == pdTRUE;
+  }
+}
+
+#endif
+#endif
@@ -0,0 +1,164 @@
+#ifndef INFINI_INVERTER_TASK_H
+#define INFINI_INVERTER_TASK_H
+
+#include "InfiniPollScheduler.h"
+#include "InfiniResponsePool.h"
+#include "InfiniConcurrency.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+// Number of requests the network side can have waiting for the I/O task.
+#ifndef INFI_INVERTER_TASK_REQUESTS_SZ
+#define INFI_INVERTER_TASK_REQUESTS_SZ 8
+#endif
+
+// Number of finished commands waiting for dispatchResults(), a power of two of at most 128.
+// Each holds a response of the task's InfiniResponsePool, so it should not exceed INFI_RESPONSE_POOL_SZ.
+#ifndef INFI_INVERTER_TASK_RESULTS_SZ
+#define INFI_INVERTER_TASK_RESULTS_SZ INFI_RESPONSE_POOL_SZ
+#endif
+
+// Stack of the I/O task, in bytes.
+#ifndef INFI_INVERTER_TASK_STACK_SZ
+#define INFI_INVERTER_TASK_STACK_SZ 4096
+#endif
+
+namespace INFI {
+
+  const BYTE INVERTER_TASK_REQUESTS_SZ = INFI_INVERTER_TASK_REQUESTS_SZ;
+  const BYTE INVERTER_TASK_RESULTS_SZ = INFI_INVERTER_TASK_RESULTS_SZ;
+  const uint32_t INVERTER_TASK_STACK_SZ = INFI_INVERTER_TASK_STACK_SZ;
+
+  //! Every command that can be in flight or waiting at once, plus the scheduled ones.
+  const BYTE INVERTER_TASK_ROUTES_SZ = POLL_SCHEDULER_SZ + COMMAND_QUEUE_SZ + COMMAND_QUEUE_HIGH_SZ + 1;
+
+  /*!
+   * Runs an InfiniPollScheduler, its queue and the serial port behind them in a FreeRTOS task of their own,
+   * so the inverter link does not wait on WiFi and MQTT, and the other way round.
+   * Once begin() is called only the I/O task touches the scheduler, the queue and the sender.
+   * The network side talks to it through request(), requestBlocking(), notifySettingsChanged() and trigger(),
+   * and runs the command callbacks in its own task by calling dispatchResults() from loop().
+   * This way the callbacks can keep calling into the MQTT client, which is not thread safe.
+   * A finished reply is copied once, out of the sender into a buffer of the task's InfiniResponsePool, and only
+   * the handle of that buffer travels to dispatchResults(), whose callback is given the pooled response itself.
+   * Results go through an InfiniSpscRing, the I/O task being their only producer and dispatchResults() their only consumer.
+   */
+  class InfiniInverterTask {
+    public:
+    InfiniInverterTask(InfiniPollScheduler &scheduler, InfiniCommandQueue &queue);
+
+    /*! Like InfiniPollScheduler::addPeriodic(), but callback runs in dispatchResults().
+     * Only call before begin().
+     */
+    bool addPeriodic(COMMAND_TYPE commandType, unsigned long periodMs, CommandCallback callback,
+                     void *context = NULL, const char* params = "");
+
+    /*! Like InfiniPollScheduler::addOnSettingsChanged(), but callback runs in dispatchResults().
+     * Only call before begin().
+     */
+    bool addOnSettingsChanged(COMMAND_TYPE commandType, CommandCallback callback, void *context = NULL,
+                              unsigned long refreshMs = 0, const char* params = "");
+
+    /*! Creates the queues and starts the I/O task pinned to core.
+     * The Arduino loop task runs on core 1 and WiFi on core 0, the default keeps the link next to WiFi
+     * since both are mostly waiting. Returns false if FreeRTOS is out of memory.
+     */
+    bool begin(BaseType_t core = 0, UBaseType_t priority = 2);
+
+    /*! Asks the I/O task to queue a command. callback runs in dispatchResults() once it finished.
+     * Safe from any task. Returns false if the request queue is full.
+     */
+    bool request(COMMAND_TYPE commandType, const char* params, CommandCallback callback = NULL, void *context = NULL);
+
+    /*! Sends a command ahead of every lane and waits until its reply is copied into response.
+     * Meant for handlers that must answer synchronously, like RPCs. Never call it from the I/O task.
+     * The wait is bounded by the sender's timeout. Returns SEND_IDLE if the command could not be queued.
+     */
+    SEND_STATUS requestBlocking(COMMAND_TYPE commandType, const char* params, InfiniResponse &response);
+
+    //! InfiniPollScheduler::notifySettingsChanged(), from any task.
+    bool notifySettingsChanged();
+
+    //! InfiniPollScheduler::trigger(), from any task.
+    bool trigger(COMMAND_TYPE commandType);
+
+    /*! Runs the callbacks of the commands that finished since the last call, in the calling task.
+     * Call it from loop(). Returns the number of callbacks run.
+     */
+    BYTE dispatchResults();
+
+    //! Results thrown away because the network side did not call dispatchResults() often enough, or the pool ran out.
+    unsigned long droppedResults() const;
+
+    private:
+    enum REQUEST_KIND {
+      REQUEST_COMMAND = 0,
+      REQUEST_BLOCKING,
+      REQUEST_SETTINGS_CHANGED,
+      REQUEST_TRIGGER
+    };
+
+    //! What the network side posts to the I/O task.
+    struct Request {
+      REQUEST_KIND kind;
+      COMMAND_TYPE commandType;
+      char params[MAX_PARAMS_SZ];
+      CommandCallback callback;
+      void *context;
+      InfiniResponse *response;
+      SEND_STATUS *status;
+      TaskHandle_t waiter;
+    };
+
+    //! What the I/O task posts back, the pool slot of the reply and whom to hand it to.
+    struct Result {
+      SEND_STATUS status;
+      //! Owned by the result from its post until dispatchResults() adopt()s it.
+      BYTE slot;
+      CommandCallback callback;
+      void *context;
+    };
+
+    //! The context of a command on the queue, it remembers where its reply goes. Owned by the I/O task.
+    struct Route {
+      InfiniInverterTask *task;
+      bool inUse;
+      bool permanent;
+      CommandCallback callback;
+      void *context;
+      InfiniResponse *response;
+      SEND_STATUS *status;
+      TaskHandle_t waiter;
+    };
+
+    static void run(void *arg);
+
+    //! Queue callback of every command the task runs, context is the Route.
+    static void onComplete(const InfiniResponse &response, SEND_STATUS status, void *context);
+
+    //! Copies reply and status into response as seen by the network side.
+    static void copyResponse(const char *val, size_t len, COMMAND_TYPE commandType, RESPONSE_ERROR error,
+                             BYTE deviceId, unsigned long sentUs, InfiniResponse &response);
+
+    Route *allocRoute(bool permanent, CommandCallback callback, void *context);
+    bool post(const Request &request);
+    void handleRequest(const Request &request);
+
+    InfiniPollScheduler &m_scheduler;
+    InfiniCommandQueue &m_queue;
+    QueueHandle_t m_requests;
+    InfiniSpscRing<Result, INVERTER_TASK_RESULTS_SZ> m_results;
+    TaskHandle_t m_task;
+    Route m_routes[INVERTER_TASK_ROUTES_SZ];
+    //! The replies on their way to dispatchResults(), taken by the I/O task and released by the network side.
+    InfiniResponsePool m_pool;
+    volatile unsigned long m_droppedResults;
+  };
+}
+
+#endif
+#endif
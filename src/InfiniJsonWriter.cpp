@@ -0,0 +1,358 @@
+#include "InfiniJsonWriter.h"
+#include <stdio.h>
+
+namespace INFI {
+  InfiniBufferPrint::InfiniBufferPrint(char *buffer, size_t bufferSize) :
+    m_buffer(buffer),
+    m_bufferSize(bufferSize),
+    m_length(0)
+  {
+    if (m_bufferSize > 0) {
+      m_buffer[0] = '\0';
+    }
+  }
+
+  size_t InfiniBufferPrint::write(uint8_t c) {
+    // Always leave room for the null terminator.
+    if (m_length + 1 >= m_bufferSize) {
+      return 0;
+    }
+    m_buffer[m_length++] = (char)c;
+    m_buffer[m_length] = '\0';
+    return 1;
+  }
+
+  size_t InfiniBufferPrint::length() const {
+    return m_length;
+  }
+
+  InfiniCountingPrint::InfiniCountingPrint() :
+    m_count(0)
+  {}
+
+  size_t InfiniCountingPrint::write(uint8_t) {
+    m_count++;
+    return 1;
+  }
+
+  size_t InfiniCountingPrint::count() const {
+    return m_count;
+  }
+
+  InfiniKeyPrefixPrint::InfiniKeyPrefixPrint(Print &out, const char *prefix) :
+    m_out(out),
+    m_prefix(prefix),
+    m_keyNext(false),
+    m_arrayDepth(0)
+  {}
+
+  size_t InfiniKeyPrefixPrint::write(uint8_t c) {
+    if (c == '"' && m_keyNext) {
+      m_out.write(c);
+      m_out.print(m_prefix);
+      m_keyNext = false;
+      return 1;
+    }
+    if (c == '[') {
+      m_arrayDepth++;
+    } else if (c == ']' && m_arrayDepth > 0) {
+      m_arrayDepth--;
+    }
+    m_keyNext = (c == '{') || (c == ',' && m_arrayDepth == 0);
+    return m_out.write(c);
+  }
+
+  size_t printUint64(uint64_t value, Print &out) {
+    // In two parts that each fit an unsigned long.
+    const unsigned long high = (unsigned long)(value / 1000000000ULL);
+    const unsigned long low = (unsigned long)(value % 1000000000ULL);
+    if (high == 0) {
+      return out.print(low);
+    }
+    char digits[10];
+    snprintf(digits, sizeof(digits), "%09lu", low);
+    return printUint64(high, out) + out.print(digits);
+  }
+
+#if INFI_MODULE_JSON
+  // Writes "key": with the comma or brace that comes before it. key is in flash, see INFI_PSTR().
+  static size_t writeKey(Print &out, const char *key, bool first) {
+    size_t n = out.print(first ? '{' : ',');
+    n += out.print('"');
+    n += out.print(INFI_FLASH(key));
+    n += out.print('"');
+    n += out.print(':');
+    return n;
+  }
+
+  // Same as writeKey(), for a key in RAM.
+  static size_t writeRamKey(Print &out, const char *key, bool first) {
+    size_t n = out.print(first ? '{' : ',');
+    n += out.print('"');
+    n += out.print(key);
+    n += out.print('"');
+    n += out.print(':');
+    return n;
+  }
+
+  static size_t writeBoolValue(Print &out, bool value) {
+    return out.print(value ? INFI_F("true") : INFI_F("false"));
+  }
+
+  // A 0.1 unit reading, e.g. 2301 is written as 230.1, and 2300 as 230 like ArduinoJson does.
+  static size_t writeDeciValue(Print &out, WORD deci) {
+    size_t n = out.print((unsigned int)(deci / 10));
+    if (deci % 10 != 0) {
+      n += out.print('.');
+      n += out.print((unsigned int)(deci % 10));
+    }
+    return n;
+  }
+
+  static size_t writeValue(Print &out, long value, JSON_FIELD_KIND kind) {
+    if (kind == JSON_DECI) {
+      return writeDeciValue(out, (WORD)value);
+    }
+    if (kind == JSON_BOOL) {
+      return writeBoolValue(out, value != 0);
+    }
+    return out.print((unsigned int)value);
+  }
+
+  static size_t writeUInt(Print &out, const char *key, unsigned int value, bool first = false) {
+    size_t n = writeKey(out, key, first);
+    return n + out.print(value);
+  }
+
+  static size_t writeDeci(Print &out, const char *key, WORD deci, bool first = false) {
+    size_t n = writeKey(out, key, first);
+    return n + writeDeciValue(out, deci);
+  }
+
+  static size_t writeBool(Print &out, const char *key, bool value, bool first = false) {
+    size_t n = writeKey(out, key, first);
+    return n + writeBoolValue(out, value);
+  }
+
+  size_t writeJsonValue(Print &out, long value, JSON_FIELD_KIND kind) {
+    return writeValue(out, value, kind);
+  }
+
+  size_t writeJsonField(Print &out, const char *key, long value, JSON_FIELD_KIND kind, bool first) {
+    size_t n = writeRamKey(out, key, first);
+    return n + writeValue(out, value, kind);
+  }
+
+  size_t writeJsonFieldP(Print &out, const char *key, long value, JSON_FIELD_KIND kind, bool first) {
+    size_t n = writeKey(out, key, first);
+    return n + writeValue(out, value, kind);
+  }
+
+#define INFI_GS_JSON(field, member, key, shortKey, width, kind, bits) \
+    n += writeJsonFieldP(out, INFI_PSTR(key), gs.member, kind, field == 0);
+
+  size_t writeGeneralStatusJson(const GeneralStatusFixed &gs, Print &out) {
+    size_t n = 0;
+    INFI_GS_SCHEMA(INFI_GS_JSON)
+    n += out.print('}');
+    return n;
+  }
+
+  size_t writeRatedInformationJson(const RatedInformation &piri, Print &out) {
+    size_t n = writeDeci(out, INFI_PSTR("ratedAcInVolt"), piri.acInVoltDeci, true);
+    n += writeDeci(out, INFI_PSTR("ratedAcInFreq"), piri.acInFreqDeci);
+    n += writeDeci(out, INFI_PSTR("ratedAcInCurr"), piri.acInCurrDeci);
+    n += writeDeci(out, INFI_PSTR("ratedAcOutVolt"), piri.acOutVoltDeci);
+    n += writeDeci(out, INFI_PSTR("ratedAcOutFreq"), piri.acOutFreqDeci);
+    n += writeDeci(out, INFI_PSTR("ratedAcOutCurr"), piri.acOutCurrDeci);
+    n += writeUInt(out, INFI_PSTR("ratedAcOutApparentPow"), piri.acOutApparentPow);
+    n += writeUInt(out, INFI_PSTR("ratedAcOutActivePow"), piri.acOutActivePow);
+    n += writeDeci(out, INFI_PSTR("ratedBattVolt"), piri.battVoltDeci);
+    n += writeDeci(out, INFI_PSTR("ratedBattRechargeVolt"), piri.battRechargeVoltDeci);
+    n += writeDeci(out, INFI_PSTR("ratedBattRedischargeVolt"), piri.battRedischargeVoltDeci);
+    n += writeDeci(out, INFI_PSTR("ratedBattUnderVolt"), piri.battUnderVoltDeci);
+    n += writeDeci(out, INFI_PSTR("ratedBattBulkVolt"), piri.battBulkVoltDeci);
+    n += writeUInt(out, INFI_PSTR("ratedBattType"), piri.battType);
+    n += writeUInt(out, INFI_PSTR("ratedMaxACChargingCurr"), piri.maxACChargingCurr);
+    n += writeUInt(out, INFI_PSTR("ratedMaxChargingCurr"), piri.maxChargingCurr);
+    n += writeUInt(out, INFI_PSTR("ratedInVoltRange"), piri.inVoltRange);
+    n += writeUInt(out, INFI_PSTR("ratedOutSourcePriority"), piri.outSourcePriority);
+    n += writeUInt(out, INFI_PSTR("ratedChargerSourcePriority"), piri.chargerSourcePriority);
+    n += writeUInt(out, INFI_PSTR("ratedParallelMaxNum"), piri.parallelMaxNum);
+    n += writeUInt(out, INFI_PSTR("ratedMachineType"), piri.machineType);
+    n += writeUInt(out, INFI_PSTR("ratedTopology"), piri.topology);
+    n += writeUInt(out, INFI_PSTR("ratedOutModel"), piri.outModel);
+    n += writeUInt(out, INFI_PSTR("ratedSolarPowerPriority"), piri.solarPowerPriority);
+    n += writeUInt(out, INFI_PSTR("ratedMpptString"), piri.mpptString);
+    n += out.print('}');
+    return n;
+  }
+
+  // In the bit order of getFaultWarningFlags(). Rows of one width, so the whole table can stay in flash.
+  static const char FWS_FLAG_KEYS[FWS_FLAGS][23] INFI_PROGMEM = {
+    "lineFail", "outCircuitShort", "invOverTemp", "fanLocked",
+    "battVoltHigh", "battLow", "battUnder", "overLoad",
+    "eepromFail", "powLimit", "pv1VoltHigh", "pv2VoltHigh",
+    "mppt1Overload", "mppt2Overload", "battTooLowToChargeSCC1", "battTooLowToChargeSCC2"
+  };
+
+  const char *getFaultWarningFlagKey(BYTE flag) {
+    return flag < FWS_FLAGS ? FWS_FLAG_KEYS[flag] : NULL;
+  }
+
+  size_t writeFaultWarningStatusJson(const FaultWarningStatus &fws, Print &out) {
+    size_t n = writeUInt(out, INFI_PSTR("faultCode"), fws.faultCode, true);
+    const WORD flags = getFaultWarningFlags(fws);
+    for (BYTE i = 0; i < FWS_FLAGS; ++i) {
+      n += writeBool(out, FWS_FLAG_KEYS[i], (flags >> i) & 1);
+    }
+    n += out.print('}');
+    return n;
+  }
+
+  static const char FLAG_KEYS[9][28] INFI_PROGMEM = {
+    "buzzer", "overloadBypass", "lcdEscape", "overloadRestart", "overTempRestart",
+    "backlight", "primarySourceInterruptAlarm", "faultCodeRecord", "gridTie"
+  };
+
+  // DI has no grid tie default.
+  static const char DEFAULT_FLAG_KEYS[8][35] INFI_PROGMEM = {
+    "defaultBuzzer", "defaultOverloadBypass", "defaultLcdEscape", "defaultOverloadRestart", "defaultOverTempRestart",
+    "defaultBacklight", "defaultPrimarySourceInterruptAlarm", "defaultFaultCodeRecord"
+  };
+
+  // The FLAG switches, without the braces so DI can reuse them. keys[i] is the flash key of switch i.
+  template <size_t W>
+  static size_t writeFlagFields(const EnableDisableStatus &flag, Print &out, const char (*keys)[W], BYTE count, bool first) {
+    size_t n = writeBool(out, keys[0], flag.buzzer, first);
+    n += writeBool(out, keys[1], flag.overloadBypass);
+    n += writeBool(out, keys[2], flag.lcdEscape);
+    n += writeBool(out, keys[3], flag.overloadRestart);
+    n += writeBool(out, keys[4], flag.overTempRestart);
+    n += writeBool(out, keys[5], flag.backlight);
+    n += writeBool(out, keys[6], flag.primarySourceInterruptAlarm);
+    n += writeBool(out, keys[7], flag.faultCodeRecord);
+    if (count > 8) {
+      n += writeBool(out, keys[8], flag.gridTie);
+    }
+    return n;
+  }
+
+  size_t writeEnableDisableStatusJson(const EnableDisableStatus &flag, Print &out) {
+    size_t n = writeFlagFields(flag, out, FLAG_KEYS, 9, true);
+    n += out.print('}');
+    return n;
+  }
+
+  size_t writeDefaultValuesJson(const DefaultValues &di, Print &out) {
+    size_t n = writeDeci(out, INFI_PSTR("defaultAcOutVolt"), di.acOutVoltDeci, true);
+    n += writeDeci(out, INFI_PSTR("defaultAcOutFreq"), di.acOutFreqDeci);
+    n += writeUInt(out, INFI_PSTR("defaultAcInVoltRange"), di.acInVoltRange);
+    n += writeDeci(out, INFI_PSTR("defaultBattUnderVolt"), di.battUnderVoltDeci);
+    n += writeDeci(out, INFI_PSTR("defaultBattFloatVolt"), di.battFloatVoltDeci);
+    n += writeDeci(out, INFI_PSTR("defaultBattBulkVolt"), di.battBulkVoltDeci);
+    n += writeDeci(out, INFI_PSTR("defaultBattRechargeVolt"), di.battRechargeVoltDeci);
+    n += writeDeci(out, INFI_PSTR("defaultBattRedischargeVolt"), di.battRedischargeVoltDeci);
+    n += writeUInt(out, INFI_PSTR("defaultMaxChargingCurr"), di.maxChargingCurr);
+    n += writeUInt(out, INFI_PSTR("defaultMaxACChargingCurr"), di.maxACChargingCurr);
+    n += writeUInt(out, INFI_PSTR("defaultBattType"), di.battType);
+    n += writeUInt(out, INFI_PSTR("defaultOutSourcePriority"), di.outSourcePriority);
+    n += writeUInt(out, INFI_PSTR("defaultChargerSourcePriority"), di.chargerSourcePriority);
+    n += writeUInt(out, INFI_PSTR("defaultSolarPowerPriority"), di.solarPowerPriority);
+    n += writeUInt(out, INFI_PSTR("defaultMachineType"), di.machineType);
+    n += writeUInt(out, INFI_PSTR("defaultOutModel"), di.outModel);
+    n += writeFlagFields(di.flags, out, DEFAULT_FLAG_KEYS, 8, false);
+    n += out.print('}');
+    return n;
+  }
+
+  size_t writeChargingCurrentsJson(const char *key, const ChargingCurrents &currents, Print &out) {
+    size_t n = writeRamKey(out, key, true);
+    n += out.print('[');
+    for (BYTE i = 0; i < currents.count; ++i) {
+      if (i > 0) {
+        n += out.print(',');
+      }
+      n += out.print((unsigned int)currents.values[i]);
+    }
+    n += out.print(']');
+    n += out.print('}');
+    return n;
+  }
+
+  size_t writeDeviceInfoJson(const DeviceInfo &info, Print &out) {
+    size_t n = writeUInt(out, INFI_PSTR("protocolId"), info.protocolId, true);
+    n += writeKey(out, INFI_PSTR("seriesNumber"), false);
+    n += out.print('"');
+    n += out.print(info.seriesNumber);
+    n += out.print('"');
+    // Five digits, more than an unsigned int holds on AVR.
+    n += writeKey(out, INFI_PSTR("mainCpuVersion"), false);
+    n += out.print(info.mainCpuVersion);
+    n += writeKey(out, INFI_PSTR("slave1CpuVersion"), false);
+    n += out.print(info.slave1CpuVersion);
+    n += writeKey(out, INFI_PSTR("slave2CpuVersion"), false);
+    n += out.print(info.slave2CpuVersion);
+    n += out.print('}');
+    return n;
+  }
+
+  //! Writes {"key":value}, value may be past what an unsigned int holds on AVR.
+  static size_t writeULongJson(Print &out, const char *key, unsigned long value) {
+    size_t n = writeRamKey(out, key, true);
+    n += out.print(value);
+    n += out.print('}');
+    return n;
+  }
+
+  size_t writeDecodedJson(const InfiniDecoded &decoded, const char *key, Print &out) {
+    switch (decoded.cmdType) {
+      case CURRENT_TIME:
+        return writeULongJson(out, key, decoded.unixTime);
+      case TOTAL_GEN_ENERGY:
+      case GEN_ENERGY_YEAR:
+      case GEN_ENERGY_MONTH:
+      case GEN_ENERGY_DAY:
+        return writeULongJson(out, key, decoded.energy);
+      case GENERAL_STATUS:
+        return writeGeneralStatusJson(decoded.gs, out);
+      case QUERY_RATED_INFORMATION:
+        return writeRatedInformationJson(decoded.piri, out);
+      case FAULT_WARNING_STATUS:
+        return writeFaultWarningStatusJson(decoded.fws, out);
+      case QUERY_ENABLE_DISABLE_STATUS:
+        return writeEnableDisableStatusJson(decoded.flag, out);
+      case QUERY_DEFAULT_VALUE:
+        return writeDefaultValuesJson(decoded.di, out);
+      case QUERY_MAX_CHARGING_CURRENT:
+      case QUERY_MAX_AC_CHARGING_CURRENT:
+        return writeChargingCurrentsJson(key, decoded.currents, out);
+      case QUERY_PROTOCOL_ID:
+      case QUERY_SERIES_NUMBER:
+      case QUERY_CPU_VERSION:
+        return writeDeviceInfoJson(decoded.info, out);
+      case QUERY_WORKING_MODE:
+        return writeULongJson(out, key, decoded.workingMode);
+      default:
+        return 0;
+    }
+  }
+
+  size_t measureGeneralStatusJson(const GeneralStatusFixed &gs) {
+    InfiniCountingPrint counter;
+    return writeGeneralStatusJson(gs, counter);
+  }
+
+  GeneralStatusJson::GeneralStatusJson(const GeneralStatusFixed &gs) :
+    m_gs(gs)
+  {}
+
+  size_t GeneralStatusJson::printTo(Print &out) const {
+    return writeGeneralStatusJson(m_gs, out);
+  }
+
+  size_t GeneralStatusJson::length() const {
+    return measureGeneralStatusJson(m_gs);
+  }
+#endif
+}
@@ -0,0 +1,122 @@
+#ifndef INFINI_JSON_WRITER_H
+#define INFINI_JSON_WRITER_H
+
+#include <Print.h>
+#include <Printable.h>
+#include "InfiniDataTypes.h"
+
+namespace INFI {
+
+  //! A Print that fills a char buffer and keeps it null terminated, whatever does not fit is dropped.
+  class InfiniBufferPrint : public Print {
+    public:
+    InfiniBufferPrint(char *buffer, size_t bufferSize);
+
+    size_t write(uint8_t c) override;
+
+    //! Number of chars stored so far, not counting the null terminator.
+    size_t length() const;
+
+    private:
+    char *m_buffer;
+    size_t m_bufferSize;
+    size_t m_length;
+  };
+
+  //! A Print that only counts, for sinks that need the length up front, e.g. an MQTT begin_publish().
+  class InfiniCountingPrint : public Print {
+    public:
+    InfiniCountingPrint();
+
+    size_t write(uint8_t c) override;
+    size_t count() const;
+
+    private:
+    size_t m_count;
+  };
+
+  /*!
+   * Forwards to out, putting prefix in front of every top level key of the flat JSON objects written here,
+   * e.g. {"batteryVoltageDeci":... becomes {"inv1_batteryVoltageDeci":...
+   * Meant for telling several inverters apart in one telemetry stream.
+   */
+  class InfiniKeyPrefixPrint : public Print {
+    public:
+    InfiniKeyPrefixPrint(Print &out, const char *prefix);
+
+    size_t write(uint8_t c) override;
+
+    private:
+    Print &m_out;
+    const char *m_prefix;
+    //! True right after '{' or a top level ',', where the next '"' opens a key.
+    bool m_keyNext;
+    BYTE m_arrayDepth;
+  };
+
+  //! Prints value in decimal, e.g. a Unix time in ms, which Print has no overload for. Returns the bytes written.
+  size_t printUint64(uint64_t value, Print &out);
+
+  //! How writeJsonField() formats a value.
+  enum JSON_FIELD_KIND {
+    JSON_UINT = 0,  // A plain unsigned number.
+    JSON_DECI,      // A 0.1 unit reading, 2301 is written as 230.1.
+    JSON_BOOL       // true for anything but 0.
+  };
+
+#if INFI_MODULE_JSON
+  //! Writes one "key":value pair, preceded by '{' if first and by ',' otherwise.
+  size_t writeJsonField(Print &out, const char *key, long value, JSON_FIELD_KIND kind, bool first);
+  //! Same, with key in flash, e.g. writeJsonFieldP(out, INFI_PSTR("linkSent"), ...), so it takes no RAM on AVR.
+  size_t writeJsonFieldP(Print &out, const char *key, long value, JSON_FIELD_KIND kind, bool first);
+  //! Writes only the value of such a pair, e.g. 230.1, as the payload of a topic of its own.
+  size_t writeJsonValue(Print &out, long value, JSON_FIELD_KIND kind);
+
+  /*! Writes gs to out as the JSON object fromILGSToGeneralStatus() puts in parsed,
+   * field by field and without building a JsonDocument. Returns the number of bytes written.
+   */
+  size_t writeGeneralStatusJson(const GeneralStatusFixed &gs, Print &out);
+
+  //! The number of bytes writeGeneralStatusJson() would write for gs.
+  size_t measureGeneralStatusJson(const GeneralStatusFixed &gs);
+
+  /*! Writers for the typed config replies, same format as writeGeneralStatusJson().
+   * The PIRI and DI keys are prefixed with rated and default, so both can go to the same device.
+   */
+  size_t writeRatedInformationJson(const RatedInformation &piri, Print &out);
+  size_t writeFaultWarningStatusJson(const FaultWarningStatus &fws, Print &out);
+  //! The JSON key of bit flag of getFaultWarningFlags(), e.g. "battLow", or NULL past FWS_FLAGS. In flash on AVR.
+  const char *getFaultWarningFlagKey(BYTE flag);
+  size_t writeEnableDisableStatusJson(const EnableDisableStatus &flag, Print &out);
+  size_t writeDefaultValuesJson(const DefaultValues &di, Print &out);
+  //! Writes {"key":[a,b,...]}.
+  size_t writeChargingCurrentsJson(const char *key, const ChargingCurrents &currents, Print &out);
+  //! Writes {"protocolId":18,"seriesNumber":"...","mainCpuVersion":...,"slave1CpuVersion":...,"slave2CpuVersion":...}.
+  size_t writeDeviceInfoJson(const DeviceInfo &info, Print &out);
+  /*! Writes what InfiniResponseParser::decode() put in decoded with the writer of its cmdType.
+   * T, the energies, MOD and the charging currents have no key of their own and are written under key,
+   * e.g. {"key":1712345678}. Writes nothing for an UPDATE's ^1.
+   */
+  size_t writeDecodedJson(const InfiniDecoded &decoded, const char *key, Print &out);
+
+  /*!
+   * gs as a Printable, so it can go to anything that takes one,
+   * e.g. ThingsBoard's sendTelemetryPrintable() which streams it into the MQTT client.
+   * Only keeps a reference, gs must outlive it.
+   */
+  class GeneralStatusJson : public Printable {
+    public:
+    explicit GeneralStatusJson(const GeneralStatusFixed &gs);
+
+    size_t printTo(Print &out) const override;
+
+    //! Same as measureGeneralStatusJson().
+    size_t length() const;
+
+    private:
+    const GeneralStatusFixed &m_gs;
+  };
+#endif
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include "InfiniLinkCalibration.h"
+#include <string.h>
+
+namespace INFI {
+
+  InfiniLinkCalibration::InfiniLinkCalibration() {
+    reset();
+  }
+
+  void InfiniLinkCalibration::recordTurnaround(COMMAND_TYPE commandType, unsigned long turnaroundMs) {
+    TurnaroundEstimate &e = m_estimates[commandType];
+    if (turnaroundMs > TURNAROUND_MAX_MS) {
+      turnaroundMs = TURNAROUND_MAX_MS;
+    }
+    if (e.samples == 0) {
+      e.smoothed8 = (WORD)(turnaroundMs * 8);
+      e.deviation4 = (WORD)(turnaroundMs * 2);
+    } else {
+      // deviation += (|error| - deviation) / 4, then smoothed += error / 8, in their fixed point units.
+      long error = (long)turnaroundMs - (long)(e.smoothed8 >> 3);
+      unsigned long absError = error < 0 ? -error : error;
+      e.deviation4 = (WORD)(e.deviation4 - (e.deviation4 >> 2) + absError);
+      e.smoothed8 = (WORD)((long)e.smoothed8 + error);
+    }
+    if (e.samples < 0xFFFF) {
+      e.samples++;
+    }
+  }
+
+  void InfiniLinkCalibration::recordTimeout(COMMAND_TYPE commandType) {
+    TurnaroundEstimate &e = m_estimates[commandType];
+    if (e.samples == 0) {
+      return;
+    }
+    unsigned long deviation4 = (unsigned long)e.deviation4 * 2;
+    if (deviation4 < TURNAROUND_MIN_MS * 4) {
+      deviation4 = TURNAROUND_MIN_MS * 4;
+    }
+    // Enough to reach TURNAROUND_MAX_MS, beyond that it would only take longer to come back down.
+    e.deviation4 = (WORD)(deviation4 > TURNAROUND_MAX_MS ? TURNAROUND_MAX_MS : deviation4);
+  }
+
+  const TurnaroundEstimate &InfiniLinkCalibration::estimate(COMMAND_TYPE commandType) const {
+    return m_estimates[commandType];
+  }
+
+  unsigned long InfiniLinkCalibration::turnaroundMs(COMMAND_TYPE commandType) const {
+    const TurnaroundEstimate &e = m_estimates[commandType];
+    return e.samples == 0 ? TURNAROUND_MS : (e.smoothed8 + 4) >> 3;
+  }
+
+  unsigned long InfiniLinkCalibration::deadlineTurnaroundMs(COMMAND_TYPE commandType) const {
+    const TurnaroundEstimate &e = m_estimates[commandType];
+    if (e.samples == 0) {
+      return TURNAROUND_MS;
+    }
+    // deviation4 is the deviation in 1/4 ms, i.e. four times it in ms.
+    unsigned long margin = e.deviation4 > TURNAROUND_MIN_MS ? e.deviation4 : TURNAROUND_MIN_MS;
+    unsigned long turnaround = turnaroundMs(commandType) + margin;
+    return turnaround > TURNAROUND_MAX_MS ? TURNAROUND_MAX_MS : turnaround;
+  }
+
+  void InfiniLinkCalibration::reset() {
+    memset(m_estimates, 0, sizeof(m_estimates));
+  }
+
+  size_t InfiniLinkCalibration::writeJson(Print &out) const {
+    size_t n = out.print('{');
+    bool first = true;
+    for (BYTE i = 0; i < NUM_COMMAND_TYPES; ++i) {
+      const COMMAND_TYPE commandType = (COMMAND_TYPE)i;
+      const TurnaroundEstimate &e = m_estimates[i];
+      if (e.samples == 0) {
+        continue;
+      }
+      n += out.print(first ? "\"turn" : ",\"turn");
+      first = false;
+      n += out.print(getCommandDescriptor(commandType).mnemonic);
+      n += out.print("\":[");
+      n += out.print(turnaroundMs(commandType));
+      n += out.print(',');
+      n += out.print((unsigned long)((e.deviation4 + 2) >> 2));
+      n += out.print(',');
+      n += out.print(deadlineTurnaroundMs(commandType));
+      n += out.print(']');
+    }
+    n += out.print('}');
+    return n;
+  }
+}
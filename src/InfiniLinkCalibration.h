@@ -0,0 +1,68 @@
+#ifndef INFINI_LINK_CALIBRATION_H
+#define INFINI_LINK_CALIBRATION_H
+
+#include <Print.h>
+#include "InfiniCommon.h"
+
+// Bounds of the learnt turnaround a deadline allows for, milliseconds. The lower one is also the
+// least margin kept above the smoothed turnaround, for the jitter of polling the reply.
+#ifndef INFI_TURNAROUND_MIN_MS
+#define INFI_TURNAROUND_MIN_MS 30
+#endif
+#ifndef INFI_TURNAROUND_MAX_MS
+#define INFI_TURNAROUND_MAX_MS 2000
+#endif
+
+namespace INFI {
+
+  const unsigned long TURNAROUND_MIN_MS = INFI_TURNAROUND_MIN_MS;
+  const unsigned long TURNAROUND_MAX_MS = INFI_TURNAROUND_MAX_MS;
+
+  //! The turnaround learnt for one COMMAND_TYPE, fixed point to keep it small on AVR.
+  struct TurnaroundEstimate {
+    //! Smoothed turnaround, in 1/8 ms.
+    WORD smoothed8;
+    //! Smoothed deviation from it, in 1/4 ms.
+    WORD deviation4;
+    //! Replies it was learnt from, stops counting at 0xFFFF.
+    WORD samples;
+  };
+
+  /*!
+   * Learns how long the inverter takes to start replying to each COMMAND_TYPE, i.e. the reply latency
+   * minus the time the frame and the reply take on the wire, and derives the transaction deadlines from it.
+   * The estimate is smoothed like a TCP round trip time: the deadline allows for the smoothed turnaround
+   * plus four times its deviation, within TURNAROUND_MIN_MS and TURNAROUND_MAX_MS. A timeout doubles
+   * the deviation, so a slow reply is waited for longer next time rather than lost again.
+   * Until the first reply to a command, its deadline uses TURNAROUND_MS.
+   *
+   * Fed by InfiniCommandSender::setCalibration(), from the first command on and for as long as it runs.
+   * Tighter deadlines free the link sooner after a lost reply, so InfiniCommandQueue gets on with the next one.
+   */
+  class InfiniLinkCalibration {
+    public:
+    InfiniLinkCalibration();
+
+    //! A reply to commandType started turnaroundMs after the command was on the wire.
+    void recordTurnaround(COMMAND_TYPE commandType, unsigned long turnaroundMs);
+    void recordTimeout(COMMAND_TYPE commandType);
+
+    const TurnaroundEstimate &estimate(COMMAND_TYPE commandType) const;
+    //! The smoothed turnaround of commandType, TURNAROUND_MS if no reply was learnt from yet.
+    unsigned long turnaroundMs(COMMAND_TYPE commandType) const;
+    //! The turnaround a deadline for commandType should allow for.
+    unsigned long deadlineTurnaroundMs(COMMAND_TYPE commandType) const;
+
+    void reset();
+
+    /*! Writes a [turnaroundMs,deviationMs,deadlineTurnaroundMs] array for each command learnt from,
+     * e.g. {"turnGS":[212,9,248],"turnT":[180,4,210]}. Meant to go up as device attributes.
+     */
+    size_t writeJson(Print &out) const;
+
+    private:
+    TurnaroundEstimate m_estimates[NUM_COMMAND_TYPES];
+  };
+}
+
+#endif
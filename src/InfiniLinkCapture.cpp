@@ -0,0 +1,130 @@
+#include "InfiniLinkCapture.h"
+#include <Arduino.h>
+
+namespace INFI {
+
+  static const size_t CAPTURE_MASK = LINK_CAPTURE_SZ - 1;
+  static_assert(LINK_CAPTURE_SZ > CAPTURE_HEADER_SZ * 2 + 2, "INFI_LINK_CAPTURE_SZ is too small for a record");
+
+  InfiniLinkCapture::InfiniLinkCapture() :
+    m_head(0),
+    m_write(0),
+    m_recordStart(0),
+    m_recordMax(0),
+    m_recording(false),
+    m_pendingDrops(0),
+    m_dropped(0),
+    m_tail(0)
+  {}
+
+  bool InfiniLinkCapture::record(CAPTURE_RECORD_TYPE type, BYTE deviceId, unsigned long us, const BYTE *bytes, size_t len) {
+    if (!reserve(type, deviceId, us, len)) {
+      return false;
+    }
+    for (size_t i = 0; i < len; ++i) {
+      put(m_write++, bytes[i]);
+    }
+    commit();
+    return true;
+  }
+
+  bool InfiniLinkCapture::begin(CAPTURE_RECORD_TYPE type, BYTE deviceId, unsigned long us, size_t maxLen) {
+    return reserve(type, deviceId, us, maxLen);
+  }
+
+  void InfiniLinkCapture::write(BYTE b) {
+    if (m_recording && m_write - m_recordStart < CAPTURE_HEADER_SZ + m_recordMax) {
+      put(m_write++, b);
+    }
+  }
+
+  void InfiniLinkCapture::commit() {
+    if (!m_recording) {
+      return;
+    }
+    size_t len = m_write - m_recordStart - CAPTURE_HEADER_SZ;
+    put(m_recordStart + 7, (BYTE)(len & 0xFF));
+    put(m_recordStart + 8, (BYTE)(len >> 8));
+    m_recording = false;
+    // Published whole, so drain() never sends a record that is still being written.
+    m_head = m_write;
+  }
+
+  size_t InfiniLinkCapture::drain(Print &out) {
+    size_t head = m_head;
+    size_t tail = m_tail;
+    size_t written = 0;
+    while (tail != head) {
+      int room = out.availableForWrite();
+      if (room <= 0) {
+        break;
+      }
+      // Up to the end of the buffer at most, the rest of a wrapped record goes next round.
+      size_t at = tail & CAPTURE_MASK;
+      size_t len = head - tail;
+      if (len > LINK_CAPTURE_SZ - at) {
+        len = LINK_CAPTURE_SZ - at;
+      }
+      if (len > (size_t)room) {
+        len = (size_t)room;
+      }
+      size_t sent = out.write(m_buffer + at, len);
+      tail += sent;
+      written += sent;
+      if (sent < len) {
+        break;
+      }
+    }
+    m_tail = tail;
+    return written;
+  }
+
+  unsigned long InfiniLinkCapture::dropped() const {
+    return m_dropped;
+  }
+
+  size_t InfiniLinkCapture::freeSpace() const {
+    return LINK_CAPTURE_SZ - (m_write - m_tail);
+  }
+
+  void InfiniLinkCapture::put(size_t at, BYTE b) {
+    m_buffer[at & CAPTURE_MASK] = b;
+  }
+
+  void InfiniLinkCapture::flushDropped() {
+    if (m_pendingDrops == 0) {
+      return;
+    }
+    const BYTE count[2] = { (BYTE)(m_pendingDrops & 0xFF), (BYTE)(m_pendingDrops >> 8) };
+    m_pendingDrops = 0;
+    record(CAPTURE_DROPPED, 0, micros(), count, sizeof(count));
+  }
+
+  bool InfiniLinkCapture::reserve(CAPTURE_RECORD_TYPE type, BYTE deviceId, unsigned long us, size_t maxLen) {
+    if (m_recording || maxLen > 0xFFFF) {
+      return false;
+    }
+    // The drop count only goes in together with the record after it, not once per record that did not fit.
+    size_t needed = CAPTURE_HEADER_SZ + maxLen + (m_pendingDrops > 0 ? CAPTURE_HEADER_SZ + 2 : 0);
+    if (freeSpace() < needed) {
+      m_dropped++;
+      if (m_pendingDrops < 0xFFFF) {
+        m_pendingDrops++;
+      }
+      return false;
+    }
+    flushDropped();
+    m_recordStart = m_write;
+    m_recordMax = maxLen;
+    m_recording = true;
+    put(m_write++, CAPTURE_SYNC);
+    put(m_write++, (BYTE)type);
+    put(m_write++, deviceId);
+    for (BYTE i = 0; i < 4; ++i) {
+      put(m_write++, (BYTE)(us >> (8 * i)));
+    }
+    // The length is filled in by commit().
+    m_write += 2;
+    return true;
+  }
+}
@@ -0,0 +1,93 @@
+#ifndef INFINI_LINK_CAPTURE_H
+#define INFINI_LINK_CAPTURE_H
+
+#include <Print.h>
+#include "InfiniCommon.h"
+
+// Bytes of capture records buffered until drain() writes them out, a power of two.
+// At 2400 baud the link moves 240 bytes a second, so this covers several seconds of a stalled host.
+#ifndef INFI_LINK_CAPTURE_SZ
+#define INFI_LINK_CAPTURE_SZ 2048
+#endif
+
+namespace INFI {
+
+  const size_t LINK_CAPTURE_SZ = INFI_LINK_CAPTURE_SZ;
+  static_assert((LINK_CAPTURE_SZ & (LINK_CAPTURE_SZ - 1)) == 0, "INFI_LINK_CAPTURE_SZ must be a power of two");
+
+  //! First byte of every capture record, for the decoder to find its way back after a gap.
+  const BYTE CAPTURE_SYNC = 0xA5;
+  //! Sync, type, device id, uint32 micros() and uint16 length.
+  const BYTE CAPTURE_HEADER_SZ = 9;
+
+  //! Second byte of a capture record.
+  enum CAPTURE_RECORD_TYPE {
+    CAPTURE_TX = 1,     // A command frame, stamped just before its first byte was written.
+    CAPTURE_RX,         // A reply frame up to its '\r', stamped when the sender took its last byte.
+    CAPTURE_RX_PARTIAL, // What arrived of a reply that timed out or overflowed the buffer, stamped then.
+    CAPTURE_DROPPED     // Records lost since the last one because the ring was full, uint16 count as payload.
+  };
+
+  /*!
+   * A binary capture of every frame on the RS232 link, for timing analysis on a laptop during commissioning.
+   * The sender adds a record per command and reply, see InfiniCommandSender::setCapture(), and loop() calls drain()
+   * to pass them to a spare port, e.g. the USB Serial at 921600 baud. Capturing is a memcpy into a ring,
+   * so the link is timed the same with it on, and drain() only writes what the port takes without blocking.
+   *
+   * The stream is records back to back, multi byte fields little endian:
+   *   byte 0     CAPTURE_SYNC, 0xA5
+   *   byte 1     CAPTURE_RECORD_TYPE
+   *   byte 2     device id, see InfiniCommandSender::setDeviceId()
+   *   bytes 3-6  micros() of the record, wrapping every 71 minutes
+   *   bytes 7-8  payload length n
+   *   bytes 9-   n payload bytes, the frame as it went over the wire
+   * A decoder reads a header, checks the sync byte and takes n bytes. On a bad sync byte, e.g. when it
+   * started reading mid stream, it skips ahead to the next 0xA5 and tries again.
+   *
+   * One producer, the task that runs the sender, and one consumer, the one calling drain().
+   * The indexes are only atomic on 32 bit cores, on AVR both sides belong to loop().
+   */
+  class InfiniLinkCapture {
+    public:
+    InfiniLinkCapture();
+
+    //! Producer side. Adds a record of len bytes. Counts it as dropped and returns false if the ring is full.
+    bool record(CAPTURE_RECORD_TYPE type, BYTE deviceId, unsigned long us, const BYTE *bytes, size_t len);
+
+    /*! Producer side. Starts a record whose payload is written as it goes out, up to maxLen bytes,
+     * then write() its bytes and commit() it. Returns false, and drops the record, if maxLen does not fit.
+     */
+    bool begin(CAPTURE_RECORD_TYPE type, BYTE deviceId, unsigned long us, size_t maxLen);
+    void write(BYTE b);
+    void commit();
+
+    /*! Consumer side. Writes the buffered records to out, as much as out.availableForWrite() says it takes
+     * without blocking. Returns the number of bytes written.
+     */
+    size_t drain(Print &out);
+
+    //! Records lost because the ring was full.
+    unsigned long dropped() const;
+
+    private:
+    size_t freeSpace() const;
+    void put(size_t at, BYTE b);
+    //! Writes a CAPTURE_DROPPED record for the records lost since the last one went in.
+    void flushDropped();
+    bool reserve(CAPTURE_RECORD_TYPE type, BYTE deviceId, unsigned long us, size_t maxLen);
+
+    BYTE m_buffer[LINK_CAPTURE_SZ];
+    //! Written by the producer only. m_write runs ahead of m_head while a record is being written.
+    volatile size_t m_head;
+    size_t m_write;
+    size_t m_recordStart;
+    size_t m_recordMax;
+    bool m_recording;
+    WORD m_pendingDrops;
+    unsigned long m_dropped;
+    //! Written by the consumer only.
+    volatile size_t m_tail;
+  };
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include "InfiniLinkDiscovery.h"
+
+#if INFI_MODULE_SCHEDULER
+#include <Arduino.h>
+
+namespace INFI {
+
+  static const BYTE NO_CANDIDATE = 0xFF;
+
+  InfiniLinkDiscovery::InfiniLinkDiscovery(InfiniCommandSender **channels, BYTE count, LinkRouter route, void *context) :
+    m_channels(channels),
+    m_count(count < LINK_DISCOVERY_CANDIDATES ? count : LINK_DISCOVERY_CANDIDATES),
+    m_route(route),
+    m_context(context)
+  {}
+
+  BYTE InfiniLinkDiscovery::discover(BYTE candidates, const unsigned long *bauds, BYTE baudCount,
+                                     DiscoveredLink *found, BYTE foundSz) {
+    if (candidates > LINK_DISCOVERY_CANDIDATES) {
+      candidates = LINK_DISCOVERY_CANDIDATES;
+    }
+    // Per candidate, the next baud to try and whether it is settled. Per channel, what it probes this round.
+    BYTE nextBaud[LINK_DISCOVERY_CANDIDATES] = {};
+    bool settled[LINK_DISCOVERY_CANDIDATES] = {};
+    BYTE probing[LINK_DISCOVERY_CANDIDATES];
+    unsigned long probingBaud[LINK_DISCOVERY_CANDIDATES];
+    BYTE cursor[LINK_DISCOVERY_CANDIDATES] = {};
+    BYTE foundCount = 0;
+
+    while (foundCount < foundSz) {
+      BYTE active = 0;
+      for (BYTE ch = 0; ch < m_count; ++ch) {
+        probing[ch] = NO_CANDIDATE;
+        // Candidate c only ever goes to channel c % m_count, so two UARTs are never routed to the same pins.
+        // Round robin over those, so each is tried at a baud before any is tried at its next one.
+        for (BYTE k = 0; k < candidates && probing[ch] == NO_CANDIDATE; ++k) {
+          BYTE c = (cursor[ch] + k) % candidates;
+          if (c % m_count != ch || settled[c]) {
+            continue;
+          }
+          while (nextBaud[c] < baudCount && !m_route(ch, c, bauds[nextBaud[c]], m_context)) {
+            ++nextBaud[c];
+          }
+          if (nextBaud[c] >= baudCount) {
+            settled[c] = true;
+            continue;
+          }
+          probing[ch] = c;
+          probingBaud[ch] = bauds[nextBaud[c]++];
+          cursor[ch] = (c + 1) % candidates;
+        }
+        if (probing[ch] != NO_CANDIDATE) {
+          m_channels[ch]->setBaud(probingBaud[ch]);
+          m_channels[ch]->beginCommand(QUERY_PROTOCOL_ID, NULL);
+          ++active;
+        }
+      }
+      if (active == 0) {
+        break;
+      }
+
+      bool pending = true;
+      while (pending) {
+        pending = false;
+        for (BYTE ch = 0; ch < m_count; ++ch) {
+          if (probing[ch] != NO_CANDIDATE && m_channels[ch]->poll() == SEND_PENDING) {
+            pending = true;
+          }
+        }
+        if (pending) {
+          yield();
+        }
+      }
+
+      for (BYTE ch = 0; ch < m_count && foundCount < foundSz; ++ch) {
+        const BYTE c = probing[ch];
+        if (c == NO_CANDIDATE || m_channels[ch]->status() != SEND_COMPLETE ||
+            m_channels[ch]->response.error != RESP_OK) {
+          continue;
+        }
+        settled[c] = true;
+        found[foundCount].candidate = c;
+        found[foundCount].channel = ch;
+        found[foundCount].baud = probingBaud[ch];
+        ++foundCount;
+      }
+    }
+    return foundCount;
+  }
+}
+#endif
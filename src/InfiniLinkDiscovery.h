@@ -0,0 +1,58 @@
+#ifndef INFINI_LINK_DISCOVERY_H
+#define INFINI_LINK_DISCOVERY_H
+
+#include "InfiniCommandSender.h"
+
+// Most candidate links one discover() tells apart.
+#ifndef INFI_LINK_DISCOVERY_CANDIDATES
+#define INFI_LINK_DISCOVERY_CANDIDATES 8
+#endif
+
+namespace INFI {
+
+  const BYTE LINK_DISCOVERY_CANDIDATES = INFI_LINK_DISCOVERY_CANDIDATES;
+
+  /*! Routes the UART behind channel to the pins of candidate and switches it to baud, e.g. with
+   * HardwareSerial::begin(baud, SERIAL_8N1, rx, tx). Returns false if it can't, the candidate is then
+   * not tried at that baud.
+   */
+  typedef bool (*LinkRouter)(BYTE channel, BYTE candidate, unsigned long baud, void *context);
+
+  //! A candidate an inverter answered on.
+  struct DiscoveredLink {
+    BYTE candidate;
+    //! The channel it answered on, c % count. Still routed to it after discover() unless a later round took it over.
+    BYTE channel;
+    unsigned long baud;
+  };
+
+  /*!
+   * Finds the links inverters are wired to at boot, so one image runs on boxes wired differently.
+   * A candidate is a pin pair an inverter may be on, a channel is a UART with its own InfiniCommandSender
+   * that can be routed to them, on ESP32 through the GPIO matrix. Candidate c is only ever routed to channel
+   * c % count, so no two UARTs drive the same pins. Every round routes each channel to one of its unanswered
+   * candidates, writes a PI query on all of them at once and polls them together, so a round takes one reply
+   * deadline however many channels there are. Candidates are tried at each of the bauds in order, and
+   * dropped once they answered or ran out of bauds.
+   * A candidate is one RS232 port: the machines of a parallel system behind it are addressed through it.
+   */
+  class InfiniLinkDiscovery {
+    public:
+    //! channels are count senders, one per UART. route switches them between candidates.
+    InfiniLinkDiscovery(InfiniCommandSender **channels, BYTE count, LinkRouter route, void *context = NULL);
+
+    /*! Probes candidates 0 to candidates - 1, at most LINK_DISCOVERY_CANDIDATES, at each of the baudCount bauds.
+     * Blocks like InfiniCommandSender::sendCommand() for every round.
+     * Fills found with up to foundSz answered candidates in the order they answered and returns how many.
+     */
+    BYTE discover(BYTE candidates, const unsigned long *bauds, BYTE baudCount, DiscoveredLink *found, BYTE foundSz);
+
+    private:
+    InfiniCommandSender **m_channels;
+    BYTE m_count;
+    LinkRouter m_route;
+    void *m_context;
+  };
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include "InfiniLinkStats.h"
+
+#if INFI_MODULE_STATS
+#include <string.h>
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+  // Upper bounds of the latency buckets, in ms. A ^S ack takes about 320 ms and GS about 560 ms at 2400 baud.
+  static const WORD LATENCY_BUCKET_MAX_MS[LATENCY_BUCKETS - 1] = { 200, 300, 400, 500, 600, 800, 1200 };
+
+  InfiniLinkStats::InfiniLinkStats() {
+    reset();
+  }
+
+  void InfiniLinkStats::recordSent(COMMAND_TYPE commandType) {
+    m_commands[commandType].sent++;
+  }
+
+  void InfiniLinkStats::recordReply(COMMAND_TYPE commandType, RESPONSE_ERROR error, unsigned long latencyMs) {
+    CommandStats &stats = m_commands[commandType];
+    switch (error) {
+      case RESP_OK:
+        stats.ok++;
+        break;
+      case RESP_NAK:
+        stats.nak++;
+        break;
+      case RESP_BAD_CRC:
+        stats.crcError++;
+        break;
+      default:
+        stats.badFrame++;
+        break;
+    }
+    stats.latencySumMs += latencyMs;
+    BYTE bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && latencyMs > LATENCY_BUCKET_MAX_MS[bucket]) {
+      bucket++;
+    }
+    m_latency[bucket]++;
+  }
+
+  void InfiniLinkStats::recordTimeout(COMMAND_TYPE commandType) {
+    m_commands[commandType].timeout++;
+  }
+
+  const CommandStats &InfiniLinkStats::command(COMMAND_TYPE commandType) const {
+    return m_commands[commandType];
+  }
+
+  CommandStats InfiniLinkStats::total() const {
+    CommandStats sum;
+    memset(&sum, 0, sizeof(sum));
+    for (BYTE i = 0; i < NUM_COMMAND_TYPES; ++i) {
+      const CommandStats &stats = m_commands[i];
+      sum.sent += stats.sent;
+      sum.ok += stats.ok;
+      sum.nak += stats.nak;
+      sum.timeout += stats.timeout;
+      sum.crcError += stats.crcError;
+      sum.badFrame += stats.badFrame;
+      sum.latencySumMs += stats.latencySumMs;
+    }
+    return sum;
+  }
+
+  unsigned long InfiniLinkStats::meanLatencyMs(COMMAND_TYPE commandType) const {
+    const CommandStats &stats = m_commands[commandType];
+    unsigned long replies = stats.ok + stats.nak + stats.crcError + stats.badFrame;
+    return replies == 0 ? 0 : stats.latencySumMs / replies;
+  }
+
+  unsigned long InfiniLinkStats::latencyBucket(BYTE i) const {
+    return i < LATENCY_BUCKETS ? m_latency[i] : 0;
+  }
+
+  WORD InfiniLinkStats::latencyBucketMaxMs(BYTE i) {
+    return i < LATENCY_BUCKETS - 1 ? LATENCY_BUCKET_MAX_MS[i] : 0;
+  }
+
+  void InfiniLinkStats::reset() {
+    memset(m_commands, 0, sizeof(m_commands));
+    memset(m_latency, 0, sizeof(m_latency));
+  }
+
+  size_t InfiniLinkStats::writeJson(Print &out) const {
+    CommandStats sum = total();
+    size_t n = writeJsonFieldP(out, INFI_PSTR("linkSent"), sum.sent, JSON_UINT, true);
+    n += writeJsonFieldP(out, INFI_PSTR("linkOk"), sum.ok, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("linkNak"), sum.nak, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("linkTimeout"), sum.timeout, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("linkCrcError"), sum.crcError, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("linkBadFrame"), sum.badFrame, JSON_UINT, false);
+    n += out.print(INFI_F(",\"linkLatency\":["));
+    for (BYTE i = 0; i < LATENCY_BUCKETS; ++i) {
+      if (i > 0) {
+        n += out.print(',');
+      }
+      n += out.print(m_latency[i]);
+    }
+    n += out.print(']');
+    for (BYTE i = 0; i < NUM_COMMAND_TYPES; ++i) {
+      const CommandStats &stats = m_commands[i];
+      if (stats.sent == 0) {
+        continue;
+      }
+      n += out.print(INFI_F(",\"link"));
+      n += out.print(getCommandDescriptor((COMMAND_TYPE)i).mnemonic);
+      n += out.print("\":[");
+      n += out.print(stats.sent);
+      n += out.print(',');
+      n += out.print(stats.ok);
+      n += out.print(',');
+      n += out.print(stats.nak);
+      n += out.print(',');
+      n += out.print(stats.timeout);
+      n += out.print(',');
+      n += out.print(stats.crcError);
+      n += out.print(',');
+      n += out.print(stats.badFrame);
+      n += out.print(',');
+      n += out.print(meanLatencyMs((COMMAND_TYPE)i));
+      n += out.print(']');
+    }
+    n += out.print('}');
+    return n;
+  }
+}
+#endif
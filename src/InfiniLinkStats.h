@@ -0,0 +1,64 @@
+#ifndef INFINI_LINK_STATS_H
+#define INFINI_LINK_STATS_H
+
+#include <Print.h>
+#include "InfiniCommon.h"
+
+namespace INFI {
+
+  //! Buckets of the reply latency histogram, the last one takes everything slower.
+  const BYTE LATENCY_BUCKETS = 8;
+
+  //! Counters of one COMMAND_TYPE. Every sent command ends up in exactly one of the others.
+  struct CommandStats {
+    unsigned long sent;
+    unsigned long ok;
+    unsigned long nak;
+    unsigned long timeout;
+    unsigned long crcError;
+    //! Bad start token or length.
+    unsigned long badFrame;
+    //! Summed over the replies that arrived, for meanLatencyMs().
+    unsigned long latencySumMs;
+  };
+
+  /*!
+   * Link quality counters per COMMAND_TYPE and a histogram of the reply latency, from writing the
+   * command to its '\r'. Fed by InfiniCommandSender::setStats(). A rising share of CRC errors or
+   * timeouts on one inverter usually means a failing RS232 converter or cable.
+   */
+  class InfiniLinkStats {
+    public:
+    InfiniLinkStats();
+
+    void recordSent(COMMAND_TYPE commandType);
+    //! A whole frame arrived latencyMs after the command was written, error is how it was judged.
+    void recordReply(COMMAND_TYPE commandType, RESPONSE_ERROR error, unsigned long latencyMs);
+    void recordTimeout(COMMAND_TYPE commandType);
+
+    const CommandStats &command(COMMAND_TYPE commandType) const;
+    //! All commands summed up.
+    CommandStats total() const;
+    //! Mean latency of the replies to commandType, 0 if none arrived.
+    unsigned long meanLatencyMs(COMMAND_TYPE commandType) const;
+
+    //! Replies in bucket i of the histogram.
+    unsigned long latencyBucket(BYTE i) const;
+    //! The slowest latency counted in bucket i, 0 for the last one, which has no limit.
+    static WORD latencyBucketMaxMs(BYTE i);
+
+    void reset();
+
+    /*! Writes the totals, the histogram and a [sent,ok,nak,timeout,crc,badFrame,meanMs] array for each
+     * command sent at least once, e.g. {"linkSent":120,...,"linkLatency":[0,3,...],"linkGS":[60,59,0,1,0,0,556]}.
+     * Meant to go up as device attributes.
+     */
+    size_t writeJson(Print &out) const;
+
+    private:
+    CommandStats m_commands[NUM_COMMAND_TYPES];
+    unsigned long m_latency[LATENCY_BUCKETS];
+  };
+}
+
+#endif
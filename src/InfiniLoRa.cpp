@@ -0,0 +1,281 @@
+#include "InfiniLoRa.h"
+
+#if INFI_MODULE_SINKS
+#include <string.h>
+
+namespace INFI {
+
+#define INFI_GS_RANGE_BITS(field, member, key, shortKey, width, kind, bits) rangeBits(width, bits),
+
+  //! Bits for the largest value of width decimal digits, e.g. 10 for 999.
+  static constexpr BYTE digitBits(BYTE width) {
+    return width <= 1 ? 4 : width == 2 ? 7 : width == 3 ? 10 : 14;
+  }
+
+  //! Bits a field takes: its digits, unless its member is narrower.
+  static constexpr BYTE rangeBits(BYTE width, BYTE bits) {
+    return digitBits(width) < bits ? digitBits(width) : bits;
+  }
+
+  // The bits of each field, by GS_FIELD.
+  static constexpr BYTE GS_RANGE_BITS[NUM_GS_FIELDS] = {
+    INFI_GS_SCHEMA(INFI_GS_RANGE_BITS)
+  };
+
+  static const BYTE VERSION_BITS = 2;
+  static const BYTE SAMPLES_BITS = 6;
+  // Two strings add up to one bit more than either.
+  static constexpr BYTE PV_BITS = GS_RANGE_BITS[GS_PV1_IN_POW] + 1;
+  static constexpr BYTE BATT_VOLT_BITS = GS_RANGE_BITS[GS_BATT_VOLT];
+  static constexpr BYTE SOC_BITS = GS_RANGE_BITS[GS_BATT_CAPACITY];
+  // Either current, plus the sign.
+  static constexpr BYTE BATT_CURR_BITS = GS_RANGE_BITS[GS_BATT_CHARGE_CURR] + 1;
+  static constexpr BYTE LOAD_BITS = GS_RANGE_BITS[GS_AC_OUT_ACTIVE_POW];
+  static const BYTE FAULT_CODE_BITS = 8;
+  static const BYTE ENERGY_BITS = 20;
+
+  static constexpr WORD PAYLOAD_BITS = VERSION_BITS + SAMPLES_BITS + 2 * PV_BITS + 2 * BATT_VOLT_BITS + SOC_BITS +
+                                       BATT_CURR_BITS + 2 * LOAD_BITS + FAULT_CODE_BITS + FWS_FLAGS + ENERGY_BITS;
+  static_assert((PAYLOAD_BITS + 7) / 8 == LORA_PAYLOAD_SZ, "LORA_PAYLOAD_SZ must fit the fields of the schema");
+  static_assert(LORA_ENERGY_UNKNOWN == (1UL << ENERGY_BITS) - 1, "LORA_ENERGY_UNKNOWN must be all ENERGY_BITS set");
+
+  //! Writes fields into a zeroed buffer, least significant bit first.
+  class BitPacker {
+    public:
+    BitPacker(BYTE *buf) : m_buf(buf), m_bit(0) {}
+
+    //! Writes value in bits, clamped to the most they hold.
+    void put(unsigned long value, BYTE bits) {
+      const unsigned long most = (1UL << bits) - 1;
+      value = value < most ? value : most;
+      for (BYTE i = 0; i < bits; ++i, ++m_bit) {
+        if (value & (1UL << i)) {
+          m_buf[m_bit / 8] |= 1 << (m_bit % 8);
+        }
+      }
+    }
+
+    //! Writes value in bits as two's complement, clamped to the range they hold.
+    void putSigned(long value, BYTE bits) {
+      const long most = (1L << (bits - 1)) - 1;
+      value = value > most ? most : value < -most - 1 ? -most - 1 : value;
+      put((unsigned long)value & ((1UL << bits) - 1), bits);
+    }
+
+    private:
+    BYTE *m_buf;
+    WORD m_bit;
+  };
+
+  class BitReader {
+    public:
+    BitReader(const BYTE *buf) : m_buf(buf), m_bit(0) {}
+
+    unsigned long get(BYTE bits) {
+      unsigned long value = 0;
+      for (BYTE i = 0; i < bits; ++i, ++m_bit) {
+        if (m_buf[m_bit / 8] & (1 << (m_bit % 8))) {
+          value |= 1UL << i;
+        }
+      }
+      return value;
+    }
+
+    long getSigned(BYTE bits) {
+      const unsigned long value = get(bits);
+      return (value & (1UL << (bits - 1))) ? (long)value - (1L << bits) : (long)value;
+    }
+
+    private:
+    const BYTE *m_buf;
+    WORD m_bit;
+  };
+
+  BYTE packLoRaRollup(const LoRaRollup &rollup, BYTE *buf) {
+    memset(buf, 0, LORA_PAYLOAD_SZ);
+    BitPacker out(buf);
+    out.put(LORA_PAYLOAD_VERSION, VERSION_BITS);
+    out.put(rollup.samples, SAMPLES_BITS);
+    out.put(rollup.pvPowAvg, PV_BITS);
+    out.put(rollup.pvPowMax, PV_BITS);
+    out.put(rollup.battVoltAvgDeci, BATT_VOLT_BITS);
+    out.put(rollup.battVoltMinDeci, BATT_VOLT_BITS);
+    out.put(rollup.battCapacity, SOC_BITS);
+    out.putSigned(rollup.battCurrAvg, BATT_CURR_BITS);
+    out.put(rollup.loadPowAvg, LOAD_BITS);
+    out.put(rollup.loadPowMax, LOAD_BITS);
+    out.put(rollup.faultCode, FAULT_CODE_BITS);
+    out.put(rollup.warningFlags, FWS_FLAGS);
+    out.put(rollup.energyTodayWh, ENERGY_BITS);
+    return LORA_PAYLOAD_SZ;
+  }
+
+  bool unpackLoRaRollup(const BYTE *buf, size_t len, LoRaRollup &rollup) {
+    if (len < LORA_PAYLOAD_SZ) {
+      return false;
+    }
+    BitReader in(buf);
+    if (in.get(VERSION_BITS) != LORA_PAYLOAD_VERSION) {
+      return false;
+    }
+    rollup.samples = in.get(SAMPLES_BITS);
+    rollup.pvPowAvg = in.get(PV_BITS);
+    rollup.pvPowMax = in.get(PV_BITS);
+    rollup.battVoltAvgDeci = in.get(BATT_VOLT_BITS);
+    rollup.battVoltMinDeci = in.get(BATT_VOLT_BITS);
+    rollup.battCapacity = in.get(SOC_BITS);
+    rollup.battCurrAvg = in.getSigned(BATT_CURR_BITS);
+    rollup.loadPowAvg = in.get(LOAD_BITS);
+    rollup.loadPowMax = in.get(LOAD_BITS);
+    rollup.faultCode = in.get(FAULT_CODE_BITS);
+    rollup.warningFlags = in.get(FWS_FLAGS);
+    rollup.energyTodayWh = in.get(ENERGY_BITS);
+    return true;
+  }
+
+  unsigned long loraAirtimeMs(BYTE payloadSz, BYTE spreadingFactor, WORD bandwidthKhz) {
+    // Semtech's formula, in microseconds. Explicit header and CRC on, coding rate 4/5.
+    const unsigned long symbolUs = (1000UL << spreadingFactor) / bandwidthKhz;
+    const long lowRate = (spreadingFactor >= 11 && bandwidthKhz <= 125) ? 1 : 0;
+    const long bits = 8L * payloadSz - 4L * spreadingFactor + 28 + 16;
+    const long perBlock = 4L * (spreadingFactor - 2 * lowRate);
+    const long blocks = bits > 0 ? (bits + perBlock - 1) / perBlock : 0;
+    const unsigned long symbols = 8 + blocks * 5;
+    // The preamble's 8 symbols and 4.25 more for the sync word.
+    const unsigned long us = (8 * 4 + 17) * symbolUs / 4 + symbols * symbolUs;
+    return (us + 999) / 1000;
+  }
+
+  InfiniLoRaUplink::InfiniLoRaUplink(LoRaSendFunction send, void *context) :
+    m_send(send),
+    m_context(context),
+    m_periodMs(LORA_DEFAULT_PERIOD_MS),
+    m_dutyPerMille(10),
+    m_airtimeMs(0),
+    m_started(false),
+    m_sentMs(0),
+    m_sent(0),
+    m_failed(0)
+  {
+    setRadio(9, 125, 13);
+    memset(&m_rollup, 0, sizeof(m_rollup));
+    m_rollup.energyTodayWh = LORA_ENERGY_UNKNOWN;
+    restart();
+  }
+
+  void InfiniLoRaUplink::setPeriod(unsigned long periodMs) {
+    m_periodMs = periodMs;
+  }
+
+  void InfiniLoRaUplink::setDutyCycle(WORD perMille) {
+    m_dutyPerMille = perMille > 0 ? perMille : 1;
+  }
+
+  void InfiniLoRaUplink::setRadio(BYTE spreadingFactor, WORD bandwidthKhz, BYTE overheadSz) {
+    m_airtimeMs = loraAirtimeMs(LORA_PAYLOAD_SZ + overheadSz, spreadingFactor, bandwidthKhz);
+  }
+
+  void InfiniLoRaUplink::restart() {
+    const BYTE soc = m_rollup.battCapacity;
+    const unsigned long energyWh = m_rollup.energyTodayWh;
+    memset(&m_rollup, 0, sizeof(m_rollup));
+    m_rollup.battCapacity = soc;
+    m_rollup.energyTodayWh = energyWh;
+    m_samples = 0;
+    m_pvSum = 0;
+    m_battVoltSum = 0;
+    m_battCurrSum = 0;
+    m_loadSum = 0;
+  }
+
+  static WORD roundedAvg(unsigned long sum, unsigned long count) {
+    return (WORD)((sum + count / 2) / count);
+  }
+
+  void InfiniLoRaUplink::add(const GeneralStatusFixed &gs) {
+    const WORD pv = gs.pv1InPow + gs.pv2InPow;
+    const long battCurr = (long)gs.battChargeCurr - (long)gs.battDischargeCurr;
+    if (m_samples == 0) {
+      m_rollup.battVoltMinDeci = gs.battVoltDeci;
+    }
+    m_samples++;
+    m_pvSum += pv;
+    m_battVoltSum += gs.battVoltDeci;
+    m_battCurrSum += battCurr;
+    m_loadSum += gs.acOutActivePow;
+
+    const long half = (long)(m_samples / 2);
+    m_rollup.samples = m_samples < 63 ? m_samples : 63;
+    m_rollup.pvPowAvg = roundedAvg(m_pvSum, m_samples);
+    m_rollup.pvPowMax = pv > m_rollup.pvPowMax ? pv : m_rollup.pvPowMax;
+    m_rollup.battVoltAvgDeci = roundedAvg(m_battVoltSum, m_samples);
+    m_rollup.battVoltMinDeci = gs.battVoltDeci < m_rollup.battVoltMinDeci ? gs.battVoltDeci : m_rollup.battVoltMinDeci;
+    m_rollup.battCapacity = gs.battCapacity;
+    m_rollup.battCurrAvg = (int16_t)((m_battCurrSum >= 0 ? m_battCurrSum + half : m_battCurrSum - half) / (long)m_samples);
+    m_rollup.loadPowAvg = roundedAvg(m_loadSum, m_samples);
+    m_rollup.loadPowMax = gs.acOutActivePow > m_rollup.loadPowMax ? gs.acOutActivePow : m_rollup.loadPowMax;
+  }
+
+  void InfiniLoRaUplink::addFaults(const FaultWarningStatus &fws) {
+    if (fws.faultCode != 0) {
+      m_rollup.faultCode = fws.faultCode;
+    }
+    m_rollup.warningFlags |= getFaultWarningFlags(fws);
+  }
+
+  void InfiniLoRaUplink::setEnergyToday(unsigned long wh) {
+    m_rollup.energyTodayWh = wh;
+  }
+
+  unsigned long InfiniLoRaUplink::minIntervalMs() const {
+    return m_airtimeMs * 1000 / m_dutyPerMille;
+  }
+
+  unsigned long InfiniLoRaUplink::msUntilWork(unsigned long nowMs) const {
+    if (!m_started) {
+      return 0;
+    }
+    const unsigned long minInterval = minIntervalMs();
+    return msUntilElapsed(m_sentMs, m_periodMs > minInterval ? m_periodMs : minInterval, nowMs);
+  }
+
+  void InfiniLoRaUplink::loop(unsigned long nowMs) {
+    if (!m_started) {
+      // The first rollup covers a whole period too.
+      m_started = true;
+      m_sentMs = nowMs;
+      return;
+    }
+    if (msUntilWork(nowMs) > 0) {
+      return;
+    }
+    BYTE payload[LORA_PAYLOAD_SZ];
+    packLoRaRollup(m_rollup, payload);
+    // A refused payload did not go on air either, so it is tried again a period on, with what came since.
+    m_sentMs = nowMs;
+    if (!m_send(payload, sizeof(payload), m_context)) {
+      m_failed++;
+      return;
+    }
+    m_sent++;
+    restart();
+  }
+
+  const LoRaRollup &InfiniLoRaUplink::rollup() const {
+    return m_rollup;
+  }
+
+  unsigned long InfiniLoRaUplink::airtimeMs() const {
+    return m_airtimeMs;
+  }
+
+  unsigned long InfiniLoRaUplink::sent() const {
+    return m_sent;
+  }
+
+  unsigned long InfiniLoRaUplink::failed() const {
+    return m_failed;
+  }
+}
+
+#endif
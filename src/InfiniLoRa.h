@@ -0,0 +1,131 @@
+#ifndef INFINI_LORA_H
+#define INFINI_LORA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "InfiniDataTypes.h"
+
+namespace INFI {
+
+  /*!
+   * One uplink of InfiniLoRaUplink: what the inverter did since the previous one.
+   * Power in W, voltage in 0.1 V and current in A, the units GeneralStatusFixed stores them in. Averages are rounded.
+   */
+  struct LoRaRollup {
+    //! GS samples folded in, at most 63. 0 if none were, the GS fields are 0 then.
+    BYTE samples;
+    //! pv1InPow plus pv2InPow.
+    WORD pvPowAvg;
+    WORD pvPowMax;
+    WORD battVoltAvgDeci;
+    WORD battVoltMinDeci;
+    //! battCapacity of the last sample, the SOC in %.
+    BYTE battCapacity;
+    //! battChargeCurr less battDischargeCurr, negative while discharging.
+    int16_t battCurrAvg;
+    //! acOutActivePow.
+    WORD loadPowAvg;
+    WORD loadPowMax;
+    //! The last non-zero fault code since the previous uplink, or 0.
+    BYTE faultCode;
+    //! getFaultWarningFlags() of every FWS since the previous uplink, or'ed, so a flag that came and went shows.
+    WORD warningFlags;
+    //! Generated today in Wh, LORA_ENERGY_UNKNOWN until ED was read.
+    unsigned long energyTodayWh;
+  };
+
+  const BYTE LORA_PAYLOAD_VERSION = 1;
+  /*!
+   * The payload, bit packed from the least significant bit of its first byte on, each field as many bits as
+   * the schema's digits for it take, so a value the inverter can send always fits:
+   *   version 2, samples 6, pvPowAvg 15, pvPowMax 15, battVoltAvgDeci 10, battVoltMinDeci 10, battCapacity 8,
+   *   battCurrAvg 11 two's complement, loadPowAvg 14, loadPowMax 14, faultCode 8, warningFlags 16,
+   *   energyTodayWh 20.
+   * Larger values are clamped to the most a field holds, energyTodayWh then reads as unknown.
+   */
+  const BYTE LORA_PAYLOAD_SZ = 19;
+  const unsigned long LORA_ENERGY_UNKNOWN = 0xFFFFF;
+
+  //! Packs rollup into LORA_PAYLOAD_SZ bytes at buf. Returns LORA_PAYLOAD_SZ.
+  BYTE packLoRaRollup(const LoRaRollup &rollup, BYTE *buf);
+  //! Reads back a packLoRaRollup() payload. False if buf does not hold one of LORA_PAYLOAD_VERSION.
+  bool unpackLoRaRollup(const BYTE *buf, size_t len, LoRaRollup &rollup);
+
+  /*! Time on air of a LoRa frame of payloadSz bytes in ms, rounded up: explicit header, CRC, coding rate 4/5
+   * and an 8 symbol preamble, with low data rate optimization at SF11 and SF12 on 125 kHz, as LoRaWAN uses them.
+   */
+  unsigned long loraAirtimeMs(BYTE payloadSz, BYTE spreadingFactor, WORD bandwidthKhz);
+
+  const unsigned long LORA_DEFAULT_PERIOD_MS = 300000;
+
+  //! Hands a packed payload of len bytes to the radio or LoRaWAN modem. Returns false if it could not be sent.
+  typedef bool (*LoRaSendFunction)(const BYTE *payload, BYTE len, void *context);
+
+  /*!
+   * The uplink of a site with neither WiFi nor cellular coverage. Samples are not sent as they come: GS, FWS
+   * and the day's energy are folded into a LoRaRollup, which goes out as LORA_PAYLOAD_SZ bytes once per
+   * period, e.g. 19 bytes every 5 minutes, and starts over.
+   * The uplink keeps to the band's duty cycle by itself. After a frame of airtimeMs() it stays off the air
+   * for the rest of that time at the duty cycle, e.g. 99 times as long at 1 %, and the rollup just covers
+   * a longer period. A slow spreading factor so stretches the period rather than breaking the limit.
+   * The library only packs and paces, send hands the payload to whatever radio or LoRaWAN modem the board has.
+   */
+  class InfiniLoRaUplink {
+    public:
+    InfiniLoRaUplink(LoRaSendFunction send, void *context = NULL);
+
+    //! How often a rollup goes out, if the duty cycle allows. LORA_DEFAULT_PERIOD_MS by default.
+    void setPeriod(unsigned long periodMs);
+    //! The share of time on air allowed, in 0.1 %, e.g. 10 for the 1 % of most EU868 sub-bands, the default.
+    void setDutyCycle(WORD perMille);
+    /*! The spreading factor and bandwidth the radio sends with, and the bytes it adds to the payload, e.g.
+     * 13 for the LoRaWAN header, port and MIC. SF9 at 125 kHz with 13 bytes by default.
+     */
+    void setRadio(BYTE spreadingFactor, WORD bandwidthKhz, BYTE overheadSz);
+
+    //! Folds in a GS sample.
+    void add(const GeneralStatusFixed &gs);
+    //! Folds in an FWS reply.
+    void addFaults(const FaultWarningStatus &fws);
+    //! The ED reply, generated today in Wh.
+    void setEnergyToday(unsigned long wh);
+
+    //! Sends the rollup once its period is up and the duty cycle allows, then starts a new one.
+    void loop(unsigned long nowMs);
+    //! How long until loop() sends, e.g. for idleFor().
+    unsigned long msUntilWork(unsigned long nowMs) const;
+
+    //! The rollup so far.
+    const LoRaRollup &rollup() const;
+    //! Time on air of one uplink in ms, and the least time from one to the next it makes for.
+    unsigned long airtimeMs() const;
+    unsigned long minIntervalMs() const;
+
+    //! Uplinks sent, and those send refused, whose rollup is carried into the next.
+    unsigned long sent() const;
+    unsigned long failed() const;
+
+    private:
+    //! Starts a new rollup, keeping the SOC and the day's energy that were read last.
+    void restart();
+
+    LoRaSendFunction m_send;
+    void *m_context;
+    unsigned long m_periodMs;
+    WORD m_dutyPerMille;
+    unsigned long m_airtimeMs;
+    LoRaRollup m_rollup;
+    //! Exact sums of what m_rollup averages, and the samples in them, which goes past the 63 it counts.
+    unsigned long m_samples;
+    unsigned long m_pvSum;
+    unsigned long m_battVoltSum;
+    long m_battCurrSum;
+    unsigned long m_loadSum;
+    bool m_started;
+    unsigned long m_sentMs;
+    unsigned long m_sent;
+    unsigned long m_failed;
+  };
+}
+
+#endif
@@ -0,0 +1,192 @@
+#include "InfiniLogImage.h"
+
+#if INFI_MODULE_SINKS
+
+#if !defined(ARDUINO)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <thread>
+#include "InfiniDeltaTelemetry.h"
+#include "InfiniRecordSchema.h"
+
+namespace INFI {
+
+  InfiniLogImage::InfiniLogImage() :
+    m_data(NULL),
+    m_size(0),
+    m_mapped(false),
+    m_sectors(0)
+  {
+    memset(&m_stats, 0, sizeof(m_stats));
+  }
+
+  InfiniLogImage::~InfiniLogImage() {
+    close();
+  }
+
+  bool InfiniLogImage::open(const char *path) {
+    close();
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= 2 * PARTITION_SECTOR_SZ) {
+      data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping stays valid without the descriptor.
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+    // Read front to back by every thread.
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    m_mapped = true;
+    return attach((const BYTE *)data, st.st_size);
+  }
+
+  bool InfiniLogImage::attach(const BYTE *data, size_t size) {
+    if (data == NULL || size < 2 * PARTITION_SECTOR_SZ) {
+      return false;
+    }
+    m_data = data;
+    m_size = size;
+    // A partial last sector, of a dump cut short, is left out.
+    m_sectors = size / PARTITION_SECTOR_SZ;
+    return true;
+  }
+
+  void InfiniLogImage::close() {
+    if (m_mapped) {
+      munmap((void *)m_data, m_size);
+    }
+    m_data = NULL;
+    m_size = 0;
+    m_mapped = false;
+    m_sectors = 0;
+    m_sectorScans.clear();
+    m_slots.clear();
+    m_records.clear();
+    memset(&m_stats, 0, sizeof(m_stats));
+  }
+
+  bool InfiniLogImage::scan(unsigned threads) {
+    if (m_data == NULL) {
+      return false;
+    }
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = (unsigned)std::min<unsigned long>(threads, m_sectors);
+    m_sectorScans.assign(m_sectors, SectorScan());
+    m_slots.assign(m_sectors * PARTITION_RECORDS_PER_SECTOR, NULL);
+    // Each thread has sectors of its own, so none of them shares what it writes.
+    std::vector<std::thread> pool;
+    const unsigned long share = (m_sectors + threads - 1) / threads;
+    for (unsigned t = 1; t < threads; ++t) {
+      pool.push_back(std::thread(&InfiniLogImage::scanSectors, this, std::min(m_sectors, t * share),
+                                 std::min(m_sectors, (t + 1) * share)));
+    }
+    scanSectors(0, std::min(m_sectors, share));
+    for (size_t t = 0; t < pool.size(); ++t) {
+      pool[t].join();
+    }
+
+    std::vector<unsigned long> order;
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_stats.sectors = m_sectors;
+    for (unsigned long s = 0; s < m_sectors; ++s) {
+      const SectorScan &sector = m_sectorScans[s];
+      if (sector.valid) {
+        order.push_back(s);
+        m_stats.validSectors++;
+        m_stats.records += sector.records;
+        m_stats.consumed += sector.consumed;
+        m_stats.corrupted += sector.corrupted;
+      }
+    }
+    std::sort(order.begin(), order.end(), [this](unsigned long a, unsigned long b) {
+      return m_sectorScans[a].seq < m_sectorScans[b].seq;
+    });
+    m_records.clear();
+    m_records.reserve(m_stats.records);
+    for (size_t i = 0; i < order.size(); ++i) {
+      const PartitionRecord *const *first = &m_slots[order[i] * PARTITION_RECORDS_PER_SECTOR];
+      m_records.insert(m_records.end(), first, first + m_sectorScans[order[i]].records);
+    }
+    return true;
+  }
+
+  void InfiniLogImage::scanSectors(unsigned long first, unsigned long end) {
+    for (unsigned long s = first; s < end; ++s) {
+      const BYTE *sector = m_data + s * PARTITION_SECTOR_SZ;
+      SectorScan &scan = m_sectorScans[s];
+      scan.valid = isPartitionSectorValid(*(const PartitionSectorHeader *)sector);
+      scan.seq = ((const PartitionSectorHeader *)sector)->seq;
+      scan.records = 0;
+      scan.consumed = 0;
+      scan.corrupted = 0;
+      if (!scan.valid) {
+        continue;
+      }
+      const PartitionRecord *records = (const PartitionRecord *)(sector + sizeof(PartitionSectorHeader));
+      const PartitionRecord **valid = &m_slots[s * PARTITION_RECORDS_PER_SECTOR];
+      for (size_t slot = 0; slot < PARTITION_RECORDS_PER_SECTOR; ++slot) {
+        const PartitionRecord &record = records[slot];
+        // Records fill a sector from the start, the first erased slot ends it.
+        if (isPartitionRecordErased(record)) {
+          break;
+        }
+        if (record.crc != partitionRecordCrc(record)) {
+          scan.corrupted++;
+          continue;
+        }
+        valid[scan.records++] = &record;
+        scan.consumed += record.live == 0 ? 1 : 0;
+      }
+    }
+  }
+
+  const LogImageStats &InfiniLogImage::stats() const {
+    return m_stats;
+  }
+
+  size_t InfiniLogImage::size() const {
+    return m_records.size();
+  }
+
+  const PartitionRecord &InfiniLogImage::record(size_t index) const {
+    return *m_records[index];
+  }
+
+  size_t InfiniLogImage::writeCsv(Print &out) const {
+    size_t n = writeGeneralStatusCsvHeader(out);
+    for (size_t i = 0; i < m_records.size(); ++i) {
+      n += writeGeneralStatusCsv(m_records[i]->gs, m_records[i]->tsMs, out);
+    }
+    return n;
+  }
+
+  size_t InfiniLogImage::writeColumns(Print &out) const {
+    size_t n = writeGsSchemaBinary(out);
+    const GeneralStatusFixed *samples[255];
+    uint64_t tsMs[255];
+    for (size_t i = 0; i < m_records.size();) {
+      BYTE count = 0;
+      for (; count < 255 && i < m_records.size(); ++count, ++i) {
+        samples[count] = &m_records[i]->gs;
+        tsMs[count] = m_records[i]->tsMs;
+      }
+      n += writeGsColumnsBinary(samples, tsMs, count, out);
+    }
+    return n;
+  }
+}
+
+#endif
+#endif
@@ -0,0 +1,85 @@
+#ifndef INFINI_LOG_IMAGE_H
+#define INFINI_LOG_IMAGE_H
+
+#include "InfiniPartitionFormat.h"
+
+// Host only: the dump of a unit's log partition is read on a PC, see tools/infini_logdump.
+#if !defined(ARDUINO)
+
+#include <Print.h>
+#include <vector>
+
+namespace INFI {
+
+  //! What InfiniLogImage::scan() found.
+  struct LogImageStats {
+    unsigned long sectors;
+    //! Sectors with a valid header, the rest were never used or were torn.
+    unsigned long validSectors;
+    //! Records that passed their CRC, and of those the ones consume() had cleared before the dump.
+    unsigned long records;
+    unsigned long consumed;
+    //! Written slots failing their CRC, e.g. torn by a reset.
+    unsigned long corrupted;
+  };
+
+  /*!
+   * Reads a dump of an InfiniPartitionLog partition, e.g. from esptool read_flash of the partition's range,
+   * without copying it: the file is mapped read only and the records are used in place.
+   * scan() checks every sector header and record CRC, the sectors split over a pool of threads, then puts the
+   * sectors in the order of their sequence numbers, which is the ring order whatever sector the ring had got to.
+   * The records are then the samples oldest first, consumed ones included, for writeCsv() or writeColumns().
+   * Not thread safe itself, use an object per dump to read several at once.
+   */
+  class InfiniLogImage {
+    public:
+    InfiniLogImage();
+    ~InfiniLogImage();
+
+    //! Maps the dump at path. False if it cannot be read or is smaller than two sectors.
+    bool open(const char *path);
+    //! Reads a dump already in memory, which must outlive the object.
+    bool attach(const BYTE *data, size_t size);
+    void close();
+
+    //! Checks and orders the records on threads threads, 0 for one per core. False if nothing is open.
+    bool scan(unsigned threads = 0);
+
+    const LogImageStats &stats() const;
+    //! Valid records in ring order, after scan().
+    size_t size() const;
+    const PartitionRecord &record(size_t index) const;
+
+    //! The records as writeGeneralStatusCsv() lines, after writeGeneralStatusCsvHeader(). Returns the bytes written.
+    size_t writeCsv(Print &out) const;
+    //! The records as a BINARY_GS_SCHEMA record and BINARY_GS_COLUMNS ones of 255 samples, see InfiniRecordDecoder.h.
+    size_t writeColumns(Print &out) const;
+
+    private:
+    struct SectorScan {
+      bool valid;
+      uint32_t seq;
+      //! Valid records, then the index of the first of them in m_slots.
+      unsigned long records;
+      unsigned long consumed;
+      unsigned long corrupted;
+    };
+
+    //! Checks sectors from first up to end, into m_sectorScans and m_slots.
+    void scanSectors(unsigned long first, unsigned long end);
+
+    const BYTE *m_data;
+    size_t m_size;
+    //! Set when m_data is a mapping of ours.
+    bool m_mapped;
+    unsigned long m_sectors;
+    std::vector<SectorScan> m_sectorScans;
+    //! PARTITION_RECORDS_PER_SECTOR per sector, the valid records of each at its start.
+    std::vector<const PartitionRecord *> m_slots;
+    std::vector<const PartitionRecord *> m_records;
+    LogImageStats m_stats;
+  };
+}
+
+#endif
+#endif
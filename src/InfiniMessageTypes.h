@@ -6,37 +6,64 @@
 
 namespace INFI {
   
+  /*!
+   * A frame buffer of BUFFER_SIZE, fixed at compile time. Bytes past actualLen are kept 0,
+   * which holds as long as whoever fills val leaves actualLen past the last byte it wrote.
+   */
   template <size_t BUFFER_SIZE, typename T = unsigned char>
   struct InfiniMessage  {
     InfiniMessage() :
-      bufferSize(BUFFER_SIZE), 
       actualLen(0)
     {
-      reset();
+      memset(val, '\0', sizeof(val));
     }
     
-    const size_t bufferSize;
+    static const size_t bufferSize = BUFFER_SIZE;
     T val[BUFFER_SIZE];
     size_t actualLen;
 
+    //! Only clears the bytes that were used, not the whole buffer.
     void reset() {
-      memset(val, '\0', bufferSize);
+      memset(val, '\0', (actualLen < BUFFER_SIZE ? actualLen : BUFFER_SIZE) * sizeof(T));
       actualLen = 0;
     }
   };
 
+  template <size_t BUFFER_SIZE, typename T>
+  const size_t InfiniMessage<BUFFER_SIZE, T>::bufferSize;
+
   struct InfiniCommand : public InfiniMessage<MAX_CMD_SZ>
   {};
 
   struct InfiniResponse: public InfiniMessage<MAX_RESPONSE_SZ, char>
   {
     COMMAND_TYPE cmdType;
+    //! Set by the sender once the frame is complete, RESP_OK if start token and CRC checked out.
+    RESPONSE_ERROR error = RESP_OK;
+    //! Which inverter replied, set by the sender from its setDeviceId().
+    BYTE deviceId = 0;
+    //! micros() when the sender wrote the command, so replies to commands sent together can be matched up.
+    unsigned long sentUs = 0;
   };
 
-  struct InfiniParseResult: public InfiniMessage<MAX_RESPONSE_SZ, char>
+  /*!
+   * The outcome of checking a reply. On success payload points into the checked InfiniResponse,
+   * at the data between ^Dxxx and the CRC, so nothing is copied. It is only valid as long as that response is.
+   */
+  struct InfiniParseResult
   {
-    char error[256] = {'\0'};
+    RESPONSE_ERROR error = RESP_OK;
     bool hasError = false;
+    const char *payload = NULL;
+    size_t payloadLen = 0;
+
+    //! Records error, or clears the result if error is RESP_OK. Either way the payload view is dropped.
+    void setError(RESPONSE_ERROR err) {
+      error = err;
+      hasError = (err != RESP_OK);
+      payload = NULL;
+      payloadLen = 0;
+    }
   };
   
 }
@@ -0,0 +1,232 @@
+#include "InfiniMetrics.h"
+
+#if INFI_MODULE_STATS
+#include <string.h>
+#include "InfiniDeltaTelemetry.h"
+
+namespace INFI {
+
+  const char METRICS_CONTENT_TYPE[] = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+  //! Longest metric name built here, the GS ones being the longest.
+  static const BYTE METRIC_NAME_SZ = 40;
+
+  static const char *const TYPE_NAMES[] = { "gauge", "counter", "histogram" };
+
+  size_t writeMetricFamily(Print &out, const char *name, METRIC_TYPE type, const char *help) {
+    size_t n = out.print(INFI_F("# TYPE "));
+    n += out.print(name);
+    n += out.print(' ');
+    n += out.print(TYPE_NAMES[type]);
+    n += out.print('\n');
+    if (help != NULL) {
+      n += out.print(INFI_F("# HELP "));
+      n += out.print(name);
+      n += out.print(' ');
+      n += out.print(help);
+      n += out.print('\n');
+    }
+    return n;
+  }
+
+  // Starts a sample line up to the space before its value, with labels, the first two pairs given unless NULL.
+  static size_t writeSampleName(Print &out, const char *name, const char *suffix, const char *label,
+                                const char *labelValue, int device) {
+    size_t n = out.print(name);
+    if (suffix != NULL) {
+      n += out.print(suffix);
+    }
+    if (label != NULL || device >= 0) {
+      n += out.print('{');
+      if (label != NULL) {
+        n += out.print(label);
+        n += out.print(INFI_F("=\""));
+        n += out.print(labelValue);
+        n += out.print('"');
+      }
+      if (device >= 0) {
+        n += out.print(label != NULL ? INFI_F(",device=\"") : INFI_F("device=\""));
+        n += out.print(device);
+        n += out.print('"');
+      }
+      n += out.print('}');
+    }
+    n += out.print(' ');
+    return n;
+  }
+
+  static size_t writeValue(Print &out, unsigned long value, JSON_FIELD_KIND kind) {
+    if (kind == JSON_DECI) {
+      size_t n = out.print(value / 10);
+      n += out.print('.');
+      return n + out.print(value % 10);
+    }
+    if (kind == JSON_BOOL) {
+      return out.print(value != 0 ? '1' : '0');
+    }
+    return out.print(value);
+  }
+
+  // Milliseconds as seconds, 1500 as 1.500, the base unit OpenMetrics wants.
+  static size_t writeSeconds(Print &out, unsigned long ms) {
+    size_t n = out.print(ms / 1000);
+    n += out.print('.');
+    const unsigned long fraction = ms % 1000;
+    if (fraction < 100) {
+      n += out.print('0');
+    }
+    if (fraction < 10) {
+      n += out.print('0');
+    }
+    return n + out.print(fraction);
+  }
+
+  size_t writeMetricSample(Print &out, const char *name, METRIC_TYPE type, unsigned long value,
+                           JSON_FIELD_KIND kind, int device) {
+    size_t n = writeSampleName(out, name, type == METRIC_COUNTER ? "_total" : NULL, NULL, NULL, device);
+    n += writeValue(out, value, kind);
+    n += out.print('\n');
+    return n;
+  }
+
+  // prefix followed by key, camelCase in flash, in snake case: battVoltSCC2 becomes batt_volt_scc2.
+  static void makeSnakeName(char *name, const char *prefix, const char *key) {
+    size_t len = strlen(prefix);
+    memcpy(name, prefix, len);
+    char prev = 0;
+    for (const char *p = key; len < METRIC_NAME_SZ - 2; ++p) {
+      const char c = (char)INFI_READ_BYTE(p);
+      if (c == '\0') {
+        break;
+      }
+      const char next = (char)INFI_READ_BYTE(p + 1);
+      const bool upper = c >= 'A' && c <= 'Z';
+      // A new word after a lower case letter or a digit, or as the last capital of an acronym, dcACPow.
+      if (upper && ((prev >= 'a' && prev <= 'z') || (prev >= '0' && prev <= '9')
+                    || (prev >= 'A' && prev <= 'Z' && next >= 'a' && next <= 'z'))) {
+        name[len++] = '_';
+      }
+      name[len++] = upper ? (char)(c - 'A' + 'a') : c;
+      prev = c;
+    }
+    name[len] = '\0';
+  }
+
+  static size_t writeEnergyFamily(Print &out, const char *name, const char *help, const StatusSnapshot *snapshots,
+                                  BYTE count, unsigned long EnergyCounters::*counter) {
+    size_t n = 0;
+    bool first = true;
+    for (BYTE d = 0; d < count; ++d) {
+      const StatusSnapshot &snapshot = snapshots[d];
+      const unsigned long wh = snapshot.energy.*counter;
+      if (!(snapshot.parts & STATUS_ENERGY) || wh == ENERGY_UNKNOWN) {
+        continue;
+      }
+      if (first) {
+        n += writeMetricFamily(out, name, METRIC_GAUGE, help);
+        first = false;
+      }
+      n += writeMetricSample(out, name, METRIC_GAUGE, wh, JSON_UINT, d);
+    }
+    return n;
+  }
+
+  size_t writeStatusMetrics(Print &out, const StatusSnapshot *snapshots, BYTE count, unsigned long nowMs) {
+    size_t n = 0;
+    BYTE withGs = 0;
+    for (BYTE d = 0; d < count; ++d) {
+      withGs += (snapshots[d].parts & STATUS_GS) ? 1 : 0;
+    }
+    if (withGs > 0) {
+      n += writeMetricFamily(out, "infini_gs_age_seconds", METRIC_GAUGE, "Time since the GS shown was read");
+      for (BYTE d = 0; d < count; ++d) {
+        if (snapshots[d].parts & STATUS_GS) {
+          n += writeSampleName(out, "infini_gs_age_seconds", NULL, NULL, NULL, d);
+          n += writeSeconds(out, nowMs - snapshots[d].gsMs);
+          n += out.print('\n');
+        }
+      }
+      char name[METRIC_NAME_SZ];
+      for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+        const GS_FIELD field = (GS_FIELD)i;
+        makeSnakeName(name, "infini_gs_", getGeneralStatusFieldKey(field));
+        n += writeMetricFamily(out, name, METRIC_GAUGE);
+        for (BYTE d = 0; d < count; ++d) {
+          if (snapshots[d].parts & STATUS_GS) {
+            n += writeMetricSample(out, name, METRIC_GAUGE, (unsigned long)getGeneralStatusField(snapshots[d].gs, field),
+                                   getGeneralStatusFieldKind(field), d);
+          }
+        }
+      }
+    }
+    n += writeEnergyFamily(out, "infini_gen_energy_day_wh", "Energy generated today", snapshots, count,
+                           &EnergyCounters::dayWh);
+    n += writeEnergyFamily(out, "infini_gen_energy_month_wh", "Energy generated this month", snapshots, count,
+                           &EnergyCounters::monthWh);
+    n += writeEnergyFamily(out, "infini_gen_energy_year_wh", "Energy generated this year", snapshots, count,
+                           &EnergyCounters::yearWh);
+    return n;
+  }
+
+  //! One outcome counter of CommandStats per family.
+  struct LinkCounter {
+    const char *name;
+    const char *help;
+    unsigned long CommandStats::*member;
+  };
+
+  static const LinkCounter LINK_COUNTERS[] = {
+    { "infini_link_sent", "Commands written", &CommandStats::sent },
+    { "infini_link_ok", "Valid replies", &CommandStats::ok },
+    { "infini_link_nak", "Replies of ^0", &CommandStats::nak },
+    { "infini_link_timeout", "Commands without a whole reply in time", &CommandStats::timeout },
+    { "infini_link_crc_error", "Replies with a bad CRC", &CommandStats::crcError },
+    { "infini_link_bad_frame", "Replies with a bad start token or length", &CommandStats::badFrame },
+  };
+
+  size_t writeLinkStatsMetrics(Print &out, const InfiniLinkStats &stats) {
+    size_t n = 0;
+    for (BYTE c = 0; c < sizeof(LINK_COUNTERS) / sizeof(LINK_COUNTERS[0]); ++c) {
+      const LinkCounter &counter = LINK_COUNTERS[c];
+      n += writeMetricFamily(out, counter.name, METRIC_COUNTER, counter.help);
+      for (BYTE i = 0; i < NUM_COMMAND_TYPES; ++i) {
+        const CommandStats &command = stats.command((COMMAND_TYPE)i);
+        if (command.sent == 0) {
+          continue;
+        }
+        n += writeSampleName(out, counter.name, "_total", "command", getCommandDescriptor((COMMAND_TYPE)i).mnemonic, -1);
+        n += out.print(command.*counter.member);
+        n += out.print('\n');
+      }
+    }
+    static const char LATENCY[] = "infini_link_latency_seconds";
+    n += writeMetricFamily(out, LATENCY, METRIC_HISTOGRAM, "Time from writing a command to the end of its reply");
+    // OpenMetrics buckets are cumulative, the last one is +Inf and holds every reply.
+    unsigned long replies = 0;
+    for (BYTE i = 0; i < LATENCY_BUCKETS; ++i) {
+      replies += stats.latencyBucket(i);
+      n += out.print(LATENCY);
+      n += out.print(INFI_F("_bucket{le=\""));
+      if (i < LATENCY_BUCKETS - 1) {
+        n += writeSeconds(out, InfiniLinkStats::latencyBucketMaxMs(i));
+      } else {
+        n += out.print(INFI_F("+Inf"));
+      }
+      n += out.print(INFI_F("\"} "));
+      n += out.print(replies);
+      n += out.print('\n');
+    }
+    n += writeSampleName(out, LATENCY, "_sum", NULL, NULL, -1);
+    n += writeSeconds(out, stats.total().latencySumMs);
+    n += out.print('\n');
+    n += writeSampleName(out, LATENCY, "_count", NULL, NULL, -1);
+    n += out.print(replies);
+    n += out.print('\n');
+    return n;
+  }
+
+  size_t writeMetricsEof(Print &out) {
+    return out.print(INFI_F("# EOF\n"));
+  }
+}
+#endif
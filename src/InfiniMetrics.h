@@ -0,0 +1,56 @@
+#ifndef INFINI_METRICS_H
+#define INFINI_METRICS_H
+
+#include <Print.h>
+#include "InfiniStatusCache.h"
+#include "InfiniLinkStats.h"
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+
+  //! The Content-Type of what the writers below produce, OpenMetrics text, which Prometheus scrapes as well.
+  extern const char METRICS_CONTENT_TYPE[];
+
+  enum METRIC_TYPE {
+    METRIC_GAUGE = 0,
+    METRIC_COUNTER,
+    METRIC_HISTOGRAM
+  };
+
+  /*!
+   * Writers of the OpenMetrics text exposition, for a Prometheus on the LAN to scrape, see InfiniStatusServer.
+   * Every family is led by its # TYPE line and all its samples follow it, so with several inverters a writer
+   * takes them all at once and labels each sample device="<id>". Everything is printed straight from the
+   * structs, a scrape holds no copy of the document and never touches the RS232 link.
+   * A body is the families, in any order and each only once, ended by writeMetricsEof().
+   */
+
+  //! Writes families of the application's own, e.g. its pipeline counters, see InfiniStatusServer::setMetricsWriter().
+  typedef size_t (*MetricsWriter)(Print &out, void *context);
+
+  //! Writes the # TYPE line of the family name, and # HELP unless help is NULL. A counter's name is without _total.
+  size_t writeMetricFamily(Print &out, const char *name, METRIC_TYPE type, const char *help = NULL);
+
+  /*! Writes a sample of the family name, e.g. infini_gs_batt_volt{device="0"} 52.1, value in the units kind
+   * gives, JSON_BOOL as 0 or 1. A counter's sample gets _total. device < 0 writes it without the label.
+   */
+  size_t writeMetricSample(Print &out, const char *name, METRIC_TYPE type, unsigned long value,
+                           JSON_FIELD_KIND kind = JSON_UINT, int device = -1);
+
+  /*! Writes the GS fields of the count snapshots, device i being snapshots[i], as infini_gs_<key> gauges in
+   * the units GeneralStatusFixed stores them, the keys of writeGeneralStatusJson() in snake case, e.g.
+   * infini_gs_batt_volt_scc. Also the age of each GS, and the energy counters known, as infini_gen_energy_day_wh,
+   * _month_wh and _year_wh. Snapshots without a part are left out of its families.
+   */
+  size_t writeStatusMetrics(Print &out, const StatusSnapshot *snapshots, BYTE count, unsigned long nowMs);
+
+  /*! Writes stats as infini_link_<outcome>_total counters labelled with the command, e.g.
+   * infini_link_timeout_total{command="GS"}, and the latency histogram as infini_link_latency_seconds.
+   */
+  size_t writeLinkStatsMetrics(Print &out, const InfiniLinkStats &stats);
+
+  //! Ends the body, OpenMetrics wants the # EOF line last.
+  size_t writeMetricsEof(Print &out);
+}
+
+#endif
@@ -0,0 +1,399 @@
+#include "InfiniModbus.h"
+
+#if INFI_MODULE_SINKS
+#include "InfiniCommandMaker.h"
+#include "InfiniDeltaTelemetry.h"
+#include <Arduino.h>
+#include <string.h>
+
+namespace INFI {
+
+  static const BYTE FC_READ_HOLDING = 0x03;
+  static const BYTE FC_READ_INPUT = 0x04;
+  static const BYTE FC_WRITE_SINGLE = 0x06;
+  static const BYTE FC_WRITE_MULTIPLE = 0x10;
+  //! Most registers one read can return, per the Modbus spec.
+  static const WORD MAX_READ_REGISTERS = 125;
+  //! Most registers one function 16 write can carry.
+  static const WORD MAX_WRITE_REGISTERS = 123;
+
+  static const BYTE PIRI_REGISTERS = 25;
+
+  static WORD readWord(const BYTE *buf) {
+    return (WORD)((buf[0] << 8) | buf[1]);
+  }
+
+  static void writeWord(BYTE *buf, WORD value) {
+    buf[0] = (BYTE)(value >> 8);
+    buf[1] = (BYTE)(value & 0xFF);
+  }
+
+  // Seconds since takenMs, saturating at the largest register value.
+  static WORD ageSeconds(unsigned long takenMs, unsigned long nowMs) {
+    unsigned long age = (nowMs - takenMs) / 1000;
+    return age > 0xFFFF ? 0xFFFF : (WORD)age;
+  }
+
+  static WORD piriRegister(const RatedInformation &piri, BYTE i) {
+    switch (i) {
+      case 0: return piri.acInVoltDeci;
+      case 1: return piri.acInFreqDeci;
+      case 2: return piri.acInCurrDeci;
+      case 3: return piri.acOutVoltDeci;
+      case 4: return piri.acOutFreqDeci;
+      case 5: return piri.acOutCurrDeci;
+      case 6: return piri.acOutApparentPow;
+      case 7: return piri.acOutActivePow;
+      case 8: return piri.battVoltDeci;
+      case 9: return piri.battRechargeVoltDeci;
+      case 10: return piri.battRedischargeVoltDeci;
+      case 11: return piri.battUnderVoltDeci;
+      case 12: return piri.battBulkVoltDeci;
+      case 13: return piri.maxChargingCurr;
+      case 14: return piri.battType;
+      case 15: return piri.maxACChargingCurr;
+      case 16: return piri.inVoltRange;
+      case 17: return piri.outSourcePriority;
+      case 18: return piri.chargerSourcePriority;
+      case 19: return piri.parallelMaxNum;
+      case 20: return piri.machineType;
+      case 21: return piri.topology;
+      case 22: return piri.outModel;
+      case 23: return piri.solarPowerPriority;
+      case 24: return piri.mpptString;
+    }
+    return 0;
+  }
+
+  InfiniModbusMap::InfiniModbusMap(const InfiniStatusCache &cache, InfiniCommandQueue &queue, BYTE machine) :
+    m_cache(cache),
+    m_queue(queue),
+    m_machine(machine),
+    m_lastWrite(MODBUS_WRITE_NONE),
+    m_writesQueued(0)
+  {}
+
+  size_t InfiniModbusMap::process(const BYTE *request, size_t len, BYTE *response) {
+    if (len < 1) {
+      return 0;
+    }
+    const BYTE function = request[0];
+    switch (function) {
+      case FC_READ_HOLDING:
+      case FC_READ_INPUT: {
+        if (len != 5) {
+          return exception(function, MODBUS_ILLEGAL_VALUE, response);
+        }
+        WORD count = readWord(request + 3);
+        if (count == 0 || count > MAX_READ_REGISTERS) {
+          return exception(function, MODBUS_ILLEGAL_VALUE, response);
+        }
+        return readRegisters(function, readWord(request + 1), count, response);
+      }
+      case FC_WRITE_SINGLE: {
+        if (len != 5) {
+          return exception(function, MODBUS_ILLEGAL_VALUE, response);
+        }
+        BYTE code = writeRegister(readWord(request + 1), readWord(request + 3));
+        if (code != 0) {
+          return exception(function, code, response);
+        }
+        // The reply echoes the request.
+        memcpy(response, request, 5);
+        return 5;
+      }
+      case FC_WRITE_MULTIPLE: {
+        if (len < 6) {
+          return exception(function, MODBUS_ILLEGAL_VALUE, response);
+        }
+        WORD address = readWord(request + 1);
+        WORD count = readWord(request + 3);
+        if (count == 0 || count > MAX_WRITE_REGISTERS || request[5] != count * 2 || len != 6 + (size_t)count * 2) {
+          return exception(function, MODBUS_ILLEGAL_VALUE, response);
+        }
+        if ((unsigned long)address + count > NUM_MODBUS_HOLDING_REGISTERS) {
+          return exception(function, MODBUS_ILLEGAL_ADDRESS, response);
+        }
+        // Registers are written in order, a write that fails leaves the ones before it queued.
+        for (WORD i = 0; i < count; ++i) {
+          BYTE code = writeRegister(address + i, readWord(request + 6 + i * 2));
+          if (code != 0) {
+            return exception(function, code, response);
+          }
+        }
+        memcpy(response, request, 5);
+        return 5;
+      }
+      default:
+        return exception(function, MODBUS_ILLEGAL_FUNCTION, response);
+    }
+  }
+
+  size_t InfiniModbusMap::readRegisters(BYTE function, WORD address, WORD count, BYTE *response) {
+    unsigned long end = (unsigned long)address + count;
+    WORD base;
+    WORD size;
+    if (function == FC_READ_HOLDING) {
+      base = 0;
+      size = NUM_MODBUS_HOLDING_REGISTERS;
+    } else if (address < MODBUS_INPUT_PIRI) {
+      base = MODBUS_INPUT_GS;
+      size = NUM_GS_FIELDS;
+    } else if (address < MODBUS_INPUT_FWS) {
+      base = MODBUS_INPUT_PIRI;
+      size = PIRI_REGISTERS;
+    } else if (address < MODBUS_INPUT_STATE) {
+      base = MODBUS_INPUT_FWS;
+      size = 1 + FWS_FLAGS + 1;
+    } else {
+      base = MODBUS_INPUT_STATE;
+      size = NUM_MODBUS_STATE_REGISTERS;
+    }
+    if (address < base || end > (unsigned long)base + size) {
+      return exception(function, MODBUS_ILLEGAL_ADDRESS, response);
+    }
+
+    m_cache.read(m_snapshot);
+    const StatusSnapshot &s = m_snapshot;
+    const unsigned long now = millis();
+    response[0] = function;
+    response[1] = (BYTE)(count * 2);
+    for (WORD i = 0; i < count; ++i) {
+      WORD r = address - base + i;
+      WORD value = 0;
+      if (function == FC_READ_HOLDING) {
+        switch (r) {
+          case MODBUS_HOLD_OUTPUT_SOURCE_PRIORITY: value = s.piri.outSourcePriority; break;
+          case MODBUS_HOLD_CHARGER_SOURCE_PRIORITY: value = s.piri.chargerSourcePriority; break;
+          case MODBUS_HOLD_SOLAR_POWER_PRIORITY: value = s.piri.solarPowerPriority; break;
+          case MODBUS_HOLD_BATTERY_TYPE: value = s.piri.battType; break;
+          case MODBUS_HOLD_MAX_CHARGING_CURRENT: value = s.piri.maxChargingCurr; break;
+          case MODBUS_HOLD_MAX_AC_CHARGING_CURRENT: value = s.piri.maxACChargingCurr; break;
+          case MODBUS_HOLD_AC_OUT_FREQ: value = (WORD)((s.piri.acOutFreqDeci + 5) / 10); break;
+        }
+      } else if (base == MODBUS_INPUT_GS) {
+        value = (WORD)getGeneralStatusField(s.gs, (GS_FIELD)r);
+      } else if (base == MODBUS_INPUT_PIRI) {
+        value = piriRegister(s.piri, (BYTE)r);
+      } else if (base == MODBUS_INPUT_FWS) {
+        value = r == 0 ? s.fws.faultCode : (r <= FWS_FLAGS ? (getFaultWarningFlags(s.fws) >> (r - 1)) & 1 : getFaultWarningFlags(s.fws));
+      } else {
+        switch (r) {
+          case MODBUS_STATE_PARTS: value = s.parts; break;
+          case MODBUS_STATE_GS_AGE: value = ageSeconds(s.gsMs, now); break;
+          case MODBUS_STATE_PIRI_AGE: value = ageSeconds(s.piriMs, now); break;
+          case MODBUS_STATE_FWS_AGE: value = ageSeconds(s.fwsMs, now); break;
+          case MODBUS_STATE_LAST_WRITE: value = m_lastWrite; break;
+          case MODBUS_STATE_WRITES_QUEUED: value = m_writesQueued; break;
+        }
+      }
+      writeWord(response + 2 + i * 2, value);
+    }
+    return 2 + (size_t)count * 2;
+  }
+
+  BYTE InfiniModbusMap::writeRegister(WORD address, WORD value) {
+    COMMAND_TYPE commandType;
+    char params[MAX_PARAMS_SZ] = "";
+    switch (address) {
+      case MODBUS_HOLD_OUTPUT_SOURCE_PRIORITY:
+      case MODBUS_HOLD_SOLAR_POWER_PRIORITY:
+      case MODBUS_HOLD_BATTERY_TYPE:
+        if (value > (address == MODBUS_HOLD_SOLAR_POWER_PRIORITY ? 1 : 2)) {
+          return MODBUS_ILLEGAL_VALUE;
+        }
+        commandType = address == MODBUS_HOLD_OUTPUT_SOURCE_PRIORITY ? SET_OUTPUT_SOURCE_PRIORITY
+          : (address == MODBUS_HOLD_SOLAR_POWER_PRIORITY ? SET_SOLAR_POWER_PRIORITY : SET_BATTERY_TYPE);
+        params[0] = (char)('0' + value);
+        params[1] = '\0';
+        break;
+      case MODBUS_HOLD_CHARGER_SOURCE_PRIORITY:
+      case MODBUS_HOLD_MAX_CHARGING_CURRENT:
+      case MODBUS_HOLD_MAX_AC_CHARGING_CURRENT:
+        commandType = address == MODBUS_HOLD_CHARGER_SOURCE_PRIORITY ? SET_CHARGING_SOURCE_PRIORITY
+          : (address == MODBUS_HOLD_MAX_CHARGING_CURRENT ? SET_MAX_CHARGING_CURRENT : SET_MAX_AC_CHARGING_CURRENT);
+        if ((address == MODBUS_HOLD_CHARGER_SOURCE_PRIORITY && value > 2)
+            || makeParallelParams(commandType, m_machine, value, params, sizeof(params)) == 0) {
+          return MODBUS_ILLEGAL_VALUE;
+        }
+        break;
+      case MODBUS_HOLD_AC_OUT_FREQ:
+        if (value != 50 && value != 60) {
+          return MODBUS_ILLEGAL_VALUE;
+        }
+        commandType = value == 50 ? AC_OUT_FREQ_50 : AC_OUT_FREQ_60;
+        break;
+      default:
+        return MODBUS_ILLEGAL_ADDRESS;
+    }
+    if (!m_queue.enqueue(commandType, params, onWriteComplete, this)) {
+      return MODBUS_DEVICE_BUSY;
+    }
+    m_writesQueued++;
+    return 0;
+  }
+
+  size_t InfiniModbusMap::exception(BYTE function, BYTE code, BYTE *response) {
+    response[0] = function | 0x80;
+    response[1] = code;
+    return 2;
+  }
+
+  void InfiniModbusMap::onWriteComplete(const InfiniResponse &response, SEND_STATUS status, void *context) {
+    InfiniModbusMap *map = (InfiniModbusMap *)context;
+    if (map->m_writesQueued > 0) {
+      map->m_writesQueued--;
+    }
+    if (status != SEND_COMPLETE) {
+      map->m_lastWrite = MODBUS_WRITE_FAILED;
+    } else {
+      map->m_lastWrite = response.error == RESP_NAK ? MODBUS_WRITE_REFUSED : MODBUS_WRITE_ACCEPTED;
+    }
+  }
+
+  WORD modbusCrc(const BYTE *buf, size_t len) {
+    WORD crc = 0xFFFF;
+    for (size_t i = 0; i < len; ++i) {
+      crc ^= buf[i];
+      for (BYTE bit = 0; bit < 8; ++bit) {
+        crc = (crc & 1) ? (WORD)((crc >> 1) ^ 0xA001) : (WORD)(crc >> 1);
+      }
+    }
+    return crc;
+  }
+
+  InfiniModbusRtu::InfiniModbusRtu(InfiniModbusMap &map, Stream &port, BYTE unitId, unsigned long baud) :
+    m_map(map),
+    m_port(port),
+    m_unitId(unitId),
+    // 3.5 characters of 11 bits, and a fixed 1750 us above 19200 baud, per the Modbus serial line spec.
+    m_frameGapUs(baud > 19200 ? 1750 : (38500000UL + baud - 1) / baud),
+    m_lastByteUs(0),
+    m_len(0),
+    m_overrun(false),
+    m_crcErrors(0)
+  {}
+
+  void InfiniModbusRtu::loop() {
+    while (m_port.available() > 0) {
+      int c = m_port.read();
+      if (c < 0) {
+        break;
+      }
+      if (m_len < sizeof(m_frame)) {
+        m_frame[m_len++] = (BYTE)c;
+      } else {
+        m_overrun = true;
+      }
+      m_lastByteUs = micros();
+    }
+    if ((m_len > 0 || m_overrun) && micros() - m_lastByteUs >= m_frameGapUs) {
+      if (!m_overrun) {
+        handleFrame();
+      }
+      m_len = 0;
+      m_overrun = false;
+    }
+  }
+
+  void InfiniModbusRtu::handleFrame() {
+    // Unit id, function code and CRC at the least.
+    if (m_len < 4) {
+      return;
+    }
+    if (m_frame[0] != m_unitId && m_frame[0] != 0) {
+      return;
+    }
+    WORD crc = modbusCrc(m_frame, m_len - 2);
+    if (m_frame[m_len - 2] != (crc & 0xFF) || m_frame[m_len - 1] != (crc >> 8)) {
+      m_crcErrors++;
+      return;
+    }
+    BYTE reply[MODBUS_RTU_FRAME_SZ];
+    size_t len = m_map.process(m_frame + 1, m_len - 3, reply + 1);
+    if (m_frame[0] == 0 || len == 0) {
+      return;
+    }
+    reply[0] = m_unitId;
+    crc = modbusCrc(reply, len + 1);
+    reply[len + 1] = (BYTE)(crc & 0xFF);
+    reply[len + 2] = (BYTE)(crc >> 8);
+    m_port.write(reply, len + 3);
+  }
+
+  unsigned long InfiniModbusRtu::crcErrors() const {
+    return m_crcErrors;
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  InfiniModbusTcp::InfiniModbusTcp(InfiniModbusMap &map, uint16_t port) :
+    m_map(map),
+    m_server(port)
+  {
+    for (BYTE i = 0; i < MODBUS_TCP_CLIENTS; ++i) {
+      m_peers[i].len = 0;
+    }
+  }
+
+  void InfiniModbusTcp::begin() {
+    m_server.begin();
+    m_server.setNoDelay(true);
+  }
+
+  void InfiniModbusTcp::loop() {
+    if (m_server.hasClient()) {
+      WiFiClient incoming = m_server.available();
+      Peer *slot = NULL;
+      for (BYTE i = 0; i < MODBUS_TCP_CLIENTS && slot == NULL; ++i) {
+        if (!m_peers[i].socket.connected()) {
+          slot = &m_peers[i];
+        }
+      }
+      if (slot == NULL) {
+        incoming.stop();
+      } else {
+        slot->socket.stop();
+        slot->socket = incoming;
+        slot->len = 0;
+      }
+    }
+    for (BYTE i = 0; i < MODBUS_TCP_CLIENTS; ++i) {
+      if (m_peers[i].socket.connected()) {
+        readRequests(m_peers[i]);
+      }
+    }
+  }
+
+  void InfiniModbusTcp::readRequests(Peer &peer) {
+    while (peer.socket.available() > 0) {
+      // Read up to the MBAP length first, then exactly the unit id and PDU it announces, so pipelined requests stay apart.
+      size_t want = peer.len < 6 ? 6 : 6 + readWord(peer.frame + 4);
+      int got = peer.socket.read(peer.frame + peer.len, want - peer.len);
+      if (got <= 0) {
+        break;
+      }
+      peer.len += got;
+      if (peer.len == 6) {
+        WORD length = readWord(peer.frame + 4);
+        // The length counts the unit id and the PDU.
+        if (readWord(peer.frame + 2) != 0 || length < 2 || length > 1 + MODBUS_PDU_SZ) {
+          peer.socket.stop();
+          peer.len = 0;
+          return;
+        }
+      }
+      if (peer.len < want) {
+        continue;
+      }
+
+      size_t len = m_map.process(peer.frame + MODBUS_MBAP_SZ, peer.len - MODBUS_MBAP_SZ, m_response + MODBUS_MBAP_SZ);
+      // Transaction id, protocol id and unit id are echoed, the length is the reply's.
+      memcpy(m_response, peer.frame, MODBUS_MBAP_SZ);
+      writeWord(m_response + 4, (WORD)(len + 1));
+      peer.socket.write(m_response, MODBUS_MBAP_SZ + len);
+      peer.len = 0;
+    }
+  }
+#endif
+}
+#endif
@@ -0,0 +1,178 @@
+#ifndef INFINI_MODBUS_H
+#define INFINI_MODBUS_H
+
+#include <Stream.h>
+#include "InfiniCommandQueue.h"
+#include "InfiniStatusCache.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <WiFi.h>
+#endif
+
+// Modbus TCP connections served at once, further ones are turned away.
+#ifndef INFI_MODBUS_TCP_CLIENTS
+#define INFI_MODBUS_TCP_CLIENTS 2
+#endif
+
+namespace INFI {
+
+  const BYTE MODBUS_TCP_CLIENTS = INFI_MODBUS_TCP_CLIENTS;
+
+  //! Longest PDU, the function code and its data, per the Modbus spec.
+  const size_t MODBUS_PDU_SZ = 253;
+  //! Longest RTU frame, the unit id, the PDU and the CRC.
+  const size_t MODBUS_RTU_FRAME_SZ = MODBUS_PDU_SZ + 3;
+  //! The MBAP header in front of a Modbus TCP PDU, unit id included.
+  const size_t MODBUS_MBAP_SZ = 7;
+
+  /*!
+   * Start of each block of input registers (function 04). Every block is the fields of its struct in order,
+   * in the units the struct stores them in, e.g. 0.1 V for the Deci fields, flags as 0 or 1.
+   * A read that goes past the last field of a block is answered with exception 02.
+   */
+  enum MODBUS_INPUT_BLOCK {
+    MODBUS_INPUT_GS = 0,     // GeneralStatusFixed, in GS_FIELD order, 28 registers.
+    MODBUS_INPUT_PIRI = 100, // RatedInformation, 25 registers.
+    MODBUS_INPUT_FWS = 200,  // FaultWarningStatus, 17 registers, then the 16 flags as one bit mask, LSB first.
+    MODBUS_INPUT_STATE = 300 // The MODBUS_STATE_REGISTER registers.
+  };
+
+  //! The registers of the MODBUS_INPUT_STATE block, relative to it.
+  enum MODBUS_STATE_REGISTER {
+    MODBUS_STATE_PARTS = 0,    // STATUS_PART bits of the blocks that hold a reading.
+    MODBUS_STATE_GS_AGE,       // Seconds since the GS reading, 65535 at most.
+    MODBUS_STATE_PIRI_AGE,
+    MODBUS_STATE_FWS_AGE,
+    MODBUS_STATE_LAST_WRITE,   // MODBUS_WRITE_RESULT of the holding register write that finished last.
+    MODBUS_STATE_WRITES_QUEUED,// SET commands queued but not finished yet.
+    NUM_MODBUS_STATE_REGISTERS
+  };
+
+  //! The outcome of a holding register write, once its SET command finished.
+  enum MODBUS_WRITE_RESULT {
+    MODBUS_WRITE_NONE = 0,    // No write finished yet.
+    MODBUS_WRITE_ACCEPTED,    // The inverter answered ^1.
+    MODBUS_WRITE_REFUSED,     // The inverter answered ^0.
+    MODBUS_WRITE_FAILED       // No valid reply, or the link was down.
+  };
+
+  /*!
+   * The holding registers (functions 03, 06 and 16). Reading one gives the setting as PIRI last reported it,
+   * writing one queues the SET command that changes it in the high priority lane of the command queue.
+   * A write is answered as soon as it is queued, its outcome shows in MODBUS_STATE_LAST_WRITE.
+   */
+  enum MODBUS_HOLDING_REGISTER {
+    MODBUS_HOLD_OUTPUT_SOURCE_PRIORITY = 0,  // POP, 0 to 2.
+    MODBUS_HOLD_CHARGER_SOURCE_PRIORITY,     // PCP, 0 to 2.
+    MODBUS_HOLD_SOLAR_POWER_PRIORITY,        // PSP, 0 or 1.
+    MODBUS_HOLD_BATTERY_TYPE,                // PBT, 0 to 2.
+    MODBUS_HOLD_MAX_CHARGING_CURRENT,        // MCHGC, A.
+    MODBUS_HOLD_MAX_AC_CHARGING_CURRENT,     // MUCHGC, A.
+    MODBUS_HOLD_AC_OUT_FREQ,                 // F50 or F60, Hz.
+    NUM_MODBUS_HOLDING_REGISTERS
+  };
+
+  //! Modbus exception codes the map answers with.
+  enum MODBUS_EXCEPTION {
+    MODBUS_ILLEGAL_FUNCTION = 0x01,
+    MODBUS_ILLEGAL_ADDRESS = 0x02,
+    MODBUS_ILLEGAL_VALUE = 0x03,
+    MODBUS_DEVICE_BUSY = 0x06   // The high priority lane is full, try the write again later.
+  };
+
+  /*!
+   * The register map of one inverter, served from its InfiniStatusCache, so reads never reach the RS232 link
+   * and a controller can poll as fast as it likes. Only writes queue commands, see MODBUS_HOLDING_REGISTER.
+   * Transport independent, InfiniModbusRtu and InfiniModbusTcp frame its PDUs.
+   * Not thread safe, because of the queue: drive it from the task that runs the queue.
+   */
+  class InfiniModbusMap {
+    public:
+    /*! machine is the parallel machine the parallel addressed SET commands (PCP, MCHGC, MUCHGC) go to.
+     */
+    InfiniModbusMap(const InfiniStatusCache &cache, InfiniCommandQueue &queue, BYTE machine = 0);
+
+    /*! Answers the PDU request, function code first, with the PDU written to response, which must hold MODBUS_PDU_SZ.
+     * An exception is answered as the function code with its top bit set and the exception code.
+     * Returns the number of bytes in response.
+     */
+    size_t process(const BYTE *request, size_t len, BYTE *response);
+
+    private:
+    size_t readRegisters(BYTE function, WORD address, WORD count, BYTE *response);
+    //! Validates value for the holding register, then queues its SET command.
+    BYTE writeRegister(WORD address, WORD value);
+    static size_t exception(BYTE function, BYTE code, BYTE *response);
+    static void onWriteComplete(const InfiniResponse &response, SEND_STATUS status, void *context);
+
+    const InfiniStatusCache &m_cache;
+    InfiniCommandQueue &m_queue;
+    BYTE m_machine;
+    StatusSnapshot m_snapshot;
+    BYTE m_lastWrite;
+    BYTE m_writesQueued;
+  };
+
+  /*!
+   * Modbus RTU on a serial port of its own, e.g. an RS485 transceiver on Serial1.
+   * A frame ends after 3.5 characters of silence. Frames for other unit ids or with a bad CRC are ignored,
+   * broadcasts to unit 0 are processed but not answered. Call loop() from the Arduino loop as often as possible.
+   */
+  class InfiniModbusRtu {
+    public:
+    InfiniModbusRtu(InfiniModbusMap &map, Stream &port, BYTE unitId, unsigned long baud);
+
+    void loop();
+
+    //! Frames dropped because their CRC did not match.
+    unsigned long crcErrors() const;
+
+    private:
+    void handleFrame();
+
+    InfiniModbusMap &m_map;
+    Stream &m_port;
+    BYTE m_unitId;
+    //! Silence that ends a frame, microseconds.
+    unsigned long m_frameGapUs;
+    unsigned long m_lastByteUs;
+    BYTE m_frame[MODBUS_RTU_FRAME_SZ];
+    size_t m_len;
+    //! Set while a frame longer than m_frame is being skipped.
+    bool m_overrun;
+    unsigned long m_crcErrors;
+  };
+
+  //! The Modbus CRC-16 of the len bytes at buf.
+  WORD modbusCrc(const BYTE *buf, size_t len);
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /*!
+   * Modbus TCP, port 502 by default. Every unit id is answered with the same map.
+   * Call loop() from the Arduino loop, it never waits for a client.
+   */
+  class InfiniModbusTcp {
+    public:
+    InfiniModbusTcp(InfiniModbusMap &map, uint16_t port = 502);
+
+    void begin();
+    void loop();
+
+    private:
+    struct Peer {
+      WiFiClient socket;
+      BYTE frame[MODBUS_MBAP_SZ + MODBUS_PDU_SZ];
+      size_t len;
+    };
+
+    void readRequests(Peer &peer);
+
+    InfiniModbusMap &m_map;
+    WiFiServer m_server;
+    Peer m_peers[MODBUS_TCP_CLIENTS];
+    BYTE m_response[MODBUS_MBAP_SZ + MODBUS_PDU_SZ];
+  };
+#endif
+}
+
+#endif
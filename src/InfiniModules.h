@@ -0,0 +1,70 @@
+#ifndef INFINI_MODULES_H
+#define INFINI_MODULES_H
+
+/*
+ * Which modules of the library are built. Every source file of a module left at 0 compiles to nothing,
+ * so a build only pays for the flash, RAM and static constructors of the modules it selects, and for
+ * their libraries: only the JSON encoders include ArduinoJson. Set them per environment with build_flags
+ * in platformio.ini, e.g. -DINFI_MODULE_JSON=0 for an AVR build that sends binary records.
+ *
+ * The core is always built: the frames, the CRC, InfiniCommandSender with its RX ring, link calibration
+ * and capture, the RS-485 bus, the clock model, InfiniSupervisor and the data types.
+ */
+
+// Typed parsers: InfiniResponseParser, InfiniFieldReader, InfiniGsView, the GS field table of
+// InfiniDeltaTelemetry, InfiniFaultEvents, InfiniStatusCache, InfiniPlantStatus and InfiniEnergyTracker.
+#ifndef INFI_MODULE_PARSERS
+#define INFI_MODULE_PARSERS 1
+#endif
+
+// The scheduler: InfiniCommandQueue with its response cache and InfiniEnergyHistory, InfiniPollScheduler, InfiniPollPolicy,
+// InfiniInverterTask, the coroutines, and what runs on the queue, InfiniSetter, InfiniSettingsBatch,
+// InfiniRules, InfiniBridge, InfiniEnergyBackfill, InfiniGsCadence, InfiniDaylight, InfiniLinkDiscovery,
+// InfiniTimerWheel and, with the statistics, InfiniStressTest. Needs the parsers.
+#ifndef INFI_MODULE_SCHEDULER
+#define INFI_MODULE_SCHEDULER 1
+#endif
+
+// The JSON encoders: the writers of InfiniJsonWriter and the JSON output of every other module,
+// InfiniGsSkeleton, InfiniFieldTopics, InfiniStaticInfo, InfiniTelemetryBatch, and the ArduinoJson based
+// InfiniGateway and InfiniCredentials. The Print helpers of InfiniJsonWriter are part of the core.
+#ifndef INFI_MODULE_JSON
+#define INFI_MODULE_JSON 1
+#endif
+
+// The binary encoders: InfiniBinaryWriter, InfiniGsHistory with its InfiniGsCodec and InfiniColumnKernels,
+// InfiniFaultCapture, InfiniRecordSchema and InfiniDeflate.
+// Needs the parsers.
+#ifndef INFI_MODULE_BINARY
+#define INFI_MODULE_BINARY 1
+#endif
+
+// Sinks: InfiniSampleFanout, InfiniSinkQueue, InfiniSdLog, InfiniTelemetryLog with InfiniLogDrain, InfiniPartitionLog with the host side
+// InfiniLogImage, InfiniInflux, and the network side, InfiniGsStream, InfiniStatusServer, InfiniModbus, InfiniBleService, InfiniEspNow,
+// InfiniCorkClient, InfiniTlsClient, InfiniWiFiFast, InfiniWiFiPower, InfiniEthernet, InfiniCellular,
+// InfiniLoRa and InfiniUploadPacer.
+// Needs the scheduler and both encoders.
+#ifndef INFI_MODULE_SINKS
+#define INFI_MODULE_SINKS 1
+#endif
+
+// Statistics: InfiniLinkStats, InfiniGsStats, InfiniRollup, InfiniResourceStats and InfiniMetrics.
+// They report as JSON or OpenMetrics text, so they need the JSON encoders, and the parsers for the GS fields.
+#ifndef INFI_MODULE_STATS
+#define INFI_MODULE_STATS 1
+#endif
+
+#if INFI_MODULE_SCHEDULER && !INFI_MODULE_PARSERS
+#error "INFI_MODULE_SCHEDULER needs INFI_MODULE_PARSERS"
+#endif
+#if INFI_MODULE_BINARY && !INFI_MODULE_PARSERS
+#error "INFI_MODULE_BINARY needs INFI_MODULE_PARSERS"
+#endif
+#if INFI_MODULE_SINKS && !(INFI_MODULE_SCHEDULER && INFI_MODULE_BINARY && INFI_MODULE_JSON)
+#error "INFI_MODULE_SINKS needs INFI_MODULE_SCHEDULER, INFI_MODULE_BINARY and INFI_MODULE_JSON"
+#endif
+#if INFI_MODULE_STATS && !(INFI_MODULE_PARSERS && INFI_MODULE_JSON)
+#error "INFI_MODULE_STATS needs INFI_MODULE_PARSERS and INFI_MODULE_JSON"
+#endif
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef INFINI_PARTITION_FORMAT_H
+#define INFINI_PARTITION_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "InfiniCRC.h"
+#include "InfiniDataTypes.h"
+
+namespace INFI {
+
+  /*
+   * The layout InfiniPartitionLog writes to its flash partition, shared with the host tools that read a dump of it,
+   * see InfiniLogImage.h. The structs are stored as they are in memory, which is the same on the ESP32 and on
+   * a little endian host: natural alignment, bit fields from the least significant bit.
+   */
+
+  //! The erase unit, every sector starts with a PartitionSectorHeader.
+  const size_t PARTITION_SECTOR_SZ = 4096;
+  //! "INFL", so a partition that held something else is not mistaken for a log.
+  const uint32_t PARTITION_SECTOR_MAGIC = 0x4C464E49UL;
+
+  struct PartitionSectorHeader {
+    uint32_t magic;
+    //! Goes up by 1 every time a sector is opened, round the ring.
+    uint32_t seq;
+    uint32_t reserved;
+    WORD crc;
+    WORD pad;
+  };
+
+  struct PartitionRecord {
+    uint64_t tsMs;
+    //! Goes up by 1 with every record appended.
+    uint32_t seq;
+    GeneralStatusFixed gs;
+    WORD crc;
+    //! 0xFF as written, 0 once consumed.
+    BYTE live;
+  };
+
+  static_assert(sizeof(PartitionSectorHeader) == 16, "The sector header layout is stored in flash");
+  static_assert(sizeof(PartitionRecord) == 56 && offsetof(PartitionRecord, crc) == 50,
+                "The record layout is stored in flash");
+
+  //! Records in a sector, after its header.
+  const size_t PARTITION_RECORDS_PER_SECTOR = (PARTITION_SECTOR_SZ - sizeof(PartitionSectorHeader)) / sizeof(PartitionRecord);
+
+  inline WORD partitionRecordCrc(const PartitionRecord &record) {
+    return calc_crc_half((const BYTE *)&record, offsetof(PartitionRecord, crc));
+  }
+
+  inline WORD partitionHeaderCrc(const PartitionSectorHeader &hdr) {
+    return calc_crc_half((const BYTE *)&hdr, offsetof(PartitionSectorHeader, crc));
+  }
+
+  inline bool isPartitionSectorValid(const PartitionSectorHeader &hdr) {
+    return hdr.magic == PARTITION_SECTOR_MAGIC && hdr.crc == partitionHeaderCrc(hdr);
+  }
+
+  //! A slot still as erased, never written since.
+  inline bool isPartitionRecordErased(const PartitionRecord &record) {
+    return record.seq == 0xFFFFFFFFUL && record.tsMs == 0xFFFFFFFFFFFFFFFFULL;
+  }
+}
+
+#endif
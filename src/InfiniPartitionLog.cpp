@@ -0,0 +1,417 @@
+#include "InfiniPartitionLog.h"
+
+#if INFI_MODULE_SINKS
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <stddef.h>
+#include <string.h>
+#include "InfiniBinaryWriter.h"
+#include "InfiniCRC.h"
+#include "InfiniDeltaTelemetry.h"
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+#define INFI_PARTITION_MMAP_DATA ESP_PARTITION_MMAP_DATA
+#else
+#define INFI_PARTITION_MMAP_DATA SPI_FLASH_MMAP_DATA
+#endif
+
+namespace INFI {
+
+  // Records a verify task checks between sleeps, so the idle task of its core still feeds the watchdog.
+  static const unsigned long VERIFY_BURST = 256;
+
+  InfiniPartitionLog::InfiniPartitionLog(const char *label) :
+    m_partition(NULL),
+    m_mapped(NULL),
+    m_mapHandle(0),
+    m_sectors(0),
+    m_perSector(0),
+    m_headSeq(0),
+    m_ringEnd(0),
+    m_wrapped(false),
+    m_count(0),
+    m_nextRecordSeq(0),
+    m_dropped(0),
+    m_nextErased(false),
+    m_verifying(0)
+  {
+    strncpy(m_label, label, sizeof(m_label) - 1);
+    m_label[sizeof(m_label) - 1] = '\0';
+    m_head.sector = 0;
+    m_head.slot = 0;
+    m_tail = m_head;
+  }
+
+  InfiniPartitionLog::~InfiniPartitionLog() {
+    // The verify tasks read through the mapping.
+    while (isVerifying()) {
+      vTaskDelay(1);
+    }
+    if (m_mapped != NULL) {
+      esp_partition_munmap(m_mapHandle);
+    }
+  }
+
+  bool InfiniPartitionLog::begin() {
+    if (m_mapped == NULL) {
+      m_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, m_label);
+      if (m_partition == NULL || m_partition->size < 2 * PARTITION_SECTOR_SZ) {
+        return false;
+      }
+      const void *mapped;
+      if (esp_partition_mmap(m_partition, 0, m_partition->size, INFI_PARTITION_MMAP_DATA, &mapped, &m_mapHandle) != ESP_OK) {
+        return false;
+      }
+      m_mapped = (const BYTE *)mapped;
+      m_sectors = m_partition->size / PARTITION_SECTOR_SZ;
+      m_perSector = PARTITION_RECORDS_PER_SECTOR;
+    }
+    m_count = 0;
+    m_nextRecordSeq = 0;
+    m_nextErased = false;
+    m_ringEnd = 0;
+    m_wrapped = false;
+
+    // The newest sector. The seqs go up round the ring, so every sector from 0 up to it has a seq at least
+    // that of sector 0, and every one after it is older or was never used.
+    const SectorHeader *first = header(0);
+    long newest = -1;
+    if (isValid(first)) {
+      unsigned long lo = 0;
+      unsigned long hi = m_sectors - 1;
+      while (lo < hi) {
+        const unsigned long mid = (lo + hi + 1) / 2;
+        const SectorHeader *hdr = header(mid);
+        if (isValid(hdr) && hdr->seq >= first->seq) {
+          lo = mid;
+        } else {
+          hi = mid - 1;
+        }
+      }
+      newest = lo;
+    } else {
+      // Sector 0 lost its header, e.g. to a reset mid erase. Rare, so a plain scan.
+      for (unsigned long s = 1; s < m_sectors; ++s) {
+        const SectorHeader *hdr = header(s);
+        if (isValid(hdr) && (newest < 0 || hdr->seq > header(newest)->seq)) {
+          newest = s;
+        }
+      }
+    }
+    if (newest < 0) {
+      // A blank or foreign partition, the first append opens sector 0.
+      m_head.sector = m_sectors - 1;
+      m_head.slot = m_perSector;
+      m_headSeq = 0;
+      m_tail = m_head;
+      return true;
+    }
+    m_head.sector = newest;
+    m_headSeq = header(newest)->seq;
+
+    // Records fill a sector from the start, so the used slots of the newest one are a prefix too.
+    unsigned long lo = 0;
+    unsigned long hi = m_perSector;
+    while (lo < hi) {
+      const unsigned long mid = (lo + hi) / 2;
+      Position pos = { m_head.sector, mid };
+      const Record *r = recordAt(pos);
+      if (!isPartitionRecordErased(*r)) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    m_head.slot = lo;
+
+    // The oldest sector still in the ring: the one after the newest, if the ring went round already.
+    // Unless eraseAhead() had erased that one already, or a reset cut its erase short, then the one after it.
+    Position oldest = { 0, 0 };
+    unsigned long next = (m_head.sector + 1) % m_sectors;
+    if (!isValid(header(next))) {
+      next = (next + 1) % m_sectors;
+    }
+    const SectorHeader *nextHdr = header(next);
+    if (next != m_head.sector && isValid(nextHdr) && nextHdr->seq < m_headSeq) {
+      oldest.sector = next;
+      m_wrapped = true;
+    }
+    // A wrapped ring with an empty newest sector ends where the one before it is full.
+    m_ringEnd = m_head.sector * m_perSector + m_head.slot;
+    if (m_ringEnd == 0 && m_wrapped) {
+      m_ringEnd = m_sectors * m_perSector;
+    }
+    const unsigned long used = (m_head.sector + m_sectors - oldest.sector) % m_sectors;
+    const unsigned long total = used * m_perSector + m_head.slot;
+
+    // consume() clears records oldest first, so the consumed ones are a prefix of the ring.
+    lo = 0;
+    hi = total;
+    while (lo < hi) {
+      const unsigned long mid = (lo + hi) / 2;
+      if (recordAt(advance(oldest, mid))->live == 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    m_tail = advance(oldest, lo);
+    m_count = total - lo;
+    if (total > 0) {
+      m_nextRecordSeq = recordAt(advance(oldest, total - 1))->seq + 1;
+    }
+    return true;
+  }
+
+  bool InfiniPartitionLog::append(const GeneralStatusFixed &gs, uint64_t tsMs) {
+    if (m_mapped == NULL) {
+      m_dropped++;
+      return false;
+    }
+    if (m_head.slot >= m_perSector) {
+      const unsigned long next = (m_head.sector + 1) % m_sectors;
+      if (next == 0 && m_ringEnd > 0) {
+        m_wrapped = true;
+      }
+      if (!(m_nextErased || eraseNext()) || !writeHeader(next, m_headSeq + 1)) {
+        m_nextErased = false;
+        m_dropped++;
+        return false;
+      }
+      m_nextErased = false;
+      m_head.sector = next;
+      m_head.slot = 0;
+      m_headSeq++;
+    }
+    Record record;
+    // Padding stays erased.
+    memset(&record, 0xFF, sizeof(record));
+    record.tsMs = tsMs;
+    record.seq = m_nextRecordSeq++;
+    record.gs = gs;
+    record.crc = partitionRecordCrc(record);
+    if (m_count == 0) {
+      m_tail = m_head;
+    }
+    const esp_err_t err = esp_partition_write(m_partition, offsetOf(m_head), &record, sizeof(record));
+    // The slot is used either way, a torn record fails its CRC.
+    m_head.slot++;
+    m_count++;
+    __atomic_store_n(&m_ringEnd, m_head.sector * m_perSector + m_head.slot, __ATOMIC_RELEASE);
+    if (err != ESP_OK) {
+      m_dropped++;
+      return false;
+    }
+    return true;
+  }
+
+  BYTE InfiniPartitionLog::peek(InfiniGsHistory &out, BYTE maxRecords, WORD skipRecords) {
+    BYTE read = 0;
+    for (unsigned long i = skipRecords; read < maxRecords && i < m_count; ++i) {
+      uint64_t tsMs;
+      const GeneralStatusFixed *gs = record(i, tsMs);
+      read++;
+      if (gs != NULL) {
+        out.push(*gs, tsMs);
+      }
+    }
+    return read;
+  }
+
+  const GeneralStatusFixed *InfiniPartitionLog::record(unsigned long index, uint64_t &tsMs) const {
+    if (index >= m_count) {
+      return NULL;
+    }
+    const Record *r = recordAt(advance(m_tail, index));
+    if (r->crc != partitionRecordCrc(*r)) {
+      return NULL;
+    }
+    tsMs = r->tsMs;
+    return &r->gs;
+  }
+
+  void InfiniPartitionLog::consume(BYTE count) {
+    const BYTE consumed = 0;
+    for (BYTE i = 0; i < count && m_count > 0; ++i) {
+      esp_partition_write(m_partition, offsetOf(m_tail) + offsetof(Record, live), &consumed, 1);
+      m_tail = advance(m_tail, 1);
+      m_count--;
+    }
+  }
+
+  bool InfiniPartitionLog::eraseAhead(unsigned long slotsLeft) {
+    if (m_mapped == NULL || m_nextErased || m_perSector - m_head.slot > slotsLeft) {
+      return false;
+    }
+    return eraseNext();
+  }
+
+  bool InfiniPartitionLog::hasRecords() const {
+    return m_count > 0;
+  }
+
+  unsigned long InfiniPartitionLog::size() const {
+    return m_count;
+  }
+
+  unsigned long InfiniPartitionLog::capacity() const {
+    return m_sectors * m_perSector;
+  }
+
+  unsigned long InfiniPartitionLog::dropped() const {
+    return m_dropped;
+  }
+
+  unsigned long InfiniPartitionLog::writeRange(uint64_t fromMs, uint64_t toMs, SAMPLE_FORMAT format, Print &out) const {
+    if (m_mapped == NULL || (format != SAMPLE_BINARY_STAMPED && format != SAMPLE_CSV)) {
+      return 0;
+    }
+    // One published value, so a concurrent append is either seen whole or not at all.
+    const unsigned long end = __atomic_load_n(&m_ringEnd, __ATOMIC_ACQUIRE);
+    if (end == 0) {
+      return 0;
+    }
+    Position oldest = { 0, 0 };
+    unsigned long total = end;
+    if (m_wrapped) {
+      const unsigned long headSector = (end - 1) / m_perSector;
+      oldest.sector = (headSector + 1) % m_sectors;
+      total = (m_sectors - 1) * m_perSector + (end - headSector * m_perSector);
+    }
+
+    // The first record at or after fromMs. Erased slots, of a sector just opened, can only lead the ring.
+    unsigned long lo = 0;
+    unsigned long hi = total;
+    while (lo < hi) {
+      const unsigned long mid = (lo + hi) / 2;
+      const Record *r = recordAt(advance(oldest, mid));
+      if (r->seq == 0xFFFFFFFFUL || r->tsMs < fromMs) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    unsigned long written = 0;
+    for (Position pos = advance(oldest, lo); lo < total; ++lo, pos = advance(pos, 1)) {
+      const Record *r = recordAt(pos);
+      if (r->crc != partitionRecordCrc(*r)) {
+        continue;
+      }
+      if (r->tsMs >= toMs) {
+        break;
+      }
+      if (format == SAMPLE_CSV) {
+        writeGeneralStatusCsv(r->gs, r->tsMs, out);
+      } else {
+        writeGsSampleBinary(r->gs, r->tsMs, out);
+      }
+      written++;
+    }
+    return written;
+  }
+
+  bool InfiniPartitionLog::startVerify(UBaseType_t priority) {
+    if (m_mapped == NULL || isVerifying()) {
+      return false;
+    }
+    const unsigned long half = m_count / 2;
+    m_verifyJobs[0].log = this;
+    m_verifyJobs[0].from = m_tail;
+    m_verifyJobs[0].count = half;
+    m_verifyJobs[0].corrupted = 0;
+    m_verifyJobs[1].log = this;
+    m_verifyJobs[1].from = advance(m_tail, half);
+    m_verifyJobs[1].count = m_count - half;
+    m_verifyJobs[1].corrupted = 0;
+    m_verifying = 2;
+    for (BYTE i = 0; i < 2; ++i) {
+      if (xTaskCreatePinnedToCore(verifyTask, "infi_verify", PARTITION_LOG_VERIFY_STACK_SZ, &m_verifyJobs[i], priority,
+                                  NULL, i % portNUM_PROCESSORS) != pdPASS) {
+        // This one and any after it never run.
+        __atomic_sub_fetch(&m_verifying, 2 - i, __ATOMIC_RELEASE);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool InfiniPartitionLog::isVerifying() const {
+    return __atomic_load_n(&m_verifying, __ATOMIC_ACQUIRE) > 0;
+  }
+
+  unsigned long InfiniPartitionLog::corrupted() const {
+    return m_verifyJobs[0].corrupted + m_verifyJobs[1].corrupted;
+  }
+
+  void InfiniPartitionLog::verifyTask(void *arg) {
+    VerifyJob *job = (VerifyJob *)arg;
+    const InfiniPartitionLog *log = job->log;
+    Position pos = job->from;
+    for (unsigned long i = 0; i < job->count; ++i) {
+      const Record *r = log->recordAt(pos);
+      // An erased slot is a sector the ring went round to since the check started.
+      const bool erased = isPartitionRecordErased(*r);
+      if (!erased && r->crc != partitionRecordCrc(*r)) {
+        job->corrupted++;
+      }
+      pos = log->advance(pos, 1);
+      if (i % VERIFY_BURST == VERIFY_BURST - 1) {
+        vTaskDelay(1);
+      }
+    }
+    __atomic_sub_fetch(&job->log->m_verifying, 1, __ATOMIC_RELEASE);
+    vTaskDelete(NULL);
+  }
+
+  const InfiniPartitionLog::SectorHeader *InfiniPartitionLog::header(unsigned long sector) const {
+    return (const SectorHeader *)(m_mapped + sector * PARTITION_SECTOR_SZ);
+  }
+
+  bool InfiniPartitionLog::isValid(const SectorHeader *hdr) const {
+    return isPartitionSectorValid(*hdr);
+  }
+
+  size_t InfiniPartitionLog::offsetOf(const Position &pos) const {
+    return pos.sector * PARTITION_SECTOR_SZ + sizeof(SectorHeader) + pos.slot * sizeof(Record);
+  }
+
+  const InfiniPartitionLog::Record *InfiniPartitionLog::recordAt(const Position &pos) const {
+    return (const Record *)(m_mapped + offsetOf(pos));
+  }
+
+  InfiniPartitionLog::Position InfiniPartitionLog::advance(const Position &from, unsigned long n) const {
+    const unsigned long slots = from.slot + n;
+    Position pos = { (from.sector + slots / m_perSector) % m_sectors, slots % m_perSector };
+    return pos;
+  }
+
+  bool InfiniPartitionLog::eraseNext() {
+    const unsigned long next = (m_head.sector + 1) % m_sectors;
+    if (m_count > 0 && m_tail.sector == next) {
+      // Full, the oldest sector goes with whatever it still held.
+      const unsigned long lost = m_perSector - m_tail.slot;
+      m_count -= lost;
+      m_dropped += lost;
+      m_tail.sector = (next + 1) % m_sectors;
+      m_tail.slot = 0;
+    }
+    if (esp_partition_erase_range(m_partition, next * PARTITION_SECTOR_SZ, PARTITION_SECTOR_SZ) != ESP_OK) {
+      return false;
+    }
+    m_nextErased = true;
+    return true;
+  }
+
+  bool InfiniPartitionLog::writeHeader(unsigned long sector, uint32_t seq) {
+    SectorHeader hdr;
+    memset(&hdr, 0xFF, sizeof(hdr));
+    hdr.magic = PARTITION_SECTOR_MAGIC;
+    hdr.seq = seq;
+    hdr.crc = partitionHeaderCrc(hdr);
+    return esp_partition_write(m_partition, sector * PARTITION_SECTOR_SZ, &hdr, sizeof(hdr)) == ESP_OK;
+  }
+}
+
+#endif
+#endif
@@ -0,0 +1,166 @@
+#ifndef INFINI_PARTITION_LOG_H
+#define INFINI_PARTITION_LOG_H
+
+#include "InfiniGsHistory.h"
+#include "InfiniPartitionFormat.h"
+#include "InfiniSampleFanout.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <esp_partition.h>
+#include <esp_idf_version.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Stack of each of the two tasks startVerify() runs, in bytes.
+#ifndef INFI_PARTITION_LOG_VERIFY_STACK_SZ
+#define INFI_PARTITION_LOG_VERIFY_STACK_SZ 2048
+#endif
+
+namespace INFI {
+
+  const uint32_t PARTITION_LOG_VERIFY_STACK_SZ = INFI_PARTITION_LOG_VERIFY_STACK_SZ;
+
+  // The mapping handle was renamed with ESP-IDF 5.
+#if ESP_IDF_VERSION_MAJOR >= 5
+  typedef esp_partition_mmap_handle_t PartitionMapHandle;
+#else
+  typedef spi_flash_mmap_handle_t PartitionMapHandle;
+#endif
+
+  /*!
+   * The telemetry log straight on a raw data partition, without a file system in between.
+   * Same use as InfiniTelemetryLog: append() while offline, then peek() and consume() once an upload went through.
+   *
+   * The partition is a ring of 4 kB flash sectors, laid out in InfiniPartitionFormat.h. Each starts with a header holding a sequence number
+   * that goes up every time a sector is erased, followed by fixed size records that never straddle a sector.
+   * Every record has its own sequence number and CRC, and a byte that consume() clears, so the read position
+   * needs no extra writes of its own. Appends go round the sectors in order, which levels the wear.
+   * When the ring is full, the oldest sector is erased for new records, and the samples it still held count as dropped().
+   * begin() finds the newest sector with a binary search over the sector headers, and the first unconsumed record
+   * with one over the records, so recovery reads a few dozen headers, whatever the partition size.
+   * Reads go through a memory mapping of the partition: peek() copies straight from flash, record() not at all.
+   * startVerify() checks the CRC of every record left after a power loss, half of them on each core.
+   * writeRange() answers the samples of a time span, consumed or not, with one more binary search, the records
+   * of the ring being in the order of their timestamps.
+   */
+  class InfiniPartitionLog {
+    public:
+    //! label is the data partition in the partition table, e.g. "spiffs" for the default Arduino tables.
+    explicit InfiniPartitionLog(const char *label = "spiffs");
+    ~InfiniPartitionLog();
+
+    /*! Finds and maps the partition, and recovers the head and the read position.
+     * A partition without a single valid sector header is erased as it is used. False if there is no such partition.
+     */
+    bool begin();
+
+    //! Appends a sample, overwriting the oldest sector if the ring is full. False if the flash write failed.
+    bool append(const GeneralStatusFixed &gs, uint64_t tsMs);
+
+    /*! Erases the sector the next append() opens once at most slotsLeft records fit in the current one, so the erase,
+     * the flash operation that keeps the cache off for tens of ms, runs when the caller chooses, e.g. between two
+     * transactions on the inverter link, rather than in whichever append() fills a sector. If the ring is full, the
+     * samples of that sector count as dropped() now. Returns whether it erased.
+     */
+    bool eraseAhead(unsigned long slotsLeft = PARTITION_RECORDS_PER_SECTOR / 4);
+
+    //! Same as InfiniTelemetryLog::peek().
+    BYTE peek(InfiniGsHistory &out, BYTE maxRecords, WORD skipRecords = 0);
+
+    /*! The sample of unconsumed record index, 0 being the oldest, read in place from the mapped flash.
+     * NULL if there is no such record or it fails its CRC. Valid until that record is erased by append().
+     */
+    const GeneralStatusFixed *record(unsigned long index, uint64_t &tsMs) const;
+
+    //! Drops the count oldest records, i.e. what the last peek() returned.
+    void consume(BYTE count);
+
+    bool hasRecords() const;
+    //! Records appended and not consumed yet.
+    unsigned long size() const;
+    //! Records the ring holds at most. Past that a whole sector goes at once, so it holds a sector's worth less after a wrap.
+    unsigned long capacity() const;
+
+    //! Samples lost, overwritten before they were consumed or not written because the flash write failed.
+    unsigned long dropped() const;
+
+    /*! Checks the CRC of every unconsumed record in the background, after begin(), e.g. before the first replay.
+     * The records are split in two halves read through the mapping by a task on each core, at priority, so a
+     * multi MB log takes half the time. append(), peek() and consume() go on meanwhile: appends only ever write past
+     * the records being checked, and a sector that the ring overwrites in the meantime is skipped, its records
+     * are dropped() rather than bad. False if a check is still running or the tasks could not be started.
+     */
+    bool startVerify(UBaseType_t priority = 1);
+    bool isVerifying() const;
+    //! Records that failed their CRC in the last check, once isVerifying() is false.
+    unsigned long corrupted() const;
+
+    /*! Writes the records still in the ring with fromMs <= tsMs < toMs, oldest first, consumed ones too, as
+     * writeGsSampleBinary() records for SAMPLE_BINARY_STAMPED or writeGeneralStatusCsv() lines for SAMPLE_CSV.
+     * The first is found with a binary search over the timestamps, which relies on them going up as appended,
+     * so a span costs its own records and a few dozen reads, whatever the size of the log. Records failing their
+     * CRC are skipped. Safe from another task than the one appending: the sector an append erases meanwhile
+     * fails its CRCs, so only the oldest samples can go missing. Returns the records written.
+     */
+    unsigned long writeRange(uint64_t fromMs, uint64_t toMs, SAMPLE_FORMAT format, Print &out) const;
+
+    private:
+    typedef PartitionSectorHeader SectorHeader;
+    typedef PartitionRecord Record;
+
+    //! A record slot, the sector and the slot in it.
+    struct Position {
+      unsigned long sector;
+      unsigned long slot;
+    };
+
+    const SectorHeader *header(unsigned long sector) const;
+    bool isValid(const SectorHeader *hdr) const;
+    const Record *recordAt(const Position &pos) const;
+    size_t offsetOf(const Position &pos) const;
+    //! The position n records after the oldest one still in the ring.
+    Position advance(const Position &from, unsigned long n) const;
+    //! Erases the sector after the head, dropping what it held if it is the oldest.
+    bool eraseNext();
+    //! Writes the header of the erased sector with seq.
+    bool writeHeader(unsigned long sector, uint32_t seq);
+
+    //! One half of a startVerify().
+    struct VerifyJob {
+      InfiniPartitionLog *log;
+      Position from;
+      unsigned long count;
+      unsigned long corrupted;
+    };
+
+    static void verifyTask(void *arg);
+
+    char m_label[17];
+    const esp_partition_t *m_partition;
+    const BYTE *m_mapped;
+    PartitionMapHandle m_mapHandle;
+    unsigned long m_sectors;
+    unsigned long m_perSector;
+    //! Where the next record goes, and the seq of its sector.
+    Position m_head;
+    uint32_t m_headSeq;
+    //! m_head as slots from the start of the partition, 0 for a blank one, and whether the ring went round.
+    //! Published after every append for writeRange().
+    volatile unsigned long m_ringEnd;
+    volatile bool m_wrapped;
+    //! The oldest unconsumed record.
+    Position m_tail;
+    unsigned long m_count;
+    uint32_t m_nextRecordSeq;
+    unsigned long m_dropped;
+    //! Set by eraseAhead() until append() opens the sector.
+    bool m_nextErased;
+    VerifyJob m_verifyJobs[2];
+    //! Verify tasks still running.
+    volatile BYTE m_verifying;
+  };
+}
+
+#endif
+#endif
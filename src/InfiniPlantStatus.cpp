@@ -0,0 +1,110 @@
+#include "InfiniPlantStatus.h"
+
+#if INFI_MODULE_PARSERS
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+  static_assert(PLANT_MODULES_SZ <= 16, "InfiniPlantAggregator tracks the modules in a WORD");
+
+  InfiniPlantAggregator::InfiniPlantAggregator() :
+    m_seen(0),
+    m_toleranceUs(0),
+    m_firstUs(0),
+    m_minUs(0),
+    m_maxUs(0)
+  {}
+
+  void InfiniPlantAggregator::setAlignment(unsigned long toleranceUs) {
+    m_toleranceUs = toleranceUs;
+  }
+
+  bool InfiniPlantAggregator::update(const GeneralStatusFixed &gs, unsigned long sampledUs) {
+    if (gs.localParallelId >= PLANT_MODULES_SZ) {
+      return false;
+    }
+    // Signed, micros() wraps and a module may have been sent a little before the first one in.
+    long offsetUs = (long)(sampledUs - m_firstUs);
+    if (m_seen != 0 && m_toleranceUs != 0 && (unsigned long)(offsetUs < 0 ? -offsetUs : offsetUs) > m_toleranceUs) {
+      // A later tick, what was seen of the earlier one will not be completed.
+      startCycle();
+    }
+    if (m_seen == 0) {
+      m_firstUs = sampledUs;
+      offsetUs = 0;
+      m_minUs = 0;
+      m_maxUs = 0;
+    }
+    if (offsetUs < m_minUs) {
+      m_minUs = offsetUs;
+    }
+    if (offsetUs > m_maxUs) {
+      m_maxUs = offsetUs;
+    }
+    m_modules[gs.localParallelId] = gs;
+    m_seen |= (WORD)1 << gs.localParallelId;
+    return true;
+  }
+
+  BYTE InfiniPlantAggregator::modulesSeen() const {
+    BYTE count = 0;
+    for (WORD seen = m_seen; seen != 0; seen >>= 1) {
+      count += seen & 1;
+    }
+    return count;
+  }
+
+  bool InfiniPlantAggregator::isComplete(BYTE expectedModules) const {
+    return modulesSeen() >= expectedModules;
+  }
+
+  void InfiniPlantAggregator::summarize(PlantStatus &plant) const {
+    plant.modules = 0;
+    plant.pvInPow = 0;
+    plant.acOutActivePow = 0;
+    plant.acOutApparentPow = 0;
+    plant.battChargeCurr = 0;
+    plant.battDischargeCurr = 0;
+    plant.minBattCapacity = 0;
+    plant.maxOutLoadPct = 0;
+    plant.skewUs = m_seen != 0 ? (unsigned long)(m_maxUs - m_minUs) : 0;
+    for (BYTE i = 0; i < PLANT_MODULES_SZ; ++i) {
+      if ((m_seen & ((WORD)1 << i)) == 0) {
+        continue;
+      }
+      const GeneralStatusFixed &gs = m_modules[i];
+      plant.pvInPow += (unsigned long)gs.pv1InPow + gs.pv2InPow;
+      plant.acOutActivePow += gs.acOutActivePow;
+      plant.acOutApparentPow += gs.acOutApparentPow;
+      plant.battChargeCurr += gs.battChargeCurr;
+      plant.battDischargeCurr += gs.battDischargeCurr;
+      if (plant.modules == 0 || gs.battCapacity < plant.minBattCapacity) {
+        plant.minBattCapacity = gs.battCapacity;
+      }
+      if (gs.outLoadPct > plant.maxOutLoadPct) {
+        plant.maxOutLoadPct = gs.outLoadPct;
+      }
+      plant.modules++;
+    }
+  }
+
+  void InfiniPlantAggregator::startCycle() {
+    m_seen = 0;
+  }
+
+#if INFI_MODULE_JSON
+  size_t writePlantStatusJson(const PlantStatus &plant, Print &out) {
+    size_t n = writeJsonFieldP(out, INFI_PSTR("plantModules"), plant.modules, JSON_UINT, true);
+    n += writeJsonFieldP(out, INFI_PSTR("plantPvInPow"), plant.pvInPow, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("plantAcOutActivePow"), plant.acOutActivePow, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("plantAcOutApparentPow"), plant.acOutApparentPow, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("plantBattChargeCurr"), plant.battChargeCurr, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("plantBattDischargeCurr"), plant.battDischargeCurr, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("plantMinBattCapacity"), plant.minBattCapacity, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("plantMaxOutLoadPct"), plant.maxOutLoadPct, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("plantSkewUs"), plant.skewUs, JSON_UINT, false);
+    n += out.print('}');
+    return n;
+  }
+#endif
+}
+#endif
@@ -0,0 +1,79 @@
+#ifndef INFINI_PLANT_STATUS_H
+#define INFINI_PLANT_STATUS_H
+
+#include <Print.h>
+#include "InfiniDataTypes.h"
+
+// Number of parallel modules a plant summary can merge, P18 addresses up to 9.
+#ifndef INFI_PLANT_MODULES_SZ
+#define INFI_PLANT_MODULES_SZ 9
+#endif
+
+namespace INFI {
+
+  const BYTE PLANT_MODULES_SZ = INFI_PLANT_MODULES_SZ;
+
+  //! The plant level summary of the GS of every parallel module. Powers in W, currents in A.
+  struct PlantStatus {
+    BYTE modules;
+    unsigned long pvInPow;
+    unsigned long acOutActivePow;
+    unsigned long acOutApparentPow;
+    unsigned long battChargeCurr;
+    unsigned long battDischargeCurr;
+    BYTE minBattCapacity;
+    BYTE maxOutLoadPct;
+    //! Between the first and the last module's GS going out, see InfiniPlantAggregator::setAlignment().
+    unsigned long skewUs;
+  };
+
+  /*!
+   * Collects the GS of each parallel module over a poll cycle, keyed by localParallelId,
+   * and merges them into one PlantStatus so the uplink sends one record per cycle instead of one per module.
+   * With an alignment set, a cycle only holds samples taken at the same tick, e.g. by a POLL_SYNCHRONIZED GS,
+   * so the plant totals are not made of readings seconds apart.
+   */
+  class InfiniPlantAggregator {
+    public:
+    InfiniPlantAggregator();
+
+    /*! A sample sent more than toleranceUs away from the first one of the cycle starts a new cycle,
+     * dropping the modules seen so far. 0, the default, merges whatever arrives in between startCycle()s.
+     */
+    void setAlignment(unsigned long toleranceUs);
+
+    /*! Stores gs as the latest reading of its module, sampledUs is the InfiniResponse::sentUs of its GS.
+     * Returns false if localParallelId is out of range.
+     */
+    bool update(const GeneralStatusFixed &gs, unsigned long sampledUs = 0);
+
+    //! Number of modules updated since the last startCycle().
+    BYTE modulesSeen() const;
+
+    //! True once expectedModules different modules were updated this cycle.
+    bool isComplete(BYTE expectedModules) const;
+
+    //! Merges the modules updated this cycle into plant.
+    void summarize(PlantStatus &plant) const;
+
+    //! Forgets which modules were seen, their readings are overwritten by the next update().
+    void startCycle();
+
+    private:
+    GeneralStatusFixed m_modules[PLANT_MODULES_SZ];
+    //! Bit i is set once module i was updated this cycle.
+    WORD m_seen;
+    unsigned long m_toleranceUs;
+    //! The earliest and latest sampledUs of this cycle, as offsets from its first.
+    unsigned long m_firstUs;
+    long m_minUs;
+    long m_maxUs;
+  };
+
+#if INFI_MODULE_JSON
+  //! Writes plant as a flat JSON object, keys prefixed with "plant". Returns the number of bytes written.
+  size_t writePlantStatusJson(const PlantStatus &plant, Print &out);
+#endif
+}
+
+#endif
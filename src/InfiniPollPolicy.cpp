@@ -0,0 +1,146 @@
+#include "InfiniPollPolicy.h"
+
+#if INFI_MODULE_SCHEDULER
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Preferences.h>
+#endif
+
+namespace INFI {
+
+#if defined(ARDUINO_ARCH_ESP32)
+  static const char *const POLICY_KEY = "policy";
+#endif
+
+  InfiniPollPolicy::InfiniPollPolicy() :
+    m_dirty(false)
+  {
+    clear();
+    m_dirty = false;
+  }
+
+  bool InfiniPollPolicy::setPeriod(const char *mnemonic, unsigned long periodMs) {
+    return setPeriod(findCommandType(mnemonic, READ), periodMs);
+  }
+
+  bool InfiniPollPolicy::setPeriod(COMMAND_TYPE commandType, unsigned long periodMs) {
+    if (commandType >= NUM_COMMAND_TYPES || getActionType(commandType) != READ || periodMs == 0) {
+      return false;
+    }
+    m_dirty |= m_state.periodsMs[commandType] != periodMs;
+    m_state.periodsMs[commandType] = periodMs;
+    return true;
+  }
+
+  unsigned long InfiniPollPolicy::period(COMMAND_TYPE commandType) const {
+    return commandType < NUM_COMMAND_TYPES ? m_state.periodsMs[commandType] : 0;
+  }
+
+  bool InfiniPollPolicy::setDeadband(const char *key, WORD deadband) {
+    GS_FIELD field = findGeneralStatusField(key);
+    if (field >= NUM_GS_FIELDS) {
+      return false;
+    }
+    const GsFieldMask bit = 1UL << field;
+    m_dirty |= (m_state.deadbandsSet & bit) == 0 || m_state.deadbands[field] != deadband;
+    m_state.deadbands[field] = deadband;
+    m_state.deadbandsSet |= bit;
+    return true;
+  }
+
+  void InfiniPollPolicy::setFlushPeriod(unsigned long periodMs) {
+    m_dirty |= m_state.flushPeriodMs != periodMs;
+    m_state.flushPeriodMs = periodMs;
+  }
+
+  unsigned long InfiniPollPolicy::flushPeriod() const {
+    return m_state.flushPeriodMs;
+  }
+
+  void InfiniPollPolicy::setFields(GsFieldMask fields) {
+    fields &= GS_ALL_FIELDS;
+    m_dirty |= m_state.fields != fields;
+    m_state.fields = fields;
+  }
+
+  GsFieldMask InfiniPollPolicy::fields() const {
+    return m_state.fields;
+  }
+
+  void InfiniPollPolicy::apply(InfiniPollScheduler &scheduler) const {
+    for (BYTE i = 0; i < NUM_COMMAND_TYPES; ++i) {
+      if (m_state.periodsMs[i] > 0) {
+        scheduler.setPeriod((COMMAND_TYPE)i, m_state.periodsMs[i]);
+      }
+    }
+  }
+
+  void InfiniPollPolicy::apply(GeneralStatusDelta &delta) const {
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      if ((m_state.deadbandsSet & (1UL << i)) != 0) {
+        delta.setDeadband((GS_FIELD)i, m_state.deadbands[i]);
+      }
+    }
+    delta.setFields(m_state.fields);
+  }
+
+  void InfiniPollPolicy::clear() {
+    m_state.version = POLL_POLICY_VERSION;
+    for (BYTE i = 0; i < NUM_COMMAND_TYPES; ++i) {
+      m_state.periodsMs[i] = 0;
+    }
+    for (BYTE i = 0; i < NUM_GS_FIELDS; ++i) {
+      m_state.deadbands[i] = 0;
+    }
+    m_state.deadbandsSet = 0;
+    m_state.flushPeriodMs = 0;
+    m_state.fields = GS_ALL_FIELDS;
+    m_dirty = true;
+  }
+
+  bool InfiniPollPolicy::isDirty() const {
+    return m_dirty;
+  }
+
+  const PollPolicyState &InfiniPollPolicy::state() const {
+    return m_state;
+  }
+
+  bool InfiniPollPolicy::restoreState(const PollPolicyState &state) {
+    if (state.version != POLL_POLICY_VERSION) {
+      return false;
+    }
+    m_state = state;
+    m_dirty = false;
+    return true;
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  bool InfiniPollPolicy::save(const char *ns) {
+    if (!m_dirty) {
+      return true;
+    }
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) {
+      return false;
+    }
+    bool saved = prefs.putBytes(POLICY_KEY, &m_state, sizeof(m_state)) == sizeof(m_state);
+    prefs.end();
+    m_dirty &= !saved;
+    return saved;
+  }
+
+  bool InfiniPollPolicy::load(const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, true)) {
+      return false;
+    }
+    PollPolicyState state;
+    bool loaded = prefs.getBytesLength(POLICY_KEY) == sizeof(state)
+      && prefs.getBytes(POLICY_KEY, &state, sizeof(state)) == sizeof(state);
+    prefs.end();
+    return loaded && restoreState(state);
+  }
+#endif
+}
+#endif
@@ -0,0 +1,81 @@
+#ifndef INFINI_POLL_POLICY_H
+#define INFINI_POLL_POLICY_H
+
+#include "InfiniPollScheduler.h"
+#include "InfiniDeltaTelemetry.h"
+
+namespace INFI {
+
+  //! Bumped whenever PollPolicyState changes, a stored policy of another version is not loaded.
+  const BYTE POLL_POLICY_VERSION = 1;
+
+  //! What InfiniPollPolicy keeps, plain data so it can be stored as one blob.
+  struct PollPolicyState {
+    BYTE version;
+    //! 0 leaves the period the sketch added the query with.
+    unsigned long periodsMs[NUM_COMMAND_TYPES];
+    WORD deadbands[NUM_GS_FIELDS];
+    //! Bit i set if deadbands[i] overrides the sketch's.
+    GsFieldMask deadbandsSet;
+    //! 0 leaves the sketch's.
+    unsigned long flushPeriodMs;
+    GsFieldMask fields;
+  };
+
+  /*!
+   * The polling settings pushed from the server, e.g. as ThingsBoard shared attributes, so the cadence
+   * of a site can be raised during an incident and lowered again without a reflash.
+   * Only what was set overrides the sketch's own settings. A period put back to the sketch's value stays set,
+   * so sending the old value is how an override is undone.
+   * On the ESP32 it is kept in NVS over reboots, see save() and load().
+   */
+  class InfiniPollPolicy {
+    public:
+    InfiniPollPolicy();
+
+    //! Polls the query with mnemonic, e.g. "GS", every periodMs. Returns false for an unknown query or 0.
+    bool setPeriod(const char *mnemonic, unsigned long periodMs);
+    bool setPeriod(COMMAND_TYPE commandType, unsigned long periodMs);
+    //! 0 if not set.
+    unsigned long period(COMMAND_TYPE commandType) const;
+
+    //! The GS deadband of the field with key, e.g. "battVolt", in its stored units. False for an unknown key.
+    bool setDeadband(const char *key, WORD deadband);
+
+    //! How often the batched telemetry goes up, 0 for the sketch's.
+    void setFlushPeriod(unsigned long periodMs);
+    unsigned long flushPeriod() const;
+
+    //! The GS fields to uplink, see GeneralStatusDelta::setFields(). All by default.
+    void setFields(GsFieldMask fields);
+    GsFieldMask fields() const;
+
+    //! Sets the periods that were set on scheduler, on every query added with that COMMAND_TYPE.
+    void apply(InfiniPollScheduler &scheduler) const;
+    //! Sets the deadbands that were set and the fields on delta.
+    void apply(GeneralStatusDelta &delta) const;
+
+    //! Forgets every override.
+    void clear();
+
+    //! True once a setter changed something since the last save() or load().
+    bool isDirty() const;
+
+    const PollPolicyState &state() const;
+    //! Returns false, leaving the policy as it was, if state is of another version.
+    bool restoreState(const PollPolicyState &state);
+
+#if defined(ARDUINO_ARCH_ESP32)
+    //! Keeps the policy in the NVS namespace ns, at most 15 chars. Skipped if nothing changed.
+    bool save(const char *ns = "infi_policy");
+    //! Loads what save() kept. Returns false if there is none, or it is of another version.
+    bool load(const char *ns = "infi_policy");
+#endif
+
+    private:
+    PollPolicyState m_state;
+    bool m_dirty;
+  };
+}
+
+#endif
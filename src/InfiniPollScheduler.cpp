@@ -0,0 +1,560 @@
+#include "InfiniPollScheduler.h"
+
+#if INFI_MODULE_SCHEDULER
+#include <Arduino.h>
+#include <string.h>
+
+namespace INFI {
+
+  InfiniPollScheduler::InfiniPollScheduler(InfiniCommandQueue &queue) :
+    m_deviceCount(1),
+    m_count(0),
+    m_night(false),
+    m_admission(POLL_ADMIT_ALL),
+    m_limitPercent(100),
+    m_scale(1000)
+#if INFI_POLL_SCHEDULER_DEVICES > 1
+    , m_completionHead(0),
+    m_completionCount(0),
+    m_firstDevice(0),
+    m_deferring(false)
+#endif
+  {
+    m_queues[0] = &queue;
+  }
+
+  bool InfiniPollScheduler::addDevice(InfiniCommandQueue &queue) {
+    if (m_deviceCount >= POLL_SCHEDULER_DEVICES) {
+      return false;
+    }
+    m_queues[m_deviceCount] = &queue;
+    // Queries added before this device are due on it straight away, like at boot.
+    for (BYTE i = 0; i < m_count; ++i) {
+      DeviceState &state = m_entries[i].devices[m_deviceCount];
+      state.entry = &m_entries[i];
+      state.lastMs = 0;
+      state.achievedMs = 0;
+      state.due = true;
+      state.queued = false;
+      state.sent = false;
+    }
+    m_deviceCount++;
+    return true;
+  }
+
+  BYTE InfiniPollScheduler::deviceCount() const {
+    return m_deviceCount;
+  }
+
+  bool InfiniPollScheduler::addPeriodic(COMMAND_TYPE commandType, unsigned long periodMs, CommandCallback callback,
+                                        void *context, const char* params) {
+    return add(commandType, POLL_PERIODIC, periodMs, callback, context, params);
+  }
+
+  bool InfiniPollScheduler::addOnSettingsChanged(COMMAND_TYPE commandType, CommandCallback callback, void *context,
+                                                 unsigned long refreshMs, const char* params) {
+    return add(commandType, POLL_ON_SETTINGS_CHANGED, refreshMs, callback, context, params);
+  }
+
+  bool InfiniPollScheduler::addSynchronized(COMMAND_TYPE commandType, unsigned long periodMs, CommandCallback callback,
+                                            void *context, const char* params) {
+    return add(commandType, POLL_SYNCHRONIZED, periodMs, callback, context, params);
+  }
+
+  bool InfiniPollScheduler::addBackground(COMMAND_TYPE commandType, unsigned long periodMs, CommandCallback callback,
+                                         void *context, const char* params) {
+    return add(commandType, POLL_BACKGROUND, periodMs, callback, context, params);
+  }
+
+  bool InfiniPollScheduler::fitsBackground(BYTE device, COMMAND_TYPE commandType) const {
+    return fitsBackground(device, commandType, millis());
+  }
+
+  void InfiniPollScheduler::setAdmission(POLL_ADMISSION admission, BYTE limitPercent) {
+    m_admission = admission;
+    m_limitPercent = limitPercent;
+    updateScale();
+  }
+
+  unsigned long InfiniPollScheduler::utilization(BYTE device) const {
+    return device < m_deviceCount ? utilizationOf(device, m_night) : 0;
+  }
+
+  unsigned long InfiniPollScheduler::periodScale() const {
+    return m_scale;
+  }
+
+  bool InfiniPollScheduler::getRates(COMMAND_TYPE commandType, BYTE device, PollRates &rates) const {
+    const Entry *entry = find(commandType);
+    if (entry == NULL || device >= m_deviceCount) {
+      return false;
+    }
+    rates.requestedMs = requestedPeriodOf(*entry, m_night);
+    rates.scheduledMs = periodOf(*entry);
+    rates.achievedMs = entry->devices[device].achievedMs;
+    return true;
+  }
+
+  bool InfiniPollScheduler::setPeriod(COMMAND_TYPE commandType, unsigned long periodMs) {
+    Entry *entry = find(commandType);
+    if (entry == NULL) {
+      return false;
+    }
+    const unsigned long oldMs = entry->periodMs;
+    entry->periodMs = periodMs;
+    if (m_admission == POLL_ADMIT_REJECT && !isAdmissible()) {
+      entry->periodMs = oldMs;
+      return false;
+    }
+    updateScale();
+    return true;
+  }
+
+  bool InfiniPollScheduler::setNightPeriod(COMMAND_TYPE commandType, unsigned long periodMs) {
+    Entry *entry = find(commandType);
+    if (entry == NULL) {
+      return false;
+    }
+    const unsigned long oldMs = entry->nightPeriodMs;
+    const bool hadNightPeriod = entry->hasNightPeriod;
+    entry->nightPeriodMs = periodMs;
+    entry->hasNightPeriod = true;
+    if (m_admission == POLL_ADMIT_REJECT && !isAdmissible()) {
+      entry->nightPeriodMs = oldMs;
+      entry->hasNightPeriod = hadNightPeriod;
+      return false;
+    }
+    updateScale();
+    return true;
+  }
+
+  void InfiniPollScheduler::setNight(bool night) {
+    m_night = night;
+    updateScale();
+  }
+
+  bool InfiniPollScheduler::isNight() const {
+    return m_night;
+  }
+
+  bool InfiniPollScheduler::setParams(COMMAND_TYPE commandType, const char* params) {
+    Entry *entry = find(commandType);
+    if (entry == NULL) {
+      return false;
+    }
+    strncpy(entry->params, params != NULL ? params : "", MAX_PARAMS_SZ - 1);
+    entry->params[MAX_PARAMS_SZ - 1] = '\0';
+    return true;
+  }
+
+  void InfiniPollScheduler::notifySettingsChanged() {
+    for (BYTE d = 0; d < m_deviceCount; ++d) {
+      notifySettingsChanged(d);
+    }
+  }
+
+  void InfiniPollScheduler::notifySettingsChanged(BYTE device) {
+    if (device >= m_deviceCount) {
+      return;
+    }
+    for (BYTE i = 0; i < m_count; ++i) {
+      if (m_entries[i].policy == POLL_ON_SETTINGS_CHANGED) {
+        m_entries[i].devices[device].due = true;
+      }
+    }
+  }
+
+  bool InfiniPollScheduler::trigger(COMMAND_TYPE commandType) {
+    Entry *entry = find(commandType);
+    if (entry == NULL) {
+      return false;
+    }
+    for (BYTE d = 0; d < m_deviceCount; ++d) {
+      entry->devices[d].due = true;
+    }
+    return true;
+  }
+
+  bool InfiniPollScheduler::trigger(COMMAND_TYPE commandType, BYTE device) {
+    Entry *entry = find(commandType);
+    if (entry == NULL || device >= m_deviceCount) {
+      return false;
+    }
+    entry->devices[device].due = true;
+    return true;
+  }
+
+  bool InfiniPollScheduler::cancel(COMMAND_TYPE commandType) {
+    Entry *entry = find(commandType);
+    if (entry == NULL) {
+      return false;
+    }
+    for (BYTE d = 0; d < m_deviceCount; ++d) {
+      entry->devices[d].due = false;
+    }
+    return true;
+  }
+
+  void InfiniPollScheduler::loop() {
+    unsigned long now = millis();
+#if INFI_POLL_SCHEDULER_DEVICES > 1
+    // Replies are held back while the links are served, see runCompletions().
+    m_deferring = true;
+    const BYTE first = m_firstDevice;
+    m_firstDevice = (BYTE)((first + 1) % m_deviceCount);
+#else
+    const BYTE first = 0;
+#endif
+    // The learnt turnarounds move the load, so the scale follows them.
+    updateScale();
+    const bool holding = startSynchronized(now);
+    for (BYTE n = 0; n < m_deviceCount; ++n) {
+      const BYTE d = (BYTE)((first + n) % m_deviceCount);
+      if (!holding) {
+        startForeground(d, now);
+        startBackground(d, now);
+      }
+      // Each queue only waits on its own link, so the devices are served side by side.
+      // One that completes a command starts the next one in the same call.
+      m_queues[d]->loop();
+      if (!holding) {
+        // The next one waits behind the command just started, so the link goes on without a gap.
+        startForeground(d, now);
+      }
+    }
+#if INFI_POLL_SCHEDULER_DEVICES > 1
+    m_deferring = false;
+    runCompletions();
+#endif
+  }
+
+  unsigned long InfiniPollScheduler::msUntilDue() const {
+    unsigned long now = millis();
+    unsigned long wait = NO_DEADLINE;
+    for (BYTE d = 0; d < m_deviceCount; ++d) {
+      unsigned long queueWait = m_queues[d]->msUntilWork();
+      if (queueWait < wait) {
+        wait = queueWait;
+      }
+      for (BYTE i = 0; i < m_count; ++i) {
+        const Entry &entry = m_entries[i];
+        const DeviceState &state = entry.devices[d];
+        if (state.queued) {
+          // Due again only after its callback, which the queue's wait covers.
+          continue;
+        }
+        const unsigned long periodMs = periodOf(entry);
+        if (periodMs == POLL_SUSPENDED) {
+          continue;
+        }
+        unsigned long entryWait = state.due ? 0
+          : periodMs != 0 ? msUntilElapsed(state.lastMs, periodMs, now) : NO_DEADLINE;
+        // Only one query waits in a queue at a time, see startForeground().
+        if (entryWait == 0 && (!m_queues[d]->isEmpty() || (entry.policy == POLL_SYNCHRONIZED && !areLinksIdle())
+                               || (entry.policy == POLL_BACKGROUND && !fitsBackground(d, entry.commandType, now)))) {
+          // Cannot be queued before the queue moves on, which its wait covers too.
+          continue;
+        }
+        if (entryWait < wait) {
+          wait = entryWait;
+        }
+      }
+    }
+    return wait;
+  }
+
+  bool InfiniPollScheduler::add(COMMAND_TYPE commandType, POLL_POLICY policy, unsigned long periodMs,
+                                CommandCallback callback, void *context, const char* params) {
+    if (m_count >= POLL_SCHEDULER_SZ || find(commandType) != NULL) {
+      return false;
+    }
+    Entry &entry = m_entries[m_count];
+    entry.scheduler = this;
+    entry.commandType = commandType;
+    entry.policy = policy;
+    entry.periodMs = periodMs;
+    entry.nightPeriodMs = 0;
+    entry.hasNightPeriod = false;
+    for (BYTE d = 0; d < POLL_SCHEDULER_DEVICES; ++d) {
+      DeviceState &state = entry.devices[d];
+      state.entry = &entry;
+      state.lastMs = 0;
+      state.achievedMs = 0;
+      // Everything is read once at boot.
+      state.due = true;
+      state.queued = false;
+      state.sent = false;
+    }
+    entry.callback = callback;
+    entry.context = context;
+    m_count++;
+    if (m_admission == POLL_ADMIT_REJECT && !isAdmissible()) {
+      m_count--;
+      return false;
+    }
+    updateScale();
+    return setParams(commandType, params);
+  }
+
+  InfiniPollScheduler::Entry *InfiniPollScheduler::find(COMMAND_TYPE commandType) {
+    for (BYTE i = 0; i < m_count; ++i) {
+      if (m_entries[i].commandType == commandType) {
+        return &m_entries[i];
+      }
+    }
+    return NULL;
+  }
+
+  const InfiniPollScheduler::Entry *InfiniPollScheduler::find(COMMAND_TYPE commandType) const {
+    for (BYTE i = 0; i < m_count; ++i) {
+      if (m_entries[i].commandType == commandType) {
+        return &m_entries[i];
+      }
+    }
+    return NULL;
+  }
+
+  unsigned long InfiniPollScheduler::requestedPeriodOf(const Entry &entry, bool night) const {
+    return night && entry.hasNightPeriod ? entry.nightPeriodMs : entry.periodMs;
+  }
+
+  unsigned long InfiniPollScheduler::periodOf(const Entry &entry) const {
+    const unsigned long periodMs = requestedPeriodOf(entry, m_night);
+    if (periodMs == 0 || periodMs == POLL_SUSPENDED || m_scale == 1000) {
+      return periodMs;
+    }
+    // In parts, so an hourly period stretched a few times does not overflow.
+    return periodMs / 1000 * m_scale + periodMs % 1000 * m_scale / 1000;
+  }
+
+  unsigned long InfiniPollScheduler::utilizationOf(BYTE device, bool night) const {
+    const InfiniCommandSender &sender = m_queues[device]->sender();
+    unsigned long permille = 0;
+    for (BYTE i = 0; i < m_count; ++i) {
+      const Entry &entry = m_entries[i];
+      const unsigned long periodMs = requestedPeriodOf(entry, night);
+      if (entry.policy == POLL_BACKGROUND || periodMs == 0 || periodMs == POLL_SUSPENDED) {
+        continue;
+      }
+      permille += sender.expectedTransactionMs(entry.commandType) * 1000UL / periodMs;
+    }
+    return permille;
+  }
+
+  bool InfiniPollScheduler::isAdmissible() const {
+    const unsigned long limit = m_limitPercent * 10UL;
+    for (BYTE d = 0; d < m_deviceCount; ++d) {
+      if (utilizationOf(d, false) > limit || utilizationOf(d, true) > limit) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void InfiniPollScheduler::updateScale() {
+    const unsigned long limit = m_limitPercent * 10UL;
+    unsigned long busiest = 0;
+    for (BYTE d = 0; m_admission == POLL_ADMIT_SCALE && d < m_deviceCount; ++d) {
+      const unsigned long permille = utilizationOf(d, m_night);
+      if (permille > busiest) {
+        busiest = permille;
+      }
+    }
+    // Rounded up, so the stretched periods never come out a little over the limit.
+    m_scale = limit > 0 && busiest > limit ? (busiest * 1000UL + limit - 1) / limit : 1000;
+  }
+
+  bool InfiniPollScheduler::isDue(const Entry &entry, const DeviceState &state, unsigned long now) const {
+    const unsigned long periodMs = periodOf(entry);
+    if (periodMs == POLL_SUSPENDED) {
+      // A due flag waits for the day.
+      return false;
+    }
+    if (state.due) {
+      return true;
+    }
+    // A zero period means "only when triggered".
+    return periodMs != 0 && now - state.lastMs >= periodMs;
+  }
+
+  bool InfiniPollScheduler::isSynchronizedDue(const Entry &entry, unsigned long now) const {
+    for (BYTE d = 0; d < m_deviceCount; ++d) {
+      if (entry.devices[d].queued) {
+        return false;
+      }
+    }
+    // The devices are sent together, so device 0 stands for all of them.
+    return isDue(entry, entry.devices[0], now);
+  }
+
+  bool InfiniPollScheduler::areLinksIdle() const {
+    for (BYTE d = 0; d < m_deviceCount; ++d) {
+      // A link that is down fails what is queued at once, it is not waited for.
+      if (!m_queues[d]->isLinkDown() && (m_queues[d]->isBusy() || !m_queues[d]->isEmpty())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  unsigned long InfiniPollScheduler::msUntilForeground(BYTE device, unsigned long now) const {
+    unsigned long wait = NO_DEADLINE;
+    for (BYTE i = 0; i < m_count; ++i) {
+      const Entry &entry = m_entries[i];
+      const DeviceState &state = entry.devices[device];
+      const unsigned long periodMs = periodOf(entry);
+      if (entry.policy == POLL_BACKGROUND || state.queued || periodMs == POLL_SUSPENDED) {
+        continue;
+      }
+      unsigned long entryWait = state.due ? 0
+        : periodMs != 0 ? msUntilElapsed(state.lastMs, periodMs, now) : NO_DEADLINE;
+      if (entryWait < wait) {
+        wait = entryWait;
+      }
+    }
+    return wait;
+  }
+
+  bool InfiniPollScheduler::fitsBackground(BYTE device, COMMAND_TYPE commandType, unsigned long now) const {
+    if (device >= m_deviceCount) {
+      return false;
+    }
+    const InfiniCommandQueue &queue = *m_queues[device];
+    if (queue.isBusy() || !queue.isEmpty() || queue.isLinkDown()) {
+      return false;
+    }
+    const unsigned long foregroundMs = msUntilForeground(device, now);
+    return foregroundMs == NO_DEADLINE || foregroundMs > queue.sender().transactionMs(commandType);
+  }
+
+  void InfiniPollScheduler::startForeground(BYTE device, unsigned long now) {
+    if (!m_queues[device]->isEmpty()) {
+      return;
+    }
+    DeviceState *earliest = NULL;
+    long earliestLeft = 0;
+    for (BYTE i = 0; i < m_count; ++i) {
+      Entry &entry = m_entries[i];
+      DeviceState &state = entry.devices[device];
+      if (entry.policy == POLL_SYNCHRONIZED || entry.policy == POLL_BACKGROUND || state.queued
+          || !isDue(entry, state, now)) {
+        continue;
+      }
+      // A period after it fell due, a triggered query's is now. Ties go in the order they were added.
+      const long left = state.due ? 0 : (long)(state.lastMs + 2 * periodOf(entry) - now);
+      if (earliest == NULL || left < earliestLeft) {
+        earliest = &state;
+        earliestLeft = left;
+      }
+    }
+    if (earliest != NULL
+        && m_queues[device]->enqueue(earliest->entry->commandType, earliest->entry->params, onComplete, earliest)) {
+      earliest->queued = true;
+      markSent(*earliest, now);
+    }
+  }
+
+  void InfiniPollScheduler::markSent(DeviceState &state, unsigned long now) {
+    if (state.sent) {
+      const unsigned long intervalMs = now - state.lastMs;
+      state.achievedMs = state.achievedMs == 0 ? intervalMs : state.achievedMs - state.achievedMs / 8 + intervalMs / 8;
+    }
+    state.sent = true;
+    state.due = false;
+    state.lastMs = now;
+  }
+
+  void InfiniPollScheduler::startBackground(BYTE device, unsigned long now) {
+    for (BYTE i = 0; i < m_count; ++i) {
+      Entry &entry = m_entries[i];
+      DeviceState &state = entry.devices[device];
+      if (entry.policy != POLL_BACKGROUND || state.queued || !isDue(entry, state, now)
+          || !fitsBackground(device, entry.commandType, now)) {
+        continue;
+      }
+      // One at a time, the next waits for a gap of its own.
+      if (m_queues[device]->enqueueWithPriority(PRIORITY_BACKGROUND, entry.commandType, entry.params, onComplete, &state)) {
+        state.queued = true;
+        markSent(state, now);
+      }
+      return;
+    }
+  }
+
+  bool InfiniPollScheduler::startSynchronized(unsigned long now) {
+    bool holding = false;
+    for (BYTE i = 0; i < m_count; ++i) {
+      Entry &entry = m_entries[i];
+      if (entry.policy != POLL_SYNCHRONIZED || !isSynchronizedDue(entry, now)) {
+        continue;
+      }
+      if (!areLinksIdle()) {
+        holding = true;
+        continue;
+      }
+      for (BYTE d = 0; d < m_deviceCount; ++d) {
+        DeviceState &state = entry.devices[d];
+        // Idle links have room, a down one completes it with SEND_LINK_DOWN.
+        state.queued = m_queues[d]->enqueue(entry.commandType, entry.params, onComplete, &state);
+        markSent(state, now);
+      }
+      // Nothing else in the way, so each starts its command right here, one after the other.
+      for (BYTE d = 0; d < m_deviceCount; ++d) {
+        m_queues[d]->loop();
+      }
+    }
+    return holding;
+  }
+
+  void InfiniPollScheduler::onComplete(const InfiniResponse &response, SEND_STATUS status, void *context) {
+    DeviceState *state = (DeviceState *)context;
+    state->queued = false;
+    Entry *entry = state->entry;
+#if INFI_POLL_SCHEDULER_DEVICES > 1
+    // A full completion queue only costs this reply its spot in line, it is handed over at once.
+    if (entry->scheduler->m_deferring && entry->scheduler->defer(*state, response, status)) {
+      return;
+    }
+#endif
+    if (entry->callback != NULL) {
+      entry->callback(response, status, entry->context);
+    }
+  }
+
+#if INFI_POLL_SCHEDULER_DEVICES > 1
+  bool InfiniPollScheduler::defer(DeviceState &state, const InfiniResponse &response, SEND_STATUS status) {
+    if (m_completionCount >= POLL_COMPLETIONS_SZ) {
+      return false;
+    }
+    Completion &completion = m_completions[(m_completionHead + m_completionCount) % POLL_COMPLETIONS_SZ];
+    completion.state = &state;
+    completion.status = status;
+    // InfiniResponse has a const member, so it cannot be assigned.
+    InfiniResponse &copy = completion.response;
+    size_t len = response.actualLen < copy.bufferSize ? response.actualLen : copy.bufferSize;
+    copy.reset();
+    memcpy(copy.val, response.val, len);
+    copy.actualLen = len;
+    copy.cmdType = response.cmdType;
+    copy.error = response.error;
+    copy.deviceId = response.deviceId;
+    copy.sentUs = response.sentUs;
+    m_completionCount++;
+    return true;
+  }
+
+  void InfiniPollScheduler::runCompletions() {
+    // Nothing is deferred meanwhile, so the slot stays as it is until its callback returns.
+    while (m_completionCount > 0) {
+      Completion &completion = m_completions[m_completionHead];
+      m_completionHead = (BYTE)((m_completionHead + 1) % POLL_COMPLETIONS_SZ);
+      m_completionCount--;
+      const Entry *entry = completion.state->entry;
+      if (entry->callback != NULL) {
+        entry->callback(completion.response, completion.status, entry->context);
+      }
+    }
+  }
+#endif
+}
+#endif
@@ -0,0 +1,283 @@
+#ifndef INFINI_POLL_SCHEDULER_H
+#define INFINI_POLL_SCHEDULER_H
+
+#include "InfiniCommandQueue.h"
+
+// Number of commands the scheduler can poll. Override with a build flag if needed.
+#ifndef INFI_POLL_SCHEDULER_SZ
+#define INFI_POLL_SCHEDULER_SZ 12
+#endif
+
+// Number of inverters, each on its own queue and link, one scheduler can drive.
+#ifndef INFI_POLL_SCHEDULER_DEVICES
+#define INFI_POLL_SCHEDULER_DEVICES 1
+#endif
+
+// Completions loop() holds back until every link was served, see the class comment. Each holds a whole InfiniResponse.
+#ifndef INFI_POLL_COMPLETIONS_SZ
+#define INFI_POLL_COMPLETIONS_SZ INFI_POLL_SCHEDULER_DEVICES
+#endif
+
+namespace INFI {
+
+  const BYTE POLL_SCHEDULER_SZ = INFI_POLL_SCHEDULER_SZ;
+  const BYTE POLL_SCHEDULER_DEVICES = INFI_POLL_SCHEDULER_DEVICES;
+  const BYTE POLL_COMPLETIONS_SZ = INFI_POLL_COMPLETIONS_SZ;
+
+  /*!
+   * How the scheduler decides a query is due.
+   * POLL_PERIODIC queries are re-sent every period.
+   * POLL_ON_SETTINGS_CHANGED queries are sent once at boot and then again only
+   * after notifySettingsChanged(), e.g. when GS reports settingsChanged.
+   * They can optionally still be refreshed every period as a fallback.
+   * POLL_SYNCHRONIZED queries are periodic, but sent on every device at the same tick, see addSynchronized().
+   * POLL_BACKGROUND queries are periodic, but only sent in the gaps the others leave, see addBackground().
+   */
+  enum POLL_POLICY { POLL_PERIODIC, POLL_ON_SETTINGS_CHANGED, POLL_SYNCHRONIZED, POLL_BACKGROUND };
+
+  //! A night period that drops the query until setNight(false), see setNightPeriod().
+  const unsigned long POLL_SUSPENDED = NO_DEADLINE;
+
+  /*!
+   * What the scheduler does with periods that would keep a link busier than its limit, see setAdmission().
+   * POLL_ADMIT_ALL takes them, the queries then fall behind their periods. This is the default.
+   * POLL_ADMIT_REJECT refuses the add or setPeriod() that would push a link over.
+   * POLL_ADMIT_SCALE takes them and stretches every period by the same factor until the busiest link fits.
+   */
+  enum POLL_ADMISSION { POLL_ADMIT_ALL, POLL_ADMIT_REJECT, POLL_ADMIT_SCALE };
+
+  //! How one query keeps up on one device, see InfiniPollScheduler::getRates().
+  struct PollRates {
+    //! The period it was added or set with, day or night, 0 if it is only sent when triggered.
+    unsigned long requestedMs;
+    //! The period it is scheduled at, requestedMs unless POLL_ADMIT_SCALE stretched it.
+    unsigned long scheduledMs;
+    //! The smoothed time between its sends, 0 before the second.
+    unsigned long achievedMs;
+  };
+
+  /*!
+   * Puts queries on an InfiniCommandQueue, each at its own cadence, so that fast changing
+   * data like GS does not share its link time with static data like PIRI or DI.
+   * A query is never queued twice: it only becomes due again once its previous
+   * transaction has completed.
+   * Several inverters can be driven at once, each through its own queue, sender and stream.
+   * Every query is polled on every device, and the links run concurrently since each queue
+   * only waits on its own sender. The callbacks tell the devices apart by response.deviceId.
+   * With more than one device, loop() serves the links round robin, a different one first every call.
+   * Their replies are copied into a shared completion queue and the callbacks only run once every link
+   * has its next command on the wire, so decoding and uploading one inverter's reply no longer holds up the others.
+   *
+   * The queries due on a link go out earliest deadline first, a query's deadline being a period after it fell due.
+   * Only one waits in the queue behind the transaction in flight, so the choice is made as late as possible and a
+   * GS that falls due meanwhile still goes ahead of an FWS that was due before it. Up to a fully used link every
+   * query then keeps its period. Whether the periods fit is known from each query's InfiniCommandSender::
+   * expectedTransactionMs(), see utilization() and setAdmission().
+   */
+  class InfiniPollScheduler {
+    public:
+    //! queue becomes device 0.
+    InfiniPollScheduler(InfiniCommandQueue &queue);
+
+    /*! Adds another inverter behind queue, returns false if POLL_SCHEDULER_DEVICES are already added.
+     * Its sender's setDeviceId() is what the callbacks will see.
+     */
+    bool addDevice(InfiniCommandQueue &queue);
+
+    //! Number of devices, including the one passed to the ctor.
+    BYTE deviceCount() const;
+
+    //! Polls commandType every periodMs. Returns false if the scheduler is full, or see POLL_ADMIT_REJECT.
+    bool addPeriodic(COMMAND_TYPE commandType, unsigned long periodMs, CommandCallback callback,
+                     void *context = NULL, const char* params = "");
+
+    /*! Polls commandType once at boot and again after every notifySettingsChanged().
+     * A non-zero refreshMs additionally re-reads it at that period.
+     */
+    bool addOnSettingsChanged(COMMAND_TYPE commandType, CommandCallback callback, void *context = NULL,
+                              unsigned long refreshMs = 0, const char* params = "");
+
+    /*! Polls commandType every periodMs on every device at once, e.g. GS of parallel modules that are merged
+     * into one plant record. Once due it waits for every link that is up to go idle, holding back the other queries,
+     * then starts on all of them back to back. The replies' sentUs tell how close together they went out.
+     */
+    bool addSynchronized(COMMAND_TYPE commandType, unsigned long periodMs, CommandCallback callback,
+                         void *context = NULL, const char* params = "");
+
+    /*! Polls commandType about every periodMs, in PRIORITY_BACKGROUND and only in a gap: once its device's queue
+     * is idle and no other query falls due before the transaction could end, see fitsBackground(). Meant for
+     * maintenance reads, e.g. an hourly PIRI or T, so they never hold up a GS sample. Read once at boot too,
+     * in the first gap.
+     */
+    bool addBackground(COMMAND_TYPE commandType, unsigned long periodMs, CommandCallback callback,
+                       void *context = NULL, const char* params = "");
+
+    /*! Whether a transaction of commandType fits on device now: its queue has nothing queued or in flight, its
+     * link is up, and no query but the background ones falls due within InfiniCommandSender::transactionMs(),
+     * the wire time of the frame and reply plus the turnaround learnt. For jobs of their own in
+     * PRIORITY_BACKGROUND, e.g. InfiniEnergyBackfill.
+     */
+    bool fitsBackground(BYTE device, COMMAND_TYPE commandType) const;
+
+    /*! Sets what an add or setPeriod() that would take a link over limitPercent of its time does, see POLL_ADMISSION.
+     * A link's load grows later too, e.g. when the inverter's turnaround is learnt, only POLL_ADMIT_SCALE follows it.
+     */
+    void setAdmission(POLL_ADMISSION admission, BYTE limitPercent = 100);
+
+    /*! The share of device's link time the queries take at their periods, in permille: the sum of each one's
+     * expectedTransactionMs() over its period. POLL_BACKGROUND queries only use the gaps, they are left out.
+     */
+    unsigned long utilization(BYTE device) const;
+
+    //! The factor POLL_ADMIT_SCALE stretches the periods by, in permille, 1000 if they fit.
+    unsigned long periodScale() const;
+
+    //! How commandType keeps up on device. Returns false if it was not added.
+    bool getRates(COMMAND_TYPE commandType, BYTE device, PollRates &rates) const;
+
+    /*! Changes the period of an already added command. Returns false if it was not added,
+     * or with POLL_ADMIT_REJECT if a link cannot fit the new period.
+     */
+    bool setPeriod(COMMAND_TYPE commandType, unsigned long periodMs);
+
+    /*! Polls an already added command every periodMs instead while setNight() is on, e.g. GS slower.
+     * POLL_SUSPENDED does not send it at all at night, its boot read and triggers included, e.g. for the PV energy.
+     * Returns false if it was not added, or with POLL_ADMIT_REJECT if a link cannot fit the night period.
+     */
+    bool setNightPeriod(COMMAND_TYPE commandType, unsigned long periodMs);
+
+    //! Switches every query with a night period to it, or back to its period, e.g. from InfiniDaylight::isNight().
+    void setNight(bool night);
+    bool isNight() const;
+
+    //! Replaces the params an already added command is sent with.
+    bool setParams(COMMAND_TYPE commandType, const char* params);
+
+    //! Marks every POLL_ON_SETTINGS_CHANGED query as due, on every device.
+    void notifySettingsChanged();
+
+    //! Marks every POLL_ON_SETTINGS_CHANGED query as due on the device at index device only.
+    void notifySettingsChanged(BYTE device);
+
+    //! Marks a single query as due on every device, whatever its policy.
+    bool trigger(COMMAND_TYPE commandType);
+
+    //! Marks a single query as due on the device at index device only.
+    bool trigger(COMMAND_TYPE commandType, BYTE device);
+
+    /*! Clears a query's due flag on every device, e.g. the boot read of one whose reply was kept from before.
+     * What is already queued still goes out.
+     */
+    bool cancel(COMMAND_TYPE commandType);
+
+    /*! Queues whatever is due and advances the command queue.
+     * Never blocks, call it from loop() as often as possible.
+     */
+    void loop();
+
+    /*! Milliseconds until loop() has something to do: a query falling due or work for one of the queues,
+     * see InfiniCommandQueue::msUntilWork(). NO_DEADLINE if nothing is scheduled.
+     * Meant for sleeping between loops instead of spinning.
+     */
+    unsigned long msUntilDue() const;
+
+    private:
+    struct Entry;
+
+    //! Where a query stands on one device.
+    struct DeviceState {
+      Entry *entry;
+      unsigned long lastMs;
+      //! Smoothed time between sends, 0 until the second.
+      unsigned long achievedMs;
+      bool due;
+      bool queued;
+      //! Set from the first send, lastMs is a send time from then on.
+      bool sent;
+    };
+
+    struct Entry {
+      InfiniPollScheduler *scheduler;
+      COMMAND_TYPE commandType;
+      POLL_POLICY policy;
+      unsigned long periodMs;
+      //! Used instead of periodMs at night if hasNightPeriod.
+      unsigned long nightPeriodMs;
+      bool hasNightPeriod;
+      char params[MAX_PARAMS_SZ];
+      CommandCallback callback;
+      void *context;
+      DeviceState devices[POLL_SCHEDULER_DEVICES];
+    };
+
+    bool add(COMMAND_TYPE commandType, POLL_POLICY policy, unsigned long periodMs,
+             CommandCallback callback, void *context, const char* params);
+    Entry *find(COMMAND_TYPE commandType);
+    const Entry *find(COMMAND_TYPE commandType) const;
+    //! The period entry was asked to run at, night or day.
+    unsigned long requestedPeriodOf(const Entry &entry, bool night) const;
+    //! The period entry runs at now, stretched by m_scale.
+    unsigned long periodOf(const Entry &entry) const;
+    //! utilization() for the day or night periods.
+    unsigned long utilizationOf(BYTE device, bool night) const;
+    //! Whether every link fits within m_limitPercent, day and night.
+    bool isAdmissible() const;
+    //! The m_scale that fits the busiest link at the current periods.
+    void updateScale();
+    //! Queues the due POLL_PERIODIC or POLL_ON_SETTINGS_CHANGED query with the first deadline, if device's queue is empty.
+    void startForeground(BYTE device, unsigned long now);
+    //! Starts the next period of state, sent at now.
+    void markSent(DeviceState &state, unsigned long now);
+    bool isDue(const Entry &entry, const DeviceState &state, unsigned long now) const;
+    //! Whether a POLL_SYNCHRONIZED entry is due, on every device as one.
+    bool isSynchronizedDue(const Entry &entry, unsigned long now) const;
+    //! Whether every link that is up has nothing queued or in flight.
+    bool areLinksIdle() const;
+    //! Milliseconds until a query but the background ones is due on device, 0 if one is.
+    unsigned long msUntilForeground(BYTE device, unsigned long now) const;
+    bool fitsBackground(BYTE device, COMMAND_TYPE commandType, unsigned long now) const;
+    //! Queues the first due background query that fits on device, if any.
+    void startBackground(BYTE device, unsigned long now);
+    /*! Starts the POLL_SYNCHRONIZED entries that are due, if the links are idle.
+     * Returns true if one is due but waits for them, nothing else should be queued meanwhile.
+     */
+    bool startSynchronized(unsigned long now);
+
+    //! The queue callback of every scheduled command, context is the DeviceState.
+    static void onComplete(const InfiniResponse &response, SEND_STATUS status, void *context);
+
+#if INFI_POLL_SCHEDULER_DEVICES > 1
+    //! A reply held back until every link was served.
+    struct Completion {
+      DeviceState *state;
+      SEND_STATUS status;
+      InfiniResponse response;
+    };
+
+    //! Copies a reply into the completion queue. Returns false if it is full.
+    bool defer(DeviceState &state, const InfiniResponse &response, SEND_STATUS status);
+    //! Runs the callbacks of the held back replies, oldest first.
+    void runCompletions();
+#endif
+
+    InfiniCommandQueue *m_queues[POLL_SCHEDULER_DEVICES];
+    BYTE m_deviceCount;
+    Entry m_entries[POLL_SCHEDULER_SZ];
+    BYTE m_count;
+    bool m_night;
+    POLL_ADMISSION m_admission;
+    BYTE m_limitPercent;
+    //! In permille.
+    unsigned long m_scale;
+#if INFI_POLL_SCHEDULER_DEVICES > 1
+    Completion m_completions[POLL_COMPLETIONS_SZ];
+    BYTE m_completionHead;
+    BYTE m_completionCount;
+    //! Served first on the next loop().
+    BYTE m_firstDevice;
+    bool m_deferring;
+#endif
+  };
+}
+
+#endif
@@ -0,0 +1,299 @@
+#ifndef INFINI_RECORD_DECODER_H
+#define INFINI_RECORD_DECODER_H
+
+/*
+ * Reads the self-describing BINARY_GS_SCHEMA and BINARY_GS_COLUMNS records of InfiniRecordSchema.h.
+ * Header only and standalone, it needs nothing but the C library, so an ingestion service on Linux can
+ * copy this one file. Nothing is copied or converted: the views point into the buffer they were given,
+ * and on a little endian host every column of an 8 byte aligned buffer is a plain array of its values.
+ *
+ * A record starts with the schema version, the record type, a count and the schema id,
+ * then the FNV-1a hash of the field table. A field is its bits, its decimal scale, raw * 10^scale in the
+ * field's unit, and, in the schema record only, its key. The hash covers, for every field in order, the key,
+ * then the bits and the scale byte, so a columns record can be matched to the schema record that names
+ * its fields, and a decoder can tell a field table it has never seen.
+ *   BINARY_GS_SCHEMA: version, type, field count, schema id, hash (uint32), then per field
+ *     bits, scale (int8), key length, key, all of it zero padded to a multiple of 8 bytes.
+ *   BINARY_GS_COLUMNS: version, type, sample count, schema id, hash (uint32), field count, then per field
+ *     bits and scale, zero padded to a multiple of 8 bytes. Then the Unix ms of the samples (int64 each),
+ *     then a column per field in order, count values of 1 byte for up to 8 bits or 2 bytes for up to 16,
+ *     each column zero padded to a multiple of 8 bytes.
+ * Multi byte values are little endian. Both records are a multiple of 8 bytes, so back to back in a
+ * buffer they all stay aligned.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace INFI {
+
+  namespace record {
+    //! The BINARY_SCHEMA_VERSION and BINARY_RECORD_TYPE values of InfiniBinaryWriter.h.
+    const uint8_t SCHEMA_VERSION = 1;
+    const uint8_t TYPE_GS_SCHEMA = 6;
+    const uint8_t TYPE_GS_COLUMNS = 7;
+    //! The schema ids, which record structure the fields are of.
+    const uint8_t SCHEMA_GS = 1;
+    //! Fields a record describes at most.
+    const uint8_t MAX_FIELDS = 64;
+    //! Bytes before the field table, and a field's entry in a columns record.
+    const size_t HEADER_SZ = 8;
+    const size_t COLUMN_FIELD_SZ = 2;
+
+    const uint32_t FNV_OFFSET = 2166136261UL;
+    const uint32_t FNV_PRIME = 16777619UL;
+
+    constexpr uint32_t fnv1a(uint32_t hash, uint8_t byte) {
+      return (hash ^ byte) * FNV_PRIME;
+    }
+
+    //! fnv1a() of len chars at key, in the C++11 constexpr form the firmware hashes its table at compile time with.
+    constexpr uint32_t fnv1aKey(uint32_t hash, const char *key, size_t len) {
+      return len == 0 ? hash : fnv1aKey(fnv1a(hash, (uint8_t)*key), key + 1, len - 1);
+    }
+
+    //! hash after one more field, see the file comment.
+    constexpr uint32_t hashField(uint32_t hash, const char *key, size_t keyLen, uint8_t bits, int8_t scale) {
+      return fnv1a(fnv1a(fnv1aKey(hash, key, keyLen), bits), (uint8_t)scale);
+    }
+
+    inline size_t padded(size_t len) {
+      return (len + 7) & ~(size_t)7;
+    }
+
+    inline uint32_t readU32(const uint8_t *p) {
+      return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    inline bool isLittleEndian() {
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+      return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+#else
+      const uint16_t probe = 1;
+      return *(const uint8_t *)&probe == 1;
+#endif
+    }
+  }
+
+  //! One field of a record.
+  struct RecordField {
+    uint8_t bits;
+    //! The value is raw * 10^scale, e.g. -1 for the 0.1 V readings.
+    int8_t scale;
+    //! Not null terminated, NULL in a columns record.
+    const char *key;
+    uint8_t keyLen;
+  };
+
+  //! A BINARY_GS_SCHEMA record, the names of the fields of the columns records with the same hash.
+  class InfiniSchemaView {
+    public:
+    InfiniSchemaView() : m_fieldCount(0), m_schemaId(0), m_hash(0), m_size(0) {}
+
+    //! Takes the record at buf. False if it is not a whole schema record, or its hash does not match its fields.
+    bool parse(const uint8_t *buf, size_t len) {
+      m_size = 0;
+      if (len < record::HEADER_SZ || buf[0] != record::SCHEMA_VERSION || buf[1] != record::TYPE_GS_SCHEMA ||
+          buf[2] > record::MAX_FIELDS) {
+        return false;
+      }
+      m_fieldCount = buf[2];
+      m_schemaId = buf[3];
+      m_hash = record::readU32(buf + 4);
+      uint32_t hash = record::FNV_OFFSET;
+      size_t at = record::HEADER_SZ;
+      for (uint8_t i = 0; i < m_fieldCount; ++i) {
+        if (at + 3 > len || at + 3 + buf[at + 2] > len) {
+          return false;
+        }
+        RecordField &field = m_fields[i];
+        field.bits = buf[at];
+        field.scale = (int8_t)buf[at + 1];
+        field.keyLen = buf[at + 2];
+        field.key = (const char *)buf + at + 3;
+        hash = record::hashField(hash, field.key, field.keyLen, field.bits, field.scale);
+        at += 3 + field.keyLen;
+      }
+      if (hash != m_hash || record::padded(at) > len) {
+        return false;
+      }
+      m_size = record::padded(at);
+      return true;
+    }
+
+    uint8_t fieldCount() const { return m_fieldCount; }
+    const RecordField &field(uint8_t index) const { return m_fields[index]; }
+    uint8_t schemaId() const { return m_schemaId; }
+    uint32_t hash() const { return m_hash; }
+    //! Bytes the record took, 0 unless parse() succeeded.
+    size_t size() const { return m_size; }
+
+    //! The index of the field named key, fieldCount() if none.
+    uint8_t find(const char *key) const {
+      const size_t keyLen = strlen(key);
+      for (uint8_t i = 0; i < m_fieldCount; ++i) {
+        if (m_fields[i].keyLen == keyLen && memcmp(m_fields[i].key, key, keyLen) == 0) {
+          return i;
+        }
+      }
+      return m_fieldCount;
+    }
+
+    private:
+    RecordField m_fields[record::MAX_FIELDS];
+    uint8_t m_fieldCount;
+    uint8_t m_schemaId;
+    uint32_t m_hash;
+    size_t m_size;
+  };
+
+  /*!
+   * A BINARY_GS_COLUMNS record: count samples, their timestamps and a column per field, all of it read in place.
+   * words(), bytes() and timestamps() are the columns themselves, or NULL if they are not of that width, the
+   * host is big endian or the buffer is not aligned. raw(), value() and timestamp() read any of them.
+   */
+  class InfiniColumnsView {
+    public:
+    InfiniColumnsView() : m_buf(NULL), m_count(0), m_fieldCount(0), m_schemaId(0), m_hash(0), m_size(0) {}
+
+    //! Takes the record at buf. False if it is not a whole columns record of this schema version.
+    bool parse(const uint8_t *buf, size_t len) {
+      m_size = 0;
+      if (len < record::HEADER_SZ + 1 || buf[0] != record::SCHEMA_VERSION || buf[1] != record::TYPE_GS_COLUMNS ||
+          buf[2] == 0 || buf[8] > record::MAX_FIELDS) {
+        return false;
+      }
+      m_buf = buf;
+      m_count = buf[2];
+      m_schemaId = buf[3];
+      m_hash = record::readU32(buf + 4);
+      m_fieldCount = buf[8];
+      const uint8_t *table = buf + record::HEADER_SZ + 1;
+      size_t at = record::padded(record::HEADER_SZ + 1 + m_fieldCount * record::COLUMN_FIELD_SZ);
+      if (at > len) {
+        return false;
+      }
+      m_tsOffset = at;
+      at += (size_t)m_count * 8;
+      for (uint8_t i = 0; i < m_fieldCount; ++i) {
+        RecordField &field = m_fields[i];
+        field.bits = table[i * record::COLUMN_FIELD_SZ];
+        field.scale = (int8_t)table[i * record::COLUMN_FIELD_SZ + 1];
+        field.key = NULL;
+        field.keyLen = 0;
+        if (field.bits == 0 || field.bits > 16) {
+          return false;
+        }
+        m_offsets[i] = at;
+        at += record::padded((size_t)m_count * width(i));
+      }
+      if (at > len) {
+        return false;
+      }
+      m_size = at;
+      return true;
+    }
+
+    //! Samples in the record, 1 to 255.
+    uint8_t count() const { return m_count; }
+    uint8_t fieldCount() const { return m_fieldCount; }
+    const RecordField &field(uint8_t index) const { return m_fields[index]; }
+    uint8_t schemaId() const { return m_schemaId; }
+    //! Matches the InfiniSchemaView::hash() of the schema record that names the fields.
+    uint32_t hash() const { return m_hash; }
+    //! Bytes the record took, where the next one starts. 0 unless parse() succeeded.
+    size_t size() const { return m_size; }
+
+    //! Bytes a value of field takes, 1 or 2.
+    uint8_t width(uint8_t field) const { return m_fields[field].bits > 8 ? 2 : 1; }
+
+    //! The Unix ms of sample index.
+    int64_t timestamp(uint8_t index) const {
+      const uint8_t *p = m_buf + m_tsOffset + (size_t)index * 8;
+      return (int64_t)((uint64_t)record::readU32(p) | ((uint64_t)record::readU32(p + 4) << 32));
+    }
+
+    //! The raw value of field of sample index.
+    uint16_t raw(uint8_t field, uint8_t index) const {
+      const uint8_t *p = m_buf + m_offsets[field];
+      return width(field) == 1 ? p[index] : (uint16_t)(p[index * 2] | (p[index * 2 + 1] << 8));
+    }
+
+    //! raw() in the field's unit.
+    double value(uint8_t field, uint8_t index) const {
+      double v = raw(field, index);
+      for (int8_t s = m_fields[field].scale; s < 0; ++s) {
+        v /= 10;
+      }
+      for (int8_t s = m_fields[field].scale; s > 0; --s) {
+        v *= 10;
+      }
+      return v;
+    }
+
+    const int64_t *timestamps() const {
+      return (const int64_t *)aligned(m_buf + m_tsOffset, 8);
+    }
+    const uint16_t *words(uint8_t field) const {
+      return width(field) == 2 ? (const uint16_t *)aligned(m_buf + m_offsets[field], 2) : NULL;
+    }
+    const uint8_t *bytes(uint8_t field) const {
+      return width(field) == 1 ? m_buf + m_offsets[field] : NULL;
+    }
+
+    private:
+    static const uint8_t *aligned(const uint8_t *p, size_t alignment) {
+      return record::isLittleEndian() && ((uintptr_t)p & (alignment - 1)) == 0 ? p : NULL;
+    }
+
+    const uint8_t *m_buf;
+    RecordField m_fields[record::MAX_FIELDS];
+    size_t m_offsets[record::MAX_FIELDS];
+    size_t m_tsOffset;
+    uint8_t m_count;
+    uint8_t m_fieldCount;
+    uint8_t m_schemaId;
+    uint32_t m_hash;
+    size_t m_size;
+  };
+
+  /*!
+   * Walks a buffer of records back to back, e.g. a batch from the uplink or a file of them, a schema record
+   * wherever the field table is announced and columns records in between. next() stops at the first record
+   * it cannot read, offset() tells where.
+   */
+  class InfiniRecordReader {
+    public:
+    InfiniRecordReader(const uint8_t *buf, size_t len) : m_buf(buf), m_len(len), m_offset(0) {}
+
+    //! The type of the next record, record::TYPE_GS_SCHEMA or record::TYPE_GS_COLUMNS, or 0 at the end.
+    uint8_t peekType() const {
+      return m_offset + 2 <= m_len && m_buf[m_offset] == record::SCHEMA_VERSION ? m_buf[m_offset + 1] : 0;
+    }
+
+    //! Reads the next record into schema or columns, whichever it is. False at the end or a bad record.
+    bool next(InfiniSchemaView &schema, InfiniColumnsView &columns) {
+      const uint8_t type = peekType();
+      const uint8_t *at = m_buf + m_offset;
+      size_t size = 0;
+      if (type == record::TYPE_GS_SCHEMA && schema.parse(at, m_len - m_offset)) {
+        size = schema.size();
+      } else if (type == record::TYPE_GS_COLUMNS && columns.parse(at, m_len - m_offset)) {
+        size = columns.size();
+      }
+      m_offset += size;
+      return size > 0;
+    }
+
+    size_t offset() const { return m_offset; }
+    bool atEnd() const { return m_offset >= m_len; }
+
+    private:
+    const uint8_t *m_buf;
+    size_t m_len;
+    size_t m_offset;
+  };
+}
+
+#endif
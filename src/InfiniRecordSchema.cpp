@@ -0,0 +1,152 @@
+#include "InfiniRecordSchema.h"
+
+#if INFI_MODULE_BINARY
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+
+  static_assert(record::SCHEMA_VERSION == BINARY_SCHEMA_VERSION && record::TYPE_GS_SCHEMA == BINARY_GS_SCHEMA &&
+                record::TYPE_GS_COLUMNS == BINARY_GS_COLUMNS, "InfiniRecordDecoder.h must match InfiniBinaryWriter.h");
+  static_assert(NUM_GS_FIELDS <= record::MAX_FIELDS, "InfiniRecordDecoder.h must take every GS field");
+
+  struct SchemaRow {
+    const char *key;
+    BYTE keyLen;
+    BYTE bits;
+    signed char scale;
+  };
+
+#define INFI_GS_ROW(field, member, key, shortKey, width, kind, bits) { key, sizeof(key) - 1, bits, kind == JSON_DECI ? -1 : 0 },
+#define INFI_GS_BITS(field, member, key, shortKey, width, kind, bits) bits,
+#define INFI_GS_SCALE(field, member, key, shortKey, width, kind, bits) kind == JSON_DECI ? -1 : 0,
+
+  // Only read at compile time, for the hash.
+  static constexpr SchemaRow GS_SCHEMA_ROWS[NUM_GS_FIELDS] = {
+    INFI_GS_SCHEMA(INFI_GS_ROW)
+  };
+
+  static const BYTE GS_FIELD_BITS[NUM_GS_FIELDS] INFI_PROGMEM = {
+    INFI_GS_SCHEMA(INFI_GS_BITS)
+  };
+
+  static const signed char GS_FIELD_SCALES[NUM_GS_FIELDS] INFI_PROGMEM = {
+    INFI_GS_SCHEMA(INFI_GS_SCALE)
+  };
+
+  static constexpr uint32_t hashRows(BYTE i, uint32_t hash) {
+    return i == NUM_GS_FIELDS ? hash : hashRows(i + 1, record::hashField(hash, GS_SCHEMA_ROWS[i].key,
+                                                                         GS_SCHEMA_ROWS[i].keyLen,
+                                                                         GS_SCHEMA_ROWS[i].bits,
+                                                                         GS_SCHEMA_ROWS[i].scale));
+  }
+
+  static constexpr uint32_t GS_SCHEMA_HASH = hashRows(0, record::FNV_OFFSET);
+
+  static size_t writeWord(Print &out, WORD value) {
+    size_t n = out.write((uint8_t)(value & 0xFF));
+    return n + out.write((uint8_t)(value >> 8));
+  }
+
+  static size_t writeLong(Print &out, uint32_t value) {
+    size_t n = writeWord(out, (WORD)(value & 0xFFFF));
+    return n + writeWord(out, (WORD)(value >> 16));
+  }
+
+  static size_t writePadding(Print &out, size_t written) {
+    size_t n = 0;
+    while ((written + n) % 8 != 0) {
+      n += out.write((uint8_t)0);
+    }
+    return n;
+  }
+
+  static size_t writeHeader(Print &out, BINARY_RECORD_TYPE type, BYTE count) {
+    size_t n = out.write(BINARY_SCHEMA_VERSION);
+    n += out.write((uint8_t)type);
+    n += out.write(count);
+    n += out.write(record::SCHEMA_GS);
+    return n + writeLong(out, GS_SCHEMA_HASH);
+  }
+
+  static BYTE fieldBits(BYTE field) {
+    return INFI_READ_BYTE(&GS_FIELD_BITS[field]);
+  }
+
+  size_t writeGsSchemaBinary(Print &out) {
+    size_t n = writeHeader(out, BINARY_GS_SCHEMA, NUM_GS_FIELDS);
+    for (BYTE f = 0; f < NUM_GS_FIELDS; ++f) {
+      const char *key = getGeneralStatusFieldKey((GS_FIELD)f);
+      const BYTE keyLen = (BYTE)INFI_STRLEN_P(key);
+      n += out.write(fieldBits(f));
+      n += out.write(INFI_READ_BYTE(&GS_FIELD_SCALES[f]));
+      n += out.write(keyLen);
+      for (BYTE i = 0; i < keyLen; ++i) {
+        n += out.write(INFI_READ_BYTE(key + i));
+      }
+    }
+    return n + writePadding(out, n);
+  }
+
+  size_t measureGsColumnsBinary(BYTE count) {
+    size_t n = record::padded(record::HEADER_SZ + 1 + NUM_GS_FIELDS * record::COLUMN_FIELD_SZ) + (size_t)count * 8;
+    for (BYTE f = 0; f < NUM_GS_FIELDS; ++f) {
+      n += record::padded((size_t)count * (fieldBits(f) > 8 ? 2 : 1));
+    }
+    return n;
+  }
+
+  // Samples given as arrays, with the accessors of InfiniGsHistory the writer below takes.
+  struct SampleArrays {
+    const GeneralStatusFixed *const *samples;
+    const uint64_t *tsMs;
+
+    uint64_t timestamp(BYTE index) const {
+      return tsMs[index];
+    }
+    long value(GS_FIELD field, BYTE index) const {
+      return getGeneralStatusField(*samples[index], field);
+    }
+  };
+
+  template<typename Samples>
+  static size_t writeColumns(const Samples &samples, BYTE count, Print &out) {
+    size_t n = writeHeader(out, BINARY_GS_COLUMNS, count);
+    n += out.write((uint8_t)NUM_GS_FIELDS);
+    for (BYTE f = 0; f < NUM_GS_FIELDS; ++f) {
+      n += out.write(fieldBits(f));
+      n += out.write(INFI_READ_BYTE(&GS_FIELD_SCALES[f]));
+    }
+    n += writePadding(out, n);
+    for (BYTE i = 0; i < count; ++i) {
+      const uint64_t tsMs = samples.timestamp(i);
+      n += writeLong(out, (uint32_t)(tsMs & 0xFFFFFFFFUL));
+      n += writeLong(out, (uint32_t)(tsMs >> 32));
+    }
+    for (BYTE f = 0; f < NUM_GS_FIELDS; ++f) {
+      const bool wide = fieldBits(f) > 8;
+      for (BYTE i = 0; i < count; ++i) {
+        const long value = samples.value((GS_FIELD)f, i);
+        n += wide ? writeWord(out, (WORD)value) : out.write((uint8_t)value);
+      }
+      n += writePadding(out, n);
+    }
+    return n;
+  }
+
+  size_t writeGsColumnsBinary(const InfiniGsHistory &history, BYTE count, Print &out) {
+    if (count > history.size()) {
+      count = (BYTE)history.size();
+    }
+    return count == 0 ? 0 : writeColumns(history, count, out);
+  }
+
+  size_t writeGsColumnsBinary(const GeneralStatusFixed *const *samples, const uint64_t *tsMs, BYTE count, Print &out) {
+    const SampleArrays arrays = { samples, tsMs };
+    return count == 0 ? 0 : writeColumns(arrays, count, out);
+  }
+
+  uint32_t gsSchemaHash() {
+    return GS_SCHEMA_HASH;
+  }
+}
+#endif
@@ -0,0 +1,36 @@
+#ifndef INFINI_RECORD_SCHEMA_H
+#define INFINI_RECORD_SCHEMA_H
+
+#include <stdint.h>
+#include "InfiniBinaryWriter.h"
+#include "InfiniGsHistory.h"
+#include "InfiniRecordDecoder.h"
+
+namespace INFI {
+
+  /*!
+   * Self-describing records for a backend that ingests samples in bulk, laid out in InfiniRecordDecoder.h,
+   * which reads them on the host without the library. Both are expanded from INFI_GS_SCHEMA: a field's bits
+   * and its scale, -1 for the JSON_DECI fields, and the hash of the whole table, computed at compile time.
+   * Adding or changing a field there changes gsSchemaHash(), so the backend can tell the tables apart.
+   *
+   * writeGsSchemaBinary() names the fields, send it once per session or at the head of a file.
+   * writeGsColumnsBinary() writes the oldest count samples of history, at most 255 and size(), as one
+   * BINARY_GS_COLUMNS record, in place of count BINARY_GS_SAMPLE ones. It carries the bits and scales itself,
+   * so it can be decoded without the schema record. A sample takes about as many bytes as in BINARY_GS_SAMPLE,
+   * but every field is a column of its own the host reads in place, with no bit fields to unpack.
+   * Both return the bytes written, a multiple of 8. 0 if there are no samples.
+   */
+  size_t writeGsSchemaBinary(Print &out);
+  size_t writeGsColumnsBinary(const InfiniGsHistory &history, BYTE count, Print &out);
+  //! The same from count samples and their Unix ms, e.g. records read in place from a log.
+  size_t writeGsColumnsBinary(const GeneralStatusFixed *const *samples, const uint64_t *tsMs, BYTE count, Print &out);
+
+  //! Bytes writeGsColumnsBinary() writes for count samples.
+  size_t measureGsColumnsBinary(BYTE count);
+
+  //! The hash of the GS field table, the one both records carry.
+  uint32_t gsSchemaHash();
+}
+
+#endif
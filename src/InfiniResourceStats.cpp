@@ -0,0 +1,316 @@
+#include "InfiniResourceStats.h"
+
+#if INFI_MODULE_STATS
+#include <string.h>
+#include "InfiniJsonWriter.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <sdkconfig.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif defined(__AVR__)
+extern char __heap_start;
+extern char *__brkval;
+#endif
+
+#if INFI_ALLOC_STATS
+#include <stdlib.h>
+
+namespace INFI {
+  static volatile unsigned long allocCount = 0;
+  static volatile unsigned long freeCount = 0;
+  static volatile unsigned long allocBytes = 0;
+
+  //! Called from whichever task allocates.
+  static void countAlloc(size_t size) {
+#if defined(ARDUINO_ARCH_ESP32)
+    __atomic_fetch_add(&allocCount, 1UL, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocBytes, (unsigned long)size, __ATOMIC_RELAXED);
+#else
+    allocCount++;
+    allocBytes += size;
+#endif
+  }
+
+  static void countFree() {
+#if defined(ARDUINO_ARCH_ESP32)
+    __atomic_fetch_add(&freeCount, 1UL, __ATOMIC_RELAXED);
+#else
+    freeCount++;
+#endif
+  }
+}
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_HEAP_USE_HOOKS)
+// The allocator calls these for every heap_caps allocation, malloc and new included.
+extern "C" void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+  (void)ptr;
+  (void)caps;
+  INFI::countAlloc(size);
+}
+
+extern "C" void esp_heap_trace_free_hook(void *ptr) {
+  (void)ptr;
+  INFI::countFree();
+}
+#else
+// The other side of -Wl,--wrap, every call to malloc() and friends in the image lands here.
+extern "C" {
+  void *__real_malloc(size_t size);
+  void *__real_calloc(size_t count, size_t size);
+  void *__real_realloc(void *ptr, size_t size);
+  void __real_free(void *ptr);
+
+  void *__wrap_malloc(size_t size) {
+    void *ptr = __real_malloc(size);
+    if (ptr != NULL) {
+      INFI::countAlloc(size);
+    }
+    return ptr;
+  }
+
+  void *__wrap_calloc(size_t count, size_t size) {
+    void *ptr = __real_calloc(count, size);
+    if (ptr != NULL) {
+      INFI::countAlloc(count * size);
+    }
+    return ptr;
+  }
+
+  // Counted as an allocation whenever it may move the block, i.e. always but for a free.
+  void *__wrap_realloc(void *ptr, size_t size) {
+    void *moved = __real_realloc(ptr, size);
+    if (moved != NULL && size > 0) {
+      INFI::countAlloc(size);
+    }
+    return moved;
+  }
+
+  void __wrap_free(void *ptr) {
+    if (ptr != NULL) {
+      INFI::countFree();
+    }
+    __real_free(ptr);
+  }
+}
+#endif
+#endif
+
+namespace INFI {
+  static const char *const STAGE_KEYS[NUM_RESOURCE_STAGES] = { "resPoll", "resParse", "resSerialize", "resPublish" };
+
+  InfiniResourceStats::InfiniResourceStats() {
+    reset();
+  }
+
+  unsigned long InfiniResourceStats::stackFree() {
+#if defined(ARDUINO_ARCH_ESP32)
+    // ESP-IDF counts the stack in bytes, not words.
+    return uxTaskGetStackHighWaterMark(NULL);
+#elif defined(__AVR__)
+    char marker;
+    char *heapEnd = __brkval != NULL ? __brkval : &__heap_start;
+    return (unsigned long)(&marker - heapEnd);
+#else
+    return 0;
+#endif
+  }
+
+  unsigned long InfiniResourceStats::heapFree() {
+#if defined(ARDUINO_ARCH_ESP32)
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+#elif defined(__AVR__)
+    // Heap and stack share the space between them.
+    return stackFree();
+#else
+    return 0;
+#endif
+  }
+
+  unsigned long InfiniResourceStats::heapFreeMinEver() {
+#if defined(ARDUINO_ARCH_ESP32)
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+#else
+    return 0;
+#endif
+  }
+
+  unsigned long InfiniResourceStats::largestFreeBlock() {
+#if defined(ARDUINO_ARCH_ESP32)
+    return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+#else
+    return 0;
+#endif
+  }
+
+  AllocCounters InfiniResourceStats::allocCounters() {
+    AllocCounters counters;
+#if INFI_ALLOC_STATS
+    counters.allocs = allocCount;
+    counters.frees = freeCount;
+    counters.bytes = allocBytes;
+#else
+    memset(&counters, 0, sizeof(counters));
+#endif
+    return counters;
+  }
+
+  void InfiniResourceStats::begin(RESOURCE_STAGE stage) {
+    StageResources &res = m_stages[stage];
+    m_stackAtBegin[stage] = stackFree();
+    unsigned long heap = heapFree();
+    if (res.runs == 0 || heap < res.heapFreeMin) {
+      res.heapFreeMin = heap;
+    }
+#if INFI_ALLOC_STATS
+    unsigned long largest = largestFreeBlock();
+    if (res.runs == 0 || largest < res.largestFreeMin) {
+      res.largestFreeMin = largest;
+    }
+    // Last, so the probe's own work is not counted.
+    AllocCounters counters = allocCounters();
+    m_allocsAtBegin[stage] = counters.allocs;
+    m_bytesAtBegin[stage] = counters.bytes;
+#endif
+  }
+
+  void InfiniResourceStats::end(RESOURCE_STAGE stage) {
+    StageResources &res = m_stages[stage];
+#if INFI_ALLOC_STATS
+    AllocCounters counters = allocCounters();
+    res.allocs += counters.allocs - m_allocsAtBegin[stage];
+    res.allocBytes += counters.bytes - m_bytesAtBegin[stage];
+    unsigned long largest = largestFreeBlock();
+    if (largest < res.largestFreeMin) {
+      res.largestFreeMin = largest;
+    }
+#endif
+    unsigned long stack = stackFree();
+    unsigned long heap = heapFree();
+    if (res.runs == 0 || stack < res.stackFreeMin) {
+      res.stackFreeMin = stack;
+    }
+    if (heap < res.heapFreeMin) {
+      res.heapFreeMin = heap;
+    }
+    if (stack < m_stackAtBegin[stage]) {
+      res.stackDeepened += m_stackAtBegin[stage] - stack;
+    }
+    res.runs++;
+  }
+
+  const StageResources &InfiniResourceStats::stage(RESOURCE_STAGE stage) const {
+    return m_stages[stage];
+  }
+
+  unsigned long InfiniResourceStats::stackFreeMin() const {
+    unsigned long least = 0;
+    bool any = false;
+    for (BYTE i = 0; i < NUM_RESOURCE_STAGES; ++i) {
+      if (m_stages[i].runs > 0 && (!any || m_stages[i].stackFreeMin < least)) {
+        least = m_stages[i].stackFreeMin;
+        any = true;
+      }
+    }
+    return least;
+  }
+
+  unsigned long InfiniResourceStats::heapFreeMin() const {
+    unsigned long least = 0;
+    bool any = false;
+    for (BYTE i = 0; i < NUM_RESOURCE_STAGES; ++i) {
+      if (m_stages[i].runs > 0 && (!any || m_stages[i].heapFreeMin < least)) {
+        least = m_stages[i].heapFreeMin;
+        any = true;
+      }
+    }
+    return least;
+  }
+
+  void InfiniResourceStats::endCycle() {
+    unsigned long allocs = allocCounters().allocs;
+    m_lastCycleAllocs = allocs - m_allocsAtCycle;
+    if (m_lastCycleAllocs > m_cycleAllocsMax) {
+      m_cycleAllocsMax = m_lastCycleAllocs;
+    }
+    m_allocsAtCycle = allocs;
+  }
+
+  unsigned long InfiniResourceStats::lastCycleAllocs() const {
+    return m_lastCycleAllocs;
+  }
+
+  unsigned long InfiniResourceStats::cycleAllocsMax() const {
+    return m_cycleAllocsMax;
+  }
+
+  void InfiniResourceStats::reset() {
+    memset(m_stages, 0, sizeof(m_stages));
+    memset(m_stackAtBegin, 0, sizeof(m_stackAtBegin));
+    memset(m_allocsAtBegin, 0, sizeof(m_allocsAtBegin));
+    memset(m_bytesAtBegin, 0, sizeof(m_bytesAtBegin));
+    m_allocsAtCycle = allocCounters().allocs;
+    m_lastCycleAllocs = 0;
+    m_cycleAllocsMax = 0;
+  }
+
+  size_t InfiniResourceStats::writeJson(Print &out) const {
+    size_t n = writeJsonFieldP(out, INFI_PSTR("stackFreeMin"), stackFreeMin(), JSON_UINT, true);
+    n += writeJsonFieldP(out, INFI_PSTR("heapFreeMin"), heapFreeMin(), JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("heapFreeMinEver"), heapFreeMinEver(), JSON_UINT, false);
+#if INFI_ALLOC_STATS
+    unsigned long largestMin = 0;
+    bool any = false;
+    for (BYTE i = 0; i < NUM_RESOURCE_STAGES; ++i) {
+      if (m_stages[i].runs > 0 && (!any || m_stages[i].largestFreeMin < largestMin)) {
+        largestMin = m_stages[i].largestFreeMin;
+        any = true;
+      }
+    }
+    n += writeJsonFieldP(out, INFI_PSTR("largestFreeMin"), largestMin, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("cycleAllocs"), m_lastCycleAllocs, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("cycleAllocsMax"), m_cycleAllocsMax, JSON_UINT, false);
+#endif
+    for (BYTE i = 0; i < NUM_RESOURCE_STAGES; ++i) {
+      const StageResources &res = m_stages[i];
+      if (res.runs == 0) {
+        continue;
+      }
+      n += out.print(",\"");
+      n += out.print(STAGE_KEYS[i]);
+      n += out.print("\":[");
+      n += out.print(res.stackFreeMin);
+      n += out.print(',');
+      n += out.print(res.heapFreeMin);
+      n += out.print(',');
+      n += out.print(res.stackDeepened);
+#if INFI_ALLOC_STATS
+      n += out.print(',');
+      n += out.print(res.allocs);
+      n += out.print(',');
+      n += out.print(res.allocBytes);
+      n += out.print(',');
+      n += out.print(res.largestFreeMin);
+#endif
+      n += out.print(']');
+    }
+    n += out.print('}');
+    return n;
+  }
+
+  InfiniResourceProbe::InfiniResourceProbe(InfiniResourceStats *stats, RESOURCE_STAGE stage) :
+    m_stats(stats),
+    m_stage(stage) {
+    if (m_stats != NULL) {
+      m_stats->begin(m_stage);
+    }
+  }
+
+  InfiniResourceProbe::~InfiniResourceProbe() {
+    if (m_stats != NULL) {
+      m_stats->end(m_stage);
+    }
+  }
+}
+#endif
@@ -0,0 +1,131 @@
+#ifndef INFINI_RESOURCE_STATS_H
+#define INFINI_RESOURCE_STATS_H
+
+#include <Print.h>
+#include "InfiniCommon.h"
+
+// Set to 1 to count the heap allocations of each stage and cycle. The allocator has to report them, either through
+// the ESP-IDF heap hooks (CONFIG_HEAP_USE_HOOKS), or by wrapping it at link time with
+// -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc -Wl,--wrap=free, which also catches new and ArduinoJson.
+#ifndef INFI_ALLOC_STATS
+#define INFI_ALLOC_STATS 0
+#endif
+
+namespace INFI {
+
+  //! The parts of a polling cycle whose stack and heap use is tracked separately.
+  enum RESOURCE_STAGE {
+    STAGE_POLL,      // Sending commands and reading replies, including the callbacks run from there.
+    STAGE_PARSE,     // Decoding a reply.
+    STAGE_SERIALIZE, // Writing telemetry JSON.
+    STAGE_PUBLISH,   // Handing it to the MQTT client.
+
+    NUM_RESOURCE_STAGES
+  };
+
+  //! What one stage left behind at worst. All in bytes.
+  struct StageResources {
+    //! Least free stack of the running task seen at the end of the stage, its high-water mark on ESP32.
+    unsigned long stackFreeMin;
+    //! Least free heap seen at the start or end of the stage.
+    unsigned long heapFreeMin;
+    //! How far the stack high-water mark moved while in the stage, summed since reset().
+    //! The stage where the deepest stack use happens is the one this keeps growing for.
+    unsigned long stackDeepened;
+    unsigned long runs;
+    //! Allocations made while in the stage and their bytes, summed since reset(). Only with INFI_ALLOC_STATS.
+    unsigned long allocs;
+    unsigned long allocBytes;
+    //! Smallest largest free block seen at the start or end of the stage, how fragmented the heap got. Only with INFI_ALLOC_STATS.
+    unsigned long largestFreeMin;
+  };
+
+  //! Heap calls counted since boot, see INFI_ALLOC_STATS. Includes those of every task.
+  struct AllocCounters {
+    unsigned long allocs;
+    unsigned long frees;
+    unsigned long bytes;
+  };
+
+  /*!
+   * Minima of the free stack and heap around each RESOURCE_STAGE, to size the tasks and buffers from data
+   * rather than guesses. On ESP32 the stack figure is uxTaskGetStackHighWaterMark() of the calling task,
+   * i.e. how close it ever came to overflowing, and the heap is the free 8 bit capable heap.
+   * On AVR both are the gap between the heap and the stack pointer, sampled when a stage begins and ends,
+   * so a peak in between is missed. Elsewhere everything stays 0.
+   *
+   * Stages can nest, e.g. STAGE_PARSE from a callback in STAGE_POLL, the outer one then also counts
+   * what the inner one used. Wrap a stage in an InfiniResourceProbe, or call begin() and end().
+   *
+   * With INFI_ALLOC_STATS every stage also counts the allocations made while it runs, in any task, and the
+   * smallest largest free block seen around it. endCycle() at the end of each poll cycle keeps the allocations
+   * of the last and of the worst cycle, so a steady state that should be allocation free can be checked.
+   */
+  class InfiniResourceStats {
+    public:
+    InfiniResourceStats();
+
+    void begin(RESOURCE_STAGE stage);
+    void end(RESOURCE_STAGE stage);
+
+    const StageResources &stage(RESOURCE_STAGE stage) const;
+    //! Least free stack of any stage.
+    unsigned long stackFreeMin() const;
+    //! Least free heap of any stage.
+    unsigned long heapFreeMin() const;
+
+    //! Free stack of the calling task right now, its high-water mark on ESP32.
+    static unsigned long stackFree();
+    //! Free heap right now.
+    static unsigned long heapFree();
+    //! The least free heap since boot according to the allocator, 0 where it does not tell.
+    static unsigned long heapFreeMinEver();
+    //! The largest block that could be allocated right now, 0 where the allocator does not tell.
+    static unsigned long largestFreeBlock();
+    //! The heap calls counted since boot, all 0 without INFI_ALLOC_STATS.
+    static AllocCounters allocCounters();
+
+    //! Ends a poll cycle, for lastCycleAllocs() and cycleAllocsMax().
+    void endCycle();
+    //! Allocations of the cycle endCycle() last ended, and of the worst one since reset().
+    unsigned long lastCycleAllocs() const;
+    unsigned long cycleAllocsMax() const;
+
+    void reset();
+
+    /*! Writes the overall minima and a [stackFreeMin,heapFreeMin,stackDeepened] array for each stage that ran,
+     * e.g. {"stackFreeMin":1200,"heapFreeMin":180000,"heapFreeMinEver":176000,"resPoll":[1200,181000,5800],...}.
+     * With INFI_ALLOC_STATS the arrays go on with allocs, allocBytes and largestFreeMin, and "cycleAllocs",
+     * "cycleAllocsMax" and "largestFreeMin" are added. Meant to go up as telemetry.
+     */
+    size_t writeJson(Print &out) const;
+
+    private:
+    StageResources m_stages[NUM_RESOURCE_STAGES];
+    //! stackFree() at begin(), per stage.
+    unsigned long m_stackAtBegin[NUM_RESOURCE_STAGES];
+    //! allocCounters() at begin(), per stage.
+    unsigned long m_allocsAtBegin[NUM_RESOURCE_STAGES];
+    unsigned long m_bytesAtBegin[NUM_RESOURCE_STAGES];
+    //! allocCounters().allocs when the running cycle began.
+    unsigned long m_allocsAtCycle;
+    unsigned long m_lastCycleAllocs;
+    unsigned long m_cycleAllocsMax;
+  };
+
+  /*!
+   * Calls begin() on construction and end() when going out of scope. A NULL stats does nothing,
+   * so the probes can stay in place with the instrumentation off.
+   */
+  class InfiniResourceProbe {
+    public:
+    InfiniResourceProbe(InfiniResourceStats *stats, RESOURCE_STAGE stage);
+    ~InfiniResourceProbe();
+
+    private:
+    InfiniResourceStats *m_stats;
+    RESOURCE_STAGE m_stage;
+  };
+}
+
+#endif
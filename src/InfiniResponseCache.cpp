@@ -0,0 +1,222 @@
+#include "InfiniResponseCache.h"
+
+#if INFI_MODULE_SCHEDULER
+#include <string.h>
+
+namespace INFI {
+
+  static_assert(NUM_COMMAND_TYPES <= 32, "dependentQueries() keeps one bit per COMMAND_TYPE in an unsigned long");
+  static_assert(RESPONSE_CACHE_WAITERS <= 32, "completeWaiters() keeps one bit per waiter in an unsigned long");
+
+  //! Queries whose replies carry the settings the ^S config commands change. GS has the "setting changed" flag.
+  static const unsigned long SETTINGS_QUERIES = (1UL << QUERY_RATED_INFORMATION) | (1UL << GENERAL_STATUS) |
+    (1UL << QUERY_MAX_CHARGING_CURRENT) | (1UL << QUERY_MAX_AC_CHARGING_CURRENT);
+
+  // Params are compared as the queue stores them, trimmed to MAX_PARAMS_SZ - 1.
+  static bool sameParams(const char *stored, const char *params) {
+    return strncmp(stored, params != NULL ? params : "", MAX_PARAMS_SZ - 1) == 0;
+  }
+
+  static void copyParams(char *dest, const char *params) {
+    dest[0] = '\0';
+    if (params != NULL) {
+      strncpy(dest, params, MAX_PARAMS_SZ - 1);
+      dest[MAX_PARAMS_SZ - 1] = '\0';
+    }
+  }
+
+  InfiniResponseCache::InfiniResponseCache() :
+    m_hits(0),
+    m_coalesced(0)
+  {
+    for (BYTE i = 0; i < NUM_COMMAND_TYPES; ++i) {
+      m_maxAgeMs[i] = 0;
+    }
+    for (BYTE i = 0; i < RESPONSE_CACHE_WAITERS; ++i) {
+      m_waiters[i].used = false;
+    }
+    clear();
+  }
+
+  bool InfiniResponseCache::setMaxAge(COMMAND_TYPE commandType, unsigned long maxAgeMs) {
+    if (commandType >= NUM_COMMAND_TYPES || getActionType(commandType) != READ) {
+      return false;
+    }
+    m_maxAgeMs[commandType] = maxAgeMs;
+    if (maxAgeMs == 0) {
+      invalidate(commandType);
+    }
+    return true;
+  }
+
+  unsigned long InfiniResponseCache::maxAge(COMMAND_TYPE commandType) const {
+    return commandType < NUM_COMMAND_TYPES ? m_maxAgeMs[commandType] : 0;
+  }
+
+  int InfiniResponseCache::findSlot(COMMAND_TYPE commandType, const char *params) const {
+    for (BYTE i = 0; i < RESPONSE_CACHE_SZ; ++i) {
+      const Slot &slot = m_slots[i];
+      if (slot.used && slot.response.cmdType == commandType && sameParams(slot.params, params)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  const InfiniResponse *InfiniResponseCache::find(COMMAND_TYPE commandType, const char *params) const {
+    int i = findSlot(commandType, params);
+    return i < 0 ? NULL : &m_slots[i].response;
+  }
+
+  const InfiniResponse *InfiniResponseCache::lookup(COMMAND_TYPE commandType, const char *params, unsigned long nowMs) const {
+    int i = findSlot(commandType, params);
+    if (i < 0 || nowMs - m_slots[i].storedMs >= maxAge(commandType)) {
+      return NULL;
+    }
+    return &m_slots[i].response;
+  }
+
+  void InfiniResponseCache::store(const InfiniResponse &response, const char *params, unsigned long nowMs) {
+    if (response.error != RESP_OK || maxAge(response.cmdType) == 0) {
+      return;
+    }
+    int i = findSlot(response.cmdType, params);
+    for (BYTE s = 0; i < 0 && s < RESPONSE_CACHE_SZ; ++s) {
+      if (!m_slots[s].used) {
+        i = s;
+      }
+    }
+    if (i < 0) {
+      // Evict the reply stored longest ago, it is the closest to going stale anyway.
+      i = 0;
+      for (BYTE s = 1; s < RESPONSE_CACHE_SZ; ++s) {
+        if (nowMs - m_slots[s].storedMs > nowMs - m_slots[i].storedMs) {
+          i = s;
+        }
+      }
+    }
+    Slot &slot = m_slots[i];
+    slot.used = true;
+    copyParams(slot.params, params);
+    slot.storedMs = nowMs;
+    // InfiniResponse has a const member, so it cannot be assigned.
+    InfiniResponse &cached = slot.response;
+    size_t len = response.actualLen < cached.bufferSize ? response.actualLen : cached.bufferSize;
+    cached.reset();
+    memcpy(cached.val, response.val, len);
+    cached.actualLen = len;
+    cached.cmdType = response.cmdType;
+    cached.error = response.error;
+    cached.deviceId = response.deviceId;
+    cached.sentUs = response.sentUs;
+  }
+
+  void InfiniResponseCache::invalidate(COMMAND_TYPE commandType) {
+    for (BYTE i = 0; i < RESPONSE_CACHE_SZ; ++i) {
+      if (m_slots[i].response.cmdType == commandType) {
+        m_slots[i].used = false;
+      }
+    }
+  }
+
+  void InfiniResponseCache::invalidateAfterUpdate(COMMAND_TYPE updateType) {
+    unsigned long queries = dependentQueries(updateType);
+    for (BYTE i = 0; i < RESPONSE_CACHE_SZ; ++i) {
+      if (m_slots[i].used && (queries & (1UL << m_slots[i].response.cmdType)) != 0) {
+        m_slots[i].used = false;
+      }
+    }
+  }
+
+  void InfiniResponseCache::clear() {
+    for (BYTE i = 0; i < RESPONSE_CACHE_SZ; ++i) {
+      m_slots[i].used = false;
+    }
+  }
+
+  unsigned long InfiniResponseCache::dependentQueries(COMMAND_TYPE updateType) {
+    switch (updateType) {
+      case SET_ENABLE_DISABLE_STATUS:
+        return 1UL << QUERY_ENABLE_DISABLE_STATUS;
+      case SET_DATE_TIME:
+        return 1UL << CURRENT_TIME;
+      case SET_MAX_CHARGING_CURRENT:
+      case SET_MAX_AC_CHARGING_CURRENT:
+      case AC_OUT_FREQ_50:
+      case AC_OUT_FREQ_60:
+      case SET_OUTPUT_SOURCE_PRIORITY:
+      case SET_CHARGING_SOURCE_PRIORITY:
+      case SET_SOLAR_POWER_PRIORITY:
+      case SET_BATTERY_TYPE:
+        return SETTINGS_QUERIES;
+      default:
+        return 0;
+    }
+  }
+
+  unsigned long InfiniResponseCache::hits() const {
+    return m_hits;
+  }
+
+  unsigned long InfiniResponseCache::coalesced() const {
+    return m_coalesced;
+  }
+
+  bool InfiniResponseCache::addWaiter(bool ready, COMMAND_TYPE commandType, const char *params,
+                                      CommandCallback callback, void *context) {
+    for (BYTE i = 0; i < RESPONSE_CACHE_WAITERS; ++i) {
+      Waiter &waiter = m_waiters[i];
+      if (waiter.used) {
+        continue;
+      }
+      waiter.used = true;
+      waiter.ready = ready;
+      waiter.commandType = commandType;
+      copyParams(waiter.params, params);
+      waiter.callback = callback;
+      waiter.context = context;
+      if (ready) {
+        m_hits++;
+      } else {
+        m_coalesced++;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  bool InfiniResponseCache::popReady(Waiter &out) {
+    for (BYTE i = 0; i < RESPONSE_CACHE_WAITERS; ++i) {
+      if (m_waiters[i].used && m_waiters[i].ready) {
+        out = m_waiters[i];
+        m_waiters[i].used = false;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void InfiniResponseCache::completeWaiters(COMMAND_TYPE commandType, const char *params,
+                                            const InfiniResponse &response, SEND_STATUS status) {
+    // Pick the waiters first, so one a callback adds meanwhile waits for the next reply, not this one.
+    unsigned long due = 0;
+    for (BYTE i = 0; i < RESPONSE_CACHE_WAITERS; ++i) {
+      const Waiter &waiter = m_waiters[i];
+      if (waiter.used && !waiter.ready && waiter.commandType == commandType && sameParams(waiter.params, params)) {
+        due |= 1UL << i;
+      }
+    }
+    for (BYTE i = 0; i < RESPONSE_CACHE_WAITERS; ++i) {
+      if ((due & (1UL << i)) == 0) {
+        continue;
+      }
+      // Free before calling back, callbacks may enqueue again.
+      Waiter waiter = m_waiters[i];
+      m_waiters[i].used = false;
+      if (waiter.callback != NULL) {
+        waiter.callback(response, status, waiter.context);
+      }
+    }
+  }
+}
+#endif
@@ -0,0 +1,98 @@
+#ifndef INFINI_RESPONSE_CACHE_H
+#define INFINI_RESPONSE_CACHE_H
+
+#include "InfiniCommandQueue.h"
+
+// Replies kept at once. Each holds a whole InfiniResponse, so mind the RAM on AVR.
+#ifndef INFI_RESPONSE_CACHE_SZ
+#define INFI_RESPONSE_CACHE_SZ 4
+#endif
+
+// Callbacks that can wait at once, on a cached reply or on an identical query already queued.
+#ifndef INFI_RESPONSE_CACHE_WAITERS
+#define INFI_RESPONSE_CACHE_WAITERS 4
+#endif
+
+namespace INFI {
+
+  const BYTE RESPONSE_CACHE_SZ = INFI_RESPONSE_CACHE_SZ;
+  const BYTE RESPONSE_CACHE_WAITERS = INFI_RESPONSE_CACHE_WAITERS;
+
+  /*!
+   * Read-through cache of ^P replies in front of an InfiniCommandQueue, see InfiniCommandQueue::setResponseCache().
+   * A READ whose COMMAND_TYPE has a max age, and whose reply with the same params is younger than that,
+   * is answered from memory instead of the link. A READ identical to one already queued or in flight
+   * waits for that one's reply instead of being sent again, whether its type has a max age or not.
+   * A finished ^S UPDATE drops the cached replies it may have changed, see dependentQueries().
+   * Callbacks still run from the queue's loop(), never from inside enqueue().
+   * Not thread safe, it belongs to the task that runs the queue.
+   */
+  class InfiniResponseCache {
+    public:
+    InfiniResponseCache();
+
+    /*! Answers commandType from memory for maxAgeMs after its reply arrived, 0 (the default) never does.
+     * Returns false for UPDATE commands, which are never cached.
+     */
+    bool setMaxAge(COMMAND_TYPE commandType, unsigned long maxAgeMs);
+    unsigned long maxAge(COMMAND_TYPE commandType) const;
+
+    //! The reply to commandType with params if it is younger than its max age at nowMs, else NULL.
+    const InfiniResponse *lookup(COMMAND_TYPE commandType, const char *params, unsigned long nowMs) const;
+
+    //! Keeps a valid reply to a READ with a max age, replacing the oldest one if every slot is taken.
+    void store(const InfiniResponse &response, const char *params, unsigned long nowMs);
+
+    //! Drops the replies of commandType, whatever their params.
+    void invalidate(COMMAND_TYPE commandType);
+    //! Drops the replies an UPDATE of updateType may have changed.
+    void invalidateAfterUpdate(COMMAND_TYPE updateType);
+    void clear();
+
+    //! Bit i set if the reply to READ i may change once updateType was applied.
+    static unsigned long dependentQueries(COMMAND_TYPE updateType);
+
+    //! Queries answered from memory, and queries that waited on an identical one instead of being sent.
+    unsigned long hits() const;
+    unsigned long coalesced() const;
+
+    //! A callback waiting for its answer, see addWaiter().
+    struct Waiter {
+      bool used;
+      //! Set if the answer is already in the cache, else it comes with the reply to the identical query.
+      bool ready;
+      COMMAND_TYPE commandType;
+      char params[MAX_PARAMS_SZ];
+      CommandCallback callback;
+      void *context;
+    };
+
+    //! Queue side. Parks callback until the queue's loop() runs it. Returns false if every waiter is taken.
+    bool addWaiter(bool ready, COMMAND_TYPE commandType, const char *params, CommandCallback callback, void *context);
+    //! Pops a ready waiter into out. Returns false if there is none.
+    bool popReady(Waiter &out);
+    //! Runs, and frees, the waiters on the query commandType with params, with its reply.
+    void completeWaiters(COMMAND_TYPE commandType, const char *params, const InfiniResponse &response, SEND_STATUS status);
+    //! The reply to commandType with params, whatever its age, or NULL.
+    const InfiniResponse *find(COMMAND_TYPE commandType, const char *params) const;
+
+    private:
+    struct Slot {
+      bool used;
+      char params[MAX_PARAMS_SZ];
+      unsigned long storedMs;
+      InfiniResponse response;
+    };
+
+    //! Index of the slot of commandType with params, or -1.
+    int findSlot(COMMAND_TYPE commandType, const char *params) const;
+
+    unsigned long m_maxAgeMs[NUM_COMMAND_TYPES];
+    Slot m_slots[RESPONSE_CACHE_SZ];
+    Waiter m_waiters[RESPONSE_CACHE_WAITERS];
+    unsigned long m_hits;
+    unsigned long m_coalesced;
+  };
+}
+
+#endif
@@ -1,41 +1,55 @@
 #include "InfiniResponseParser.h"
+
+#if INFI_MODULE_PARSERS
+#include <stdio.h>
 #include <string.h>
-#include <time.h>
-#include "ArduinoJson.h"
+#include "InfiniCRC.h"
+#include "InfiniCivilDate.h"
+#include "InfiniClock.h"
+#include "InfiniFieldReader.h"
+#include "InfiniJsonWriter.h"
+#include "InfiniDeltaTelemetry.h"
+#include "InfiniTrace.h"
 
 namespace INFI {
   
-  InfiniResponseParser::InfiniResponseParser() {
+  InfiniResponseParser::InfiniResponseParser() :
+    generalStatus(),
+    generalStatusFixed(),
+    m_gsFields(GS_ALL_FIELDS)
+  {
+  }
+
+  void InfiniResponseParser::setGsFields(GsFieldMask fields) {
+    m_gsFields = fields & GS_ALL_FIELDS;
+  }
+
+  GsFieldMask InfiniResponseParser::gsFields() const {
+    return m_gsFields;
   }
   
   unsigned long InfiniResponseParser::fromILCurrentTimetoUnixTime(const char* in, size_t inSize) {
-    if (!checkQueryResponseBasic(in, inSize, RESP_TO_END_SZS[CURRENT_TIME])) {
+    if (!checkQueryResponseBasic(in, inSize, getCommandDescriptor(CURRENT_TIME).respToEndSz)) {
       return 0;
     }
   
-    tm tms;
-    const int S = START_OFFSET_SZ;
-    tms.tm_year = (in[S+0] - '0') * 1000 + (in[S+1] - '0') * 100 + (in[S+2] - '0') * 10 + (in[S+3] - '0') - 1900; // Years since 1900
-    tms.tm_mon = (in[S+4] - '0') * 10 + (in[S+5] - '0') - 1; // Months since Jan
-    tms.tm_mday = (in[S+6] - '0') * 10 + (in[S+7] - '0');
-    tms.tm_hour = (in[S+8] - '0') * 10 + (in[S+9] - '0');
-    tms.tm_min = (in[S+10] - '0') * 10 + (in[S+11] - '0');
-    tms.tm_sec = (in[S+12] - '0') * 10 + (in[S+13] - '0');
-    tms.tm_isdst = 0;
-    time_t t = mktime(&tms);
-  
-    sprintf(parsed, "%ld", t);
-    
+    // The inverter's local time taken as UTC, as mktime() did without a TZ, but without its locking and locale.
+    unsigned long seconds;
+    if (!InfiniClock::parseSeconds(in + START_OFFSET_SZ, seconds)) {
+      return 0;
+    }
+    const unsigned long t = seconds + UNIX_SECONDS_AT_2000;
+    formatUnsigned(t, parsed);
     return t;
   }
   
   size_t InfiniResponseParser::fromILCurrentTimeToILCurrentDay(const char* in, size_t inSize) {
-    if (!checkQueryResponseBasic(in, inSize, RESP_TO_END_SZS[CURRENT_TIME])) {
+    if (!checkQueryResponseBasic(in, inSize, getCommandDescriptor(CURRENT_TIME).respToEndSz)) {
       return 0;
     }
     
     const int S = START_OFFSET_SZ;
-    memset(parsed, '\0', MAX_RESPONSE_SZ);
+    memset(parsed, '\0', PARSED_SZ);
     for (BYTE i = 0; i < TIME_DAY_SZ; ++i) {
       parsed[i] = in[S+i];
     }
@@ -43,114 +57,515 @@ namespace INFI {
   }
   
   unsigned long InfiniResponseParser::fromInfiniGenEnergyToULong(const char* in, size_t inSize) {
-    if (!checkQueryResponseBasic(in, inSize, RESP_TO_END_SZS[GEN_ENERGY_DAY])) {
+    if (!checkQueryResponseBasic(in, inSize, getCommandDescriptor(GEN_ENERGY_DAY).respToEndSz)) {
       return 0;
     }
     
-    unsigned long energy;
-    // 5 is START_TOKEN_SZ + DATA_LENGTH_SZ,
-    // 8 is GEN_ENERGY_DAY_SZ - CRC_SZ - END_TOKEN_SZ
-    sscanf(in,"%*5s%8lu%*s",&energy);
-    return energy;
+    // 8 is GEN_ENERGY_DAY_SZ - CRC_SZ - END_TOKEN_SZ. Read like decodeEnergy(), sscanf would pull in the scanf machinery.
+    InfiniFieldReader r(in, START_OFFSET_SZ, inSize - CRC_SZ - END_TOKEN_SZ);
+    return (unsigned long)r.next(8);
   }
 
+  bool InfiniResponseParser::fromILGSToGeneralStatusFixed(const char *in, size_t inSize) {
+    if (!checkQueryResponseBasic(in, inSize, getCommandDescriptor(GENERAL_STATUS).respToEndSz)) {
+      return false;
+    }
+    if (!decodeGeneralStatus(in, inSize, generalStatusFixed)) {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    return true;
+  }
+
+#if INFI_MODULE_JSON
   size_t InfiniResponseParser::fromILGSToGeneralStatus(const char *in, size_t inSize) {
-    if (!checkQueryResponseBasic(in, inSize, RESP_TO_END_SZS[GENERAL_STATUS])) {
+    if (!fromILGSToGeneralStatusFixed(in, inSize)) {
       return -1;
     }
     
-    GeneralStatus gs;
-    // Exact size is calculated with https://arduinojson.org/v6/assistant/ with a sample json.
-    const uint16_t DOC_SZ = 812;
-    StaticJsonDocument<DOC_SZ> doc; 
-    
-    // Read the data from in into gs.
-    uint8_t settingsChanged;
-    uint8_t loadConnection;
+    toGeneralStatus(generalStatusFixed, generalStatus);
+
+    // Write the JSON straight into parsed, no JsonDocument needed.
+    InfiniBufferPrint out(parsed, PARSED_SZ);
+    if (m_gsFields != GS_ALL_FIELDS) {
+      return writeGeneralStatusFieldsJson(generalStatusFixed, m_gsFields, out);
+    }
+    return writeGeneralStatusJson(generalStatusFixed, out);
+  }
+#endif
+
+#if !INFI_GS_SSCANF
+  //! The next field if it is in fields, else it is stepped over and 0.
+  static long readGsField(InfiniFieldReader &r, GsFieldMask fields, GS_FIELD field, BYTE width) {
+    if ((fields & (1UL << field)) == 0) {
+      r.skip();
+      return 0;
+    }
+    return r.next(width);
+  }
+
+  //! value cut to a member of bits. The flags are set by a 1 only, as 0 and 1 are all the reply should send.
+  static long fitGsField(long value, BYTE bits) {
+    return bits == 1 ? value == 1 : value & ((1UL << bits) - 1);
+  }
+
+#define INFI_GS_READ(field, member, key, shortKey, width, kind, bits) \
+    gs.member = fitGsField(readGsField(r, m, field, width), bits);
+#endif
+
+  bool InfiniResponseParser::decodeGeneralStatus(const char *in, size_t inSize, GeneralStatusFixed &gs) {
+#if INFI_GS_SSCANF
+    (void)inSize;
+    // Bitfields have no address, so the single digit fields go through temporaries.
+    unsigned short w[15];
+    unsigned short b[13];
     // NOTE: Apparently sscanf is quite memory intensive. It might be better to just use indexes/loops to get the relevant data.
-    sscanf(in, "%*5s%4f,%3f,%4f,%3f,%4d,%4d,%3hhd,%3f,%3f,%3f,%3d,%3d,%3hhd,%3hhd,%3hhd,%3hhd,%4hd,%4hd,%4f,%4f,%3hhd,%3hhd,%3hhd,%3hhd,%3hhd,%3hhd,%3hhd,%3hhd%*s",
-           &(gs.gridVolt), &(gs.gridFreq), &(gs.acOutVolt), &(gs.acOutFreq), &(gs.acOutApparentPow), &(gs.acOutActivePow), 
-           &(gs.outLoadPct), &(gs.battVolt), &(gs.battVoltSCC), &(gs.battVoltSCC2), &(gs.battDischargeCurr), &(gs.battChargeCurr), &(gs.battCapacity),
-           &(gs.invHeatSinkTemp), &(gs.mppt1ChrgrTemp), &(gs.mppt2ChrgrTemp),
-           &(gs.pv1InPow), &(gs.pv2InPow), &(gs.pv1InVolt), &(gs.pv2InVolt),
-           &settingsChanged, &(gs.mppt1ChrgrStatus), &(gs.mppt2ChrgrStatus), &loadConnection, &(gs.battPowDir), &(gs.dcACPowDir), &(gs.linePowDir), &(gs.localParallelId));
-    
-    // Apply multipliers, other transforms
-    gs.gridVolt *= 0.1;
-    gs.gridFreq *= 0.1;
-    gs.acOutVolt *= 0.1;
-    gs.acOutFreq *= 0.1;
-    gs.battVolt *= 0.1;
-    gs.battVoltSCC *= 0.1;
-    gs.battVoltSCC2 *= 0.1;
-    gs.pv1InVolt *= 0.1;
-    gs.pv2InVolt *= 0.1;
-    gs.settingsChanged = (settingsChanged == 1) ? true : false;
-    gs.loadConnection = (loadConnection == 1) ? true : false;
-    
-    // Store in doc
-    doc["gridVolt"] = gs.gridVolt;
-    doc["gridFreq"] = gs.gridFreq;
-    doc["acOutVolt"] = gs.acOutVolt;
-    doc["acOutFreq"] = gs.acOutFreq;
-    doc["acOutApparentPow"] = gs.acOutApparentPow;
-    doc["acOutActivePow"] = gs.acOutActivePow;
-    doc["outLoadPct"] = gs.outLoadPct;
-    doc["battVolt"] = gs.battVolt;
-    doc["battVoltSCC"] = gs.battVoltSCC;
-    doc["battVoltSCC2"] = gs.battVoltSCC2;
-    doc["battDischargeCurr"] = gs.battDischargeCurr;
-    doc["battChargeCurr"] = gs.battChargeCurr;
-    doc["battCapacity"] = gs.battCapacity;
-    doc["invHeatSinkTemp"] = gs.invHeatSinkTemp;
-    doc["mppt1ChrgrTemp"] = gs.mppt1ChrgrTemp;
-    doc["mppt2ChrgrTemp"] = gs.mppt2ChrgrTemp;
-    doc["pv1InPow"] = gs.pv1InPow;
-    doc["pv2InPow"] = gs.pv2InPow;
-    doc["pv1InVolt"] = gs.pv1InVolt;
-    doc["pv2InVolt"] = gs.pv2InVolt;
-    doc["settingsChanged"] = settingsChanged;
-    doc["mppt1ChrgrStatus"] = gs.mppt1ChrgrStatus;
-    doc["mppt2ChrgrStatus"] = gs.mppt2ChrgrStatus;
-    doc["loadConnection"] = gs.loadConnection;
-    doc["battPowDir"] = gs.battPowDir;
-    doc["dcACPowDir"] = gs.dcACPowDir;
-    doc["linePowDir"] = gs.linePowDir;
-    doc["localParallelId"] = gs.localParallelId;
-
-    // Serialize to parsed and return the size.
-    return serializeJson(doc, parsed);
+    // The single digit fields are read as one char, so the last one cannot run on into a CRC byte that is a digit.
+    int n = sscanf(in, "%*5s%4hu,%3hu,%4hu,%3hu,%4hu,%4hu,%3hu,%3hu,%3hu,%3hu,%3hu,%3hu,%3hu,%3hu,%3hu,%3hu,%4hu,%4hu,%4hu,%4hu,%1hu,%1hu,%1hu,%1hu,%1hu,%1hu,%1hu,%1hu%*s",
+           &w[0], &w[1], &w[2], &w[3], &w[4], &w[5], &b[0], &w[6], &w[7], &w[8], &w[9], &w[10], &b[1],
+           &b[2], &b[3], &b[4], &w[11], &w[12], &w[13], &w[14],
+           &b[5], &b[6], &b[7], &b[8], &b[9], &b[10], &b[11], &b[12]);
+    gs.gridVoltDeci = w[0];
+    gs.gridFreqDeci = w[1];
+    gs.acOutVoltDeci = w[2];
+    gs.acOutFreqDeci = w[3];
+    gs.acOutApparentPow = w[4];
+    gs.acOutActivePow = w[5];
+    gs.outLoadPct = b[0];
+    gs.battVoltDeci = w[6];
+    gs.battVoltSCCDeci = w[7];
+    gs.battVoltSCC2Deci = w[8];
+    gs.battDischargeCurr = w[9];
+    gs.battChargeCurr = w[10];
+    gs.battCapacity = b[1];
+    gs.invHeatSinkTemp = b[2];
+    gs.mppt1ChrgrTemp = b[3];
+    gs.mppt2ChrgrTemp = b[4];
+    gs.pv1InPow = w[11];
+    gs.pv2InPow = w[12];
+    gs.pv1InVoltDeci = w[13];
+    gs.pv2InVoltDeci = w[14];
+    gs.settingsChanged = (b[5] == 1);
+    gs.mppt1ChrgrStatus = b[6];
+    gs.mppt2ChrgrStatus = b[7];
+    gs.loadConnection = (b[8] == 1);
+    gs.battPowDir = b[9];
+    gs.dcACPowDir = b[10];
+    gs.linePowDir = b[11];
+    gs.localParallelId = b[12];
+    return n == 28;
+#else
+    // One pass over AAAA,BBB,CCCC,...,b with the widths from the protocol manual.
+    // Fields outside m_gsFields are stepped over and left 0.
+    InfiniFieldReader r(in, START_OFFSET_SZ, inSize - CRC_SZ - END_TOKEN_SZ);
+    const GsFieldMask m = m_gsFields;
+    INFI_GS_SCHEMA(INFI_GS_READ)
+    return r.done();
+#endif
   }
-    
+
+  bool InfiniResponseParser::fromPIRIToRatedInformation(const char *in, size_t inSize, RatedInformation &out) {
+    if (!checkTypedResponse(QUERY_RATED_INFORMATION, in, inSize)) {
+      return false;
+    }
+    // AAAA,BBB,CCCC,DDD,EEE,FFFF,GGGG,HHH,III,JJJ,KKK,LLL,MMM,N,OO,PPP,Q,R,S,T,U,V,W,Z,a
+    InfiniFieldReader r(in, START_OFFSET_SZ, inSize - CRC_SZ - END_TOKEN_SZ);
+    out.acInVoltDeci = r.next(4);
+    out.acInFreqDeci = r.next(3);
+    out.acInCurrDeci = r.next(4);
+    out.acOutVoltDeci = r.next(4);
+    out.acOutFreqDeci = r.next(3);
+    out.acOutCurrDeci = r.next(4);
+    out.acOutApparentPow = r.next(4);
+    out.acOutActivePow = r.next(4);
+    out.battVoltDeci = r.next(3);
+    out.battRechargeVoltDeci = r.next(3);
+    out.battRedischargeVoltDeci = r.next(3);
+    out.battUnderVoltDeci = r.next(3);
+    out.battBulkVoltDeci = r.next(3);
+    out.battType = r.next(1);
+    out.maxACChargingCurr = r.next(2);
+    out.maxChargingCurr = r.next(3);
+    out.inVoltRange = r.next(1);
+    out.outSourcePriority = r.next(1);
+    out.chargerSourcePriority = r.next(1);
+    out.parallelMaxNum = r.next(1);
+    out.machineType = r.next(1);
+    out.topology = r.next(1);
+    out.outModel = r.next(1);
+    out.solarPowerPriority = r.next(1);
+    out.mpptString = r.next(1);
+    if (!r.done()) {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    return true;
+  }
+
+  bool InfiniResponseParser::fromFWSToFaultWarningStatus(const char *in, size_t inSize, FaultWarningStatus &out) {
+    if (!checkTypedResponse(FAULT_WARNING_STATUS, in, inSize)) {
+      return false;
+    }
+    // AA,B,C,D,E,F,G,H,I,J,K,L,M,N,O,P,Q
+    InfiniFieldReader r(in, START_OFFSET_SZ, inSize - CRC_SZ - END_TOKEN_SZ);
+    out.faultCode = r.next(2);
+    out.lineFail = (r.next(1) == 1);
+    out.outCircuitShort = (r.next(1) == 1);
+    out.invOverTemp = (r.next(1) == 1);
+    out.fanLocked = (r.next(1) == 1);
+    out.battVoltHigh = (r.next(1) == 1);
+    out.battLow = (r.next(1) == 1);
+    out.battUnder = (r.next(1) == 1);
+    out.overLoad = (r.next(1) == 1);
+    out.eepromFail = (r.next(1) == 1);
+    out.powLimit = (r.next(1) == 1);
+    out.pv1VoltHigh = (r.next(1) == 1);
+    out.pv2VoltHigh = (r.next(1) == 1);
+    out.mppt1Overload = (r.next(1) == 1);
+    out.mppt2Overload = (r.next(1) == 1);
+    out.battTooLowToChargeSCC1 = (r.next(1) == 1);
+    out.battTooLowToChargeSCC2 = (r.next(1) == 1);
+    if (!r.done()) {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    return true;
+  }
+
+  bool InfiniResponseParser::fromFLAGToEnableDisableStatus(const char *in, size_t inSize, EnableDisableStatus &out) {
+    if (!checkTypedResponse(QUERY_ENABLE_DISABLE_STATUS, in, inSize)) {
+      return false;
+    }
+    // A,B,C,D,E,F,G,H,I
+    InfiniFieldReader r(in, START_OFFSET_SZ, inSize - CRC_SZ - END_TOKEN_SZ);
+    out.buzzer = (r.next(1) == 1);
+    out.overloadBypass = (r.next(1) == 1);
+    out.lcdEscape = (r.next(1) == 1);
+    out.overloadRestart = (r.next(1) == 1);
+    out.overTempRestart = (r.next(1) == 1);
+    out.backlight = (r.next(1) == 1);
+    out.primarySourceInterruptAlarm = (r.next(1) == 1);
+    out.faultCodeRecord = (r.next(1) == 1);
+    out.gridTie = (r.next(1) == 1);
+    if (!r.done()) {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    return true;
+  }
+
+  bool InfiniResponseParser::fromDIToDefaultValues(const char *in, size_t inSize, DefaultValues &out) {
+    if (!checkTypedResponse(QUERY_DEFAULT_VALUE, in, inSize)) {
+      return false;
+    }
+    // AAAA,BBB,C,DDD,EEE,FFF,GGG,HHH,III,JJ,K,L,M,N,O,P,S,T,U,V,W,X,Y,Z
+    InfiniFieldReader r(in, START_OFFSET_SZ, inSize - CRC_SZ - END_TOKEN_SZ);
+    out.acOutVoltDeci = r.next(4);
+    out.acOutFreqDeci = r.next(3);
+    out.acInVoltRange = r.next(1);
+    out.battUnderVoltDeci = r.next(3);
+    out.battFloatVoltDeci = r.next(3);
+    out.battBulkVoltDeci = r.next(3);
+    out.battRechargeVoltDeci = r.next(3);
+    out.battRedischargeVoltDeci = r.next(3);
+    out.maxChargingCurr = r.next(3);
+    out.maxACChargingCurr = r.next(2);
+    out.battType = r.next(1);
+    out.outSourcePriority = r.next(1);
+    out.chargerSourcePriority = r.next(1);
+    out.solarPowerPriority = r.next(1);
+    out.machineType = r.next(1);
+    out.outModel = r.next(1);
+    // The default FLAG switches, except grid tie which DI does not list.
+    out.flags.buzzer = (r.next(1) == 1);
+    out.flags.overloadBypass = (r.next(1) == 1);
+    out.flags.lcdEscape = (r.next(1) == 1);
+    out.flags.overloadRestart = (r.next(1) == 1);
+    out.flags.overTempRestart = (r.next(1) == 1);
+    out.flags.backlight = (r.next(1) == 1);
+    out.flags.primarySourceInterruptAlarm = (r.next(1) == 1);
+    out.flags.faultCodeRecord = (r.next(1) == 1);
+    out.flags.gridTie = false;
+    if (!r.done()) {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    return true;
+  }
+
+  bool InfiniResponseParser::fromChargingCurrentsResponse(COMMAND_TYPE commandType, const char *in, size_t inSize, ChargingCurrents &out) {
+    if (commandType != QUERY_MAX_CHARGING_CURRENT && commandType != QUERY_MAX_AC_CHARGING_CURRENT) {
+      result.setError(RESP_BAD_LENGTH);
+      return false;
+    }
+    if (!checkTypedResponse(commandType, in, inSize)) {
+      return false;
+    }
+    // AAA,BBB,... one 3 digit current per field.
+    InfiniFieldReader r(in, START_OFFSET_SZ, inSize - CRC_SZ - END_TOKEN_SZ);
+    out.count = 0;
+    while (out.count < MAX_CHARGING_CURRENTS_SZ && !r.done()) {
+      out.values[out.count] = r.next(3);
+      if (!r.ok()) {
+        break;
+      }
+      out.count++;
+    }
+    if (!r.done()) {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    return true;
+  }
+
+  bool InfiniResponseParser::fromPIToDeviceInfo(const char *in, size_t inSize, DeviceInfo &out) {
+    if (!checkTypedResponse(QUERY_PROTOCOL_ID, in, inSize)) {
+      return false;
+    }
+    // AA
+    InfiniFieldReader r(in, START_OFFSET_SZ, inSize - CRC_SZ - END_TOKEN_SZ);
+    BYTE protocolId = r.next(2);
+    if (!r.done()) {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    out.protocolId = protocolId;
+    return true;
+  }
+
+  bool InfiniResponseParser::fromIDToDeviceInfo(const char *in, size_t inSize, DeviceInfo &out) {
+    if (!checkTypedResponse(QUERY_SERIES_NUMBER, in, inSize)) {
+      return false;
+    }
+    // AABBBBBBBBBBBBBBBBBBBB, AA is how many of the B chars are valid. They are not a number, so no field reader.
+    const char *digits = in + START_OFFSET_SZ;
+    if (digits[0] < '0' || digits[0] > '9' || digits[1] < '0' || digits[1] > '9') {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    BYTE len = (digits[0] - '0') * 10 + (digits[1] - '0');
+    if (len > SERIES_NUMBER_SZ) {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    memcpy(out.seriesNumber, digits + 2, len);
+    out.seriesNumber[len] = '\0';
+    return true;
+  }
+
+  bool InfiniResponseParser::fromVFWToDeviceInfo(const char *in, size_t inSize, DeviceInfo &out) {
+    if (!checkTypedResponse(QUERY_CPU_VERSION, in, inSize)) {
+      return false;
+    }
+    // AAAAA,BBBBB,CCCCC
+    InfiniFieldReader r(in, START_OFFSET_SZ, inSize - CRC_SZ - END_TOKEN_SZ);
+    unsigned long main = r.next(5);
+    unsigned long slave1 = r.next(5);
+    unsigned long slave2 = r.next(5);
+    if (!r.done()) {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    out.mainCpuVersion = main;
+    out.slave1CpuVersion = slave1;
+    out.slave2CpuVersion = slave2;
+    return true;
+  }
+
+  bool InfiniResponseParser::fromMODToWorkingMode(const char *in, size_t inSize, BYTE &mode) {
+    if (!checkTypedResponse(QUERY_WORKING_MODE, in, inSize)) {
+      return false;
+    }
+    // AA
+    InfiniFieldReader r(in, START_OFFSET_SZ, inSize - CRC_SZ - END_TOKEN_SZ);
+    long value = r.next(2);
+    if (!r.done() || value < 0 || value >= NUM_WORKING_MODES) {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    mode = (BYTE)value;
+    return true;
+  }
+
+  static_assert(SET_DATE_TIME + 1 == NUM_COMMAND_TYPES, "DECODERS needs a row for the new COMMAND_TYPE");
+
+  const InfiniResponseParser::ResponseDecoder InfiniResponseParser::DECODERS[NUM_COMMAND_TYPES] = {
+    &InfiniResponseParser::decodeTime,      // CURRENT_TIME
+    &InfiniResponseParser::decodeEnergy,    // TOTAL_GEN_ENERGY
+    &InfiniResponseParser::decodeEnergy,    // GEN_ENERGY_YEAR
+    &InfiniResponseParser::decodeEnergy,    // GEN_ENERGY_MONTH
+    &InfiniResponseParser::decodeEnergy,    // GEN_ENERGY_DAY
+    &InfiniResponseParser::decodeGs,        // GENERAL_STATUS
+    &InfiniResponseParser::decodePiri,      // QUERY_RATED_INFORMATION
+    &InfiniResponseParser::decodeFws,       // FAULT_WARNING_STATUS
+    &InfiniResponseParser::decodeFlag,      // QUERY_ENABLE_DISABLE_STATUS
+    &InfiniResponseParser::decodeDi,        // QUERY_DEFAULT_VALUE
+    &InfiniResponseParser::decodeCurrents,  // QUERY_MAX_CHARGING_CURRENT
+    &InfiniResponseParser::decodeCurrents,  // QUERY_MAX_AC_CHARGING_CURRENT
+    &InfiniResponseParser::decodePi,        // QUERY_PROTOCOL_ID
+    &InfiniResponseParser::decodeId,        // QUERY_SERIES_NUMBER
+    &InfiniResponseParser::decodeVfw,       // QUERY_CPU_VERSION
+    &InfiniResponseParser::decodeMod,       // QUERY_WORKING_MODE
+    &InfiniResponseParser::decodeAck,       // SET_ENABLE_DISABLE_STATUS
+    &InfiniResponseParser::decodeAck,       // SET_MAX_CHARGING_CURRENT
+    &InfiniResponseParser::decodeAck,       // SET_MAX_AC_CHARGING_CURRENT
+    &InfiniResponseParser::decodeAck,       // AC_OUT_FREQ_50
+    &InfiniResponseParser::decodeAck,       // AC_OUT_FREQ_60
+    &InfiniResponseParser::decodeAck,       // SET_OUTPUT_SOURCE_PRIORITY
+    &InfiniResponseParser::decodeAck,       // SET_CHARGING_SOURCE_PRIORITY
+    &InfiniResponseParser::decodeAck,       // SET_SOLAR_POWER_PRIORITY
+    &InfiniResponseParser::decodeAck,       // SET_BATTERY_TYPE
+    &InfiniResponseParser::decodeAck        // SET_DATE_TIME
+  };
+
+  bool InfiniResponseParser::decode(const InfiniResponse &response, InfiniDecoded &out) {
+    if (response.cmdType >= NUM_COMMAND_TYPES) {
+      result.setError(RESP_BAD_LENGTH);
+      return false;
+    }
+    out.cmdType = response.cmdType;
+    INFI_TRACE_SCOPE(TRACE_PARSE, response.cmdType);
+    return (this->*DECODERS[response.cmdType])(response.val, response.actualLen, out);
+  }
+
+  bool InfiniResponseParser::decodeTime(const char *in, size_t inSize, InfiniDecoded &out) {
+    if (!checkTypedResponse(CURRENT_TIME, in, inSize)) {
+      return false;
+    }
+    out.unixTime = fromILCurrentTimetoUnixTime(in, inSize);
+    return true;
+  }
+
+  bool InfiniResponseParser::decodeEnergy(const char *in, size_t inSize, InfiniDecoded &out) {
+    if (!checkTypedResponse(out.cmdType, in, inSize)) {
+      return false;
+    }
+    // NNNNNNNN
+    InfiniFieldReader r(in, START_OFFSET_SZ, inSize - CRC_SZ - END_TOKEN_SZ);
+    long energy = r.next(8);
+    if (!r.done()) {
+      result.setError(RESP_BAD_FIELD);
+      return false;
+    }
+    out.energy = (unsigned long)energy;
+    return true;
+  }
+
+  bool InfiniResponseParser::decodeGs(const char *in, size_t inSize, InfiniDecoded &out) {
+    if (!fromILGSToGeneralStatusFixed(in, inSize)) {
+      if (!result.hasError) {
+        result.setError(RESP_BAD_LENGTH);
+      }
+      return false;
+    }
+    out.gs = generalStatusFixed;
+    return true;
+  }
+
+  bool InfiniResponseParser::decodePiri(const char *in, size_t inSize, InfiniDecoded &out) {
+    return fromPIRIToRatedInformation(in, inSize, out.piri);
+  }
+
+  bool InfiniResponseParser::decodeFws(const char *in, size_t inSize, InfiniDecoded &out) {
+    return fromFWSToFaultWarningStatus(in, inSize, out.fws);
+  }
+
+  bool InfiniResponseParser::decodeFlag(const char *in, size_t inSize, InfiniDecoded &out) {
+    return fromFLAGToEnableDisableStatus(in, inSize, out.flag);
+  }
+
+  bool InfiniResponseParser::decodeDi(const char *in, size_t inSize, InfiniDecoded &out) {
+    return fromDIToDefaultValues(in, inSize, out.di);
+  }
+
+  bool InfiniResponseParser::decodeCurrents(const char *in, size_t inSize, InfiniDecoded &out) {
+    return fromChargingCurrentsResponse(out.cmdType, in, inSize, out.currents);
+  }
+
+  bool InfiniResponseParser::decodePi(const char *in, size_t inSize, InfiniDecoded &out) {
+    memset(&out.info, 0, sizeof(out.info));
+    return fromPIToDeviceInfo(in, inSize, out.info);
+  }
+
+  bool InfiniResponseParser::decodeId(const char *in, size_t inSize, InfiniDecoded &out) {
+    memset(&out.info, 0, sizeof(out.info));
+    return fromIDToDeviceInfo(in, inSize, out.info);
+  }
+
+  bool InfiniResponseParser::decodeVfw(const char *in, size_t inSize, InfiniDecoded &out) {
+    memset(&out.info, 0, sizeof(out.info));
+    return fromVFWToDeviceInfo(in, inSize, out.info);
+  }
+
+  bool InfiniResponseParser::decodeMod(const char *in, size_t inSize, InfiniDecoded &out) {
+    return fromMODToWorkingMode(in, inSize, out.workingMode);
+  }
+
+  bool InfiniResponseParser::decodeAck(const char *in, size_t inSize, InfiniDecoded &) {
+    // ^1<CRC><cr> or ^0<CRC><cr>, as in parseUpdateResponse().
+    result.setError(RESP_OK);
+    if (inSize != START_TOKEN_SZ + CRC_SZ + END_TOKEN_SZ) {
+      result.setError(RESP_BAD_LENGTH);
+    } else if (in[0] != '^' || (in[1] != '1' && in[1] != '0')) {
+      result.setError(RESP_BAD_START);
+    } else if (!checkCrc(in, inSize)) {
+      result.setError(RESP_BAD_CRC);
+    } else if (in[1] == '0') {
+      result.setError(RESP_NAK);
+    }
+    return !result.hasError;
+  }
+
+  void InfiniResponseParser::parseResponse(InfiniResponse &response) {
+    INFI_TRACE_SCOPE(TRACE_PARSE, response.cmdType);
+    if (getActionType(response.cmdType) == UPDATE) {
+      parseUpdateResponse(response.cmdType, response);
+    } else {
+      parseQueryResponse(response.cmdType, response);
+    }
+  }
+
   void InfiniResponseParser::parseQueryResponse(COMMAND_TYPE commandType, InfiniResponse &response) {
+    result.setError(RESP_OK);
     // The response start with ^Dxxx, where xxx is the response to <cr> length.
-    if (response.actualLen != START_OFFSET_SZ + RESP_TO_END_SZS[commandType]) {
-      result.hasError = true;
-      strcpy(result.error, 
-             "The response to be parsed did not have the expected length.");
+    if (response.actualLen != getResponseSize(commandType)) {
+      result.setError(RESP_BAD_LENGTH);
       return;
     }
     if (!checkStartTokenD(response.val)) {
-      result.hasError = true;
-      strcpy(result.error, "The query response did not begin with ^D.");
+      result.setError(RESP_BAD_START);
+      return;
+    }
+    if (!checkDigits(response.val, getCommandDescriptor(commandType).respToEndSz)) {
+      result.setError(RESP_BAD_LENGTH);
       return;
     }
-    if (!checkDigits(response.val, RESP_TO_END_SZS[commandType])) {
-      result.hasError = true;
-      strcpy(result.error, 
-             "The query response does not have the expected length.");
+    if (!checkCrc(response.val, response.actualLen)) {
+      result.setError(RESP_BAD_CRC);
       return;
     }
+    result.payload = response.val + START_OFFSET_SZ;
+    result.payloadLen = response.actualLen - START_OFFSET_SZ - CRC_SZ - END_TOKEN_SZ;
   }
 
   void InfiniResponseParser::parseUpdateResponse(COMMAND_TYPE commandType, InfiniResponse &response) {
+    result.setError(RESP_OK);
     // In this case the response is simple ^1<CRC><cr> or ^0<CRC><cr>.
     if (response.actualLen != START_TOKEN_SZ + CRC_SZ + END_TOKEN_SZ) {
-      result.hasError = true;
-      strcpy(result.error,
-             "The response to be parsed did not have the expected length.");
+      result.setError(RESP_BAD_LENGTH);
+      return;
+    }
+    if (response.val[0] != '^' || (response.val[1] != '1' && response.val[1] != '0')) {
+      result.setError(RESP_BAD_START);
       return;
     }
+    if (!checkCrc(response.val, response.actualLen)) {
+      result.setError(RESP_BAD_CRC);
+      return;
+    }
+    if (response.val[1] == '0') {
+      result.setError(RESP_NAK);
+    }
   }
   
   //private
@@ -174,10 +589,36 @@ namespace INFI {
     return true;
   }
 
+  bool InfiniResponseParser::checkCrc(const char* in, size_t inSize) {
+    if (inSize < START_TOKEN_SZ + CRC_SZ + END_TOKEN_SZ) {
+      return false;
+    }
+    // The CRC covers everything before itself, the two bytes before the '\r'.
+    const size_t crcPos = inSize - CRC_SZ - END_TOKEN_SZ;
+    WORD received = ((WORD)(BYTE)in[crcPos] << 8) | (BYTE)in[crcPos + 1];
+    return received == calc_crc_half((const BYTE*)in, (BYTE)crcPos);
+  }
+
+  bool InfiniResponseParser::checkTypedResponse(COMMAND_TYPE commandType, const char *in, size_t inSize) {
+    result.setError(RESP_OK);
+    if (inSize != getResponseSize(commandType)) {
+      result.setError(RESP_BAD_LENGTH);
+    } else if (!checkStartTokenD(in)) {
+      result.setError(RESP_BAD_START);
+    } else if (!checkDigits(in, getCommandDescriptor(commandType).respToEndSz)) {
+      result.setError(RESP_BAD_LENGTH);
+    } else if (!checkCrc(in, inSize)) {
+      result.setError(RESP_BAD_CRC);
+    }
+    return !result.hasError;
+  }
+
   bool InfiniResponseParser::checkQueryResponseBasic(const char* in, size_t inSize, BYTE commandSz) {
-    if (inSize != getFullSizeFromCommandSize(commandSz, false) || !checkStartTokenD(in) || !checkDigits(in, commandSz)) {
+    if (inSize != getFullSizeFromCommandSize(commandSz, false) || !checkStartTokenD(in) || !checkDigits(in, commandSz)
+        || !checkCrc(in, inSize)) {
       return false;
     }
     return true;
   }
 }
+#endif
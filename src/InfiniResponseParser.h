@@ -5,22 +5,89 @@
 #include "InfiniMessageTypes.h"
 #include "InfiniDataTypes.h"
 
+/*
+ * Set to 1 to decode GS replies with sscanf, e.g. to compare against the field reader.
+ * It pulls in the scanf machinery, which is slow and large on AVR.
+ */
+#ifndef INFI_GS_SSCANF
+#define INFI_GS_SSCANF 0
+#endif
+
+// Size of parsed. The GS JSON written by fromILGSToGeneralStatus() is at most 533 chars,
+// builds that never call it can make this much smaller. Without the JSON encoders it only
+// holds the time and the day.
+#ifndef INFI_PARSED_SZ
+#if INFI_MODULE_JSON
+#define INFI_PARSED_SZ 544
+#else
+#define INFI_PARSED_SZ 16
+#endif
+#endif
+
 namespace INFI {
+
+  const size_t PARSED_SZ = INFI_PARSED_SZ;
   
   class InfiniResponseParser {
     public:
-    char parsed[MAX_RESPONSE_SZ] = {'\r'};
+    char parsed[PARSED_SZ] = {'\r'};
     
     //! The publicly available ParseResult object.
     InfiniParseResult result;
+
+    //! The GeneralStatus decoded by the last successful fromILGSToGeneralStatus().
+    GeneralStatus generalStatus;
+
+    //! The GeneralStatusFixed decoded by the last successful fromILGSToGeneralStatusFixed() or fromILGSToGeneralStatus().
+    GeneralStatusFixed generalStatusFixed;
   
     InfiniResponseParser();
     
+    //! The T reply as Unix seconds, its local time taken as UTC, also written to parsed. 0 if it is no valid time.
     unsigned long fromILCurrentTimetoUnixTime(const char* in, size_t inSize);
     size_t fromILCurrentTimeToILCurrentDay(const char* in, size_t inSize);
     unsigned long fromInfiniGenEnergyToULong(const char* in, size_t inSize);
+    /*! Decodes only the GS fields in the mask, the others are stepped over and left 0. All of them by default.
+     * fromILGSToGeneralStatus() then only serializes those fields as well. With INFI_GS_SSCANF every field is decoded.
+     */
+    void setGsFields(GsFieldMask fields);
+    GsFieldMask gsFields() const;
+
+    //! Decodes a GS reply into generalStatusFixed with integer math only. False with result's error set if rejected.
+    bool fromILGSToGeneralStatusFixed(const char *in, size_t inSize);
+
+#if INFI_MODULE_JSON
+    /*! Decodes a GS reply into generalStatusFixed and generalStatus, and serializes it as JSON into parsed.
+     * Returns the JSON size, or -1 with result's error set if the reply was rejected.
+     */
     size_t fromILGSToGeneralStatus(const char *in, size_t inSize);
+#endif
     
+    /*! Typed decoders for the config type queries, the same way GS is decoded: integer math, no allocation.
+     * Each checks the reply first and returns false with result's error set if it was rejected,
+     * out is only meaningful when they return true.
+     */
+    bool fromPIRIToRatedInformation(const char *in, size_t inSize, RatedInformation &out);
+    bool fromFWSToFaultWarningStatus(const char *in, size_t inSize, FaultWarningStatus &out);
+    bool fromFLAGToEnableDisableStatus(const char *in, size_t inSize, EnableDisableStatus &out);
+    bool fromDIToDefaultValues(const char *in, size_t inSize, DefaultValues &out);
+    //! Decodes a MCHGCR or MUCHGCR reply, commandType says which.
+    bool fromChargingCurrentsResponse(COMMAND_TYPE commandType, const char *in, size_t inSize, ChargingCurrents &out);
+    //! Decode PI, ID and VFW into their fields of out, leaving the others as they are.
+    bool fromPIToDeviceInfo(const char *in, size_t inSize, DeviceInfo &out);
+    bool fromIDToDeviceInfo(const char *in, size_t inSize, DeviceInfo &out);
+    bool fromVFWToDeviceInfo(const char *in, size_t inSize, DeviceInfo &out);
+    //! Decodes a MOD reply, mode is one of WORKING_MODE.
+    bool fromMODToWorkingMode(const char *in, size_t inSize, BYTE &mode);
+
+    /*! Decodes a reply of any command into out with the decoder of response.cmdType, found in one table lookup.
+     * False with result's error set if it was rejected, for an UPDATE also if it was answered ^0.
+     * A GS reply is decoded with the gsFields() mask and also lands in generalStatusFixed.
+     */
+    bool decode(const InfiniResponse &response, InfiniDecoded &out);
+
+    //! Checks response against the command table row for response.cmdType, the result goes to result.
+    void parseResponse(InfiniResponse &response);
     void parseQueryResponse(COMMAND_TYPE commandType, InfiniResponse &response);
     void parseUpdateResponse(COMMAND_TYPE commandType, InfiniResponse &response);
   
@@ -28,7 +95,34 @@ namespace INFI {
     bool checkStartTokenD(const char* in);
     bool checkDigits(const char* in, BYTE correctDigits);
     bool checkArraysEqual(const char* a1, const char* a2, BYTE startPos1, BYTE startPos2, BYTE numElems);
+    //! Checks the two CRC bytes before the trailing '\r' against the rest of the frame.
+    bool checkCrc(const char* in, size_t inSize);
     bool checkQueryResponseBasic(const char* in, size_t inSize, BYTE commandSz);
+    //! Checks a reply to commandType, then sets result's error if it was rejected.
+    bool checkTypedResponse(COMMAND_TYPE commandType, const char *in, size_t inSize);
+    //! Decodes the GS payload of a checked reply into gs, false if a field was malformed.
+    bool decodeGeneralStatus(const char *in, size_t inSize, GeneralStatusFixed &gs);
+
+    //! The decode() entry of one command. out.cmdType is already set.
+    typedef bool (InfiniResponseParser::*ResponseDecoder)(const char *in, size_t inSize, InfiniDecoded &out);
+    //! The decoders, indexed by COMMAND_TYPE like COMMAND_DESCRIPTORS.
+    static const ResponseDecoder DECODERS[NUM_COMMAND_TYPES];
+
+    bool decodeTime(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodeEnergy(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodeGs(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodePiri(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodeFws(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodeFlag(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodeDi(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodeCurrents(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodePi(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodeId(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodeVfw(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodeMod(const char *in, size_t inSize, InfiniDecoded &out);
+    bool decodeAck(const char *in, size_t inSize, InfiniDecoded &out);
+
+    GsFieldMask m_gsFields;
   };
 }
 #endif
@@ -0,0 +1,146 @@
+#include "InfiniResponsePool.h"
+
+namespace INFI {
+
+  //! Marks used taken and returns true if it was free. Handles may be released from another task on ESP32.
+  static bool claim(volatile BYTE &used) {
+#if defined(ARDUINO_ARCH_ESP32)
+    return __atomic_exchange_n(&used, (BYTE)1, __ATOMIC_ACQ_REL) == 0;
+#else
+    if (used != 0) {
+      return false;
+    }
+    used = 1;
+    return true;
+#endif
+  }
+
+  static void unclaim(volatile BYTE &used) {
+#if defined(ARDUINO_ARCH_ESP32)
+    __atomic_store_n(&used, (BYTE)0, __ATOMIC_RELEASE);
+#else
+    used = 0;
+#endif
+  }
+
+  ResponseHandle::ResponseHandle() :
+    m_pool(NULL),
+    m_slot(RESPONSE_POOL_NONE)
+  {}
+
+  ResponseHandle::ResponseHandle(InfiniResponsePool *pool, BYTE slot) :
+    m_pool(pool),
+    m_slot(slot)
+  {}
+
+  ResponseHandle::ResponseHandle(ResponseHandle &&other) :
+    m_pool(other.m_pool),
+    m_slot(other.m_slot)
+  {
+    other.m_pool = NULL;
+    other.m_slot = RESPONSE_POOL_NONE;
+  }
+
+  ResponseHandle &ResponseHandle::operator=(ResponseHandle &&other) {
+    if (this != &other) {
+      release();
+      m_pool = other.m_pool;
+      m_slot = other.m_slot;
+      other.m_pool = NULL;
+      other.m_slot = RESPONSE_POOL_NONE;
+    }
+    return *this;
+  }
+
+  ResponseHandle::~ResponseHandle() {
+    release();
+  }
+
+  ResponseHandle::operator bool() const {
+    return m_pool != NULL;
+  }
+
+  InfiniResponse &ResponseHandle::operator*() const {
+    return m_pool->m_responses[m_slot];
+  }
+
+  InfiniResponse *ResponseHandle::operator->() const {
+    return &m_pool->m_responses[m_slot];
+  }
+
+  void ResponseHandle::release() {
+    if (m_pool != NULL) {
+      m_pool->release(m_slot);
+    }
+    m_pool = NULL;
+    m_slot = RESPONSE_POOL_NONE;
+  }
+
+  BYTE ResponseHandle::detach() {
+    BYTE slot = m_slot;
+    m_pool = NULL;
+    m_slot = RESPONSE_POOL_NONE;
+    return slot;
+  }
+
+  InfiniResponsePool::InfiniResponsePool() :
+    m_exhausted(0)
+  {
+    for (BYTE i = 0; i < RESPONSE_POOL_SZ; ++i) {
+      m_used[i] = 0;
+    }
+  }
+
+  ResponseHandle InfiniResponsePool::acquire() {
+    for (BYTE i = 0; i < RESPONSE_POOL_SZ; ++i) {
+      if (claim(m_used[i])) {
+        InfiniResponse &response = m_responses[i];
+        response.reset();
+        response.error = RESP_OK;
+        response.deviceId = 0;
+        response.sentUs = 0;
+        return ResponseHandle(this, i);
+      }
+    }
+    m_exhausted++;
+    return ResponseHandle();
+  }
+
+  ResponseHandle InfiniResponsePool::acquire(const InfiniResponse &response) {
+    ResponseHandle handle = acquire();
+    if (handle) {
+      InfiniResponse &copy = *handle;
+      size_t len = response.actualLen < copy.bufferSize ? response.actualLen : copy.bufferSize;
+      memcpy(copy.val, response.val, len);
+      copy.actualLen = len;
+      copy.cmdType = response.cmdType;
+      copy.error = response.error;
+      copy.deviceId = response.deviceId;
+      copy.sentUs = response.sentUs;
+    }
+    return handle;
+  }
+
+  ResponseHandle InfiniResponsePool::adopt(BYTE slot) {
+    if (slot >= RESPONSE_POOL_SZ) {
+      return ResponseHandle();
+    }
+    return ResponseHandle(this, slot);
+  }
+
+  BYTE InfiniResponsePool::used() const {
+    BYTE count = 0;
+    for (BYTE i = 0; i < RESPONSE_POOL_SZ; ++i) {
+      count += m_used[i] != 0;
+    }
+    return count;
+  }
+
+  unsigned long InfiniResponsePool::exhausted() const {
+    return m_exhausted;
+  }
+
+  void InfiniResponsePool::release(BYTE slot) {
+    unclaim(m_used[slot]);
+  }
+}
@@ -0,0 +1,90 @@
+#ifndef INFINI_RESPONSE_POOL_H
+#define INFINI_RESPONSE_POOL_H
+
+#include "InfiniMessageTypes.h"
+
+// Frame buffers one pool holds. Each is a whole InfiniResponse, so mind the RAM on AVR.
+#ifndef INFI_RESPONSE_POOL_SZ
+#define INFI_RESPONSE_POOL_SZ 8
+#endif
+
+namespace INFI {
+
+  const BYTE RESPONSE_POOL_SZ = INFI_RESPONSE_POOL_SZ;
+
+  //! The slot of a response that was detach()ed from its handle, e.g. to go through a FreeRTOS queue.
+  const BYTE RESPONSE_POOL_NONE = 0xFF;
+
+  class InfiniResponsePool;
+
+  /*!
+   * Owns one response of an InfiniResponsePool until it is destroyed or release()d, then the buffer is free again.
+   * It can only be moved, never copied, so a frame handed from stage to stage always has exactly one owner
+   * and is never copied after it was received.
+   */
+  class ResponseHandle {
+    public:
+    ResponseHandle();
+    ResponseHandle(ResponseHandle &&other);
+    ResponseHandle &operator=(ResponseHandle &&other);
+    ResponseHandle(const ResponseHandle &) = delete;
+    ResponseHandle &operator=(const ResponseHandle &) = delete;
+    ~ResponseHandle();
+
+    //! Whether the handle owns a response.
+    explicit operator bool() const;
+    InfiniResponse &operator*() const;
+    InfiniResponse *operator->() const;
+
+    //! Gives the response back to the pool now, the handle is empty afterwards.
+    void release();
+
+    /*! Gives up ownership without freeing the buffer and returns its slot, for InfiniResponsePool::adopt().
+     * Meant for passing the response through something that copies bytes, like a FreeRTOS queue.
+     */
+    BYTE detach();
+
+    private:
+    friend class InfiniResponsePool;
+    ResponseHandle(InfiniResponsePool *pool, BYTE slot);
+
+    InfiniResponsePool *m_pool;
+    BYTE m_slot;
+  };
+
+  /*!
+   * RESPONSE_POOL_SZ response buffers that are handed out by ResponseHandle, so the memory of the frames
+   * in flight between the link and the sinks is fixed at compile time. A buffer is taken once for a received
+   * frame and moves with its handle through parsing, encoding and the sinks, until the last owner drops it.
+   * acquire() and the release of a handle may run in different tasks on ESP32.
+   */
+  class InfiniResponsePool {
+    public:
+    InfiniResponsePool();
+
+    //! A free, reset response buffer. The handle is empty if every buffer is owned, see exhausted().
+    ResponseHandle acquire();
+
+    //! A free buffer holding a copy of response, which is only copied up to its actualLen.
+    ResponseHandle acquire(const InfiniResponse &response);
+
+    //! Takes back ownership of a slot ResponseHandle::detach() returned.
+    ResponseHandle adopt(BYTE slot);
+
+    //! Buffers owned right now.
+    BYTE used() const;
+
+    //! acquire() calls that found every buffer owned.
+    unsigned long exhausted() const;
+
+    private:
+    friend class ResponseHandle;
+    void release(BYTE slot);
+
+    InfiniResponse m_responses[RESPONSE_POOL_SZ];
+    volatile BYTE m_used[RESPONSE_POOL_SZ];
+    volatile unsigned long m_exhausted;
+  };
+}
+
+#endif
@@ -0,0 +1,307 @@
+#include "InfiniRollup.h"
+
+#if INFI_MODULE_STATS
+#include <string.h>
+
+#if INFI_ENABLE_PSRAM
+#include <esp_heap_caps.h>
+#endif
+
+namespace INFI {
+
+  static const uint64_t MS_PER_MINUTE = 60000ULL;
+  static const uint64_t MS_PER_HOUR = 3600000ULL;
+
+  static const char *const TIER_SUFFIXES[NUM_ROLLUP_TIERS] = { "1m", "1h" };
+
+  //! Wh to the 0.1 Wh a JSON_DECI field takes.
+  static long deciWh(float wh) {
+    return wh < 0 ? 0 : (long)(wh * 10 + 0.5f);
+  }
+
+  // key is a flash key of getGeneralStatusFieldKey().
+  static size_t writeAggregate(Print &out, const char *key, const char *stat, const char *suffix, long value,
+                               JSON_FIELD_KIND kind, bool first) {
+    char aggregateKey[32];
+    INFI_STRNCPY_P(aggregateKey, key, sizeof(aggregateKey) - 8);
+    aggregateKey[sizeof(aggregateKey) - 8] = '\0';
+    strcat(aggregateKey, stat);
+    strcat(aggregateKey, suffix);
+    return writeJsonField(out, aggregateKey, value, kind, first);
+  }
+
+  InfiniRollup::InfiniRollup() :
+    m_tracked(0),
+    m_hasLast(false),
+    m_lastMs(0),
+    m_lastChargeW(0),
+    m_lastDischargeW(0),
+    m_lastPvW(0),
+    m_lastLoadW(0)
+  {
+    GsRollup *internal[NUM_ROLLUP_TIERS] = { m_internalMinutes, m_internalHours };
+    const unsigned long capacities[NUM_ROLLUP_TIERS] = { ROLLUP_MINUTES_SZ, ROLLUP_HOURS_SZ };
+    for (BYTE t = 0; t < NUM_ROLLUP_TIERS; ++t) {
+      Ring &ring = m_rings[t];
+      ring.items = internal[t];
+      ring.capacity = capacities[t];
+      ring.retention = capacities[t];
+      ring.head = 0;
+      ring.count = 0;
+      ring.dropped = 0;
+    }
+    memset(&m_minute, 0, sizeof(m_minute));
+    memset(&m_hour, 0, sizeof(m_hour));
+  }
+
+  InfiniRollup::~InfiniRollup() {
+#if INFI_ENABLE_PSRAM
+    if (m_rings[ROLLUP_MINUTE].items != m_internalMinutes) {
+      heap_caps_free(m_rings[ROLLUP_MINUTE].items);
+    }
+    if (m_rings[ROLLUP_HOUR].items != m_internalHours) {
+      heap_caps_free(m_rings[ROLLUP_HOUR].items);
+    }
+#endif
+  }
+
+  bool InfiniRollup::track(GS_FIELD field) {
+    if (m_tracked >= ROLLUP_FIELDS_SZ || field >= NUM_GS_FIELDS || m_hasLast) {
+      return false;
+    }
+    m_fields[m_tracked++] = field;
+    return true;
+  }
+
+  BYTE InfiniRollup::tracked() const {
+    return m_tracked;
+  }
+
+  bool InfiniRollup::allocate(ROLLUP_TIER tier, unsigned long capacity) {
+#if INFI_ENABLE_PSRAM
+    Ring &ring = m_rings[tier];
+    if (capacity <= (tier == ROLLUP_MINUTE ? ROLLUP_MINUTES_SZ : ROLLUP_HOURS_SZ)) {
+      return false;
+    }
+    // NULL when the board has no PSRAM, or not that much of it.
+    GsRollup *items = (GsRollup *)heap_caps_malloc(capacity * sizeof(GsRollup), MALLOC_CAP_SPIRAM);
+    if (items == NULL) {
+      return false;
+    }
+    if (ring.items != m_internalMinutes && ring.items != m_internalHours) {
+      heap_caps_free(ring.items);
+    }
+    ring.items = items;
+    ring.capacity = capacity;
+    ring.retention = capacity;
+    ring.head = 0;
+    ring.count = 0;
+    return true;
+#else
+    (void)tier;
+    (void)capacity;
+    return false;
+#endif
+  }
+
+  unsigned long InfiniRollup::capacity(ROLLUP_TIER tier) const {
+    return m_rings[tier].capacity;
+  }
+
+  void InfiniRollup::setRetention(ROLLUP_TIER tier, unsigned long count) {
+    Ring &ring = m_rings[tier];
+    ring.retention = count > ring.capacity ? ring.capacity : count;
+    if (ring.count > ring.retention) {
+      ring.dropped += ring.count - ring.retention;
+      pop(tier, ring.count - ring.retention);
+    }
+  }
+
+  unsigned long InfiniRollup::retention(ROLLUP_TIER tier) const {
+    return m_rings[tier].retention;
+  }
+
+  void InfiniRollup::add(const GeneralStatusFixed &gs, uint64_t tsMs) {
+    const uint64_t minuteMs = tsMs - tsMs % MS_PER_MINUTE;
+    if (m_minute.rollup.samples > 0 && minuteMs != m_minute.rollup.startMs) {
+      sealMinute();
+    }
+
+    const float battVolt = deciToFloat(gs.battVoltDeci);
+    const float chargeW = battVolt * gs.battChargeCurr;
+    const float dischargeW = battVolt * gs.battDischargeCurr;
+    const float pvW = (float)gs.pv1InPow + gs.pv2InPow;
+    const float loadW = gs.acOutActivePow;
+    // The interval counts towards the minute of the later sample, across a gap there is nothing to integrate.
+    if (m_hasLast && tsMs > m_lastMs && tsMs - m_lastMs <= GS_STATS_MAX_GAP_MS) {
+      const float hours = (float)(tsMs - m_lastMs) / MS_PER_HOUR;
+      m_minute.rollup.battChargeWh += (m_lastChargeW + chargeW) / 2 * hours;
+      m_minute.rollup.battDischargeWh += (m_lastDischargeW + dischargeW) / 2 * hours;
+      m_minute.rollup.pvWh += (m_lastPvW + pvW) / 2 * hours;
+      m_minute.rollup.loadWh += (m_lastLoadW + loadW) / 2 * hours;
+    }
+    m_hasLast = true;
+    m_lastMs = tsMs;
+    m_lastChargeW = chargeW;
+    m_lastDischargeW = dischargeW;
+    m_lastPvW = pvW;
+    m_lastLoadW = loadW;
+
+    GsRollup &minute = m_minute.rollup;
+    minute.startMs = minuteMs;
+    minute.samples++;
+    for (BYTE i = 0; i < m_tracked; ++i) {
+      const WORD value = (WORD)getGeneralStatusField(gs, m_fields[i]);
+      if (minute.samples == 1 || value < minute.fields[i].min) {
+        minute.fields[i].min = value;
+      }
+      if (minute.samples == 1 || value > minute.fields[i].max) {
+        minute.fields[i].max = value;
+      }
+      minute.fields[i].last = value;
+      m_minute.sums[i] += value;
+    }
+  }
+
+  void InfiniRollup::seal() {
+    if (m_minute.rollup.samples > 0) {
+      sealMinute();
+    }
+    if (m_hour.rollup.samples > 0) {
+      sealHour();
+    }
+  }
+
+  void InfiniRollup::sealMinute() {
+    finish(m_minute);
+    const GsRollup &minute = m_minute.rollup;
+    push(ROLLUP_MINUTE, minute);
+
+    const uint64_t hourMs = minute.startMs - minute.startMs % MS_PER_HOUR;
+    if (m_hour.rollup.samples > 0 && hourMs != m_hour.rollup.startMs) {
+      sealHour();
+    }
+    GsRollup &hour = m_hour.rollup;
+    hour.startMs = hourMs;
+    for (BYTE i = 0; i < m_tracked; ++i) {
+      if (hour.samples == 0 || minute.fields[i].min < hour.fields[i].min) {
+        hour.fields[i].min = minute.fields[i].min;
+      }
+      if (hour.samples == 0 || minute.fields[i].max > hour.fields[i].max) {
+        hour.fields[i].max = minute.fields[i].max;
+      }
+      hour.fields[i].last = minute.fields[i].last;
+      m_hour.sums[i] += m_minute.sums[i];
+    }
+    hour.samples += minute.samples;
+    hour.battChargeWh += minute.battChargeWh;
+    hour.battDischargeWh += minute.battDischargeWh;
+    hour.pvWh += minute.pvWh;
+    hour.loadWh += minute.loadWh;
+    memset(&m_minute, 0, sizeof(m_minute));
+  }
+
+  void InfiniRollup::sealHour() {
+    finish(m_hour);
+    push(ROLLUP_HOUR, m_hour.rollup);
+    memset(&m_hour, 0, sizeof(m_hour));
+  }
+
+  void InfiniRollup::finish(Open &open) {
+    for (BYTE i = 0; i < ROLLUP_FIELDS_SZ; ++i) {
+      open.rollup.fields[i].avg = open.rollup.samples > 0
+        ? (WORD)((open.sums[i] + open.rollup.samples / 2) / open.rollup.samples) : 0;
+    }
+  }
+
+  void InfiniRollup::push(ROLLUP_TIER tier, const GsRollup &rollup) {
+    Ring &ring = m_rings[tier];
+    if (ring.retention == 0) {
+      ring.dropped++;
+      return;
+    }
+    if (ring.count >= ring.retention) {
+      pop(tier, 1);
+      ring.dropped++;
+    }
+    ring.items[(ring.head + ring.count) % ring.capacity] = rollup;
+    ring.count++;
+  }
+
+  unsigned long InfiniRollup::size(ROLLUP_TIER tier) const {
+    return m_rings[tier].count;
+  }
+
+  bool InfiniRollup::isEmpty(ROLLUP_TIER tier) const {
+    return m_rings[tier].count == 0;
+  }
+
+  const GsRollup *InfiniRollup::at(ROLLUP_TIER tier, unsigned long index) const {
+    const Ring &ring = m_rings[tier];
+    return index < ring.count ? &ring.items[(ring.head + index) % ring.capacity] : NULL;
+  }
+
+  BYTE InfiniRollup::writeJson(ROLLUP_TIER tier, Print &out, size_t maxLen) const {
+    const Ring &ring = m_rings[tier];
+    // '[' and ']' always go out.
+    size_t len = 2;
+    BYTE consumed = 0;
+    bool first = true;
+    out.print('[');
+    for (; consumed < ring.count && consumed < 0xFF; ++consumed) {
+      const GsRollup &rollup = *at(tier, consumed);
+      InfiniCountingPrint counter;
+      size_t rollupLen = writeRollup(counter, rollup, TIER_SUFFIXES[tier], first);
+      if (len + rollupLen > maxLen) {
+        if (!first) {
+          break;
+        }
+        // Does not fit even on its own, so it never will. Skip it rather than wedge the ring.
+        continue;
+      }
+      len += writeRollup(out, rollup, TIER_SUFFIXES[tier], first);
+      first = false;
+    }
+    out.print(']');
+    return consumed;
+  }
+
+  void InfiniRollup::pop(ROLLUP_TIER tier, unsigned long count) {
+    Ring &ring = m_rings[tier];
+    if (count > ring.count) {
+      count = ring.count;
+    }
+    ring.head = (ring.head + count) % ring.capacity;
+    ring.count -= count;
+  }
+
+  unsigned long InfiniRollup::dropped(ROLLUP_TIER tier) const {
+    return m_rings[tier].dropped;
+  }
+
+  size_t InfiniRollup::writeRollup(Print &out, const GsRollup &rollup, const char *suffix, bool first) const {
+    size_t n = 0;
+    if (!first) {
+      n += out.print(',');
+    }
+    n += out.print(INFI_F("{\"ts\":"));
+    n += printUint64(rollup.startMs, out);
+    n += out.print(INFI_F(",\"values\":"));
+    for (BYTE i = 0; i < m_tracked; ++i) {
+      const char *key = getGeneralStatusFieldKey(m_fields[i]);
+      const JSON_FIELD_KIND kind = getGeneralStatusFieldKind(m_fields[i]);
+      n += writeAggregate(out, key, "Min", suffix, rollup.fields[i].min, kind, i == 0);
+      n += writeAggregate(out, key, "Max", suffix, rollup.fields[i].max, kind, false);
+      n += writeAggregate(out, key, "Avg", suffix, rollup.fields[i].avg, kind, false);
+      n += writeAggregate(out, key, "Last", suffix, rollup.fields[i].last, kind, false);
+    }
+    n += writeAggregate(out, INFI_PSTR("battCharge"), "Wh", suffix, deciWh(rollup.battChargeWh), JSON_DECI, m_tracked == 0);
+    n += writeAggregate(out, INFI_PSTR("battDischarge"), "Wh", suffix, deciWh(rollup.battDischargeWh), JSON_DECI, false);
+    n += writeAggregate(out, INFI_PSTR("pv"), "Wh", suffix, deciWh(rollup.pvWh), JSON_DECI, false);
+    n += writeAggregate(out, INFI_PSTR("load"), "Wh", suffix, deciWh(rollup.loadWh), JSON_DECI, false);
+    n += writeAggregate(out, INFI_PSTR("samples"), "", suffix, rollup.samples, JSON_UINT, false);
+    n += out.print(INFI_F("}}"));
+    return n;
+  }
+}
+#endif
@@ -0,0 +1,148 @@
+#ifndef INFINI_ROLLUP_H
+#define INFINI_ROLLUP_H
+
+#include <stdint.h>
+#include "InfiniGsHistory.h"
+#include "InfiniGsStats.h"
+
+// GS fields one InfiniRollup aggregates.
+#ifndef INFI_ROLLUP_FIELDS_SZ
+#define INFI_ROLLUP_FIELDS_SZ 6
+#endif
+
+// 1 minute aggregates kept in internal RAM, e.g. an hour of them.
+#ifndef INFI_ROLLUP_MINUTES_SZ
+#define INFI_ROLLUP_MINUTES_SZ 60
+#endif
+
+// 1 hour aggregates kept in internal RAM, e.g. 2 days of them.
+#ifndef INFI_ROLLUP_HOURS_SZ
+#define INFI_ROLLUP_HOURS_SZ 48
+#endif
+
+namespace INFI {
+
+  const BYTE ROLLUP_FIELDS_SZ = INFI_ROLLUP_FIELDS_SZ;
+  const WORD ROLLUP_MINUTES_SZ = INFI_ROLLUP_MINUTES_SZ;
+  const WORD ROLLUP_HOURS_SZ = INFI_ROLLUP_HOURS_SZ;
+
+  enum ROLLUP_TIER {
+    ROLLUP_MINUTE = 0,
+    ROLLUP_HOUR,
+    NUM_ROLLUP_TIERS
+  };
+
+  //! The aggregate of the samples of one minute or hour.
+  struct GsRollup {
+    //! The start of its minute or hour, ms since the Unix epoch.
+    uint64_t startMs;
+    unsigned long samples;
+    //! Per tracked field, in the units GeneralStatusFixed stores it in. avg is rounded.
+    struct {
+      WORD min;
+      WORD max;
+      WORD avg;
+      WORD last;
+    } fields[ROLLUP_FIELDS_SZ];
+    //! Trapezoidal integrals, as in GeneralStatusStats: battVolt times the charge or discharge current,
+    //! pv1InPow plus pv2InPow, and acOutActivePow.
+    float battChargeWh;
+    float battDischargeWh;
+    float pvWh;
+    float loadWh;
+  };
+
+  /*!
+   * Ages GS samples into 1 minute aggregates and those into 1 hour ones, so a long outage is still covered
+   * once the raw samples no longer fit, in InfiniGsHistory or the flash log. Each aggregate has the min, max,
+   * average and last value of every tracked field, and the energy integrals. Each tier is a ring with its
+   * own retention, the oldest aggregate makes room once it is reached. Samples are added in time order, e.g.
+   * as they are spilled to the flash log. A minute is sealed by the first sample of the next one, and folded
+   * into its hour then, an hour by the first minute of the next. writeJson() writes a tier as ThingsBoard's
+   * telemetry array, keys suffixed with the tier, battVoltAvg1m or pvWh1h, so the aggregates sit next to the
+   * raw keys on a dashboard.
+   * The tiers live in the object, allocate() swaps one for a bigger ring in PSRAM.
+   */
+  class InfiniRollup {
+    public:
+    InfiniRollup();
+    ~InfiniRollup();
+
+    //! Aggregates field. Returns false if ROLLUP_FIELDS_SZ fields are tracked already, or samples were added.
+    bool track(GS_FIELD field);
+    BYTE tracked() const;
+
+    /*! Moves tier to PSRAM with room for capacity aggregates, dropping what it held. Returns false, keeping
+     * the ring in internal RAM, without PSRAM or if it is too small.
+     */
+    bool allocate(ROLLUP_TIER tier, unsigned long capacity);
+    unsigned long capacity(ROLLUP_TIER tier) const;
+
+    //! Keeps at most count aggregates of tier, at most its capacity(), which it keeps by default.
+    void setRetention(ROLLUP_TIER tier, unsigned long count);
+    unsigned long retention(ROLLUP_TIER tier) const;
+
+    //! Adds gs taken at tsMs, ms since the Unix epoch. A sample older than the open minute seals it.
+    void add(const GeneralStatusFixed &gs, uint64_t tsMs);
+
+    //! Seals the minute and the hour still open, e.g. before what was gathered offline goes up.
+    void seal();
+
+    unsigned long size(ROLLUP_TIER tier) const;
+    bool isEmpty(ROLLUP_TIER tier) const;
+    //! Aggregate index of tier, 0 being the oldest. NULL past size().
+    const GsRollup *at(ROLLUP_TIER tier, unsigned long index) const;
+
+    /*! Writes the oldest aggregates of tier to out as a telemetry array of at most maxLen chars.
+     * Returns the number consumed, at most 255, pop() them once the array was sent.
+     * An aggregate too long for maxLen on its own is skipped.
+     */
+    BYTE writeJson(ROLLUP_TIER tier, Print &out, size_t maxLen) const;
+    //! Drops the count oldest aggregates of tier.
+    void pop(ROLLUP_TIER tier, unsigned long count);
+
+    //! Aggregates of tier that made room before they were popped.
+    unsigned long dropped(ROLLUP_TIER tier) const;
+
+    private:
+    //! A ring of a tier.
+    struct Ring {
+      GsRollup *items;
+      unsigned long capacity;
+      unsigned long retention;
+      unsigned long head;
+      unsigned long count;
+      unsigned long dropped;
+    };
+
+    //! An aggregate still being added to, with the exact sums its average comes from.
+    struct Open {
+      GsRollup rollup;
+      uint64_t sums[ROLLUP_FIELDS_SZ];
+    };
+
+    void push(ROLLUP_TIER tier, const GsRollup &rollup);
+    //! Seals the open minute into the minute tier and folds it into the open hour.
+    void sealMinute();
+    void sealHour();
+    static void finish(Open &open);
+    size_t writeRollup(Print &out, const GsRollup &rollup, const char *suffix, bool first) const;
+
+    GS_FIELD m_fields[ROLLUP_FIELDS_SZ];
+    BYTE m_tracked;
+    Ring m_rings[NUM_ROLLUP_TIERS];
+    Open m_minute;
+    Open m_hour;
+    //! The last sample, for the energy integrals.
+    bool m_hasLast;
+    uint64_t m_lastMs;
+    float m_lastChargeW;
+    float m_lastDischargeW;
+    float m_lastPvW;
+    float m_lastLoadW;
+    GsRollup m_internalMinutes[ROLLUP_MINUTES_SZ];
+    GsRollup m_internalHours[ROLLUP_HOURS_SZ];
+  };
+}
+
+#endif
@@ -0,0 +1,164 @@
+#include "InfiniRs485Bus.h"
+#include <Arduino.h>
+
+namespace INFI {
+
+  InfiniRs485Bus::InfiniRs485Bus(unsigned long guardMs) :
+    m_guardMs(guardMs),
+    m_selector(NULL),
+    m_selectorContext(NULL),
+    m_busy(false),
+    m_holder(0),
+    m_holderQueue(NULL),
+    m_lastHolder(RS485_BUS_DEVICES),
+    m_selected(false),
+    m_releasedUs(0),
+    m_waiting(0)
+  {}
+
+  void InfiniRs485Bus::setSelector(BusSelector selector, void *context) {
+    m_selector = selector;
+    m_selectorContext = context;
+    m_selected = false;
+  }
+
+  bool InfiniRs485Bus::acquire(BYTE deviceId, InfiniCommandQueue *queue, bool urgent) {
+    if (m_busy && m_holder == deviceId) {
+      return true;
+    }
+    const uint32_t bit = deviceId < RS485_BUS_DEVICES ? (uint32_t)1 << deviceId : 0;
+    const bool owedElsewhere = !urgent && deviceId == m_lastHolder && (m_waiting & ~bit) != 0;
+    const bool guarding = m_lastHolder < RS485_BUS_DEVICES && micros() - m_releasedUs < m_guardMs * 1000UL;
+    if (m_busy || owedElsewhere || guarding) {
+      m_waiting |= bit;
+      return false;
+    }
+    m_waiting &= ~bit;
+    if (m_selector != NULL && (!m_selected || deviceId != m_lastHolder)) {
+      m_selector(deviceId, m_selectorContext);
+      m_selected = true;
+    }
+    m_busy = true;
+    m_holder = deviceId;
+    m_holderQueue = queue;
+    m_lastHolder = deviceId;
+    return true;
+  }
+
+  void InfiniRs485Bus::release() {
+    if (!m_busy) {
+      return;
+    }
+    m_busy = false;
+    m_holderQueue = NULL;
+    m_releasedUs = micros();
+    if (m_waiting != 0 && m_guardMs > 0) {
+      m_guardTimer.once(m_guardMs * 1000UL);
+    }
+  }
+
+  InfiniCommandQueue *InfiniRs485Bus::holder() const {
+    return m_busy ? m_holderQueue : NULL;
+  }
+
+  bool InfiniRs485Bus::isBusy() const {
+    return m_busy;
+  }
+
+  unsigned long InfiniRs485Bus::msUntilFree() const {
+    if (m_busy) {
+      return NO_DEADLINE;
+    }
+    if (m_lastHolder >= RS485_BUS_DEVICES) {
+      return 0;
+    }
+    return msUntilElapsedUs(m_releasedUs, m_guardMs, micros());
+  }
+
+  InfiniRs485Stream::InfiniRs485Stream(Stream &uart, int dePin, unsigned long baud) :
+    m_uart(uart),
+    m_dePin(dePin),
+    m_baud(baud),
+    m_transmitting(false),
+    m_txStartUs(0),
+    m_txBytes(0)
+  {}
+
+  void InfiniRs485Stream::begin() {
+    digitalWrite(m_dePin, LOW);
+    pinMode(m_dePin, OUTPUT);
+    m_transmitting = false;
+  }
+
+  void InfiniRs485Stream::setBaud(unsigned long baud) {
+    m_baud = baud;
+  }
+
+  bool InfiniRs485Stream::isTransmitting() {
+    releaseIfSent();
+    return m_transmitting;
+  }
+
+  int InfiniRs485Stream::available() {
+    releaseIfSent();
+    return m_transmitting ? 0 : m_uart.available();
+  }
+
+  int InfiniRs485Stream::read() {
+    releaseIfSent();
+    return m_transmitting ? -1 : m_uart.read();
+  }
+
+  int InfiniRs485Stream::peek() {
+    releaseIfSent();
+    return m_transmitting ? -1 : m_uart.peek();
+  }
+
+  void InfiniRs485Stream::flush() {
+    // Waits for the FIFO on most cores, the one place where blocking is asked for.
+    m_uart.flush();
+    releaseIfSent();
+  }
+
+  size_t InfiniRs485Stream::write(uint8_t b) {
+    return write(&b, 1);
+  }
+
+  size_t InfiniRs485Stream::write(const uint8_t *buffer, size_t size) {
+    releaseIfSent();
+    if (!m_transmitting) {
+      digitalWrite(m_dePin, HIGH);
+      m_transmitting = true;
+      m_txStartUs = micros();
+      m_txBytes = 0;
+    }
+    size_t written = m_uart.write(buffer, size);
+    m_txBytes += written;
+    return written;
+  }
+
+  void InfiniRs485Stream::releaseIfSent() {
+    if (!m_transmitting) {
+      return;
+    }
+    // Rounded up per byte, which keeps the product small for any frame.
+    const unsigned long wireUs = m_txBytes * ((BITS_PER_WIRE_BYTE * 1000000UL + m_baud - 1) / m_baud);
+    if (micros() - m_txStartUs < wireUs + RS485_DE_HOLD_US) {
+      return;
+    }
+    digitalWrite(m_dePin, LOW);
+    m_transmitting = false;
+    while (m_uart.available() > 0) {
+      m_uart.read();
+    }
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  bool beginRs485(HardwareSerial &serial, unsigned long baud, int8_t rxPin, int8_t txPin, int8_t dePin) {
+    serial.begin(baud, SERIAL_8N1, rxPin, txPin);
+    // -1 leaves RX, TX and CTS where begin() put them.
+    serial.setPins(-1, -1, -1, dePin);
+    return serial.setMode(UART_MODE_RS485_HALF_DUPLEX);
+  }
+#endif
+}
@@ -0,0 +1,140 @@
+#ifndef INFINI_RS485_BUS_H
+#define INFINI_RS485_BUS_H
+
+#include <Stream.h>
+#include "InfiniCommon.h"
+#include "InfiniIdle.h"
+
+// Quiet time between a reply and the next command on the bus, milliseconds.
+// Covers the inverter's driver letting go of the pair and a converter switching units.
+#ifndef INFI_RS485_GUARD_MS
+#define INFI_RS485_GUARD_MS 5
+#endif
+
+// Extra time DE stays asserted after the last stop bit when it is timed in software, microseconds.
+#ifndef INFI_RS485_DE_HOLD_US
+#define INFI_RS485_DE_HOLD_US 200
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <HardwareSerial.h>
+#endif
+
+namespace INFI {
+
+  class InfiniCommandQueue;
+
+  const unsigned long RS485_GUARD_MS = INFI_RS485_GUARD_MS;
+  const unsigned long RS485_DE_HOLD_US = INFI_RS485_DE_HOLD_US;
+
+  //! Most devices one bus tells apart, device ids go from 0 to this - 1.
+  const BYTE RS485_BUS_DEVICES = 32;
+
+  /*! Makes deviceId the one that hears the next transaction, e.g. by switching a converter or mux to it.
+   * Called before the bus is granted to a device other than the previous one.
+   */
+  typedef void (*BusSelector)(BYTE deviceId, void *context);
+
+  /*!
+   * One half-duplex RS485 pair shared by several inverters, each with its own InfiniCommandSender and
+   * InfiniCommandQueue on the same UART. Queues given the bus through InfiniCommandQueue::setBus() only
+   * write once acquire() granted it to their sender's deviceId, and give it back when the reply is in,
+   * so transactions go out back to back with only RS485_GUARD_MS between them.
+   * The grant goes round: a device that just had the bus waits while another is asking for it.
+   * P18 frames carry no address, so the units on the pair must be told apart by the selector, e.g. by
+   * enabling one converter per unit. Use the unit's parallel id as deviceId so the replies and the
+   * "m," of the parallel addressed ^S commands name the same machine.
+   */
+  class InfiniRs485Bus {
+    public:
+    InfiniRs485Bus(unsigned long guardMs = RS485_GUARD_MS);
+
+    void setSelector(BusSelector selector, void *context = NULL);
+
+    /*! Grants the bus to deviceId if it is free, the guard time passed and no other device is owed it.
+     * Otherwise notes that deviceId waits and returns false. Granting it to the holder again is a no-op.
+     * queue is kept as the holder(). urgent skips the turn taking, for a caller that blocks until it has it.
+     */
+    bool acquire(BYTE deviceId, InfiniCommandQueue *queue = NULL, bool urgent = false);
+
+    /*! The queue given to acquire() by the device holding the bus, NULL if it is free.
+     * A caller that blocks for the bus drives it with loop(), nothing else would bring its reply in.
+     */
+    InfiniCommandQueue *holder() const;
+
+    //! Gives the bus back, the guard time starts now. Only the holder calls it.
+    void release();
+
+    bool isBusy() const;
+
+    /*! 0 if a device could acquire() now, the rest of the guard time if it just was released, rounded up,
+     * NO_DEADLINE while it is held: the holder's queue wakes the loop when its reply is in or times out.
+     * On ESP32 the end of the guard time ends idleFor() too, through an InfiniWakeTimer.
+     */
+    unsigned long msUntilFree() const;
+
+    private:
+    unsigned long m_guardMs;
+    BusSelector m_selector;
+    void *m_selectorContext;
+    bool m_busy;
+    BYTE m_holder;
+    InfiniCommandQueue *m_holderQueue;
+    //! RS485_BUS_DEVICES until the bus was first granted.
+    BYTE m_lastHolder;
+    bool m_selected;
+    //! micros() of the last release(), the guard time is kept to the microsecond.
+    unsigned long m_releasedUs;
+    //! Wakes idleFor() when the guard time is over and a device waits for the bus.
+    InfiniWakeTimer m_guardTimer;
+    //! Bit per device id that asked for the bus since it last had it.
+    uint32_t m_waiting;
+  };
+
+  /*!
+   * Drives the DE/RE pin of an RS485 transceiver around the frames written through it, for cores whose
+   * UART can't do it. DE goes high on the first byte of a frame and low once the bytes written took their
+   * wire time at baud plus RS485_DE_HOLD_US, checked whenever the stream is read, so nothing waits on the
+   * TX FIFO. Bytes echoed back while DE was high, if RE is not tied to it, are dropped.
+   * Give it to the InfiniCommandSender instead of the UART. On ESP32 prefer beginRs485(), the UART switches
+   * DE itself from its TX-done interrupt and it works with attachRxRing().
+   */
+  class InfiniRs485Stream : public Stream {
+    public:
+    InfiniRs485Stream(Stream &uart, int dePin, unsigned long baud = SERIAL_BAUD);
+
+    //! Makes the pin an output, with DE low.
+    void begin();
+    void setBaud(unsigned long baud);
+    //! Whether DE is asserted.
+    bool isTransmitting();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    private:
+    //! Drops DE once the frame is out, and what was echoed meanwhile.
+    void releaseIfSent();
+
+    Stream &m_uart;
+    int m_dePin;
+    unsigned long m_baud;
+    bool m_transmitting;
+    unsigned long m_txStartUs;
+    unsigned long m_txBytes;
+  };
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /*! Starts serial at baud on rxPin/txPin in the UART's RS485 half-duplex mode, with dePin driven as RTS.
+   * The UART asserts it for every write and drops it from the TX-done interrupt, see InfiniRs485Stream.
+   * Returns false if the core refused the mode.
+   */
+  bool beginRs485(HardwareSerial &serial, unsigned long baud, int8_t rxPin, int8_t txPin, int8_t dePin);
+#endif
+}
+
+#endif
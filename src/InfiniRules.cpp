@@ -0,0 +1,501 @@
+#include "InfiniRules.h"
+
+#if INFI_MODULE_SCHEDULER
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Preferences.h>
+#endif
+
+namespace INFI {
+
+#if defined(ARDUINO_ARCH_ESP32)
+  static const char *const RULES_KEY = "rules";
+#endif
+
+  //! The bytecode, each op a byte. OP_FIELD is followed by a GS_FIELD, OP_CONST by a little endian int32.
+  enum RULE_OP {
+    OP_END = 0,    // The rule's condition is on top of the stack.
+    OP_FIELD,
+    OP_CONST,
+    OP_WIDEN_UP,   // Adds the top to the number under it if the condition held, for < and <=.
+    OP_WIDEN_DOWN, // Subtracts it instead, for > and >=.
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_EQ,
+    OP_NE,
+    OP_AND,
+    OP_OR
+  };
+
+  //! Deepest the stack of a rule gets: the | and & so far, and a condition with hysteresis.
+  static const BYTE RULE_STACK_SZ = 5;
+
+  //! Longest GS key a rule names.
+  static const BYTE RULE_KEY_SZ = 24;
+
+  //! Seconds of @, so holdMs can not overflow.
+  static const unsigned long RULE_MAX_HOLD_S = 86400UL * 7;
+
+  //! Turns the rule text into bytecode and rules, see InfiniRules::compile().
+  class RuleCompiler {
+    public:
+    RuleCompiler(const char *source, BYTE *code, WORD codeSize) :
+      m_source(source),
+      m_pos(0),
+      m_code(code),
+      m_codeSize(codeSize),
+      m_codeLen(0),
+      m_fields(0)
+    {}
+
+    //! The operands of a rule's action, filled in by rule().
+    struct Action {
+      WORD code;
+      unsigned long holdMs;
+      COMMAND_TYPE commandType;
+      BYTE machine;
+      unsigned long value;
+      char alarm[RULES_ALARM_SZ];
+    };
+
+    //! True once only spaces and ';' are left.
+    bool atEnd() {
+      while (peek() == ';' || peek() == ' ') {
+        m_pos++;
+      }
+      return peek() == '\0';
+    }
+
+    //! Compiles the next rule. Returns false where it fails, see pos().
+    bool rule(Action &action) {
+      action.code = m_codeLen;
+      if (!expression()) {
+        return false;
+      }
+      action.holdMs = 0;
+      if (accept('@')) {
+        unsigned long seconds;
+        if (!number(seconds) || seconds > RULE_MAX_HOLD_S) {
+          return false;
+        }
+        action.holdMs = seconds * 1000;
+      }
+      if (!accept(':') || !(accept('!') ? alarm(action) : command(action)) || !emit(OP_END)) {
+        return false;
+      }
+      skipSpaces();
+      return peek() == ';' || peek() == '\0';
+    }
+
+    size_t pos() const {
+      return m_pos;
+    }
+
+    WORD codeLen() const {
+      return m_codeLen;
+    }
+
+    GsFieldMask fields() const {
+      return m_fields;
+    }
+
+    private:
+    char peek() const {
+      return m_source[m_pos];
+    }
+
+    void skipSpaces() {
+      while (peek() == ' ') {
+        m_pos++;
+      }
+    }
+
+    //! Steps over c, and the spaces before it, if it comes next.
+    bool accept(char c) {
+      skipSpaces();
+      if (peek() != c) {
+        return false;
+      }
+      m_pos++;
+      return true;
+    }
+
+    bool number(unsigned long &value) {
+      skipSpaces();
+      if (peek() < '0' || peek() > '9') {
+        return false;
+      }
+      value = 0;
+      while (peek() >= '0' && peek() <= '9') {
+        value = value * 10 + (peek() - '0');
+        if (value > 0x7FFFFFFFUL) {
+          return false;
+        }
+        m_pos++;
+      }
+      return true;
+    }
+
+    //! Letters and digits, e.g. a key or a mnemonic.
+    bool word(char *out, BYTE size) {
+      skipSpaces();
+      BYTE len = 0;
+      while ((peek() >= 'a' && peek() <= 'z') || (peek() >= 'A' && peek() <= 'Z') || (peek() >= '0' && peek() <= '9')) {
+        if (len + 1 >= size) {
+          return false;
+        }
+        out[len++] = peek();
+        m_pos++;
+      }
+      out[len] = '\0';
+      return len > 0;
+    }
+
+    bool emit(BYTE b) {
+      if (m_codeLen >= m_codeSize) {
+        return false;
+      }
+      m_code[m_codeLen++] = b;
+      return true;
+    }
+
+    bool emitConst(unsigned long value) {
+      if (!emit(OP_CONST)) {
+        return false;
+      }
+      for (BYTE i = 0; i < 4; ++i) {
+        if (!emit((BYTE)(value >> (8 * i)))) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    //! term, then | term as long as there are any.
+    bool expression() {
+      if (!term()) {
+        return false;
+      }
+      while (accept('|')) {
+        if (!term() || !emit(OP_OR)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    //! condition, then & condition as long as there are any.
+    bool term() {
+      if (!condition()) {
+        return false;
+      }
+      while (accept('&')) {
+        if (!condition() || !emit(OP_AND)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    //! key op number, with an optional ~hysteresis.
+    bool condition() {
+      char key[RULE_KEY_SZ];
+      if (!word(key, sizeof(key))) {
+        return false;
+      }
+      const GS_FIELD field = findGeneralStatusField(key);
+      if (field >= NUM_GS_FIELDS) {
+        return false;
+      }
+      BYTE op;
+      if (accept('<')) {
+        op = accept('=') ? OP_LE : OP_LT;
+      } else if (accept('>')) {
+        op = accept('=') ? OP_GE : OP_GT;
+      } else if (accept('=')) {
+        op = OP_EQ;
+      } else if (accept('!') && accept('=')) {
+        op = OP_NE;
+      } else {
+        return false;
+      }
+      unsigned long threshold;
+      if (!number(threshold) || !emit(OP_FIELD) || !emit((BYTE)field) || !emitConst(threshold)) {
+        return false;
+      }
+      if (accept('~')) {
+        unsigned long hysteresis;
+        if (op == OP_EQ || op == OP_NE || !number(hysteresis) || !emitConst(hysteresis)
+            || !emit(op == OP_LT || op == OP_LE ? OP_WIDEN_UP : OP_WIDEN_DOWN)) {
+          return false;
+        }
+      }
+      m_fields |= 1UL << field;
+      return emit(op);
+    }
+
+    //! MNEMONIC=value or MNEMONIC=m,value, or just the mnemonic for the commands without a value.
+    bool command(Action &action) {
+      char mnemonic[RULE_KEY_SZ];
+      if (!word(mnemonic, sizeof(mnemonic))) {
+        return false;
+      }
+      action.commandType = findCommandType(mnemonic, UPDATE);
+      action.alarm[0] = '\0';
+      // ENABLE_DISABLE takes a letter, not a value.
+      if (action.commandType >= NUM_COMMAND_TYPES || action.commandType == SET_ENABLE_DISABLE_STATUS) {
+        return false;
+      }
+      action.machine = 0;
+      action.value = 0;
+      if (!accept('=')) {
+        return getCommandDescriptor(action.commandType).paramSz == 0;
+      }
+      if (!number(action.value)) {
+        return false;
+      }
+      if (accept(',')) {
+        if (!isParallelAddressed(action.commandType) || action.value > 9) {
+          return false;
+        }
+        action.machine = (BYTE)action.value;
+        return number(action.value);
+      }
+      return true;
+    }
+
+    //! The name after '!'.
+    bool alarm(Action &action) {
+      action.commandType = NUM_COMMAND_TYPES;
+      action.machine = 0;
+      action.value = 0;
+      return word(action.alarm, sizeof(action.alarm));
+    }
+
+    const char *m_source;
+    size_t m_pos;
+    BYTE *m_code;
+    WORD m_codeSize;
+    WORD m_codeLen;
+    GsFieldMask m_fields;
+  };
+
+  InfiniRules::InfiniRules(InfiniCommandQueue &queue, const InfiniSetter &setter) :
+    m_queue(queue),
+    m_setter(setter),
+    m_onFired(NULL),
+    m_onFiredContext(NULL),
+    m_onAlarm(NULL),
+    m_onAlarmContext(NULL),
+    m_count(0),
+    m_fields(0),
+    m_errorAt(0),
+    m_fired(0),
+    m_failed(0)
+  {
+    m_source[0] = '\0';
+  }
+
+  bool InfiniRules::compile(const char *source) {
+    m_errorAt = 0;
+    if (strlen(source) >= RULES_SOURCE_SZ) {
+      m_errorAt = RULES_SOURCE_SZ - 1;
+      return false;
+    }
+    // Into the side buffers first, so a bad source leaves the rules in force alone.
+    BYTE code[RULES_CODE_SZ];
+    RuleCompiler::Action actions[RULES_MAX];
+    RuleCompiler compiler(source, code, sizeof(code));
+    BYTE count = 0;
+    while (!compiler.atEnd()) {
+      if (count >= RULES_MAX || !compiler.rule(actions[count])) {
+        m_errorAt = compiler.pos();
+        return false;
+      }
+      count++;
+    }
+    dropAlarms();
+    memcpy(m_code, code, compiler.codeLen());
+    for (BYTE i = 0; i < count; ++i) {
+      Rule &rule = m_rules[i];
+      rule.code = actions[i].code;
+      rule.holdMs = actions[i].holdMs;
+      rule.commandType = actions[i].commandType;
+      rule.machine = actions[i].machine;
+      rule.value = actions[i].value;
+      strcpy(rule.alarm, actions[i].alarm);
+      rule.held = false;
+      rule.active = false;
+      rule.sinceMs = 0;
+    }
+    m_count = count;
+    m_fields = compiler.fields();
+    strcpy(m_source, source);
+    return true;
+  }
+
+  size_t InfiniRules::errorAt() const {
+    return m_errorAt;
+  }
+
+  const char *InfiniRules::source() const {
+    return m_source;
+  }
+
+  BYTE InfiniRules::count() const {
+    return m_count;
+  }
+
+  void InfiniRules::clear() {
+    dropAlarms();
+    m_count = 0;
+    m_fields = 0;
+    m_source[0] = '\0';
+  }
+
+  GsFieldMask InfiniRules::fields() const {
+    return m_fields;
+  }
+
+  void InfiniRules::setOnFired(RuleFired onFired, void *context) {
+    m_onFired = onFired;
+    m_onFiredContext = context;
+  }
+
+  void InfiniRules::setOnAlarm(RuleAlarm onAlarm, void *context) {
+    m_onAlarm = onAlarm;
+    m_onAlarmContext = context;
+  }
+
+  void InfiniRules::evaluate(const GeneralStatusFixed &gs, unsigned long nowMs) {
+    for (BYTE i = 0; i < m_count; ++i) {
+      Rule &rule = m_rules[i];
+      if (!run(rule.code, gs, rule.held)) {
+        if (rule.active && rule.commandType == NUM_COMMAND_TYPES && m_onAlarm != NULL) {
+          m_onAlarm(i, rule.alarm, false, m_onAlarmContext);
+        }
+        rule.held = false;
+        rule.active = false;
+        continue;
+      }
+      if (!rule.held) {
+        rule.held = true;
+        rule.sinceMs = nowMs;
+      }
+      if (rule.active || nowMs - rule.sinceMs < rule.holdMs) {
+        continue;
+      }
+      rule.active = true;
+      if (rule.commandType == NUM_COMMAND_TYPES) {
+        if (m_onAlarm != NULL) {
+          m_onAlarm(i, rule.alarm, true, m_onAlarmContext);
+        }
+        continue;
+      }
+      char params[MAX_PARAMS_SZ];
+      const bool queued = m_setter.makeParams(rule.commandType, rule.machine, rule.value, params)
+        && m_queue.enqueue(rule.commandType, params);
+      if (queued) {
+        m_fired++;
+      } else {
+        m_failed++;
+      }
+      if (m_onFired != NULL) {
+        m_onFired(i, rule.commandType, queued, m_onFiredContext);
+      }
+    }
+  }
+
+  bool InfiniRules::isActive(BYTE rule) const {
+    return rule < m_count && m_rules[rule].active;
+  }
+
+  const char *InfiniRules::alarm(BYTE rule) const {
+    return rule < m_count && m_rules[rule].commandType == NUM_COMMAND_TYPES ? m_rules[rule].alarm : NULL;
+  }
+
+  unsigned long InfiniRules::fired() const {
+    return m_fired;
+  }
+
+  unsigned long InfiniRules::failed() const {
+    return m_failed;
+  }
+
+  void InfiniRules::dropAlarms() {
+    for (BYTE i = 0; i < m_count; ++i) {
+      if (m_rules[i].active && m_rules[i].commandType == NUM_COMMAND_TYPES && m_onAlarm != NULL) {
+        m_onAlarm(i, m_rules[i].alarm, false, m_onAlarmContext);
+      }
+    }
+  }
+
+  bool InfiniRules::run(WORD code, const GeneralStatusFixed &gs, bool held) const {
+    // compile() only emits well formed code, so neither the stack nor the code is checked here.
+    long stack[RULE_STACK_SZ];
+    BYTE sp = 0;
+    const BYTE *pc = m_code + code;
+    for (;;) {
+      const BYTE op = *pc++;
+      if (op >= OP_LT) {
+        sp--;
+      }
+      switch (op) {
+        case OP_END:
+          return stack[0] != 0;
+        case OP_FIELD:
+          stack[sp++] = getGeneralStatusField(gs, (GS_FIELD)*pc++);
+          break;
+        case OP_CONST:
+          stack[sp++] = (long)((uint32_t)pc[0] | ((uint32_t)pc[1] << 8) | ((uint32_t)pc[2] << 16) | ((uint32_t)pc[3] << 24));
+          pc += 4;
+          break;
+        case OP_WIDEN_UP:
+          sp--;
+          stack[sp - 1] += held ? stack[sp] : 0;
+          break;
+        case OP_WIDEN_DOWN:
+          sp--;
+          stack[sp - 1] -= held ? stack[sp] : 0;
+          break;
+        case OP_LT: stack[sp - 1] = stack[sp - 1] < stack[sp]; break;
+        case OP_LE: stack[sp - 1] = stack[sp - 1] <= stack[sp]; break;
+        case OP_GT: stack[sp - 1] = stack[sp - 1] > stack[sp]; break;
+        case OP_GE: stack[sp - 1] = stack[sp - 1] >= stack[sp]; break;
+        case OP_EQ: stack[sp - 1] = stack[sp - 1] == stack[sp]; break;
+        case OP_NE: stack[sp - 1] = stack[sp - 1] != stack[sp]; break;
+        case OP_AND: stack[sp - 1] = stack[sp - 1] && stack[sp]; break;
+        case OP_OR: stack[sp - 1] = stack[sp - 1] || stack[sp]; break;
+        default:
+          return false;
+      }
+    }
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  bool InfiniRules::save(const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) {
+      return false;
+    }
+    bool saved = prefs.putString(RULES_KEY, m_source) == strlen(m_source);
+    prefs.end();
+    return saved;
+  }
+
+  bool InfiniRules::load(const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, true)) {
+      return false;
+    }
+    char source[RULES_SOURCE_SZ];
+    bool loaded = prefs.getString(RULES_KEY, source, sizeof(source)) > 0;
+    prefs.end();
+    return loaded && compile(source);
+  }
+#endif
+}
+#endif
@@ -0,0 +1,137 @@
+#ifndef INFINI_RULES_H
+#define INFINI_RULES_H
+
+#include "InfiniSetter.h"
+#include "InfiniDeltaTelemetry.h"
+
+// Most rules compiled at once.
+#ifndef INFI_RULES_MAX
+#define INFI_RULES_MAX 8
+#endif
+
+// Bytes of bytecode of all the rules together, a condition takes 6 to 15.
+#ifndef INFI_RULES_CODE_SZ
+#define INFI_RULES_CODE_SZ 192
+#endif
+
+// Longest rule text kept, and stored in NVS, null terminator included.
+#ifndef INFI_RULES_SOURCE_SZ
+#define INFI_RULES_SOURCE_SZ 256
+#endif
+
+// Longest alarm name, null terminator included.
+#ifndef INFI_RULES_ALARM_SZ
+#define INFI_RULES_ALARM_SZ 16
+#endif
+
+namespace INFI {
+
+  const BYTE RULES_MAX = INFI_RULES_MAX;
+  const WORD RULES_CODE_SZ = INFI_RULES_CODE_SZ;
+  const WORD RULES_SOURCE_SZ = INFI_RULES_SOURCE_SZ;
+  const BYTE RULES_ALARM_SZ = INFI_RULES_ALARM_SZ;
+
+  /*! Called when rule fired, i.e. its condition just held for its time. queued is false if the command's value
+   * was invalid, e.g. a charging current the inverter does not list, or its lane was full.
+   */
+  typedef void (*RuleFired)(BYTE rule, COMMAND_TYPE commandType, bool queued, void *context);
+
+  //! Called when the alarm of rule is raised, as its rule fires, and when it clears, as the condition stops holding.
+  typedef void (*RuleAlarm)(BYTE rule, const char *alarm, bool raised, void *context);
+
+  /*!
+   * Local control rules, so the box reacts to a sample within the poll instead of after a round trip through
+   * the cloud, and also while offline. A rule is a condition over GS fields that, once it held for a while,
+   * queues a ^S command. Rules are given as text, e.g. from a shared attribute, separated by ';':
+   *   battCapacity<30~10@60:POP=0; battCapacity>60@60:POP=1
+   * A condition compares a field, by its key and in the units GeneralStatusFixed stores it in, with a number,
+   * using <, <=, >, >=, = or !=. Conditions are joined by & and |, & binding first. ~n adds hysteresis to a <, <=,
+   * > or >=: once the rule's condition held, the comparison only fails n further past its number, so
+   * battCapacity<30~10 holds from below 30 up to 40. @s makes the condition hold for s seconds before the rule
+   * fires. After ':' comes the command, its mnemonic, '=', and the value InfiniSetter::makeParams() takes,
+   * prefixed by "m," for the parallel addressed ones, e.g. PCP=0,1. A rule fires once each time its condition
+   * starts to hold, and again only after it stopped.
+   * Instead of a command a rule may raise an alarm, '!' and its name, e.g. invHeatSinkTemp>80~5@5:!overTemp.
+   * The alarm is handed to the RuleAlarm callback as the rule fires, and again once it clears, so the sketch
+   * can publish it at once rather than with the next batch. @ debounces it, ~ keeps it from flapping.
+   * compile() turns the text into a small stack bytecode once, so evaluate() reads each field straight from
+   * the struct and costs a few microseconds per sample. Not thread safe, evaluate it where the queue is run.
+   */
+  class InfiniRules {
+    public:
+    InfiniRules(InfiniCommandQueue &queue, const InfiniSetter &setter);
+
+    /*! Replaces the rules by those in source. Returns false, keeping the rules as they were, if source does not
+     * compile, see errorAt(), or is longer than RULES_SOURCE_SZ - 1. An empty source drops every rule.
+     */
+    bool compile(const char *source);
+    //! The offset in source of the char the last failed compile() stopped at.
+    size_t errorAt() const;
+    //! The text of the rules in force.
+    const char *source() const;
+    BYTE count() const;
+    void clear();
+
+    //! The GS fields the rules read, which the parser has to decode, see InfiniResponseParser::setGsFields().
+    GsFieldMask fields() const;
+
+    void setOnFired(RuleFired onFired, void *context = NULL);
+    void setOnAlarm(RuleAlarm onAlarm, void *context = NULL);
+
+    //! Runs every rule on gs, sampled at nowMs, and queues the commands of the rules that fire.
+    void evaluate(const GeneralStatusFixed &gs, unsigned long nowMs);
+
+    //! Whether rule fired and its condition still holds.
+    bool isActive(BYTE rule) const;
+    //! The name of the alarm rule raises, NULL if it queues a command.
+    const char *alarm(BYTE rule) const;
+    //! Commands queued, and commands that could not be.
+    unsigned long fired() const;
+    unsigned long failed() const;
+
+#if defined(ARDUINO_ARCH_ESP32)
+    //! Keeps the source in the NVS namespace ns, at most 15 chars, so the rules run offline after a reboot.
+    bool save(const char *ns = "infi_rules");
+    //! Compiles what save() kept. Returns false if there is none, or it no longer compiles.
+    bool load(const char *ns = "infi_rules");
+#endif
+
+    private:
+    struct Rule {
+      //! Where its bytecode starts in m_code.
+      WORD code;
+      unsigned long holdMs;
+      //! NUM_COMMAND_TYPES for an alarm.
+      COMMAND_TYPE commandType;
+      BYTE machine;
+      unsigned long value;
+      char alarm[RULES_ALARM_SZ];
+      //! The condition held on the last sample, since sinceMs.
+      bool held;
+      bool active;
+      unsigned long sinceMs;
+    };
+
+    //! Clears the alarms raised, before the rules are replaced.
+    void dropAlarms();
+    //! Runs the bytecode at code, with the hysteresis of a condition that held.
+    bool run(WORD code, const GeneralStatusFixed &gs, bool held) const;
+
+    InfiniCommandQueue &m_queue;
+    const InfiniSetter &m_setter;
+    RuleFired m_onFired;
+    void *m_onFiredContext;
+    RuleAlarm m_onAlarm;
+    void *m_onAlarmContext;
+    BYTE m_code[RULES_CODE_SZ];
+    Rule m_rules[RULES_MAX];
+    BYTE m_count;
+    GsFieldMask m_fields;
+    char m_source[RULES_SOURCE_SZ];
+    size_t m_errorAt;
+    unsigned long m_fired;
+    unsigned long m_failed;
+  };
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include "InfiniRxRing.h"
+#include "InfiniIdle.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_arduino_version.h>
+#endif
+
+namespace INFI {
+  InfiniRxRing::InfiniRxRing() :
+    m_head(0),
+    m_framesPushed(0),
+    m_overflowed(false),
+    m_tail(0),
+    m_framesPopped(0)
+  {}
+
+  bool INFI_IRAM InfiniRxRing::push(BYTE b) {
+    BYTE head = m_head;
+    BYTE next = (head + 1) & (RX_RING_SZ - 1);
+    if (next == __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE)) {
+      m_overflowed = true;
+      return false;
+    }
+    m_buffer[head] = b;
+    // Publish the byte before the frame count, so a counted frame is always complete.
+    __atomic_store_n(&m_head, next, __ATOMIC_RELEASE);
+    if (b == '\r') {
+      __atomic_store_n(&m_framesPushed, (BYTE)(m_framesPushed + 1), __ATOMIC_RELEASE);
+    }
+    return true;
+  }
+
+  size_t InfiniRxRing::pushFrom(Stream &stream) {
+    size_t moved = 0;
+    while (stream.available() > 0) {
+      int c = stream.read();
+      if (c < 0) {
+        break;
+      }
+      push((BYTE)c);
+      moved++;
+    }
+    return moved;
+  }
+
+  BYTE InfiniRxRing::framesReady() const {
+    return __atomic_load_n(&m_framesPushed, __ATOMIC_ACQUIRE) - m_framesPopped;
+  }
+
+  size_t InfiniRxRing::popFrame(char *out, size_t outSz) {
+    if (framesReady() == 0) {
+      return 0;
+    }
+    BYTE tail = m_tail;
+    size_t len = 0;
+    bool started = false;
+    // The '\r' is known to be in the ring, so this always ends.
+    while (true) {
+      BYTE b = m_buffer[tail];
+      tail = (tail + 1) & (RX_RING_SZ - 1);
+      if (b == '^') {
+        started = true;
+      }
+      if (started && len < outSz) {
+        out[len++] = (char)b;
+      }
+      if (b == '\r') {
+        break;
+      }
+    }
+    __atomic_store_n(&m_tail, tail, __ATOMIC_RELEASE);
+    m_framesPopped++;
+    return len;
+  }
+
+  void InfiniRxRing::discard() {
+    // Only the consumer's indexes move, so this is safe while the producer runs.
+    // It is meant for an idle line, before a command is sent.
+    BYTE head = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+    m_framesPopped = __atomic_load_n(&m_framesPushed, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&m_tail, head, __ATOMIC_RELEASE);
+    m_overflowed = false;
+  }
+
+  bool InfiniRxRing::overflowed() const {
+    return m_overflowed;
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  void attachRxRing(HardwareSerial &serial, InfiniRxRing &ring) {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    // The driver empties the FIFO a few bytes at a time rather than near full, so the rest of it can take the
+    // bytes that arrive while a flash erase holds its interrupt off.
+    serial.setRxFIFOFull(RX_FIFO_FULL);
+#endif
+    // onReceive runs in the UART event task, which makes it the ring's single producer.
+    serial.onReceive([&serial, &ring]() {
+      ring.pushFrom(serial);
+      wakeIdle();
+    });
+  }
+#endif
+}
@@ -0,0 +1,81 @@
+#ifndef INFINI_RX_RING_H
+#define INFINI_RX_RING_H
+
+#include <Stream.h>
+#include "InfiniCommon.h"
+
+// Bytes the RX ring can hold, a power of two of at most 256. One slot is always kept free.
+#ifndef INFI_RX_RING_SZ
+#define INFI_RX_RING_SZ 256
+#endif
+
+// Bytes in the 128 byte UART FIFO that have attachRxRing() move them on (Arduino-ESP32 3 and later).
+// The rest of the FIFO holds what arrives while a flash erase or write keeps the UART interrupt off.
+#ifndef INFI_RX_FIFO_FULL
+#define INFI_RX_FIFO_FULL 16
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <HardwareSerial.h>
+#endif
+
+namespace INFI {
+
+  const size_t RX_RING_SZ = INFI_RX_RING_SZ;
+  static_assert(RX_RING_SZ <= 256 && (RX_RING_SZ & (RX_RING_SZ - 1)) == 0,
+                "INFI_RX_RING_SZ must be a power of two of at most 256");
+  const BYTE RX_FIFO_FULL = INFI_RX_FIFO_FULL;
+
+  /*!
+   * A lock-free single producer, single consumer byte ring for the inverter's replies.
+   * The producer (UART ISR or event task) pushes bytes and counts every '\r' as a finished frame,
+   * so the consumer (the polling loop) only ever deals with complete frames.
+   * Indexes are single bytes, so their loads and stores are atomic on AVR too.
+   */
+  class InfiniRxRing {
+    public:
+    InfiniRxRing();
+
+    //! Producer side. Stores b, or drops it and returns false if the ring is full.
+    //! In IRAM on ESP32, so an interrupt handler can call it while the flash is written.
+    bool push(BYTE b);
+
+    //! Producer side. Moves everything available on stream into the ring, returns the number of bytes moved.
+    size_t pushFrom(Stream &stream);
+
+    //! Consumer side. Number of complete frames waiting.
+    BYTE framesReady() const;
+
+    /*! Consumer side. Moves the next complete frame, '\r' included, into out.
+     * Anything before its '^' is dropped, as is whatever does not fit in outSz.
+     * Returns the number of bytes stored in out, 0 if no frame is ready.
+     */
+    size_t popFrame(char *out, size_t outSz);
+
+    //! Consumer side. Drops everything pushed so far, e.g. a late reply to an earlier command.
+    void discard();
+
+    //! Whether a byte was dropped because the ring was full. Cleared by discard().
+    bool overflowed() const;
+
+    private:
+    BYTE m_buffer[RX_RING_SZ];
+    //! Written by the producer only.
+    volatile BYTE m_head;
+    volatile BYTE m_framesPushed;
+    volatile bool m_overflowed;
+    //! Written by the consumer only.
+    volatile BYTE m_tail;
+    volatile BYTE m_framesPopped;
+  };
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /*! Fills ring from the UART event task of serial, so bytes are taken off the FIFO as they arrive
+   * even while the loop task is busy. Call after serial.begin(). Lowers the FIFO threshold to INFI_RX_FIFO_FULL.
+   * Every batch of bytes also calls wakeIdle(), so a loop sleeping in idleFor() picks the reply up.
+   */
+  void attachRxRing(HardwareSerial &serial, InfiniRxRing &ring);
+#endif
+}
+
+#endif
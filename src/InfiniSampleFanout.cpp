@@ -0,0 +1,139 @@
+#include "InfiniSampleFanout.h"
+
+#if INFI_MODULE_SINKS
+#include "InfiniBinaryWriter.h"
+#include "InfiniDeltaTelemetry.h"
+#include "InfiniJsonWriter.h"
+#include "InfiniSinkQueue.h"
+
+namespace INFI {
+
+  static_assert(BINARY_GS_SAMPLE_SZ < SAMPLE_BUFFER_SZ, "SAMPLE_BUFFER_SZ must hold a binary sample");
+
+  //! Adds delta to refs and returns the new count. Sinks may release from another task on ESP32.
+  static BYTE addRefs(volatile BYTE &refs, int delta) {
+#if defined(ARDUINO_ARCH_ESP32)
+    return __atomic_add_fetch(&refs, (BYTE)delta, __ATOMIC_ACQ_REL);
+#else
+    refs += delta;
+    return refs;
+#endif
+  }
+
+  InfiniSampleFanout::InfiniSampleFanout() :
+    m_sinkCount(0),
+    m_encoded(0),
+    m_dropped(0)
+  {
+    for (BYTE i = 0; i < SAMPLE_BUFFERS; ++i) {
+      m_buffers[i].refs = 0;
+    }
+  }
+
+  bool InfiniSampleFanout::addSink(SAMPLE_FORMAT format, SampleSink sink, void *context) {
+    if (m_sinkCount >= SAMPLE_SINKS || format >= NUM_SAMPLE_FORMATS || sink == NULL) {
+      return false;
+    }
+    Sink &entry = m_sinks[m_sinkCount++];
+    entry.format = format;
+    entry.sink = sink;
+    entry.context = context;
+    entry.queue = NULL;
+    return true;
+  }
+
+  bool InfiniSampleFanout::addSink(SAMPLE_FORMAT format, InfiniSinkQueue &queue) {
+    if (m_sinkCount >= SAMPLE_SINKS || format >= NUM_SAMPLE_FORMATS) {
+      return false;
+    }
+    Sink &entry = m_sinks[m_sinkCount++];
+    entry.format = format;
+    entry.sink = NULL;
+    entry.context = NULL;
+    entry.queue = &queue;
+    return true;
+  }
+
+  BYTE InfiniSampleFanout::publish(const GeneralStatusFixed &gs, uint64_t tsMs, BYTE deviceId) {
+    InfiniSampleBuffer *buffers[NUM_SAMPLE_FORMATS] = {};
+    // Formats tried this publish, so one that found no buffer is not encoded again for its next sink.
+    BYTE tried = 0;
+    BYTE served = 0;
+    for (BYTE s = 0; s < m_sinkCount; ++s) {
+      const Sink &sink = m_sinks[s];
+      const BYTE bit = (BYTE)(1 << sink.format);
+      if ((tried & bit) == 0) {
+        tried |= bit;
+        buffers[sink.format] = encode(sink.format, gs, tsMs, deviceId);
+      }
+      if (buffers[sink.format] == NULL) {
+        m_dropped++;
+        continue;
+      }
+      const InfiniSampleBuffer &buffer = *buffers[sink.format];
+      if (sink.queue != NULL) {
+        // What the queue does not take is counted by its policy, not here.
+        sink.queue->push(buffer.data, buffer.len, buffer.tsMs, buffer.deviceId);
+      } else {
+        sink.sink(buffer, sink.context);
+      }
+      served++;
+    }
+    for (BYTE f = 0; f < NUM_SAMPLE_FORMATS; ++f) {
+      release(buffers[f]);
+    }
+    return served;
+  }
+
+  const InfiniSampleBuffer *InfiniSampleFanout::retain(const InfiniSampleBuffer &buffer) {
+    InfiniSampleBuffer &shared = const_cast<InfiniSampleBuffer &>(buffer);
+    addRefs(shared.refs, 1);
+    return &shared;
+  }
+
+  void InfiniSampleFanout::release(const InfiniSampleBuffer *buffer) {
+    if (buffer != NULL) {
+      // The buffer is free again once the count is back to 0, encode() looks for that.
+      addRefs(const_cast<InfiniSampleBuffer *>(buffer)->refs, -1);
+    }
+  }
+
+  unsigned long InfiniSampleFanout::encoded() const {
+    return m_encoded;
+  }
+
+  unsigned long InfiniSampleFanout::dropped() const {
+    return m_dropped;
+  }
+
+  InfiniSampleBuffer *InfiniSampleFanout::encode(SAMPLE_FORMAT format, const GeneralStatusFixed &gs, uint64_t tsMs,
+                                                 BYTE deviceId) {
+    InfiniSampleBuffer *buffer = NULL;
+    for (BYTE i = 0; i < SAMPLE_BUFFERS && buffer == NULL; ++i) {
+      if (m_buffers[i].refs == 0) {
+        buffer = &m_buffers[i];
+      }
+    }
+    if (buffer == NULL || (format == SAMPLE_JSON && measureGeneralStatusJson(gs) >= SAMPLE_BUFFER_SZ)) {
+      return NULL;
+    }
+    buffer->refs = 1;
+    buffer->format = format;
+    buffer->deviceId = deviceId;
+    buffer->tsMs = tsMs;
+    InfiniBufferPrint out(buffer->data, SAMPLE_BUFFER_SZ);
+    if (format == SAMPLE_JSON) {
+      writeGeneralStatusJson(gs, out);
+    } else if (format == SAMPLE_BINARY) {
+      writeGeneralStatusBinary(gs, out);
+    } else if (format == SAMPLE_BINARY_STAMPED) {
+      writeGsSampleBinary(gs, tsMs, out);
+    } else {
+      writeGeneralStatusCsv(gs, tsMs, out);
+    }
+    buffer->len = out.length();
+    m_encoded++;
+    return buffer;
+  }
+}
+#endif
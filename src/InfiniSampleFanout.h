@@ -0,0 +1,106 @@
+#ifndef INFINI_SAMPLE_FANOUT_H
+#define INFINI_SAMPLE_FANOUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "InfiniDataTypes.h"
+
+// Sinks one fan-out feeds, e.g. ThingsBoard, the WebSocket stream, an SD log and a LAN broker.
+#ifndef INFI_SAMPLE_SINKS
+#define INFI_SAMPLE_SINKS 4
+#endif
+
+// Encoded samples that can exist at once: one per format while publish() runs, plus what sinks retain().
+#ifndef INFI_SAMPLE_BUFFERS
+#define INFI_SAMPLE_BUFFERS 3
+#endif
+
+// Room for one encoded sample, a GS as JSON is at most about 560 chars.
+#ifndef INFI_SAMPLE_BUFFER_SZ
+#define INFI_SAMPLE_BUFFER_SZ 600
+#endif
+
+namespace INFI {
+
+  const BYTE SAMPLE_SINKS = INFI_SAMPLE_SINKS;
+  const BYTE SAMPLE_BUFFERS = INFI_SAMPLE_BUFFERS;
+  const size_t SAMPLE_BUFFER_SZ = INFI_SAMPLE_BUFFER_SZ;
+
+  class InfiniSinkQueue;
+
+  //! What a sink is handed a sample as.
+  enum SAMPLE_FORMAT {
+    SAMPLE_JSON = 0,        // The writeGeneralStatusJson() object, null terminated.
+    SAMPLE_BINARY,          // The writeGeneralStatusBinary() record.
+    SAMPLE_BINARY_STAMPED,  // The writeGsSampleBinary() record, with the sample's Unix ms.
+    SAMPLE_CSV,             // The writeGeneralStatusCsv() line, with the sample's Unix ms.
+    NUM_SAMPLE_FORMATS
+  };
+
+  //! One sample encoded in one format, shared by every sink of that format. Sinks only read it.
+  struct InfiniSampleBuffer {
+    SAMPLE_FORMAT format;
+    BYTE deviceId;
+    uint64_t tsMs;
+    size_t len;
+    char data[SAMPLE_BUFFER_SZ];
+    //! Holders of the buffer, the fan-out's own while publish() runs and one per retain().
+    volatile BYTE refs;
+  };
+
+  //! Gets a sample from InfiniSampleFanout::publish(). buffer is valid for the call, retain() it to keep it longer.
+  typedef void (*SampleSink)(const InfiniSampleBuffer &buffer, void *context);
+
+  /*!
+   * Hands every GS sample to a set of sinks, each in the format it asked for. A sample is encoded once per
+   * format some sink wants, however many sinks share it, and they all get the same buffer, so adding a sink
+   * only costs its own delivery. A sink that cannot finish inside its call, e.g. one that passes the sample
+   * to another task, retain()s the buffer and release()s it when done, from any task on ESP32.
+   * A sink that may be slow, e.g. an SD card, goes behind an InfiniSinkQueue instead, publish() only copies the
+   * sample into it and the sink drains it where waiting does no harm.
+   * publish() and addSink() belong to one task.
+   */
+  class InfiniSampleFanout {
+    public:
+    InfiniSampleFanout();
+
+    //! Adds sink for samples in format. Returns false if SAMPLE_SINKS are already added.
+    bool addSink(SAMPLE_FORMAT format, SampleSink sink, void *context = NULL);
+    //! Adds queue as a sink, publish() pushes the samples in format into it at normal priority.
+    bool addSink(SAMPLE_FORMAT format, InfiniSinkQueue &queue);
+
+    /*! Encodes gs in each format a sink wants and hands it to the sinks, in the order they were added.
+     * tsMs is the sample's Unix ms, 0 if not known. Returns the number of sinks served.
+     * A sink is skipped if every buffer is retained, see dropped().
+     */
+    BYTE publish(const GeneralStatusFixed &gs, uint64_t tsMs, BYTE deviceId = 0);
+
+    //! Keeps buffer past the sink call. Every retain() needs a release().
+    const InfiniSampleBuffer *retain(const InfiniSampleBuffer &buffer);
+    void release(const InfiniSampleBuffer *buffer);
+
+    //! Samples encoded so far, once per format per publish(), and sink deliveries skipped for want of a buffer.
+    unsigned long encoded() const;
+    unsigned long dropped() const;
+
+    private:
+    struct Sink {
+      SAMPLE_FORMAT format;
+      SampleSink sink;
+      void *context;
+      //! Set instead of sink for a queued one.
+      InfiniSinkQueue *queue;
+    };
+
+    //! A free buffer holding gs in format, NULL if none is free.
+    InfiniSampleBuffer *encode(SAMPLE_FORMAT format, const GeneralStatusFixed &gs, uint64_t tsMs, BYTE deviceId);
+
+    Sink m_sinks[SAMPLE_SINKS];
+    BYTE m_sinkCount;
+    InfiniSampleBuffer m_buffers[SAMPLE_BUFFERS];
+    unsigned long m_encoded;
+    unsigned long m_dropped;
+  };
+}
+
+#endif
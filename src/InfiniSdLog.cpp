@@ -0,0 +1,198 @@
+#include "InfiniSdLog.h"
+
+#if INFI_MODULE_SINKS
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <stdio.h>
+#include <string.h>
+#include "InfiniBinaryWriter.h"
+#include "InfiniCivilDate.h"
+#include "InfiniDeltaTelemetry.h"
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+
+  static const unsigned long MS_PER_DAY = 86400000UL;
+
+  InfiniSdLog::InfiniSdLog(fs::FS &fs, SAMPLE_FORMAT format, const char *dir) :
+    m_fs(fs),
+    m_format(format),
+    m_day(0),
+    m_blockLen(0),
+    m_blockRecords(0),
+    m_blockIndex(0),
+    m_fileBlocks(0),
+    m_dropped(0),
+    m_failures(0)
+  {
+    strncpy(m_dir, dir, sizeof(m_dir) - 1);
+    m_dir[sizeof(m_dir) - 1] = '\0';
+  }
+
+  InfiniSdLog::~InfiniSdLog() {
+    end();
+  }
+
+  bool InfiniSdLog::begin() {
+    if (m_format != SAMPLE_BINARY_STAMPED && m_format != SAMPLE_CSV) {
+      return false;
+    }
+    return m_fs.exists(m_dir) || m_fs.mkdir(m_dir);
+  }
+
+  bool InfiniSdLog::append(const GeneralStatusFixed &gs, uint64_t tsMs) {
+    // A CSV line is about 200 chars at most.
+    char record[256];
+    InfiniBufferPrint out(record, sizeof(record));
+    if (m_format == SAMPLE_CSV) {
+      writeGeneralStatusCsv(gs, tsMs, out);
+    } else {
+      writeGsSampleBinary(gs, tsMs, out);
+    }
+    return appendRecord(record, out.length(), tsMs);
+  }
+
+  bool InfiniSdLog::appendRecord(const char *record, size_t len, uint64_t tsMs) {
+    if (tsMs == 0 || len == 0 || len > SD_LOG_BLOCK_SZ) {
+      m_dropped++;
+      return false;
+    }
+    unsigned long day = (unsigned long)(tsMs / MS_PER_DAY);
+    if ((day != m_day || !m_file) && !openDay(day)) {
+      m_dropped++;
+      m_failures++;
+      return false;
+    }
+    if (m_blockLen + len > SD_LOG_BLOCK_SZ) {
+      memset(m_block + m_blockLen, padByte(), SD_LOG_BLOCK_SZ - m_blockLen);
+      bool written = writeBlock();
+      if (!written) {
+        m_dropped += m_blockRecords;
+        m_failures++;
+      }
+      // A failed block is given up on rather than retried with every sample.
+      m_blockIndex++;
+      m_blockLen = 0;
+      m_blockRecords = 0;
+      if (!written) {
+        m_dropped++;
+        return false;
+      }
+    }
+    memcpy(m_block + m_blockLen, record, len);
+    m_blockLen += len;
+    m_blockRecords++;
+    return true;
+  }
+
+  void InfiniSdLog::sink(const InfiniSampleBuffer &buffer, void *context) {
+    InfiniSdLog &log = *(InfiniSdLog *)context;
+    if (buffer.format == log.m_format) {
+      log.appendRecord(buffer.data, buffer.len, buffer.tsMs);
+    }
+  }
+
+  bool InfiniSdLog::flush() {
+    if (!m_file || m_blockLen == 0) {
+      return true;
+    }
+    memset(m_block + m_blockLen, padByte(), SD_LOG_BLOCK_SZ - m_blockLen);
+    if (!writeBlock()) {
+      m_failures++;
+      return false;
+    }
+    return true;
+  }
+
+  void InfiniSdLog::end() {
+    if (m_file) {
+      flush();
+      m_file.close();
+    }
+    m_day = 0;
+    m_blockLen = 0;
+    m_blockRecords = 0;
+  }
+
+  unsigned long InfiniSdLog::dropped() const {
+    return m_dropped;
+  }
+
+  unsigned long InfiniSdLog::failures() const {
+    return m_failures;
+  }
+
+  bool InfiniSdLog::openDay(unsigned long day) {
+    end();
+    char date[TIME_DAY_SZ + 1];
+    formatCivilDay(civilFromDays(day), date);
+    char path[sizeof(m_dir) + 32];
+    snprintf(path, sizeof(path), "%s/%s.%s", m_dir, date, m_format == SAMPLE_CSV ? "csv" : "bin");
+
+    bool exists = m_fs.exists(path);
+    m_file = m_fs.open(path, exists ? "r+" : "w+");
+    if (!m_file) {
+      return false;
+    }
+    m_day = day;
+    m_fileBlocks = exists ? m_file.size() / SD_LOG_BLOCK_SZ : 0;
+    // Blocks are written in order, so the used ones are all ahead of the padding.
+    unsigned long lo = 0;
+    unsigned long hi = m_fileBlocks;
+    while (lo < hi) {
+      unsigned long mid = lo + (hi - lo) / 2;
+      if (isBlockUsed(mid)) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    m_blockIndex = lo;
+    if (m_format == SAMPLE_CSV && m_blockIndex == 0) {
+      InfiniBufferPrint out((char *)m_block, SD_LOG_BLOCK_SZ);
+      writeGeneralStatusCsvHeader(out);
+      m_blockLen = out.length();
+    }
+    return true;
+  }
+
+  bool InfiniSdLog::writeBlock() {
+    if (m_blockIndex >= m_fileBlocks) {
+      BYTE pad[SD_LOG_BLOCK_SZ];
+      memset(pad, padByte(), sizeof(pad));
+      if (!m_file.seek(m_fileBlocks * SD_LOG_BLOCK_SZ)) {
+        return false;
+      }
+      unsigned long grow = m_blockIndex - m_fileBlocks + SD_LOG_GROW_BLOCKS;
+      for (unsigned long i = 0; i < grow; ++i) {
+        if (m_file.write(pad, sizeof(pad)) != sizeof(pad)) {
+          return false;
+        }
+        m_fileBlocks++;
+      }
+      // The new size goes to the directory once, not with every block.
+      m_file.flush();
+    }
+    if (!m_file.seek(m_blockIndex * SD_LOG_BLOCK_SZ) || m_file.write(m_block, SD_LOG_BLOCK_SZ) != SD_LOG_BLOCK_SZ) {
+      return false;
+    }
+    m_file.flush();
+    return true;
+  }
+
+  bool InfiniSdLog::isBlockUsed(unsigned long index) {
+    if (!m_file.seek(index * SD_LOG_BLOCK_SZ)) {
+      return false;
+    }
+    int first = m_file.read();
+    return first >= 0 && first != padByte();
+  }
+
+  BYTE InfiniSdLog::padByte() const {
+    return m_format == SAMPLE_CSV ? '\n' : 0xFF;
+  }
+}
+
+#endif
+#endif
@@ -0,0 +1,94 @@
+#ifndef INFINI_SD_LOG_H
+#define INFINI_SD_LOG_H
+
+#include "InfiniSampleFanout.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <FS.h>
+
+// Bytes written to the card at once, the sector size of SD cards. Records never straddle two blocks.
+#ifndef INFI_SD_LOG_BLOCK_SZ
+#define INFI_SD_LOG_BLOCK_SZ 512
+#endif
+
+// Blocks a day file grows by at a time, padding written ahead of the samples so FAT allocates the
+// clusters in bulk instead of for every block. 8640 allocates a whole day of 1 Hz binary samples when it starts.
+#ifndef INFI_SD_LOG_GROW_BLOCKS
+#define INFI_SD_LOG_GROW_BLOCKS 64
+#endif
+
+namespace INFI {
+
+  const size_t SD_LOG_BLOCK_SZ = INFI_SD_LOG_BLOCK_SZ;
+  const unsigned long SD_LOG_GROW_BLOCKS = INFI_SD_LOG_GROW_BLOCKS;
+
+  /*!
+   * A long term log of GS samples on an SD card, one file per UTC day, e.g. /gs/20240131.bin.
+   * Records are the writeGsSampleBinary() ones or writeGeneralStatusCsv() lines. They are gathered in a RAM block
+   * and the card only sees whole, block aligned writes, one per full block, into space that was allocated ahead,
+   * so a sample costs a memcpy rather than a FAT append that updates the directory and the allocation table.
+   * Space a block has left once the next record does not fit, and the space allocated ahead, is padding:
+   * 0xFF in binary files, which no record starts with, newlines in CSV ones.
+   * On begin() and every new day, the first padding block of the file is found with a binary search,
+   * so samples go on after the last block written, even across a reboot.
+   * Up to a block of samples is lost on a reset, flush() writes the partial block, e.g. before a deep sleep.
+   * Driven from loop() or an InfiniSampleFanout sink, not thread safe.
+   */
+  class InfiniSdLog {
+    public:
+    //! fs is the mounted card, e.g. SD or SD_MMC. format is SAMPLE_BINARY_STAMPED or SAMPLE_CSV. dir is at most 16 chars.
+    InfiniSdLog(fs::FS &fs, SAMPLE_FORMAT format = SAMPLE_BINARY_STAMPED, const char *dir = "/gs");
+    ~InfiniSdLog();
+
+    //! Creates dir if needed. Call once the card is mounted. False if the format is not one the log takes.
+    bool begin();
+
+    //! Logs a sample, tsMs is its Unix ms. False if it has no time or the card write failed.
+    bool append(const GeneralStatusFixed &gs, uint64_t tsMs);
+
+    //! Logs an already serialized record in the log's format, e.g. from an InfiniSampleFanout buffer.
+    bool appendRecord(const char *record, size_t len, uint64_t tsMs);
+
+    //! An InfiniSampleFanout sink, context is the InfiniSdLog. Add it with the log's format.
+    static void sink(const InfiniSampleBuffer &buffer, void *context);
+
+    //! Writes the partial block, padded. Samples appended later go into the same block, written again.
+    bool flush();
+
+    //! Closes the day file, after a flush().
+    void end();
+
+    //! Samples not logged, without a time, larger than a block, or lost to a failed write.
+    unsigned long dropped() const;
+    //! Day files that would not open and block writes that failed, e.g. to tell a card gone bad.
+    unsigned long failures() const;
+
+    private:
+    //! Opens the file of day, days since 1970, flushing and closing the previous one.
+    bool openDay(unsigned long day);
+    //! Writes the current block at m_blockIndex, growing the file first if needed.
+    bool writeBlock();
+    //! Whether block index of the open file holds records.
+    bool isBlockUsed(unsigned long index);
+    BYTE padByte() const;
+
+    fs::FS &m_fs;
+    SAMPLE_FORMAT m_format;
+    char m_dir[17];
+    fs::File m_file;
+    //! The open day, 0 if none.
+    unsigned long m_day;
+    //! The block being filled, where it goes in the file, and the blocks the file holds.
+    BYTE m_block[SD_LOG_BLOCK_SZ];
+    size_t m_blockLen;
+    WORD m_blockRecords;
+    unsigned long m_blockIndex;
+    unsigned long m_fileBlocks;
+    unsigned long m_dropped;
+    unsigned long m_failures;
+  };
+}
+
+#endif
+#endif
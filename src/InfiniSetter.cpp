@@ -0,0 +1,187 @@
+#include "InfiniSetter.h"
+
+#if INFI_MODULE_SCHEDULER
+#include "InfiniClock.h"
+
+namespace INFI {
+
+  static bool contains(const ChargingCurrents &currents, WORD amps) {
+    for (BYTE i = 0; i < currents.count; ++i) {
+      if (currents.values[i] == amps) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The switch of a Pxy letter code, NULL for one FLAG does not have.
+  static const bool *flagOf(const EnableDisableStatus &flags, char code) {
+    switch (code) {
+      case 'A': return &flags.buzzer;
+      case 'B': return &flags.overloadBypass;
+      case 'C': return &flags.lcdEscape;
+      case 'D': return &flags.overloadRestart;
+      case 'E': return &flags.overTempRestart;
+      case 'F': return &flags.backlight;
+      case 'G': return &flags.primarySourceInterruptAlarm;
+      case 'H': return &flags.faultCodeRecord;
+      case 'I': return &flags.gridTie;
+      default: return NULL;
+    }
+  }
+
+  InfiniSetter::InfiniSetter(InfiniCommandQueue &queue, InfiniCommandSender &sender) :
+    m_queue(queue),
+    m_sender(sender),
+    m_piriMachine(0),
+    m_hasPiri(false),
+    m_hasFlags(false)
+  {
+    m_maxChargingCurrents.count = 0;
+    m_maxAcChargingCurrents.count = 0;
+  }
+
+  void InfiniSetter::setChargingCurrents(COMMAND_TYPE query, const ChargingCurrents &currents) {
+    if (query == QUERY_MAX_CHARGING_CURRENT) {
+      m_maxChargingCurrents = currents;
+    } else if (query == QUERY_MAX_AC_CHARGING_CURRENT) {
+      m_maxAcChargingCurrents = currents;
+    }
+  }
+
+  bool InfiniSetter::isChargingCurrent(COMMAND_TYPE commandType, WORD amps) const {
+    if (commandType == SET_MAX_CHARGING_CURRENT) {
+      return contains(m_maxChargingCurrents, amps);
+    }
+    if (commandType == SET_MAX_AC_CHARGING_CURRENT) {
+      return contains(m_maxAcChargingCurrents, amps);
+    }
+    return false;
+  }
+
+  void InfiniSetter::updateSettings(const RatedInformation &piri, BYTE machine) {
+    m_piri = piri;
+    m_piriMachine = machine;
+    m_hasPiri = true;
+  }
+
+  void InfiniSetter::updateFlags(const EnableDisableStatus &flags) {
+    m_flags = flags;
+    m_hasFlags = true;
+  }
+
+  void InfiniSetter::invalidateSettings() {
+    m_hasPiri = false;
+    m_hasFlags = false;
+  }
+
+  bool InfiniSetter::isUnchanged(COMMAND_TYPE commandType, BYTE machine, unsigned long value) const {
+    if (!m_hasPiri) {
+      return false;
+    }
+    switch (commandType) {
+      case SET_OUTPUT_SOURCE_PRIORITY:
+        return m_piri.outSourcePriority == value;
+      case SET_SOLAR_POWER_PRIORITY:
+        return m_piri.solarPowerPriority == value;
+      case SET_BATTERY_TYPE:
+        return m_piri.battType == value;
+      case SET_CHARGING_SOURCE_PRIORITY:
+        return machine == m_piriMachine && m_piri.chargerSourcePriority == value;
+      case SET_MAX_CHARGING_CURRENT:
+        return machine == m_piriMachine && m_piri.maxChargingCurr == value;
+      case SET_MAX_AC_CHARGING_CURRENT:
+        return machine == m_piriMachine && m_piri.maxACChargingCurr == value;
+      case AC_OUT_FREQ_50:
+        return m_piri.acOutFreqDeci == 500;
+      case AC_OUT_FREQ_60:
+        return m_piri.acOutFreqDeci == 600;
+      default:
+        return false;
+    }
+  }
+
+  bool InfiniSetter::isFlagUnchanged(char code, bool enable) const {
+    const bool *flag = flagOf(m_flags, code);
+    return m_hasFlags && flag != NULL && *flag == enable;
+  }
+
+  SET_RESULT InfiniSetter::setOutputSourcePriority(OUTPUT_SOURCE_PRIORITY priority) {
+    return send(SET_OUTPUT_SOURCE_PRIORITY, 0, priority);
+  }
+
+  SET_RESULT InfiniSetter::setChargingSourcePriority(BYTE machine, CHARGER_SOURCE_PRIORITY priority) {
+    return send(SET_CHARGING_SOURCE_PRIORITY, machine, priority);
+  }
+
+  SET_RESULT InfiniSetter::setSolarPowerPriority(SOLAR_POWER_PRIORITY priority) {
+    return send(SET_SOLAR_POWER_PRIORITY, 0, priority);
+  }
+
+  SET_RESULT InfiniSetter::setBatteryType(BATTERY_TYPE type) {
+    return send(SET_BATTERY_TYPE, 0, type);
+  }
+
+  SET_RESULT InfiniSetter::setMaxChargingCurrent(BYTE machine, WORD amps) {
+    return send(SET_MAX_CHARGING_CURRENT, machine, amps);
+  }
+
+  SET_RESULT InfiniSetter::setMaxAcChargingCurrent(BYTE machine, WORD amps) {
+    return send(SET_MAX_AC_CHARGING_CURRENT, machine, amps);
+  }
+
+  SET_RESULT InfiniSetter::setOutputFrequency(BYTE hz) {
+    if (hz != 50 && hz != 60) {
+      return SET_INVALID;
+    }
+    return send(hz == 50 ? AC_OUT_FREQ_50 : AC_OUT_FREQ_60, 0, 0);
+  }
+
+  SET_RESULT InfiniSetter::setDateTime(unsigned long seconds) {
+    return send(SET_DATE_TIME, 0, seconds);
+  }
+
+  bool InfiniSetter::makeParams(COMMAND_TYPE commandType, BYTE machine, unsigned long value, char *out) const {
+    out[0] = '\0';
+    switch (commandType) {
+      case SET_OUTPUT_SOURCE_PRIORITY:
+      case SET_SOLAR_POWER_PRIORITY:
+      case SET_BATTERY_TYPE:
+        return value < getSettingValueCount(commandType) &&
+               makeSettingParams(commandType, value, out, MAX_PARAMS_SZ) > 0;
+      case SET_CHARGING_SOURCE_PRIORITY:
+        return value < getSettingValueCount(commandType) &&
+               makeParallelParams(commandType, machine, value, out, MAX_PARAMS_SZ) > 0;
+      case SET_MAX_CHARGING_CURRENT:
+      case SET_MAX_AC_CHARGING_CURRENT:
+        return value <= 0xFFFF && isChargingCurrent(commandType, value) &&
+               makeParallelParams(commandType, machine, value, out, MAX_PARAMS_SZ) > 0;
+      case AC_OUT_FREQ_50:
+      case AC_OUT_FREQ_60:
+        return true;
+      case SET_DATE_TIME:
+        return InfiniClock::formatDateTime(value, out);
+      default:
+        // P takes a letter, not a value.
+        return false;
+    }
+  }
+
+  SET_RESULT InfiniSetter::send(COMMAND_TYPE commandType, BYTE machine, unsigned long value) {
+    char params[MAX_PARAMS_SZ];
+    if (!makeParams(commandType, machine, value, params)) {
+      return SET_INVALID;
+    }
+    if (isUnchanged(commandType, machine, value)) {
+      return SET_UNCHANGED;
+    }
+    SEND_STATUS status = m_queue.sendBlocking(commandType, params);
+    if (status == SEND_COMPLETE && m_sender.response.error == RESP_OK) {
+      // Whatever else the SET changed shows with the next PIRI.
+      invalidateSettings();
+      return SET_ACCEPTED;
+    }
+    return status == SEND_COMPLETE && m_sender.response.error == RESP_NAK ? SET_REFUSED : SET_FAILED;
+  }
+}
+#endif
@@ -0,0 +1,91 @@
+#ifndef INFINI_SETTER_H
+#define INFINI_SETTER_H
+
+#include "InfiniCommandQueue.h"
+#include "InfiniCommandMaker.h"
+#include "InfiniDataTypes.h"
+
+namespace INFI {
+
+  //! How an InfiniSetter call ended.
+  enum SET_RESULT {
+    SET_ACCEPTED = 0, // The inverter answered ^1.
+    SET_REFUSED,      // The inverter answered ^0.
+    SET_FAILED,       // No valid reply, or the link was down. It may have been applied.
+    SET_INVALID,      // The value is not one the inverter takes. Nothing was sent.
+    SET_UNCHANGED     // The inverter has that value already, see InfiniSetter::isUnchanged(). Nothing was sent.
+  };
+
+  /*!
+   * Typed ^S commands, so callers pass an enum or a number instead of building the params themselves.
+   * Each value is checked before anything is sent: the enums against the values the command takes, the
+   * charging currents against the last MCHGCR and MUCHGCR reply given to setChargingCurrents(), the date
+   * against what DAT can hold. The digits are written straight into the params, there is no printf.
+   * The set calls block like InfiniCommandQueue::sendBlocking(), the make calls only encode, e.g. for
+   * InfiniSettingsBatch::add().
+   * Given the last PIRI and FLAG replies, it also tells a SET that would change nothing, which the set calls
+   * then answer with SET_UNCHANGED without touching the link. A dashboard re-sending the current value costs
+   * a serial transaction otherwise, and some settings restart the charger even when set to what they were.
+   */
+  class InfiniSetter {
+    public:
+    InfiniSetter(InfiniCommandQueue &queue, InfiniCommandSender &sender);
+
+    /*! Keeps the currents a MCHGCR or MUCHGCR reply lists, query says which.
+     * Until one came in, every current for its SET command is taken for invalid.
+     */
+    void setChargingCurrents(COMMAND_TYPE query, const ChargingCurrents &currents);
+
+    //! Whether amps is in the list kept for SET_MAX_CHARGING_CURRENT or SET_MAX_AC_CHARGING_CURRENT.
+    bool isChargingCurrent(COMMAND_TYPE commandType, WORD amps) const;
+
+    //! Keeps the settings of a PIRI reply of the parallel machine machine, for isUnchanged().
+    void updateSettings(const RatedInformation &piri, BYTE machine = 0);
+    //! Keeps the switches of a FLAG reply, for isFlagUnchanged().
+    void updateFlags(const EnableDisableStatus &flags);
+    /*! Forgets what updateSettings() and updateFlags() kept, until they are called again, e.g. when GS raises
+     * settingsChanged or a SET went out through the queue. Also makes the next set call send regardless.
+     */
+    void invalidateSettings();
+
+    /*! Whether commandType with value, for machine, is what the last updateSettings() holds already.
+     * False if that is not known: nothing was kept, the command is not in PIRI, e.g. DAT, or it is addressed
+     * to another parallel machine.
+     */
+    bool isUnchanged(COMMAND_TYPE commandType, BYTE machine, unsigned long value) const;
+    //! The same for SET_ENABLE_DISABLE_STATUS, code is the switch's letter, 'A' to 'I', enable whether it goes on.
+    bool isFlagUnchanged(char code, bool enable) const;
+
+    SET_RESULT setOutputSourcePriority(OUTPUT_SOURCE_PRIORITY priority);
+    SET_RESULT setChargingSourcePriority(BYTE machine, CHARGER_SOURCE_PRIORITY priority);
+    SET_RESULT setSolarPowerPriority(SOLAR_POWER_PRIORITY priority);
+    SET_RESULT setBatteryType(BATTERY_TYPE type);
+    SET_RESULT setMaxChargingCurrent(BYTE machine, WORD amps);
+    SET_RESULT setMaxAcChargingCurrent(BYTE machine, WORD amps);
+    //! F50 or F60, hz is either 50 or 60.
+    SET_RESULT setOutputFrequency(BYTE hz);
+    //! DAT, seconds since 2000-01-01 in the inverter's local time, see InfiniClock.
+    SET_RESULT setDateTime(unsigned long seconds);
+
+    /*! Writes the params of commandType with value into out, at least MAX_PARAMS_SZ chars, as the set call
+     * for it would send them. machine is only used by the parallel addressed commands, seconds since 2000
+     * are the value of DAT. Returns false, with out empty, if the set call would return SET_INVALID.
+     */
+    bool makeParams(COMMAND_TYPE commandType, BYTE machine, unsigned long value, char *out) const;
+
+    private:
+    SET_RESULT send(COMMAND_TYPE commandType, BYTE machine, unsigned long value);
+
+    InfiniCommandQueue &m_queue;
+    InfiniCommandSender &m_sender;
+    ChargingCurrents m_maxChargingCurrents;
+    ChargingCurrents m_maxAcChargingCurrents;
+    RatedInformation m_piri;
+    BYTE m_piriMachine;
+    bool m_hasPiri;
+    EnableDisableStatus m_flags;
+    bool m_hasFlags;
+  };
+}
+
+#endif
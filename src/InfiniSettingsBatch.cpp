@@ -0,0 +1,198 @@
+#include "InfiniSettingsBatch.h"
+
+#if INFI_MODULE_SCHEDULER
+#include <string.h>
+#include "InfiniCommandMaker.h"
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+
+  static const char BATCH_RESULT_NAMES[][8] INFI_PROGMEM = { "ok", "refused", "failed", "noPrior" };
+
+  //! The FLAG field that the letter n of a ^S P<m><n> command switches, NULL for an unknown letter.
+  static bool *flagField(EnableDisableStatus &flag, char letter) {
+    switch (letter) {
+      case 'A': return &flag.buzzer;
+      case 'B': return &flag.overloadBypass;
+      case 'C': return &flag.lcdEscape;
+      case 'D': return &flag.overloadRestart;
+      case 'E': return &flag.overTempRestart;
+      case 'F': return &flag.backlight;
+      case 'G': return &flag.primarySourceInterruptAlarm;
+      case 'H': return &flag.faultCodeRecord;
+      case 'I': return &flag.gridTie;
+      default: return NULL;
+    }
+  }
+
+  InfiniSettingsBatch::InfiniSettingsBatch(InfiniCommandQueue &queue, InfiniCommandSender &sender,
+                                           InfiniResponseParser &parser) :
+    m_queue(queue),
+    m_sender(sender),
+    m_parser(parser),
+    m_size(0),
+    m_accepted(0),
+    m_restored(0),
+    m_result(BATCH_OK)
+  {}
+
+  bool InfiniSettingsBatch::add(COMMAND_TYPE commandType, const char *params) {
+    if (m_size >= SETTINGS_BATCH_SZ || commandType >= NUM_COMMAND_TYPES || getActionType(commandType) != UPDATE) {
+      return false;
+    }
+    Command &command = m_commands[m_size++];
+    command.commandType = commandType;
+    command.params[0] = '\0';
+    if (params != NULL) {
+      strncpy(command.params, params, MAX_PARAMS_SZ - 1);
+      command.params[MAX_PARAMS_SZ - 1] = '\0';
+    }
+    return true;
+  }
+
+  void InfiniSettingsBatch::clear() {
+    m_size = 0;
+    m_accepted = 0;
+    m_restored = 0;
+    m_result = BATCH_OK;
+  }
+
+  BYTE InfiniSettingsBatch::size() const {
+    return m_size;
+  }
+
+  BATCH_RESULT InfiniSettingsBatch::run(bool rollback) {
+    m_accepted = 0;
+    m_restored = 0;
+    if (rollback && !readPrior()) {
+      m_result = BATCH_NO_PRIOR;
+      return m_result;
+    }
+    m_result = BATCH_OK;
+    for (; m_accepted < m_size; ++m_accepted) {
+      SEND_STATUS status;
+      if (!send(m_commands[m_accepted], status)) {
+        m_result = (status == SEND_COMPLETE && m_sender.response.error == RESP_NAK) ? BATCH_REFUSED : BATCH_FAILED;
+        break;
+      }
+    }
+    if (rollback && m_result != BATCH_OK) {
+      rollBack();
+    }
+    return m_result;
+  }
+
+  BYTE InfiniSettingsBatch::accepted() const {
+    return m_accepted;
+  }
+
+  BYTE InfiniSettingsBatch::failed() const {
+    return m_result == BATCH_OK || m_result == BATCH_NO_PRIOR ? m_size : m_accepted;
+  }
+
+  BYTE InfiniSettingsBatch::restored() const {
+    return m_restored;
+  }
+
+  BATCH_RESULT InfiniSettingsBatch::result() const {
+    return m_result;
+  }
+
+#if INFI_MODULE_JSON
+  size_t InfiniSettingsBatch::writeJson(Print &out) const {
+    size_t n = out.print(INFI_F("{\"result\":\""));
+    n += out.print(INFI_FLASH(BATCH_RESULT_NAMES[m_result]));
+    n += out.print('"');
+    n += writeJsonFieldP(out, INFI_PSTR("accepted"), m_accepted, JSON_UINT, false);
+    if (failed() < m_size) {
+      n += out.print(INFI_F(",\"failed\":\""));
+      n += out.print(getCommandDescriptor(m_commands[failed()].commandType).mnemonic);
+      n += out.print('"');
+    }
+    n += writeJsonFieldP(out, INFI_PSTR("restored"), m_restored, JSON_UINT, false);
+    n += out.print('}');
+    return n;
+  }
+#endif
+
+  bool InfiniSettingsBatch::readPrior() {
+    bool needFlag = false;
+    for (BYTE i = 0; i < m_size; ++i) {
+      needFlag |= m_commands[i].commandType == SET_ENABLE_DISABLE_STATUS;
+    }
+    if (m_queue.sendBlocking(QUERY_RATED_INFORMATION, "") != SEND_COMPLETE
+        || !m_parser.fromPIRIToRatedInformation(m_sender.response.val, m_sender.response.actualLen, m_piri)) {
+      return false;
+    }
+    if (needFlag && (m_queue.sendBlocking(QUERY_ENABLE_DISABLE_STATUS, "") != SEND_COMPLETE
+        || !m_parser.fromFLAGToEnableDisableStatus(m_sender.response.val, m_sender.response.actualLen, m_flag))) {
+      return false;
+    }
+    return true;
+  }
+
+  bool InfiniSettingsBatch::makeUndo(const Command &command, Command &undo) const {
+    undo.commandType = command.commandType;
+    undo.params[0] = '\0';
+    // Parallel addressed commands are reverted on the machine they went to.
+    const BYTE machine = isParallelAddressed(command.commandType) && command.params[1] == ',' ? command.params[0] - '0' : 0;
+    BYTE value;
+    switch (command.commandType) {
+      case SET_ENABLE_DISABLE_STATUS: {
+        EnableDisableStatus flag = m_flag;
+        bool *field = flagField(flag, command.params[1]);
+        if (field == NULL) {
+          return false;
+        }
+        undo.params[0] = *field ? 'E' : 'D';
+        undo.params[1] = command.params[1];
+        undo.params[2] = '\0';
+        return true;
+      }
+      case AC_OUT_FREQ_50:
+      case AC_OUT_FREQ_60:
+        undo.commandType = m_piri.acOutFreqDeci < 550 ? AC_OUT_FREQ_50 : AC_OUT_FREQ_60;
+        return true;
+      case SET_OUTPUT_SOURCE_PRIORITY:
+        value = m_piri.outSourcePriority;
+        break;
+      case SET_SOLAR_POWER_PRIORITY:
+        value = m_piri.solarPowerPriority;
+        break;
+      case SET_BATTERY_TYPE:
+        value = m_piri.battType;
+        break;
+      case SET_CHARGING_SOURCE_PRIORITY:
+        return makeParallelParams(command.commandType, machine, m_piri.chargerSourcePriority,
+                                  undo.params, sizeof(undo.params)) > 0;
+      case SET_MAX_CHARGING_CURRENT:
+        return makeParallelParams(command.commandType, machine, m_piri.maxChargingCurr,
+                                  undo.params, sizeof(undo.params)) > 0;
+      case SET_MAX_AC_CHARGING_CURRENT:
+        return makeParallelParams(command.commandType, machine, m_piri.maxACChargingCurr,
+                                  undo.params, sizeof(undo.params)) > 0;
+      default:
+        // DAT, the clock cannot be put back.
+        return false;
+    }
+    return makeSettingParams(command.commandType, value, undo.params, sizeof(undo.params)) > 0;
+  }
+
+  void InfiniSettingsBatch::rollBack() {
+    // The failed command too, unless the inverter refused it: it may have been applied before the reply got lost.
+    BYTE count = m_result == BATCH_FAILED ? m_accepted + 1 : m_accepted;
+    for (BYTE i = count; i > 0; --i) {
+      Command undo;
+      SEND_STATUS status;
+      if (makeUndo(m_commands[i - 1], undo) && send(undo, status)) {
+        m_restored++;
+      }
+    }
+  }
+
+  bool InfiniSettingsBatch::send(const Command &command, SEND_STATUS &status) {
+    status = m_queue.sendBlocking(command.commandType, command.params);
+    return status == SEND_COMPLETE && m_sender.response.error == RESP_OK;
+  }
+}
+#endif
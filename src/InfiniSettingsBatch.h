@@ -0,0 +1,86 @@
+#ifndef INFINI_SETTINGS_BATCH_H
+#define INFINI_SETTINGS_BATCH_H
+
+#include <Print.h>
+#include "InfiniCommandQueue.h"
+#include "InfiniResponseParser.h"
+
+// SET commands one batch holds, e.g. a whole settings profile pushed by an operator.
+#ifndef INFI_SETTINGS_BATCH_SZ
+#define INFI_SETTINGS_BATCH_SZ 8
+#endif
+
+namespace INFI {
+
+  const BYTE SETTINGS_BATCH_SZ = INFI_SETTINGS_BATCH_SZ;
+
+  //! How InfiniSettingsBatch::run() ended.
+  enum BATCH_RESULT {
+    BATCH_OK = 0,     // Every command was accepted.
+    BATCH_REFUSED,    // The inverter answered ^0 to the failed() command.
+    BATCH_FAILED,     // No valid reply to the failed() command, or the link was down. It may have been applied.
+    BATCH_NO_PRIOR    // A rollback was asked for, but the current settings could not be read. Nothing was sent.
+  };
+
+  /*!
+   * A list of ^S commands sent as one transaction, instead of one RPC and one blocking send each.
+   * run() sends them back to back through InfiniCommandQueue::sendBlocking(), so no poll gets in between,
+   * and stops at the first one the inverter does not accept.
+   * With a rollback, the settings are read from PIRI (and FLAG, if the batch holds a P command) before anything
+   * is sent, and after a failure the commands accepted so far are reverted, newest first, to what was read.
+   * DAT cannot be reverted, the inverter's clock has moved on.
+   */
+  class InfiniSettingsBatch {
+    public:
+    InfiniSettingsBatch(InfiniCommandQueue &queue, InfiniCommandSender &sender, InfiniResponseParser &parser);
+
+    /*! Appends the command. Returns false if it is not an UPDATE or the batch is full.
+     * params longer than MAX_PARAMS_SZ - 1 are trimmed.
+     */
+    bool add(COMMAND_TYPE commandType, const char *params);
+    void clear();
+    BYTE size() const;
+
+    //! Sends the batch, see the class comment. Blocks for about 320 ms per command sent.
+    BATCH_RESULT run(bool rollback = false);
+
+    //! After run(): the commands accepted, the index of the one that was not (size() if none), and how many were reverted.
+    BYTE accepted() const;
+    BYTE failed() const;
+    BYTE restored() const;
+    BATCH_RESULT result() const;
+
+#if INFI_MODULE_JSON
+    //! Writes the outcome of run() as {"result":"refused","accepted":2,"failed":"PBT","restored":2}, for the RPC reply.
+    size_t writeJson(Print &out) const;
+#endif
+
+    private:
+    struct Command {
+      COMMAND_TYPE commandType;
+      char params[MAX_PARAMS_SZ];
+    };
+
+    //! Reads what the rollback restores into m_piri and m_flag.
+    bool readPrior();
+    //! The command that puts back what command changed, from the prior settings. False if there is none.
+    bool makeUndo(const Command &command, Command &undo) const;
+    //! Reverts the first m_accepted commands, newest first.
+    void rollBack();
+    //! Sends one command, true if the inverter answered ^1.
+    bool send(const Command &command, SEND_STATUS &status);
+
+    InfiniCommandQueue &m_queue;
+    InfiniCommandSender &m_sender;
+    InfiniResponseParser &m_parser;
+    Command m_commands[SETTINGS_BATCH_SZ];
+    BYTE m_size;
+    BYTE m_accepted;
+    BYTE m_restored;
+    BATCH_RESULT m_result;
+    RatedInformation m_piri;
+    EnableDisableStatus m_flag;
+  };
+}
+
+#endif
@@ -0,0 +1,250 @@
+#include "InfiniSimulatedInverter.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "InfiniCRC.h"
+#include "InfiniCommandMaker.h"
+
+namespace INFI {
+  // Plausible replies, in COMMAND_TYPE order. NULL for the ^S commands, which are only acked.
+  static const char *const DEFAULT_PAYLOADS[NUM_COMMAND_TYPES] = {
+    "20240315123456",                                                                                             // T
+    "00123456",                                                                                                   // ET
+    "00012345",                                                                                                   // EY
+    "00001234",                                                                                                   // EM
+    "00000123",                                                                                                   // ED
+    "2300,500,2301,500,0450,0400,009,524,000,000,000,012,100,035,030,000,0850,0000,3400,0000,0,2,0,1,1,2,1,0", // GS
+    "2300,500,0200,230,500,0217,5000,500,480,460,540,420,564,1,30,060,0,0,2,9,0,1,0,1,2",                      // PIRI
+    "00,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0",                                                                        // FWS
+    "1,0,1,0,1,1,1,0,0",                                                                                          // FLAG
+    "2300,500,0,440,540,564,460,540,060,30,0,0,2,0,0,0,1,0,1,0,1,1,1,0",                                        // DI
+    "010,020,030,040,050,060,070,080,090,100,110,120,130,140",                                                   // MCHGCR
+    "002,010,020,030,040,050,060",                                                                                // MUCHGCR
+    "18",                                                                                                         // PI
+    "1492932105105335000000",                                                                                     // ID
+    "00123,00000,00000",                                                                                          // VFW
+    "05",                                                                                                         // MOD
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
+  };
+
+  static bool hasPayloadSize(COMMAND_TYPE commandType, const char *payload) {
+    const InfiniCommandDescriptor &desc = getCommandDescriptor(commandType);
+    return desc.actionType == READ && strlen(payload) == (size_t)(desc.respToEndSz - CRC_SZ - END_TOKEN_SZ);
+  }
+
+  InfiniSimulatedInverter::InfiniSimulatedInverter(unsigned long baud, unsigned long turnaroundMs) :
+    m_byteUs(0),
+    m_turnaroundMs(turnaroundMs),
+    m_nak(false),
+    m_corruptPct(0),
+    m_dropPct(0),
+    m_seed(1),
+    m_capture(NULL),
+    m_captureLen(0),
+    m_capturePos(0),
+    m_rxLen(0),
+    m_txLen(0),
+    m_txPos(0),
+    m_txStartUs(0),
+    m_commands(0),
+    m_badCommands(0),
+    m_corrupted(0),
+    m_dropped(0)
+  {
+    setBaud(baud);
+    for (BYTE i = 0; i < NUM_COMMAND_TYPES; ++i) {
+      m_payloads[i] = DEFAULT_PAYLOADS[i];
+    }
+  }
+
+  void InfiniSimulatedInverter::setBaud(unsigned long baud) {
+    m_byteUs = baud == 0 ? 0 : (BITS_PER_WIRE_BYTE * 1000000UL + baud - 1) / baud;
+  }
+
+  void InfiniSimulatedInverter::setTurnaround(unsigned long turnaroundMs) {
+    m_turnaroundMs = turnaroundMs;
+  }
+
+  bool InfiniSimulatedInverter::setPayload(COMMAND_TYPE commandType, const char *payload) {
+    if (commandType >= NUM_COMMAND_TYPES || payload == NULL || !hasPayloadSize(commandType, payload)) {
+      return false;
+    }
+    m_payloads[commandType] = payload;
+    return true;
+  }
+
+  void InfiniSimulatedInverter::setNak(bool nak) {
+    m_nak = nak;
+  }
+
+  void InfiniSimulatedInverter::setFaults(BYTE corruptPct, BYTE dropPct, unsigned long seed) {
+    m_corruptPct = corruptPct;
+    m_dropPct = dropPct;
+    m_seed = (uint32_t)seed;
+  }
+
+  void InfiniSimulatedInverter::replay(const char *capture, size_t len) {
+    m_capture = capture;
+    m_captureLen = capture == NULL ? 0 : len;
+    m_capturePos = 0;
+  }
+
+  void InfiniSimulatedInverter::reset() {
+    m_rxLen = 0;
+    m_txLen = 0;
+    m_txPos = 0;
+  }
+
+  unsigned long InfiniSimulatedInverter::commands() const {
+    return m_commands;
+  }
+
+  unsigned long InfiniSimulatedInverter::badCommands() const {
+    return m_badCommands;
+  }
+
+  unsigned long InfiniSimulatedInverter::corrupted() const {
+    return m_corrupted;
+  }
+
+  unsigned long InfiniSimulatedInverter::dropped() const {
+    return m_dropped;
+  }
+
+  int InfiniSimulatedInverter::available() {
+    return (int)(arrived() - m_txPos);
+  }
+
+  int InfiniSimulatedInverter::read() {
+    if (available() <= 0) {
+      return -1;
+    }
+    BYTE c = (BYTE)m_tx[m_txPos++];
+    if (m_txPos == m_txLen) {
+      m_txLen = 0;
+      m_txPos = 0;
+    }
+    return c;
+  }
+
+  int InfiniSimulatedInverter::peek() {
+    if (available() <= 0) {
+      return -1;
+    }
+    return (BYTE)m_tx[m_txPos];
+  }
+
+  size_t InfiniSimulatedInverter::write(uint8_t c) {
+    // Anything before the start of a frame is line noise.
+    if (m_rxLen == 0 && c != '^') {
+      return 1;
+    }
+    if (m_rxLen == MAX_CMD_SZ) {
+      // Too long for any command, drop it and wait for the next one.
+      m_rxLen = 0;
+      m_badCommands++;
+      return 1;
+    }
+    m_rx[m_rxLen++] = (char)c;
+    if (c == '\r') {
+      respond();
+      m_rxLen = 0;
+    }
+    return 1;
+  }
+
+  COMMAND_TYPE InfiniSimulatedInverter::identify() const {
+    return parseCommandFrame(m_rx, m_rxLen, NULL, 0);
+  }
+
+  void InfiniSimulatedInverter::respond() {
+    m_commands++;
+    m_txLen = 0;
+    m_txPos = 0;
+    if (m_dropPct > 0 && nextPercent() < m_dropPct) {
+      m_dropped++;
+      return;
+    }
+    if (!queueReplayed()) {
+      COMMAND_TYPE commandType = identify();
+      if (commandType == NUM_COMMAND_TYPES) {
+        m_badCommands++;
+        queueAck(false);
+      } else if (getCommandDescriptor(commandType).actionType == UPDATE) {
+        queueAck(!m_nak);
+      } else {
+        const char *payload = m_payloads[commandType];
+        queueReply(payload, strlen(payload));
+      }
+    }
+    if (m_corruptPct > 0 && nextPercent() < m_corruptPct && m_txLen > 2) {
+      // Never the '^' or '\r', so the frame still ends where it should.
+      size_t pos = 1 + nextPercent() % (m_txLen - 2);
+      char flipped = m_tx[pos] ^ 0x01;
+      if (flipped == '\r' || flipped == '^') {
+        flipped = m_tx[pos] ^ 0x02;
+      }
+      m_tx[pos] = flipped;
+      m_corrupted++;
+    }
+    // The command takes its wire time to arrive, then the inverter thinks it over.
+    m_txStartUs = micros() + m_rxLen * m_byteUs + m_turnaroundMs * 1000UL;
+  }
+
+  void InfiniSimulatedInverter::queueReply(const char *payload, size_t payloadLen) {
+    int n = snprintf(m_tx, sizeof(m_tx), "^D%03u", (unsigned int)(payloadLen + CRC_SZ + END_TOKEN_SZ));
+    memcpy(m_tx + n, payload, payloadLen);
+    finishReply(n + payloadLen);
+  }
+
+  void InfiniSimulatedInverter::queueAck(bool ok) {
+    m_tx[0] = '^';
+    m_tx[1] = ok ? '1' : '0';
+    finishReply(START_TOKEN_SZ);
+  }
+
+  bool InfiniSimulatedInverter::queueReplayed() {
+    while (m_capturePos < m_captureLen) {
+      const char *start = m_capture + m_capturePos;
+      const char *end = (const char *)memchr(start, '\r', m_captureLen - m_capturePos);
+      size_t len = end == NULL ? m_captureLen - m_capturePos : (size_t)(end - start) + 1;
+      m_capturePos += len;
+      if (end != NULL && len <= sizeof(m_tx)) {
+        memcpy(m_tx, start, len);
+        m_txLen = len;
+        return true;
+      }
+      // A cut off or oversized frame in the capture, skip it.
+    }
+    return false;
+  }
+
+  void InfiniSimulatedInverter::finishReply(size_t lenWithoutCrc) {
+    WORD crc = calc_crc_half((const BYTE *)m_tx, (BYTE)lenWithoutCrc);
+    m_tx[lenWithoutCrc] = (char)(crc >> 8);
+    m_tx[lenWithoutCrc + 1] = (char)(crc & 0xFF);
+    m_tx[lenWithoutCrc + 2] = '\r';
+    m_txLen = lenWithoutCrc + CRC_SZ + END_TOKEN_SZ;
+  }
+
+  size_t InfiniSimulatedInverter::arrived() const {
+    if (m_txLen == 0) {
+      return 0;
+    }
+    long sinceStartUs = (long)(micros() - m_txStartUs);
+    if (sinceStartUs < 0) {
+      return 0;
+    }
+    if (m_byteUs == 0) {
+      return m_txLen;
+    }
+    size_t bytes = (unsigned long)sinceStartUs / m_byteUs;
+    return bytes < m_txLen ? bytes : m_txLen;
+  }
+
+  BYTE InfiniSimulatedInverter::nextPercent() {
+    // The usual LCG, only needs to be repeatable.
+    m_seed = m_seed * 1103515245UL + 12345UL;
+    return (BYTE)((m_seed >> 16) % 100);
+  }
+}
@@ -0,0 +1,102 @@
+#ifndef INFINI_SIMULATED_INVERTER_H
+#define INFINI_SIMULATED_INVERTER_H
+
+#include <stdint.h>
+#include <Stream.h>
+#include "InfiniCommon.h"
+
+namespace INFI {
+
+  /*!
+   * A Stream that answers P18 command frames like an inverter would, for load tests without one.
+   * Hand it to an InfiniCommandSender in place of the serial port. Every ^P query gets a CRC'd ^D reply
+   * with a canned payload, every ^S command ^1, or ^0 after setNak(). Frames with a bad CRC or an
+   * unknown mnemonic get ^0.
+   *
+   * The reply only becomes readable once the command went out at the simulated baud rate and the
+   * turnaround passed, and then one byte per byte time, so latencies come out as on the wire.
+   * Faults are injected from a seeded generator, so a run can be repeated exactly. A captured session
+   * can be replayed instead of the canned payloads.
+   */
+  class InfiniSimulatedInverter : public Stream {
+    public:
+    //! baud 0 makes each reply readable as soon as the command is complete.
+    InfiniSimulatedInverter(unsigned long baud = SERIAL_BAUD, unsigned long turnaroundMs = TURNAROUND_MS);
+
+    void setBaud(unsigned long baud);
+    void setTurnaround(unsigned long turnaroundMs);
+
+    /*! The data between ^Dxxx and the CRC of the replies to commandType, e.g. "00012345" for ED.
+     * Must match the reply size of COMMAND_DESCRIPTORS, and outlive the simulator as only the pointer is kept.
+     * Returns false, keeping the old one, if the size is wrong or commandType is not a query.
+     */
+    bool setPayload(COMMAND_TYPE commandType, const char *payload);
+
+    //! Answer ^S commands with ^0 instead of ^1.
+    void setNak(bool nak);
+
+    /*! Percentages of replies with one byte flipped, which fails their CRC, and of commands not answered.
+     * seed restarts the generator deciding which.
+     */
+    void setFaults(BYTE corruptPct, BYTE dropPct, unsigned long seed = 1);
+
+    /*! Replies with the frames in capture, in order and whatever was asked, until it runs out.
+     * capture is the raw bytes read from an inverter, each frame ending in '\r'. Only the pointer is kept.
+     */
+    void replay(const char *capture, size_t len);
+
+    //! Drops a reply in progress and anything received since the last complete frame.
+    void reset();
+
+    //! Number of complete command frames received.
+    unsigned long commands() const;
+    //! Frames answered with ^0 for a bad CRC or unknown mnemonic.
+    unsigned long badCommands() const;
+    unsigned long corrupted() const;
+    unsigned long dropped() const;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    private:
+    //! The query or command in m_rx, NUM_COMMAND_TYPES if it is not one.
+    COMMAND_TYPE identify() const;
+    void respond();
+    void queueReply(const char *payload, size_t payloadLen);
+    void queueAck(bool ok);
+    bool queueReplayed();
+    void finishReply(size_t lenWithoutCrc);
+    //! Bytes of the reply readable by now.
+    size_t arrived() const;
+    //! 0 to 99.
+    BYTE nextPercent();
+
+    unsigned long m_byteUs;
+    unsigned long m_turnaroundMs;
+    const char *m_payloads[NUM_COMMAND_TYPES];
+    bool m_nak;
+    BYTE m_corruptPct;
+    BYTE m_dropPct;
+    uint32_t m_seed;
+    const char *m_capture;
+    size_t m_captureLen;
+    size_t m_capturePos;
+
+    char m_rx[MAX_CMD_SZ];
+    BYTE m_rxLen;
+    char m_tx[MAX_RESPONSE_SZ];
+    size_t m_txLen;
+    size_t m_txPos;
+    unsigned long m_txStartUs;
+
+    unsigned long m_commands;
+    unsigned long m_badCommands;
+    unsigned long m_corrupted;
+    unsigned long m_dropped;
+  };
+}
+
+#endif
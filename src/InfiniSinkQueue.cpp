@@ -0,0 +1,233 @@
+#include "InfiniSinkQueue.h"
+
+#if INFI_MODULE_SINKS
+#include <string.h>
+
+namespace INFI {
+
+  static_assert(SINK_QUEUE_SLOTS <= 32, "m_used has a bit per slot");
+
+  InfiniSinkQueue::InfiniSinkQueue(char *storage, size_t storageSize, size_t slotSize, SINK_POLICY policy) :
+    m_storage(storage),
+    m_slotSize(slotSize),
+    m_slots(0),
+    m_policy(policy),
+    m_keepOneIn(4),
+    m_offered(0),
+    m_congested(false),
+    m_spill(NULL),
+    m_spillContext(NULL),
+    m_count(0),
+    m_used(0),
+    m_pushed(0),
+    m_dropped(0),
+    m_downsampled(0),
+    m_spilled(0),
+    m_refused(0),
+    m_highWater(0)
+  {
+    const size_t slots = storage != NULL && slotSize > 0 ? storageSize / slotSize : 0;
+    m_slots = slots < SINK_QUEUE_SLOTS ? (BYTE)slots : SINK_QUEUE_SLOTS;
+    m_high = (BYTE)((m_slots * 3 + 3) / 4);
+    m_low = m_slots / 4;
+  }
+
+  void InfiniSinkQueue::setWatermarks(BYTE high, BYTE low) {
+    m_high = high < m_slots ? high : m_slots;
+    m_low = low < m_high ? low : (m_high > 0 ? m_high - 1 : 0);
+    updateCongestion();
+  }
+
+  void InfiniSinkQueue::setDownsample(BYTE keepOneIn) {
+    m_keepOneIn = keepOneIn > 0 ? keepOneIn : 1;
+  }
+
+  void InfiniSinkQueue::setSpill(SinkConsumer spill, void *context) {
+    m_spill = spill;
+    m_spillContext = context;
+  }
+
+  bool InfiniSinkQueue::push(const void *data, size_t len, uint64_t tsMs, BYTE deviceId, SINK_PRIORITY priority) {
+    if (m_slots == 0 || len > m_slotSize) {
+      m_refused++;
+      return false;
+    }
+    if (priority == SINK_PRIORITY_NORMAL && m_congested) {
+      if (m_policy == SINK_DOWNSAMPLE && m_offered++ % m_keepOneIn != 0) {
+        m_downsampled++;
+        return false;
+      }
+      // What the spill callback does not take is left to the drop below, once full.
+      while (m_policy == SINK_SPILL && m_count >= m_high && spillOldest()) {
+      }
+    }
+    if (m_count >= m_slots) {
+      if (priority == SINK_PRIORITY_NORMAL && m_policy == SINK_BLOCK) {
+        m_refused++;
+        return false;
+      }
+      if (!(m_policy == SINK_SPILL && spillOldest())) {
+        const BYTE oldest = oldestNormal();
+        if (oldest == m_count) {
+          // All events, none of them goes for another.
+          m_refused++;
+          return false;
+        }
+        remove(oldest);
+        m_dropped++;
+      }
+    }
+    BYTE slot = 0;
+    while (m_used & (1UL << slot)) {
+      slot++;
+    }
+    m_used |= 1UL << slot;
+    memcpy(m_storage + slot * m_slotSize, data, len);
+    Meta &meta = m_items[m_count++];
+    meta.tsMs = tsMs;
+    meta.len = len;
+    meta.slot = slot;
+    meta.deviceId = deviceId;
+    meta.priority = (BYTE)priority;
+    m_pushed++;
+    if (m_count > m_highWater) {
+      m_highWater = m_count;
+    }
+    updateCongestion();
+    return true;
+  }
+
+  BYTE InfiniSinkQueue::drain(SinkConsumer consumer, void *context, BYTE maxItems) {
+    BYTE delivered = 0;
+    while (delivered < maxItems && m_count > 0) {
+      const BYTE index = next();
+      if (!consumer(item(index), context)) {
+        break;
+      }
+      remove(index);
+      delivered++;
+    }
+    return delivered;
+  }
+
+  BYTE InfiniSinkQueue::peek(SinkItem *items, BYTE maxItems) const {
+    BYTE n = 0;
+    // The events, then the rest, both in the order pushed.
+    for (BYTE pass = 0; pass < 2; ++pass) {
+      const BYTE priority = pass == 0 ? SINK_PRIORITY_EVENT : SINK_PRIORITY_NORMAL;
+      for (BYTE i = 0; i < m_count && n < maxItems; ++i) {
+        if (m_items[i].priority == priority) {
+          items[n++] = item(i);
+        }
+      }
+    }
+    return n;
+  }
+
+  void InfiniSinkQueue::pop(BYTE count) {
+    for (BYTE i = 0; i < count && m_count > 0; ++i) {
+      remove(next());
+    }
+  }
+
+  void InfiniSinkQueue::clear() {
+    m_count = 0;
+    m_used = 0;
+    updateCongestion();
+  }
+
+  BYTE InfiniSinkQueue::size() const {
+    return m_count;
+  }
+
+  BYTE InfiniSinkQueue::capacity() const {
+    return m_slots;
+  }
+
+  bool InfiniSinkQueue::isEmpty() const {
+    return m_count == 0;
+  }
+
+  bool InfiniSinkQueue::isCongested() const {
+    return m_congested;
+  }
+
+  unsigned long InfiniSinkQueue::pushed() const {
+    return m_pushed;
+  }
+
+  unsigned long InfiniSinkQueue::dropped() const {
+    return m_dropped;
+  }
+
+  unsigned long InfiniSinkQueue::downsampled() const {
+    return m_downsampled;
+  }
+
+  unsigned long InfiniSinkQueue::spilled() const {
+    return m_spilled;
+  }
+
+  unsigned long InfiniSinkQueue::refused() const {
+    return m_refused;
+  }
+
+  BYTE InfiniSinkQueue::highWater() const {
+    return m_highWater;
+  }
+
+  BYTE InfiniSinkQueue::next() const {
+    for (BYTE i = 0; i < m_count; ++i) {
+      if (m_items[i].priority == SINK_PRIORITY_EVENT) {
+        return i;
+      }
+    }
+    return 0;
+  }
+
+  BYTE InfiniSinkQueue::oldestNormal() const {
+    BYTE i = 0;
+    while (i < m_count && m_items[i].priority != SINK_PRIORITY_NORMAL) {
+      i++;
+    }
+    return i;
+  }
+
+  SinkItem InfiniSinkQueue::item(BYTE index) const {
+    const Meta &meta = m_items[index];
+    SinkItem item;
+    item.data = m_storage + meta.slot * m_slotSize;
+    item.len = meta.len;
+    item.tsMs = meta.tsMs;
+    item.deviceId = meta.deviceId;
+    item.priority = (SINK_PRIORITY)meta.priority;
+    return item;
+  }
+
+  void InfiniSinkQueue::remove(BYTE index) {
+    m_used &= ~(1UL << m_items[index].slot);
+    memmove(&m_items[index], &m_items[index + 1], (m_count - index - 1) * sizeof(Meta));
+    m_count--;
+    updateCongestion();
+  }
+
+  bool InfiniSinkQueue::spillOldest() {
+    const BYTE oldest = oldestNormal();
+    if (m_spill == NULL || oldest == m_count || !m_spill(item(oldest), m_spillContext)) {
+      return false;
+    }
+    remove(oldest);
+    m_spilled++;
+    return true;
+  }
+
+  void InfiniSinkQueue::updateCongestion() {
+    if (m_count >= m_high && m_high > 0) {
+      m_congested = true;
+    } else if (m_count <= m_low) {
+      m_congested = false;
+      m_offered = 0;
+    }
+  }
+}
+#endif
@@ -0,0 +1,140 @@
+#ifndef INFINI_SINK_QUEUE_H
+#define INFINI_SINK_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "InfiniCommon.h"
+
+// Items one queue holds at most, however much storage it is given.
+#ifndef INFI_SINK_QUEUE_SLOTS
+#define INFI_SINK_QUEUE_SLOTS 16
+#endif
+
+namespace INFI {
+
+  const BYTE SINK_QUEUE_SLOTS = INFI_SINK_QUEUE_SLOTS;
+
+  //! What an InfiniSinkQueue does with a normal item its consumer is too slow for.
+  enum SINK_POLICY {
+    SINK_BLOCK = 0,    // Refuses it once full, the producer keeps it. Nothing is ever waited for.
+    SINK_DROP_OLDEST,  // Makes room by dropping the oldest normal item once full.
+    SINK_DOWNSAMPLE,   // Keeps 1 in N above the high watermark, then drops the oldest once full.
+    SINK_SPILL         // Hands the oldest normal items to the spill callback above the high watermark, e.g. to flash.
+  };
+
+  enum SINK_PRIORITY {
+    SINK_PRIORITY_NORMAL = 0,  // A sample, another one comes soon.
+    SINK_PRIORITY_EVENT        // An alarm or a fault, never dropped for a normal item and delivered ahead of them.
+  };
+
+  //! One queued item, data is valid until it is delivered or dropped.
+  struct SinkItem {
+    const char *data;
+    size_t len;
+    uint64_t tsMs;
+    BYTE deviceId;
+    SINK_PRIORITY priority;
+  };
+
+  //! Takes item. Returns false if it cannot right now, e.g. a stalled write, and the item stays queued.
+  typedef bool (*SinkConsumer)(const SinkItem &item, void *context);
+
+  /*!
+   * A bounded queue between a producer that must not wait, the polling loop, and a consumer that may,
+   * e.g. an SD card or a broker. The producer push()es and returns at once, the consumer is drain()ed a few items
+   * at a time where waiting is fine. Items are copied into fixed size slots of the storage given, so the queue
+   * never takes more memory than that, however long the consumer is away.
+   *
+   * The policy says what a normal item costs once the consumer falls behind, see SINK_POLICY. The queue is
+   * congested from the high watermark until it is back down to the low one. Event items are never downsampled
+   * or spilled, they push out the oldest normal item once full and are delivered first. A queue full of
+   * events refuses the next one, which then stays with the producer. Not thread safe.
+   */
+  class InfiniSinkQueue {
+    public:
+    //! storageSize / slotSize slots, at most SINK_QUEUE_SLOTS. Watermarks at 3/4 and 1/4, downsampling 1 in 4.
+    InfiniSinkQueue(char *storage, size_t storageSize, size_t slotSize, SINK_POLICY policy = SINK_DROP_OLDEST);
+
+    //! Congested from high items until back down to low. high is at most capacity(), low below high.
+    void setWatermarks(BYTE high, BYTE low);
+    //! The N of SINK_DOWNSAMPLE, at least 1.
+    void setDownsample(BYTE keepOneIn);
+    //! Where SINK_SPILL moves items, e.g. a flash log. It returning false leaves them to be dropped once full.
+    void setSpill(SinkConsumer spill, void *context = NULL);
+
+    /*! Copies data into the queue, as the policy allows. Returns whether it was queued.
+     * An item longer than a slot is refused.
+     */
+    bool push(const void *data, size_t len, uint64_t tsMs, BYTE deviceId = 0,
+              SINK_PRIORITY priority = SINK_PRIORITY_NORMAL);
+
+    //! Hands at most maxItems to consumer, events first, each in the order pushed. Stops at the first it refuses.
+    BYTE drain(SinkConsumer consumer, void *context, BYTE maxItems);
+
+    /*! The first maxItems in the order drain() takes them, to be sent as one, e.g. a publish.
+     * Returns how many, pop() them once they went out.
+     */
+    BYTE peek(SinkItem *items, BYTE maxItems) const;
+    void pop(BYTE count);
+    void clear();
+
+    BYTE size() const;
+    BYTE capacity() const;
+    bool isEmpty() const;
+    bool isCongested() const;
+
+    //! Items queued, dropped once queued, not queued by downsampling, moved to the spill callback and refused.
+    unsigned long pushed() const;
+    unsigned long dropped() const;
+    unsigned long downsampled() const;
+    unsigned long spilled() const;
+    unsigned long refused() const;
+    //! The most items held at once.
+    BYTE highWater() const;
+
+    private:
+    struct Meta {
+      uint64_t tsMs;
+      size_t len;
+      BYTE slot;
+      BYTE deviceId;
+      BYTE priority;
+    };
+
+    //! Index into m_items of the item drain() takes next, m_count if none.
+    BYTE next() const;
+    //! Index of the oldest normal item, m_count if none.
+    BYTE oldestNormal() const;
+    SinkItem item(BYTE index) const;
+    void remove(BYTE index);
+    //! Moves the oldest normal item to the spill callback. False if there is none or it refused.
+    bool spillOldest();
+    void updateCongestion();
+
+    char *m_storage;
+    size_t m_slotSize;
+    BYTE m_slots;
+    SINK_POLICY m_policy;
+    BYTE m_high;
+    BYTE m_low;
+    BYTE m_keepOneIn;
+    //! Normal items offered while congested, for SINK_DOWNSAMPLE.
+    unsigned long m_offered;
+    bool m_congested;
+    SinkConsumer m_spill;
+    void *m_spillContext;
+    //! The items in the order pushed.
+    Meta m_items[SINK_QUEUE_SLOTS];
+    BYTE m_count;
+    //! A bit per storage slot in use.
+    uint32_t m_used;
+    unsigned long m_pushed;
+    unsigned long m_dropped;
+    unsigned long m_downsampled;
+    unsigned long m_spilled;
+    unsigned long m_refused;
+    BYTE m_highWater;
+  };
+}
+
+#endif
@@ -0,0 +1,172 @@
+#include "InfiniStaticInfo.h"
+
+#if INFI_MODULE_PARSERS && INFI_MODULE_JSON
+#include <string.h>
+#include <Print.h>
+#include "InfiniJsonWriter.h"
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Preferences.h>
+#endif
+
+namespace INFI {
+
+  static const uint32_t FNV_OFFSET_BASIS = 2166136261UL;
+  static const uint32_t FNV_PRIME = 16777619UL;
+
+  //! Folds whatever is printed to it into an FNV-1a hash, nothing is kept.
+  class FnvPrint : public Print {
+    public:
+    FnvPrint() :
+      m_hash(FNV_OFFSET_BASIS)
+    {}
+
+    size_t write(uint8_t b) override {
+      m_hash = (m_hash ^ b) * FNV_PRIME;
+      return 1;
+    }
+
+    uint32_t hash() const {
+      return m_hash;
+    }
+
+    private:
+    uint32_t m_hash;
+  };
+
+  InfiniStaticInfo::InfiniStaticInfo() :
+    m_dirty(false)
+  {
+    memset(&m_state, 0, sizeof(m_state));
+    m_state.version = STATIC_INFO_VERSION;
+  }
+
+  void InfiniStaticInfo::setSeriesNumber(const char *seriesNumber) {
+    if (strncmp(m_state.seriesNumber, seriesNumber, SERIES_NUMBER_SZ) == 0) {
+      return;
+    }
+    memset(&m_state, 0, sizeof(m_state));
+    m_state.version = STATIC_INFO_VERSION;
+    strncpy(m_state.seriesNumber, seriesNumber, SERIES_NUMBER_SZ);
+    m_dirty = true;
+  }
+
+  const char *InfiniStaticInfo::seriesNumber() const {
+    return m_state.seriesNumber;
+  }
+
+  void InfiniStaticInfo::updatePiri(const RatedInformation &piri) {
+    m_state.piri = piri;
+    m_state.parts |= STATIC_INFO_PIRI;
+    m_dirty = true;
+  }
+
+  void InfiniStaticInfo::updateDi(const DefaultValues &di) {
+    m_state.di = di;
+    m_state.parts |= STATIC_INFO_DI;
+    m_dirty = true;
+  }
+
+  bool InfiniStaticInfo::isComplete() const {
+    return (m_state.parts & STATIC_INFO_ALL) == STATIC_INFO_ALL;
+  }
+
+  const RatedInformation &InfiniStaticInfo::piri() const {
+    return m_state.piri;
+  }
+
+  const DefaultValues &InfiniStaticInfo::di() const {
+    return m_state.di;
+  }
+
+  uint32_t InfiniStaticInfo::hash() const {
+    if (!isComplete()) {
+      return 0;
+    }
+    // Over the JSON rather than the structs, whose padding bytes are not defined.
+    FnvPrint out;
+    writeRatedInformationJson(m_state.piri, out);
+    writeDefaultValuesJson(m_state.di, out);
+    return out.hash();
+  }
+
+  bool InfiniStaticInfo::isChanged() const {
+    return isComplete() && hash() != m_state.publishedHash;
+  }
+
+  void InfiniStaticInfo::markPublished() {
+    uint32_t current = hash();
+    if (current != m_state.publishedHash) {
+      m_state.publishedHash = current;
+      m_dirty = true;
+    }
+  }
+
+  const StaticInfoState &InfiniStaticInfo::state() const {
+    return m_state;
+  }
+
+  bool InfiniStaticInfo::restoreState(const StaticInfoState &state) {
+    if (state.version != STATIC_INFO_VERSION) {
+      return false;
+    }
+    m_state = state;
+    m_state.seriesNumber[SERIES_NUMBER_SZ] = '\0';
+    m_dirty = false;
+    return true;
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  //! NVS keys are at most 15 chars and series numbers up to 20, so the key is "sn" and the hash of it in hex.
+  static void makeKey(const char *seriesNumber, char *key) {
+    FnvPrint out;
+    out.print(seriesNumber);
+    uint32_t hash = out.hash();
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    key[0] = 's';
+    key[1] = 'n';
+    for (BYTE i = 0; i < 8; ++i) {
+      key[2 + i] = HEX_DIGITS[(hash >> (28 - 4 * i)) & 0x0F];
+    }
+    key[10] = '\0';
+  }
+
+  bool InfiniStaticInfo::save(const char *ns) {
+    if (!m_dirty) {
+      return true;
+    }
+    if (m_state.seriesNumber[0] == '\0') {
+      return false;
+    }
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) {
+      return false;
+    }
+    char key[11];
+    makeKey(m_state.seriesNumber, key);
+    bool saved = prefs.putBytes(key, &m_state, sizeof(m_state)) == sizeof(m_state);
+    prefs.end();
+    m_dirty &= !saved;
+    return saved;
+  }
+
+  bool InfiniStaticInfo::load(const char *ns) {
+    if (m_state.seriesNumber[0] == '\0') {
+      return false;
+    }
+    Preferences prefs;
+    if (!prefs.begin(ns, true)) {
+      return false;
+    }
+    char key[11];
+    makeKey(m_state.seriesNumber, key);
+    StaticInfoState state;
+    bool loaded = prefs.getBytesLength(key) == sizeof(state)
+      && prefs.getBytes(key, &state, sizeof(state)) == sizeof(state);
+    prefs.end();
+    // Two series numbers can share a key, the one stored has to match.
+    return loaded && strncmp(state.seriesNumber, m_state.seriesNumber, SERIES_NUMBER_SZ) == 0
+      && (state.parts & STATIC_INFO_ALL) == STATIC_INFO_ALL && restoreState(state);
+  }
+#endif
+}
+#endif
@@ -0,0 +1,79 @@
+#ifndef INFINI_STATIC_INFO_H
+#define INFINI_STATIC_INFO_H
+
+#include <stdint.h>
+#include "InfiniDataTypes.h"
+
+namespace INFI {
+
+  //! Bumped whenever StaticInfoState changes, a stored state of another version is not loaded.
+  const BYTE STATIC_INFO_VERSION = 1;
+
+  //! Parts of StaticInfoState::parts.
+  const BYTE STATIC_INFO_PIRI = 0x01;
+  const BYTE STATIC_INFO_DI = 0x02;
+  const BYTE STATIC_INFO_ALL = STATIC_INFO_PIRI | STATIC_INFO_DI;
+
+  //! What InfiniStaticInfo keeps, plain data so it can be stored as one blob.
+  struct StaticInfoState {
+    BYTE version;
+    //! From ID, which unit piri and di belong to.
+    char seriesNumber[SERIES_NUMBER_SZ + 1];
+    //! STATIC_INFO_PIRI and STATIC_INFO_DI, set once the reply is in.
+    BYTE parts;
+    RatedInformation piri;
+    DefaultValues di;
+    //! hash() of what was last published.
+    uint32_t publishedHash;
+  };
+
+  /*!
+   * PIRI and DI of one inverter, which are all but constant, so they can be uploaded once as attributes
+   * instead of as telemetry samples. The hash is FNV-1a over their JSON, see writeRatedInformationJson() and
+   * writeDefaultValuesJson(), so it changes exactly when what would be uploaded does.
+   * On the ESP32 it is kept in NVS per series number, so a reboot of the same unit takes PIRI and DI from there
+   * instead of querying them, see load(). A changed setting still reaches it: GS flags it, the sketch
+   * re-reads them and update*() takes the new reply.
+   */
+  class InfiniStaticInfo {
+    public:
+    InfiniStaticInfo();
+
+    //! The unit, from ID. Another one than kept drops PIRI and DI.
+    void setSeriesNumber(const char *seriesNumber);
+    const char *seriesNumber() const;
+
+    void updatePiri(const RatedInformation &piri);
+    void updateDi(const DefaultValues &di);
+    //! Both PIRI and DI are in.
+    bool isComplete() const;
+    const RatedInformation &piri() const;
+    const DefaultValues &di() const;
+
+    //! Hash of the JSON of PIRI and DI, 0 until isComplete().
+    uint32_t hash() const;
+    //! Complete, and different from what markPublished() saw.
+    bool isChanged() const;
+    //! Takes the current hash() as uploaded, e.g. once the attributes went out.
+    void markPublished();
+
+    const StaticInfoState &state() const;
+    //! Returns false, leaving it as it was, if state is of another version.
+    bool restoreState(const StaticInfoState &state);
+
+#if defined(ARDUINO_ARCH_ESP32)
+    //! Keeps the state in the NVS namespace ns, under a key made from the series number. Skipped if nothing changed.
+    bool save(const char *ns = "infi_static");
+    /*! Loads what save() kept for the series number set, e.g. right after ID came in.
+     * Returns false if there is none, or it is of another version or incomplete.
+     */
+    bool load(const char *ns = "infi_static");
+#endif
+
+    private:
+    StaticInfoState m_state;
+    bool m_dirty;
+  };
+}
+
+#endif
@@ -0,0 +1,187 @@
+#include "InfiniStatusCache.h"
+
+#if INFI_MODULE_PARSERS
+#include "InfiniDeltaTelemetry.h"
+#include "InfiniJsonWriter.h"
+#include <stddef.h>
+#include <string.h>
+
+namespace INFI {
+  // The bytes of a RatedInformation that hold its fields.
+  static const size_t PIRI_COMPARED_SZ = offsetof(RatedInformation, mpptString) + sizeof(BYTE);
+
+  InfiniStatusCache::InfiniStatusCache() {
+  }
+
+  void InfiniStatusCache::updateGs(const GeneralStatusFixed &gs, unsigned long nowMs) {
+    StatusSnapshot &next = m_snapshot.beginWrite();
+    // Compared field by field, the struct's padding bytes are not part of the reading.
+    const bool first = !(next.parts & STATUS_GS);
+    const unsigned long seq = next.seq + 1;
+    bool changed = false;
+    for (BYTE f = 0; f < NUM_GS_FIELDS; ++f) {
+      if (first || getGeneralStatusField(next.gs, (GS_FIELD)f) != getGeneralStatusField(gs, (GS_FIELD)f)) {
+        next.gsFieldSeqs[f] = seq;
+        changed = true;
+      }
+    }
+    if (changed) {
+      next.seq = seq;
+    }
+    next.gs = gs;
+    next.gsMs = nowMs;
+    next.parts |= STATUS_GS;
+    m_snapshot.endWrite();
+  }
+
+  void InfiniStatusCache::updatePiri(const RatedInformation &piri, unsigned long nowMs) {
+    StatusSnapshot &next = m_snapshot.beginWrite();
+    // The words come first, so only the padding behind the last byte is left out.
+    if (!(next.parts & STATUS_PIRI) || memcmp(&next.piri, &piri, PIRI_COMPARED_SZ) != 0) {
+      next.piriSeq = ++next.seq;
+    }
+    next.piri = piri;
+    next.piriMs = nowMs;
+    next.parts |= STATUS_PIRI;
+    m_snapshot.endWrite();
+  }
+
+  void InfiniStatusCache::updateFws(const FaultWarningStatus &fws, unsigned long nowMs) {
+    StatusSnapshot &next = m_snapshot.beginWrite();
+    if (!(next.parts & STATUS_FWS) || next.fws.faultCode != fws.faultCode
+        || getFaultWarningFlags(next.fws) != getFaultWarningFlags(fws)) {
+      next.fwsSeq = ++next.seq;
+    }
+    next.fws = fws;
+    next.fwsMs = nowMs;
+    next.parts |= STATUS_FWS;
+    m_snapshot.endWrite();
+  }
+
+  void InfiniStatusCache::updateEnergy(const EnergyCounters &energy, unsigned long nowMs) {
+    StatusSnapshot &next = m_snapshot.beginWrite();
+    if (!(next.parts & STATUS_ENERGY) || next.energy.dayWh != energy.dayWh || next.energy.monthWh != energy.monthWh
+        || next.energy.yearWh != energy.yearWh) {
+      next.energySeq = ++next.seq;
+    }
+    next.energy = energy;
+    next.energyMs = nowMs;
+    next.parts |= STATUS_ENERGY;
+    m_snapshot.endWrite();
+  }
+
+  bool InfiniStatusCache::read(StatusSnapshot &out) const {
+    m_snapshot.read(out);
+    return out.parts != 0;
+  }
+
+  BYTE InfiniStatusCache::version() const {
+    return (BYTE)m_snapshot.version();
+  }
+
+  GsFieldMask InfiniStatusCache::changedGsFields(const StatusSnapshot &snapshot, unsigned long sinceSeq) {
+    if (!(snapshot.parts & STATUS_GS)) {
+      return 0;
+    }
+    if (sinceSeq > snapshot.seq) {
+      return GS_ALL_FIELDS;
+    }
+    GsFieldMask changed = 0;
+    for (BYTE f = 0; f < NUM_GS_FIELDS; ++f) {
+      if (snapshot.gsFieldSeqs[f] > sinceSeq) {
+        changed |= (GsFieldMask)1 << f;
+      }
+    }
+    return changed;
+  }
+
+  // Writes "<name>AgeMs":...,"<name>": with the comma or brace that comes before it.
+  static size_t writePartKeys(Print &out, const char *name, unsigned long takenMs, unsigned long nowMs, bool first) {
+    size_t n = out.print(first ? "{\"" : ",\"");
+    n += out.print(name);
+    n += out.print(INFI_F("AgeMs\":"));
+    n += out.print(nowMs - takenMs);
+    n += out.print(",\"");
+    n += out.print(name);
+    n += out.print("\":");
+    return n;
+  }
+
+#if INFI_MODULE_JSON
+  // Writes the known counters of energy as {"dayWh":...,"monthWh":...,"yearWh":...}.
+  static size_t writeEnergyJson(const EnergyCounters &energy, Print &out) {
+    const unsigned long counters[] = { energy.dayWh, energy.monthWh, energy.yearWh };
+    static const char *const keys[] = { "dayWh", "monthWh", "yearWh" };
+    size_t n = 0;
+    bool first = true;
+    for (BYTE i = 0; i < 3; ++i) {
+      if (counters[i] != ENERGY_UNKNOWN) {
+        // Printed as unsigned long, a year of Wh outgrows an AVR's int.
+        n += out.print(first ? "{\"" : ",\"");
+        n += out.print(keys[i]);
+        n += out.print("\":");
+        n += out.print(counters[i]);
+        first = false;
+      }
+    }
+    n += out.print(first ? "{}" : "}");
+    return n;
+  }
+
+  size_t InfiniStatusCache::writeJson(const StatusSnapshot &snapshot, unsigned long nowMs, Print &out) {
+    size_t n = 0;
+    bool first = true;
+    if (snapshot.parts & STATUS_GS) {
+      n += writePartKeys(out, "gs", snapshot.gsMs, nowMs, first);
+      n += writeGeneralStatusJson(snapshot.gs, out);
+      first = false;
+    }
+    if (snapshot.parts & STATUS_PIRI) {
+      n += writePartKeys(out, "piri", snapshot.piriMs, nowMs, first);
+      n += writeRatedInformationJson(snapshot.piri, out);
+      first = false;
+    }
+    if (snapshot.parts & STATUS_FWS) {
+      n += writePartKeys(out, "fws", snapshot.fwsMs, nowMs, first);
+      n += writeFaultWarningStatusJson(snapshot.fws, out);
+      first = false;
+    }
+    if (snapshot.parts & STATUS_ENERGY) {
+      n += writePartKeys(out, "energy", snapshot.energyMs, nowMs, first);
+      n += writeEnergyJson(snapshot.energy, out);
+      first = false;
+    }
+    n += out.print(first ? "{}" : "}");
+    return n;
+  }
+
+  size_t InfiniStatusCache::writeChangesJson(const StatusSnapshot &snapshot, unsigned long sinceSeq, unsigned long nowMs,
+                                             Print &out) {
+    if (sinceSeq > snapshot.seq) {
+      sinceSeq = 0;
+    }
+    size_t n = out.print(INFI_F("{\"seq\":"));
+    n += out.print(snapshot.seq);
+    const GsFieldMask gsFields = changedGsFields(snapshot, sinceSeq);
+    if (gsFields != 0) {
+      n += writePartKeys(out, "gs", snapshot.gsMs, nowMs, false);
+      n += writeGeneralStatusFieldsJson(snapshot.gs, gsFields, out);
+    }
+    if ((snapshot.parts & STATUS_PIRI) && snapshot.piriSeq > sinceSeq) {
+      n += writePartKeys(out, "piri", snapshot.piriMs, nowMs, false);
+      n += writeRatedInformationJson(snapshot.piri, out);
+    }
+    if ((snapshot.parts & STATUS_FWS) && snapshot.fwsSeq > sinceSeq) {
+      n += writePartKeys(out, "fws", snapshot.fwsMs, nowMs, false);
+      n += writeFaultWarningStatusJson(snapshot.fws, out);
+    }
+    if ((snapshot.parts & STATUS_ENERGY) && snapshot.energySeq > sinceSeq) {
+      n += writePartKeys(out, "energy", snapshot.energyMs, nowMs, false);
+      n += writeEnergyJson(snapshot.energy, out);
+    }
+    n += out.print("}");
+    return n;
+  }
+#endif
+}
+#endif
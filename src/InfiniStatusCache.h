@@ -0,0 +1,101 @@
+#ifndef INFINI_STATUS_CACHE_H
+#define INFINI_STATUS_CACHE_H
+
+#include <Print.h>
+#include "InfiniDataTypes.h"
+#include "InfiniConcurrency.h"
+
+namespace INFI {
+
+  //! Which parts of a StatusSnapshot hold a reading.
+  enum STATUS_PART {
+    STATUS_GS = 0x01,
+    STATUS_PIRI = 0x02,
+    STATUS_FWS = 0x04,
+    STATUS_ENERGY = 0x08
+  };
+
+  //! An energy counter of a StatusSnapshot that was not read yet.
+  const unsigned long ENERGY_UNKNOWN = 0xFFFFFFFFUL;
+
+  //! The generated energy counters in Wh, as InfiniEnergyTracker keeps them, ENERGY_UNKNOWN until known.
+  struct EnergyCounters {
+    unsigned long dayWh;
+    unsigned long monthWh;
+    unsigned long yearWh;
+  };
+
+  /*! The latest parsed GS, PIRI and FWS of one inverter, its energy counters, and the millis() each was taken at.
+   * Every update that changes something is numbered, and each GS field and the other parts keep the number of
+   * the update that last changed them, so a reader can ask for what changed since the number it saw last.
+   */
+  struct StatusSnapshot {
+    //! STATUS_PART bits of the parts below that were ever updated.
+    BYTE parts;
+    unsigned long gsMs;
+    unsigned long piriMs;
+    unsigned long fwsMs;
+    unsigned long energyMs;
+    GeneralStatusFixed gs;
+    RatedInformation piri;
+    FaultWarningStatus fws;
+    EnergyCounters energy;
+    //! Number of the last update that changed anything, 0 before the first. Restarts from 0 on a reboot.
+    unsigned long seq;
+    //! seq of the update that last changed each GS field.
+    unsigned long gsFieldSeqs[NUM_GS_FIELDS];
+    unsigned long piriSeq;
+    unsigned long fwsSeq;
+    unsigned long energySeq;
+  };
+
+  /*!
+   * Keeps the latest StatusSnapshot of an inverter for readers in other tasks, e.g. InfiniStatusServer,
+   * so they never wait on, or add traffic to, the RS232 link.
+   * The snapshot is an InfiniSnapshot, so an update changes it in place while readers copy the other copy,
+   * and read() only starts over if an update finished meanwhile.
+   * Readers never wait for the writer, so the writer is never held up either, whatever the task priorities.
+   * Updates must all come from one task, typically the command callbacks. Any number of tasks can read.
+   */
+  class InfiniStatusCache {
+    public:
+    InfiniStatusCache();
+
+    //! Writer side. Stores a reading taken at nowMs.
+    void updateGs(const GeneralStatusFixed &gs, unsigned long nowMs);
+    void updatePiri(const RatedInformation &piri, unsigned long nowMs);
+    void updateFws(const FaultWarningStatus &fws, unsigned long nowMs);
+    void updateEnergy(const EnergyCounters &energy, unsigned long nowMs);
+
+    //! Reader side. Copies the latest snapshot into out. Returns false if nothing was stored yet.
+    bool read(StatusSnapshot &out) const;
+
+    //! Bumped by every update, so a reader can tell whether the snapshot moved since it last looked.
+    BYTE version() const;
+
+    //! The GS fields of snapshot changed by updates after sinceSeq.
+    static GsFieldMask changedGsFields(const StatusSnapshot &snapshot, unsigned long sinceSeq);
+
+#if INFI_MODULE_JSON
+    /*! Writes snapshot as {"gsAgeMs":...,"gs":{...},"piriAgeMs":...,"piri":{...},"fwsAgeMs":...,"fws":{...},
+     * "energyAgeMs":...,"energy":{"dayWh":...,"monthWh":...,"yearWh":...}}, with the objects
+     * writeGeneralStatusJson() and the typed writers produce. Parts never updated, and unknown counters, are
+     * left out, ages are taken against nowMs. Returns the number of bytes written.
+     */
+    static size_t writeJson(const StatusSnapshot &snapshot, unsigned long nowMs, Print &out);
+
+    /*! Writes what changed in snapshot after the update numbered sinceSeq, as {"seq":...} and the keys of
+     * writeJson(): only the parts that changed, and of "gs" only the fields that did. A sinceSeq ahead of
+     * snapshot.seq is from before a reboot and gets everything. Pass the "seq" written as the next sinceSeq.
+     * Returns the number of bytes written.
+     */
+    static size_t writeChangesJson(const StatusSnapshot &snapshot, unsigned long sinceSeq, unsigned long nowMs,
+                                   Print &out);
+#endif
+
+    private:
+    InfiniSnapshot<StatusSnapshot> m_snapshot;
+  };
+}
+
+#endif
@@ -0,0 +1,211 @@
+#include "InfiniStatusServer.h"
+
+#if INFI_MODULE_SINKS
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include "InfiniJsonWriter.h"
+#include "InfiniTrace.h"
+
+namespace INFI {
+
+  // Forwards what is printed to the client in STATUS_SERVER_CHUNK_SZ pieces, rather than a byte per write.
+  class WebServerChunkPrint : public Print {
+    public:
+    explicit WebServerChunkPrint(WebServer &server) :
+      m_server(server),
+      m_length(0)
+    {}
+
+    size_t write(uint8_t c) override {
+      if (m_length == STATUS_SERVER_CHUNK_SZ) {
+        flush();
+      }
+      m_buffer[m_length++] = (char)c;
+      return 1;
+    }
+
+    void flush() override {
+      if (m_length > 0) {
+        m_server.sendContent(m_buffer, m_length);
+        m_length = 0;
+      }
+    }
+
+    private:
+    WebServer &m_server;
+    char m_buffer[STATUS_SERVER_CHUNK_SZ];
+    size_t m_length;
+  };
+
+  InfiniStatusServer::InfiniStatusServer(const InfiniStatusCache *caches, BYTE numCaches, uint16_t port) :
+    m_caches(caches),
+    m_numCaches(numCaches),
+    m_server(port),
+    m_task(NULL),
+    m_snapshots(NULL),
+    m_linkStats(NULL),
+    m_metricsWriter(NULL),
+    m_metricsContext(NULL),
+    m_history(NULL),
+    m_requests(0)
+  {}
+
+  void InfiniStatusServer::setLinkStats(const InfiniLinkStats *stats) {
+    m_linkStats = stats;
+  }
+
+  void InfiniStatusServer::setMetricsWriter(MetricsWriter writer, void *context) {
+    m_metricsWriter = writer;
+    m_metricsContext = context;
+  }
+
+  void InfiniStatusServer::setHistory(const InfiniPartitionLog *log) {
+    m_history = log;
+  }
+
+  bool InfiniStatusServer::begin(BaseType_t core, UBaseType_t priority) {
+    if (m_task != NULL) {
+      return true;
+    }
+    if (m_snapshots == NULL) {
+      m_snapshots = (StatusSnapshot *)malloc(sizeof(StatusSnapshot) * m_numCaches);
+      if (m_snapshots == NULL) {
+        return false;
+      }
+    }
+    m_server.on("/status", HTTP_GET, [this]() { handleStatus(); });
+    m_server.on("/metrics", HTTP_GET, [this]() { handleMetrics(); });
+    m_server.on("/history", HTTP_GET, [this]() { handleHistory(); });
+#if INFI_TRACE
+    m_server.on("/trace", HTTP_GET, [this]() { handleTrace(); });
+#endif
+    m_server.onNotFound([this]() { handleNotFound(); });
+    m_server.begin();
+    return xTaskCreatePinnedToCore(run, "infi_http", STATUS_SERVER_STACK_SZ, this, priority, &m_task, core) == pdPASS;
+  }
+
+  unsigned long InfiniStatusServer::requests() const {
+    return m_requests;
+  }
+
+  void InfiniStatusServer::run(void *arg) {
+    InfiniStatusServer *server = (InfiniStatusServer *)arg;
+    // At least a tick, so lower priority tasks on the core get to run.
+    TickType_t ticks = pdMS_TO_TICKS(STATUS_SERVER_POLL_MS);
+    if (ticks == 0) {
+      ticks = 1;
+    }
+    while (true) {
+      server->m_server.handleClient();
+      vTaskDelay(ticks);
+    }
+  }
+
+  void InfiniStatusServer::handleStatus() {
+    long device = m_server.hasArg("device") ? m_server.arg("device").toInt() : 0;
+    if (device < 0 || device >= m_numCaches) {
+      m_server.send(404, "text/plain", "No such device");
+      return;
+    }
+    if (!m_caches[device].read(m_snapshot)) {
+      m_server.send(503, "text/plain", "No reading yet");
+      return;
+    }
+    String seq(m_snapshot.seq);
+    m_server.sendHeader("Cache-Control", "no-store");
+    m_server.sendHeader("X-Seq", seq);
+    // A client polling with the sequence it has seen gets an empty answer while nothing moved, and only
+    // what changed after it otherwise.
+    const bool changes = m_server.hasArg("since");
+    const unsigned long since = changes ? (unsigned long)m_server.arg("since").toInt() : 0;
+    if (changes && since == m_snapshot.seq) {
+      m_server.send(304, "application/json", "");
+      m_requests++;
+      return;
+    }
+    // Known up front, so the body goes out with a Content-Length and without being held in RAM whole.
+    unsigned long now = millis();
+    InfiniCountingPrint counter;
+    writeStatus(changes, since, now, counter);
+    m_server.setContentLength(counter.count());
+    m_server.send(200, "application/json", "");
+    WebServerChunkPrint body(m_server);
+    writeStatus(changes, since, now, body);
+    body.flush();
+    m_requests++;
+  }
+
+  size_t InfiniStatusServer::writeStatus(bool changes, unsigned long since, unsigned long nowMs, Print &out) const {
+    return changes ? InfiniStatusCache::writeChangesJson(m_snapshot, since, nowMs, out)
+                   : InfiniStatusCache::writeJson(m_snapshot, nowMs, out);
+  }
+
+  void InfiniStatusServer::handleMetrics() {
+    // Every device first, so the families are written from one reading each.
+    for (BYTE d = 0; d < m_numCaches; ++d) {
+      m_caches[d].read(m_snapshots[d]);
+    }
+    // The counters move while they are written, so the length is not known up front and the body goes out chunked.
+    unsigned long now = millis();
+    m_server.sendHeader("Cache-Control", "no-store");
+    m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    m_server.send(200, METRICS_CONTENT_TYPE, "");
+    WebServerChunkPrint body(m_server);
+    writeStatusMetrics(body, m_snapshots, m_numCaches, now);
+    if (m_linkStats != NULL) {
+      writeLinkStatsMetrics(body, *m_linkStats);
+    }
+    if (m_metricsWriter != NULL) {
+      m_metricsWriter(body, m_metricsContext);
+    }
+    writeMetricsEof(body);
+    body.flush();
+    m_server.sendContent("");
+    m_requests++;
+  }
+
+  void InfiniStatusServer::handleTrace() {
+    // The ring keeps filling while it is written, so the length is not known up front and the body goes out chunked.
+    m_server.sendHeader("Cache-Control", "no-store");
+    m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    m_server.send(200, "application/json", "");
+    WebServerChunkPrint body(m_server);
+    writeTraceJson(body);
+    body.flush();
+    m_server.sendContent("");
+    m_requests++;
+  }
+
+  void InfiniStatusServer::handleHistory() {
+    if (m_history == NULL) {
+      handleNotFound();
+      return;
+    }
+    // Unix ms do not fit the long of toInt().
+    const uint64_t from = m_server.hasArg("from") ? strtoull(m_server.arg("from").c_str(), NULL, 10) : 0;
+    const uint64_t to = m_server.hasArg("to") ? strtoull(m_server.arg("to").c_str(), NULL, 10) : UINT64_MAX;
+    const bool binary = m_server.arg("format") == "bin";
+    // The span is only counted as it is written, so the body goes out chunked.
+    m_server.sendHeader("Cache-Control", "no-store");
+    m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    m_server.send(200, binary ? "application/octet-stream" : "text/csv", "");
+    WebServerChunkPrint body(m_server);
+    if (!binary) {
+      writeGeneralStatusCsvHeader(body);
+    }
+    m_history->writeRange(from, to, binary ? SAMPLE_BINARY_STAMPED : SAMPLE_CSV, body);
+    body.flush();
+    m_server.sendContent("");
+    m_requests++;
+  }
+
+  void InfiniStatusServer::handleNotFound() {
+    m_server.send(404, "text/plain", "Not found");
+  }
+}
+
+#endif
+#endif
@@ -0,0 +1,100 @@
+#ifndef INFINI_STATUS_SERVER_H
+#define INFINI_STATUS_SERVER_H
+
+#include "InfiniMetrics.h"
+#include "InfiniPartitionLog.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <WebServer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Stack of the HTTP task, in bytes.
+#ifndef INFI_STATUS_SERVER_STACK_SZ
+#define INFI_STATUS_SERVER_STACK_SZ 4096
+#endif
+
+// How often the HTTP task looks for a client, milliseconds. Bounds the latency a request adds.
+#ifndef INFI_STATUS_SERVER_POLL_MS
+#define INFI_STATUS_SERVER_POLL_MS 2
+#endif
+
+// Bytes of the response collected before they go to the client, the whole body is about 1.6 KB.
+#ifndef INFI_STATUS_SERVER_CHUNK_SZ
+#define INFI_STATUS_SERVER_CHUNK_SZ 256
+#endif
+
+namespace INFI {
+
+  const uint32_t STATUS_SERVER_STACK_SZ = INFI_STATUS_SERVER_STACK_SZ;
+  const unsigned long STATUS_SERVER_POLL_MS = INFI_STATUS_SERVER_POLL_MS;
+  const size_t STATUS_SERVER_CHUNK_SZ = INFI_STATUS_SERVER_CHUNK_SZ;
+
+  /*!
+   * A small HTTP server on the LAN that answers GET /status with the InfiniStatusCache::writeJson()
+   * of an inverter, for local readers like a SCADA that should not go through ThingsBoard.
+   * With several inverters, pass one cache per device id, /status?device=<id> picks one, 0 by default.
+   * Every answer carries the snapshot's sequence number as X-Seq. /status?since=<seq> answers 304 while
+   * the cache has not moved past it and InfiniStatusCache::writeChangesJson() otherwise, so a reader polling
+   * often only transfers what changed.
+   * It runs in a FreeRTOS task of its own and only ever reads the caches, so a request neither waits on
+   * the RS232 link nor on the loop, and any number of readers cost the inverter nothing.
+   * GET /metrics answers the same caches as OpenMetrics text for Prometheus, see InfiniMetrics.h, with the
+   * link counters of setLinkStats() and the families of setMetricsWriter(). The body is streamed in chunks as
+   * it is written, so a scrape takes no more RAM than a snapshot per device.
+   * Needs WiFi to be up to be reachable, begin() can be called before that.
+   * With setHistory(), GET /history?from=<ms>&to=<ms> streams the logged samples of that span of Unix ms as CSV,
+   * with a header line, or with &format=bin as writeGsSampleBinary() records, see InfiniPartitionLog::writeRange().
+   * Built with INFI_TRACE, GET /trace answers the recorded trace points as Chrome trace-event JSON, see writeTraceJson().
+   */
+  class InfiniStatusServer {
+    public:
+    InfiniStatusServer(const InfiniStatusCache *caches, BYTE numCaches = 1, uint16_t port = 80);
+
+    /*! Starts listening and the HTTP task pinned to core, next to WiFi by default.
+     * Returns false if FreeRTOS is out of memory.
+     */
+    bool begin(BaseType_t core = 0, UBaseType_t priority = 1);
+
+    /*! Adds the counters of stats to /metrics, NULL for none. stats is read from the HTTP task while the loop
+     * updates it, a scrape may catch one reply counted in sent but not yet in its outcome.
+     */
+    void setLinkStats(const InfiniLinkStats *stats);
+    //! Calls writer for more families on every /metrics, before its # EOF. Called from the HTTP task.
+    void setMetricsWriter(MetricsWriter writer, void *context = NULL);
+    //! Serves /history from log, NULL for none. The log is only read, from the HTTP task.
+    void setHistory(const InfiniPartitionLog *log);
+
+    //! Requests answered since begin().
+    unsigned long requests() const;
+
+    private:
+    static void run(void *arg);
+
+    void handleStatus();
+    //! writeChangesJson() after since if changes, otherwise writeJson() of m_snapshot.
+    size_t writeStatus(bool changes, unsigned long since, unsigned long nowMs, Print &out) const;
+    void handleMetrics();
+    void handleTrace();
+    void handleHistory();
+    void handleNotFound();
+
+    const InfiniStatusCache *m_caches;
+    BYTE m_numCaches;
+    WebServer m_server;
+    TaskHandle_t m_task;
+    //! Only touched by the HTTP task, kept here rather than on its stack.
+    StatusSnapshot m_snapshot;
+    //! One per cache for /metrics, allocated by begin().
+    StatusSnapshot *m_snapshots;
+    const InfiniLinkStats *m_linkStats;
+    MetricsWriter m_metricsWriter;
+    void *m_metricsContext;
+    const InfiniPartitionLog *m_history;
+    volatile unsigned long m_requests;
+  };
+}
+
+#endif
+#endif
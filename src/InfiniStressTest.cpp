@@ -0,0 +1,190 @@
+#include "InfiniStressTest.h"
+
+#if INFI_MODULE_SCHEDULER && INFI_MODULE_STATS
+#include <string.h>
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+
+  //! Commands queued at once, the one in flight and the one waiting behind it.
+  static const BYTE STRESS_PIPELINE = 2;
+
+  InfiniStressTest::InfiniStressTest(InfiniCommandQueue &queue) :
+    m_queue(queue),
+    m_mixCount(0),
+    m_next(0),
+    m_running(false),
+    m_startMs(0),
+    m_durationMs(0),
+    m_pending(0)
+  {
+    memset(&m_result, 0, sizeof(m_result));
+    memset(m_turnaround, 0, sizeof(m_turnaround));
+  }
+
+  bool InfiniStressTest::add(COMMAND_TYPE commandType, const char *params) {
+    if (m_running || m_mixCount >= STRESS_MIX_SZ) {
+      return false;
+    }
+    MixEntry &entry = m_mix[m_mixCount++];
+    entry.commandType = commandType;
+    strncpy(entry.params, params != NULL ? params : "", MAX_PARAMS_SZ - 1);
+    entry.params[MAX_PARAMS_SZ - 1] = '\0';
+    return true;
+  }
+
+  void InfiniStressTest::clear() {
+    if (!m_running) {
+      m_mixCount = 0;
+    }
+  }
+
+  bool InfiniStressTest::begin(unsigned long durationMs) {
+    if (m_running || m_mixCount == 0) {
+      return false;
+    }
+    memset(&m_result, 0, sizeof(m_result));
+    memset(m_turnaround, 0, sizeof(m_turnaround));
+    m_result.turnaroundMinMs = NO_DEADLINE;
+    m_next = 0;
+    m_running = true;
+    m_durationMs = durationMs;
+    m_startMs = millis();
+    loop();
+    return true;
+  }
+
+  bool InfiniStressTest::isRunning() const {
+    return m_running;
+  }
+
+  void InfiniStressTest::loop() {
+    if (!m_running) {
+      return;
+    }
+    if (millis() - m_startMs >= m_durationMs) {
+      // The run is over once what is still queued came back, so its link time counts too.
+      m_running = m_pending > 0;
+      return;
+    }
+    while (m_pending < STRESS_PIPELINE) {
+      const MixEntry &entry = m_mix[m_next];
+      if (!m_queue.enqueue(entry.commandType, entry.params, onComplete, this)) {
+        return;
+      }
+      m_pending++;
+      m_next = (m_next + 1) % m_mixCount;
+    }
+  }
+
+  void InfiniStressTest::onComplete(const InfiniResponse &response, SEND_STATUS status, void *context) {
+    InfiniStressTest *self = (InfiniStressTest *)context;
+    StressResult &result = self->m_result;
+    const unsigned long latencyMs = (micros() - response.sentUs) / 1000;
+    self->m_pending--;
+    result.elapsedMs = millis() - self->m_startMs;
+    result.transactions++;
+    switch (status) {
+      case SEND_COMPLETE:
+        if (response.error == RESP_NAK) {
+          result.nak++;
+        } else {
+          result.ok++;
+        }
+        break;
+      case SEND_TIMEOUT:
+        result.timeout++;
+        break;
+      case SEND_LINK_DOWN:
+        // Never sent.
+        result.linkDown++;
+        return;
+      default:
+        result.error++;
+        break;
+    }
+    const unsigned long bytes = (unsigned long)getFrameSize(response.cmdType) + response.actualLen;
+    result.bytes += bytes;
+    if (status == SEND_TIMEOUT) {
+      return;
+    }
+    const unsigned long wireMs = getWireTimeMs(bytes, self->m_queue.sender().baud());
+    const unsigned long turnaroundMs = latencyMs > wireMs ? latencyMs - wireMs : 0;
+    result.replies++;
+    result.turnaroundSumMs += turnaroundMs;
+    if (turnaroundMs < result.turnaroundMinMs) {
+      result.turnaroundMinMs = turnaroundMs;
+    }
+    if (turnaroundMs > result.turnaroundMaxMs) {
+      result.turnaroundMaxMs = turnaroundMs;
+    }
+    BYTE bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && turnaroundMs > InfiniLinkStats::latencyBucketMaxMs(bucket)) {
+      bucket++;
+    }
+    self->m_turnaround[bucket]++;
+  }
+
+  const StressResult &InfiniStressTest::result() const {
+    return m_result;
+  }
+
+  unsigned long InfiniStressTest::transactionsPerS10() const {
+    return m_result.elapsedMs == 0 ? 0 : (unsigned long)((uint64_t)m_result.transactions * 10000 / m_result.elapsedMs);
+  }
+
+  unsigned long InfiniStressTest::bytesPerS10() const {
+    return m_result.elapsedMs == 0 ? 0 : (unsigned long)((uint64_t)m_result.bytes * 10000 / m_result.elapsedMs);
+  }
+
+  unsigned long InfiniStressTest::utilization10() const {
+    // Tenths of a byte a second, times 10 bits, against the baud rate, in tenths of a percent.
+    return (unsigned long)((uint64_t)bytesPerS10() * 10 * 100 / m_queue.sender().baud());
+  }
+
+  unsigned long InfiniStressTest::wireLimitPerS10() const {
+    unsigned long wireMs = 0;
+    for (BYTE i = 0; i < m_mixCount; ++i) {
+      const COMMAND_TYPE commandType = m_mix[i].commandType;
+      wireMs += getWireTimeMs((unsigned long)getFrameSize(commandType) + getResponseSize(commandType),
+                              m_queue.sender().baud());
+    }
+    return wireMs == 0 ? 0 : (unsigned long)m_mixCount * 10000 / wireMs;
+  }
+
+  unsigned long InfiniStressTest::meanTurnaroundMs() const {
+    return m_result.replies == 0 ? 0 : m_result.turnaroundSumMs / m_result.replies;
+  }
+
+  unsigned long InfiniStressTest::turnaroundBucket(BYTE i) const {
+    return i < LATENCY_BUCKETS ? m_turnaround[i] : 0;
+  }
+
+  size_t InfiniStressTest::writeJson(Print &out) const {
+    size_t n = writeJsonFieldP(out, INFI_PSTR("stressMs"), m_result.elapsedMs, JSON_UINT, true);
+    n += writeJsonFieldP(out, INFI_PSTR("stressTx"), m_result.transactions, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressTxPerS"), transactionsPerS10(), JSON_DECI, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressWirePerS"), wireLimitPerS10(), JSON_DECI, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressOk"), m_result.ok, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressNak"), m_result.nak, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressTimeout"), m_result.timeout, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressError"), m_result.error, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressLinkDown"), m_result.linkDown, JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressBytesPerS"), bytesPerS10(), JSON_DECI, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressLinkPct"), utilization10(), JSON_DECI, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressTurnMin"), m_result.replies == 0 ? 0 : m_result.turnaroundMinMs,
+                         JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressTurnAvg"), meanTurnaroundMs(), JSON_UINT, false);
+    n += writeJsonFieldP(out, INFI_PSTR("stressTurnMax"), m_result.turnaroundMaxMs, JSON_UINT, false);
+    n += out.print(INFI_F(",\"stressTurn\":["));
+    for (BYTE i = 0; i < LATENCY_BUCKETS; ++i) {
+      if (i > 0) {
+        n += out.print(',');
+      }
+      n += out.print(m_turnaround[i]);
+    }
+    n += out.print("]}");
+    return n;
+  }
+}
+#endif
@@ -0,0 +1,102 @@
+#ifndef INFINI_STRESS_TEST_H
+#define INFINI_STRESS_TEST_H
+
+#include "InfiniCommandQueue.h"
+
+// Most commands in the mix of one InfiniStressTest.
+#ifndef INFI_STRESS_MIX_SZ
+#define INFI_STRESS_MIX_SZ 8
+#endif
+
+namespace INFI {
+
+  const BYTE STRESS_MIX_SZ = INFI_STRESS_MIX_SZ;
+
+  //! What a run got through, every transaction ends up in exactly one of ok, nak, timeout, error or linkDown.
+  struct StressResult {
+    unsigned long elapsedMs;
+    unsigned long transactions;
+    unsigned long ok;
+    unsigned long nak;
+    unsigned long timeout;
+    //! Rejected replies, after the queue's retries.
+    unsigned long error;
+    unsigned long linkDown;
+    //! Command frames and the replies to them, of the last attempt of each transaction.
+    unsigned long bytes;
+    //! Of the replies that arrived: the latency minus the wire time of the frame and the reply.
+    unsigned long turnaroundMinMs;
+    unsigned long turnaroundMaxMs;
+    unsigned long turnaroundSumMs;
+    unsigned long replies;
+  };
+
+  /*!
+   * Characterizes how fast an inverter and its link answer back to back queries, e.g. to find a cadence
+   * ceiling per model and firmware. begin() runs the added mix round robin through the queue for a while,
+   * keeping one command waiting behind the one in flight so the link is never idle, and counts how each
+   * transaction ended, the bytes on the wire and the inverter's turnaround, with a histogram over the
+   * buckets of InfiniLinkStats. The rates are set against what the baud rate could carry at most, so a
+   * utilization well below 100 % is the inverter's think time, not the wire. For the error rates of each
+   * attempt, retries included, give the sender an InfiniLinkStats too.
+   * Nothing else should use the queue during a run, it would count as link time of the mix.
+   */
+  class InfiniStressTest {
+    public:
+    InfiniStressTest(InfiniCommandQueue &queue);
+
+    //! Adds commandType with params to the mix. Returns false if STRESS_MIX_SZ are added already, or during a run.
+    bool add(COMMAND_TYPE commandType, const char *params = "");
+    void clear();
+
+    //! Starts a run of durationMs, dropping the result of the last one. Returns false without a mix.
+    bool begin(unsigned long durationMs);
+    //! True from begin() until the last transaction of the run completed.
+    bool isRunning() const;
+
+    //! Keeps the queue fed while running. Call it from loop(), along with the queue's loop().
+    void loop();
+
+    const StressResult &result() const;
+    //! Transactions, and bytes, per second of the run, in tenths.
+    unsigned long transactionsPerS10() const;
+    unsigned long bytesPerS10() const;
+    //! bytesPerS10() against the baud rate's 10 bits a byte, in tenths of a percent.
+    unsigned long utilization10() const;
+    /*! Transactions per second the mix would reach with no turnaround at all, in tenths, e.g. 1.9 for GS alone
+     * at 2400 baud.
+     */
+    unsigned long wireLimitPerS10() const;
+    unsigned long meanTurnaroundMs() const;
+    //! Replies in bucket i of the turnaround histogram, see InfiniLinkStats::latencyBucketMaxMs().
+    unsigned long turnaroundBucket(BYTE i) const;
+
+    /*! Writes the result, e.g. {"stressMs":60000,"stressTx":98,"stressTxPerS":1.6,"stressWirePerS":1.9,
+     * "stressOk":98,...,"stressBytesPerS":198.2,"stressLinkPct":82.6,"stressTurnMin":81,"stressTurnAvg":95,
+     * "stressTurnMax":140,"stressTurn":[98,0,...]}.
+     */
+    size_t writeJson(Print &out) const;
+
+    private:
+    struct MixEntry {
+      COMMAND_TYPE commandType;
+      char params[MAX_PARAMS_SZ];
+    };
+
+    static void onComplete(const InfiniResponse &response, SEND_STATUS status, void *context);
+
+    InfiniCommandQueue &m_queue;
+    MixEntry m_mix[STRESS_MIX_SZ];
+    BYTE m_mixCount;
+    BYTE m_next;
+    bool m_running;
+    unsigned long m_startMs;
+    unsigned long m_durationMs;
+    //! Queued and not completed yet.
+    BYTE m_pending;
+    StressResult m_result;
+    unsigned long m_turnaround[LATENCY_BUCKETS];
+  };
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include "InfiniSupervisor.h"
+#include <stddef.h>
+
+namespace INFI {
+
+  InfiniSupervisor::InfiniSupervisor() :
+    m_count(0),
+    m_checkedMs(0)
+  {}
+
+  BYTE InfiniSupervisor::add(const char *name, unsigned long watchdogMs, HealthCheck check, SubsystemRestart restart,
+                             void *context, unsigned long nowMs) {
+    if (m_count >= SUPERVISOR_SZ || restart == NULL) {
+      return SUPERVISOR_SZ;
+    }
+    Subsystem &subsystem = m_subsystems[m_count];
+    subsystem.name = name;
+    subsystem.watchdogMs = watchdogMs;
+    subsystem.check = check;
+    subsystem.restart = restart;
+    subsystem.context = context;
+    subsystem.kickedMs = nowMs;
+    subsystem.restartedMs = nowMs;
+    subsystem.backoffMs = 0;
+    subsystem.restarts = 0;
+    subsystem.healthy = true;
+    return m_count++;
+  }
+
+  void InfiniSupervisor::kick(BYTE id, unsigned long nowMs) {
+    if (id < m_count) {
+      m_subsystems[id].kickedMs = nowMs;
+    }
+  }
+
+  void InfiniSupervisor::loop(unsigned long nowMs) {
+    if (nowMs - m_checkedMs < SUPERVISOR_CHECK_MS) {
+      return;
+    }
+    m_checkedMs = nowMs;
+    for (BYTE i = 0; i < m_count; ++i) {
+      supervise(m_subsystems[i], nowMs);
+    }
+  }
+
+  void InfiniSupervisor::supervise(Subsystem &subsystem, unsigned long nowMs) {
+    const bool starved = subsystem.watchdogMs > 0 && nowMs - subsystem.kickedMs >= subsystem.watchdogMs;
+    subsystem.healthy = !starved && (subsystem.check == NULL || subsystem.check(subsystem.context));
+    const unsigned long sinceRestart = nowMs - subsystem.restartedMs;
+    if (subsystem.healthy) {
+      if (subsystem.backoffMs > 0 && sinceRestart / 2 >= subsystem.backoffMs) {
+        subsystem.backoffMs = 0;
+      }
+      return;
+    }
+    if (sinceRestart < subsystem.backoffMs) {
+      // Still coming up, or given up on for a while.
+      return;
+    }
+    subsystem.restart(subsystem.context);
+    subsystem.restarts++;
+    subsystem.restartedMs = nowMs;
+    // A watchdog counts from the restart, the subsystem gets a whole one to show progress.
+    subsystem.kickedMs = nowMs;
+    if (subsystem.backoffMs == 0) {
+      subsystem.backoffMs = SUPERVISOR_MIN_BACKOFF_MS;
+    } else {
+      subsystem.backoffMs = subsystem.backoffMs > SUPERVISOR_MAX_BACKOFF_MS / 2 ? SUPERVISOR_MAX_BACKOFF_MS
+                                                                             : subsystem.backoffMs * 2;
+    }
+  }
+
+  unsigned long InfiniSupervisor::msUntilCheck(unsigned long nowMs) const {
+    return m_count == 0 ? NO_DEADLINE : msUntilElapsed(m_checkedMs, SUPERVISOR_CHECK_MS, nowMs);
+  }
+
+  BYTE InfiniSupervisor::size() const {
+    return m_count;
+  }
+
+  const char *InfiniSupervisor::name(BYTE id) const {
+    return id < m_count ? m_subsystems[id].name : "";
+  }
+
+  bool InfiniSupervisor::isHealthy(BYTE id) const {
+    return id < m_count && m_subsystems[id].healthy;
+  }
+
+  unsigned long InfiniSupervisor::restarts(BYTE id) const {
+    return id < m_count ? m_subsystems[id].restarts : 0;
+  }
+}
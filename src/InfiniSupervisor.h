@@ -0,0 +1,96 @@
+#ifndef INFINI_SUPERVISOR_H
+#define INFINI_SUPERVISOR_H
+
+#include "InfiniCommon.h"
+
+// Subsystems one InfiniSupervisor watches.
+#ifndef INFI_SUPERVISOR_SZ
+#define INFI_SUPERVISOR_SZ 6
+#endif
+
+// How often the health checks run, milliseconds.
+#ifndef INFI_SUPERVISOR_CHECK_MS
+#define INFI_SUPERVISOR_CHECK_MS 1000
+#endif
+
+// First and longest wait before a subsystem that is still failing is restarted again, milliseconds.
+#ifndef INFI_SUPERVISOR_MIN_BACKOFF_MS
+#define INFI_SUPERVISOR_MIN_BACKOFF_MS 10000
+#endif
+#ifndef INFI_SUPERVISOR_MAX_BACKOFF_MS
+#define INFI_SUPERVISOR_MAX_BACKOFF_MS 600000UL
+#endif
+
+namespace INFI {
+
+  const BYTE SUPERVISOR_SZ = INFI_SUPERVISOR_SZ;
+  const unsigned long SUPERVISOR_CHECK_MS = INFI_SUPERVISOR_CHECK_MS;
+  const unsigned long SUPERVISOR_MIN_BACKOFF_MS = INFI_SUPERVISOR_MIN_BACKOFF_MS;
+  const unsigned long SUPERVISOR_MAX_BACKOFF_MS = INFI_SUPERVISOR_MAX_BACKOFF_MS;
+
+  //! Whether a subsystem works, context is what was passed to InfiniSupervisor::add().
+  typedef bool (*HealthCheck)(void *context);
+  //! Tears a subsystem down and brings it up again, e.g. Serial2.end() and begin(). Should not block for long.
+  typedef void (*SubsystemRestart)(void *context);
+
+  /*!
+   * Restarts the parts of a sketch that stopped working one by one, so the rest keeps sampling and buffering
+   * instead of the whole device rebooting, which would lose the samples in RAM and the clock and energy models.
+   * Every subsystem has a software watchdog, kicked with kick() whenever it makes progress or has nothing to do,
+   * e.g. on every reply for a UART, and an optional health check. loop() runs the checks every SUPERVISOR_CHECK_MS.
+   * A subsystem that was not kicked for its watchdogMs, or whose check returns false, is restarted at once.
+   * If it is still failing after the restart, it is restarted again after SUPERVISOR_MIN_BACKOFF_MS, the wait
+   * doubling up to SUPERVISOR_MAX_BACKOFF_MS, so a part that cannot come back, e.g. an unplugged card, costs
+   * little. The wait goes back to none once a subsystem stayed healthy for twice its last wait.
+   */
+  class InfiniSupervisor {
+    public:
+    InfiniSupervisor();
+
+    /*! Watches a subsystem called name, a literal that is kept. A watchdogMs of 0 leaves only check,
+     * a NULL check only the watchdog. The watchdog starts kicked at nowMs.
+     * Returns the id for kick(), or SUPERVISOR_SZ if all are taken.
+     */
+    BYTE add(const char *name, unsigned long watchdogMs, HealthCheck check, SubsystemRestart restart,
+             void *context, unsigned long nowMs);
+
+    //! The subsystem id made progress, or has nothing to do.
+    void kick(BYTE id, unsigned long nowMs);
+
+    //! Runs the checks if SUPERVISOR_CHECK_MS passed, and restarts what fails.
+    void loop(unsigned long nowMs);
+    //! How long until loop() checks again, e.g. for idleFor().
+    unsigned long msUntilCheck(unsigned long nowMs) const;
+
+    BYTE size() const;
+    const char *name(BYTE id) const;
+    //! Whether id passed its last check.
+    bool isHealthy(BYTE id) const;
+    //! Restarts of id since boot.
+    unsigned long restarts(BYTE id) const;
+
+    private:
+    struct Subsystem {
+      const char *name;
+      unsigned long watchdogMs;
+      HealthCheck check;
+      SubsystemRestart restart;
+      void *context;
+      unsigned long kickedMs;
+      unsigned long restartedMs;
+      //! The wait before the next restart, 0 while healthy.
+      unsigned long backoffMs;
+      unsigned long restarts;
+      bool healthy;
+    };
+
+    //! Checks one subsystem and restarts it if it fails.
+    void supervise(Subsystem &subsystem, unsigned long nowMs);
+
+    Subsystem m_subsystems[SUPERVISOR_SZ];
+    BYTE m_count;
+    unsigned long m_checkedMs;
+  };
+}
+
+#endif
@@ -0,0 +1,159 @@
+#include "InfiniTelemetryBatch.h"
+
+#if INFI_MODULE_JSON
+#include <stdio.h>
+#include <string.h>
+
+namespace INFI {
+
+  //! Longest "key":value that addInt() and addString() build, null terminator included.
+  static const size_t MEMBER_SZ = 96;
+
+  InfiniTelemetryBatch::InfiniTelemetryBatch(char *buffer, size_t bufferSize, BYTE maxFields, TelemetryFlush flush,
+                                             void *context) :
+    m_buffer(buffer),
+    m_backBuffer(NULL),
+    m_bufferSize(bufferSize),
+    m_length(0),
+    m_maxFields(maxFields),
+    m_fields(0),
+    m_flush(flush),
+    m_context(context),
+    m_sealed(false)
+  {
+    if (m_bufferSize > 0) {
+      m_buffer[0] = '\0';
+    }
+  }
+
+  InfiniTelemetryBatch::InfiniTelemetryBatch(char *buffer, char *backBuffer, size_t bufferSize, BYTE maxFields,
+                                             TelemetryFlush flush, void *context) :
+    InfiniTelemetryBatch(buffer, bufferSize, maxFields, flush, context)
+  {
+    m_backBuffer = backBuffer;
+  }
+
+  bool InfiniTelemetryBatch::addInt(const char *key, long value) {
+    char member[MEMBER_SZ];
+    int len = snprintf(member, sizeof(member), "\"%s\":%ld", key, value);
+    return len > 0 && (size_t)len < sizeof(member) && addMember(member, len);
+  }
+
+  bool InfiniTelemetryBatch::addString(const char *key, const char *value) {
+    char member[MEMBER_SZ];
+    int len = snprintf(member, sizeof(member), "\"%s\":\"%s\"", key, value);
+    return len > 0 && (size_t)len < sizeof(member) && addMember(member, len);
+  }
+
+  bool InfiniTelemetryBatch::addJson(const char *json) {
+    const char *c = strchr(json, '{');
+    if (c == NULL) {
+      return false;
+    }
+    c++;
+    // Walk the top level members, a ',' or the closing '}' outside of strings and arrays ends one.
+    const char *start = c;
+    BYTE depth = 0;
+    bool inString = false;
+    for (; *c != '\0'; ++c) {
+      if (inString) {
+        if (*c == '\\' && c[1] != '\0') {
+          ++c;
+        } else if (*c == '"') {
+          inString = false;
+        }
+        continue;
+      }
+      if (*c == '"') {
+        inString = true;
+      } else if (*c == '[' || *c == '{') {
+        depth++;
+      } else if ((*c == ']' || *c == '}') && depth > 0) {
+        depth--;
+      } else if ((*c == ',' || *c == '}') && depth == 0) {
+        if (c > start && !addMember(start, c - start)) {
+          return false;
+        }
+        if (*c == '}') {
+          return true;
+        }
+        start = c + 1;
+      }
+    }
+    // No closing brace.
+    return false;
+  }
+
+  bool InfiniTelemetryBatch::flush() {
+    if (m_fields == 0) {
+      return true;
+    }
+    bool sent = true;
+    if (m_backBuffer == NULL) {
+      append("}", 1);
+      sent = m_flush == NULL || m_flush(m_buffer, m_context);
+    } else {
+      if (hasSealed()) {
+        return false;
+      }
+      append("}", 1);
+      char *sealed = m_buffer;
+      m_buffer = m_backBuffer;
+      m_backBuffer = sealed;
+      // Hands the sealed buffer over only once it is complete.
+      __atomic_store_n(&m_sealed, true, __ATOMIC_RELEASE);
+    }
+    m_length = 0;
+    m_fields = 0;
+    m_buffer[0] = '\0';
+    return sent;
+  }
+
+  bool InfiniTelemetryBatch::publishSealed() {
+    if (!hasSealed()) {
+      return true;
+    }
+    bool sent = m_flush == NULL || m_flush(m_backBuffer, m_context);
+    // flush() may seal into it again from here on.
+    __atomic_store_n(&m_sealed, false, __ATOMIC_RELEASE);
+    return sent;
+  }
+
+  bool InfiniTelemetryBatch::hasSealed() const {
+    return __atomic_load_n(&m_sealed, __ATOMIC_ACQUIRE);
+  }
+
+  BYTE InfiniTelemetryBatch::fieldCount() const {
+    return m_fields;
+  }
+
+  bool InfiniTelemetryBatch::isEmpty() const {
+    return m_fields == 0;
+  }
+
+  bool InfiniTelemetryBatch::addMember(const char *member, size_t len) {
+    // '{' or ',' before it, and room for the closing '}' and null terminator after it.
+    if (len + 3 > m_bufferSize) {
+      return false;
+    }
+    bool sent = true;
+    if (m_length + len + 3 > m_bufferSize || (m_maxFields > 0 && m_fields >= m_maxFields)) {
+      sent = flush();
+      if (m_fields > 0) {
+        // Could not be sealed while the last sealed buffer waits, there is no room for member.
+        return false;
+      }
+    }
+    append(m_fields == 0 ? "{" : ",", 1);
+    append(member, len);
+    m_fields++;
+    return sent;
+  }
+
+  void InfiniTelemetryBatch::append(const char *in, size_t len) {
+    memcpy(m_buffer + m_length, in, len);
+    m_length += len;
+    m_buffer[m_length] = '\0';
+  }
+}
+#endif
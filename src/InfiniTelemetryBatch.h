@@ -0,0 +1,86 @@
+#ifndef INFINI_TELEMETRY_BATCH_H
+#define INFINI_TELEMETRY_BATCH_H
+
+#include "InfiniCommon.h"
+#include <stddef.h>
+
+namespace INFI {
+
+  /*!
+   * Publishes json, a flat JSON object, e.g. with ThingsBoard's sendTelemetryJson().
+   * Returns false if it could not be sent.
+   */
+  typedef bool (*TelemetryFlush)(const char *json, void *context);
+
+  /*!
+   * Gathers the telemetry of a poll cycle into one JSON object, so it goes out as one publish
+   * instead of one per key or per query. The object is only split, by handing what is gathered
+   * to the flush callback early, when the next member would not fit in the buffer or would exceed maxFields.
+   * The buffer should leave room for the MQTT header and topic within the client's buffer.
+   *
+   * Given a second buffer of the same size the batch is double buffered, so the next cycle is gathered while the
+   * last one is still being published. flush(), and an early flush, then only seal what was gathered and carry on
+   * in the other buffer, and publishSealed() hands the sealed one to the flush callback. A cycle's sample period
+   * becomes the longer of its serial and network time instead of their sum. publishSealed() may run in another
+   * task than the rest, e.g. the one that owns the MQTT client. While a sealed buffer waits, the next flush() fails
+   * and keeps gathering, and a member that would need it to split the batch is dropped.
+   */
+  class InfiniTelemetryBatch {
+    public:
+    InfiniTelemetryBatch(char *buffer, size_t bufferSize, BYTE maxFields, TelemetryFlush flush, void *context = NULL);
+
+    //! Double buffered, both buffers are bufferSize. See the class comment.
+    InfiniTelemetryBatch(char *buffer, char *backBuffer, size_t bufferSize, BYTE maxFields, TelemetryFlush flush,
+                         void *context = NULL);
+
+    //! Adds "key":value. Returns false if it can not fit even in an empty batch, or an early flush failed.
+    bool addInt(const char *key, long value);
+
+    //! Adds "key":"value", value must not need escaping.
+    bool addString(const char *key, const char *value);
+
+    /*! Adds every member of the flat JSON object json, e.g. what the InfiniJsonWriter functions write.
+     * Members may be split across publishes, each member stays whole.
+     */
+    bool addJson(const char *json);
+
+    /*! Publishes whatever was gathered, if anything. Returns false if the flush callback failed.
+     * Double buffered, it seals it for publishSealed() instead, and returns false if the last sealed one still waits.
+     */
+    bool flush();
+
+    /*! Double buffered, publishes the buffer flush() sealed, if any, which frees it for the next one.
+     * Returns false if the flush callback failed, the buffer is freed anyway.
+     */
+    bool publishSealed();
+
+    //! Whether a sealed buffer waits for publishSealed().
+    bool hasSealed() const;
+
+    //! Number of members gathered since the last flush.
+    BYTE fieldCount() const;
+
+    bool isEmpty() const;
+
+    private:
+    //! Appends len chars of member, a whole "key":value, flushing first if needed.
+    bool addMember(const char *member, size_t len);
+
+    //! Appends len chars of in without any checks.
+    void append(const char *in, size_t len);
+
+    //! The buffer being gathered into.
+    char *m_buffer;
+    //! The other one when double buffered, NULL if not. Owned by publishSealed() while m_sealed is set.
+    char *m_backBuffer;
+    size_t m_bufferSize;
+    size_t m_length;
+    BYTE m_maxFields;
+    BYTE m_fields;
+    TelemetryFlush m_flush;
+    void *m_context;
+    volatile bool m_sealed;
+  };
+}
+
+#endif
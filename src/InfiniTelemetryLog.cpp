@@ -0,0 +1,216 @@
+#include "InfiniTelemetryLog.h"
+
+#if INFI_MODULE_SINKS
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <stddef.h>
+#include <string.h>
+#include "InfiniCRC.h"
+#include "InfiniJsonWriter.h"
+
+namespace INFI {
+  InfiniTelemetryLog::InfiniTelemetryLog(fs::FS &fs, const char *path) :
+    m_fs(fs),
+    m_readPos(0),
+    m_size(0),
+    m_dropped(0)
+  {
+    strncpy(m_path, path, sizeof(m_path) - 1);
+    m_path[sizeof(m_path) - 1] = '\0';
+    strncpy(m_posPath, m_path, sizeof(m_posPath) - 1);
+    m_posPath[sizeof(m_posPath) - 1] = '\0';
+    strncat(m_posPath, ".pos", sizeof(m_posPath) - strlen(m_posPath) - 1);
+  }
+
+  bool InfiniTelemetryLog::begin() {
+    m_readPos = 0;
+    m_size = 0;
+    if (m_fs.exists(m_path)) {
+      fs::File log = m_fs.open(m_path, "r");
+      if (!log) {
+        return false;
+      }
+      m_size = log.size();
+      log.close();
+    }
+    if (m_fs.exists(m_posPath)) {
+      fs::File pos = m_fs.open(m_posPath, "r");
+      if (pos && pos.read((uint8_t *)&m_readPos, sizeof(m_readPos)) != sizeof(m_readPos)) {
+        m_readPos = 0;
+      }
+      pos.close();
+    }
+    // A partial record at the end, e.g. from a reset mid write, is padded to a whole one,
+    // which then fails its CRC, so the next append lands on a record boundary again.
+    size_t partial = m_size % sizeof(Record);
+    if (partial != 0) {
+      uint8_t pad[sizeof(Record)];
+      memset(pad, 0xFF, sizeof(pad));
+      fs::File log = m_fs.open(m_path, "a");
+      if (!log || log.write(pad, sizeof(Record) - partial) != sizeof(Record) - partial) {
+        return false;
+      }
+      log.close();
+      m_size += sizeof(Record) - partial;
+    }
+    if (m_readPos > m_size) {
+      m_readPos = m_size;
+    }
+    return true;
+  }
+
+  bool InfiniTelemetryLog::append(const GeneralStatusFixed &gs, uint64_t tsMs) {
+    if (m_size + sizeof(Record) > TELEMETRY_LOG_MAX_SZ) {
+      m_dropped++;
+      return false;
+    }
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.tsMs = tsMs;
+    record.gs = gs;
+    record.crc = recordCrc(record);
+    fs::File log = m_fs.open(m_path, "a");
+    if (!log || log.write((const uint8_t *)&record, sizeof(record)) != sizeof(record)) {
+      m_dropped++;
+      return false;
+    }
+    log.close();
+    m_size += sizeof(record);
+    return true;
+  }
+
+  BYTE InfiniTelemetryLog::peek(InfiniGsHistory &out, BYTE maxRecords, WORD skipRecords) {
+    unsigned long start = m_readPos + (unsigned long)skipRecords * sizeof(Record);
+    if (start >= m_size || maxRecords == 0) {
+      return 0;
+    }
+    fs::File log = m_fs.open(m_path, "r");
+    if (!log || !log.seek(start)) {
+      return 0;
+    }
+    BYTE read = 0;
+    Record record;
+    while (read < maxRecords && start + (read + 1) * sizeof(Record) <= m_size) {
+      if (log.read((uint8_t *)&record, sizeof(record)) != sizeof(record)) {
+        break;
+      }
+      read++;
+      if (record.crc == recordCrc(record)) {
+        out.push(record.gs, record.tsMs);
+      }
+    }
+    log.close();
+    return read;
+  }
+
+  void InfiniTelemetryLog::consume(BYTE count) {
+    m_readPos += count * sizeof(Record);
+    if (m_readPos >= m_size) {
+      // Everything went out, start over with an empty log.
+      m_fs.remove(m_path);
+      m_fs.remove(m_posPath);
+      m_readPos = 0;
+      m_size = 0;
+      return;
+    }
+    savePosition();
+  }
+
+  bool InfiniTelemetryLog::hasRecords() const {
+    return m_readPos < m_size;
+  }
+
+  unsigned long InfiniTelemetryLog::dropped() const {
+    return m_dropped;
+  }
+
+  WORD InfiniTelemetryLog::recordCrc(const Record &record) {
+    return calc_crc_half((const BYTE *)&record, offsetof(Record, crc));
+  }
+
+  void InfiniTelemetryLog::savePosition() {
+    fs::File pos = m_fs.open(m_posPath, "w");
+    if (pos) {
+      pos.write((const uint8_t *)&m_readPos, sizeof(m_readPos));
+      pos.close();
+    }
+  }
+
+  InfiniLogDrain::InfiniLogDrain(InfiniTelemetryLog &log, char *buffer, size_t bufferSize, LogDrainPublish publish, void *context) :
+    m_log(log),
+    m_buffer(buffer),
+    m_bufferSize(bufferSize),
+    m_publish(publish),
+    m_context(context),
+    m_inflight(0),
+    m_skipRecords(0)
+  {
+  }
+
+  BYTE InfiniLogDrain::loop() {
+    BYTE published = 0;
+    while (m_inflight < LOG_DRAIN_WINDOW && m_bufferSize > 1) {
+      BYTE maxRecords = m_batch.capacity() < 255 ? (BYTE)m_batch.capacity() : 255;
+      BYTE records;
+      BYTE written;
+      for (;;) {
+        m_batch.pop(m_batch.size());
+        records = m_log.peek(m_batch, maxRecords, m_skipRecords);
+        if (records == 0) {
+          return published;
+        }
+        InfiniBufferPrint out(m_buffer, m_bufferSize);
+        GeneralStatusDelta delta;
+        written = m_batch.writeJson(out, delta, m_bufferSize - 1);
+        if (written >= m_batch.size()) {
+          break;
+        }
+        // Not all fit the buffer, peek only as many records. Some may fail their CRC, so fewer samples still.
+        maxRecords = written;
+      }
+      if (m_batch.isEmpty()) {
+        // Only records failing their CRC. Consumed right away if that keeps the order, else once the PUBACKs are in.
+        if (m_inflight > 0) {
+          return published;
+        }
+        m_log.consume(records);
+        continue;
+      }
+      uint16_t packetId = m_publish(m_buffer, m_context);
+      if (packetId == 0) {
+        return published;
+      }
+      m_packetIds[m_inflight] = packetId;
+      m_records[m_inflight] = records;
+      m_inflight++;
+      m_skipRecords += records;
+      published++;
+    }
+    return published;
+  }
+
+  bool InfiniLogDrain::onAck(uint16_t packetId) {
+    if (m_inflight == 0 || m_packetIds[0] != packetId) {
+      return false;
+    }
+    m_log.consume(m_records[0]);
+    m_skipRecords -= m_records[0];
+    m_inflight--;
+    memmove(m_packetIds, m_packetIds + 1, m_inflight * sizeof(m_packetIds[0]));
+    memmove(m_records, m_records + 1, m_inflight * sizeof(m_records[0]));
+    return true;
+  }
+
+  void InfiniLogDrain::reset() {
+    m_inflight = 0;
+    m_skipRecords = 0;
+  }
+
+  BYTE InfiniLogDrain::inflight() const {
+    return m_inflight;
+  }
+}
+
+#endif
+#endif
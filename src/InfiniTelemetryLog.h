@@ -0,0 +1,122 @@
+#ifndef INFINI_TELEMETRY_LOG_H
+#define INFINI_TELEMETRY_LOG_H
+
+#include "InfiniGsHistory.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <FS.h>
+
+// Largest the log file may grow to, in bytes. Samples beyond that are dropped until it drains.
+#ifndef INFI_TELEMETRY_LOG_MAX_SZ
+#define INFI_TELEMETRY_LOG_MAX_SZ 262144UL
+#endif
+
+// Uploads InfiniLogDrain keeps in flight at once, as PubSubClient's MQTT_MAX_INFLIGHT.
+#ifndef INFI_LOG_DRAIN_WINDOW
+#define INFI_LOG_DRAIN_WINDOW 4
+#endif
+
+namespace INFI {
+
+  const unsigned long TELEMETRY_LOG_MAX_SZ = INFI_TELEMETRY_LOG_MAX_SZ;
+  const BYTE LOG_DRAIN_WINDOW = INFI_LOG_DRAIN_WINDOW;
+
+  /*!
+   * An append-only log of timestamped GS samples in a flash file system, e.g. LittleFS on the
+   * data partition, so samples taken while WiFi or MQTT is down survive until they can be sent,
+   * even across a reboot. Records are fixed size binary, each with its own CRC.
+   * Draining is two step: peek() copies the oldest records out, consume() drops them
+   * once their upload went through. The read position is kept in a small file next to the log,
+   * and both files are removed once everything was consumed.
+   */
+  class InfiniTelemetryLog {
+    public:
+    //! path is the log file, the read position goes to path with ".pos" appended. At most 30 chars.
+    InfiniTelemetryLog(fs::FS &fs, const char *path = "/infi_gs.log");
+
+    //! Loads the read position. Call once the file system is mounted.
+    bool begin();
+
+    //! Appends a sample. Returns false if the log is full or the write failed.
+    bool append(const GeneralStatusFixed &gs, uint64_t tsMs);
+
+    /*! Pushes up to maxRecords of the oldest records into out, without consuming them.
+     * Records failing their CRC are skipped. Returns the number of records read, pass it to consume().
+     * skipRecords starts further in, past the records of uploads still waiting for their acknowledgement,
+     * so several can be in flight. consume() them in the order they were peeked.
+     */
+    BYTE peek(InfiniGsHistory &out, BYTE maxRecords, WORD skipRecords = 0);
+
+    //! Drops the count oldest records, i.e. what the last peek() returned.
+    void consume(BYTE count);
+
+    //! Whether there are records that were not consumed yet.
+    bool hasRecords() const;
+
+    //! Samples not logged because the log was full or a write failed.
+    unsigned long dropped() const;
+
+    private:
+    struct Record {
+      uint64_t tsMs;
+      GeneralStatusFixed gs;
+      WORD crc;
+    };
+
+    static WORD recordCrc(const Record &record);
+    void savePosition();
+
+    fs::FS &m_fs;
+    char m_path[32];
+    char m_posPath[36];
+    unsigned long m_readPos;
+    unsigned long m_size;
+    unsigned long m_dropped;
+  };
+
+  //! Publishes payload with QoS 1 without waiting for the PUBACK, e.g. with PubSubClient::publishQos1().
+  //! Returns the packet identifier, 0 if it was not sent.
+  typedef uint16_t (*LogDrainPublish)(const char *payload, void *context);
+
+  /*!
+   * Uploads an InfiniTelemetryLog over MQTT QoS 1 and trims it only once the broker acknowledged it.
+   * loop() peeks the records past the uploads in flight and publishes them as a telemetry array,
+   * up to LOG_DRAIN_WINDOW uploads at once. onAck() takes the PUBACKs, which come in the order
+   * the uploads were sent, and consumes the records of each. Call reset() on every connect:
+   * what was in flight without a PUBACK is published again. Samples are never lost, at worst
+   * a few go out twice, with the same timestamps.
+   */
+  class InfiniLogDrain {
+    public:
+    //! Payloads are written to buffer. Each upload starts with a full snapshot, so it reads on its own.
+    InfiniLogDrain(InfiniTelemetryLog &log, char *buffer, size_t bufferSize, LogDrainPublish publish, void *context = NULL);
+
+    //! Publishes as many uploads as the window has room for. Returns the number published.
+    BYTE loop();
+
+    //! Consumes the records of the upload with packetId, the oldest in flight. False for any other packet.
+    bool onAck(uint16_t packetId);
+
+    //! Forgets the uploads in flight, so loop() publishes them again. Call once connected.
+    void reset();
+
+    //! Uploads waiting for their PUBACK.
+    BYTE inflight() const;
+
+    private:
+    InfiniTelemetryLog &m_log;
+    char *m_buffer;
+    size_t m_bufferSize;
+    LogDrainPublish m_publish;
+    void *m_context;
+    InfiniGsHistory m_batch;
+    uint16_t m_packetIds[LOG_DRAIN_WINDOW];
+    BYTE m_records[LOG_DRAIN_WINDOW];
+    BYTE m_inflight;
+    WORD m_skipRecords;
+  };
+}
+
+#endif
+#endif
@@ -0,0 +1,237 @@
+#include "InfiniTimerWheel.h"
+
+#if INFI_MODULE_SCHEDULER
+#include <stddef.h>
+
+namespace INFI {
+
+  // Ticks each level reaches, 64 to the power of level + 1.
+  static inline uint32_t levelSpan(BYTE level) {
+    return 1UL << (6 * (level + 1));
+  }
+
+  InfiniTimerWheel::InfiniTimerWheel() :
+    m_tick(0),
+    m_tickMs(0),
+    m_free(0),
+    m_count(0)
+  {
+    for (BYTE i = 0; i < TIMER_WHEEL_SZ; ++i) {
+      m_timers[i].list = FREE;
+      m_timers[i].next = i + 1 < TIMER_WHEEL_SZ ? i + 1 : NONE;
+    }
+    for (WORD i = 0; i <= FIRING; ++i) {
+      m_heads[i] = NONE;
+    }
+    for (BYTE level = 0; level < LEVELS; ++level) {
+      m_used[level] = 0;
+    }
+  }
+
+  BYTE InfiniTimerWheel::start(unsigned long delayMs, TimerCallback callback, void *context, unsigned long nowMs,
+                               unsigned long periodMs) {
+    if (m_free == NONE || callback == NULL) {
+      return TIMER_WHEEL_SZ;
+    }
+    const BYTE id = m_free;
+    Timer &timer = m_timers[id];
+    m_free = timer.next;
+    timer.callback = callback;
+    timer.context = context;
+    timer.periodMs = periodMs;
+    timer.list = IDLE;
+    timer.deadline = deadlineOf(delayMs, nowMs);
+    schedule(id);
+    m_count++;
+    return id;
+  }
+
+  bool InfiniTimerWheel::restart(BYTE id, unsigned long delayMs, unsigned long nowMs) {
+    if (id >= TIMER_WHEEL_SZ || m_timers[id].list == FREE) {
+      return false;
+    }
+    unlink(id);
+    m_timers[id].deadline = deadlineOf(delayMs, nowMs);
+    schedule(id);
+    return true;
+  }
+
+  bool InfiniTimerWheel::cancel(BYTE id) {
+    if (id >= TIMER_WHEEL_SZ || m_timers[id].list == FREE) {
+      return false;
+    }
+    unlink(id);
+    m_timers[id].list = FREE;
+    m_timers[id].next = m_free;
+    m_free = id;
+    m_count--;
+    return true;
+  }
+
+  bool InfiniTimerWheel::isActive(BYTE id) const {
+    return id < TIMER_WHEEL_SZ && m_timers[id].list <= FIRING;
+  }
+
+  BYTE InfiniTimerWheel::size() const {
+    return m_count;
+  }
+
+  BYTE InfiniTimerWheel::loop(unsigned long nowMs) {
+    const unsigned long elapsedMs = nowMs - m_tickMs;
+    if ((long)elapsedMs < 0) {
+      // An older nowMs than the last one.
+      return 0;
+    }
+    const uint32_t end = m_tick + elapsedMs / TIMER_WHEEL_TICK_MS;
+    BYTE fired = 0;
+    uint32_t tick;
+    // Only the ticks where a slot fires or moves down are visited, the callbacks may add some on the way.
+    while (nextTick(tick) && tick - m_tick <= end - m_tick) {
+      m_tickMs += (tick - m_tick) * TIMER_WHEEL_TICK_MS;
+      m_tick = tick;
+      // From the top, so a timer can move down more than one level at the same tick.
+      for (BYTE level = LEVELS - 1; level > 0; --level) {
+        if ((tick & ((1UL << (6 * level)) - 1)) == 0) {
+          expire(level);
+        }
+      }
+      expire(0);
+      fired += fire(nowMs, end);
+    }
+    m_tickMs += (end - m_tick) * TIMER_WHEEL_TICK_MS;
+    m_tick = end;
+    return fired;
+  }
+
+  unsigned long InfiniTimerWheel::msUntilNext(unsigned long nowMs) const {
+    uint32_t tick;
+    if (!nextTick(tick)) {
+      return NO_DEADLINE;
+    }
+    const unsigned long dueMs = (tick - m_tick) * TIMER_WHEEL_TICK_MS;
+    const unsigned long elapsedMs = nowMs - m_tickMs;
+    return (long)elapsedMs >= 0 && elapsedMs < dueMs ? dueMs - elapsedMs : 0;
+  }
+
+  uint32_t InfiniTimerWheel::deadlineOf(unsigned long delayMs, unsigned long nowMs) const {
+    unsigned long sinceTickMs = nowMs - m_tickMs;
+    if ((long)sinceTickMs < 0) {
+      sinceTickMs = 0;
+    }
+    // Rounded up, in parts so a delay of NO_DEADLINE does not overflow.
+    uint32_t ticks = sinceTickMs / TIMER_WHEEL_TICK_MS + delayMs / TIMER_WHEEL_TICK_MS;
+    ticks += (sinceTickMs % TIMER_WHEEL_TICK_MS + delayMs % TIMER_WHEEL_TICK_MS + TIMER_WHEEL_TICK_MS - 1)
+             / TIMER_WHEEL_TICK_MS;
+    // The current tick was handled already.
+    return m_tick + (ticks > 0 ? ticks : 1);
+  }
+
+  void InfiniTimerWheel::schedule(BYTE id) {
+    Timer &timer = m_timers[id];
+    uint32_t delta = timer.deadline - m_tick;
+    if ((int32_t)delta < 0) {
+      // Overdue, fires at this tick.
+      delta = 0;
+      timer.deadline = m_tick;
+    }
+    BYTE level = 0;
+    while (level < LEVELS - 1 && delta >= levelSpan(level)) {
+      level++;
+    }
+    // Past the top level, it waits in its last slot and is put back from there.
+    const uint32_t at = delta < levelSpan(LEVELS - 1) ? timer.deadline : m_tick + levelSpan(LEVELS - 1) - 1;
+    link(id, level * SLOTS + ((at >> (6 * level)) & (SLOTS - 1)));
+  }
+
+  void InfiniTimerWheel::link(BYTE id, WORD list) {
+    Timer &timer = m_timers[id];
+    timer.list = list;
+    timer.prev = NONE;
+    timer.next = m_heads[list];
+    if (timer.next != NONE) {
+      m_timers[timer.next].prev = id;
+    }
+    m_heads[list] = id;
+    if (list < FIRING) {
+      m_used[list / SLOTS] |= (uint64_t)1 << (list % SLOTS);
+    }
+  }
+
+  void InfiniTimerWheel::unlink(BYTE id) {
+    Timer &timer = m_timers[id];
+    if (timer.list > FIRING) {
+      return;
+    }
+    if (timer.prev != NONE) {
+      m_timers[timer.prev].next = timer.next;
+    } else {
+      m_heads[timer.list] = timer.next;
+      if (timer.next == NONE && timer.list < FIRING) {
+        m_used[timer.list / SLOTS] &= ~((uint64_t)1 << (timer.list % SLOTS));
+      }
+    }
+    if (timer.next != NONE) {
+      m_timers[timer.next].prev = timer.prev;
+    }
+    timer.list = IDLE;
+  }
+
+  bool InfiniTimerWheel::nextTickOf(BYTE level, uint32_t &tick) const {
+    const uint64_t used = m_used[level];
+    if (used == 0) {
+      return false;
+    }
+    // The slots after the current one first, then round to it.
+    const uint32_t unit = m_tick >> (6 * level);
+    const BYTE from = (unit + 1) & (SLOTS - 1);
+    const uint64_t rotated = from == 0 ? used : (used >> from) | (used << (SLOTS - from));
+    tick = (unit + 1 + __builtin_ctzll(rotated)) << (6 * level);
+    return true;
+  }
+
+  bool InfiniTimerWheel::nextTick(uint32_t &tick) const {
+    bool found = false;
+    for (BYTE level = 0; level < LEVELS; ++level) {
+      uint32_t candidate;
+      if (nextTickOf(level, candidate) && (!found || candidate - m_tick < tick - m_tick)) {
+        tick = candidate;
+        found = true;
+      }
+    }
+    return found;
+  }
+
+  void InfiniTimerWheel::expire(BYTE level) {
+    const WORD list = level * SLOTS + ((m_tick >> (6 * level)) & (SLOTS - 1));
+    while (m_heads[list] != NONE) {
+      const BYTE id = m_heads[list];
+      unlink(id);
+      if (level == 0 && (int32_t)(m_timers[id].deadline - m_tick) <= 0) {
+        link(id, FIRING);
+      } else {
+        schedule(id);
+      }
+    }
+  }
+
+  BYTE InfiniTimerWheel::fire(unsigned long nowMs, uint32_t end) {
+    BYTE fired = 0;
+    while (m_heads[FIRING] != NONE) {
+      const BYTE id = m_heads[FIRING];
+      Timer &timer = m_timers[id];
+      unlink(id);
+      if (timer.periodMs > 0) {
+        // Queued again before the callback, which may still restart or cancel it.
+        timer.deadline += (timer.periodMs + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+        if (timer.deadline - m_tick <= end - m_tick) {
+          timer.deadline = deadlineOf(timer.periodMs, nowMs);
+        }
+        schedule(id);
+      }
+      timer.callback(timer.context);
+      fired++;
+    }
+    return fired;
+  }
+}
+#endif
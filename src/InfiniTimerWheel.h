@@ -0,0 +1,117 @@
+#ifndef INFINI_TIMER_WHEEL_H
+#define INFINI_TIMER_WHEEL_H
+
+#include <stdint.h>
+#include "InfiniCommon.h"
+
+// Timers one InfiniTimerWheel holds at most, up to 255.
+#ifndef INFI_TIMER_WHEEL_SZ
+#define INFI_TIMER_WHEEL_SZ 32
+#endif
+
+// Resolution of the wheel, milliseconds. A timer never fires early, and at most this late after loop() sees it due.
+#ifndef INFI_TIMER_WHEEL_TICK_MS
+#define INFI_TIMER_WHEEL_TICK_MS 10
+#endif
+
+namespace INFI {
+
+  const BYTE TIMER_WHEEL_SZ = INFI_TIMER_WHEEL_SZ;
+  const unsigned long TIMER_WHEEL_TICK_MS = INFI_TIMER_WHEEL_TICK_MS;
+  static_assert(INFI_TIMER_WHEEL_SZ < 255, "INFI_TIMER_WHEEL_SZ must be below 255");
+
+  //! What a timer runs when it fires, context is what was passed to InfiniTimerWheel::start().
+  typedef void (*TimerCallback)(void *context);
+
+  /*!
+   * Timers for a loop() with many of them, e.g. retries, deadlines and periodic uploads of several inverters,
+   * where checking every deadline on every pass no longer pays. A hierarchical wheel of 4 levels of 64 slots:
+   * the first covers the next 64 ticks a slot per tick, each level above 64 times as far with slots 64 times
+   * as wide, so 4 levels of 10 ms ticks reach 46 hours, and longer timers wait at the top. start() and cancel()
+   * are O(1), a timer moves down a level at most 3 times before it fires, and a bitmap of the slots in use lets
+   * loop() and msUntilNext() step over empty ones without looking at them.
+   *
+   * A timer keeps its id from start() until cancel(), so a one-shot one that fired can be restart()ed, e.g. for
+   * a retry. The callbacks run from loop(), which may start, restart or cancel timers, its own included.
+   * A periodic timer that fell behind, e.g. loop() not called for a while, fires once and goes on from then,
+   * it does not catch up. Not thread safe.
+   */
+  class InfiniTimerWheel {
+    public:
+    InfiniTimerWheel();
+
+    /*! Runs callback once delayMs passed from nowMs, then every periodMs if not 0, rounded up to whole ticks.
+     * Returns the id for cancel() and restart(), or TIMER_WHEEL_SZ if all are taken.
+     */
+    BYTE start(unsigned long delayMs, TimerCallback callback, void *context, unsigned long nowMs,
+               unsigned long periodMs = 0);
+
+    //! Makes id fire delayMs from nowMs instead, keeping its period, whether it still waits or not. False if it is free.
+    bool restart(BYTE id, unsigned long delayMs, unsigned long nowMs);
+
+    //! Stops id and frees it. False if it was free.
+    bool cancel(BYTE id);
+
+    //! Whether id waits to fire.
+    bool isActive(BYTE id) const;
+    //! Timers started and not cancelled.
+    BYTE size() const;
+
+    //! Runs the callbacks of the timers due at nowMs, oldest deadline first. Returns how many ran.
+    BYTE loop(unsigned long nowMs);
+
+    /*! Milliseconds until loop() has something to do, NO_DEADLINE without a timer, e.g. for idleFor().
+     * Never later than the next deadline, and early at most when a timer far out moves down a level.
+     */
+    unsigned long msUntilNext(unsigned long nowMs) const;
+
+    private:
+    static const BYTE LEVELS = 4;
+    static const BYTE SLOTS = 64;
+    //! The list of the timers firing at the current tick.
+    static const WORD FIRING = LEVELS * SLOTS;
+    //! Not on a list: a one-shot timer that fired, or a free one.
+    static const WORD IDLE = 0xFFFE;
+    static const WORD FREE = 0xFFFF;
+    static const BYTE NONE = 0xFF;
+
+    struct Timer {
+      //! In ticks of the wheel.
+      uint32_t deadline;
+      unsigned long periodMs;
+      TimerCallback callback;
+      void *context;
+      BYTE next;
+      BYTE prev;
+      //! The list it is on, a slot or FIRING, else IDLE or FREE. The free ones are chained through next.
+      WORD list;
+    };
+
+    //! The first tick at or after delayMs from nowMs, and after the current one.
+    uint32_t deadlineOf(unsigned long delayMs, unsigned long nowMs) const;
+    void schedule(BYTE id);
+    void link(BYTE id, WORD list);
+    void unlink(BYTE id);
+    //! The next tick after m_tick where a slot of level fires or moves down, false if the level is empty.
+    bool nextTickOf(BYTE level, uint32_t &tick) const;
+    //! The earliest such tick of all levels, false without a timer.
+    bool nextTick(uint32_t &tick) const;
+    //! Moves the timers of the slot of level at m_tick down a level, or to FIRING from the first.
+    void expire(BYTE level);
+    //! Runs the callbacks of FIRING. Periodic timers go on from nowMs, the tick end stands for.
+    BYTE fire(unsigned long nowMs, uint32_t end);
+
+    Timer m_timers[TIMER_WHEEL_SZ];
+    //! Heads of the slot lists, level by level, then FIRING.
+    BYTE m_heads[LEVELS * SLOTS + 1];
+    //! A bit per slot with timers, per level.
+    uint64_t m_used[LEVELS];
+    //! The last tick handled, and the ms it started at.
+    uint32_t m_tick;
+    unsigned long m_tickMs;
+    BYTE m_free;
+    BYTE m_count;
+  };
+}
+
+#endif
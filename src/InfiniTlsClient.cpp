@@ -0,0 +1,336 @@
+#include "InfiniTlsClient.h"
+
+#if INFI_MODULE_SINKS
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <stddef.h>
+#include <string.h>
+#include <Preferences.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/version.h>
+
+namespace INFI {
+
+  static const uint32_t FNV_OFFSET_BASIS = 2166136261UL;
+  static const uint32_t FNV_PRIME = 16777619UL;
+  static const char TLS_SESSION_KEY[] = "session";
+  static const char TLS_PERS[] = "infi_tls";
+
+  static uint32_t hashServer(const char *host, uint16_t port) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (const char *c = host; *c != '\0'; ++c) {
+      hash = (hash ^ (BYTE)*c) * FNV_PRIME;
+    }
+    hash = (hash ^ (port >> 8)) * FNV_PRIME;
+    return (hash ^ (port & 0xFF)) * FNV_PRIME;
+  }
+
+  InfiniTlsClient::InfiniTlsClient(TlsSessionState &session) :
+    m_session(session),
+    m_rootCA(NULL),
+    m_handshakeTimeoutMs(TLS_HANDSHAKE_TIMEOUT_MS),
+    m_tlsUp(false),
+    m_sawCertificate(false),
+    m_resumed(false),
+    m_handshakeMs(0),
+    m_peeked(-1)
+  {
+    mbedtls_ssl_init(&m_ssl);
+    mbedtls_ssl_config_init(&m_conf);
+    mbedtls_ctr_drbg_init(&m_drbg);
+    mbedtls_entropy_init(&m_entropy);
+    mbedtls_x509_crt_init(&m_ca);
+  }
+
+  InfiniTlsClient::~InfiniTlsClient() {
+    stop();
+  }
+
+  void InfiniTlsClient::setCACert(const char *rootCA) {
+    m_rootCA = rootCA;
+  }
+
+  void InfiniTlsClient::setHandshakeTimeout(unsigned long timeoutMs) {
+    m_handshakeTimeoutMs = timeoutMs;
+  }
+
+  bool InfiniTlsClient::isResumed() const {
+    return m_resumed;
+  }
+
+  unsigned long InfiniTlsClient::handshakeMs() const {
+    return m_handshakeMs;
+  }
+
+  void InfiniTlsClient::forgetSession() {
+    m_session.length = 0;
+  }
+
+  int InfiniTlsClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port);
+  }
+
+  int InfiniTlsClient::connect(const char *host, uint16_t port) {
+    stop();
+    return m_socket.connect(host, port) ? startTls(host, port) : 0;
+  }
+
+  int InfiniTlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+    return connect(ip.toString().c_str(), port, timeout);
+  }
+
+  int InfiniTlsClient::connect(const char *host, uint16_t port, int32_t timeout) {
+    stop();
+    return m_socket.connect(host, port, timeout) ? startTls(host, port) : 0;
+  }
+
+  int InfiniTlsClient::startTls(const char *host, uint16_t port) {
+    if (!handshake(host, port)) {
+      stop();
+      return 0;
+    }
+    return 1;
+  }
+
+  bool InfiniTlsClient::handshake(const char *host, uint16_t port) {
+    unsigned long start = millis();
+    if (mbedtls_ctr_drbg_seed(&m_drbg, mbedtls_entropy_func, &m_entropy,
+                              (const unsigned char *)TLS_PERS, sizeof(TLS_PERS) - 1) != 0 ||
+        mbedtls_ssl_config_defaults(&m_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+      return false;
+    }
+#if MBEDTLS_VERSION_NUMBER >= 0x03020000
+    mbedtls_ssl_conf_max_tls_version(&m_conf, MBEDTLS_SSL_VERSION_TLS1_2);
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&m_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+    if (m_rootCA != NULL) {
+      if (mbedtls_x509_crt_parse(&m_ca, (const unsigned char *)m_rootCA, strlen(m_rootCA) + 1) != 0) {
+        return false;
+      }
+      mbedtls_ssl_conf_ca_chain(&m_conf, &m_ca, NULL);
+      mbedtls_ssl_conf_authmode(&m_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    } else {
+      // Still walks the chain, so onVerify() tells a full handshake from a resumed one.
+      mbedtls_ssl_conf_authmode(&m_conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
+    }
+    mbedtls_ssl_conf_verify(&m_conf, onVerify, this);
+    mbedtls_ssl_conf_rng(&m_conf, mbedtls_ctr_drbg_random, &m_drbg);
+    if (mbedtls_ssl_setup(&m_ssl, &m_conf) != 0 || mbedtls_ssl_set_hostname(&m_ssl, host) != 0) {
+      return false;
+    }
+    mbedtls_ssl_set_bio(&m_ssl, this, sendTo, receiveFrom, NULL);
+    m_tlsUp = true;
+
+    uint32_t serverHash = hashServer(host, port);
+    offerSession(serverHash);
+    m_sawCertificate = false;
+    int ret;
+    while ((ret = mbedtls_ssl_handshake(&m_ssl)) != 0) {
+      if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        // Whatever the server rejected, the next try starts from scratch. A timeout keeps the session.
+        forgetSession();
+        return false;
+      }
+      if (millis() - start > m_handshakeTimeoutMs) {
+        return false;
+      }
+      delay(1);
+    }
+    m_handshakeMs = millis() - start;
+    m_resumed = !m_sawCertificate;
+    saveSession(serverHash);
+    return true;
+  }
+
+  void InfiniTlsClient::offerSession(uint32_t serverHash) {
+    if (m_session.version != TLS_SESSION_VERSION || m_session.serverHash != serverHash ||
+        m_session.length == 0 || m_session.length > TLS_SESSION_SZ) {
+      return;
+    }
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_session_load(&session, m_session.data, m_session.length) != 0 ||
+        mbedtls_ssl_set_session(&m_ssl, &session) != 0) {
+      // Saved by another build of mbedTLS.
+      forgetSession();
+    }
+    mbedtls_ssl_session_free(&session);
+  }
+
+  void InfiniTlsClient::saveSession(uint32_t serverHash) {
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    size_t length = 0;
+    if (mbedtls_ssl_get_session(&m_ssl, &session) == 0 &&
+        mbedtls_ssl_session_save(&session, m_session.data, TLS_SESSION_SZ, &length) == 0) {
+      m_session.version = TLS_SESSION_VERSION;
+      m_session.serverHash = serverHash;
+      m_session.length = length;
+    } else {
+      forgetSession();
+    }
+    mbedtls_ssl_session_free(&session);
+  }
+
+  void InfiniTlsClient::freeTls() {
+    mbedtls_ssl_free(&m_ssl);
+    mbedtls_ssl_config_free(&m_conf);
+    mbedtls_ctr_drbg_free(&m_drbg);
+    mbedtls_entropy_free(&m_entropy);
+    mbedtls_x509_crt_free(&m_ca);
+    mbedtls_ssl_init(&m_ssl);
+    mbedtls_ssl_config_init(&m_conf);
+    mbedtls_ctr_drbg_init(&m_drbg);
+    mbedtls_entropy_init(&m_entropy);
+    mbedtls_x509_crt_init(&m_ca);
+  }
+
+  int InfiniTlsClient::sendTo(void *context, const unsigned char *buf, size_t len) {
+    InfiniTlsClient &client = *(InfiniTlsClient *)context;
+    size_t written = client.m_socket.write(buf, len);
+    if (written > 0) {
+      return written;
+    }
+    return client.m_socket.connected() ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_CONN_RESET;
+  }
+
+  int InfiniTlsClient::receiveFrom(void *context, unsigned char *buf, size_t len) {
+    InfiniTlsClient &client = *(InfiniTlsClient *)context;
+    if (client.m_socket.available() <= 0) {
+      return client.m_socket.connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    int got = client.m_socket.read(buf, len);
+    return got > 0 ? got : MBEDTLS_ERR_SSL_WANT_READ;
+  }
+
+  int InfiniTlsClient::onVerify(void *context, mbedtls_x509_crt *crt, int depth, uint32_t *flags) {
+    InfiniTlsClient &client = *(InfiniTlsClient *)context;
+    client.m_sawCertificate = true;
+    return 0;
+  }
+
+  size_t InfiniTlsClient::write(uint8_t b) {
+    return write(&b, 1);
+  }
+
+  size_t InfiniTlsClient::write(const uint8_t *buf, size_t size) {
+    if (!m_tlsUp) {
+      return 0;
+    }
+    size_t done = 0;
+    unsigned long start = millis();
+    while (done < size) {
+      int ret = mbedtls_ssl_write(&m_ssl, buf + done, size - done);
+      if (ret > 0) {
+        done += ret;
+      } else if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+                 millis() - start > m_handshakeTimeoutMs) {
+        break;
+      }
+    }
+    return done;
+  }
+
+  int InfiniTlsClient::available() {
+    if (!m_tlsUp) {
+      return 0;
+    }
+    // Decrypts a record, if one came in, so its bytes count.
+    if (mbedtls_ssl_get_bytes_avail(&m_ssl) == 0 && m_socket.available() > 0) {
+      mbedtls_ssl_read(&m_ssl, NULL, 0);
+    }
+    return mbedtls_ssl_get_bytes_avail(&m_ssl) + (m_peeked >= 0 ? 1 : 0);
+  }
+
+  int InfiniTlsClient::read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+  }
+
+  int InfiniTlsClient::read(uint8_t *buf, size_t size) {
+    if (!m_tlsUp || size == 0) {
+      return -1;
+    }
+    size_t got = 0;
+    if (m_peeked >= 0) {
+      buf[got++] = m_peeked;
+      m_peeked = -1;
+      if (available() == 0) {
+        return got;
+      }
+    }
+    int ret = mbedtls_ssl_read(&m_ssl, buf + got, size - got);
+    if (ret > 0) {
+      return got + ret;
+    }
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+      // Closed by the server, or broken.
+      stop();
+    }
+    return got > 0 ? (int)got : -1;
+  }
+
+  int InfiniTlsClient::peek() {
+    if (m_peeked < 0 && available() > 0) {
+      uint8_t b;
+      if (mbedtls_ssl_read(&m_ssl, &b, 1) == 1) {
+        m_peeked = b;
+      }
+    }
+    return m_peeked;
+  }
+
+  void InfiniTlsClient::flush() {
+  }
+
+  void InfiniTlsClient::stop() {
+    if (m_tlsUp && m_socket.connected()) {
+      mbedtls_ssl_close_notify(&m_ssl);
+    }
+    m_socket.stop();
+    freeTls();
+    m_tlsUp = false;
+    m_peeked = -1;
+  }
+
+  uint8_t InfiniTlsClient::connected() {
+    return m_tlsUp && (m_socket.connected() || available() > 0);
+  }
+
+  InfiniTlsClient::operator bool() {
+    return connected();
+  }
+
+  bool saveTlsSession(const TlsSessionState &session, const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) {
+      return false;
+    }
+    // Only the used part of data.
+    size_t size = offsetof(TlsSessionState, data) + (session.length <= TLS_SESSION_SZ ? session.length : 0);
+    bool saved = prefs.putBytes(TLS_SESSION_KEY, &session, size) == size;
+    prefs.end();
+    return saved;
+  }
+
+  bool loadTlsSession(TlsSessionState &session, const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, true)) {
+      return false;
+    }
+    size_t size = prefs.getBytesLength(TLS_SESSION_KEY);
+    bool loaded = size >= offsetof(TlsSessionState, data) && size <= sizeof(session)
+      && prefs.getBytes(TLS_SESSION_KEY, &session, size) == size;
+    prefs.end();
+    if (loaded && session.version == TLS_SESSION_VERSION && offsetof(TlsSessionState, data) + session.length == size) {
+      return true;
+    }
+    session.length = 0;
+    return false;
+  }
+}
+#endif
+#endif
@@ -0,0 +1,131 @@
+#ifndef INFINI_TLS_CLIENT_H
+#define INFINI_TLS_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "InfiniCommon.h"
+
+// Largest serialized TLS session kept. With MBEDTLS_SSL_KEEP_PEER_CERTIFICATE, the ESP-IDF default,
+// the server's certificate is part of it, about 1.5 kB for a typical one. A bigger session is not kept.
+#ifndef INFI_TLS_SESSION_SZ
+#define INFI_TLS_SESSION_SZ 2048
+#endif
+
+// How long connect() waits for the TLS handshake, milliseconds.
+#ifndef INFI_TLS_HANDSHAKE_TIMEOUT_MS
+#define INFI_TLS_HANDSHAKE_TIMEOUT_MS 10000
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Client.h>
+#include <WiFiClient.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+#endif
+
+namespace INFI {
+
+  const size_t TLS_SESSION_SZ = INFI_TLS_SESSION_SZ;
+  const unsigned long TLS_HANDSHAKE_TIMEOUT_MS = INFI_TLS_HANDSHAKE_TIMEOUT_MS;
+
+  //! Bumped whenever TlsSessionState changes, a stored state of another version is not resumed.
+  const BYTE TLS_SESSION_VERSION = 1;
+
+  /*! The TLS session of the last handshake, plain data so it can live in RTC memory over deep sleep,
+   * e.g. RTC_DATA_ATTR, or be stored in NVS with saveTlsSession(). Zeroed it holds no session.
+   */
+  struct TlsSessionState {
+    BYTE version;
+    //! FNV-1a of the host name and the port, a session is only offered to the server it came from.
+    uint32_t serverHash;
+    //! Bytes of data used, 0 if there is no session.
+    uint16_t length;
+    BYTE data[TLS_SESSION_SZ];
+  };
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /*!
+   * A TLS client for the MQTT connection that resumes its last session instead of doing a full handshake,
+   * e.g. tb(tlsClient) on port 8883. A full handshake costs the certificate chain on the wire and seconds of
+   * ECDHE and RSA on the CPU, every reconnect and every deep sleep wake. A resumed one is a round trip with
+   * only symmetric crypto. The session, its ID and the session ticket if the server issued one, is saved into
+   * the TlsSessionState as soon as a handshake is done and offered on the next connect() to the same host and port.
+   * A server that forgot it simply answers with a full handshake, whose session replaces it.
+   * WiFiClientSecure can't be given a session, so this drives mbedTLS itself over a WiFiClient.
+   * Pinned to TLS 1.2, where the session is complete at the end of the handshake.
+   */
+  class InfiniTlsClient : public Client {
+    public:
+    InfiniTlsClient(TlsSessionState &session);
+    ~InfiniTlsClient();
+
+    /*! The root certificate the server's chain is checked against, in PEM. It must outlive the client.
+     * Without one the server is not authenticated.
+     */
+    void setCACert(const char *rootCA);
+    void setHandshakeTimeout(unsigned long timeoutMs);
+
+    //! Whether the last handshake resumed the kept session, i.e. the server sent no certificate.
+    bool isResumed() const;
+    //! How long the last handshake took, milliseconds.
+    unsigned long handshakeMs() const;
+    //! Drops the kept session, the next connect() does a full handshake.
+    void forgetSession();
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char *host, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeout);
+    int connect(const char *host, uint16_t port, int32_t timeout);
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t *buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override;
+
+    private:
+    static int sendTo(void *context, const unsigned char *buf, size_t len);
+    static int receiveFrom(void *context, unsigned char *buf, size_t len);
+    static int onVerify(void *context, mbedtls_x509_crt *crt, int depth, uint32_t *flags);
+
+    //! Runs the handshake on the connected socket, closes it if that fails.
+    int startTls(const char *host, uint16_t port);
+    //! Sets up mbedTLS for host and runs the handshake.
+    bool handshake(const char *host, uint16_t port);
+    //! Offers the kept session if it came from serverHash.
+    void offerSession(uint32_t serverHash);
+    void saveSession(uint32_t serverHash);
+    void freeTls();
+
+    WiFiClient m_socket;
+    TlsSessionState &m_session;
+    const char *m_rootCA;
+    unsigned long m_handshakeTimeoutMs;
+    mbedtls_ssl_context m_ssl;
+    mbedtls_ssl_config m_conf;
+    mbedtls_ctr_drbg_context m_drbg;
+    mbedtls_entropy_context m_entropy;
+    mbedtls_x509_crt m_ca;
+    bool m_tlsUp;
+    //! Set while the server's certificate is checked, which a resumed handshake skips.
+    bool m_sawCertificate;
+    bool m_resumed;
+    unsigned long m_handshakeMs;
+    //! The byte peek() took, -1 if none.
+    int m_peeked;
+  };
+
+  //! Stores session in the NVS namespace ns, for a reboot rather than a deep sleep. Returns false on failure.
+  bool saveTlsSession(const TlsSessionState &session, const char *ns = "infi_tls");
+  //! Loads what saveTlsSession() stored into session. Returns false, with no session kept, if there is none.
+  bool loadTlsSession(TlsSessionState &session, const char *ns = "infi_tls");
+#endif
+}
+
+#endif
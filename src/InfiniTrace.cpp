@@ -0,0 +1,79 @@
+#include "InfiniTrace.h"
+#include <Arduino.h>
+
+namespace INFI {
+
+  static const char *const TRACE_STAGE_NAMES[NUM_TRACE_STAGES] = {
+    "tx", "inverter", "rx", "crc", "parse", "serialize", "publish", "network"
+  };
+
+  const char *getTraceStageName(TRACE_STAGE stage) {
+    return stage < NUM_TRACE_STAGES ? TRACE_STAGE_NAMES[stage] : "?";
+  }
+
+#if INFI_TRACE
+  static TraceEvent traceRing[TRACE_EVENTS];
+  //! Events recorded since boot or clearTrace(), the next one goes to traceNext % TRACE_EVENTS.
+  static volatile uint32_t traceNext = 0;
+
+  //! Claims the slot of the next event. Trace points run in several tasks and ISRs on ESP32.
+  static uint32_t claimTraceSlot() {
+#if defined(ARDUINO_ARCH_ESP32)
+    return __atomic_fetch_add(&traceNext, 1, __ATOMIC_RELAXED);
+#else
+    noInterrupts();
+    uint32_t slot = traceNext++;
+    interrupts();
+    return slot;
+#endif
+  }
+
+  void traceEvent(TRACE_STAGE stage, char phase, uint16_t arg) {
+    TraceEvent &event = traceRing[claimTraceSlot() & (TRACE_EVENTS - 1)];
+    event.us = micros();
+    event.arg = arg;
+#if defined(ARDUINO_ARCH_ESP32)
+    event.stage = (BYTE)(stage | (xPortGetCoreID() << 7));
+#else
+    event.stage = (BYTE)stage;
+#endif
+    event.phase = phase;
+  }
+
+  size_t writeTraceJson(Print &out) {
+    uint32_t next = traceNext;
+    uint32_t count = next < TRACE_EVENTS ? next : TRACE_EVENTS;
+    size_t n = out.print(INFI_F("{\"traceEvents\":["));
+    for (uint32_t i = next - count; i != next; ++i) {
+      const TraceEvent &event = traceRing[i & (TRACE_EVENTS - 1)];
+      n += out.print(i == next - count ? "{\"name\":\"" : ",{\"name\":\"");
+      n += out.print(getTraceStageName((TRACE_STAGE)(event.stage & 0x7F)));
+      n += out.print(INFI_F("\",\"ph\":\""));
+      n += out.print(event.phase);
+      n += out.print(INFI_F("\",\"ts\":"));
+      n += out.print((unsigned long)event.us);
+      n += out.print(INFI_F(",\"pid\":0,\"tid\":"));
+      n += out.print(event.stage >> 7);
+      n += out.print(INFI_F(",\"args\":{\"arg\":"));
+      n += out.print(event.arg);
+      n += out.print("}}");
+    }
+    n += out.print("]}");
+    return n;
+  }
+
+  void clearTrace() {
+    traceNext = 0;
+  }
+#else
+  void traceEvent(TRACE_STAGE, char, uint16_t) {
+  }
+
+  size_t writeTraceJson(Print &out) {
+    return out.print(INFI_F("{\"traceEvents\":[]}"));
+  }
+
+  void clearTrace() {
+  }
+#endif
+}
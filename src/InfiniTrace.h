@@ -0,0 +1,97 @@
+#ifndef INFINI_TRACE_H
+#define INFINI_TRACE_H
+
+#include <Print.h>
+#include "InfiniCommon.h"
+
+// Set to 1 to record the trace points. Left at 0, every INFI_TRACE_* compiles to nothing.
+#ifndef INFI_TRACE
+#define INFI_TRACE 0
+#endif
+
+// Events the trace ring keeps, a power of two. Once full the oldest are overwritten. 8 bytes each.
+#ifndef INFI_TRACE_EVENTS
+#define INFI_TRACE_EVENTS 256
+#endif
+
+namespace INFI {
+
+  const uint32_t TRACE_EVENTS = INFI_TRACE_EVENTS;
+  static_assert((TRACE_EVENTS & (TRACE_EVENTS - 1)) == 0, "INFI_TRACE_EVENTS must be a power of two");
+
+  //! The parts of a polling cycle the trace points mark.
+  enum TRACE_STAGE {
+    TRACE_TX = 0,     // Writing a command to the link.
+    TRACE_WAIT,       // From the command written to the first byte of its reply: its wire time and the inverter's turnaround.
+    TRACE_RX,         // Receiving the reply, from its first byte until it is complete or timed out.
+    TRACE_CRC,        // Checking the reply's start, length and CRC.
+    TRACE_PARSE,      // Decoding it.
+    TRACE_SERIALIZE,  // Writing telemetry JSON.
+    TRACE_PUBLISH,    // Handing it to the MQTT client.
+    TRACE_NETWORK,    // The MQTT client's own loop, e.g. tb.loop().
+
+    NUM_TRACE_STAGES
+  };
+
+  //! One trace point, arg is whatever the point passes, e.g. the COMMAND_TYPE.
+  struct TraceEvent {
+    //! micros() when it was recorded.
+    uint32_t us;
+    uint16_t arg;
+    //! The TRACE_STAGE, with the core it ran on in the top bit.
+    BYTE stage;
+    //! 'B' where the stage begins, 'E' where it ends.
+    char phase;
+  };
+
+  //! Short name of stage, as it shows in the trace viewer.
+  const char *getTraceStageName(TRACE_STAGE stage);
+
+  //! Records a trace point, from any task or ISR. Use the INFI_TRACE_* macros rather than calling it directly.
+  void traceEvent(TRACE_STAGE stage, char phase, uint16_t arg);
+
+  /*!
+   * Writes the recorded events, oldest first, as Chrome trace-event JSON, e.g.
+   * {"traceEvents":[{"name":"rx","ph":"B","ts":1234567,"pid":0,"tid":0,"args":{"arg":3}},...]}.
+   * Load it in chrome://tracing or Perfetto. tid is the core the event ran on.
+   * An empty array without INFI_TRACE. Events recorded while it runs may show up torn.
+   */
+  size_t writeTraceJson(Print &out);
+
+  //! Drops every recorded event.
+  void clearTrace();
+
+  //! Records the begin of stage on construction and its end when going out of scope.
+  class InfiniTraceScope {
+    public:
+    InfiniTraceScope(TRACE_STAGE stage, uint16_t arg) :
+      m_stage(stage),
+      m_arg(arg)
+    {
+      traceEvent(m_stage, 'B', m_arg);
+    }
+
+    ~InfiniTraceScope() {
+      traceEvent(m_stage, 'E', m_arg);
+    }
+
+    private:
+    TRACE_STAGE m_stage;
+    uint16_t m_arg;
+  };
+}
+
+#if INFI_TRACE
+#define INFI_TRACE_BEGIN(stage, arg) INFI::traceEvent((stage), 'B', (uint16_t)(arg))
+#define INFI_TRACE_END(stage, arg) INFI::traceEvent((stage), 'E', (uint16_t)(arg))
+#define INFI_TRACE_CONCAT(a, b) a##b
+#define INFI_TRACE_NAME(line) INFI_TRACE_CONCAT(infiTraceScope, line)
+//! Traces stage from here to the end of the enclosing block.
+#define INFI_TRACE_SCOPE(stage, arg) INFI::InfiniTraceScope INFI_TRACE_NAME(__LINE__)((stage), (uint16_t)(arg))
+#else
+#define INFI_TRACE_BEGIN(stage, arg) ((void)0)
+#define INFI_TRACE_END(stage, arg) ((void)0)
+#define INFI_TRACE_SCOPE(stage, arg) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,108 @@
+#include "InfiniUploadPacer.h"
+
+#if INFI_MODULE_SINKS
+
+namespace INFI {
+
+  InfiniUploadPacer::InfiniUploadPacer(unsigned long bytesPerS, unsigned long messagesPerS) :
+    m_state(0x9E3779B9UL),
+    m_bytesPerS(0),
+    m_messagesPerS(0),
+    m_bytesMilli(0),
+    m_messagesMilli(0),
+    m_refillMs(0),
+    m_wanted(0),
+    m_waiting(false)
+  {
+    setRates(bytesPerS, messagesPerS, 0);
+  }
+
+  void InfiniUploadPacer::seed(uint32_t seed) {
+    // Seeds a bit apart, e.g. consecutive MACs, would start xorshift on draws a bit apart too.
+    seed ^= seed >> 16;
+    seed *= 0x85EBCA6BUL;
+    seed ^= seed >> 13;
+    seed *= 0xC2B2AE35UL;
+    seed ^= seed >> 16;
+    // xorshift never leaves 0.
+    m_state = seed != 0 ? seed : 0x9E3779B9UL;
+  }
+
+  unsigned long InfiniUploadPacer::jitterMs(unsigned long maxMs) {
+    if (maxMs == 0) {
+      return 0;
+    }
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 17;
+    m_state ^= m_state << 5;
+    return m_state % maxMs;
+  }
+
+  void InfiniUploadPacer::setRates(unsigned long bytesPerS, unsigned long messagesPerS, unsigned long nowMs) {
+    m_bytesPerS = bytesPerS;
+    m_messagesPerS = messagesPerS;
+    m_bytesMilli = (uint64_t)bytesPerS * 1000;
+    m_messagesMilli = (uint64_t)messagesPerS * 1000;
+    m_refillMs = nowMs;
+  }
+
+  unsigned long InfiniUploadPacer::bytesPerS() const {
+    return m_bytesPerS;
+  }
+
+  unsigned long InfiniUploadPacer::messagesPerS() const {
+    return m_messagesPerS;
+  }
+
+  void InfiniUploadPacer::refill(unsigned long nowMs) {
+    const uint64_t elapsedMs = nowMs - m_refillMs;
+    m_refillMs = nowMs;
+    // A bucket holds a second's worth, in thousandths that is the rate times 1000.
+    const uint64_t bytesFull = (uint64_t)m_bytesPerS * 1000;
+    const uint64_t messagesFull = (uint64_t)m_messagesPerS * 1000;
+    m_bytesMilli += m_bytesPerS * elapsedMs;
+    m_messagesMilli += m_messagesPerS * elapsedMs;
+    if (m_bytesMilli > bytesFull) {
+      m_bytesMilli = bytesFull;
+    }
+    if (m_messagesMilli > messagesFull) {
+      m_messagesMilli = messagesFull;
+    }
+  }
+
+  bool InfiniUploadPacer::take(size_t bytes, unsigned long nowMs) {
+    refill(nowMs);
+    // Larger than the bucket, it goes once the bucket is full.
+    const uint64_t bytesNeeded = (uint64_t)(bytes < m_bytesPerS ? bytes : m_bytesPerS) * 1000;
+    const uint64_t messagesNeeded = m_messagesPerS > 0 ? 1000 : 0;
+    if (m_bytesMilli < bytesNeeded || m_messagesMilli < messagesNeeded) {
+      m_wanted = bytes;
+      m_waiting = true;
+      return false;
+    }
+    m_bytesMilli -= bytesNeeded;
+    m_messagesMilli -= messagesNeeded;
+    m_waiting = false;
+    return true;
+  }
+
+  unsigned long InfiniUploadPacer::msUntilAvailable(unsigned long nowMs) {
+    if (!m_waiting) {
+      return 0;
+    }
+    refill(nowMs);
+    const uint64_t bytesNeeded = (uint64_t)(m_wanted < m_bytesPerS ? m_wanted : m_bytesPerS) * 1000;
+    const uint64_t messagesNeeded = m_messagesPerS > 0 ? 1000 : 0;
+    unsigned long waitMs = 0;
+    // Rounded up, so the take() after the wait passes.
+    if (m_bytesMilli < bytesNeeded) {
+      waitMs = (unsigned long)((bytesNeeded - m_bytesMilli + m_bytesPerS - 1) / m_bytesPerS);
+    }
+    if (m_messagesMilli < messagesNeeded) {
+      const unsigned long messagesMs = (unsigned long)((messagesNeeded - m_messagesMilli + m_messagesPerS - 1) / m_messagesPerS);
+      waitMs = messagesMs > waitMs ? messagesMs : waitMs;
+    }
+    return waitMs;
+  }
+}
+#endif
@@ -0,0 +1,56 @@
+#ifndef INFINI_UPLOAD_PACER_H
+#define INFINI_UPLOAD_PACER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "InfiniCommon.h"
+
+namespace INFI {
+
+  /*!
+   * Spreads the uploads of a fleet over time, so units that come back together after a regional outage
+   * do not all reconnect and flush their backlogs in the same second.
+   *
+   * jitterMs() draws delays from a generator seeded with something unique to the unit, e.g. its MAC, so every
+   * unit waits its own time before a reconnect or a flush, and the same unit keeps different draws apart.
+   * take() passes a backlog publish through two token buckets, one of bytes and one of messages a second.
+   * Each holds a second's worth, so a unit may burst that much and then goes at the rates. A publish larger
+   * than a bucket only waits for it to be full. A rate of 0 takes that bucket out.
+   */
+  class InfiniUploadPacer {
+    public:
+    InfiniUploadPacer(unsigned long bytesPerS = 0, unsigned long messagesPerS = 0);
+
+    //! Seeds jitterMs(), e.g. with the low 32 bits of the MAC. Units with different seeds draw apart.
+    void seed(uint32_t seed);
+    //! A delay in [0, maxMs). 0 for a maxMs of 0.
+    unsigned long jitterMs(unsigned long maxMs);
+
+    //! Changes the rates, e.g. from the server. Both buckets start over full.
+    void setRates(unsigned long bytesPerS, unsigned long messagesPerS, unsigned long nowMs);
+    unsigned long bytesPerS() const;
+    unsigned long messagesPerS() const;
+
+    //! Takes a message of bytes from the buckets if both hold enough at nowMs. False leaves them as they were.
+    bool take(size_t bytes, unsigned long nowMs);
+    //! How long until the message take() last refused would pass, 0 if none was refused since.
+    unsigned long msUntilAvailable(unsigned long nowMs);
+
+    private:
+    //! Tops the buckets up for the time since the last refill.
+    void refill(unsigned long nowMs);
+
+    uint32_t m_state;
+    unsigned long m_bytesPerS;
+    unsigned long m_messagesPerS;
+    //! The buckets in thousandths, so a rate of a few bytes a second refills every ms too.
+    uint64_t m_bytesMilli;
+    uint64_t m_messagesMilli;
+    unsigned long m_refillMs;
+    //! The size take() last refused, while m_waiting.
+    size_t m_wanted;
+    bool m_waiting;
+  };
+}
+
+#endif
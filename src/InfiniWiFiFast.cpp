@@ -0,0 +1,144 @@
+#include "InfiniWiFiFast.h"
+
+#if INFI_MODULE_SINKS
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <string.h>
+#include <WiFi.h>
+#include <Preferences.h>
+
+namespace INFI {
+
+  static const uint32_t FNV_OFFSET_BASIS = 2166136261UL;
+  static const uint32_t FNV_PRIME = 16777619UL;
+  static const char WIFI_FAST_KEY[] = "ap";
+
+  static uint32_t hashSsid(const char *ssid) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (const char *c = ssid; *c != '\0'; ++c) {
+      hash = (hash ^ (BYTE)*c) * FNV_PRIME;
+    }
+    return hash;
+  }
+
+  InfiniWiFiFast::InfiniWiFiFast(WiFiFastState &state) :
+    m_state(state),
+    m_reuseLease(false),
+    m_fast(false),
+    m_ssidHash(0)
+  {}
+
+  void InfiniWiFiFast::setReuseLease(bool reuse) {
+    m_reuseLease = reuse;
+  }
+
+  bool InfiniWiFiFast::hasCache(const char *ssid) const {
+    return m_state.version == WIFI_FAST_VERSION && m_state.channel != 0 && m_state.ssidHash == hashSsid(ssid);
+  }
+
+  void InfiniWiFiFast::begin(const char *ssid, const char *password) {
+    m_ssidHash = hashSsid(ssid);
+    m_fast = hasCache(ssid);
+    WiFi.mode(WIFI_STA);
+    if (m_fast && m_reuseLease && m_state.ip != 0) {
+      WiFi.config(IPAddress(m_state.ip), IPAddress(m_state.gateway), IPAddress(m_state.subnet), IPAddress(m_state.dns));
+    } else {
+      // Back to DHCP, a static config is kept by the driver otherwise.
+      WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+    }
+    if (m_fast) {
+      WiFi.begin(ssid, password, m_state.channel, m_state.bssid);
+    } else {
+      WiFi.begin(ssid, password);
+    }
+  }
+
+  bool InfiniWiFiFast::isFast() const {
+    return m_fast;
+  }
+
+  bool InfiniWiFiFast::onConnected() {
+    WiFiFastState current;
+    memset(&current, 0, sizeof(current));
+    current.version = WIFI_FAST_VERSION;
+    current.ssidHash = m_ssidHash;
+    const uint8_t *bssid = WiFi.BSSID();
+    if (bssid != NULL) {
+      memcpy(current.bssid, bssid, sizeof(current.bssid));
+    }
+    current.channel = WiFi.channel();
+    current.ip = (uint32_t)WiFi.localIP();
+    current.gateway = (uint32_t)WiFi.gatewayIP();
+    current.subnet = (uint32_t)WiFi.subnetMask();
+    current.dns = (uint32_t)WiFi.dnsIP();
+    if (memcmp(&current, &m_state, sizeof(current)) == 0) {
+      return false;
+    }
+    m_state = current;
+    return true;
+  }
+
+  void InfiniWiFiFast::onFailed() {
+    if (m_fast) {
+      memset(&m_state, 0, sizeof(m_state));
+      m_fast = false;
+    }
+  }
+
+  bool InfiniWiFiFast::connect(const char *ssid, const char *password, unsigned long timeoutMs) {
+    unsigned long start = millis();
+    begin(ssid, password);
+    if (m_fast) {
+      if (waitConnected(start, timeoutMs < WIFI_FAST_TIMEOUT_MS ? timeoutMs : WIFI_FAST_TIMEOUT_MS)) {
+        onConnected();
+        return true;
+      }
+      onFailed();
+      WiFi.disconnect();
+      begin(ssid, password);
+    }
+    if (!waitConnected(start, timeoutMs)) {
+      return false;
+    }
+    onConnected();
+    return true;
+  }
+
+  bool InfiniWiFiFast::waitConnected(unsigned long start, unsigned long timeoutMs) {
+    while (WiFi.status() != WL_CONNECTED) {
+      if (millis() - start > timeoutMs) {
+        return false;
+      }
+      delay(10);
+    }
+    return true;
+  }
+
+  bool saveWiFiFast(const WiFiFastState &state, const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) {
+      return false;
+    }
+    bool saved = prefs.putBytes(WIFI_FAST_KEY, &state, sizeof(state)) == sizeof(state);
+    prefs.end();
+    return saved;
+  }
+
+  bool loadWiFiFast(WiFiFastState &state, const char *ns) {
+    Preferences prefs;
+    if (!prefs.begin(ns, true)) {
+      memset(&state, 0, sizeof(state));
+      return false;
+    }
+    bool loaded = prefs.getBytesLength(WIFI_FAST_KEY) == sizeof(state)
+      && prefs.getBytes(WIFI_FAST_KEY, &state, sizeof(state)) == sizeof(state)
+      && state.version == WIFI_FAST_VERSION;
+    prefs.end();
+    if (!loaded) {
+      memset(&state, 0, sizeof(state));
+    }
+    return loaded;
+  }
+}
+#endif
+#endif
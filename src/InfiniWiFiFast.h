@@ -0,0 +1,87 @@
+#ifndef INFINI_WIFI_FAST_H
+#define INFINI_WIFI_FAST_H
+
+#include <stdint.h>
+#include "InfiniCommon.h"
+
+// How long a connect with the cached AP may take before the full scan is tried, milliseconds.
+// A fast connect takes a few hundred ms when it works.
+#ifndef INFI_WIFI_FAST_TIMEOUT_MS
+#define INFI_WIFI_FAST_TIMEOUT_MS 2000
+#endif
+
+namespace INFI {
+
+  const unsigned long WIFI_FAST_TIMEOUT_MS = INFI_WIFI_FAST_TIMEOUT_MS;
+
+  //! Bumped whenever WiFiFastState changes, a stored state of another version is not used.
+  const BYTE WIFI_FAST_VERSION = 1;
+
+  /*! The AP and IP lease of the last connect, plain data so it can live in RTC memory over deep sleep,
+   * e.g. RTC_DATA_ATTR, or be stored in NVS with saveWiFiFast(). Zeroed it holds nothing.
+   */
+  struct WiFiFastState {
+    BYTE version;
+    //! FNV-1a of the SSID it was learnt for.
+    uint32_t ssidHash;
+    BYTE bssid[6];
+    BYTE channel;
+    //! The lease, in network order as IPAddress keeps it.
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+  };
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /*!
+   * Connects to the AP of the last connect without scanning, WiFi.begin() with its BSSID and channel, and with
+   * setReuseLease() also without DHCP, configuring the IP it leased last as static. That takes a few hundred ms
+   * instead of the 2 to 5 s of a scan, association and DHCP, the bulk of a duty cycled wake.
+   * A fast attempt that fails, e.g. the AP moved channel, forgets the cache and the next begin() scans.
+   * Either drive it by events, begin(), then onConnected() on got IP or onFailed() on a timeout, or block in connect().
+   */
+  class InfiniWiFiFast {
+    public:
+    InfiniWiFiFast(WiFiFastState &state);
+
+    /*! Takes the last lease as a static IP on fast connects. Only for networks whose DHCP server keeps
+     * a device's address, otherwise two devices might end up with the same one.
+     */
+    void setReuseLease(bool reuse);
+
+    //! Whether state holds an AP for ssid.
+    bool hasCache(const char *ssid) const;
+
+    //! Starts connecting to ssid, fast if hasCache(), with a full scan and DHCP otherwise. Never blocks.
+    void begin(const char *ssid, const char *password);
+    //! Whether the last begin() was a fast one.
+    bool isFast() const;
+
+    //! Keeps the AP and lease now connected to. Returns true if they changed, e.g. to store them in NVS.
+    bool onConnected();
+    //! The attempt failed. If it was a fast one the cache is dropped, so begin() scans next.
+    void onFailed();
+
+    /*! Blocks until connected, first fast for up to WIFI_FAST_TIMEOUT_MS, then with a scan, timeoutMs in all.
+     * Returns false if it did not connect.
+     */
+    bool connect(const char *ssid, const char *password, unsigned long timeoutMs);
+
+    private:
+    bool waitConnected(unsigned long start, unsigned long timeoutMs);
+
+    WiFiFastState &m_state;
+    bool m_reuseLease;
+    bool m_fast;
+    uint32_t m_ssidHash;
+  };
+
+  //! Stores state in the NVS namespace ns, for a reboot rather than a deep sleep. Returns false on failure.
+  bool saveWiFiFast(const WiFiFastState &state, const char *ns = "infi_wifi");
+  //! Loads what saveWiFiFast() stored into state. Returns false, with state zeroed, if there is none.
+  bool loadWiFiFast(WiFiFastState &state, const char *ns = "infi_wifi");
+#endif
+}
+
+#endif
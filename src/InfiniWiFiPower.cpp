@@ -0,0 +1,104 @@
+#include "InfiniWiFiPower.h"
+
+#if INFI_MODULE_SINKS
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_wifi.h>
+
+namespace INFI {
+
+  InfiniWiFiPower::InfiniWiFiPower(unsigned long keepAliveMs, unsigned long sessionMs, unsigned long pollMs) :
+    m_keepAliveMs(keepAliveMs),
+    m_sessionMs(sessionMs),
+    m_pollMs(pollMs),
+    m_windowMs(0),
+    m_rpcMs(0),
+    m_polledMs(0),
+    m_hasSession(false),
+    m_awake(true),
+    m_windows(0),
+    m_sessions(0)
+  {}
+
+  void InfiniWiFiPower::begin(unsigned long nowMs) {
+    openWindow(nowMs);
+    apply(true, true);
+  }
+
+  void InfiniWiFiPower::openWindow(unsigned long nowMs) {
+    m_windowMs = nowMs;
+    // The first poll of a window goes at once.
+    m_polledMs = nowMs - m_pollMs;
+    m_windows++;
+    apply(true, false);
+  }
+
+  void InfiniWiFiPower::onRpc(unsigned long nowMs) {
+    if (!inSession(nowMs)) {
+      m_sessions++;
+    }
+    m_rpcMs = nowMs;
+    m_hasSession = true;
+    apply(true, false);
+  }
+
+  bool InfiniWiFiPower::inWindow(unsigned long nowMs) const {
+    return nowMs - m_windowMs < WIFI_POWER_WINDOW_MS;
+  }
+
+  bool InfiniWiFiPower::inSession(unsigned long nowMs) const {
+    return m_hasSession && nowMs - m_rpcMs < m_sessionMs;
+  }
+
+  bool InfiniWiFiPower::shouldPoll(unsigned long nowMs) {
+    if (nowMs - m_windowMs >= m_keepAliveMs + WIFI_POWER_PING_SLACK_MS) {
+      // Nothing was flushed for a keepalive, the ping gets a window of its own.
+      openWindow(nowMs);
+    }
+    const bool session = inSession(nowMs);
+    if (!session) {
+      m_hasSession = false;
+    }
+    apply(session || inWindow(nowMs), false);
+    if (!m_awake || nowMs - m_polledMs < m_pollMs) {
+      return false;
+    }
+    m_polledMs = nowMs;
+    return true;
+  }
+
+  unsigned long InfiniWiFiPower::msUntilPoll(unsigned long nowMs) const {
+    const unsigned long keepAliveWait = msUntilElapsed(m_windowMs, m_keepAliveMs + WIFI_POWER_PING_SLACK_MS, nowMs);
+    if (!m_awake) {
+      return keepAliveWait;
+    }
+    if (!inWindow(nowMs) && !inSession(nowMs)) {
+      // Over, shouldPoll() puts the radio back to sleep.
+      return 0;
+    }
+    const unsigned long pollWait = msUntilElapsed(m_polledMs, m_pollMs, nowMs);
+    return pollWait < keepAliveWait ? pollWait : keepAliveWait;
+  }
+
+  bool InfiniWiFiPower::isAwake() const {
+    return m_awake;
+  }
+
+  unsigned long InfiniWiFiPower::windows() const {
+    return m_windows;
+  }
+
+  unsigned long InfiniWiFiPower::sessions() const {
+    return m_sessions;
+  }
+
+  void InfiniWiFiPower::apply(bool awake, bool force) {
+    if (awake == m_awake && !force) {
+      return;
+    }
+    m_awake = awake;
+    esp_wifi_set_ps(awake ? WIFI_PS_NONE : WIFI_PS_MAX_MODEM);
+  }
+}
+#endif
+#endif
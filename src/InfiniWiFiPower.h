@@ -0,0 +1,78 @@
+#ifndef INFINI_WIFI_POWER_H
+#define INFINI_WIFI_POWER_H
+
+#include "InfiniCommon.h"
+
+// How long the radio stays at full power after a flush opened a window, for the broker's answers, milliseconds.
+#ifndef INFI_WIFI_POWER_WINDOW_MS
+#define INFI_WIFI_POWER_WINDOW_MS 500
+#endif
+
+// How long past the MQTT keepalive a window opens on its own, so the client's ping is due by then, milliseconds.
+#ifndef INFI_WIFI_POWER_PING_SLACK_MS
+#define INFI_WIFI_POWER_PING_SLACK_MS 250
+#endif
+
+namespace INFI {
+
+  const unsigned long WIFI_POWER_WINDOW_MS = INFI_WIFI_POWER_WINDOW_MS;
+  const unsigned long WIFI_POWER_PING_SLACK_MS = INFI_WIFI_POWER_PING_SLACK_MS;
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /*!
+   * Keeps WiFi in WIFI_PS_MAX_MODEM between the flushes, where the radio only wakes every listen interval
+   * for the AP's beacons, and at WIFI_PS_NONE in the windows around them.
+   * The sketch opens a window with openWindow() before it publishes, and only runs the MQTT client's loop()
+   * while shouldPoll() says so. That is in every window, and a window opens by itself keepAliveMs and a slack
+   * after the last one, when the client's keepalive ping is due at the latest. So the pings go out in the
+   * windows, most of them alongside a flush, and never wake the radio on their own.
+   * While awake the client is polled every pollMs. An RPC starts a session with onRpc(): for sessionMs the radio
+   * stays up and the polls go on, so the follow-up calls of an operator are answered within pollMs.
+   * The first RPC after a quiet spell waits for the next window, keepAliveMs and a slack at most.
+   * Call begin() once the station is connected, the Arduino core puts its own mode back on every connect.
+   */
+  class InfiniWiFiPower {
+    public:
+    //! keepAliveMs is the MQTT client's, 15 s for PubSubClient unless set otherwise.
+    InfiniWiFiPower(unsigned long keepAliveMs, unsigned long sessionMs, unsigned long pollMs);
+
+    //! Puts the radio in the mode for the state at nowMs and opens a window, for the subscribes of the connect.
+    void begin(unsigned long nowMs);
+
+    //! A flush is about to go out, the radio is up for WIFI_POWER_WINDOW_MS from now.
+    void openWindow(unsigned long nowMs);
+    //! An RPC came in, the session runs for sessionMs from now.
+    void onRpc(unsigned long nowMs);
+
+    //! Whether to run the client's loop() now. Opens the keepalive window when due and sets the radio's mode.
+    bool shouldPoll(unsigned long nowMs);
+    //! How long until shouldPoll() turns true, e.g. for idleFor().
+    unsigned long msUntilPoll(unsigned long nowMs) const;
+
+    //! Whether the radio is at full power, in a window or a session.
+    bool isAwake() const;
+    //! Windows opened, by a flush or for the keepalive, and RPC sessions started, e.g. to tell the savings.
+    unsigned long windows() const;
+    unsigned long sessions() const;
+
+    private:
+    bool inWindow(unsigned long nowMs) const;
+    bool inSession(unsigned long nowMs) const;
+    //! Sets the modem sleep mode if awake changed, or always with force.
+    void apply(bool awake, bool force);
+
+    unsigned long m_keepAliveMs;
+    unsigned long m_sessionMs;
+    unsigned long m_pollMs;
+    unsigned long m_windowMs;
+    unsigned long m_rpcMs;
+    unsigned long m_polledMs;
+    bool m_hasSession;
+    bool m_awake;
+    unsigned long m_windows;
+    unsigned long m_sessions;
+  };
+#endif
+}
+
+#endif
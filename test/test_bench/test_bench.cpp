@@ -0,0 +1,167 @@
+/*
+ * Host micro-benchmarks for the protocol code, run with
+ *   pio test -e native -f test_bench -v
+ * Every benchmark first checks its input round trips, then prints ns per frame.
+ * Only compare numbers from the same machine and build flags.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include "InfiniCRC.h"
+#include "InfiniCommandMaker.h"
+#include "InfiniResponseParser.h"
+#include "InfiniJsonWriter.h"
+
+using namespace INFI;
+
+static const unsigned long ITERATIONS = 200000;
+
+// Results go here so the optimizer cannot drop the work being timed.
+static volatile unsigned long sink = 0;
+
+// Discards whatever is written, for timing the writers without a buffer.
+class NullPrint : public Print {
+  public:
+  size_t write(uint8_t) override { return 1; }
+};
+
+// A ^Dxxx reply around payload with a valid CRC, as the inverter would send it.
+struct Frame {
+  char data[MAX_RESPONSE_SZ];
+  size_t len;
+
+  explicit Frame(const char *payload) {
+    int n = snprintf(data, sizeof(data), "^D%03d%s", (int)strlen(payload) + CRC_SZ + END_TOKEN_SZ, payload);
+    WORD crc = calc_crc_half((const BYTE *)data, (BYTE)n);
+    data[n++] = (char)(crc >> 8);
+    data[n++] = (char)(crc & 0xFF);
+    data[n++] = '\r';
+    data[n] = '\0';
+    len = (size_t)n;
+  }
+};
+
+static const Frame T_FRAME("20240315123456");
+static const Frame ED_FRAME("00012345");
+static const Frame GS_FRAME("2300,500,2301,500,0450,0400,009,524,000,000,000,012,100,035,030,000,0850,0000,3400,0000,0,2,0,1,1,2,1,0");
+static const Frame PIRI_FRAME("2300,500,0200,230,500,0217,5000,500,480,460,540,420,564,1,30,060,0,0,2,9,0,1,0,1,2");
+static const Frame FWS_FRAME("00,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,1");
+static const Frame FLAG_FRAME("1,0,1,0,1,1,1,0,0");
+static const Frame DI_FRAME("2300,500,0,440,540,564,460,540,060,30,0,0,2,0,0,0,1,0,1,0,1,1,1,0");
+static const Frame MCHGCR_FRAME("010,020,030,040,050,060,070,080,090,100,110,120,130,140");
+static const Frame MUCHGCR_FRAME("002,010,020,030,040,050,060");
+
+static InfiniResponseParser parser;
+
+//! Runs op ITERATIONS times and prints the mean in ns.
+template<typename Op>
+static void bench(const char *name, Op op) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (unsigned long i = 0; i < ITERATIONS; ++i) {
+    op();
+  }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+  char msg[80];
+  snprintf(msg, sizeof(msg), "%-28s %9.1f ns/frame", name, ns);
+  TEST_MESSAGE(msg);
+}
+
+static void test_crc() {
+  TEST_ASSERT_TRUE(crc_self_test());
+  const BYTE *frame = (const BYTE *)GS_FRAME.data;
+  const BYTE len = (BYTE)(GS_FRAME.len - CRC_SZ - END_TOKEN_SZ);
+  InfiniCrcAccumulator acc;
+  acc.update(frame, len);
+  TEST_ASSERT_EQUAL_HEX16(calc_crc_half(frame, len), acc.finalize());
+
+  bench("calc_crc_half GS", [&]() { sink += calc_crc_half(frame, len); });
+  bench("InfiniCrcAccumulator GS", [&]() {
+    InfiniCrcAccumulator a;
+    a.update(frame, len);
+    sink += a.finalize();
+  });
+}
+
+static void test_command_building() {
+  InfiniCommandMaker maker;
+  NullPrint null;
+  TEST_ASSERT_EQUAL(10, maker.writeCommand(GENERAL_STATUS, NULL, null));
+
+  bench("makeCommand GS", [&]() {
+    maker.command.reset();
+    maker.makeCommand(GENERAL_STATUS, NULL);
+    sink += maker.command.actualLen;
+  });
+  bench("makeCommand ED", [&]() {
+    maker.command.reset();
+    maker.makeCommand(GEN_ENERGY_DAY, "20240315");
+    sink += maker.command.actualLen;
+  });
+  bench("writeCommand GS", [&]() { sink += maker.writeCommand(GENERAL_STATUS, NULL, null); });
+  bench("writeCommand MCHGC", [&]() { sink += maker.writeCommand(SET_MAX_CHARGING_CURRENT, "0,060", null); });
+}
+
+static void test_time_and_energy_parsers() {
+  TEST_ASSERT_NOT_EQUAL(0, parser.fromILCurrentTimetoUnixTime(T_FRAME.data, T_FRAME.len));
+  TEST_ASSERT_EQUAL(12345, parser.fromInfiniGenEnergyToULong(ED_FRAME.data, ED_FRAME.len));
+
+  bench("T to unix time", [&]() { sink += parser.fromILCurrentTimetoUnixTime(T_FRAME.data, T_FRAME.len); });
+  bench("T to day", [&]() { sink += parser.fromILCurrentTimeToILCurrentDay(T_FRAME.data, T_FRAME.len); });
+  bench("ED to ulong", [&]() { sink += parser.fromInfiniGenEnergyToULong(ED_FRAME.data, ED_FRAME.len); });
+}
+
+static void test_gs_parsers() {
+  TEST_ASSERT_TRUE(parser.fromILGSToGeneralStatusFixed(GS_FRAME.data, GS_FRAME.len));
+  TEST_ASSERT_NOT_EQUAL((size_t)-1, parser.fromILGSToGeneralStatus(GS_FRAME.data, GS_FRAME.len));
+
+  bench("GS to GeneralStatusFixed", [&]() { sink += parser.fromILGSToGeneralStatusFixed(GS_FRAME.data, GS_FRAME.len); });
+  bench("GS to JSON", [&]() { sink += parser.fromILGSToGeneralStatus(GS_FRAME.data, GS_FRAME.len); });
+}
+
+static void test_typed_parsers() {
+  RatedInformation piri;
+  FaultWarningStatus fws;
+  EnableDisableStatus flag;
+  DefaultValues di;
+  ChargingCurrents currents;
+  TEST_ASSERT_TRUE(parser.fromPIRIToRatedInformation(PIRI_FRAME.data, PIRI_FRAME.len, piri));
+  TEST_ASSERT_TRUE(parser.fromFWSToFaultWarningStatus(FWS_FRAME.data, FWS_FRAME.len, fws));
+  TEST_ASSERT_TRUE(parser.fromFLAGToEnableDisableStatus(FLAG_FRAME.data, FLAG_FRAME.len, flag));
+  TEST_ASSERT_TRUE(parser.fromDIToDefaultValues(DI_FRAME.data, DI_FRAME.len, di));
+  TEST_ASSERT_TRUE(parser.fromChargingCurrentsResponse(QUERY_MAX_CHARGING_CURRENT, MCHGCR_FRAME.data, MCHGCR_FRAME.len, currents));
+  TEST_ASSERT_TRUE(parser.fromChargingCurrentsResponse(QUERY_MAX_AC_CHARGING_CURRENT, MUCHGCR_FRAME.data, MUCHGCR_FRAME.len, currents));
+
+  bench("PIRI", [&]() { sink += parser.fromPIRIToRatedInformation(PIRI_FRAME.data, PIRI_FRAME.len, piri); });
+  bench("FWS", [&]() { sink += parser.fromFWSToFaultWarningStatus(FWS_FRAME.data, FWS_FRAME.len, fws); });
+  bench("FLAG", [&]() { sink += parser.fromFLAGToEnableDisableStatus(FLAG_FRAME.data, FLAG_FRAME.len, flag); });
+  bench("DI", [&]() { sink += parser.fromDIToDefaultValues(DI_FRAME.data, DI_FRAME.len, di); });
+  bench("MCHGCR", [&]() {
+    sink += parser.fromChargingCurrentsResponse(QUERY_MAX_CHARGING_CURRENT, MCHGCR_FRAME.data, MCHGCR_FRAME.len, currents);
+  });
+  bench("MUCHGCR", [&]() {
+    sink += parser.fromChargingCurrentsResponse(QUERY_MAX_AC_CHARGING_CURRENT, MUCHGCR_FRAME.data, MUCHGCR_FRAME.len, currents);
+  });
+}
+
+static void test_json_writers() {
+  TEST_ASSERT_TRUE(parser.fromILGSToGeneralStatusFixed(GS_FRAME.data, GS_FRAME.len));
+  GeneralStatusFixed gs = parser.generalStatusFixed;
+  NullPrint null;
+
+  bench("writeGeneralStatusJson", [&]() { sink += writeGeneralStatusJson(gs, null); });
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc);
+  RUN_TEST(test_command_building);
+  RUN_TEST(test_time_and_energy_parsers);
+  RUN_TEST(test_gs_parsers);
+  RUN_TEST(test_typed_parsers);
+  RUN_TEST(test_json_writers);
+  return UNITY_END();
+}
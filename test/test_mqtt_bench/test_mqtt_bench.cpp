@@ -0,0 +1,549 @@
+/*
+ * Host benchmark of the uplink against a real broker, the counterpart of examples/infinisolar_p18_mqtt_bench.
+ * Run with e.g.
+ *   INFI_BENCH_BROKER=localhost INFI_BENCH_RAW_TOPIC=infini/bench pio test -e native -f test_mqtt_bench -v
+ * Without INFI_BENCH_BROKER the test is ignored. INFI_BENCH_PORT is the port, 1883 by default,
+ * INFI_BENCH_TOKEN the user name, a ThingsBoard device's access token, and INFI_BENCH_QOS 1 makes every
+ * publish wait for its PUBACK, so the latency is the broker's round trip rather than the send() call.
+ * MessagePack and the compressed JSON go to INFI_BENCH_RAW_TOPIC and are skipped without it: ThingsBoard
+ * drops a session that publishes anything but JSON telemetry, so point it at a broker, or a topic of a
+ * ThingsBoard gateway or integration, that takes raw payloads.
+ *
+ * The samples come through the simulator, the sender and the parser beforehand, only encoding and
+ * publishing are timed. Each run sends SAMPLES samples through ThingsBoardSized, or the client for the
+ * raw topic, for every buffer size, encoding and batch size, and then a PINGREQ, so its PINGRESP means
+ * the broker took every publish before it. A line per run gives the samples/s to that point, the
+ * publish latency percentiles, the bytes on the wire per sample and the process's CPU time, per sample
+ * and as a share of the run. A batch is cut to what fits the buffer, the samples per publish say so.
+ */
+
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <chrono>
+#include <ArduinoJson.h>
+#include <ThingsBoard.h>
+#include "InfiniCommandSender.h"
+#include "InfiniSimulatedInverter.h"
+#include "InfiniResponseParser.h"
+#include "InfiniJsonWriter.h"
+#include "InfiniGsSkeleton.h"
+#include "InfiniDeltaTelemetry.h"
+#include "InfiniDeflate.h"
+
+using namespace INFI;
+
+static const unsigned long SAMPLES = 1200;
+// As in the ThingsBoard example, the header and topic of a publish.
+static const size_t MQTT_OVERHEAD_SZ = 32;
+static const size_t MAX_BUFFER_SZ = 16384;
+static const unsigned long long FIRST_TS_MS = 1700000000000ULL;
+static const unsigned long SAMPLE_PERIOD_MS = 5000;
+
+static const WORD BUFFER_SIZES[] = { 1024, 4096, 16384 };
+static const BYTE BATCH_SIZES[] = { 1, 4, 16, 64 };
+
+enum ENCODING {
+  ENCODING_JSON = 0,  // ThingsBoard's [{"ts":...,"values":{...}}] array of writeGeneralStatusJson() objects.
+  ENCODING_SKELETON,  // InfiniGsSkeleton by sendTelemetryPrintable(), one sample a publish and no timestamp.
+  ENCODING_MSGPACK,   // The same array as MessagePack, the fields in the units they are stored in.
+  ENCODING_DEFLATE,   // The JSON array through InfiniDeflatePrint, GZIP.
+  NUM_ENCODINGS
+};
+
+static const char *const ENCODING_NAMES[NUM_ENCODINGS] = { "json", "skeleton", "msgpack", "deflate" };
+
+//! Whether encoding goes to the raw topic rather than ThingsBoard's telemetry topic.
+static bool isRaw(ENCODING encoding) {
+  return encoding == ENCODING_MSGPACK || encoding == ENCODING_DEFLATE;
+}
+
+/*!
+ * A plain MQTT 3.1.1 client over a blocking POSIX socket, what Arduino_MQTT_Client is on the ESP32 without
+ * PubSubClient in the way. It only publishes, at QoS 0, or at QoS 1 and then waits for the PUBACK, and counts
+ * the bytes it sends. Nothing is subscribed, whatever the broker sends besides acknowledgements is dropped.
+ */
+class SocketClient : public IMQTT_Client {
+  public:
+  SocketClient() :
+    m_fd(-1),
+    m_host(NULL),
+    m_port(1883),
+    m_bufferSize(1024),
+    m_qos(0),
+    m_packetId(0),
+    m_wireBytes(0)
+  {}
+
+  ~SocketClient() {
+    disconnect();
+  }
+
+  void set_data_callback(Callback<void, char *, uint8_t *, unsigned int>::function) override {}
+  void set_connect_callback(Callback<void>::function) override {}
+
+  bool set_buffer_size(uint16_t size) override {
+    m_bufferSize = size;
+    return true;
+  }
+
+  uint16_t get_buffer_size() override { return m_bufferSize; }
+
+  void set_server(char const *host, uint16_t port) override {
+    m_host = host;
+    m_port = port;
+  }
+
+  bool connect(char const *clientId, char const *user, char const *password) override {
+    char port[8];
+    snprintf(port, sizeof(port), "%u", (unsigned int)m_port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *addrs = NULL;
+    if (m_host == NULL || getaddrinfo(m_host, port, &hints, &addrs) != 0) {
+      return false;
+    }
+    for (struct addrinfo *a = addrs; a != NULL && m_fd < 0; a = a->ai_next) {
+      m_fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (m_fd >= 0 && ::connect(m_fd, a->ai_addr, a->ai_addrlen) != 0) {
+        close(m_fd);
+        m_fd = -1;
+      }
+    }
+    freeaddrinfo(addrs);
+    if (m_fd < 0) {
+      return false;
+    }
+    // Each publish goes out as it is written, as lwIP sends it on the ESP32.
+    int one = 1;
+    setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct timeval timeout = { 5, 0 };
+    setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    const bool hasUser = user != NULL && *user != '\0';
+    const bool hasPassword = password != NULL && *password != '\0';
+    uint8_t packet[256];
+    size_t n = 0;
+    // Variable header: "MQTT", level 4, the flags and a keep alive of 60 s.
+    const uint8_t header[] = { 0, 4, 'M', 'Q', 'T', 'T', 4, 0, 0, 60 };
+    memcpy(packet + 2, header, sizeof(header));
+    n = 2 + sizeof(header);
+    packet[2 + 7] = 0x02 | (hasUser ? 0x80 : 0) | (hasPassword ? 0x40 : 0);
+    n = putString(packet, n, sizeof(packet), clientId);
+    if (hasUser) {
+      n = putString(packet, n, sizeof(packet), user);
+    }
+    if (hasPassword) {
+      n = putString(packet, n, sizeof(packet), password);
+    }
+    if (n == 0 || n - 2 >= 128) {
+      disconnect();
+      return false;
+    }
+    packet[0] = 0x10;
+    packet[1] = (uint8_t)(n - 2);
+    uint8_t connack[4];
+    if (!sendAll(packet, n) || !readPacket(0x20, connack, sizeof(connack)) || connack[1] != 0) {
+      disconnect();
+      return false;
+    }
+    return true;
+  }
+
+  void disconnect() override {
+    if (m_fd >= 0) {
+      const uint8_t packet[] = { 0xE0, 0 };
+      sendAll(packet, sizeof(packet));
+      close(m_fd);
+      m_fd = -1;
+    }
+  }
+
+  bool loop() override { return connected(); }
+  bool subscribe(char const *) override { return false; }
+  bool unsubscribe(char const *) override { return false; }
+  bool connected() override { return m_fd >= 0; }
+
+  bool publish(char const *topic, uint8_t const *payload, size_t const &length) override {
+    return begin_publish(topic, length) && write(payload, length) == length && end_publish();
+  }
+
+  bool begin_publish(char const *topic, size_t const &length) override {
+    const size_t topicLen = strlen(topic);
+    size_t remaining = 2 + topicLen + length + (m_qos > 0 ? 2 : 0);
+    uint8_t header[8 + 2];
+    size_t n = 0;
+    header[n++] = 0x30 | (m_qos << 1);
+    do {
+      uint8_t b = remaining & 0x7F;
+      remaining >>= 7;
+      header[n++] = b | (remaining > 0 ? 0x80 : 0);
+    } while (remaining > 0);
+    header[n++] = (uint8_t)(topicLen >> 8);
+    header[n++] = (uint8_t)topicLen;
+    if (!sendAll(header, n) || !sendAll((const uint8_t *)topic, topicLen)) {
+      return false;
+    }
+    if (m_qos > 0) {
+      m_packetId = m_packetId == 0xFFFF ? 1 : m_packetId + 1;
+      const uint8_t id[] = { (uint8_t)(m_packetId >> 8), (uint8_t)m_packetId };
+      return sendAll(id, sizeof(id));
+    }
+    return true;
+  }
+
+  size_t write(uint8_t const *buffer, size_t const &size) override {
+    return sendAll(buffer, size) ? size : 0;
+  }
+
+  bool end_publish() override {
+    if (m_qos == 0) {
+      return connected();
+    }
+    uint8_t puback[2];
+    return readPacket(0x40, puback, sizeof(puback)) &&
+           ((puback[0] << 8) | puback[1]) == m_packetId;
+  }
+
+  //! Sends a PINGREQ and waits for its PINGRESP, which the broker sends once it took everything before it.
+  bool ping() {
+    const uint8_t packet[] = { 0xC0, 0 };
+    uint8_t none[1];
+    return sendAll(packet, sizeof(packet)) && readPacket(0xD0, none, 0);
+  }
+
+  void setQos(uint8_t qos) { m_qos = qos > 0 ? 1 : 0; }
+  void resetCount() { m_wireBytes = 0; }
+  unsigned long long wireBytes() const { return m_wireBytes; }
+
+  private:
+  //! Appends str with its length at n. Returns the new length, 0 if it did not fit.
+  static size_t putString(uint8_t *packet, size_t n, size_t size, const char *str) {
+    const size_t len = str != NULL ? strlen(str) : 0;
+    if (n == 0 || n + 2 + len > size) {
+      return 0;
+    }
+    packet[n++] = (uint8_t)(len >> 8);
+    packet[n++] = (uint8_t)len;
+    memcpy(packet + n, str, len);
+    return n + len;
+  }
+
+  bool sendAll(const uint8_t *data, size_t len) {
+    while (len > 0 && m_fd >= 0) {
+      ssize_t sent = send(m_fd, data, len, MSG_NOSIGNAL);
+      if (sent <= 0) {
+        close(m_fd);
+        m_fd = -1;
+        return false;
+      }
+      m_wireBytes += sent;
+      data += sent;
+      len -= sent;
+    }
+    return m_fd >= 0;
+  }
+
+  bool readAll(uint8_t *data, size_t len) {
+    while (len > 0) {
+      ssize_t got = recv(m_fd, data, len, 0);
+      if (got <= 0) {
+        close(m_fd);
+        m_fd = -1;
+        return false;
+      }
+      data += got;
+      len -= got;
+    }
+    return true;
+  }
+
+  //! Reads packets until one of type, whose first size bytes go to body. Other packets are dropped.
+  bool readPacket(uint8_t type, uint8_t *body, size_t size) {
+    while (m_fd >= 0) {
+      uint8_t first;
+      if (!readAll(&first, 1)) {
+        return false;
+      }
+      size_t remaining = 0;
+      uint8_t b = 0x80;
+      for (BYTE shift = 0; (b & 0x80) && shift < 28; shift += 7) {
+        if (!readAll(&b, 1)) {
+          return false;
+        }
+        remaining |= (size_t)(b & 0x7F) << shift;
+      }
+      const bool wanted = (first & 0xF0) == type;
+      uint8_t skip[64];
+      while (remaining > 0) {
+        size_t n = std::min(remaining, sizeof(skip));
+        if (!readAll(skip, n)) {
+          return false;
+        }
+        if (wanted) {
+          const size_t kept = std::min(n, size);
+          memcpy(body, skip, kept);
+          body += kept;
+          size -= kept;
+        }
+        remaining -= n;
+      }
+      if (wanted) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  int m_fd;
+  const char *m_host;
+  uint16_t m_port;
+  uint16_t m_bufferSize;
+  uint8_t m_qos;
+  uint16_t m_packetId;
+  unsigned long long m_wireBytes;
+};
+
+static SocketClient client;
+static ThingsBoardSized<> tb(client, MAX_BUFFER_SZ);
+static const char *rawTopic = NULL;
+
+static InfiniSimulatedInverter inverter(0, 0);
+static InfiniCommandSenderT<InfiniSimulatedInverter> sender(inverter);
+static InfiniResponseParser parser;
+static GeneralStatusFixed samples[SAMPLES];
+
+// The GS reply of every sample, PV and load wander and the grid jitters, as in the uplink benchmark.
+static const char GS_FORMAT[] =
+  "%04u,500,2301,500,%04u,%04u,%03u,524,000,000,000,%03u,%03u,035,030,000,%04u,0000,3400,0000,0,2,0,1,1,2,1,0";
+
+static void makeSamples() {
+  char payload[sizeof(GS_FORMAT)];
+  for (unsigned long i = 0; i < SAMPLES; ++i) {
+    unsigned int load = 400 + (unsigned int)(i * 7) % 90;
+    snprintf(payload, sizeof(payload), GS_FORMAT, 2295 + (unsigned int)(i * 13) % 11, load + 50, load, load / 12,
+             (unsigned int)(i / 50) % 10, 30 + (unsigned int)(i / 200) % 70, 850 + (unsigned int)(i * 3) % 200);
+    TEST_ASSERT_TRUE(inverter.setPayload(GENERAL_STATUS, payload));
+    sender.sendCommand(GENERAL_STATUS, NULL);
+    TEST_ASSERT_TRUE(parser.fromILGSToGeneralStatusFixed(sender.response.val, sender.response.actualLen));
+    samples[i] = parser.generalStatusFixed;
+  }
+}
+
+static unsigned long long sampleTs(unsigned long i) {
+  return FIRST_TS_MS + (unsigned long long)i * SAMPLE_PERIOD_MS;
+}
+
+//! Writes count samples from first on as ThingsBoard's timestamped telemetry array.
+static void writeTelemetryArray(unsigned long first, BYTE count, Print &out) {
+  char ts[32];
+  out.print('[');
+  for (BYTE i = 0; i < count; ++i) {
+    snprintf(ts, sizeof(ts), "%s{\"ts\":%llu,\"values\":", i > 0 ? "," : "", sampleTs(first + i));
+    out.print(ts);
+    writeGeneralStatusJson(samples[first + i], out);
+    out.print('}');
+  }
+  out.print(']');
+}
+
+static size_t encodeMsgPack(unsigned long first, BYTE count, BYTE *out, size_t room) {
+  JsonDocument doc;
+  JsonArray array = doc.to<JsonArray>();
+  for (BYTE i = 0; i < count; ++i) {
+    JsonObject sample = array.add<JsonObject>();
+    sample["ts"] = sampleTs(first + i);
+    JsonObject values = sample["values"].to<JsonObject>();
+    for (BYTE f = 0; f < NUM_GS_FIELDS; ++f) {
+      values[getGeneralStatusFieldKey((GS_FIELD)f)] = getGeneralStatusField(samples[first + i], (GS_FIELD)f);
+    }
+  }
+  if (measureMsgPack(doc) > room) {
+    return 0;
+  }
+  return serializeMsgPack(doc, out, room);
+}
+
+static char payload[MAX_BUFFER_SZ];
+// The JSON text deflate compresses, which may take more than the buffer it compresses into.
+static char deflateText[4 * MAX_BUFFER_SZ];
+
+/*!
+ * Encodes count samples from first on into payload, with room bytes for it.
+ * Returns its length, 0 if it does not fit. JSON is null terminated.
+ */
+static size_t encode(ENCODING encoding, unsigned long first, BYTE count, size_t room) {
+  switch (encoding) {
+    case ENCODING_JSON: {
+      // InfiniBufferPrint keeps a byte for the terminator.
+      InfiniBufferPrint out(payload, room + 1);
+      InfiniCountingPrint counter;
+      writeTelemetryArray(first, count, counter);
+      if (counter.count() > room) {
+        return 0;
+      }
+      writeTelemetryArray(first, count, out);
+      return out.length();
+    }
+    case ENCODING_MSGPACK:
+      return encodeMsgPack(first, count, (BYTE *)payload, room);
+    case ENCODING_DEFLATE: {
+      InfiniBufferPrint text(deflateText, sizeof(deflateText));
+      writeTelemetryArray(first, count, text);
+      if (text.length() + 1 >= sizeof(deflateText)) {
+        return 0;
+      }
+      InfiniBufferPrint out(payload, room + 1);
+      InfiniDeflatePrint deflate(out, DEFLATE_GZIP);
+      deflate.write((const uint8_t *)deflateText, text.length());
+      return deflate.finish() ? out.length() : 0;
+    }
+    default:
+      return 0;
+  }
+}
+
+//! The most samples up to batch that fit a payload of room bytes, taken from the first ones. 0 if none does.
+static BYTE fitBatch(ENCODING encoding, BYTE batch, size_t room) {
+  while (batch > 0 && encode(encoding, 0, batch, room) == 0) {
+    --batch;
+  }
+  return batch;
+}
+
+static double cpuSeconds() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static double latencyUs[SAMPLES];
+
+static double percentile(double *sorted, unsigned long n, unsigned int pct) {
+  return sorted[(n - 1) * pct / 100];
+}
+
+static void run(WORD bufferSize, ENCODING encoding, BYTE batch) {
+  static InfiniGsSkeleton skeleton;
+  const size_t room = bufferSize - MQTT_OVERHEAD_SZ;
+  const BYTE perPublish = encoding == ENCODING_SKELETON ? 1 : fitBatch(encoding, batch, room);
+  char msg[200];
+  if (perPublish == 0) {
+    snprintf(msg, sizeof(msg), "%5u %-8s %2u  no sample fits", bufferSize, ENCODING_NAMES[encoding], batch);
+    TEST_MESSAGE(msg);
+    return;
+  }
+  TEST_ASSERT_TRUE(tb.setBufferSize(bufferSize));
+  client.resetCount();
+  unsigned long publishes = 0;
+  unsigned long failed = 0;
+  BYTE count = 0;
+  const double cpuStart = cpuSeconds();
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for (unsigned long first = 0; first < SAMPLES; first += count) {
+    count = (BYTE)std::min<unsigned long>(perPublish, SAMPLES - first);
+    bool sent = false;
+    std::chrono::steady_clock::time_point publishStart;
+    if (encoding == ENCODING_SKELETON) {
+      skeleton.fill(samples[first]);
+      publishStart = std::chrono::steady_clock::now();
+      sent = tb.sendTelemetryPrintable(skeleton, skeleton.length());
+    } else {
+      size_t len = encode(encoding, first, count, room);
+      // The compressed size varies, samples that do not fit after all go with the next publish.
+      while (len == 0 && count > 1) {
+        len = encode(encoding, first, --count, room);
+      }
+      publishStart = std::chrono::steady_clock::now();
+      if (len == 0) {
+        sent = false;
+      } else if (isRaw(encoding)) {
+        sent = client.publish(rawTopic, (const uint8_t *)payload, len);
+      } else {
+        sent = tb.sendTelemtryString(payload);
+      }
+    }
+    latencyUs[publishes++] =
+      std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - publishStart).count();
+    if (!sent) {
+      ++failed;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(client.connected(), "the broker closed the session");
+  }
+  TEST_ASSERT_TRUE_MESSAGE(client.ping(), "no PINGRESP");
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const double cpu = cpuSeconds() - cpuStart;
+
+  std::sort(latencyUs, latencyUs + publishes);
+  snprintf(msg, sizeof(msg),
+           "%5u %-8s %2u %2u/pub %9.0f samples/s  p50 %7.1f p90 %7.1f p99 %7.1f us  %6.1f B/sample  "
+           "cpu %5.1f us/sample %3.0f %%  %lu failed",
+           bufferSize, ENCODING_NAMES[encoding], batch, perPublish, SAMPLES / seconds,
+           percentile(latencyUs, publishes, 50), percentile(latencyUs, publishes, 90),
+           percentile(latencyUs, publishes, 99), (double)client.wireBytes() / SAMPLES, cpu * 1e6 / SAMPLES,
+           100.0 * cpu / seconds, failed);
+  TEST_MESSAGE(msg);
+}
+
+static void test_sweep() {
+  const char *broker = getenv("INFI_BENCH_BROKER");
+  if (broker == NULL || *broker == '\0') {
+    TEST_IGNORE_MESSAGE("set INFI_BENCH_BROKER to the broker's host to run");
+  }
+  const char *port = getenv("INFI_BENCH_PORT");
+  const char *token = getenv("INFI_BENCH_TOKEN");
+  const char *qos = getenv("INFI_BENCH_QOS");
+  rawTopic = getenv("INFI_BENCH_RAW_TOPIC");
+  if (rawTopic != NULL && *rawTopic == '\0') {
+    rawTopic = NULL;
+  }
+  client.setQos(qos != NULL ? (uint8_t)atoi(qos) : 0);
+  makeSamples();
+  TEST_ASSERT_TRUE_MESSAGE(tb.connect(broker, token != NULL ? token : "", port != NULL ? atoi(port) : 1883),
+                           "could not connect to the broker");
+  // A sample's bytes per encoding, to tell the buffer sizes apart from the encodings.
+  char msg[160];
+  InfiniCountingPrint json;
+  writeGeneralStatusJson(samples[0], json);
+  snprintf(msg, sizeof(msg), "one sample: json %u B, skeleton %u B, msgpack %u B", (unsigned int)json.count(),
+           (unsigned int)GS_SKELETON_SZ, (unsigned int)encodeMsgPack(0, 1, (BYTE *)payload, sizeof(payload)));
+  TEST_MESSAGE(msg);
+  TEST_MESSAGE("buffer encoding batch");
+
+  for (size_t b = 0; b < sizeof(BUFFER_SIZES) / sizeof(BUFFER_SIZES[0]); ++b) {
+    for (BYTE e = 0; e < NUM_ENCODINGS; ++e) {
+      const ENCODING encoding = (ENCODING)e;
+      if (isRaw(encoding) && rawTopic == NULL) {
+        continue;
+      }
+      for (size_t n = 0; n < sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]); ++n) {
+        // The skeleton is one sample a publish, its batch is always 1.
+        if (encoding == ENCODING_SKELETON && n > 0) {
+          break;
+        }
+        run(BUFFER_SIZES[b], encoding, BATCH_SIZES[n]);
+      }
+    }
+  }
+  tb.disconnect();
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sweep);
+  return UNITY_END();
+}
@@ -0,0 +1,539 @@
+/*
+ * Property tests for the response parsers and the CRC, run with
+ *   pio test -e native -f test_parser_fuzz -v
+ * Random valid replies must decode to the values they were made from, and the hand written parsers
+ * must agree with sscanf reference decoders on randomly mutated replies: whatever the field reader
+ * accepts, the reference accepts with the same values, and the other way round.
+ * The mutations keep the CRC valid most of the time, so they get past it into the field decoding.
+ *
+ * The same checks run under libFuzzer, with ASan watching the fixed offset reads:
+ *   clang++ -std=gnu++11 -g -O1 -fsanitize=fuzzer,address -DINFI_LIBFUZZER -Itest/native_shim -Isrc \
+ *     test/test_parser_fuzz/test_parser_fuzz.cpp src/InfiniCRC.cpp src/InfiniCommon.cpp src/InfiniDataTypes.cpp \
+ *     src/InfiniFieldReader.cpp src/InfiniJsonWriter.cpp src/InfiniResponseParser.cpp -o parser_fuzz && ./parser_fuzz
+ * The first input byte picks the reply type, bit 7 of it whether the CRC is fixed up, the rest is the reply.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "InfiniCRC.h"
+#include "InfiniResponseParser.h"
+#include "InfiniJsonWriter.h"
+
+#ifndef INFI_LIBFUZZER
+#include <unity.h>
+#endif
+
+using namespace INFI;
+
+static const unsigned long SEED = 20240315;
+static const unsigned long VALID_FRAMES = 2000;
+static const unsigned long MUTATED_FRAMES = 50000;
+
+#ifdef INFI_LIBFUZZER
+#define CHECK(cond) do { if (!(cond)) { fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); abort(); } } while (0)
+#else
+#define CHECK(cond) TEST_ASSERT_TRUE(cond)
+#endif
+
+// How a field lands in the decoded struct, so the reference values can be narrowed the same way.
+enum FIELD_KIND { F_WORD, F_BYTE, F_FLAG };
+
+struct FieldSpec {
+  BYTE width;
+  FIELD_KIND kind;
+};
+
+#define W4 { 4, F_WORD }
+#define W3 { 3, F_WORD }
+#define B3 { 3, F_BYTE }
+#define B2 { 2, F_BYTE }
+#define B1 { 1, F_BYTE }
+#define F1 { 1, F_FLAG }
+
+// Field layouts from the protocol manual, in the order the reply lists them.
+static const FieldSpec PIRI_FIELDS[] = {
+  W4, W3, W4, W4, W3, W4, W4, W4, W3, W3, W3, W3, W3, B1, B2, W3, B1, B1, B1, B1, B1, B1, B1, B1, B1
+};
+static const FieldSpec FWS_FIELDS[] = {
+  B2, F1, F1, F1, F1, F1, F1, F1, F1, F1, F1, F1, F1, F1, F1, F1, F1
+};
+static const FieldSpec FLAG_FIELDS[] = { F1, F1, F1, F1, F1, F1, F1, F1, F1 };
+static const FieldSpec DI_FIELDS[] = {
+  W4, W3, B1, W3, W3, W3, W3, W3, W3, B2, B1, B1, B1, B1, B1, B1, F1, F1, F1, F1, F1, F1, F1, F1
+};
+static const FieldSpec CURRENT_FIELDS[] = { W3, W3, W3, W3, W3, W3, W3, W3, W3, W3, W3, W3, W3, W3 };
+// Only the widths matter for GS, it is compared against the sscanf decoder of INFI_GS_SSCANF.
+static const FieldSpec GS_FIELDS[] = {
+  W4, W3, W4, W3, W4, W4, B3, W3, W3, W3, W3, W3, B3, B3, B3, B3, W4, W4, W4, W4, F1, B1, B1, F1, B1, B1, B1, B1
+};
+
+#define FIELDS(a) a, (BYTE)(sizeof(a) / sizeof(a[0]))
+
+struct ReplySpec {
+  COMMAND_TYPE cmdType;
+  const FieldSpec *fields;
+  //! 0 for MCHGCR and MUCHGCR, which list up to MAX_CHARGING_CURRENTS_SZ currents.
+  BYTE fieldCount;
+};
+
+static const ReplySpec REPLIES[] = {
+  { GENERAL_STATUS, FIELDS(GS_FIELDS) },
+  { QUERY_RATED_INFORMATION, FIELDS(PIRI_FIELDS) },
+  { FAULT_WARNING_STATUS, FIELDS(FWS_FIELDS) },
+  { QUERY_ENABLE_DISABLE_STATUS, FIELDS(FLAG_FIELDS) },
+  { QUERY_DEFAULT_VALUE, FIELDS(DI_FIELDS) },
+  { QUERY_MAX_CHARGING_CURRENT, CURRENT_FIELDS, 0 },
+  { QUERY_MAX_AC_CHARGING_CURRENT, CURRENT_FIELDS, 0 },
+  { GEN_ENERGY_DAY, NULL, 0 }
+};
+static const BYTE NUM_REPLIES = sizeof(REPLIES) / sizeof(REPLIES[0]);
+
+static BYTE payloadSize(COMMAND_TYPE cmdType) {
+  return getResponseSize(cmdType) - START_OFFSET_SZ - CRC_SZ - END_TOKEN_SZ;
+}
+
+//! The fields of the valid replies made by makeValidReply().
+static BYTE fieldCount(const ReplySpec &spec) {
+  // AAA,BBB,... every current takes 4 chars but the last.
+  return spec.fields == CURRENT_FIELDS ? (BYTE)((payloadSize(spec.cmdType) + 1) / 4) : spec.fieldCount;
+}
+
+// Deterministic, so a failure can be reproduced from SEED.
+static uint32_t rngState = SEED;
+
+static uint32_t nextRandom() {
+  rngState = rngState * 1664525UL + 1013904223UL;
+  return rngState >> 8;
+}
+
+static unsigned long randomBelow(unsigned long n) {
+  return nextRandom() % n;
+}
+
+// A reply buffer, NUL terminated like InfiniResponse::val so sscanf stops at its end.
+struct Reply {
+  char data[MAX_RESPONSE_SZ + 2];
+  size_t len;
+
+  void fixCrc() {
+    if (len < START_TOKEN_SZ + CRC_SZ + END_TOKEN_SZ) {
+      return;
+    }
+    size_t crcPos = len - CRC_SZ - END_TOKEN_SZ;
+    WORD crc = calc_crc_half((const BYTE *)data, (BYTE)crcPos);
+    data[crcPos] = (char)(crc >> 8);
+    data[crcPos + 1] = (char)(crc & 0xFF);
+  }
+
+  void frame(const char *payload, size_t payloadLen) {
+    int n = snprintf(data, sizeof(data), "^D%03d", (int)(payloadLen + CRC_SZ + END_TOKEN_SZ));
+    memcpy(data + n, payload, payloadLen);
+    len = n + payloadLen + CRC_SZ + END_TOKEN_SZ;
+    data[len - 1] = '\r';
+    data[len] = '\0';
+    fixCrc();
+  }
+};
+
+//! CRC-16/XMODEM one bit at a time, then the same escaping of '(', '\r' and '\n' as the protocol.
+static WORD referenceCrc(const BYTE *in, size_t len) {
+  WORD crc = 0;
+  for (size_t i = 0; i < len; ++i) {
+    crc ^= (WORD)in[i] << 8;
+    for (BYTE bit = 0; bit < 8; ++bit) {
+      crc = (crc & 0x8000) ? (WORD)((crc << 1) ^ 0x1021) : (WORD)(crc << 1);
+    }
+  }
+  BYTE high = crc >> 8;
+  BYTE low = crc & 0xFF;
+  if (high == 0x28 || high == 0x0d || high == 0x0a) high++;
+  if (low == 0x28 || low == 0x0d || low == 0x0a) low++;
+  return ((WORD)high << 8) | low;
+}
+
+//! The checks every query reply has to pass before its payload is looked at.
+static bool referenceFraming(COMMAND_TYPE cmdType, const Reply &reply) {
+  char header[START_OFFSET_SZ + 1];
+  snprintf(header, sizeof(header), "^D%03d", getCommandDescriptor(cmdType).respToEndSz);
+  if (reply.len != getResponseSize(cmdType) || memcmp(reply.data, header, START_OFFSET_SZ) != 0) {
+    return false;
+  }
+  size_t crcPos = reply.len - CRC_SZ - END_TOKEN_SZ;
+  WORD crc = ((WORD)(BYTE)reply.data[crcPos] << 8) | (BYTE)reply.data[crcPos + 1];
+  return crc == referenceCrc((const BYTE *)reply.data, crcPos);
+}
+
+/*! Decodes the payload field by field with sscanf. A field is an optional '-' and digits, at most its width
+ * chars, followed by a comma or the end of the payload. The values are narrowed like the parsers store them.
+ * Returns the number of fields, 0 if the payload is malformed.
+ */
+static BYTE referenceFields(const ReplySpec &spec, const Reply &reply, long *values) {
+  const char *p = reply.data + START_OFFSET_SZ;
+  const char *end = reply.data + reply.len - CRC_SZ - END_TOKEN_SZ;
+  bool variable = spec.fieldCount == 0;
+  BYTE count = variable ? MAX_CHARGING_CURRENTS_SZ : spec.fieldCount;
+  BYTE i = 0;
+  for (; i < count && !(variable && i > 0 && p == end); ++i) {
+    if (i > 0) {
+      if (p >= end || *p != ',') {
+        return 0;
+      }
+      p++;
+    }
+    char field[8] = {};
+    size_t avail = (size_t)(end - p);
+    size_t take = strspn(p, "-0123456789");
+    if (take > avail) {
+      take = avail;
+    }
+    if (take == 0 || take > spec.fields[i].width || take >= sizeof(field) || memchr(p + 1, '-', take - 1) != NULL) {
+      return 0;
+    }
+    memcpy(field, p, take);
+    long v;
+    int consumed = 0;
+    if (sscanf(field, "%ld%n", &v, &consumed) != 1 || (size_t)consumed != take) {
+      return 0;
+    }
+    p += take;
+    switch (spec.fields[i].kind) {
+      case F_WORD: values[i] = (WORD)v; break;
+      case F_BYTE: values[i] = (BYTE)v; break;
+      case F_FLAG: values[i] = (v == 1); break;
+    }
+  }
+  return p == end ? i : 0;
+}
+
+//! The INFI_GS_SSCANF decoder, kept here so both can be compared in one build.
+static bool referenceGs(const Reply &reply, GeneralStatusFixed &gs) {
+  unsigned short w[15];
+  unsigned short b[13];
+  int n = sscanf(reply.data, "%*5s%4hu,%3hu,%4hu,%3hu,%4hu,%4hu,%3hu,%3hu,%3hu,%3hu,%3hu,%3hu,%3hu,%3hu,%3hu,%3hu,%4hu,%4hu,%4hu,%4hu,%1hu,%1hu,%1hu,%1hu,%1hu,%1hu,%1hu,%1hu%*s",
+         &w[0], &w[1], &w[2], &w[3], &w[4], &w[5], &b[0], &w[6], &w[7], &w[8], &w[9], &w[10], &b[1],
+         &b[2], &b[3], &b[4], &w[11], &w[12], &w[13], &w[14],
+         &b[5], &b[6], &b[7], &b[8], &b[9], &b[10], &b[11], &b[12]);
+  gs.gridVoltDeci = w[0];
+  gs.gridFreqDeci = w[1];
+  gs.acOutVoltDeci = w[2];
+  gs.acOutFreqDeci = w[3];
+  gs.acOutApparentPow = w[4];
+  gs.acOutActivePow = w[5];
+  gs.outLoadPct = b[0];
+  gs.battVoltDeci = w[6];
+  gs.battVoltSCCDeci = w[7];
+  gs.battVoltSCC2Deci = w[8];
+  gs.battDischargeCurr = w[9];
+  gs.battChargeCurr = w[10];
+  gs.battCapacity = b[1];
+  gs.invHeatSinkTemp = b[2];
+  gs.mppt1ChrgrTemp = b[3];
+  gs.mppt2ChrgrTemp = b[4];
+  gs.pv1InPow = w[11];
+  gs.pv2InPow = w[12];
+  gs.pv1InVoltDeci = w[13];
+  gs.pv2InVoltDeci = w[14];
+  gs.settingsChanged = (b[5] == 1);
+  gs.mppt1ChrgrStatus = b[6];
+  gs.mppt2ChrgrStatus = b[7];
+  gs.loadConnection = (b[8] == 1);
+  gs.battPowDir = b[9];
+  gs.dcACPowDir = b[10];
+  gs.linePowDir = b[11];
+  gs.localParallelId = b[12];
+  return n == 28;
+}
+
+// The decoded structs in reply order, to compare with referenceFields().
+static BYTE valuesOf(const RatedInformation &o, long *v) {
+  const long f[] = { o.acInVoltDeci, o.acInFreqDeci, o.acInCurrDeci, o.acOutVoltDeci, o.acOutFreqDeci,
+    o.acOutCurrDeci, o.acOutApparentPow, o.acOutActivePow, o.battVoltDeci, o.battRechargeVoltDeci,
+    o.battRedischargeVoltDeci, o.battUnderVoltDeci, o.battBulkVoltDeci, o.battType, o.maxACChargingCurr,
+    o.maxChargingCurr, o.inVoltRange, o.outSourcePriority, o.chargerSourcePriority, o.parallelMaxNum,
+    o.machineType, o.topology, o.outModel, o.solarPowerPriority, o.mpptString };
+  memcpy(v, f, sizeof(f));
+  return sizeof(f) / sizeof(f[0]);
+}
+
+static BYTE valuesOf(const FaultWarningStatus &o, long *v) {
+  const long f[] = { o.faultCode, o.lineFail, o.outCircuitShort, o.invOverTemp, o.fanLocked, o.battVoltHigh,
+    o.battLow, o.battUnder, o.overLoad, o.eepromFail, o.powLimit, o.pv1VoltHigh, o.pv2VoltHigh,
+    o.mppt1Overload, o.mppt2Overload, o.battTooLowToChargeSCC1, o.battTooLowToChargeSCC2 };
+  memcpy(v, f, sizeof(f));
+  return sizeof(f) / sizeof(f[0]);
+}
+
+static BYTE valuesOf(const EnableDisableStatus &o, long *v) {
+  const long f[] = { o.buzzer, o.overloadBypass, o.lcdEscape, o.overloadRestart, o.overTempRestart,
+    o.backlight, o.primarySourceInterruptAlarm, o.faultCodeRecord, o.gridTie };
+  memcpy(v, f, sizeof(f));
+  return sizeof(f) / sizeof(f[0]);
+}
+
+static BYTE valuesOf(const DefaultValues &o, long *v) {
+  const long f[] = { o.acOutVoltDeci, o.acOutFreqDeci, o.acInVoltRange, o.battUnderVoltDeci,
+    o.battFloatVoltDeci, o.battBulkVoltDeci, o.battRechargeVoltDeci, o.battRedischargeVoltDeci,
+    o.maxChargingCurr, o.maxACChargingCurr, o.battType, o.outSourcePriority, o.chargerSourcePriority,
+    o.solarPowerPriority, o.machineType, o.outModel, o.flags.buzzer, o.flags.overloadBypass,
+    o.flags.lcdEscape, o.flags.overloadRestart, o.flags.overTempRestart, o.flags.backlight,
+    o.flags.primarySourceInterruptAlarm, o.flags.faultCodeRecord };
+  memcpy(v, f, sizeof(f));
+  return sizeof(f) / sizeof(f[0]);
+}
+
+static BYTE valuesOf(const ChargingCurrents &o, long *v) {
+  for (BYTE i = 0; i < o.count; ++i) {
+    v[i] = o.values[i];
+  }
+  return o.count;
+}
+
+static bool sameGs(const GeneralStatusFixed &a, const GeneralStatusFixed &b) {
+  // Compared through the JSON, the struct has padding.
+  char ja[PARSED_SZ];
+  char jb[PARSED_SZ];
+  InfiniBufferPrint pa(ja, sizeof(ja));
+  InfiniBufferPrint pb(jb, sizeof(jb));
+  writeGeneralStatusJson(a, pa);
+  writeGeneralStatusJson(b, pb);
+  return strcmp(ja, jb) == 0;
+}
+
+//! Decodes reply as spec.cmdType with the library, nonzero count of values on success.
+static BYTE decode(InfiniResponseParser &parser, const ReplySpec &spec, const Reply &reply, long *values) {
+  switch (spec.cmdType) {
+    case QUERY_RATED_INFORMATION: {
+      RatedInformation o;
+      return parser.fromPIRIToRatedInformation(reply.data, reply.len, o) ? valuesOf(o, values) : 0;
+    }
+    case FAULT_WARNING_STATUS: {
+      FaultWarningStatus o;
+      return parser.fromFWSToFaultWarningStatus(reply.data, reply.len, o) ? valuesOf(o, values) : 0;
+    }
+    case QUERY_ENABLE_DISABLE_STATUS: {
+      EnableDisableStatus o;
+      // gridTie is the last field, DI has no counterpart, so all nine are compared.
+      return parser.fromFLAGToEnableDisableStatus(reply.data, reply.len, o) ? valuesOf(o, values) : 0;
+    }
+    case QUERY_DEFAULT_VALUE: {
+      DefaultValues o;
+      return parser.fromDIToDefaultValues(reply.data, reply.len, o) ? valuesOf(o, values) : 0;
+    }
+    default: {
+      ChargingCurrents o;
+      return parser.fromChargingCurrentsResponse(spec.cmdType, reply.data, reply.len, o) ? valuesOf(o, values) : 0;
+    }
+  }
+}
+
+/*! The properties every reply has to satisfy, whatever its content:
+ * the library accepts it exactly when the reference decoders do, with the same values.
+ */
+static void checkReply(const ReplySpec &spec, const Reply &reply) {
+  InfiniResponseParser parser;
+  bool framed = referenceFraming(spec.cmdType, reply);
+
+  if (spec.cmdType == GENERAL_STATUS) {
+    bool ok = parser.fromILGSToGeneralStatusFixed(reply.data, reply.len);
+    long fields[MAX_CHARGING_CURRENTS_SZ * 2];
+    bool strict = framed && referenceFields(spec, reply, fields) != 0;
+    CHECK(ok == strict);
+    if (ok) {
+      // The sscanf decoder is more lenient, e.g. about spaces, but must agree on what the reader accepts.
+      GeneralStatusFixed gs;
+      CHECK(referenceGs(reply, gs));
+      CHECK(sameGs(gs, parser.generalStatusFixed));
+    }
+    return;
+  }
+
+  if (spec.cmdType == GEN_ENERGY_DAY) {
+    unsigned long energy = parser.fromInfiniGenEnergyToULong(reply.data, reply.len);
+    const char *digits = reply.data + START_OFFSET_SZ;
+    BYTE len = payloadSize(GEN_ENERGY_DAY);
+    if (!framed) {
+      CHECK(energy == 0);
+    } else if (strspn(digits, "0123456789") >= len) {
+      unsigned long expected = 0;
+      for (BYTE i = 0; i < len; ++i) {
+        expected = expected * 10 + (digits[i] - '0');
+      }
+      CHECK(energy == expected);
+    }
+    return;
+  }
+
+  long got[MAX_CHARGING_CURRENTS_SZ * 2];
+  long want[MAX_CHARGING_CURRENTS_SZ * 2];
+  BYTE n = decode(parser, spec, reply, got);
+  BYTE wanted = framed ? referenceFields(spec, reply, want) : 0;
+  CHECK(n == wanted);
+  if (n != 0 && n == wanted) {
+    CHECK(memcmp(got, want, n * sizeof(long)) == 0);
+  }
+}
+
+//! A well formed reply with random values of the right widths, their narrowed values in values.
+static void makeValidReply(const ReplySpec &spec, Reply &reply, long *values) {
+  char payload[MAX_RESPONSE_SZ];
+  size_t len = 0;
+  if (spec.fields == NULL) {
+    BYTE digits = payloadSize(spec.cmdType);
+    for (BYTE i = 0; i < digits; ++i) {
+      payload[len++] = (char)('0' + randomBelow(10));
+    }
+  } else {
+    // The widths are the most a field may take, some replies are shorter than they add up to,
+    // e.g. PIRI sends 3 digit output voltages. Random fields give up digits until the reply size fits.
+    BYTE count = fieldCount(spec);
+    BYTE digits[MAX_CHARGING_CURRENTS_SZ * 2];
+    int excess = count - 1 - payloadSize(spec.cmdType);
+    for (BYTE i = 0; i < count; ++i) {
+      digits[i] = spec.fields[i].width;
+      excess += digits[i];
+    }
+    CHECK(excess >= 0);
+    while (excess > 0) {
+      BYTE i = (BYTE)randomBelow(count);
+      if (digits[i] > 1) {
+        digits[i]--;
+        excess--;
+      }
+    }
+    for (BYTE i = 0; i < count; ++i) {
+      const FieldSpec &field = spec.fields[i];
+      unsigned long limit = 1;
+      for (BYTE d = 0; d < digits[i]; ++d) {
+        limit *= 10;
+      }
+      unsigned long v = randomBelow(field.kind == F_FLAG ? 2 : limit);
+      len += snprintf(payload + len, sizeof(payload) - len, i == 0 ? "%0*lu" : ",%0*lu", (int)digits[i], v);
+      values[i] = field.kind == F_WORD ? (long)(WORD)v : field.kind == F_BYTE ? (long)(BYTE)v : (long)(v == 1);
+    }
+  }
+  reply.frame(payload, len);
+}
+
+// What mutated bytes are replaced with, weighted towards what could slip through a field reader.
+static const char MUTATIONS[] = "0123456789,,--+ .^D\r\n\x80\xff";
+
+static void mutate(Reply &reply) {
+  switch (randomBelow(8)) {
+    case 0:
+      // Different length, the framing has to reject it.
+      if (randomBelow(2) == 0 && reply.len > 1) {
+        reply.len -= 1 + randomBelow(reply.len - 1 < 4 ? reply.len - 1 : 4);
+      } else if (reply.len < MAX_RESPONSE_SZ) {
+        reply.data[reply.len - 1] = (char)MUTATIONS[randomBelow(sizeof(MUTATIONS) - 1)];
+        reply.data[reply.len++] = '\r';
+      }
+      reply.data[reply.len] = '\0';
+      break;
+    case 1:
+      // A corrupted byte anywhere, CRC left as is.
+      reply.data[randomBelow(reply.len)] ^= (char)(1 << randomBelow(8));
+      break;
+    default: {
+      // A few payload bytes replaced, CRC fixed up, so only the field decoding can catch it.
+      BYTE changes = 1 + randomBelow(3);
+      size_t payloadEnd = reply.len - CRC_SZ - END_TOKEN_SZ;
+      for (BYTE i = 0; i < changes && payloadEnd > START_OFFSET_SZ; ++i) {
+        reply.data[START_OFFSET_SZ + randomBelow(payloadEnd - START_OFFSET_SZ)] = MUTATIONS[randomBelow(sizeof(MUTATIONS) - 1)];
+      }
+      reply.fixCrc();
+      break;
+    }
+  }
+}
+
+#ifdef INFI_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size < 1 || size - 1 > MAX_RESPONSE_SZ) {
+    return 0;
+  }
+  const ReplySpec &spec = REPLIES[(data[0] & 0x7F) % NUM_REPLIES];
+  Reply reply;
+  memcpy(reply.data, data + 1, size - 1);
+  reply.len = size - 1;
+  reply.data[reply.len] = '\0';
+  if (data[0] & 0x80) {
+    reply.fixCrc();
+  }
+  checkReply(spec, reply);
+  return 0;
+}
+
+#else
+
+static void test_crc_matches_reference() {
+  BYTE buf[MAX_RESPONSE_SZ];
+  for (unsigned long n = 0; n < VALID_FRAMES; ++n) {
+    BYTE len = (BYTE)randomBelow(sizeof(buf) + 1);
+    for (BYTE i = 0; i < len; ++i) {
+      buf[i] = (BYTE)nextRandom();
+    }
+    WORD crc = calc_crc_half(buf, len);
+    CHECK(crc == referenceCrc(buf, len));
+
+    // Fed in random pieces, as InfiniRxRing does.
+    InfiniCrcAccumulator acc;
+    BYTE done = 0;
+    while (done < len) {
+      BYTE piece = (BYTE)(1 + randomBelow(len - done));
+      acc.update(buf + done, piece);
+      done += piece;
+    }
+    CHECK(acc.finalize() == crc);
+  }
+}
+
+static void test_valid_replies_decode() {
+  for (BYTE r = 0; r < NUM_REPLIES; ++r) {
+    const ReplySpec &spec = REPLIES[r];
+    for (unsigned long n = 0; n < VALID_FRAMES; ++n) {
+      Reply reply;
+      long values[MAX_CHARGING_CURRENTS_SZ * 2];
+      makeValidReply(spec, reply, values);
+      CHECK(referenceFraming(spec.cmdType, reply));
+      if (spec.fields != NULL && spec.cmdType != GENERAL_STATUS) {
+        InfiniResponseParser parser;
+        long got[MAX_CHARGING_CURRENTS_SZ * 2];
+        BYTE count = decode(parser, spec, reply, got);
+        CHECK(count == fieldCount(spec));
+        CHECK(memcmp(got, values, count * sizeof(long)) == 0);
+      }
+      checkReply(spec, reply);
+    }
+  }
+}
+
+static void test_mutated_replies_agree() {
+  unsigned long accepted = 0;
+  for (unsigned long n = 0; n < MUTATED_FRAMES; ++n) {
+    const ReplySpec &spec = REPLIES[randomBelow(NUM_REPLIES)];
+    Reply reply;
+    long values[MAX_CHARGING_CURRENTS_SZ * 2];
+    makeValidReply(spec, reply, values);
+    mutate(reply);
+    checkReply(spec, reply);
+    accepted += referenceFraming(spec.cmdType, reply);
+  }
+  char msg[80];
+  snprintf(msg, sizeof(msg), "%lu of %lu mutated replies got past the framing", accepted, MUTATED_FRAMES);
+  TEST_MESSAGE(msg);
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc_matches_reference);
+  RUN_TEST(test_valid_replies_decode);
+  RUN_TEST(test_mutated_replies_agree);
+  return UNITY_END();
+}
+
+#endif
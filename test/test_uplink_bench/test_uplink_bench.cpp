@@ -0,0 +1,336 @@
+/*
+ * Host benchmark of the whole uplink, run with
+ *   pio test -e native -f test_uplink_bench -v
+ * Every cycle a simulated inverter answers a GS query, and the reply goes through the sender, the parser,
+ * one of the encoders, the telemetry batch and ThingsBoardSized into a client that only records what would
+ * go on the wire. Each mode prints the bytes on the wire per sample, the publishes per cycle, the time spent
+ * in each stage and the heap operations per cycle. The first cycle of every mode checks its payload decodes.
+ * Only compare numbers from the same machine and build flags: the stage times include the clock reads.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <new>
+#include <ArduinoJson.h>
+#include <ThingsBoard.h>
+#include "InfiniCommandSender.h"
+#include "InfiniSimulatedInverter.h"
+#include "InfiniResponseParser.h"
+#include "InfiniJsonWriter.h"
+#include "InfiniTelemetryBatch.h"
+#include "InfiniGsSkeleton.h"
+#include "InfiniDeltaTelemetry.h"
+#include "InfiniBinaryWriter.h"
+#include "InfiniDeflate.h"
+
+using namespace INFI;
+
+static const unsigned long CYCLES = 2000;
+
+// As in the ThingsBoard example, so the batch splits the same way.
+static const size_t MQTT_BUFFER_SZ = 1024;
+static const size_t MQTT_OVERHEAD_SZ = 32;
+static const BYTE MAX_FIELDS_AMT = 16;
+
+// Every new and delete while a mode runs, the SDK's std::function and containers are the usual suspects.
+static unsigned long heapOps = 0;
+
+void *operator new(size_t size) {
+  ++heapOps;
+  void *p = malloc(size ? size : 1);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  if (p != NULL) {
+    ++heapOps;
+  }
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  operator delete(p);
+}
+
+//! An IMQTT_Client that is always connected and only records the PUBLISH packets it was given.
+class RecordingClient : public IMQTT_Client {
+  public:
+  RecordingClient() :
+    m_publishes(0),
+    m_wireBytes(0),
+    m_payloadLen(0),
+    m_streamTopicLen(0),
+    m_streamLen(0)
+  {}
+
+  void set_data_callback(Callback<void, char *, uint8_t *, unsigned int>::function) override {}
+  void set_connect_callback(Callback<void>::function) override {}
+  bool set_buffer_size(uint16_t) override { return true; }
+  uint16_t get_buffer_size() override { return MQTT_BUFFER_SZ; }
+  void set_server(char const *, uint16_t) override {}
+  bool connect(char const *, char const *, char const *) override { return true; }
+  void disconnect() override {}
+  bool loop() override { return true; }
+  bool subscribe(char const *) override { return true; }
+  bool unsubscribe(char const *) override { return true; }
+  bool connected() override { return true; }
+
+  bool publish(char const *topic, uint8_t const *payload, size_t const &length) override {
+    m_payloadLen = 0;
+    keep(payload, length);
+    record(strlen(topic), length);
+    return true;
+  }
+
+  bool begin_publish(char const *topic, size_t const &length) override {
+    m_streamTopicLen = strlen(topic);
+    m_streamLen = length;
+    m_payloadLen = 0;
+    return true;
+  }
+
+  size_t write(uint8_t const *buffer, size_t const &size) override {
+    keep(buffer, size);
+    return size;
+  }
+
+  bool end_publish() override {
+    record(m_streamTopicLen, m_streamLen);
+    return true;
+  }
+
+  void reset() {
+    m_publishes = 0;
+    m_wireBytes = 0;
+  }
+
+  unsigned long publishes() const { return m_publishes; }
+  unsigned long wireBytes() const { return m_wireBytes; }
+  //! The payload of the last publish, null terminated.
+  const char *payload() const { return m_payload; }
+  size_t payloadLen() const { return m_payloadLen; }
+
+  private:
+  //! A QoS 0 PUBLISH: the fixed header with the remaining length, the topic with its length, then the payload.
+  void record(size_t topicLen, size_t payloadLen) {
+    size_t remaining = 2 + topicLen + payloadLen;
+    size_t header = 1;
+    for (size_t n = remaining; n > 0; n >>= 7) {
+      ++header;
+    }
+    ++m_publishes;
+    m_wireBytes += header + remaining;
+  }
+
+  void keep(uint8_t const *data, size_t size) {
+    size_t n = size < MQTT_BUFFER_SZ - m_payloadLen ? size : MQTT_BUFFER_SZ - m_payloadLen;
+    memcpy(m_payload + m_payloadLen, data, n);
+    m_payloadLen += n;
+    m_payload[m_payloadLen] = '\0';
+  }
+
+  unsigned long m_publishes;
+  unsigned long m_wireBytes;
+  char m_payload[MQTT_BUFFER_SZ + 1];
+  size_t m_payloadLen;
+  size_t m_streamTopicLen;
+  size_t m_streamLen;
+};
+
+enum STAGE {
+  STAGE_LINK = 0, // sendCommand() against the simulator, CRC included.
+  STAGE_PARSE,
+  STAGE_ENCODE,
+  STAGE_BATCH,
+  STAGE_PUBLISH,
+  NUM_STAGES
+};
+
+static const char *const STAGE_NAMES[NUM_STAGES] = { "link", "parse", "encode", "batch", "publish" };
+
+enum MODE {
+  MODE_JSON = 0,  // writeGeneralStatusJson() into the batch, as the example does.
+  MODE_SKELETON,  // InfiniGsSkeleton streamed by sendTelemetryPrintable(), no batch.
+  MODE_DELTA,     // GeneralStatusDelta into the batch.
+  MODE_BINARY,    // The packed BINARY_GS_SAMPLE record, the compact binary format this tree has.
+  MODE_DEFLATE,   // writeGeneralStatusJson() through InfiniDeflatePrint.
+  NUM_MODES
+};
+
+static const char *const MODE_NAMES[NUM_MODES] = { "json", "skeleton", "delta", "binary", "deflate" };
+
+// The GS reply of every cycle, PV and load wander and the grid jitters, as on a sunny afternoon.
+static const char GS_FORMAT[] =
+  "%04u,500,2301,500,%04u,%04u,%03u,524,000,000,000,%03u,%03u,035,030,000,%04u,0000,3400,0000,0,2,0,1,1,2,1,0";
+
+static char gsPayload[sizeof(GS_FORMAT)];
+
+static void makeGsPayload(unsigned long cycle) {
+  unsigned int load = 400 + (unsigned int)(cycle * 7) % 90;
+  snprintf(gsPayload, sizeof(gsPayload), GS_FORMAT, 2295 + (unsigned int)(cycle * 13) % 11, load + 50, load, load / 12,
+           (unsigned int)(cycle / 50) % 10, 30 + (unsigned int)(cycle / 200) % 70, 850 + (unsigned int)(cycle * 3) % 200);
+}
+
+static RecordingClient client;
+static ThingsBoardSized<> tb(client, MQTT_BUFFER_SZ);
+static InfiniSimulatedInverter inverter(0, 0);
+// Read through the simulator's own available() and read(), as a firmware build reads its UART.
+static InfiniCommandSenderT<InfiniSimulatedInverter> sender(inverter);
+static InfiniResponseParser parser;
+
+static std::chrono::steady_clock::time_point stageStart;
+static double stageNs[NUM_STAGES];
+
+static void beginStage() {
+  stageStart = std::chrono::steady_clock::now();
+}
+
+static void endStage(STAGE stage) {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  stageNs[stage] += std::chrono::duration<double, std::nano>(now - stageStart).count();
+  stageStart = now;
+}
+
+//! The batch's flush callback, its time goes to the publish stage rather than the batch.
+static bool publishBatch(const char *json, void *) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool sent = tb.sendTelemtryString(json);
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  stageNs[STAGE_PUBLISH] += ns;
+  stageNs[STAGE_BATCH] -= ns;
+  return sent;
+}
+
+static void publishRaw(const uint8_t *payload, size_t len) {
+  client.publish(TELEMETRY_TOPIC, payload, len);
+}
+
+//! Checks the payload of the first cycle of mode decodes back to gs.
+static void checkPayload(MODE mode, const GeneralStatusFixed &gs, unsigned long tsMs) {
+  if (mode == MODE_BINARY) {
+    GeneralStatusFixed decoded;
+    uint64_t decodedTs = 0;
+    TEST_ASSERT_TRUE(readGsSampleBinary((const BYTE *)client.payload(), client.payloadLen(), decoded, decodedTs));
+    TEST_ASSERT_EQUAL(tsMs, (unsigned long)decodedTs);
+    TEST_ASSERT_EQUAL(gs.acOutActivePow, decoded.acOutActivePow);
+    return;
+  }
+  if (mode == MODE_DEFLATE) {
+    // GZIP magic, the stream itself is checked by the deflate tests against a real inflater.
+    TEST_ASSERT_EQUAL_HEX8(0x1F, (BYTE)client.payload()[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x8B, (BYTE)client.payload()[1]);
+    return;
+  }
+  JsonDocument doc;
+  TEST_ASSERT_EQUAL(DeserializationError::Ok, deserializeJson(doc, client.payload(), client.payloadLen()).code());
+  TEST_ASSERT_TRUE(doc.is<JsonObject>());
+  TEST_ASSERT_TRUE(doc.size() > 0);
+}
+
+static void runMode(MODE mode) {
+  static char batchJson[MQTT_BUFFER_SZ - MQTT_OVERHEAD_SZ];
+  static char encoded[MQTT_BUFFER_SZ];
+  static InfiniGsSkeleton skeleton;
+  InfiniTelemetryBatch batch(batchJson, sizeof(batchJson), MAX_FIELDS_AMT, publishBatch);
+  GeneralStatusDelta delta;
+  unsigned long samples = 0;
+
+  memset(stageNs, 0, sizeof(stageNs));
+  client.reset();
+  makeGsPayload(0);
+  TEST_ASSERT_TRUE(inverter.setPayload(GENERAL_STATUS, gsPayload));
+  heapOps = 0;
+
+  for (unsigned long cycle = 0; cycle < CYCLES; ++cycle) {
+    makeGsPayload(cycle);
+    unsigned long tsMs = 1700000000UL + cycle;
+
+    beginStage();
+    sender.sendCommand(GENERAL_STATUS, NULL);
+    endStage(STAGE_LINK);
+    bool parsed = parser.fromILGSToGeneralStatusFixed(sender.response.val, sender.response.actualLen);
+    endStage(STAGE_PARSE);
+    TEST_ASSERT_TRUE(parsed);
+    const GeneralStatusFixed &gs = parser.generalStatusFixed;
+
+    InfiniBufferPrint out(encoded, sizeof(encoded));
+    switch (mode) {
+      case MODE_JSON:
+        writeGeneralStatusJson(gs, out);
+        endStage(STAGE_ENCODE);
+        TEST_ASSERT_TRUE(batch.addJson(encoded));
+        batch.flush();
+        endStage(STAGE_BATCH);
+        break;
+      case MODE_SKELETON:
+        skeleton.fill(gs);
+        endStage(STAGE_ENCODE);
+        tb.sendTelemetryPrintable(skeleton, skeleton.length());
+        endStage(STAGE_PUBLISH);
+        break;
+      case MODE_DELTA:
+        if (delta.writeJson(gs, out) > 0) {
+          delta.markPublished(gs);
+          endStage(STAGE_ENCODE);
+          TEST_ASSERT_TRUE(batch.addJson(encoded));
+          batch.flush();
+          endStage(STAGE_BATCH);
+        }
+        break;
+      case MODE_BINARY:
+        writeGsSampleBinary(gs, tsMs, out);
+        endStage(STAGE_ENCODE);
+        publishRaw((const uint8_t *)encoded, out.length());
+        endStage(STAGE_PUBLISH);
+        break;
+      case MODE_DEFLATE: {
+        InfiniDeflatePrint deflate(out, DEFLATE_GZIP);
+        writeGeneralStatusJson(gs, deflate);
+        TEST_ASSERT_TRUE(deflate.finish());
+        endStage(STAGE_ENCODE);
+        publishRaw((const uint8_t *)encoded, out.length());
+        endStage(STAGE_PUBLISH);
+        break;
+      }
+      default:
+        break;
+    }
+    ++samples;
+    if (cycle == 0) {
+      checkPayload(mode, gs, tsMs);
+    }
+  }
+
+  char msg[160];
+  snprintf(msg, sizeof(msg), "%-9s %7.1f B/sample %5.2f publishes/cycle %6.2f heap ops/cycle", MODE_NAMES[mode],
+           (double)client.wireBytes() / samples, (double)client.publishes() / CYCLES, (double)heapOps / CYCLES);
+  TEST_MESSAGE(msg);
+  int n = snprintf(msg, sizeof(msg), "%-9s", "");
+  for (BYTE s = 0; s < NUM_STAGES; ++s) {
+    n += snprintf(msg + n, sizeof(msg) - n, " %s %7.1f", STAGE_NAMES[s], stageNs[s] / CYCLES);
+  }
+  snprintf(msg + n, sizeof(msg) - n, " ns/cycle");
+  TEST_MESSAGE(msg);
+}
+
+static void test_json() { runMode(MODE_JSON); }
+static void test_skeleton() { runMode(MODE_SKELETON); }
+static void test_delta() { runMode(MODE_DELTA); }
+static void test_binary() { runMode(MODE_BINARY); }
+static void test_deflate() { runMode(MODE_DEFLATE); }
+
+void setUp() {}
+void tearDown() {}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_json);
+  RUN_TEST(test_skeleton);
+  RUN_TEST(test_delta);
+  RUN_TEST(test_binary);
+  RUN_TEST(test_deflate);
+  return UNITY_END();
+}
@@ -0,0 +1,812 @@
+/*
+ * Puts the load of a fleet on a ThingsBoard cluster, or any MQTT broker, from one PC, e.g. before new batching
+ * or key defaults go out to the units. Every simulated unit runs the code a unit runs: an InfiniSimulatedInverter
+ * answers its InfiniCommandSender at the wire rate, an InfiniPollScheduler polls GS, InfiniResponseParser decodes
+ * it, GeneralStatusDelta or the history's timestamped arrays encode it, and ThingsBoardSized publishes it over a
+ * session of its own. The units are split over a pool of threads, each an event loop that sleeps in poll() until
+ * a scheduler or a socket has something to do.
+ *
+ *   pio run -e fleetload
+ *   .pio/build/fleetload/program -h broker [-p 1883] [-n units] [-j threads] [-t token] [-d seconds] ...
+ *
+ * -t is a printf pattern of the units' access tokens, e.g. fleet%04u for devices provisioned as fleet0000,
+ * fleet0001 and so on, or a single token every session shares. The sessions connect spread over the ramp, -r.
+ * -g is the GS period, -b the batch: 1 publishes each GS as the delta against the last one, as the example does
+ * live, with short keys after -k, and more publishes that many samples as a timestamped array, as the history
+ * does. -q 1 waits for a PUBACK per publish, without blocking the loop, so the broker's latency is measured.
+ * -s is the MQTT buffer, -B the simulated baud rate, 0 for replies at once, -i the seconds between reports.
+ *
+ * A line per report gives, for the interval, the units online, the GS polled and the publishes per second,
+ * then the client side: the bytes on the wire per second, the time to encode and write a publish and how old
+ * its oldest sample was, and the broker side: the PUBACKs per second, their latency, and the publishes still
+ * unacknowledged. The totals of the whole run follow at the end.
+ */
+
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <ArduinoJson.h>
+#include <ThingsBoard.h>
+#include "InfiniPollScheduler.h"
+#include "InfiniSimulatedInverter.h"
+#include "InfiniResponseParser.h"
+#include "InfiniJsonWriter.h"
+#include "InfiniDeltaTelemetry.h"
+
+using namespace INFI;
+
+static const BYTE MAX_BATCH = 64;
+static const BYTE MAX_INFLIGHT = 32;
+static const unsigned long RECONNECT_MS = 5000;
+// Sent as a PINGREQ once a session was quiet this long, the keep alive is 60 s.
+static const unsigned long KEEP_ALIVE_MS = 30000;
+// The longest a loop sleeps while a reply is coming in on a simulated link, which wakes nothing.
+static const int REPLY_POLL_MS = 1;
+static const int IDLE_POLL_MS = 50;
+
+static const char GS_FORMAT[] =
+  "%04u,500,2301,500,%04u,%04u,%03u,524,000,000,000,%03u,%03u,035,030,000,%04u,0000,3400,0000,0,2,0,1,1,2,1,0";
+
+static const char *host = NULL;
+static unsigned port = 1883;
+static const char *tokenPattern = "";
+static unsigned units = 100;
+static unsigned threads = 0;
+static unsigned long seconds = 60;
+static unsigned long rampMs = 10000;
+static unsigned long gsPeriodMs = 5000;
+static unsigned batch = 1;
+static bool shortKeys = false;
+static unsigned qos = 1;
+static unsigned bufferSize = 4096;
+static unsigned long baud = SERIAL_BAUD;
+static unsigned long reportMs = 10000;
+static std::atomic<bool> stopping(false);
+
+static unsigned long long steadyUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static unsigned long long wallMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+//! Counts of values in buckets a quarter of a power of two wide, for percentiles without keeping the values.
+struct Histogram {
+  static const unsigned BUCKETS = 4 * 40;
+  unsigned long long counts[BUCKETS];
+
+  Histogram() { clear(); }
+  void clear() { memset(counts, 0, sizeof(counts)); }
+
+  static unsigned bucketOf(unsigned long long value) {
+    if (value < 4) {
+      return (unsigned)value;
+    }
+    const unsigned msb = 63 - __builtin_clzll(value);
+    return std::min(BUCKETS - 1, 4 * (msb - 1) + (unsigned)((value >> (msb - 2)) & 3));
+  }
+
+  //! The largest value bucket holds.
+  static unsigned long long ceilingOf(unsigned bucket) {
+    if (bucket < 4) {
+      return bucket;
+    }
+    const unsigned msb = bucket / 4 + 1;
+    return ((4ULL + bucket % 4 + 1) << (msb - 2)) - 1;
+  }
+
+  void add(unsigned long long value) { counts[bucketOf(value)]++; }
+
+  void merge(const Histogram &other) {
+    for (unsigned i = 0; i < BUCKETS; ++i) {
+      counts[i] += other.counts[i];
+    }
+  }
+
+  unsigned long long total() const {
+    unsigned long long n = 0;
+    for (unsigned i = 0; i < BUCKETS; ++i) {
+      n += counts[i];
+    }
+    return n;
+  }
+
+  //! Rounded up to its bucket, 0 without values.
+  unsigned long long percentile(unsigned pct) const {
+    const unsigned long long n = total();
+    if (n == 0) {
+      return 0;
+    }
+    const unsigned long long rank = (n * pct + 99) / 100;
+    unsigned long long seen = 0;
+    for (unsigned i = 0; i < BUCKETS; ++i) {
+      seen += counts[i];
+      if (seen >= rank && counts[i] > 0) {
+        return ceilingOf(i);
+      }
+    }
+    return ceilingOf(BUCKETS - 1);
+  }
+};
+
+//! What the units of a thread did, over an interval or the run.
+struct Stats {
+  unsigned long long polled;
+  unsigned long long pollFailed;
+  unsigned long long publishes;
+  unsigned long long publishFailed;
+  unsigned long long unchanged;
+  unsigned long long wireBytes;
+  unsigned long long acked;
+  unsigned long long connects;
+  unsigned long long connectFailed;
+  unsigned long long disconnects;
+  //! Encoding and writing a publish, us.
+  Histogram publishUs;
+  //! Publish to its PUBACK, us.
+  Histogram ackUs;
+  //! GS reply to the publish of its sample, ms.
+  Histogram ageMs;
+
+  Stats() { clear(); }
+
+  void clear() {
+    polled = pollFailed = publishes = publishFailed = unchanged = wireBytes = acked = 0;
+    connects = connectFailed = disconnects = 0;
+    publishUs.clear();
+    ackUs.clear();
+    ageMs.clear();
+  }
+
+  void merge(const Stats &other) {
+    polled += other.polled;
+    pollFailed += other.pollFailed;
+    publishes += other.publishes;
+    publishFailed += other.publishFailed;
+    unchanged += other.unchanged;
+    wireBytes += other.wireBytes;
+    acked += other.acked;
+    connects += other.connects;
+    connectFailed += other.connectFailed;
+    disconnects += other.disconnects;
+    publishUs.merge(other.publishUs);
+    ackUs.merge(other.ackUs);
+    ageMs.merge(other.ageMs);
+  }
+};
+
+//! A thread's Stats, taken and cleared by the reports.
+struct SharedStats {
+  std::mutex lock;
+  Stats interval;
+  unsigned online;
+  unsigned long inflight;
+};
+
+/*!
+ * MQTT 3.1.1 over a POSIX socket for one unit, as Arduino_MQTT_Client is on the ESP32. It publishes at QoS 0,
+ * or at QoS 1 without waiting: the PUBACKs are read by pump() when poll() says they are in, and matched to the
+ * send times of the publishes in flight. Nothing is subscribed, anything else the broker sends is dropped.
+ */
+class FleetClient : public IMQTT_Client {
+  public:
+  FleetClient() :
+    m_fd(-1),
+    m_host(NULL),
+    m_port(1883),
+    m_bufferSize(1024),
+    m_qos(0),
+    m_packetId(0),
+    m_inflight(0),
+    m_rxLen(0),
+    m_sentUs(0),
+    m_stats(NULL)
+  {}
+
+  ~FleetClient() {
+    disconnect();
+  }
+
+  void set_data_callback(Callback<void, char *, uint8_t *, unsigned int>::function) override {}
+  void set_connect_callback(Callback<void>::function) override {}
+
+  bool set_buffer_size(uint16_t size) override {
+    m_bufferSize = size;
+    return true;
+  }
+
+  uint16_t get_buffer_size() override { return m_bufferSize; }
+
+  void set_server(char const *host, uint16_t port) override {
+    m_host = host;
+    m_port = port;
+  }
+
+  //! Blocks until the CONNACK, only the sends after it leave the socket non-blocking for reads.
+  bool connect(char const *clientId, char const *user, char const *password) override {
+    char portText[8];
+    snprintf(portText, sizeof(portText), "%u", (unsigned int)m_port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *addrs = NULL;
+    if (m_host == NULL || getaddrinfo(m_host, portText, &hints, &addrs) != 0) {
+      return false;
+    }
+    for (struct addrinfo *a = addrs; a != NULL && m_fd < 0; a = a->ai_next) {
+      m_fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (m_fd >= 0 && ::connect(m_fd, a->ai_addr, a->ai_addrlen) != 0) {
+        close(m_fd);
+        m_fd = -1;
+      }
+    }
+    freeaddrinfo(addrs);
+    if (m_fd < 0) {
+      return false;
+    }
+    int one = 1;
+    setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct timeval timeout = { 10, 0 };
+    setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    const bool hasUser = user != NULL && *user != '\0';
+    const bool hasPassword = password != NULL && *password != '\0';
+    uint8_t packet[256];
+    // Variable header: "MQTT", level 4, the flags and a keep alive of 60 s.
+    const uint8_t header[] = { 0, 4, 'M', 'Q', 'T', 'T', 4, 0, 0, 60 };
+    memcpy(packet + 2, header, sizeof(header));
+    size_t n = 2 + sizeof(header);
+    packet[2 + 7] = 0x02 | (hasUser ? 0x80 : 0) | (hasPassword ? 0x40 : 0);
+    n = putString(packet, n, sizeof(packet), clientId);
+    if (hasUser) {
+      n = putString(packet, n, sizeof(packet), user);
+    }
+    if (hasPassword) {
+      n = putString(packet, n, sizeof(packet), password);
+    }
+    if (n == 0 || n - 2 >= 128) {
+      disconnect();
+      return false;
+    }
+    packet[0] = 0x10;
+    packet[1] = (uint8_t)(n - 2);
+    uint8_t connack[4];
+    if (!sendAll(packet, n) || !readConnack(connack) || connack[3] != 0) {
+      disconnect();
+      return false;
+    }
+    m_inflight = 0;
+    m_rxLen = 0;
+    return true;
+  }
+
+  void disconnect() override {
+    if (m_fd >= 0) {
+      const uint8_t packet[] = { 0xE0, 0 };
+      sendAll(packet, sizeof(packet));
+      drop();
+    }
+  }
+
+  bool loop() override { return connected(); }
+  bool subscribe(char const *) override { return false; }
+  bool unsubscribe(char const *) override { return false; }
+  bool connected() override { return m_fd >= 0; }
+
+  bool publish(char const *topic, uint8_t const *payload, size_t const &length) override {
+    return begin_publish(topic, length) && write(payload, length) == length && end_publish();
+  }
+
+  bool begin_publish(char const *topic, size_t const &length) override {
+    // A broker that stopped acknowledging would otherwise get every publish from then on.
+    if (m_qos > 0 && m_inflight == MAX_INFLIGHT) {
+      return false;
+    }
+    const size_t topicLen = strlen(topic);
+    size_t remaining = 2 + topicLen + length + (m_qos > 0 ? 2 : 0);
+    uint8_t header[8 + 2 + 2];
+    size_t n = 0;
+    header[n++] = 0x30 | (m_qos << 1);
+    do {
+      uint8_t b = remaining & 0x7F;
+      remaining >>= 7;
+      header[n++] = b | (remaining > 0 ? 0x80 : 0);
+    } while (remaining > 0);
+    header[n++] = (uint8_t)(topicLen >> 8);
+    header[n++] = (uint8_t)topicLen;
+    if (!sendAll(header, n) || !sendAll((const uint8_t *)topic, topicLen)) {
+      return false;
+    }
+    if (m_qos > 0) {
+      m_packetId = m_packetId == 0xFFFF ? 1 : m_packetId + 1;
+      const uint8_t id[] = { (uint8_t)(m_packetId >> 8), (uint8_t)m_packetId };
+      return sendAll(id, sizeof(id));
+    }
+    return true;
+  }
+
+  size_t write(uint8_t const *buffer, size_t const &size) override {
+    return sendAll(buffer, size) ? size : 0;
+  }
+
+  bool end_publish() override {
+    if (m_fd < 0) {
+      return false;
+    }
+    if (m_qos > 0) {
+      m_inflightIds[m_inflight] = m_packetId;
+      m_inflightUs[m_inflight] = steadyUs();
+      m_inflight++;
+    }
+    return true;
+  }
+
+  //! Reads what the broker sent without blocking and times the PUBACKs in it. False once the session is gone.
+  bool pump() {
+    while (m_fd >= 0) {
+      const ssize_t got = recv(m_fd, m_rx + m_rxLen, sizeof(m_rx) - m_rxLen, MSG_DONTWAIT);
+      if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        drop();
+        return false;
+      }
+      if (got < 0) {
+        break;
+      }
+      m_rxLen += got;
+      parse();
+    }
+    return m_fd >= 0;
+  }
+
+  //! Sends a PINGREQ if nothing went out for KEEP_ALIVE_MS, its PINGRESP is dropped by pump().
+  void keepAlive() {
+    if (m_fd >= 0 && steadyUs() - m_sentUs >= KEEP_ALIVE_MS * 1000ULL) {
+      const uint8_t packet[] = { 0xC0, 0 };
+      sendAll(packet, sizeof(packet));
+    }
+  }
+
+  int fd() const { return m_fd; }
+  BYTE inflight() const { return m_inflight; }
+  void setQos(uint8_t qos) { m_qos = qos > 0 ? 1 : 0; }
+  void setStats(Stats *stats) { m_stats = stats; }
+
+  private:
+  void drop() {
+    close(m_fd);
+    m_fd = -1;
+    m_inflight = 0;
+    m_rxLen = 0;
+  }
+
+  //! Takes the whole packets off m_rx.
+  void parse() {
+    size_t pos = 0;
+    while (pos + 2 <= m_rxLen) {
+      size_t remaining = 0;
+      size_t at = pos + 1;
+      BYTE shift = 0;
+      bool complete = false;
+      while (at < m_rxLen && shift < 28) {
+        const uint8_t b = m_rx[at++];
+        remaining |= (size_t)(b & 0x7F) << shift;
+        shift += 7;
+        if ((b & 0x80) == 0) {
+          complete = true;
+          break;
+        }
+      }
+      if (!complete || at + remaining > m_rxLen) {
+        break;
+      }
+      if ((m_rx[pos] & 0xF0) == 0x40 && remaining >= 2) {
+        acknowledge((WORD)((m_rx[at] << 8) | m_rx[at + 1]));
+      }
+      pos = at + remaining;
+    }
+    memmove(m_rx, m_rx + pos, m_rxLen - pos);
+    m_rxLen -= pos;
+  }
+
+  void acknowledge(WORD id) {
+    for (BYTE i = 0; i < m_inflight; ++i) {
+      if (m_inflightIds[i] != id) {
+        continue;
+      }
+      if (m_stats != NULL) {
+        m_stats->acked++;
+        m_stats->ackUs.add(steadyUs() - m_inflightUs[i]);
+      }
+      m_inflight--;
+      m_inflightIds[i] = m_inflightIds[m_inflight];
+      m_inflightUs[i] = m_inflightUs[m_inflight];
+      return;
+    }
+  }
+
+  bool readConnack(uint8_t *connack) {
+    size_t got = 0;
+    while (got < 4) {
+      const ssize_t n = recv(m_fd, connack + got, 4 - got, 0);
+      if (n <= 0) {
+        return false;
+      }
+      got += n;
+    }
+    return connack[0] == 0x20 && connack[1] == 2;
+  }
+
+  //! Appends str with its length at n. Returns the new length, 0 if it did not fit.
+  static size_t putString(uint8_t *packet, size_t n, size_t size, const char *str) {
+    const size_t len = str != NULL ? strlen(str) : 0;
+    if (n == 0 || n + 2 + len > size) {
+      return 0;
+    }
+    packet[n++] = (uint8_t)(len >> 8);
+    packet[n++] = (uint8_t)len;
+    memcpy(packet + n, str, len);
+    return n + len;
+  }
+
+  bool sendAll(const uint8_t *data, size_t len) {
+    while (len > 0 && m_fd >= 0) {
+      const ssize_t sent = send(m_fd, data, len, MSG_NOSIGNAL);
+      if (sent <= 0) {
+        drop();
+        return false;
+      }
+      if (m_stats != NULL) {
+        m_stats->wireBytes += sent;
+      }
+      data += sent;
+      len -= sent;
+    }
+    m_sentUs = steadyUs();
+    return m_fd >= 0;
+  }
+
+  int m_fd;
+  const char *m_host;
+  uint16_t m_port;
+  uint16_t m_bufferSize;
+  uint8_t m_qos;
+  uint16_t m_packetId;
+  WORD m_inflightIds[MAX_INFLIGHT];
+  unsigned long long m_inflightUs[MAX_INFLIGHT];
+  BYTE m_inflight;
+  uint8_t m_rx[512];
+  size_t m_rxLen;
+  unsigned long long m_sentUs;
+  Stats *m_stats;
+};
+
+//! One simulated unit: an inverter on its link, the pipeline and an MQTT session.
+struct Unit {
+  explicit Unit(unsigned index) :
+    index(index),
+    inverter(baud),
+    sender(inverter),
+    queue(sender),
+    scheduler(queue),
+    tb(client, bufferSize),
+    count(0),
+    cycle(index * 37),
+    connectAtMs(0)
+  {
+    snprintf(token, sizeof(token), tokenPattern, index);
+    snprintf(clientId, sizeof(clientId), "infini-fleet-%u", index);
+    nextPayload();
+    inverter.setPayload(GENERAL_STATUS, gsPayload);
+    scheduler.addPeriodic(GENERAL_STATUS, gsPeriodMs, onGeneralStatus, this);
+    client.setQos(qos);
+    delta.setShortKeys(shortKeys);
+    delta.setDeadband(GS_BATT_VOLT, 2);
+    delta.setDeadband(GS_GRID_VOLT, 20);
+    delta.setDeadband(GS_AC_OUT_VOLT, 20);
+    delta.setDeadband(GS_PV1_IN_VOLT, 20);
+    delta.setDeadband(GS_PV2_IN_VOLT, 20);
+    delta.setDeadband(GS_AC_OUT_ACTIVE_POW, 20);
+    delta.setDeadband(GS_AC_OUT_APPARENT_POW, 20);
+    delta.setDeadband(GS_PV1_IN_POW, 20);
+    delta.setDeadband(GS_PV2_IN_POW, 20);
+  }
+
+  //! The next GS reply, PV and load wander and the grid jitters. Each unit starts somewhere else.
+  void nextPayload() {
+    const unsigned i = cycle++;
+    const unsigned load = 400 + (i * 7) % 90;
+    snprintf(gsPayload, sizeof(gsPayload), GS_FORMAT, 2295 + (i * 13) % 11, load + 50, load, load / 12,
+             (i / 50) % 10, 30 + (i / 200) % 70, 850 + (i * 3) % 200);
+  }
+
+  static void onGeneralStatus(const InfiniResponse &response, SEND_STATUS status, void *context) {
+    Unit &unit = *(Unit *)context;
+    if (status != SEND_COMPLETE || !unit.parser.fromILGSToGeneralStatusFixed(response.val, response.actualLen)) {
+      unit.stats->pollFailed++;
+      return;
+    }
+    unit.stats->polled++;
+    unit.nextPayload();
+    unit.samples[unit.count] = unit.parser.generalStatusFixed;
+    unit.sampleTs[unit.count] = wallMs();
+    unit.sampleUs[unit.count] = steadyUs();
+    if (++unit.count >= batch) {
+      unit.publish();
+    }
+  }
+
+  void publish() {
+    static thread_local char payload[65536];
+    const unsigned long long startUs = steadyUs();
+    InfiniBufferPrint out(payload, std::min<size_t>(sizeof(payload), bufferSize));
+    if (batch == 1) {
+      // The live path: only what moved past its deadband.
+      if (delta.writeJson(samples[0], out) == 0) {
+        stats->unchanged++;
+        count = 0;
+        return;
+      }
+    } else {
+      char ts[40];
+      out.print('[');
+      for (BYTE i = 0; i < count; ++i) {
+        snprintf(ts, sizeof(ts), "%s{\"ts\":%llu,\"values\":", i > 0 ? "," : "", sampleTs[i]);
+        out.print(ts);
+        writeGeneralStatusJson(samples[i], out);
+        out.print('}');
+      }
+      out.print(']');
+    }
+    const bool sent = tb.sendTelemtryString(payload);
+    const unsigned long long endUs = steadyUs();
+    stats->publishUs.add(endUs - startUs);
+    if (sent) {
+      stats->publishes++;
+      stats->ageMs.add((endUs - sampleUs[0]) / 1000);
+      if (batch == 1) {
+        delta.markPublished(samples[0]);
+      }
+    } else {
+      stats->publishFailed++;
+    }
+    count = 0;
+  }
+
+  unsigned index;
+  char token[64];
+  char clientId[32];
+  char gsPayload[sizeof(GS_FORMAT)];
+  InfiniSimulatedInverter inverter;
+  InfiniCommandSenderT<InfiniSimulatedInverter> sender;
+  InfiniCommandQueue queue;
+  InfiniPollScheduler scheduler;
+  InfiniResponseParser parser;
+  GeneralStatusDelta delta;
+  FleetClient client;
+  ThingsBoardSized<> tb;
+  GeneralStatusFixed samples[MAX_BATCH];
+  unsigned long long sampleTs[MAX_BATCH];
+  unsigned long long sampleUs[MAX_BATCH];
+  BYTE count;
+  unsigned cycle;
+  unsigned long long connectAtMs;
+  Stats *stats;
+};
+
+//! The event loop of one thread over its units.
+static void runUnits(std::vector<Unit *> units, SharedStats *shared, unsigned long long startMs) {
+  Stats local;
+  std::vector<struct pollfd> fds;
+  std::vector<Unit *> polled;
+  for (size_t u = 0; u < units.size(); ++u) {
+    units[u]->stats = &local;
+    units[u]->client.setStats(&local);
+  }
+  unsigned long long lastShareMs = 0;
+  while (!stopping) {
+    const unsigned long long nowMs = steadyUs() / 1000;
+    int waitMs = IDLE_POLL_MS;
+    unsigned online = 0;
+    unsigned long inflight = 0;
+    fds.clear();
+    polled.clear();
+    for (size_t u = 0; u < units.size(); ++u) {
+      Unit &unit = *units[u];
+      if (!unit.client.connected()) {
+        if (nowMs < startMs + unit.connectAtMs) {
+          continue;
+        }
+        if (!unit.tb.connect(host, unit.token, port, unit.clientId)) {
+          local.connectFailed++;
+          unit.connectAtMs = nowMs - startMs + RECONNECT_MS;
+          continue;
+        }
+        local.connects++;
+        // Everything is read again, as after a reboot.
+        unit.count = 0;
+        unit.delta.forceFullSnapshot();
+      }
+      unit.scheduler.loop();
+      if (!unit.client.connected()) {
+        local.disconnects++;
+        unit.connectAtMs = nowMs - startMs + RECONNECT_MS;
+        continue;
+      }
+      unit.client.keepAlive();
+      online++;
+      inflight += unit.client.inflight();
+      const unsigned long due = unit.queue.isBusy() ? REPLY_POLL_MS : unit.scheduler.msUntilDue();
+      waitMs = (int)std::min<unsigned long>(waitMs, due);
+      struct pollfd fd = { unit.client.fd(), POLLIN, 0 };
+      fds.push_back(fd);
+      polled.push_back(&unit);
+    }
+    if (nowMs - lastShareMs >= 100) {
+      std::lock_guard<std::mutex> guard(shared->lock);
+      shared->interval.merge(local);
+      shared->online = online;
+      shared->inflight = inflight;
+      local.clear();
+      lastShareMs = nowMs;
+    }
+    if (poll(fds.empty() ? NULL : &fds[0], fds.size(), waitMs) <= 0) {
+      continue;
+    }
+    for (size_t i = 0; i < fds.size(); ++i) {
+      if (fds[i].revents != 0 && !polled[i]->client.pump()) {
+        local.disconnects++;
+        polled[i]->connectAtMs = steadyUs() / 1000 - startMs + RECONNECT_MS;
+      }
+    }
+  }
+  for (size_t u = 0; u < units.size(); ++u) {
+    units[u]->tb.disconnect();
+  }
+  std::lock_guard<std::mutex> guard(shared->lock);
+  shared->interval.merge(local);
+  shared->online = 0;
+}
+
+static void printLine(const char *label, const Stats &stats, double seconds, unsigned online, unsigned long inflight) {
+  printf("%-6s %5u online %8.1f GS/s %8.1f pub/s %9.1f kB/s  publish p50 %6llu p99 %7llu us  age p50 %6llu p99 %6llu ms"
+         "  ack %8.1f/s p50 %7llu p90 %7llu p99 %8llu us  %lu unacked  %llu unchanged %llu failed %llu poll errors"
+         "  %llu connects %llu refused %llu dropped\n",
+         label, online, stats.polled / seconds, stats.publishes / seconds, stats.wireBytes / seconds / 1000,
+         stats.publishUs.percentile(50), stats.publishUs.percentile(99), stats.ageMs.percentile(50),
+         stats.ageMs.percentile(99), stats.acked / seconds, stats.ackUs.percentile(50), stats.ackUs.percentile(90),
+         stats.ackUs.percentile(99), inflight, stats.unchanged, stats.publishFailed, stats.pollFailed,
+         stats.connects, stats.connectFailed, stats.disconnects);
+  fflush(stdout);
+}
+
+static void onSignal(int) {
+  stopping = true;
+}
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s -h host [-p port] [-t token] [-n units] [-j threads] [-d seconds] [-r ramp_seconds]\n"
+          "       [-g gs_period_ms] [-b batch] [-k] [-q 0|1] [-s buffer] [-B baud] [-i report_seconds]\n", program);
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    if (strcmp(arg, "-k") == 0) {
+      shortKeys = true;
+      continue;
+    }
+    if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || i + 1 >= argc) {
+      usage(argv[0]);
+      return 2;
+    }
+    const char *value = argv[++i];
+    switch (arg[1]) {
+      case 'h': host = value; break;
+      case 'p': port = atoi(value); break;
+      case 't': tokenPattern = value; break;
+      case 'n': units = atoi(value); break;
+      case 'j': threads = atoi(value); break;
+      case 'd': seconds = atol(value); break;
+      case 'r': rampMs = atol(value) * 1000UL; break;
+      case 'g': gsPeriodMs = atol(value); break;
+      case 'b': batch = std::max(1, std::min(atoi(value), (int)MAX_BATCH)); break;
+      case 'q': qos = atoi(value); break;
+      case 's': bufferSize = std::max(256, std::min(atoi(value), 65535)); break;
+      case 'B': baud = atol(value); break;
+      case 'i': reportMs = std::max(1L, atol(value)) * 1000UL; break;
+      default:
+        usage(argv[0]);
+        return 2;
+    }
+  }
+  if (host == NULL || units == 0) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min(threads, units);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  std::vector<Unit *> all;
+  for (unsigned u = 0; u < units; ++u) {
+    all.push_back(new Unit(u));
+    all.back()->connectAtMs = (unsigned long long)u * rampMs / units;
+  }
+  printf("%u units on %u threads, GS every %lu ms at %lu baud, %u per publish%s, QoS %u\n", units, threads,
+         gsPeriodMs, baud, batch, batch == 1 ? (shortKeys ? " as short key deltas" : " as deltas") : "", qos);
+
+  // Round robin, so each thread has units from all over the ramp.
+  std::vector<SharedStats> shared(threads);
+  std::vector<std::thread> pool;
+  const unsigned long long startMs = steadyUs() / 1000;
+  for (unsigned t = 0; t < threads; ++t) {
+    std::vector<Unit *> mine;
+    for (unsigned u = t; u < units; u += threads) {
+      mine.push_back(all[u]);
+    }
+    pool.push_back(std::thread(runUnits, mine, &shared[t], startMs));
+  }
+
+  Stats total;
+  unsigned lastOnline = 0;
+  unsigned long long lastMs = startMs;
+  while (!stopping && (seconds == 0 || steadyUs() / 1000 - startMs < seconds * 1000ULL)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(
+      std::min<unsigned long long>(reportMs, 200)));
+    const unsigned long long nowMs = steadyUs() / 1000;
+    if (nowMs - lastMs < reportMs) {
+      continue;
+    }
+    Stats interval;
+    unsigned online = 0;
+    unsigned long inflight = 0;
+    for (unsigned t = 0; t < threads; ++t) {
+      std::lock_guard<std::mutex> guard(shared[t].lock);
+      interval.merge(shared[t].interval);
+      shared[t].interval.clear();
+      online += shared[t].online;
+      inflight += shared[t].inflight;
+    }
+    char label[24];
+    snprintf(label, sizeof(label), "%llus", (nowMs - startMs) / 1000);
+    printLine(label, interval, (nowMs - lastMs) / 1000.0, online, inflight);
+    total.merge(interval);
+    lastOnline = online;
+    lastMs = nowMs;
+  }
+  stopping = true;
+  for (size_t t = 0; t < pool.size(); ++t) {
+    pool[t].join();
+  }
+  unsigned long inflight = 0;
+  for (unsigned t = 0; t < threads; ++t) {
+    total.merge(shared[t].interval);
+    inflight += shared[t].inflight;
+  }
+  printLine("total", total, std::max(1.0, (steadyUs() / 1000 - startMs) / 1000.0), lastOnline,
+            inflight);
+  for (size_t u = 0; u < all.size(); ++u) {
+    delete all[u];
+  }
+  return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Turns dumps of InfiniPartitionLog partitions into CSV or columns, e.g. of units back from the field.
+ * Every dump is checked record by record, put in ring order, and written next to it as <dump>.csv or
+ * <dump>.cols, the BINARY_GS_COLUMNS records of InfiniRecordDecoder.h. One line of counts per dump goes to stdout.
+ *
+ *   pio run -e logdump
+ *   .pio/build/logdump/program [-j threads] [-f csv|columns] dump...
+ *
+ * A dump is the partition's range of the flash, e.g. for the "spiffs" partition of the default table
+ *   esptool.py read_flash 0x290000 0x160000 unit42.bin
+ * Several dumps are read at once, a thread each. A single one is checked by all the threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "InfiniLogImage.h"
+
+using namespace INFI;
+
+// Buffers the bytes the writers hand over one at a time.
+class FilePrint : public Print {
+  public:
+  explicit FilePrint(FILE *file) : m_file(file), m_len(0) {}
+  ~FilePrint() { flush(); }
+
+  size_t write(uint8_t c) override {
+    if (m_len == sizeof(m_buffer)) {
+      flush();
+    }
+    m_buffer[m_len++] = c;
+    return 1;
+  }
+
+  void flush() override {
+    fwrite(m_buffer, 1, m_len, m_file);
+    m_len = 0;
+  }
+
+  private:
+  FILE *m_file;
+  char m_buffer[65536];
+  size_t m_len;
+};
+
+static bool toCsv = false;
+
+// Reads one dump and writes its export. Returns false, having printed why, if it could not.
+static bool exportDump(const char *path, unsigned threads) {
+  InfiniLogImage image;
+  if (!image.open(path)) {
+    fprintf(stderr, "%s: not readable, or under two sectors\n", path);
+    return false;
+  }
+  image.scan(threads);
+  const std::string outPath = std::string(path) + (toCsv ? ".csv" : ".cols");
+  FILE *file = fopen(outPath.c_str(), "wb");
+  if (file == NULL) {
+    fprintf(stderr, "%s: cannot write\n", outPath.c_str());
+    return false;
+  }
+  {
+    FilePrint out(file);
+    if (toCsv) {
+      image.writeCsv(out);
+    } else {
+      image.writeColumns(out);
+    }
+  }
+  fclose(file);
+  const LogImageStats &stats = image.stats();
+  const unsigned long long firstMs = image.size() > 0 ? image.record(0).tsMs : 0;
+  const unsigned long long lastMs = image.size() > 0 ? image.record(image.size() - 1).tsMs : 0;
+  printf("%s: %lu/%lu sectors, %lu records (%lu consumed), %lu corrupted, %llu to %llu\n", path,
+         stats.validSectors, stats.sectors, stats.records, stats.consumed, stats.corrupted, firstMs, lastMs);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<const char *> dumps;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+      toCsv = strcmp(argv[++i], "csv") == 0;
+    } else {
+      dumps.push_back(argv[i]);
+    }
+  }
+  if (dumps.empty()) {
+    fprintf(stderr, "usage: %s [-j threads] [-f csv|columns] dump...\n", argv[0]);
+    return 2;
+  }
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::atomic<size_t> next(0);
+  std::atomic<unsigned> failed(0);
+  // A single dump gets every thread, several get one each.
+  const unsigned workers = std::min<size_t>(threads, dumps.size());
+  const unsigned perDump = dumps.size() == 1 ? threads : 1;
+  std::vector<std::thread> pool;
+  for (unsigned w = 0; w < workers; ++w) {
+    pool.push_back(std::thread([&]() {
+      for (size_t d = next++; d < dumps.size(); d = next++) {
+        if (!exportDump(dumps[d], perDump)) {
+          failed++;
+        }
+      }
+    }));
+  }
+  for (size_t w = 0; w < pool.size(); ++w) {
+    pool[w].join();
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "%zu dumps in %.2f s\n", dumps.size(), seconds);
+  return failed > 0 ? 1 : 0;
+}